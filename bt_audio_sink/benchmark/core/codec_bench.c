@@ -0,0 +1,228 @@
+/*
+ * Codec benchmark core: replays a capture through the A2DP decoder
+ * interface the sink task uses (see codec_bench.h for the format).
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "codec_bench.h"
+
+#include "common/bt_target.h"
+#include "stack/a2dp_codec_api.h"
+#include "stack/avdt_api.h"
+#include "esp_a2dp_api.h"
+#include "codec_config.h"
+
+// Same size as the sink task's decode buffer (BT_A2DP_SINK_BUF_SIZE)
+#define BENCH_PCM_BUF_SIZE      (64 * 1024)
+// Headroom in front of the packet, as left by L2CAP and used for the
+// sink's arrival stamp
+#define BENCH_PKT_OFFSET        16
+// Zeroed slack behind the packet: the bitstream readers fetch ahead
+#define BENCH_PKT_TAIL          16
+
+static uint32_t s_crc_table[256];
+
+static struct {
+    uint32_t crc;
+    uint64_t pcm_bytes;
+    uint32_t cb_ticks;          // Spent in the callback during this packet
+} s_out;
+
+uint32_t codec_bench_crc32(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    if (s_crc_table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            s_crc_table[i] = c;
+        }
+    }
+    crc = ~crc;
+    while (len--) {
+        crc = s_crc_table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// Decoder output; its own time is taken out of the decode time
+static void bench_data_cb(uint8_t *buf, uint32_t len)
+{
+    uint32_t start = codec_bench_ticks();
+    s_out.crc = codec_bench_crc32(s_out.crc, buf, len);
+    s_out.pcm_bytes += len;
+    s_out.cb_ticks += codec_bench_ticks() - start;
+}
+
+static uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/* Output format the app would configure for this stream: ESP32-A2DP's view
+ * of the codec, 16 bit as S16 and anything wider in a 32 bit container */
+static bool bench_stream_format(const uint8_t *codec_info, codec_bench_result_t *res)
+{
+    esp_a2d_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.audio_cfg.mcc.type = A2DP_GetCodecType(codec_info);
+    size_t len = (codec_info[0] + 1) - AVDT_CODEC_HEADER_SIZE;
+    len = len < sizeof(param.audio_cfg.mcc.cie) ? len : sizeof(param.audio_cfg.mcc.cie);
+    memcpy(&param.audio_cfg.mcc.cie, codec_info + AVDT_CODEC_HEADER_SIZE, len);
+
+    uint8_t bps = 0;
+    if (!get_codec_config(&param, &res->sample_rate, &bps, &res->channels)) {
+        return false;
+    }
+    res->codec = get_codec_id_name(get_codec_id(&param));
+    res->sample_bytes = bps <= 16 ? 2 : 4;
+    return true;
+}
+
+bool codec_bench_run(const uint8_t *capture, size_t len, codec_bench_result_t *res)
+{
+    memset(res, 0, sizeof(*res));
+    res->ticks_per_second = codec_bench_ticks_per_second();
+
+    if (len < 6 || memcmp(capture, CODEC_BENCH_MAGIC, 4) != 0 ||
+            capture[4] != CODEC_BENCH_VERSION) {
+        printf("bench: not a capture\n");
+        return false;
+    }
+    size_t info_len = capture[5];
+    if (info_len < AVDT_CODEC_HEADER_SIZE || info_len > AVDT_CODEC_SIZE ||
+            6 + info_len > len || (size_t)capture[6] + 1 != info_len) {
+        printf("bench: bad codec info\n");
+        return false;
+    }
+    uint8_t codec_info[AVDT_CODEC_SIZE] = {0};
+    memcpy(codec_info, capture + 6, info_len);
+
+    // Walk the records once for the largest packet
+    const uint8_t *first = capture + 6 + info_len;
+    const uint8_t *end = capture + len;
+    size_t max_pkt = 0;
+    for (const uint8_t *p = first; p < end; ) {
+        if (end - p < 2 || (size_t)(end - p - 2) < rd16(p)) {
+            printf("bench: truncated packet record\n");
+            return false;
+        }
+        size_t n = rd16(p);
+        max_pkt = n > max_pkt ? n : max_pkt;
+        p += 2 + n;
+    }
+
+    const tA2DP_DECODER_INTERFACE *decoder = A2DP_GetDecoderInterface(codec_info);
+    if (decoder == NULL || !bench_stream_format(codec_info, res)) {
+        printf("bench: codec not supported by this build\n");
+        return false;
+    }
+
+    BT_HDR *pkt = (BT_HDR *)calloc(1, sizeof(BT_HDR) + BENCH_PKT_OFFSET + max_pkt + BENCH_PKT_TAIL);
+    uint8_t *pcm = (uint8_t *)malloc(BENCH_PCM_BUF_SIZE);
+    if (pkt == NULL || pcm == NULL) {
+        printf("bench: out of memory\n");
+        free(pkt);
+        free(pcm);
+        return false;
+    }
+    memset(&s_out, 0, sizeof(s_out));
+
+    // Same sequence as btc_a2dp_sink_handle_decoder_reset
+    codec_bench_heap_reset();
+    if (decoder->decoder_init && !decoder->decoder_init(bench_data_cb)) {
+        printf("bench: decoder failed to initialize\n");
+        free(pkt);
+        free(pcm);
+        return false;
+    }
+    if (decoder->decoder_configure) {
+        decoder->decoder_configure(codec_info);
+    }
+    if (decoder->decoder_start) {
+        decoder->decoder_start();
+    }
+    codec_bench_heap_get(&res->setup_allocs, &res->setup_bytes);
+
+    codec_bench_heap_reset();
+    res->ticks_min = UINT32_MAX;
+    for (const uint8_t *p = first; p < end; p += 2 + rd16(p)) {
+        uint16_t n = rd16(p);
+        pkt->event = 0;
+        pkt->len = n;
+        pkt->offset = BENCH_PKT_OFFSET;
+        pkt->layer_specific = 0;
+        memcpy(pkt->data + BENCH_PKT_OFFSET, p + 2, n);
+        memset(pkt->data + BENCH_PKT_OFFSET + n, 0, BENCH_PKT_TAIL);
+        s_out.cb_ticks = 0;
+
+        uint32_t start = codec_bench_ticks();
+        bool ok = true;
+        if (decoder->decode_packet_header) {
+            ok = decoder->decode_packet_header(pkt) >= 0;
+        }
+        if (ok && decoder->decode_packet) {
+            ok = decoder->decode_packet(pkt, pcm, BENCH_PCM_BUF_SIZE);
+        }
+        uint32_t ticks = codec_bench_ticks() - start - s_out.cb_ticks;
+
+        res->packets++;
+        res->errors += ok ? 0 : 1;
+        res->ticks_total += ticks;
+        res->ticks_min = ticks < res->ticks_min ? ticks : res->ticks_min;
+        res->ticks_max = ticks > res->ticks_max ? ticks : res->ticks_max;
+    }
+    codec_bench_heap_get(&res->decode_allocs, &res->decode_bytes);
+    if (res->packets == 0) {
+        res->ticks_min = 0;
+    }
+
+    if (decoder->decoder_cleanup) {
+        decoder->decoder_cleanup();
+    }
+    free(pkt);
+    free(pcm);
+
+    res->pcm_bytes = s_out.pcm_bytes;
+    res->crc32 = s_out.crc;
+    return true;
+}
+
+void codec_bench_print(const char *name, const codec_bench_result_t *res)
+{
+    uint32_t frame_bytes = (uint32_t)res->channels * res->sample_bytes;
+    double audio_s = (res->sample_rate && frame_bytes) ?
+                     (double)res->pcm_bytes / frame_bytes / res->sample_rate : 0;
+    double decode_s = res->ticks_per_second ?
+                      (double)res->ticks_total / res->ticks_per_second : 0;
+
+    printf("%s: %s %" PRIu32 "/%u/%u packets %" PRIu32 " errors %" PRIu32
+           " ticks/packet %" PRIu32 "/%" PRIu64 "/%" PRIu32 " load %.2f%%"
+           " heap setup %" PRIu32 "/%" PRIu32 " decode %" PRIu32 "/%" PRIu32
+           " stack %" PRIu32 " pcm %" PRIu64 " crc %08" PRIx32 "\n",
+           name, res->codec, res->sample_rate, res->channels, res->sample_bytes * 8,
+           res->packets, res->errors,
+           res->ticks_min, res->packets ? res->ticks_total / res->packets : 0, res->ticks_max,
+           audio_s > 0 ? 100.0 * decode_s / audio_s : 0.0,
+           res->setup_allocs, res->setup_bytes, res->decode_allocs, res->decode_bytes,
+           res->peak_stack, res->pcm_bytes, res->crc32);
+}
+
+void codec_bench_print_json(const char *name, const codec_bench_result_t *res)
+{
+    printf("{\"suite\":\"codec\",\"capture\":\"%s\",\"codec\":\"%s\",\"rate\":%" PRIu32
+           ",\"channels\":%u,\"bits\":%u,\"packets\":%" PRIu32 ",\"errors\":%" PRIu32
+           ",\"ticks_min\":%" PRIu32 ",\"ticks_avg\":%" PRIu64 ",\"ticks_max\":%" PRIu32
+           ",\"ticks_per_second\":%" PRIu64 ",\"setup_allocs\":%" PRIu32 ",\"setup_bytes\":%" PRIu32
+           ",\"decode_allocs\":%" PRIu32 ",\"decode_bytes\":%" PRIu32 ",\"stack\":%" PRIu32
+           ",\"pcm_bytes\":%" PRIu64 ",\"crc\":\"%08" PRIx32 "\"}\n",
+           name, res->codec, res->sample_rate, res->channels, res->sample_bytes * 8,
+           res->packets, res->errors,
+           res->ticks_min, res->packets ? res->ticks_total / res->packets : 0, res->ticks_max,
+           res->ticks_per_second, res->setup_allocs, res->setup_bytes,
+           res->decode_allocs, res->decode_bytes, res->peak_stack, res->pcm_bytes, res->crc32);
+}
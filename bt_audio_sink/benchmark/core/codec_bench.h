@@ -0,0 +1,71 @@
+/*
+ * Codec benchmark core, shared by the on-device app (main/) and the host
+ * build (host/).
+ *
+ * A capture (.a2dp) holds the negotiated codec information element and the
+ * AVDTP media packets of a stream, RTP header included, exactly as the sink
+ * task hands them to the decoder:
+ *
+ *   "A2DC"  u8 version (1)  u8 info_len  codec_info[info_len]
+ *   { u16 len  packet[len] } ...
+ *
+ * codec_info is LOSC-prefixed like the stack's (codec_info[0] = LOSC). All
+ * integers are little endian.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CODEC_BENCH_MAGIC       "A2DC"
+#define CODEC_BENCH_VERSION     1
+
+typedef struct {
+    const char *codec;          // Codec name (ESP32-A2DP naming)
+    uint32_t sample_rate;
+    uint8_t channels;
+    uint8_t sample_bytes;       // Per sample as delivered to the app
+    uint32_t packets;
+    uint32_t errors;            // Packets rejected by the header or decoder
+    uint64_t pcm_bytes;
+    uint32_t ticks_min;         // Per packet, header + decode
+    uint32_t ticks_max;
+    uint64_t ticks_total;
+    uint64_t ticks_per_second;
+    uint32_t setup_allocs;      // init + configure
+    uint32_t setup_bytes;
+    uint32_t decode_allocs;     // All packets
+    uint32_t decode_bytes;
+    uint32_t peak_stack;        // Filled in by the runner, 0 if unknown
+    uint32_t crc32;             // Of the PCM output
+} codec_bench_result_t;
+
+/* Platform hooks, implemented by the runner */
+
+// Free running counter: CPU cycles on target, nanoseconds on host
+uint32_t codec_bench_ticks(void);
+uint64_t codec_bench_ticks_per_second(void);
+// Allocations made by the calling thread since the last reset
+void codec_bench_heap_reset(void);
+void codec_bench_heap_get(uint32_t *allocs, uint32_t *bytes);
+
+/* Decodes a whole capture through the stack's decoder interface for its
+ * codec. Returns false if the capture is malformed or the codec is not
+ * built in; packets the decoder rejects are only counted. */
+bool codec_bench_run(const uint8_t *capture, size_t len, codec_bench_result_t *res);
+
+// One line per capture, also used as the CI log format
+void codec_bench_print(const char *name, const codec_bench_result_t *res);
+// Same as one JSON object ("suite":"codec"), for the on-device runner
+void codec_bench_print_json(const char *name, const codec_bench_result_t *res);
+
+uint32_t codec_bench_crc32(uint32_t crc, const uint8_t *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,405 @@
+/*
+ * DSP golden-vector suite, shared by the on-device app (main/, the
+ * "golden" system suite) and the host build (pipeline/dsp_golden.cpp).
+ *
+ * Deterministic stereo test signals run through the sink's DSPProcessor in
+ * each mode, at 44.1, 48 and 96 kHz:
+ *
+ *   sweep     exponential sine sweep, 20 Hz up on L and down on R
+ *   impulse   one sample on L, another three blocks later on R
+ *   pink      independent pink noise per channel (seeded)
+ *
+ *   bypass, eq (+6/-4/+3 dB), split_ear, 3d, bass_boost, limiter (EQ
+ *   +9/0/+9 dB on a signal 1 dB below full scale), binaural (3D mode 2)
+ *
+ * Every case settles (an EQ change crossfades over one block), clears the
+ * filter states and runs FRAMES frames in blocks of BLOCK. The output is
+ * reduced to a fingerprint: per segment and channel, the RMS level in dB
+ * and the correlation with the input delayed by the limiter's lookahead,
+ * plus each channel's peak. Fingerprints are compared with the golden
+ * table (dsp_golden_ref.h) within RMS_TOL_DB / CORR_TOL / PEAK_TOL_DB
+ * (wider for quiet segments), so float rounding across compilers and the
+ * Q31 path both pass while a wrong coefficient, a swapped channel or a
+ * missing stage does not.
+ *
+ * The table comes from the host's float path with the Kconfig defaults
+ * (pipeline/port/sdkconfig.h); regenerate it with dsp_golden --update
+ * after an intended change to the DSP's output.
+ */
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "audio/sample_format.h"
+#include "dsp/dsp_processor.h"
+
+namespace dsp_golden {
+
+constexpr uint32_t BLOCK = 256;
+constexpr uint32_t SEGMENTS = 16;
+constexpr uint32_t SEGMENT_FRAMES = 512;
+constexpr uint32_t FRAMES = SEGMENTS * SEGMENT_FRAMES;
+constexpr uint32_t SETTLE_BLOCKS = 2;
+
+constexpr float FLOOR_DB = -100.0f;
+// Levels below these are noise-floor detail: compared only as "quiet".
+// The Q31 path's 90 Hz crossover at 96 kHz leaves a residual near
+// -72 dB where the float path is silent, so its floor sits higher.
+constexpr float QUIET_DB = -80.0f;
+constexpr float QUIET_Q31_DB = -70.0f;
+constexpr float RMS_TOL_DB = 0.1f;
+constexpr float CORR_TOL = 0.02f;
+constexpr float PEAK_TOL_DB = 0.1f;
+// Below LOUD_DB a path's own rounding (the Q31 biquads' in particular)
+// is a visible part of the level: the tolerances widen by TOL_PER_DB
+constexpr float LOUD_DB = -40.0f;
+constexpr float TOL_PER_DB = 0.1f;
+
+enum Signal : uint8_t { SIG_SWEEP, SIG_IMPULSE, SIG_PINK, SIG_COUNT };
+
+static const char* const SIGNAL_NAMES[SIG_COUNT] = { "sweep", "impulse", "pink" };
+
+static const uint32_t RATES[] = { 44100, 48000, 96000 };
+constexpr int RATE_COUNT = sizeof(RATES) / sizeof(RATES[0]);
+
+struct Mode {
+    const char* name;
+    bool bypass;
+    bool bassBoost;
+    uint8_t sound3D;    // DSPProcessor::Sound3DMode
+    int8_t bassDb;
+    int8_t midDb;
+    int8_t trebleDb;
+    float levelDb;      // Input level (sweep and impulse peak, pink RMS + 10 dB)
+};
+
+static const Mode MODES[] = {
+    {"bypass",     true,  false, 0, 0,  0, 0, -12.0f},
+    {"eq",         true,  false, 0, 6, -4, 3, -12.0f},
+    {"split_ear",  false, false, 0, 0,  0, 0, -12.0f},
+    {"3d",         true,  false, 1, 0,  0, 0, -12.0f},
+    {"bass_boost", true,  true,  0, 0,  0, 0, -12.0f},
+    {"limiter",    true,  false, 0, 9,  0, 9, -1.0f},
+    {"binaural",   true,  false, 2, 0,  0, 0, -12.0f},
+};
+constexpr int MODE_COUNT = sizeof(MODES) / sizeof(MODES[0]);
+
+struct Print {
+    float rmsDb[SEGMENTS][2];
+    float corr[SEGMENTS][2];
+    float peakDb[2];
+};
+
+struct Ref {
+    uint8_t signal;
+    uint8_t mode;
+    uint32_t rate;
+    Print print;
+};
+
+// Frame by frame, so the same generator also yields the delayed reference
+class Generator {
+public:
+    Generator(Signal sig, uint32_t rate, float levelDb, uint32_t delay = 0)
+        : m_sig(sig), m_rate(rate), m_gain(powf(10.0f, levelDb / 20.0f)), m_delay(delay) {}
+
+    void next(float& l, float& r) {
+        if (m_delay) {
+            m_delay--;
+            l = r = 0.0f;
+            return;
+        }
+        const uint32_t n = m_n++;
+        switch (m_sig) {
+            case SIG_SWEEP:
+                l = m_gain * (float)sin(sweepPhase(n));
+                r = m_gain * (float)sin(sweepPhase(FRAMES - 1 - n));
+                break;
+            case SIG_IMPULSE:
+                l = n == 64 ? m_gain : 0.0f;
+                r = n == 64 + 3 * BLOCK ? m_gain : 0.0f;
+                break;
+            default:
+                l = pink(m_pinkL, m_seedL);
+                r = pink(m_pinkR, m_seedR);
+                break;
+        }
+    }
+
+private:
+    // 20 Hz to 0.45 fs over FRAMES, phase in closed form per frame
+    double sweepPhase(uint32_t n) const {
+        const double f0 = 20.0, f1 = 0.45 * m_rate;
+        const double T = (double)FRAMES / m_rate;
+        const double k = log(f1 / f0) / T;
+        const double t = (double)n / m_rate;
+        return 2.0 * M_PI * f0 * (exp(k * t) - 1.0) / k;
+    }
+
+    // Paul Kellet's economy pink filter over xorshift32 white noise
+    float pink(float* b, uint32_t& s) {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        const float w = (float)(int32_t)s * (1.0f / 2147483648.0f);
+        b[0] = 0.99765f * b[0] + w * 0.0990460f;
+        b[1] = 0.96300f * b[1] + w * 0.2965164f;
+        b[2] = 0.57000f * b[2] + w * 1.0526913f;
+        float v = (b[0] + b[1] + b[2] + w * 0.1848f) * 0.11f * m_gain;
+        if (v > 1.0f) v = 1.0f;
+        if (v < -1.0f) v = -1.0f;
+        return v;
+    }
+
+    Signal m_sig;
+    uint32_t m_rate;
+    float m_gain;
+    uint32_t m_delay;
+    uint32_t m_n = 0;
+    float m_pinkL[3] = {};
+    float m_pinkR[3] = {};
+    uint32_t m_seedL = 0x2545F491u;
+    uint32_t m_seedR = 0x9E3779B9u;
+};
+
+static void applyMode(DSPProcessor& dsp, const Mode& m) {
+    dsp.setAnalysisEnabled(false);
+    dsp.setChannelFlip(false);
+    dsp.setBypass(m.bypass);
+    dsp.setBassBoost(m.bassBoost);
+    dsp.set3DMode(m.sound3D);
+    dsp.setEQ((float)m.bassDb, (float)m.midDb, (float)m.trebleDb);
+}
+
+static float toDb(double meanSquare) {
+    if (meanSquare <= 0.0) return FLOOR_DB;
+    const float db = (float)(10.0 * log10(meanSquare));
+    return db < FLOOR_DB ? FLOOR_DB : db;
+}
+
+#if APP_DSP_Q31_PATH
+static int32_t toQ31(float x) {
+    if (x >= 1.0f) return INT32_MAX;
+    if (x <= -1.0f) return INT32_MIN;
+    return (int32_t)lrintf(x * 2147483648.0f);
+}
+#endif
+
+struct Timing {
+    uint32_t avg;       // Ticks per measured block
+    uint32_t max;
+};
+
+// One case through the float path or, with q31 (APP_DSP_Q31_PATH), the
+// Q31 path. buf holds BLOCK stereo frames of the path's sample type.
+// ticks: a free-running counter for the timing (may be null).
+static void run(DSPProcessor& dsp, Signal sig, const Mode& mode, uint32_t rate, bool q31, void* buf,
+                uint32_t (*ticks)(), Print& out, Timing& timing) {
+    dsp.setSampleRate(rate);
+    applyMode(dsp, mode);
+
+    float* fbuf = static_cast<float*>(buf);
+#if APP_DSP_Q31_PATH
+    int32_t* qbuf = static_cast<int32_t*>(buf);
+#endif
+    auto fill = [&](Generator& gen) {
+        for (uint32_t i = 0; i < BLOCK; i++) {
+            float l, r;
+            gen.next(l, r);
+#if APP_DSP_Q31_PATH
+            if (q31) {
+                qbuf[2 * i] = toQ31(l);
+                qbuf[2 * i + 1] = toQ31(r);
+                continue;
+            }
+#endif
+            fbuf[2 * i] = l;
+            fbuf[2 * i + 1] = r;
+        }
+    };
+    auto process = [&]() {
+#if APP_DSP_Q31_PATH
+        if (q31) {
+            dsp.processBlockQ31(qbuf, BLOCK);
+            return;
+        }
+#endif
+        dsp.processBlock(fbuf, fbuf, BLOCK);
+    };
+    auto sample = [&](uint32_t i) -> float {
+#if APP_DSP_Q31_PATH
+        if (q31) return (float)qbuf[i] * (1.0f / 2147483648.0f);
+#endif
+        return fbuf[i];
+    };
+
+    Generator settle(sig, rate, mode.levelDb);
+    for (uint32_t b = 0; b < SETTLE_BLOCKS; b++) {
+        fill(settle);
+        process();
+    }
+    dsp.resetAllFilters();
+
+    Generator gen(sig, rate, mode.levelDb);
+    Generator ref(sig, rate, mode.levelDb, dsp.limiterDelay());
+    double sumOut[2] = {}, sumRef[2] = {}, sumCross[2] = {};
+    float peak[2] = {};
+    uint64_t total = 0;
+    uint32_t worst = 0;
+    for (uint32_t frame = 0; frame < FRAMES; frame += BLOCK) {
+        fill(gen);
+        const uint32_t t0 = ticks ? ticks() : 0;
+        process();
+        const uint32_t dt = ticks ? ticks() - t0 : 0;
+        total += dt;
+        if (dt > worst) worst = dt;
+
+        for (uint32_t i = 0; i < BLOCK; i++) {
+            float refS[2];
+            ref.next(refS[0], refS[1]);
+            for (int c = 0; c < 2; c++) {
+                const float y = sample(2 * i + c);
+                sumOut[c] += (double)y * y;
+                sumRef[c] += (double)refS[c] * refS[c];
+                sumCross[c] += (double)y * refS[c];
+                const float a = fabsf(y);
+                if (a > peak[c]) peak[c] = a;
+            }
+            if ((frame + i + 1) % SEGMENT_FRAMES == 0) {
+                const uint32_t seg = (frame + i) / SEGMENT_FRAMES;
+                for (int c = 0; c < 2; c++) {
+                    out.rmsDb[seg][c] = toDb(sumOut[c] / SEGMENT_FRAMES);
+                    const double norm = sqrt(sumOut[c] * sumRef[c]);
+                    out.corr[seg][c] = norm > 1e-12 ? (float)(sumCross[c] / norm) : 0.0f;
+                    sumOut[c] = sumRef[c] = sumCross[c] = 0.0;
+                }
+            }
+        }
+    }
+    for (int c = 0; c < 2; c++) out.peakDb[c] = toDb((double)peak[c] * peak[c]);
+    timing.avg = (uint32_t)(total / (FRAMES / BLOCK));
+    timing.max = worst;
+}
+
+static const Ref* findRef(const Ref* refs, size_t count, Signal sig, int mode, uint32_t rate) {
+    for (size_t i = 0; i < count; i++) {
+        if (refs[i].signal == sig && refs[i].mode == mode && refs[i].rate == rate) return &refs[i];
+    }
+    return nullptr;
+}
+
+static bool levelMatches(float got, float want, float tol, float quiet) {
+    if (got < quiet && want < quiet) return true;
+    if (want < LOUD_DB) tol += (LOUD_DB - want) * TOL_PER_DB;
+    return fabsf(got - want) <= tol;
+}
+
+// First difference beyond the tolerances into what (e.g. "rms seg 3 R:
+// -20.41 dB, want -20.12"); true if none
+static bool compare(const Print& got, const Print& want, bool q31, char* what, size_t cap) {
+    const float quiet = q31 ? QUIET_Q31_DB : QUIET_DB;
+    static const char CH[2] = { 'L', 'R' };
+    for (int c = 0; c < 2; c++) {
+        if (!levelMatches(got.peakDb[c], want.peakDb[c], PEAK_TOL_DB, quiet)) {
+            snprintf(what, cap, "peak %c: %.2f dB, want %.2f", CH[c], got.peakDb[c], want.peakDb[c]);
+            return false;
+        }
+    }
+    for (uint32_t s = 0; s < SEGMENTS; s++) {
+        for (int c = 0; c < 2; c++) {
+            if (!levelMatches(got.rmsDb[s][c], want.rmsDb[s][c], RMS_TOL_DB, quiet)) {
+                snprintf(what, cap, "rms seg %u %c: %.2f dB, want %.2f", (unsigned)s, CH[c],
+                         got.rmsDb[s][c], want.rmsDb[s][c]);
+                return false;
+            }
+            // Correlation only where the signal dominates the rounding
+            if (want.rmsDb[s][c] >= LOUD_DB && fabsf(got.corr[s][c] - want.corr[s][c]) > CORR_TOL) {
+                snprintf(what, cap, "corr seg %u %c: %.3f, want %.3f", (unsigned)s, CH[c],
+                         got.corr[s][c], want.corr[s][c]);
+                return false;
+            }
+        }
+    }
+    what[0] = '\0';
+    return true;
+}
+
+// The block converters (sample_format.h), every input format at one, two
+// and three channels into both working formats, against the formats'
+// definitions: Q31 and float must match bit for bit
+static bool checkConverters(char* what, size_t cap) {
+    constexpr uint32_t N = 64;
+    static const SampleFmt FMTS[] = { SAMPLE_FMT_S16, SAMPLE_FMT_S24_PACKED, SAMPLE_FMT_S24_IN_32, SAMPLE_FMT_S32 };
+    uint8_t src[N * 3 * 4];
+    int32_t q[N * 2];
+    float f[N * 2];
+    uint32_t s = 0x12345678u;
+    for (SampleFmt fmt : FMTS) {
+        const uint32_t bytes = sampleFmtBytes(fmt);
+        for (uint8_t channels = 1; channels <= 3; channels++) {
+            const uint32_t samples = N * channels;
+            int32_t value[N * 3];
+            for (uint32_t i = 0; i < samples; i++) {
+                s ^= s << 13;
+                s ^= s >> 17;
+                s ^= s << 5;
+                int32_t v = (int32_t)s;
+                uint8_t* p = src + i * bytes;
+                switch (fmt) {
+                    case SAMPLE_FMT_S16:
+                        v >>= 16;
+                        p[0] = (uint8_t)v;
+                        p[1] = (uint8_t)(v >> 8);
+                        break;
+                    case SAMPLE_FMT_S24_PACKED:
+                        v >>= 8;
+                        p[0] = (uint8_t)v;
+                        p[1] = (uint8_t)(v >> 8);
+                        p[2] = (uint8_t)(v >> 16);
+                        break;
+                    case SAMPLE_FMT_S24_IN_32:
+                        v >>= 8;
+                        memcpy(p, &v, 4);
+                        break;
+                    default:
+                        memcpy(p, &v, 4);
+                        break;
+                }
+                value[i] = v;
+            }
+            convertBlock<int32_t>(fmt, channels, src, q, N);
+            convertBlock<float>(fmt, channels, src, f, N);
+            for (uint32_t i = 0; i < N * 2; i++) {
+                const int32_t v = value[(i / 2) * channels + (channels == 1 ? 0 : i % 2)];
+                int32_t wantQ;
+                float wantF;
+                switch (fmt) {
+                    case SAMPLE_FMT_S16:
+                        wantQ = (int32_t)((uint32_t)v << 16);
+                        wantF = (float)v * (1.0f / 32768.0f);
+                        break;
+                    case SAMPLE_FMT_S32:
+                        wantQ = v;
+                        wantF = (float)v * (1.0f / 2147483648.0f);
+                        break;
+                    default:
+                        wantQ = (int32_t)((uint32_t)v << 8);
+                        wantF = (float)v * (1.0f / 8388608.0f);
+                        break;
+                }
+                if (q[i] != wantQ || f[i] != wantF) {
+                    snprintf(what, cap, "%s x%u sample %u: q31 %ld float %.9g, want %ld %.9g", sampleFmtName(fmt),
+                             (unsigned)channels, (unsigned)i, (long)q[i], f[i], (long)wantQ, wantF);
+                    return false;
+                }
+            }
+        }
+    }
+    what[0] = '\0';
+    return true;
+}
+
+}  // namespace dsp_golden
@@ -0,0 +1,327 @@
+/*
+ * Golden fingerprints of the DSP suite (dsp_golden.h), written by
+ * pipeline/dsp_golden --update from the host's float path with the
+ * Kconfig defaults. Do not edit; regenerate after an intended change.
+ *
+ * {signal, mode, rate, {rms dB [segment][L, R], correlation
+ * [segment][L, R], peak dB [L, R]}}
+ */
+#pragma once
+
+static const dsp_golden::Ref DSP_GOLDEN_REF[] = {
+    // sweep, bypass, 44100 Hz
+    {0, 0, 44100, {
+        {{-16.003, -15.585}, {-15.471, -15.019}, {-14.190, -15.004}, {-15.116, -15.021}, {-15.049, -14.995}, {-15.208, -15.035}, {-14.925, -14.992}, {-15.100, -15.054}, {-15.018, -14.907}, {-14.992, -15.054}, {-15.012, -15.194}, {-15.013, -14.624}, {-15.003, -15.112}, {-15.012, -15.547}, {-15.009, -15.423}, {-15.005, -14.041}},
+        {{1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}},
+        {-12.000, -12.000}}},
+    // impulse, bypass, 44100 Hz
+    {1, 0, 44100, {
+        {{-39.093, -100.000}, {-100.000, -39.093}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{1.000, 0.000}, {0.000, 1.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-12.000, -12.000}}},
+    // pink, bypass, 44100 Hz
+    {2, 0, 44100, {
+        {{-27.953, -28.515}, {-21.649, -26.125}, {-25.722, -26.688}, {-26.939, -23.396}, {-27.926, -26.928}, {-28.050, -27.025}, {-27.511, -27.522}, {-27.150, -28.663}, {-26.969, -25.526}, {-25.766, -26.691}, {-27.621, -26.537}, {-26.929, -25.697}, {-27.323, -23.531}, {-27.023, -25.702}, {-28.031, -25.866}, {-26.763, -25.784}},
+        {{1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}},
+        {-15.518, -15.494}}},
+    // sweep, eq, 44100 Hz
+    {0, 1, 44100, {
+        {{-13.323, -13.495}, {-12.422, -13.045}, {-11.298, -13.622}, {-12.441, -14.605}, {-13.071, -15.225}, {-14.593, -15.942}, {-15.038, -17.163}, {-15.872, -17.420}, {-17.009, -15.926}, {-17.518, -15.271}, {-16.194, -14.857}, {-15.377, -13.291}, {-14.786, -12.469}, {-13.877, -12.883}, {-13.119, -12.394}, {-12.923, -10.912}},
+        {{0.999, 0.999}, {0.996, 0.993}, {0.995, 0.981}, {0.982, 0.977}, {0.962, 0.982}, {0.954, 0.982}, {0.974, 0.990}, {0.976, 0.990}, {0.984, 0.978}, {0.995, 0.975}, {0.982, 0.964}, {0.982, 0.968}, {0.979, 0.974}, {0.978, 0.987}, {0.991, 0.996}, {0.998, 0.999}},
+        {-9.011, -8.994}}},
+    // impulse, eq, 44100 Hz
+    {1, 1, 44100, {
+        {{-37.620, -100.000}, {-100.000, -37.620}, {-100.000, -87.085}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.984, 0.000}, {0.000, 0.984}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-10.664, -10.664}}},
+    // pink, eq, 44100 Hz
+    {2, 1, 44100, {
+        {{-27.257, -27.819}, {-19.024, -25.031}, {-24.115, -24.791}, {-25.584, -21.058}, {-26.484, -25.525}, {-27.532, -26.063}, {-25.795, -26.285}, {-26.158, -27.779}, {-25.579, -23.804}, {-24.106, -24.906}, {-26.399, -25.261}, {-25.846, -24.155}, {-25.994, -21.092}, {-25.696, -23.659}, {-27.058, -24.226}, {-25.134, -23.835}},
+        {{0.981, 0.979}, {0.986, 0.960}, {0.969, 0.975}, {0.974, 0.983}, {0.965, 0.968}, {0.968, 0.971}, {0.969, 0.966}, {0.967, 0.962}, {0.970, 0.971}, {0.971, 0.973}, {0.969, 0.966}, {0.969, 0.974}, {0.962, 0.985}, {0.969, 0.976}, {0.969, 0.971}, {0.973, 0.976}},
+        {-13.422, -14.784}}},
+    // sweep, split_ear, 44100 Hz
+    {0, 2, 44100, {
+        {{-16.300, -12.601}, {-11.665, -12.035}, {-12.481, -12.022}, {-13.343, -12.037}, {-17.529, -12.014}, {-25.277, -12.075}, {-33.086, -12.189}, {-40.659, -12.606}, {-48.027, -14.561}, {-55.584, -18.624}, {-63.153, -25.431}, {-70.764, -32.265}, {-78.524, -40.151}, {-86.706, -48.260}, {-95.914, -54.258}, {-100.000, -60.752}},
+        {{0.968, 1.000}, {0.823, 0.999}, {0.691, 0.996}, {0.153, 0.989}, {-0.389, 0.972}, {-0.767, 0.930}, {-0.904, 0.830}, {-0.940, 0.594}, {-0.958, 0.124}, {-0.966, -0.403}, {-0.968, -0.727}, {-0.968, -0.899}, {-0.967, -0.939}, {-0.962, -0.976}, {-0.945, -0.975}, {-0.859, -0.963}},
+        {-9.113, -8.992}}},
+    // impulse, split_ear, 44100 Hz
+    {1, 2, 44100, {
+        {{-59.552, -100.000}, {-87.108, -36.219}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.001, 0.000}, {0.000, 0.963}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-53.679, -9.453}}},
+    // pink, split_ear, 44100 Hz
+    {2, 2, 44100, {
+        {{-36.411, -27.941}, {-20.078, -26.176}, {-25.847, -27.611}, {-27.998, -26.873}, {-29.382, -27.065}, {-35.483, -26.938}, {-28.045, -27.452}, {-31.052, -27.568}, {-29.160, -27.558}, {-26.829, -27.595}, {-31.447, -27.190}, {-32.419, -26.750}, {-28.533, -26.999}, {-29.352, -28.110}, {-34.373, -26.795}, {-30.189, -27.242}},
+        {{0.455, 0.675}, {0.772, 0.505}, {0.462, 0.552}, {0.433, 0.382}, {0.389, 0.559}, {0.107, 0.596}, {0.451, 0.509}, {0.238, 0.672}, {0.404, 0.422}, {0.506, 0.503}, {0.424, 0.499}, {0.237, 0.469}, {0.156, 0.399}, {0.460, 0.434}, {0.275, 0.449}, {0.480, 0.508}},
+        {-17.151, -17.278}}},
+    // sweep, 3d, 44100 Hz
+    {0, 3, 44100, {
+        {{-16.799, -16.838}, {-16.127, -15.341}, {-13.590, -12.777}, {-12.453, -11.346}, {-13.817, -10.663}, {-11.244, -9.119}, {-9.095, -9.910}, {-9.443, -8.874}, {-9.357, -8.535}, {-9.516, -10.962}, {-9.710, -9.147}, {-9.505, -13.400}, {-11.166, -13.262}, {-12.581, -12.051}, {-13.606, -13.833}, {-13.514, -15.313}},
+        {{0.931, 0.332}, {0.794, 0.070}, {0.816, 0.320}, {0.799, 0.522}, {0.602, 0.705}, {0.592, 0.701}, {0.860, 0.772}, {0.721, 0.781}, {0.781, 0.795}, {0.769, 0.676}, {0.712, 0.783}, {0.630, 0.446}, {0.598, 0.713}, {0.376, 0.827}, {0.106, 0.721}, {0.125, 0.771}},
+        {-1.575, -1.494}}},
+    // impulse, 3d, 44100 Hz
+    {1, 3, 44100, {
+        {{-38.028, -43.067}, {-45.921, -39.497}, {-44.486, -42.803}, {-51.434, -49.312}, {-99.167, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.525, 0.000}, {0.000, 0.621}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-15.436, -15.432}}},
+    // pink, 3d, 44100 Hz
+    {2, 3, 44100, {
+        {{-26.068, -26.670}, {-22.288, -20.589}, {-21.289, -23.973}, {-23.051, -20.840}, {-23.798, -22.624}, {-23.144, -23.193}, {-24.333, -23.598}, {-25.001, -24.246}, {-23.623, -22.737}, {-21.364, -22.543}, {-22.861, -23.096}, {-23.350, -22.714}, {-21.179, -23.442}, {-22.401, -22.540}, {-22.929, -23.074}, {-23.129, -23.265}},
+        {{0.759, 0.694}, {0.718, 0.535}, {0.820, 0.627}, {0.569, 0.805}, {0.588, 0.650}, {0.635, 0.620}, {0.554, 0.567}, {0.682, 0.593}, {0.654, 0.761}, {0.736, 0.714}, {0.707, 0.701}, {0.687, 0.690}, {0.600, 0.681}, {0.718, 0.730}, {0.612, 0.636}, {0.676, 0.706}},
+        {-11.990, -9.605}}},
+    // sweep, bass_boost, 44100 Hz
+    {0, 4, 44100, {
+        {{-14.187, -15.585}, {-13.451, -15.019}, {-12.255, -15.004}, {-13.325, -15.021}, {-13.712, -14.995}, {-14.726, -15.035}, {-14.802, -14.989}, {-15.085, -15.052}, {-15.022, -14.883}, {-14.990, -14.945}, {-15.013, -14.866}, {-15.014, -13.672}, {-15.003, -13.347}, {-15.012, -13.749}, {-15.009, -13.408}, {-15.005, -11.970}},
+        {{1.000, 1.000}, {0.999, 1.000}, {0.999, 1.000}, {0.994, 1.000}, {0.987, 1.000}, {0.987, 1.000}, {0.996, 1.000}, {0.998, 1.000}, {0.999, 0.999}, {1.000, 0.997}, {1.000, 0.991}, {1.000, 0.990}, {1.000, 0.991}, {1.000, 0.996}, {1.000, 0.999}, {1.000, 1.000}},
+        {-10.011, -10.000}}},
+    // impulse, bass_boost, 44100 Hz
+    {1, 4, 44100, {
+        {{-39.075, -100.000}, {-100.000, -39.075}, {-100.000, -92.692}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{1.000, 0.000}, {0.000, 1.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-11.985, -11.985}}},
+    // pink, bass_boost, 44100 Hz
+    {2, 4, 44100, {
+        {{-27.437, -28.086}, {-19.942, -25.428}, {-24.692, -25.542}, {-26.130, -21.886}, {-27.118, -26.100}, {-27.717, -26.383}, {-26.512, -26.842}, {-26.566, -28.275}, {-26.151, -24.445}, {-24.737, -25.622}, {-26.916, -25.717}, {-26.229, -24.717}, {-26.537, -21.967}, {-26.231, -24.463}, {-27.497, -24.877}, {-25.754, -24.587}},
+        {{0.997, 0.997}, {0.995, 0.991}, {0.992, 0.993}, {0.994, 0.995}, {0.992, 0.992}, {0.996, 0.995}, {0.991, 0.992}, {0.993, 0.992}, {0.992, 0.991}, {0.992, 0.993}, {0.993, 0.992}, {0.994, 0.993}, {0.990, 0.995}, {0.993, 0.992}, {0.994, 0.992}, {0.993, 0.993}},
+        {-14.125, -14.825}}},
+    // sweep, limiter, 44100 Hz
+    {0, 5, 44100, {
+        {{-6.455, -3.874}, {-5.267, -3.329}, {-3.108, -3.969}, {-3.433, -5.708}, {-3.734, -6.345}, {-5.255, -6.146}, {-5.406, -5.733}, {-5.483, -5.459}, {-5.170, -5.004}, {-4.926, -4.739}, {-4.732, -4.168}, {-5.076, -2.934}, {-5.525, -3.010}, {-3.894, -4.033}, {-3.282, -4.650}, {-3.299, -3.925}},
+        {{0.999, 0.994}, {0.996, 0.961}, {0.993, 0.895}, {0.973, 0.903}, {0.942, 0.962}, {0.941, 0.989}, {0.983, 0.998}, {0.996, 1.000}, {1.000, 0.998}, {0.999, 0.988}, {0.992, 0.960}, {0.971, 0.955}, {0.921, 0.961}, {0.885, 0.978}, {0.945, 0.993}, {0.990, 0.999}},
+        {-0.300, -0.300}}},
+    // impulse, limiter, 44100 Hz
+    {1, 5, 44100, {
+        {{-26.872, -100.000}, {-100.000, -26.872}, {-100.000, -74.543}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.942, 0.000}, {0.000, 0.942}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-0.300, -0.300}}},
+    // pink, limiter, 44100 Hz
+    {2, 5, 44100, {
+        {{-14.311, -14.776}, {-6.476, -12.315}, {-11.355, -11.933}, {-12.726, -8.432}, {-13.441, -12.629}, {-14.430, -13.170}, {-12.840, -13.390}, {-13.275, -14.629}, {-12.744, -11.183}, {-11.433, -12.073}, {-13.478, -12.485}, {-13.126, -11.474}, {-13.062, -8.419}, {-12.813, -10.915}, {-13.938, -11.451}, {-12.274, -11.112}},
+        {{0.954, 0.944}, {0.979, 0.934}, {0.953, 0.957}, {0.950, 0.975}, {0.938, 0.944}, {0.933, 0.947}, {0.947, 0.936}, {0.937, 0.919}, {0.944, 0.950}, {0.952, 0.954}, {0.941, 0.944}, {0.947, 0.954}, {0.933, 0.978}, {0.944, 0.957}, {0.937, 0.951}, {0.954, 0.958}},
+        {-0.733, -1.736}}},
+    // sweep, binaural, 44100 Hz
+    {0, 6, 44100, {
+        {{-25.980, -21.184}, {-20.035, -16.999}, {-21.043, -17.635}, {-20.323, -17.166}, {-20.698, -17.842}, {-20.945, -18.061}, {-21.403, -19.182}, {-20.682, -18.888}, {-20.504, -19.829}, {-18.887, -20.789}, {-18.766, -21.171}, {-17.968, -20.713}, {-18.119, -21.215}, {-17.365, -20.699}, {-17.636, -21.180}, {-16.776, -19.474}},
+        {{0.887, -0.005}, {0.715, -0.003}, {0.487, 0.017}, {-0.129, 0.009}, {-0.743, -0.061}, {-0.463, 0.001}, {0.592, 0.030}, {-0.311, -0.139}, {-0.017, -0.023}, {0.162, 0.216}, {-0.098, 0.205}, {0.050, -0.836}, {-0.034, -0.398}, {0.008, -0.029}, {-0.002, 0.572}, {-0.000, 0.908}},
+        {-10.746, -10.660}}},
+    // impulse, binaural, 44100 Hz
+    {1, 6, 44100, {
+        {{-44.522, -54.689}, {-100.000, -100.000}, {-54.689, -44.522}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-19.544, -19.544}}},
+    // pink, binaural, 44100 Hz
+    {2, 6, 44100, {
+        {{-36.997, -36.290}, {-29.691, -28.460}, {-28.725, -29.489}, {-27.143, -26.793}, {-32.639, -32.061}, {-31.213, -31.249}, {-33.717, -33.672}, {-31.503, -31.513}, {-30.418, -30.032}, {-28.224, -28.268}, {-30.689, -30.749}, {-31.035, -30.797}, {-28.987, -29.409}, {-28.545, -28.872}, {-30.592, -29.802}, {-29.458, -29.680}},
+        {{0.193, -0.226}, {0.419, 0.015}, {0.520, -0.002}, {0.101, 0.756}, {0.057, 0.321}, {-0.100, 0.168}, {-0.066, 0.008}, {-0.025, 0.096}, {0.132, 0.213}, {0.481, 0.407}, {0.122, 0.067}, {0.116, 0.388}, {0.119, 0.473}, {0.381, 0.584}, {0.202, 0.495}, {0.367, 0.530}},
+        {-19.149, -19.117}}},
+    // sweep, bypass, 48000 Hz
+    {0, 0, 48000, {
+        {{-16.794, -15.759}, {-15.145, -15.016}, {-14.633, -15.009}, {-15.029, -15.004}, {-14.840, -15.004}, {-14.849, -15.002}, {-15.094, -14.999}, {-14.967, -15.011}, {-15.022, -14.968}, {-14.975, -15.004}, {-15.040, -14.925}, {-14.996, -15.152}, {-15.015, -15.301}, {-15.005, -14.823}, {-15.013, -15.679}, {-15.008, -14.024}},
+        {{1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}},
+        {-12.000, -12.000}}},
+    // impulse, bypass, 48000 Hz
+    {1, 0, 48000, {
+        {{-39.093, -100.000}, {-100.000, -39.093}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{1.000, 0.000}, {0.000, 1.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-12.000, -12.000}}},
+    // pink, bypass, 48000 Hz
+    {2, 0, 48000, {
+        {{-29.183, -29.270}, {-21.428, -25.843}, {-25.759, -26.630}, {-27.085, -23.388}, {-27.741, -26.961}, {-28.175, -27.396}, {-27.419, -27.147}, {-27.128, -28.676}, {-27.145, -25.557}, {-25.577, -26.631}, {-27.623, -26.630}, {-26.926, -25.809}, {-27.389, -23.458}, {-26.986, -25.736}, {-28.011, -25.738}, {-26.789, -25.805}},
+        {{1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}},
+        {-15.518, -15.494}}},
+    // sweep, eq, 48000 Hz
+    {0, 1, 48000, {
+        {{-14.193, -13.667}, {-12.002, -13.003}, {-11.839, -13.468}, {-12.174, -14.423}, {-12.786, -15.136}, {-14.408, -15.772}, {-15.246, -16.969}, {-15.752, -17.515}, {-17.116, -16.119}, {-17.415, -15.365}, {-16.113, -14.612}, {-15.304, -13.649}, {-14.705, -12.933}, {-13.739, -12.218}, {-13.084, -12.622}, {-12.921, -10.871}},
+        {{0.999, 0.999}, {0.997, 0.995}, {0.994, 0.983}, {0.982, 0.977}, {0.966, 0.981}, {0.961, 0.982}, {0.972, 0.988}, {0.978, 0.993}, {0.986, 0.978}, {0.993, 0.976}, {0.982, 0.971}, {0.982, 0.961}, {0.978, 0.968}, {0.979, 0.990}, {0.992, 0.995}, {0.998, 0.999}},
+        {-9.014, -8.995}}},
+    // impulse, eq, 48000 Hz
+    {1, 1, 48000, {
+        {{-37.570, -100.000}, {-100.000, -37.571}, {-100.000, -81.613}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.985, 0.000}, {0.000, 0.985}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-10.606, -10.606}}},
+    // pink, eq, 48000 Hz
+    {2, 1, 48000, {
+        {{-28.431, -28.694}, {-18.929, -24.769}, {-24.110, -24.769}, {-25.793, -21.052}, {-26.258, -25.533}, {-27.651, -26.433}, {-25.625, -25.991}, {-26.201, -27.694}, {-25.681, -23.911}, {-24.034, -24.824}, {-26.418, -25.361}, {-25.932, -24.379}, {-25.997, -21.051}, {-25.668, -23.647}, {-27.080, -24.084}, {-25.247, -23.842}},
+        {{0.976, 0.977}, {0.985, 0.962}, {0.969, 0.976}, {0.973, 0.984}, {0.967, 0.966}, {0.966, 0.970}, {0.973, 0.969}, {0.965, 0.961}, {0.971, 0.970}, {0.970, 0.974}, {0.971, 0.966}, {0.974, 0.973}, {0.957, 0.986}, {0.969, 0.975}, {0.972, 0.973}, {0.973, 0.976}},
+        {-13.411, -14.803}}},
+    // sweep, split_ear, 48000 Hz
+    {0, 2, 48000, {
+        {{-17.876, -12.775}, {-10.996, -12.031}, {-12.776, -12.026}, {-13.396, -12.024}, {-18.410, -12.021}, {-24.979, -12.047}, {-33.507, -12.161}, {-40.951, -12.544}, {-48.563, -14.199}, {-56.203, -18.038}, {-63.908, -24.245}, {-71.534, -31.765}, {-79.409, -39.791}, {-87.617, -46.807}, {-96.860, -54.231}, {-100.000, -60.414}},
+        {{0.966, 1.000}, {0.870, 0.999}, {0.612, 0.996}, {0.301, 0.990}, {-0.475, 0.976}, {-0.823, 0.941}, {-0.908, 0.852}, {-0.946, 0.642}, {-0.958, 0.187}, {-0.965, -0.340}, {-0.968, -0.716}, {-0.968, -0.871}, {-0.967, -0.958}, {-0.961, -0.970}, {-0.945, -0.968}, {-0.864, -0.960}},
+        {-9.125, -8.794}}},
+    // impulse, split_ear, 48000 Hz
+    {1, 2, 48000, {
+        {{-59.920, -100.000}, {-87.209, -36.210}, {-100.000, -93.931}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.001, 0.000}, {0.000, 0.966}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-54.415, -9.418}}},
+    // pink, split_ear, 48000 Hz
+    {2, 2, 48000, {
+        {{-37.149, -28.070}, {-20.284, -26.012}, {-25.740, -27.558}, {-27.451, -26.878}, {-29.488, -26.819}, {-35.664, -26.953}, {-28.198, -27.303}, {-31.373, -27.452}, {-29.198, -27.419}, {-27.048, -27.571}, {-31.774, -27.050}, {-32.475, -26.769}, {-28.754, -26.794}, {-29.538, -28.060}, {-34.465, -26.573}, {-30.995, -27.225}},
+        {{0.380, 0.746}, {0.756, 0.492}, {0.441, 0.556}, {0.419, 0.401}, {0.386, 0.553}, {0.086, 0.597}, {0.445, 0.537}, {0.202, 0.675}, {0.419, 0.425}, {0.502, 0.494}, {0.417, 0.511}, {0.211, 0.502}, {0.129, 0.403}, {0.477, 0.412}, {0.255, 0.465}, {0.462, 0.508}},
+        {-17.436, -17.249}}},
+    // sweep, 3d, 48000 Hz
+    {0, 3, 48000, {
+        {{-16.989, -15.766}, {-15.098, -13.282}, {-13.218, -12.174}, {-12.481, -11.089}, {-13.157, -10.511}, {-11.078, -9.340}, {-9.252, -9.342}, {-9.871, -9.829}, {-9.894, -8.127}, {-9.277, -11.631}, {-9.377, -8.741}, {-9.618, -12.763}, {-10.869, -13.532}, {-12.265, -11.796}, {-13.006, -13.374}, {-12.136, -14.693}},
+        {{0.894, 0.291}, {0.694, 0.055}, {0.763, 0.279}, {0.765, 0.527}, {0.631, 0.676}, {0.612, 0.692}, {0.830, 0.803}, {0.738, 0.747}, {0.809, 0.807}, {0.816, 0.701}, {0.717, 0.831}, {0.642, 0.409}, {0.592, 0.649}, {0.385, 0.820}, {0.112, 0.704}, {0.095, 0.688}},
+        {-1.943, -1.868}}},
+    // impulse, 3d, 48000 Hz
+    {1, 3, 48000, {
+        {{-37.130, -45.762}, {-43.680, -38.047}, {-42.534, -40.052}, {-48.878, -46.286}, {-75.718, -84.241}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.473, 0.000}, {0.000, 0.527}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-13.774, -13.774}}},
+    // pink, 3d, 48000 Hz
+    {2, 3, 48000, {
+        {{-26.270, -26.628}, {-22.600, -20.116}, {-21.070, -23.590}, {-22.510, -20.786}, {-23.934, -22.745}, {-23.500, -24.090}, {-23.368, -23.075}, {-23.529, -24.840}, {-23.559, -22.962}, {-20.933, -22.528}, {-22.687, -23.015}, {-23.424, -22.249}, {-20.825, -23.131}, {-22.130, -21.772}, {-22.916, -22.731}, {-23.220, -22.964}},
+        {{0.738, 0.714}, {0.705, 0.577}, {0.765, 0.604}, {0.603, 0.768}, {0.546, 0.628}, {0.603, 0.617}, {0.542, 0.539}, {0.691, 0.527}, {0.598, 0.690}, {0.739, 0.715}, {0.724, 0.682}, {0.617, 0.735}, {0.601, 0.681}, {0.744, 0.724}, {0.566, 0.663}, {0.638, 0.726}},
+        {-11.185, -9.881}}},
+    // sweep, bass_boost, 48000 Hz
+    {0, 4, 48000, {
+        {{-15.020, -15.759}, {-13.068, -15.016}, {-12.755, -15.009}, {-13.133, -15.004}, {-13.444, -15.004}, {-14.443, -15.002}, {-14.989, -14.997}, {-14.943, -15.010}, {-15.028, -14.947}, {-14.974, -14.942}, {-15.041, -14.604}, {-14.997, -14.127}, {-15.016, -13.711}, {-15.005, -13.049}, {-15.013, -13.647}, {-15.008, -11.937}},
+        {{1.000, 1.000}, {0.999, 1.000}, {0.998, 1.000}, {0.994, 1.000}, {0.989, 1.000}, {0.989, 1.000}, {0.995, 1.000}, {0.999, 1.000}, {0.999, 0.999}, {1.000, 0.997}, {1.000, 0.993}, {1.000, 0.987}, {1.000, 0.989}, {1.000, 0.997}, {1.000, 0.998}, {1.000, 1.000}},
+        {-10.010, -9.999}}},
+    // impulse, bass_boost, 48000 Hz
+    {1, 4, 48000, {
+        {{-39.076, -100.000}, {-100.000, -39.076}, {-100.000, -86.972}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{1.000, 0.000}, {0.000, 1.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-11.986, -11.986}}},
+    // pink, bass_boost, 48000 Hz
+    {2, 4, 48000, {
+        {{-28.772, -28.985}, {-19.791, -25.153}, {-24.713, -25.516}, {-26.308, -21.884}, {-26.914, -26.135}, {-27.894, -26.796}, {-26.373, -26.497}, {-26.584, -28.251}, {-26.318, -24.543}, {-24.610, -25.551}, {-26.948, -25.830}, {-26.278, -24.902}, {-26.597, -21.912}, {-26.211, -24.484}, {-27.526, -24.745}, {-25.841, -24.618}},
+        {{0.997, 0.998}, {0.995, 0.991}, {0.992, 0.993}, {0.993, 0.995}, {0.992, 0.992}, {0.996, 0.994}, {0.992, 0.993}, {0.993, 0.992}, {0.992, 0.991}, {0.992, 0.993}, {0.993, 0.992}, {0.995, 0.993}, {0.989, 0.995}, {0.993, 0.991}, {0.995, 0.993}, {0.993, 0.992}},
+        {-14.124, -14.841}}},
+    // sweep, limiter, 48000 Hz
+    {0, 5, 48000, {
+        {{-7.361, -4.049}, {-4.931, -3.309}, {-3.952, -3.765}, {-3.376, -5.450}, {-3.626, -6.360}, {-5.291, -6.243}, {-5.765, -5.889}, {-5.492, -5.565}, {-5.315, -5.214}, {-5.038, -4.920}, {-4.871, -4.076}, {-4.907, -3.161}, {-5.174, -3.398}, {-3.662, -3.480}, {-3.308, -5.054}, {-3.297, -3.888}},
+        {{0.999, 0.995}, {0.996, 0.969}, {0.990, 0.906}, {0.972, 0.893}, {0.948, 0.953}, {0.951, 0.986}, {0.983, 0.997}, {0.997, 1.000}, {1.000, 0.998}, {0.998, 0.990}, {0.991, 0.970}, {0.967, 0.948}, {0.912, 0.955}, {0.890, 0.982}, {0.952, 0.991}, {0.991, 0.999}},
+        {-0.300, -0.300}}},
+    // impulse, limiter, 48000 Hz
+    {1, 5, 48000, {
+        {{-26.902, -100.000}, {-96.174, -26.903}, {-100.000, -69.567}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.945, 0.000}, {0.000, 0.945}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-0.300, -0.300}}},
+    // pink, limiter, 48000 Hz
+    {2, 5, 48000, {
+        {{-15.264, -15.445}, {-6.387, -12.047}, {-11.316, -11.896}, {-12.823, -8.399}, {-13.237, -12.613}, {-14.450, -13.452}, {-12.640, -13.090}, {-13.254, -14.477}, {-12.790, -11.273}, {-11.335, -11.952}, {-13.440, -12.544}, {-13.170, -11.631}, {-13.030, -8.362}, {-12.741, -10.889}, {-13.909, -11.273}, {-12.373, -11.079}},
+        {{0.942, 0.935}, {0.978, 0.937}, {0.952, 0.957}, {0.947, 0.975}, {0.941, 0.941}, {0.928, 0.943}, {0.951, 0.940}, {0.935, 0.919}, {0.944, 0.947}, {0.951, 0.956}, {0.941, 0.943}, {0.949, 0.951}, {0.929, 0.978}, {0.944, 0.957}, {0.937, 0.953}, {0.954, 0.956}},
+        {-0.683, -1.755}}},
+    // sweep, binaural, 48000 Hz
+    {0, 6, 48000, {
+        {{-27.223, -21.488}, {-19.530, -16.758}, {-21.098, -17.529}, {-20.647, -17.633}, {-21.236, -17.838}, {-20.862, -18.047}, {-21.181, -18.791}, {-20.829, -19.264}, {-18.372, -21.573}, {-18.967, -20.917}, {-18.818, -21.331}, {-18.087, -21.180}, {-17.667, -20.517}, {-17.718, -21.460}, {-17.576, -21.068}, {-16.700, -19.296}},
+        {{0.877, 0.005}, {0.809, -0.003}, {0.458, 0.015}, {0.120, 0.006}, {-0.698, -0.047}, {-0.643, -0.024}, {0.507, 0.018}, {-0.310, -0.041}, {0.308, -0.167}, {0.079, 0.333}, {0.029, 0.015}, {-0.075, -0.820}, {0.040, -0.380}, {-0.015, 0.037}, {0.005, 0.606}, {-0.001, 0.925}},
+        {-10.734, -10.826}}},
+    // impulse, binaural, 48000 Hz
+    {1, 6, 48000, {
+        {{-44.175, -54.993}, {-100.000, -100.000}, {-54.993, -44.175}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-17.406, -17.406}}},
+    // pink, binaural, 48000 Hz
+    {2, 6, 48000, {
+        {{-37.061, -36.357}, {-30.101, -28.771}, {-28.475, -29.235}, {-27.215, -26.750}, {-32.889, -32.209}, {-30.896, -31.031}, {-33.419, -33.258}, {-31.595, -31.651}, {-30.781, -30.139}, {-28.061, -28.265}, {-30.506, -30.519}, {-30.896, -30.788}, {-29.051, -29.541}, {-28.835, -29.114}, {-30.149, -29.521}, {-29.274, -29.543}},
+        {{0.167, -0.130}, {0.421, 0.023}, {0.511, -0.058}, {0.149, 0.757}, {-0.048, 0.295}, {-0.062, 0.150}, {-0.048, 0.065}, {-0.037, 0.061}, {0.086, 0.213}, {0.523, 0.413}, {0.124, 0.066}, {0.132, 0.418}, {0.132, 0.469}, {0.405, 0.568}, {0.171, 0.528}, {0.350, 0.516}},
+        {-18.751, -19.279}}},
+    // sweep, bypass, 96000 Hz
+    {0, 0, 96000, {
+        {{-23.688, -16.454}, {-13.283, -15.009}, {-16.381, -15.017}, {-14.743, -15.016}, {-14.272, -14.987}, {-15.371, -15.001}, {-14.839, -15.072}, {-15.091, -14.917}, {-15.009, -14.978}, {-15.032, -15.201}, {-15.020, -14.712}, {-15.023, -15.185}, {-15.022, -15.724}, {-14.998, -15.193}, {-15.014, -13.258}, {-15.018, -16.116}},
+        {{1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}},
+        {-12.000, -12.000}}},
+    // impulse, bypass, 96000 Hz
+    {1, 0, 96000, {
+        {{-39.093, -100.000}, {-100.000, -39.093}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{1.000, 0.000}, {0.000, 1.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-12.000, -12.000}}},
+    // pink, bypass, 96000 Hz
+    {2, 0, 96000, {
+        {{-30.654, -30.823}, {-21.499, -25.696}, {-25.367, -26.644}, {-27.542, -23.436}, {-27.410, -26.567}, {-28.129, -28.063}, {-27.247, -27.336}, {-27.229, -28.020}, {-26.834, -25.460}, {-25.688, -26.485}, {-27.615, -26.651}, {-27.741, -26.281}, {-26.512, -23.690}, {-27.113, -25.147}, {-28.467, -25.703}, {-27.063, -25.755}},
+        {{1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}, {1.000, 1.000}},
+        {-15.518, -15.494}}},
+    // sweep, eq, 96000 Hz
+    {0, 1, 96000, {
+        {{-21.907, -14.355}, {-10.567, -12.917}, {-12.988, -12.980}, {-12.035, -13.275}, {-12.613, -14.117}, {-15.356, -15.013}, {-15.275, -15.760}, {-16.574, -16.851}, {-17.609, -17.338}, {-16.370, -16.228}, {-15.383, -14.752}, {-14.696, -14.341}, {-13.717, -14.339}, {-13.072, -12.350}, {-12.938, -10.590}, {-12.921, -12.550}},
+        {{0.999, 1.000}, {1.000, 0.999}, {0.989, 0.996}, {0.982, 0.987}, {0.971, 0.977}, {0.950, 0.980}, {0.978, 0.981}, {0.978, 0.988}, {0.995, 0.992}, {0.981, 0.975}, {0.981, 0.979}, {0.977, 0.965}, {0.979, 0.953}, {0.992, 0.983}, {0.998, 0.997}, {0.999, 1.000}},
+        {-9.048, -8.977}}},
+    // impulse, eq, 96000 Hz
+    {1, 1, 96000, {
+        {{-37.284, -100.000}, {-93.118, -37.287}, {-100.000, -69.840}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.992, 0.000}, {0.000, 0.992}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-10.265, -10.265}}},
+    // pink, eq, 96000 Hz
+    {2, 1, 96000, {
+        {{-29.791, -29.873}, {-19.316, -24.801}, {-23.813, -25.188}, {-25.500, -21.224}, {-26.041, -24.902}, {-27.512, -26.744}, {-25.598, -26.165}, {-26.436, -27.283}, {-25.570, -24.681}, {-24.295, -24.355}, {-26.518, -25.622}, {-26.992, -25.292}, {-25.444, -21.345}, {-25.711, -23.205}, {-27.503, -23.927}, {-26.017, -23.739}},
+        {{0.972, 0.977}, {0.985, 0.968}, {0.964, 0.972}, {0.960, 0.986}, {0.969, 0.965}, {0.969, 0.957}, {0.973, 0.967}, {0.966, 0.971}, {0.970, 0.975}, {0.971, 0.971}, {0.976, 0.968}, {0.966, 0.968}, {0.966, 0.985}, {0.973, 0.977}, {0.974, 0.972}, {0.980, 0.975}},
+        {-13.602, -14.732}}},
+    // sweep, split_ear, 96000 Hz
+    {0, 2, 96000, {
+        {{-32.744, -13.470}, {-13.800, -12.025}, {-10.536, -12.034}, {-14.462, -12.032}, {-17.956, -12.007}, {-28.649, -12.028}, {-36.795, -12.107}, {-45.573, -12.161}, {-53.836, -12.773}, {-62.197, -14.547}, {-70.520, -19.449}, {-78.907, -26.920}, {-87.392, -36.062}, {-96.155, -42.187}, {-100.000, -50.222}, {-100.000, -61.985}},
+        {{0.949, 1.000}, {0.977, 1.000}, {0.741, 0.999}, {0.284, 0.997}, {-0.702, 0.992}, {-0.895, 0.979}, {-0.942, 0.943}, {-0.954, 0.855}, {-0.961, 0.604}, {-0.963, 0.142}, {-0.964, -0.525}, {-0.963, -0.778}, {-0.962, -0.941}, {-0.957, -0.992}, {-0.944, -0.957}, {-0.879, -0.872}},
+        {-9.393, -8.999}}},
+    // impulse, split_ear, 96000 Hz
+    {1, 2, 96000, {
+        {{-64.297, -100.000}, {-68.633, -36.162}, {-90.369, -67.216}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.000, 0.000}, {0.000, 0.983}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-60.438, -9.217}}},
+    // pink, split_ear, 96000 Hz
+    {2, 2, 96000, {
+        {{-44.830, -28.288}, {-23.161, -25.267}, {-23.217, -26.717}, {-26.976, -26.298}, {-32.272, -26.190}, {-33.690, -26.486}, {-30.747, -26.202}, {-35.761, -26.944}, {-29.862, -26.019}, {-29.030, -26.696}, {-29.838, -26.282}, {-31.901, -25.940}, {-32.732, -26.557}, {-32.406, -26.710}, {-31.574, -25.546}, {-33.144, -27.030}},
+        {{0.201, 0.898}, {0.719, 0.562}, {0.168, 0.594}, {0.364, 0.413}, {-0.035, 0.640}, {0.234, 0.741}, {0.287, 0.649}, {0.250, 0.689}, {0.377, 0.393}, {0.555, 0.604}, {0.406, 0.583}, {0.164, 0.578}, {-0.009, 0.465}, {0.480, 0.433}, {0.247, 0.624}, {0.415, 0.528}},
+        {-20.152, -16.827}}},
+    // sweep, 3d, 96000 Hz
+    {0, 3, 96000, {
+        {{-22.620, -19.464}, {-13.960, -14.384}, {-15.095, -12.017}, {-12.534, -10.920}, {-12.784, -10.456}, {-10.140, -9.215}, {-10.320, -9.902}, {-9.633, -9.222}, {-9.027, -10.259}, {-9.065, -10.044}, {-9.587, -11.524}, {-9.168, -9.402}, {-10.046, -13.515}, {-11.238, -13.045}, {-13.103, -11.208}, {-12.159, -14.953}},
+        {{0.845, 0.449}, {0.927, 0.059}, {0.604, 0.302}, {0.786, 0.553}, {0.719, 0.728}, {0.644, 0.697}, {0.803, 0.795}, {0.733, 0.755}, {0.767, 0.788}, {0.732, 0.814}, {0.763, 0.642}, {0.665, 0.700}, {0.618, 0.436}, {0.445, 0.660}, {0.193, 0.855}, {0.043, 0.496}},
+        {-1.972, -2.108}}},
+    // impulse, 3d, 96000 Hz
+    {1, 3, 96000, {
+        {{-39.511, -48.136}, {-39.318, -36.044}, {-49.031, -40.714}, {-41.823, -50.315}, {-50.549, -42.065}, {-87.448, -78.920}, {-49.990, -58.504}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.621, 0.000}, {0.000, 0.824}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-13.674, -10.628}}},
+    // pink, 3d, 96000 Hz
+    {2, 3, 96000, {
+        {{-28.330, -28.338}, {-20.728, -20.990}, {-20.440, -22.766}, {-22.510, -20.251}, {-23.732, -21.402}, {-23.174, -22.368}, {-23.013, -22.786}, {-23.217, -23.400}, {-22.472, -21.531}, {-20.714, -20.831}, {-23.201, -22.854}, {-22.437, -22.410}, {-21.743, -22.155}, {-20.241, -21.674}, {-23.865, -21.873}, {-21.728, -22.408}},
+        {{0.774, 0.748}, {0.799, 0.637}, {0.737, 0.272}, {0.625, 0.845}, {0.524, 0.692}, {0.607, 0.629}, {0.568, 0.637}, {0.532, 0.542}, {0.543, 0.761}, {0.722, 0.753}, {0.651, 0.636}, {0.681, 0.620}, {0.549, 0.675}, {0.741, 0.722}, {0.576, 0.748}, {0.728, 0.652}},
+        {-9.543, -10.855}}},
+    // sweep, bass_boost, 96000 Hz
+    {0, 4, 96000, {
+        {{-22.375, -16.454}, {-11.436, -15.009}, {-14.164, -15.017}, {-12.930, -15.016}, {-13.103, -14.987}, {-15.233, -15.001}, {-14.794, -15.071}, {-15.096, -14.914}, {-15.007, -14.968}, {-15.033, -15.190}, {-15.020, -14.529}, {-15.023, -14.572}, {-15.022, -14.766}, {-14.998, -13.288}, {-15.014, -11.433}, {-15.018, -13.777}},
+        {{1.000, 1.000}, {1.000, 1.000}, {0.996, 1.000}, {0.994, 1.000}, {0.991, 1.000}, {0.988, 1.000}, {0.998, 1.000}, {0.999, 1.000}, {1.000, 1.000}, {1.000, 0.999}, {1.000, 0.997}, {1.000, 0.991}, {1.000, 0.985}, {1.000, 0.994}, {1.000, 0.999}, {1.000, 1.000}},
+        {-10.024, -9.978}}},
+    // impulse, bass_boost, 96000 Hz
+    {1, 4, 96000, {
+        {{-39.084, -100.000}, {-98.257, -39.085}, {-100.000, -76.115}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{1.000, 0.000}, {0.000, 1.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-11.993, -11.993}}},
+    // pink, bass_boost, 96000 Hz
+    {2, 4, 96000, {
+        {{-30.411, -30.761}, {-20.081, -25.200}, {-24.392, -25.884}, {-26.541, -22.057}, {-26.754, -25.674}, {-27.933, -27.545}, {-26.431, -26.731}, {-26.817, -27.851}, {-26.213, -25.040}, {-24.888, -25.253}, {-27.106, -26.130}, {-27.439, -25.765}, {-25.992, -22.225}, {-26.437, -24.008}, {-28.192, -24.666}, {-26.554, -24.616}},
+        {{0.997, 0.999}, {0.995, 0.994}, {0.991, 0.992}, {0.987, 0.995}, {0.992, 0.990}, {0.997, 0.989}, {0.992, 0.993}, {0.995, 0.996}, {0.993, 0.996}, {0.993, 0.990}, {0.996, 0.993}, {0.994, 0.993}, {0.992, 0.994}, {0.994, 0.993}, {0.996, 0.993}, {0.996, 0.991}},
+        {-14.313, -14.978}}},
+    // sweep, limiter, 96000 Hz
+    {0, 5, 96000, {
+        {{-15.307, -4.745}, {-3.715, -3.299}, {-5.892, -3.314}, {-4.623, -3.657}, {-5.092, -5.455}, {-7.894, -7.138}, {-7.243, -7.439}, {-7.223, -7.035}, {-6.825, -6.771}, {-6.525, -6.703}, {-6.018, -5.600}, {-4.567, -4.821}, {-3.358, -5.732}, {-3.292, -4.985}, {-3.304, -3.747}, {-3.298, -5.472}},
+        {{0.999, 0.999}, {0.999, 0.994}, {0.984, 0.976}, {0.971, 0.925}, {0.956, 0.885}, {0.944, 0.938}, {0.992, 0.982}, {0.999, 0.997}, {0.999, 1.000}, {0.992, 0.997}, {0.968, 0.988}, {0.907, 0.959}, {0.891, 0.932}, {0.952, 0.976}, {0.986, 0.996}, {0.997, 0.999}},
+        {-0.300, -0.300}}},
+    // impulse, limiter, 96000 Hz
+    {1, 5, 96000, {
+        {{-27.113, -100.000}, {-81.404, -27.115}, {-100.000, -61.650}, {-100.000, -88.298}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.968, 0.000}, {0.000, 0.968}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-0.300, -0.300}}},
+    // pink, limiter, 96000 Hz
+    {2, 5, 96000, {
+        {{-15.968, -15.885}, {-6.756, -11.696}, {-10.804, -12.080}, {-12.098, -8.474}, {-12.673, -11.645}, {-13.686, -13.258}, {-12.432, -12.720}, {-12.985, -13.658}, {-12.276, -11.787}, {-11.249, -11.150}, {-13.044, -12.434}, {-13.520, -12.165}, {-12.496, -8.535}, {-12.377, -10.242}, {-13.657, -10.713}, {-12.715, -10.682}},
+        {{0.931, 0.923}, {0.975, 0.935}, {0.944, 0.941}, {0.937, 0.976}, {0.935, 0.936}, {0.929, 0.918}, {0.941, 0.938}, {0.936, 0.925}, {0.937, 0.943}, {0.950, 0.955}, {0.941, 0.935}, {0.922, 0.934}, {0.932, 0.972}, {0.945, 0.962}, {0.930, 0.956}, {0.944, 0.953}},
+        {-0.778, -2.010}}},
+    // sweep, binaural, 96000 Hz
+    {0, 6, 96000, {
+        {{-34.783, -23.765}, {-20.880, -17.726}, {-19.786, -16.696}, {-20.704, -17.477}, {-22.067, -18.069}, {-21.171, -17.909}, {-22.339, -18.803}, {-21.481, -19.455}, {-17.657, -21.907}, {-19.641, -20.438}, {-18.802, -22.245}, {-18.478, -21.913}, {-17.450, -20.986}, {-17.438, -20.657}, {-17.840, -21.184}, {-16.714, -19.706}},
+        {{0.682, 0.016}, {0.962, -0.010}, {0.818, 0.000}, {0.620, 0.008}, {0.110, -0.023}, {-0.639, 0.044}, {-0.695, 0.053}, {0.500, 0.037}, {-0.258, -0.045}, {0.086, 0.346}, {-0.047, -0.775}, {0.017, -0.437}, {-0.008, -0.025}, {0.003, 0.672}, {0.005, 0.878}, {0.008, 0.968}},
+        {-10.666, -10.709}}},
+    // impulse, binaural, 96000 Hz
+    {1, 6, 96000, {
+        {{-44.259, -56.117}, {-100.000, -94.874}, {-56.116, -44.259}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}, {-100.000, -100.000}},
+        {{0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}, {0.000, 0.000}},
+        {-18.001, -18.001}}},
+    // pink, binaural, 96000 Hz
+    {2, 6, 96000, {
+        {{-38.326, -38.014}, {-30.766, -29.382}, {-28.958, -29.524}, {-27.379, -26.773}, {-31.745, -31.255}, {-30.775, -30.972}, {-33.543, -33.182}, {-32.966, -33.147}, {-32.060, -30.914}, {-28.052, -27.827}, {-30.219, -30.257}, {-31.609, -31.131}, {-29.618, -30.616}, {-29.286, -28.968}, {-29.290, -29.331}, {-29.381, -29.252}},
+        {{-0.043, 0.246}, {0.484, 0.115}, {0.485, -0.285}, {0.288, 0.759}, {-0.387, 0.410}, {0.045, 0.049}, {-0.100, 0.261}, {-0.050, 0.024}, {0.178, 0.200}, {0.497, 0.444}, {0.174, 0.182}, {0.199, 0.356}, {0.153, 0.415}, {0.367, 0.603}, {0.250, 0.513}, {0.412, 0.460}},
+        {-19.928, -19.249}}},
+};
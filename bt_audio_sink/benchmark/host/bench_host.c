@@ -0,0 +1,120 @@
+/*
+ * Host runner of the codec benchmark.
+ *
+ *     codec_bench_host capture.a2dp...
+ *
+ * Each capture is decoded on a thread with a painted stack. If a
+ * "<capture>.crc" sidecar exists (hex CRC32 of the PCM), the output must
+ * match it. Exit status is non-zero if any capture fails.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "codec_bench.h"
+
+#define BENCH_STACK_SIZE    (256 * 1024)
+#define BENCH_STACK_PAINT   0xa5
+
+typedef struct {
+    const uint8_t *capture;
+    size_t len;
+    codec_bench_result_t res;
+    bool ok;
+} bench_job_t;
+
+static void *bench_thread(void *arg)
+{
+    bench_job_t *job = (bench_job_t *)arg;
+    job->ok = codec_bench_run(job->capture, job->len, &job->res);
+    return NULL;
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = size > 0 ? (uint8_t *)malloc((size_t)size) : NULL;
+    if (buf && fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = (size_t)size;
+    return buf;
+}
+
+// Stack use: painted bytes overwritten from the top (stacks grow down)
+static uint32_t stack_used(const uint8_t *stack, size_t size)
+{
+    size_t untouched = 0;
+    while (untouched < size && stack[untouched] == BENCH_STACK_PAINT) {
+        untouched++;
+    }
+    return (uint32_t)(size - untouched);
+}
+
+static bool bench_one(const char *path)
+{
+    bench_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.capture = read_file(path, &job.len);
+    if (job.capture == NULL) {
+        printf("%s: cannot read\n", path);
+        return false;
+    }
+
+    uint8_t *stack = (uint8_t *)malloc(BENCH_STACK_SIZE);
+    memset(stack, BENCH_STACK_PAINT, BENCH_STACK_SIZE);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, BENCH_STACK_SIZE);
+    pthread_t thread;
+    bool started = pthread_create(&thread, &attr, bench_thread, &job) == 0;
+    if (started) {
+        pthread_join(thread, NULL);
+    }
+    pthread_attr_destroy(&attr);
+    job.res.peak_stack = stack_used(stack, BENCH_STACK_SIZE);
+    free(stack);
+    free((void *)job.capture);
+
+    if (!started || !job.ok) {
+        printf("%s: failed\n", path);
+        return false;
+    }
+    codec_bench_print(path, &job.res);
+
+    char crc_path[1024];
+    snprintf(crc_path, sizeof(crc_path), "%s.crc", path);
+    FILE *f = fopen(crc_path, "r");
+    if (f != NULL) {
+        unsigned int expect = 0;
+        int n = fscanf(f, "%x", &expect);
+        fclose(f);
+        if (n != 1 || expect != job.res.crc32) {
+            printf("%s: crc %08x, expected %08x\n", path, (unsigned)job.res.crc32, expect);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("usage: %s capture.a2dp...\n", argv[0]);
+        return 2;
+    }
+    int failed = 0;
+    for (int i = 1; i < argc; i++) {
+        failed += bench_one(argv[i]) ? 0 : 1;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,257 @@
+/*
+ * Synthetic benchmark captures from the in-tree encoders, for the codecs
+ * that have one: SBC, aptX, aptX HD and LC3plus. Half a second of test audio
+ * (a rising tone, noise, full-scale square waves, decaying bursts into
+ * silence) is encoded and packetized as a source would send it, in the
+ * capture format of codec_bench.h:
+ *
+ *   capture_gen ../captures
+ *
+ * writes sbc_bp53.a2dp, aptx.a2dp, aptx_hd.a2dp and lc3plus.a2dp. Their
+ * .crc files come from codec_bench_host with the portable decoders. The
+ * output only depends on this file and the encoders, so a regenerated
+ * capture is byte-identical unless one of them changed.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/bt_target.h"
+#include "sbc_encoder.h"
+#include "freeaptx.h"
+#include "lc3.h"
+
+#define GEN_MS          500
+#define GEN_MAX_RATE    48000
+#define GEN_SAMPLES     (GEN_MAX_RATE * GEN_MS / 1000)
+#define RTP_HEADER_SIZE 12
+
+static unsigned int s_seed;
+static int rnd(int n)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return (int)((s_seed >> 8) % (unsigned int)n);
+}
+
+static int32_t clip24(int64_t v)
+{
+    return v > 0x7FFFFF ? 0x7FFFFF : v < -0x800000 ? -0x800000 : (int32_t)v;
+}
+
+/* Interleaved 24-bit stereo in int32, the same sequence at every rate */
+static int make_pcm(int32_t *pcm, int rate)
+{
+    const int n = rate * GEN_MS / 1000;
+    int32_t phase = 0;
+    s_seed = 12345;
+    for (int i = 0; i < n; i++) {
+        const int part = i * 4 / n;
+        int32_t l, r;
+        phase += 1 + i / 64;
+        if (part == 0) {
+            l = (int32_t)(((phase & 0x3FF) - 0x200) * 0x3000);
+            r = (int32_t)((((i * 37) & 0x7FF) - 0x400) * 0xC00);
+        } else if (part == 1) {
+            l = rnd(0x1000000) - 0x800000;
+            r = (rnd(0x1000000) - 0x800000) / 16;
+        } else if (part == 2) {
+            l = (i / 50) & 1 ? 0x7FFFFF : -0x800000;
+            r = -l - 1;
+        } else {
+            l = (i % (rate / 10)) < 200 ? rnd(0x1000000) - 0x800000 : 0;
+            r = n - i < rate / 50 ? 0 : rnd(0x2000) - 0x1000;
+        }
+        pcm[2 * i] = clip24(l);
+        pcm[2 * i + 1] = clip24(r);
+    }
+    return n;
+}
+
+typedef struct {
+    FILE *f;
+    uint16_t seq;
+    uint32_t timestamp;
+} capture_t;
+
+static int capture_open(capture_t *c, const char *dir, const char *name,
+                        const uint8_t *codec_info)
+{
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s.a2dp", dir, name);
+    c->f = fopen(path, "wb");
+    if (c->f == NULL) {
+        printf("%s: cannot create\n", path);
+        return 0;
+    }
+    const uint8_t header[6] = { 'A', '2', 'D', 'C', 1, (uint8_t)(codec_info[0] + 1) };
+    fwrite(header, 1, sizeof(header), c->f);
+    fwrite(codec_info, 1, codec_info[0] + 1, c->f);
+    c->seq = 1;
+    c->timestamp = 0;
+    printf("%s\n", path);
+    return 1;
+}
+
+/* RTP header as the source's media task writes it: version 2, dynamic
+ * payload type, sequence and timestamp (in samples) big endian */
+static uint8_t *rtp_header(capture_t *c, uint8_t *p, uint32_t samples)
+{
+    p[0] = 0x80;
+    p[1] = 0x60;
+    p[2] = (uint8_t)(c->seq >> 8);
+    p[3] = (uint8_t)c->seq;
+    for (int b = 0; b < 4; b++) {
+        p[4 + b] = (uint8_t)(c->timestamp >> (24 - 8 * b));
+        p[8 + b] = 0;
+    }
+    p[11] = 1;
+    c->seq++;
+    c->timestamp += samples;
+    return p + RTP_HEADER_SIZE;
+}
+
+static void capture_packet(capture_t *c, const uint8_t *pkt, size_t len)
+{
+    const uint8_t n[2] = { (uint8_t)len, (uint8_t)(len >> 8) };
+    fwrite(n, 1, 2, c->f);
+    fwrite(pkt, 1, len, c->f);
+}
+
+static int capture_close(capture_t *c)
+{
+    return fclose(c->f) == 0;
+}
+
+/* SBC 44.1 kHz joint stereo, 16 blocks, 8 subbands, loudness, bitpool 53:
+ * the high quality setting, five frames per packet */
+static int gen_sbc(const char *dir, int32_t *pcm)
+{
+    static const uint8_t info[] = { 6, 0x00, 0x00, 0x21, 0x15, 2, 53 };
+    static SBC_ENC_PARAMS enc;
+    const int n = make_pcm(pcm, 44100);
+    const int frame_samples = 16 * 8;
+    uint8_t pkt[RTP_HEADER_SIZE + 1 + 5 * 128];
+    capture_t c;
+
+    memset(&enc, 0, sizeof(enc));
+    enc.s16SamplingFreq = SBC_sf44100;
+    enc.s16ChannelMode = SBC_JOINT_STEREO;
+    enc.s16NumOfSubBands = 8;
+    enc.s16NumOfBlocks = 16;
+    enc.s16AllocationMethod = SBC_LOUDNESS;
+    enc.u16BitRate = 328;
+    enc.sbc_mode = SBC_MODE_STD;
+    SBC_Encoder_Init(&enc);
+    enc.s16BitPool = 53;
+
+    if (!capture_open(&c, dir, "sbc_bp53", info)) {
+        return 0;
+    }
+    for (int i = 0; i + 5 * frame_samples <= n; i += 5 * frame_samples) {
+        uint8_t *p = rtp_header(&c, pkt, 5 * frame_samples);
+        uint8_t *frames = p + 1;
+        *p = 5;
+        for (int f = 0; f < 5; f++) {
+            for (int s = 0; s < 2 * frame_samples; s++) {
+                enc.as16PcmBuffer[s] = (SINT16)(pcm[2 * (i + f * frame_samples) + s] >> 8);
+            }
+            enc.pu8Packet = frames;
+            SBC_Encoder(&enc);
+            frames += enc.u16PacketLength;
+        }
+        capture_packet(&c, pkt, (size_t)(frames - pkt));
+    }
+    return capture_close(&c);
+}
+
+/* aptX 44.1 kHz and aptX HD 48 kHz stereo. aptX packets are bare codewords,
+ * aptX HD ones carry an RTP header; both as large as a 2-DH5 slot allows */
+static int gen_aptx(const char *dir, int32_t *pcm, int hd)
+{
+    static const uint8_t info_aptx[] = { 9, 0x00, 0xFF, 0x4F, 0, 0, 0, 0x01, 0x00, 0x22 };
+    static const uint8_t info_hd[] = { 13, 0x00, 0xFF, 0xD7, 0, 0, 0, 0x24, 0x00, 0x12, 0, 0, 0, 0 };
+    const int rate = hd ? 48000 : 44100;
+    const int n = make_pcm(pcm, rate);
+    const size_t word = hd ? 6 : 4;             // Bytes per 4 stereo samples
+    const size_t words = hd ? 100 : 150;
+    uint8_t *in = malloc((size_t)n * 6);
+    uint8_t *enc = malloc((size_t)n / 4 * word + 64);
+    size_t elen = 0, tail = 0;
+    capture_t c;
+
+    for (int i = 0; i < 2 * n; i++) {
+        for (int b = 0; b < 3; b++) {
+            in[i * 3 + b] = (uint8_t)((uint32_t)pcm[i] >> (8 * b));
+        }
+    }
+    struct aptx_context *ctx = aptx_init(hd);
+    aptx_encode(ctx, in, (size_t)n * 6, enc, (size_t)n / 4 * word + 64, &elen);
+    aptx_encode_finish(ctx, enc + elen, 64, &tail);
+    aptx_finish(ctx);
+    elen += tail;
+
+    int ok = capture_open(&c, dir, hd ? "aptx_hd" : "aptx", hd ? info_hd : info_aptx);
+    for (size_t off = 0; ok && off < elen; off += words * word) {
+        uint8_t pkt[RTP_HEADER_SIZE + 150 * 6];
+        const size_t len = elen - off < words * word ? elen - off : words * word;
+        uint8_t *p = hd ? rtp_header(&c, pkt, (uint32_t)(len / word * 4)) : pkt;
+        memcpy(p, enc + off, len);
+        capture_packet(&c, pkt, (size_t)(p - pkt) + len);
+    }
+    ok = ok && capture_close(&c);
+    free(in);
+    free(enc);
+    return ok;
+}
+
+/* LC3plus high resolution, 48 kHz stereo, 10 ms frames of 160 bytes per
+ * channel, one frame per packet */
+static int gen_lc3plus(const char *dir, int32_t *pcm)
+{
+    static const uint8_t info[] = { 12, 0x00, 0xFF, 0xA9, 0x08, 0, 0, 0x01, 0x00,
+                                    0x40, 0x40, 0x01, 0x00 };
+    const int n = make_pcm(pcm, 48000);
+    const int frame = 480, nbytes = 160;
+    void *mem[2] = { NULL, NULL };
+    lc3_encoder_t enc[2];
+    capture_t c;
+    int ok = 1;
+
+    for (int ch = 0; ch < 2; ch++) {
+        mem[ch] = malloc(lc3_hr_encoder_size(true, 10000, 48000));
+        enc[ch] = lc3_hr_setup_encoder(true, 10000, 48000, 48000, mem[ch]);
+        ok = ok && enc[ch] != NULL;
+    }
+    ok = ok && capture_open(&c, dir, "lc3plus", info);
+    for (int i = 0; ok && i + frame <= n; i += frame) {
+        uint8_t pkt[RTP_HEADER_SIZE + 1 + 2 * 160];
+        uint8_t *p = rtp_header(&c, pkt, frame);
+        *p++ = 1;
+        for (int ch = 0; ch < 2 && ok; ch++) {
+            ok = lc3_encode(enc[ch], LC3_PCM_FORMAT_S24, pcm + 2 * i + ch, 2, nbytes,
+                            p + ch * nbytes) == 0;
+        }
+        capture_packet(&c, pkt, sizeof(pkt));
+    }
+    ok = ok && capture_close(&c);
+    free(mem[0]);
+    free(mem[1]);
+    if (!ok) {
+        printf("lc3plus: encoder failed\n");
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        printf("usage: %s captures-dir\n", argv[0]);
+        return 2;
+    }
+    int32_t *pcm = malloc(sizeof(int32_t) * 2 * GEN_SAMPLES);
+    const int ok = gen_sbc(argv[1], pcm) && gen_aptx(argv[1], pcm, 0) &&
+                   gen_aptx(argv[1], pcm, 1) && gen_lc3plus(argv[1], pcm);
+    free(pcm);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,6 @@
+/* Host port of esp_cpu.h: the "cycle" count is the nanosecond clock */
+#pragma once
+
+#include <stdint.h>
+
+uint32_t esp_cpu_get_cycle_count(void);
@@ -0,0 +1,18 @@
+/* Host port: the FreeRTOS types the bluedroid OSI headers mention. The
+ * decoders are single threaded here. */
+#pragma once
+
+#include <errno.h>
+#include <stdint.h>
+
+typedef void *SemaphoreHandle_t;
+typedef void *QueueHandle_t;
+typedef void *TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
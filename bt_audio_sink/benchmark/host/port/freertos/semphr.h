@@ -0,0 +1,2 @@
+/* Host port: intentionally empty */
+#pragma once
@@ -0,0 +1,193 @@
+/*
+ * Host port of the few ESP-IDF and bluedroid services the decoder wrappers
+ * link against, plus the benchmark's platform hooks.
+ *
+ * Heap accounting wraps malloc/calloc/realloc/free at link time
+ * (-Wl,--wrap=...), so the codec libraries' direct calls are counted as
+ * well as osi_malloc and heap_caps_malloc. Counters are per thread.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "osi/allocator.h"
+#include "osi/mutex.h"
+#include "stack/a2d_api.h"
+#include "codec_bench.h"
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static __thread uint32_t t_allocs;
+static __thread uint32_t t_bytes;
+
+void *__wrap_malloc(size_t size)
+{
+    t_allocs++;
+    t_bytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    t_allocs++;
+    t_bytes += n * size;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    t_allocs++;
+    t_bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr)
+{
+    __real_free(ptr);
+}
+
+void codec_bench_heap_reset(void)
+{
+    t_allocs = 0;
+    t_bytes = 0;
+}
+
+void codec_bench_heap_get(uint32_t *allocs, uint32_t *bytes)
+{
+    *allocs = t_allocs;
+    *bytes = t_bytes;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+uint32_t codec_bench_ticks(void)
+{
+    return (uint32_t)now_ns();
+}
+
+uint64_t codec_bench_ticks_per_second(void)
+{
+    return 1000000000u;
+}
+
+uint32_t esp_cpu_get_cycle_count(void)
+{
+    return (uint32_t)now_ns();
+}
+
+/* esp_log */
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    (void)level;
+    (void)tag;
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(now_ns() / 1000000u);
+}
+
+/* esp_heap_caps */
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
+
+void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return realloc(ptr, size);
+}
+
+void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    return 0;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    (void)caps;
+    return 0;
+}
+
+/* bluedroid OSI and stack */
+
+uint8_t appl_trace_level = 0;
+
+void *osi_malloc_func(size_t size)
+{
+    return malloc(size);
+}
+
+void *osi_calloc_func(size_t size)
+{
+    return calloc(1, size);
+}
+
+void osi_free_func(void *ptr)
+{
+    free(ptr);
+}
+
+int osi_mutex_new(osi_mutex_t *mutex)
+{
+    *mutex = (osi_mutex_t)1;
+    return 0;
+}
+
+int osi_mutex_lock(osi_mutex_t *mutex, uint32_t timeout)
+{
+    (void)mutex;
+    (void)timeout;
+    return 0;
+}
+
+void osi_mutex_unlock(osi_mutex_t *mutex)
+{
+    (void)mutex;
+}
+
+void osi_mutex_free(osi_mutex_t *mutex)
+{
+    *mutex = NULL;
+}
+
+// From a2d_api.c, which otherwise drags in SDP
+uint8_t A2D_BitsSet(uint64_t num)
+{
+    if (num == 0) {
+        return A2D_SET_ZERO_BIT;
+    }
+    return ((num & (num - 1)) == 0) ? A2D_SET_ONE_BIT : A2D_SET_MULTL_BIT;
+}
@@ -0,0 +1,13 @@
+/* Host build of the codec benchmark: the parts of an A2DP sink sdkconfig
+ * the decoder wrappers and their headers look at */
+#pragma once
+
+#define CONFIG_BT_ENABLED 1
+#define CONFIG_BT_BLUEDROID_ENABLED 1
+#define CONFIG_BT_CLASSIC_ENABLED 1
+#define CONFIG_BT_A2DP_ENABLE 1
+#define CONFIG_BT_A2DP_APTX_DECODER 1
+#define CONFIG_BT_A2DP_LDAC_DECODER 1
+#define CONFIG_BT_A2DP_OPUS_DECODER 1
+#define CONFIG_BT_A2DP_LC3PLUS_DECODER 1
+#define CONFIG_BT_A2DP_AAC_DECODER 1
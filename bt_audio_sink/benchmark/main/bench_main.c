@@ -0,0 +1,229 @@
+/*
+ * On-device runner of the benchmark.
+ *
+ * Runs the system suites (system_bench.h), then decodes every capture on
+ * the "bench" SPIFFS partition (built from ../captures), each on a task of
+ * its own pinned to the audio core. Results are one JSON object per line,
+ * ending with {"suite":"done",...} and the failure count. A
+ * "<capture>.crc" next to a capture is the expected CRC32 of its PCM
+ * output.
+ */
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_private/esp_clk.h"
+#include "esp_spiffs.h"
+
+#include "codec_bench.h"
+#include "system_bench.h"
+
+static const char *TAG = "BENCH";
+
+#define BENCH_MOUNT         "/captures"
+#define BENCH_STACK_SIZE    (16 * 1024)
+#define BENCH_TASK_PRIO     (configMAX_PRIORITIES - 2)
+
+typedef struct {
+    const uint8_t *capture;
+    size_t len;
+    codec_bench_result_t res;
+    bool ok;
+} bench_job_t;
+
+typedef struct {
+    void (*fn)(void *arg);
+    void *arg;
+    uint32_t peak_stack;
+    TaskHandle_t caller;
+} bench_run_t;
+
+/* Heap accounting (CONFIG_HEAP_USE_HOOKS): allocations of the bench task */
+static TaskHandle_t s_bench_task;
+static volatile uint32_t s_allocs;
+static volatile uint32_t s_bytes;
+
+void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    (void)ptr;
+    (void)caps;
+    if (s_bench_task != NULL && xTaskGetCurrentTaskHandle() == s_bench_task) {
+        s_allocs++;
+        s_bytes += size;
+    }
+}
+
+void codec_bench_heap_reset(void)
+{
+    s_allocs = 0;
+    s_bytes = 0;
+}
+
+void codec_bench_heap_get(uint32_t *allocs, uint32_t *bytes)
+{
+    *allocs = s_allocs;
+    *bytes = s_bytes;
+}
+
+uint32_t codec_bench_ticks(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+
+uint64_t codec_bench_ticks_per_second(void)
+{
+    return (uint64_t)esp_clk_cpu_freq();
+}
+
+static void bench_task(void *arg)
+{
+    bench_run_t *run = (bench_run_t *)arg;
+    run->fn(run->arg);
+    // StackType_t is a byte on this port
+    run->peak_stack = BENCH_STACK_SIZE - uxTaskGetStackHighWaterMark(NULL);
+    xTaskNotifyGive(run->caller);
+    vTaskSuspend(NULL);
+}
+
+// Runs fn(arg) on a bench task on core 1 (where audio_tx runs) and waits
+// for it; returns its peak stack use, or -1 if the task could not start
+static int run_on_bench_task(void (*fn)(void *arg), void *arg)
+{
+    static bench_run_t run;
+    run.fn = fn;
+    run.arg = arg;
+    run.peak_stack = 0;
+    run.caller = xTaskGetCurrentTaskHandle();
+
+    TaskHandle_t task = NULL;
+    if (xTaskCreatePinnedToCore(bench_task, "bench", BENCH_STACK_SIZE, &run,
+                                BENCH_TASK_PRIO, &task, 1) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create bench task");
+        return -1;
+    }
+    s_bench_task = task;
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    s_bench_task = NULL;
+    vTaskDelete(task);
+    return (int)run.peak_stack;
+}
+
+static void system_suites(void *arg)
+{
+    *(int *)arg = system_bench_run();
+}
+
+#if CONFIG_BT_CLASSIC_ENABLED
+static void decode_capture(void *arg)
+{
+    bench_job_t *job = (bench_job_t *)arg;
+    job->ok = codec_bench_run(job->capture, job->len, &job->res);
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    struct stat st;
+    if (stat(path, &st) != 0 || st.st_size <= 0) {
+        return NULL;
+    }
+    // Captures go to PSRAM when there is some, keeping internal RAM for the codec
+    uint8_t *buf = heap_caps_malloc(st.st_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buf == NULL) {
+        buf = heap_caps_malloc(st.st_size, MALLOC_CAP_8BIT);
+    }
+    FILE *f = fopen(path, "rb");
+    if (buf == NULL || f == NULL || fread(buf, 1, st.st_size, f) != (size_t)st.st_size) {
+        ESP_LOGE(TAG, "Failed to read %s", path);
+        heap_caps_free(buf);
+        buf = NULL;
+    }
+    if (f != NULL) {
+        fclose(f);
+    }
+    *len = st.st_size;
+    return buf;
+}
+
+static bool bench_one(const char *name)
+{
+    char path[64];
+    snprintf(path, sizeof(path), BENCH_MOUNT "/%s", name);
+
+    static bench_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.capture = read_file(path, &job.len);
+    if (job.capture == NULL) {
+        return false;
+    }
+    const int stack = run_on_bench_task(decode_capture, &job);
+    heap_caps_free((void *)job.capture);
+    if (stack < 0 || !job.ok) {
+        printf("{\"suite\":\"codec\",\"capture\":\"%s\",\"error\":\"failed\"}\n", name);
+        return false;
+    }
+    job.res.peak_stack = (uint32_t)stack;
+    codec_bench_print_json(name, &job.res);
+
+    char crc_path[72];
+    snprintf(crc_path, sizeof(crc_path), "%s.crc", path);
+    FILE *f = fopen(crc_path, "r");
+    if (f != NULL) {
+        unsigned int expect = 0;
+        int n = fscanf(f, "%x", &expect);
+        fclose(f);
+        if (n != 1 || expect != job.res.crc32) {
+            printf("{\"suite\":\"codec\",\"capture\":\"%s\",\"error\":\"crc\",\"expected\":\"%08x\"}\n",
+                   name, expect);
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+void app_main(void)
+{
+    system_bench_print_info();
+
+    int failed = 0;
+    if (run_on_bench_task(system_suites, &failed) < 0) {
+        failed++;
+    }
+
+    int total = 0;
+#if CONFIG_BT_CLASSIC_ENABLED
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = BENCH_MOUNT,
+        .partition_label = "bench",
+        .max_files = 4,
+        .format_if_mount_failed = false,
+    };
+    DIR *dir = NULL;
+    if (esp_vfs_spiffs_register(&conf) == ESP_OK) {
+        dir = opendir(BENCH_MOUNT);
+    } else {
+        ESP_LOGW(TAG, "No capture partition, codec suite skipped");
+    }
+    struct dirent *entry;
+    while (dir != NULL && (entry = readdir(dir)) != NULL) {
+        size_t n = strlen(entry->d_name);
+        if (n < 5 || strcmp(entry->d_name + n - 5, ".a2dp") != 0) {
+            continue;
+        }
+        total++;
+        failed += bench_one(entry->d_name) ? 0 : 1;
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
+#else
+    ESP_LOGW(TAG, "No Classic BT on this target, codec suite skipped");
+#endif
+    printf("{\"suite\":\"done\",\"captures\":%d,\"failed\":%d}\n", total, failed);
+}
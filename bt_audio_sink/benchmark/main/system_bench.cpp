@@ -0,0 +1,668 @@
+/*
+ * System benchmark suites (see system_bench.h). The objects under test are
+ * the main app's, built with its Kconfig; each suite sets them up the way
+ * main.cpp does and times the calls the audio and LED tasks make.
+ */
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_app_desc.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_private/esp_clk.h"
+#include "esp_spiffs.h"
+#include "esp_timer.h"
+#if CONFIG_SPIRAM
+#include "esp_psram.h"
+#endif
+
+#include "system_bench.h"
+#include "config/app_config.h"
+#include "dsp/dsp_processor.h"
+#include "dsp/pie_kernels.h"
+#include "audio/i2s_output.h"
+#include "audio/overlay_mixer.h"
+#include "audio/sound_assets.h"
+#include "led/led_effects.h"
+#include "dsp_golden.h"
+#include "dsp_golden_ref.h"
+
+static const char *TAG = "SYSBENCH";
+
+#define WARMUP_BLOCKS   8
+#define TIMED_BLOCKS    200
+#define MEM_BYTES       (32 * 1024)
+#define MEM_PASSES      16
+#define LED_FRAMES      100
+#define I2S_WRITES      200
+
+static const uint32_t s_rates[] = {44100, 48000, 96000};
+
+// Per call cycles, min/avg/max
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t n;
+} cycle_stats_t;
+
+static void stats_reset(cycle_stats_t *s)
+{
+    s->min = UINT32_MAX;
+    s->max = 0;
+    s->total = 0;
+    s->n = 0;
+}
+
+static void stats_add(cycle_stats_t *s, uint32_t cycles)
+{
+    if (cycles < s->min) s->min = cycles;
+    if (cycles > s->max) s->max = cycles;
+    s->total += cycles;
+    s->n++;
+}
+
+static uint32_t stats_avg(const cycle_stats_t *s)
+{
+    return s->n ? (uint32_t)(s->total / s->n) : 0;
+}
+
+static double cycles_to_us(uint64_t cycles)
+{
+    return (double)cycles * 1e6 / esp_clk_cpu_freq();
+}
+
+// "cycles_min":..,"cycles_avg":..,"cycles_max":..
+static void print_cycles(const cycle_stats_t *s)
+{
+    printf("\"cycles_min\":%" PRIu32 ",\"cycles_avg\":%" PRIu32 ",\"cycles_max\":%" PRIu32,
+           s->n ? s->min : 0, stats_avg(s), s->max);
+}
+
+/* DSP: one output block per call, per mode and rate */
+
+typedef struct {
+    const char *name;
+    bool bypass;
+    bool bass_boost;
+    bool sound_3d;
+    bool analysis;
+} dsp_mode_t;
+
+static const dsp_mode_t s_dsp_modes[] = {
+    {"bypass",     true,  false, false, false},
+    {"flat",       false, false, false, false},
+    {"bass_boost", false, true,  false, false},
+    {"3d",         false, false, true,  false},
+    {"analysis",   false, false, false, true},
+    {"full",       false, true,  true,  true},
+};
+
+static DSPProcessor s_dsp;
+
+// Two tones at -6 dBFS: above the silence gate, so every stage runs
+static void fill_test_signal(float *buf, size_t frames, uint32_t rate)
+{
+    for (size_t i = 0; i < frames; i++) {
+        buf[2 * i] = 0.5f * sinf(2.0f * (float)M_PI * 100.0f * i / rate);
+        buf[2 * i + 1] = 0.5f * sinf(2.0f * (float)M_PI * 1000.0f * i / rate);
+    }
+}
+
+static void dsp_set_mode(const dsp_mode_t *m)
+{
+    s_dsp.setBypass(m->bypass);
+    s_dsp.setBassBoost(m->bass_boost);
+    s_dsp.set3DSound(m->sound_3d);
+    s_dsp.setAnalysisEnabled(m->analysis);
+}
+
+static void print_dsp(const char *path, const dsp_mode_t *m, uint32_t rate, const cycle_stats_t *s)
+{
+    // Share of the block's playback time spent on it
+    const double block_cycles = (double)esp_clk_cpu_freq() * APP_DSP_OUT_FRAMES / rate;
+    printf("{\"suite\":\"dsp\",\"path\":\"%s\",\"mode\":\"%s\",\"rate\":%" PRIu32 ",\"frames\":%d,",
+           path, m->name, rate, APP_DSP_OUT_FRAMES);
+    print_cycles(s);
+    printf(",\"load_pct\":%.2f}\n", 100.0 * stats_avg(s) / block_cycles);
+}
+
+static bool bench_dsp(void)
+{
+    const size_t bytes = APP_DSP_OUT_FRAMES * 2 * sizeof(float);
+    float *in = (float *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    float *out = (float *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#if APP_DSP_Q31_PATH
+    int32_t *q31_in = (int32_t *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    int32_t *q31 = (int32_t *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    bool ok = in && out && q31_in && q31;
+#else
+    bool ok = in && out;
+#endif
+    if (!ok) {
+        ESP_LOGE(TAG, "DSP buffers");
+    }
+
+    s_dsp.init(s_rates[0]);
+    for (size_t r = 0; ok && r < sizeof(s_rates) / sizeof(s_rates[0]); r++) {
+        const uint32_t rate = s_rates[r];
+        s_dsp.setSampleRate(rate);
+        fill_test_signal(in, APP_DSP_OUT_FRAMES, rate);
+#if APP_DSP_Q31_PATH
+        for (size_t i = 0; i < APP_DSP_OUT_FRAMES * 2; i++) {
+            q31_in[i] = (int32_t)(in[i] * 2147483647.0f);
+        }
+#endif
+        for (size_t m = 0; m < sizeof(s_dsp_modes) / sizeof(s_dsp_modes[0]); m++) {
+            const dsp_mode_t *mode = &s_dsp_modes[m];
+            cycle_stats_t s;
+            dsp_set_mode(mode);
+            s_dsp.resetAllFilters();
+            stats_reset(&s);
+            for (int b = 0; b < WARMUP_BLOCKS + TIMED_BLOCKS; b++) {
+                const uint32_t t0 = esp_cpu_get_cycle_count();
+                s_dsp.processBlock(in, out, APP_DSP_OUT_FRAMES);
+                const uint32_t t1 = esp_cpu_get_cycle_count();
+                if (b >= WARMUP_BLOCKS) stats_add(&s, t1 - t0);
+            }
+            print_dsp("float", mode, rate, &s);
+#if APP_DSP_Q31_PATH
+            s_dsp.resetAllFilters();
+            stats_reset(&s);
+            for (int b = 0; b < WARMUP_BLOCKS + TIMED_BLOCKS; b++) {
+                memcpy(q31, q31_in, bytes);
+                const uint32_t t0 = esp_cpu_get_cycle_count();
+                s_dsp.processBlockQ31(q31, APP_DSP_OUT_FRAMES);
+                const uint32_t t1 = esp_cpu_get_cycle_count();
+                if (b >= WARMUP_BLOCKS) stats_add(&s, t1 - t0);
+            }
+            print_dsp("q31", mode, rate, &s);
+#endif
+        }
+    }
+    heap_caps_free(in);
+    heap_caps_free(out);
+#if APP_DSP_Q31_PATH
+    heap_caps_free(q31_in);
+    heap_caps_free(q31);
+#endif
+    return ok;
+}
+
+/* Golden: every signal, mode and rate of the golden-vector suite checked
+ * against the host's fingerprints, each case's cycles held to a share of
+ * the block's playback time (CONFIG_BENCH_DSP_BUDGET_PCT) */
+
+static uint32_t golden_ticks(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+
+static bool bench_golden(void)
+{
+    using namespace dsp_golden;
+    alignas(16) static float buf[BLOCK * 2];
+    const size_t table = sizeof(DSP_GOLDEN_REF) / sizeof(DSP_GOLDEN_REF[0]);
+    bool ok = true;
+
+    s_dsp.init(RATES[0]);
+    for (int path = 0; path < (APP_DSP_Q31_PATH ? 2 : 1); path++) {
+        const bool q31 = path == 1;
+        for (int r = 0; r < RATE_COUNT; r++) {
+            const double budget = (double)esp_clk_cpu_freq() * BLOCK / RATES[r] * CONFIG_BENCH_DSP_BUDGET_PCT / 100;
+            for (int m = 0; m < MODE_COUNT; m++) {
+                for (int sig = 0; sig < SIG_COUNT; sig++) {
+                    Print print;
+                    Timing timing;
+                    char what[96] = "";
+                    run(s_dsp, (Signal)sig, MODES[m], RATES[r], q31, buf, golden_ticks, print, timing);
+                    const Ref *ref = findRef(DSP_GOLDEN_REF, table, (Signal)sig, m, RATES[r]);
+                    bool match = ref && compare(print, ref->print, q31, what, sizeof(what));
+                    if (!ref) snprintf(what, sizeof(what), "no golden entry");
+                    const bool in_budget = timing.avg <= budget;
+                    printf("{\"suite\":\"golden\",\"path\":\"%s\",\"signal\":\"%s\",\"mode\":\"%s\","
+                           "\"rate\":%" PRIu32 ",\"cycles_avg\":%" PRIu32 ",\"cycles_max\":%" PRIu32
+                           ",\"budget\":%" PRIu32 ",\"match\":%s,\"ok\":%s%s%s%s}\n",
+                           q31 ? "q31" : "float", SIGNAL_NAMES[sig], MODES[m].name, RATES[r], timing.avg,
+                           timing.max, (uint32_t)budget, match ? "true" : "false",
+                           match && in_budget ? "true" : "false", match ? "" : ",\"diff\":\"",
+                           match ? "" : what, match ? "" : "\"");
+                    ok = ok && match && in_budget;
+                }
+            }
+        }
+    }
+
+    char what[128] = "";
+    const bool exact = checkConverters(what, sizeof(what));
+    printf("{\"suite\":\"golden\",\"converters\":\"%s\"%s%s%s}\n", exact ? "exact" : "differ",
+           exact ? "" : ",\"diff\":\"", exact ? "" : what, exact ? "" : "\"");
+    return ok && exact;
+}
+
+/* Overlay mixer: a prompt mixed into one output block, with ducking */
+
+static OverlayMixer s_overlay;
+
+static bool bench_overlay(void)
+{
+    const size_t bytes = APP_DSP_OUT_FRAMES * 2 * sizeof(int32_t);
+    int32_t *prompt = (int32_t *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    int32_t *block = (int32_t *)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!prompt || !block || !s_overlay.init()) {
+        ESP_LOGE(TAG, "Overlay setup");
+        heap_caps_free(prompt);
+        heap_caps_free(block);
+        return false;
+    }
+    for (size_t i = 0; i < APP_DSP_OUT_FRAMES * 2; i++) {
+        prompt[i] = (int32_t)(i * 0x10000);
+    }
+
+    cycle_stats_t s;
+    stats_reset(&s);
+    for (int b = 0; b < WARMUP_BLOCKS + TIMED_BLOCKS; b++) {
+        s_overlay.pushSamples(prompt, APP_DSP_OUT_FRAMES);
+        memset(block, 0x11, bytes);
+        const uint32_t t0 = esp_cpu_get_cycle_count();
+        s_overlay.mixIntoOutput(block, APP_DSP_OUT_FRAMES);
+        const uint32_t t1 = esp_cpu_get_cycle_count();
+        if (b >= WARMUP_BLOCKS) stats_add(&s, t1 - t0);
+    }
+    s_overlay.clear();
+    printf("{\"suite\":\"overlay\",\"frames\":%d,", APP_DSP_OUT_FRAMES);
+    print_cycles(&s);
+    printf("}\n");
+    heap_caps_free(prompt);
+    heap_caps_free(block);
+    return true;
+}
+
+/* Memory: memcpy bandwidth between internal RAM and PSRAM */
+
+static void *mem_alloc(bool psram)
+{
+    return heap_caps_malloc(MEM_BYTES, (psram ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL) | MALLOC_CAP_8BIT);
+}
+
+static void bench_memcpy_one(const char *name, bool src_psram, bool dst_psram)
+{
+    uint8_t *src = (uint8_t *)mem_alloc(src_psram);
+    uint8_t *dst = (uint8_t *)mem_alloc(dst_psram);
+    if (src && dst) {
+        memset(src, 0x5A, MEM_BYTES);
+        uint64_t cycles = 0;
+        for (int i = 0; i < MEM_PASSES; i++) {
+            const uint32_t t0 = esp_cpu_get_cycle_count();
+            memcpy(dst, src, MEM_BYTES);
+            cycles += esp_cpu_get_cycle_count() - t0;
+        }
+        const double us = cycles_to_us(cycles);
+        printf("{\"suite\":\"memcpy\",\"path\":\"%s\",\"bytes\":%d,\"mb_per_s\":%.1f}\n",
+               name, MEM_BYTES, us > 0 ? (double)MEM_BYTES * MEM_PASSES / us : 0.0);
+    }
+    heap_caps_free(src);
+    heap_caps_free(dst);
+}
+
+static bool bench_memcpy(void)
+{
+    bench_memcpy_one("internal_to_internal", false, false);
+    if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) == 0) {
+        printf("{\"suite\":\"memcpy\",\"path\":\"psram\",\"skipped\":\"no psram\"}\n");
+        return true;
+    }
+    bench_memcpy_one("psram_to_internal", true, false);
+    bench_memcpy_one("internal_to_psram", false, true);
+    bench_memcpy_one("psram_to_psram", true, true);
+    return true;
+}
+
+/* LED: encode + queue of a changing frame (show()), with the strip idle
+ * before each call and back to back (then it also waits for the wire) */
+
+static bool bench_led(void)
+{
+    static LedDriver s_led;
+    if (s_led.init() != ESP_OK) {
+        ESP_LOGE(TAG, "LED init");
+        return false;
+    }
+    s_led.setBrightness(128);
+
+    cycle_stats_t idle, busy;
+    stats_reset(&idle);
+    stats_reset(&busy);
+    for (int f = 0; f < 2 * LED_FRAMES; f++) {
+        const bool back_to_back = f >= LED_FRAMES;
+        for (int i = 0; i < LED_MATRIX_COUNT; i++) {
+            s_led.setPixel(i, RGB_SPI::fromHSV((uint8_t)(i + f * 7), 255, 255));
+        }
+        if (!back_to_back) vTaskDelay(pdMS_TO_TICKS(20));
+        const uint32_t t0 = esp_cpu_get_cycle_count();
+        s_led.show();
+        const uint32_t t1 = esp_cpu_get_cycle_count();
+        stats_add(back_to_back ? &busy : &idle, t1 - t0);
+    }
+    s_led.clear();
+    s_led.show();
+    printf("{\"suite\":\"led\",\"pixels\":%d,\"parallel\":%d,\"encode_us\":%.1f,\"encode_max_us\":%.1f,"
+           "\"frame_us\":%.1f,\"frame_max_us\":%.1f}\n",
+           LED_MATRIX_COUNT, LED_OUTPUT_PARALLEL,
+           cycles_to_us(stats_avg(&idle)), cycles_to_us(idle.max),
+           cycles_to_us(stats_avg(&busy)), cycles_to_us(busy.max));
+    return true;
+}
+
+/* I2S: time blocked in a one-DMA-buffer write once the DMA is full; on
+ * average that is the buffer's play time, the spread is the jitter */
+
+static I2SOutput s_i2s;
+
+static bool bench_i2s(void)
+{
+    if (s_i2s.init(s_rates[0]) != ESP_OK) {
+        ESP_LOGE(TAG, "I2S init");
+        return false;
+    }
+    bool ok = true;
+    for (size_t r = 0; ok && r < sizeof(s_rates) / sizeof(s_rates[0]); r++) {
+        const uint32_t rate = s_rates[r];
+        if (s_i2s.reconfigure(rate, I2S_LATENCY_STANDARD) != ESP_OK) {
+            ok = false;
+            break;
+        }
+        const size_t bytes = s_i2s.getDmaFrameNum() * I2SOutput::FRAME_BYTES;
+        uint8_t *buf = (uint8_t *)heap_caps_calloc(1, bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!buf) {
+            ok = false;
+            break;
+        }
+        cycle_stats_t s;
+        stats_reset(&s);
+        uint32_t short_writes = 0;
+        const uint32_t fill = s_i2s.getDmaDescNum();
+        for (uint32_t w = 0; w < fill + I2S_WRITES; w++) {
+            const uint32_t t0 = esp_cpu_get_cycle_count();
+            const size_t n = s_i2s.write(buf, bytes);
+            const uint32_t t1 = esp_cpu_get_cycle_count();
+            if (n != bytes) short_writes++;
+            if (w >= fill) stats_add(&s, t1 - t0);
+        }
+        heap_caps_free(buf);
+        printf("{\"suite\":\"i2s\",\"rate\":%" PRIu32 ",\"dma\":\"%" PRIu32 "x%" PRIu32 "\",\"buffer_us\":%.1f,"
+               "\"block_us\":%.1f,\"block_min_us\":%.1f,\"block_max_us\":%.1f,\"short_writes\":%" PRIu32 "}\n",
+               rate, s_i2s.getDmaDescNum(), s_i2s.getDmaFrameNum(), 1e6 * s_i2s.getDmaFrameNum() / rate,
+               cycles_to_us(stats_avg(&s)), cycles_to_us(s.min), cycles_to_us(s.max), short_writes);
+    }
+    s_i2s.zeroDMA();
+    return ok;
+}
+
+/* SIMD: each PIE kernel (dsp/pie_kernels.h) against its scalar reference
+ * on the same block of random samples, at a few misalignments, outputs
+ * compared bit for bit; then both timed on the aligned block */
+
+#define SIMD_SAMPLES    (APP_DSP_OUT_FRAMES * 2)
+#define SIMD_PAD        4
+#define SIMD_RUNS       50
+
+typedef struct {
+    const char *name;
+    int32_t range;          // Samples in (-range, range); 0 = full scale
+    bool spike;             // One full scale sample late in the block
+    void (*run)(int32_t *out, size_t off, size_t n, bool simd);
+} simd_case_t;
+
+alignas(16) static int32_t s_simd_src[SIMD_SAMPLES + SIMD_PAD];
+alignas(16) static int32_t s_simd_ref[SIMD_SAMPLES + SIMD_PAD];
+alignas(16) static int32_t s_simd_vec[SIMD_SAMPLES + SIMD_PAD];
+
+static uint32_t s_simd_seed = 0x2545F491;
+
+static uint32_t simd_rand(void)
+{
+    s_simd_seed ^= s_simd_seed << 13;
+    s_simd_seed ^= s_simd_seed >> 17;
+    s_simd_seed ^= s_simd_seed << 5;
+    return s_simd_seed;
+}
+
+static void simd_shl(int32_t *out, size_t off, size_t n, bool simd)
+{
+    (simd ? vec_shl_s32 : vec_shl_s32_ref)(out + off, s_simd_src + off, n, 8);
+}
+
+static void simd_sra(int32_t *out, size_t off, size_t n, bool simd)
+{
+    (simd ? vec_sra_s32 : vec_sra_s32_ref)(out + off, n, 4);     // Q31 -> Q27
+}
+
+static void simd_within(int32_t *out, size_t off, size_t n, bool simd)
+{
+    out[0] = (simd ? vec_within_s32 : vec_within_s32_ref)(s_simd_src + off, n, 1 << 16);
+}
+
+static void simd_scale(int32_t *out, size_t off, size_t n, bool simd)
+{
+    // Same bytes as the int32 block, as 8.8 channels at halfword offsets
+    (simd ? vec_scale_u16 : vec_scale_u16_ref)((uint16_t *)out + off * 3, n, 77);
+}
+
+static const simd_case_t s_simd_cases[] = {
+    {"shl_s32",      0,       false, simd_shl},
+    {"sra_s32",      0,       false, simd_sra},
+    {"within_quiet", 1 << 12, false, simd_within},
+    {"within_spike", 1 << 12, true,  simd_within},
+    {"scale_u16",    0,       false, simd_scale},
+};
+
+static bool bench_simd(void)
+{
+#if !APP_DSP_SIMD
+    printf("{\"suite\":\"simd\",\"skipped\":\"no PIE\"}\n");
+    return true;
+#else
+    bool ok = true;
+    for (const simd_case_t &c : s_simd_cases) {
+        for (size_t i = 0; i < SIMD_SAMPLES + SIMD_PAD; i++) {
+            const uint32_t r = simd_rand();
+            s_simd_src[i] = c.range ? (int32_t)(r % (2 * c.range - 1)) - (c.range - 1) : (int32_t)r;
+        }
+        if (c.spike) {
+            s_simd_src[SIMD_SAMPLES - 1 - simd_rand() % (SIMD_SAMPLES / 4)] = INT32_MIN;
+        }
+
+        bool exact = true;
+        for (size_t off = 0; off < SIMD_PAD; off++) {
+            const size_t n = SIMD_SAMPLES - off;
+            memcpy(s_simd_ref, s_simd_src, sizeof(s_simd_src));
+            memcpy(s_simd_vec, s_simd_src, sizeof(s_simd_src));
+            c.run(s_simd_ref, off, n, false);
+            c.run(s_simd_vec, off, n, true);
+            exact = exact && memcmp(s_simd_ref, s_simd_vec, sizeof(s_simd_ref)) == 0;
+        }
+
+        cycle_stats_t ref, vec;
+        stats_reset(&ref);
+        stats_reset(&vec);
+        for (int i = 0; i < SIMD_RUNS; i++) {
+            uint32_t t0 = esp_cpu_get_cycle_count();
+            c.run(s_simd_ref, 0, SIMD_SAMPLES, false);
+            stats_add(&ref, esp_cpu_get_cycle_count() - t0);
+            t0 = esp_cpu_get_cycle_count();
+            c.run(s_simd_vec, 0, SIMD_SAMPLES, true);
+            stats_add(&vec, esp_cpu_get_cycle_count() - t0);
+        }
+        const uint32_t vec_avg = stats_avg(&vec);
+        printf("{\"suite\":\"simd\",\"kernel\":\"%s\",\"samples\":%d,\"exact\":%s,"
+               "\"ref_cycles\":%" PRIu32 ",\"simd_cycles\":%" PRIu32 ",\"speedup\":%.2f}\n",
+               c.name, SIMD_SAMPLES, exact ? "true" : "false", stats_avg(&ref), vec_avg,
+               vec_avg ? (double)stats_avg(&ref) / vec_avg : 0.0);
+        ok = ok && exact;
+    }
+    return ok;
+#endif
+}
+
+/* Sound store: one prompt-sized WAV written to an asset slot and to a
+ * SPIFFS file (the capture partition), then the time from open to the
+ * first 20 ms chunk and for the whole sound read back */
+
+#define STORE_RATE      48000
+#define STORE_MS        500
+#define STORE_MOUNT     "/sndbench"
+#define STORE_PATH      STORE_MOUNT "/store.wav"
+
+static void print_store(const char *store, size_t bytes, int64_t write_us, int64_t open_us, int64_t read_us)
+{
+    printf("{\"suite\":\"sound_store\",\"store\":\"%s\",\"bytes\":%u,\"write_ms\":%.1f,"
+           "\"write_kbps\":%.0f,\"first_chunk_us\":%" PRId64 ",\"read_ms\":%.2f}\n",
+           store, (unsigned)bytes, write_us / 1000.0, write_us ? bytes * 1e6 / 1024.0 / write_us : 0.0,
+           open_us, read_us / 1000.0);
+}
+
+// Open to the first chunk, then the rest; false if the sound reads short
+static bool store_read(WavSource &src, uint8_t *chunk, size_t chunk_bytes, int64_t t0,
+                       int64_t *open_us, int64_t *read_us)
+{
+    size_t total = src.read(chunk, chunk_bytes);
+    *open_us = esp_timer_get_time() - t0;
+    size_t n;
+    while ((n = src.read(chunk, chunk_bytes)) > 0) total += n;
+    *read_us = esp_timer_get_time() - t0;
+    const bool ok = total == src.dataBytes;
+    src.close();
+    return ok;
+}
+
+static bool bench_sound_store(void)
+{
+    const size_t data_bytes = STORE_RATE * STORE_MS / 1000 * 4;
+    const size_t len = sizeof(WavHeader) + 8 + data_bytes;
+    const size_t chunk_bytes = STORE_RATE / 50 * 4;
+    uint8_t *wav = (uint8_t *)heap_caps_malloc(len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!wav) wav = (uint8_t *)heap_caps_malloc(len, MALLOC_CAP_8BIT);
+    uint8_t *chunk = (uint8_t *)heap_caps_malloc(chunk_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!wav || !chunk) {
+        heap_caps_free(wav);
+        heap_caps_free(chunk);
+        ESP_LOGE(TAG, "Sound store buffers");
+        return false;
+    }
+
+    WavHeader h = {};
+    memcpy(h.riff, "RIFF", 4);
+    memcpy(h.wave, "WAVE", 4);
+    memcpy(h.fmt, "fmt ", 4);
+    h.fileSize = len - 8;
+    h.fmtSize = 16;
+    h.audioFormat = 1;
+    h.numChannels = 2;
+    h.sampleRate = STORE_RATE;
+    h.bitsPerSample = 16;
+    h.blockAlign = 4;
+    h.byteRate = STORE_RATE * 4;
+    memcpy(wav, &h, sizeof(h));
+    const uint32_t chunk_size = data_bytes;
+    memcpy(wav + sizeof(h), "data", 4);
+    memcpy(wav + sizeof(h) + 4, &chunk_size, 4);
+    int16_t *pcm = (int16_t *)(wav + sizeof(h) + 8);
+    for (size_t i = 0; i < data_bytes / 4; i++) {
+        pcm[2 * i] = pcm[2 * i + 1] = (int16_t)(8000.0f * sinf(2.0f * (float)M_PI * 440.0f * i / STORE_RATE));
+    }
+
+    bool ok = true;
+    int64_t write_us, open_us, read_us;
+
+    // Raw asset slot (pause 0: erase and write time only, no BT to yield to)
+    static SoundAssets s_assets;
+    if (!s_assets.available() && !s_assets.init()) {
+        printf("{\"suite\":\"sound_store\",\"store\":\"assets\",\"skipped\":\"no '%s' partition\"}\n",
+               APP_SOUND_ASSET_LABEL);
+    } else {
+        int64_t t0 = esp_timer_get_time();
+        const bool written = s_assets.write(0, wav, len, 0);
+        write_us = esp_timer_get_time() - t0;
+        WavSource src;
+        t0 = esp_timer_get_time();
+        if (written && s_assets.open(0, src) && store_read(src, chunk, chunk_bytes, t0, &open_us, &read_us)) {
+            print_store("assets", data_bytes, write_us, open_us, read_us);
+        } else {
+            ESP_LOGE(TAG, "Sound store: asset slot");
+            ok = false;
+        }
+        s_assets.remove(0);
+    }
+
+    // SPIFFS file, as the sounds were stored before the asset partition
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = STORE_MOUNT,
+        .partition_label = "bench",
+        .max_files = 2,
+        .format_if_mount_failed = false,
+    };
+    if (esp_vfs_spiffs_register(&conf) != ESP_OK) {
+        printf("{\"suite\":\"sound_store\",\"store\":\"spiffs\",\"skipped\":\"no bench filesystem\"}\n");
+    } else {
+        int64_t t0 = esp_timer_get_time();
+        size_t written = 0;
+        if (FILE *f = fopen(STORE_PATH, "wb")) {
+            written = fwrite(wav, 1, len, f);
+            fclose(f);
+        }
+        write_us = esp_timer_get_time() - t0;
+        WavSource src;
+        if (written != len) {
+            // A capture partition near full is not a failure of the store
+            printf("{\"suite\":\"sound_store\",\"store\":\"spiffs\",\"skipped\":\"write %u of %u bytes\"}\n",
+                   (unsigned)written, (unsigned)len);
+        } else {
+            t0 = esp_timer_get_time();
+            if (src.openFile(STORE_PATH) && store_read(src, chunk, chunk_bytes, t0, &open_us, &read_us)) {
+                print_store("spiffs", data_bytes, write_us, open_us, read_us);
+            } else {
+                ESP_LOGE(TAG, "Sound store: SPIFFS read");
+                ok = false;
+            }
+        }
+        remove(STORE_PATH);
+        esp_vfs_spiffs_unregister("bench");
+    }
+
+    heap_caps_free(chunk);
+    heap_caps_free(wav);
+    return ok;
+}
+
+void system_bench_print_info(void)
+{
+    const esp_app_desc_t *app = esp_app_get_description();
+#if CONFIG_SPIRAM
+    const size_t psram = esp_psram_is_initialized() ? esp_psram_get_size() : 0;
+#else
+    const size_t psram = 0;
+#endif
+    printf("{\"suite\":\"info\",\"app\":\"%s\",\"idf\":\"%s\",\"built\":\"%s %s\",\"cpu_mhz\":%d,"
+           "\"psram_bytes\":%u,\"internal_free\":%u}\n",
+           app->version, app->idf_ver, app->date, app->time, esp_clk_cpu_freq() / 1000000,
+           (unsigned)psram, (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+}
+
+int system_bench_run(void)
+{
+    int failed = 0;
+    failed += bench_dsp() ? 0 : 1;
+    failed += bench_golden() ? 0 : 1;
+    failed += bench_overlay() ? 0 : 1;
+    failed += bench_memcpy() ? 0 : 1;
+    failed += bench_led() ? 0 : 1;
+    failed += bench_i2s() ? 0 : 1;
+    failed += bench_simd() ? 0 : 1;
+    failed += bench_sound_store() ? 0 : 1;
+    return failed;
+}
@@ -0,0 +1,29 @@
+/*
+ * System benchmark: the sink's own DSP, LED output, overlay mixer and I2S
+ * output (from ../../main) timed on the device, plus memory bandwidth and
+ * sound storage (asset partition against a SPIFFS file).
+ *
+ * Every result is one JSON object per line on the console, so runs on the
+ * same board can be compared across firmware versions:
+ *
+ *   {"suite":"dsp","mode":"bass_boost","rate":48000,"frames":256,...}
+ *
+ * Cycle counts are CPU cycles of the core the suite runs on. The "golden"
+ * suite also checks the DSP's output against the host's fingerprints
+ * (../core/dsp_golden.h) and fails past the cycle budget.
+ */
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Build and board: app version, IDF version, CPU clock, PSRAM
+void system_bench_print_info(void);
+
+// Runs every suite on the calling task; returns the number that failed
+int system_bench_run(void);
+
+#ifdef __cplusplus
+}
+#endif
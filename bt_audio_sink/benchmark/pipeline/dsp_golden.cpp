@@ -0,0 +1,194 @@
+/*
+ * Host run of the DSP golden-vector suite (../core/dsp_golden.h): every
+ * signal, mode and rate through main/'s DSPProcessor on the simulated
+ * heap, fingerprints checked against ../core/dsp_golden_ref.h, and the
+ * block converters checked bit for bit.
+ *
+ *     dsp_golden [--path float|q31] [--graph] [--update FILE] [-v]
+ *
+ *     --path P     only that sample path (default: every path built in;
+ *                  q31 needs CONFIG_DSP_Q31_PATH)
+ *     --graph      float path through a compiled stage schedule: PEQ and
+ *                  dynamics (flat and off here) moved to the front, so
+ *                  the fused chains' table must still match
+ *     --update F   write the float path's fingerprints to F as the new
+ *                  golden table, nothing is checked
+ *     -v           one line per case, with the host time per block
+ *
+ * Host times are for orientation only; the cycle budget is asserted on
+ * the device ("golden" system suite).
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim.h"
+#include "dsp_golden.h"
+#include "dsp_golden_ref.h"
+
+using namespace dsp_golden;
+
+static DSPProcessor g_dsp;
+
+static uint32_t hostNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+
+static void writeFloats(FILE* f, const float* v, size_t n) {
+    for (size_t i = 0; i < n; i++) fprintf(f, "%s%.3f", i ? ", " : "", v[i]);
+}
+
+static bool writeTable(const char* path, const Ref* refs, size_t count) {
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        printf("%s: cannot write\n", path);
+        return false;
+    }
+    fprintf(f, "/*\n"
+               " * Golden fingerprints of the DSP suite (dsp_golden.h), written by\n"
+               " * pipeline/dsp_golden --update from the host's float path with the\n"
+               " * Kconfig defaults. Do not edit; regenerate after an intended change.\n"
+               " *\n"
+               " * {signal, mode, rate, {rms dB [segment][L, R], correlation\n"
+               " * [segment][L, R], peak dB [L, R]}}\n"
+               " */\n"
+               "#pragma once\n\n"
+               "static const dsp_golden::Ref DSP_GOLDEN_REF[] = {\n");
+    for (size_t i = 0; i < count; i++) {
+        const Ref& r = refs[i];
+        fprintf(f, "    // %s, %s, %" PRIu32 " Hz\n", SIGNAL_NAMES[r.signal], MODES[r.mode].name, r.rate);
+        fprintf(f, "    {%u, %u, %" PRIu32 ", {\n        {", (unsigned)r.signal, (unsigned)r.mode, r.rate);
+        for (uint32_t s = 0; s < SEGMENTS; s++) {
+            fprintf(f, "%s{", s ? ", " : "");
+            writeFloats(f, r.print.rmsDb[s], 2);
+            fprintf(f, "}");
+        }
+        fprintf(f, "},\n        {");
+        for (uint32_t s = 0; s < SEGMENTS; s++) {
+            fprintf(f, "%s{", s ? ", " : "");
+            writeFloats(f, r.print.corr[s], 2);
+            fprintf(f, "}");
+        }
+        fprintf(f, "},\n        {");
+        writeFloats(f, r.print.peakDb, 2);
+        fprintf(f, "}}},\n");
+    }
+    fprintf(f, "};\n");
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* update = nullptr;
+    bool runFloat = true;
+    bool runQ31 = APP_DSP_Q31_PATH != 0;
+    bool verbose = false;
+    bool graph = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--update") && i + 1 < argc) {
+            update = argv[++i];
+        } else if (!strcmp(argv[i], "--path") && i + 1 < argc) {
+            const char* p = argv[++i];
+            runFloat = !strcmp(p, "float");
+            runQ31 = !strcmp(p, "q31");
+            if (runQ31 && !APP_DSP_Q31_PATH) {
+                printf("q31: not built with CONFIG_DSP_Q31_PATH\n");
+                return 2;
+            }
+            if (!runFloat && !runQ31) {
+                printf("unknown path '%s'\n", p);
+                return 2;
+            }
+        } else if (!strcmp(argv[i], "--graph")) {
+            graph = true;
+        } else if (!strcmp(argv[i], "-v")) {
+            verbose = true;
+        } else {
+            printf("usage: %s [--path float|q31] [--graph] [--update FILE] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (update) {
+        runFloat = true;
+        runQ31 = false;
+    }
+    sim::setLogLevel(ESP_LOG_WARN);
+    sim::heapConfigure(128 * 1024, 4096 * 1024);
+    g_dsp.init(RATES[0]);
+    if (graph) {
+#if APP_DSP_GRAPH
+        // The schedule runs the float path only
+        static const uint8_t ORDER[] = {6, DspGraph::NODE_PEQ, DspGraph::NODE_DYNAMICS, DspGraph::NODE_TONE,
+                                        DspGraph::NODE_3D, DspGraph::NODE_EAR, DspGraph::NODE_LIMITER};
+        DspGraph g;
+        if (!DspGraph::parse(ORDER, sizeof(ORDER), g) || !g_dsp.setGraph(g) || !g_dsp.hasCustomGraph()) {
+            printf("graph: rejected\n");
+            return 1;
+        }
+        runFloat = true;
+        runQ31 = false;
+#else
+        printf("graph: not built with CONFIG_DSP_GRAPH\n");
+        return 2;
+#endif
+    }
+
+    static float buf[BLOCK * 2];
+    static Ref refs[SIG_COUNT * MODE_COUNT * RATE_COUNT];
+    size_t refCount = 0;
+    int failed = 0, cases = 0;
+    const size_t tableSize = sizeof(DSP_GOLDEN_REF) / sizeof(DSP_GOLDEN_REF[0]);
+
+    for (int path = 0; path < 2; path++) {
+        const bool q31 = path == 1;
+        if (q31 ? !runQ31 : !runFloat) continue;
+        for (int r = 0; r < RATE_COUNT; r++) {
+            for (int m = 0; m < MODE_COUNT; m++) {
+                for (int s = 0; s < SIG_COUNT; s++) {
+                    Print print;
+                    Timing timing;
+                    run(g_dsp, (Signal)s, MODES[m], RATES[r], q31, buf, hostNs, print, timing);
+                    cases++;
+                    if (update) {
+                        refs[refCount++] = Ref{(uint8_t)s, (uint8_t)m, RATES[r], print};
+                        continue;
+                    }
+                    char what[96];
+                    const Ref* ref = findRef(DSP_GOLDEN_REF, tableSize, (Signal)s, m, RATES[r]);
+                    bool ok = ref != nullptr;
+                    if (!ref) {
+                        snprintf(what, sizeof(what), "no golden entry");
+                    } else {
+                        ok = compare(print, ref->print, q31, what, sizeof(what));
+                    }
+                    if (!ok) failed++;
+                    if (!ok || verbose) {
+                        printf("%-5s %-7s %-10s %6" PRIu32 " Hz  %s  %6.1f us/block%s%s\n", q31 ? "q31" : "float",
+                               SIGNAL_NAMES[s], MODES[m].name, RATES[r], ok ? "ok  " : "FAIL",
+                               timing.avg / 1000.0, ok ? "" : "  ", what);
+                    }
+                }
+            }
+        }
+    }
+
+    if (update) {
+        if (!writeTable(update, refs, refCount)) return 1;
+        printf("%d cases written to %s\n", cases, update);
+        return 0;
+    }
+
+    char what[128];
+    const bool convOk = checkConverters(what, sizeof(what));
+    if (!convOk) {
+        printf("converters FAIL  %s\n", what);
+        failed++;
+    }
+    printf("%d of %d DSP cases match the golden table, converters %s\n", cases - (failed - !convOk), cases,
+           convOk ? "exact" : "differ");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,605 @@
+/*
+ * Host simulation of the sink's audio path: PCM is fed through the real
+ * AudioPipeline, DSPProcessor and I2SOutput from main/, set up the way
+ * main.cpp sets them up for a stream, with the I2S DMA, FreeRTOS and the
+ * heap simulated on a virtual clock (port/). Runs faster than real time
+ * and reproducibly, so pipeline changes can be checked for throughput,
+ * allocations in the audio path and bit-exact output without a board.
+ *
+ *     pipeline_sim [options] [capture.wav]
+ *
+ *     --codec NAME     sbc aac aptx aptx-ll aptx-hd ldac opus lc3plus: the
+ *                      codec's jitter target, DMA depth and packet size
+ *     --rate HZ        synthetic input (without a capture): sample rate,
+ *     --bits N         16, 24 or 32 bits,
+ *     --seconds S      and length
+ *     --packet N       frames per packet
+ *     --ppm N          source clock offset against the nominal rate
+ *     --jitter MS      packet arrival jitter (uniform, seeded)
+ *     --seed N
+ *     --internal-kb N  internal RAM free at startup (default 128)
+ *     --psram-kb N     PSRAM (default 4096, 0 = none)
+ *     --dynamics N     multiband dynamics preset (0 off, default)
+ *     --bypass         full range on both channels (crossover off)
+ *     --settle-ms N    start-up time after the jitter buffer first releases
+ *                      that --strict forgives underruns in (default 1000)
+ *     --strict         fail on underruns, drops or allocations while streaming,
+ *                      or input frames the pipeline never took from the ring
+ *     --bit-exact      fail unless, once streaming, every 32-bit output
+ *                      sample has nothing below the source's bits (the
+ *                      PCM passed through unscaled: CONFIG_DSP_PASSTHROUGH)
+ *     --capture-out F  with CONFIG_PCM_CAPTURE: the capture image, re-armed
+ *                      after start-up and frozen when the source ends, to F
+ *                      (checked either way)
+ *     --switch-at S    codec switch after S seconds of source, as
+ *                      onCodecConfig() runs it: the stream carries on at
+ *     --switch-rate HZ this rate (default the same); --strict then also
+ *                      fails on the gap (CONFIG_CODEC_BRIDGE covers it)
+ *     -v               pipeline logs
+ *
+ * Captures are WAV (PCM 16/24/32-bit, mono or stereo). If "<capture>.crc"
+ * exists (hex CRC32 of the I2S output), the output must match it.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "sim.h"
+#include "audio/audio_pipeline.h"
+#include "audio/i2s_output.h"
+#include "dsp/dsp_processor.h"
+
+static AudioPipeline g_pipeline;
+static DSPProcessor g_dsp;
+static I2SOutput g_i2s;
+
+struct CodecProfile {
+    const char* name;
+    uint32_t targetMs;
+    I2SLatencyClass latency;
+    uint32_t packetFrames;      // Typical PCM per media packet
+    SampleFmt wideFmt;          // Layout of the decoder's > 16-bit output
+};
+
+// Mirrors jitterTargetForCodec(), i2sLatencyForCodec() and
+// sampleFmtForCodec() in main.cpp
+static const CodecProfile s_codecs[] = {
+    {"sbc",     APP_JB_TARGET_SBC_MS,     I2S_LATENCY_STANDARD, 512,  SAMPLE_FMT_S32},
+    {"aac",     APP_JB_TARGET_AAC_MS,     I2S_LATENCY_DEEP,     1024, SAMPLE_FMT_S32},
+    {"aptx",    APP_JB_TARGET_APTX_MS,    I2S_LATENCY_STANDARD, 1024, SAMPLE_FMT_S32},
+    {"aptx-ll", APP_JB_TARGET_APTX_LL_MS, I2S_LATENCY_LOW,      256,  SAMPLE_FMT_S32},
+    {"aptx-hd", APP_JB_TARGET_APTX_HD_MS, I2S_LATENCY_DEEP,     1024, SAMPLE_FMT_S32},
+    {"ldac",    APP_JB_TARGET_LDAC_MS,    I2S_LATENCY_DEEP,     256,  SAMPLE_FMT_S32},
+    {"opus",    APP_JB_TARGET_OPUS_MS,    I2S_LATENCY_LOW,      960,  SAMPLE_FMT_S32},
+    {"lc3plus", APP_JB_TARGET_LC3PLUS_MS, I2S_LATENCY_LOW,      480,  SAMPLE_FMT_S24_IN_32},
+};
+
+struct Options {
+    const char* capture = nullptr;
+    const char* captureOut = nullptr;
+    const CodecProfile* codec = &s_codecs[0];
+    uint32_t rate = 44100;
+    uint32_t bits = 16;
+    double seconds = 10.0;
+    uint32_t packetFrames = 0;
+    double ppm = 0.0;
+    double jitterMs = 0.0;
+    uint32_t seed = 1;
+    uint32_t internalKb = 128;
+    uint32_t psramKb = 4096;
+    uint32_t settleMs = 1000;
+    uint8_t dynamics = 0;
+    double switchAt = 0.0;
+    uint32_t switchRate = 0;
+    bool bypass = false;
+    bool bitExact = false;
+    bool strict = false;
+    bool verbose = false;
+};
+
+// Packet source: the decoder's side of the ring
+struct Source {
+    const uint8_t* pcm;         // Capture, or null for the synthetic signal
+    uint64_t totalFrames;
+    uint32_t rate;
+    uint8_t channels;
+    SampleFmt fmt;
+    uint32_t bytesPerFrame;
+    uint32_t packetFrames;
+    double intervalUs;          // Per packet, at the source's clock
+    double jitterUs;
+    uint32_t rng;
+
+    uint64_t sent;              // Frames
+    uint32_t packets;
+    int64_t startUs;
+    int64_t lastUs;
+    uint8_t* packet;
+    double phase[2];
+};
+
+static uint32_t xorshift(uint32_t& s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+static void storeSample(uint8_t* p, SampleFmt fmt, double v) {
+    if (v > 0.999) v = 0.999;
+    if (v < -0.999) v = -0.999;
+    switch (fmt) {
+        case SAMPLE_FMT_S16: {
+            int16_t s = (int16_t)lrint(v * 32767.0);
+            memcpy(p, &s, 2);
+            break;
+        }
+        case SAMPLE_FMT_S24_PACKED: {
+            int32_t s = (int32_t)lrint(v * 8388607.0);
+            p[0] = (uint8_t)s;
+            p[1] = (uint8_t)(s >> 8);
+            p[2] = (uint8_t)(s >> 16);
+            break;
+        }
+        case SAMPLE_FMT_S24_IN_32: {
+            int32_t s = (int32_t)lrint(v * 8388607.0);
+            memcpy(p, &s, 4);
+            break;
+        }
+        default: {
+            int32_t s = (int32_t)lrint(v * 2147483647.0);
+            memcpy(p, &s, 4);
+            break;
+        }
+    }
+}
+
+// Synthetic program: a log sweep 20 Hz - 20 kHz on the left, a 1 kHz tone
+// with a slow tremolo on the right, both around -6 dBFS
+static void synthesize(Source& src, uint8_t* out, uint32_t frames) {
+    const double total = (double)src.totalFrames;
+    const double k = log(20000.0 / 20.0);
+    const uint32_t sampleBytes = src.bytesPerFrame / src.channels;
+    for (uint32_t i = 0; i < frames; i++) {
+        const double n = (double)(src.sent + i);
+        const double f = 20.0 * exp(k * n / total);
+        src.phase[0] += 2.0 * M_PI * f / src.rate;
+        src.phase[1] += 2.0 * M_PI * 1000.0 / src.rate;
+        if (src.phase[0] > 2.0 * M_PI) src.phase[0] -= 2.0 * M_PI;
+        if (src.phase[1] > 2.0 * M_PI) src.phase[1] -= 2.0 * M_PI;
+        const double tremolo = 0.75 + 0.25 * sin(2.0 * M_PI * 2.0 * n / src.rate);
+        uint8_t* p = out + (size_t)i * src.bytesPerFrame;
+        storeSample(p, src.fmt, 0.5 * sin(src.phase[0]));
+        if (src.channels > 1) storeSample(p + sampleBytes, src.fmt, 0.5 * tremolo * sin(src.phase[1]));
+    }
+}
+
+// Deliver one packet; returns when the next one arrives
+static int64_t onPacket(void* ctx) {
+    Source& src = *(Source*)ctx;
+    uint64_t left = src.totalFrames - src.sent;
+    uint32_t frames = left < src.packetFrames ? (uint32_t)left : src.packetFrames;
+    const uint8_t* data;
+    if (src.pcm) {
+        data = src.pcm + src.sent * src.bytesPerFrame;
+    } else {
+        // As Bluedroid does: decode into ring space the pipeline lends
+        size_t lentSize = 0;
+        uint8_t* lent = g_pipeline.lendPcmBuffer(frames * src.bytesPerFrame, &lentSize);
+        uint8_t* out = lent ? lent : src.packet;
+        synthesize(src, out, frames);
+        data = out;
+    }
+    const uint32_t rtpTs = (uint32_t)src.sent;
+    g_pipeline.stampNextWrite(rtpTs, (uint32_t)sim::nowUs());
+    g_pipeline.enqueue(data, frames * src.bytesPerFrame, src.fmt, src.channels);
+    src.sent += frames;
+    src.packets++;
+    if (src.sent >= src.totalFrames) return -1;
+
+    // In order: a late packet holds back the ones behind it
+    double due = src.startUs + src.packets * src.intervalUs;
+    if (src.jitterUs > 0) due += src.jitterUs * (xorshift(src.rng) / 4294967296.0);
+    int64_t next = (int64_t)due;
+    if (next < src.lastUs) next = src.lastUs;
+    src.lastUs = next;
+    return next;
+}
+
+static uint8_t* readFile(const char* path, size_t& len) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return nullptr;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* buf = size > 0 ? (uint8_t*)malloc((size_t)size) : nullptr;
+    if (buf && fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        free(buf);
+        buf = nullptr;
+    }
+    fclose(f);
+    len = (size_t)size;
+    return buf;
+}
+
+static uint32_t le16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+// RIFF/WAVE with PCM (or extensible PCM) data
+static bool parseWav(const uint8_t* buf, size_t len, Source& src) {
+    if (len < 12 || memcmp(buf, "RIFF", 4) || memcmp(buf + 8, "WAVE", 4)) return false;
+    uint32_t bits = 0;
+    bool haveFmt = false;
+    for (size_t pos = 12; pos + 8 <= len;) {
+        const uint8_t* chunk = buf + pos;
+        uint32_t size = le32(chunk + 4);
+        if (size > len - pos - 8) size = (uint32_t)(len - pos - 8);
+        if (!memcmp(chunk, "fmt ", 4) && size >= 16) {
+            uint32_t tag = le16(chunk + 8);
+            if (tag == 0xFFFE && size >= 40) tag = le16(chunk + 8 + 24);
+            if (tag != 1) return false;
+            src.channels = (uint8_t)le16(chunk + 10);
+            src.rate = le32(chunk + 12);
+            bits = le16(chunk + 22);
+            haveFmt = true;
+        } else if (!memcmp(chunk, "data", 4) && haveFmt) {
+            if (src.channels < 1 || src.channels > 2 || src.rate == 0) return false;
+            switch (bits) {
+                case 16: src.fmt = SAMPLE_FMT_S16; break;
+                case 24: src.fmt = SAMPLE_FMT_S24_PACKED; break;
+                case 32: src.fmt = SAMPLE_FMT_S32; break;
+                default: return false;
+            }
+            src.bytesPerFrame = sampleFmtBytes(src.fmt) * src.channels;
+            src.pcm = chunk + 8;
+            src.totalFrames = size / src.bytesPerFrame;
+            return src.totalFrames > 0;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+static bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "--strict")) {
+            opt.strict = true;
+        } else if (!strcmp(a, "--bypass")) {
+            opt.bypass = true;
+        } else if (!strcmp(a, "--bit-exact")) {
+            opt.bitExact = true;
+        } else if (!strcmp(a, "-v")) {
+            opt.verbose = true;
+        } else if (a[0] != '-') {
+            opt.capture = a;
+        } else if (!v) {
+            return false;
+        } else {
+            i++;
+            if (!strcmp(a, "--codec")) {
+                opt.codec = nullptr;
+                for (const CodecProfile& c : s_codecs) {
+                    if (!strcmp(c.name, v)) opt.codec = &c;
+                }
+                if (!opt.codec) return false;
+            } else if (!strcmp(a, "--rate")) {
+                opt.rate = (uint32_t)atoi(v);
+            } else if (!strcmp(a, "--bits")) {
+                opt.bits = (uint32_t)atoi(v);
+            } else if (!strcmp(a, "--seconds")) {
+                opt.seconds = atof(v);
+            } else if (!strcmp(a, "--packet")) {
+                opt.packetFrames = (uint32_t)atoi(v);
+            } else if (!strcmp(a, "--ppm")) {
+                opt.ppm = atof(v);
+            } else if (!strcmp(a, "--jitter")) {
+                opt.jitterMs = atof(v);
+            } else if (!strcmp(a, "--seed")) {
+                opt.seed = (uint32_t)atoi(v);
+            } else if (!strcmp(a, "--internal-kb")) {
+                opt.internalKb = (uint32_t)atoi(v);
+            } else if (!strcmp(a, "--settle-ms")) {
+                opt.settleMs = (uint32_t)atoi(v);
+            } else if (!strcmp(a, "--psram-kb")) {
+                opt.psramKb = (uint32_t)atoi(v);
+            } else if (!strcmp(a, "--dynamics")) {
+                opt.dynamics = (uint8_t)atoi(v);
+            } else if (!strcmp(a, "--capture-out")) {
+                opt.captureOut = v;
+            } else if (!strcmp(a, "--switch-at")) {
+                opt.switchAt = atof(v);
+            } else if (!strcmp(a, "--switch-rate")) {
+                opt.switchRate = (uint32_t)atoi(v);
+            } else {
+                return false;
+            }
+        }
+    }
+    return opt.rate >= 8000 && (opt.bits == 16 || opt.bits == 24 || opt.bits == 32) && opt.seconds > 0 &&
+           (opt.switchRate == 0 || opt.switchRate >= 8000);
+}
+
+#if APP_PCM_CAPTURE
+static uint32_t get32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// The frozen image, read as the BLE client reads it: 250-byte chunks by
+// offset. Walks the records and counts each stream's frames.
+static bool checkCapture(const char* name, const char* outPath) {
+    const PcmCapture& cap = PcmCapture::getInstance();
+    const uint32_t total = cap.imageBytes();
+    if (cap.state() != PcmCapture::FROZEN || total < PcmCapture::HEADER_BYTES) {
+        printf("%s: capture not frozen (state %u)\n", name, (unsigned)cap.state());
+        return false;
+    }
+    uint8_t* image = (uint8_t*)malloc(total);
+    uint32_t got = 0;
+    while (got < total) {
+        const size_t n = cap.read(got, image + got, total - got < 250 ? total - got : 250);
+        if (n == 0) break;
+        got += (uint32_t)n;
+    }
+    bool ok = got == total && !memcmp(image, "ACAP", 4) && get32(image + 16) == total;
+    const uint32_t records = get32(image + 8);
+    const uint32_t markers = image[6] | image[7] << 8;
+    ok = ok && PcmCapture::HEADER_BYTES + records + markers * PcmCapture::MARKER_BYTES == total;
+    uint64_t frames[3] = {};
+    uint32_t blocks = 0;
+    for (uint32_t off = PcmCapture::HEADER_BYTES; ok && off < PcmCapture::HEADER_BYTES + records;) {
+        const uint8_t* r = image + off;
+        const uint32_t len = get32(r);
+        const uint8_t kind = r[4];
+        const uint32_t frameBytes = (kind == CAPTURE_POST_DSP ? 4 : sampleFmtBytes(r[5])) * r[6];
+        if ((kind != CAPTURE_PRE_DSP && kind != CAPTURE_POST_DSP) || !frameBytes || len % frameBytes) {
+            printf("%s: bad capture record at %" PRIu32 "\n", name, off);
+            ok = false;
+            break;
+        }
+        frames[kind] += len / frameBytes;
+        blocks++;
+        off += PcmCapture::RECORD_HEADER + ((len + 3) & ~3u);
+    }
+    ok = ok && frames[CAPTURE_PRE_DSP] > 0 && frames[CAPTURE_POST_DSP] > 0;
+    printf("%s: capture %" PRIu32 " KB %" PRIu32 " ms, %" PRIu32 " blocks, pre %" PRIu64
+           " post %" PRIu64 " frames, %" PRIu32 " markers%s\n",
+           name, total / 1024, cap.spanMs(), blocks, frames[CAPTURE_PRE_DSP], frames[CAPTURE_POST_DSP],
+           markers, ok ? "" : " - bad image");
+    if (ok && outPath) {
+        FILE* f = fopen(outPath, "wb");
+        ok = f && fwrite(image, 1, total, f) == total;
+        if (f) fclose(f);
+        if (!ok) printf("%s: cannot write %s\n", name, outPath);
+    }
+    free(image);
+    return ok;
+}
+#endif
+
+static uint64_t hostNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        printf("usage: %s [--codec NAME] [--rate HZ] [--bits N] [--seconds S] [--packet N] [--ppm N]\n"
+               "       [--jitter MS] [--seed N] [--internal-kb N] [--psram-kb N]\n"
+               "       [--settle-ms N] [--dynamics N] [--bypass] [--bit-exact] [--capture-out F] [--strict]\n"
+               "       [--switch-at S] [--switch-rate HZ]\n"
+               "       [-v] [capture.wav]\n",
+               argv[0]);
+        return 2;
+    }
+    const char* name = opt.capture ? opt.capture : "synthetic";
+    sim::setLogLevel(opt.verbose ? ESP_LOG_INFO : ESP_LOG_WARN);
+    sim::heapConfigure((size_t)opt.internalKb * 1024, (size_t)opt.psramKb * 1024);
+
+    Source src = {};
+    size_t fileLen = 0;
+    uint8_t* file = nullptr;
+    if (opt.capture) {
+        file = readFile(opt.capture, fileLen);
+        if (!file || !parseWav(file, fileLen, src)) {
+            printf("%s: not a PCM WAV file\n", name);
+            free(file);
+            return 1;
+        }
+    } else {
+        src.rate = opt.rate;
+        src.channels = 2;
+        src.fmt = opt.bits == 16 ? SAMPLE_FMT_S16 : opt.bits == 24 ? opt.codec->wideFmt : SAMPLE_FMT_S32;
+        if (opt.bits == 24 && src.fmt == SAMPLE_FMT_S32) src.fmt = SAMPLE_FMT_S24_PACKED;
+        src.bytesPerFrame = sampleFmtBytes(src.fmt) * src.channels;
+        src.totalFrames = (uint64_t)(opt.seconds * src.rate);
+    }
+    src.packetFrames = opt.packetFrames ? opt.packetFrames : opt.codec->packetFrames;
+    src.intervalUs = src.packetFrames * 1e6 / (src.rate * (1.0 + opt.ppm * 1e-6));
+    src.jitterUs = opt.jitterMs * 1000.0;
+    src.rng = opt.seed ? opt.seed : 1;
+    src.packet = (uint8_t*)malloc((size_t)src.packetFrames * src.bytesPerFrame);
+
+    // Boot, as app_main
+    sim::heapResetCounters();
+    if (g_i2s.init(APP_I2S_DEFAULT_SAMPLE_RATE) != ESP_OK || !g_pipeline.init()) {
+        printf("%s: pipeline init failed\n", name);
+        return 1;
+    }
+#if APP_PCM_CAPTURE
+    PcmCapture::getInstance().begin();
+#endif
+    g_dsp.init(APP_I2S_DEFAULT_SAMPLE_RATE);
+    if (!g_dsp.setDynamicsPreset(opt.dynamics)) {
+        printf("%s: unknown dynamics preset %u\n", name, opt.dynamics);
+        return 1;
+    }
+    g_dsp.setBypass(opt.bypass);
+
+    // Codec configured, as applyStreamFormat()
+    g_i2s.reconfigure(src.rate, opt.codec->latency);
+    g_dsp.setSampleRate(src.rate);
+    g_pipeline.setStreamFormat(src.rate, src.fmt, src.channels, opt.codec->targetMs);
+    const sim::HeapStats setup = sim::heapStats();
+    sim::heapResetCounters();
+
+    // Stream, as audioTxTask; the tail lets everything queued play out
+    src.startUs = sim::nowUs() + 10000;
+    src.lastUs = src.startUs;
+    sim::setSource(onPacket, &src, src.startUs);
+    const int64_t tailUs = (int64_t)opt.codec->targetMs * 1000 + g_i2s.getDmaLatencyUs() + 200000;
+    int64_t endUs = -1;
+    int64_t settleUs = -1;
+    uint32_t startDmaUnderruns = 0;
+    uint32_t startJitterUnderruns = 0;
+    uint32_t endJitterUnderruns = 0;
+    int64_t lastUs = -1;
+    uint32_t stalls = 0;
+    const uint64_t switchFrames = (uint64_t)(opt.switchAt * src.rate);
+    bool switched = opt.switchAt <= 0.0;
+    const uint64_t t0 = hostNs();
+    while (endUs < 0 || sim::nowUs() < endUs) {
+        if (!switched && src.sent >= switchFrames) {
+            // New codec configured, as onCodecConfig(); the source goes on
+            // at the new rate from the next packet
+            switched = true;
+            const uint32_t rate = opt.switchRate ? opt.switchRate : src.rate;
+#if APP_CODEC_BRIDGE
+            g_pipeline.bridgeStream();
+#else
+            g_pipeline.clear();
+#endif
+            g_i2s.reconfigure(rate, opt.codec->latency);
+            g_dsp.setSampleRate(rate);
+            g_pipeline.setStreamFormat(rate, src.fmt, src.channels, opt.codec->targetMs);
+            src.totalFrames = src.sent + (src.totalFrames - src.sent) * rate / src.rate;
+            src.rate = rate;
+            src.intervalUs = src.packetFrames * 1e6 / (src.rate * (1.0 + opt.ppm * 1e-6));
+            src.startUs = src.lastUs;
+            src.packets = 0;
+        }
+        g_pipeline.processBuffer(g_dsp, g_i2s);
+        if (g_pipeline.getJitterBuffer().isPlaying() && !sim::sourceDone()) {
+            sim::watchUnderruns(true);
+            if (settleUs < 0) settleUs = sim::nowUs() + (int64_t)opt.settleMs * 1000;
+        }
+        // Underruns up to here are the start-up's
+        if (settleUs >= 0 && sim::nowUs() < settleUs) {
+            sim::I2SStats s = {};
+            sim::i2sStats(APP_I2S_PORT, s);
+            startDmaUnderruns = s.underruns;
+            startJitterUnderruns = g_pipeline.getJitterBuffer().getUnderrunCount();
+            sim::i2sResetLowBits();     // Stream start ramps in
+#if APP_PCM_CAPTURE
+            // A start-up underrun froze it; the capture checked is the end
+            PcmCapture::getInstance().rearm();
+#endif
+        }
+        if (endUs < 0 && sim::sourceDone()) {
+            // The ring running dry after the last packet is not a glitch
+            sim::watchUnderruns(false);
+            endJitterUnderruns = g_pipeline.getJitterBuffer().getUnderrunCount();
+            endUs = sim::nowUs() + tailUs;
+#if APP_PCM_CAPTURE
+            PcmCapture::getInstance().freeze();
+#endif
+        }
+        // A pass that neither waited nor consumed: let a millisecond go by
+        // as the task's time slice would
+        if (sim::nowUs() == lastUs && ++stalls > 1000) {
+            sim::advanceTo(lastUs + 1000);
+            stalls = 0;
+        } else if (sim::nowUs() != lastUs) {
+            stalls = 0;
+        }
+        lastUs = sim::nowUs();
+    }
+    const double wallS = (hostNs() - t0) / 1e9;
+    const sim::HeapStats stream = sim::heapStats();
+
+    sim::I2SStats out = {};
+    sim::i2sStats(APP_I2S_PORT, out);
+    const JitterBuffer& jb = g_pipeline.getJitterBuffer();
+    const double audioS = (double)src.sent / src.rate;
+    printf("%s: %s %" PRIu32 "/%u/%u packets %" PRIu32 " frames/s %.0f (x%.1f real time)"
+           " heap setup %" PRIu32 "/%" PRIu64 " stream %" PRIu32 "/%" PRIu64
+           " internal %u KB psram %u KB\n",
+           name, opt.codec->name, src.rate, (unsigned)src.channels, (unsigned)(sampleFmtBytes(src.fmt) * 8),
+           src.packets, wallS > 0 ? src.sent / wallS : 0.0, wallS > 0 ? audioS / wallS : 0.0,
+           setup.allocs, setup.bytes, stream.allocs, stream.bytes,
+           (unsigned)(stream.internalUsed / 1024), (unsigned)(stream.psramUsed / 1024));
+    printf("%s: i2s %u Hz dma %ux%u sent %" PRIu32 " underruns %" PRIu32 " overflows %" PRIu32
+           " trim %+.1f ppm | jitter %u ms target %u underruns %" PRIu32 " stretch %" PRIu32
+           " shrink %" PRIu32 " | drops %" PRIu32 " enqueue fails %" PRIu32 " short writes %" PRIu32
+           " | pcm %" PRIu64 " crc %08" PRIx32 "\n",
+           name, (unsigned)out.rateHz, (unsigned)g_i2s.getDmaDescNum(), (unsigned)g_i2s.getDmaFrameNum(),
+           out.sent, out.underruns, out.overflows, (double)out.trimPpm,
+           (unsigned)jb.getDepthMs(), (unsigned)jb.getTargetMs(), jb.getUnderrunCount(),
+           jb.getStretchCount(), jb.getShrinkCount(),
+           g_pipeline.getDropCount(), g_pipeline.getEnqueueFailCount(), g_pipeline.getShortWriteCount(),
+           out.bytes, out.crc);
+    const AudioPipeline::FrameCounts frames = g_pipeline.getFrameCounts();
+    printf("%s: frames sent %" PRIu64 " in %" PRIu32 " out %" PRIu32 " dropped %" PRIu32 "\n",
+           name, src.sent, frames.in, frames.out, frames.dropped);
+#if APP_AUDIO_LATENCY_PROBE
+    TraceHistogram h;
+    g_pipeline.latency().snapshot(h);
+    if (h.count) {
+        printf("%s: latency n=%u min %.1f avg %.1f p99 %.1f max %.1f ms\n", name, (unsigned)h.count,
+               h.min / 1000.0f, h.avg() / 1000.0f, h.percentile(99) / 1000.0f, h.max / 1000.0f);
+    }
+#endif
+
+    bool ok = out.bytes > 0;
+    if (opt.strict) {
+        const uint32_t dmaUnderruns = out.underruns - startDmaUnderruns;
+        const uint32_t jitterUnderruns = endJitterUnderruns - startJitterUnderruns;
+        if (dmaUnderruns || jitterUnderruns || g_pipeline.getDropCount() ||
+            g_pipeline.getEnqueueFailCount() || g_pipeline.getShortWriteCount()) {
+            printf("%s: glitches while streaming (underruns after start-up: i2s %" PRIu32 " jitter %" PRIu32 ")\n",
+                   name, dmaUnderruns, jitterUnderruns);
+            ok = false;
+        }
+        if (frames.in != (uint32_t)src.sent || frames.out != frames.in || frames.dropped) {
+            printf("%s: frames lost between source and DSP\n", name);
+            ok = false;
+        }
+        if (stream.allocs) {
+            printf("%s: %" PRIu32 " allocations while streaming\n", name, stream.allocs);
+            ok = false;
+        }
+    }
+    if (opt.bitExact) {
+        const uint32_t below = src.fmt == SAMPLE_FMT_S16 ? 0xFFFFu : src.fmt == SAMPLE_FMT_S32 ? 0u : 0xFFu;
+        if (out.lowBits & below) {
+            printf("%s: output not bit-exact (low bits %04" PRIx32 ")\n", name, out.lowBits);
+            ok = false;
+        }
+    }
+#if APP_PCM_CAPTURE
+    if (!checkCapture(name, opt.captureOut)) ok = false;
+#endif
+    if (opt.capture) {
+        char crcPath[1024];
+        snprintf(crcPath, sizeof(crcPath), "%s.crc", opt.capture);
+        FILE* f = fopen(crcPath, "r");
+        if (f) {
+            unsigned int expect = 0;
+            int n = fscanf(f, "%x", &expect);
+            fclose(f);
+            if (n != 1 || expect != out.crc) {
+                printf("%s: crc %08" PRIx32 ", expected %08x\n", name, out.crc, expect);
+                ok = false;
+            }
+        }
+    }
+    free(src.packet);
+    free(file);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+/* Host port of clk_ctrl_os.h: APLL trims move the simulated I2S clock */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t periph_rtc_apll_freq_set(uint32_t expt_freq, uint32_t *real_freq);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,6 @@
+/* Host port of driver/gpio.h: pin numbers only */
+#pragma once
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_NC (-1)
@@ -0,0 +1,7 @@
+/* Host port of esp_attr.h: placement attributes are no-ops */
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
+#define RTC_DATA_ATTR
@@ -0,0 +1,13 @@
+/* Host port of esp_cpu.h: the "cycle" count is the host's nanosecond clock
+ * (only the PEQ load meter reads it) */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+uint32_t esp_cpu_get_cycle_count(void);
+#ifdef __cplusplus
+}
+#endif
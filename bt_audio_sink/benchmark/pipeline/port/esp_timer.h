@@ -0,0 +1,12 @@
+/* Host port of esp_timer.h: the simulator's virtual clock */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+int64_t esp_timer_get_time(void);
+#ifdef __cplusplus
+}
+#endif
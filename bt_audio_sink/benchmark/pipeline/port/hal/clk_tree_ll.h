@@ -0,0 +1,5 @@
+/* Host port of hal/clk_tree_ll.h: the ESP32 APLL range */
+#pragma once
+
+#define CLK_LL_APLL_MIN_HZ (5000000)
+#define CLK_LL_APLL_MAX_HZ (125000000)
@@ -0,0 +1,693 @@
+/*
+ * Host port of the services the audio pipeline runs on, as a single-threaded
+ * discrete-event simulation (see sim.h).
+ *
+ * Time only moves while the audio task waits: a wait fires the events due
+ * before its deadline (DMA buffer ends, packet arrivals) in time order and
+ * returns as soon as what it waits for has happened. Processing itself takes
+ * no simulated time, so a run is as fast as the host and reproducible: the
+ * output depends on the input and the options only.
+ *
+ * The heap is two pools sized like a WROVER module after BT is up; the
+ * pipeline's placement logic sees their real fill, and every allocation is
+ * counted, including operator new.
+ */
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <new>
+
+#include "clk_ctrl_os.h"
+#include "driver/i2s_std.h"
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "hal/clk_tree_ll.h"
+#include "sim.h"
+
+namespace {
+
+constexpr double NS_PER_TICK = 1e9 / configTICK_RATE_HZ;
+constexpr double NEVER = INFINITY;
+constexpr int MAX_CHANNELS = 4;
+constexpr int MAX_PORTS = 2;
+
+double g_nowNs = 0;
+int g_logLevel = ESP_LOG_WARN;
+
+/* Source */
+
+sim::SourceFn g_source = nullptr;
+void* g_sourceCtx = nullptr;
+double g_sourceNs = NEVER;
+
+/* The audio task */
+
+struct Task {
+    uint32_t notify;
+} g_task;
+
+struct Semaphore {
+    int count;
+    int max;
+};
+
+/* Heap */
+
+enum Pool : uint32_t { POOL_INTERNAL, POOL_PSRAM };
+
+struct alignas(16) Block {
+    size_t size;
+    uint32_t pool;
+};
+
+size_t g_poolSize[2] = {128 * 1024, 4096 * 1024};
+size_t g_poolUsed[2];
+uint32_t g_allocs;
+uint64_t g_allocBytes;
+
+}  // namespace
+
+/* I2S */
+
+struct i2s_channel_obj_t {
+    int port;
+    uint32_t descNum;
+    uint32_t frameNum;
+    uint32_t bufBytes;
+    uint32_t slotBytes;
+    bool autoClear;
+    bool ready;                 // In std mode
+    bool enabled;
+    bool started;               // Written to since enable
+    uint32_t rateHz;
+    bool apll;
+    i2s_event_callbacks_t cbs;
+    void* ctx;
+
+    uint8_t* dma;               // descNum buffers
+    uint32_t* fill;             // Bytes written to each since it was sent
+    uint32_t* queue;            // Sent buffers, oldest first (descNum - 1)
+    uint32_t qHead;
+    uint32_t qCount;
+    int32_t curr;               // Buffer being written, -1 = none
+    uint32_t rwPos;
+
+    uint32_t playing;           // Buffer being sent
+    double endNs;               // ... and when it is done
+};
+
+namespace {
+
+using Channel = i2s_channel_obj_t;
+
+Channel* g_channels[MAX_CHANNELS];
+
+struct PortState {
+    bool used;
+    sim::I2SStats stats;
+} g_ports[MAX_PORTS];
+
+bool g_watchUnderruns = false;
+uint32_t g_apllHz = 0;
+
+// APLL frequency the driver picks for a rate (mclk = 256 fs, multiplied up
+// past the APLL minimum)
+uint32_t apllNominal(uint32_t rate) {
+    uint32_t mclk = rate * 256;
+    uint32_t div = CLK_LL_APLL_MIN_HZ / mclk + 1;
+    if (div < 2) div = 2;
+    return mclk * div;
+}
+
+double effectiveRate(const Channel& ch) {
+    if (!ch.apll || g_apllHz == 0) return ch.rateHz;
+    return (double)ch.rateHz * g_apllHz / apllNominal(ch.rateHz);
+}
+
+double bufferNs(const Channel& ch) {
+    return ch.frameNum * 1e9 / effectiveRate(ch);
+}
+
+PortState& portOf(const Channel& ch) {
+    return g_ports[ch.port >= 0 && ch.port < MAX_PORTS ? ch.port : 0];
+}
+
+uint32_t queueCap(const Channel& ch) {
+    return ch.descNum - 1;
+}
+
+void queuePush(Channel& ch, uint32_t buf) {
+    ch.queue[(ch.qHead + ch.qCount) % queueCap(ch)] = buf;
+    ch.qCount++;
+}
+
+bool queuePop(Channel& ch, uint32_t& buf) {
+    if (ch.qCount == 0) return false;
+    buf = ch.queue[ch.qHead];
+    ch.qHead = (ch.qHead + 1) % queueCap(ch);
+    ch.qCount--;
+    return true;
+}
+
+// The DMA restarts from the first descriptor; the queue and the write
+// position are left as disable/preload set them
+void dmaStart(Channel& ch) {
+    ch.started = false;
+    ch.playing = 0;
+    ch.endNs = g_nowNs + bufferNs(ch);
+}
+
+// Buffer `playing` has been sent: as i2s_tx_default_isr, on_sent first,
+// then the oldest queued buffer is dropped if the queue is full, then the
+// sent one is queued for writers. The next buffer starts.
+void dmaBufferDone(Channel& ch) {
+    PortState& ps = portOf(ch);
+    const uint32_t done = ch.playing;
+    i2s_event_data_t ev = {ch.dma + (size_t)done * ch.bufBytes, ch.bufBytes};
+
+    ps.stats.sent++;
+    if (ch.cbs.on_sent) ch.cbs.on_sent(&ch, &ev, ch.ctx);
+    if (ch.qCount == queueCap(ch)) {
+        ch.qHead = (ch.qHead + 1) % queueCap(ch);
+        ch.qCount--;
+        ps.stats.overflows++;
+        if (ch.cbs.on_send_q_ovf) ch.cbs.on_send_q_ovf(&ch, &ev, ch.ctx);
+    }
+    if (ch.autoClear) memset(ev.data, 0, ch.bufBytes);
+    ch.fill[done] = 0;
+    queuePush(ch, done);
+
+    ch.playing = (done + 1) % ch.descNum;
+    if (g_watchUnderruns && ch.started && ch.fill[ch.playing] < ch.bufBytes) ps.stats.underruns++;
+    ch.endNs += bufferNs(ch);
+}
+
+/* Event loop */
+
+double nextEventNs() {
+    double t = g_sourceNs;
+    for (Channel* ch : g_channels) {
+        if (ch && ch->enabled && ch->endNs < t) t = ch->endNs;
+    }
+    return t;
+}
+
+// Fire the earliest event (and anything due at the same time)
+void fireNext() {
+    const double t = nextEventNs();
+    if (t == NEVER) return;
+    if (t > g_nowNs) g_nowNs = t;
+    for (Channel* ch : g_channels) {
+        while (ch && ch->enabled && ch->endNs <= g_nowNs) dmaBufferDone(*ch);
+    }
+    if (g_sourceNs <= g_nowNs) {
+        g_sourceNs = NEVER;
+        const int64_t next = g_source(g_sourceCtx);
+        if (next >= 0) g_sourceNs = (double)next * 1000.0;
+    }
+}
+
+// Block the audio task until ready() or the timeout; true if ready
+template <typename F>
+bool waitUntil(F ready, TickType_t ticks) {
+    if (ready()) return true;
+    if (ticks == 0) return false;
+    const double deadline = ticks == portMAX_DELAY ? NEVER : g_nowNs + ticks * NS_PER_TICK;
+    while (true) {
+        const double t = nextEventNs();
+        if (t > deadline) {
+            if (deadline == NEVER) {
+                fprintf(stderr, "sim: audio task blocked forever at %.3f ms\n", g_nowNs / 1e6);
+                return false;
+            }
+            g_nowNs = deadline;
+            return ready();
+        }
+        fireNext();
+        if (ready()) return true;
+    }
+}
+
+uint64_t hostNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+}  // namespace
+
+/* Simulator interface */
+
+namespace sim {
+
+void setSource(SourceFn fn, void* ctx, int64_t firstUs) {
+    g_source = fn;
+    g_sourceCtx = ctx;
+    g_sourceNs = (fn && firstUs >= 0) ? (double)firstUs * 1000.0 : NEVER;
+}
+
+bool sourceDone() { return g_sourceNs == NEVER; }
+
+int64_t nowUs() { return (int64_t)(g_nowNs / 1000.0); }
+
+void advanceTo(int64_t us) {
+    const double target = (double)us * 1000.0;
+    while (nextEventNs() <= target) fireNext();
+    if (target > g_nowNs) g_nowNs = target;
+}
+
+bool i2sStats(int port, I2SStats& out) {
+    if (port < 0 || port >= MAX_PORTS || !g_ports[port].used) return false;
+    out = g_ports[port].stats;
+    return true;
+}
+
+void i2sResetLowBits() {
+    for (PortState& ps : g_ports) ps.stats.lowBits = 0;
+}
+
+void watchUnderruns(bool on) { g_watchUnderruns = on; }
+
+void heapConfigure(size_t internalBytes, size_t psramBytes) {
+    g_poolSize[POOL_INTERNAL] = internalBytes;
+    g_poolSize[POOL_PSRAM] = psramBytes;
+}
+
+void heapResetCounters() {
+    g_allocs = 0;
+    g_allocBytes = 0;
+}
+
+HeapStats heapStats() {
+    return {g_allocs, g_allocBytes, g_poolUsed[POOL_INTERNAL], g_poolUsed[POOL_PSRAM]};
+}
+
+void setLogLevel(int level) { g_logLevel = level; }
+
+uint32_t crc32(uint32_t crc, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+}  // namespace sim
+
+/* esp_timer, esp_cpu, esp_log, esp_err */
+
+int64_t esp_timer_get_time(void) {
+    return sim::nowUs();
+}
+
+uint32_t esp_cpu_get_cycle_count(void) {
+    return (uint32_t)hostNs();
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
+    (void)tag;
+    if ((int)level > g_logLevel) return;
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+}
+
+uint32_t esp_log_timestamp(void) {
+    return (uint32_t)(g_nowNs / 1e6);
+}
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                return "ESP_OK";
+        case ESP_FAIL:              return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+        default:                    return "ERROR";
+    }
+}
+
+/* esp_heap_caps */
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    g_allocs++;
+    g_allocBytes += size;
+    // Default-caps requests go to internal RAM first, like malloc() with
+    // SPIRAM_USE_MALLOC
+    uint32_t pool = (caps & MALLOC_CAP_SPIRAM) ? POOL_PSRAM : POOL_INTERNAL;
+    if (g_poolUsed[pool] + size > g_poolSize[pool]) {
+        const bool anyPool = !(caps & (MALLOC_CAP_SPIRAM | MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA));
+        if (!anyPool || pool != POOL_INTERNAL) return nullptr;
+        pool = POOL_PSRAM;
+        if (g_poolUsed[pool] + size > g_poolSize[pool]) return nullptr;
+    }
+    Block* b = (Block*)malloc(sizeof(Block) + size);
+    if (!b) return nullptr;
+    b->size = size;
+    b->pool = pool;
+    g_poolUsed[pool] += size;
+    return b + 1;
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    void* p = heap_caps_malloc(n * size, caps);
+    if (p) memset(p, 0, n * size);
+    return p;
+}
+
+void heap_caps_free(void* ptr) {
+    if (!ptr) return;
+    Block* b = (Block*)ptr - 1;
+    g_poolUsed[b->pool] -= b->size;
+    free(b);
+}
+
+void* heap_caps_realloc(void* ptr, size_t size, uint32_t caps) {
+    void* p = heap_caps_malloc(size, caps);
+    if (p && ptr) {
+        const size_t old = ((Block*)ptr - 1)->size;
+        memcpy(p, ptr, old < size ? old : size);
+        heap_caps_free(ptr);
+    }
+    return p;
+}
+
+static uint32_t poolOf(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? POOL_PSRAM : POOL_INTERNAL;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    const uint32_t pool = poolOf(caps);
+    return g_poolSize[pool] - g_poolUsed[pool];
+}
+
+// No fragmentation model: the largest block is everything free
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+size_t heap_caps_get_total_size(uint32_t caps) {
+    return g_poolSize[poolOf(caps)];
+}
+
+void* operator new(size_t size) {
+    void* p = heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    heap_caps_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    heap_caps_free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    heap_caps_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    heap_caps_free(ptr);
+}
+
+/* FreeRTOS */
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return &g_task;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    waitUntil([] { return g_task.notify > 0; }, ticksToWait);
+    const uint32_t value = g_task.notify;
+    if (value) g_task.notify = clearOnExit ? 0 : value - 1;
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    ((Task*)task)->notify++;
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {
+    xTaskNotifyGive(task);
+    if (woken) *woken = pdTRUE;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    waitUntil([] { return false; }, ticks);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(g_nowNs / NS_PER_TICK);
+}
+
+static SemaphoreHandle_t semaphoreCreate(int count, int max) {
+    Semaphore* s = (Semaphore*)heap_caps_malloc(sizeof(Semaphore), MALLOC_CAP_INTERNAL);
+    if (s) *s = {count, max};
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return semaphoreCreate(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return semaphoreCreate(0, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait) {
+    Semaphore* s = (Semaphore*)sem;
+    if (!waitUntil([s] { return s->count > 0; }, ticksToWait)) return pdFALSE;
+    s->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    Semaphore* s = (Semaphore*)sem;
+    if (s->count >= s->max) return pdFALSE;
+    s->count++;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* woken) {
+    const BaseType_t ok = xSemaphoreGive(sem);
+    if (woken) *woken = ok;
+    return ok;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    heap_caps_free(sem);
+}
+
+/* APLL */
+
+esp_err_t periph_rtc_apll_freq_set(uint32_t expt_freq, uint32_t* real_freq) {
+    if (expt_freq < CLK_LL_APLL_MIN_HZ || expt_freq > CLK_LL_APLL_MAX_HZ) return ESP_ERR_INVALID_ARG;
+    g_apllHz = expt_freq;
+    if (real_freq) *real_freq = expt_freq;
+    for (PortState& ps : g_ports) {
+        if (ps.used && ps.stats.rateHz) {
+            ps.stats.trimPpm = (float)(((double)g_apllHz / apllNominal(ps.stats.rateHz) - 1.0) * 1e6);
+        }
+    }
+    return ESP_OK;
+}
+
+/* I2S std driver */
+
+static void setClock(Channel& ch, const i2s_std_clk_config_t& clk) {
+    ch.rateHz = clk.sample_rate_hz;
+    ch.apll = clk.clk_src == I2S_CLK_SRC_APLL;
+    // The driver programs the APLL to nominal for the new rate
+    if (ch.apll) g_apllHz = apllNominal(ch.rateHz);
+    PortState& ps = portOf(ch);
+    ps.stats.rateHz = ch.rateHz;
+    ps.stats.trimPpm = 0.0f;
+}
+
+esp_err_t i2s_new_channel(const i2s_chan_config_t* chan_cfg, i2s_chan_handle_t* ret_tx_handle,
+                          i2s_chan_handle_t* ret_rx_handle) {
+    if (!chan_cfg || !ret_tx_handle || ret_rx_handle) return ESP_ERR_NOT_SUPPORTED;
+    if (chan_cfg->dma_desc_num < 2 || chan_cfg->dma_frame_num == 0) return ESP_ERR_INVALID_ARG;
+    int slot = -1;
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        if (!g_channels[i]) {
+            slot = i;
+        } else if (g_channels[i]->port == chan_cfg->id) {
+            return ESP_ERR_NOT_FOUND;       // Port taken
+        }
+    }
+    if (slot < 0) return ESP_ERR_NOT_FOUND;
+
+    Channel* ch = (Channel*)heap_caps_calloc(1, sizeof(Channel), MALLOC_CAP_INTERNAL);
+    if (!ch) return ESP_ERR_NO_MEM;
+    ch->port = chan_cfg->id;
+    ch->descNum = chan_cfg->dma_desc_num;
+    ch->frameNum = chan_cfg->dma_frame_num;
+    ch->autoClear = chan_cfg->auto_clear;
+    ch->curr = -1;
+    g_channels[slot] = ch;
+    *ret_tx_handle = ch;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_init_std_mode(i2s_chan_handle_t handle, const i2s_std_config_t* std_cfg) {
+    Channel& ch = *handle;
+    if (ch.ready || std_cfg->slot_cfg.slot_mode != I2S_SLOT_MODE_STEREO) return ESP_ERR_INVALID_STATE;
+    // The driver allocates the chain here, in DMA-capable internal RAM
+    const uint32_t bytesPerFrame = 2 * (std_cfg->slot_cfg.data_bit_width / 8);
+    ch.bufBytes = ch.frameNum * bytesPerFrame;
+    ch.slotBytes = bytesPerFrame / 2;
+    ch.dma = (uint8_t*)heap_caps_calloc(ch.descNum, ch.bufBytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    ch.fill = (uint32_t*)heap_caps_calloc(ch.descNum, sizeof(uint32_t), MALLOC_CAP_INTERNAL);
+    ch.queue = (uint32_t*)heap_caps_calloc(ch.descNum - 1, sizeof(uint32_t), MALLOC_CAP_INTERNAL);
+    if (!ch.dma || !ch.fill || !ch.queue) return ESP_ERR_NO_MEM;
+    setClock(ch, std_cfg->clk_cfg);
+    portOf(ch).used = true;
+    ch.ready = true;
+    return ESP_OK;
+}
+
+esp_err_t i2s_del_channel(i2s_chan_handle_t handle) {
+    if (!handle || handle->enabled) return ESP_ERR_INVALID_STATE;
+    for (Channel*& ch : g_channels) {
+        if (ch == handle) ch = nullptr;
+    }
+    heap_caps_free(handle->dma);
+    heap_caps_free(handle->fill);
+    heap_caps_free(handle->queue);
+    heap_caps_free(handle);
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_reconfig_std_clock(i2s_chan_handle_t handle, const i2s_std_clk_config_t* clk_cfg) {
+    if (!handle->ready || handle->enabled) return ESP_ERR_INVALID_STATE;
+    setClock(*handle, *clk_cfg);
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle) {
+    if (!handle->ready || handle->enabled) return ESP_ERR_INVALID_STATE;
+    dmaStart(*handle);
+    handle->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle) {
+    if (!handle->enabled) return ESP_ERR_INVALID_STATE;
+    handle->enabled = false;
+    handle->curr = -1;
+    handle->rwPos = 0;
+    handle->qHead = 0;
+    handle->qCount = 0;
+    return ESP_OK;
+}
+
+// As the driver: the first call queues every buffer but the first and
+// starts writing there; less than size is loaded once all are full
+esp_err_t i2s_channel_preload_data(i2s_chan_handle_t tx_handle, const void* src, size_t size,
+                                   size_t* bytes_loaded) {
+    Channel& ch = *tx_handle;
+    if (!ch.ready || ch.enabled) return ESP_ERR_INVALID_STATE;
+    if (ch.curr < 0) {
+        ch.qHead = 0;
+        ch.qCount = 0;
+        for (uint32_t i = 1; i < ch.descNum; i++) queuePush(ch, i);
+        ch.curr = 0;
+        ch.rwPos = 0;
+        ch.fill[0] = 0;
+    }
+    const uint8_t* p = (const uint8_t*)src;
+    size_t loaded = 0;
+    while (size > 0) {
+        if (ch.rwPos == ch.bufBytes) {
+            uint32_t next;
+            if (!queuePop(ch, next)) break;
+            ch.curr = (int32_t)next;
+            ch.rwPos = 0;
+            ch.fill[next] = 0;
+        }
+        size_t n = ch.bufBytes - ch.rwPos;
+        if (n > size) n = size;
+        memcpy(ch.dma + (size_t)ch.curr * ch.bufBytes + ch.rwPos, p, n);
+        ch.fill[ch.curr] += (uint32_t)n;
+        ch.rwPos += (uint32_t)n;
+        p += n;
+        size -= n;
+        loaded += n;
+    }
+    *bytes_loaded = loaded;
+    return ESP_OK;
+}
+
+// As the driver: a new buffer is taken when the current one is full, or
+// when the queue is nearly full (the current one is about to be sent again)
+esp_err_t i2s_channel_write(i2s_chan_handle_t handle, const void* src, size_t size, size_t* bytes_written,
+                            uint32_t timeout_ms) {
+    Channel& ch = *handle;
+    *bytes_written = 0;
+    if (!ch.enabled) return ESP_ERR_INVALID_STATE;
+    PortState& ps = portOf(ch);
+    const uint8_t* p = (const uint8_t*)src;
+    const uint32_t nearlyFull = ch.descNum > 2 ? 1 : 0;
+    while (size > 0) {
+        if (ch.curr < 0 || ch.rwPos == ch.bufBytes || queueCap(ch) - ch.qCount <= nearlyFull) {
+            if (!waitUntil([&ch] { return ch.qCount > 0; }, pdMS_TO_TICKS(timeout_ms))) {
+                return ESP_ERR_TIMEOUT;
+            }
+            uint32_t next;
+            queuePop(ch, next);
+            ch.curr = (int32_t)next;
+            ch.rwPos = 0;
+        }
+        size_t n = ch.bufBytes - ch.rwPos;
+        if (n > size) n = size;
+        memcpy(ch.dma + (size_t)ch.curr * ch.bufBytes + ch.rwPos, p, n);
+        ch.fill[ch.curr] += (uint32_t)n;
+        ch.rwPos += (uint32_t)n;
+        ps.stats.crc = sim::crc32(ps.stats.crc, p, n);
+        if (g_watchUnderruns && ch.slotBytes == 4) {
+            for (size_t i = 0; i + 4 <= n; i += 4) {
+                uint32_t w;
+                memcpy(&w, p + i, sizeof(w));
+                ps.stats.lowBits |= w & 0xFFFFu;
+            }
+        }
+        ps.stats.bytes += n;
+        ch.started = true;
+        p += n;
+        size -= n;
+        *bytes_written += n;
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_register_event_callback(i2s_chan_handle_t handle, const i2s_event_callbacks_t* callbacks,
+                                              void* user_data) {
+    if (handle->enabled) return ESP_ERR_INVALID_STATE;
+    handle->cbs = *callbacks;
+    handle->ctx = user_data;
+    return ESP_OK;
+}
@@ -0,0 +1,90 @@
+/* Host build of the pipeline simulator: the Kconfig defaults of the audio
+ * path (main/Kconfig.projbuild). Options can be switched per target with
+ * -DCONFIG_...=1; the values below are the menuconfig defaults. */
+#pragma once
+
+#define CONFIG_IDF_TARGET_ESP32 1
+#define CONFIG_FREERTOS_HZ 1000
+#define CONFIG_SPIRAM 1
+
+/* I2S */
+#define CONFIG_I2S_BCK_PIN 27
+#define CONFIG_I2S_LRCK_PIN 25
+#define CONFIG_I2S_DATA_PIN 26
+#define CONFIG_I2S_DEFAULT_SAMPLE_RATE 44100
+#define CONFIG_I2S_USE_APLL 1
+#define CONFIG_I2S_OUT_SLOTS 2
+#define CONFIG_I2S_FIXED_RATE_HZ 48000
+#define CONFIG_AUX_SLOT_LEFT 1
+#define CONFIG_AUX_SLOT_RIGHT 1
+#define CONFIG_SUB_CROSSOVER_FREQ 80
+#define CONFIG_AUX_I2S_BCK_PIN 14
+#define CONFIG_AUX_I2S_LRCK_PIN 32
+#define CONFIG_AUX_I2S_DATA_PIN 13
+
+/* GPIO */
+#define CONFIG_BUTTON1_GPIO 18
+#define CONFIG_BUTTON2_GPIO 21
+#define CONFIG_BEAT_LED_GPIO 5
+
+/* DSP */
+#define CONFIG_DSP_GOERTZEL_N 512
+#define CONFIG_DSP_ANALYSIS_DECIMATE 1
+#define CONFIG_DSP_SPECTRUM 1
+#define CONFIG_DSP_SPECTRUM_BANDS 16
+#define CONFIG_DSP_CROSSOVER_LP_FREQ 90
+#define CONFIG_DSP_CROSSOVER_HP_FREQ 500
+#define CONFIG_DSP_OUT_FRAMES 1024
+#define CONFIG_DSP_VOLUME_RAMP_MS 20
+#define CONFIG_DSP_LIMITER 1
+#define CONFIG_DSP_LIMITER_LOOKAHEAD_US 1500
+#define CONFIG_DSP_LIMITER_RELEASE_MS 60
+#define CONFIG_DSP_DYNAMICS 1
+#define CONFIG_DSP_DYNAMICS_DEFAULT 0
+#define CONFIG_DSP_PEQ 1
+#define CONFIG_DSP_PEQ_BANDS 10
+#define CONFIG_DSP_PEQ_CYCLE_BUDGET 400
+#define CONFIG_DSP_SILENCE_GATE 1
+#define CONFIG_DSP_SILENCE_HOLD_MS 500
+#define CONFIG_DSP_FIR_PARTITION 128
+#define CONFIG_DSP_FIR_MAX_TAPS 4096
+#define CONFIG_DSP_BINAURAL 1
+#define CONFIG_DSP_BINAURAL_ANGLE 30
+#define CONFIG_DSP_GRAPH 1
+
+/* Beat detection and levels */
+#define CONFIG_BEAT_BASS_AVG_ALPHA 10
+#define CONFIG_BEAT_BASS_SMOOTH_ALPHA 350
+#define CONFIG_BEAT_BASS_MIN_LEVEL 120
+#define CONFIG_BEAT_RATIO_THRESH 16
+#define CONFIG_BEAT_MIN_INTERVAL_MS 90
+#define CONFIG_BEAT_FLASH_DURATION_MS 60
+#define CONFIG_LEVELS_UPDATE_MS 50
+#define CONFIG_LED_FPS 30
+
+/* Memory */
+#define CONFIG_PSRAM_MODE 1
+#define CONFIG_AUDIO_POOL_COUNT 48
+#define CONFIG_AUDIO_POOL_BUF_SIZE 8192
+#define CONFIG_AUDIO_FAST_RING_KB 40
+#define CONFIG_AUDIO_DECODE_IN_PLACE 1
+#define CONFIG_AUDIO_FAST_RING_RESERVE_KB 48
+
+/* Audio task and diagnostics */
+#define CONFIG_BT_A2DP_SINK_TASK_CORE 0
+#define CONFIG_AUDIO_TX_CORE 1
+#define CONFIG_AUDIO_LOAD_REPORT_INTERVAL_S 10
+
+/* Jitter buffer and drift */
+#define CONFIG_JITTER_BUFFER_ENABLE 1
+#define CONFIG_JITTER_TARGET_SBC_MS 100
+#define CONFIG_JITTER_TARGET_AAC_MS 120
+#define CONFIG_JITTER_TARGET_APTX_MS 80
+#define CONFIG_JITTER_TARGET_APTX_LL_MS 40
+#define CONFIG_JITTER_TARGET_APTX_HD_MS 100
+#define CONFIG_JITTER_TARGET_LDAC_MS 150
+#define CONFIG_JITTER_TARGET_OPUS_MS 60
+#define CONFIG_JITTER_TARGET_LC3PLUS_MS 60
+#define CONFIG_DRIFT_COMP_ENABLE 1
+#define CONFIG_CODEC_BRIDGE 1
+#define CONFIG_CODEC_BRIDGE_MS 300
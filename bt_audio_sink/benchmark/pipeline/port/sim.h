@@ -0,0 +1,71 @@
+/*
+ * Simulator side of the pipeline host port: the virtual clock the FreeRTOS,
+ * esp_timer and I2S shims run on, and the counters the harness reports.
+ *
+ * Everything runs on one host thread. The audio task is the caller; when it
+ * blocks (task notification, semaphore, blocking I2S write) the clock jumps
+ * to the next event instead of sleeping. Events are the ends of simulated
+ * DMA buffers (on_sent) and packet arrivals from the source, which calls
+ * AudioPipeline::enqueue() as the decoder would, from inside the wait.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace sim {
+
+// Packet source: called when a packet is due; returns when the next one is
+// (us), or a negative value once the input is exhausted
+typedef int64_t (*SourceFn)(void* ctx);
+
+void setSource(SourceFn fn, void* ctx, int64_t firstUs);
+bool sourceDone();
+
+int64_t nowUs();
+
+// Fire everything due up to `us` and leave the clock there
+void advanceTo(int64_t us);
+
+struct I2SStats {
+    uint64_t bytes;         // Accepted by i2s_channel_write
+    uint32_t crc;           // CRC32 of those bytes, in order
+    uint32_t sent;          // DMA buffers sent (on_sent events)
+    uint32_t underruns;     // Buffers sent not fully refilled, while watched
+    uint32_t overflows;     // Free-queue drops (on_send_q_ovf)
+    uint32_t lowBits;       // 32-bit slots: OR of every sample's low 16 bits, while
+                            // watched and since i2sResetLowBits()
+    uint32_t rateHz;        // Nominal clock of the last channel
+    float trimPpm;          // APLL trim in effect
+};
+
+// Per I2S port, accumulated over channel re-creation. False if the port
+// never had a channel.
+bool i2sStats(int port, I2SStats& out);
+
+// Start I2SStats::lowBits over on every port
+void i2sResetLowBits();
+
+// Count underruns from now on (the harness turns this on at the first
+// output and off once the source is exhausted, so prebuffer and tail
+// silence are not counted)
+void watchUnderruns(bool on);
+
+struct HeapStats {
+    uint32_t allocs;        // heap_caps_* and operator new calls
+    uint64_t bytes;
+    size_t internalUsed;    // Live bytes per pool
+    size_t psramUsed;
+};
+
+// Pool sizes as seen at startup (free internal RAM once BT is up, PSRAM)
+void heapConfigure(size_t internalBytes, size_t psramBytes);
+void heapResetCounters();
+HeapStats heapStats();
+
+// esp_log verbosity (ESP_LOG_*)
+void setLogLevel(int level);
+
+uint32_t crc32(uint32_t crc, const void* data, size_t len);
+
+}  // namespace sim
@@ -0,0 +1,4 @@
+/* Host port of soc_caps.h: an ESP32, so I2S can be clocked from the APLL */
+#pragma once
+
+#define SOC_CLK_APLL_SUPPORTED 1
@@ -51,22 +51,73 @@ class A2DPVolumeControl {
   }
 
   virtual void update_audio_data(Frame* data, uint16_t frameCount) {
-    if (data != nullptr && frameCount > 0 && (mono_downmix || is_volume_used)) {
-      ESP_LOGD("VolumeControl", "update_audio_data");
-      for (int i = 0; i < frameCount; i++) {
+    update_audio_data(data, (uint32_t)frameCount, false);
+  }
+
+  /// Channel swap, mono downmix and volume in one pass over int16 stereo
+  /// frames; this is what BluetoothA2DPSink calls. Each frame is handled
+  /// as one 32 bit word, two per iteration, with a shift instead of a
+  /// division and saturation to int16. Returns without touching the data
+  /// when there is nothing to do (unity gain, no swap, no downmix).
+  /// Classes overriding update_audio_data(Frame*, uint16_t) should
+  /// override this as well.
+  virtual void update_audio_data(Frame* data, uint32_t frameCount,
+                                 bool swapChannels) {
+    const bool scale = is_volume_used && volumeFactor != volumeFactorMax;
+    if (data == nullptr || frameCount == 0) return;
+    if (!scale && !mono_downmix) {
+      if (swapChannels) swap_channels(data, frameCount);
+      return;
+    }
+    ESP_LOGD("VolumeControl", "update_audio_data");
+    const int32_t factor = scale ? volumeFactor : volumeFactorMax;
+    if ((volumeFactorMax & (volumeFactorMax - 1)) != 0 || !is_word_aligned(data)) {
+      // factor max not a power of two or unaligned buffer: per sample
+      for (uint32_t i = 0; i < frameCount; i++) {
         int32_t pcmLeft = data[i].channel1;
         int32_t pcmRight = data[i].channel2;
-        // if mono -> we provide the same output on both channels
         if (mono_downmix) {
           pcmRight = pcmLeft = (pcmLeft + pcmRight) / 2;
         }
-        // adjust the volume
+        pcmLeft = clip(pcmLeft * factor / volumeFactorMax);
+        pcmRight = clip(pcmRight * factor / volumeFactorMax);
+        data[i].channel1 = swapChannels ? pcmRight : pcmLeft;
+        data[i].channel2 = swapChannels ? pcmLeft : pcmRight;
+      }
+      return;
+    }
+    const int shift = __builtin_ctz((uint32_t)volumeFactorMax);
+    const bool mono = mono_downmix;
+    void* raw = data;  // alignment checked
+    uint32_t* words = (uint32_t*)raw;
+    uint32_t i = 0;
+    for (; i + 2 <= frameCount; i += 2) {
+      words[i] = scale_word(words[i], factor, shift, mono, swapChannels);
+      words[i + 1] = scale_word(words[i + 1], factor, shift, mono, swapChannels);
+    }
+    if (i < frameCount) {
+      words[i] = scale_word(words[i], factor, shift, mono, swapChannels);
+    }
+  }
+
+  /// Same as update_audio_data() for streams decoded to 32 bit containers
+  /// (aptX, LDAC, LC3plus); frameCount counts stereo int32 pairs
+  virtual void update_audio_data32(int32_t* data, uint32_t frameCount) {
+    if (data != nullptr && frameCount > 0 && (mono_downmix || is_volume_used)) {
+      ESP_LOGD("VolumeControl", "update_audio_data32");
+      for (uint32_t i = 0; i < frameCount; i++) {
+        int64_t pcmLeft = data[2 * i];
+        int64_t pcmRight = data[2 * i + 1];
+        if (mono_downmix) {
+          pcmRight = pcmLeft = (pcmLeft + pcmRight) / 2;
+        }
+        // volumeFactor never exceeds volumeFactorMax, so no clipping needed
         if (is_volume_used) {
-          pcmLeft = clip(pcmLeft * volumeFactor / volumeFactorMax);
-          pcmRight = clip(pcmRight * volumeFactor / volumeFactorMax);
+          pcmLeft = pcmLeft * volumeFactor / volumeFactorMax;
+          pcmRight = pcmRight * volumeFactor / volumeFactorMax;
         }
-        data[i].channel1 = pcmLeft;
-        data[i].channel2 = pcmRight;
+        data[2 * i] = (int32_t)pcmLeft;
+        data[2 * i + 1] = (int32_t)pcmRight;
       }
     }
   }
@@ -95,6 +146,46 @@ class A2DPVolumeControl {
     if (value > 32767) result = 32767;
     return result;
   }
+
+  /// Left and right exchanged: each frame word rotated by 16 bits
+  static void swap_channels(Frame* data, uint32_t frameCount) {
+    if (!is_word_aligned(data)) {
+      for (uint32_t i = 0; i < frameCount; i++) {
+        int16_t temp = data[i].channel1;
+        data[i].channel1 = data[i].channel2;
+        data[i].channel2 = temp;
+      }
+      return;
+    }
+    void* raw = data;  // alignment checked
+    uint32_t* words = (uint32_t*)raw;
+    for (uint32_t i = 0; i < frameCount; i++) {
+      words[i] = (words[i] >> 16) | (words[i] << 16);
+    }
+  }
+
+  static bool is_word_aligned(const void* ptr) {
+    return ((uintptr_t)ptr & 3) == 0;
+  }
+
+  /// One frame word (channel1 in the low half): downmix, scale by
+  /// factor >> shift with saturation, swap
+  inline uint32_t scale_word(uint32_t word, int32_t factor, int shift,
+                             bool mono, bool swap) {
+    int32_t left = (int16_t)(word & 0xffff);
+    int32_t right = (int16_t)(word >> 16);
+    if (mono) {
+      left = right = (left + right) >> 1;
+    }
+    left = clip((left * factor) >> shift);
+    right = clip((right * factor) >> shift);
+    if (swap) {
+      int32_t temp = left;
+      left = right;
+      right = temp;
+    }
+    return (uint32_t)(uint16_t)left | ((uint32_t)(uint16_t)right << 16);
+  }
 };
 
 /**
@@ -156,5 +247,10 @@ class A2DPLinearVolumeControl : public A2DPVolumeControl {
 class A2DPNoVolumeControl : public A2DPVolumeControl {
  public:
   void update_audio_data(Frame* data, uint16_t frameCount) override {}
+  void update_audio_data(Frame* data, uint32_t frameCount,
+                         bool swapChannels) override {
+    if (data != nullptr && swapChannels) swap_channels(data, frameCount);
+  }
+  void update_audio_data32(int32_t* data, uint32_t frameCount) override {}
   void set_volume(uint8_t volume) override {}
 };
\ No newline at end of file
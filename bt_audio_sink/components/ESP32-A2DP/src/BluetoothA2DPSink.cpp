@@ -84,6 +84,13 @@ void BluetoothA2DPSink::set_stream_reader(void (*callBack)(const uint8_t *,
   this->is_output = is_i2s;
 }
 
+void BluetoothA2DPSink::set_stream_reader_fmt(
+    void (*callBack)(const uint8_t *, uint32_t, uint8_t, uint8_t, uint32_t),
+    bool is_i2s) {
+  this->stream_reader_fmt = callBack;
+  this->is_output = is_i2s;
+}
+
 void BluetoothA2DPSink::set_raw_stream_reader(void (*callBack)(const uint8_t *,
                                                                uint32_t)) {
   this->raw_stream_reader = callBack;
@@ -140,9 +147,6 @@ void BluetoothA2DPSink::start(const char *name) {
     get_last_connection();
 
     memcpy(peer_bd_addr, last_connection, ESP_BD_ADDR_LEN);
-
-    // trigger timeout
-    delay_ms(reconnect_delay);
   }
 
   // setup i2s
@@ -360,6 +364,18 @@ void BluetoothA2DPSink::app_gap_callback(esp_bt_gap_cb_event_t event,
     } break;
 #endif
 
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    case ESP_BT_GAP_ACL_CONN_CMPL_STAT_EVT: {
+      ESP_LOGI(BT_AV_TAG, "ESP_BT_GAP_ACL_CONN_CMPL_STAT_EVT stat:%d %s",
+               param->acl_conn_cmpl_stat.stat,
+               to_str(param->acl_conn_cmpl_stat.bda));
+      if (param->acl_conn_cmpl_stat.stat == ESP_BT_STATUS_SUCCESS &&
+          acl_connected_callback != nullptr) {
+        acl_connected_callback(param->acl_conn_cmpl_stat.bda);
+      }
+    } break;
+#endif
+
     default: {
       ESP_LOGI(BT_AV_TAG, "event: %d", event);
       break;
@@ -495,6 +511,9 @@ void BluetoothA2DPSink::handle_audio_cfg(uint16_t event, void *p_param) {
   uint8_t ch;
 
   get_codec_config(a2d, &sr, &bps, &ch);
+  codec_id = ::get_codec_id(a2d);
+  stream_bits = bps == 0 ? 16 : bps;
+  stream_channels = ch == 0 ? 2 : ch;
 
   if (codec_config_callback != nullptr) {
     codec_config_callback(sr, bps, ch);
@@ -552,6 +571,16 @@ void BluetoothA2DPSink::set_i2s_active(bool active) {
   }
 }
 
+void BluetoothA2DPSink::reconnect_timer_cb(void *arg) {
+  BluetoothA2DPSink *self = static_cast<BluetoothA2DPSink *>(arg);
+  if (self->get_connection_state() != ESP_A2D_CONNECTION_STATE_DISCONNECTED) {
+    ESP_LOGI(BT_AV_TAG, "peer connected first - no reconnect");
+    return;
+  }
+  ESP_LOGD(BT_AV_TAG, "reconnect");
+  self->reconnect();
+}
+
 void BluetoothA2DPSink::handle_connection_state(uint16_t event, void *p_param) {
   ESP_LOGD(BT_AV_TAG, "%s evt %d", __func__, event);
   esp_a2d_cb_param_t *a2d = (esp_a2d_cb_param_t *)(p_param);
@@ -683,8 +712,10 @@ void BluetoothA2DPSink::av_new_track() {
   ESP_LOGD(BT_AV_TAG, "%s", __func__);
   // Register notifications and request metadata
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
-  esp_avrc_ct_send_metadata_cmd(APP_RC_CT_TL_GET_META_DATA,
-                                avrc_metadata_flags);
+  if (avrc_metadata_auto) {
+    esp_avrc_ct_send_metadata_cmd(APP_RC_CT_TL_GET_META_DATA,
+                                  avrc_metadata_flags);
+  }
   if (esp_avrc_rn_evt_bit_mask_operation(ESP_AVRC_BIT_MASK_OP_TEST,
                                          &s_avrc_peer_rn_cap,
                                          ESP_AVRC_RN_TRACK_CHANGE)) {
@@ -694,6 +725,13 @@ void BluetoothA2DPSink::av_new_track() {
 #endif
 }
 
+void BluetoothA2DPSink::request_avrc_metadata() {
+  ESP_LOGD(BT_AV_TAG, "%s", __func__);
+  if (!avrc_connection_state) return;
+  esp_avrc_ct_send_metadata_cmd(APP_RC_CT_TL_GET_META_DATA,
+                                avrc_metadata_flags);
+}
+
 void BluetoothA2DPSink::av_playback_changed() {
   ESP_LOGD(BT_AV_TAG, "%s", __func__);
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
@@ -910,9 +948,25 @@ void BluetoothA2DPSink::av_hdl_stack_evt(uint16_t event, void *p_param) {
 
       // start automatic reconnect if relevant and stack is up
       if (reconnect_status == AutoReconnect && has_last_connection()) {
-        ESP_LOGD(BT_AV_TAG, "reconnect");
         memcpy(peer_bd_addr, last_connection, ESP_BD_ADDR_LEN);
-        reconnect();
+        if (reconnect_delay > 0) {
+          // connectable meanwhile: a peer connecting by itself comes first
+          ESP_LOGD(BT_AV_TAG, "reconnect in %d ms", reconnect_delay);
+          const esp_timer_create_args_t args = {
+              .callback = reconnect_timer_cb, .arg = this, .name = "a2dp_reconn"};
+          if (reconnect_timer == nullptr &&
+              esp_timer_create(&args, &reconnect_timer) != ESP_OK) {
+            reconnect_timer = nullptr;
+          }
+          if (reconnect_timer == nullptr ||
+              esp_timer_start_once(reconnect_timer,
+                                   (uint64_t)reconnect_delay * 1000) != ESP_OK) {
+            reconnect();
+          }
+        } else {
+          ESP_LOGD(BT_AV_TAG, "reconnect");
+          reconnect();
+        }
       }
 
       /* set discoverable and connectable mode, wait to be connected */
@@ -967,31 +1021,59 @@ void BluetoothA2DPSink::app_a2d_callback(esp_a2d_cb_event_t event,
 }
 
 void BluetoothA2DPSink::audio_data_callback(const uint8_t *data, uint32_t len) {
-
-  // swap left and right channels
-  if (swap_left_right) {
-    Frame *frame = (Frame *)data;
-    for (int i = 0; i < len / 4; i++) {
-      int16_t temp = frame[i].channel1;
-      frame[i].channel1 = frame[i].channel2;
-      frame[i].channel2 = temp;
+  // Decoders with more than 16 bits (aptX, LDAC, LC3plus) deliver int32
+  // containers; the Frame based helpers below only understand int16 stereo.
+  // The format is the last one handle_audio_cfg() stored, read once so the
+  // whole packet is handled with the same one.
+  const uint8_t bits = stream_bits;
+  const uint8_t channels = stream_channels;
+  const bool wide = bits > 16;
+  const uint32_t frame_bytes = (wide ? 4 : 2) * channels;
+  const uint32_t frames = len / frame_bytes;
+
+  // swap left and right channels; int16 stereo without a raw reader is
+  // swapped in the volume pass below
+  const bool swap = swap_left_right && channels == 2;
+  const bool fused = !wide && raw_stream_reader == nullptr;
+  if (swap && !fused) {
+    if (wide) {
+      int32_t *pcm = (int32_t *)data;
+      for (uint32_t i = 0; i < frames; i++) {
+        int32_t temp = pcm[2 * i];
+        pcm[2 * i] = pcm[2 * i + 1];
+        pcm[2 * i + 1] = temp;
+      }
+    } else {
+      Frame *frame = (Frame *)data;
+      for (uint32_t i = 0; i < frames; i++) {
+        int16_t temp = frame[i].channel1;
+        frame[i].channel1 = frame[i].channel2;
+        frame[i].channel2 = temp;
+      }
     }
   }
 
   // make data available via callback, before volume control
   if (raw_stream_reader != nullptr) {
-    ESP_LOGD(BT_AV_TAG, "raw_stream_reader");
     (*raw_stream_reader)(data, len);
   }
 
   // adjust the volume
-  volume_control()->update_audio_data((Frame *)data, len / 4);
+  if (wide) {
+    volume_control()->update_audio_data32((int32_t *)data, len / 8);
+  } else {
+    volume_control()->update_audio_data((Frame *)data, len / 4,
+                                        swap && fused);
+  }
 
   // make data available via callback
   if (stream_reader != nullptr) {
-    ESP_LOGD(BT_AV_TAG, "stream_reader");
     (*stream_reader)(data, len);
   }
+  if (stream_reader_fmt != nullptr) {
+    (*stream_reader_fmt)(data, frames * frame_bytes, bits, channels,
+                         frames);
+  }
 
   // put data into ringbuffer
   if (is_output) {
@@ -1000,7 +1082,6 @@ void BluetoothA2DPSink::audio_data_callback(const uint8_t *data, uint32_t len) {
 
   // data_received callback
   if (data_received != nullptr) {
-    ESP_LOGD(BT_AV_TAG, "data_received");
     (*data_received)();
   }
 }
@@ -17,6 +17,7 @@
 #include "BluetoothA2DPCommon.h"
 #include "BluetoothA2DPOutput.h"
 #include "freertos/ringbuf.h"
+#include "codec_config/codec_config.h"
 
 // Comment out next line to deactivate warnings
 #ifndef A2DP_I2S_AUDIOTOOLS
@@ -162,6 +163,8 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
 
   /// Determine the actual audio type
   virtual esp_a2d_mct_t get_audio_type();
+  /// Codec of the current stream, including the vendor codec (LDAC, aptX...)
+  virtual a2dp_codec_id_t get_codec_id() { return codec_id; }
 
   /// Define a callback method which provides connection state of AVRC service
   virtual void set_avrc_connection_state_callback(void (*callback)(bool)) {
@@ -214,6 +217,18 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   virtual void set_stream_reader(void (*callBack)(const uint8_t *, uint32_t),
                                  bool i2s_output = true);
 
+  /// Like set_stream_reader(), but also passes the bits per sample and the
+  /// channel count of the last configured codec, and the number of whole
+  /// frames in the packet. Streams with more than 16 bits arrive in 32 bit
+  /// containers, so frames is len / (4 * channels) for them and
+  /// len / (2 * channels) otherwise.
+  virtual void set_stream_reader_fmt(void (*callBack)(const uint8_t *data,
+                                                      uint32_t len,
+                                                      uint8_t bits,
+                                                      uint8_t channels,
+                                                      uint32_t frames),
+                                     bool i2s_output = true);
+
   /// Define a callback that is called before the volume changes: this callback
   /// provides access to the data
   virtual void set_raw_stream_reader(void (*callBack)(const uint8_t *,
@@ -222,6 +237,12 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   /// Define callback which is called when we receive data
   virtual void set_on_data_received(void (*callBack)());
 
+  /// Called (BT task) when any device completes an ACL link to us, also
+  /// while another one is connected: a bonded phone asking to stream
+  virtual void set_on_acl_connected(void (*callBack)(esp_bd_addr_t bda)) {
+    acl_connected_callback = callBack;
+  }
+
   /// Allows you to reject unauthorized addresses
   virtual void set_address_validator(
       bool (*callBack)(esp_bd_addr_t remote_bda)) {
@@ -295,6 +316,16 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
     avrc_metadata_flags = flags;
   }
 
+  /// Metadata is requested on every track change by default; with false it
+  /// is sent only on request_avrc_metadata()
+  virtual void set_avrc_metadata_auto(bool active) {
+    avrc_metadata_auto = active;
+  }
+
+  /// requests the metadata (set_avrc_metadata_attribute_mask) of the current
+  /// track
+  virtual void request_avrc_metadata();
+
   /// swaps the left and right channel
   virtual void set_swap_lr_channels(bool swap) { swap_left_right = swap; }
 
@@ -329,8 +360,9 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
     rssi_callbak = callback;
   }
 
-  /// Defines the delay that is added to delay the startup when we automatically
-  /// reconnect
+  /// Defines how long after the stack is up we wait before automatically
+  /// reconnecting, so a peer that connects by itself gets in first. The sink
+  /// is connectable during the wait.
   void set_reconnect_delay(int delay) { reconnect_delay = delay; }
 
   /// Activates SSP (Serial protocol)
@@ -374,6 +406,11 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   uint32_t m_pkt_cnt = 0;
   // esp_a2d_audio_state_t m_audio_state = ESP_A2D_AUDIO_STATE_STOPPED;
   esp_a2d_mct_t audio_type;
+  a2dp_codec_id_t codec_id = A2DP_CODEC_ID_UNKNOWN;
+  // Last configured format of the decoded PCM (handle_audio_cfg()), used
+  // by audio_data_callback()
+  uint8_t stream_bits = 16;
+  uint8_t stream_channels = 2;
   char pin_code_str[20] = {0};
   int connection_rety_count = 0;
   bool spp_active = false;
@@ -389,12 +426,16 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
       ESP_AVRC_MD_ATTR_TITLE | ESP_AVRC_MD_ATTR_ARTIST |
       ESP_AVRC_MD_ATTR_ALBUM | ESP_AVRC_MD_ATTR_TRACK_NUM |
       ESP_AVRC_MD_ATTR_NUM_TRACKS | ESP_AVRC_MD_ATTR_GENRE;
+  bool avrc_metadata_auto = true;
   void (*bt_volumechange)(int) = nullptr;
   void (*bt_dis_connected)() = nullptr;
   void (*bt_connected)() = nullptr;
   void (*data_received)() = nullptr;
+  void (*acl_connected_callback)(esp_bd_addr_t bda) = nullptr;
   void (*stream_reader)(const uint8_t *, uint32_t) = nullptr;
   void (*raw_stream_reader)(const uint8_t *, uint32_t) = nullptr;
+  void (*stream_reader_fmt)(const uint8_t *, uint32_t, uint8_t, uint8_t,
+                            uint32_t) = nullptr;
   void (*avrc_connection_state_callback)(bool connected) = nullptr;
   void (*avrc_metadata_callback)(uint8_t, const uint8_t *) = nullptr;
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
@@ -416,6 +457,7 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   void (*rssi_callbak)(esp_bt_gap_cb_param_t::read_rssi_delta_param &rssi) =
       nullptr;
   int reconnect_delay = 1000;
+  esp_timer_handle_t reconnect_timer = nullptr;
   int max_write_size = A2DP_I2S_MAX_WRITE_SIZE;
   int max_write_delay_ms = A2DP_I2S_MAX_WRITE_DELAY_MS;
 
@@ -430,6 +472,7 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   void app_a2d_callback(esp_a2d_cb_event_t event,
                         esp_a2d_cb_param_t *param) override;
   void av_hdl_stack_evt(uint16_t event, void *p_param) override;
+  static void reconnect_timer_cb(void *arg);
 
   virtual int init_bluetooth();
   virtual bool app_work_dispatch(app_callback_t p_cback, uint16_t event,
@@ -8,7 +8,8 @@ void BluetoothA2DPSinkQueued::bt_i2s_task_start_up(void) {
         ESP_LOGE(BT_APP_TAG, "%s, Semaphore create failed", __func__);
         return;
     }
-    if ((s_ringbuf_i2s = xRingbufferCreate(i2s_ringbuffer_size, RINGBUF_TYPE_BYTEBUF)) == nullptr) {
+    ringbuffer_fill = 0;
+    if ((s_ringbuf_i2s = xRingbufferCreate(i2s_ringbuffer_size, RINGBUF_TYPE_NOSPLIT)) == nullptr) {
         ESP_LOGE(BT_APP_TAG, "%s, ringbuffer create failed", __func__);
         return;
     }
@@ -52,26 +53,25 @@ void BluetoothA2DPSinkQueued::i2s_task_handler(void *arg) {
         if (pdTRUE != xSemaphoreTake(s_i2s_write_semaphore, portMAX_DELAY)){
             continue;
         }
+        // start steering from the target: prefetching just reached it
+        ringbuffer_fill_avg = i2s_ringbuffer_target_size();
 
         while (true) {
             // xSemaphoreTake was succeeding here, so we have the buffer filled up
             item_size = 0;
 
-            // receive data from ringbuffer and write it to I2S DMA transmit buffer
-            data = (uint8_t *)xRingbufferReceiveUpTo(s_ringbuf_i2s, &item_size, (TickType_t)pdMS_TO_TICKS(i2s_ticks), i2s_write_size_upto);
-            if (item_size == 0) {
-                ESP_LOGI(BT_APP_TAG, "ringbuffer underflowed! mode changed: RINGBUFFER_MODE_PREFETCHING");
+            // one packet, read in place
+            data = (uint8_t *)xRingbufferReceive(s_ringbuf_i2s, &item_size, (TickType_t)pdMS_TO_TICKS(i2s_ticks));
+            if (data == nullptr) {
                 ringbuffer_mode = RINGBUFFER_MODE_PREFETCHING;
+                ringbuffer_event(RINGBUFFER_EVENT_UNDERFLOW);
                 break;
             }
+            ringbuffer_fill -= (int32_t)item_size;
 
             // if i2s is not active we just consume the buffer w/o output
             if (is_i2s_active && is_output){
-                size_t written = i2s_write_data(data, item_size);
-                ESP_LOGD(BT_AV_TAG, "i2s_task_handler: %d->%d", item_size, written);
-                if (written==0){
-                    ESP_LOGE(BT_APP_TAG, "i2s_write_data failed %d->%d", item_size, written);
-                }
+                write_item(data, item_size);
             }
 
             vRingbufferReturnItem(s_ringbuf_i2s, (void *)data);
@@ -79,52 +79,65 @@ void BluetoothA2DPSinkQueued::i2s_task_handler(void *arg) {
     }
 }
 
+void BluetoothA2DPSinkQueued::write_item(const uint8_t *data, size_t size) {
+    // smoothed fill level w/o this packet; one frame per packet moves it
+    int32_t fill = ringbuffer_fill;
+    ringbuffer_fill_avg += (fill - ringbuffer_fill_avg) / RINGBUF_FILL_SMOOTHING;
+    int32_t target = i2s_ringbuffer_target_size();
+    int32_t deadband = RINGBUF_FILL_DEADBAND_MS * bytes_per_ms();
+    size_t frame = frame_bytes();
+
+    if (size >= 2 * frame && ringbuffer_fill_avg > target + deadband) {
+        // too much queued: drop the last frame
+        write_chunked(data, size - frame);
+        dropped_frames++;
+    } else if (size >= frame && ringbuffer_fill_avg < target - deadband) {
+        // too little queued: play the last frame twice
+        write_chunked(data, size);
+        write_chunked(data + (size / frame - 1) * frame, frame);
+        inserted_frames++;
+    } else {
+        write_chunked(data, size);
+    }
+}
+
+void BluetoothA2DPSinkQueued::write_chunked(const uint8_t *data, size_t size) {
+    while (size > 0) {
+        size_t len = size < i2s_write_size_upto ? size : i2s_write_size_upto;
+        size_t written = i2s_write_data(data, len);
+        if (written==0){
+            ringbuffer_event(RINGBUFFER_EVENT_WRITE_FAILED);
+            return;
+        }
+        data += written;
+        size -= written;
+    }
+}
+
 size_t BluetoothA2DPSinkQueued::write_audio(const uint8_t *data, size_t size)
 {
-    size_t item_size = 0;
-    BaseType_t done = pdFALSE;
-
     // esp-idf bluetooth stack can still call write callback when disconnected.
     if (!is_i2s_active || !s_ringbuf_i2s){
         return 0;
     }
 
-    if (ringbuffer_mode == RINGBUFFER_MODE_DROPPING) {
-        ESP_LOGW(BT_APP_TAG, "ringbuffer is full, drop this packet!");
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
-        vRingbufferGetInfo(s_ringbuf_i2s, nullptr, nullptr, nullptr, nullptr, &item_size);
-#else
-        vRingbufferGetInfo(s_ringbuf_i2s, nullptr, nullptr, nullptr, &item_size);
-#endif
-        if (item_size <= i2s_ringbuffer_prefetch_size()) {
-            ESP_LOGI(BT_APP_TAG, "ringbuffer data decreased! mode changed: RINGBUFFER_MODE_PROCESSING");
-            ringbuffer_mode = RINGBUFFER_MODE_PROCESSING;
-        }
+    // the fill controller keeps us off the limit: a full ringbuffer costs
+    // this packet only
+    if (!xRingbufferSend(s_ringbuf_i2s, (void *)data, size, (TickType_t)0)) {
+        overflow_count++;
+        ringbuffer_event(RINGBUFFER_EVENT_OVERFLOW);
         return 0;
     }
-
-    done = xRingbufferSend(s_ringbuf_i2s, (void *)data, size, (TickType_t)0);
-
-    if (!done) {
-        ESP_LOGW(BT_APP_TAG, "ringbuffer overflowed, ready to decrease data! mode changed: RINGBUFFER_MODE_DROPPING");
-        ringbuffer_mode = RINGBUFFER_MODE_DROPPING;
-    }
-
-    if (ringbuffer_mode == RINGBUFFER_MODE_PREFETCHING) {
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
-        vRingbufferGetInfo(s_ringbuf_i2s, nullptr, nullptr, nullptr, nullptr, &item_size);
-#else
-        vRingbufferGetInfo(s_ringbuf_i2s, nullptr, nullptr, nullptr, &item_size);
-#endif
-
-        if (item_size >= i2s_ringbuffer_prefetch_size()) {
-            ESP_LOGI(BT_APP_TAG, "ringbuffer data increased! mode changed: RINGBUFFER_MODE_PROCESSING");
-            ringbuffer_mode = RINGBUFFER_MODE_PROCESSING;
-            if (pdFALSE == xSemaphoreGive(s_i2s_write_semaphore)) {
-                ESP_LOGE(BT_APP_TAG, "semphore give failed");
-            }
+    ringbuffer_fill += (int32_t)size;
+
+    if (ringbuffer_mode == RINGBUFFER_MODE_PREFETCHING &&
+        ringbuffer_fill.load() >= i2s_ringbuffer_target_size()) {
+        ringbuffer_mode = RINGBUFFER_MODE_PROCESSING;
+        ringbuffer_event(RINGBUFFER_EVENT_PREFETCHED);
+        if (pdFALSE == xSemaphoreGive(s_i2s_write_semaphore)) {
+            ESP_LOGE(BT_APP_TAG, "semphore give failed");
         }
     }
 
-    return done ? size : 0;
+    return size;
 }
@@ -1,22 +1,39 @@
 #pragma once
 
+#include <atomic>
 #include "BluetoothA2DPSink.h"
 
 #define RINGBUF_HIGHEST_WATER_LEVEL (32 * 1024)
 #define RINGBUF_PREFETCH_PERCENT 65
+#define RINGBUF_FILL_DEADBAND_MS 4
+#define RINGBUF_FILL_SMOOTHING 8
 
 enum A2DPRingBufferMode : char {
   RINGBUFFER_MODE_PROCESSING,  /* ringbuffer is buffering incoming audio data,
                                   I2S is working */
   RINGBUFFER_MODE_PREFETCHING, /* ringbuffer is buffering incoming audio data,
                                   I2S is waiting */
-  RINGBUFFER_MODE_DROPPING /* ringbuffer is not buffering (dropping) incoming
-                              audio data, I2S is working */
+};
+
+/// Ringbuffer events reported to the callback instead of being logged from
+/// the BT and I2S tasks
+enum A2DPRingBufferEvent : char {
+  RINGBUFFER_EVENT_PREFETCHED,   /* target fill reached, I2S starts */
+  RINGBUFFER_EVENT_UNDERFLOW,    /* ran dry, prefetching again */
+  RINGBUFFER_EVENT_OVERFLOW,     /* full, packet dropped */
+  RINGBUFFER_EVENT_WRITE_FAILED, /* i2s_write_data wrote nothing */
 };
 
 /**
  * @brief The BluetoothA2DPSinkQueued is using a separate Task with an additinal
  * Queue to write the I2S data. application.
+ *
+ * Each packet is one item of a no-split ringbuffer and is written to I2S
+ * straight from the ringbuffer. While playing, the fill level (in time) is
+ * steered to its target one frame at a time: above the target the last
+ * frame of a packet is dropped, below it the last frame is repeated. Only a
+ * packet that does not fit at all is lost; prefetching happens only at the
+ * start and after an underflow.
  * @ingroup a2dp
  * @author Phil Schatzmann
  * @copyright Apache License Version 2
@@ -52,13 +69,37 @@ class BluetoothA2DPSinkQueued : public BluetoothA2DPSink {
   /// Defines the ringbuffer size used by the i2s task (in bytes)
   void set_i2s_ringbuffer_size(int size) { i2s_ringbuffer_size = size; }
 
-  /// Audio starts to play when limit exeeded
+  /// Audio starts to play when limit exeeded; also the fill level kept while
+  /// playing unless a target in ms is defined
   void set_i2s_ringbuffer_prefetch_percent(int percent) {
     if (percent < 0) return;
     if (percent > 100) return;
     ringbuffer_prefetch_percent = percent;
   }
 
+  /// Defines the fill level (in ms of audio) that is prefetched and then
+  /// kept while playing; 0 uses the prefetch percent
+  void set_i2s_ringbuffer_target_ms(int ms) {
+    if (ms < 0) return;
+    ringbuffer_target_ms = ms;
+  }
+
+  /// Frames dropped to bring the fill level down
+  uint32_t get_dropped_frames() { return dropped_frames; }
+
+  /// Frames repeated to bring the fill level up
+  uint32_t get_inserted_frames() { return inserted_frames; }
+
+  /// Packets lost because the ringbuffer was full
+  uint32_t get_overflow_count() { return overflow_count; }
+
+  /// Called on ringbuffer mode changes and losses, with the bytes queued,
+  /// from the BT or I2S task: it must not block or log
+  void set_ringbuffer_event_callback(void (*callback)(A2DPRingBufferEvent event,
+                                                      uint32_t fill_bytes)) {
+    ringbuffer_event_callback = callback;
+  }
+
   /// Defines the priority of the I2S task
   void set_i2s_task_priority(UBaseType_t prio) { i2s_task_priority = prio; }
 
@@ -78,11 +119,26 @@ class BluetoothA2DPSinkQueued : public BluetoothA2DPSink {
   size_t i2s_write_size_upto = 240 * 6;
   int i2s_ticks = 20;
   int ringbuffer_prefetch_percent = RINGBUF_PREFETCH_PERCENT;
+  int ringbuffer_target_ms = 0;
+  std::atomic<int32_t> ringbuffer_fill{0};  /* bytes queued, w/o item headers */
+  int32_t ringbuffer_fill_avg = 0;           /* smoothed, i2s task only */
+  volatile uint32_t dropped_frames = 0;
+  volatile uint32_t inserted_frames = 0;
+  volatile uint32_t overflow_count = 0;
+  void (*ringbuffer_event_callback)(A2DPRingBufferEvent event, uint32_t fill_bytes) = nullptr;
 
   void bt_i2s_task_start_up(void) override;
   void bt_i2s_task_shut_down(void) override;
   void i2s_task_handler(void *arg) override;
   size_t write_audio(const uint8_t *data, size_t size) override;
+  void write_item(const uint8_t *data, size_t size);
+  void write_chunked(const uint8_t *data, size_t size);
+
+  void ringbuffer_event(A2DPRingBufferEvent event) {
+    if (ringbuffer_event_callback != nullptr) {
+      ringbuffer_event_callback(event, (uint32_t)ringbuffer_fill.load());
+    }
+  }
 
   void set_i2s_active(bool active) override {
     BluetoothA2DPSink::set_i2s_active(active);
@@ -95,4 +151,19 @@ class BluetoothA2DPSinkQueued : public BluetoothA2DPSink {
     int bytes = i2s_ringbuffer_size * ringbuffer_prefetch_percent / 100;
     return (bytes / 4 * 4);
   }
+
+  int frame_bytes() { return (stream_bits > 16 ? 4 : 2) * stream_channels; }
+
+  int bytes_per_ms() {
+    int rate = sample_rate() > 0 ? sample_rate() : 44100;
+    return rate * frame_bytes() / 1000;
+  }
+
+  /// Fill level to prefetch and to keep, at most 3/4 of the ringbuffer
+  int i2s_ringbuffer_target_size() {
+    int bytes = ringbuffer_target_ms > 0 ? ringbuffer_target_ms * bytes_per_ms()
+                                         : i2s_ringbuffer_prefetch_size();
+    int limit = i2s_ringbuffer_size * 3 / 4;
+    return bytes < limit ? bytes : limit;
+  }
 };
@@ -15,6 +15,24 @@
 #include "a2dp_vendor_lc3plus_constants.h"
 #include "a2dp_aac_constants.h"
 
+/* A codec the application's profile excludes (CONFIG_CODEC_EXCLUDE_*) is
+ * not built into the stack even with its decoder option on */
+#if defined(CONFIG_BT_A2DP_AAC_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_AAC)
+#define CODEC_CONFIG_AAC 1
+#endif
+#if defined(CONFIG_BT_A2DP_APTX_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_APTX)
+#define CODEC_CONFIG_APTX 1
+#endif
+#if defined(CONFIG_BT_A2DP_LDAC_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_LDAC)
+#define CODEC_CONFIG_LDAC 1
+#endif
+#if defined(CONFIG_BT_A2DP_OPUS_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_OPUS)
+#define CODEC_CONFIG_OPUS 1
+#endif
+#if defined(CONFIG_BT_A2DP_LC3PLUS_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_LC3PLUS)
+#define CODEC_CONFIG_LC3PLUS 1
+#endif
+
 
 bool get_codec_config(esp_a2d_cb_param_t *a2d, uint32_t* sr, uint8_t* bps,
                       uint8_t* ch)
@@ -55,7 +73,7 @@ bool get_codec_config(esp_a2d_cb_param_t *a2d, uint32_t* sr, uint8_t* bps,
             channels = 2;
         }
     } else if (a2d->audio_cfg.mcc.type == ESP_A2D_MCT_M24) {
-#if defined(CONFIG_BT_A2DP_AAC_DECODER)
+#if defined(CODEC_CONFIG_AAC)
         ESP_LOGI(CODEC_CONFIG_TAG, "%s: configure AAC codec", __func__);
         ESP_LOGI(CODEC_CONFIG_TAG, "%s: configure audio player %x-%x-%x-%x-%x-%x-%x-%x",
                 __func__,
@@ -112,7 +130,7 @@ bool get_codec_config(esp_a2d_cb_param_t *a2d, uint32_t* sr, uint8_t* bps,
         ESP_LOGI(CODEC_CONFIG_TAG, "%s: AAC vbr support = %u", __func__, vbr);
 #else
         ESP_LOGE(CODEC_CONFIG_TAG, "%s: AAC sink unsupported", __func__);
-#endif /* CONFIG_BT_A2DP_AAC_DECODER */
+#endif /* CODEC_CONFIG_AAC */
 
     } else if (a2d->audio_cfg.mcc.type == ESP_A2D_MCT_NON_A2DP) {
         uint8_t *cie = (uint8_t*)&a2d->audio_cfg.mcc.cie;
@@ -134,7 +152,7 @@ bool get_codec_config(esp_a2d_cb_param_t *a2d, uint32_t* sr, uint8_t* bps,
             (vendor_id == A2DP_APTX_LL_VENDOR_ID &&
               codec_id == A2DP_APTX_LL_CODEC_ID_BLUETOOTH))
             {
-#if defined(CONFIG_BT_A2DP_APTX_DECODER)
+#if defined(CODEC_CONFIG_APTX)
             if (vendor_id == A2DP_APTX_VENDOR_ID &&
                 codec_id == A2DP_APTX_CODEC_ID_BLUETOOTH)
             {
@@ -165,11 +183,11 @@ bool get_codec_config(esp_a2d_cb_param_t *a2d, uint32_t* sr, uint8_t* bps,
             }
 #else
             ESP_LOGE(CODEC_CONFIG_TAG, "%s: aptX sink unsupported", __func__);
-#endif /* CONFIG_BT_A2DP_APTX_DECODER */
+#endif /* CODEC_CONFIG_APTX */
         } else if (vendor_id == A2DP_APTX_HD_VENDOR_ID &&
                    codec_id == A2DP_APTX_HD_CODEC_ID_BLUETOOTH)
         {
-#if defined(CONFIG_BT_A2DP_APTX_DECODER)
+#if defined(CODEC_CONFIG_APTX)
             ESP_LOGI(CODEC_CONFIG_TAG, "%s: configure aptX-HD codec", __func__);
             bits_per_sample = 24;
 
@@ -196,7 +214,7 @@ bool get_codec_config(esp_a2d_cb_param_t *a2d, uint32_t* sr, uint8_t* bps,
         } else if (vendor_id == A2DP_LDAC_VENDOR_ID &&
                    codec_id == A2DP_LDAC_CODEC_ID)
         {
-#if defined(CONFIG_BT_A2DP_LDAC_DECODER)
+#if defined(CODEC_CONFIG_LDAC)
             ESP_LOGI(CODEC_CONFIG_TAG, "%s: configure LDAC codec", __func__);
             bits_per_sample = 32;
 
@@ -227,21 +245,21 @@ bool get_codec_config(esp_a2d_cb_param_t *a2d, uint32_t* sr, uint8_t* bps,
             }
 #else
             ESP_LOGE(CODEC_CONFIG_TAG, "LDAC sink unsupported");
-#endif /* CONFIG_BT_A2DP_LDAC_DECODER */
+#endif /* CODEC_CONFIG_LDAC */
         } else if (vendor_id == A2DP_OPUS_VENDOR_ID &&
                    codec_id == A2DP_OPUS_CODEC_ID)
         {
-#if defined(CONFIG_BT_A2DP_OPUS_DECODER)
+#if defined(CODEC_CONFIG_OPUS)
             ESP_LOGI(CODEC_CONFIG_TAG, "%s: configure Opus codec", __func__);
             bits_per_sample = 16;
             sample_rate = 48000;
 #else
             ESP_LOGE(CODEC_CONFIG_TAG, "Opus sink unsupported");
-#endif /* CONFIG_BT_A2DP_OPUS_DECODER */
+#endif /* CODEC_CONFIG_OPUS */
         } else if (vendor_id == A2DP_LC3PLUS_VENDOR_ID &&
                    codec_id == A2DP_LC3PLUS_CODEC_ID)
         {
-#if defined(CONFIG_BT_A2DP_LC3PLUS_DECODER)
+#if defined(CODEC_CONFIG_LC3PLUS)
             ESP_LOGI(CODEC_CONFIG_TAG, "%s: configure LC3 Plus codec", __func__);
 
             bits_per_sample = 24;
@@ -266,7 +284,7 @@ bool get_codec_config(esp_a2d_cb_param_t *a2d, uint32_t* sr, uint8_t* bps,
             }
 #else
             ESP_LOGE(CODEC_CONFIG_TAG, "LC3 Plus sink unsupported");
-#endif /* CONFIG_BT_A2DP_LC3PLUS_DECODER */
+#endif /* CODEC_CONFIG_LC3PLUS */
         } else {
             ESP_LOGE(CODEC_CONFIG_TAG, "%s: Unsupported vendor_id 0x%lx, codec_id 0x%x",
                      __func__, vendor_id, codec_id);
@@ -292,3 +310,50 @@ bool get_codec_config(esp_a2d_cb_param_t *a2d, uint32_t* sr, uint8_t* bps,
 
     return true;
 }
+
+a2dp_codec_id_t get_codec_id(esp_a2d_cb_param_t *a2d)
+{
+    if (a2d->audio_cfg.mcc.type == ESP_A2D_MCT_SBC) {
+        return A2DP_CODEC_ID_SBC;
+    }
+    if (a2d->audio_cfg.mcc.type == ESP_A2D_MCT_M24) {
+        return A2DP_CODEC_ID_AAC;
+    }
+    if (a2d->audio_cfg.mcc.type != ESP_A2D_MCT_NON_A2DP) {
+        return A2DP_CODEC_ID_UNKNOWN;
+    }
+
+    uint8_t *cie = (uint8_t*)&a2d->audio_cfg.mcc.cie;
+    uint32_t vendor_id = *((uint32_t*) cie);
+    uint16_t codec_id = *((uint16_t*) (cie + sizeof(uint32_t)));
+
+    if (vendor_id == A2DP_APTX_VENDOR_ID && codec_id == A2DP_APTX_CODEC_ID_BLUETOOTH) {
+        return A2DP_CODEC_ID_APTX;
+    } else if (vendor_id == A2DP_APTX_LL_VENDOR_ID && codec_id == A2DP_APTX_LL_CODEC_ID_BLUETOOTH) {
+        return A2DP_CODEC_ID_APTX_LL;
+    } else if (vendor_id == A2DP_APTX_HD_VENDOR_ID && codec_id == A2DP_APTX_HD_CODEC_ID_BLUETOOTH) {
+        return A2DP_CODEC_ID_APTX_HD;
+    } else if (vendor_id == A2DP_LDAC_VENDOR_ID && codec_id == A2DP_LDAC_CODEC_ID) {
+        return A2DP_CODEC_ID_LDAC;
+    } else if (vendor_id == A2DP_OPUS_VENDOR_ID && codec_id == A2DP_OPUS_CODEC_ID) {
+        return A2DP_CODEC_ID_OPUS;
+    } else if (vendor_id == A2DP_LC3PLUS_VENDOR_ID && codec_id == A2DP_LC3PLUS_CODEC_ID) {
+        return A2DP_CODEC_ID_LC3PLUS;
+    }
+    return A2DP_CODEC_ID_UNKNOWN;
+}
+
+const char* get_codec_id_name(a2dp_codec_id_t id)
+{
+    switch (id) {
+        case A2DP_CODEC_ID_SBC:     return "SBC";
+        case A2DP_CODEC_ID_AAC:     return "AAC";
+        case A2DP_CODEC_ID_APTX:    return "aptX";
+        case A2DP_CODEC_ID_APTX_LL: return "aptX-LL";
+        case A2DP_CODEC_ID_APTX_HD: return "aptX-HD";
+        case A2DP_CODEC_ID_LDAC:    return "LDAC";
+        case A2DP_CODEC_ID_OPUS:    return "Opus";
+        case A2DP_CODEC_ID_LC3PLUS: return "LC3plus";
+        default:                    return "Unknown";
+    }
+}
@@ -15,9 +15,27 @@ extern "C"
 {
 #endif  /* __cplusplus */
 
+/// Codec negotiated for the stream, resolved from the media codec type and,
+/// for vendor codecs, the vendor/codec id pair
+typedef enum {
+    A2DP_CODEC_ID_UNKNOWN = 0,
+    A2DP_CODEC_ID_SBC,
+    A2DP_CODEC_ID_AAC,
+    A2DP_CODEC_ID_APTX,
+    A2DP_CODEC_ID_APTX_LL,
+    A2DP_CODEC_ID_APTX_HD,
+    A2DP_CODEC_ID_LDAC,
+    A2DP_CODEC_ID_OPUS,
+    A2DP_CODEC_ID_LC3PLUS,
+} a2dp_codec_id_t;
+
 bool get_codec_config(esp_a2d_cb_param_t *a2d, uint32_t* sr, uint8_t* bps,
                       uint8_t* ch);
 
+a2dp_codec_id_t get_codec_id(esp_a2d_cb_param_t *a2d);
+
+const char* get_codec_id_name(a2dp_codec_id_t id);
+
 #ifdef __cplusplus
 }   /* extern "C" */
 #endif /* __cplusplus */
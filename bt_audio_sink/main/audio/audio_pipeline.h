@@ -3,60 +3,226 @@
 /*
  * audio_pipeline.h
  *
- * Manages the audio buffer queue between Bluetooth decode and I2S output.
+ * Manages the audio buffer ring between Bluetooth decode and I2S output.
  * This decouples the two so we don't get stuttering when the decoder hiccups.
+ * The BT sink callback is the only producer and audio_tx the only consumer,
+ * so a lock-free SPSC ring (spsc_ring.h) carries the PCM.
  * 
  * Also handles overlay mixing: sound effects can be mixed with BT audio
  * through OverlayMixer integration (mixing happens in DSP processing loop).
+ *
+ * Latency is managed by JitterBuffer: output is held until the per-codec
+ * target depth is buffered, and blocks are stretched/shrunk by a few frames
+ * to keep it there instead of dropping buffers when the pool runs dry.
+ * Long-term clock drift between source and I2S is removed by DriftEstimator
+ * trimming the I2S APLL, so slips only absorb what the trim misses.
+ *
+ * A record can hold more frames than a DSP block (APP_AUDIO_POOL_BUF_SIZE
+ * against APP_DSP_OUT_FRAMES, or a whole in-place decode batch): the
+ * consumer takes it a block per pass, keeping its place in the record, and
+ * releases it after the last one, so a long record is delayed, never cut
+ * short. Frames in, out and dropped are counted (getFrameCounts()); the
+ * only drops left are records that found the ring full.
+ *
+ * Ring placement comes from a startup memory probe: the full-size ring goes
+ * to PSRAM when it is present, and if enough internal RAM is spare a second,
+ * smaller ring there carries low-bitrate streams. Either way the DSP reads
+ * its input straight from the ring record (no staging copy). With
+ * APP_AUDIO_DECODE_IN_PLACE the decoder writes there too: Bluedroid borrows
+ * the next record's space for each decode batch (lendPcmBuffer()) and
+ * enqueue() only publishes it, so nothing copies the PCM between the
+ * decoder and the DSP.
+ *
+ * With APP_AUDIO_PULL_DECODE the consumer decodes too: packets wait
+ * encoded in Bluedroid's queue and processBuffer() pulls just enough of
+ * them (PullSource) to hold one DSP block in the ring, so the PCM ring
+ * stays shallow and output timing drives decode timing. The queued packets
+ * count towards the jitter buffer's depth at the PCM they decode to, and a
+ * packet's arrival (onPacketQueued()) wakes the consumer. With
+ * APP_AUDIO_ENCODED_JITTER that packet queue (Bluedroid's RX slab in
+ * PSRAM, with each packet's RTP timestamp) is the jitter buffer: the PCM
+ * ring shrinks to a short window in internal RAM (APP_AUDIO_PCM_WINDOW_KB)
+ * and the target may grow to APP_AUDIO_ENCODED_MAX_MS, several times the
+ * buffered time per KB that PCM would give.
+ *
+ * Output goes through APP_I2S_OUT_SLOTS DSP blocks that are queued to the
+ * I2S DMA without blocking; the task only sleeps (until the DMA's on_sent
+ * event) once every slot is still pending, so DSP overlaps the DMA drain.
+ * Blocks are built in Q31; for a 16-bit port (APP_I2S_OUT_BITS) commitSlot()
+ * packs them to dithered S16 in place, so the DMA moves half the bytes.
+ * With APP_DSP_PASSTHROUGH a block the DSP would leave as it is (and every
+ * block with the DSP disabled) is converted straight into its slot: 16/24-bit
+ * PCM is only shifted into Q31, S16 comes back out of the packer undithered,
+ * and the DSP just gates silence and feeds the analyzer.
+ *
+ * With APP_AUDIO_LOAD_REPORT each stage's busy time is tracked (StageLoad)
+ * so the task layout can be checked against real streams. APP_AUDIO_PERF_TRACE
+ * adds cycle-count histograms (perf_trace.h) for enqueue, DSP and the time
+ * spent blocked on I2S; the decode point is fed from the Bluedroid hook.
+ * APP_AUDIO_LATENCY_PROBE carries each packet's arrival time through the ring
+ * to the output slot and has I2SOutput time when that frame leaves the DMA.
+ * Every block also tells the analyzer how long until it is heard, for the
+ * LED sync: that probe's commit-to-exit time when it runs, else the queued
+ * slots plus the DMA chain.
+ *
+ * With APP_PCM_CAPTURE each block is also copied, as read from the ring
+ * and as committed, into the PSRAM capture ring (pcm_capture.h); glitches
+ * and deadline misses are marked there and freeze it.
+ *
+ * With APP_I2S_FIXED_RATE the I2S clock never follows the stream: each block
+ * is converted to APP_I2S_FIXED_RATE_HZ by a PolyphaseResampler after the
+ * DSP (which still runs at the stream rate), so slots are sized for the
+ * largest upsampling ratio from 44.1 kHz.
+ *
+ * With APP_POWER_SAVE the audio task sleeps for APP_AUDIO_IDLE_WAIT_MS
+ * rather than 20 ms while nothing is queued, so the chip can light-sleep,
+ * and it parks I2S after APP_POWER_I2S_PARK_MS without output. A write,
+ * clear(), a new stream format or wake() (overlay sounds) ends the wait.
+ *
+ * Multi-room sync (sync_link.h) numbers input frames on both sides of the
+ * ring, so a frame keeps its index from enqueue() to the DAC. A master taps
+ * every record written and learns when each block is heard; a follower
+ * gives a target time per frame instead: output starts on it (padded with
+ * silence to the frame) and the jitter buffer steers by the timing error.
+ * While either is set the silence gate is off, so the DAC timeline never
+ * skips. For true-wireless stereo each unit keeps one channel of the
+ * stream (setChannelPick), copied to both outputs ahead of the DSP so the
+ * crossover still splits it across the unit's drivers. A relaying master
+ * taps the finished output blocks instead (setOutputTap: a view of the
+ * slot, no copy) and numbers its timing in output frames; the unit that
+ * plays them runs with setDspEnabled(false).
+ *
+ * Aux output (APP_AUX_OUTPUT, 2.1 / zone 2): every block is fanned out as
+ * it is committed, after slips, rate conversion, fades and overlays, so
+ * nothing later can shift one port against the other. OutputMatrix fills a
+ * parallel aux slot per the layout (setOutputLayout) and high-passes the
+ * mains when one of its slots is the sub; pumpOutput() hands both to
+ * I2SOutput and a slot is done once both channels took it.
+ *
+ * Source handoff: fadeOut() ramps the stream down over one block and keeps
+ * it silent until the next flush; the first block after every flush ramps
+ * in, so a phone switch or codec change never starts on a step.
+ *
+ * Stream start and end: output also ramps in whenever the jitter buffer's
+ * pre-roll opens the gate (stream start, after an underrun). endStream()
+ * (A2DP suspend) ramps the next queued block down and drops the rest,
+ * keeping what is already queued for the DMA; with nothing queued, and on
+ * an underrun, a short ramp from the last sample sent to zero follows it,
+ * so output never stops on a step into the DMA's silence.
+ *
+ * Codec switch (APP_CODEC_BRIDGE): bridgeStream() flushes like clear(), but
+ * the consumer first moves the PCM still queued to a StreamBridge and keeps
+ * the output slots. While the next stream pre-rolls, the bridge plays on,
+ * resampled to the rate output runs at by then and through the DSP; the
+ * new stream's first block crossfades from it, or if it runs out first the
+ * tail ramp follows. A reclock restarts the DMA on silence (the slots go
+ * with it), so the bridge ramps in after one. endStream() takes this path
+ * too while the stream is playing: a suspend plays its buffer out.
  */
 
 #include <stdint.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "../config/app_config.h"
+#include "../core/static_alloc.h"
+#include "../core/mem_placement.h"
+#include "../core/event_log.h"
 #include "../dsp/dsp_processor.h"
 #include "i2s_output.h"
 #include "overlay_mixer.h"
+#include "jitter_buffer.h"
+#include "drift_estimator.h"
+#include "spsc_ring.h"
+#include "memory_probe.h"
+#include "sample_format.h"
+#include "stage_load.h"
+#include "perf_trace.h"
+#include "latency_probe.h"
+#include "glitch_journal.h"
+#include "deadline_monitor.h"
+#include "pcm_capture.h"
+#if APP_I2S_FIXED_RATE
+#include "../dsp/polyphase_resampler.h"
+#endif
+#if APP_AUX_OUTPUT
+#include "../dsp/output_matrix.h"
+#endif
+#if APP_CODEC_BRIDGE
+#include "stream_bridge.h"
+#endif
 
-// Audio buffer structure
-struct AudioBuf {
-    uint32_t cap;
-    uint32_t len;
-    uint8_t bits;
-    uint8_t channels;
-    uint8_t reserved[2];
-    uint8_t data[APP_AUDIO_POOL_BUF_SIZE];
-};
+// Extra output frames so a jitter-buffer slip can stretch a full block
+#define APP_DSP_SLIP_HEADROOM   8
+
+// Output frames per DSP block: a full block, or with a fixed I2S rate a
+// full block upsampled from 44.1 kHz
+#if APP_I2S_FIXED_RATE
+#define APP_DSP_SLOT_FRAMES     ((APP_DSP_OUT_FRAMES * APP_I2S_FIXED_RATE_HZ + 44099) / 44100 + 1)
+#else
+#define APP_DSP_SLOT_FRAMES     APP_DSP_OUT_FRAMES
+#endif
 
-// Callback type for checking if I2S write should be skipped
-typedef bool (*ShouldSkipWriteCallback)();
+// int32 words per DSP output slot
+#define APP_DSP_SLOT_WORDS      ((APP_DSP_SLOT_FRAMES + APP_DSP_SLIP_HEADROOM) * 2)
+// Streams up to this byte rate may use the internal RAM ring (16-bit/48k stereo)
+#define APP_FAST_RING_MAX_BPS   (48000u * 4u)
+
+// Stages tracked for load reporting. ENQUEUE runs in the decoder task,
+// the rest in audio_tx; waits for input or a free slot are not counted.
+enum PipelineStage : uint8_t {
+    STAGE_ENQUEUE = 0,
+    STAGE_CONVERT,
+    STAGE_DSP,
+    STAGE_OUTPUT,
+    STAGE_COUNT
+};
 
 class AudioPipeline {
 public:
+    // Multi-room sync hooks (set before streaming starts). Frame indexes
+    // are input frames, wrapping at 32 bits.
+    typedef void (*InputTap)(void* ctx, const uint8_t* data, uint32_t len, SampleFmt fmt,
+                             uint8_t channels, uint32_t frameIndex);
+    typedef void (*BlockTap)(void* ctx, uint32_t frameIndex, int64_t exitUs);
+    typedef int64_t (*SyncTarget)(void* ctx, uint32_t frameIndex);
+    typedef void (*OutputTap)(void* ctx, const int32_t* stereo, uint32_t frames, uint32_t frameIndex,
+                              uint32_t sampleRate);
+    static constexpr int64_t SYNC_UNKNOWN = INT64_MIN;     // SyncTarget: no timing yet
+
     AudioPipeline() 
-        : m_audioQueue(nullptr)
-        , m_freeQueue(nullptr)
-        , m_pool(nullptr)
-        , m_dspOut(nullptr)
-        , m_stagingBuf(nullptr)
+        : m_dspOut(nullptr)
+        , m_outSlots(nullptr)
+        , m_slotHead(0)
+        , m_slotPending(0)
+        , m_floatBuf(nullptr)
         , m_dropCount(0)
         , m_enqueueFail(0)
         , m_shortWriteCount(0)
         , m_writeCount(0)
         , m_lastProcessMs(0)
-        , m_skipWriteCallback(nullptr)
-        , m_wasSkipping(false)
         , m_audioActive(false)
         , m_overlayMixer(nullptr)
+        , m_nextStampUs(0)
+        , m_nextRtpTs(0)
+        , m_probeStampUs(0)
+        , m_probeRtpTs(0)
+        , m_probeCommitUs(0)
+        , m_outputDelayUs(0)
     {
     }
 
     ~AudioPipeline() {
-        if (m_pool) heap_caps_free(m_pool);
-        if (m_dspOut) heap_caps_free(m_dspOut);
-        if (m_stagingBuf) heap_caps_free(m_stagingBuf);
+        if (m_outSlots && !StaticAlloc::owns(m_outSlots)) MemPlacement::release(m_outSlots);
+        if (m_floatBuf && !StaticAlloc::owns(m_floatBuf)) MemPlacement::release(m_floatBuf);
+#if APP_AUX_OUTPUT
+        if (m_auxSlots && !StaticAlloc::owns(m_auxSlots)) MemPlacement::release(m_auxSlots);
+#endif
+        m_fastRing.deinit();
+        m_bulkRing.deinit();
+        MemPlacement::release(m_fastHeap);
+        MemPlacement::release(m_bulkHeap);
     }
     
     // Set overlay mixer for sound effect mixing (call before init)
@@ -67,193 +233,672 @@ public:
     // Get overlay mixer (for SoundPlayer to push samples)
     OverlayMixer* getOverlayMixer() const { return m_overlayMixer; }
 
-    // Initialize queues and buffer pool
+    // Initialize PCM ring and work buffers
     bool init() {
-        m_audioQueue = xQueueCreate(APP_AUDIO_POOL_COUNT, sizeof(void*));
-        m_freeQueue = xQueueCreate(APP_AUDIO_POOL_COUNT, sizeof(void*));
-        
-        if (!m_audioQueue || !m_freeQueue) {
-            ESP_LOGE(TAG, "Failed to create audio queues");
-            return false;
-        }
+#if APP_AUDIO_ENCODED_JITTER
+        // The jitter buffer stays encoded; the ring is the short PCM window
+        // in front of the DSP, in internal RAM if it fits
+        size_t ringSize = (size_t)APP_AUDIO_PCM_WINDOW_KB * 1024;
+        const StaticAlloc::Region ringRegion = StaticAlloc::INTERNAL;
+        const MemRegion ringPlace = MEM_INTERNAL;
+#else
+        // Same memory budget as the old fixed-slot pool, but records are packed
+        size_t ringSize = (size_t)APP_AUDIO_POOL_COUNT * APP_AUDIO_POOL_BUF_SIZE;
+        const StaticAlloc::Region ringRegion = StaticAlloc::PSRAM;
+        const MemRegion ringPlace = MEM_PSRAM;
+#endif
+        ESP_LOGI(TAG, "Allocating audio ring: %u KB", (unsigned)(ringSize / 1024));
 
-        // Calculate required memory
-        size_t poolSize = sizeof(AudioBuf) * APP_AUDIO_POOL_COUNT;
-        ESP_LOGI(TAG, "Allocating audio pool: %d buffers x %d bytes = %u KB total",
-                 APP_AUDIO_POOL_COUNT, (int)sizeof(AudioBuf), (unsigned)(poolSize / 1024));
-        
-        // Log available memory
-        ESP_LOGI(TAG, "Free heap: internal=%u KB, PSRAM=%u KB",
-                 (unsigned)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) / 1024),
-                 (unsigned)(heap_caps_get_free_size(MALLOC_CAP_SPIRAM) / 1024));
-
-        // Try PSRAM first (if available), then fall back to internal
-        m_pool = (AudioBuf*)heap_caps_malloc(poolSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        if (m_pool) {
-            ESP_LOGI(TAG, "Audio pool allocated in PSRAM");
+        // Static build: the arena decides, PSRAM for the full ring when the build has one
+        uint8_t* ringMem = (uint8_t*)StaticAlloc::take("audio_ring", ringSize, ringRegion);
+        if (ringMem) {
+            m_bulkRing.init(ringMem, ringSize);
+            m_bulkInPsram = StaticAlloc::inPsram(ringMem);
         } else {
-            ESP_LOGW(TAG, "PSRAM alloc failed, trying internal heap");
-            m_pool = (AudioBuf*)heap_caps_malloc(poolSize, MALLOC_CAP_8BIT);
-            if (m_pool) {
-                ESP_LOGI(TAG, "Audio pool allocated in internal RAM");
+            // Decide placement from what the heap really has, not from the build flag
+            MemoryProbe probe = MemoryProbe::run();
+            probe.log(TAG);
+
+            // Full-size ring: PSRAM if there is any, else internal
+            m_bulkHeap = (uint8_t*)MemPlacement::alloc("audio_ring", MEM_OWNER_AUDIO, ringSize,
+                                                       ringPlace, MEM_PRIO_CRITICAL);
+            if (m_bulkRing.init(m_bulkHeap, ringSize)) {
+                m_bulkInPsram = !MemPlacement::isInternal(m_bulkHeap);
+                ESP_LOGI(TAG, "Audio ring allocated in %s", m_bulkInPsram ? "PSRAM" : "internal RAM");
             }
         }
-        if (!m_pool) {
-            ESP_LOGE(TAG, "Failed to allocate audio pool - try reducing CONFIG_AUDIO_POOL_COUNT or CONFIG_AUDIO_POOL_BUF_SIZE");
+        if (!m_bulkRing.isValid()) {
+            ESP_LOGE(TAG, "Failed to allocate audio ring - try reducing CONFIG_AUDIO_POOL_COUNT or CONFIG_AUDIO_POOL_BUF_SIZE");
             return false;
         }
+        m_ring.store(&m_bulkRing);
 
-        // Allocate DSP output buffer in DMA-capable internal RAM for fast I2S writes
-        // This reduces latency as DMA can access internal RAM without cache contention
-        size_t dspSize = sizeof(int32_t) * APP_DSP_OUT_FRAMES * 2;
-        m_dspOut = (int32_t*)heap_caps_malloc(dspSize, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
-        if (!m_dspOut) {
-            ESP_LOGW(TAG, "DMA-capable RAM dsp_out failed, trying internal 8BIT");
-            m_dspOut = (int32_t*)heap_caps_malloc(dspSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-        }
-        if (!m_dspOut) {
-            ESP_LOGW(TAG, "Internal RAM dsp_out failed, trying any available memory");
-            m_dspOut = (int32_t*)heap_caps_malloc(dspSize, MALLOC_CAP_8BIT);
+        // Allocate DSP output slots in internal RAM for fast I2S writes
+        // This reduces latency as the I2S driver copies without cache contention
+        size_t dspSize = sizeof(int32_t) * APP_DSP_SLOT_WORDS * APP_I2S_OUT_SLOTS;
+        m_outSlots = (int32_t*)StaticAlloc::take("dsp_out", dspSize, StaticAlloc::INTERNAL);
+        if (!m_outSlots) {
+            m_outSlots = (int32_t*)MemPlacement::alloc("dsp_out", MEM_OWNER_AUDIO, dspSize,
+                                                       MEM_DMA, MEM_PRIO_CRITICAL);
         }
-        if (!m_dspOut) {
+        if (!m_outSlots) {
             ESP_LOGE(TAG, "Failed to allocate DSP output buffer");
             return false;
         }
+        m_dspOut = m_outSlots;
 
-        // Allocate staging buffer in internal RAM for fast DSP processing
-        // This provides a low-latency copy point from PSRAM audio buffers
-        // LDAC at 96kHz needs fast access - PSRAM has ~100ns latency vs ~20ns internal
-        // Size: enough for one buffer's worth of audio data
-        size_t stagingSize = APP_AUDIO_POOL_BUF_SIZE;
-        m_stagingBuf = (uint8_t*)heap_caps_malloc(stagingSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-        if (!m_stagingBuf) {
-            ESP_LOGW(TAG, "Internal staging buffer failed, DSP will read from PSRAM directly (may cause jitter)");
-            // Not fatal - we can still work without it, just with slightly more jitter
-        } else {
-            ESP_LOGI(TAG, "Staging buffer allocated in internal RAM: %u bytes", (unsigned)stagingSize);
+#if APP_AUX_OUTPUT
+        // Aux slots next to them, same size and placement rules
+        m_auxSlots = (int32_t*)StaticAlloc::take("aux_out", dspSize, StaticAlloc::INTERNAL);
+        if (!m_auxSlots) {
+            m_auxSlots = (int32_t*)MemPlacement::alloc("aux_out", MEM_OWNER_AUDIO, dspSize,
+                                                       MEM_DMA, MEM_PRIO_CRITICAL);
+        }
+        if (!m_auxSlots) {
+            ESP_LOGE(TAG, "Failed to allocate aux output buffer");
+            return false;
         }
+#endif
 
-        // Initialize pool and push to free queue
-        for (int i = 0; i < APP_AUDIO_POOL_COUNT; i++) {
-            m_pool[i].cap = APP_AUDIO_POOL_BUF_SIZE;
-            m_pool[i].len = 0;
-            m_pool[i].bits = 16;
-            m_pool[i].channels = 2;
-            void *p = &m_pool[i];
-            xQueueSend(m_freeQueue, &p, 0);
+        // Float work buffer for block DSP - internal RAM, it is touched by every stage
+        size_t floatSize = sizeof(float) * APP_DSP_OUT_FRAMES * 2;
+        m_floatBuf = (float*)StaticAlloc::take("dsp_float", floatSize, StaticAlloc::INTERNAL);
+        if (!m_floatBuf) {
+            m_floatBuf = (float*)MemPlacement::alloc("dsp_float", MEM_OWNER_AUDIO, floatSize,
+                                                     MEM_INTERNAL, MEM_PRIO_CRITICAL);
+        }
+        if (!m_floatBuf) {
+            ESP_LOGE(TAG, "Failed to allocate DSP float buffer");
+            return false;
         }
 
-        ESP_LOGI(TAG, "Audio pipeline initialized: %d buffers @ %d bytes (total %u KB)", 
-                 APP_AUDIO_POOL_COUNT, APP_AUDIO_POOL_BUF_SIZE, (unsigned)(poolSize / 1024));
+#if APP_I2S_FIXED_RATE
+        // Coefficient table now; streams only rebuild it for a new cutoff
+        if (!m_resampler.init(APP_I2S_FIXED_RATE_HZ, APP_I2S_FIXED_RATE_HZ)) {
+            ESP_LOGE(TAG, "Failed to allocate resampler table");
+            return false;
+        }
+#endif
+#if APP_CODEC_BRIDGE
+        m_bridge.init();    // Optional: without it a switch flushes
+#endif
+
+        // Low-bitrate ring in internal RAM, sized from what is left now that
+        // the work buffers are in place. Pointless if the main ring is internal.
+        if (m_bulkInPsram && APP_AUDIO_FAST_RING_KB > 0 && !APP_AUDIO_ENCODED_JITTER && !allocFastRing()) {
+            ESP_LOGI(TAG, "No internal RAM to spare for a low-bitrate ring, using PSRAM for all codecs");
+        }
+
+        ESP_LOGI(TAG, "Audio pipeline initialized: ring %u KB, records up to %d bytes",
+                 (unsigned)(m_bulkRing.capacity() / 1024), APP_AUDIO_POOL_BUF_SIZE);
         return true;
     }
 
-    // Set callback to check if I2S writes should be skipped (e.g., during sound playback)
-    void setSkipWriteCallback(ShouldSkipWriteCallback cb) {
-        m_skipWriteCallback = cb;
+    // Configure the jitter buffer for a new stream format (call on codec config)
+    // and pick the ring it runs through
+    void setStreamFormat(uint32_t sampleRate, SampleFmt fmt, uint8_t channels, uint32_t targetMs) {
+        uint32_t bytesPerFrame = sampleFmtBytes(fmt) * (channels ? channels : 2u);
+        uint32_t rate = sampleRate ? sampleRate : 44100;
+
+        // Low-bitrate streams go through the internal ring if that still
+        // leaves the target plus headroom room to breathe. A high-bitrate
+        // codec gives the ring's RAM back to the budgets; the next
+        // low-bitrate one has the consumer place it again at the flush.
+        const bool lowRate = rate * bytesPerFrame <= APP_FAST_RING_MAX_BPS;
+        SpscRing* ring = &m_bulkRing;
+        if (lowRate && m_fastRing.isValid()) {
+            uint32_t fastMs = ringMs(m_fastRing, rate, bytesPerFrame);
+            if (fastMs >= targetMs + targetMs / 2) ring = &m_fastRing;
+        } else if (lowRate && fastRingPlaceable()) {
+            ring = &m_fastRing;
+        } else if (!lowRate && !APP_STATIC_ALLOCATION && m_fastRing.isValid()) {
+            m_fastParked.store(true);
+            m_fastRingOp.store(FAST_RING_RELEASE);
+        }
+        m_streamLowRate.store(lowRate);
+        m_streamBpf = bytesPerFrame;
+        m_streamTargetMs = targetMs;
+
+        // Until the consumer has placed the fast ring, the bulk ring's depth
+#if APP_AUDIO_ENCODED_JITTER
+        uint32_t maxMs = APP_AUDIO_ENCODED_MAX_MS;     // Bounded by the packet queue
+#else
+        uint32_t maxMs = ringMs(m_fastRing.isValid() ? *ring : m_bulkRing, rate, bytesPerFrame);
+#endif
+        m_jitter.configure(sampleRate, bytesPerFrame, targetMs, maxMs);
+        m_streamRate = rate;
+        m_drift.reset();
+#if APP_I2S_FIXED_RATE
+        m_pendingRate.store(rate);  // Resampler follows at the same flush
+#endif
+
+        // The consumer switches rings at its next flush
+        m_pendingRing.store(ring);
+        m_flushRequest.store(true);
+        wake();
+        ESP_LOGI(TAG, "Jitter buffer: %u Hz, target %u ms (max %u ms), %s ring",
+                 (unsigned)sampleRate, (unsigned)m_jitter.getTargetMs(), (unsigned)maxMs,
+                 (ring == &m_fastRing || !m_bulkInPsram) ? "internal" : "PSRAM");
+    }
+
+    // Arrival stamp of the packet about to be decoded (producer side, from
+    // the Bluedroid media hook). The oldest one wins until enqueue() uses it.
+    void stampNextWrite(uint32_t rtpTs, uint32_t arrivalUs) {
+        if (m_nextStampUs != 0) return;
+        m_nextStampUs = arrivalUs | 1u;     // 0 means "no stamp"
+        m_nextRtpTs = rtpTs;
+    }
+
+    // Memory pressure: give the low-bitrate ring's internal RAM back, moving
+    // the stream to the bulk ring, or take it again once memory recovered
+    // (used from the next stream format on). Run by the consumer; safe from
+    // any task.
+    // (a static build's ring is not heap, so there is nothing to give back)
+    void releaseFastRing() {
+        if (APP_STATIC_ALLOCATION) return;
+        m_fastHeld.store(true);
+        m_fastRingOp.store(FAST_RING_RELEASE);
+    }
+    void restoreFastRing() {
+        m_fastHeld.store(false);
+        m_fastRingOp.store(FAST_RING_RESTORE);
+    }
+    bool hasFastRing() const { return m_fastRing.isValid(); }
+
+    // Master: every record written (producer side), and when the first
+    // frame of each block is heard (audio task, local esp_timer time)
+    void setSyncTaps(InputTap input, BlockTap block, void* ctx) {
+        m_inputTap = input;
+        m_blockTap = block;
+        m_syncCtx = ctx;
+    }
+
+    // Follower: local time a frame should be heard, or SYNC_UNKNOWN
+    void setSyncTarget(SyncTarget target, void* ctx) {
+        m_syncTarget = target;
+        m_syncCtx = ctx;
+        m_jitter.setSyncMode(target != nullptr);
+    }
+
+    // Relay: every output block (interleaved stereo int32, I2S rate) as it
+    // is queued, valid during the call only. BlockTap indexes then count
+    // output frames.
+    void setOutputTap(OutputTap tap, void* ctx) {
+        m_outputTap = tap;
+        m_syncCtx = ctx;
+    }
+
+    // Off: input goes to I2S as it is (audio the master already processed)
+    void setDspEnabled(bool enabled) { m_dspEnabled = enabled; }
+
+#if APP_AUX_OUTPUT
+    // Roles of the aux port's slots (any task; taken at the next block)
+    bool setOutputLayout(uint8_t left, uint8_t right) {
+        if (left >= OUT_ROLE_COUNT || right >= OUT_ROLE_COUNT) return false;
+        m_pendingLayout.store((uint16_t)(left << 8 | right));
+        return true;
     }
+#endif
 
-    // Enqueue audio data from BT callback (non-blocking)
-    void enqueue(const uint8_t *data, uint32_t len, uint8_t bits, uint8_t channels) {
-        if (!m_audioQueue || !m_freeQueue || len == 0) return;
+    // Play one channel of the stream on both outputs (TWS), or both
+    enum ChannelPick : uint8_t { PICK_STEREO = 0, PICK_LEFT, PICK_RIGHT };
+    void setChannelPick(ChannelPick pick) { m_channelPick = pick; }
+
+    // Index the next enqueue()d frame gets
+    uint32_t getInputFrameIndex() const { return m_inFrames.load(std::memory_order_relaxed); }
+
+#if APP_AUDIO_DECODE_IN_PLACE
+    // Producer: ring space for the decoder to write the next batch into
+    // (Bluedroid's PCM buffer hook), at least need bytes. It comes back
+    // through enqueue(), which commits it without a copy, or through
+    // returnPcmBuffer(). nullptr when the ring has no such room.
+    uint8_t* lendPcmBuffer(size_t need, size_t* size) {
+        // Held until the buffer comes back: the lent ring must not be freed
+        m_producerBusy.store(true);
+        m_lent = nullptr;
+        SpscRing *ring = m_ring.load();
+        const uint32_t room = ring ? maxChunk(ring) : 0;
+        uint8_t* buf = (room >= need) ? ring->reserve(room) : nullptr;
+        if (!buf) {
+            m_producerBusy.store(false);
+            return nullptr;
+        }
+        m_lent = buf;
+        m_lentRing = ring;
+        m_lentSize = room;
+        *size = room;
+        return buf;
+    }
+
+    // Producer: a lent buffer the decoder did not fill
+    void returnPcmBuffer(const uint8_t* buf) {
+        if (!buf || buf != m_lent) return;
+        m_lent = nullptr;
+        m_producerBusy.store(false);
+    }
+#endif
+
+#if APP_AUDIO_PULL_DECODE
+    // The decoder processBuffer() pulls packets from: decode() decodes up
+    // to maxPackets of them on the calling task (their PCM comes back
+    // through enqueue() before it returns), queued() counts the rest
+    struct PullSource {
+        uint16_t (*decode)(uint16_t maxPackets);
+        uint16_t (*queued)();
+    };
+    void setPullSource(const PullSource& source) { m_pull = source; }
+
+    // Any task: a packet was queued for the decoder. Its arrival feeds the
+    // jitter estimate and wakes the consumer to decode it.
+    void onPacketQueued() {
+        m_jitter.noteArrival(m_pullPacketBytes.load(std::memory_order_relaxed));
+        SpscRing *ring = m_ring.load();
+        if (ring) ring->wakeConsumer();
+    }
+#endif
+
+    // Enqueue audio data from BT callback (non-blocking, producer side)
+    void enqueue(const uint8_t *data, uint32_t len, SampleFmt fmt, uint8_t channels) {
+        // Announced before the ring is picked: a ring being retired is only
+        // freed while no enqueue() can still hold it
+        m_producerBusy.store(true);
+        SpscRing *ring = m_ring.load();
+#if APP_AUDIO_DECODE_IN_PLACE
+        // Decoded into the record lendPcmBuffer() reserved; if the stream
+        // moved to the other ring since, it is copied over as usual
+        const bool inPlace = data == m_lent && ring == m_lentRing && len <= m_lentSize;
+        m_lent = nullptr;
+#else
+        const bool inPlace = false;
+#endif
+        if (!ring || len == 0) {
+            m_producerBusy.store(false);
+            return;
+        }
+        int64_t t = loadStamp();
+        const uint32_t tc = traceStamp();
+        // Records hold whole frames (S24 packed frames are 3 or 6 bytes)
+        const size_t bytesPerFrame = sampleFmtBytes(fmt) * (channels ? channels : 2u);
+
+        if (inPlace) {
+            ring->commit(len, fmt, channels, m_nextStampUs, m_nextRtpTs);
+            noteRecord(data, len, fmt, channels, bytesPerFrame);
+            len = 0;
+        }
 
         size_t remaining = len;
         const uint8_t *ptr = data;
+        size_t chunk = maxChunk(ring);
+        chunk -= chunk % bytesPerFrame;
 
         while (remaining > 0) {
-            AudioBuf *buf = nullptr;
-            if (xQueueReceive(m_freeQueue, &buf, 0) != pdTRUE) {
+            size_t copyLen = (remaining > chunk) ? chunk : remaining;
+            if (!ring->write(ptr, (uint32_t)copyLen, fmt, channels, m_nextStampUs, m_nextRtpTs)) {
+                // Ring full: the rest of the packet is lost, and counted
                 m_dropCount++;
-                if ((m_dropCount % 500) == 0) {
-                    ESP_LOGW(TAG, "Buffer drop count: %u", (unsigned)m_dropCount);
-                }
-                break;
-            }
-
-            size_t copyLen = (remaining > buf->cap) ? buf->cap : remaining;
-            buf->len = copyLen;
-            buf->bits = bits;
-            buf->channels = channels;
-            memcpy(buf->data, ptr, copyLen);
-
-            if (xQueueSend(m_audioQueue, &buf, 0) != pdTRUE) {
-                m_enqueueFail++;
-                xQueueSend(m_freeQueue, &buf, 0);
+                m_droppedFrames.fetch_add((uint32_t)(remaining / bytesPerFrame), std::memory_order_relaxed);
+                noteGlitch(GLITCH_DROP);
+                logEvent(EV_PIPELINE_DROP, getBufferedMs(), m_dropCount, (uint32_t)(remaining / bytesPerFrame));
                 break;
             }
+            noteRecord(ptr, copyLen, fmt, channels, bytesPerFrame);
 
             ptr += copyLen;
             remaining -= copyLen;
         }
         
+        m_producerBusy.store(false);
+
         // Mark audio as active when we enqueue data
         m_audioActive = true;
+        loadMark(STAGE_ENQUEUE, t);
+        traceMark(TRACE_ENQUEUE, tc);
     }
 
     // Process queued audio (called from TX task)
     void processBuffer(DSPProcessor &dsp, I2SOutput &i2s) {
-        AudioBuf *buf = nullptr;
-        
-        // Check if we should skip I2S write (e.g., sound effect playing)
-        bool skipWrite = m_skipWriteCallback && m_skipWriteCallback();
-        
-        // Detect transition to exclusive sound - clear DMA for instant cutoff
-        if (skipWrite && !m_wasSkipping) {
-            i2s.zeroDMA();  // Clear I2S DMA for instant audio cutoff
+        // Flush requested by clear(): only the consumer may move the read side.
+        // A ring switch from setStreamFormat() takes effect here too; a record
+        // the producer still puts into the old ring is dropped with the rest.
+        if (m_flushRequest.exchange(false)) {
+#if APP_CODEC_BRIDGE
+            // What the old stream left queued moves to the bridge first;
+            // the output queued ahead of it stays unless the DMA already
+            // restarted (reclock) and dropped its own
+            const uint32_t bridgeRate = m_bridgeRate.exchange(0);
+            const bool held = bridgeRate && holdStream(bridgeRate);
+            if (m_bridge.live() && i2s.getRestarts() == m_outRestarts) m_flushKeepsOutput = true;
+#endif
+            SpscRing *next = m_pendingRing.exchange(nullptr);
+            if (next == &m_fastRing) next = placeFastRing();
+            if (next) m_ring.store(next);
+            m_bulkRing.drain();
+            if (m_fastRing.isValid()) m_fastRing.drain();
+            m_jitter.reset();
+            m_recordOffset = 0;
+            if (!m_flushKeepsOutput) m_slotPending = 0;
+            m_flushKeepsOutput = false;
+            m_tailL = 0;
+            m_tailR = 0;
+            m_outputDelayUs = 0;    // Measured again for the new stream
+            m_outFrames = m_inFrames.load(std::memory_order_relaxed);
+#if APP_AUDIO_PULL_DECODE
+            m_pullPacketBytes.store(0, std::memory_order_relaxed);     // Learned again per stream
+#endif
+            m_fadeOutRequest.store(false);
+#if APP_CODEC_BRIDGE
+            // The bridge carries on from the output queued; while it
+            // plays, its own ramps stand
+            if (held) {
+                m_fade = FADE_NONE;
+            } else if (!m_bridge.live()) {
+                m_fade = FADE_IN;
+            }
+#else
+            m_fade = FADE_IN;
+#endif
+#if APP_AUX_OUTPUT
+            m_outMatrix.reset();
+#endif
+#if APP_I2S_FIXED_RATE
+            uint32_t rate = m_pendingRate.exchange(0);
+            if (rate) {
+                m_resampler.init(rate, APP_I2S_FIXED_RATE_HZ);
+                // Input per block that still fits a slot once converted
+                uint64_t fit = (uint64_t)(APP_DSP_SLOT_FRAMES - 1) * rate / APP_I2S_FIXED_RATE_HZ;
+                m_maxInFrames = fit < (uint64_t)APP_DSP_OUT_FRAMES ? (uint32_t)fit : APP_DSP_OUT_FRAMES;
+                logEvent(EV_OUTPUT_RATE, m_resampler.passthrough(), rate, APP_I2S_FIXED_RATE_HZ);
+            }
+            m_resampler.reset();
+#endif
+        }
+        SpscRing *active = m_ring.load(std::memory_order_relaxed);
+        if (!active) return;
+        active = serviceFastRing(active);
+        SpscRing &ring = *active;
+
+        // Keep queued output flowing into the DMA, also while waiting for input
+        pumpOutput(i2s);
+#if APP_AUDIO_PULL_DECODE
+        pullDecode();
+#endif
+
+        // Stream end: ramp the next block down (flushed after it, see
+        // applyFade), or with nothing to ramp end on the tail
+        if (m_endRequest.exchange(false)) {
+            if (!ring.empty() && m_jitter.isPlaying() && m_fade != FADE_MUTED) {
+                m_fadeOutRequest.store(true);
+                m_endFlush = true;
+            } else {
+                appendTail(i2s);
+                flushKeepingOutput();
+                return;
+            }
+        }
+
+#if APP_CODEC_BRIDGE
+        // The last stream's end plays on until the next one is ready
+        if (ring.empty() && m_bridge.live() && playBridge(dsp, i2s)) {
+            return;
+        }
+#endif
+
+        // No BT audio queued but a sound effect is: it plays on its own.
+        // Exclusive prompts take this path too, so audio_tx stays the only
+        // I2S writer whether or not a stream is running.
+        if (ring.empty() && mixOverlayAlone(i2s)) {
+            return;
         }
-        m_wasSkipping = skipWrite;
+#if APP_AUDIO_LATENCY_PROBE
+        uint32_t exitUs;
+        if (i2s.takeExit(exitUs)) {
+            m_latency.add(exitUs - m_probeStampUs, m_probeRtpTs);
+            // Commit-to-exit alone is the output latency, smoothed over probes
+            const uint32_t outUs = exitUs - m_probeCommitUs;
+            if (outUs < LatencyProbe::MAX_VALID_US) {
+                m_outputDelayUs = m_outputDelayUs ? m_outputDelayUs - (m_outputDelayUs >> 3) + (outUs >> 3) : outUs;
+            }
+        }
+#endif
         
+#if APP_CODEC_BRIDGE
+        bool bridgeXfade = false;
+#endif
+#if APP_JITTER_BUFFER_ENABLE
+        if (m_syncTarget) {
+            // Follower: output starts when the master's does, not on depth
+            if (!m_jitter.isPlaying() && !syncStart(i2s, ring)) return;
+        } else {
+            const bool starting = !m_jitter.isPlaying();
+            bool release = m_jitter.shouldRelease();
+#if APP_CODEC_BRIDGE
+            if (!release && m_bridge.live()) {
+                // The bridge plays through the pre-roll. About to run out,
+                // it hands over early (from half the target) rather than
+                // leave a gap.
+                if (m_bridge.remainingMs() <= BRIDGE_HANDOFF_MS &&
+                    m_jitter.getDepthMs() * 2 >= m_jitter.getTargetMs()) {
+                    m_jitter.startPlaying();
+                    release = true;
+                } else if (playBridge(dsp, i2s)) {
+                    return;
+                }
+            }
+#endif
+            if (!release) {
+                // Prebuffer: hold output until the target depth is queued,
+                // sleeping until the producer writes again
+                m_drift.restart();
+                ring.waitForWrite(idleWait(i2s, ring));
+                return;
+            }
+            // Pre-roll done: the first block ramps in, or crossfades from
+            // the bridge still playing
+#if APP_CODEC_BRIDGE
+            if (starting && m_bridge.live()) {
+                bridgeXfade = true;
+            } else
+#endif
+            if (starting && m_fade == FADE_NONE) m_fade = FADE_IN;
+        }
+#endif
+
         // Adaptive timeout: Use short timeout when audio is active for lower latency,
         // longer timeout when idle to reduce CPU usage during silence.
         // This significantly reduces LDAC jitter by processing buffers faster.
-        TickType_t timeout = m_audioActive ? pdMS_TO_TICKS(5) : pdMS_TO_TICKS(20);
+        TickType_t timeout = m_audioActive ? pdMS_TO_TICKS(5) : idleWait(i2s, ring);
         
-        if (xQueueReceive(m_audioQueue, &buf, timeout) != pdTRUE || !buf) {
+        uint32_t len = 0;
+        uint8_t fmt = SAMPLE_FMT_S16;
+        uint8_t channels = 2;
+        uint32_t stampUs = 0, rtpTs = 0;
+        const uint8_t *record = peekRecord(ring, len, fmt, channels, &stampUs, &rtpTs);
+        if (!record) {
+            ring.waitForData(timeout);
+#if APP_AUDIO_PULL_DECODE
+            pullDecode();
+#endif
+            record = peekRecord(ring, len, fmt, channels, &stampUs, &rtpTs);
+        }
+        if (!record) {
             // No data - mark audio as inactive after timeout
             if (timeout == pdMS_TO_TICKS(5)) {
                 m_audioActive = false;
             }
+#if APP_JITTER_BUFFER_ENABLE
+            if (m_jitter.isPlaying()) {
+                noteGlitch(GLITCH_UNDERRUN);
+                appendTail(i2s);
+            }
+            m_jitter.onUnderrun();
+#endif
             return;
         }
 
-        uint32_t len = buf->len;
-        uint8_t bits = buf->bits;
-        uint8_t channels = buf->channels ? buf->channels : 2;
+        if (channels == 0) channels = 2;
         
-        // Copy data to internal RAM staging buffer if available
-        // This dramatically reduces DSP processing jitter for LDAC/high-bitrate codecs
-        // PSRAM has ~100ns access latency vs ~20ns for internal RAM
-        const uint8_t* audioData;
-        if (m_stagingBuf && len <= APP_AUDIO_POOL_BUF_SIZE) {
-            // Fast memcpy from PSRAM to internal RAM (burst-optimized by cache)
-            memcpy(m_stagingBuf, buf->data, len);
-            audioData = m_stagingBuf;
-        } else {
-            // Fallback to direct PSRAM access
-            audioData = buf->data;
-        }
+        bool released = false;
 
-        uint32_t bytesPerSample = (bits <= 16) ? 2u : 4u;
-        uint32_t bytesPerFrame = bytesPerSample * channels;
-        
-        uint32_t frames;
-        if (bytesPerFrame == 0) {
-            frames = 0;
-        } else if (bytesPerFrame == 4) {
-            frames = len >> 2;
-        } else if (bytesPerFrame == 8) {
-            frames = len >> 3;
-        } else {
-            frames = len / bytesPerFrame;
-        }
+        // At most one DSP block of the record; the rest waits for the next pass
+        uint32_t bytesPerFrame = sampleFmtBytes(fmt) * channels;
+        uint32_t frames = len / bytesPerFrame;
+#if APP_I2S_FIXED_RATE
+        if (frames > m_maxInFrames) frames = m_maxInFrames;
+#else
+        if (frames > APP_DSP_OUT_FRAMES) frames = APP_DSP_OUT_FRAMES;
+#endif
+        const uint32_t chunkBytes = frames * bytesPerFrame;
+        const bool lastChunk = len - chunkBytes < bytesPerFrame;
+#if APP_JITTER_BUFFER_ENABLE
+        m_jitter.onConsumed(lastChunk ? len : chunkBytes);
+#endif
+        const uint32_t frameIndex = m_outFrames;
+        m_outFrames += frames;
+#if APP_DSP_Q31_PATH
+        // 24/32-bit sources stay fixed-point end to end, in m_dspOut;
+        // that path has the built-in stage order only
+#if APP_DSP_GRAPH
+        const bool q31 = (fmt != SAMPLE_FMT_S16) && !dsp.hasCustomGraph();
+#else
+        const bool q31 = (fmt != SAMPLE_FMT_S16);
+#endif
+#endif
+#if APP_DSP_PASSTHROUGH
+        // Nothing for the DSP to do: the PCM goes to the slot as it came,
+        // widened to Q31 by shifts
+        const bool direct = !m_dspEnabled || dsp.passthrough();
+#endif
 
         if (frames > 0) {
-            if (frames > APP_DSP_OUT_FRAMES) frames = APP_DSP_OUT_FRAMES;
+            // Free output slot first (sleeps only while every slot is queued)
+            uint32_t tc = traceStamp();
+            acquireSlot(i2s);
+            traceMark(TRACE_I2S_BLOCKED, tc);
+            int64_t t = loadStamp();
+            tc = traceStamp();
+#if APP_DEADLINE_MONITOR
+            const uint32_t blockStart = DeadlineMonitor::start();
+#endif
+#if APP_CODEC_BRIDGE
+            if (bridgeXfade) renderBridgeMix(dsp, i2s, frames);
+#endif
+
+            // One sequential pass over the record (PSRAM or internal) into
+            // the internal work buffer; the DSP stages never touch the ring.
+            // Its space goes back to the producer before the DSP runs
+            // (after its last block). Format and channel count are
+            // dispatched once per block.
+#if APP_PCM_CAPTURE
+            PcmCapture::getInstance().write(CAPTURE_PRE_DSP, record, chunkBytes, fmt, channels,
+                                            m_streamRate, frameIndex);
+#endif
+#if APP_DSP_PASSTHROUGH
+            if (direct) {
+                convertBlock<int32_t>(fmt, channels, record, m_dspOut, frames);
+            } else
+#endif
+#if APP_DSP_Q31_PATH
+            if (q31) {
+                convertBlock<int32_t>(fmt, channels, record, m_dspOut, frames);
+            } else
+#endif
+            {
+                convertBlock<float>(fmt, channels, record, m_floatBuf, frames);
+            }
+            consumeRecord(ring, chunkBytes, lastChunk);
+            released = true;
+            if (m_channelPick != PICK_STEREO) {
+#if APP_DSP_PASSTHROUGH
+                if (direct) {
+                    pickChannel(m_dspOut, frames);
+                } else
+#endif
+#if APP_DSP_Q31_PATH
+                if (q31) {
+                    pickChannel(m_dspOut, frames);
+                } else
+#endif
+                {
+                    pickChannel(m_floatBuf, frames);
+                }
+            }
+            loadMark(STAGE_CONVERT, t);
 
-            if (bytesPerSample == 2) {
-                process16bitFast(audioData, frames, channels, dsp);
+#if APP_DSP_PASSTHROUGH
+            if (direct) {
+                if (m_dspEnabled) dsp.processPassthrough(m_dspOut, frames);
+            } else
+#endif
+#if APP_DSP_Q31_PATH
+            if (q31) {
+                if (m_dspEnabled) dsp.processBlockQ31(m_dspOut, frames);
+            } else
+#endif
+            if (!m_dspEnabled) {
+                floatToOut(m_floatBuf, frames);
             } else {
-                process32bitFast(audioData, frames, channels, dsp);
+                dsp.processBlock(m_floatBuf, m_floatBuf, frames);
+                if (dsp.isIdle()) {
+                    memset(m_dspOut, 0, frames * 2 * sizeof(int32_t));
+                } else {
+                    floatToOut(m_floatBuf, frames);
+                }
+            }
+#if APP_CODEC_BRIDGE
+            if (bridgeXfade) crossfadeBridge(frames);
+#endif
+            loadMark(STAGE_DSP, t);
+            traceMark(TRACE_DSP, tc);
+
+            // Silence gate: the DSP idled on silent input, so unless an
+            // overlay sound plays there is nothing to send. The DMA
+            // clears itself (auto_clear) and the task sleeps on the ring.
+            bool idle = m_dspEnabled && dsp.isIdle() && !(m_overlayMixer && m_overlayMixer->isActive()) &&
+                        !m_blockTap && !m_syncTarget;
+#if APP_CODEC_BRIDGE
+            if (bridgeXfade) idle = false;     // The bridge fades out in it
+#endif
+            if (idle) {
+                m_drift.restart();
+                m_tailL = 0;    // Output went quiet: no tail to ramp
+                m_tailR = 0;
+            } else {
+#if APP_I2S_FIXED_RATE
+                frames = convertRate(frames);
+#endif
+#if APP_JITTER_BUFFER_ENABLE
+                // Steer buffered depth towards the target by a few frames per block
+                int slip = m_jitter.slipFrames(frames);
+                if (slip != 0) {
+#if APP_DSP_PASSTHROUGH
+                    if (direct) {
+                        frames = applySlip<true>(m_dspOut, frames, (uint32_t)((int32_t)frames + slip));
+                    } else
+#endif
+                    {
+                        frames = applySlip<false>(m_dspOut, frames, (uint32_t)((int32_t)frames + slip));
+                    }
+                }
+#endif
+
+#if APP_DRIFT_COMP_ENABLE
+                // Follow the source clock with the I2S APLL. Without APLL, or
+                // with the aux channel holding it too, the slips above take
+                // the drift instead
+                float trimPpm;
+                if (i2s.canTrimClock() && m_drift.update(m_jitter.getDepthErrorMs(), trimPpm)) {
+                    i2s.setClockTrimPpm(trimPpm);
+                }
+#endif
+            }
+
+            if (m_fade != FADE_NONE || m_fadeOutRequest.load(std::memory_order_relaxed)) {
+                applyFade(frames);
+                // Stream end: that ramp was the last block
+                if (m_endFlush && m_fade == FADE_MUTED) {
+                    m_endFlush = false;
+                    flushKeepingOutput();
+                }
             }
 
             // Mix overlay audio (sound effects) with BT audio
@@ -262,37 +907,96 @@ public:
                 m_overlayMixer->mixIntoOutput(m_dspOut, frames);
             }
 
-            if (!skipWrite) {
-                size_t bytesToWrite = frames * 2u * sizeof(int32_t);
-                size_t written = i2s.write(m_dspOut, bytesToWrite);
-                
+            if (!idle) {
+                const uint32_t outIndex = m_outputFrames;
+                m_outputFrames += frames;
+                if (m_outputTap) m_outputTap(m_syncCtx, m_dspOut, frames, outIndex, i2s.getSampleRate());
+#if APP_PCM_CAPTURE
+                PcmCapture::getInstance().write(CAPTURE_POST_DSP, m_dspOut, frames * 2 * sizeof(int32_t),
+                                                SAMPLE_FMT_S32, 2, i2s.getSampleRate(), outIndex);
+#endif
+                if (frames > 0) {
+                    m_tailL = m_dspOut[2 * (frames - 1)];
+                    m_tailR = m_dspOut[2 * (frames - 1) + 1];
+                }
+                commitSlot(i2s, frames, stampUs, rtpTs);
+                const int64_t nowUs = esp_timer_get_time();
+                const uint32_t delayUs = outputDelayUs(i2s, frames);
+                dsp.analyzer().markBlock((uint32_t)nowUs, delayUs);
+                if (m_blockTap || m_syncTarget) {
+                    syncBlock(i2s, m_outputTap ? outIndex : frameIndex, frames, nowUs + delayUs);
+                }
                 m_writeCount++;
                 m_lastProcessMs = millis32();
-
-                if (written < bytesToWrite) {
-                    m_shortWriteCount++;
+#if APP_DEADLINE_MONITOR
+                if (m_deadline.end(blockStart, frames, i2s.getSampleRate(), dsp)) {
+                    captureMark(CAPTURE_MARK_DEADLINE);
                 }
+#endif
             }
+            loadMark(STAGE_OUTPUT, t);
         }
 
-        // Return buffer to free pool
-        xQueueSend(m_freeQueue, &buf, 0);
+        if (!released) {
+            consumeRecord(ring, chunkBytes, lastChunk);
+        }
     }
 
-    // Clear all queued audio (fast path - no waiting)
+    // Clear all queued audio (fast path - no waiting). Safe from any task:
+    // the consumer drains the ring at the start of its next processBuffer().
     void clear() {
-        if (!m_audioQueue || !m_freeQueue) return;
+        if (!m_ring.load()) return;
         
         // Mark audio as inactive
         m_audioActive = false;
         
-        AudioBuf *buf = nullptr;
-        // Drain all buffers from audio queue back to free pool
-        while (xQueueReceive(m_audioQueue, &buf, 0) == pdTRUE) {
-            if (buf) {
-                xQueueSend(m_freeQueue, &buf, 0);
-            }
+        m_flushRequest.store(true);
+        m_jitter.reset();
+        m_drift.restart();
+        wake();
+    }
+
+    // Ramp BT audio to silence within a block and hold it there until the
+    // next clear() (any task). Overlay sounds are not affected.
+    void fadeOut() {
+        m_fadeOutRequest.store(true);
+        wake();
+    }
+
+    // The stream stopped (A2DP suspend, any task): ramp down within a
+    // block, then flush like clear(), but let output already queued for
+    // the DMA play out
+    void endStream() {
+        if (!m_ring.load()) return;
+#if APP_CODEC_BRIDGE
+        if (m_bridge.ready() && m_jitter.isPlaying()) {
+            bridgeStream();
+            return;
         }
+#endif
+        m_endRequest.store(true);
+        wake();
+    }
+
+#if APP_CODEC_BRIDGE
+    // Flush like clear(), but what the stream still has queued plays on
+    // and the next stream crossfades from it (codec switch, reconnect;
+    // any task). A plain clear() unless the stream is playing.
+    void bridgeStream() {
+        if (m_bridge.ready() && m_jitter.isPlaying()) m_bridgeRate.store(m_streamRate);
+        clear();
+    }
+
+    // Output still comes from a stream that ended (any task)
+    bool bridging() const {
+        return m_bridgeRate.load() != 0 || m_bridge.live();
+    }
+#endif
+
+    // End the audio task's idle wait (overlay audio queued, any task)
+    void wake() {
+        m_bulkRing.wakeConsumer();
+        if (m_fastRing.isValid()) m_fastRing.wakeConsumer();
     }
 
     // Aggressive clear - also zeros I2S DMA buffers for faster audio cutoff
@@ -307,345 +1011,825 @@ public:
     uint32_t getDropCount() const { return m_dropCount; }
     uint32_t getEnqueueFailCount() const { return m_enqueueFail; }
     uint32_t getShortWriteCount() const { return m_shortWriteCount; }
+    uint32_t getWriteCount() const { return m_writeCount; }   // Output blocks since boot
+
+    // Frame accounting since boot (wrapping): in = written to the ring,
+    // out = taken from it (played, skipped or flushed), dropped = lost
+    // to a full ring. in - out is what is queued now.
+    struct FrameCounts {
+        uint32_t in;
+        uint32_t out;
+        uint32_t dropped;
+    };
+    FrameCounts getFrameCounts() const {
+        return { m_inFrames.load(std::memory_order_relaxed), m_outFrames,
+                 m_droppedFrames.load(std::memory_order_relaxed) };
+    }
     
     // Get queue fill level (0-100%)
     uint8_t getQueueFillPercent() const {
-        if (!m_audioQueue) return 0;
-        UBaseType_t waiting = uxQueueMessagesWaiting(m_audioQueue);
-        return (uint8_t)((waiting * 100) / APP_AUDIO_POOL_COUNT);
+        const SpscRing *ring = m_ring.load(std::memory_order_relaxed);
+        if (!ring) return 0;
+        return (uint8_t)(((uint64_t)ring->usedBytes() * 100) / ring->capacity());
+    }
+
+    // Jitter buffer state (depth/target in ms of audio)
+    const JitterBuffer& getJitterBuffer() const { return m_jitter; }
+    void setLinkMarginMs(uint32_t ms) { m_jitter.setLinkMarginMs(ms); }
+    uint32_t getBufferedMs() const { return m_jitter.getDepthMs(); }
+    float getDriftPpm() const { return m_drift.getDriftPpm(); }
+
+    // Per-stage busy time since the last call (load reporter only)
+    void takeStageLoad(PipelineStage stage, uint32_t& busyUs, uint32_t& peakUs) {
+        m_load[stage].take(busyUs, peakUs);
+    }
+    static const char* stageName(PipelineStage stage) {
+        switch (stage) {
+            case STAGE_ENQUEUE: return "enqueue";
+            case STAGE_CONVERT: return "convert";
+            case STAGE_DSP:     return "dsp";
+            default:            return "output";
+        }
     }
 
+#if APP_AUDIO_PERF_TRACE
+    // Cycle histograms; the decode point is written by the Bluedroid hook
+    PerfTrace& perfTrace() { return m_trace; }
+#endif
+
+#if APP_DEADLINE_MONITOR
+    // Block deadline misses per DSP mode, and what was shed for them
+    DeadlineMonitor& deadline() { return m_deadline; }
+#endif
+
+    // Enqueue-to-DMA-exit latency (APP_AUDIO_LATENCY_PROBE)
+    LatencyProbe& latency() { return m_latency; }
+
 private:
     static constexpr const char* TAG = "AudioPipe";
 
+    // Smallest internal ring worth allocating (~90 ms of 44.1k/16 stereo)
+    static constexpr size_t FAST_RING_MIN_BYTES = 16 * 1024;
+
+    enum : uint8_t { FAST_RING_NONE, FAST_RING_RELEASE, FAST_RING_RESTORE };
+
+    // Low-bitrate ring sized from the internal RAM left above the reserve
+    bool allocFastRing() {
+#if APP_STATIC_ALLOCATION
+        // Full configured size from the internal arena, taken once
+        const size_t fastBytes = (size_t)APP_AUDIO_FAST_RING_KB * 1024;
+        if (!m_fastStatic) m_fastStatic = (uint8_t*)StaticAlloc::take("fast_ring", fastBytes, StaticAlloc::INTERNAL);
+        if (!m_fastRing.init(m_fastStatic, fastBytes)) return false;
+        ESP_LOGI(TAG, "Low-bitrate ring in the static arena: %u KB", (unsigned)(m_fastRing.capacity() / 1024));
+        return true;
+#else
+        // What the reserve leaves, capped by the audio budget; internal
+        // only, a PSRAM copy of the bulk ring would be pointless
+        size_t fastSize = MemoryProbe::run().internalBudget(
+            (size_t)APP_AUDIO_FAST_RING_KB * 1024,
+            (size_t)APP_AUDIO_FAST_RING_RESERVE_KB * 1024,
+            FAST_RING_MIN_BYTES);
+        const size_t budget = MemPlacement::internalAvailable(MEM_OWNER_AUDIO, MEM_PRIO_OPTIONAL);
+        if (fastSize > budget) fastSize = budget >= FAST_RING_MIN_BYTES ? budget : 0;
+        if (!fastSize) return false;
+        m_fastHeap = (uint8_t*)MemPlacement::alloc("fast_ring", MEM_OWNER_AUDIO, fastSize, MEM_INTERNAL,
+                                                   MEM_PRIO_OPTIONAL, MALLOC_CAP_INTERNAL);
+        if (!m_fastRing.init(m_fastHeap, fastSize)) {
+            MemPlacement::release(m_fastHeap);
+            m_fastHeap = nullptr;
+            return false;
+        }
+        ESP_LOGI(TAG, "Low-bitrate ring allocated in internal RAM: %u KB",
+                 (unsigned)(m_fastRing.capacity() / 1024));
+        return true;
+#endif
+    }
+
+    // The fast ring could be placed for a new stream: a high-bitrate codec
+    // gave it back and memory pressure is not holding it back
+    bool fastRingPlaceable() const {
+        return m_fastParked.load() && m_bulkInPsram && !m_fastHeld.load();
+    }
+
+    // Consumer, at a format flush that asked for the fast ring: place it
+    // again if a high-bitrate codec had given it back, and move the jitter
+    // buffer to its depth. The bulk ring when it is retiring, has no room
+    // or is too short for the target.
+    SpscRing* placeFastRing() {
+        if (m_fastRetiring) return &m_bulkRing;
+        if (m_fastRing.isValid()) return &m_fastRing;
+        if (!fastRingPlaceable() || !allocFastRing()) return &m_bulkRing;
+        m_fastParked.store(false);
+        const uint32_t fastMs = ringMs(m_fastRing, m_streamRate, m_streamBpf);
+        if (fastMs < m_streamTargetMs + m_streamTargetMs / 2) return &m_bulkRing;
+        m_jitter.configure(m_streamRate, m_streamBpf, m_streamTargetMs, fastMs);
+        return &m_fastRing;
+    }
+
+    // Consumer: carry out releaseFastRing()/restoreFastRing(). The producer
+    // moves to the bulk ring at once; the consumer plays out what the fast
+    // ring still holds, then frees it. Returns the ring to read from.
+    // Producer: largest record enqueue() writes
+    static uint32_t maxChunk(const SpscRing *ring) {
+        return ring->maxPayload() < APP_AUDIO_POOL_BUF_SIZE ? ring->maxPayload() : APP_AUDIO_POOL_BUF_SIZE;
+    }
+
+    // Producer: bookkeeping for a record just written
+    void noteRecord(const uint8_t *data, size_t len, SampleFmt fmt, uint8_t channels, size_t bytesPerFrame) {
+        const uint32_t index = m_inFrames.load(std::memory_order_relaxed);
+        if (m_inputTap) m_inputTap(m_syncCtx, data, (uint32_t)len, fmt, channels, index);
+        m_inFrames.store(index + (uint32_t)(len / bytesPerFrame), std::memory_order_relaxed);
+#if APP_AUDIO_PULL_DECODE
+        // Pulled PCM arrived as a packet already (onPacketQueued())
+        if (m_pulling) {
+            m_jitter.onDecoded(len);
+        } else {
+            m_jitter.onArrival(len);
+        }
+#elif APP_JITTER_BUFFER_ENABLE
+        m_jitter.onArrival(len);
+#endif
+        m_nextStampUs = 0;  // Only the first record carries it
+    }
+
+#if APP_AUDIO_PULL_DECODE
+    // Consumer: decode queued packets until the ring holds a DSP block, a
+    // packet's worth at a time once its size is known, then report what
+    // is still encoded to the jitter buffer
+    void pullDecode() {
+        if (!m_pull.decode) return;
+        const uint32_t want = APP_DSP_OUT_FRAMES * m_streamBpf;
+        uint32_t perPacket = m_pullPacketBytes.load(std::memory_order_relaxed);
+        m_pulling = true;
+        for (int i = 0; i < PULL_MAX_CALLS; i++) {
+            const uint32_t have = m_jitter.getBufferedBytes();
+            if (have >= want) break;
+            const uint16_t n = perPacket ? (uint16_t)((want - have + perPacket - 1) / perPacket) : 1;
+            const uint16_t got = m_pull.decode(n);
+            if (got == 0) break;
+            // Only this task adds to the depth meanwhile
+            const uint32_t bytes = (m_jitter.getBufferedBytes() - have) / got;
+            perPacket = perPacket ? perPacket - (perPacket >> 3) + (bytes >> 3) : bytes;
+        }
+        m_pulling = false;
+        m_pullPacketBytes.store(perPacket, std::memory_order_relaxed);
+        m_jitter.setBacklogBytes(m_pull.queued() * perPacket);
+    }
+#endif
+
+    SpscRing* serviceFastRing(SpscRing *active) {
+        uint8_t op = m_fastRingOp.exchange(FAST_RING_NONE, std::memory_order_relaxed);
+        if (op == FAST_RING_RELEASE && m_fastRing.isValid() && !m_fastRetiring) {
+            if (active == &m_fastRing) m_ring.store(&m_bulkRing);
+            m_fastRetiring = true;
+        } else if (op == FAST_RING_RESTORE && !m_fastRetiring && !m_fastRing.isValid() &&
+                   m_bulkInPsram && APP_AUDIO_FAST_RING_KB > 0 && m_streamLowRate.load()) {
+            if (allocFastRing()) m_fastParked.store(false);
+        }
+        if (!m_fastRetiring) return active;
+
+        // Producer first: once it is out, nothing more lands in the fast ring
+        if (m_producerBusy.load() || !m_fastRing.empty()) return &m_fastRing;
+        m_fastRing.deinit();
+        MemPlacement::release(m_fastHeap);
+        m_fastHeap = nullptr;
+        m_fastRetiring = false;
+        logEvent(EV_FAST_RING_RELEASED);
+        return m_ring.load(std::memory_order_relaxed);
+    }
+
+    // Consumer: the unread part of the oldest record. Only the first block
+    // of a record carries its arrival stamp; later ones get the RTP time of
+    // their own first frame.
+    const uint8_t* peekRecord(SpscRing &ring, uint32_t &len, uint8_t &fmt, uint8_t &channels,
+                              uint32_t *stampUs = nullptr, uint32_t *rtpTs = nullptr) {
+        const uint8_t *record = ring.peek(len, fmt, channels, stampUs, rtpTs);
+        if (!record || m_recordOffset == 0) return record;
+        if (stampUs) *stampUs = 0;
+        if (rtpTs) *rtpTs += m_recordOffset / (sampleFmtBytes(fmt) * (channels ? channels : 2u));
+        len -= m_recordOffset;
+        return record + m_recordOffset;
+    }
+
+    // Consumer: bytes of the record used; it goes back to the producer
+    // with its last block
+    void consumeRecord(SpscRing &ring, uint32_t bytes, bool last) {
+        if (last) {
+            ring.release();
+            m_recordOffset = 0;
+        } else {
+            m_recordOffset += bytes;
+        }
+    }
+
     static uint32_t millis32() {
         return (uint32_t)(esp_timer_get_time() / 1000ULL);
     }
 
-    void process16bit(AudioBuf *buf, uint32_t frames, uint8_t channels, DSPProcessor &dsp) {
-        const int16_t *smp = (const int16_t *)buf->data;
-        constexpr float scale16 = 1.0f / 32768.0f;
-        constexpr float scaleOut = 2147483647.0f;
-        
-        // Process in blocks of 4 samples to reduce loop overhead
-        uint32_t i = 0;
-        const uint32_t unrollEnd = frames & ~3u;  // Round down to multiple of 4
-        
-        if (channels == 1) {
-            // Mono path - unrolled
-            for (; i < unrollEnd; i += 4) {
-                float L0 = (float)smp[i] * scale16;
-                float L1 = (float)smp[i + 1] * scale16;
-                float L2 = (float)smp[i + 2] * scale16;
-                float L3 = (float)smp[i + 3] * scale16;
-                float R0 = L0, R1 = L1, R2 = L2, R3 = L3;
-                
-                dsp.processStereo(L0, R0);
-                dsp.processStereo(L1, R1);
-                dsp.processStereo(L2, R2);
-                dsp.processStereo(L3, R3);
-                
-                m_dspOut[2 * i + 0] = (int32_t)(L0 * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R0 * scaleOut);
-                m_dspOut[2 * (i + 1) + 0] = (int32_t)(L1 * scaleOut);
-                m_dspOut[2 * (i + 1) + 1] = (int32_t)(R1 * scaleOut);
-                m_dspOut[2 * (i + 2) + 0] = (int32_t)(L2 * scaleOut);
-                m_dspOut[2 * (i + 2) + 1] = (int32_t)(R2 * scaleOut);
-                m_dspOut[2 * (i + 3) + 0] = (int32_t)(L3 * scaleOut);
-                m_dspOut[2 * (i + 3) + 1] = (int32_t)(R3 * scaleOut);
-            }
-            // Handle remaining samples
-            for (; i < frames; i++) {
-                float L = (float)smp[i] * scale16;
-                float R = L;
-                dsp.processStereo(L, R);
-                m_dspOut[2 * i + 0] = (int32_t)(L * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R * scaleOut);
+    // Usable depth of a ring for a format: leave a quarter as headroom
+    static uint32_t ringMs(const SpscRing& ring, uint32_t rate, uint32_t bytesPerFrame) {
+        uint64_t frames = (uint64_t)ring.capacity() / bytesPerFrame;
+        return (uint32_t)(frames * 1000ULL / rate) * 3 / 4;
+    }
+
+    // Resample an interleaved stereo block from inFrames to outFrames in place
+    // with linear interpolation (Exact: the nearest frame, so frames are only
+    // repeated or dropped and every sample stays one of the input's). Used for
+    // small jitter-buffer slips only, so outFrames stays within inFrames +/-
+    // APP_DSP_SLIP_HEADROOM.
+    template <bool Exact>
+    static uint32_t applySlip(int32_t* buf, uint32_t inFrames, uint32_t outFrames) {
+        if (inFrames < 2 || outFrames < 2 || outFrames > APP_DSP_SLOT_FRAMES + APP_DSP_SLIP_HEADROOM) {
+            return inFrames;
+        }
+        // 16.16 fixed-point step so first and last frames map exactly
+        uint32_t step = (uint32_t)(((uint64_t)(inFrames - 1) << 16) / (outFrames - 1));
+
+        auto lerp = [](int32_t a, int32_t b, uint32_t frac) -> int32_t {
+            if (Exact) return frac < 0x8000 ? a : b;
+            return a + (int32_t)(((int64_t)(b - (int64_t)a) * frac) >> 16);
+        };
+
+        if (outFrames < inFrames) {
+            // Shrink: source index is always ahead of the destination
+            for (uint32_t j = 0; j < outFrames; j++) {
+                uint32_t pos = j * step;
+                uint32_t idx = pos >> 16;
+                uint32_t frac = pos & 0xFFFF;
+                uint32_t nxt = (idx + 1 < inFrames) ? idx + 1 : idx;
+                buf[2 * j + 0] = lerp(buf[2 * idx + 0], buf[2 * nxt + 0], frac);
+                buf[2 * j + 1] = lerp(buf[2 * idx + 1], buf[2 * nxt + 1], frac);
             }
         } else {
-            // Stereo path - unrolled
-            for (; i < unrollEnd; i += 4) {
-                float L0 = (float)smp[(i) * 2 + 0] * scale16;
-                float R0 = (float)smp[(i) * 2 + 1] * scale16;
-                float L1 = (float)smp[(i + 1) * 2 + 0] * scale16;
-                float R1 = (float)smp[(i + 1) * 2 + 1] * scale16;
-                float L2 = (float)smp[(i + 2) * 2 + 0] * scale16;
-                float R2 = (float)smp[(i + 2) * 2 + 1] * scale16;
-                float L3 = (float)smp[(i + 3) * 2 + 0] * scale16;
-                float R3 = (float)smp[(i + 3) * 2 + 1] * scale16;
-                
-                dsp.processStereo(L0, R0);
-                dsp.processStereo(L1, R1);
-                dsp.processStereo(L2, R2);
-                dsp.processStereo(L3, R3);
-                
-                m_dspOut[2 * i + 0] = (int32_t)(L0 * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R0 * scaleOut);
-                m_dspOut[2 * (i + 1) + 0] = (int32_t)(L1 * scaleOut);
-                m_dspOut[2 * (i + 1) + 1] = (int32_t)(R1 * scaleOut);
-                m_dspOut[2 * (i + 2) + 0] = (int32_t)(L2 * scaleOut);
-                m_dspOut[2 * (i + 2) + 1] = (int32_t)(R2 * scaleOut);
-                m_dspOut[2 * (i + 3) + 0] = (int32_t)(L3 * scaleOut);
-                m_dspOut[2 * (i + 3) + 1] = (int32_t)(R3 * scaleOut);
-            }
-            // Handle remaining samples
-            for (; i < frames; i++) {
-                float L = (float)smp[i * channels + 0] * scale16;
-                float R = (float)smp[i * channels + 1] * scale16;
-                dsp.processStereo(L, R);
-                m_dspOut[2 * i + 0] = (int32_t)(L * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R * scaleOut);
+            // Stretch: walk backwards so sources are read before being overwritten
+            for (uint32_t j = outFrames; j-- > 0;) {
+                uint32_t pos = j * step;
+                uint32_t idx = pos >> 16;
+                uint32_t frac = pos & 0xFFFF;
+                uint32_t nxt = (idx + 1 < inFrames) ? idx + 1 : idx;
+                buf[2 * j + 0] = lerp(buf[2 * idx + 0], buf[2 * nxt + 0], frac);
+                buf[2 * j + 1] = lerp(buf[2 * idx + 1], buf[2 * nxt + 1], frac);
             }
         }
+        return outFrames;
     }
 
-    void process32bit(AudioBuf *buf, uint32_t frames, uint8_t channels, DSPProcessor &dsp) {
-        const int32_t *smp = (const int32_t *)buf->data;
-        constexpr float scale32 = 1.0f / 2147483648.0f;
-        constexpr float scaleOut = 2147483647.0f;
-        
-        // Process in blocks of 4 samples to reduce loop overhead
-        uint32_t i = 0;
-        const uint32_t unrollEnd = frames & ~3u;  // Round down to multiple of 4
-        
-        if (channels == 1) {
-            // Mono path - unrolled
-            for (; i < unrollEnd; i += 4) {
-                float L0 = (float)smp[i] * scale32;
-                float L1 = (float)smp[i + 1] * scale32;
-                float L2 = (float)smp[i + 2] * scale32;
-                float L3 = (float)smp[i + 3] * scale32;
-                float R0 = L0, R1 = L1, R2 = L2, R3 = L3;
-                
-                dsp.processStereo(L0, R0);
-                dsp.processStereo(L1, R1);
-                dsp.processStereo(L2, R2);
-                dsp.processStereo(L3, R3);
-                
-                m_dspOut[2 * i + 0] = (int32_t)(L0 * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R0 * scaleOut);
-                m_dspOut[2 * (i + 1) + 0] = (int32_t)(L1 * scaleOut);
-                m_dspOut[2 * (i + 1) + 1] = (int32_t)(R1 * scaleOut);
-                m_dspOut[2 * (i + 2) + 0] = (int32_t)(L2 * scaleOut);
-                m_dspOut[2 * (i + 2) + 1] = (int32_t)(R2 * scaleOut);
-                m_dspOut[2 * (i + 3) + 0] = (int32_t)(L3 * scaleOut);
-                m_dspOut[2 * (i + 3) + 1] = (int32_t)(R3 * scaleOut);
-            }
-            // Handle remaining samples
-            for (; i < frames; i++) {
-                float L = (float)smp[i] * scale32;
-                float R = L;
-                dsp.processStereo(L, R);
-                m_dspOut[2 * i + 0] = (int32_t)(L * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R * scaleOut);
-            }
-        } else {
-            // Stereo path - unrolled
-            for (; i < unrollEnd; i += 4) {
-                float L0 = (float)smp[(i) * 2 + 0] * scale32;
-                float R0 = (float)smp[(i) * 2 + 1] * scale32;
-                float L1 = (float)smp[(i + 1) * 2 + 0] * scale32;
-                float R1 = (float)smp[(i + 1) * 2 + 1] * scale32;
-                float L2 = (float)smp[(i + 2) * 2 + 0] * scale32;
-                float R2 = (float)smp[(i + 2) * 2 + 1] * scale32;
-                float L3 = (float)smp[(i + 3) * 2 + 0] * scale32;
-                float R3 = (float)smp[(i + 3) * 2 + 1] * scale32;
-                
-                dsp.processStereo(L0, R0);
-                dsp.processStereo(L1, R1);
-                dsp.processStereo(L2, R2);
-                dsp.processStereo(L3, R3);
-                
-                m_dspOut[2 * i + 0] = (int32_t)(L0 * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R0 * scaleOut);
-                m_dspOut[2 * (i + 1) + 0] = (int32_t)(L1 * scaleOut);
-                m_dspOut[2 * (i + 1) + 1] = (int32_t)(R1 * scaleOut);
-                m_dspOut[2 * (i + 2) + 0] = (int32_t)(L2 * scaleOut);
-                m_dspOut[2 * (i + 2) + 1] = (int32_t)(R2 * scaleOut);
-                m_dspOut[2 * (i + 3) + 0] = (int32_t)(L3 * scaleOut);
-                m_dspOut[2 * (i + 3) + 1] = (int32_t)(R3 * scaleOut);
+#if APP_AUDIO_LOAD_REPORT
+    static int64_t loadStamp() { return esp_timer_get_time(); }
+    // Charge the time since t to a stage and restart t
+    void loadMark(PipelineStage stage, int64_t &t) {
+        int64_t now = esp_timer_get_time();
+        m_load[stage].add((uint32_t)(now - t));
+        t = now;
+    }
+#else
+    static int64_t loadStamp() { return 0; }
+    void loadMark(PipelineStage, int64_t &) {}
+#endif
+
+#if APP_AUDIO_PERF_TRACE
+    static uint32_t traceStamp() { return PerfTrace::now(); }
+    void traceMark(TracePoint p, uint32_t start) { m_trace.record(p, start); }
+#else
+    static uint32_t traceStamp() { return 0; }
+    void traceMark(TracePoint, uint32_t) {}
+#endif
+
+    // Until the end of a block just committed (frames long) is heard
+    uint32_t outputDelayUs(const I2SOutput &i2s, uint32_t frames) const {
+        const uint32_t rate = i2s.getSampleRate();
+        if (rate == 0) return 0;
+        if (m_outputDelayUs) {
+            return m_outputDelayUs + (uint32_t)((uint64_t)frames * 1000000ULL / rate);
+        }
+        uint32_t bytes = 0;
+        for (uint8_t i = 0; i < m_slotPending; i++) {
+            const OutSlot &slot = m_slots[(m_slotHead + i) % APP_I2S_OUT_SLOTS];
+            bytes += slot.bytes - slot.offset;
+        }
+        return (uint32_t)((uint64_t)(bytes / I2SOutput::FRAME_BYTES) * 1000000ULL / rate) + i2s.getDmaLatencyUs();
+    }
+
+    int32_t *slotBuf(uint8_t idx) const { return m_outSlots + (size_t)idx * APP_DSP_SLOT_WORDS; }
+#if APP_AUX_OUTPUT
+    int32_t *auxSlotBuf(uint8_t idx) const { return m_auxSlots + (size_t)idx * APP_DSP_SLOT_WORDS; }
+#endif
+
+    // Queue pending slots into free DMA buffers, oldest first, without
+    // blocking. Returns true once nothing is pending.
+    bool pumpOutput(I2SOutput &i2s) {
+        while (m_slotPending > 0) {
+            OutSlot &slot = m_slots[m_slotHead];
+            const uint8_t *p = (const uint8_t *)slotBuf(m_slotHead) + slot.offset;
+            uint32_t pos = 0;
+            size_t n = i2s.writeNoWait(p, slot.bytes - slot.offset, &pos);
+#if APP_AUDIO_LATENCY_PROBE
+            if (slot.stampUs != 0 && slot.offset == 0 && n > 0) {
+                // Probe the slot's first frame unless one is still in flight
+                if (i2s.probeExit(pos)) {
+                    m_probeStampUs = slot.stampUs;
+                    m_probeRtpTs = slot.rtpTs;
+                    m_probeCommitUs = slot.commitUs;
+                }
+                slot.stampUs = 0;
             }
-            // Handle remaining samples
-            for (; i < frames; i++) {
-                float L = (float)smp[i * channels + 0] * scale32;
-                float R = (float)smp[i * channels + 1] * scale32;
-                dsp.processStereo(L, R);
-                m_dspOut[2 * i + 0] = (int32_t)(L * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R * scaleOut);
+#endif
+            slot.offset += n;
+#if APP_AUX_OUTPUT
+            if (slot.auxOffset < slot.bytes) {
+                slot.auxOffset += i2s.writeAuxNoWait((const uint8_t *)auxSlotBuf(m_slotHead) + slot.auxOffset,
+                                                     slot.bytes - slot.auxOffset);
             }
+            if (slot.auxOffset < slot.bytes) return false;
+#endif
+            if (slot.offset < slot.bytes) return false;
+            m_slotHead = (uint8_t)((m_slotHead + 1) % APP_I2S_OUT_SLOTS);
+            m_slotPending--;
         }
+        return true;
     }
 
-    // Fast versions that take a data pointer (for staging buffer optimization)
-    void process16bitFast(const uint8_t *data, uint32_t frames, uint8_t channels, DSPProcessor &dsp) {
-        const int16_t *smp = (const int16_t *)data;
-        constexpr float scale16 = 1.0f / 32768.0f;
-        constexpr float scaleOut = 2147483647.0f;
-        
-        // Process in blocks of 4 samples to reduce loop overhead
-        uint32_t i = 0;
-        const uint32_t unrollEnd = frames & ~3u;  // Round down to multiple of 4
-        
-        if (channels == 1) {
-            // Mono path - unrolled
-            for (; i < unrollEnd; i += 4) {
-                float L0 = (float)smp[i] * scale16;
-                float L1 = (float)smp[i + 1] * scale16;
-                float L2 = (float)smp[i + 2] * scale16;
-                float L3 = (float)smp[i + 3] * scale16;
-                float R0 = L0, R1 = L1, R2 = L2, R3 = L3;
-                
-                dsp.processStereo(L0, R0);
-                dsp.processStereo(L1, R1);
-                dsp.processStereo(L2, R2);
-                dsp.processStereo(L3, R3);
-                
-                m_dspOut[2 * i + 0] = (int32_t)(L0 * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R0 * scaleOut);
-                m_dspOut[2 * (i + 1) + 0] = (int32_t)(L1 * scaleOut);
-                m_dspOut[2 * (i + 1) + 1] = (int32_t)(R1 * scaleOut);
-                m_dspOut[2 * (i + 2) + 0] = (int32_t)(L2 * scaleOut);
-                m_dspOut[2 * (i + 2) + 1] = (int32_t)(R2 * scaleOut);
-                m_dspOut[2 * (i + 3) + 0] = (int32_t)(L3 * scaleOut);
-                m_dspOut[2 * (i + 3) + 1] = (int32_t)(R3 * scaleOut);
+    // Journal entry (APP_GLITCH_JOURNAL) and capture marker for a glitch,
+    // with the depth it hit
+    void noteGlitch(GlitchType type) {
+#if APP_GLITCH_JOURNAL
+        GlitchJournal::getInstance().record(type, getBufferedMs());
+#endif
+        captureMark(type);
+    }
+
+    // Marker in the PCM capture (APP_PCM_CAPTURE); an underrun or a
+    // deadline miss also freezes it
+    void captureMark(uint8_t type) {
+#if APP_PCM_CAPTURE
+        PcmCapture::getInstance().mark(type, getBufferedMs());
+#else
+        (void)type;
+#endif
+    }
+
+    // Point m_dspOut at a free slot. With every slot pending, sleep on the
+    // DMA's on_sent event until the oldest one has been taken.
+    void acquireSlot(I2SOutput &i2s) {
+#if APP_POWER_SAVE
+        m_idleSinceMs = 0;
+        if (m_i2sParked) {
+            i2s.start();
+            m_i2sParked = false;
+        }
+#endif
+        while (!pumpOutput(i2s) && m_slotPending == APP_I2S_OUT_SLOTS) {
+            if (!i2s.waitSent(pdMS_TO_TICKS(100))) {
+                // DMA not draining (stopped / reconfiguring): drop the oldest
+                m_slotHead = (uint8_t)((m_slotHead + 1) % APP_I2S_OUT_SLOTS);
+                m_slotPending--;
+                m_shortWriteCount++;
+                noteGlitch(GLITCH_SHORT_WRITE);
+                break;
             }
-            // Handle remaining samples
-            for (; i < frames; i++) {
-                float L = (float)smp[i] * scale16;
-                float R = L;
-                dsp.processStereo(L, R);
-                m_dspOut[2 * i + 0] = (int32_t)(L * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R * scaleOut);
+        }
+        m_dspOut = slotBuf((uint8_t)((m_slotHead + m_slotPending) % APP_I2S_OUT_SLOTS));
+    }
+
+    // Input wait with nothing playing. With power save: long, and I2S is
+    // parked once nothing has been output for APP_POWER_I2S_PARK_MS.
+    TickType_t idleWait(I2SOutput &i2s, const SpscRing &ring) {
+#if APP_POWER_SAVE
+        if (m_slotPending == 0 && ring.empty()) {
+            const uint32_t nowMs = millis32();
+            if (m_idleSinceMs == 0) {
+                m_idleSinceMs = nowMs | 1u;     // 0 means "not idle"
+            } else if (!m_i2sParked && nowMs - m_idleSinceMs >= APP_POWER_I2S_PARK_MS) {
+                i2s.stop();
+                m_i2sParked = true;
+                logEvent(EV_I2S_PARKED);
             }
+            return pdMS_TO_TICKS(APP_AUDIO_IDLE_WAIT_MS);
+        }
+        m_idleSinceMs = 0;
+#else
+        (void)i2s;
+        (void)ring;
+#endif
+        return pdMS_TO_TICKS(20);
+    }
+
+    // Consumer side of clear() for a stream end: pending output slots
+    // are kept
+    void flushKeepingOutput() {
+        m_flushKeepsOutput = true;
+        clear();
+    }
+
+    // A short ramp from the last sample sent down to zero, queued after
+    // it. Not while sync taps count output frames.
+    void appendTail(I2SOutput &i2s) {
+        if ((m_tailL == 0 && m_tailR == 0) || m_blockTap || m_syncTarget || m_outputTap) return;
+        acquireSlot(i2s);
+        const float step = 1.0f / (float)TAIL_FRAMES;
+        for (uint32_t i = 0; i < TAIL_FRAMES; i++) {
+            const float g = 1.0f - (float)(i + 1) * step;
+            m_dspOut[2 * i + 0] = (int32_t)((float)m_tailL * g);
+            m_dspOut[2 * i + 1] = (int32_t)((float)m_tailR * g);
+        }
+        commitSlot(i2s, TAIL_FRAMES);
+        m_tailL = 0;
+        m_tailR = 0;
+    }
+
+    // Handoff ramps on the block in m_dspOut: down once fadeOut() asked
+    // (silent after that), up on the first block after a flush
+    void applyFade(uint32_t frames) {
+        if (m_fade == FADE_MUTED) {
+            memset(m_dspOut, 0, frames * 2 * sizeof(int32_t));
+            return;
+        }
+        const bool down = m_fadeOutRequest.exchange(false);
+        m_fade = down ? FADE_MUTED : FADE_NONE;
+        if (frames == 0) return;
+        const float step = 1.0f / (float)frames;
+        for (uint32_t i = 0; i < frames; i++) {
+            const float g = down ? 1.0f - (float)i * step : (float)i * step;
+            m_dspOut[2 * i + 0] = (int32_t)((float)m_dspOut[2 * i + 0] * g);
+            m_dspOut[2 * i + 1] = (int32_t)((float)m_dspOut[2 * i + 1] * g);
+        }
+    }
+
+    // Copy the picked channel over the other one (interleaved stereo)
+    template <typename T>
+    void pickChannel(T *buf, uint32_t frames) const {
+        const uint32_t from = m_channelPick == PICK_RIGHT ? 1 : 0;
+        for (uint32_t i = 0; i < frames; i++) {
+            buf[2 * i + (from ^ 1)] = buf[2 * i + from];
+        }
+    }
+
+    // Follower start gate: wait for the head record's frame to come due at
+    // the DAC, pad the last stretch with silence so it lands on time, and
+    // drop records that are already late. True once output may start.
+    bool syncStart(I2SOutput &i2s, SpscRing &ring) {
+        m_drift.restart();
+        uint32_t len = 0;
+        uint8_t fmt = SAMPLE_FMT_S16;
+        uint8_t channels = 2;
+        const uint8_t *record = peekRecord(ring, len, fmt, channels);
+        const int64_t due = record ? m_syncTarget(m_syncCtx, m_outFrames) : SYNC_UNKNOWN;
+        const uint32_t rate = i2s.getSampleRate();
+        if (due == SYNC_UNKNOWN || rate == 0) {
+            ring.waitForWrite(idleWait(i2s, ring));
+            return false;
+        }
+        const uint32_t bytesPerFrame = sampleFmtBytes(fmt) * (channels ? channels : 2u);
+        const uint32_t frames = len / bytesPerFrame;
+        const int64_t leadUs = due - esp_timer_get_time() - (int64_t)outputDelayUs(i2s, 0);
+        const int64_t leadFrames = leadUs * rate / 1000000;
+
+        if (leadFrames + (int64_t)frames < 0) {
+            // Already past: skip it, as if played
+            m_jitter.onConsumed(len);
+            consumeRecord(ring, len, true);
+            m_outFrames += frames;
+            return false;
+        }
+        if (leadFrames > APP_DSP_OUT_FRAMES) {
+            ring.waitForWrite(pdMS_TO_TICKS(leadUs / 2000) + 1);
+            return false;
+        }
+        if (leadFrames > 0) {
+            acquireSlot(i2s);
+            memset(m_dspOut, 0, (size_t)leadFrames * 2 * sizeof(int32_t));
+            commitSlot(i2s, (uint32_t)leadFrames);
+        }
+        // Up to one record late at most; the slips take the rest
+        m_jitter.startPlaying();
+        return true;
+    }
+
+    // A block was committed whose last frame is heard at endUs: report its
+    // first frame (master) or how late it runs (follower)
+    void syncBlock(const I2SOutput &i2s, uint32_t frameIndex, uint32_t frames, int64_t endUs) {
+        const uint32_t rate = i2s.getSampleRate();
+        if (rate == 0) return;
+        const int64_t exitUs = endUs - (int64_t)frames * 1000000 / rate;
+        if (m_blockTap) m_blockTap(m_syncCtx, frameIndex, exitUs);
+        if (m_syncTarget) {
+            const int64_t due = m_syncTarget(m_syncCtx, frameIndex);
+            if (due != SYNC_UNKNOWN) m_jitter.setSyncErrorUs((int32_t)(exitUs - due));
+        }
+    }
+
+    // One block of overlay audio over silence, when there is no BT input
+    bool mixOverlayAlone(I2SOutput &i2s) {
+        if (!m_overlayMixer) return false;
+        size_t frames = m_overlayMixer->getFramesAvailable();
+        if (frames == 0) return false;
+        if (frames > APP_DSP_OUT_FRAMES) frames = APP_DSP_OUT_FRAMES;
+        acquireSlot(i2s);
+        memset(m_dspOut, 0, frames * 2 * sizeof(int32_t));
+        m_overlayMixer->mixIntoOutput(m_dspOut, frames);
+        commitSlot(i2s, frames);
+        m_drift.restart();
+        m_tailL = 0;
+        m_tailR = 0;
+        return true;
+    }
+
+#if APP_CODEC_BRIDGE
+    // Flush with a bridge request: the records still queued move to the
+    // bridge as Q31 stereo, as much as it holds. Not while sync taps count
+    // frames, nor after fadeOut() silenced the stream.
+    bool holdStream(uint32_t rate) {
+        SpscRing *ring = m_ring.load(std::memory_order_relaxed);
+        if (!ring || m_fade == FADE_MUTED || m_blockTap || m_syncTarget || m_outputTap) return false;
+        m_bridge.begin(rate);
+        uint32_t len = 0;
+        uint8_t fmt = SAMPLE_FMT_S16;
+        uint8_t channels = 2;
+        const uint8_t *record;
+        while ((record = peekRecord(*ring, len, fmt, channels)) != nullptr) {
+            uint32_t room = 0;
+            int32_t *dst = m_bridge.space(room);
+            uint32_t frames = len / (sampleFmtBytes(fmt) * (channels ? channels : 2u));
+            if (frames > room) frames = room;
+            convertBlock<int32_t>(fmt, channels ? channels : 2u, record, dst, frames);
+            m_bridge.commit(frames);
+            consumeRecord(*ring, len, true);
+            if (frames == room) break;
+        }
+        if (m_bridge.live()) logEvent(EV_STREAM_BRIDGED, m_bridge.remainingMs(), rate);
+        return m_bridge.live();
+    }
+
+    // Rate the output runs at ahead of any conversion: what the bridge
+    // renders to
+    uint32_t bridgeOutRate(const I2SOutput &i2s) const {
+#if APP_I2S_FIXED_RATE
+        (void)i2s;
+        return m_resampler.inRate();
+#else
+        return i2s.getSampleRate();
+#endif
+    }
+
+    // Bridge block in m_floatBuf through the DSP into m_dspOut, as on the
+    // float path
+    void processBridge(DSPProcessor &dsp, uint32_t frames) {
+        if (m_channelPick != PICK_STEREO) pickChannel(m_floatBuf, frames);
+        if (!m_dspEnabled) {
+            floatToOut(m_floatBuf, frames);
+            return;
+        }
+        dsp.processBlock(m_floatBuf, m_floatBuf, frames);
+        if (dsp.isIdle()) {
+            memset(m_dspOut, 0, frames * 2 * sizeof(int32_t));
         } else {
-            // Stereo path - unrolled
-            for (; i < unrollEnd; i += 4) {
-                float L0 = (float)smp[(i) * 2 + 0] * scale16;
-                float R0 = (float)smp[(i) * 2 + 1] * scale16;
-                float L1 = (float)smp[(i + 1) * 2 + 0] * scale16;
-                float R1 = (float)smp[(i + 1) * 2 + 1] * scale16;
-                float L2 = (float)smp[(i + 2) * 2 + 0] * scale16;
-                float R2 = (float)smp[(i + 2) * 2 + 1] * scale16;
-                float L3 = (float)smp[(i + 3) * 2 + 0] * scale16;
-                float R3 = (float)smp[(i + 3) * 2 + 1] * scale16;
-                
-                dsp.processStereo(L0, R0);
-                dsp.processStereo(L1, R1);
-                dsp.processStereo(L2, R2);
-                dsp.processStereo(L3, R3);
-                
-                m_dspOut[2 * i + 0] = (int32_t)(L0 * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R0 * scaleOut);
-                m_dspOut[2 * (i + 1) + 0] = (int32_t)(L1 * scaleOut);
-                m_dspOut[2 * (i + 1) + 1] = (int32_t)(R1 * scaleOut);
-                m_dspOut[2 * (i + 2) + 0] = (int32_t)(L2 * scaleOut);
-                m_dspOut[2 * (i + 2) + 1] = (int32_t)(R2 * scaleOut);
-                m_dspOut[2 * (i + 3) + 0] = (int32_t)(L3 * scaleOut);
-                m_dspOut[2 * (i + 3) + 1] = (int32_t)(R3 * scaleOut);
-            }
-            // Handle remaining samples
-            for (; i < frames; i++) {
-                float L = (float)smp[i * channels + 0] * scale16;
-                float R = (float)smp[i * channels + 1] * scale16;
-                dsp.processStereo(L, R);
-                m_dspOut[2 * i + 0] = (int32_t)(L * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R * scaleOut);
+            floatToOut(m_floatBuf, frames);
+        }
+    }
+
+    // One block of the bridge, out like a stream block; the tail ramp
+    // follows the last. False once there is nothing left.
+    bool playBridge(DSPProcessor &dsp, I2SOutput &i2s) {
+        if (m_blockTap || m_syncTarget || m_outputTap) {
+            m_bridge.clear();       // Taps count stream frames only
+            return false;
+        }
+#if APP_I2S_FIXED_RATE
+        const uint32_t maxFrames = m_maxInFrames;
+#else
+        const uint32_t maxFrames = APP_DSP_OUT_FRAMES;
+#endif
+        acquireSlot(i2s);
+        // The DMA restarted on silence since the last block: ramp in
+        if (i2s.getRestarts() != m_outRestarts) m_fade = FADE_IN;
+        uint32_t frames = m_bridge.render(m_floatBuf, maxFrames, bridgeOutRate(i2s));
+        if (frames == 0) return false;
+        processBridge(dsp, frames);
+#if APP_I2S_FIXED_RATE
+        frames = convertRate(frames);
+#endif
+        if (m_fade != FADE_NONE || m_fadeOutRequest.load(std::memory_order_relaxed)) {
+            applyFade(frames);
+            if (m_fade == FADE_MUTED) m_bridge.clear();     // fadeOut() silences it too
+        }
+        if (m_overlayMixer) m_overlayMixer->mixIntoOutput(m_dspOut, frames);
+        if (frames > 0) {
+            m_tailL = m_dspOut[2 * (frames - 1)];
+            m_tailR = m_dspOut[2 * (frames - 1) + 1];
+        }
+        commitSlot(i2s, frames);
+        m_drift.restart();
+        m_writeCount++;
+        m_lastProcessMs = millis32();
+        if (!m_bridge.live()) appendTail(i2s);
+        return true;
+    }
+
+    // The bridge's next frames, through the DSP, into its mix buffer for
+    // the new stream's first block (silence past its end). Runs before
+    // that block is converted: m_floatBuf and the slot are free.
+    void renderBridgeMix(DSPProcessor &dsp, I2SOutput &i2s, uint32_t frames) {
+        const uint32_t n = m_bridge.render(m_floatBuf, frames, bridgeOutRate(i2s));
+        memset(m_floatBuf + 2 * n, 0, (size_t)(frames - n) * 2 * sizeof(float));
+        processBridge(dsp, frames);
+        memcpy(m_bridge.mixBuffer(), m_dspOut, (size_t)frames * 2 * sizeof(int32_t));
+    }
+
+    // The new stream's first block (in m_dspOut) rises as the bridge falls
+    void crossfadeBridge(uint32_t frames) {
+        const int32_t *old = m_bridge.mixBuffer();
+        const float step = 1.0f / (float)frames;
+        for (uint32_t i = 0; i < frames; i++) {
+            const float g = (float)i * step;
+            for (uint32_t c = 0; c < 2; c++) {
+                const float o = (float)old[2 * i + c];
+                m_dspOut[2 * i + c] = (int32_t)(o + ((float)m_dspOut[2 * i + c] - o) * g);
             }
         }
+        m_bridge.clear();
     }
+#endif
 
-    void process32bitFast(const uint8_t *data, uint32_t frames, uint8_t channels, DSPProcessor &dsp) {
-        const int32_t *smp = (const int32_t *)data;
-        constexpr float scale32 = 1.0f / 2147483648.0f;
+    // Queue the Q31 block (frames long) in the slot m_dspOut points at and
+    // push what fits right away. A 16-bit port gets it packed to S16 in the
+    // slot. stampUs/rtpTs tag its first frame for the latency probe (0 = none).
+    void commitSlot(I2SOutput &i2s, uint32_t frames, uint32_t stampUs = 0, uint32_t rtpTs = 0) {
+        uint8_t idx = (uint8_t)((m_slotHead + m_slotPending) % APP_I2S_OUT_SLOTS);
+#if APP_AUX_OUTPUT
+        // Mains and aux from the block as it will be heard; the crossover
+        // is only redesigned when the I2S rate changes
+        const uint16_t layout = m_pendingLayout.exchange(LAYOUT_NONE, std::memory_order_relaxed);
+        if (layout != LAYOUT_NONE) m_outMatrix.setLayout((OutputRole)(layout >> 8), (OutputRole)(layout & 0xFF));
+        const uint32_t rate = i2s.getSampleRate();
+        if (rate != m_outMatrix.getSampleRate()) m_outMatrix.configure(rate, APP_SUB_CROSSOVER_FREQ);
+        m_outMatrix.process(slotBuf(idx), auxSlotBuf(idx), frames);
+#if APP_I2S_OUT_BITS == 16
+        m_packer.pack(auxSlotBuf(idx), frames * 2);
+#endif
+        m_slots[idx].auxOffset = 0;
+#endif
+#if APP_I2S_OUT_BITS == 16
+        m_packer.pack(slotBuf(idx), frames * 2);
+#endif
+        m_slots[idx].bytes = frames * I2SOutput::FRAME_BYTES;
+        m_slots[idx].offset = 0;
+        m_slots[idx].stampUs = stampUs;
+        m_slots[idx].rtpTs = rtpTs;
+#if APP_AUDIO_LATENCY_PROBE
+        m_slots[idx].commitUs = stampUs ? (uint32_t)esp_timer_get_time() : 0;
+#endif
+        m_slotPending++;
+#if APP_CODEC_BRIDGE
+        m_outRestarts = i2s.getRestarts();
+#endif
+        pumpOutput(i2s);
+    }
+
+    // Processed float block -> Q31 output block
+    void floatToOut(const float *f, uint32_t frames) {
         constexpr float scaleOut = 2147483647.0f;
-        
-        // Process in blocks of 4 samples to reduce loop overhead
-        uint32_t i = 0;
-        const uint32_t unrollEnd = frames & ~3u;  // Round down to multiple of 4
-        
-        if (channels == 1) {
-            // Mono path - unrolled
-            for (; i < unrollEnd; i += 4) {
-                float L0 = (float)smp[i] * scale32;
-                float L1 = (float)smp[i + 1] * scale32;
-                float L2 = (float)smp[i + 2] * scale32;
-                float L3 = (float)smp[i + 3] * scale32;
-                float R0 = L0, R1 = L1, R2 = L2, R3 = L3;
-                
-                dsp.processStereo(L0, R0);
-                dsp.processStereo(L1, R1);
-                dsp.processStereo(L2, R2);
-                dsp.processStereo(L3, R3);
-                
-                m_dspOut[2 * i + 0] = (int32_t)(L0 * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R0 * scaleOut);
-                m_dspOut[2 * (i + 1) + 0] = (int32_t)(L1 * scaleOut);
-                m_dspOut[2 * (i + 1) + 1] = (int32_t)(R1 * scaleOut);
-                m_dspOut[2 * (i + 2) + 0] = (int32_t)(L2 * scaleOut);
-                m_dspOut[2 * (i + 2) + 1] = (int32_t)(R2 * scaleOut);
-                m_dspOut[2 * (i + 3) + 0] = (int32_t)(L3 * scaleOut);
-                m_dspOut[2 * (i + 3) + 1] = (int32_t)(R3 * scaleOut);
-            }
-            // Handle remaining samples
-            for (; i < frames; i++) {
-                float L = (float)smp[i] * scale32;
-                float R = L;
-                dsp.processStereo(L, R);
-                m_dspOut[2 * i + 0] = (int32_t)(L * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R * scaleOut);
-            }
-        } else {
-            // Stereo path - unrolled
-            for (; i < unrollEnd; i += 4) {
-                float L0 = (float)smp[(i) * 2 + 0] * scale32;
-                float R0 = (float)smp[(i) * 2 + 1] * scale32;
-                float L1 = (float)smp[(i + 1) * 2 + 0] * scale32;
-                float R1 = (float)smp[(i + 1) * 2 + 1] * scale32;
-                float L2 = (float)smp[(i + 2) * 2 + 0] * scale32;
-                float R2 = (float)smp[(i + 2) * 2 + 1] * scale32;
-                float L3 = (float)smp[(i + 3) * 2 + 0] * scale32;
-                float R3 = (float)smp[(i + 3) * 2 + 1] * scale32;
-                
-                dsp.processStereo(L0, R0);
-                dsp.processStereo(L1, R1);
-                dsp.processStereo(L2, R2);
-                dsp.processStereo(L3, R3);
-                
-                m_dspOut[2 * i + 0] = (int32_t)(L0 * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R0 * scaleOut);
-                m_dspOut[2 * (i + 1) + 0] = (int32_t)(L1 * scaleOut);
-                m_dspOut[2 * (i + 1) + 1] = (int32_t)(R1 * scaleOut);
-                m_dspOut[2 * (i + 2) + 0] = (int32_t)(L2 * scaleOut);
-                m_dspOut[2 * (i + 2) + 1] = (int32_t)(R2 * scaleOut);
-                m_dspOut[2 * (i + 3) + 0] = (int32_t)(L3 * scaleOut);
-                m_dspOut[2 * (i + 3) + 1] = (int32_t)(R3 * scaleOut);
-            }
-            // Handle remaining samples
-            for (; i < frames; i++) {
-                float L = (float)smp[i * channels + 0] * scale32;
-                float R = (float)smp[i * channels + 1] * scale32;
-                dsp.processStereo(L, R);
-                m_dspOut[2 * i + 0] = (int32_t)(L * scaleOut);
-                m_dspOut[2 * i + 1] = (int32_t)(R * scaleOut);
-            }
+        const uint32_t n = frames * 2;
+        for (uint32_t i = 0; i < n; i++) {
+            m_dspOut[i] = (int32_t)(f[i] * scaleOut);
         }
     }
 
-    QueueHandle_t m_audioQueue;
-    QueueHandle_t m_freeQueue;
-    AudioBuf *m_pool;
-    int32_t *m_dspOut;
-    uint8_t *m_stagingBuf;  // Internal RAM staging buffer for fast DSP input
+#if APP_I2S_FIXED_RATE
+    // Stream rate -> fixed I2S rate on the block in m_dspOut. The block is
+    // moved to m_floatBuf first (the DSP is done with it) and converted
+    // back into the slot; returns the new frame count.
+    uint32_t convertRate(uint32_t frames) {
+        if (m_resampler.passthrough()) return frames;
+        constexpr float scaleIn = 1.0f / 2147483648.0f;
+        const uint32_t n = frames * 2;
+        for (uint32_t i = 0; i < n; i++) {
+            m_floatBuf[i] = (float)m_dspOut[i] * scaleIn;
+        }
+        return (uint32_t)m_resampler.process(m_floatBuf, frames, 2, 1.0f, m_dspOut,
+                                             APP_DSP_SLOT_FRAMES, 2147483647.0f);
+    }
+#endif
+
+    SpscRing m_bulkRing;    // Full-size BT callback -> audio_tx ring (PSRAM if present)
+    SpscRing m_fastRing;    // Optional internal RAM ring for low-bitrate streams
+#if APP_STATIC_ALLOCATION
+    uint8_t* m_fastStatic = nullptr;    // Its arena block
+#endif
+    uint8_t* m_bulkHeap = nullptr;      // Placed storage of the rings (heap builds)
+    uint8_t* m_fastHeap = nullptr;
+    std::atomic<bool> m_fastHeld{false};        // Released for memory pressure until restored
+    std::atomic<bool> m_fastParked{false};      // Released for a high-bitrate codec
+    std::atomic<bool> m_streamLowRate{true};    // Current stream could use the fast ring
+    uint32_t m_streamBpf = 4;                   // Current stream, for placeFastRing()
+    uint32_t m_streamTargetMs = 0;
+    std::atomic<SpscRing*> m_ring{nullptr};         // Ring in use, switched by the consumer
+    std::atomic<SpscRing*> m_pendingRing{nullptr};  // Requested by setStreamFormat()
+    bool m_bulkInPsram = false;
+    std::atomic<bool> m_flushRequest{false};
+    std::atomic<uint8_t> m_fastRingOp{FAST_RING_NONE};  // releaseFastRing()/restoreFastRing()
+    std::atomic<bool> m_producerBusy{false};            // Inside enqueue(), or a buffer is lent
+#if APP_AUDIO_DECODE_IN_PLACE
+    const uint8_t* m_lent = nullptr;    // Producer: buffer lendPcmBuffer() gave the decoder
+    SpscRing* m_lentRing = nullptr;
+    uint32_t m_lentSize = 0;
+#endif
+#if APP_AUDIO_PULL_DECODE
+    static constexpr int PULL_MAX_CALLS = 4;    // Decoder calls per pullDecode()
+    PullSource m_pull = {};
+    bool m_pulling = false;                     // Consumer: inside m_pull.decode()
+    std::atomic<uint32_t> m_pullPacketBytes{0}; // PCM per packet (smoothed), 0 = not known yet
+#endif
+    bool m_fastRetiring = false;    // Consumer: fast ring drains out before it is freed
+    struct OutSlot {
+        uint32_t bytes;     // Block size queued for I2S (port width)
+        uint32_t offset;    // Bytes already taken by the DMA
+        uint32_t stampUs;   // Arrival time of the first frame, 0 = not probed
+        uint32_t rtpTs;
+        uint32_t commitUs;  // When it was queued, for probed slots
+#if APP_AUX_OUTPUT
+        uint32_t auxOffset; // Aux slot bytes already taken
+#endif
+    };
+
+    int32_t *m_dspOut;      // Slot the DSP is filling
+    int32_t *m_outSlots;    // APP_I2S_OUT_SLOTS blocks of APP_DSP_SLOT_WORDS
+    OutSlot m_slots[APP_I2S_OUT_SLOTS];
+    uint8_t m_slotHead;     // Oldest pending slot (audio task only)
+    uint8_t m_slotPending;  // Slots queued but not yet fully taken
+    float *m_floatBuf;      // Internal RAM float block for DSPProcessor::processBlock
+#if APP_AUX_OUTPUT
+    int32_t *m_auxSlots = nullptr;  // Aux port block per slot, APP_DSP_SLOT_WORDS each
+    OutputMatrix m_outMatrix;       // Consumer: aux fan-out in commitSlot()
+    static constexpr uint16_t LAYOUT_NONE = 0xFFFF;
+    std::atomic<uint16_t> m_pendingLayout{LAYOUT_NONE};    // setOutputLayout(), left << 8 | right
+#endif
+#if APP_I2S_OUT_BITS == 16
+    S16Packer m_packer;             // Consumer: Q31 -> S16 in commitSlot()
+#endif
 
     volatile uint32_t m_dropCount;
+    std::atomic<uint32_t> m_droppedFrames{0};   // Producer: frames lost to a full ring
+    uint32_t m_recordOffset = 0;                // Consumer: bytes of the oldest record already processed
     volatile uint32_t m_enqueueFail;
     volatile uint32_t m_shortWriteCount;
     volatile uint32_t m_writeCount;
     volatile uint32_t m_lastProcessMs;
     
-    ShouldSkipWriteCallback m_skipWriteCallback;
-    bool m_wasSkipping;  // Track state transition for DMA clearing
     volatile bool m_audioActive;  // Track if audio is actively streaming
     
     OverlayMixer* m_overlayMixer;  // For mixing sound effects with BT audio
+    JitterBuffer m_jitter;         // Target-depth latency manager
+    DriftEstimator m_drift;        // Source/I2S clock drift -> APLL trim
+    StageLoad m_load[STAGE_COUNT]; // Busy time per stage (APP_AUDIO_LOAD_REPORT)
+#if APP_AUDIO_PERF_TRACE
+    PerfTrace m_trace;             // Cycle histograms (APP_AUDIO_PERF_TRACE)
+#endif
+#if APP_DEADLINE_MONITOR
+    DeadlineMonitor m_deadline{CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ};
+#endif
+    LatencyProbe m_latency;        // Enqueue-to-DMA-exit (APP_AUDIO_LATENCY_PROBE)
+#if APP_I2S_FIXED_RATE
+    PolyphaseResampler m_resampler;            // Stream -> I2S rate (audio task)
+    std::atomic<uint32_t> m_pendingRate{0};    // Set by setStreamFormat()
+    uint32_t m_maxInFrames = APP_DSP_OUT_FRAMES;
+#endif
+#if APP_CODEC_BRIDGE
+    StreamBridge m_bridge;                      // Audio task, apart from ready()/live()
+    std::atomic<uint32_t> m_bridgeRate{0};      // bridgeStream(): rate of the stream to hold
+    uint32_t m_outRestarts = 0;                 // Consumer: DMA restarts at the last commit
+    static constexpr uint32_t BRIDGE_HANDOFF_MS = 20;  // Left in the bridge when pre-roll may cut short
+#endif
+    uint32_t m_nextStampUs;        // Producer: stamp for the next record
+    uint32_t m_nextRtpTs;
+    uint32_t m_probeStampUs;       // Consumer: stamp of the frame being probed
+    uint32_t m_probeRtpTs;
+    uint32_t m_probeCommitUs;      // Consumer: commit time of the slot being probed
+    uint32_t m_outputDelayUs;      // Consumer: smoothed commit-to-exit, 0 = not measured
+    std::atomic<uint32_t> m_inFrames{0};   // Producer: index of the next frame written
+    uint32_t m_outFrames = 0;      // Consumer: index of the next frame read
+    volatile uint32_t m_streamRate = APP_I2S_DEFAULT_SR;   // Input rate (PCM capture)
+    InputTap m_inputTap = nullptr; // Multi-room sync hooks (sync_link.h)
+    BlockTap m_blockTap = nullptr;
+    SyncTarget m_syncTarget = nullptr;
+    void* m_syncCtx = nullptr;
+    volatile ChannelPick m_channelPick = PICK_STEREO;
+    OutputTap m_outputTap = nullptr;
+    uint32_t m_outputFrames = 0;   // Consumer: output frames queued (relay index)
+    volatile bool m_dspEnabled = true;
+    enum : uint8_t { FADE_NONE, FADE_IN, FADE_MUTED };
+    uint8_t m_fade = FADE_NONE;    // Consumer: handoff ramp state
+    std::atomic<bool> m_fadeOutRequest{false};
+    std::atomic<bool> m_endRequest{false};  // endStream(), taken by the consumer
+    bool m_endFlush = false;       // Consumer: flush once the fade-out block is done
+    bool m_flushKeepsOutput = false;    // Consumer: next flush keeps pending slots
+    // Consumer: last frame committed, the start of the tail ramp
+    int32_t m_tailL = 0;
+    int32_t m_tailR = 0;
+    // Tail ramp length (~3 ms at 44.1 kHz)
+    static constexpr uint32_t TAIL_FRAMES = 128;
+    static_assert(TAIL_FRAMES <= APP_DSP_SLOT_FRAMES, "tail ramp must fit an output slot");
+#if APP_POWER_SAVE
+    uint32_t m_idleSinceMs = 0;    // Consumer: start of the idle stretch, 0 = busy
+    bool m_i2sParked = false;      // Consumer: I2S stopped by idleWait()
+#endif
 };
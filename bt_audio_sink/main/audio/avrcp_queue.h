@@ -0,0 +1,146 @@
+#pragma once
+
+/*
+ * avrcp_queue.h
+ *
+ * AVRCP commands to the phone off the caller's task (APP_AVRCP_QUEUE). The
+ * library's play()/pause()/next() send the press, sleep 100 ms and send the
+ * release in whatever task calls them, so a knob click used to freeze the
+ * encoder task for that long. Here input tasks only queue, and one avrcp
+ * task sends each press/release pair, paced, in order.
+ *
+ * Volume is not a command: setVolume() keeps the latest absolute level and
+ * the task hands it to the sink (the AVRCP volume-change notification) at
+ * most every APP_AVRCP_VOLUME_INTERVAL_MS. A fast turn of the knob becomes
+ * a few absolute updates the phone can follow, always ending on the level
+ * the knob stopped at, rather than one notification per detent.
+ *
+ * send() and setVolume(): any task, never an ISR; neither blocks. The done
+ * callback runs on the avrcp task once the release went out (or the
+ * command could not be sent).
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_avrc_api.h"
+#include "esp_log.h"
+#include "BluetoothA2DPSink.h"
+#include "../config/app_config.h"
+#include "../core/static_alloc.h"
+
+class AvrcpQueue {
+public:
+    typedef void (*DoneCb)(uint8_t cmd, bool ok);
+
+    static constexpr int DEPTH = 8;
+    static constexpr uint32_t STACK_BYTES = 3072;
+    static constexpr uint32_t PRESS_MS = 100;   // Press to release, as the library holds it
+    static constexpr uint32_t GAP_MS = 50;      // Release to the next press
+
+    // Once at boot, after the sink is set up
+    bool begin(BluetoothA2DPSink& sink, UBaseType_t prio, BaseType_t core) {
+        m_sink = &sink;
+        m_queue = xQueueCreateStatic(DEPTH, sizeof(Item), m_storage, &m_queueBuf);
+        return StaticAlloc::createTask(queueTask, "avrcp", STACK_BYTES, this, prio, &m_task, core) == pdPASS;
+    }
+
+    // Queue a passthrough command (ESP_AVRC_PT_CMD_*). False, without a
+    // callback, when the queue is full.
+    bool send(uint8_t cmd, DoneCb done = nullptr) {
+        Item item = { done, cmd };
+        if (!m_queue || xQueueSend(m_queue, &item, 0) != pdTRUE) {
+            ESP_LOGW(TAG, "Queue full, command 0x%02X dropped", cmd);
+            return false;
+        }
+        xTaskNotifyGive(m_task);
+        return true;
+    }
+
+    // Absolute volume (0-127) for the phone; replaces one not sent yet
+    void setVolume(uint8_t volume) {
+        m_volume.store(volume > 127 ? 127 : volume, std::memory_order_relaxed);
+        if (m_task) xTaskNotifyGive(m_task);
+    }
+
+private:
+    static constexpr const char* TAG = "AVRCP";
+    static constexpr int16_t NO_VOLUME = -1;
+
+    struct Item {
+        DoneCb done;
+        uint8_t cmd;
+    };
+
+    static void queueTask(void* param) {
+        static_cast<AvrcpQueue*>(param)->run();
+    }
+
+    void run() {
+        TickType_t wait = portMAX_DELAY;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, wait);
+            wait = portMAX_DELAY;
+
+            // Volume first: a command holds the task for PRESS_MS + GAP_MS
+            const int16_t volume = m_volume.load(std::memory_order_relaxed);
+            if (volume != NO_VOLUME) {
+                const TickType_t now = xTaskGetTickCount();
+                const TickType_t interval = pdMS_TO_TICKS(APP_AVRCP_VOLUME_INTERVAL_MS);
+                if (m_volumeSent && now - m_lastVolume < interval) {
+                    wait = interval - (now - m_lastVolume);
+                } else {
+                    int16_t expected = volume;
+                    m_volume.compare_exchange_strong(expected, NO_VOLUME, std::memory_order_relaxed);
+                    m_sink->set_volume((uint8_t)volume);
+                    m_lastVolume = now;
+                    m_volumeSent = true;
+                }
+            }
+
+            // One command per pass, so a level that came in meanwhile
+            // goes out between commands
+            Item item;
+            if (xQueueReceive(m_queue, &item, 0) == pdTRUE) {
+                const bool ok = press(item.cmd);
+                if (item.done) item.done(item.cmd, ok);
+                vTaskDelay(pdMS_TO_TICKS(GAP_MS));
+                // The take cleared the other commands' notifications
+                if (uxQueueMessagesWaiting(m_queue) > 0) wait = 0;
+            }
+        }
+    }
+
+    bool press(uint8_t cmd) {
+        if (!m_sink->is_avrc_connected()) {
+            ESP_LOGW(TAG, "Command 0x%02X: AVRCP not connected", cmd);
+            return false;
+        }
+        const uint8_t tl = m_label;
+        m_label = (uint8_t)((m_label + 1) & 0x0F);
+        esp_err_t err = esp_avrc_ct_send_passthrough_cmd(tl, cmd, ESP_AVRC_PT_CMD_STATE_PRESSED);
+        if (err == ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(PRESS_MS));
+            err = esp_avrc_ct_send_passthrough_cmd(tl, cmd, ESP_AVRC_PT_CMD_STATE_RELEASED);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Command 0x%02X failed: %s", cmd, esp_err_to_name(err));
+            return false;
+        }
+        return true;
+    }
+
+    BluetoothA2DPSink* m_sink = nullptr;
+    TaskHandle_t m_task = nullptr;
+    QueueHandle_t m_queue = nullptr;
+    StaticQueue_t m_queueBuf;
+    uint8_t m_storage[DEPTH * sizeof(Item)];
+    std::atomic<int16_t> m_volume{NO_VOLUME};
+
+    // avrcp task
+    TickType_t m_lastVolume = 0;
+    bool m_volumeSent = false;
+    uint8_t m_label = 0;        // AVRCP transaction label, 4 bits
+};
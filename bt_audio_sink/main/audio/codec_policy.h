@@ -0,0 +1,247 @@
+#pragma once
+
+/*
+ * codec_policy.h
+ *
+ * Per-peer codec steering from measured link quality. A sink cannot ask the
+ * source for a lower LDAC bitrate, but it decides which of its stream
+ * endpoints each peer gets to see: endpoints declined in
+ * esp_a2d_sink_sep_offer_hook are reported as in use, and the source falls
+ * back to the next codec it supports (LDAC -> aptX HD -> aptX -> ... -> SBC).
+ *
+ * Every stream is scored once it ends, on packet loss (RTP gaps plus packets
+ * the sink dropped), jitter-buffer underruns, arrival jitter and, with a
+ * link monitor, the share of seconds the radio link was degraded. A bad
+ * stream hides its codec from that peer from the next connection on; SBC is
+ * never hidden. After a run of good streams the codec hidden last is offered
+ * again. Records of the most recent peers are kept as one NVS blob.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_a2dp_api.h"
+#include "codec_config/codec_config.h"
+#include "../config/app_config.h"
+
+class CodecPolicy {
+public:
+    static constexpr int MAX_PEERS = 8;
+    static constexpr int MAX_HIDDEN = 7;                // Every codec but SBC
+    static constexpr size_t PEER_BYTES = 6 + 2 + 1 + MAX_HIDDEN + 1;
+    static constexpr size_t BLOB_BYTES = 2 + MAX_PEERS * PEER_BYTES;
+
+    // Sink (BTU task): may this peer see the endpoint of this codec?
+    bool offer(const uint8_t* addr, a2dp_codec_id_t codec) {
+        if (codec == A2DP_CODEC_ID_SBC || codec == A2DP_CODEC_ID_UNKNOWN) return true;
+        bool hidden = false;
+        portENTER_CRITICAL(&m_lock);
+        int i = find(addr);
+        if (i >= 0) hidden = (m_peers[i].hidden & bit(codec)) != 0;
+        portEXIT_CRITICAL(&m_lock);
+        if (hidden) {
+            ESP_LOGI(TAG, "%s hidden from " ESP_BD_ADDR_STR, get_codec_id_name(codec), ESP_BD_ADDR_HEX(addr));
+        }
+        return !hidden;
+    }
+
+    // Codec configured: scores the previous stream and starts a new one
+    void begin(const uint8_t* addr, a2dp_codec_id_t codec, uint32_t underruns) {
+        end();
+        portENTER_CRITICAL(&m_lock);
+        memcpy(m_session.addr, addr, sizeof(m_session.addr));
+        m_session.codec = codec;
+        m_session.underrunsAtStart = underruns;
+        m_session.underruns = underruns;
+        m_session.active = true;
+        portEXIT_CRITICAL(&m_lock);
+    }
+
+    // Stream gone (disconnect or reconfiguration): score it
+    void end() {
+        portENTER_CRITICAL(&m_lock);
+        Session s = m_session;
+        memset(&m_session, 0, sizeof(m_session));
+        portEXIT_CRITICAL(&m_lock);
+        if (!s.active) return;
+
+        if (s.activeSec < APP_CODEC_POLICY_MIN_SESSION_S || s.received == 0) return;
+        const uint32_t lossPermille = (uint32_t)((uint64_t)(s.lost + s.dropped) * 1000 / s.received);
+        const uint32_t underrunsPerMin = (s.underruns - s.underrunsAtStart) * 60 / s.activeSec;
+        const uint32_t jitterMs = (uint32_t)(s.jitterSum / s.activeSec);
+        const uint32_t rfBadPct = s.rfBadSec * 100 / s.activeSec;
+        const bool bad = lossPermille > APP_CODEC_POLICY_LOSS_PERMILLE ||
+                         underrunsPerMin > APP_CODEC_POLICY_UNDERRUNS_PER_MIN ||
+                         jitterMs > APP_CODEC_POLICY_JITTER_MS ||
+                         rfBadPct > APP_CODEC_POLICY_RF_BAD_PCT;
+        ESP_LOGI(TAG, "%s stream from " ESP_BD_ADDR_STR ": %u s, loss %u.%u%%, %u underruns/min, jitter %u ms, "
+                 "RF degraded %u%% -> %s",
+                 get_codec_id_name(s.codec), ESP_BD_ADDR_HEX(s.addr), (unsigned)s.activeSec,
+                 (unsigned)(lossPermille / 10), (unsigned)(lossPermille % 10),
+                 (unsigned)underrunsPerMin, (unsigned)jitterMs, (unsigned)rfBadPct, bad ? "bad" : "good");
+        score(s.addr, s.codec, bad);
+    }
+
+    // Control task, about once a second: latest counters of the stream,
+    // and whether the link monitor found the radio link degraded
+    void sample(const esp_a2d_sink_rx_stats_t& rx, uint32_t underruns, float jitterMs, bool rfDegraded) {
+        portENTER_CRITICAL(&m_lock);
+        Session& s = m_session;
+        // The sink clears its counters on reconfiguration, possibly before
+        // begin() runs for the new codec; keep the last sample of this stream
+        if (s.active && rx.received >= s.received) {
+            if (rx.received > s.received) {
+                s.activeSec++;
+                s.jitterSum += jitterMs;
+                if (rfDegraded) s.rfBadSec++;
+            }
+            s.received = rx.received;
+            s.dropped = rx.dropped;
+            s.lost = rx.lost;
+            if (underruns >= s.underrunsAtStart) s.underruns = underruns;
+        }
+        portEXIT_CRITICAL(&m_lock);
+    }
+
+    // Records changed since the last call (the owner saves the blob)
+    bool takeDirty() {
+        portENTER_CRITICAL(&m_lock);
+        bool dirty = m_dirty;
+        m_dirty = false;
+        portEXIT_CRITICAL(&m_lock);
+        return dirty;
+    }
+
+    // All peers: [version, count, peer...]; returns bytes written (0 if cap too small)
+    size_t serialize(uint8_t* out, size_t cap) {
+        if (cap < BLOB_BYTES) return 0;
+        memset(out, 0, BLOB_BYTES);
+        portENTER_CRITICAL(&m_lock);
+        out[0] = BLOB_VERSION;
+        out[1] = (uint8_t)m_count;
+        for (int i = 0; i < m_count; i++) {
+            const Peer& p = m_peers[i];
+            uint8_t* q = out + 2 + i * PEER_BYTES;
+            memcpy(q, p.addr, 6);
+            q[6] = (uint8_t)p.hidden;
+            q[7] = (uint8_t)(p.hidden >> 8);
+            q[8] = p.depth;
+            memcpy(q + 9, p.order, MAX_HIDDEN);
+            q[9 + MAX_HIDDEN] = p.goodStreak;
+        }
+        portEXIT_CRITICAL(&m_lock);
+        return BLOB_BYTES;
+    }
+
+    // Inverse of serialize; a blob of another version is ignored
+    bool deserialize(const uint8_t* in, size_t len) {
+        if (len < 2 || in[0] != BLOB_VERSION || in[1] > MAX_PEERS ||
+                len < 2 + (size_t)in[1] * PEER_BYTES) {
+            return false;
+        }
+        portENTER_CRITICAL(&m_lock);
+        m_count = in[1];
+        for (int i = 0; i < m_count; i++) {
+            Peer& p = m_peers[i];
+            const uint8_t* q = in + 2 + i * PEER_BYTES;
+            memcpy(p.addr, q, 6);
+            p.hidden = (uint16_t)(q[6] | (q[7] << 8)) & ~bit(A2DP_CODEC_ID_SBC);
+            p.depth = q[8] < MAX_HIDDEN ? q[8] : MAX_HIDDEN;
+            memcpy(p.order, q + 9, MAX_HIDDEN);
+            p.goodStreak = q[9 + MAX_HIDDEN];
+        }
+        portEXIT_CRITICAL(&m_lock);
+        return true;
+    }
+
+    int peerCount() const { return m_count; }
+
+private:
+    static constexpr const char* TAG = "CodecPolicy";
+    static constexpr uint8_t BLOB_VERSION = 1;
+
+    struct Peer {
+        uint8_t addr[6];
+        uint16_t hidden;                // Bit per a2dp_codec_id_t
+        uint8_t depth;                  // Entries in order[]
+        uint8_t order[MAX_HIDDEN];      // Codecs in the order they were hidden
+        uint8_t goodStreak;             // Good streams since the last change
+    };
+
+    struct Session {
+        uint8_t addr[6];
+        a2dp_codec_id_t codec;
+        bool active;
+        uint32_t activeSec;             // Seconds with packets arriving
+        uint32_t received;
+        uint32_t dropped;
+        uint32_t lost;
+        uint32_t underrunsAtStart;
+        uint32_t underruns;
+        float jitterSum;                // Jitter (ms) summed over activeSec
+        uint32_t rfBadSec;              // Of activeSec with the link degraded
+    };
+
+    static uint16_t bit(a2dp_codec_id_t codec) { return (uint16_t)(1u << codec); }
+
+    // Caller holds m_lock
+    int find(const uint8_t* addr) const {
+        for (int i = 0; i < m_count; i++) {
+            if (memcmp(m_peers[i].addr, addr, 6) == 0) return i;
+        }
+        return -1;
+    }
+
+    void score(const uint8_t* addr, a2dp_codec_id_t codec, bool bad) {
+        a2dp_codec_id_t restored = A2DP_CODEC_ID_UNKNOWN;
+        bool hid = false;
+        portENTER_CRITICAL(&m_lock);
+        int i = find(addr);
+        if (i < 0) {
+            if (!bad) {                 // Nothing to remember for a peer doing fine
+                portEXIT_CRITICAL(&m_lock);
+                return;
+            }
+            i = m_count < MAX_PEERS ? m_count++ : MAX_PEERS - 1;   // Oldest goes
+            memset(&m_peers[i], 0, sizeof(Peer));
+            memcpy(m_peers[i].addr, addr, 6);
+        }
+        // Most recent peer first
+        Peer p = m_peers[i];
+        memmove(&m_peers[1], &m_peers[0], i * sizeof(Peer));
+
+        if (bad) {
+            p.goodStreak = 0;
+            if (codec != A2DP_CODEC_ID_SBC && !(p.hidden & bit(codec)) && p.depth < MAX_HIDDEN) {
+                p.hidden |= bit(codec);
+                p.order[p.depth++] = (uint8_t)codec;
+                hid = true;
+            }
+        } else if (p.depth > 0 && ++p.goodStreak >= APP_CODEC_POLICY_REPROBE_STREAK) {
+            restored = (a2dp_codec_id_t)p.order[--p.depth];
+            p.hidden &= ~bit(restored);
+            p.goodStreak = 0;
+        }
+        m_peers[0] = p;
+        m_dirty = true;
+        portEXIT_CRITICAL(&m_lock);
+
+        if (hid) {
+            ESP_LOGW(TAG, "Hiding %s from " ESP_BD_ADDR_STR " from the next connection",
+                     get_codec_id_name(codec), ESP_BD_ADDR_HEX(addr));
+        }
+        if (restored != A2DP_CODEC_ID_UNKNOWN) {
+            ESP_LOGI(TAG, "Offering %s to " ESP_BD_ADDR_STR " again",
+                     get_codec_id_name(restored), ESP_BD_ADDR_HEX(addr));
+        }
+    }
+
+    portMUX_TYPE m_lock = portMUX_INITIALIZER_UNLOCKED;
+    Peer m_peers[MAX_PEERS] = {};
+    int m_count = 0;
+    bool m_dirty = false;
+    Session m_session = {};             // Current stream, also under m_lock
+};
@@ -0,0 +1,252 @@
+#pragma once
+
+/*
+ * deadline_monitor.h
+ *
+ * Per-block deadline check for audio_tx. A block of N output frames at
+ * rate R plays for N/R seconds; converting, running the DSP, mixing and
+ * committing it to I2S has to fit in that (times APP_DEADLINE_BUDGET_PCT,
+ * leaving room for the rest of the core). The work is timed in CPU cycles
+ * from the free slot to the commit, so waiting on the DMA is not counted.
+ *
+ * Blocks and misses are counted per DSP mode (DSPProcessor::activeMode),
+ * so a mode that does not fit at some rate shows up as such. With
+ * APP_DEADLINE_AUTO_SHED, APP_DEADLINE_SHED_MISSES misses within a second
+ * first raise the CPU clock while it is below the top (ClockBoostCallback,
+ * APP_STREAM_CLOCK), then shed the next optional stage still running, in
+ * this order: 3D, analysis,
+ * the limiter's true-peak detection, then (APP_DEADLINE_SHED_DECODER) the
+ * decoder's two complexity steps, which free time on the core the decoder
+ * shares with audio_tx. After APP_DEADLINE_RESTORE_S without a miss the
+ * last one shed comes back; one that misses again within its hold doubles
+ * the hold (up to 16x), so a stage that cannot fit stays off.
+ *
+ * Report (BLE STATUS_DEADLINE), little endian:
+ *   [shed, budget_pct, peak_permille u16, n, {mode, blocks u32, misses u32}...]
+ * shed holds DSPProcessor::ShedStage bits and SHED_DECODE_1/2; peak_permille
+ * is the largest block time seen, per mille of its budget.
+ *
+ * The budget is counted in cycles of the clock setCpuMhz() last passed.
+ *
+ * end() runs on audio_tx only; report() and reset() from any task.
+ */
+
+#include "../config/app_config.h"
+
+#if APP_DEADLINE_MONITOR
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "../dsp/dsp_processor.h"
+
+class DeadlineMonitor {
+public:
+    static constexpr int MODES = 32;        // DSPProcessor::activeMode() values
+    static constexpr uint32_t MAX_HOLD_SHIFT = 4;
+
+    // Shed bits above the DSPProcessor::ShedStage ones
+    static constexpr uint8_t SHED_DECODE_1 = 0x10;
+    static constexpr uint8_t SHED_DECODE_2 = 0x20;
+    static constexpr uint8_t SHED_DSP_MASK = 0x0F;
+
+    // Decoder complexity level to run at, 0 = full (called from audio_tx)
+    typedef void (*DecodeLevelCallback)(uint8_t level);
+    // One CPU clock step up, false at the top (called from audio_tx)
+    typedef bool (*ClockBoostCallback)();
+
+    explicit DeadlineMonitor(uint32_t cpuMhz) : m_cpuMhz(cpuMhz) {}
+
+    // Once at boot, before audio_tx starts; without one the decoder
+    // steps are not part of the ladder
+    void setDecodeLevelCallback(DecodeLevelCallback cb) { m_decodeLevelCb = cb; }
+    // Once at boot, before audio_tx starts; without one misses only shed
+    void setClockBoostCallback(ClockBoostCallback cb) { m_clockBoostCb = cb; }
+
+    // Any task: the CPU clock blocks now run at
+    void setCpuMhz(uint32_t mhz) { m_cpuMhz = mhz; }
+
+    static uint32_t start() { return esp_cpu_get_cycle_count(); }
+
+    // One block of frames at rate done since startCycles; true on a miss
+    bool end(uint32_t startCycles, uint32_t frames, uint32_t rate, DSPProcessor& dsp) {
+        const uint32_t used = esp_cpu_get_cycle_count() - startCycles;
+        if (frames == 0 || rate == 0) return false;
+        if (m_resetRequest.exchange(false, std::memory_order_acquire)) clearStats();
+
+        const uint32_t budget = (uint32_t)((uint64_t)frames * m_cpuMhz * 1000000u / rate *
+                                           APP_DEADLINE_BUDGET_PCT / 100);
+        const uint8_t mode = dsp.activeMode() & (MODES - 1);
+        m_blocks[mode]++;
+        const uint32_t permille = (uint32_t)((uint64_t)used * 1000 / (budget ? budget : 1));
+        if (permille > m_peakPermille) m_peakPermille = permille < 0xFFFF ? permille : 0xFFFF;
+        if (used <= budget) {
+#if APP_DEADLINE_AUTO_SHED
+            if (m_shed != 0) maybeRestore(dsp);
+#endif
+            return false;
+        }
+        m_misses[mode]++;
+#if APP_DEADLINE_AUTO_SHED
+        onMiss(dsp);
+#endif
+        return true;
+    }
+
+    // Zero the counts at the next block
+    void reset() { m_resetRequest.store(true, std::memory_order_release); }
+
+    size_t report(uint8_t* out, size_t cap) const {
+        if (cap < 5) return 0;
+        size_t idx = 0;
+        out[idx++] = m_shed;
+        out[idx++] = APP_DEADLINE_BUDGET_PCT;
+        const uint32_t peak = m_peakPermille;
+        out[idx++] = (uint8_t)peak;
+        out[idx++] = (uint8_t)(peak >> 8);
+        const size_t countAt = idx++;
+        uint8_t n = 0;
+        for (int m = 0; m < MODES && idx + 9 <= cap; m++) {
+            const uint32_t blocks = m_blocks[m];
+            if (blocks == 0) continue;
+            out[idx++] = (uint8_t)m;
+            idx = put32(out, idx, blocks);
+            idx = put32(out, idx, m_misses[m]);
+            n++;
+        }
+        out[countAt] = n;
+        return idx;
+    }
+
+    void log(const char* tag) const {
+        for (int m = 0; m < MODES; m++) {
+            if (m_blocks[m] == 0) continue;
+            ESP_LOGI(tag, "Deadline mode 0x%02x: %u misses in %u blocks", m,
+                     (unsigned)m_misses[m], (unsigned)m_blocks[m]);
+        }
+        ESP_LOGI(tag, "Deadline peak %u.%u%% of budget, shed 0x%02x (decode level %u)",
+                 (unsigned)(m_peakPermille / 10), (unsigned)(m_peakPermille % 10), m_shed,
+                 decodeLevel(m_shed));
+    }
+
+private:
+    static constexpr const char* TAG = "Deadline";
+
+    static uint8_t decodeLevel(uint8_t shed) {
+        return (shed & SHED_DECODE_2) ? 2 : (shed & SHED_DECODE_1) ? 1 : 0;
+    }
+
+    void clearStats() {
+        for (int m = 0; m < MODES; m++) {
+            m_blocks[m] = 0;
+            m_misses[m] = 0;
+        }
+        m_peakPermille = 0;
+    }
+
+#if APP_DEADLINE_AUTO_SHED
+    void onMiss(DSPProcessor& dsp) {
+        const uint32_t nowMs = (uint32_t)(esp_timer_get_time() / 1000);
+        m_lastMissMs = nowMs;
+        if (nowMs - m_windowStartMs > 1000) {
+            m_windowStartMs = nowMs;
+            m_windowMisses = 0;
+        }
+        if (++m_windowMisses < APP_DEADLINE_SHED_MISSES) return;
+        m_windowMisses = 0;
+
+        if (m_clockBoostCb && m_clockBoostCb()) {
+            ESP_LOGW(TAG, "Missing deadlines at %u MHz, raising the clock", (unsigned)m_cpuMhz);
+            return;
+        }
+
+        // Next stage that is still doing work
+        uint8_t stage = 0;
+        if (!(m_shed & DSPProcessor::SHED_3D) && dsp.is3DSoundEnabled()) {
+            stage = DSPProcessor::SHED_3D;
+        } else if (!(m_shed & DSPProcessor::SHED_ANALYSIS) && dsp.isAnalysisEnabled()) {
+            stage = DSPProcessor::SHED_ANALYSIS;
+#if APP_DSP_LIMITER
+        } else if (!(m_shed & DSPProcessor::SHED_TRUE_PEAK)) {
+            stage = DSPProcessor::SHED_TRUE_PEAK;
+#endif
+#if APP_DEADLINE_SHED_DECODER
+        } else if (!(m_shed & SHED_DECODE_1) && m_decodeLevelCb) {
+            stage = SHED_DECODE_1;
+        } else if (!(m_shed & SHED_DECODE_2) && m_decodeLevelCb) {
+            stage = SHED_DECODE_2;
+#endif
+        }
+        if (stage == 0) return;
+
+        // Back too soon after its restore: keep it off longer next time
+        if (stage == m_restored && nowMs - m_restoredMs < holdMs()) {
+            if (m_holdShift < MAX_HOLD_SHIFT) m_holdShift++;
+        } else {
+            m_holdShift = 0;
+        }
+        m_shed |= stage;
+        m_shedOrder[m_shedCount++] = stage;
+        m_restored = 0;
+        apply(dsp);
+        ESP_LOGW(TAG, "Missing deadlines, shed 0x%02x (now 0x%02x)", stage, m_shed);
+    }
+
+    void maybeRestore(DSPProcessor& dsp) {
+        const uint32_t nowMs = (uint32_t)(esp_timer_get_time() / 1000);
+        const uint32_t since = nowMs - (m_restoredMs > m_lastMissMs ? m_restoredMs : m_lastMissMs);
+        if (since < holdMs()) return;
+        const uint8_t stage = m_shedOrder[--m_shedCount];
+        m_shed &= (uint8_t)~stage;
+        m_restored = stage;
+        m_restoredMs = nowMs;
+        apply(dsp);
+        ESP_LOGI(TAG, "Deadlines met, restored 0x%02x (shed 0x%02x)", stage, m_shed);
+    }
+
+    void apply(DSPProcessor& dsp) {
+        dsp.setShed(m_shed & SHED_DSP_MASK);
+        const uint8_t level = decodeLevel(m_shed);
+        if (m_decodeLevelCb && level != m_decodeLevel) {
+            m_decodeLevel = level;
+            m_decodeLevelCb(level);
+        }
+    }
+
+    uint32_t holdMs() const { return (APP_DEADLINE_RESTORE_S * 1000u) << m_holdShift; }
+#endif
+
+    static size_t put32(uint8_t* out, size_t idx, uint32_t v) {
+        out[idx] = (uint8_t)v;
+        out[idx + 1] = (uint8_t)(v >> 8);
+        out[idx + 2] = (uint8_t)(v >> 16);
+        out[idx + 3] = (uint8_t)(v >> 24);
+        return idx + 4;
+    }
+
+    volatile uint32_t m_cpuMhz;
+    uint32_t m_blocks[MODES] = {};
+    uint32_t m_misses[MODES] = {};
+    volatile uint32_t m_peakPermille = 0;
+    std::atomic<bool> m_resetRequest{false};
+    volatile uint8_t m_shed = 0;            // DSPProcessor::ShedStage bits, SHED_DECODE_*
+    DecodeLevelCallback m_decodeLevelCb = nullptr;
+    ClockBoostCallback m_clockBoostCb = nullptr;
+
+#if APP_DEADLINE_AUTO_SHED
+    uint8_t m_shedOrder[5] = {};
+    uint8_t m_decodeLevel = 0;              // Last level passed to the callback
+    uint8_t m_shedCount = 0;
+    uint8_t m_restored = 0;                 // Last stage restored
+    uint32_t m_holdShift = 0;
+    uint32_t m_windowStartMs = 0;
+    uint32_t m_windowMisses = 0;
+    uint32_t m_lastMissMs = 0;
+    uint32_t m_restoredMs = 0;
+#endif
+};
+
+#endif // APP_DEADLINE_MONITOR
@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ * delay_report.h
+ *
+ * AVDTP delay reporting: the sink tells the source how long its audio
+ * takes from arrival to the DAC, so video can be held back to match. The
+ * stack sends the value set with esp_a2d_sink_set_delay_value to the
+ * connected source (when it configured delay reporting) and to every
+ * source configuring a stream later.
+ *
+ * The value is the latency probe's average once it has enough packets,
+ * else the estimate from the jitter target, the I2S DMA chain and the
+ * limiter lookahead. It is re-sent on every stream format, profile and
+ * stream start, and whenever it moves by APP_DELAY_REPORT_STEP_MS or more
+ * (the jitter target follows measured jitter), at most once per check.
+ */
+
+#include <stdint.h>
+#include "esp_a2dp_api.h"
+#include "esp_log.h"
+#include "../config/app_config.h"
+
+class DelayReporter {
+public:
+    static constexpr uint32_t MIN_PROBE_PACKETS = 50;   // Before the probe's average is trusted
+
+    // Latency in us; force sends it even when close to the last one
+    void update(uint32_t latencyUs, bool force) {
+        uint32_t tenths = (latencyUs + 50) / 100;       // AVDTP unit: 0.1 ms
+        if (tenths == 0) tenths = 1;
+        if (tenths > 0xFFFF) tenths = 0xFFFF;
+        const uint32_t diff = tenths > m_last ? tenths - m_last : m_last - tenths;
+        if (!force && m_last != 0 && diff < APP_DELAY_REPORT_STEP_MS * 10) return;
+        if (esp_a2d_sink_set_delay_value((uint16_t)tenths) != ESP_OK) return;
+        m_last = tenths;
+        ESP_LOGI(TAG, "Delay report %u.%u ms", (unsigned)(tenths / 10), (unsigned)(tenths % 10));
+    }
+
+    uint16_t last() const { return (uint16_t)m_last; }
+
+private:
+    static constexpr const char* TAG = "DelayRpt";
+    uint32_t m_last = 0;        // 0.1 ms, 0 = nothing sent yet
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+/*
+ * drift_estimator.h
+ *
+ * Estimates the clock drift between the A2DP source and the local I2S clock
+ * and turns it into a clock trim in ppm.
+ *
+ * The source clock is only observable through how fast PCM arrives, so the
+ * input is the jitter buffer depth error (depth - target). A source running
+ * fast makes the depth climb, a slow one makes it drain. A PI controller on
+ * the per-second average error drives the trim:
+ *   - the P term pulls the depth back towards the target
+ *   - the I term converges to the actual drift, so the trim holds once the
+ *     error is zero
+ * Typical crystals are within +/-100 ppm of each other, so the loop only needs
+ * a few minutes to lock and can then hold the depth for hours.
+ */
+
+#include <stdint.h>
+#include "esp_timer.h"
+
+class DriftEstimator {
+public:
+    // Restart estimation (new stream or resume after a gap). The integral is
+    // kept across restarts since the clock pair is usually the same.
+    void restart() {
+        m_errSum = 0.0f;
+        m_errCount = 0;
+        m_lastUpdateUs = 0;
+    }
+
+    // Forget everything (new device / codec change)
+    void reset() {
+        restart();
+        m_integralPpm = 0.0f;
+        m_trimPpm = 0.0f;
+    }
+
+    // Feed the current depth error. Returns true once per update period with
+    // a new trim in ppm (positive = speed the local clock up).
+    bool update(int32_t depthErrMs, float& trimPpmOut) {
+        int64_t nowUs = esp_timer_get_time();
+        if (m_lastUpdateUs == 0) {
+            m_lastUpdateUs = nowUs;
+            return false;
+        }
+
+        m_errSum += (float)depthErrMs;
+        m_errCount++;
+        if (nowUs - m_lastUpdateUs < UPDATE_PERIOD_US) return false;
+
+        float dt = (float)(nowUs - m_lastUpdateUs) * 1e-6f;
+        float err = m_errSum / (float)m_errCount;
+        m_errSum = 0.0f;
+        m_errCount = 0;
+        m_lastUpdateUs = nowUs;
+
+        m_integralPpm += err * KI_PPM_PER_MS_S * dt;
+        if (m_integralPpm > MAX_TRIM_PPM) m_integralPpm = MAX_TRIM_PPM;
+        if (m_integralPpm < -MAX_TRIM_PPM) m_integralPpm = -MAX_TRIM_PPM;
+
+        float trim = m_integralPpm + err * KP_PPM_PER_MS;
+        if (trim > MAX_TRIM_PPM) trim = MAX_TRIM_PPM;
+        if (trim < -MAX_TRIM_PPM) trim = -MAX_TRIM_PPM;
+        m_trimPpm = trim;
+        trimPpmOut = trim;
+        return true;
+    }
+
+    float getTrimPpm() const { return m_trimPpm; }
+    float getDriftPpm() const { return m_integralPpm; }
+
+private:
+    static constexpr int64_t UPDATE_PERIOD_US = 1000000;
+    // 10 ms of depth error asks for 100 ppm; with KI this is ~0.7 damped
+    static constexpr float KP_PPM_PER_MS = 10.0f;
+    static constexpr float KI_PPM_PER_MS_S = 0.05f;
+    static constexpr float MAX_TRIM_PPM = 300.0f;
+
+    float m_errSum = 0.0f;
+    uint32_t m_errCount = 0;
+    int64_t m_lastUpdateUs = 0;
+    float m_integralPpm = 0.0f;
+    volatile float m_trimPpm = 0.0f;
+};
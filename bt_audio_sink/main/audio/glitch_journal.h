@@ -0,0 +1,161 @@
+#pragma once
+
+/*
+ * glitch_journal.h
+ *
+ * Ring of the last audio glitches, kept in RTC slow memory so it is still
+ * there after a panic, watchdog or software reset (a power cycle or
+ * brownout clears it). Each event records when (boot index and ms since
+ * that boot), what, the codec streaming and how deep the jitter buffer and
+ * how much internal RAM were at that moment.
+ *
+ * record() is meant for the audio hot paths: a relaxed fetch_add for the
+ * slot and four word stores, no lock, from any task (the decoder, audio_tx,
+ * the stack's hooks). The sequence number goes in last, so a dump that
+ * races a write skips that slot. Reads go oldest first by sequence.
+ *
+ * The types are always declared, so hot paths can name them; the journal
+ * itself only exists with APP_GLITCH_JOURNAL.
+ *
+ * Entry, as read over BLE (STATUS_GLITCHES), 16 bytes little endian:
+ *   [seq u32, time_ms u32, boot u16, type, codec, queue_ms u16, free_kb u16]
+ */
+
+#include <stdint.h>
+#include "../config/app_config.h"
+
+enum GlitchType : uint8_t {
+    GLITCH_UNDERRUN = 1,    // Jitter buffer ran dry while playing
+    GLITCH_DROP,            // Ring full: decoded PCM dropped
+    GLITCH_SHORT_WRITE,     // Output slot dropped, DMA not draining
+    GLITCH_DECODE_ERROR,    // Packet rejected by the decoder
+    GLITCH_QUEUE_FULL,      // Media packet dropped by the stack, queue full
+    GLITCH_MEMORY_FLUSH,    // Media packets flushed for internal RAM
+};
+
+#if APP_GLITCH_JOURNAL
+
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+class GlitchJournal {
+public:
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint32_t ENTRIES = APP_GLITCH_JOURNAL_ENTRIES;
+    static constexpr size_t ENTRY_BYTES = 16;
+    static_assert((ENTRIES & (ENTRIES - 1)) == 0, "journal size must be a power of two");
+
+    static GlitchJournal& getInstance() {
+        static GlitchJournal instance;
+        return instance;
+    }
+
+    // At boot, before any record(): keeps what the last resets left, or
+    // starts over after a power cycle or a layout change
+    void begin() {
+        const esp_reset_reason_t reason = esp_reset_reason();
+        const bool kept = s_rtc.magic == MAGIC && reason != ESP_RST_POWERON && reason != ESP_RST_BROWNOUT;
+        if (!kept) {
+            memset(&s_rtc, 0, sizeof(s_rtc));
+            s_rtc.magic = MAGIC;
+        } else {
+            s_rtc.boot++;
+        }
+        uint32_t last = 0;
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < ENTRIES; i++) {
+            const uint32_t seq = s_rtc.entries[i].seq;
+            if (seq == 0) continue;
+            count++;
+            if (seq > last) last = seq;
+        }
+        m_next.store(last, std::memory_order_relaxed);
+        ESP_LOGI(TAG, "Boot %u, %u glitch(es) kept", (unsigned)s_rtc.boot, (unsigned)count);
+    }
+
+    void setCodec(uint8_t codec) { m_codec = codec; }
+
+    void record(GlitchType type, uint32_t queueMs) {
+        const uint32_t seq = m_next.fetch_add(1, std::memory_order_relaxed) + 1;
+        Entry& e = s_rtc.entries[seq & (ENTRIES - 1)];
+        const uint32_t freeKb = heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024;
+        e.seq = 0;
+        e.timeMs = (uint32_t)(esp_timer_get_time() / 1000);
+        e.info = (uint32_t)s_rtc.boot | (uint32_t)type << 16 | (uint32_t)m_codec << 24;
+        e.levels = (queueMs < 0xFFFF ? queueMs : 0xFFFF) | (freeKb < 0xFFFF ? freeKb : 0xFFFF) << 16;
+        std::atomic_signal_fence(std::memory_order_release);
+        e.seq = seq;
+    }
+
+    uint32_t count() const {
+        const uint32_t n = m_next.load(std::memory_order_relaxed);
+        return n < ENTRIES ? n : ENTRIES;
+    }
+
+    uint16_t boot() const { return s_rtc.boot; }
+
+    // Entries from sequence number seq on (or the oldest kept, if later),
+    // ENTRY_BYTES each, as many as fit cap; seq is left past the last one
+    // read. Returns the bytes written, 0 once there is nothing newer.
+    size_t read(uint32_t& seq, uint8_t* out, size_t cap) const {
+        const uint32_t last = m_next.load(std::memory_order_relaxed);
+        const uint32_t oldest = last > ENTRIES ? last - ENTRIES + 1 : 1;
+        if (seq < oldest) seq = oldest;
+        size_t len = 0;
+        for (; seq <= last && len + ENTRY_BYTES <= cap; seq++) {
+            const Entry& e = s_rtc.entries[seq & (ENTRIES - 1)];
+            if (e.seq != seq) continue;     // Being written (or overwritten)
+            put32(out + len, e.seq);
+            put32(out + len + 4, e.timeMs);
+            put32(out + len + 8, e.info);
+            put32(out + len + 12, e.levels);
+            len += ENTRY_BYTES;
+        }
+        return len;
+    }
+
+    void clear() {
+        memset(s_rtc.entries, 0, sizeof(s_rtc.entries));
+        m_next.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr const char* TAG = "Glitch";
+    static constexpr uint32_t MAGIC = 0x474A0000 | (ENTRIES << 4) | VERSION;
+
+    // Word fields, so a record is whole-word stores
+    struct Entry {
+        volatile uint32_t seq;      // 0 = empty
+        volatile uint32_t timeMs;
+        volatile uint32_t info;     // boot u16, type, codec
+        volatile uint32_t levels;   // queue_ms u16, free_kb u16
+    };
+    struct Rtc {
+        uint32_t magic;
+        uint16_t boot;
+        Entry entries[ENTRIES];
+    };
+
+    GlitchJournal() = default;
+
+    static void put32(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+
+    static Rtc s_rtc;
+    std::atomic<uint32_t> m_next{0};    // Last sequence number used
+    volatile uint8_t m_codec = 0;
+};
+
+inline RTC_NOINIT_ATTR GlitchJournal::Rtc GlitchJournal::s_rtc;
+
+#endif // APP_GLITCH_JOURNAL
@@ -0,0 +1,280 @@
+#pragma once
+
+/*
+ * hfp_link.h
+ *
+ * Hands-free calls: the HFP client profile with Bluedroid's own speech
+ * codec (mSBC at 16 kHz, CVSD at 8 kHz, with its packet loss concealment),
+ * so audio crosses this side as 16-bit mono PCM in 7.5 ms frames.
+ *
+ *   downlink  stack -> onIncoming() -> the speech processor's reference
+ *             ring and the caller's downlink callback (the audio pipeline,
+ *             in place of A2DP for the call)
+ *   uplink    mic (MicInput) -> SpeechProcessor -> uplink queue ->
+ *             onOutgoing(), which the stack calls for each frame it sends
+ *
+ * The uplink task (APP_CONTROL_CORE) owns the mic and the processor. It
+ * times every block against APP_HFP_DSP_BUDGET_PCT of the block period
+ * and halves the echo canceller's filter (not below MIN_TAPS) for the rest
+ * of the call when a second of blocks went over, so a busy core costs
+ * echo tail rather than dropped frames. The uplink queue holds at most
+ * UPLINK_MAX_BLOCKS; a block that finds it full is dropped, so a stalled
+ * stack never builds up delay.
+ *
+ * Latency: jitterBudgetMs() gives the downlink's jitter buffer what
+ * APP_HFP_RTT_TARGET_MS leaves after the parts with a fixed cost (frame
+ * assembly, output DMA, mic DMA, uplink queue, processing), never less
+ * than two frames.
+ *
+ * The processor's buffers are placed at the first call and kept: the
+ * downlink runs in the stack's task and may still push a reference while
+ * a call ends.
+ *
+ * Call control (answer, reject, dial) stays on the phone.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_hf_client_api.h"
+#include "mic_input.h"
+#include "../dsp/speech_processor.h"
+#include "../core/static_alloc.h"
+#include "../config/app_config.h"
+
+class HfpLink {
+public:
+    static constexpr uint32_t MIN_TAPS = 64;
+    static constexpr uint32_t UPLINK_MAX_BLOCKS = 2;
+
+    // Output side of a call, as the caller set it up
+    struct VoicePath {
+        uint32_t playoutUs;     // Downlink frame in to speaker out
+        bool sharedClock;       // Output on the APLL at the mic's rate
+    };
+
+    struct Callbacks {
+        // Call audio up: switch the output to rate, mono
+        VoicePath (*voiceStart)(uint32_t rate);
+        // Call audio down: back to the media stream
+        void (*voiceStop)();
+        void (*downlink)(const int16_t* pcm, uint32_t frames);
+        // Speaker gain from the phone, 0-15
+        void (*speakerVolume)(uint8_t volume);
+    };
+
+    static HfpLink& getInstance() {
+        static HfpLink instance;
+        return instance;
+    }
+
+    // After the Bluedroid stack is enabled
+    bool begin(const Callbacks& cb) {
+        m_cb = cb;
+        esp_err_t err = esp_hf_client_register_callback(onEvent);
+        if (err == ESP_OK) err = esp_hf_client_init();
+        if (err == ESP_OK) err = esp_hf_client_register_data_callback(onIncoming, onOutgoing);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "HFP client init failed: %s", esp_err_to_name(err));
+            return false;
+        }
+        if (StaticAlloc::createTask(uplinkTask, "hfp_up", 4096, this, 8, &m_task, APP_CONTROL_CORE) != pdPASS) {
+            ESP_LOGE(TAG, "Uplink task not created");
+            return false;
+        }
+        ESP_LOGI(TAG, "Hands-free ready (AEC %u taps, DSP budget %u%%, round trip target %u ms)",
+                 (unsigned)APP_HFP_AEC_TAPS, (unsigned)APP_HFP_DSP_BUDGET_PCT, (unsigned)APP_HFP_RTT_TARGET_MS);
+        return true;
+    }
+
+    bool inCall() const { return m_voice.load(std::memory_order_acquire); }
+
+    // Frames per block (one codec frame) at rate
+    static uint32_t blockFrames(uint32_t rate) { return rate * 15 / 2000; }
+
+    // Jitter buffer target (ms) for a call at rate whose output (DMA and
+    // limiter) adds outputUs
+    static uint32_t jitterBudgetMs(uint32_t rate, uint32_t outputUs) {
+        const uint32_t frameUs = blockFrames(rate) * 1000000 / rate;
+        const uint32_t dspUs = frameUs * APP_HFP_DSP_BUDGET_PCT / 100;
+        // Frame assembly, mic DMA block, uplink queue: one frame each
+        const uint32_t fixedUs = 3 * frameUs + outputUs + dspUs;
+        const uint32_t targetUs = (uint32_t)APP_HFP_RTT_TARGET_MS * 1000;
+        uint32_t jitterUs = targetUs > fixedUs ? targetUs - fixedUs : 0;
+        if (jitterUs < 2 * frameUs) jitterUs = 2 * frameUs;
+        const uint32_t jitterMs = (jitterUs + 999) / 1000;
+        const uint32_t rttUs = fixedUs + jitterMs * 1000;
+        ESP_LOGI(TAG, "Voice latency at %u Hz: frame %.1f, output %.1f, mic %.1f, uplink %.1f, DSP %.1f, "
+                 "jitter %u ms = %.1f ms (target %u)", (unsigned)rate, frameUs / 1000.0f, outputUs / 1000.0f,
+                 frameUs / 1000.0f, frameUs / 1000.0f, dspUs / 1000.0f, (unsigned)jitterMs, rttUs / 1000.0f,
+                 (unsigned)APP_HFP_RTT_TARGET_MS);
+        if (rttUs > targetUs + 500) {
+            ESP_LOGW(TAG, "Round trip over target by %.1f ms (jitter buffer at its two-frame minimum)",
+                     (rttUs - targetUs) / 1000.0f);
+        }
+        return jitterMs;
+    }
+
+private:
+    static constexpr const char* TAG = "HFP";
+    static constexpr uint32_t MAX_BLOCK = 120;          // mSBC frame
+    static constexpr uint32_t UPLINK_RING = 512;        // Samples, power of two
+    static constexpr uint32_t WINDOW_BLOCKS = 133;      // About a second
+    static constexpr uint32_t READ_TIMEOUT_MS = 50;
+
+    HfpLink() = default;
+
+    static void onEvent(esp_hf_client_cb_event_t event, esp_hf_client_cb_param_t* param) {
+        HfpLink& self = getInstance();
+        switch (event) {
+        case ESP_HF_CLIENT_CONNECTION_STATE_EVT:
+            ESP_LOGI(TAG, "Service level connection state %d", (int)param->conn_stat.state);
+            break;
+        case ESP_HF_CLIENT_AUDIO_STATE_EVT:
+            switch (param->audio_stat.state) {
+            case ESP_HF_CLIENT_AUDIO_STATE_CONNECTED:
+                self.startVoice(8000);
+                break;
+            case ESP_HF_CLIENT_AUDIO_STATE_CONNECTED_MSBC:
+                self.startVoice(16000);
+                break;
+            case ESP_HF_CLIENT_AUDIO_STATE_DISCONNECTED:
+                self.stopVoice();
+                break;
+            default:
+                break;
+            }
+            break;
+        case ESP_HF_CLIENT_VOLUME_CONTROL_EVT:
+            if (param->volume_control.type == ESP_HF_VOLUME_CONTROL_TARGET_SPK && self.m_cb.speakerVolume) {
+                self.m_cb.speakerVolume((uint8_t)param->volume_control.volume);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    void startVoice(uint32_t rate) {
+        if (m_voice.load()) return;
+        m_upRead.store(0);
+        m_upWrite.store(0);
+        m_rate = rate;
+        m_call.fetch_add(1);
+        m_path = m_cb.voiceStart ? m_cb.voiceStart(rate) : VoicePath{ 0, false };
+        m_voice.store(true, std::memory_order_release);
+        xTaskNotifyGive(m_task);
+        ESP_LOGI(TAG, "Call audio up: %s, %u Hz", rate == 16000 ? "mSBC" : "CVSD", (unsigned)rate);
+    }
+
+    void stopVoice() {
+        if (!m_voice.exchange(false)) return;
+        if (m_cb.voiceStop) m_cb.voiceStop();
+        ESP_LOGI(TAG, "Call audio down");
+    }
+
+    // Stack task: one decoded frame
+    static void onIncoming(const uint8_t* buf, uint32_t len) {
+        HfpLink& self = getInstance();
+        if (!self.m_voice.load(std::memory_order_acquire)) return;
+        const int16_t* pcm = (const int16_t*)buf;
+        const uint32_t frames = len / sizeof(int16_t);
+        if (self.m_spReady.load(std::memory_order_acquire)) self.m_sp.pushReference(pcm, frames);
+        if (self.m_cb.downlink) self.m_cb.downlink(pcm, frames);
+    }
+
+    // Stack task: len bytes for the next frame, all or nothing
+    static uint32_t onOutgoing(uint8_t* buf, uint32_t len) {
+        HfpLink& self = getInstance();
+        const uint32_t n = len / sizeof(int16_t);
+        const uint32_t r = self.m_upRead.load(std::memory_order_relaxed);
+        const uint32_t w = self.m_upWrite.load(std::memory_order_acquire);
+        if (w - r < n) return 0;
+        int16_t* out = (int16_t*)buf;
+        for (uint32_t i = 0; i < n; i++) out[i] = self.m_upRing[(r + i) & (UPLINK_RING - 1)];
+        self.m_upRead.store(r + n, std::memory_order_release);
+        return n * sizeof(int16_t);
+    }
+
+    // Uplink task: queue a processed block unless the queue is full
+    bool pushUplink(const int16_t* pcm, uint32_t frames) {
+        const uint32_t w = m_upWrite.load(std::memory_order_relaxed);
+        const uint32_t r = m_upRead.load(std::memory_order_acquire);
+        if (w - r + frames > UPLINK_MAX_BLOCKS * frames) return false;
+        for (uint32_t i = 0; i < frames; i++) m_upRing[(w + i) & (UPLINK_RING - 1)] = pcm[i];
+        m_upWrite.store(w + frames, std::memory_order_release);
+        return true;
+    }
+
+    static void uplinkTask(void* arg) {
+        HfpLink& self = *(HfpLink*)arg;
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            if (self.m_voice.load(std::memory_order_acquire)) self.runCall();
+        }
+    }
+
+    void runCall() {
+        const uint32_t call = m_call.load();
+        const uint32_t rate = m_rate;
+        const uint32_t block = blockFrames(rate);
+        if (!m_spReady.load() && m_sp.init(APP_HFP_AEC_TAPS, MAX_BLOCK)) m_spReady.store(true, std::memory_order_release);
+        if (!m_spReady.load()) {
+            ESP_LOGE(TAG, "No memory for the speech processor - uplink muted");
+            return;
+        }
+        // Echo in a mic block left the speaker playoutUs after its downlink
+        // frame came in, and the block is read one block after capture
+        const uint32_t refDelay = (uint32_t)((uint64_t)m_path.playoutUs * rate / 1000000) + block;
+        m_sp.begin(rate, refDelay);
+        if (m_mic.start(rate, block, APP_I2S_USE_APLL && m_path.sharedClock) != ESP_OK) return;
+
+        const uint32_t budgetUs = block * 1000000 / rate * APP_HFP_DSP_BUDGET_PCT / 100;
+        uint32_t windowBusyUs = 0, windowBlocks = 0, maxUs = 0, drops = 0;
+        // Until this call ends, or the next one started before it was seen
+        while (m_voice.load(std::memory_order_acquire) && m_call.load() == call) {
+            if (!m_mic.read(m_micBlock, block, READ_TIMEOUT_MS)) continue;
+            const int64_t t0 = esp_timer_get_time();
+            m_sp.process(m_micBlock, m_outBlock, block);
+            const uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+            if (!pushUplink(m_outBlock, block)) drops++;
+            esp_hf_client_outgoing_data_ready();
+
+            windowBusyUs += us;
+            if (us > maxUs) maxUs = us;
+            if (++windowBlocks < WINDOW_BLOCKS) continue;
+            if (windowBusyUs > budgetUs * windowBlocks && m_sp.taps() > MIN_TAPS) {
+                m_sp.setTaps(m_sp.taps() / 2);
+                ESP_LOGW(TAG, "DSP over budget (%u of %u us per block) - echo filter down to %u taps",
+                         (unsigned)(windowBusyUs / windowBlocks), (unsigned)budgetUs, (unsigned)m_sp.taps());
+            }
+            windowBusyUs = 0;
+            windowBlocks = 0;
+        }
+        m_mic.stop();
+        ESP_LOGI(TAG, "Call done: ERLE %.1f dB, %u taps, max %u us per block, %u uplink blocks dropped, "
+                 "%u reference re-anchors", m_sp.erleDb(), (unsigned)m_sp.taps(), (unsigned)maxUs,
+                 (unsigned)drops, (unsigned)m_sp.reanchors());
+    }
+
+    Callbacks m_cb = {};
+    TaskHandle_t m_task = nullptr;
+    std::atomic<bool> m_voice{false};
+    std::atomic<bool> m_spReady{false};
+    std::atomic<uint32_t> m_call{0};
+    uint32_t m_rate = 16000;
+    VoicePath m_path = {};
+
+    MicInput m_mic;
+    SpeechProcessor m_sp;
+    int32_t m_micBlock[MAX_BLOCK];
+    int16_t m_outBlock[MAX_BLOCK];
+
+    int16_t m_upRing[UPLINK_RING];
+    std::atomic<uint32_t> m_upRead{0};
+    std::atomic<uint32_t> m_upWrite{0};
+};
@@ -2,34 +2,94 @@
 
 // -----------------------------------------------------------
 // I2S Output - manages I2S driver for audio output
-// Always operates in 32-bit stereo mode
+// Stereo, 32- or 16-bit slots (APP_I2S_OUT_BITS); writers hand it blocks
+// already in that width
+// Clocked from the APLL (when enabled) so the rate can be trimmed by a few
+// ppm to track the source clock without resampling
+// Uses the i2s_std channel driver; an on_sent callback signals each DMA
+// buffer handed back, so writers can queue without blocking and sleep only
+// until the DMA has room again (see waitSent())
+// Rate changes reconfigure the clock while the channel is disabled and
+// preload silence, so they finish in about a millisecond without sleeping
+// For latency measurement the on_sent events are counted: the driver hands
+// DMA buffers to writers in the order they were sent, so the stream byte
+// position of a write tells which later event completes it (see probeExit())
+// With APP_AUX_OUTPUT a second stereo channel on APP_AUX_I2S_PORT carries
+// the aux outputs (sub, zone 2; see OutputMatrix): same clock source, same
+// DMA depth, and it is enabled, stopped and re-clocked together with the
+// main channel, so the two stay frame-aligned. Each channel holds its own
+// APLL reference and the driver won't retune a shared APLL, so the clock is
+// not trimmed while aux is open (drift goes to jitter buffer slips), and a
+// rate change lets aux drop its reference while the main channel moves it.
+// The ESP32's I2S has no TDM mode; more outputs means more ports
 // -----------------------------------------------------------
 
 #include <stdint.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
-#include "driver/i2s.h"
+#include "driver/i2s_std.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "soc/soc_caps.h"
+#if SOC_CLK_APLL_SUPPORTED
+#include "clk_ctrl_os.h"
+#include "hal/clk_tree_ll.h"
+#endif
 #include "../config/app_config.h"
 
 // Callback for sample rate change notifications
 using SampleRateChangeCallback = void(*)(uint32_t newRate);
 
+// DMA chain depth, chosen per codec: short chains keep aptX-LL's latency
+// advantage, deep ones ride out LDAC/AAC decode stalls. VOICE is for HFP
+// calls, where the round trip counts and frames are 7.5 ms anyway
+enum I2SLatencyClass {
+    I2S_LATENCY_LOW = 0,
+    I2S_LATENCY_STANDARD,
+    I2S_LATENCY_DEEP,
+    I2S_LATENCY_VOICE,
+};
+
 class I2SOutput {
 public:
-    I2SOutput() 
+    static constexpr uint32_t SAMPLE_BYTES = APP_I2S_OUT_BITS / 8;
+    static constexpr uint32_t FRAME_BYTES = 2 * SAMPLE_BYTES;
+
+    I2SOutput()
         : m_initialized(false)
+        , m_enabled(false)
         , m_sampleRate(0)
         , m_reconfig(false)
+        , m_useApll(false)
+        , m_apllBaseHz(0)
+        , m_trimPpm(0.0f)
+        , m_tx(nullptr)
+        , m_auxTx(nullptr)
+        , m_dmaBufBytes(0)
+        , m_dmaDescNum(0)
+        , m_dmaFrameNum(0)
         , m_mutex(nullptr)
+        , m_sentSem(nullptr)
         , m_sampleRateCallback(nullptr)
+        , m_writePos(0)
+        , m_sentEvents(0)
+        , m_ovfEvents(0)
+        , m_probeEvent(0)
+        , m_probeTailUs(0)
+        , m_probeExitUs(0)
+        , m_probeDone(false)
     {
     }
 
     ~I2SOutput() {
+        destroyChannel();
         if (m_mutex) {
             vSemaphoreDelete(m_mutex);
         }
+        if (m_sentSem) {
+            vSemaphoreDelete(m_sentSem);
+        }
     }
 
     // Initialize I2S driver (call once at startup)
@@ -38,123 +98,227 @@ public:
 
         // Create mutex for thread-safe access
         m_mutex = xSemaphoreCreateMutex();
-        if (!m_mutex) {
+        m_sentSem = xSemaphoreCreateBinary();
+        if (!m_mutex || !m_sentSem) {
             ESP_LOGE(TAG, "Failed to create I2S mutex");
             return ESP_ERR_NO_MEM;
         }
 
-        i2s_config_t i2s_config = {};
-        i2s_config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX);
-        i2s_config.sample_rate = sampleRate;
-        i2s_config.bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT;
-        i2s_config.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
-        i2s_config.communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_I2S_MSB);
-        i2s_config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
-        // Increased DMA buffering: 16 buffers x 1024 samples = 16384 samples (~371ms at 44.1kHz)
-        // This provides more headroom for brief decode stalls and reduces underrun probability
-        i2s_config.dma_buf_count = 16;
-        i2s_config.dma_buf_len = 1024;
-        i2s_config.use_apll = false;
-        i2s_config.tx_desc_auto_clear = true;
-        i2s_config.fixed_mclk = 0;
-
-        auto install_with = [&](int dma_count, int dma_len) -> esp_err_t {
-            i2s_config.dma_buf_count = dma_count;
-            i2s_config.dma_buf_len = dma_len;
-            esp_err_t e = i2s_driver_install((i2s_port_t)APP_I2S_PORT, &i2s_config, 0, NULL);
-            if (e != ESP_OK) {
-                ESP_LOGE(TAG, "i2s_driver_install failed (dma_count=%d dma_len=%d): %s", 
-                         dma_count, dma_len, esp_err_to_name(e));
-            }
-            return e;
-        };
+#if SOC_CLK_APLL_SUPPORTED && APP_I2S_USE_APLL
+        m_useApll = true;
+#endif
 
+        // Start deep; onCodecConfig() picks the codec's class via reconfigure()
         // Try progressively smaller configurations if memory constrained
-        esp_err_t err = install_with(16, 1024);
+        DmaGeometry deep = geometryFor(I2S_LATENCY_DEEP);
+        esp_err_t err = createChannel(sampleRate, deep.descNum, deep.frameNum);
         if (err == ESP_ERR_NO_MEM) {
-            ESP_LOGW(TAG, "Trying reduced DMA config (12x512)");
-            err = install_with(12, 512);
+            ESP_LOGW(TAG, "Trying reduced DMA config (8x480)");
+            err = createChannel(sampleRate, 8, 480);
         }
         if (err == ESP_ERR_NO_MEM) {
-            ESP_LOGW(TAG, "Trying minimal DMA config (8x256)");
-            err = install_with(8, 256);
+            ESP_LOGW(TAG, "Trying minimal DMA config (4x256)");
+            err = createChannel(sampleRate, 4, 256);
         }
         if (err != ESP_OK) {
             return err;
         }
 
-        i2s_pin_config_t pins = {};
-        pins.mck_io_num = I2S_PIN_NO_CHANGE;
-        pins.bck_io_num = APP_I2S_BCK_PIN;
-        pins.ws_io_num = APP_I2S_LRCK_PIN;
-        pins.data_out_num = APP_I2S_DATA_PIN;
-        pins.data_in_num = I2S_PIN_NO_CHANGE;
+        m_initialized = true;
+        m_enabled = true;
+        m_sampleRate = sampleRate;
+        m_apllBaseHz = apllFreqFor(sampleRate);
+        m_trimPpm = 0.0f;
+        ESP_LOGI(TAG, "I2S initialized: sr=%u, %u-bit stereo%s%s, DMA %ux%u (%u us)", (unsigned)sampleRate,
+                 (unsigned)APP_I2S_OUT_BITS,
+                 m_auxTx ? " + aux" : "", m_useApll ? ", APLL" : "", (unsigned)m_dmaDescNum,
+                 (unsigned)m_dmaFrameNum, (unsigned)getDmaLatencyUs());
+        return ESP_OK;
+    }
+
+    // Apply a new stream's rate and DMA latency class in one step. If the
+    // geometry is unchanged this is just updateClock(); otherwise the channel
+    // is re-provisioned (DMA buffers freed and reallocated) at the new rate.
+    esp_err_t reconfigure(uint32_t sampleRate, I2SLatencyClass cls) {
+        if (!m_initialized) return ESP_ERR_INVALID_STATE;
+        if (sampleRate == 0) sampleRate = APP_I2S_DEFAULT_SR;
 
-        err = i2s_set_pin((i2s_port_t)APP_I2S_PORT, &pins);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "i2s_set_pin failed: %s", esp_err_to_name(err));
-            i2s_driver_uninstall((i2s_port_t)APP_I2S_PORT);
-            return err;
+        DmaGeometry g = geometryFor(cls);
+        if (g.descNum == m_dmaDescNum && g.frameNum == m_dmaFrameNum) {
+            updateClock(sampleRate);
+            return ESP_OK;
         }
+        return setDmaGeometry(g.descNum, g.frameNum, sampleRate);
+    }
+
+    // Re-provision the DMA chain (descriptor count x frames per descriptor).
+    // Frames are capped at MAX_DMA_FRAMES per descriptor. Falls back to the
+    // old geometry on failure.
+    esp_err_t setDmaGeometry(uint32_t descNum, uint32_t frameNum, uint32_t sampleRate) {
+        if (!m_initialized) return ESP_ERR_INVALID_STATE;
+        if (frameNum > MAX_DMA_FRAMES) frameNum = MAX_DMA_FRAMES;
 
-        err = i2s_set_clk((i2s_port_t)APP_I2S_PORT, sampleRate, I2S_BITS_PER_SAMPLE_32BIT, I2S_CHANNEL_STEREO);
+        int64_t startUs = esp_timer_get_time();
+        uint32_t oldDesc = m_dmaDescNum, oldFrames = m_dmaFrameNum, oldRate = m_sampleRate;
+        lock();
+        m_reconfig = true;
+        bool wasEnabled = m_enabled;
+        destroyChannel();
+
+        esp_err_t err = createChannel(sampleRate, descNum, frameNum);
         if (err != ESP_OK) {
-            ESP_LOGE(TAG, "i2s_set_clk failed: %s", esp_err_to_name(err));
-            i2s_driver_uninstall((i2s_port_t)APP_I2S_PORT);
-            return err;
+            ESP_LOGW(TAG, "DMA %ux%u failed, restoring %ux%u", (unsigned)descNum, (unsigned)frameNum,
+                     (unsigned)oldDesc, (unsigned)oldFrames);
+            sampleRate = oldRate;
+            if (createChannel(sampleRate, oldDesc, oldFrames) != ESP_OK) {
+                // No channel at all: writes are refused until the next attempt
+                ESP_LOGE(TAG, "I2S channel lost");
+                m_reconfig = false;
+                unlock();
+                return err;
+            }
+        }
+        if (!wasEnabled) {
+            disableChannels();
+            m_enabled = false;
         }
 
-        m_initialized = true;
+        bool rateChanged = m_sampleRate != sampleRate;
         m_sampleRate = sampleRate;
-        ESP_LOGI(TAG, "I2S initialized: sr=%u, 32-bit stereo", (unsigned)sampleRate);
-        return ESP_OK;
+        m_restarts++;
+        m_apllBaseHz = apllFreqFor(sampleRate);
+        m_trimPpm = 0.0f;
+        m_reconfig = false;
+        unlock();
+
+        ESP_LOGI(TAG, "I2S DMA %ux%u frames at %u Hz: %u us of buffering (set up in %u us)",
+                 (unsigned)m_dmaDescNum, (unsigned)m_dmaFrameNum, (unsigned)sampleRate,
+                 (unsigned)getDmaLatencyUs(), (unsigned)(esp_timer_get_time() - startUs));
+        if (rateChanged && m_sampleRateCallback) {
+            m_sampleRateCallback(sampleRate);
+        }
+        return err;
     }
 
-    // Update sample rate (clock only, no driver reinstall)
+    // Current DMA geometry and the latency it adds at the current rate
+    uint32_t getDmaDescNum() const { return m_dmaDescNum; }
+    uint32_t getDmaFrameNum() const { return m_dmaFrameNum; }
+    uint32_t getDmaLatencyUs() const {
+        if (m_sampleRate == 0) return 0;
+        return (uint32_t)((uint64_t)m_dmaDescNum * m_dmaFrameNum * 1000000ULL / m_sampleRate);
+    }
+
+    // Update sample rate (clock only, channel stays allocated). Safe to call
+    // from the BT callback task: nothing here sleeps.
     void updateClock(uint32_t sampleRate) {
         if (!m_initialized) return;
         if (sampleRate == 0) sampleRate = APP_I2S_DEFAULT_SR;
         if (m_sampleRate == sampleRate) return;
 
+        int64_t startUs = esp_timer_get_time();
         lock();
         m_reconfig = true;
 
-        i2s_stop((i2s_port_t)APP_I2S_PORT);
-        i2s_zero_dma_buffer((i2s_port_t)APP_I2S_PORT);
+        // The clock can only be reconfigured while the channel is disabled
+        bool wasEnabled = m_enabled;
+        if (m_enabled) {
+            disableChannels();
+            m_enabled = false;
+        }
 
-        esp_err_t err = i2s_set_clk((i2s_port_t)APP_I2S_PORT, sampleRate, 
-                                     I2S_BITS_PER_SAMPLE_32BIT, I2S_CHANNEL_STEREO);
+        i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sampleRate);
+        clk_cfg.mclk_multiple = I2S_MCLK_MULTIPLE_256;
+#if SOC_CLK_APLL_SUPPORTED
+        if (m_useApll) clk_cfg.clk_src = I2S_CLK_SRC_APLL;
+#endif
+        esp_err_t err = ESP_OK;
+#if SOC_CLK_APLL_SUPPORTED
+        // The APLL only moves while one channel references it: aux steps
+        // over to the default source, then follows the main channel back
+        if (m_useApll && m_auxTx) {
+            i2s_std_clk_config_t auxClk = I2S_STD_CLK_DEFAULT_CONFIG(sampleRate);
+            auxClk.mclk_multiple = I2S_MCLK_MULTIPLE_256;
+            err = i2s_channel_reconfig_std_clock(m_auxTx, &auxClk);
+        }
+#endif
+        if (err == ESP_OK) err = i2s_channel_reconfig_std_clock(m_tx, &clk_cfg);
+        if (err == ESP_OK && m_auxTx) err = i2s_channel_reconfig_std_clock(m_auxTx, &clk_cfg);
         if (err == ESP_OK) {
             m_sampleRate = sampleRate;
-            ESP_LOGI(TAG, "I2S clock updated: sr=%u", (unsigned)sampleRate);
-            
+            // The driver reprograms the APLL to nominal
+            m_apllBaseHz = apllFreqFor(sampleRate);
+            m_trimPpm = 0.0f;
+        } else {
+            ESP_LOGE(TAG, "i2s_channel_reconfig_std_clock failed: %s", esp_err_to_name(err));
+        }
+
+        // Old-rate samples left in the descriptors would play at the new
+        // rate; the channel starts on silence instead, no settling delay
+        preloadSilence();
+        resetExitLedger();
+        if (wasEnabled && enableChannels() == ESP_OK) {
+            m_enabled = true;
+        }
+
+        m_reconfig = false;
+        unlock();
+
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "I2S clock updated: sr=%u in %u us", (unsigned)sampleRate,
+                     (unsigned)(esp_timer_get_time() - startUs));
+
             // Notify SoundPlayer about sample rate change
             if (m_sampleRateCallback) {
                 m_sampleRateCallback(sampleRate);
             }
-        } else {
-            ESP_LOGE(TAG, "i2s_set_clk failed: %s", esp_err_to_name(err));
         }
+    }
 
-        i2s_start((i2s_port_t)APP_I2S_PORT);
-        
-        // Small delay to let I2S DMA stabilize after clock change
-        vTaskDelay(pdMS_TO_TICKS(10));
-        
-        m_reconfig = false;
+    // Trim the output clock by ppm (positive = faster) for drift compensation.
+    // Only the APLL fractional divider is touched, so there is no glitch and
+    // no DMA restart. Returns false when the clock cannot be trimmed: the
+    // driver refuses to retune an APLL that more than one channel references,
+    // so not while the aux channel is open (see canTrimClock()).
+    bool setClockTrimPpm(float ppm) {
+#if SOC_CLK_APLL_SUPPORTED
+        if (!canTrimClock() || !m_initialized || m_reconfig || m_apllBaseHz == 0) return false;
+        // Below the APLL step (~1 ppm at audio rates) there is nothing to do
+        float delta = ppm - m_trimPpm;
+        if (delta > -0.5f && delta < 0.5f) return true;
+
+        uint32_t freq = (uint32_t)((double)m_apllBaseHz * (1.0 + (double)ppm * 1e-6) + 0.5);
+        uint32_t real = 0;
+        lock();
+        esp_err_t err = periph_rtc_apll_freq_set(freq, &real);
         unlock();
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "APLL trim failed: %s", esp_err_to_name(err));
+            return false;
+        }
+        m_trimPpm = ppm;
+        return true;
+#else
+        (void)ppm;
+        return false;
+#endif
     }
-    
+
+    float getClockTrimPpm() const { return m_trimPpm; }
+    bool canTrimClock() const { return m_useApll && !m_auxTx; }
+
     // Set callback for sample rate changes
     void setSampleRateCallback(SampleRateChangeCallback cb) {
         m_sampleRateCallback = cb;
     }
-    
+
     // Get current sample rate
     uint32_t getSampleRate() const {
         return m_sampleRate;
     }
 
+    // Bytes of one DMA buffer (one on_sent event frees this much room)
+    uint32_t getDmaBufferBytes() const { return m_dmaBufBytes; }
+
     // Reset to default sample rate (on disconnect)
     void resetToDefault() {
         updateClock(APP_I2S_DEFAULT_SR);
@@ -163,40 +327,121 @@ public:
 
     // Write audio data
     size_t write(const void *data, size_t bytes) {
-        if (!m_initialized || m_reconfig) return 0;
-        
+        if (!m_initialized || m_reconfig || !m_enabled) return 0;
+
         size_t written = 0;
         lock();
         // Use timeout instead of portMAX_DELAY to prevent indefinite blocking
         // during initialization race conditions
-        i2s_write((i2s_port_t)APP_I2S_PORT, data, bytes, &written, pdMS_TO_TICKS(100));
+        i2s_channel_write(m_tx, data, bytes, &written, 100);
+        m_writePos += written;
         unlock();
         return written;
     }
 
+    // Queue as much as fits into free DMA buffers right now, never blocking.
+    // Returns 0 if the DMA is full or another writer holds the channel.
+    // startPos receives the stream position of the first byte (see probeExit()).
+    size_t writeNoWait(const void *data, size_t bytes, uint32_t *startPos = nullptr) {
+        if (!m_initialized || m_reconfig || !m_enabled) return 0;
+        if (!m_mutex || xSemaphoreTake(m_mutex, 0) != pdTRUE) return 0;
+
+        size_t written = 0;
+        if (startPos) *startPos = m_writePos;
+        i2s_channel_write(m_tx, data, bytes, &written, 0);
+        m_writePos += written;
+        xSemaphoreGive(m_mutex);
+        return written;
+    }
+
+#if APP_AUX_OUTPUT
+    // Aux channel: same as writeNoWait(), called with each block right
+    // after the main channel's part of it
+    size_t writeAuxNoWait(const void *data, size_t bytes) {
+        if (!m_initialized || m_reconfig || !m_enabled || !m_auxTx) return 0;
+        if (!m_mutex || xSemaphoreTake(m_mutex, 0) != pdTRUE) return 0;
+
+        size_t written = 0;
+        i2s_channel_write(m_auxTx, data, bytes, &written, 0);
+        xSemaphoreGive(m_mutex);
+        return written;
+    }
+#endif
+
+    // Latency probe: timestamp the moment the byte at stream position pos
+    // (from writeNoWait) has left the DMA. Buffer n (1-based, pos / buffer
+    // size + 1) that writers fill is the one the n-th on_sent freed, shifted
+    // by queue overflows; it is sent again one chain length later. Returns
+    // false while another probe is pending. Poll with takeExit().
+    bool probeExit(uint32_t pos) {
+        if (m_probeEvent != 0 || m_probeDone || m_dmaBufBytes == 0 || m_sampleRate == 0) return false;
+        const uint32_t offset = pos % m_dmaBufBytes;
+        // on_sent fires at the end of the buffer; the byte left earlier by
+        // the frames behind it
+        m_probeTailUs = (uint32_t)((uint64_t)((m_dmaBufBytes - offset) / FRAME_BYTES) *
+                                   1000000ULL / m_sampleRate);
+        uint32_t target = pos / m_dmaBufBytes + 1 + m_ovfEvents + m_dmaDescNum;
+        m_probeEvent = target ? target : 1;
+        return true;
+    }
+
+    // Completed probe: exit time of the probed byte (esp_timer, low 32 bits)
+    bool takeExit(uint32_t &exitUs) {
+        if (!m_probeDone) return false;
+        exitUs = m_probeExitUs - m_probeTailUs;
+        m_probeDone = false;
+        return true;
+    }
+
+    // Block until the DMA hands back a buffer (on_sent) or the timeout expires
+    bool waitSent(TickType_t timeout) {
+        if (!m_sentSem) return false;
+        return xSemaphoreTake(m_sentSem, timeout) == pdTRUE;
+    }
+
     // Zero DMA buffer
     void zeroDMA() {
-        if (m_initialized) {
-            i2s_zero_dma_buffer((i2s_port_t)APP_I2S_PORT);
+        if (!m_initialized) return;
+        lock();
+        bool wasEnabled = m_enabled;
+        if (m_enabled) {
+            disableChannels();
+            m_enabled = false;
         }
+        preloadSilence();
+        resetExitLedger();
+        if (wasEnabled && enableChannels() == ESP_OK) {
+            m_enabled = true;
+        }
+        unlock();
     }
 
     // Stop I2S
     void stop() {
-        if (m_initialized) {
-            i2s_stop((i2s_port_t)APP_I2S_PORT);
+        if (!m_initialized) return;
+        lock();
+        if (m_enabled && disableChannels() == ESP_OK) {
+            m_enabled = false;
         }
+        unlock();
     }
 
     // Start I2S
     void start() {
-        if (m_initialized) {
-            i2s_start((i2s_port_t)APP_I2S_PORT);
+        if (!m_initialized) return;
+        lock();
+        if (!m_enabled) resetExitLedger();
+        if (!m_enabled && enableChannels() == ESP_OK) {
+            m_enabled = true;
         }
+        unlock();
     }
 
     bool isInitialized() const { return m_initialized; }
     bool isReconfiguring() const { return m_reconfig; }
+    // Times the DMA dropped what it held and restarted on silence (clock
+    // and geometry changes, zeroDMA), wrapping
+    uint32_t getRestarts() const { return m_restarts; }
 
     void lock() {
         if (m_mutex) xSemaphoreTake(m_mutex, portMAX_DELAY);
@@ -209,9 +454,225 @@ public:
 private:
     static constexpr const char* TAG = "I2S";
 
+    // 4092-byte descriptor limit / 8 bytes per 32-bit stereo frame. 16-bit
+    // slots keep the same frames (and latency) in half the bytes.
+    static constexpr uint32_t MAX_DMA_FRAMES = 511;
+
+    struct DmaGeometry {
+        uint32_t descNum;
+        uint32_t frameNum;
+    };
+
+    // Chains per latency class. Durations at 44.1 kHz: ~23 ms, ~87 ms, ~139 ms;
+    // the voice chain is 16 ms at 16 kHz
+    static DmaGeometry geometryFor(I2SLatencyClass cls) {
+        switch (cls) {
+            case I2S_LATENCY_VOICE:    return {4, 64};
+            case I2S_LATENCY_LOW:      return {4, 256};
+            case I2S_LATENCY_STANDARD: return {8, 480};
+            case I2S_LATENCY_DEEP:
+            default:                   return {12, MAX_DMA_FRAMES};
+        }
+    }
+
+    // Allocate, configure and enable the TX channel(s). DMA buffers are
+    // allocated when a channel is put into std mode.
+    esp_err_t createChannel(uint32_t sampleRate, uint32_t descNum, uint32_t frameNum) {
+        esp_err_t err = newStdChannel((i2s_port_t)APP_I2S_PORT, APP_I2S_BCK_PIN, APP_I2S_LRCK_PIN,
+                                      APP_I2S_DATA_PIN, sampleRate, descNum, frameNum, m_tx);
+        if (err == ESP_OK) {
+            i2s_event_callbacks_t cbs = {};
+            cbs.on_sent = onSent;
+            cbs.on_send_q_ovf = onSendOverflow;
+            err = i2s_channel_register_event_callback(m_tx, &cbs, this);
+        }
+#if APP_AUX_OUTPUT
+        // No callbacks: the main channel's on_sent paces both
+        if (err == ESP_OK) {
+            err = newStdChannel((i2s_port_t)APP_AUX_I2S_PORT, APP_AUX_I2S_BCK_PIN,
+                                APP_AUX_I2S_LRCK_PIN, APP_AUX_I2S_DATA_PIN, sampleRate, descNum, frameNum, m_auxTx);
+        }
+#endif
+        if (err == ESP_OK) {
+            // Fresh DMA buffers are zeroed by the driver, nothing to preload
+            resetExitLedger();
+            err = enableChannels();
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "I2S channel setup failed (dma_count=%u dma_len=%u): %s",
+                     (unsigned)descNum, (unsigned)frameNum, esp_err_to_name(err));
+            if (m_tx) {
+                i2s_del_channel(m_tx);
+                m_tx = nullptr;
+            }
+            if (m_auxTx) {
+                i2s_del_channel(m_auxTx);
+                m_auxTx = nullptr;
+            }
+            return err;
+        }
+
+        m_enabled = true;
+        m_dmaDescNum = descNum;
+        m_dmaFrameNum = frameNum > MAX_DMA_FRAMES ? MAX_DMA_FRAMES : frameNum;
+        m_dmaBufBytes = m_dmaFrameNum * FRAME_BYTES;
+        return ESP_OK;
+    }
+
+    // One stereo Philips TX channel in std mode, not yet enabled
+    esp_err_t newStdChannel(i2s_port_t port, int bck, int ws, int dout,
+                            uint32_t sampleRate, uint32_t descNum, uint32_t frameNum,
+                            i2s_chan_handle_t &handle) {
+        i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(port, I2S_ROLE_MASTER);
+        chan_cfg.dma_desc_num = descNum;
+        chan_cfg.dma_frame_num = frameNum;
+        chan_cfg.auto_clear = true;
+        chan_cfg.intr_priority = 1;
+
+        i2s_std_config_t std_cfg = {
+            .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sampleRate),
+            .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(
+                APP_I2S_OUT_BITS == 16 ? I2S_DATA_BIT_WIDTH_16BIT : I2S_DATA_BIT_WIDTH_32BIT,
+                I2S_SLOT_MODE_STEREO),
+            .gpio_cfg = {
+                .mclk = I2S_GPIO_UNUSED,
+                .bclk = (gpio_num_t)bck,
+                .ws = (gpio_num_t)ws,
+                .dout = (gpio_num_t)dout,
+                .din = I2S_GPIO_UNUSED,
+                .invert_flags = {},
+            },
+        };
+        std_cfg.clk_cfg.mclk_multiple = I2S_MCLK_MULTIPLE_256;
+#if SOC_CLK_APLL_SUPPORTED
+        if (m_useApll) std_cfg.clk_cfg.clk_src = I2S_CLK_SRC_APLL;
+#endif
+
+        esp_err_t err = i2s_new_channel(&chan_cfg, &handle, NULL);
+        if (err == ESP_OK) {
+            err = i2s_channel_init_std_mode(handle, &std_cfg);
+        }
+        return err;
+    }
+
+    // The aux channel starts right after the main one, so both run the
+    // same distance behind their writes
+    esp_err_t enableChannels() {
+        esp_err_t err = i2s_channel_enable(m_tx);
+        if (err == ESP_OK && m_auxTx) {
+            err = i2s_channel_enable(m_auxTx);
+            if (err != ESP_OK) i2s_channel_disable(m_tx);
+        }
+        return err;
+    }
+
+    esp_err_t disableChannels() {
+        if (m_auxTx) i2s_channel_disable(m_auxTx);
+        return i2s_channel_disable(m_tx);
+    }
+
+    void destroyChannel() {
+        if (!m_tx) return;
+        if (m_enabled) disableChannels();
+        m_enabled = false;
+        i2s_del_channel(m_tx);
+        m_tx = nullptr;
+        if (m_auxTx) {
+            i2s_del_channel(m_auxTx);
+            m_auxTx = nullptr;
+        }
+    }
+
+    // DMA ISR: a buffer finished sending and is free for the next write
+    static bool IRAM_ATTR onSent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *ctx) {
+        (void)handle;
+        (void)event;
+        I2SOutput *self = (I2SOutput *)ctx;
+        uint32_t n = self->m_sentEvents + 1;
+        self->m_sentEvents = n;
+        if (self->m_probeEvent != 0 && (int32_t)(n - self->m_probeEvent) >= 0) {
+            self->m_probeExitUs = (uint32_t)esp_timer_get_time();
+            self->m_probeEvent = 0;
+            self->m_probeDone = true;
+        }
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(self->m_sentSem, &woken);
+        return woken == pdTRUE;
+    }
+
+    // DMA ISR: no writer took the oldest sent buffer in time, the driver
+    // dropped it from its queue (shifts the buffer order probeExit() assumes)
+    static bool IRAM_ATTR onSendOverflow(i2s_chan_handle_t handle, i2s_event_data_t *event, void *ctx) {
+        (void)handle;
+        (void)event;
+        I2SOutput *self = (I2SOutput *)ctx;
+        self->m_ovfEvents = self->m_ovfEvents + 1;
+        return false;
+    }
+
+    // The driver restarts from the first descriptor on enable: restart the
+    // event count with it (channel disabled, so the ISR is quiet)
+    void resetExitLedger() {
+        m_writePos = 0;
+        m_sentEvents = 0;
+        m_ovfEvents = 0;
+        m_probeEvent = 0;
+        m_probeDone = false;
+    }
+
+    // Fill the DMA buffers with zeros (channels must be disabled). The source
+    // lives in DRAM so the copy does not go through the flash cache.
+    void preloadSilence() {
+        m_restarts++;
+        static int32_t zeros[256] = {};
+        i2s_chan_handle_t chans[2] = {m_tx, m_auxTx};
+        for (i2s_chan_handle_t chan : chans) {
+            if (!chan) continue;
+            size_t loaded = 0;
+            do {
+                if (i2s_channel_preload_data(chan, zeros, sizeof(zeros), &loaded) != ESP_OK) break;
+            } while (loaded == sizeof(zeros));
+        }
+    }
+
+    // APLL frequency the driver picks for this rate (mirrors
+    // i2s_set_get_apll_freq: mclk = 256 * fs, multiplied up past the APLL
+    // minimum), so trims are applied relative to the same nominal value
+    uint32_t apllFreqFor(uint32_t sampleRate) const {
+#if SOC_CLK_APLL_SUPPORTED
+        if (!m_useApll || sampleRate == 0) return 0;
+        uint32_t mclk = sampleRate * 256;
+        uint32_t div = CLK_LL_APLL_MIN_HZ / mclk + 1;
+        if (div < 2) div = 2;
+        return mclk * div;
+#else
+        (void)sampleRate;
+        return 0;
+#endif
+    }
+
     bool m_initialized;
+    volatile bool m_enabled;
     uint32_t m_sampleRate;
     volatile bool m_reconfig;
+    volatile uint32_t m_restarts = 0;
+    bool m_useApll;
+    uint32_t m_apllBaseHz;
+    volatile float m_trimPpm;
+    i2s_chan_handle_t m_tx;
+    i2s_chan_handle_t m_auxTx;      // APP_AUX_OUTPUT channel, else null
+    uint32_t m_dmaBufBytes;
+    uint32_t m_dmaDescNum;
+    uint32_t m_dmaFrameNum;
     SemaphoreHandle_t m_mutex;
+    SemaphoreHandle_t m_sentSem;
     SampleRateChangeCallback m_sampleRateCallback;
+
+    uint32_t m_writePos;            // Bytes written since the last enable (under m_mutex)
+    volatile uint32_t m_sentEvents; // on_sent events since the last enable
+    volatile uint32_t m_ovfEvents;  // Driver queue overflows since the last enable
+    volatile uint32_t m_probeEvent; // Event that completes the probed byte, 0 = none
+    uint32_t m_probeTailUs;         // Play time after the probed byte in its buffer
+    volatile uint32_t m_probeExitUs;
+    volatile bool m_probeDone;
 };
@@ -0,0 +1,81 @@
+#pragma once
+
+// -----------------------------------------------------------
+// IMA ADPCM - block decoder for WAV format 0x11 (Microsoft IMA)
+// - 4 bits per sample, 4:1 against 16-bit PCM
+// - Each block starts with a 4-byte header per channel (first
+//   sample, step index), then 4-byte groups of 8 nibbles per
+//   channel in turn, low nibble first
+// - A block is decoded on its own, so a stream can start at any
+//   block and only one block of PCM is ever held
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+
+static constexpr uint16_t WAV_FORMAT_IMA_ADPCM = 0x11;
+
+// Largest block accepted (bounds the decode buffers)
+static constexpr uint16_t IMA_MAX_BLOCK = 2048;
+
+// Frames in a block of bytes: a full one, or a short last block
+static inline size_t imaBlockFrames(size_t bytes, int channels) {
+    const size_t head = 4 * (size_t)channels;
+    if (bytes < head) return 0;
+    return 1 + (bytes - head) / head * 8;
+}
+
+struct ImaChannel {
+    int32_t predictor;
+    int32_t index;
+
+    inline int16_t decode(uint8_t nibble) {
+        static const int16_t STEPS[89] = {
+            7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+            34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+            157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+            724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+            3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+            15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+        };
+        static const int8_t INDEX_STEP[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+        const int32_t step = STEPS[index];
+        int32_t diff = step >> 3;
+        if (nibble & 4) diff += step;
+        if (nibble & 2) diff += step >> 1;
+        if (nibble & 1) diff += step >> 2;
+        predictor += (nibble & 8) ? -diff : diff;
+        if (predictor > 32767) predictor = 32767;
+        else if (predictor < -32768) predictor = -32768;
+        index += INDEX_STEP[nibble & 7];
+        if (index < 0) index = 0;
+        else if (index > 88) index = 88;
+        return (int16_t)predictor;
+    }
+};
+
+// Decodes one block (bytes long, mono or stereo) to interleaved S16;
+// returns the frames written (imaBlockFrames)
+static inline size_t imaDecodeBlock(const uint8_t* in, size_t bytes, int channels, int16_t* out) {
+    const size_t frames = imaBlockFrames(bytes, channels);
+    if (frames == 0) return 0;
+    ImaChannel ch[2];
+    for (int c = 0; c < channels; c++) {
+        const uint8_t* h = in + 4 * c;
+        ch[c].predictor = (int16_t)(h[0] | (h[1] << 8));
+        ch[c].index = h[2] > 88 ? 88 : h[2];
+        out[c] = (int16_t)ch[c].predictor;
+    }
+    const uint8_t* p = in + 4 * channels;
+    for (size_t f = 1; f < frames; f += 8) {
+        for (int c = 0; c < channels; c++) {
+            int16_t* o = out + f * channels + c;
+            for (int k = 0; k < 4; k++) {
+                const uint8_t b = *p++;
+                o[(2 * k) * channels] = ch[c].decode(b & 0x0F);
+                o[(2 * k + 1) * channels] = ch[c].decode(b >> 4);
+            }
+        }
+    }
+    return frames;
+}
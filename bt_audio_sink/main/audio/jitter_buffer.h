@@ -0,0 +1,235 @@
+#pragma once
+
+/*
+ * jitter_buffer.h
+ *
+ * Latency manager for the decoded PCM queue in AudioPipeline.
+ *
+ * Tracks packet arrival jitter (RFC 3550 style: the difference between wall
+ * clock time and audio time between two arrivals) and keeps the buffered audio
+ * near a target depth in milliseconds. The target starts at the per-codec
+ * default and adapts to the measured jitter within [min, max].
+ *
+ * Depth is held by:
+ *   - prebuffering: output is gated after start/underrun until the target
+ *     depth is reached, or PREROLL_GRACE_MS past the time that takes at
+ *     the stream rate if the source delivers slower than that
+ *   - frame slips: when the depth drifts outside a dead band around the
+ *     target, the pipeline stretches or shrinks a block by a few frames
+ *     (interpolated, inaudible) instead of dropping whole buffers
+ *
+ * With pull decoding (APP_AUDIO_PULL_DECODE) most of the depth waits still
+ * encoded in the sink's packet queue: the pipeline reports that backlog as
+ * the PCM it will decode to (setBacklogBytes()), packet arrivals feed the
+ * jitter estimate (noteArrival()) and decoded PCM only the depth
+ * (onDecoded()).
+ *
+ * A link monitor (link_monitor.h) may add a margin to the target while the
+ * radio link is poor (setLinkMarginMs()); it is kept across streams.
+ *
+ * A multi-room follower (sync_link.h) steers by time instead of depth:
+ * in sync mode the error is how late its output runs against the master,
+ * and the pipeline gates the start itself.
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include "esp_timer.h"
+
+class JitterBuffer {
+public:
+    // Configure for a new stream. targetMs is the codec default, maxMs the
+    // most the PCM pool can hold for this format.
+    void configure(uint32_t sampleRate, uint32_t bytesPerFrame, uint32_t targetMs, uint32_t maxMs) {
+        m_sampleRate = sampleRate ? sampleRate : 44100;
+        m_bytesPerFrame = bytesPerFrame ? bytesPerFrame : 4;
+        m_baseTargetMs = targetMs;
+        m_maxMs = (maxMs > MIN_TARGET_MS) ? maxMs : MIN_TARGET_MS;
+        if (m_baseTargetMs > m_maxMs) m_baseTargetMs = m_maxMs;
+        m_targetMs = (float)m_baseTargetMs;
+        m_jitterMs = 0.0f;
+        m_lastArrivalUs = 0;
+        m_lastArrivalFrames = 0;
+        m_bufferedBytes.store(0);
+        m_backlogBytes.store(0);
+        m_playing = false;
+        m_prerollStartUs = 0;
+    }
+
+    // Called from the producer for every chunk of PCM bytes accepted
+    void onArrival(uint32_t bytes) {
+        noteArrival(bytes);
+        onDecoded(bytes);
+    }
+
+    // Pull decoding: a packet of about `bytes` PCM arrived (timing only;
+    // 0 while its size is not known yet)
+    void noteArrival(uint32_t bytes) {
+        int64_t nowUs = esp_timer_get_time();
+        uint32_t frames = bytes / m_bytesPerFrame;
+
+        if (m_lastArrivalUs != 0 && m_lastArrivalFrames != 0) {
+            // Transit variation: wall time elapsed minus audio time delivered
+            float wallMs = (float)(nowUs - m_lastArrivalUs) * 0.001f;
+            float audioMs = (float)m_lastArrivalFrames * 1000.0f / (float)m_sampleRate;
+            float d = wallMs - audioMs;
+            if (d < 0.0f) d = -d;
+            // Ignore stream gaps (pause/resume), they are not jitter
+            if (d < GAP_MS) {
+                m_jitterMs += (d - m_jitterMs) * (1.0f / 16.0f);
+            }
+        }
+        if (!m_playing && m_prerollStartUs == 0) m_prerollStartUs = nowUs;
+        m_lastArrivalUs = nowUs;
+        m_lastArrivalFrames = frames;
+    }
+
+    // Pull decoding: PCM bytes decoded into the queue (depth only)
+    void onDecoded(uint32_t bytes) { m_bufferedBytes.fetch_add(bytes); }
+
+    // Pull decoding: PCM the packets still waiting to be decoded hold
+    void setBacklogBytes(uint32_t bytes) { m_backlogBytes.store(bytes); }
+
+    // Called from the consumer for every chunk of PCM bytes taken
+    void onConsumed(uint32_t bytes) {
+        uint32_t cur = m_bufferedBytes.load();
+        while (!m_bufferedBytes.compare_exchange_weak(cur, bytes > cur ? 0 : cur - bytes)) {
+        }
+    }
+
+    void reset() {
+        m_bufferedBytes.store(0);
+        m_backlogBytes.store(0);
+        m_lastArrivalUs = 0;
+        m_playing = false;
+        m_prerollStartUs = 0;
+        m_syncErrUs = 0;
+    }
+
+    // Sync mode: slips and the drift trim follow setSyncErrorUs() (output
+    // late vs. the master = positive, like excess depth), not the depth
+    void setSyncMode(bool on) { m_syncMode = on; }
+    void setSyncErrorUs(int32_t errUs) { m_syncErrUs = errUs; }
+    int32_t getSyncErrorUs() const { return m_syncErrUs; }
+
+    // Extra target depth while the radio link is poor; the target glides
+    // to it like to a jitter change
+    void setLinkMarginMs(uint32_t ms) { m_linkMarginMs = ms; }
+
+    // Output started by the caller's own gate (sync mode)
+    void startPlaying() { m_playing = true; }
+
+    // Gate output until the target depth is buffered. Also opens if the
+    // producer went quiet (end of stream tail shorter than the target), or
+    // once the pre-roll has run PREROLL_GRACE_MS over the target, so a
+    // source that starts slow cannot hold the start back indefinitely.
+    bool shouldRelease() {
+        if (m_playing) return true;
+        uint32_t depth = getDepthMs();
+        const int64_t nowUs = esp_timer_get_time();
+        const int64_t idleUs = nowUs - m_lastArrivalUs;
+        const int64_t prerollUs = m_prerollStartUs ? nowUs - m_prerollStartUs : 0;
+        if (depth >= (uint32_t)m_targetMs ||
+            (depth > 0 && (idleUs > (int64_t)m_maxMs * 1000 ||
+                           prerollUs > ((int64_t)m_targetMs + PREROLL_GRACE_MS) * 1000))) {
+            m_playing = true;
+        }
+        return m_playing;
+    }
+
+    // Consumer found nothing to play while streaming
+    void onUnderrun() {
+        if (m_playing) {
+            m_playing = false;
+            m_prerollStartUs = 0;
+            m_underruns++;
+            // Widen the target a little; it relaxes again via adapt()
+            m_targetMs += UNDERRUN_STEP_MS;
+            if (m_targetMs > (float)m_maxMs) m_targetMs = (float)m_maxMs;
+        }
+    }
+
+    // Frames to add (>0) or remove (<0) from a block of `frames` frames to
+    // steer the depth towards the target. Also slowly adapts the target.
+    int slipFrames(uint32_t frames) {
+        adapt();
+        int32_t err = getDepthErrorMs();
+        int32_t band = m_syncMode ? SYNC_DEAD_BAND_MS : (int32_t)(m_targetMs * 0.1f) + DEAD_BAND_MS;
+        if (err > -band && err < band) return 0;
+
+        // At most ~0.4% per block (one frame in 256), never on tiny blocks
+        int32_t maxSlip = (int32_t)(frames >> 8);
+        if (maxSlip < 1) maxSlip = (frames >= 128) ? 1 : 0;
+        if (maxSlip < 1) return 0;
+        int32_t slip = (err > 0 ? err : -err) / band;
+        if (slip < 1) slip = 1;
+        if (slip > 4) slip = 4;
+        if (slip > maxSlip) slip = maxSlip;
+        if (err > 0) {
+            m_shrinks++;
+            return -slip;
+        }
+        m_stretches++;
+        return slip;
+    }
+
+    uint32_t getDepthMs() const {
+        uint64_t frames = ((uint64_t)m_bufferedBytes.load() + m_backlogBytes.load()) / m_bytesPerFrame;
+        return (uint32_t)(frames * 1000ULL / m_sampleRate);
+    }
+    uint32_t getBufferedBytes() const { return m_bufferedBytes.load(); }
+    uint32_t getTargetMs() const { return (uint32_t)m_targetMs; }
+    int32_t getDepthErrorMs() const {
+        if (m_syncMode) {
+            const int32_t us = m_syncErrUs;
+            return (us >= 0 ? us + 500 : us - 500) / 1000;
+        }
+        return (int32_t)getDepthMs() - (int32_t)m_targetMs;
+    }
+    float getJitterMs() const { return m_jitterMs; }
+    uint32_t getUnderrunCount() const { return m_underruns; }
+    uint32_t getStretchCount() const { return m_stretches; }
+    uint32_t getShrinkCount() const { return m_shrinks; }
+    bool isPlaying() const { return m_playing; }
+
+private:
+    static constexpr uint32_t MIN_TARGET_MS = 20;
+    static constexpr int32_t DEAD_BAND_MS = 5;
+    static constexpr int32_t SYNC_DEAD_BAND_MS = 2;    // Finer steps are left to the drift trim
+    static constexpr float GAP_MS = 500.0f;
+    static constexpr float UNDERRUN_STEP_MS = 10.0f;
+    static constexpr int64_t PREROLL_GRACE_MS = 150;
+
+    void adapt() {
+        // Cover ~4x the mean deviation, never below the codec default,
+        // plus the link margin
+        float want = (float)m_baseTargetMs;
+        float jitterNeed = m_jitterMs * 4.0f + (float)MIN_TARGET_MS;
+        if (jitterNeed > want) want = jitterNeed;
+        want += (float)m_linkMarginMs;
+        if (want > (float)m_maxMs) want = (float)m_maxMs;
+        // Glide so the slip controller never sees a step
+        m_targetMs += (want - m_targetMs) * (1.0f / 256.0f);
+    }
+
+    uint32_t m_sampleRate = 44100;
+    uint32_t m_bytesPerFrame = 4;
+    uint32_t m_baseTargetMs = 100;
+    uint32_t m_maxMs = 300;
+    volatile float m_targetMs = 100.0f;
+    volatile float m_jitterMs = 0.0f;
+    volatile uint32_t m_linkMarginMs = 0;
+
+    int64_t m_lastArrivalUs = 0;
+    int64_t m_prerollStartUs = 0;      // First arrival while gated, 0 = none yet
+    uint32_t m_lastArrivalFrames = 0;
+    std::atomic<uint32_t> m_bufferedBytes{0};
+    std::atomic<uint32_t> m_backlogBytes{0};   // Still encoded (pull decoding)
+    volatile bool m_playing = false;
+    bool m_syncMode = false;
+    volatile int32_t m_syncErrUs = 0;
+
+    uint32_t m_underruns = 0;
+    uint32_t m_stretches = 0;
+    uint32_t m_shrinks = 0;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+/*
+ * latency_probe.h
+ *
+ * End-to-end latency statistics: time from a media packet reaching the
+ * sink task (btc_a2dp_sink_enque_buf) until its first frame leaves the I2S
+ * DMA. audio_tx is the only writer; BLE and the log read snapshots. Kept per
+ * stream: reset() on every codec change so each codec is measured alone.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include "perf_trace.h"
+
+class LatencyProbe {
+public:
+    // Measurements above this are stalls or a missed reset, not latency
+    static constexpr uint32_t MAX_VALID_US = 2000000;
+
+    // Writer (audio_tx)
+    void add(uint32_t us, uint32_t rtpTs) {
+        if (m_resetReq.exchange(false, std::memory_order_acquire)) {
+            m_hist = TraceHistogram();
+        }
+        if (us > MAX_VALID_US) return;
+        m_hist.add(us);
+        m_lastUs = us;
+        m_lastRtp = rtpTs;
+    }
+
+    // Any task: start a new measurement (applied on the next add)
+    void reset() { m_resetReq.store(true, std::memory_order_release); }
+
+    void snapshot(TraceHistogram& out) const { memcpy(&out, &m_hist, sizeof(out)); }
+    uint32_t getLastUs() const { return m_lastUs; }
+    uint32_t getLastRtp() const { return m_lastRtp; }
+
+    // BLE summary: [count u16, min, avg, p99, max as u16 in 0.1 ms], LE
+    static constexpr size_t SUMMARY_BYTES = 10;
+    size_t serialize(uint8_t* out, size_t cap) const {
+        if (cap < SUMMARY_BYTES) return 0;
+        TraceHistogram h;
+        snapshot(h);
+        size_t idx = 0;
+        put16(out, idx, h.count > 0xFFFF ? 0xFFFF : h.count);
+        put16(out, idx, toTenthMs(h.count ? h.min : 0));
+        put16(out, idx, toTenthMs(h.avg()));
+        put16(out, idx, toTenthMs(h.percentile(99)));
+        put16(out, idx, toTenthMs(h.max));
+        return idx;
+    }
+
+private:
+    static uint32_t toTenthMs(uint32_t us) {
+        uint32_t v = (us + 50) / 100;
+        return v > 0xFFFF ? 0xFFFF : v;
+    }
+
+    static void put16(uint8_t* out, size_t& idx, uint32_t v) {
+        out[idx++] = (uint8_t)v;
+        out[idx++] = (uint8_t)(v >> 8);
+    }
+
+    TraceHistogram m_hist;
+    volatile uint32_t m_lastUs = 0;
+    volatile uint32_t m_lastRtp = 0;
+    std::atomic<bool> m_resetReq{false};
+};
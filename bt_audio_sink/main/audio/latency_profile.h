@@ -0,0 +1,70 @@
+#pragma once
+
+/*
+ * latency_profile.h
+ *
+ * One switch for the latency knobs spread across the sink. BALANCED is
+ * the per-codec behaviour the Kconfig targets describe. GAMING trades
+ * robustness for delay: the jitter target is capped, the I2S DMA chain is
+ * the short one whatever the codec, the limiter looks ahead less, the
+ * stack's media queue is kept shallow (a late burst is dropped rather than
+ * queued behind), analysis runs decimated, and the high-latency codecs
+ * (AAC, aptX HD, LDAC) are not offered, so a source that has aptX LL picks
+ * it. HIFI is the robust end for LDAC: a jitter floor, the deep DMA chain
+ * and aptX LL not offered.
+ *
+ * The codec offer applies from the next AVDTP discovery (reconnect); the
+ * rest is applied to the running stream at once.
+ */
+
+#include <stdint.h>
+#include "codec_config/codec_config.h"
+#include "i2s_output.h"
+#include "../config/app_config.h"
+
+enum LatencyProfileId : uint8_t {
+    LATENCY_PROFILE_BALANCED = 0,
+    LATENCY_PROFILE_GAMING,
+    LATENCY_PROFILE_HIFI,
+    LATENCY_PROFILE_COUNT
+};
+
+struct LatencyProfile {
+    const char* name;
+    uint16_t jitterCapMs;           // 0 = codec target
+    uint16_t jitterFloorMs;         // 0 = codec target
+    int8_t i2sClass;                // I2SLatencyClass, -1 = per codec
+    uint16_t limiterLookaheadUs;    // 0 = APP_DSP_LIMITER_LOOKAHEAD_US
+    uint8_t rxQueueLimit;           // Stack media queue, 0 = its default
+    bool decimateAnalysis;
+    uint32_t hiddenCodecs;          // Bit per a2dp_codec_id_t not offered
+
+    static const LatencyProfile& get(uint8_t id) {
+        static const LatencyProfile s_profiles[LATENCY_PROFILE_COUNT] = {
+            { "balanced", 0, 0, -1, 0, 0, false, 0 },
+            { "gaming", APP_LATENCY_GAMING_JB_MS, 0, I2S_LATENCY_LOW,
+              APP_LATENCY_GAMING_LOOKAHEAD_US, APP_LATENCY_GAMING_RX_QUEUE, true,
+              bit(A2DP_CODEC_ID_AAC) | bit(A2DP_CODEC_ID_APTX_HD) | bit(A2DP_CODEC_ID_LDAC) },
+            { "hifi", 0, APP_LATENCY_HIFI_JB_MS, I2S_LATENCY_DEEP, 0, 0, false,
+              bit(A2DP_CODEC_ID_APTX_LL) },
+        };
+        return s_profiles[id < LATENCY_PROFILE_COUNT ? id : LATENCY_PROFILE_BALANCED];
+    }
+
+    uint32_t jitterTarget(uint32_t codecTargetMs) const {
+        if (jitterCapMs && codecTargetMs > jitterCapMs) return jitterCapMs;
+        if (jitterFloorMs && codecTargetMs < jitterFloorMs) return jitterFloorMs;
+        return codecTargetMs;
+    }
+
+    I2SLatencyClass i2sLatency(I2SLatencyClass codecClass) const {
+        return i2sClass < 0 ? codecClass : (I2SLatencyClass)i2sClass;
+    }
+
+    bool offers(a2dp_codec_id_t codec) const {
+        return codec == A2DP_CODEC_ID_SBC || (hiddenCodecs & bit(codec)) == 0;
+    }
+
+private:
+    static constexpr uint32_t bit(a2dp_codec_id_t codec) { return 1u << codec; }
+};
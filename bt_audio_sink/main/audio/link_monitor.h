@@ -0,0 +1,124 @@
+#pragma once
+
+/*
+ * link_monitor.h
+ *
+ * Tells dropouts caused by the radio link from dropouts caused by the CPU
+ * (APP_LINK_MONITOR). Once a second, while a stream is up, the owner hands
+ * in the sink's counters and the last readings of the source's ACL
+ * (esp_a2d_sink_read_link: RSSI against the golden receive range and the
+ * controller's link quality), and starts the next readings.
+ *
+ * What each counter says about the cause:
+ *   lost       RTP sequence gaps: packets the source flushed after its
+ *              retransmissions ran out, so the air (the receiving host never
+ *              sees baseband retransmissions themselves)
+ *   dropped    "Pkt dropped": the media queue was full, so the sink fell
+ *              behind (CPU)
+ *   underruns  the jitter buffer ran dry: with packets still waiting in
+ *              RxSbcQ the decoder was late (CPU), with none nothing had
+ *              arrived (RF)
+ *
+ * Poor readings or lost packets push the RF level (0-255) up quickly; it
+ * decays over about half a minute of clean air. The level feeds the jitter
+ * buffer as extra target depth (jitterMarginMs()) and the codec policy as
+ * seconds of degraded RF (rfDegraded()), and all of it goes out as the LINK
+ * section of the BLE telemetry frame.
+ */
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_a2dp_api.h"
+#include "../config/app_config.h"
+
+class LinkMonitor {
+public:
+    enum Cause : uint8_t { CAUSE_NONE, CAUSE_RF, CAUSE_CPU };
+
+    struct Snapshot {
+        int8_t rssi;                // dB outside the golden range, 0 inside
+        uint8_t quality;            // Controller link quality, 255 best
+        uint8_t rfLevel;            // 0 clean - 255 poor
+        uint16_t queued;            // Packets waiting in RxSbcQ
+        uint16_t rfGlitches;        // Losses and underruns put down to RF (wrap)
+        uint16_t cpuGlitches;       // Drops and underruns put down to the CPU (wrap)
+        Cause last;                 // Cause of the last glitch
+    };
+
+    // Control task, once a second while streaming: the last readings and
+    // the stream's counters; the rx counters restart with every codec
+    void sample(const esp_a2d_sink_link_stats_t& link, const esp_a2d_sink_rx_stats_t& rx,
+                uint16_t queued, uint32_t underruns) {
+        // Counters went back: a new stream, no deltas from this sample
+        const bool restart = rx.received < m_received;
+        const uint32_t lost = restart ? 0 : rx.lost - m_lost;
+        const uint32_t dropped = restart ? 0 : rx.dropped - m_dropped;
+        const uint32_t starved = underruns - m_underruns;
+        m_received = rx.received;
+        m_lost = rx.lost;
+        m_dropped = rx.dropped;
+        m_underruns = underruns;
+
+        const bool freshRssi = link.rssi_readings != m_rssiReadings;
+        const bool freshQuality = link.quality_readings != m_qualityReadings;
+        m_rssiReadings = link.rssi_readings;
+        m_qualityReadings = link.quality_readings;
+        const bool poor = lost > 0 ||
+                          (freshRssi && link.rssi <= -APP_LINK_MONITOR_RSSI_POOR) ||
+                          (freshQuality && link.link_quality < APP_LINK_MONITOR_QUALITY_POOR);
+
+        uint32_t rfLevel = m_snap.rfLevel;
+        if (poor) {
+            rfLevel += (255 - rfLevel + 3) / 4;     // Four bad seconds to ~200
+        } else {
+            rfLevel -= (rfLevel + 15) / 16;         // Half-life of about 11 s
+        }
+
+        // Underruns with packets still queued were the decoder's
+        uint32_t rf = lost;
+        uint32_t cpu = dropped;
+        if (starved) {
+            if (queued > 0 && !poor) cpu += starved;
+            else rf += starved;
+        }
+
+        portENTER_CRITICAL(&m_lock);
+        if (freshRssi) m_snap.rssi = link.rssi;
+        if (freshQuality) m_snap.quality = link.link_quality;
+        m_snap.rfLevel = (uint8_t)rfLevel;
+        m_snap.queued = queued;
+        m_snap.rfGlitches += (uint16_t)rf;
+        m_snap.cpuGlitches += (uint16_t)cpu;
+        if (rf || cpu) m_snap.last = rf >= cpu ? CAUSE_RF : CAUSE_CPU;
+        portEXIT_CRITICAL(&m_lock);
+    }
+
+    Snapshot snapshot() {
+        portENTER_CRITICAL(&m_lock);
+        Snapshot s = m_snap;
+        portEXIT_CRITICAL(&m_lock);
+        return s;
+    }
+
+    // RF bad enough to count against the codec
+    bool rfDegraded() const { return m_snap.rfLevel >= DEGRADED_LEVEL; }
+
+    // Extra jitter-buffer depth for the air as it is
+    uint32_t jitterMarginMs() const {
+        return (uint32_t)APP_LINK_MONITOR_MARGIN_MS * m_snap.rfLevel / 255;
+    }
+
+private:
+    static constexpr uint8_t DEGRADED_LEVEL = 128;
+
+    portMUX_TYPE m_lock = portMUX_INITIALIZER_UNLOCKED;
+    Snapshot m_snap = {0, 255, 0, 0, 0, 0, CAUSE_NONE};
+
+    // Control task: counters at the last sample
+    uint32_t m_received = 0;
+    uint32_t m_lost = 0;
+    uint32_t m_dropped = 0;
+    uint32_t m_underruns = 0;
+    uint16_t m_rssiReadings = 0;
+    uint16_t m_qualityReadings = 0;
+};
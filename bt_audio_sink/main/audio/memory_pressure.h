@@ -0,0 +1,175 @@
+#pragma once
+
+/*
+ * memory_pressure.h
+ *
+ * Degradation ladder for low internal RAM. Instead of letting the A2DP sink
+ * purge its packet queue at the first sign of pressure, the app gives up
+ * the cheapest things first and climbs one tier at a time:
+ *
+ *   LIGHT   LED effects and BLE level notifications paused
+ *   SHRINK  low-bitrate internal ring handed back to the heap
+ *   REDUCE  3D sound and audio analysis off
+ *   SHED    the sink may drop queued packets (esp_a2d_sink_memory_pressure_hook)
+ *
+ * A poll task follows heap_caps_get_free_size(); an allocation failure
+ * reported by the stack climbs a tier right away. Tiers are left one at a
+ * time once free RAM has stayed above the threshold plus the hysteresis for
+ * the hold time. The owner applies each tier in the callback.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "../config/app_config.h"
+
+enum MemoryTier : uint8_t {
+    MEM_TIER_NORMAL,
+    MEM_TIER_LIGHT,
+    MEM_TIER_SHRINK,
+    MEM_TIER_REDUCE,
+    MEM_TIER_SHED,
+    MEM_TIER_COUNT
+};
+
+class MemoryPressure {
+public:
+    // Called from the poll task for every tier change (always one step)
+    typedef void (*TierCallback)(MemoryTier tier, MemoryTier prev);
+
+    struct Stats {
+        uint32_t entries[MEM_TIER_COUNT];   // Times each tier was entered
+        uint32_t shedAllowed;               // Sink drops let through
+        uint32_t shedDenied;                // Sink drops held off
+        uint32_t allocFailures;             // Lower-layer allocations that failed
+        uint32_t minFree;                   // Lowest free internal RAM seen (bytes)
+    };
+
+    static const char* tierName(MemoryTier tier) {
+        static const char* const kNames[MEM_TIER_COUNT] = { "normal", "light", "shrink", "reduce", "shed" };
+        return tier < MEM_TIER_COUNT ? kNames[tier] : "?";
+    }
+
+    void setTierCallback(TierCallback cb) { m_callback = cb; }
+
+    // Poll task: wait for the next poll or an allocation failure
+    void wait(TickType_t timeout) {
+        m_task = xTaskGetCurrentTaskHandle();
+        ulTaskNotifyTake(pdTRUE, timeout);
+    }
+
+    // Poll task: follow free internal RAM, at most one tier per call
+    void poll() {
+        uint32_t freeBytes = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (freeBytes < m_minFree.load(std::memory_order_relaxed)) {
+            m_minFree.store(freeBytes, std::memory_order_relaxed);
+        }
+
+        MemoryTier cur = tier();
+        MemoryTier want = target(freeBytes, cur);
+        // The stack already failed an allocation: step up even if the
+        // thresholds do not ask for it yet
+        if (m_urgent.exchange(false) && want <= cur && cur < MEM_TIER_SHED) {
+            want = (MemoryTier)(cur + 1);
+        }
+
+        if (want > cur) {
+            m_recoverSinceUs = 0;
+            enter((MemoryTier)(cur + 1), cur, freeBytes);
+        } else if (want < cur) {
+            int64_t now = esp_timer_get_time();
+            if (m_recoverSinceUs == 0) {
+                m_recoverSinceUs = now;
+            } else if (now - m_recoverSinceUs >= (int64_t)APP_MEM_PRESSURE_HOLD_MS * 1000) {
+                m_recoverSinceUs = now;     // Next step down needs its own hold
+                enter((MemoryTier)(cur - 1), cur, freeBytes);
+            }
+        } else {
+            m_recoverSinceUs = 0;
+        }
+    }
+
+    // Sink side (esp_a2d_sink_memory_pressure_hook): may queued packets go?
+    bool allowShed(bool allocFailed) {
+        if (allocFailed) {
+            m_allocFailures.fetch_add(1, std::memory_order_relaxed);
+            m_urgent.store(true);
+            TaskHandle_t task = m_task;
+            if (task) xTaskNotifyGive(task);
+        }
+        bool allow = tier() >= MEM_TIER_SHED;
+        (allow ? m_shedAllowed : m_shedDenied).fetch_add(1, std::memory_order_relaxed);
+        return allow;
+    }
+
+    MemoryTier tier() const { return m_tier.load(std::memory_order_relaxed); }
+
+    void getStats(Stats& s) const {
+        for (int i = 0; i < MEM_TIER_COUNT; i++) {
+            s.entries[i] = m_entries[i].load(std::memory_order_relaxed);
+        }
+        s.shedAllowed = m_shedAllowed.load(std::memory_order_relaxed);
+        s.shedDenied = m_shedDenied.load(std::memory_order_relaxed);
+        s.allocFailures = m_allocFailures.load(std::memory_order_relaxed);
+        s.minFree = m_minFree.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr const char* TAG = "MemPressure";
+    // Same as MEMORY_PRESSURE_THRESHOLD_KB in btc_a2dp_sink.c: below it
+    // the sink asks before every packet it queues
+    static constexpr uint32_t SHED_BYTES = 24 * 1024;
+
+    static uint32_t threshold(MemoryTier tier) {
+        switch (tier) {
+            case MEM_TIER_LIGHT:  return APP_MEM_PRESSURE_LIGHT_KB * 1024u;
+            case MEM_TIER_SHRINK: return APP_MEM_PRESSURE_SHRINK_KB * 1024u;
+            case MEM_TIER_REDUCE: return APP_MEM_PRESSURE_REDUCE_KB * 1024u;
+            case MEM_TIER_SHED:   return SHED_BYTES;
+            default:              return 0;
+        }
+    }
+
+    // Deepest tier free RAM calls for; tiers already in force hold on
+    // until the hysteresis is cleared as well
+    static MemoryTier target(uint32_t freeBytes, MemoryTier cur) {
+        for (int t = MEM_TIER_SHED; t > MEM_TIER_NORMAL; t--) {
+            uint32_t limit = threshold((MemoryTier)t);
+            if (t <= cur) limit += APP_MEM_PRESSURE_HYSTERESIS_KB * 1024u;
+            if (freeBytes < limit) return (MemoryTier)t;
+        }
+        return MEM_TIER_NORMAL;
+    }
+
+    void enter(MemoryTier next, MemoryTier prev, uint32_t freeBytes) {
+        m_tier.store(next, std::memory_order_relaxed);
+        m_entries[next].fetch_add(1, std::memory_order_relaxed);
+        if (m_callback) m_callback(next, prev);
+
+        Stats s;
+        getStats(s);
+        ESP_LOGW(TAG, "Tier %s -> %s: %u KB free (min %u KB), entered %u/%u/%u/%u, "
+                 "shed %u allowed %u held, %u alloc failures",
+                 tierName(prev), tierName(next),
+                 (unsigned)(freeBytes / 1024), (unsigned)(s.minFree / 1024),
+                 (unsigned)s.entries[MEM_TIER_LIGHT], (unsigned)s.entries[MEM_TIER_SHRINK],
+                 (unsigned)s.entries[MEM_TIER_REDUCE], (unsigned)s.entries[MEM_TIER_SHED],
+                 (unsigned)s.shedAllowed, (unsigned)s.shedDenied, (unsigned)s.allocFailures);
+    }
+
+    std::atomic<MemoryTier> m_tier{MEM_TIER_NORMAL};
+    std::atomic<bool> m_urgent{false};          // Allocation failed since the last poll
+    volatile TaskHandle_t m_task = nullptr;
+    TierCallback m_callback = nullptr;
+    int64_t m_recoverSinceUs = 0;               // Poll task: below target since
+    std::atomic<uint32_t> m_entries[MEM_TIER_COUNT] = {};
+    std::atomic<uint32_t> m_shedAllowed{0};
+    std::atomic<uint32_t> m_shedDenied{0};
+    std::atomic<uint32_t> m_allocFailures{0};
+    std::atomic<uint32_t> m_minFree{UINT32_MAX};
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+/*
+ * memory_probe.h
+ *
+ * Snapshot of what the heap actually offers at startup. APP_HAS_PSRAM only
+ * says the build expects PSRAM; this says whether it was found and how much
+ * internal RAM is really left once BT, WiFi and the tasks are up, so buffer
+ * placement can be decided per board instead of per build.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+struct MemoryProbe {
+    bool hasPsram = false;
+    size_t internalFree = 0;
+    size_t internalLargest = 0;
+    size_t psramFree = 0;
+    size_t psramLargest = 0;
+
+    static MemoryProbe run() {
+        MemoryProbe p;
+        p.internalFree = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        p.internalLargest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        p.hasPsram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+        if (p.hasPsram) {
+            p.psramFree = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+            p.psramLargest = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+        }
+        return p;
+    }
+
+    // How much of `want` bytes can go to internal RAM while leaving
+    // `reserve` bytes free. 0 if not even `minBytes` fits.
+    size_t internalBudget(size_t want, size_t reserve, size_t minBytes) const {
+        if (internalFree <= reserve) return 0;
+        size_t avail = internalFree - reserve;
+        if (avail > internalLargest) avail = internalLargest;
+        if (avail > want) avail = want;
+        return (avail >= minBytes) ? avail : 0;
+    }
+
+    void log(const char* tag) const {
+        ESP_LOGI(tag, "Memory probe: internal %u KB free (largest %u KB), PSRAM %s %u KB free (largest %u KB)",
+                 (unsigned)(internalFree / 1024), (unsigned)(internalLargest / 1024),
+                 hasPsram ? "present," : "absent,",
+                 (unsigned)(psramFree / 1024), (unsigned)(psramLargest / 1024));
+    }
+};
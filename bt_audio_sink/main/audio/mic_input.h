@@ -0,0 +1,97 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Mic Input - I2S RX channel for the hands-free microphone
+// One mono I2S MEMS mic on APP_HFP_MIC_I2S_PORT: 24 bits, left-justified
+// in the left 32-bit slot. The channel exists only during a call: start()
+// creates it with a DMA chain of three blocks, so a read returns one block
+// after it was spoken, and stop() frees it again for A2DP's sake.
+// When the output runs at the mic's rate the mic is clocked from the same
+// APLL, so drift trims on the output move the mic as well and the echo
+// canceller's reference stays aligned.
+// Single owner task (the HFP uplink task).
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include "driver/i2s_std.h"
+#include "esp_log.h"
+#include "soc/soc_caps.h"
+#include "../config/app_config.h"
+
+class MicInput {
+public:
+    MicInput() = default;
+    MicInput(const MicInput&) = delete;
+    MicInput& operator=(const MicInput&) = delete;
+    ~MicInput() { stop(); }
+
+    // Open the channel at sampleRate, blockFrames per DMA buffer
+    esp_err_t start(uint32_t sampleRate, uint32_t blockFrames, bool useApll) {
+        stop();
+        i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG((i2s_port_t)APP_HFP_MIC_I2S_PORT, I2S_ROLE_MASTER);
+        chan_cfg.dma_desc_num = DMA_BLOCKS;
+        chan_cfg.dma_frame_num = blockFrames;
+
+        i2s_std_config_t std_cfg = {
+            .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sampleRate),
+            .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT, I2S_SLOT_MODE_MONO),
+            .gpio_cfg = {
+                .mclk = I2S_GPIO_UNUSED,
+                .bclk = (gpio_num_t)APP_HFP_MIC_BCK_PIN,
+                .ws = (gpio_num_t)APP_HFP_MIC_WS_PIN,
+                .dout = I2S_GPIO_UNUSED,
+                .din = (gpio_num_t)APP_HFP_MIC_DATA_PIN,
+                .invert_flags = {},
+            },
+        };
+        std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_LEFT;
+        std_cfg.clk_cfg.mclk_multiple = I2S_MCLK_MULTIPLE_256;
+#if SOC_CLK_APLL_SUPPORTED
+        if (useApll) std_cfg.clk_cfg.clk_src = I2S_CLK_SRC_APLL;
+#else
+        (void)useApll;
+#endif
+
+        esp_err_t err = i2s_new_channel(&chan_cfg, NULL, &m_rx);
+        if (err == ESP_OK) err = i2s_channel_init_std_mode(m_rx, &std_cfg);
+        if (err == ESP_OK) err = i2s_channel_enable(m_rx);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Mic channel setup failed: %s", esp_err_to_name(err));
+            if (m_rx) i2s_del_channel(m_rx);
+            m_rx = nullptr;
+            return err;
+        }
+        m_blockFrames = blockFrames;
+        ESP_LOGI(TAG, "Mic on I2S%d: %u Hz, DMA %ux%u%s", (int)APP_HFP_MIC_I2S_PORT, (unsigned)sampleRate,
+                 (unsigned)DMA_BLOCKS, (unsigned)blockFrames, useApll ? ", APLL" : "");
+        return ESP_OK;
+    }
+
+    void stop() {
+        if (!m_rx) return;
+        i2s_channel_disable(m_rx);
+        i2s_del_channel(m_rx);
+        m_rx = nullptr;
+    }
+
+    bool running() const { return m_rx != nullptr; }
+
+    // Block until frames samples (Q31, full scale +-2^31) are in; false on
+    // timeout or with the channel closed
+    bool read(int32_t* out, uint32_t frames, uint32_t timeoutMs) {
+        if (!m_rx) return false;
+        size_t got = 0;
+        const esp_err_t err = i2s_channel_read(m_rx, out, frames * sizeof(int32_t), &got, timeoutMs);
+        return err == ESP_OK && got == frames * sizeof(int32_t);
+    }
+
+    // Capture latency the DMA adds: the block being filled
+    uint32_t blockFrames() const { return m_blockFrames; }
+
+private:
+    static constexpr const char* TAG = "Mic";
+    static constexpr uint32_t DMA_BLOCKS = 3;
+
+    i2s_chan_handle_t m_rx = nullptr;
+    uint32_t m_blockFrames = 0;
+};
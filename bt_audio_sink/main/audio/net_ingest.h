@@ -0,0 +1,432 @@
+#pragma once
+
+/*
+ * net_ingest.h
+ *
+ * Lossless input over WiFi: 16- or 24-bit PCM at up to 96 kHz, received
+ * over RTP/UDP and enqueued into the AudioPipeline like a decoded A2DP
+ * packet, so the same jitter buffer, frame slips and APLL drift trim
+ * carry it to the DAC. The jitter target is fixed (APP_NET_INGEST_TARGET_MS)
+ * and only widens when the measured jitter asks for more.
+ *
+ * Wire format (UDP on APP_NET_INGEST_PORT, RTP v2 header, network byte
+ * order throughout):
+ *   PT_AUDIO  RTP timestamp in frames at the stream rate, then a FmtHeader
+ *             (rate, bits 16/24, channels) and the PCM, big-endian L16/L24
+ *             interleaved as in RFC 3551/3190. Up to MAX_PCM_BYTES each.
+ *   PT_FEC    Row parity after every N audio packets (N <= MAX_GROUP),
+ *             with sequence numbers of its own: a FecHeader (first audio
+ *             sequence number, N, XOR of the payload lengths) and the XOR
+ *             of the N payloads, each zero-padded to the longest. One lost
+ *             packet per row is rebuilt.
+ *
+ * Receive: packets wait in a reorder window indexed by sequence number
+ * and leave in order. A gap is held until the row's parity can rebuild
+ * it, or until packets more than a row past it came in; then it is
+ * played as silence of the length the timestamps say, so the timeline
+ * (and the latency) does not move. No FEC from the sender: a gap waits
+ * for REORDER_PACKETS only.
+ *
+ * A local A2DP stream takes precedence: while one plays, ingest packets
+ * are dropped and the output goes back to it. The radio is shared with
+ * BT through the coexistence scheduler (see wifi_station.h); since the
+ * two never stream at once, each gets the airtime it needs.
+ *
+ * One task (rx) owns the window and calls the format callback.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "../config/app_config.h"
+#include "../core/static_alloc.h"
+#include "../core/mem_placement.h"
+#include "../core/wifi_station.h"
+#include "audio_pipeline.h"
+
+#if APP_NET_INGEST
+
+class NetIngest {
+public:
+    // The stream's format changed; sampleRate 0 when it ended. From the
+    // rx task, before the first packet in the new format is enqueued.
+    typedef void (*FormatCallback)(uint32_t sampleRate, SampleFmt fmt, uint8_t channels);
+
+    static NetIngest& getInstance() {
+        static NetIngest instance;
+        return instance;
+    }
+
+    // WiFi station, socket, window and rx task. After the pipeline is up.
+    bool begin(AudioPipeline& pipeline, FormatCallback onFormat) {
+        m_pipeline = &pipeline;
+        m_onFormat = onFormat;
+        m_slots = (Slot*)MemPlacement::alloc("ingest_window", MEM_OWNER_AUDIO, sizeof(Slot) * WINDOW, MEM_PSRAM);
+        m_fec = (Slot*)MemPlacement::alloc("ingest_fec", MEM_OWNER_AUDIO, sizeof(Slot) * FEC_SLOTS, MEM_PSRAM);
+        if (!m_slots || !m_fec) return false;
+        memset(m_slots, 0, sizeof(Slot) * WINDOW);
+        memset(m_fec, 0, sizeof(Slot) * FEC_SLOTS);
+        if (!WifiStation::start(APP_NET_INGEST_WIFI_SSID, APP_NET_INGEST_WIFI_PASSWORD, &onWifiEvent, this) ||
+            !openSocket()) {
+            return false;
+        }
+        StaticAlloc::createTask(rxTask, "ingest_rx", 4096, this, 7, nullptr, APP_CONTROL_CORE);
+        ESP_LOGI(TAG, "WiFi ingest on UDP %d, jitter target %u ms", APP_NET_INGEST_PORT,
+                 (unsigned)APP_NET_INGEST_TARGET_MS);
+        return true;
+    }
+
+    // A local A2DP stream plays (or stopped): ingest yields to it
+    void setLocalStream(bool active) { m_localStream.store(active); }
+
+    // The output was set up for something else (an A2DP codec config):
+    // announce the format again with the next packet
+    void reannounce() { m_reannounce.store(true); }
+
+    bool isActive() const { return m_active; }
+
+private:
+    static constexpr const char* TAG = "Ingest";
+    static constexpr uint8_t PT_AUDIO = 96;
+    static constexpr uint8_t PT_FEC = 97;
+    static constexpr uint32_t MAX_PCM_BYTES = 1440;         // 240 frames of 24-bit stereo
+    static constexpr uint32_t WINDOW = 16;                  // Power of two
+    static constexpr uint32_t FEC_SLOTS = 4;                // Power of two
+    static constexpr uint32_t MAX_GROUP = 8;
+    static constexpr uint32_t REORDER_PACKETS = 2;
+    static constexpr uint32_t MAX_GAP_MS = 200;             // Longer: a new timeline, not a loss
+    static constexpr int64_t IDLE_TIMEOUT_US = 1000000;
+    static constexpr int64_t STATUS_PERIOD_US = 10000000;
+
+    struct __attribute__((packed)) RtpHeader {
+        uint8_t vpxcc;
+        uint8_t mpt;
+        uint16_t seq;
+        uint32_t ts;
+        uint32_t ssrc;
+    };
+    struct __attribute__((packed)) FmtHeader {
+        uint32_t sampleRate;
+        uint8_t bits;
+        uint8_t channels;
+        uint16_t reserved;
+    };
+    struct __attribute__((packed)) FecHeader {
+        uint16_t baseSeq;
+        uint8_t count;
+        uint8_t reserved;
+        uint16_t lenXor;
+        uint16_t reserved2;
+    };
+    static constexpr uint32_t MAX_PAYLOAD = sizeof(FmtHeader) + MAX_PCM_BYTES;
+
+    // Audio: payload after the RTP header. FEC: the parity after the FecHeader.
+    struct Slot {
+        uint32_t ts;
+        uint16_t seq;
+        uint16_t len;
+        uint8_t count;          // FEC row length
+        bool valid;             // Waiting to be played
+        bool played;            // Played; kept for rebuilding its row
+        uint8_t data[MAX_PAYLOAD];
+    };
+
+    NetIngest() = default;
+
+    static void onWifiEvent(void* arg, esp_event_base_t base, int32_t id, void* data) {
+        NetIngest* self = (NetIngest*)arg;
+        if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+            self->m_hasIp = false;
+        } else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+            self->m_hasIp = true;
+            ESP_LOGI(TAG, "WiFi up");
+        }
+    }
+
+    bool openSocket() {
+        m_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (m_sock < 0) {
+            ESP_LOGE(TAG, "socket() failed");
+            return false;
+        }
+        sockaddr_in local = {};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(APP_NET_INGEST_PORT);
+        local.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(m_sock, (sockaddr*)&local, sizeof(local)) < 0) {
+            ESP_LOGE(TAG, "bind() failed");
+            close(m_sock);
+            m_sock = -1;
+            return false;
+        }
+        timeval tv = { 0, 100000 };     // Idle and status checks between packets
+        setsockopt(m_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        return true;
+    }
+
+    // ---- rx task ----
+
+    static void rxTask(void* arg) {
+        ((NetIngest*)arg)->rxLoop();
+    }
+
+    void rxLoop() {
+        int64_t nextStatusUs = esp_timer_get_time() + STATUS_PERIOD_US;
+        for (;;) {
+            if (!m_hasIp) {
+                vTaskDelay(pdMS_TO_TICKS(200));
+                continue;
+            }
+            const int n = recv(m_sock, m_packet, sizeof(m_packet), 0);
+            const int64_t nowUs = esp_timer_get_time();
+            if (m_localStream.load()) {
+                if (m_active) stop("A2DP stream");
+            } else if (n >= (int)sizeof(RtpHeader)) {
+                onPacket(m_packet, (uint32_t)n, nowUs);
+            }
+            if (m_active && nowUs - m_lastRxUs > IDLE_TIMEOUT_US) stop("idle");
+            if (nowUs >= nextStatusUs) {
+                nextStatusUs = nowUs + STATUS_PERIOD_US;
+                if (m_active) {
+                    ESP_LOGI(TAG, "%u Hz %u-bit: %u packets, %u rebuilt, %u concealed, %u late, %u resyncs",
+                             (unsigned)m_rate, (unsigned)m_bits, (unsigned)m_packets, (unsigned)m_rebuilt,
+                             (unsigned)m_concealed, (unsigned)m_late, (unsigned)m_resyncs);
+                }
+            }
+        }
+    }
+
+    void onPacket(const uint8_t* pkt, uint32_t len, int64_t nowUs) {
+        RtpHeader h;
+        memcpy(&h, pkt, sizeof(h));
+        if ((h.vpxcc & 0xC0) != 0x80) return;
+        const uint8_t pt = h.mpt & 0x7F;
+        const uint16_t seq = ntohs(h.seq);
+        const uint8_t* payload = pkt + sizeof(RtpHeader);
+        const uint32_t payloadLen = len - sizeof(RtpHeader);
+        m_lastRxUs = nowUs;
+
+        if (pt == PT_FEC) {
+            if (payloadLen <= sizeof(FecHeader) || payloadLen - sizeof(FecHeader) > MAX_PAYLOAD) return;
+            FecHeader f;
+            memcpy(&f, payload, sizeof(f));
+            if (f.count < 2 || f.count > MAX_GROUP) return;
+            Slot& s = m_fec[seq & (FEC_SLOTS - 1)];
+            s.seq = ntohs(f.baseSeq);
+            s.count = f.count;
+            s.len = ntohs(f.lenXor);
+            const uint32_t parityLen = payloadLen - sizeof(FecHeader);
+            memcpy(s.data, payload + sizeof(FecHeader), parityLen);
+            memset(s.data + parityLen, 0, MAX_PAYLOAD - parityLen);
+            s.valid = true;
+            m_rowSize = f.count;
+        } else if (pt == PT_AUDIO) {
+            if (payloadLen <= sizeof(FmtHeader) || payloadLen > MAX_PAYLOAD) return;
+            m_packets++;
+            if (!m_synced) resync(seq);
+            const int16_t ahead = (int16_t)(uint16_t)(seq - m_nextSeq);
+            if (ahead < 0) {
+                m_late++;
+                return;
+            }
+            if ((uint32_t)ahead >= WINDOW) {
+                // Beyond the window: play out what is here, start over
+                flushWindow();
+                resync(seq);
+            }
+            Slot& s = m_slots[seq & (WINDOW - 1)];
+            s.seq = seq;
+            s.ts = ntohl(h.ts);
+            s.len = (uint16_t)payloadLen;
+            memcpy(s.data, payload, payloadLen);
+            s.valid = true;
+            s.played = false;
+            if ((int16_t)(uint16_t)(seq - m_newestSeq) > 0) m_newestSeq = seq;
+        } else {
+            return;
+        }
+        drain();
+    }
+
+    void resync(uint16_t seq) {
+        for (uint32_t i = 0; i < WINDOW; i++) m_slots[i].valid = m_slots[i].played = false;
+        m_nextSeq = seq;
+        m_newestSeq = seq;
+        m_tsValid = false;
+        if (m_synced) m_resyncs++;
+        m_synced = true;
+    }
+
+    // Everything up to the newest packet, gaps concealed
+    void flushWindow() {
+        while ((int16_t)(uint16_t)(m_newestSeq - m_nextSeq) >= 0) {
+            if (!deliverNext()) concealNext();
+        }
+    }
+
+    // Deliver in order while possible; a gap waits for its parity or gives up
+    void drain() {
+        while ((int16_t)(uint16_t)(m_newestSeq - m_nextSeq) >= 0) {
+            if (deliverNext() || rebuildNext()) continue;
+            const uint32_t hold = m_rowSize ? m_rowSize + 1 : REORDER_PACKETS;
+            if ((uint16_t)(m_newestSeq - m_nextSeq) < hold) return;
+            concealNext();
+        }
+    }
+
+    bool deliverNext() {
+        Slot& s = m_slots[m_nextSeq & (WINDOW - 1)];
+        if (!s.valid || s.seq != m_nextSeq) return false;
+        s.valid = false;
+        s.played = true;
+        play(s);
+        m_nextSeq++;
+        return true;
+    }
+
+    // XOR of the row's parity and its other members
+    bool rebuildNext() {
+        for (uint32_t i = 0; i < FEC_SLOTS; i++) {
+            Slot& f = m_fec[i];
+            if (!f.valid || (uint16_t)(m_nextSeq - f.seq) >= f.count) continue;
+            for (uint32_t k = 0; k < f.count; k++) {
+                const uint16_t seq = (uint16_t)(f.seq + k);
+                if (seq == m_nextSeq) continue;
+                const Slot& m = m_slots[seq & (WINDOW - 1)];
+                if (!(m.valid || m.played) || m.seq != seq) return false;
+            }
+            Slot& s = m_slots[m_nextSeq & (WINDOW - 1)];
+            memcpy(s.data, f.data, MAX_PAYLOAD);
+            uint16_t len = f.len;
+            for (uint32_t k = 0; k < f.count; k++) {
+                const uint16_t seq = (uint16_t)(f.seq + k);
+                if (seq == m_nextSeq) continue;
+                const Slot& m = m_slots[seq & (WINDOW - 1)];
+                for (uint32_t b = 0; b < m.len; b++) s.data[b] ^= m.data[b];
+                len ^= m.len;
+            }
+            f.valid = false;
+            if (len <= sizeof(FmtHeader) || len > MAX_PAYLOAD) return false;
+            s.seq = m_nextSeq;
+            s.len = len;
+            // The timestamp is not protected: it follows the last one
+            s.ts = m_nextTs;
+            s.valid = true;
+            m_rebuilt++;
+            return deliverNext();
+        }
+        return false;
+    }
+
+    // The missing packet as silence, as long as the timestamps around it say
+    void concealNext() {
+        uint32_t frames = m_lastFrames;
+        for (uint16_t seq = m_nextSeq + 1; (int16_t)(uint16_t)(m_newestSeq - seq) >= 0; seq++) {
+            const Slot& s = m_slots[seq & (WINDOW - 1)];
+            if (!s.valid || s.seq != seq || !m_tsValid) continue;
+            frames = (s.ts - m_nextTs) / (uint16_t)(seq - m_nextSeq);
+            break;
+        }
+        m_nextSeq++;
+        m_concealed++;
+        if (!m_active || !frames || frames * 1000 > MAX_GAP_MS * m_rate) return;
+        const uint32_t bytesPerFrame = sampleFmtBytes(m_fmt) * m_channels;
+        uint32_t bytes = frames * bytesPerFrame;
+        while (bytes) {
+            const uint32_t n = bytes < MAX_PCM_BYTES - MAX_PCM_BYTES % bytesPerFrame
+                                   ? bytes : MAX_PCM_BYTES - MAX_PCM_BYTES % bytesPerFrame;
+            m_pipeline->enqueue(s_silence, n, m_fmt, m_channels);
+            bytes -= n;
+        }
+        m_nextTs += frames;
+    }
+
+    void play(Slot& s) {
+        FmtHeader f;
+        memcpy(&f, s.data, sizeof(f));
+        const uint32_t rate = ntohl(f.sampleRate);
+        if ((f.bits != 16 && f.bits != 24) || f.channels < 1 || f.channels > 2 || rate < 8000 || rate > 96000) return;
+        const SampleFmt fmt = f.bits == 16 ? SAMPLE_FMT_S16 : SAMPLE_FMT_S24_PACKED;
+        const uint32_t bytesPerFrame = (f.bits / 8) * f.channels;
+        const uint8_t* pcm = s.data + sizeof(FmtHeader);
+        const uint32_t pcmLen = (s.len - sizeof(FmtHeader)) / bytesPerFrame * bytesPerFrame;
+
+        if (!m_active || m_reannounce.exchange(false) || rate != m_rate || fmt != m_fmt || f.channels != m_channels) {
+            m_rate = rate;
+            m_fmt = fmt;
+            m_bits = f.bits;
+            m_channels = f.channels;
+            m_active = true;
+            ESP_LOGI(TAG, "Stream: %u Hz, %u-bit, %u ch", (unsigned)rate, (unsigned)f.bits, (unsigned)f.channels);
+            if (m_onFormat) m_onFormat(rate, fmt, f.channels);
+        }
+
+        // Network order to the pipeline's little-endian layouts; the slot
+        // stays as received for its row's parity
+        if (f.bits == 16) {
+            for (uint32_t i = 0; i + 1 < pcmLen; i += 2) {
+                m_pcm[i] = pcm[i + 1];
+                m_pcm[i + 1] = pcm[i];
+            }
+        } else {
+            for (uint32_t i = 0; i + 2 < pcmLen; i += 3) {
+                m_pcm[i] = pcm[i + 2];
+                m_pcm[i + 1] = pcm[i + 1];
+                m_pcm[i + 2] = pcm[i];
+            }
+        }
+        const uint32_t frames = pcmLen / bytesPerFrame;
+        m_nextTs = s.ts + frames;
+        m_tsValid = true;
+        m_lastFrames = frames;
+        m_pipeline->enqueue(m_pcm, pcmLen, fmt, f.channels);
+    }
+
+    void stop(const char* why) {
+        m_active = false;
+        m_synced = false;
+        m_rowSize = 0;
+        for (uint32_t i = 0; i < FEC_SLOTS; i++) m_fec[i].valid = false;
+        ESP_LOGI(TAG, "Stream ended (%s)", why);
+        if (m_onFormat) m_onFormat(0, SAMPLE_FMT_S16, 0);
+    }
+
+    AudioPipeline* m_pipeline = nullptr;
+    FormatCallback m_onFormat = nullptr;
+    int m_sock = -1;
+    volatile bool m_hasIp = false;
+    std::atomic<bool> m_localStream{false};
+    std::atomic<bool> m_reannounce{false};
+
+    // rx task only
+    Slot* m_slots = nullptr;
+    Slot* m_fec = nullptr;
+    uint8_t m_packet[sizeof(RtpHeader) + MAX_PAYLOAD + 32];
+    uint8_t m_pcm[MAX_PCM_BYTES];
+    bool m_synced = false;
+    bool m_active = false;
+    bool m_tsValid = false;
+    uint16_t m_nextSeq = 0;
+    uint16_t m_newestSeq = 0;
+    uint32_t m_nextTs = 0;
+    uint32_t m_lastFrames = 0;
+    uint32_t m_rowSize = 0;
+    int64_t m_lastRxUs = 0;
+    uint32_t m_rate = 0;
+    SampleFmt m_fmt = SAMPLE_FMT_S16;
+    uint8_t m_bits = 0;
+    uint8_t m_channels = 0;
+    uint32_t m_packets = 0, m_rebuilt = 0, m_concealed = 0, m_late = 0, m_resyncs = 0;
+
+    static const uint8_t s_silence[MAX_PCM_BYTES];
+};
+
+inline const uint8_t NetIngest::s_silence[NetIngest::MAX_PCM_BYTES] = {};
+
+#endif // APP_NET_INGEST
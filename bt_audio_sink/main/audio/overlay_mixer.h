@@ -1,187 +1,256 @@
 #pragma once
 
 // -----------------------------------------------------------
-// Overlay Mixer - ring buffer for sound effect overlay
+// Overlay Mixer - ring buffers for sound effect overlay
 // Sound effects push samples here, DSP pulls and mixes them
 // with Bluetooth audio before I2S output
+// - Several voices (prompt, exclusive prompt, UI click, alert),
+//   each with its own ring, gain and duck depth; all are mixed in
+//   one fused loop whose cost does not depend on how many are playing
+// - Exclusive prompts duck BT fully, so audio_tx stays the only
+//   I2S writer; with no BT audio queued it plays the voices alone
+// - Each ring is lock-free single producer (the voice's task) /
+//   single consumer (audio_tx): the audio task never waits
+// - Power-of-two capacities with free-running frame counters, so
+//   indices are masked and a ring is at most two spans per block
+// - BT ducking follows a linear ramp precomputed per block
 // -----------------------------------------------------------
 
 #include <stdint.h>
 #include <string.h>
+#include <atomic>
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "../core/static_alloc.h"
+
+enum OverlayVoice : uint8_t {
+    OVERLAY_VOICE_PROMPT = 0,   // SoundPlayer overlay prompts
+    OVERLAY_VOICE_EXCLUSIVE,    // SoundPlayer exclusive prompts (BT muted)
+    OVERLAY_VOICE_CLICK,        // UI feedback (encoder detents)
+    OVERLAY_VOICE_ALERT,        // Short warning beeps
+    OVERLAY_VOICE_COUNT
+};
 
 class OverlayMixer {
 public:
     static constexpr const char* TAG = "OverlayMixer";
-    
-    // Ring buffer size: ~100ms at 96kHz stereo 32-bit = 96000 * 0.1 * 2 * 4 = 76800 bytes
-    // We use PSRAM so we can be generous
-    static constexpr size_t RING_SIZE = 96 * 1024;  // 96KB - plenty for any sample rate
-    
+
     // Ducking settings (Q15 fixed point for efficiency)
     static constexpr int16_t DUCK_GAIN_Q15 = 6554;   // ~0.2 = -14dB (duck BT by 80%)
     static constexpr int16_t UNITY_Q15 = 32767;      // 1.0
-    static constexpr int16_t DUCK_RAMP_STEP = 328;   // ~10ms ramp at 96kHz (32767 / (96*10))
-    
+    static constexpr int16_t DUCK_RAMP_STEP = 328;   // Per frame: ~10ms ramp at 96kHz (32767 / (96*10))
+
     OverlayMixer() = default;
-    
+
     bool init() {
         if (m_initialized) return true;
-        
-        // Allocate ring buffer in PSRAM
-        m_ringBuf = (int32_t*)heap_caps_malloc(RING_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        if (!m_ringBuf) {
-            ESP_LOGE(TAG, "Failed to allocate ring buffer in PSRAM");
-            return false;
-        }
-        
-        memset(m_ringBuf, 0, RING_SIZE);
-        
-        m_mutex = xSemaphoreCreateMutex();
-        if (!m_mutex) {
-            heap_caps_free(m_ringBuf);
-            m_ringBuf = nullptr;
-            return false;
+
+        for (int v = 0; v < OVERLAY_VOICE_COUNT; v++) {
+            Voice& voice = m_voices[v];
+            voice.frames = VOICE_FRAMES[v];
+            const size_t bytes = voice.frames * 2 * sizeof(int32_t);
+            // Ring buffers in PSRAM (the static arena's when the build has one)
+            voice.buf = StaticAlloc::psramArena()
+                ? (int32_t*)StaticAlloc::take("overlay_voice", bytes, StaticAlloc::PSRAM) : nullptr;
+            if (!voice.buf) voice.buf = (int32_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (!voice.buf) {
+                ESP_LOGE(TAG, "Failed to allocate voice %d ring in PSRAM", v);
+                return false;
+            }
+            memset(voice.buf, 0, bytes);
+            voice.write.store(0);
+            voice.read.store(0);
+            voice.gainQ15.store(VOICE_GAIN_Q15[v]);
         }
-        
-        m_ringFrameCount = RING_SIZE / (2 * sizeof(int32_t));  // Stereo frames
-        m_writeIdx = 0;
-        m_readIdx = 0;
-        m_framesAvailable = 0;
-        m_duckGainQ15 = UNITY_Q15;  // Start at full volume (no ducking)
-        m_targetDuckQ15 = UNITY_Q15;
-        m_overlayActive = false;
-        
+        m_duckGainQ15.store(UNITY_Q15);  // Start at full volume (no ducking)
+
         m_initialized = true;
-        ESP_LOGI(TAG, "Initialized: %u frames capacity", (unsigned)m_ringFrameCount);
+        ESP_LOGI(TAG, "Initialized: %u/%u/%u/%u frames (prompt/exclusive/click/alert)",
+                 (unsigned)VOICE_FRAMES[0], (unsigned)VOICE_FRAMES[1], (unsigned)VOICE_FRAMES[2],
+                 (unsigned)VOICE_FRAMES[3]);
         return true;
     }
-    
-    // Push stereo samples from SoundPlayer (called from sound playback task)
-    // Samples are already resampled to match I2S rate
-    void pushSamples(const int32_t* stereoSamples, size_t frames) {
-        if (!m_initialized || frames == 0) return;
-        
-        xSemaphoreTake(m_mutex, portMAX_DELAY);
-        
-        size_t freeFrames = m_ringFrameCount - m_framesAvailable;
+
+    // Push stereo samples for a voice (producer: that voice's task only)
+    // Samples are already resampled to match I2S rate. Returns the
+    // frames now queued for the voice, for the producer's pacing.
+    size_t pushSamples(OverlayVoice v, const int32_t* stereoSamples, size_t frames) {
+        if (!m_initialized || v >= OVERLAY_VOICE_COUNT) return 0;
+        Voice& voice = m_voices[v];
+
+        const uint32_t w = voice.write.load(std::memory_order_relaxed);
+        const uint32_t r = voice.read.load(std::memory_order_acquire);
+        const uint32_t freeFrames = voice.frames - (w - r);
         if (frames > freeFrames) {
             frames = freeFrames;  // Clip to available space
         }
-        
-        // Copy frames to ring buffer (wrap around if needed)
-        for (size_t i = 0; i < frames; i++) {
-            size_t idx = ((m_writeIdx + i) % m_ringFrameCount) * 2;
-            m_ringBuf[idx + 0] = stereoSamples[i * 2 + 0];  // Left
-            m_ringBuf[idx + 1] = stereoSamples[i * 2 + 1];  // Right
+
+        // Copy in at most two spans (up to the end of storage, then from 0)
+        const uint32_t at = w & (voice.frames - 1);
+        const size_t first = frames < voice.frames - at ? frames : voice.frames - at;
+        memcpy(voice.buf + at * 2, stereoSamples, first * 2 * sizeof(int32_t));
+        if (frames > first) {
+            memcpy(voice.buf, stereoSamples + first * 2, (frames - first) * 2 * sizeof(int32_t));
         }
-        
-        m_writeIdx = (m_writeIdx + frames) % m_ringFrameCount;
-        m_framesAvailable += frames;
-        m_overlayActive = true;
-        m_targetDuckQ15 = DUCK_GAIN_Q15;  // Start ducking BT audio
-        
-        xSemaphoreGive(m_mutex);
+
+        voice.write.store(w + (uint32_t)frames, std::memory_order_release);
+        return (w - r) + frames;
+    }
+
+    // Prompt voice (SoundPlayer overlay mode)
+    size_t pushSamples(const int32_t* stereoSamples, size_t frames) {
+        return pushSamples(OVERLAY_VOICE_PROMPT, stereoSamples, frames);
+    }
+
+    // Per-voice mix gain (0..1), from any task
+    void setVoiceGain(OverlayVoice v, float gain) {
+        if (v >= OVERLAY_VOICE_COUNT) return;
+        if (gain < 0.0f) gain = 0.0f;
+        if (gain > 1.0f) gain = 1.0f;
+        m_voices[v].gainQ15.store((int16_t)(gain * UNITY_Q15));
     }
-    
-    // Mix overlay samples into DSP output buffer (called from DSP processing)
-    // This applies ducking to BT audio when overlay is playing
+
+    // Mix overlay samples into DSP output buffer (consumer: audio_tx)
+    // This applies ducking to BT audio while a ducking voice has samples
+    // queued; dspOut may be silence when there is no BT audio
     void mixIntoOutput(int32_t* dspOut, size_t frames) {
-        if (!m_initialized) return;
-        
-        xSemaphoreTake(m_mutex, portMAX_DELAY);
-        
-        // Smooth gain ramping for duck in/out
-        bool hasOverlay = (m_framesAvailable > 0);
-        
-        for (size_t i = 0; i < frames; i++) {
-            // Update duck gain (ramp toward target)
-            if (m_duckGainQ15 < m_targetDuckQ15) {
-                m_duckGainQ15 += DUCK_RAMP_STEP;
-                if (m_duckGainQ15 > m_targetDuckQ15) m_duckGainQ15 = m_targetDuckQ15;
-            } else if (m_duckGainQ15 > m_targetDuckQ15) {
-                m_duckGainQ15 -= DUCK_RAMP_STEP;
-                if (m_duckGainQ15 < m_targetDuckQ15) m_duckGainQ15 = m_targetDuckQ15;
+        if (!m_initialized || frames == 0) return;
+
+        // Per voice: samples this block, where they start, their gain
+        uint32_t take[OVERLAY_VOICE_COUNT];
+        uint32_t start[OVERLAY_VOICE_COUNT];
+        bool any = false;
+        int32_t target = UNITY_Q15;
+        for (int v = 0; v < OVERLAY_VOICE_COUNT; v++) {
+            Voice& voice = m_voices[v];
+            uint32_t r = voice.read.load(std::memory_order_relaxed);
+            const uint32_t w = voice.write.load(std::memory_order_acquire);
+            if (voice.clearRequested.exchange(false)) {
+                r = w;
+                voice.read.store(r, std::memory_order_release);
+            }
+            const uint32_t available = w - r;
+            take[v] = available < frames ? available : (uint32_t)frames;
+            start[v] = r;
+            any |= take[v] > 0;
+            if (take[v] > 0 && VOICE_DUCK_Q15[v] < target) target = VOICE_DUCK_Q15[v];
+        }
+
+        // Duck as deep as the deepest playing voice asks, ramp back once
+        // drained. The ramp over this block is linear from gStart to gEnd.
+        const int32_t gStart = m_duckGainQ15.load(std::memory_order_relaxed);
+        if (!any && gStart == UNITY_Q15) return;  // Nothing to do
+        const int32_t maxMove = (int32_t)(frames * DUCK_RAMP_STEP);
+        int32_t gEnd = target;
+        if (gEnd > gStart + maxMove) gEnd = gStart + maxMove;
+        if (gEnd < gStart - maxMove) gEnd = gStart - maxMove;
+        int32_t duckQ16 = gStart << 16;
+        const int32_t duckStepQ16 = ((gEnd - gStart) << 16) / (int32_t)frames;
+        m_duckGainQ15.store((int16_t)gEnd, std::memory_order_relaxed);
+
+        // Every voice takes part in every frame: an idle or drained voice
+        // reads a silent sample at zero gain, so the loop never branches
+        // on voice count. The block is cut where a ring wraps or drains.
+        size_t pos = 0;
+        while (pos < frames) {
+            const int32_t* src[OVERLAY_VOICE_COUNT];
+            size_t stride[OVERLAY_VOICE_COUNT];
+            int32_t gain[OVERLAY_VOICE_COUNT];
+            size_t seg = frames - pos;
+            for (int v = 0; v < OVERLAY_VOICE_COUNT; v++) {
+                const Voice& voice = m_voices[v];
+                if (pos < take[v]) {
+                    const uint32_t at = (start[v] + (uint32_t)pos) & (voice.frames - 1);
+                    size_t run = take[v] - pos;
+                    if (run > voice.frames - at) run = voice.frames - at;
+                    if (run < seg) seg = run;
+                    src[v] = voice.buf + at * 2;
+                    stride[v] = 2;
+                    gain[v] = voice.gainQ15.load(std::memory_order_relaxed);
+                } else {
+                    src[v] = s_silence;
+                    stride[v] = 0;
+                    gain[v] = 0;
+                }
             }
-            
-            // Apply duck gain to BT audio (Q15 fixed point multiply)
-            int32_t btL = dspOut[i * 2 + 0];
-            int32_t btR = dspOut[i * 2 + 1];
-            
-            btL = (int32_t)(((int64_t)btL * m_duckGainQ15) >> 15);
-            btR = (int32_t)(((int64_t)btR * m_duckGainQ15) >> 15);
-            
-            // Add overlay sample if available
-            if (m_framesAvailable > 0) {
-                size_t idx = (m_readIdx % m_ringFrameCount) * 2;
-                int32_t ovL = m_ringBuf[idx + 0];
-                int32_t ovR = m_ringBuf[idx + 1];
-                
-                // Simple add with saturation
-                int64_t sumL = (int64_t)btL + ovL;
-                int64_t sumR = (int64_t)btR + ovR;
-                
-                // Soft clip at 32-bit max
-                if (sumL > 2147483647LL) sumL = 2147483647LL;
-                if (sumL < -2147483648LL) sumL = -2147483648LL;
-                if (sumR > 2147483647LL) sumR = 2147483647LL;
-                if (sumR < -2147483648LL) sumR = -2147483648LL;
-                
-                btL = (int32_t)sumL;
-                btR = (int32_t)sumR;
-                
-                m_readIdx = (m_readIdx + 1) % m_ringFrameCount;
-                m_framesAvailable--;
+
+            int32_t* out = dspOut + pos * 2;
+            for (size_t i = 0; i < seg; i++) {
+                const int64_t g = duckQ16 >> 16;
+                duckQ16 += duckStepQ16;
+                int64_t l = (int64_t)out[0] * g;
+                int64_t r = (int64_t)out[1] * g;
+                for (int v = 0; v < OVERLAY_VOICE_COUNT; v++) {
+                    l += (int64_t)src[v][0] * gain[v];
+                    r += (int64_t)src[v][1] * gain[v];
+                    src[v] += stride[v];
+                }
+                out[0] = clamp32(l >> 15);
+                out[1] = clamp32(r >> 15);
+                out += 2;
             }
-            
-            dspOut[i * 2 + 0] = btL;
-            dspOut[i * 2 + 1] = btR;
+            pos += seg;
         }
-        
-        // If overlay finished, start ramping gain back up
-        if (m_framesAvailable == 0 && m_overlayActive) {
-            m_overlayActive = false;
-            m_targetDuckQ15 = UNITY_Q15;  // Ramp back to full volume
+
+        for (int v = 0; v < OVERLAY_VOICE_COUNT; v++) {
+            if (take[v]) m_voices[v].read.store(start[v] + take[v], std::memory_order_release);
         }
-        
-        xSemaphoreGive(m_mutex);
     }
-    
+
     // Check if overlay is currently active (samples in buffer or ducking active)
     bool isActive() const {
-        return m_overlayActive || m_duckGainQ15 < UNITY_Q15;
+        return getFramesAvailable() > 0 || m_duckGainQ15.load(std::memory_order_relaxed) < UNITY_Q15;
     }
-    
-    // Get frames available for mixing
-    size_t getFramesAvailable() const { return m_framesAvailable; }
-    
-    // Clear overlay buffer (e.g., when stopping playback)
+
+    // Frames queued in the fullest voice, i.e. what the next mixes can
+    // take without a gap (approximate from the other side)
+    size_t getFramesAvailable() const {
+        size_t n = 0;
+        for (int v = 0; v < OVERLAY_VOICE_COUNT; v++) {
+            size_t q = m_voices[v].write.load(std::memory_order_acquire) - m_voices[v].read.load(std::memory_order_acquire);
+            if (q > n) n = q;
+        }
+        return n;
+    }
+
+    // Clear overlay buffers (e.g., when stopping playback). Safe from any
+    // task: the consumer drops the queued samples at its next mix.
     void clear() {
-        if (!m_initialized) return;
-        
-        xSemaphoreTake(m_mutex, portMAX_DELAY);
-        m_writeIdx = 0;
-        m_readIdx = 0;
-        m_framesAvailable = 0;
-        m_overlayActive = false;
-        m_targetDuckQ15 = UNITY_Q15;
-        xSemaphoreGive(m_mutex);
+        for (int v = 0; v < OVERLAY_VOICE_COUNT; v++) clear((OverlayVoice)v);
+    }
+    void clear(OverlayVoice v) {
+        if (!m_initialized || v >= OVERLAY_VOICE_COUNT) return;
+        m_voices[v].clearRequested.store(true);
     }
-    
+
 private:
+    // Stereo frames per voice ring (powers of two): ~170/170/21/85ms at 96kHz
+    static constexpr uint32_t VOICE_FRAMES[OVERLAY_VOICE_COUNT] = { 16384, 16384, 2048, 8192 };
+    static constexpr int16_t VOICE_GAIN_Q15[OVERLAY_VOICE_COUNT] = { UNITY_Q15, UNITY_Q15, 16384, UNITY_Q15 };
+    // BT gain while the voice plays
+    static constexpr int16_t VOICE_DUCK_Q15[OVERLAY_VOICE_COUNT] = { DUCK_GAIN_Q15, 0, UNITY_Q15, DUCK_GAIN_Q15 };
+    static_assert((VOICE_FRAMES[0] & (VOICE_FRAMES[0] - 1)) == 0 &&
+                  (VOICE_FRAMES[1] & (VOICE_FRAMES[1] - 1)) == 0 &&
+                  (VOICE_FRAMES[2] & (VOICE_FRAMES[2] - 1)) == 0 &&
+                  (VOICE_FRAMES[3] & (VOICE_FRAMES[3] - 1)) == 0, "voice rings must be powers of two");
+
+    struct Voice {
+        int32_t* buf = nullptr;
+        uint32_t frames = 0;
+        std::atomic<uint32_t> write{0};     // Frames pushed, owned by producer
+        std::atomic<uint32_t> read{0};      // Frames mixed, owned by consumer
+        std::atomic<bool> clearRequested{false};
+        std::atomic<int16_t> gainQ15{UNITY_Q15};
+    };
+
+    static inline int32_t clamp32(int64_t x) {
+        return x > INT32_MAX ? INT32_MAX : (x < INT32_MIN ? INT32_MIN : (int32_t)x);
+    }
+
+    static constexpr int32_t s_silence[2] = { 0, 0 };
+
     bool m_initialized = false;
-    int32_t* m_ringBuf = nullptr;
-    SemaphoreHandle_t m_mutex = nullptr;
-    
-    size_t m_ringFrameCount = 0;
-    size_t m_writeIdx = 0;
-    size_t m_readIdx = 0;
-    size_t m_framesAvailable = 0;
-    
-    bool m_overlayActive = false;
-    int16_t m_duckGainQ15 = UNITY_Q15;
-    int16_t m_targetDuckQ15 = UNITY_Q15;
+    Voice m_voices[OVERLAY_VOICE_COUNT];
+    std::atomic<int16_t> m_duckGainQ15{UNITY_Q15};  // Written by consumer only
 };
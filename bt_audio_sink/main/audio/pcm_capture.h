@@ -0,0 +1,332 @@
+#pragma once
+
+/*
+ * pcm_capture.h
+ *
+ * Flight recorder for the audio around a glitch. audio_tx copies every
+ * block twice into a PSRAM ring: the ring record as the decoder left it
+ * (pre-DSP, stream format and rate) and the finished Q31 stereo block
+ * just before it is committed to I2S (post-DSP, after slips, rate
+ * conversion, fades and overlays). That is one memcpy per block and
+ * stream, plus a 20-byte header; the oldest records are overwritten, so
+ * the ring holds the last few seconds.
+ *
+ * Glitches go in as markers (mark(), lock-free from any task, the same
+ * events the glitch journal gets), with deadline misses. An underrun or a
+ * miss triggers a freeze: APP_PCM_CAPTURE_POST_MS later the ring stops
+ * and keeps what led up to the event and what followed it, until it is
+ * re-armed. Only the audio task writes the ring; readers only look at a
+ * frozen one.
+ *
+ * A frozen capture reads as one image (read(), BLE request 0xFA), which
+ * tools/pcm_capture_to_wav.py turns into WAV files and a marker list:
+ *
+ *   header, 20 bytes:
+ *     ["ACAP", version u8, reason u8, markers u16, records_bytes u32,
+ *      trigger_us u32, image_bytes u32]
+ *   records, oldest first, each 4-byte aligned:
+ *     [bytes u32, kind u8, fmt u8, channels u8, 0, time_us u32, rate u32,
+ *      frame_index u32] + bytes of PCM
+ *     kind 1 = pre-DSP (fmt: SampleFmt), 2 = post-DSP (Q31 stereo)
+ *   markers, 8 bytes each:
+ *     [time_us u32, type u8, 0, queue_ms u16]
+ *     type: GlitchType, CAPTURE_MARK_DEADLINE or CAPTURE_MARK_MANUAL
+ *
+ * All little endian; times are esp_timer microseconds (32 bits).
+ */
+
+#include <stdint.h>
+#include "../config/app_config.h"
+#include "../core/event_log.h"
+#include "glitch_journal.h"
+
+enum CaptureKind : uint8_t {
+    CAPTURE_PRE_DSP = 1,
+    CAPTURE_POST_DSP = 2,
+};
+
+// Marker types next to GlitchType
+constexpr uint8_t CAPTURE_MARK_DEADLINE = 0x80;    // Block over its deadline
+constexpr uint8_t CAPTURE_MARK_MANUAL = 0x81;      // Frozen on request
+
+#if APP_PCM_CAPTURE
+
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+class PcmCapture {
+public:
+    static constexpr uint8_t VERSION = 1;
+    static constexpr size_t HEADER_BYTES = 20;
+    static constexpr size_t RECORD_HEADER = 20;
+    static constexpr size_t MARKER_BYTES = 8;
+    static constexpr uint32_t MARKERS = 64;
+    static_assert((MARKERS & (MARKERS - 1)) == 0, "marker count must be a power of two");
+
+    enum State : uint8_t { OFF = 0, ARMED, TRIGGERED, FROZEN };
+
+    static PcmCapture& getInstance() {
+        static PcmCapture instance;
+        return instance;
+    }
+
+    // At boot: the ring in PSRAM; without it the capture stays off
+    bool begin() {
+        if (m_buf) return true;
+        const size_t bytes = (size_t)APP_PCM_CAPTURE_KB * 1024;
+        m_buf = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!m_buf) {
+            ESP_LOGW(TAG, "No PSRAM for %u KB, capture off", (unsigned)APP_PCM_CAPTURE_KB);
+            return false;
+        }
+        m_size = (uint32_t)bytes;
+        m_state.store(ARMED, std::memory_order_release);
+        ESP_LOGI(TAG, "%u KB armed, freeze %u ms after a glitch", (unsigned)APP_PCM_CAPTURE_KB,
+                 (unsigned)APP_PCM_CAPTURE_POST_MS);
+        return true;
+    }
+
+    State state() const { return (State)m_state.load(std::memory_order_acquire); }
+
+    // Audio task, once per block and stream: frames of fmt / channels
+    // at rate, len bytes from pcm
+    void write(CaptureKind kind, const void* pcm, uint32_t len, uint8_t fmt, uint8_t channels,
+               uint32_t rate, uint32_t frameIndex) {
+        uint8_t st = m_state.load(std::memory_order_acquire);
+        if (m_rearm.exchange(false, std::memory_order_acquire)) {
+            reset();
+            st = ARMED;
+        }
+        if (st == OFF || st == FROZEN) return;
+        const uint32_t nowUs = (uint32_t)esp_timer_get_time();
+        const uint32_t need = RECORD_HEADER + ((len + 3) & ~3u);
+        if (need > m_size / 2) return;
+        makeRoom(need);
+
+        uint8_t* r = m_buf + m_head;
+        uint32_t hdr[5] = { len, (uint32_t)kind | (uint32_t)fmt << 8 | (uint32_t)channels << 16,
+                            nowUs, rate, frameIndex };
+        memcpy(r, hdr, sizeof(hdr));
+        memcpy(r + RECORD_HEADER, pcm, len);
+        m_head += need;
+        m_lastUs = nowUs;
+
+        if (st == TRIGGERED && (int32_t)(nowUs - m_freezeAtUs) >= 0) {
+            m_state.store(FROZEN, std::memory_order_release);
+            logEvent(EV_CAPTURE_FROZEN, m_reason, recordsBytes() / 1024);
+        }
+    }
+
+    // Any task: a glitch marker; an underrun or a deadline miss also
+    // starts the freeze countdown
+    void mark(uint8_t type, uint32_t queueMs) {
+        const uint8_t st = m_state.load(std::memory_order_acquire);
+        if (st == OFF || st == FROZEN) return;
+        const uint32_t nowUs = (uint32_t)esp_timer_get_time();
+        const uint32_t seq = m_markNext.fetch_add(1, std::memory_order_relaxed) + 1;
+        Marker& m = m_markers[seq & (MARKERS - 1)];
+        m.seq = 0;
+        m.timeUs = nowUs;
+        m.info = (uint32_t)type | (queueMs < 0xFFFF ? queueMs : 0xFFFF) << 16;
+        std::atomic_signal_fence(std::memory_order_release);
+        m.seq = seq;
+        if (type == GLITCH_UNDERRUN || type == CAPTURE_MARK_DEADLINE || type == CAPTURE_MARK_MANUAL) {
+            trigger(type, nowUs, type == CAPTURE_MARK_MANUAL ? 0 : APP_PCM_CAPTURE_POST_MS);
+        }
+    }
+
+    // Any task: freeze at the next block, or start over
+    void freeze() { mark(CAPTURE_MARK_MANUAL, 0); }
+    void rearm() {
+        if (m_state.load(std::memory_order_acquire) == OFF) return;
+        m_rearm.store(true, std::memory_order_release);
+    }
+
+    // Image size; 0 unless frozen
+    uint32_t imageBytes() const {
+        if (state() != FROZEN) return 0;
+        return (uint32_t)HEADER_BYTES + recordsBytes() + markerCount() * (uint32_t)MARKER_BYTES;
+    }
+
+    // First and last record time of a frozen capture (ms covered)
+    uint32_t spanMs() const {
+        if (state() != FROZEN || recordsBytes() == 0) return 0;
+        return (m_lastUs - recordTime(m_tail)) / 1000;
+    }
+
+    uint8_t reason() const { return m_reason; }
+
+    // Image bytes from offset, at most cap; 0 past the end or unless frozen
+    size_t read(uint32_t offset, uint8_t* out, size_t cap) const {
+        const uint32_t total = imageBytes();
+        if (offset >= total) return 0;
+        size_t n = 0;
+        while (n < cap && offset < total) {
+            size_t got = readAt(offset, out + n, cap - n);
+            if (got == 0) break;
+            n += got;
+            offset += (uint32_t)got;
+        }
+        return n;
+    }
+
+private:
+    static constexpr const char* TAG = "Capture";
+
+    struct Marker {
+        volatile uint32_t seq;      // 0 = empty or being written
+        volatile uint32_t timeUs;
+        volatile uint32_t info;     // type u8, 0, queue_ms u16
+    };
+
+    PcmCapture() = default;
+
+    // The first trigger wins; its fields are set before the state the
+    // audio task reads them by (two racing triggers both still arm it)
+    void trigger(uint8_t reason, uint32_t nowUs, uint32_t postMs) {
+        if (m_state.load(std::memory_order_acquire) != ARMED) return;
+        m_reason = reason;
+        m_triggerUs = nowUs;
+        m_freezeAtUs = nowUs + postMs * 1000;
+        uint8_t armed = ARMED;
+        m_state.compare_exchange_strong(armed, TRIGGERED, std::memory_order_acq_rel);
+    }
+
+    // Audio task
+    void reset() {
+        m_head = 0;
+        m_tail = 0;
+        m_wrapAt = 0;
+        m_wrapped = false;
+        for (uint32_t i = 0; i < MARKERS; i++) m_markers[i].seq = 0;
+        m_markNext.store(0, std::memory_order_relaxed);
+        m_state.store(ARMED, std::memory_order_release);
+    }
+
+    // Free need bytes at m_head, dropping the oldest records. Data is
+    // [tail, head) or, once wrapped, [tail, wrapAt) + [0, head).
+    void makeRoom(uint32_t need) {
+        for (;;) {
+            if (!m_wrapped) {
+                if (m_size - m_head >= need) return;
+                m_wrapAt = m_head;
+                m_head = 0;
+                m_wrapped = true;
+            }
+            while (m_wrapped && m_tail - m_head < need) {
+                m_tail += stride(m_tail);
+                if (m_tail >= m_wrapAt) {
+                    m_tail = 0;
+                    m_wrapped = false;
+                }
+            }
+            if (m_wrapped) return;
+        }
+    }
+
+    uint32_t stride(uint32_t at) const {
+        uint32_t len;
+        memcpy(&len, m_buf + at, 4);
+        return RECORD_HEADER + ((len + 3) & ~3u);
+    }
+
+    uint32_t recordTime(uint32_t at) const {
+        uint32_t t;
+        memcpy(&t, m_buf + at + 8, 4);
+        return t;
+    }
+
+    uint32_t recordsBytes() const {
+        return m_wrapped ? (m_wrapAt - m_tail) + m_head : m_head - m_tail;
+    }
+
+    // Markers not older than the oldest record, oldest first
+    uint32_t markerCount() const {
+        uint32_t n = 0;
+        forEachMarker([&n](uint32_t, uint32_t) { n++; });
+        return n;
+    }
+
+    template <typename Fn>
+    void forEachMarker(Fn fn) const {
+        const uint32_t last = m_markNext.load(std::memory_order_relaxed);
+        const uint32_t first = last > MARKERS ? last - MARKERS + 1 : 1;
+        const uint32_t oldestUs = recordsBytes() ? recordTime(m_tail) : 0;
+        for (uint32_t seq = first; seq <= last; seq++) {
+            const Marker& m = m_markers[seq & (MARKERS - 1)];
+            if (m.seq != seq) continue;
+            if ((int32_t)(m.timeUs - oldestUs) < 0) continue;
+            fn(m.timeUs, m.info);
+        }
+    }
+
+    size_t readAt(uint32_t offset, uint8_t* out, size_t cap) const {
+        const uint32_t records = recordsBytes();
+        if (offset < HEADER_BYTES) {
+            uint8_t h[HEADER_BYTES];
+            const uint32_t markers = markerCount();
+            memcpy(h, "ACAP", 4);
+            h[4] = VERSION;
+            h[5] = m_reason;
+            h[6] = (uint8_t)markers;
+            h[7] = (uint8_t)(markers >> 8);
+            put32(h + 8, records);
+            put32(h + 12, m_triggerUs);
+            put32(h + 16, imageBytes());
+            return copy(out, cap, h + offset, HEADER_BYTES - offset);
+        }
+        offset -= HEADER_BYTES;
+        if (offset < records) {
+            const uint32_t first = m_wrapped ? m_wrapAt - m_tail : records;
+            if (offset < first) return copy(out, cap, m_buf + m_tail + offset, first - offset);
+            return copy(out, cap, m_buf + (offset - first), records - offset);
+        }
+        offset -= records;
+        const uint32_t index = offset / MARKER_BYTES;
+        uint32_t i = 0;
+        size_t n = 0;
+        forEachMarker([&](uint32_t timeUs, uint32_t info) {
+            if (i++ != index || n) return;
+            uint8_t m[MARKER_BYTES];
+            put32(m, timeUs);
+            put32(m + 4, info);
+            const uint32_t skip = offset % MARKER_BYTES;
+            n = copy(out, cap, m + skip, MARKER_BYTES - skip);
+        });
+        return n;
+    }
+
+    static size_t copy(uint8_t* out, size_t cap, const uint8_t* src, size_t len) {
+        const size_t n = len < cap ? len : cap;
+        memcpy(out, src, n);
+        return n;
+    }
+
+    static void put32(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+
+    uint8_t* m_buf = nullptr;           // PSRAM ring
+    uint32_t m_size = 0;
+    uint32_t m_head = 0;                // Audio task: next record goes here
+    uint32_t m_tail = 0;                // Oldest record
+    uint32_t m_wrapAt = 0;              // End of the data before head wrapped
+    bool m_wrapped = false;
+    uint32_t m_lastUs = 0;
+    std::atomic<uint8_t> m_state{OFF};
+    std::atomic<bool> m_rearm{false};
+    volatile uint8_t m_reason = 0;
+    volatile uint32_t m_triggerUs = 0;
+    volatile uint32_t m_freezeAtUs = 0;
+    Marker m_markers[MARKERS] = {};
+    std::atomic<uint32_t> m_markNext{0};    // Last marker sequence number used
+};
+
+#endif // APP_PCM_CAPTURE
@@ -0,0 +1,113 @@
+#pragma once
+
+/*
+ * peer_stream_cache.h
+ *
+ * Last stream format negotiated with each recent peer (codec, rate, sample
+ * width, channels). When a known peer connects, the app sets I2S, DSP
+ * filters and the jitter buffer up for its format right away; if the codec
+ * configuration that follows matches, onCodecConfig() has nothing left to
+ * reconfigure and audio starts as soon as the first packets arrive.
+ * Records of the most recent peers are kept as one NVS blob.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "codec_config/codec_config.h"
+
+class PeerStreamCache {
+public:
+    static constexpr int MAX_PEERS = 8;
+    static constexpr size_t ENTRY_BYTES = 6 + 1 + 1 + 1 + 4;
+    static constexpr size_t BLOB_BYTES = 2 + MAX_PEERS * ENTRY_BYTES;
+
+    struct Format {
+        a2dp_codec_id_t codec;
+        uint32_t sampleRate;
+        uint8_t bitsPerSample;
+        uint8_t channels;
+
+        bool operator==(const Format& o) const {
+            return codec == o.codec && sampleRate == o.sampleRate &&
+                   bitsPerSample == o.bitsPerSample && channels == o.channels;
+        }
+        bool operator!=(const Format& o) const { return !(*this == o); }
+    };
+
+    bool lookup(const uint8_t* addr, Format& out) const {
+        int i = find(addr);
+        if (i < 0) return false;
+        out = m_entries[i].fmt;
+        return true;
+    }
+
+    // Records the peer's format as most recent; true if the blob changed
+    bool remember(const uint8_t* addr, const Format& fmt) {
+        int i = find(addr);
+        if (i == 0 && m_entries[0].fmt == fmt) return false;
+        if (i < 0) i = m_count < MAX_PEERS ? m_count++ : MAX_PEERS - 1;   // Oldest goes
+        memmove(&m_entries[1], &m_entries[0], i * sizeof(Entry));
+        memcpy(m_entries[0].addr, addr, 6);
+        m_entries[0].fmt = fmt;
+        return true;
+    }
+
+    // All peers: [version, count, entry...]; returns bytes written (0 if cap too small)
+    size_t serialize(uint8_t* out, size_t cap) const {
+        if (cap < BLOB_BYTES) return 0;
+        memset(out, 0, BLOB_BYTES);
+        out[0] = BLOB_VERSION;
+        out[1] = (uint8_t)m_count;
+        for (int i = 0; i < m_count; i++) {
+            const Entry& e = m_entries[i];
+            uint8_t* q = out + 2 + i * ENTRY_BYTES;
+            memcpy(q, e.addr, 6);
+            q[6] = (uint8_t)e.fmt.codec;
+            q[7] = e.fmt.bitsPerSample;
+            q[8] = e.fmt.channels;
+            for (int b = 0; b < 4; b++) q[9 + b] = (uint8_t)(e.fmt.sampleRate >> (8 * b));
+        }
+        return BLOB_BYTES;
+    }
+
+    // Inverse of serialize; a blob of another version is ignored
+    bool deserialize(const uint8_t* in, size_t len) {
+        if (len < 2 || in[0] != BLOB_VERSION || in[1] > MAX_PEERS ||
+                len < 2 + (size_t)in[1] * ENTRY_BYTES) {
+            return false;
+        }
+        m_count = in[1];
+        for (int i = 0; i < m_count; i++) {
+            Entry& e = m_entries[i];
+            const uint8_t* q = in + 2 + i * ENTRY_BYTES;
+            memcpy(e.addr, q, 6);
+            e.fmt.codec = (a2dp_codec_id_t)q[6];
+            e.fmt.bitsPerSample = q[7];
+            e.fmt.channels = q[8];
+            e.fmt.sampleRate = (uint32_t)q[9] | ((uint32_t)q[10] << 8) |
+                               ((uint32_t)q[11] << 16) | ((uint32_t)q[12] << 24);
+        }
+        return true;
+    }
+
+    int peerCount() const { return m_count; }
+
+private:
+    static constexpr uint8_t BLOB_VERSION = 1;
+
+    struct Entry {
+        uint8_t addr[6];
+        Format fmt;
+    };
+
+    int find(const uint8_t* addr) const {
+        for (int i = 0; i < m_count; i++) {
+            if (memcmp(m_entries[i].addr, addr, 6) == 0) return i;
+        }
+        return -1;
+    }
+
+    Entry m_entries[MAX_PEERS] = {};    // Most recent peer first
+    int m_count = 0;
+};
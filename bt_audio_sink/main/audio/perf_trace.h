@@ -0,0 +1,186 @@
+#pragma once
+
+/*
+ * perf_trace.h
+ *
+ * Cycle-count histograms for the audio path: decode (Bluedroid hook),
+ * enqueue, DSP and time audio_tx spends blocked on I2S. Each point has one
+ * writer task, so recording is a handful of plain stores; readers take a
+ * snapshot that may be one sample stale, which is fine for diagnostics.
+ *
+ * Buckets are log2 with two steps per octave (values within +/-25%),
+ * enough to tell a p99 spike from the average without storing samples.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include "esp_cpu.h"
+#include "esp_log.h"
+
+enum TracePoint : uint8_t {
+    TRACE_DECODE = 0,   // decode_packet() per media packet (A2DP_DECODER)
+    TRACE_ENQUEUE,      // AudioPipeline::enqueue (A2DP_DECODER)
+    TRACE_DSP,          // convert + DSP per block (audio_tx)
+    TRACE_I2S_BLOCKED,  // audio_tx waiting for a free output slot
+    TRACE_COUNT
+};
+
+struct TraceHistogram {
+    static constexpr int BUCKETS = 64;
+
+    uint32_t count = 0;
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    uint64_t sum = 0;
+    uint32_t bucket[BUCKETS] = {};
+
+    static int bucketOf(uint32_t v) {
+        if (v < 2) return (int)v;
+        int msb = 31 - __builtin_clz(v);
+        return msb * 2 + (int)((v >> (msb - 1)) & 1u);
+    }
+
+    // Largest value that falls into bucket i
+    static uint32_t bucketTop(int i) {
+        if (i < 2) return (uint32_t)i;
+        int msb = i / 2;
+        uint64_t top = ((uint64_t)(3 + (i & 1)) << (msb - 1)) - 1;
+        return top > UINT32_MAX ? UINT32_MAX : (uint32_t)top;
+    }
+
+    void add(uint32_t v) {
+        count++;
+        sum += v;
+        if (v < min) min = v;
+        if (v > max) max = v;
+        bucket[bucketOf(v)]++;
+    }
+
+    uint32_t avg() const { return count ? (uint32_t)(sum / count) : 0; }
+
+    // Upper bound of the bucket holding the given percentile, capped at max
+    uint32_t percentile(uint32_t pct) const {
+        if (count == 0) return 0;
+        uint64_t want = ((uint64_t)count * pct + 99) / 100;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += bucket[i];
+            if (seen >= want) {
+                uint32_t top = bucketTop(i);
+                return top < max ? top : max;
+            }
+        }
+        return max;
+    }
+};
+
+class PerfTrace {
+public:
+    static uint32_t now() { return esp_cpu_get_cycle_count(); }
+
+    // Writer side: record the cycles since start
+    void record(TracePoint p, uint32_t start) {
+        span(p, now() - start);
+    }
+
+    void span(TracePoint p, uint32_t cycles) {
+        if (m_resetReq[p].exchange(false, std::memory_order_acquire)) {
+            m_hist[p] = TraceHistogram();
+        }
+        m_hist[p].add(cycles);
+    }
+
+    // Reader side: clear every point (done by each writer on its next record)
+    void reset() {
+        for (int p = 0; p < TRACE_COUNT; p++) m_resetReq[p].store(true, std::memory_order_release);
+    }
+
+    void snapshot(TracePoint p, TraceHistogram& out) const {
+        memcpy(&out, &m_hist[p], sizeof(out));
+    }
+
+    static const char* name(TracePoint p) {
+        switch (p) {
+            case TRACE_DECODE:  return "decode";
+            case TRACE_ENQUEUE: return "enqueue";
+            case TRACE_DSP:     return "dsp";
+            default:            return "i2s_blocked";
+        }
+    }
+
+    // Compact binary summary, per point: [id][count u32][min][avg][p99][max],
+    // all little-endian cycle counts. Returns bytes written.
+    size_t serialize(uint8_t* out, size_t cap) const {
+        size_t idx = 0;
+        for (int p = 0; p < TRACE_COUNT && idx + ENTRY_BYTES <= cap; p++) {
+            TraceHistogram h;
+            snapshot((TracePoint)p, h);
+            out[idx++] = (uint8_t)p;
+            put32(out, idx, h.count);
+            put32(out, idx, h.count ? h.min : 0);
+            put32(out, idx, h.avg());
+            put32(out, idx, h.percentile(99));
+            put32(out, idx, h.max);
+        }
+        return idx;
+    }
+
+    void log(const char* tag, uint32_t cpuMhz) const {
+        for (int p = 0; p < TRACE_COUNT; p++) {
+            TraceHistogram h;
+            snapshot((TracePoint)p, h);
+            if (h.count == 0) continue;
+            ESP_LOGI(tag, "Trace %-11s n=%u min %u avg %u p99 %u max %u us",
+                     name((TracePoint)p), (unsigned)h.count,
+                     (unsigned)(h.min / cpuMhz), (unsigned)(h.avg() / cpuMhz),
+                     (unsigned)(h.percentile(99) / cpuMhz), (unsigned)(h.max / cpuMhz));
+        }
+    }
+
+    static constexpr size_t ENTRY_BYTES = 1 + 5 * 4;
+
+    // Media packets since the last reset, sent after the points in their
+    // layout (readers skipping unknown ids keep working):
+    // [MEDIA_ID][packets u32][payload bytes][largest payload][MTU][PCM frames].
+    // Bytes and frames per packet are the ratios to packets.
+    static constexpr uint8_t MEDIA_ID = 0x80;
+    struct Media {
+        uint32_t packets;
+        uint32_t bytes;
+        uint32_t maxLen;
+        uint32_t mtu;
+        uint32_t frames;
+    };
+
+    static size_t serializeMedia(const Media& m, uint8_t* out, size_t cap) {
+        if (cap < ENTRY_BYTES) return 0;
+        size_t idx = 0;
+        out[idx++] = MEDIA_ID;
+        put32(out, idx, m.packets);
+        put32(out, idx, m.bytes);
+        put32(out, idx, m.maxLen);
+        put32(out, idx, m.mtu);
+        put32(out, idx, m.frames);
+        return idx;
+    }
+
+    static void logMedia(const char* tag, const Media& m) {
+        if (m.packets == 0) return;
+        const uint32_t fpp10 = (uint32_t)((uint64_t)m.frames * 10 / m.packets);
+        ESP_LOGI(tag, "Trace media       n=%u avg %u max %u of MTU %u bytes, %u.%u frames/packet",
+                 (unsigned)m.packets, (unsigned)(m.bytes / m.packets), (unsigned)m.maxLen,
+                 (unsigned)m.mtu, (unsigned)(fpp10 / 10), (unsigned)(fpp10 % 10));
+    }
+
+private:
+    static void put32(uint8_t* out, size_t& idx, uint32_t v) {
+        out[idx++] = (uint8_t)v;
+        out[idx++] = (uint8_t)(v >> 8);
+        out[idx++] = (uint8_t)(v >> 16);
+        out[idx++] = (uint8_t)(v >> 24);
+    }
+
+    TraceHistogram m_hist[TRACE_COUNT];
+    std::atomic<bool> m_resetReq[TRACE_COUNT] = {};
+};
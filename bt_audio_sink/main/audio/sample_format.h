@@ -0,0 +1,205 @@
+#pragma once
+
+/*
+ * sample_format.h
+ *
+ * PCM input formats the decoders hand to AudioPipeline, and the converters
+ * that turn them into the DSP's working formats (interleaved stereo float
+ * or Q31). One template covers every format/channel-count pair; the format
+ * and channel count are dispatched once per block, so the inner loops have
+ * no per-sample branches.
+ *
+ *   S16         - int16, SBC/AAC/Opus
+ *   S24_PACKED  - 3-byte little endian, 24 significant bits
+ *   S24_IN_32   - int32 carrying a sign-extended 24-bit value (LC3plus)
+ *   S32         - int32, full scale (LDAC, and aptX, whose 24 bits are left
+ *                 justified by aptx_decode32)
+ *
+ * On the way out, S16Packer reduces a Q31 block to S16 for a 16-bit I2S
+ * port (APP_I2S_OUT_BITS).
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include "../dsp/pie_kernels.h"
+
+enum SampleFmt : uint8_t {
+    SAMPLE_FMT_S16 = 0,
+    SAMPLE_FMT_S24_PACKED,
+    SAMPLE_FMT_S24_IN_32,
+    SAMPLE_FMT_S32,
+};
+
+template <SampleFmt F> struct SampleTraits;
+
+template <> struct SampleTraits<SAMPLE_FMT_S16> {
+    static constexpr uint32_t BYTES = 2;
+    static inline int32_t toQ31(const uint8_t* p) {
+        int16_t v;
+        memcpy(&v, p, sizeof(v));
+        return (int32_t)((uint32_t)(int32_t)v << 16);
+    }
+    static inline float toFloat(const uint8_t* p) {
+        int16_t v;
+        memcpy(&v, p, sizeof(v));
+        return (float)v * (1.0f / 32768.0f);
+    }
+};
+
+template <> struct SampleTraits<SAMPLE_FMT_S24_PACKED> {
+    static constexpr uint32_t BYTES = 3;
+    static inline int32_t toQ31(const uint8_t* p) {
+        return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24));
+    }
+    static inline float toFloat(const uint8_t* p) {
+        return (float)toQ31(p) * (1.0f / 2147483648.0f);
+    }
+};
+
+template <> struct SampleTraits<SAMPLE_FMT_S24_IN_32> {
+    static constexpr uint32_t BYTES = 4;
+    static inline int32_t toQ31(const uint8_t* p) {
+        int32_t v;
+        memcpy(&v, p, sizeof(v));
+        return (int32_t)((uint32_t)v << 8);
+    }
+    static inline float toFloat(const uint8_t* p) {
+        int32_t v;
+        memcpy(&v, p, sizeof(v));
+        return (float)v * (1.0f / 8388608.0f);
+    }
+};
+
+template <> struct SampleTraits<SAMPLE_FMT_S32> {
+    static constexpr uint32_t BYTES = 4;
+    static inline int32_t toQ31(const uint8_t* p) {
+        int32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    static inline float toFloat(const uint8_t* p) {
+        int32_t v;
+        memcpy(&v, p, sizeof(v));
+        return (float)v * (1.0f / 2147483648.0f);
+    }
+};
+
+static inline uint32_t sampleFmtBytes(uint8_t fmt) {
+    switch (fmt) {
+        case SAMPLE_FMT_S16:        return SampleTraits<SAMPLE_FMT_S16>::BYTES;
+        case SAMPLE_FMT_S24_PACKED: return SampleTraits<SAMPLE_FMT_S24_PACKED>::BYTES;
+        case SAMPLE_FMT_S24_IN_32:  return SampleTraits<SAMPLE_FMT_S24_IN_32>::BYTES;
+        default:                    return SampleTraits<SAMPLE_FMT_S32>::BYTES;
+    }
+}
+
+static inline const char* sampleFmtName(uint8_t fmt) {
+    switch (fmt) {
+        case SAMPLE_FMT_S16:        return "S16";
+        case SAMPLE_FMT_S24_PACKED: return "S24 packed";
+        case SAMPLE_FMT_S24_IN_32:  return "S24 in 32";
+        default:                    return "S32";
+    }
+}
+
+// Source frames -> interleaved stereo. Mono is duplicated to both sides;
+// Channels == 0 means "stride given at runtime", first two channels used.
+// Out is float (full scale +/-1.0) or int32 (Q31).
+template <SampleFmt In, int Channels, typename Out>
+inline void convertToStereo(const uint8_t* src, Out* dst, uint32_t frames, uint32_t stride = Channels) {
+    using T = SampleTraits<In>;
+    constexpr uint32_t B = T::BYTES;
+    auto conv = [](const uint8_t* p) -> Out {
+        if constexpr (std::is_same<Out, float>::value) {
+            return T::toFloat(p);
+        } else {
+            return T::toQ31(p);
+        }
+    };
+
+    if constexpr (Channels == 1) {
+        for (uint32_t i = 0; i < frames; i++) {
+            const Out v = conv(src + i * B);
+            dst[2 * i + 0] = v;
+            dst[2 * i + 1] = v;
+        }
+    } else {
+        // Interleaved stereo S32 -> Q31 is a copy
+        if constexpr (Channels == 2 && In == SAMPLE_FMT_S32 && std::is_same<Out, int32_t>::value) {
+            memcpy(dst, src, frames * 2 * sizeof(int32_t));
+            return;
+        }
+#if APP_DSP_SIMD
+        // Interleaved stereo S24_IN_32 -> Q31 is one shift over the block
+        if constexpr (Channels == 2 && In == SAMPLE_FMT_S24_IN_32 && std::is_same<Out, int32_t>::value) {
+            if (((uintptr_t)src & 3) == 0) {
+                vec_shl_s32(dst, reinterpret_cast<const int32_t*>(src), frames * 2, 8);
+                return;
+            }
+        }
+#endif
+        constexpr uint32_t fixedStep = (Channels > 0) ? (uint32_t)Channels * B : 0;
+        const uint32_t step = fixedStep ? fixedStep : stride * B;
+        const uint8_t* p = src;
+        for (uint32_t i = 0; i < frames; i++, p += step) {
+            dst[2 * i + 0] = conv(p);
+            dst[2 * i + 1] = conv(p + B);
+        }
+    }
+}
+
+template <SampleFmt In, typename Out>
+inline void convertByChannels(const uint8_t* src, Out* dst, uint32_t frames, uint8_t channels) {
+    switch (channels) {
+        case 1:  convertToStereo<In, 1>(src, dst, frames); break;
+        case 2:  convertToStereo<In, 2>(src, dst, frames); break;
+        default: convertToStereo<In, 0>(src, dst, frames, channels); break;
+    }
+}
+
+// Runtime entry point: one dispatch per block
+template <typename Out>
+inline void convertBlock(uint8_t fmt, uint8_t channels, const uint8_t* src, Out* dst, uint32_t frames) {
+    switch (fmt) {
+        case SAMPLE_FMT_S16:        convertByChannels<SAMPLE_FMT_S16>(src, dst, frames, channels); break;
+        case SAMPLE_FMT_S24_PACKED: convertByChannels<SAMPLE_FMT_S24_PACKED>(src, dst, frames, channels); break;
+        case SAMPLE_FMT_S24_IN_32:  convertByChannels<SAMPLE_FMT_S24_IN_32>(src, dst, frames, channels); break;
+        default:                    convertByChannels<SAMPLE_FMT_S32>(src, dst, frames, channels); break;
+    }
+}
+
+// Q31 -> S16 in place (the S16 block lands in the first half of the
+// buffer), with TPDF dither of +/-1 LSB: the sum of two uniform values
+// from one xorshift32 draw. Blocks with nothing below bit 16 (S16
+// sources through a bypassed DSP) are truncated exactly, no dither.
+struct S16Packer {
+    uint32_t seed = 0x9E3779B9u;
+
+    void pack(int32_t* buf, uint32_t samples) {
+        uint8_t* out = reinterpret_cast<uint8_t*>(buf);
+        int32_t low = 0;
+        for (uint32_t i = 0; i < samples; i++) low |= buf[i];
+        if ((low & 0xFFFF) == 0) {
+            for (uint32_t i = 0; i < samples; i++) {
+                const int16_t v = (int16_t)(buf[i] >> 16);
+                memcpy(out + 2 * i, &v, sizeof(v));     // Store behind the reads
+            }
+            return;
+        }
+        uint32_t r = seed;
+        for (uint32_t i = 0; i < samples; i++) {
+            r ^= r << 13;
+            r ^= r >> 17;
+            r ^= r << 5;
+            const int32_t d = (int32_t)(r & 0xFFFF) + (int32_t)(r >> 16) - 0xFFFF;
+            // Half scale so sample + dither + rounding cannot overflow
+            int32_t v = ((buf[i] >> 1) + (d >> 1) + 0x4000) >> 15;
+            if (v > 32767) v = 32767;
+            if (v < -32768) v = -32768;
+            const int16_t s16 = (int16_t)v;
+            memcpy(out + 2 * i, &s16, sizeof(s16));
+        }
+        seed = r;
+    }
+};
@@ -0,0 +1,213 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Sound Assets - prompts in a raw, memory-mapped flash partition
+// - Data partition APP_SOUND_ASSET_LABEL (any subtype): one 4 KB
+//   table sector, then one fixed, sector-aligned slot per sound
+// - A slot holds the bare data chunk of the uploaded WAV (PCM or IMA
+//   ADPCM); its format and length live in the table
+// - The partition is mapped once at init, so playback reads PCM
+//   straight out of the flash cache: no VFS, no copies
+// - Writes erase a few sectors ahead of the write pointer, with a
+//   short pause per step so BT keeps up; no filesystem GC stalls
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "../config/app_config.h"
+#include "wav_reader.h"
+
+class SoundAssets {
+public:
+    static constexpr int MAX_SLOTS = 4;
+
+    // Finds and maps the partition; false (SPIFFS only) if absent
+    bool init() {
+        m_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                          APP_SOUND_ASSET_LABEL);
+        if (!m_part) {
+            ESP_LOGI(TAG, "No '%s' partition, sounds stay on SPIFFS", APP_SOUND_ASSET_LABEL);
+            return false;
+        }
+        m_slotBytes = ((m_part->size - SECTOR) / MAX_SLOTS) & ~(size_t)(SECTOR - 1);
+        if (m_slotBytes == 0) {
+            ESP_LOGW(TAG, "'%s' partition too small", APP_SOUND_ASSET_LABEL);
+            m_part = nullptr;
+            return false;
+        }
+        const void* base = nullptr;
+        esp_err_t err = esp_partition_mmap(m_part, 0, m_part->size, ESP_PARTITION_MMAP_DATA,
+                                           &base, &m_mmap);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "mmap failed: %s", esp_err_to_name(err));
+            m_part = nullptr;
+            return false;
+        }
+        m_base = (const uint8_t*)base;
+
+        memcpy(&m_table, m_base, sizeof(m_table));
+        if (m_table.magic == MAGIC && m_table.version == 1) {
+            migrateTableV1();
+        } else if (m_table.magic != MAGIC || m_table.version != TABLE_VERSION) {
+            m_table = Table{};  // Blank or foreign: empty until first upload
+        }
+        ESP_LOGI(TAG, "'%s': %u KB per sound", APP_SOUND_ASSET_LABEL, (unsigned)(m_slotBytes / 1024));
+        return true;
+    }
+
+    bool available() const { return m_base != nullptr; }
+
+    bool has(int slot) const {
+        return available() && slot >= 0 && slot < MAX_SLOTS && m_table.entries[slot].bytes > 0;
+    }
+
+    // Points src at the slot's data
+    bool open(int slot, WavSource& src) const {
+        if (!has(slot)) return false;
+        const Entry& e = m_table.entries[slot];
+        WavHeader h = {};
+        h.audioFormat = e.format;
+        h.numChannels = e.channels;
+        h.sampleRate = e.sampleRate;
+        h.bitsPerSample = e.bitsPerSample;
+        h.blockAlign = e.blockAlign;
+        h.byteRate = h.sampleRate * h.blockAlign;
+        return src.openMapped(h, slotData(slot), e.bytes);
+    }
+
+    // Stores the PCM of an uploaded WAV in slot. The old sound is gone
+    // as soon as this starts; pauseMs is yielded after each erase step.
+    bool write(int slot, const uint8_t* wav, size_t len, uint32_t pauseMs) {
+        if (!available() || slot < 0 || slot >= MAX_SLOTS) return false;
+        WavHeader h;
+        size_t dataOffset = 0;
+        uint32_t dataBytes = 0;
+        if (!parseWavData(wav, len, h, dataOffset, dataBytes) || dataBytes == 0) {
+            ESP_LOGE(TAG, "Slot %d: not a playable WAV", slot);
+            return false;
+        }
+        if (dataBytes > m_slotBytes) {
+            ESP_LOGE(TAG, "Slot %d: %u bytes of audio, slot holds %u", slot,
+                     (unsigned)dataBytes, (unsigned)m_slotBytes);
+            return false;
+        }
+
+        // Unlist first, so a reset mid-write leaves no half-written sound
+        m_table.entries[slot] = Entry{};
+        if (!commitTable()) return false;
+
+        const size_t slotOffset = SECTOR + (size_t)slot * m_slotBytes;
+        const size_t eraseEnd = (dataBytes + SECTOR - 1) & ~(size_t)(SECTOR - 1);
+        size_t erased = 0;
+        size_t written = 0;
+        while (written < dataBytes) {
+            // Keep the erased region ERASE_STEP ahead of the write pointer
+            if (erased < eraseEnd && erased < written + ERASE_STEP) {
+                size_t n = eraseEnd - erased < ERASE_STEP ? eraseEnd - erased : ERASE_STEP;
+                if (esp_partition_erase_range(m_part, slotOffset + erased, n) != ESP_OK) {
+                    ESP_LOGE(TAG, "Slot %d: erase failed at %u", slot, (unsigned)erased);
+                    return false;
+                }
+                erased += n;
+                vTaskDelay(pdMS_TO_TICKS(pauseMs));
+            }
+            size_t n = dataBytes - written < SECTOR ? dataBytes - written : SECTOR;
+            if (esp_partition_write(m_part, slotOffset + written, wav + dataOffset + written, n) != ESP_OK) {
+                ESP_LOGE(TAG, "Slot %d: write failed at %u", slot, (unsigned)written);
+                return false;
+            }
+            written += n;
+            vTaskDelay(1);
+        }
+
+        Entry& e = m_table.entries[slot];
+        e.bytes = dataBytes;
+        e.sampleRate = h.sampleRate;
+        e.channels = h.numChannels;
+        e.bitsPerSample = h.bitsPerSample;
+        e.format = h.audioFormat;
+        e.blockAlign = h.blockAlign;
+        if (!commitTable()) return false;
+        ESP_LOGI(TAG, "Slot %d: %u bytes, %u Hz %u-bit %uch", slot, (unsigned)dataBytes,
+                 (unsigned)h.sampleRate, (unsigned)h.bitsPerSample, (unsigned)h.numChannels);
+        return true;
+    }
+
+    // Unlists slot; its sectors are erased by the next write
+    bool remove(int slot) {
+        if (!has(slot)) return false;
+        m_table.entries[slot] = Entry{};
+        return commitTable();
+    }
+
+private:
+    static constexpr const char* TAG = "SoundAssets";
+    static constexpr size_t SECTOR = 4096;
+    static constexpr size_t ERASE_STEP = 4 * SECTOR;
+    static constexpr uint32_t MAGIC = 0x41444E53;  // "SNDA"
+    static constexpr uint16_t TABLE_VERSION = 2;
+
+    struct Entry {
+        uint32_t bytes = 0;         // Data length, 0 = empty
+        uint32_t sampleRate = 0;
+        uint16_t channels = 0;
+        uint16_t bitsPerSample = 0;
+        uint16_t format = 0;        // WAV audioFormat
+        uint16_t blockAlign = 0;
+    };
+    struct Table {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t reserved;
+        Entry entries[MAX_SLOTS];
+    };
+
+    // Version 1 tables (PCM only, no format or block size) are read
+    // as such; the next commit writes them as the current version
+    void migrateTableV1() {
+        struct EntryV1 {
+            uint32_t bytes;
+            uint32_t sampleRate;
+            uint16_t channels;
+            uint16_t bitsPerSample;
+        };
+        EntryV1 old[MAX_SLOTS];
+        memcpy(old, m_base + offsetof(Table, entries), sizeof(old));
+        m_table = Table{};
+        for (int i = 0; i < MAX_SLOTS; i++) {
+            Entry& e = m_table.entries[i];
+            e.bytes = old[i].bytes;
+            e.sampleRate = old[i].sampleRate;
+            e.channels = old[i].channels;
+            e.bitsPerSample = old[i].bitsPerSample;
+            e.format = 1;
+            e.blockAlign = (uint16_t)(old[i].channels * old[i].bitsPerSample / 8);
+        }
+    }
+
+    const uint8_t* slotData(int slot) const {
+        return m_base + SECTOR + (size_t)slot * m_slotBytes;
+    }
+
+    bool commitTable() {
+        m_table.magic = MAGIC;
+        m_table.version = TABLE_VERSION;
+        if (esp_partition_erase_range(m_part, 0, SECTOR) != ESP_OK ||
+            esp_partition_write(m_part, 0, &m_table, sizeof(m_table)) != ESP_OK) {
+            ESP_LOGE(TAG, "Table write failed");
+            return false;
+        }
+        return true;
+    }
+
+    const esp_partition_t* m_part = nullptr;
+    esp_partition_mmap_handle_t m_mmap = 0;
+    const uint8_t* m_base = nullptr;
+    size_t m_slotBytes = 0;
+    Table m_table = {};
+};
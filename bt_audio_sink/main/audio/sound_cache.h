@@ -0,0 +1,169 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Sound Cache - system prompts pre-rendered for the live I2S rate
+// - Each cached prompt is the whole WAV resampled to the current
+//   I2S rate as interleaved S16 stereo in PSRAM, fade-in applied,
+//   so playing it is a pointer walk: no file I/O, no allocation
+// - Rendering happens off the playback path (SoundPlayer's cache
+//   task) and again whenever the I2S rate changes; until then
+//   playback streams the file as before
+// - An entry is swapped under the cache lock; playback holds the
+//   lock while it walks an entry, so a render never frees PCM in use
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "../config/app_config.h"
+#include "../dsp/polyphase_resampler.h"
+#include "wav_reader.h"
+
+class SoundCache {
+public:
+    struct Entry {
+        int16_t* pcm = nullptr;     // Interleaved stereo at rate
+        size_t frames = 0;
+        uint32_t rate = 0;          // 0 = not rendered
+        bool tooLong = false;       // File exceeds APP_SOUND_CACHE_MAX_MS
+    };
+
+    SoundCache() : m_lock(xSemaphoreCreateMutexStatic(&m_lockBuf)) {}
+
+    // Rendered for rate and not taken by a render: caller walks
+    // entry(slot) and must call release()
+    bool acquire(int slot, uint32_t rate) {
+        if (slot < 0 || slot >= MAX_SLOTS) return false;
+        if (xSemaphoreTake(m_lock, 0) != pdTRUE) return false;
+        if (m_entries[slot].pcm && m_entries[slot].rate == rate) return true;
+        xSemaphoreGive(m_lock);
+        return false;
+    }
+    void release() { xSemaphoreGive(m_lock); }
+    const Entry& entry(int slot) const { return m_entries[slot]; }
+
+    // Whether slot should be (re-)rendered for rate
+    bool stale(int slot, uint32_t rate) const {
+        const Entry& e = m_entries[slot];
+        return !e.tooLong && e.rate != rate;
+    }
+
+    // Drops a slot's PCM (file replaced or deleted)
+    void invalidate(int slot) {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        freeEntry(m_entries[slot]);
+        m_entries[slot].tooLong = false;
+        xSemaphoreGive(m_lock);
+    }
+
+    // Resamples src (closed on return) to rate into slot; name is for
+    // the log. Slow (flash reads and the resampler): only from the
+    // cache task.
+    bool render(int slot, WavSource& src, uint32_t rate, const char* name) {
+        const WavHeader& h = src.header;
+        const size_t inFrames = src.dataBytes / h.blockAlign;
+        if ((uint64_t)inFrames * 1000 > (uint64_t)h.sampleRate * APP_SOUND_CACHE_MAX_MS) {
+            src.close();
+            xSemaphoreTake(m_lock, portMAX_DELAY);
+            freeEntry(m_entries[slot]);
+            m_entries[slot].tooLong = true;
+            xSemaphoreGive(m_lock);
+            ESP_LOGI(TAG, "%s: longer than %u ms, streamed from flash", name, (unsigned)APP_SOUND_CACHE_MAX_MS);
+            return false;
+        }
+
+        m_resampler.reset();
+        if (!m_resampler.init(h.sampleRate, rate)) {
+            src.close();
+            return false;
+        }
+        // Stereo S16 already at rate (a transcoded upload) is copied as is
+        const bool direct = h.numChannels == 2 && h.bitsPerSample == 16 && h.sampleRate == rate;
+        const size_t capFrames = m_resampler.maxOutput(inFrames);
+        const size_t chunkOut = m_resampler.maxOutput(CHUNK_FRAMES);
+        int16_t* pcm = (int16_t*)heap_caps_malloc(capFrames * 2 * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        int32_t* out = (int32_t*)heap_caps_malloc(chunkOut * 2 * sizeof(int32_t), MALLOC_CAP_8BIT);
+        if (!pcm || !out) {
+            ESP_LOGW(TAG, "%s: no memory for %u frames", name, (unsigned)capFrames);
+            if (pcm) heap_caps_free(pcm);
+            if (out) heap_caps_free(out);
+            src.close();
+            return false;
+        }
+
+        uint8_t raw[CHUNK_FRAMES * 4];
+        int16_t s16[CHUNK_FRAMES * 2];
+        size_t frames = 0;
+        size_t left = inFrames;
+        while (left > 0) {
+            size_t n = left < CHUNK_FRAMES ? left : CHUNK_FRAMES;
+            n = src.read(raw, n * h.blockAlign) / h.blockAlign;
+            if (n == 0) break;
+            left -= n;
+            const size_t samples = n * h.numChannels;
+            if (h.bitsPerSample == 16) {
+                memcpy(s16, raw, samples * sizeof(int16_t));
+            } else {
+                for (size_t i = 0; i < samples; i++) s16[i] = convert_u8_to_s16(raw[i]);
+            }
+            size_t got;
+            if (direct) {
+                memcpy(pcm + frames * 2, s16, n * 2 * sizeof(int16_t));
+                frames += n;
+                continue;
+            }
+            got = m_resampler.process(s16, n, h.numChannels, 1.0f, out, chunkOut, 1.0f);
+            if (got > capFrames - frames) got = capFrames - frames;
+            for (size_t i = 0; i < got * 2; i++) {
+                int32_t v = out[i];
+                pcm[frames * 2 + i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+            }
+            frames += got;
+        }
+        src.close();
+        heap_caps_free(out);
+        applyFadeIn(pcm, frames, rate);
+
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        freeEntry(m_entries[slot]);
+        m_entries[slot].pcm = pcm;
+        m_entries[slot].frames = frames;
+        m_entries[slot].rate = rate;
+        xSemaphoreGive(m_lock);
+        ESP_LOGI(TAG, "%s: %u frames at %u Hz (%u KB)", name, (unsigned)frames, (unsigned)rate,
+                 (unsigned)(frames * 4 / 1024));
+        return true;
+    }
+
+    static constexpr int MAX_SLOTS = 4;
+
+private:
+    static constexpr const char* TAG = "SoundCache";
+    static constexpr size_t CHUNK_FRAMES = 256;
+    static constexpr int FADE_IN_MS = 10;  // Same pop guard as streamed playback
+
+    static void applyFadeIn(int16_t* pcm, size_t frames, uint32_t rate) {
+        size_t fade = (size_t)rate * FADE_IN_MS / 1000;
+        if (fade > frames) fade = frames;
+        for (size_t i = 0; i < fade; i++) {
+            const float g = (float)i / (float)fade;
+            pcm[i * 2] = (int16_t)((float)pcm[i * 2] * g);
+            pcm[i * 2 + 1] = (int16_t)((float)pcm[i * 2 + 1] * g);
+        }
+    }
+
+    static void freeEntry(Entry& e) {
+        if (e.pcm) heap_caps_free(e.pcm);
+        e.pcm = nullptr;
+        e.frames = 0;
+        e.rate = 0;
+    }
+
+    StaticSemaphore_t m_lockBuf;
+    SemaphoreHandle_t m_lock;
+    Entry m_entries[MAX_SLOTS];
+    PolyphaseResampler m_resampler;   // Cache task only
+};
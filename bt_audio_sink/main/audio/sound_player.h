@@ -3,14 +3,37 @@
 // -----------------------------------------------------------
 // Sound Player - plays WAV files with dynamic resampling
 // Supports: startup, pairing, connected, max volume sounds
-// Uses linear interpolation resampler for any I2S sample rate
+// Uses the polyphase resampler for any I2S sample rate
 // 
 // Two playback modes:
-// - EXCLUSIVE: Sound replaces BT audio (writes directly to I2S)
+// - EXCLUSIVE: Sound replaces BT audio (OverlayMixer voice that
+//   ducks BT fully; audio_tx remains the only I2S writer)
 // - OVERLAY: Sound is mixed with BT audio via OverlayMixer
+//
+// With APP_SOUND_CACHE the system prompts (all but startup) are also
+// kept pre-rendered at the I2S rate (see SoundCache) and played from
+// there; the file is streamed only while a render is outstanding
+//
+// With APP_SOUND_ASSETS, sounds are stored in a raw mapped partition
+// (see SoundAssets) when the partition table has one; SPIFFS files
+// left from older firmware are moved there after boot
+// (migrateToAssets) and played from SPIFFS until then
+//
+// With APP_SOUND_TRANSCODE, uploads are rewritten as stereo S16 at
+// the boot I2S rate, so playback at that rate skips the resampler
+//
+// Sounds may also be IMA ADPCM WAVs (a quarter of the 16-bit size,
+// uploaded and stored as they are); WavSource decodes them a block
+// at a time into the same 20 ms chunks the PCM path reads
+//
+// Playback runs on one worker task, created at init on the reserved
+// stack with its buffers; play() hands it a command (sound and mode,
+// the rate is the current target) by task notification, so a prompt
+// starts without a task to create or memory to find
 // -----------------------------------------------------------
 
 #include <stdint.h>
+#include <new>
 #include <string.h>
 #include <cmath>
 #include "freertos/FreeRTOS.h"
@@ -20,142 +43,17 @@
 #include "esp_spiffs.h"
 #include "esp_heap_caps.h"
 #include "../config/app_config.h"
+#include "../core/static_alloc.h"
+#include "../core/mem_placement.h"
 #include "../dsp/fast_math.h"
-
-// -----------------------------------------------------------
-// Dynamic Audio Resampler (linear interpolation)
-// Works with any input → any output sample rate
-// -----------------------------------------------------------
+#include "../dsp/polyphase_resampler.h"
+#include "wav_reader.h"
+#include "sound_cache.h"
+#include "sound_assets.h"
 
 // Fade duration in milliseconds (to eliminate pop sounds)
 static constexpr int FADE_MS = 10;  // 10ms fade-in/fade-out
 
-typedef struct {
-    float ratio;         // input_rate / output_rate
-    float pos;           // fractional position in input stream
-    int16_t lastLeft;    // last sample for interpolation (left/mono)
-    int16_t lastRight;   // last sample for interpolation (right)
-    bool hasLast;        // true after first sample processed
-    bool isStereo;       // source is stereo
-    
-    // Fade-in control to eliminate pop at start
-    size_t fadeInFrames;     // Total frames in fade-in ramp
-    size_t fadeInRemaining;  // Frames left in fade-in
-} AudioResampler;
-
-// Initialize resampler - call when WAV or I2S config changes
-static inline void resampler_init(AudioResampler* r,
-                                   uint32_t inputRate,
-                                   uint32_t outputRate,
-                                   bool stereo) {
-    r->ratio = (float)inputRate * fast_recipsf2((float)outputRate);
-    r->pos = 0.0f;
-    r->lastLeft = 0;
-    r->lastRight = 0;
-    r->hasLast = false;
-    r->isStereo = stereo;
-    
-    // Calculate fade-in frames based on output rate
-    r->fadeInFrames = (outputRate * FADE_MS) / 1000;
-    r->fadeInRemaining = r->fadeInFrames;
-}
-
-// Resample 16-bit audio to 32-bit stereo I2S output
-// Returns number of stereo frames written to output
-static inline size_t resample_s16_to_s32_stereo(
-    AudioResampler* r,
-    const int16_t* in,       // Input samples (mono or stereo based on r->isStereo)
-    size_t inSamples,        // Number of input FRAMES (not samples)
-    int32_t* out,            // Output buffer (stereo interleaved: L,R,L,R...)
-    size_t outCapacity)      // Max output FRAMES
-{
-    size_t outCount = 0;
-    
-    if (!r->hasLast && inSamples > 0) {
-        if (r->isStereo) {
-            r->lastLeft = in[0];
-            r->lastRight = in[1];
-        } else {
-            r->lastLeft = r->lastRight = in[0];
-        }
-        r->hasLast = true;
-    }
-    
-    const size_t inStep = r->isStereo ? 2 : 1;
-    
-    while (outCount < outCapacity) {
-        uint32_t idx = (uint32_t)r->pos;
-        uint32_t next = idx + 1;
-        
-        if (next >= inSamples) {
-            break; // Need more input
-        }
-        
-        float frac = r->pos - (float)idx;
-        
-        int16_t l0, r0, l1, r1;
-        
-        if (r->isStereo) {
-            if (idx == 0 && r->hasLast) {
-                l0 = r->lastLeft;
-                r0 = r->lastRight;
-            } else {
-                l0 = in[idx * 2];
-                r0 = in[idx * 2 + 1];
-            }
-            l1 = in[next * 2];
-            r1 = in[next * 2 + 1];
-        } else {
-            // Mono input → stereo output
-            if (idx == 0 && r->hasLast) {
-                l0 = r0 = r->lastLeft;
-            } else {
-                l0 = r0 = in[idx];
-            }
-            l1 = r1 = in[next];
-        }
-        
-        // Linear interpolation
-        float sampleL = (1.0f - frac) * l0 + frac * l1;
-        float sampleR = (1.0f - frac) * r0 + frac * r1;
-        
-        // Apply fade-in envelope to eliminate pop at start
-        if (r->fadeInRemaining > 0) {
-            float fadeGain = 1.0f - ((float)r->fadeInRemaining * fast_recipsf2((float)r->fadeInFrames));
-            sampleL *= fadeGain;
-            sampleR *= fadeGain;
-            r->fadeInRemaining--;
-        }
-        
-        // Expand 16-bit → 32-bit signed (left-align for I2S)
-        out[outCount * 2] = (int32_t)(sampleL * 65536.0f);
-        out[outCount * 2 + 1] = (int32_t)(sampleR * 65536.0f);
-        
-        outCount++;
-        r->pos += r->ratio;
-    }
-    
-    // Keep fractional remainder, save last sample for next chunk
-    uint32_t consumed = (uint32_t)r->pos;
-    r->pos -= (float)consumed;
-    
-    if (inSamples > 0) {
-        if (r->isStereo) {
-            r->lastLeft = in[(inSamples - 1) * 2];
-            r->lastRight = in[(inSamples - 1) * 2 + 1];
-        } else {
-            r->lastLeft = r->lastRight = in[inSamples - 1];
-        }
-    }
-    
-    return outCount;
-}
-
-// Convert 8-bit unsigned to 16-bit signed
-static inline int16_t convert_u8_to_s16(uint8_t sample) {
-    return ((int16_t)sample - 128) << 8;
-}
-
 // -----------------------------------------------------------
 
 // Sound types (matches Android app)
@@ -173,22 +71,6 @@ enum SoundPlayMode {
     SOUND_MODE_OVERLAY       // Mix with current A2DP audio
 };
 
-// WAV file header structure
-struct WavHeader {
-    char riff[4];           // "RIFF"
-    uint32_t fileSize;      // File size - 8
-    char wave[4];           // "WAVE"
-    char fmt[4];            // "fmt "
-    uint32_t fmtSize;       // Format chunk size (16 for PCM)
-    uint16_t audioFormat;   // 1 = PCM
-    uint16_t numChannels;   // 1 = mono, 2 = stereo
-    uint32_t sampleRate;    // e.g., 44100
-    uint32_t byteRate;      // sampleRate * numChannels * bitsPerSample/8
-    uint16_t blockAlign;    // numChannels * bitsPerSample/8
-    uint16_t bitsPerSample; // 8 or 16
-    // Data chunk follows
-};
-
 // Sound file paths in SPIFFS
 static const char* SOUND_PATHS[SOUND_TYPE_COUNT] = {
     "/spiffs/startup.wav",
@@ -247,30 +129,65 @@ public:
             return false;
         }
         
-        // Pre-allocate task stack in internal RAM while we have plenty available
-        // This avoids task creation failures later when BT consumes internal RAM
-        if (!m_taskStack) {
-            m_taskStack = (StackType_t*)heap_caps_malloc(TASK_STACK_SIZE * sizeof(StackType_t), 
-                                                          MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-            if (!m_taskStack) {
-                ESP_LOGE(TAG, "Failed to pre-allocate task stack from internal RAM");
-                return false;
-            }
-            ESP_LOGI(TAG, "Pre-allocated task stack: %u bytes in internal RAM", 
-                     (unsigned)(TASK_STACK_SIZE * sizeof(StackType_t)));
+        if (!reserveTaskStack()) return false;
+        // Playback scratch for the largest chunk up front (without PSRAM
+        // each play allocates its own, as before)
+        m_scratch = (uint8_t*)StaticAlloc::take("snd_scratch", SCRATCH_BYTES, StaticAlloc::PSRAM);
+        if (!m_scratch) m_scratch = (uint8_t*)heap_caps_malloc(SCRATCH_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        
+        m_playbackTaskHandle = xTaskCreateStaticPinnedToCore(
+            playbackTask, "sound_play", TASK_STACK_SIZE, this, 5,
+            m_taskStack, &m_taskTCB, APP_CONTROL_CORE);  // Away from audio_tx
+        if (!m_playbackTaskHandle) {
+            ESP_LOGE(TAG, "Failed to create playback task");
+            return false;
         }
         
+#if APP_SOUND_ASSETS
+        m_assets.init();
+#endif
+        
         // Check which sound files exist
         updateSoundStatus();
         
+#if APP_SOUND_CACHE
+        // Prompts are rendered in the background, starting at the boot rate
+        if (StaticAlloc::createTask(cacheTask, "snd_cache", 6144, this, 1,
+                                    &m_cacheTask, APP_CONTROL_CORE) == pdPASS) {
+            kickCache();
+        }
+#endif
+        
         m_initialized = true;
         ESP_LOGI(TAG, "SoundPlayer initialized, status: 0x%02X", m_soundStatus);
         return true;
     }
 
-    // Initialize with a target sample rate
+    // Pre-allocate task stack in internal RAM while we have plenty available
+    // This avoids task creation failures later when BT consumes internal RAM
+    // (init() does this too; call it early when init() runs alongside BT init)
+    bool reserveTaskStack() {
+        if (m_taskStack) return true;
+        m_taskStack = (StackType_t*)StaticAlloc::take("sound_play", TASK_STACK_SIZE * sizeof(StackType_t),
+                                                      StaticAlloc::INTERNAL);
+        if (!m_taskStack) {
+            m_taskStack = (StackType_t*)heap_caps_malloc(TASK_STACK_SIZE * sizeof(StackType_t), 
+                                                          MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        }
+        if (!m_taskStack) {
+            ESP_LOGE(TAG, "Failed to pre-allocate task stack from internal RAM");
+            return false;
+        }
+        ESP_LOGI(TAG, "Pre-allocated task stack: %u bytes in internal RAM", 
+                 (unsigned)(TASK_STACK_SIZE * sizeof(StackType_t)));
+        return true;
+    }
+
+    // Initialize with a target sample rate (also the rate uploads are
+    // transcoded to)
     bool init(uint32_t targetRate) {
         m_targetSampleRate = targetRate;
+        m_canonicalRate = targetRate;
         return init();
     }
 
@@ -279,6 +196,7 @@ public:
     void setTargetSampleRate(uint32_t rate) {
         m_targetSampleRate = rate;
         m_sampleRateChanged = true;  // Signal to playback loop
+        kickCache();
     }
     
     // Get current target sample rate
@@ -316,68 +234,35 @@ public:
 
     // Play a sound with explicit sample rate (non-blocking)
     bool play(SoundType type, uint32_t targetRate, SoundPlayMode mode) {
-        m_targetSampleRate = targetRate;
+        if (targetRate != m_targetSampleRate) {
+            m_targetSampleRate = targetRate;
+            kickCache();
+        }
         return play(type, mode);
     }
 
-    // Play a sound (non-blocking, starts playback task)
+    // Play a sound (non-blocking, wakes the playback task). A sound
+    // asked for while another plays follows it (the last one asked for)
     bool play(SoundType type, SoundPlayMode mode = SOUND_MODE_EXCLUSIVE) {
         if (!m_initialized || m_muted) return false;
         if (type >= SOUND_TYPE_COUNT) return false;
         if (!hasSound(type)) return false;
         
-        // If already playing something in exclusive mode, queue it
-        if (m_playing && mode == SOUND_MODE_EXCLUSIVE) {
+        portENTER_CRITICAL(&m_lock);
+        const bool busy = m_playing;
+        if (busy) {
             m_pendingSound = type;
             m_pendingMode = mode;
+        } else {
+            m_playing = true;
+            m_stopRequested = false;
+        }
+        portEXIT_CRITICAL(&m_lock);
+        if (busy) {
             ESP_LOGI(TAG, "Queued sound: %d", type);
             return true;
         }
-        
-        // If a previous task exists, wait for it to fully clean up
-        if (m_playbackTaskHandle != nullptr) {
-            ESP_LOGW(TAG, "Waiting for previous playback task to finish");
-            uint32_t waitStart = millis32();
-            while (m_playbackTaskHandle != nullptr && (millis32() - waitStart) < 500) {
-                vTaskDelay(pdMS_TO_TICKS(10));
-            }
-            if (m_playbackTaskHandle != nullptr) {
-                ESP_LOGE(TAG, "Previous task did not finish, aborting");
-                return false;
-            }
-        }
-        
-        // Start playback
-        m_currentSound = type;
-        m_playMode = mode;
-        m_playing = true;
-        m_stopRequested = false;
-        
-        // Log heap before task creation
-        ESP_LOGI(TAG, "Creating playback task, free heap: internal=%u, PSRAM=%u",
-                 (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
-                 (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
-        
-        // Use pre-allocated internal RAM stack with static task creation
-        // This avoids dynamic allocation when internal RAM is fragmented
-        if (!m_taskStack) {
-            ESP_LOGE(TAG, "Task stack not pre-allocated!");
-            m_playing = false;
-            return false;
-        }
-        
-        m_playbackTaskHandle = xTaskCreateStaticPinnedToCore(
-            playbackTask, "sound_play", TASK_STACK_SIZE, this, 5,
-            m_taskStack, &m_taskTCB, 0);  // Core 0, away from BT on core 1
-        
-        if (!m_playbackTaskHandle) {
-            ESP_LOGE(TAG, "Failed to create playback task (static), free internal=%u",
-                     (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
-            m_playing = false;
-            return false;
-        }
-        
-        ESP_LOGI(TAG, "Playing sound: %d (mode=%d)", type, mode);
+        xTaskNotify(m_playbackTaskHandle, command(type, mode), eSetValueWithOverwrite);
         return true;
     }
 
@@ -402,23 +287,61 @@ public:
     bool deleteSound(SoundType type) {
         if (type >= SOUND_TYPE_COUNT) return false;
         
+        stopIfPlaying(type);
         xSemaphoreTake(m_mutex, portMAX_DELAY);
         
-        int ret = remove(SOUND_PATHS[type]);
-        if (ret == 0) {
+        bool deleted = remove(SOUND_PATHS[type]) == 0;
+#if APP_SOUND_ASSETS
+        deleted |= m_assets.remove(type);
+#endif
+        if (deleted) {
             m_soundStatus &= ~(1 << type);
             ESP_LOGI(TAG, "Deleted sound: %s", SOUND_PATHS[type]);
         }
+#if APP_SOUND_CACHE
+        m_cache.invalidate(type);
+#endif
         
         xSemaphoreGive(m_mutex);
-        return ret == 0;
+        return deleted;
     }
 
-    // Save uploaded sound file
-    bool saveSound(SoundType type, const uint8_t* data, size_t len) {
+    // Whether uploads go to the asset partition (saveSound) rather
+    // than SPIFFS files
+    bool hasAssetStore() const {
+#if APP_SOUND_ASSETS
+        return m_assets.available();
+#else
+        return false;
+#endif
+    }
+    
+    // Save uploaded sound file. pauseMs is yielded per flash erase step
+    // when the asset partition is used.
+    bool saveSound(SoundType type, const uint8_t* data, size_t len, uint32_t pauseMs = 20) {
         if (type >= SOUND_TYPE_COUNT) return false;
         if (len < sizeof(WavHeader)) return false;
         
+#if APP_SOUND_ASSETS
+        if (m_assets.available()) {
+            stopIfPlaying(type);
+            xSemaphoreTake(m_mutex, portMAX_DELAY);
+            bool ok = m_assets.write(type, data, len, pauseMs);
+            if (ok) {
+                m_soundStatus |= (1 << type);
+                remove(SOUND_PATHS[type]);  // Superseded SPIFFS copy, if any
+            } else {
+                m_soundStatus &= ~(1 << type);
+            }
+#if APP_SOUND_CACHE
+            m_cache.invalidate(type);
+#endif
+            xSemaphoreGive(m_mutex);
+            kickCache();
+            return ok;
+        }
+#endif
+        
         xSemaphoreTake(m_mutex, portMAX_DELAY);
         
         FILE* f = fopen(SOUND_PATHS[type], "wb");
@@ -435,11 +358,147 @@ public:
             m_soundStatus |= (1 << type);
             ESP_LOGI(TAG, "Saved sound: %s (%u bytes)", SOUND_PATHS[type], (unsigned)len);
         }
+#if APP_SOUND_CACHE
+        m_cache.invalidate(type);
+#endif
         
         xSemaphoreGive(m_mutex);
+        kickCache();
         return written == len;
     }
 
+    // Moves sounds still held as SPIFFS files into the asset partition
+    // (as saveSound, so transcoded and the file deleted once its slot is
+    // committed). A sound that cannot be read or does not fit stays on
+    // SPIFFS and keeps playing from there. Slow: from a background task.
+    // Returns how many were moved.
+    int migrateToAssets(uint32_t pauseMs) {
+        int moved = 0;
+#if APP_SOUND_ASSETS
+        if (!m_assets.available()) return 0;
+        for (int i = 0; i < SOUND_TYPE_COUNT; i++) {
+            if (m_assets.has(i)) continue;
+            FILE* f = fopen(SOUND_PATHS[i], "rb");
+            if (!f) continue;
+            fseek(f, 0, SEEK_END);
+            const long size = ftell(f);
+            fseek(f, 0, SEEK_SET);
+            uint8_t* buf = nullptr;
+            size_t len = 0;
+            if (size > (long)sizeof(WavHeader)) {
+                buf = (uint8_t*)heap_caps_malloc((size_t)size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+                if (!buf) buf = (uint8_t*)heap_caps_malloc((size_t)size, MALLOC_CAP_8BIT);
+                if (buf) len = fread(buf, 1, (size_t)size, f);
+            }
+            fclose(f);
+            if (!buf || len != (size_t)size) {
+                ESP_LOGW(TAG, "Migrate %s: %u bytes not readable, left on SPIFFS",
+                         SOUND_PATHS[i], (unsigned)size);
+                heap_caps_free(buf);
+                continue;
+            }
+
+            uint8_t* canonical = nullptr;
+            size_t canonicalSize = 0;
+            if (transcode(buf, len, canonical, canonicalSize)) {
+                heap_caps_free(buf);
+                buf = canonical;
+                len = canonicalSize;
+            }
+            const uint32_t t0 = millis32();
+            if (saveSound((SoundType)i, buf, len, pauseMs)) {
+                ESP_LOGI(TAG, "Migrated %s to the asset partition in %u ms", SOUND_PATHS[i],
+                         (unsigned)(millis32() - t0));
+                moved++;
+            } else if (FILE* keep = fopen(SOUND_PATHS[i], "rb")) {
+                // A failed slot write leaves the file; it still plays
+                fclose(keep);
+                m_soundStatus |= (1 << i);
+            }
+            heap_caps_free(buf);
+        }
+#else
+        (void)pauseMs;
+#endif
+        return moved;
+    }
+
+    // Rewrites an uploaded WAV as stereo S16 at the canonical rate, so
+    // playback at that rate is a straight copy. out is a new PSRAM
+    // buffer the caller frees; false leaves the upload as it is
+    // (already canonical, ADPCM, not a WAV, too large, out of memory).
+    // Slow: from the upload's background task.
+    bool transcode(const uint8_t* wav, size_t len, uint8_t*& out, size_t& outLen) {
+#if APP_SOUND_TRANSCODE
+        WavHeader h;
+        size_t dataOffset = 0;
+        uint32_t dataBytes = 0;
+        if (!parseWavData(wav, len, h, dataOffset, dataBytes)) return false;
+        // Compressed uploads stay compressed: 4x less flash to read
+        if (wavIsAdpcm(h)) return false;
+        const uint32_t rate = m_canonicalRate;
+        if (h.numChannels == 2 && h.bitsPerSample == 16 && h.sampleRate == rate) return false;
+        
+        PolyphaseResampler* rs = new (std::nothrow) PolyphaseResampler();
+        if (!rs || !rs->init(h.sampleRate, rate)) {
+            delete rs;
+            return false;
+        }
+        const size_t inFrames = dataBytes / h.blockAlign;
+        const size_t capFrames = rs->maxOutput(inFrames);
+        const size_t chunkOut = rs->maxOutput(TRANSCODE_CHUNK);
+        if (WAV_CANONICAL_HEADER + capFrames * 4 > TRANSCODE_MAX_BYTES) {
+            ESP_LOGW(TAG, "Upload would be %u KB at %u Hz, kept as is",
+                     (unsigned)(capFrames * 4 / 1024), (unsigned)rate);
+            delete rs;
+            return false;
+        }
+        uint8_t* dst = (uint8_t*)heap_caps_malloc(WAV_CANONICAL_HEADER + capFrames * 4, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        int32_t* tmp = (int32_t*)heap_caps_malloc(chunkOut * 2 * sizeof(int32_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!dst || !tmp) {
+            ESP_LOGW(TAG, "No memory to transcode upload");
+            if (dst) heap_caps_free(dst);
+            if (tmp) heap_caps_free(tmp);
+            delete rs;
+            return false;
+        }
+        
+        int16_t* pcm = (int16_t*)(dst + WAV_CANONICAL_HEADER);
+        int16_t s16[TRANSCODE_CHUNK * 2];
+        const uint8_t* src = wav + dataOffset;
+        size_t frames = 0;
+        for (size_t done = 0; done < inFrames; ) {
+            size_t n = inFrames - done < TRANSCODE_CHUNK ? inFrames - done : TRANSCODE_CHUNK;
+            const size_t samples = n * h.numChannels;
+            if (h.bitsPerSample == 16) {
+                memcpy(s16, src + done * h.blockAlign, samples * sizeof(int16_t));
+            } else {
+                for (size_t i = 0; i < samples; i++) s16[i] = convert_u8_to_s16(src[done * h.blockAlign + i]);
+            }
+            size_t got = rs->process(s16, n, h.numChannels, 1.0f, tmp, chunkOut, 1.0f);
+            if (got > capFrames - frames) got = capFrames - frames;
+            for (size_t i = 0; i < got * 2; i++) {
+                int32_t v = tmp[i];
+                pcm[frames * 2 + i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+            }
+            frames += got;
+            done += n;
+        }
+        heap_caps_free(tmp);
+        delete rs;
+        
+        writeWavHeader(dst, rate, 2, 16, (uint32_t)(frames * 4));
+        out = dst;
+        outLen = WAV_CANONICAL_HEADER + frames * 4;
+        ESP_LOGI(TAG, "Upload transcoded: %u Hz %u-bit %uch -> %u Hz 16-bit stereo (%u KB)",
+                 (unsigned)h.sampleRate, (unsigned)h.bitsPerSample, (unsigned)h.numChannels,
+                 (unsigned)rate, (unsigned)(outLen / 1024));
+        return true;
+#else
+        return false;
+#endif
+    }
+    
     // Get samples for mixing with A2DP (for overlay mode)
     // Returns number of samples written, 0 if no sound playing
     // Note: Overlay mode not fully implemented with streaming resampler
@@ -463,15 +522,13 @@ public:
 
     // Refresh sound file status (public for use after upload)
     void refreshStatus() {
-        m_soundStatus = 0;
-        for (int i = 0; i < SOUND_TYPE_COUNT; i++) {
-            FILE* f = fopen(SOUND_PATHS[i], "rb");
-            if (f) {
-                fclose(f);
-                m_soundStatus |= (1 << i);
-            }
-        }
+        updateSoundStatus();
         ESP_LOGI(TAG, "Sound status refreshed: 0x%02X", m_soundStatus);
+#if APP_SOUND_CACHE
+        // Called after uploads, which replace files behind our back
+        for (int i = 0; i < SOUND_TYPE_COUNT; i++) m_cache.invalidate(i);
+        kickCache();
+#endif
     }
 
 private:
@@ -482,6 +539,12 @@ private:
     void updateSoundStatus() {
         m_soundStatus = 0;
         for (int i = 0; i < SOUND_TYPE_COUNT; i++) {
+#if APP_SOUND_ASSETS
+            if (m_assets.has(i)) {
+                m_soundStatus |= (1 << i);
+                continue;
+            }
+#endif
             FILE* f = fopen(SOUND_PATHS[i], "rb");
             if (f) {
                 fclose(f);
@@ -490,79 +553,180 @@ private:
         }
     }
     
+    // PCM of a sound: the asset partition first, then its SPIFFS file
+    bool openSource(SoundType type, WavSource& src) {
+#if APP_SOUND_ASSETS
+        if (m_assets.open(type, src)) return true;
+#endif
+        return src.openFile(SOUND_PATHS[type]);
+    }
+    
+    // Storage of type is about to change under playback
+    void stopIfPlaying(SoundType type) {
+        if (m_playing && m_currentSound == type) {
+            stop();
+            waitForCompletion(1000);
+        }
+    }
+    
     static uint32_t millis32() {
         return (uint32_t)(esp_timer_get_time() / 1000);
     }
     
-    // Playback task
+    // Play command for the task's notification value: sound, mode
+    static uint32_t command(SoundType type, SoundPlayMode mode) {
+        return (uint32_t)type | ((uint32_t)mode << 8);
+    }
+    
+    // Playback task: one command at a time, then the sound queued
+    // behind it, if any, without going back to sleep
     static void playbackTask(void* param) {
         SoundPlayer* self = (SoundPlayer*)param;
-        self->doPlayback();
-        vTaskDelete(NULL);
+        while (true) {
+            uint32_t cmd = 0;
+            xTaskNotifyWait(0, UINT32_MAX, &cmd, portMAX_DELAY);
+            self->doPlayback((SoundType)(cmd & 0xFF), (SoundPlayMode)((cmd >> 8) & 0xFF));
+        }
     }
     
-    void doPlayback() {
-        ESP_LOGI(TAG, ">>> doPlayback task started");
-        
-        xSemaphoreTake(m_mutex, portMAX_DELAY);
-        
-        ESP_LOGI(TAG, ">>> mutex acquired, opening file");
-        
-        const char* path = SOUND_PATHS[m_currentSound];
-        FILE* f = fopen(path, "rb");
-        if (!f) {
-            ESP_LOGE(TAG, "Failed to open: %s", path);
-            m_playing = false;
-            xSemaphoreGive(m_mutex);
-            return;
+    void doPlayback(SoundType type, SoundPlayMode mode) {
+        for (;;) {
+            m_currentSound = type;
+            m_playMode = mode;
+            ESP_LOGD(TAG, "Playing sound: %d (mode=%d)", type, mode);
+#if APP_SOUND_CACHE
+            if (!playCached())
+#endif
+            playFile();
+            
+            // The queued sound and m_playing change together, so a
+            // play() either queues behind this one or sends a command
+            portENTER_CRITICAL(&m_lock);
+            const int pending = m_pendingSound;
+            const bool next = pending >= 0 && pending < SOUND_TYPE_COUNT && !m_muted;
+            m_pendingSound = -1;
+            if (next) {
+                type = (SoundType)pending;
+                mode = m_pendingMode;
+                m_stopRequested = false;
+            } else {
+                m_playing = false;
+            }
+            portEXIT_CRITICAL(&m_lock);
+            if (!next) break;
+            ESP_LOGI(TAG, "Playing queued sound: %d", pending);
         }
-        
-        // Read WAV header
-        WavHeader header;
-        if (fread(&header, 1, sizeof(header), f) != sizeof(header)) {
-            ESP_LOGE(TAG, "Failed to read WAV header");
-            fclose(f);
-            m_playing = false;
+        ESP_LOGI(TAG, "Playback complete");
+    }
+    
+    // Hands one block of 32-bit stereo to the overlay mixer, then waits
+    // while more than PUSH_AHEAD_MS is queued there; false without a mixer
+    bool emit(int32_t* outputS32, size_t outputFrames, uint32_t rate) {
+        if (!m_overlayPushFunc) return false;
+        if (outputFrames == 0) return true;
+        // Exclusive sounds go to a voice that mutes BT instead of
+        // writing I2S themselves, so audio_tx stays the only writer
+        size_t queued = m_overlayPushFunc(outputS32, outputFrames, m_playMode == SOUND_MODE_EXCLUSIVE);
+        const size_t ahead = (size_t)rate * PUSH_AHEAD_MS / 1000;
+        if (queued > ahead) {
+            uint32_t waitMs = (uint32_t)((queued - ahead) * 1000 / rate);
+            vTaskDelay(pdMS_TO_TICKS(waitMs > 0 ? waitMs : 1));
+        }
+        return true;
+    }
+    
+#if APP_SOUND_CACHE
+    static bool cacheable(SoundType type) { return type != SOUND_STARTUP; }  // Startup plays once per boot
+    
+    // Plays the pre-rendered prompt if it matches the I2S rate
+    bool playCached() {
+        const uint32_t rate = m_targetSampleRate;
+        if (!cacheable(m_currentSound) || !m_cache.acquire(m_currentSound, rate)) return false;
+        const SoundCache::Entry& e = m_cache.entry(m_currentSound);
+        ESP_LOGD(TAG, "Cached: %u frames at %u Hz", (unsigned)e.frames, (unsigned)rate);
+        m_sampleRateChanged = false;
+        for (size_t pos = 0; pos < e.frames && !m_stopRequested; ) {
+            if (m_sampleRateChanged && m_targetSampleRate != rate) {
+                ESP_LOGI(TAG, "Sample rate changed under a cached prompt, stopping it");
+                break;
+            }
+            size_t n = e.frames - pos;
+            if (n > CACHE_BLOCK_FRAMES) n = CACHE_BLOCK_FRAMES;
+            const int16_t* src = e.pcm + pos * 2;
+            for (size_t i = 0; i < n * 2; i++) m_cacheOut[i] = (int32_t)src[i] << 16;
+            if (!emit(m_cacheOut, n, rate)) break;
+            pos += n;
+        }
+        m_cache.release();
+        return true;
+    }
+    
+    static void cacheTask(void* param) {
+        SoundPlayer* self = (SoundPlayer*)param;
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            self->refreshCache();
+        }
+    }
+    
+    // Renders every prompt not yet rendered for the current rate;
+    // connected first, it follows a codec config (and its new rate)
+    void refreshCache() {
+        static const SoundType order[] = { SOUND_CONNECTED, SOUND_MAX_VOLUME, SOUND_PAIRING };
+        for (SoundType t : order) {
+            const uint32_t rate = m_targetSampleRate;
+            if (!hasSound(t) || !m_cache.stale(t, rate)) continue;
+            xSemaphoreTake(m_mutex, portMAX_DELAY);  // Flash access is serialised with uploads
+            WavSource src;
+            if (openSource(t, src)) m_cache.render(t, src, rate, SOUND_PATHS[t]);
             xSemaphoreGive(m_mutex);
-            return;
         }
+    }
+#endif
+    
+    void kickCache() {
+#if APP_SOUND_CACHE
+        if (m_cacheTask) xTaskNotifyGive(m_cacheTask);
+#endif
+    }
+    
+    // Streams the sound from flash through the resampler; mapped
+    // 16-bit PCM is fed to it in place
+    void playFile() {
+        xSemaphoreTake(m_mutex, portMAX_DELAY);
         
-        // Validate WAV
-        if (memcmp(header.riff, "RIFF", 4) != 0 || 
-            memcmp(header.wave, "WAVE", 4) != 0 ||
-            header.audioFormat != 1) {
-            ESP_LOGE(TAG, "Invalid WAV file");
-            fclose(f);
-            m_playing = false;
+        WavSource src;
+        if (!openSource(m_currentSound, src)) {
+            ESP_LOGE(TAG, "Failed to open WAV: %s", SOUND_PATHS[m_currentSound]);
             xSemaphoreGive(m_mutex);
             return;
         }
+        const WavHeader& header = src.header;
+        const bool inPlace = src.view() && header.bitsPerSample == 16;
+        const bool stereo16 = header.numChannels == 2 && header.bitsPerSample == 16;
         
-        ESP_LOGI(TAG, "WAV: %uHz %ubit %uch -> I2S %uHz", 
+        ESP_LOGD(TAG, "WAV: %uHz %ubit %uch -> I2S %uHz", 
                  (unsigned)header.sampleRate, 
                  (unsigned)header.bitsPerSample,
                  (unsigned)header.numChannels,
                  (unsigned)m_targetSampleRate);
         
-        // Find data chunk
-        char chunkId[4];
-        uint32_t chunkSize;
-        while (fread(chunkId, 1, 4, f) == 4) {
-            fread(&chunkSize, 4, 1, f);
-            if (memcmp(chunkId, "data", 4) == 0) {
-                break;
-            }
-            fseek(f, chunkSize, SEEK_CUR);
-        }
-        
         xSemaphoreGive(m_mutex);
         
         // Initialize the streaming resampler
-        AudioResampler resampler;
-        bool isStereo = (header.numChannels == 2);
         uint32_t currentOutputRate = m_targetSampleRate;
         m_sampleRateChanged = false;  // Clear flag
-        resampler_init(&resampler, header.sampleRate, currentOutputRate, isStereo);
+        m_resampler.reset();
+        if (!m_resampler.init(header.sampleRate, currentOutputRate)) {
+            src.close();
+            return;
+        }
+        // Stereo S16 at the output rate (transcoded uploads) is only widened
+        bool direct = stereo16 && header.sampleRate == currentOutputRate;
+        
+        // Fade-in ramp at the output rate eliminates the pop at start
+        size_t fadeInFrames = (currentOutputRate * FADE_MS) / 1000;
+        size_t fadeInRemaining = fadeInFrames;
         
         // Calculate buffer sizes
         // Input: enough for ~20ms of audio at source rate
@@ -573,48 +737,56 @@ private:
         // Output: enough for resampled frames (upsampling ratio can be ~4.4x for 22050->96000)
         // Use max possible rate (96kHz) for buffer sizing to handle any rate change
         const size_t maxOutputFrames = (inputChunkFrames * 96000 / header.sampleRate) + 16;
-        
-        // Allocate buffers - prefer PSRAM to avoid exhausting internal RAM
-        // Internal RAM is needed for BLE/BT operations
-        uint8_t* inputRaw = (uint8_t*)heap_caps_malloc(inputChunkFrames * inputBytesPerFrame, 
-                                                        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        if (!inputRaw) {
-            inputRaw = (uint8_t*)heap_caps_malloc(inputChunkFrames * inputBytesPerFrame, MALLOC_CAP_8BIT);
-        }
-        int16_t* inputS16 = (int16_t*)heap_caps_malloc(inputChunkSamples * sizeof(int16_t), 
-                                                        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        if (!inputS16) {
-            inputS16 = (int16_t*)heap_caps_malloc(inputChunkSamples * sizeof(int16_t), MALLOC_CAP_8BIT);
+        const size_t outputBytes = maxOutputFrames * 2 * sizeof(int32_t);
+        const size_t inputRawBytes = inPlace ? 0 : (inputChunkFrames * inputBytesPerFrame + 7) & ~(size_t)7;
+        const size_t inputS16Bytes = inPlace ? 0 : inputChunkSamples * sizeof(int16_t);
+        
+        // Carved from the scratch taken at init (without it, or for a file
+        // above SCRATCH_MAX_RATE, from the heap)
+        uint8_t* inputRaw = nullptr;
+        int16_t* inputS16 = nullptr;
+        int32_t* outputS32 = nullptr;
+        const bool scratch = m_scratch && outputBytes + inputRawBytes + inputS16Bytes <= SCRATCH_BYTES;
+        if (scratch) {
+            outputS32 = (int32_t*)m_scratch;
+            if (!inPlace) {
+                inputRaw = m_scratch + outputBytes;
+                inputS16 = (int16_t*)(inputRaw + inputRawBytes);
+            }
+        } else if (!inPlace) {
+            // PSRAM first; internal only within the sound budget, BLE/BT
+            // needs the rest (no input buffers when the resampler reads
+            // mapped PCM in place)
+            inputRaw = (uint8_t*)MemPlacement::alloc("sound_in", MEM_OWNER_SOUND,
+                                                     inputChunkFrames * inputBytesPerFrame, MEM_PSRAM);
+            inputS16 = (int16_t*)MemPlacement::alloc("sound_s16", MEM_OWNER_SOUND,
+                                                     inputChunkSamples * sizeof(int16_t), MEM_PSRAM);
         }
-        // Output buffer doesn't need DMA capability - I2S driver copies from it
-        int32_t* outputS32 = (int32_t*)heap_caps_malloc(maxOutputFrames * 2 * sizeof(int32_t), 
-                                                         MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        if (!outputS32) {
-            outputS32 = (int32_t*)heap_caps_malloc(maxOutputFrames * 2 * sizeof(int32_t), MALLOC_CAP_8BIT);
+        if (!scratch) {
+            // Output buffer doesn't need DMA capability - I2S driver copies from it
+            outputS32 = (int32_t*)MemPlacement::alloc("sound_out", MEM_OWNER_SOUND, outputBytes, MEM_PSRAM);
         }
         
-        if (!inputRaw || !inputS16 || !outputS32) {
+        if ((!inPlace && (!inputRaw || !inputS16)) || !outputS32) {
             ESP_LOGE(TAG, "Failed to allocate playback buffers (in=%u, out=%u bytes)", 
                      (unsigned)(inputChunkFrames * inputBytesPerFrame),
                      (unsigned)(maxOutputFrames * 2 * sizeof(int32_t)));
-            if (inputRaw) heap_caps_free(inputRaw);
-            if (inputS16) heap_caps_free(inputS16);
-            if (outputS32) heap_caps_free(outputS32);
-            fclose(f);
-            m_playing = false;
+            MemPlacement::release(inputRaw);
+            MemPlacement::release(inputS16);
+            MemPlacement::release(outputS32);
+            src.close();
             return;
         }
         
-        ESP_LOGI(TAG, "Resampler: ratio=%.4f, input=%u frames, output max=%u frames",
-                 resampler.ratio, (unsigned)inputChunkFrames, (unsigned)maxOutputFrames);
+        ESP_LOGD(TAG, "Resampler: %u -> %u Hz, input=%u frames, output max=%u frames",
+                 (unsigned)header.sampleRate, (unsigned)currentOutputRate,
+                 (unsigned)inputChunkFrames, (unsigned)maxOutputFrames);
         
         // Streaming playback loop
-        size_t totalDataBytes = chunkSize;
+        size_t totalDataBytes = src.dataBytes;
         size_t bytesRead = 0;
         uint32_t playbackStartTime = xTaskGetTickCount() * portTICK_PERIOD_MS;
         uint32_t maxPlaybackTimeMs = 10000;  // Maximum 10 seconds for any sound
-        uint32_t consecutiveWriteFailures = 0;
-        const uint32_t maxConsecutiveFailures = 20;  // Abort after 20 consecutive I2S write failures
         
         while (bytesRead < totalDataBytes && !m_stopRequested) {
             // Check for timeout to prevent infinite loops
@@ -630,8 +802,9 @@ private:
                     ESP_LOGI(TAG, "Sample rate changed %u -> %u Hz, reinit resampler",
                              (unsigned)currentOutputRate, (unsigned)newRate);
                     currentOutputRate = newRate;
-                    // Reinitialize resampler with new output rate (preserving position)
-                    resampler_init(&resampler, header.sampleRate, currentOutputRate, isStereo);
+                    // Reinitialize resampler with new output rate (history is kept)
+                    m_resampler.init(header.sampleRate, currentOutputRate);
+                    direct = stereo16 && header.sampleRate == currentOutputRate;
                 }
                 m_sampleRateChanged = false;
             }
@@ -641,9 +814,18 @@ private:
             size_t remaining = totalDataBytes - bytesRead;
             if (toRead > remaining) toRead = remaining;
             
-            xSemaphoreTake(m_mutex, portMAX_DELAY);
-            size_t actualRead = fread(inputRaw, 1, toRead, f);
-            xSemaphoreGive(m_mutex);
+            const int16_t* input = inputS16;
+            size_t actualRead;
+            if (inPlace) {
+                // Mapped 16-bit PCM: the resampler reads the flash cache directly
+                input = (const int16_t*)src.view();
+                actualRead = toRead - toRead % inputBytesPerFrame;
+                src.skip(actualRead);
+            } else {
+                xSemaphoreTake(m_mutex, portMAX_DELAY);
+                actualRead = src.read(inputRaw, toRead);
+                xSemaphoreGive(m_mutex);
+            }
             
             if (actualRead == 0) break;
             
@@ -651,7 +833,9 @@ private:
             size_t inputFrames = actualRead / inputBytesPerFrame;
             
             // Convert to 16-bit signed if needed
-            if (header.bitsPerSample == 16) {
+            if (inPlace) {
+                // Resampler reads the mapping
+            } else if (header.bitsPerSample == 16) {
                 // Already 16-bit, just copy
                 memcpy(inputS16, inputRaw, inputFrames * header.numChannels * sizeof(int16_t));
             } else if (header.bitsPerSample == 8) {
@@ -662,86 +846,70 @@ private:
             }
             
             // Resample this chunk to 32-bit stereo for I2S
-            size_t outputFrames = resample_s16_to_s32_stereo(
-                &resampler,
-                inputS16,
-                inputFrames,
-                outputS32,
-                maxOutputFrames
-            );
+            // (16-bit left-aligned in the 32-bit slot)
+            size_t outputFrames;
+            if (direct) {
+                for (size_t i = 0; i < inputFrames * 2; i++) outputS32[i] = (int32_t)input[i] << 16;
+                outputFrames = inputFrames;
+            } else {
+                outputFrames = m_resampler.process(input, inputFrames, header.numChannels,
+                                                   1.0f, outputS32, maxOutputFrames, 65536.0f);
+            }
             
-            // Output samples
-            if (outputFrames > 0) {
-                if (m_playMode == SOUND_MODE_OVERLAY && m_overlayPushFunc) {
-                    // Push to overlay mixer for mixing with BT audio in DSP
-                    m_overlayPushFunc(outputS32, outputFrames);
-                    // Rate-limit to match real-time playback
-                    // Calculate how many ms of audio we just pushed and delay accordingly
-                    // This prevents buffer overflow and ensures audio plays at correct speed
-                    uint32_t audioMs = (outputFrames * 1000) / currentOutputRate;
-                    if (audioMs < 1) audioMs = 1;
-                    // Delay slightly less than the audio duration to stay ahead of consumption
-                    vTaskDelay(pdMS_TO_TICKS(audioMs > 2 ? audioMs - 1 : audioMs));
-                } else if (m_playMode == SOUND_MODE_EXCLUSIVE && m_i2sWriteFunc) {
-                    // Write directly to I2S (exclusive mode)
-                    size_t written = m_i2sWriteFunc((uint8_t*)outputS32, outputFrames * 2 * sizeof(int32_t));
-                    if (written == 0) {
-                        consecutiveWriteFailures++;
-                        if (consecutiveWriteFailures >= maxConsecutiveFailures) {
-                            ESP_LOGW(TAG, "Too many I2S write failures (%u), aborting playback", consecutiveWriteFailures);
-                            break;
-                        }
-                        // I2S might be reconfiguring, wait a bit
-                        vTaskDelay(pdMS_TO_TICKS(10));
-                    } else {
-                        consecutiveWriteFailures = 0;  // Reset on successful write
-                    }
-                }
+            // Apply fade-in envelope to eliminate pop at start
+            for (size_t i = 0; i < outputFrames && fadeInRemaining > 0; i++) {
+                float fadeGain = 1.0f - ((float)fadeInRemaining * fast_recipsf2((float)fadeInFrames));
+                outputS32[i * 2] = (int32_t)((float)outputS32[i * 2] * fadeGain);
+                outputS32[i * 2 + 1] = (int32_t)((float)outputS32[i * 2 + 1] * fadeGain);
+                fadeInRemaining--;
             }
             
+            // Output samples
+            if (!emit(outputS32, outputFrames, currentOutputRate)) break;
+            
             // Small yield to prevent watchdog
             vTaskDelay(1);
         }
         
         // Cleanup
-        heap_caps_free(inputRaw);
-        heap_caps_free(inputS16);
-        heap_caps_free(outputS32);
-        fclose(f);
-        
-        ESP_LOGI(TAG, "Playback complete");
-        
-        // Check for pending sound BEFORE clearing state
-        SoundType pending = (SoundType)m_pendingSound;
-        SoundPlayMode pendingMode = m_pendingMode;
-        m_pendingSound = -1;
-        
-        // Clear state - important: do this BEFORE calling play() to avoid
-        // the "previous task still running" check blocking us
-        m_playing = false;
-        m_playbackTaskHandle = nullptr;
-        
-        // Now play the pending sound (this creates a new task)
-        if (pending >= 0 && pending < SOUND_TYPE_COUNT) {
-            ESP_LOGI(TAG, "Playing queued sound: %d", pending);
-            play(pending, pendingMode);
+        if (!scratch) {
+            MemPlacement::release(inputRaw);
+            MemPlacement::release(inputS16);
+            MemPlacement::release(outputS32);
         }
+        src.close();
     }
     
-    // Task stack size - allocated once during init for reuse
+    // Task stack size - allocated once, the task lives from init on
     static constexpr size_t TASK_STACK_SIZE = 4096;
+    // Playback scratch: output, raw and S16 input of a
+    // 20 ms chunk of 16-bit stereo at up to SCRATCH_MAX_RATE
+    static constexpr uint32_t SCRATCH_MAX_RATE = 96000;
+    static constexpr size_t SCRATCH_FRAMES = SCRATCH_MAX_RATE * 20 / 1000;
+    static constexpr size_t SCRATCH_BYTES = (SCRATCH_FRAMES + 16) * 2 * sizeof(int32_t) +
+                                            2 * SCRATCH_FRAMES * 2 * sizeof(int16_t);
+    // Audio kept queued in the mixer ahead of playback
+    static constexpr uint32_t PUSH_AHEAD_MS = 40;
+    // Upload transcoding: input frames per step (on the upload task's
+    // stack), and the largest result kept instead of the original
+    static constexpr size_t TRANSCODE_CHUNK = 128;
+    static constexpr size_t TRANSCODE_MAX_BYTES = 1024 * 1024;
     
     bool m_initialized = false;
     bool m_muted = false;
     uint8_t m_soundStatus = 0;
     uint32_t m_targetSampleRate = 44100;
+    uint32_t m_canonicalRate = 44100;   // Uploads are stored at this rate
+    PolyphaseResampler m_resampler;  // Playback task only
     
     SemaphoreHandle_t m_mutex = nullptr;
     TaskHandle_t m_playbackTaskHandle = nullptr;
+    portMUX_TYPE m_lock = portMUX_INITIALIZER_UNLOCKED;  // m_playing with the queued sound
     
     // Pre-allocated task stack and TCB for static task creation
     StackType_t* m_taskStack = nullptr;
     StaticTask_t m_taskTCB;
+    uint8_t* m_scratch = nullptr;   // Playback scratch, PSRAM
     
     volatile bool m_playing = false;
     volatile bool m_stopRequested = false;
@@ -752,18 +920,22 @@ private:
     int m_pendingSound = -1;
     SoundPlayMode m_pendingMode = SOUND_MODE_EXCLUSIVE;
     
-public:
-    // I2S write function pointer (set by main for exclusive mode)
-    using I2SWriteFunc = size_t(*)(const uint8_t*, size_t);
-    I2SWriteFunc m_i2sWriteFunc = nullptr;
+#if APP_SOUND_ASSETS
+    SoundAssets m_assets;
+#endif
     
-    void setI2SWriteFunc(I2SWriteFunc func) {
-        m_i2sWriteFunc = func;
-    }
+#if APP_SOUND_CACHE
+    static constexpr size_t CACHE_BLOCK_FRAMES = 256;
+    SoundCache m_cache;
+    TaskHandle_t m_cacheTask = nullptr;
+    int32_t m_cacheOut[CACHE_BLOCK_FRAMES * 2];  // Widened block for the mixer
+#endif
     
-    // Overlay push function pointer (set by main for overlay mode)
-    // Pushes resampled stereo samples to OverlayMixer for mixing with BT audio
-    using OverlayPushFunc = void(*)(const int32_t* stereoSamples, size_t frames);
+public:
+    // Overlay push function pointer (set by main, used in both modes)
+    // Pushes resampled stereo samples to OverlayMixer for mixing with BT
+    // audio (fully ducked when exclusive); returns the frames queued there
+    using OverlayPushFunc = size_t(*)(const int32_t* stereoSamples, size_t frames, bool exclusive);
     OverlayPushFunc m_overlayPushFunc = nullptr;
     
     void setOverlayPushFunc(OverlayPushFunc func) {
@@ -0,0 +1,243 @@
+#pragma once
+
+/*
+ * spsc_ring.h
+ *
+ * Lock-free single-producer / single-consumer ring of variable-length PCM
+ * records, used between the BT sink callback (producer) and audio_tx
+ * (consumer). Replaces the FreeRTOS free/audio queue pair: no kernel
+ * critical section on either side, and a record takes only its own length
+ * instead of a whole fixed-size slot.
+ *
+ * A record is either copied in (write()) or filled in place: reserve()
+ * hands the producer the payload area, commit() publishes it.
+ *
+ * Layout: [RecordHeader][payload, padded to 8] ... Records never straddle
+ * the end of the storage; when one does not fit the producer writes a wrap
+ * marker (or leaves less than a header) and continues at offset 0, so the
+ * consumer always gets one contiguous payload pointer.
+ *
+ * The consumer blocks on a task notification; the producer only notifies
+ * when the consumer has announced it is waiting.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+
+class SpscRing {
+public:
+    struct RecordHeader {
+        uint32_t len;       // Payload bytes, WRAP_MARK = continue at offset 0
+        uint8_t format;     // SampleFmt of the payload
+        uint8_t channels;
+        uint8_t reserved[2];
+        uint32_t stampUs;   // Arrival time of the first frame (0 = none), latency probe
+        uint32_t rtpTs;     // RTP timestamp of that packet
+    };
+
+    ~SpscRing() {
+        if (m_storage && m_owned) heap_caps_free(m_storage);
+    }
+
+    // Allocate storage (rounded down to the record alignment)
+    bool init(size_t bytes, uint32_t caps) {
+        bytes &= ~(size_t)(ALIGN - 1);
+        if (bytes < 2 * sizeof(RecordHeader)) return false;
+        return attach((uint8_t*)heap_caps_malloc(bytes, caps), bytes, true);
+    }
+
+    // Run on storage the caller keeps (8-byte aligned, never freed here)
+    bool init(uint8_t* storage, size_t bytes) {
+        bytes &= ~(size_t)(ALIGN - 1);
+        if (bytes < 2 * sizeof(RecordHeader)) return false;
+        return attach(storage, bytes, false);
+    }
+
+    // Give the storage back; only once the producer can no longer reach the ring
+    void deinit() {
+        if (m_storage && m_owned) heap_caps_free(m_storage);
+        m_storage = nullptr;
+        m_size = 0;
+    }
+
+    bool isValid() const { return m_storage != nullptr; }
+    uint32_t capacity() const { return m_size; }
+
+    // Producer: largest payload a single record can carry
+    uint32_t maxPayload() const { return m_size / 2 - (uint32_t)sizeof(RecordHeader); }
+
+    // Producer: copy one record in. Returns false (nothing written) if full.
+    bool write(const uint8_t* data, uint32_t len, uint8_t format, uint8_t channels,
+               uint32_t stampUs = 0, uint32_t rtpTs = 0) {
+        uint8_t* payload = reserve(len);
+        if (!payload) return false;
+        memcpy(payload, data, len);
+        commit(len, format, channels, stampUs, rtpTs);
+        return true;
+    }
+
+    // Producer: room for a record of up to len payload bytes, to be filled
+    // in place and published with commit(). nullptr if full. The consumer
+    // sees nothing until then; a reservation never committed just lapses
+    // (the next one starts from the same place).
+    uint8_t* reserve(uint32_t len) {
+        if (len == 0 || len > maxPayload()) return nullptr;
+        const uint32_t need = recordSize(len);
+        uint32_t w = m_write.load(std::memory_order_relaxed);
+        const uint32_t r = m_read.load(std::memory_order_acquire);
+
+        if (w >= r) {
+            // Free space is [w, size) and [0, r); never let w catch up to r
+            if (w + need > m_size || (w + need == m_size && r == 0)) {
+                if (need >= r) return nullptr;
+                if (m_size - w >= sizeof(RecordHeader)) {
+                    RecordHeader* mark = (RecordHeader*)(m_storage + w);
+                    mark->len = WRAP_MARK;
+                }
+                w = 0;
+            }
+        } else if (w + need >= r) {
+            return nullptr;
+        }
+        m_reserved = w;
+        return m_storage + w + sizeof(RecordHeader);
+    }
+
+    // Producer: publish the last reservation with len (at most the length
+    // reserved) payload bytes
+    void commit(uint32_t len, uint8_t format, uint8_t channels, uint32_t stampUs = 0, uint32_t rtpTs = 0) {
+        uint32_t w = m_reserved;
+        RecordHeader* hdr = (RecordHeader*)(m_storage + w);
+        hdr->len = len;
+        hdr->format = format;
+        hdr->channels = channels;
+        hdr->stampUs = stampUs;
+        hdr->rtpTs = rtpTs;
+
+        const uint32_t need = recordSize(len);
+        w += need;
+        if (w == m_size) w = 0;
+        m_write.store(w, std::memory_order_release);
+        m_written.fetch_add(need, std::memory_order_relaxed);
+
+        wakeConsumer();
+    }
+
+    // Wake the consumer only if it is (about to be) blocked in a wait
+    void wakeConsumer() {
+        if (m_waiting.exchange(false)) {
+            TaskHandle_t t = m_consumer;
+            if (t) xTaskNotifyGive(t);
+        }
+    }
+
+    // Consumer: get the next record without consuming it. Returns nullptr
+    // if empty. The pointer is valid until release().
+    const uint8_t* peek(uint32_t& len, uint8_t& format, uint8_t& channels,
+                        uint32_t* stampUs = nullptr, uint32_t* rtpTs = nullptr) {
+        uint32_t r = m_read.load(std::memory_order_relaxed);
+        const uint32_t w = m_write.load(std::memory_order_acquire);
+        if (r == w) return nullptr;
+
+        if (m_size - r < sizeof(RecordHeader) ||
+            ((RecordHeader*)(m_storage + r))->len == WRAP_MARK) {
+            r = 0;
+            m_read.store(0, std::memory_order_release);
+            if (r == w) return nullptr;
+        }
+
+        const RecordHeader* hdr = (const RecordHeader*)(m_storage + r);
+        len = hdr->len;
+        format = hdr->format;
+        channels = hdr->channels;
+        if (stampUs) *stampUs = hdr->stampUs;
+        if (rtpTs) *rtpTs = hdr->rtpTs;
+        return m_storage + r + sizeof(RecordHeader);
+    }
+
+    // Consumer: drop the record returned by peek()
+    void release() {
+        uint32_t r = m_read.load(std::memory_order_relaxed);
+        const RecordHeader* hdr = (const RecordHeader*)(m_storage + r);
+        uint32_t need = recordSize(hdr->len);
+        r += need;
+        if (r == m_size) r = 0;
+        m_read.store(r, std::memory_order_release);
+        m_consumed.fetch_add(need, std::memory_order_relaxed);
+    }
+
+    // Consumer: skip everything written up to now
+    void drain() {
+        m_read.store(m_write.load(std::memory_order_acquire), std::memory_order_release);
+        m_consumed.store(m_written.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    // Consumer: block until the producer writes or the timeout expires.
+    // Returns immediately if data is already pending.
+    void waitForData(TickType_t timeout) {
+        m_consumer = xTaskGetCurrentTaskHandle();
+        if (!empty()) return;
+        ulTaskNotifyTake(pdTRUE, 0);
+        // Announce first, then re-check, so a write in between is not missed
+        m_waiting.store(true);
+        if (empty()) {
+            ulTaskNotifyTake(pdTRUE, timeout);
+        }
+        m_waiting.store(false);
+    }
+
+    // Consumer: block until the next write, even if data is pending
+    void waitForWrite(TickType_t timeout) {
+        m_consumer = xTaskGetCurrentTaskHandle();
+        // Clear a stale notification before announcing, then wait
+        ulTaskNotifyTake(pdTRUE, 0);
+        m_waiting.store(true);
+        ulTaskNotifyTake(pdTRUE, timeout);
+        m_waiting.store(false);
+    }
+
+    bool empty() const {
+        return m_read.load(std::memory_order_acquire) == m_write.load(std::memory_order_acquire);
+    }
+
+    // Bytes in use (records incl. headers; approximate from either side)
+    uint32_t usedBytes() const {
+        uint32_t used = m_written.load(std::memory_order_relaxed) - m_consumed.load(std::memory_order_relaxed);
+        return used > m_size ? m_size : used;
+    }
+
+private:
+    static constexpr uint32_t ALIGN = 8;
+    static constexpr uint32_t WRAP_MARK = 0xFFFFFFFFu;
+    static_assert(sizeof(RecordHeader) % ALIGN == 0, "record header must be whole alignment units");
+
+    static uint32_t recordSize(uint32_t len) {
+        return ((uint32_t)sizeof(RecordHeader) + len + ALIGN - 1) & ~(ALIGN - 1);
+    }
+
+    bool attach(uint8_t* storage, size_t bytes, bool owned) {
+        if (!storage) return false;
+        m_storage = storage;
+        m_owned = owned;
+        m_size = (uint32_t)bytes;
+        m_write.store(0);
+        m_read.store(0);
+        return true;
+    }
+
+    uint8_t* m_storage = nullptr;
+    uint32_t m_size = 0;
+    bool m_owned = true;
+    std::atomic<uint32_t> m_write{0};       // Owned by producer
+    uint32_t m_reserved = 0;                // Producer: offset of the pending reservation
+    std::atomic<uint32_t> m_read{0};        // Owned by consumer
+    std::atomic<uint32_t> m_written{0};     // Running totals for fill level
+    std::atomic<uint32_t> m_consumed{0};
+    std::atomic<bool> m_waiting{false};
+    volatile TaskHandle_t m_consumer = nullptr;
+};
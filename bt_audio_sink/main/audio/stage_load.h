@@ -0,0 +1,106 @@
+#pragma once
+
+/*
+ * stage_load.h
+ *
+ * CPU load bookkeeping for the audio path. StageLoad accumulates the busy
+ * time one pipeline stage spends inside its owning task; TaskLoadSampler
+ * reads FreeRTOS run-time counters so whole tasks that live outside this
+ * code (the Bluedroid decoder, the idle tasks) can be reported alongside.
+ * Both are read as "percent of one core over the last window".
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+
+struct StageLoad {
+    // Owner task: add time spent in the stage
+    void add(uint32_t us) {
+        m_busyUs.fetch_add(us, std::memory_order_relaxed);
+        if (us > m_peakUs.load(std::memory_order_relaxed)) {
+            m_peakUs.store(us, std::memory_order_relaxed);
+        }
+    }
+
+    // Reporter: busy microseconds and longest single run since the last take
+    void take(uint32_t& busyUs, uint32_t& peakUs) {
+        busyUs = m_busyUs.exchange(0, std::memory_order_relaxed);
+        peakUs = m_peakUs.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint32_t> m_busyUs{0};
+    std::atomic<uint32_t> m_peakUs{0};
+};
+
+// Load of named tasks from the FreeRTOS run-time counters. Needs
+// CONFIG_FREERTOS_USE_TRACE_FACILITY and CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS;
+// without them available() is false and sample() reports nothing.
+class TaskLoadSampler {
+public:
+    static constexpr int MAX_TASKS = 8;
+
+    // Names are matched against pcTaskName; the strings must outlive the sampler
+    explicit TaskLoadSampler(const char* const* names, int count)
+        : m_count(count < MAX_TASKS ? count : MAX_TASKS) {
+        for (int i = 0; i < m_count; i++) m_names[i] = names[i];
+    }
+
+    static constexpr bool available() {
+#if defined(CONFIG_FREERTOS_USE_TRACE_FACILITY) && defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    int count() const { return m_count; }
+    const char* name(int i) const { return m_names[i]; }
+
+    // Percent of one core each task used since the previous call (-1 = task
+    // not found). The first call only primes the counters.
+    bool sample(float* percent) {
+#if defined(CONFIG_FREERTOS_USE_TRACE_FACILITY) && defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+        UBaseType_t n = uxTaskGetNumberOfTasks() + 4;
+        TaskStatus_t* st = (TaskStatus_t*)heap_caps_malloc(n * sizeof(TaskStatus_t), MALLOC_CAP_8BIT);
+        if (!st) return false;
+        configRUN_TIME_COUNTER_TYPE total = 0;
+        n = uxTaskGetSystemState(st, n, &total);
+
+        // Counters and total share the run-time clock, so the ratio is
+        // independent of its unit; total advances once per tick of one core
+        const uint32_t span = (uint32_t)total - m_lastTotal;
+        const bool primed = m_primed && span > 0;
+        for (int i = 0; i < m_count; i++) {
+            percent[i] = -1.0f;
+            for (UBaseType_t t = 0; t < n; t++) {
+                if (strcmp(st[t].pcTaskName, m_names[i]) != 0) continue;
+                uint32_t counter = (uint32_t)st[t].ulRunTimeCounter;
+                if (primed) {
+                    percent[i] = (float)(uint32_t)(counter - m_lastCounter[i]) * 100.0f / (float)span;
+                }
+                m_lastCounter[i] = counter;
+                break;
+            }
+        }
+        heap_caps_free(st);
+        m_lastTotal = (uint32_t)total;
+        m_primed = true;
+        return primed;
+#else
+        (void)percent;
+        return false;
+#endif
+    }
+
+private:
+    const char* m_names[MAX_TASKS] = {};
+    uint32_t m_lastCounter[MAX_TASKS] = {};
+    int m_count;
+    uint32_t m_lastTotal = 0;
+    bool m_primed = false;
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Stream Bridge - a stream's buffered end, played across a suspend,
+// codec switch or reconnect (APP_CODEC_BRIDGE)
+// - When a stream ends or changes format, AudioPipeline moves the
+//   PCM still in its ring here instead of dropping it: Q31 stereo at
+//   the old stream's rate, up to APP_CODEC_BRIDGE_MS at 48 kHz
+// - The audio task plays it while the next stream pre-rolls,
+//   resampled to the rate the DSP and I2S run at by then (one
+//   PolyphaseResampler; its table is rebuilt only for a new cutoff)
+//   and through the DSP like any block
+// - Whichever ends first decides the join: the next stream's first
+//   block crossfades from the bridge (mixBuffer()), or the bridge
+//   runs out and output ramps to zero as on an underrun
+// - Audio task only, apart from ready() and live()
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "../config/app_config.h"
+#include "../core/static_alloc.h"
+#include "../dsp/polyphase_resampler.h"
+
+class StreamBridge {
+public:
+    static constexpr uint32_t CAPACITY_FRAMES = (uint32_t)APP_CODEC_BRIDGE_MS * 48;
+
+    // Buffers in PSRAM and the resampler table; false leaves the bridge
+    // off (streams end and switch on a flush, as without it)
+    bool init() {
+        const size_t bytes = ((size_t)CAPACITY_FRAMES + APP_DSP_OUT_FRAMES) * 2 * sizeof(int32_t);
+        m_buf = StaticAlloc::psramArena()
+            ? (int32_t*)StaticAlloc::take("bridge", bytes, StaticAlloc::PSRAM) : nullptr;
+        if (!m_buf) m_buf = (int32_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!m_buf || !m_resampler.init(44100, 48000)) {
+            ESP_LOGW(TAG, "No PSRAM for the stream bridge (%u KB): stream ends cut", (unsigned)(bytes / 1024));
+            m_buf = nullptr;
+            return false;
+        }
+        m_mix = m_buf + (size_t)CAPACITY_FRAMES * 2;
+        m_ready.store(true, std::memory_order_release);
+        ESP_LOGI(TAG, "Stream bridge: %u ms at 48 kHz", (unsigned)APP_CODEC_BRIDGE_MS);
+        return true;
+    }
+
+    bool ready() const { return m_ready.load(std::memory_order_acquire); }
+    // Holding audio not played yet (any task)
+    bool live() const { return m_live.load(std::memory_order_relaxed); }
+
+    // Start holding a stream at rate, dropping whatever was left
+    void begin(uint32_t rate) {
+        m_rate = rate;
+        m_frames = 0;
+        m_read = 0;
+        m_outRate = 0;
+        m_resampler.reset();
+        m_live.store(false, std::memory_order_relaxed);
+    }
+
+    // Space for the next frames (Q31 stereo), room of them at most;
+    // commit() what was written
+    int32_t* space(uint32_t& room) {
+        room = CAPACITY_FRAMES - m_frames;
+        return m_buf + (size_t)m_frames * 2;
+    }
+
+    void commit(uint32_t frames) {
+        m_frames += frames;
+        m_live.store(m_read < m_frames, std::memory_order_relaxed);
+    }
+
+    void clear() {
+        m_frames = 0;
+        m_read = 0;
+        m_live.store(false, std::memory_order_relaxed);
+    }
+
+    // Held time left at the stream's own rate
+    uint32_t remainingMs() const {
+        return m_rate ? (uint32_t)((uint64_t)(m_frames - m_read) * 1000 / m_rate) : 0;
+    }
+
+    // Up to maxOut frames at outRate into out (interleaved stereo float,
+    // full scale 1.0); 0 once it is empty
+    uint32_t render(float* out, uint32_t maxOut, uint32_t outRate) {
+        if (m_read >= m_frames || outRate == 0 || maxOut < 2) return 0;
+        const int32_t* in = m_buf + (size_t)m_read * 2;
+        const uint32_t avail = m_frames - m_read;
+        uint32_t n;
+        if (outRate == m_rate && m_outRate == 0) {
+            n = avail < maxOut ? avail : maxOut;
+            for (uint32_t i = 0; i < n * 2; i++) out[i] = (float)in[i] * Q31_TO_FLOAT;
+            m_read += n;
+        } else {
+            // Once resampling, it stays on: the filter's history carries on
+            if (outRate != m_outRate) {
+                m_resampler.init(m_rate, outRate);
+                m_outRate = outRate;
+            }
+            // Input whose output fits maxOut (maxOutput() adds a frame)
+            uint32_t take = (uint32_t)((uint64_t)(maxOut - 1) * m_rate / outRate);
+            if (take == 0) take = 1;
+            if (take > avail) take = avail;
+            n = (uint32_t)m_resampler.process(in, take, 2, Q31_TO_FLOAT, out, maxOut, 1.0f);
+            m_read += take;
+        }
+        if (m_read >= m_frames) clear();
+        return n;
+    }
+
+    // Q31 stereo block for the crossfade, APP_DSP_OUT_FRAMES long
+    int32_t* mixBuffer() { return m_mix; }
+
+private:
+    static constexpr const char* TAG = "Bridge";
+    static constexpr float Q31_TO_FLOAT = 1.0f / 2147483648.0f;
+
+    int32_t* m_buf = nullptr;       // CAPACITY_FRAMES held, then the mix block
+    int32_t* m_mix = nullptr;
+    std::atomic<bool> m_ready{false};
+    std::atomic<bool> m_live{false};
+    uint32_t m_rate = 0;            // Of the held stream
+    uint32_t m_frames = 0;          // Held
+    uint32_t m_read = 0;            // Played
+    uint32_t m_outRate = 0;         // Resampler's output rate, 0 = not resampling
+    PolyphaseResampler m_resampler;
+};
@@ -0,0 +1,624 @@
+#pragma once
+
+/*
+ * sync_link.h
+ *
+ * Multi-room playback: one A2DP sink (the master) rebroadcasts its stream
+ * over WiFi and followers play it in step with the master's DAC.
+ *
+ * Wire format (UDP on APP_SYNC_PORT, host byte order, MAGIC first):
+ *   TIMING  master -> group, 4 Hz: input frame I is heard at master time
+ *           T (esp_timer us), stream rate R. Followers find the master by it.
+ *   CLOCK   follower -> master request carrying t1; the master answers with
+ *           its receive (t2) and send (t3) times. Requests double as the
+ *           follower's registration and keep-alive.
+ *   AUDIO   master -> each follower (unicast), S16 stereo from frame I.
+ *           Multicast goes out at the basic rate, too slow for PCM.
+ *
+ * Clock: offset = master - local from the four NTP timestamps. WiFi queuing
+ * only ever adds delay, so the exchange with the shortest round trip of
+ * the last CLOCK_WINDOW is used, low-passed.
+ *
+ * Follower: master frame I is enqueued as local frame I - delta (delta set
+ * by the first packet of a stream; lost packets are filled with silence so
+ * indexes stay in step) and is due at the DAC at
+ *   T + (I - I_timing) / R - offset
+ * AudioPipeline's start gate and jitter steering chase that time. DSP and
+ * volume stay per room. A follower's own A2DP stream takes precedence.
+ *
+ * The master sends PCM as-is (there is no encoder in this tree): about
+ * 1.4 Mbit/s per follower at 44.1 kHz.
+ *
+ * True-wireless stereo (APP_SYNC_TWS): the master keeps one channel and
+ * sends only the other, as mono (half the airtime, twice the frames per
+ * datagram); the follower plays what it gets on both of its outputs. Skew
+ * between the two ears is the follower's timing error: a frame-exact
+ * start, then slips beyond SYNC_DEAD_BAND_MS and the APLL trim below it,
+ * so well under one DSP block.
+ *
+ * Relay (APP_SYNC_RELAY): the master sends its finished output instead -
+ * DSP, volume and sounds applied, at the I2S rate - taken from each output
+ * slot as it is queued, and counts frame indexes in output frames. The
+ * follower plays it with its own DSP off, e.g. as a second speaker or a
+ * subwoofer fed the master's exact signal.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "../config/app_config.h"
+#include "../core/static_alloc.h"
+#include "../core/wifi_station.h"
+#include "audio_pipeline.h"
+
+#if APP_SYNC_ENABLE
+
+class SyncLink {
+public:
+    // Follower: the master's stream changed (rate, or 1 channel for TWS),
+    // set the output up for it
+    typedef void (*FormatCallback)(uint32_t sampleRate, uint8_t channels);
+
+    static SyncLink& getInstance() {
+        static SyncLink instance;
+        return instance;
+    }
+
+    // WiFi station, socket and tasks. Call after the pipeline is initialized.
+    bool begin(AudioPipeline& pipeline, FormatCallback onFormat) {
+        m_pipeline = &pipeline;
+        m_onFormat = onFormat;
+        m_lock = xSemaphoreCreateMutex();
+        if (!m_lock || !startWifi() || !openSocket()) return false;
+
+        if (APP_SYNC_MASTER) {
+            if (!m_txRing.init(TX_RING_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) &&
+                !m_txRing.init(TX_RING_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)) {
+                ESP_LOGE(TAG, "Failed to allocate the send ring");
+                return false;
+            }
+            if (APP_SYNC_RELAY) {
+                pipeline.setSyncTaps(nullptr, &onBlockTap, this);
+                pipeline.setOutputTap(&onOutputTap, this);
+            } else {
+                pipeline.setSyncTaps(&onInputTap, &onBlockTap, this);
+            }
+            if (APP_SYNC_TWS) {
+                pipeline.setChannelPick(APP_SYNC_TWS_LEFT ? AudioPipeline::PICK_LEFT : AudioPipeline::PICK_RIGHT);
+            }
+            StaticAlloc::createTask(txTask, "sync_tx", 4096, this, 6, nullptr, APP_CONTROL_CORE);
+        } else {
+            pipeline.setSyncTarget(&onSyncTarget, this);
+        }
+        StaticAlloc::createTask(rxTask, "sync_rx", 4096, this, 7, nullptr, APP_CONTROL_CORE);
+        ESP_LOGI(TAG, "Multi-room %s%s on %s:%d", APP_SYNC_MASTER ? "master" : "follower",
+                 APP_SYNC_TWS ? " (TWS)" : APP_SYNC_RELAY ? " (relay)" : "", APP_SYNC_GROUP, APP_SYNC_PORT);
+        return true;
+    }
+
+    // Master: stream rate of what is enqueued (TIMING carries it). A relay
+    // takes the I2S rate from its output blocks instead.
+    void setSampleRate(uint32_t sampleRate) {
+        if (!APP_SYNC_RELAY) m_sampleRate = sampleRate;
+    }
+
+    // Follower: a local A2DP stream plays, so the master's is ignored and
+    // the pipeline runs on its own depth until it ends
+    void setLocalStream(bool active) {
+        if (APP_SYNC_MASTER || m_localStream == active) return;
+        m_localStream = active;
+        m_pipeline->setSyncTarget(active ? nullptr : &onSyncTarget, this);
+        if (active) m_pipeline->setDspEnabled(true);
+        m_sampleRate = 0;   // The next master packet sets the output up again
+    }
+
+    // Follower: clock offset and timing known
+    bool isLocked() const {
+        State st;
+        return loadState(st) && st.clockValid && st.timingValid;
+    }
+
+private:
+    static constexpr const char* TAG = "Sync";
+    static constexpr uint32_t MAGIC = 0x314D5253;          // "SRM1"
+    static constexpr size_t TX_RING_BYTES = 32 * 1024;
+    static constexpr uint32_t MAX_AUDIO_SAMPLES = 720;     // 1440 bytes of S16
+    static constexpr uint32_t MAX_AUDIO_FRAMES = APP_SYNC_TWS ? MAX_AUDIO_SAMPLES : MAX_AUDIO_SAMPLES / 2;
+    static constexpr int64_t TIMING_PERIOD_US = 250000;
+    static constexpr int64_t CLOCK_PERIOD_US = 250000;
+    static constexpr int64_t FOLLOWER_TIMEOUT_US = 3000000;
+    static constexpr int64_t STATUS_PERIOD_US = 10000000;
+    static constexpr int CLOCK_WINDOW = 8;
+
+    enum : uint8_t { MSG_TIMING = 1, MSG_CLOCK_REQ, MSG_CLOCK_RESP, MSG_AUDIO };
+    static constexpr uint8_t AUDIO_PROCESSED = 0x01;   // Master's output, play without DSP
+
+    struct __attribute__((packed)) MsgHeader {
+        uint32_t magic;
+        uint8_t type;
+        uint8_t reserved[3];
+    };
+    struct __attribute__((packed)) TimingMsg {
+        MsgHeader hdr;
+        uint32_t frameIndex;
+        uint32_t sampleRate;
+        int64_t exitUs;
+    };
+    struct __attribute__((packed)) ClockMsg {
+        MsgHeader hdr;
+        int64_t t1, t2, t3;
+    };
+    struct __attribute__((packed)) AudioMsg {
+        MsgHeader hdr;
+        uint32_t frameIndex;
+        uint32_t sampleRate;
+        uint16_t frames;
+        uint8_t channels;       // 2, or 1 for a TWS ear
+        uint8_t flags;          // AUDIO_PROCESSED
+        int16_t pcm[MAX_AUDIO_SAMPLES];
+    };
+
+    // Shared between the audio task and rx task, one writer per role
+    struct State {
+        uint32_t frameIndex = 0;    // TIMING: master frame heard at exitUs
+        uint32_t sampleRate = 0;
+        int64_t exitUs = 0;         // Master clock
+        int64_t offsetUs = 0;       // Master - local
+        uint32_t delta = 0;         // Master frame index - local frame index
+        bool timingValid = false;
+        bool clockValid = false;
+        bool deltaValid = false;
+    };
+
+    struct ClockSample {
+        int64_t offsetUs;
+        int64_t rttUs;
+    };
+
+    struct Follower {
+        sockaddr_in addr;
+        int64_t lastSeenUs;
+    };
+
+    SyncLink() = default;
+
+    // ---- Seqlock around m_state ----
+
+    void storeState(const State& st) {
+        m_stateSeq.fetch_add(1, std::memory_order_acq_rel);
+        m_state = st;
+        m_stateSeq.fetch_add(1, std::memory_order_release);
+    }
+
+    bool loadState(State& st) const {
+        for (;;) {
+            const uint32_t seq = m_stateSeq.load(std::memory_order_acquire);
+            if (seq & 1) continue;
+            st = m_state;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_stateSeq.load(std::memory_order_relaxed) == seq) return seq != 0;
+        }
+    }
+
+    // ---- Network ----
+
+    bool startWifi() {
+        return WifiStation::start(APP_SYNC_WIFI_SSID, APP_SYNC_WIFI_PASSWORD, &onWifiEvent, this);
+    }
+
+    static void onWifiEvent(void* arg, esp_event_base_t base, int32_t id, void* data) {
+        SyncLink* self = (SyncLink*)arg;
+        (void)data;
+        if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
+            self->m_hasIp = false;
+        } else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
+            self->m_hasIp = true;
+            self->m_joinGroup = true;   // Membership is per connection
+            ESP_LOGI(TAG, "WiFi up");
+        }
+    }
+
+    bool openSocket() {
+        m_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (m_sock < 0) {
+            ESP_LOGE(TAG, "socket() failed");
+            return false;
+        }
+        sockaddr_in local = {};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(APP_SYNC_PORT);
+        local.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(m_sock, (sockaddr*)&local, sizeof(local)) < 0) {
+            ESP_LOGE(TAG, "bind() failed");
+            close(m_sock);
+            m_sock = -1;
+            return false;
+        }
+        timeval tv = { 0, 50000 };      // rx loop also runs the periodic sends
+        setsockopt(m_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        uint8_t ttl = 1;
+        setsockopt(m_sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+
+        m_group.sin_family = AF_INET;
+        m_group.sin_port = htons(APP_SYNC_PORT);
+        m_group.sin_addr.s_addr = inet_addr(APP_SYNC_GROUP);
+        return true;
+    }
+
+    void joinGroup() {
+        ip_mreq mreq = {};
+        mreq.imr_multiaddr.s_addr = m_group.sin_addr.s_addr;
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (setsockopt(m_sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            ESP_LOGW(TAG, "Multicast join failed");
+        }
+    }
+
+    static void header(MsgHeader& h, uint8_t type) {
+        h.magic = MAGIC;
+        h.type = type;
+        memset(h.reserved, 0, sizeof(h.reserved));
+    }
+
+    void sendTo(const void* msg, size_t len, const sockaddr_in& to) {
+        sendto(m_sock, msg, len, 0, (const sockaddr*)&to, sizeof(to));
+    }
+
+    // ---- Receive task (both roles) ----
+
+    static void rxTask(void* arg) {
+        ((SyncLink*)arg)->rxLoop();
+    }
+
+    void rxLoop() {
+        static AudioMsg buf;    // Largest message; this task only
+        int64_t nextPeriodicUs = 0;
+        int64_t nextStatusUs = esp_timer_get_time() + STATUS_PERIOD_US;
+        for (;;) {
+            if (!m_hasIp) {
+                vTaskDelay(pdMS_TO_TICKS(200));
+                continue;
+            }
+            if (m_joinGroup) {
+                m_joinGroup = false;
+                if (!APP_SYNC_MASTER) joinGroup();
+            }
+
+            sockaddr_in from = {};
+            socklen_t fromLen = sizeof(from);
+            const int n = recvfrom(m_sock, &buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+            const int64_t rxUs = esp_timer_get_time();
+            if (n >= (int)sizeof(MsgHeader) && buf.hdr.magic == MAGIC) {
+                if (APP_SYNC_MASTER) {
+                    masterReceive((const uint8_t*)&buf, (size_t)n, from, rxUs);
+                } else {
+                    followerReceive((const uint8_t*)&buf, (size_t)n, from, rxUs);
+                }
+            }
+
+            const int64_t now = esp_timer_get_time();
+            if (now >= nextPeriodicUs) {
+                nextPeriodicUs = now + (APP_SYNC_MASTER ? TIMING_PERIOD_US : CLOCK_PERIOD_US);
+                if (APP_SYNC_MASTER) {
+                    sendTiming();
+                } else {
+                    requestClock();
+                }
+            }
+            if (now >= nextStatusUs) {
+                nextStatusUs = now + STATUS_PERIOD_US;
+                logStatus();
+            }
+        }
+    }
+
+    // ---- Master ----
+
+    void masterReceive(const uint8_t* msg, size_t len, const sockaddr_in& from, int64_t rxUs) {
+        const MsgHeader* h = (const MsgHeader*)msg;
+        if (h->type != MSG_CLOCK_REQ || len < sizeof(ClockMsg)) return;
+        ClockMsg reply;
+        memcpy(&reply, msg, sizeof(reply));
+        header(reply.hdr, MSG_CLOCK_RESP);
+        reply.t2 = rxUs;
+        reply.t3 = esp_timer_get_time();
+        sendTo(&reply, sizeof(reply), from);
+        registerFollower(from, rxUs);
+    }
+
+    void registerFollower(const sockaddr_in& addr, int64_t nowUs) {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        int slot = -1;
+        for (int i = 0; i < m_followerCount; i++) {
+            if (m_followers[i].addr.sin_addr.s_addr == addr.sin_addr.s_addr &&
+                m_followers[i].addr.sin_port == addr.sin_port) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0 && m_followerCount < APP_SYNC_MAX_FOLLOWERS) {
+            slot = m_followerCount++;
+            m_followers[slot].addr = addr;
+            ESP_LOGI(TAG, "Follower %s joined (%d)", inet_ntoa(addr.sin_addr), m_followerCount);
+        }
+        if (slot >= 0) m_followers[slot].lastSeenUs = nowUs;
+        xSemaphoreGive(m_lock);
+    }
+
+    void sendTiming() {
+        State st;
+        if (!loadState(st) || !st.timingValid || m_sampleRate == 0) return;
+        TimingMsg msg;
+        header(msg.hdr, MSG_TIMING);
+        msg.frameIndex = st.frameIndex;
+        msg.sampleRate = m_sampleRate;
+        msg.exitUs = st.exitUs;
+        sendTo(&msg, sizeof(msg), m_group);
+    }
+
+    // Producer side of the pipeline: copy each record out for sending
+    static void onInputTap(void* ctx, const uint8_t* data, uint32_t len, SampleFmt fmt,
+                           uint8_t channels, uint32_t frameIndex) {
+        SyncLink* self = (SyncLink*)ctx;
+        if (self->m_followerCount == 0) return;
+        if (!self->m_txRing.write(data, len, fmt, channels, 0, frameIndex)) self->m_txDrops++;
+    }
+
+    // Relay: audio task, one finished output block; the tx ring takes
+    // the only copy
+    static void onOutputTap(void* ctx, const int32_t* stereo, uint32_t frames, uint32_t frameIndex,
+                            uint32_t sampleRate) {
+        SyncLink* self = (SyncLink*)ctx;
+        self->m_sampleRate = sampleRate;
+        if (self->m_followerCount == 0) return;
+        if (!self->m_txRing.write((const uint8_t*)stereo, frames * 2 * sizeof(int32_t), SAMPLE_FMT_S32, 2,
+                                  0, frameIndex)) {
+            self->m_txDrops++;
+        }
+    }
+
+    // Audio task: latest frame-to-DAC mapping
+    static void onBlockTap(void* ctx, uint32_t frameIndex, int64_t exitUs) {
+        SyncLink* self = (SyncLink*)ctx;
+        State st;
+        st.frameIndex = frameIndex;
+        st.exitUs = exitUs;
+        st.timingValid = true;
+        self->storeState(st);
+    }
+
+    static void txTask(void* arg) {
+        ((SyncLink*)arg)->txLoop();
+    }
+
+    void txLoop() {
+        static AudioMsg msg;
+        static int32_t q31[MAX_AUDIO_FRAMES * 2];
+        header(msg.hdr, MSG_AUDIO);
+        // TWS: the ear this unit does not play
+        const uint32_t ear = APP_SYNC_TWS_LEFT ? 1 : 0;
+        msg.channels = APP_SYNC_TWS ? 1 : 2;
+        msg.flags = APP_SYNC_RELAY ? AUDIO_PROCESSED : 0;
+        for (;;) {
+            uint32_t len = 0, frameIndex = 0;
+            uint8_t fmt = SAMPLE_FMT_S16, channels = 2;
+            const uint8_t* rec = m_txRing.peek(len, fmt, channels, nullptr, &frameIndex);
+            if (!rec) {
+                m_txRing.waitForData(pdMS_TO_TICKS(100));
+                continue;
+            }
+            if (channels == 0) channels = 2;
+            const uint32_t bytesPerFrame = sampleFmtBytes(fmt) * channels;
+            const uint32_t total = len / bytesPerFrame;
+            for (uint32_t done = 0; done < total;) {
+                uint32_t frames = total - done;
+                if (frames > MAX_AUDIO_FRAMES) frames = MAX_AUDIO_FRAMES;
+                convertBlock<int32_t>(fmt, channels, rec + done * bytesPerFrame, q31, frames);
+                if (APP_SYNC_TWS) {
+                    for (uint32_t i = 0; i < frames; i++) {
+                        msg.pcm[i] = (int16_t)(q31[2 * i + ear] >> 16);
+                    }
+                } else {
+                    for (uint32_t i = 0; i < frames * 2; i++) {
+                        msg.pcm[i] = (int16_t)(q31[i] >> 16);
+                    }
+                }
+                msg.frameIndex = frameIndex + done;
+                msg.sampleRate = m_sampleRate;
+                msg.frames = (uint16_t)frames;
+                sendAudio(msg, offsetof(AudioMsg, pcm) + frames * msg.channels * sizeof(int16_t));
+                done += frames;
+            }
+            m_txRing.release();
+        }
+    }
+
+    // To every follower heard from recently; quiet ones are dropped
+    void sendAudio(const AudioMsg& msg, size_t len) {
+        const int64_t now = esp_timer_get_time();
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        for (int i = 0; i < m_followerCount;) {
+            if (now - m_followers[i].lastSeenUs > FOLLOWER_TIMEOUT_US) {
+                ESP_LOGI(TAG, "Follower %s left", inet_ntoa(m_followers[i].addr.sin_addr));
+                m_followers[i] = m_followers[--m_followerCount];
+                continue;
+            }
+            sendTo(&msg, len, m_followers[i].addr);
+            i++;
+        }
+        xSemaphoreGive(m_lock);
+    }
+
+    // ---- Follower ----
+
+    void followerReceive(const uint8_t* msg, size_t len, const sockaddr_in& from, int64_t rxUs) {
+        const MsgHeader* h = (const MsgHeader*)msg;
+        if (h->type == MSG_TIMING && len >= sizeof(TimingMsg)) {
+            TimingMsg t;
+            memcpy(&t, msg, sizeof(t));
+            if (!m_hasMaster || m_master.sin_addr.s_addr != from.sin_addr.s_addr) {
+                ESP_LOGI(TAG, "Master at %s", inet_ntoa(from.sin_addr));
+                m_master = from;
+                m_hasMaster = true;
+                m_clockCount = 0;
+            }
+            State st;
+            loadState(st);
+            st.frameIndex = t.frameIndex;
+            st.sampleRate = t.sampleRate;
+            st.exitUs = t.exitUs;
+            st.timingValid = t.sampleRate != 0;
+            storeState(st);
+        } else if (h->type == MSG_CLOCK_RESP && len >= sizeof(ClockMsg)) {
+            ClockMsg c;
+            memcpy(&c, msg, sizeof(c));
+            onClock(c, rxUs);
+        } else if (h->type == MSG_AUDIO && len >= offsetof(AudioMsg, pcm)) {
+            const AudioMsg* a = (const AudioMsg*)msg;
+            const size_t need = offsetof(AudioMsg, pcm) + (size_t)a->frames * a->channels * sizeof(int16_t);
+            if ((a->channels == 1 || a->channels == 2) && (uint32_t)a->frames * a->channels <= MAX_AUDIO_SAMPLES &&
+                len >= need) {
+                onAudio(*a);
+            }
+        }
+    }
+
+    void requestClock() {
+        if (!m_hasMaster) return;
+        ClockMsg req = {};
+        header(req.hdr, MSG_CLOCK_REQ);
+        req.t1 = esp_timer_get_time();
+        sendTo(&req, sizeof(req), m_master);
+    }
+
+    void onClock(const ClockMsg& c, int64_t t4) {
+        const int64_t rtt = (t4 - c.t1) - (c.t3 - c.t2);
+        if (rtt < 0) return;
+        m_clock[m_clockNext] = { ((c.t2 - c.t1) + (c.t3 - t4)) / 2, rtt };
+        m_clockNext = (m_clockNext + 1) % CLOCK_WINDOW;
+        if (m_clockCount < CLOCK_WINDOW) m_clockCount++;
+
+        const ClockSample* best = &m_clock[0];
+        for (int i = 1; i < m_clockCount; i++) {
+            if (m_clock[i].rttUs < best->rttUs) best = &m_clock[i];
+        }
+        m_rttUs = best->rttUs;
+        State st;
+        loadState(st);
+        // A big step (master rebooted, first lock) is taken at once
+        const int64_t step = best->offsetUs - st.offsetUs;
+        st.offsetUs = (!st.clockValid || step > 10000 || step < -10000) ? best->offsetUs : st.offsetUs + step / 4;
+        st.clockValid = true;
+        storeState(st);
+    }
+
+    void onAudio(const AudioMsg& a) {
+        if (m_localStream || a.sampleRate == 0) return;
+        State st;
+        loadState(st);
+        if (a.sampleRate != m_sampleRate || a.channels != m_channels) {
+            m_sampleRate = a.sampleRate;
+            m_channels = a.channels;
+            if (m_onFormat) m_onFormat(a.sampleRate, a.channels);
+            st.deltaValid = false;
+        }
+        m_pipeline->setDspEnabled((a.flags & AUDIO_PROCESSED) == 0);
+
+        const uint32_t local = m_pipeline->getInputFrameIndex();
+        if (!st.deltaValid) {
+            st.delta = a.frameIndex - local;
+            st.deltaValid = true;
+            storeState(st);
+        }
+        const uint8_t* pcm = (const uint8_t*)a.pcm;
+        const uint32_t frameBytes = a.channels * sizeof(int16_t);
+        uint32_t frames = a.frames;
+        const int32_t gap = (int32_t)(a.frameIndex - (local + st.delta));
+        if (gap < 0) {
+            // Already have these (duplicate, reordered)
+            if ((uint32_t)-gap >= frames) return;
+            pcm += (uint32_t)-gap * frameBytes;
+            frames -= (uint32_t)-gap;
+        } else if (gap > (int32_t)(a.sampleRate / 4)) {
+            // Lost too much to patch: start over from this packet
+            m_pipeline->clear();
+            st.delta = a.frameIndex - local;
+            storeState(st);
+            m_resyncs++;
+        } else if (gap > 0) {
+            // Lost packets: silence in their place keeps the indexes in step
+            static const int16_t zeros[MAX_AUDIO_SAMPLES] = {};
+            const uint32_t chunk = MAX_AUDIO_SAMPLES / a.channels;
+            for (uint32_t left = (uint32_t)gap; left > 0;) {
+                const uint32_t n = left < chunk ? left : chunk;
+                m_pipeline->enqueue((const uint8_t*)zeros, n * frameBytes, SAMPLE_FMT_S16, a.channels);
+                left -= n;
+            }
+            m_lostFrames += (uint32_t)gap;
+        }
+        m_pipeline->enqueue(pcm, frames * frameBytes, SAMPLE_FMT_S16, a.channels);
+    }
+
+    // Audio task: when local frame frameIndex is due at the DAC
+    static int64_t onSyncTarget(void* ctx, uint32_t frameIndex) {
+        SyncLink* self = (SyncLink*)ctx;
+        State st;
+        if (!self->loadState(st) || !st.timingValid || !st.clockValid || !st.deltaValid) {
+            return AudioPipeline::SYNC_UNKNOWN;
+        }
+        const int32_t ahead = (int32_t)(frameIndex + st.delta - st.frameIndex);
+        return st.exitUs + (int64_t)ahead * 1000000 / st.sampleRate - st.offsetUs;
+    }
+
+    void logStatus() {
+        if (APP_SYNC_MASTER) {
+            ESP_LOGI(TAG, "%d follower(s), %u send drops", m_followerCount, (unsigned)m_txDrops);
+            return;
+        }
+        State st;
+        loadState(st);
+        ESP_LOGI(TAG, "%s: offset %lld us (rtt %lld us), error %ld us, %u frames lost, %u resyncs",
+                 isLocked() ? "locked" : "searching", (long long)st.offsetUs, (long long)m_rttUs,
+                 (long)m_pipeline->getJitterBuffer().getSyncErrorUs(),
+                 (unsigned)m_lostFrames, (unsigned)m_resyncs);
+    }
+
+    AudioPipeline* m_pipeline = nullptr;
+    FormatCallback m_onFormat = nullptr;
+    int m_sock = -1;
+    sockaddr_in m_group = {};
+    volatile bool m_hasIp = false;
+    volatile bool m_joinGroup = false;
+    volatile uint32_t m_sampleRate = 0;
+    uint8_t m_channels = 0;         // Follower: of the master's stream
+
+    State m_state;
+    std::atomic<uint32_t> m_stateSeq{0};
+
+    // Master
+    SpscRing m_txRing;              // BT callback -> sync_tx
+    SemaphoreHandle_t m_lock = nullptr;
+    Follower m_followers[APP_SYNC_MAX_FOLLOWERS > 0 ? APP_SYNC_MAX_FOLLOWERS : 1];
+    volatile int m_followerCount = 0;
+    uint32_t m_txDrops = 0;
+
+    // Follower (rx task, except m_localStream)
+    sockaddr_in m_master = {};
+    bool m_hasMaster = false;
+    volatile bool m_localStream = false;
+    ClockSample m_clock[CLOCK_WINDOW] = {};
+    int m_clockNext = 0;
+    int m_clockCount = 0;
+    int64_t m_rttUs = 0;
+    uint32_t m_lostFrames = 0;
+    uint32_t m_resyncs = 0;
+};
+
+#endif // APP_SYNC_ENABLE
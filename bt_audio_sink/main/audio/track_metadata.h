@@ -0,0 +1,203 @@
+#pragma once
+
+/*
+ * track_metadata.h
+ *
+ * Title, artist and play position of the phone's current track (for the LED
+ * scroller). The library's own fetch - every attribute on every track-change
+ * notification - is switched off; instead a track change looks its UID up in
+ * a small LRU of the tracks seen on this link, and only a miss sends
+ * GetElementAttributes (title, artist, length). A repeated notification for
+ * the track already shown costs nothing.
+ *
+ * Track UIDs (AVRCP 1.4+): 0 is "a track, but no UID" (1.3 targets), so it
+ * is fetched every time and never cached; all ones is "nothing selected".
+ * UIDs only mean something to the player that sent them, so the cache goes
+ * with the AVRCP link.
+ *
+ * The text callback gets "Artist - Title" once both have arrived, the
+ * position callback position and length per play-position notification. All
+ * of it runs in the library's app task, so nothing here is locked.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "BluetoothA2DPSink.h"
+
+class TrackMetadata {
+public:
+    using TextCallback = void (*)(const char* text);
+    using PositionCallback = void (*)(uint32_t posMs, uint32_t lengthMs);
+
+    static constexpr int CACHE_SIZE = 8;
+    static constexpr size_t FIELD_MAX = 48;             // Title, artist (bytes, UTF-8)
+    static constexpr uint32_t POS_INTERVAL_S = 2;       // Play-position notifications
+
+    static TrackMetadata& getInstance() {
+        static TrackMetadata instance;
+        return instance;
+    }
+
+    // Before sink.start()
+    void begin(BluetoothA2DPSink& sink, TextCallback onText, PositionCallback onPosition) {
+        m_sink = &sink;
+        m_onText = onText;
+        m_onPosition = onPosition;
+        sink.set_avrc_metadata_attribute_mask(ATTR_MASK);
+        sink.set_avrc_metadata_auto(false);
+        sink.set_avrc_metadata_callback(&onAttrThunk);
+        sink.set_avrc_rn_track_change_callback(&onTrackChangeThunk);
+        sink.set_avrc_rn_play_pos_callback(&onPlayPosThunk, POS_INTERVAL_S);
+        sink.set_avrc_connection_state_callback(&onAvrcConnectionThunk);
+    }
+
+    const char* getText() const { return m_text; }
+    uint32_t getLengthMs() const { return m_current.lengthMs; }
+
+private:
+    static constexpr const char* TAG = "Track";
+    static constexpr int TEXT_ATTRS = ESP_AVRC_MD_ATTR_TITLE | ESP_AVRC_MD_ATTR_ARTIST;
+    static constexpr int ATTR_MASK = TEXT_ATTRS | ESP_AVRC_MD_ATTR_PLAYING_TIME;
+    static constexpr uint64_t UID_UNKNOWN = 0;
+    static constexpr uint64_t UID_NONE = ~0ull;
+    static constexpr uint32_t POS_NONE = 0xFFFFFFFF;
+
+    struct Track {
+        uint64_t uid;
+        uint32_t lengthMs;
+        char title[FIELD_MAX];
+        char artist[FIELD_MAX];
+    };
+
+    TrackMetadata() = default;
+
+    static void onAttrThunk(uint8_t id, const uint8_t* text) { getInstance().onAttr(id, (const char*)text); }
+    static void onTrackChangeThunk(uint8_t* id) { getInstance().onTrackChange(id); }
+    static void onPlayPosThunk(uint32_t pos) { getInstance().onPlayPos(pos); }
+    static void onAvrcConnectionThunk(bool connected) { getInstance().onAvrcConnection(connected); }
+
+    void onAvrcConnection(bool connected) {
+        m_cacheCount = 0;
+        reset(UID_UNKNOWN);
+        // The track already playing never sent a change
+        if (connected) fetch();
+    }
+
+    void onTrackChange(const uint8_t* id) {
+        uint64_t uid = 0;
+        for (int i = 0; i < 8; i++) uid = (uid << 8) | id[i];
+
+        if (uid == UID_NONE) {
+            reset(UID_NONE);
+            return;
+        }
+        if (uid != UID_UNKNOWN && uid == m_current.uid && (m_have & TEXT_ATTRS) == TEXT_ATTRS) return;
+
+        reset(uid);
+        const int hit = uid != UID_UNKNOWN ? find(uid) : -1;
+        if (hit >= 0) {
+            touch(hit);
+            m_current = m_cache[0];
+            m_have = ATTR_MASK;
+            ESP_LOGD(TAG, "Cached: %s", m_current.title);
+            publish();
+            return;
+        }
+        fetch();
+    }
+
+    // One response per attribute, in the target's order
+    void onAttr(uint8_t id, const char* text) {
+        if (!m_fetching || !text) return;
+        switch (id) {
+            case ESP_AVRC_MD_ATTR_TITLE:
+                snprintf(m_current.title, FIELD_MAX, "%s", text);
+                break;
+            case ESP_AVRC_MD_ATTR_ARTIST:
+                snprintf(m_current.artist, FIELD_MAX, "%s", text);
+                break;
+            case ESP_AVRC_MD_ATTR_PLAYING_TIME:
+                m_current.lengthMs = (uint32_t)strtoul(text, nullptr, 10);
+                break;
+            default:
+                return;
+        }
+        const bool shown = (m_have & TEXT_ATTRS) == TEXT_ATTRS;
+        m_have |= id;
+        if ((m_have & TEXT_ATTRS) != TEXT_ATTRS) return;
+        if (!shown) publish();
+        if (m_current.uid != UID_UNKNOWN) store();
+        if ((m_have & ATTR_MASK) == ATTR_MASK) m_fetching = false;
+    }
+
+    void onPlayPos(uint32_t posMs) {
+        if (posMs == POS_NONE || !m_onPosition) return;
+        m_onPosition(posMs, m_current.lengthMs);
+    }
+
+    void fetch() {
+        m_fetching = true;
+        m_sink->request_avrc_metadata();
+    }
+
+    void reset(uint64_t uid) {
+        m_current = Track{};
+        m_current.uid = uid;
+        m_have = 0;
+        m_fetching = false;
+        m_text[0] = '\0';
+    }
+
+    // "Artist - Title", or whichever of the two is there
+    void publish() {
+        const Track& t = m_current;
+        if (t.artist[0] && t.title[0]) {
+            snprintf(m_text, sizeof(m_text), "%s - %s", t.artist, t.title);
+        } else {
+            snprintf(m_text, sizeof(m_text), "%s", t.artist[0] ? t.artist : t.title);
+        }
+        if (!m_text[0]) return;
+        ESP_LOGI(TAG, "%s", m_text);
+        if (m_onText) m_onText(m_text);
+    }
+
+    int find(uint64_t uid) const {
+        for (int i = 0; i < m_cacheCount; i++) {
+            if (m_cache[i].uid == uid) return i;
+        }
+        return -1;
+    }
+
+    // Move entry i to the front (most recent)
+    void touch(int i) {
+        const Track t = m_cache[i];
+        memmove(&m_cache[1], &m_cache[0], i * sizeof(Track));
+        m_cache[0] = t;
+    }
+
+    // Insert or refresh the current track; the oldest falls out
+    void store() {
+        int i = find(m_current.uid);
+        if (i < 0) {
+            if (m_cacheCount < CACHE_SIZE) m_cacheCount++;
+            i = m_cacheCount - 1;
+        }
+        m_cache[i] = m_current;
+        touch(i);
+    }
+
+    BluetoothA2DPSink* m_sink = nullptr;
+    TextCallback m_onText = nullptr;
+    PositionCallback m_onPosition = nullptr;
+
+    Track m_cache[CACHE_SIZE] = {};     // Most recent first
+    int m_cacheCount = 0;
+    Track m_current = {};
+    int m_have = 0;                     // ESP_AVRC_MD_ATTR_* received
+    bool m_fetching = false;
+    char m_text[2 * FIELD_MAX + 4] = {};
+};
@@ -0,0 +1,250 @@
+#pragma once
+
+// -----------------------------------------------------------
+// WAV reader - header and data chunk lookup for PCM and IMA ADPCM
+// WAV files. Shared by SoundPlayer (streaming playback) and
+// SoundCache (prompt pre-rendering); WavSource hands out ADPCM
+// decoded, so both only ever see 16-bit PCM from it.
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "ima_adpcm.h"
+
+// Convert 8-bit unsigned to 16-bit signed
+static inline int16_t convert_u8_to_s16(uint8_t sample) {
+    return ((int16_t)sample - 128) << 8;
+}
+
+// WAV file header structure
+struct WavHeader {
+    char riff[4];           // "RIFF"
+    uint32_t fileSize;      // File size - 8
+    char wave[4];           // "WAVE"
+    char fmt[4];            // "fmt "
+    uint32_t fmtSize;       // Format chunk size (16 for PCM)
+    uint16_t audioFormat;   // 1 = PCM, 0x11 = IMA ADPCM
+    uint16_t numChannels;   // 1 = mono, 2 = stereo
+    uint32_t sampleRate;    // e.g., 44100
+    uint32_t byteRate;      // sampleRate * numChannels * bitsPerSample/8
+    uint16_t blockAlign;    // numChannels * bitsPerSample/8 (ADPCM: block bytes)
+    uint16_t bitsPerSample; // 8 or 16 (ADPCM: 4)
+    // Data chunk follows
+};
+
+static inline bool wavIsAdpcm(const WavHeader& header) {
+    return header.audioFormat == WAV_FORMAT_IMA_ADPCM;
+}
+
+// Formats the players handle: PCM, 8/16-bit, or IMA ADPCM, mono or stereo
+static inline bool wavFormatOk(const WavHeader& header) {
+    if (memcmp(header.riff, "RIFF", 4) != 0 || memcmp(header.wave, "WAVE", 4) != 0 ||
+        header.numChannels < 1 || header.numChannels > 2 ||
+        header.sampleRate == 0 || header.blockAlign == 0) {
+        return false;
+    }
+    if (wavIsAdpcm(header)) {
+        const uint16_t head = 4 * header.numChannels;
+        return header.bitsPerSample == 4 && header.blockAlign > head &&
+               header.blockAlign % head == 0 && header.blockAlign <= IMA_MAX_BLOCK;
+    }
+    return header.audioFormat == 1 && (header.bitsPerSample == 8 || header.bitsPerSample == 16);
+}
+
+// Opens a PCM WAV and leaves the file at the start of its data chunk.
+// Returns nullptr (file closed) if it is not a WAV this player can read.
+static inline FILE* openWavData(const char* path, WavHeader& header, uint32_t& dataBytes) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return nullptr;
+
+    if (fread(&header, 1, sizeof(header), f) != sizeof(header) || !wavFormatOk(header)) {
+        fclose(f);
+        return nullptr;
+    }
+
+    // Find data chunk (chunks start after the fmt chunk, whatever its size)
+    fseek(f, 20 + header.fmtSize, SEEK_SET);
+    char chunkId[4];
+    uint32_t chunkSize = 0;
+    while (fread(chunkId, 1, 4, f) == 4) {
+        if (fread(&chunkSize, 4, 1, f) != 1) break;
+        if (memcmp(chunkId, "data", 4) == 0) {
+            dataBytes = chunkSize;
+            return f;
+        }
+        fseek(f, chunkSize, SEEK_CUR);
+    }
+    fclose(f);
+    return nullptr;
+}
+
+// Same for a WAV already in memory (an upload): data chunk offset and
+// length, clamped to the buffer
+static inline bool parseWavData(const uint8_t* buf, size_t len, WavHeader& header,
+                                size_t& dataOffset, uint32_t& dataBytes) {
+    if (len < sizeof(header)) return false;
+    memcpy(&header, buf, sizeof(header));
+    if (!wavFormatOk(header)) return false;
+
+    size_t pos = 20 + (size_t)header.fmtSize;
+    while (pos + 8 <= len) {
+        uint32_t chunkSize;
+        memcpy(&chunkSize, buf + pos + 4, 4);
+        if (memcmp(buf + pos, "data", 4) == 0) {
+            dataOffset = pos + 8;
+            dataBytes = chunkSize < len - dataOffset ? chunkSize : (uint32_t)(len - dataOffset);
+            if (!wavIsAdpcm(header)) dataBytes -= dataBytes % header.blockAlign;  // ADPCM: short last block
+            return true;
+        }
+        pos += 8 + (size_t)chunkSize;
+    }
+    return false;
+}
+
+// Canonical 44-byte PCM WAV header (fmt chunk of 16, then data)
+static constexpr size_t WAV_CANONICAL_HEADER = 44;
+static inline void writeWavHeader(uint8_t* dst, uint32_t sampleRate, uint16_t channels,
+                                  uint16_t bitsPerSample, uint32_t dataBytes) {
+    WavHeader h;
+    memcpy(h.riff, "RIFF", 4);
+    h.fileSize = (uint32_t)(WAV_CANONICAL_HEADER - 8) + dataBytes;
+    memcpy(h.wave, "WAVE", 4);
+    memcpy(h.fmt, "fmt ", 4);
+    h.fmtSize = 16;
+    h.audioFormat = 1;
+    h.numChannels = channels;
+    h.sampleRate = sampleRate;
+    h.blockAlign = channels * bitsPerSample / 8;
+    h.byteRate = sampleRate * h.blockAlign;
+    h.bitsPerSample = bitsPerSample;
+    memcpy(dst, &h, sizeof(h));
+    memcpy(dst + sizeof(h), "data", 4);
+    memcpy(dst + sizeof(h) + 4, &dataBytes, 4);
+}
+
+// PCM data of one sound: a WAV file positioned at its data chunk, or
+// data already addressable in memory (mapped flash). IMA ADPCM is
+// decoded a block at a time as it is read: header and dataBytes then
+// describe the 16-bit PCM it decodes to.
+struct WavSource {
+    WavHeader header = {};
+    uint32_t dataBytes = 0;
+    FILE* file = nullptr;
+    const uint8_t* mapped = nullptr;
+    size_t pos = 0;
+
+    bool openFile(const char* path) {
+        file = openWavData(path, header, dataBytes);
+        if (!file) return false;
+        if (wavIsAdpcm(header) && !openAdpcm()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    bool openMapped(const WavHeader& h, const uint8_t* data, uint32_t bytes) {
+        header = h;
+        mapped = data;
+        dataBytes = bytes;
+        pos = 0;
+        if (wavIsAdpcm(header) && !openAdpcm()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Next bytes of PCM in place, or nullptr if they must be read()
+    const uint8_t* view() const { return mapped && !m_adpcmPcm ? mapped + pos : nullptr; }
+    void skip(size_t bytes) { pos += bytes; }
+
+    size_t read(void* dst, size_t bytes) {
+        if (m_adpcmPcm) return readAdpcm((uint8_t*)dst, bytes);
+        if (file) return fread(dst, 1, bytes, file);
+        if (!mapped) return 0;
+        if (bytes > dataBytes - pos) bytes = dataBytes - pos;
+        memcpy(dst, mapped + pos, bytes);
+        pos += bytes;
+        return bytes;
+    }
+
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+        mapped = nullptr;
+        if (m_adpcmPcm) heap_caps_free(m_adpcmPcm);
+        if (m_adpcmRaw) heap_caps_free(m_adpcmRaw);
+        m_adpcmPcm = nullptr;
+        m_adpcmRaw = nullptr;
+    }
+
+private:
+    // Block buffers (PSRAM when present; the raw one for files only),
+    // and header / dataBytes switched to the decoded PCM
+    bool openAdpcm() {
+        const int ch = header.numChannels;
+        const uint16_t block = header.blockAlign;
+        const size_t pcmBytes = imaBlockFrames(block, ch) * ch * sizeof(int16_t);
+        m_adpcmPcm = (int16_t*)heap_caps_malloc(pcmBytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!m_adpcmPcm) m_adpcmPcm = (int16_t*)heap_caps_malloc(pcmBytes, MALLOC_CAP_8BIT);
+        if (file) {
+            m_adpcmRaw = (uint8_t*)heap_caps_malloc(block, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (!m_adpcmRaw) m_adpcmRaw = (uint8_t*)heap_caps_malloc(block, MALLOC_CAP_8BIT);
+        }
+        if (!m_adpcmPcm || (file && !m_adpcmRaw)) return false;
+
+        m_adpcmBlock = block;
+        m_adpcmLeft = dataBytes;
+        m_pcmFrames = 0;
+        m_pcmPos = 0;
+        const uint32_t frames = (uint32_t)(dataBytes / block * imaBlockFrames(block, ch) +
+                                           imaBlockFrames(dataBytes % block, ch));
+        header.audioFormat = 1;
+        header.bitsPerSample = 16;
+        header.blockAlign = (uint16_t)(ch * sizeof(int16_t));
+        header.byteRate = header.sampleRate * header.blockAlign;
+        dataBytes = frames * header.blockAlign;
+        return true;
+    }
+
+    // Whole frames only, as the PCM reads return them
+    size_t readAdpcm(uint8_t* dst, size_t bytes) {
+        const size_t frameBytes = header.blockAlign;
+        size_t done = 0;
+        while (bytes - done >= frameBytes) {
+            if (m_pcmPos == m_pcmFrames && !decodeBlock()) break;
+            size_t n = (bytes - done) / frameBytes;
+            if (n > m_pcmFrames - m_pcmPos) n = m_pcmFrames - m_pcmPos;
+            memcpy(dst + done, (const uint8_t*)m_adpcmPcm + m_pcmPos * frameBytes, n * frameBytes);
+            m_pcmPos += n;
+            done += n * frameBytes;
+        }
+        return done;
+    }
+
+    bool decodeBlock() {
+        size_t n = m_adpcmLeft < m_adpcmBlock ? m_adpcmLeft : m_adpcmBlock;
+        const uint8_t* block;
+        if (file) {
+            n = fread(m_adpcmRaw, 1, n, file);
+            block = m_adpcmRaw;
+        } else {
+            block = mapped + pos;
+            pos += n;
+        }
+        m_adpcmLeft -= n;
+        m_pcmFrames = imaDecodeBlock(block, n, header.numChannels, m_adpcmPcm);
+        m_pcmPos = 0;
+        return m_pcmFrames > 0;
+    }
+
+    int16_t* m_adpcmPcm = nullptr;      // Decoded block; non-null for ADPCM
+    uint8_t* m_adpcmRaw = nullptr;
+    uint16_t m_adpcmBlock = 0;
+    uint32_t m_adpcmLeft = 0;           // Encoded bytes not yet decoded
+    size_t m_pcmFrames = 0;
+    size_t m_pcmPos = 0;
+};
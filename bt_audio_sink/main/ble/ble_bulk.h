@@ -0,0 +1,160 @@
+#pragma once
+
+// -----------------------------------------------------------
+// BLE Bulk Channel - LE credit based L2CAP channel for transfers
+// (APP_BLE_BULK_CHANNEL)
+// - One server channel on APP_BLE_BULK_PSM next to the GATT service;
+//   GATT stays the control path (BEGIN/END, acks, status)
+// - SDUs are [kind, data...], kind the BleCmd (OTA_DATA,
+//   SOUND_UP_DATA) or BleResp (STATUS_CAPTURE) the data belongs to;
+//   L2CAP delivers them reliably and in order, so there are no
+//   sequence numbers or acks
+// - Flow control is the peer's credits, one per K-frame of MPS bytes:
+//   the sink's CreditFn says how many frames it can take now, and
+//   refill() tops the peer up to that after each SDU and whenever the
+//   sink has room again (no credits are given at connect)
+// - Events arrive on the Bluetooth host task and must not block
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_ble_l2cap_coc_api.h"
+#include "esp_log.h"
+#include "../config/app_config.h"
+
+class BleBulkChannel {
+public:
+    enum State : uint8_t { STATE_OFF, STATE_LISTENING, STATE_OPEN };
+
+    // Host task: one SDU, kind stripped
+    using DataFn = void (*)(uint8_t kind, const uint8_t* data, size_t len);
+    // K-frames of mps bytes the sink can take now, outstanding ones included
+    using CreditFn = uint16_t (*)(uint16_t mps);
+
+    static constexpr uint16_t MPS = 247;            // One LE data length extended PDU
+    static constexpr uint16_t MAX_CREDITS = 32;
+    static constexpr uint16_t MAX_IN_FLIGHT = 16;   // Downlink frames per write burst
+
+    static BleBulkChannel& getInstance() {
+        static BleBulkChannel instance;
+        return instance;
+    }
+
+    // Once, after the Bluetooth host is enabled
+    bool begin(DataFn data, CreditFn credit) {
+        m_data = data;
+        m_credit = credit;
+        const esp_err_t err = esp_ble_l2cap_coc_server_register(APP_BLE_BULK_PSM, APP_BLE_BULK_MTU, MPS, 0,
+                                                                onEvent);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Bulk channel unavailable: %s", esp_err_to_name(err));
+            return false;
+        }
+        m_state = STATE_LISTENING;
+        ESP_LOGI(TAG, "Bulk channel on PSM 0x%02X, SDU %u bytes", APP_BLE_BULK_PSM, APP_BLE_BULK_MTU);
+        return true;
+    }
+
+    // [state, psm u16, sdu u16] for STATUS_BULK
+    size_t status(uint8_t* out, size_t cap) const {
+        if (cap < 5) return 0;
+        out[0] = m_state;
+        out[1] = (uint8_t)APP_BLE_BULK_PSM;
+        out[2] = (uint8_t)(APP_BLE_BULK_PSM >> 8);
+        out[3] = (uint8_t)APP_BLE_BULK_MTU;
+        out[4] = (uint8_t)(APP_BLE_BULK_MTU >> 8);
+        return 5;
+    }
+
+    bool isOpen() const { return m_state == STATE_OPEN; }
+
+    // Largest downlink SDU, kind included; 0 when closed
+    size_t maxSdu() const {
+        if (!isOpen()) return 0;
+        return m_peerMtu < APP_BLE_BULK_MTU ? m_peerMtu : APP_BLE_BULK_MTU;
+    }
+
+    // SDUs of sduBytes one burst may queue, at least one
+    uint8_t window(size_t sduBytes) const {
+        const size_t mps = m_peerMps ? m_peerMps : 23;
+        const size_t frames = (sduBytes + 2 + mps - 1) / mps;      // First frame carries the SDU length
+        const size_t n = MAX_IN_FLIGHT / frames;
+        return n ? (uint8_t)(n < 255 ? n : 255) : 1;
+    }
+
+    // Downlink SDU; false when closed, congested or it could not be queued
+    bool write(const uint8_t* data, size_t len) {
+        if (!isOpen() || m_congested || len > maxSdu()) return false;
+        return esp_ble_l2cap_coc_write(m_lcid, data, (uint16_t)len) == ESP_OK;
+    }
+
+    // Any task: give the peer the credits the sink has room for
+    void refill() {
+        if (!isOpen() || !m_credit) return;
+        const uint16_t target = m_credit(MPS);
+        uint16_t give = 0;
+        portENTER_CRITICAL(&m_lock);
+        if (target > m_outstanding) {
+            give = target - m_outstanding;
+            m_outstanding = target;
+        }
+        portEXIT_CRITICAL(&m_lock);
+        if (give && esp_ble_l2cap_coc_give_credits(m_lcid, give) != ESP_OK) {
+            portENTER_CRITICAL(&m_lock);
+            m_outstanding -= give;
+            portEXIT_CRITICAL(&m_lock);
+        }
+    }
+
+private:
+    static constexpr const char* TAG = "BleBulk";
+
+    BleBulkChannel() = default;
+
+    // Host task
+    static void onEvent(esp_ble_l2cap_coc_cb_event_t event, esp_ble_l2cap_coc_cb_param_t* param) {
+        BleBulkChannel& self = getInstance();
+        switch (event) {
+            case ESP_BLE_L2CAP_COC_OPEN_EVT:
+                self.m_lcid = param->open.lcid;
+                self.m_peerMtu = param->open.peer_mtu;
+                self.m_peerMps = param->open.peer_mps;
+                self.m_outstanding = 0;
+                self.m_congested = false;
+                self.m_state = STATE_OPEN;
+                ESP_LOGI(TAG, "Opened, peer SDU %u MPS %u", self.m_peerMtu, self.m_peerMps);
+                self.refill();
+                break;
+            case ESP_BLE_L2CAP_COC_DATA_EVT: {
+                const uint16_t frames = param->data.frames;
+                if (param->data.len >= 1 && self.m_data) {
+                    self.m_data(param->data.data[0], param->data.data + 1, param->data.len - 1);
+                }
+                portENTER_CRITICAL(&self.m_lock);
+                self.m_outstanding = frames < self.m_outstanding ? self.m_outstanding - frames : 0;
+                portEXIT_CRITICAL(&self.m_lock);
+                self.refill();
+                break;
+            }
+            case ESP_BLE_L2CAP_COC_CONG_EVT:
+                self.m_congested = param->cong.congested;
+                break;
+            case ESP_BLE_L2CAP_COC_CLOSE_EVT:
+                self.m_state = STATE_LISTENING;
+                self.m_congested = false;
+                ESP_LOGI(TAG, "Closed");
+                break;
+        }
+    }
+
+    DataFn m_data = nullptr;
+    CreditFn m_credit = nullptr;
+    portMUX_TYPE m_lock = portMUX_INITIALIZER_UNLOCKED;
+    volatile State m_state = STATE_OFF;
+    volatile bool m_congested = false;
+    uint16_t m_lcid = 0;
+    uint16_t m_peerMtu = 0;
+    uint16_t m_peerMps = 0;
+    uint16_t m_outstanding = 0;     // Credits given, frames not yet received
+};
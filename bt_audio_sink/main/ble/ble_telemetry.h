@@ -0,0 +1,196 @@
+#pragma once
+
+// -----------------------------------------------------------
+// BLE Telemetry - one METER notification carrying levels, spectrum
+// and stats, in place of the 3-byte level meter once a client asks
+// for it (SET_TELEMETRY)
+// Frame: [seq, base, contents, sections in contents bit order...]
+//   LEVELS    [l30, l60, l100] 0-100 as the level meter
+//   SPECTRUM  [n, (changed bitmap, (n+7)/8 bytes), nibbles...]
+//             4-bit levels, 4 dB steps from -60 dB, low nibble first;
+//             a key frame has every band and no bitmap, a delta frame
+//             only the bands changed since frame `base`
+//   LIMITER   [gr u16] gain reduction in 0.1 dB
+//   QUEUE     [fill %, buffered_ms u16]
+//   CODEC     [codec id, drops u16, short writes u16] counters wrap
+//   LINK      [rssi i8, link quality, rf level, queued packets,
+//             rf glitches u16, cpu glitches u16, last cause]
+//             see link_monitor.h; counters wrap
+// - base == seq marks a key frame; a delta frame only applies on top
+//   of frame `base`, so after a gap a client waits for the next key
+//   (at most KEY_EVERY frames)
+// - The METER slot keeps only the newest frame: when the previous one
+//   was replaced before it went out, the next delta is still taken
+//   against the last frame that did
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+struct TelemetryInput {
+    static constexpr int MAX_BANDS = 32;
+    uint8_t levels[3] = {};
+    uint8_t numBands = 0;
+    float bands[MAX_BANDS];         // Linear, full scale 1.0
+    uint16_t grTenthDb = 0;
+    uint8_t queuePct = 0;
+    uint16_t bufferedMs = 0;
+    uint8_t codec = 0;
+    uint16_t drops = 0;
+    uint16_t shortWrites = 0;
+    int8_t rssi = 0;
+    uint8_t linkQuality = 0;
+    uint8_t rfLevel = 0;
+    uint8_t queuedPackets = 0;
+    uint16_t rfGlitches = 0;
+    uint16_t cpuGlitches = 0;
+    uint8_t glitchCause = 0;
+};
+
+class BleTelemetry {
+public:
+    enum : uint8_t {
+        LEVELS   = 0x01,
+        SPECTRUM = 0x02,
+        LIMITER  = 0x04,
+        QUEUE    = 0x08,
+        CODEC    = 0x10,
+        LINK     = 0x20,
+        ALL      = 0x3F,
+    };
+    static constexpr size_t MAX_FRAME = 48;
+    static constexpr uint8_t KEY_EVERY = 20;
+
+    void reset() {
+        m_seq = 0;
+        m_haveBase = false;
+        m_pending = false;
+        m_sinceKey = 0;
+    }
+
+    // prevSent: the last frame encoded left the TX queue (was not
+    // replaced). Sections that do not fit cap are left out.
+    size_t encode(const TelemetryInput& in, uint8_t contents, bool prevSent, uint8_t* out, size_t cap) {
+        if (cap > MAX_FRAME) cap = MAX_FRAME;
+        if (cap < 3) return 0;
+        if (m_pending && prevSent) {
+            memcpy(m_baseQ, m_pendingQ, sizeof(m_baseQ));
+            m_baseBands = m_pendingBands;
+            m_baseSeq = m_pendingSeq;
+            m_haveBase = true;
+        }
+        m_pending = false;
+
+        uint8_t q[TelemetryInput::MAX_BANDS];
+        const int n = in.numBands < TelemetryInput::MAX_BANDS ? in.numBands : TelemetryInput::MAX_BANDS;
+        for (int i = 0; i < n; i++) q[i] = quantize(in.bands[i]);
+
+        const bool key = !m_haveBase || m_sinceKey >= KEY_EVERY || n != m_baseBands;
+        const uint8_t seq = ++m_seq;
+        size_t idx = 3;
+        uint8_t sent = 0;
+
+        if (contents & LEVELS) {
+            if (idx + 3 <= cap) {
+                memcpy(&out[idx], in.levels, 3);
+                idx += 3;
+                sent |= LEVELS;
+            }
+        }
+        if ((contents & SPECTRUM) && n > 0) {
+            const size_t mapBytes = key ? 0 : (size_t)(n + 7) / 8;
+            uint8_t map[TelemetryInput::MAX_BANDS / 8] = {};
+            int count = 0;
+            for (int i = 0; i < n; i++) {
+                if (key || q[i] != m_baseQ[i]) {
+                    map[i >> 3] |= (uint8_t)(1u << (i & 7));
+                    count++;
+                }
+            }
+            const size_t need = 1 + mapBytes + (size_t)(count + 1) / 2;
+            if (idx + need <= cap) {
+                out[idx++] = (uint8_t)n;
+                memcpy(&out[idx], map, mapBytes);
+                idx += mapBytes;
+                int k = 0;
+                for (int i = 0; i < n; i++) {
+                    if (!(map[i >> 3] & (1u << (i & 7)))) continue;
+                    if ((k & 1) == 0) out[idx] = q[i];
+                    else out[idx++] |= (uint8_t)(q[i] << 4);
+                    k++;
+                }
+                if (k & 1) idx++;
+                sent |= SPECTRUM;
+            }
+        }
+        if ((contents & LIMITER) && idx + 2 <= cap) {
+            idx = put16(out, idx, in.grTenthDb);
+            sent |= LIMITER;
+        }
+        if ((contents & QUEUE) && idx + 3 <= cap) {
+            out[idx++] = in.queuePct;
+            idx = put16(out, idx, in.bufferedMs);
+            sent |= QUEUE;
+        }
+        if ((contents & CODEC) && idx + 5 <= cap) {
+            out[idx++] = in.codec;
+            idx = put16(out, idx, in.drops);
+            idx = put16(out, idx, in.shortWrites);
+            sent |= CODEC;
+        }
+        if ((contents & LINK) && idx + 9 <= cap) {
+            out[idx++] = (uint8_t)in.rssi;
+            out[idx++] = in.linkQuality;
+            out[idx++] = in.rfLevel;
+            out[idx++] = in.queuedPackets;
+            idx = put16(out, idx, in.rfGlitches);
+            idx = put16(out, idx, in.cpuGlitches);
+            out[idx++] = in.glitchCause;
+            sent |= LINK;
+        }
+
+        out[0] = seq;
+        out[1] = key ? seq : m_baseSeq;
+        out[2] = sent;
+
+        // A key frame resets the base only once it is known to be out;
+        // a spectrum left out of the frame does not move it either
+        if (sent & SPECTRUM) {
+            memcpy(m_pendingQ, q, (size_t)n);
+            m_pendingBands = (uint8_t)n;
+        } else {
+            memcpy(m_pendingQ, m_baseQ, sizeof(m_pendingQ));
+            m_pendingBands = m_baseBands;
+        }
+        m_pendingSeq = seq;
+        m_pending = true;
+        if (sent & SPECTRUM) m_sinceKey = key ? 0 : m_sinceKey + 1;
+        return idx;
+    }
+
+private:
+    static uint8_t quantize(float lin) {
+        if (lin <= 0.001f) return 0;                    // Below -60 dB
+        const float db = 20.0f * log10f(lin);
+        const int v = (int)((db + 60.0f) * 0.25f + 0.5f);
+        return (uint8_t)(v < 0 ? 0 : (v > 15 ? 15 : v));
+    }
+
+    static size_t put16(uint8_t* out, size_t idx, uint16_t v) {
+        out[idx++] = (uint8_t)v;
+        out[idx++] = (uint8_t)(v >> 8);
+        return idx;
+    }
+
+    uint8_t m_seq = 0;
+    uint8_t m_sinceKey = 0;
+    bool m_haveBase = false;
+    uint8_t m_baseSeq = 0;
+    uint8_t m_baseBands = 0;
+    uint8_t m_baseQ[TelemetryInput::MAX_BANDS] = {};
+    bool m_pending = false;
+    uint8_t m_pendingSeq = 0;
+    uint8_t m_pendingBands = 0;
+    uint8_t m_pendingQ[TelemetryInput::MAX_BANDS] = {};
+};
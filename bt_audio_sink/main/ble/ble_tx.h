@@ -0,0 +1,345 @@
+#pragma once
+
+// -----------------------------------------------------------
+// BLE TX Scheduler - one task sends every notification
+// - Messages (acks, errors, OTA/sound flow control, reports) are
+//   queued in order and never dropped while connected
+// - State (EQ, control, name, FW, LED, sound status, progress) is
+//   one slot per kind: a newer value replaces a pending one and keeps
+//   its place in line, so a burst of encoder steps is one notify
+// - Meter levels go last, newest only, when nothing else waits
+// - With batching on (client opt-in) messages in line share one PDU
+//   up to the MTU: [BATCH, {len, resp_id, payload...}...], len
+//   counting resp_id and payload
+// - Congestion (ESP_GATTS_CONGEST_EVT, or a send the stack refused)
+//   holds the queue until it clears; only a disconnect drops it
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_gatts_api.h"
+#include "esp_log.h"
+#include "../config/app_config.h"
+#include "../core/static_alloc.h"
+
+class BleTxScheduler {
+public:
+    BleTxScheduler() : m_lock(xSemaphoreCreateMutexStatic(&m_lockBuf)) {}
+
+    // TX task on the control core; batchResp is the BATCH response id
+    void start(uint8_t batchResp) {
+        m_batchResp = batchResp;
+        if (m_task) return;
+        StaticAlloc::createTask(taskEntry, "ble_tx", 3072, this, 4, &m_task, APP_CONTROL_CORE);
+    }
+
+    void connect(esp_gatt_if_t gattsIf, uint16_t connId, uint16_t statusHandle, uint16_t meterHandle) {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        clearLocked();
+        m_gattsIf = gattsIf;
+        m_connId = connId;
+        m_statusHandle = statusHandle;
+        m_meterHandle = meterHandle;
+        m_mtu = 23;
+        m_batching = false;
+        m_congested = false;
+        m_connected = true;
+        xSemaphoreGive(m_lock);
+    }
+
+    void disconnect() {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        m_connected = false;
+        clearLocked();
+        xSemaphoreGive(m_lock);
+    }
+
+    void setMtu(uint16_t mtu) { m_mtu = mtu; }
+    void setBatching(bool on) { m_batching = on; }
+
+    // From ESP_GATTS_CONGEST_EVT
+    void setCongested(bool congested) {
+        m_congested = congested;
+        if (!congested) kick();
+    }
+
+    // In order, kept until sent
+    void postMessage(uint8_t resp, const uint8_t* data, size_t len) {
+        if (len > MAX_PAYLOAD) len = MAX_PAYLOAD;
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        if (m_connected && !fifoPush(m_seq, resp, data, len)) {
+            ESP_LOGW(TAG, "TX queue full, 0x%02X dropped", resp);
+        }
+        m_seq++;
+        xSemaphoreGive(m_lock);
+        kick();
+    }
+
+    // Newest value of its kind; falls back to postMessage for a kind
+    // without a slot
+    void postState(uint8_t resp, const uint8_t* data, size_t len) {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        StateSlot* slot = nullptr;
+        for (int i = 0; i < STATE_SLOTS; i++) {
+            if (m_state[i].resp == resp || (!slot && m_state[i].resp == 0)) slot = &m_state[i];
+            if (m_state[i].resp == resp) break;
+        }
+        if (!slot || len > sizeof(slot->data)) {
+            xSemaphoreGive(m_lock);
+            postMessage(resp, data, len);
+            return;
+        }
+        if (m_connected) {
+            slot->resp = resp;
+            slot->len = (uint8_t)len;
+            if (len) memcpy(slot->data, data, len);
+            if (!slot->pending) slot->seq = m_seq++;
+            slot->pending = true;
+        }
+        xSemaphoreGive(m_lock);
+        kick();
+    }
+
+    // Meter characteristic, newest only; false from meterPending() once
+    // the last posted value has gone out
+    bool meterPending() const { return m_meterPending; }
+
+    void postMeter(const uint8_t* data, size_t len) {
+        if (len > sizeof(m_meter)) len = sizeof(m_meter);
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        memcpy(m_meter, data, len);
+        m_meterLen = (uint8_t)len;
+        m_meterPending = m_connected;
+        xSemaphoreGive(m_lock);
+        kick();
+    }
+
+private:
+    static constexpr const char* TAG = "BLE_TX";
+    static constexpr size_t MAX_PAYLOAD = 255;
+    static constexpr size_t FIFO_BYTES = 2048;
+    static constexpr size_t HDR = 6;            // seq u32, len u16 (resp + payload)
+    static constexpr int STATE_SLOTS = 8;
+    static constexpr uint32_t RETRY_MS = 20;    // Send refused: try again after
+    static constexpr int MAX_BATCH = 24;
+
+    struct StateSlot {
+        uint8_t resp = 0;           // 0 = unused slot
+        uint8_t len = 0;
+        bool pending = false;
+        uint32_t seq = 0;
+        uint8_t data[64];
+    };
+
+    void kick() {
+        if (m_task) xTaskNotifyGive(m_task);
+    }
+
+    static void taskEntry(void* arg) {
+        BleTxScheduler* self = static_cast<BleTxScheduler*>(arg);
+        for (;;) {
+            const TickType_t wait = self->m_retry ? pdMS_TO_TICKS(RETRY_MS) : portMAX_DELAY;
+            ulTaskNotifyTake(pdTRUE, wait);
+            self->m_retry = false;
+            while (self->sendNext()) {}
+        }
+    }
+
+    // One PDU; false when there is nothing (more) to send now
+    bool sendNext() {
+        if (m_congested) return false;
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        if (!m_connected) {
+            xSemaphoreGive(m_lock);
+            return false;
+        }
+
+        // Pick messages in line (lowest seq first) while they fit
+        const size_t cap = m_mtu > 3 ? m_mtu - 3 : 20;
+        size_t fifoPos = m_head;
+        int fifoLeft = m_fifoCount;
+        int fifoTaken = 0;
+        uint8_t slotsTaken = 0;
+        int n = 0;
+        size_t pduLen = 0;
+        const uint8_t* single = nullptr;
+        size_t singleLen = 0;
+
+        while (n < MAX_BATCH) {
+            const uint8_t* item = nullptr;
+            size_t itemLen = 0;
+            uint32_t itemSeq = 0;
+            int slot = -1;
+            if (fifoLeft > 0) {
+                const uint8_t* e = m_fifo + fifoPos;
+                memcpy(&itemSeq, e, 4);
+                uint16_t l;
+                memcpy(&l, e + 4, 2);
+                item = e + HDR;
+                itemLen = l;
+            }
+            for (int i = 0; i < STATE_SLOTS; i++) {
+                const StateSlot& s = m_state[i];
+                if (!s.pending || (slotsTaken & (1u << i))) continue;
+                if (!item || (int32_t)(s.seq - itemSeq) < 0) {
+                    // resp_id and payload are adjacent in m_stateMsg
+                    m_stateMsg[i][0] = s.resp;
+                    memcpy(&m_stateMsg[i][1], s.data, s.len);
+                    item = m_stateMsg[i];
+                    itemLen = 1 + s.len;
+                    itemSeq = s.seq;
+                    slot = i;
+                }
+            }
+            if (!item) break;
+
+            if (n == 0) {
+                single = item;
+                singleLen = itemLen;
+            } else {
+                if (!m_batching || itemLen > 255 || singleLen > 255) break;
+                if (n == 1) {
+                    // Second message: the first becomes batch entry one
+                    m_pdu[0] = m_batchResp;
+                    m_pdu[1] = (uint8_t)singleLen;
+                    memcpy(&m_pdu[2], single, singleLen);
+                    pduLen = 2 + singleLen;
+                }
+                if (pduLen + 1 + itemLen > cap) break;
+                m_pdu[pduLen++] = (uint8_t)itemLen;
+                memcpy(&m_pdu[pduLen], item, itemLen);
+                pduLen += itemLen;
+            }
+            n++;
+            if (slot >= 0) {
+                slotsTaken |= (uint8_t)(1u << slot);
+            } else {
+                fifoPos = fifoNext(fifoPos);
+                fifoLeft--;
+                fifoTaken++;
+            }
+            if (!m_batching) break;
+        }
+
+        bool meter = false;
+        if (n == 0) {
+            if (!m_meterPending) {
+                xSemaphoreGive(m_lock);
+                return false;
+            }
+            meter = true;
+        }
+
+        esp_err_t err;
+        if (meter) {
+            err = esp_ble_gatts_send_indicate(m_gattsIf, m_connId, m_meterHandle, m_meterLen, m_meter, false);
+        } else if (n == 1) {
+            err = esp_ble_gatts_send_indicate(m_gattsIf, m_connId, m_statusHandle, singleLen, (uint8_t*)single, false);
+        } else {
+            err = esp_ble_gatts_send_indicate(m_gattsIf, m_connId, m_statusHandle, pduLen, m_pdu, false);
+        }
+
+        if (err != ESP_OK) {
+            // Stack queue full: everything stays queued
+            xSemaphoreGive(m_lock);
+            ESP_LOGD(TAG, "Send refused (%s), retrying", esp_err_to_name(err));
+            m_retry = true;
+            return false;
+        }
+
+        if (meter) {
+            m_meterPending = false;
+        } else {
+            for (int i = 0; i < fifoTaken; i++) fifoPop();
+            for (int i = 0; i < STATE_SLOTS; i++) {
+                if (slotsTaken & (1u << i)) m_state[i].pending = false;
+            }
+        }
+        xSemaphoreGive(m_lock);
+        return true;
+    }
+
+    // Byte ring of [seq, len, resp, payload] entries that never wrap:
+    // an entry that does not fit before the end starts at 0 and
+    // m_wrapAt marks where the data before it ends
+    bool fifoPush(uint32_t seq, uint8_t resp, const uint8_t* data, size_t len) {
+        const size_t need = HDR + 1 + len;
+        if (m_fifoCount == 0) {
+            m_head = m_tail = 0;
+            m_wrapAt = FIFO_BYTES;
+        }
+        size_t at = m_tail;
+        if (m_fifoCount > 0 && m_tail <= m_head) {
+            if (m_head - m_tail < need) return false;
+        } else if (FIFO_BYTES - m_tail < need) {
+            if (m_head < need) return false;
+            m_wrapAt = m_tail;
+            at = 0;
+        }
+        const uint16_t l = (uint16_t)(1 + len);
+        memcpy(m_fifo + at, &seq, 4);
+        memcpy(m_fifo + at + 4, &l, 2);
+        m_fifo[at + HDR] = resp;
+        if (len) memcpy(m_fifo + at + HDR + 1, data, len);
+        m_tail = at + need;
+        m_fifoCount++;
+        return true;
+    }
+
+    size_t fifoNext(size_t pos) const {
+        uint16_t l;
+        memcpy(&l, m_fifo + pos + 4, 2);
+        pos += HDR + l;
+        return pos == m_wrapAt ? 0 : pos;
+    }
+
+    void fifoPop() {
+        const size_t next = fifoNext(m_head);
+        if (next == 0) m_wrapAt = FIFO_BYTES;
+        m_head = next;
+        m_fifoCount--;
+    }
+
+    void clearLocked() {
+        m_fifoCount = 0;
+        m_head = m_tail = 0;
+        m_wrapAt = FIFO_BYTES;
+        for (int i = 0; i < STATE_SLOTS; i++) m_state[i].pending = false;
+        m_meterPending = false;
+    }
+
+    StaticSemaphore_t m_lockBuf;
+    SemaphoreHandle_t m_lock;
+    TaskHandle_t m_task = nullptr;
+
+    // Link; written by the GATTS callbacks
+    esp_gatt_if_t m_gattsIf = 0;
+    uint16_t m_connId = 0;
+    uint16_t m_statusHandle = 0;
+    uint16_t m_meterHandle = 0;
+    volatile uint16_t m_mtu = 23;
+    volatile bool m_connected = false;
+    volatile bool m_congested = false;
+    volatile bool m_batching = false;
+    volatile bool m_retry = false;      // TX task only
+    uint8_t m_batchResp = 0;
+
+    // Under m_lock
+    uint32_t m_seq = 0;
+    uint8_t m_fifo[FIFO_BYTES];
+    size_t m_head = 0;
+    size_t m_tail = 0;
+    size_t m_wrapAt = FIFO_BYTES;
+    int m_fifoCount = 0;
+    StateSlot m_state[STATE_SLOTS];
+    uint8_t m_meter[48];            // Level meter or telemetry frame
+    uint8_t m_meterLen = 0;
+    bool m_meterPending = false;
+
+    // TX task only
+    uint8_t m_stateMsg[STATE_SLOTS][1 + 64];
+    uint8_t m_pdu[517];
+};
@@ -19,6 +19,8 @@
 #include "esp_gatt_common_api.h"
 #include "esp_log.h"
 #include "../config/app_config.h"
+#include "ble_tx.h"
+#include "ble_telemetry.h"
 
 // Protocol Command IDs (Phone -> ESP32)
 namespace BleCmd {
@@ -29,19 +31,42 @@ namespace BleCmd {
     constexpr uint8_t SET_LED          = 0x05;  // [effect, bright, speed, r1,g1,b1, r2,g2,b2, gradient] 10 bytes
     constexpr uint8_t SET_LED_EFFECT   = 0x06;  // [effect_id] 1 byte
     constexpr uint8_t SET_LED_BRIGHT   = 0x07;  // [brightness] 1 byte
+    constexpr uint8_t SET_PEQ_BAND     = 0x08;  // [index, flags, freq u16, gain i16 0.1dB, q u16 x100] 8 bytes LE
+    constexpr uint8_t SET_TX_BATCH     = 0x09;  // [0/1] 1 byte - allow BATCH notifications
+    constexpr uint8_t SET_TELEMETRY    = 0x0A;  // [contents, period x10 ms] 2 bytes - METER telemetry frames, contents 0 = level meter
+    constexpr uint8_t SET_DSP_PRESET   = 0x0B;  // [slot, fields, bass, mid, treble, modes, limiter 0.1dB] 7 bytes - store a preset
+    constexpr uint8_t SET_OUTPUT_LAYOUT = 0x0C; // [left, right] 2 bytes - aux port slot roles (0 off, 1 sub, 2-4 zone L/R/mono)
+    constexpr uint8_t SET_LATENCY_PROFILE = 0x0D;  // [profile] 1 byte - 0 balanced, 1 gaming, 2 hi-fi
+    constexpr uint8_t SET_FAST_CONNECT = 0x0E;  // [seconds] 0-1 bytes - fast page scan for a phone about to connect, none/0 = default window
+    constexpr uint8_t SET_DYNAMICS     = 0x0F;  // [preset] 1 byte - multiband dynamics, 0 off, 1 gentle, 2 small, 3 tiny enclosure
     
     constexpr uint8_t SOUND_MUTE       = 0x10;  // [0/1] 1 byte
     constexpr uint8_t SOUND_DELETE     = 0x11;  // [type] 1 byte
-    constexpr uint8_t SOUND_UP_START   = 0x12;  // [type, size_lo, size_mid, size_hi] 4 bytes
-    constexpr uint8_t SOUND_UP_DATA    = 0x13;  // [seq, data...] 1+N bytes
+    constexpr uint8_t SOUND_UP_START   = 0x12;  // [type, size_lo, size_mid, size_hi, (flags)] 4-5 bytes, type 0x10 = FIR IR, 0x11 = LED animation, flags bit 0 = windowed
+    constexpr uint8_t SOUND_UP_DATA    = 0x13;  // [seq, data...] 1+N bytes, windowed [seq u16, data...]
     constexpr uint8_t SOUND_UP_END     = 0x14;  // no payload
+    constexpr uint8_t SET_3D_MODE      = 0x15;  // [mode] 1 byte - 0 off, 1 stage presence, 2 binaural (headphones)
+    constexpr uint8_t SET_DSP_GRAPH    = 0x16;  // [count, node...] 2-8 bytes - float chain stage order, see dsp_graph.h
     
-    constexpr uint8_t OTA_BEGIN        = 0x20;  // [size_lo, size_mid, size_hi, size_hhi] 4 bytes
-    constexpr uint8_t OTA_DATA         = 0x21;  // [seq, data...] 1+N bytes
-    constexpr uint8_t OTA_END          = 0x22;  // no payload
+    constexpr uint8_t OTA_BEGIN        = 0x20;  // [size u32, (flags), (sha256 x32)] 4-37 bytes, flags bit 0 = windowed, bit 1 = resumable (digest follows)
+    constexpr uint8_t OTA_DATA         = 0x21;  // [seq, data...] 1+N bytes; windowed [seq u16, data...] 2+N, write without response
+    constexpr uint8_t OTA_END          = 0x22;  // [(sha256 x32)] 0 or 32 bytes - image digest to verify
     constexpr uint8_t OTA_ABORT        = 0x23;  // no payload
     
     constexpr uint8_t REQUEST_STATUS   = 0xF0;  // no payload - request full sync
+    constexpr uint8_t REQUEST_TRACE    = 0xF1;  // [reset] 0-1 bytes - perf trace summary
+    constexpr uint8_t REQUEST_LIMITER  = 0xF2;  // [reset] 0-1 bytes - limiter gain reduction
+    constexpr uint8_t REQUEST_PEQ      = 0xF3;  // no payload - parametric EQ bands and load
+    constexpr uint8_t REQUEST_LED_PROFILE = 0xF4;  // [reset] 0-1 bytes - LED frame cost per effect
+    constexpr uint8_t REQUEST_SNAPSHOT = 0xF5;  // no payload - STATUS_SNAPSHOT notification(s)
+    constexpr uint8_t REQUEST_TASKS    = 0xF6;  // [follow] 0-1 bytes - task/heap diagnostics, follow 1 = after every sample
+    constexpr uint8_t REQUEST_GLITCHES = 0xF7;  // [clear] 0-1 bytes - STATUS_GLITCHES notification(s), clear 1 = empty the journal after
+    constexpr uint8_t REQUEST_DEADLINE = 0xF8;  // [reset] 0-1 bytes - block deadline misses per DSP mode
+    constexpr uint8_t REQUEST_PROFILE  = 0xF9;  // no payload - latency profile and estimated latency
+    constexpr uint8_t REQUEST_CAPTURE  = 0xFA;  // [op, ...] PCM capture: 0 status, 1 freeze, 2 re-arm, 3 read [offset u32, count] - STATUS_CAPTURE
+    constexpr uint8_t REQUEST_BULK     = 0xFB;  // no payload - STATUS_BULK, the L2CAP bulk channel to open for transfers
+    constexpr uint8_t REQUEST_DSP_GRAPH = 0xFC; // no payload - STATUS_DSP_GRAPH
+    constexpr uint8_t REQUEST_FLEET_REPORT = 0xFD;  // no payload - ack, then reboot via recovery to upload the fleet report (fleet_report.h)
     constexpr uint8_t PING             = 0xFF;  // no payload
 }
 
@@ -53,24 +78,72 @@ namespace BleResp {
     constexpr uint8_t STATUS_FW        = 0x04;  // [version...] string
     constexpr uint8_t STATUS_LED       = 0x05;  // [effect, bright, speed, r1,g1,b1, r2,g2,b2, gradient] 10 bytes
     constexpr uint8_t STATUS_SOUND     = 0x06;  // [status_byte] 1 byte
+    constexpr uint8_t STATUS_TRACE     = 0x07;  // [mhz_lo, mhz_hi, codec, {id, count, min, avg, p99, max}...] u32 LE, id 0x80 = media packets (perf_trace.h)
+    constexpr uint8_t STATUS_LIMITER   = 0x08;  // [gr_now, gr_max, active_permille] u16 LE, gr in 0.1 dB
+    constexpr uint8_t STATUS_PEQ       = 0x09;  // [active, cyc_block u32, cyc_frame, cyc_frame_max, budget u16, count, {band 7 bytes}...]
+    constexpr uint8_t STATUS_LED_PROFILE = 0x0A;  // [budget_us u16, n, {id, frames, render avg/p99/max, show avg/max, overruns u16, quality}...]
+    constexpr uint8_t STATUS_TASKS     = 0x0B;  // [version, interval_s, total, n, heaps, {core, prio, cpu u16, stack u16, name_len, name}...] see task_diagnostics.h
+    constexpr uint8_t STATUS_GLITCHES  = 0x0C;  // [frag, {entry 16 bytes}...] oldest first, frag = index | 0x80 on the last, see glitch_journal.h
+    constexpr uint8_t STATUS_DEADLINE  = 0x0D;  // [shed, budget_pct, peak_permille u16, n, {mode, blocks u32, misses u32}...] see deadline_monitor.h
+    constexpr uint8_t STATUS_PROFILE   = 0x0E;  // [profile, est, measured, jitter_target, dma, limiter] u16 LE in 0.1 ms, measured 0 = none
+    constexpr uint8_t STATUS_CAPTURE   = 0x0F;  // [0, state, reason, image_bytes u32, span_ms u32] or [3, offset u32, image bytes...] see pcm_capture.h
     
     constexpr uint8_t ACK_OK           = 0x10;  // [cmd] 1 byte
     constexpr uint8_t ACK_ERROR        = 0x11;  // [cmd, error_code] 2 bytes
+    constexpr uint8_t STATUS_BULK      = 0x12;  // [state, psm u16, sdu u16] state 0 off, 1 listening, 2 open, see ble_bulk.h
+    constexpr uint8_t STATUS_DSP_GRAPH = 0x13;  // [count, node...] the stage order running
     
     constexpr uint8_t OTA_PROGRESS     = 0x20;  // [percent] 1 byte
-    constexpr uint8_t OTA_READY        = 0x21;  // no payload - ready for next chunk
+    constexpr uint8_t OTA_READY        = 0x21;  // no payload - ready for next chunk; after a resumable BEGIN [offset u32], send the image from there
     constexpr uint8_t OTA_COMPLETE     = 0x22;  // no payload
     constexpr uint8_t OTA_FAILED       = 0x23;  // [error_code] 1 byte
+    constexpr uint8_t OTA_ACK          = 0x24;  // [next_seq u16, window] 3 bytes - windowed OTA, resend from next_seq
     
     constexpr uint8_t SOUND_PROGRESS   = 0x30;  // [percent] 1 byte
     constexpr uint8_t SOUND_READY      = 0x31;  // no payload - ready for next chunk
     constexpr uint8_t SOUND_COMPLETE   = 0x32;  // no payload
     constexpr uint8_t SOUND_FAILED     = 0x33;  // [error_code] 1 byte
+    constexpr uint8_t SOUND_ACK        = 0x34;  // [next_seq u16, window] 3 bytes - windowed upload, resend from next_seq
     
     constexpr uint8_t FULL_STATUS      = 0xF0;  // full status dump
+    constexpr uint8_t BATCH            = 0xF1;  // {len, resp_id, payload...}... after SET_TX_BATCH 1
+    constexpr uint8_t STATUS_SNAPSHOT  = 0xF2;  // [frag, snapshot part...] frag = index | 0x80 on the last
     constexpr uint8_t PONG             = 0xFF;  // ping response
 }
 
+// Status snapshot: [version, {tag, len, value...}...], the value of the
+// STATUS characteristic (read / read blob) and of STATUS_SNAPSHOT.
+// Tags are the STATUS_* response ids with the same payload; items
+// without one start at 0x80. Unknown tags are skipped by length.
+namespace BleSnapshot {
+    constexpr uint8_t VERSION          = 1;
+    constexpr uint8_t TAG_LATENCY      = 0x80;  // [codec, count u16, min, avg, p99, max u16 in 0.1 ms]
+    constexpr size_t  MAX_BYTES        = 200;
+}
+
+// 128-bit UUID from its string form, little endian as GATT sends it;
+// constexpr, so the attribute table's UUIDs are built by the compiler
+struct BleUuid128 {
+    uint8_t bytes[16];
+};
+
+constexpr BleUuid128 bleUuid128(const char* str) {
+    BleUuid128 u = {};
+    int nibble = 0;
+    for (int i = 0; str[i] && nibble < 32; i++) {
+        const char c = str[i];
+        int val = 0;
+        if (c >= '0' && c <= '9') val = c - '0';
+        else if (c >= 'a' && c <= 'f') val = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') val = c - 'A' + 10;
+        else continue;      // Dashes
+        uint8_t& b = u.bytes[15 - (nibble >> 1)];
+        b = (uint8_t)((nibble & 1) ? (b | val) : (val << 4));
+        nibble++;
+    }
+    return u;
+}
+
 // Error codes
 namespace BleError {
     constexpr uint8_t NONE             = 0x00;
@@ -102,6 +175,31 @@ public:
     using SoundDeleteCallback = void(*)(uint8_t soundType);
     using SoundDataCallback = void(*)(uint8_t cmd, const uint8_t* data, size_t len);
     using OtaCallback = void(*)(uint8_t cmd, const uint8_t* data, size_t len);
+    using TraceCallback = void(*)(bool reset);
+    using LimiterCallback = void(*)(bool reset);
+    using PeqBandCallback = bool(*)(uint8_t index, const uint8_t* band, size_t len);
+    using PeqStatusCallback = size_t(*)(uint8_t* out, size_t cap);
+    using PresetCallback = bool(*)(uint8_t slot, const uint8_t* preset, size_t len);
+    using LatencyCallback = size_t(*)(uint8_t* out, size_t cap);
+    using LedProfileCallback = size_t(*)(uint8_t* out, size_t cap, bool reset);
+    using OutputLayoutCallback = bool(*)(uint8_t left, uint8_t right);
+    using TaskReportCallback = size_t(*)(uint8_t* out, size_t cap);
+    using GlitchReadCallback = size_t(*)(uint32_t& seq, uint8_t* out, size_t cap);
+    using GlitchClearCallback = void(*)();
+    using DeadlineCallback = size_t(*)(uint8_t* out, size_t cap, bool reset);
+    using ProfileSetCallback = bool(*)(uint8_t profile);
+    using ProfileStatusCallback = size_t(*)(uint8_t* out, size_t cap);
+    using FastConnectCallback = void(*)(uint8_t seconds);
+    using DynamicsCallback = bool(*)(uint8_t preset);
+    using Sound3DModeCallback = bool(*)(uint8_t mode);
+    using CaptureStatusCallback = size_t(*)(uint8_t* out, size_t cap);
+    using CaptureControlCallback = void(*)(bool freeze);
+    using CaptureReadCallback = size_t(*)(uint32_t offset, uint8_t* out, size_t cap);
+    using BulkStatusCallback = size_t(*)(uint8_t* out, size_t cap);
+    using CaptureBulkCallback = bool(*)(uint32_t offset, uint8_t count);
+    using DspGraphCallback = bool(*)(const uint8_t* graph, size_t len);
+    using DspGraphStatusCallback = size_t(*)(uint8_t* out, size_t cap);
+    using FleetReportCallback = void(*)();
 
     BleUnifiedService()
         : m_gattsIf(0)
@@ -126,12 +224,32 @@ public:
         , m_soundDeleteCb(nullptr)
         , m_soundDataCb(nullptr)
         , m_otaCb(nullptr)
+        , m_traceCb(nullptr)
+        , m_limiterCb(nullptr)
+        , m_peqBandCb(nullptr)
+        , m_peqStatusCb(nullptr)
+        , m_presetCb(nullptr)
+        , m_latencyCb(nullptr)
+        , m_ledProfileCb(nullptr)
+        , m_outputLayoutCb(nullptr)
+        , m_taskReportCb(nullptr)
+        , m_glitchReadCb(nullptr)
+        , m_glitchClearCb(nullptr)
+        , m_deadlineCb(nullptr)
+        , m_profileSetCb(nullptr)
+        , m_profileStatusCb(nullptr)
+        , m_fastConnectCb(nullptr)
+        , m_dynamicsCb(nullptr)
+        , m_sound3DModeCb(nullptr)
+        , m_captureStatusCb(nullptr)
+        , m_captureControlCb(nullptr)
+        , m_captureReadCb(nullptr)
+        , m_bulkStatusCb(nullptr)
+        , m_captureBulkCb(nullptr)
+        , m_dspGraphCb(nullptr)
+        , m_dspGraphStatusCb(nullptr)
+        , m_fleetReportCb(nullptr)
     {
-        memset(m_uuidService, 0, 16);
-        memset(m_uuidCmdChar, 0, 16);
-        memset(m_uuidStatusChar, 0, 16);
-        memset(m_uuidMeterChar, 0, 16);
-        
         // Initialize state
         memset(m_eqValue, 0, sizeof(m_eqValue));
         m_controlValue = 0;
@@ -170,6 +288,65 @@ public:
         m_otaCb = otaCb;
     }
 
+    // Optional: perf trace requests are rejected as unknown without it
+    void setTraceCallback(TraceCallback traceCb) { m_traceCb = traceCb; }
+    // Optional: limiter requests are rejected as unknown without it
+    void setLimiterCallback(LimiterCallback limiterCb) { m_limiterCb = limiterCb; }
+    // Optional: parametric EQ commands are rejected as unknown without them
+    void setPeqCallbacks(PeqBandCallback bandCb, PeqStatusCallback statusCb) {
+        m_peqBandCb = bandCb;
+        m_peqStatusCb = statusCb;
+    }
+    // Optional: preset stores are rejected as unknown without it
+    void setPresetCallback(PresetCallback presetCb) { m_presetCb = presetCb; }
+    // Optional: latency summary appended to the full status
+    void setLatencyCallback(LatencyCallback latencyCb) { m_latencyCb = latencyCb; }
+    // Optional: LED profile requests are rejected as unknown without it
+    void setLedProfileCallback(LedProfileCallback ledProfileCb) { m_ledProfileCb = ledProfileCb; }
+    // Optional: output layout commands are rejected as unknown without it
+    void setOutputLayoutCallback(OutputLayoutCallback layoutCb) { m_outputLayoutCb = layoutCb; }
+    // Optional: task diagnostics requests are rejected as unknown without it
+    void setTaskReportCallback(TaskReportCallback taskReportCb) { m_taskReportCb = taskReportCb; }
+    // Optional: glitch journal requests are rejected as unknown without them
+    void setGlitchCallbacks(GlitchReadCallback readCb, GlitchClearCallback clearCb) {
+        m_glitchReadCb = readCb;
+        m_glitchClearCb = clearCb;
+    }
+    // Optional: deadline requests are rejected as unknown without it
+    void setDeadlineCallback(DeadlineCallback deadlineCb) { m_deadlineCb = deadlineCb; }
+    // Optional: latency profile commands are rejected as unknown without them
+    void setProfileCallbacks(ProfileSetCallback setCb, ProfileStatusCallback statusCb) {
+        m_profileSetCb = setCb;
+        m_profileStatusCb = statusCb;
+    }
+    // Optional: fast connect is rejected as unknown without it
+    void setFastConnectCallback(FastConnectCallback fastConnectCb) { m_fastConnectCb = fastConnectCb; }
+    // Optional: dynamics presets are rejected as unknown without it
+    void setDynamicsCallback(DynamicsCallback dynamicsCb) { m_dynamicsCb = dynamicsCb; }
+    // Optional: 3D modes are rejected as unknown without it
+    void setSound3DModeCallback(Sound3DModeCallback sound3DModeCb) { m_sound3DModeCb = sound3DModeCb; }
+    // Optional: PCM capture requests are rejected as unknown without them
+    void setCaptureCallbacks(CaptureStatusCallback statusCb, CaptureControlCallback controlCb,
+                             CaptureReadCallback readCb) {
+        m_captureStatusCb = statusCb;
+        m_captureControlCb = controlCb;
+        m_captureReadCb = readCb;
+    }
+    // Optional: bulk channel requests are rejected as unknown without the
+    // status; capture reads go over the channel while captureCb takes them
+    void setBulkCallbacks(BulkStatusCallback statusCb, CaptureBulkCallback captureCb) {
+        m_bulkStatusCb = statusCb;
+        m_captureBulkCb = captureCb;
+    }
+    // Optional: stage order commands are rejected as unknown without them
+    void setDspGraphCallbacks(DspGraphCallback setCb, DspGraphStatusCallback statusCb) {
+        m_dspGraphCb = setCb;
+        m_dspGraphStatusCb = statusCb;
+    }
+    // Optional: fleet report requests are rejected as unknown without it;
+    // the callback must return at once (the upload reboots)
+    void setFleetReportCallback(FleetReportCallback fleetReportCb) { m_fleetReportCb = fleetReportCb; }
+
     bool init(const char* deviceName, const char* fwVersion,
               uint8_t controlByte, int8_t bassDb, int8_t midDb, int8_t trebleDb,
               uint8_t ledEffect = 0, uint8_t brightness = 128) {
@@ -190,12 +367,6 @@ public:
         m_ledValue[0] = brightness;  // brightness at index 0
         m_ledValue[9] = ledEffect;   // effectId at index 9
 
-        // Parse UUIDs - New unified UUIDs
-        uuid128FromString(BLE_UNIFIED_SERVICE_UUID, m_uuidService);
-        uuid128FromString(BLE_UNIFIED_CHAR_CMD, m_uuidCmdChar);
-        uuid128FromString(BLE_UNIFIED_CHAR_STATUS, m_uuidStatusChar);
-        uuid128FromString(BLE_UNIFIED_CHAR_METER, m_uuidMeterChar);
-
         // Init Bluetooth controller
         esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
         ESP_ERROR_CHECK(esp_bt_controller_init(&bt_cfg));
@@ -215,6 +386,7 @@ public:
         ESP_ERROR_CHECK(esp_ble_gap_register_callback(gapEventHandler));
         ESP_ERROR_CHECK(esp_ble_gatts_register_callback(gattsEventHandler));
         ESP_ERROR_CHECK(esp_ble_gatts_app_register(0));
+        m_tx.start(BleResp::BATCH);
 
         ESP_LOGI(TAG, "BLE Unified GATT initialized");
         return true;
@@ -222,42 +394,71 @@ public:
 
     bool isConnected() const { return m_connected; }
 
+    // Connection parameters follow what the radio is shared with:
+    // every BLE connection event takes air time from the A2DP stream.
+    // Called on A2DP audio state and OTA / sound upload changes.
+    void setLinkDemand(bool audioStreaming, bool bulkTransfer) {
+        m_linkMode = bulkTransfer ? LINK_TRANSFER : (audioStreaming ? LINK_STREAMING : LINK_IDLE);
+        requestLinkParams();
+    }
+
     // ========== Update state and notify ==========
+    // Queued for the TX task (BleTxScheduler): state updates replace a
+    // pending one of the same kind, so callers may update freely
     
     void updateLevels(uint8_t l30, uint8_t l60, uint8_t l100) {
         if (m_connected && m_meterCharHandle && m_gattsIf) {
             uint8_t data[3] = { l30, l60, l100 };
-            esp_err_t err = esp_ble_gatts_send_indicate(m_gattsIf, m_connId, m_meterCharHandle, 3, data, false);
-            if (err != ESP_OK) {
-                // Connection likely dead, mark as disconnected
-                ESP_LOGW(TAG, "Meter notify failed: %s - marking disconnected", esp_err_to_name(err));
-                m_connected = false;
-            }
+            m_tx.postMeter(data, 3);
+        }
+    }
+
+    // Telemetry (ble_telemetry.h) the client asked for, 0 = level meter
+    uint8_t telemetryContents() const { return m_telemetryContents & m_telemetryAvailable; }
+    void setTelemetryAvailable(uint8_t contents) { m_telemetryAvailable = contents; }
+
+    // Frame period: as asked, but no faster than the connection interval
+    // while A2DP streams
+    uint32_t telemetryPeriodMs(bool audioStreaming) const {
+        uint32_t ms = m_telemetryPeriodMs;
+        if (audioStreaming && ms < APP_TELEMETRY_STREAMING_MS) ms = APP_TELEMETRY_STREAMING_MS;
+        return ms;
+    }
+
+    void updateTelemetry(const TelemetryInput& in) {
+        if (!m_connected || !m_meterCharHandle || !m_gattsIf) return;
+        if (m_telemetryReset) {
+            m_telemetryReset = false;
+            m_telemetry.reset();
         }
+        uint8_t frame[BleTelemetry::MAX_FRAME];
+        const size_t cap = m_mtu > 3 ? m_mtu - 3 : 20;
+        const size_t len = m_telemetry.encode(in, telemetryContents(), !m_tx.meterPending(), frame, cap);
+        if (len > 0) m_tx.postMeter(frame, len);
     }
 
     void updateEq(int8_t bass, int8_t mid, int8_t treble) {
         m_eqValue[0] = bass;
         m_eqValue[1] = mid;
         m_eqValue[2] = treble;
-        notifyStatus(BleResp::STATUS_EQ, (uint8_t*)m_eqValue, 3);
+        notifyState(BleResp::STATUS_EQ, (uint8_t*)m_eqValue, 3);
     }
 
     void updateControl(uint8_t controlByte) {
         m_controlValue = controlByte;
-        notifyStatus(BleResp::STATUS_CONTROL, &m_controlValue, 1);
+        notifyState(BleResp::STATUS_CONTROL, &m_controlValue, 1);
     }
 
     void updateName(const char* name) {
         strncpy(m_nameValue, name, sizeof(m_nameValue) - 1);
         m_nameValue[sizeof(m_nameValue) - 1] = '\0';
-        notifyStatus(BleResp::STATUS_NAME, (uint8_t*)m_nameValue, strlen(m_nameValue));
+        notifyState(BleResp::STATUS_NAME, (uint8_t*)m_nameValue, strlen(m_nameValue));
     }
 
     void updateFw(const char* fw) {
         strncpy(m_fwValue, fw, sizeof(m_fwValue) - 1);
         m_fwValue[sizeof(m_fwValue) - 1] = '\0';
-        notifyStatus(BleResp::STATUS_FW, (uint8_t*)m_fwValue, strlen(m_fwValue));
+        notifyState(BleResp::STATUS_FW, (uint8_t*)m_fwValue, strlen(m_fwValue));
     }
 
     // Fast brightness conversion: 0-255 -> 0-100 using multiply+shift (no division)
@@ -286,7 +487,7 @@ public:
         unified[8] = m_ledValue[6];  // b2
         unified[9] = m_ledValue[7];  // gradient
         
-        notifyStatus(BleResp::STATUS_LED, unified, 10);
+        notifyState(BleResp::STATUS_LED, unified, 10);
     }
 
     void updateLedEffect(uint8_t effectId) {
@@ -305,7 +506,7 @@ public:
         unified[8] = m_ledValue[6];  // b2
         unified[9] = m_ledValue[7];  // gradient
         
-        notifyStatus(BleResp::STATUS_LED, unified, 10);
+        notifyState(BleResp::STATUS_LED, unified, 10);
     }
 
     void updateLedBrightness(uint8_t brightness) {
@@ -324,13 +525,13 @@ public:
         unified[8] = m_ledValue[6];  // b2
         unified[9] = m_ledValue[7];  // gradient
         
-        notifyStatus(BleResp::STATUS_LED, unified, 10);
+        notifyState(BleResp::STATUS_LED, unified, 10);
     }
 
     void updateSoundStatus(uint8_t status) {
         ESP_LOGI(TAG, "updateSoundStatus: status=0x%02X, connected=%d", status, m_connected);
         m_soundStatus = status;
-        notifyStatus(BleResp::STATUS_SOUND, &m_soundStatus, 1);
+        notifyState(BleResp::STATUS_SOUND, &m_soundStatus, 1);
     }
 
     // ========== Response helpers ==========
@@ -345,13 +546,20 @@ public:
     }
 
     void sendOtaProgress(uint8_t percent) {
-        notifyStatus(BleResp::OTA_PROGRESS, &percent, 1);
+        notifyState(BleResp::OTA_PROGRESS, &percent, 1);
     }
 
     void sendOtaReady() {
         notifyStatus(BleResp::OTA_READY, nullptr, 0);
     }
 
+    // Resumable OTA: the image offset to send from (0 = from the start)
+    void sendOtaReady(uint32_t offset) {
+        const uint8_t data[4] = { (uint8_t)offset, (uint8_t)(offset >> 8),
+                                  (uint8_t)(offset >> 16), (uint8_t)(offset >> 24) };
+        notifyStatus(BleResp::OTA_READY, data, sizeof(data));
+    }
+
     void sendOtaComplete() {
         notifyStatus(BleResp::OTA_COMPLETE, nullptr, 0);
     }
@@ -360,14 +568,27 @@ public:
         notifyStatus(BleResp::OTA_FAILED, &errorCode, 1);
     }
 
+    // Windowed OTA: chunks before nextSeq are written; the phone may send
+    // up to window chunks from nextSeq on
+    void sendOtaAck(uint16_t nextSeq, uint8_t window) {
+        const uint8_t data[3] = { (uint8_t)nextSeq, (uint8_t)(nextSeq >> 8), window };
+        notifyStatus(BleResp::OTA_ACK, data, sizeof(data));
+    }
+
     void sendSoundProgress(uint8_t percent) {
-        notifyStatus(BleResp::SOUND_PROGRESS, &percent, 1);
+        notifyState(BleResp::SOUND_PROGRESS, &percent, 1);
     }
 
     void sendSoundReady() {
         notifyStatus(BleResp::SOUND_READY, nullptr, 0);
     }
 
+    // Windowed sound upload, as sendOtaAck
+    void sendSoundAck(uint16_t nextSeq, uint8_t window) {
+        const uint8_t data[3] = { (uint8_t)nextSeq, (uint8_t)(nextSeq >> 8), window };
+        notifyStatus(BleResp::SOUND_ACK, data, sizeof(data));
+    }
+
     void sendSoundComplete() {
         notifyStatus(BleResp::SOUND_COMPLETE, nullptr, 0);
     }
@@ -380,12 +601,90 @@ public:
         notifyStatus(BleResp::PONG, nullptr, 0);
     }
 
+    // Needs a negotiated MTU of ~90 bytes; the phone app requests 517
+    void sendTrace(const uint8_t* data, size_t len) {
+        if (len > 255) len = 255;
+        notifyStatus(BleResp::STATUS_TRACE, data, len);
+    }
+
+    void sendLimiter(const uint8_t* data, size_t len) {
+        notifyStatus(BleResp::STATUS_LIMITER, data, len);
+    }
+
+    // Up to ~85 bytes with 10 bands; needs the larger MTU like sendTrace
+    void sendPeqStatus() {
+        if (!m_peqStatusCb) return;
+        uint8_t buf[128];
+        size_t len = m_peqStatusCb(buf, sizeof(buf));
+        if (len > 0) notifyStatus(BleResp::STATUS_PEQ, buf, len);
+    }
+
+    // Up to 15 effects per report; needs the larger MTU like sendTrace
+    void sendLedProfile(bool reset) {
+        if (!m_ledProfileCb) return;
+        uint8_t buf[255];
+        size_t len = m_ledProfileCb(buf, sizeof(buf), reset);
+        if (len > 0) notifyStatus(BleResp::STATUS_LED_PROFILE, buf, len);
+    }
+
+    // Up to 5 + 9 bytes per DSP mode seen; needs the larger MTU like sendTrace
+    void sendDeadline(bool reset) {
+        if (!m_deadlineCb) return;
+        uint8_t buf[255];
+        size_t len = m_deadlineCb(buf, sizeof(buf), reset);
+        if (len > 0) notifyStatus(BleResp::STATUS_DEADLINE, buf, len);
+    }
+
+    // Capture download, pulled by the client: count notifications of
+    // [3, offset u32, image bytes...] from offset on, at most
+    // CAPTURE_WINDOW per request so they fit the TX queue; the last one
+    // may be short, and one past the end is empty
+    void sendCapture(uint32_t offset, uint8_t count) {
+        constexpr uint8_t CAPTURE_WINDOW = 6;
+        const size_t room = (m_mtu > 3 + 1 + 5 + 16) ? m_mtu - 3 - 1 - 5 : 16;     // ATT, resp id, op + offset
+        const size_t part = room < 250 ? room : 250;
+        uint8_t buf[5 + 250];
+        if (count == 0 || count > CAPTURE_WINDOW) count = CAPTURE_WINDOW;
+        for (uint8_t i = 0; i < count; i++) {
+            const size_t n = m_captureReadCb(offset, &buf[5], part);
+            buf[0] = 3;
+            buf[1] = (uint8_t)offset;
+            buf[2] = (uint8_t)(offset >> 8);
+            buf[3] = (uint8_t)(offset >> 16);
+            buf[4] = (uint8_t)(offset >> 24);
+            notifyStatus(BleResp::STATUS_CAPTURE, buf, 5 + n);
+            if (n < part) break;
+            offset += (uint32_t)n;
+        }
+    }
+
+    // 11 bytes, fits the default MTU
+    void sendProfileStatus() {
+        if (!m_profileStatusCb) return;
+        uint8_t buf[16];
+        size_t len = m_profileStatusCb(buf, sizeof(buf));
+        if (len > 0) notifyStatus(BleResp::STATUS_PROFILE, buf, len);
+    }
+
+    // Up to 255 bytes; needs the larger MTU like sendTrace
+    void sendTaskReport() {
+        if (!m_taskReportCb) return;
+        uint8_t buf[255];
+        size_t len = m_taskReportCb(buf, sizeof(buf));
+        if (len > 0) notifyStatus(BleResp::STATUS_TASKS, buf, len);
+    }
+
+    // The client asked for a report after every diagnostics sample
+    bool taskReportFollowed() const { return m_connected && m_taskReportFollow; }
+
     void sendFullStatus() {
         // Build full status packet:
-        // [resp_id, bass, mid, treble, control, led[10], sound, name_len, name..., fw_len, fw...]
+        // [resp_id, bass, mid, treble, control, led[10], sound, name_len, name..., fw_len, fw...,
+        //  lat_len, latency...]
         // LED is sent in unified format: [effect, bright, speed, r1, g1, b1, r2, g2, b2, gradient]
         // Brightness is mapped from 0-255 (ESP32) to 0-100 (phone)
-        uint8_t buffer[64];
+        // Latency (lat_len 0 if not measured): [codec, count u16, min, avg, p99, max u16 in 0.1 ms]
+        uint8_t buffer[sizeof(m_nameValue) + sizeof(m_fwValue) + 48];
         size_t idx = 0;
         
         buffer[idx++] = BleResp::FULL_STATUS;
@@ -427,9 +726,52 @@ public:
         buffer[idx++] = (uint8_t)fwLen;
         memcpy(&buffer[idx], m_fwValue, fwLen);
         idx += fwLen;
+
+        // Latency (length + summary), appended so older parsers can ignore it
+        size_t latLen = m_latencyCb ? m_latencyCb(&buffer[idx + 1], sizeof(buffer) - idx - 1) : 0;
+        buffer[idx++] = (uint8_t)latLen;
+        idx += latLen;
         
-        if (m_connected && m_statusCharHandle && m_gattsIf) {
-            esp_ble_gatts_send_indicate(m_gattsIf, m_connId, m_statusCharHandle, idx, buffer, false);
+        notifyStatus(buffer[0], &buffer[1], idx - 1);
+    }
+
+    // Whole journal entries per notification, as many as the MTU allows;
+    // a lone [0x80] when it is empty. One read ahead, to flag the last.
+    void sendGlitches() {
+        if (!m_glitchReadCb) return;
+        constexpr size_t ENTRY = 16;
+        const size_t room = (m_mtu > 3 + 1 + 1 + ENTRY) ? m_mtu - 3 - 1 - 1 : ENTRY;  // ATT, resp id, frag
+        uint8_t bufs[2][1 + 15 * ENTRY];
+        const size_t cap = (room < sizeof(bufs[0]) - 1 ? room : sizeof(bufs[0]) - 1) / ENTRY * ENTRY;
+        uint32_t seq = 0;
+        uint8_t index = 0;
+        uint8_t* cur = bufs[0];
+        uint8_t* next = bufs[1];
+        size_t len = m_glitchReadCb(seq, &cur[1], cap);
+        for (;;) {
+            const size_t nextLen = len ? m_glitchReadCb(seq, &next[1], cap) : 0;
+            cur[0] = (index++ & 0x7F) | (nextLen == 0 ? 0x80 : 0);
+            notifyStatus(BleResp::STATUS_GLITCHES, cur, 1 + len);
+            if (nextLen == 0) break;
+            uint8_t* done = cur;
+            cur = next;
+            next = done;
+            len = nextLen;
+        }
+    }
+
+    // Snapshot in as few notifications as the MTU allows
+    void sendSnapshot() {
+        uint8_t snap[BleSnapshot::MAX_BYTES];
+        const size_t len = buildSnapshot(snap, sizeof(snap));
+        const size_t part = (m_mtu > 3 + 1 + 8) ? m_mtu - 3 - 1 - 1 : 8;   // ATT, resp id, frag
+        uint8_t frag[1 + BleSnapshot::MAX_BYTES];
+        uint8_t index = 0;
+        for (size_t at = 0; at < len; at += part, index++) {
+            const size_t n = (len - at < part) ? len - at : part;
+            frag[0] = index | ((at + n == len) ? 0x80 : 0);
+            memcpy(&frag[1], &snap[at], n);
+            notifyStatus(BleResp::STATUS_SNAPSHOT, frag, 1 + n);
         }
     }
 
@@ -475,60 +817,147 @@ private:
     static constexpr uint8_t ADV_CONFIG_FLAG = 0x01;
     static constexpr uint8_t SCAN_RSP_CONFIG_FLAG = 0x02;
 
-    void notifyStatus(uint8_t respId, const uint8_t* data, size_t len) {
-        if (!m_connected || !m_statusCharHandle || !m_gattsIf) {
-            ESP_LOGW(TAG, "notifyStatus(0x%02X) failed: connected=%d, handle=%d, gattsIf=%d",
-                     respId, m_connected, m_statusCharHandle, m_gattsIf);
-            return;
-        }
-        
-        uint8_t buffer[256];
-        buffer[0] = respId;
-        if (data && len > 0) {
-            memcpy(&buffer[1], data, len);
+    // GATT database: one primary service, CMD (write), STATUS and METER
+    // (read, notify, with a CCCD each). Built in one call from this
+    // table, always in this order, so a client's cached handles stay
+    // valid from boot to boot.
+    enum : uint8_t {
+        ATTR_SERVICE,
+        ATTR_CMD_DECL, ATTR_CMD_VALUE,
+        ATTR_STATUS_DECL, ATTR_STATUS_VALUE, ATTR_STATUS_CCCD,
+        ATTR_METER_DECL, ATTR_METER_VALUE, ATTR_METER_CCCD,
+        ATTR_COUNT
+    };
+    static constexpr BleUuid128 UUID_SERVICE = bleUuid128(BLE_UNIFIED_SERVICE_UUID);
+    static constexpr BleUuid128 UUID_CMD = bleUuid128(BLE_UNIFIED_CHAR_CMD);
+    static constexpr BleUuid128 UUID_STATUS = bleUuid128(BLE_UNIFIED_CHAR_STATUS);
+    static constexpr BleUuid128 UUID_METER = bleUuid128(BLE_UNIFIED_CHAR_METER);
+    static constexpr uint16_t VALUE_MAX_LEN = 512;
+
+    static const esp_gatts_attr_db_t* gattDb() {
+        static const uint16_t PRIMARY = ESP_GATT_UUID_PRI_SERVICE;
+        static const uint16_t CHAR_DECL = ESP_GATT_UUID_CHAR_DECLARE;
+        static const uint16_t CCCD = ESP_GATT_UUID_CHAR_CLIENT_CONFIG;
+        static const uint8_t PROP_CMD = ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_WRITE_NR;
+        static const uint8_t PROP_NOTIFY = ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_NOTIFY;
+        static const uint8_t CCCD_OFF[2] = { 0, 0 };
+        // The table API takes non-const pointers but only copies from them
+        #define GATT_U8(p) const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(p))
+        static const esp_gatts_attr_db_t TABLE[ATTR_COUNT] = {
+            { { ESP_GATT_AUTO_RSP }, { ESP_UUID_LEN_16, GATT_U8(&PRIMARY), ESP_GATT_PERM_READ,
+                                       16, 16, GATT_U8(UUID_SERVICE.bytes) } },
+            // CMD: written by the client, answered by the app
+            { { ESP_GATT_AUTO_RSP }, { ESP_UUID_LEN_16, GATT_U8(&CHAR_DECL), ESP_GATT_PERM_READ,
+                                       1, 1, GATT_U8(&PROP_CMD) } },
+            { { ESP_GATT_RSP_BY_APP }, { ESP_UUID_LEN_128, GATT_U8(UUID_CMD.bytes), ESP_GATT_PERM_WRITE,
+                                         VALUE_MAX_LEN, 0, nullptr } },
+            // STATUS: reads give the snapshot (handleReadEvent)
+            { { ESP_GATT_AUTO_RSP }, { ESP_UUID_LEN_16, GATT_U8(&CHAR_DECL), ESP_GATT_PERM_READ,
+                                       1, 1, GATT_U8(&PROP_NOTIFY) } },
+            { { ESP_GATT_RSP_BY_APP }, { ESP_UUID_LEN_128, GATT_U8(UUID_STATUS.bytes), ESP_GATT_PERM_READ,
+                                         VALUE_MAX_LEN, 0, nullptr } },
+            { { ESP_GATT_AUTO_RSP }, { ESP_UUID_LEN_16, GATT_U8(&CCCD), ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+                                       2, 2, GATT_U8(CCCD_OFF) } },
+            // METER
+            { { ESP_GATT_AUTO_RSP }, { ESP_UUID_LEN_16, GATT_U8(&CHAR_DECL), ESP_GATT_PERM_READ,
+                                       1, 1, GATT_U8(&PROP_NOTIFY) } },
+            { { ESP_GATT_RSP_BY_APP }, { ESP_UUID_LEN_128, GATT_U8(UUID_METER.bytes), ESP_GATT_PERM_READ,
+                                         VALUE_MAX_LEN, 0, nullptr } },
+            { { ESP_GATT_AUTO_RSP }, { ESP_UUID_LEN_16, GATT_U8(&CCCD), ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+                                       2, 2, GATT_U8(CCCD_OFF) } },
+        };
+        #undef GATT_U8
+        return TABLE;
+    }
+
+    // Link modes and their connection parameters (interval in 1.25 ms,
+    // timeout in 10 ms; within Apple's accessory limits)
+    enum : uint8_t { LINK_IDLE, LINK_STREAMING, LINK_TRANSFER, LINK_UNKNOWN = 0xFF };
+    struct LinkParams {
+        uint16_t minInt, maxInt, latency, timeout;
+    };
+    static constexpr LinkParams LINK_PARAMS[3] = {
+        { 24, 48, 0, 400 },     // Idle: 30-60 ms
+        { 80, 104, 4, 600 },    // Streaming: 100-130 ms, may skip 4 events (meters only)
+        { 12, 24, 0, 400 },     // OTA / upload: 15-30 ms
+    };
+    static constexpr uint16_t BLE_DLE_TX_OCTETS = 251;     // Link-layer payload maximum
+
+    void requestLinkParams() {
+        const uint8_t mode = m_linkMode;
+        if (!m_connected || mode == m_linkApplied) return;
+        const LinkParams& lp = LINK_PARAMS[mode];
+        esp_ble_conn_update_params_t p = {};
+        memcpy(p.bda, m_remoteBda, sizeof(esp_bd_addr_t));
+        p.min_int = lp.minInt;
+        p.max_int = lp.maxInt;
+        p.latency = lp.latency;
+        p.timeout = lp.timeout;
+        esp_err_t err = esp_ble_gap_update_conn_params(&p);
+        if (err == ESP_OK) {
+            m_linkApplied = mode;
+            ESP_LOGI(TAG, "Conn params for %s requested",
+                     mode == LINK_TRANSFER ? "transfer" : (mode == LINK_STREAMING ? "streaming" : "idle"));
+        } else {
+            ESP_LOGW(TAG, "Conn params request failed: %s", esp_err_to_name(err));
         }
-        esp_err_t err = esp_ble_gatts_send_indicate(m_gattsIf, m_connId, m_statusCharHandle, 1 + len, buffer, false);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "notifyStatus(0x%02X) send failed: %s - marking disconnected", respId, esp_err_to_name(err));
-            // Connection likely dead, mark as disconnected to stop further attempts
-            m_connected = false;
+
+        // Longest link-layer packets for transfers, so a 512-byte chunk is
+        // 3 packets rather than 20 (data length extension, BLE 4.2)
+        if (mode == LINK_TRANSFER && !m_dleRequested) {
+            err = esp_ble_gap_set_pkt_data_len(m_remoteBda, BLE_DLE_TX_OCTETS);
+            m_dleRequested = (err == ESP_OK);
+            if (err != ESP_OK) ESP_LOGW(TAG, "Data length request failed: %s", esp_err_to_name(err));
         }
     }
 
-    // UUID parsing helper
-    static void uuid128FromString(const char* str, uint8_t* out) {
-        uint8_t temp[16];
-        memset(temp, 0, 16);
-        int idx = 0;
-        for (int i = 0; str[i] && idx < 32; i++) {
-            char c = str[i];
-            if (c == '-') continue;
-            int val = 0;
-            if (c >= '0' && c <= '9') val = c - '0';
-            else if (c >= 'a' && c <= 'f') val = c - 'a' + 10;
-            else if (c >= 'A' && c <= 'F') val = c - 'A' + 10;
-            else continue;
-            
-            if ((idx & 1) == 0) {
-                temp[idx >> 1] = (uint8_t)(val << 4);
-            } else {
-                temp[idx >> 1] |= (uint8_t)val;
+    static size_t putTlv(uint8_t* out, size_t cap, size_t idx, uint8_t tag, const void* value, size_t len) {
+        if (len > 255 || idx + 2 + len > cap) return idx;
+        out[idx++] = tag;
+        out[idx++] = (uint8_t)len;
+        memcpy(&out[idx], value, len);
+        return idx + len;
+    }
+
+    size_t buildSnapshot(uint8_t* out, size_t cap) {
+        size_t idx = 0;
+        out[idx++] = BleSnapshot::VERSION;
+        idx = putTlv(out, cap, idx, BleResp::STATUS_EQ, m_eqValue, 3);
+        idx = putTlv(out, cap, idx, BleResp::STATUS_CONTROL, &m_controlValue, 1);
+        const uint8_t led[10] = {
+            m_ledValue[9], brightness255to100(m_ledValue[0]), m_ledValue[8],
+            m_ledValue[1], m_ledValue[2], m_ledValue[3],
+            m_ledValue[4], m_ledValue[5], m_ledValue[6], m_ledValue[7],
+        };
+        idx = putTlv(out, cap, idx, BleResp::STATUS_LED, led, sizeof(led));
+        idx = putTlv(out, cap, idx, BleResp::STATUS_SOUND, &m_soundStatus, 1);
+        idx = putTlv(out, cap, idx, BleResp::STATUS_NAME, m_nameValue, strlen(m_nameValue));
+        idx = putTlv(out, cap, idx, BleResp::STATUS_FW, m_fwValue, strlen(m_fwValue));
+        if (m_latencyCb && idx + 2 < cap) {
+            const size_t latLen = m_latencyCb(&out[idx + 2], cap - idx - 2);
+            if (latLen > 0 && latLen <= 255) {
+                out[idx] = BleSnapshot::TAG_LATENCY;
+                out[idx + 1] = (uint8_t)latLen;
+                idx += 2 + latLen;
             }
-            idx++;
-        }
-        // Reverse for little-endian
-        for (int i = 0; i < 16; i++) {
-            out[i] = temp[15 - i];
         }
+        return idx;
     }
 
-    static bool uuidEqual128(const esp_bt_uuid_t& uuid, const uint8_t* raw) {
-        if (uuid.len != ESP_UUID_LEN_128) return false;
-        return memcmp(uuid.uuid.uuid128, raw, 16) == 0;
+    // Messages: queued in order, all delivered
+    void notifyStatus(uint8_t respId, const uint8_t* data, size_t len) {
+        if (!m_connected || !m_statusCharHandle || !m_gattsIf) {
+            ESP_LOGW(TAG, "notifyStatus(0x%02X) failed: connected=%d, handle=%d, gattsIf=%d",
+                     respId, m_connected, m_statusCharHandle, m_gattsIf);
+            return;
+        }
+        m_tx.postMessage(respId, data, len);
     }
 
-    static bool uuidEqual128Raw(const uint8_t* a, const uint8_t* b) {
-        return memcmp(a, b, 16) == 0;
+    // State: only the newest pending value of each kind is sent
+    void notifyState(uint8_t respId, const uint8_t* data, size_t len) {
+        if (!m_connected || !m_statusCharHandle || !m_gattsIf) return;
+        m_tx.postState(respId, data, len);
     }
 
     // Static callback wrappers
@@ -561,11 +990,17 @@ private:
             }
             break;
         case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
-            ESP_LOGI(TAG, "GAP: CONN_PARAMS update, status=%d, bda=%02x:%02x:%02x:%02x:%02x:%02x",
-                     param->update_conn_params.status,
-                     param->update_conn_params.bda[0], param->update_conn_params.bda[1],
-                     param->update_conn_params.bda[2], param->update_conn_params.bda[3],
-                     param->update_conn_params.bda[4], param->update_conn_params.bda[5]);
+            ESP_LOGI(TAG, "GAP: CONN_PARAMS update, status=%d, int=%d, latency=%d, timeout=%d",
+                     param->update_conn_params.status, param->update_conn_params.conn_int,
+                     param->update_conn_params.latency, param->update_conn_params.timeout);
+            if (param->update_conn_params.status != ESP_BT_STATUS_SUCCESS) {
+                m_linkApplied = LINK_UNKNOWN;   // Asked again on the next change
+            }
+            break;
+        case ESP_GAP_BLE_SET_PKT_LENGTH_COMPLETE_EVT:
+            ESP_LOGI(TAG, "GAP: data length, status=%d, tx=%d, rx=%d",
+                     param->pkt_data_lenth_cmpl.status, param->pkt_data_lenth_cmpl.params.tx_len,
+                     param->pkt_data_lenth_cmpl.params.rx_len);
             break;
         case ESP_GAP_BLE_SEC_REQ_EVT:
             ESP_LOGI(TAG, "GAP: SEC_REQ from %02x:%02x:%02x:%02x:%02x:%02x",
@@ -592,11 +1027,8 @@ private:
         case ESP_GATTS_REG_EVT:
             handleRegEvent(gatts_if, param);
             break;
-        case ESP_GATTS_CREATE_EVT:
-            handleCreateEvent(gatts_if, param);
-            break;
-        case ESP_GATTS_ADD_CHAR_EVT:
-            handleAddCharEvent(gatts_if, param);
+        case ESP_GATTS_CREAT_ATTR_TAB_EVT:
+            handleAttrTabEvent(gatts_if, param);
             break;
         case ESP_GATTS_CONNECT_EVT:
             handleConnectEvent(gatts_if, param);
@@ -613,6 +1045,9 @@ private:
         case ESP_GATTS_MTU_EVT:
             handleMtuEvent(gatts_if, param);
             break;
+        case ESP_GATTS_CONGEST_EVT:
+            m_tx.setCongested(param->congest.congested);
+            break;
         case ESP_GATTS_CONF_EVT:
             ESP_LOGD(TAG, "GATTS: CONF_EVT, status=%d", param->conf.status);
             break;
@@ -643,7 +1078,7 @@ private:
         adv_data.max_interval = 0x0010;
         adv_data.flag = ESP_BLE_ADV_FLAG_GEN_DISC | ESP_BLE_ADV_FLAG_BREDR_NOT_SPT;
         adv_data.service_uuid_len = 16;
-        adv_data.p_service_uuid = m_uuidService;
+        adv_data.p_service_uuid = const_cast<uint8_t*>(UUID_SERVICE.bytes);
 
         esp_ble_adv_data_t scan_rsp = {};
         scan_rsp.set_scan_rsp = true;
@@ -655,115 +1090,57 @@ private:
         esp_ble_gap_config_adv_data(&adv_data);
         esp_ble_gap_config_adv_data(&scan_rsp);
 
-        // Create service - 3 characteristics with CCCD = 3*3 + 1 = 10 handles
-        esp_gatt_srvc_id_t svc = {};
-        svc.is_primary = true;
-        svc.id.inst_id = 0x00;
-        svc.id.uuid.len = ESP_UUID_LEN_128;
-        memcpy(svc.id.uuid.uuid.uuid128, m_uuidService, 16);
-        esp_ble_gatts_create_service(gatts_if, &svc, 10);
+        // The whole service in one call, from the static table; its
+        // handles come back in ESP_GATTS_CREAT_ATTR_TAB_EVT
+        esp_err_t err = esp_ble_gatts_create_attr_tab(gattDb(), gatts_if, ATTR_COUNT, 0);
+        if (err != ESP_OK) ESP_LOGE(TAG, "GATT table not created: %s", esp_err_to_name(err));
     }
 
-    void handleCreateEvent(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
-        m_serviceHandle = param->create.service_handle;
-        esp_ble_gatts_start_service(m_serviceHandle);
-        
-        // Add CMD characteristic (Write + Write No Response)
-        addCharacteristic(m_serviceHandle, m_uuidCmdChar,
-                         ESP_GATT_PERM_WRITE,
-                         ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_WRITE_NR);
-        
-        // Add STATUS characteristic (Notify)
-        addCharacteristic(m_serviceHandle, m_uuidStatusChar,
-                         ESP_GATT_PERM_READ,
-                         ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_NOTIFY);
-        
-        // Add METER characteristic (Notify)
-        addCharacteristic(m_serviceHandle, m_uuidMeterChar,
-                         ESP_GATT_PERM_READ,
-                         ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_NOTIFY);
-    }
-
-    void addCharacteristic(uint16_t svcHandle, const uint8_t* uuid128, esp_gatt_perm_t perm, uint8_t prop) {
-        static esp_attr_control_t rspByApp = { .auto_rsp = ESP_GATT_RSP_BY_APP };
-        esp_bt_uuid_t uuid = {};
-        uuid.len = ESP_UUID_LEN_128;
-        memcpy(uuid.uuid.uuid128, uuid128, 16);
-        esp_attr_value_t val = {};
-        val.attr_max_len = 512;
-        val.attr_len = 0;
-        esp_ble_gatts_add_char(svcHandle, &uuid, perm, (esp_gatt_char_prop_t)prop, &val, &rspByApp);
-    }
-
-    void handleAddCharEvent(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
-        uint16_t handle = param->add_char.attr_handle;
-        
-        if (uuidEqual128(param->add_char.char_uuid, m_uuidCmdChar)) {
-            m_cmdCharHandle = handle;
-            ESP_LOGI(TAG, "CMD char handle: %d", handle);
-        } else if (uuidEqual128(param->add_char.char_uuid, m_uuidStatusChar)) {
-            m_statusCharHandle = handle;
-            ESP_LOGI(TAG, "STATUS char handle: %d", handle);
-            // Add CCCD for notifications
-            addCccd(param->add_char.service_handle);
-        } else if (uuidEqual128(param->add_char.char_uuid, m_uuidMeterChar)) {
-            m_meterCharHandle = handle;
-            ESP_LOGI(TAG, "METER char handle: %d", handle);
-            // Add CCCD for notifications
-            addCccd(param->add_char.service_handle);
+    void handleAttrTabEvent(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
+        if (param->add_attr_tab.status != ESP_GATT_OK || param->add_attr_tab.num_handle != ATTR_COUNT) {
+            ESP_LOGE(TAG, "GATT table failed: status 0x%x, %d handles",
+                     param->add_attr_tab.status, param->add_attr_tab.num_handle);
+            return;
         }
-    }
-
-    void addCccd(uint16_t svcHandle) {
-        esp_bt_uuid_t cccdUuid = {};
-        cccdUuid.len = ESP_UUID_LEN_16;
-        cccdUuid.uuid.uuid16 = 0x2902;
-        // Use AUTO_RSP so ESP-IDF handles CCCD writes automatically
-        static esp_attr_control_t cccdRsp = { .auto_rsp = ESP_GATT_AUTO_RSP };
-        static uint8_t cccdValue[2] = {0, 0};  // Initial value
-        esp_attr_value_t cccdAttr = {
-            .attr_max_len = 2,
-            .attr_len = 2,
-            .attr_value = cccdValue
-        };
-        esp_ble_gatts_add_char_descr(svcHandle, &cccdUuid,
-                                     ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, &cccdAttr, &cccdRsp);
+        const uint16_t* h = param->add_attr_tab.handles;
+        m_serviceHandle = h[ATTR_SERVICE];
+        m_cmdCharHandle = h[ATTR_CMD_VALUE];
+        m_statusCharHandle = h[ATTR_STATUS_VALUE];
+        m_statusCccdHandle = h[ATTR_STATUS_CCCD];
+        m_meterCharHandle = h[ATTR_METER_VALUE];
+        ESP_LOGI(TAG, "GATT service handles %d-%d (CMD %d, STATUS %d, METER %d)", h[ATTR_SERVICE],
+                 h[ATTR_COUNT - 1], m_cmdCharHandle, m_statusCharHandle, m_meterCharHandle);
+        esp_ble_gatts_start_service(m_serviceHandle);
     }
 
     void handleConnectEvent(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
         m_connId = param->connect.conn_id;
+        memcpy(m_remoteBda, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+        m_linkApplied = LINK_UNKNOWN;
+        m_dleRequested = false;
+        m_telemetryContents = 0;
+        m_telemetryReset = true;
+        m_taskReportFollow = false;
+        m_tx.connect(gatts_if, m_connId, m_statusCharHandle, m_meterCharHandle);
         m_connected = true;
         m_mtu = 23;  // Default, will be updated if MTU exchange happens
         m_mtuExchanged = false;
         ESP_LOGI(TAG, "Client connected, conn_id=%d", m_connId);
-
-        // Send initial status after connection (same as old working code)
-        // The app may or may not request MTU exchange
-        xTaskCreate([](void* arg) {
-            BleUnifiedService* self = (BleUnifiedService*)arg;
-            vTaskDelay(pdMS_TO_TICKS(500));  // Wait for CCCD setup
-            
-            if (!self->m_connected) {
-                vTaskDelete(NULL);
-                return;
-            }
-            
-            // Send full status
-            self->sendFullStatus();
-            
-            ESP_LOGI("BLE_U", "Initial status sent");
-            vTaskDelete(NULL);
-        }, "ble_init", 2048, this, 5, NULL);
+        requestLinkParams();
+        // Initial status: read from STATUS, or pushed once the client
+        // enables its notifications (handleWriteEvent)
     }
     
     void handleMtuEvent(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
         m_mtu = param->mtu.mtu;
         m_mtuExchanged = true;
+        m_tx.setMtu(m_mtu);
         ESP_LOGI(TAG, "MTU exchanged: %d bytes", m_mtu);
     }
 
     void handleDisconnectEvent(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
         m_connected = false;
+        m_tx.disconnect();
         m_connId = 0;
         m_mtu = 23;
         m_mtuExchanged = false;
@@ -774,12 +1151,27 @@ private:
     void handleReadEvent(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
         esp_gatt_rsp_t rsp = {};
         rsp.attr_value.handle = param->read.handle;
+        esp_gatt_status_t status = ESP_GATT_OK;
         
-        // For reads, just return empty - all data sent via notifications
-        rsp.attr_value.len = 0;
+        // STATUS reads give the snapshot; a long read (read blob) continues
+        // from the copy made at offset 0 so the parts match. Other reads
+        // are empty - their data comes via notifications.
+        if (param->read.handle == m_statusCharHandle) {
+            const uint16_t offset = param->read.is_long ? param->read.offset : 0;
+            if (offset == 0) m_snapshotLen = buildSnapshot(m_snapshot, sizeof(m_snapshot));
+            if (offset > m_snapshotLen) {
+                status = ESP_GATT_INVALID_OFFSET;
+            } else {
+                size_t n = m_snapshotLen - offset;
+                if (n > (size_t)(m_mtu - 1)) n = m_mtu - 1;
+                memcpy(rsp.attr_value.value, &m_snapshot[offset], n);
+                rsp.attr_value.len = n;
+                rsp.attr_value.offset = offset;
+            }
+        }
         
         esp_ble_gatts_send_response(gatts_if, param->read.conn_id,
-                                    param->read.trans_id, ESP_GATT_OK, &rsp);
+                                    param->read.trans_id, status, &rsp);
     }
 
     void handleWriteEvent(esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
@@ -791,6 +1183,12 @@ private:
             processCommand(data[0], &data[1], len - 1);
         }
 
+        // Notifications on STATUS enabled: push the initial status
+        if (handle == m_statusCccdHandle && len >= 1 && (data[0] & 0x01)) {
+            sendFullStatus();
+            ESP_LOGI(TAG, "Initial status sent");
+        }
+
         if (param->write.need_rsp) {
             esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
                                         param->write.trans_id, ESP_GATT_OK, NULL);
@@ -798,7 +1196,12 @@ private:
     }
 
     void processCommand(uint8_t cmd, const uint8_t* payload, size_t len) {
-        ESP_LOGI(TAG, "CMD: 0x%02X, len=%d", cmd, len);
+        // Upload chunks arrive by the hundred per second
+        if (cmd == BleCmd::OTA_DATA || cmd == BleCmd::SOUND_UP_DATA) {
+            ESP_LOGD(TAG, "CMD: 0x%02X, len=%d", cmd, len);
+        } else {
+            ESP_LOGI(TAG, "CMD: 0x%02X, len=%d", cmd, len);
+        }
         
         switch (cmd) {
         case BleCmd::SET_EQ:
@@ -904,6 +1307,228 @@ private:
         case BleCmd::REQUEST_STATUS:
             sendFullStatus();
             break;
+
+        case BleCmd::REQUEST_SNAPSHOT:
+            sendSnapshot();
+            break;
+
+        case BleCmd::REQUEST_TRACE:
+            if (m_traceCb) {
+                m_traceCb(len >= 1 && payload[0] != 0);
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+
+        case BleCmd::SET_PEQ_BAND:
+            if (!m_peqBandCb) {
+                sendError(cmd, BleError::INVALID_CMD);
+            } else if (len >= 8 && m_peqBandCb(payload[0], payload + 1, len - 1)) {
+                sendAck(cmd);
+            } else {
+                sendError(cmd, BleError::INVALID_PARAM);
+            }
+            break;
+
+        case BleCmd::SET_DSP_PRESET:
+            if (!m_presetCb) {
+                sendError(cmd, BleError::INVALID_CMD);
+            } else if (len >= 7 && m_presetCb(payload[0], payload + 1, len - 1)) {
+                sendAck(cmd);
+            } else {
+                sendError(cmd, BleError::INVALID_PARAM);
+            }
+            break;
+
+        case BleCmd::SET_OUTPUT_LAYOUT:
+            if (!m_outputLayoutCb) {
+                sendError(cmd, BleError::INVALID_CMD);
+            } else if (len >= 2 && m_outputLayoutCb(payload[0], payload[1])) {
+                sendAck(cmd);
+            } else {
+                sendError(cmd, BleError::INVALID_PARAM);
+            }
+            break;
+
+        case BleCmd::SET_LATENCY_PROFILE:
+            if (!m_profileSetCb) {
+                sendError(cmd, BleError::INVALID_CMD);
+            } else if (len >= 1 && m_profileSetCb(payload[0])) {
+                sendAck(cmd);
+                sendProfileStatus();
+            } else {
+                sendError(cmd, BleError::INVALID_PARAM);
+            }
+            break;
+
+        case BleCmd::SET_FAST_CONNECT:
+            if (m_fastConnectCb) {
+                m_fastConnectCb(len >= 1 ? payload[0] : 0);
+                sendAck(cmd);
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+
+        case BleCmd::SET_DYNAMICS:
+            if (!m_dynamicsCb) {
+                sendError(cmd, BleError::INVALID_CMD);
+            } else if (len >= 1 && m_dynamicsCb(payload[0])) {
+                sendAck(cmd);
+            } else {
+                sendError(cmd, BleError::INVALID_PARAM);
+            }
+            break;
+
+        case BleCmd::SET_3D_MODE:
+            if (!m_sound3DModeCb) {
+                sendError(cmd, BleError::INVALID_CMD);
+            } else if (len >= 1 && m_sound3DModeCb(payload[0])) {
+                sendAck(cmd);
+            } else {
+                sendError(cmd, BleError::INVALID_PARAM);
+            }
+            break;
+
+        case BleCmd::SET_DSP_GRAPH:
+            if (!m_dspGraphCb) {
+                sendError(cmd, BleError::INVALID_CMD);
+            } else if (len >= 2 && m_dspGraphCb(payload, len)) {
+                sendAck(cmd);
+            } else {
+                sendError(cmd, BleError::INVALID_PARAM);
+            }
+            break;
+
+        case BleCmd::REQUEST_DSP_GRAPH:
+            if (m_dspGraphStatusCb) {
+                uint8_t buf[16];
+                const size_t n = m_dspGraphStatusCb(buf, sizeof(buf));
+                notifyStatus(BleResp::STATUS_DSP_GRAPH, buf, n);
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+
+        case BleCmd::REQUEST_FLEET_REPORT:
+            if (m_fleetReportCb) {
+                sendAck(cmd);
+                m_fleetReportCb();
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+
+        case BleCmd::REQUEST_CAPTURE:
+            if (!m_captureStatusCb || !m_captureControlCb || !m_captureReadCb) {
+                sendError(cmd, BleError::INVALID_CMD);
+            } else if (len >= 1 && payload[0] == 0) {
+                uint8_t buf[16];
+                buf[0] = 0;
+                const size_t n = m_captureStatusCb(&buf[1], sizeof(buf) - 1);
+                notifyStatus(BleResp::STATUS_CAPTURE, buf, 1 + n);
+            } else if (len >= 1 && (payload[0] == 1 || payload[0] == 2)) {
+                m_captureControlCb(payload[0] == 1);
+                sendAck(cmd);
+            } else if (len >= 6 && payload[0] == 3) {
+                const uint32_t offset = (uint32_t)payload[1] | (uint32_t)payload[2] << 8 |
+                                        (uint32_t)payload[3] << 16 | (uint32_t)payload[4] << 24;
+                if (!m_captureBulkCb || !m_captureBulkCb(offset, payload[5])) sendCapture(offset, payload[5]);
+            } else {
+                sendError(cmd, BleError::INVALID_PARAM);
+            }
+            break;
+
+        case BleCmd::REQUEST_BULK:
+            if (m_bulkStatusCb) {
+                uint8_t buf[8];
+                const size_t n = m_bulkStatusCb(buf, sizeof(buf));
+                notifyStatus(BleResp::STATUS_BULK, buf, n);
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+
+        case BleCmd::REQUEST_PROFILE:
+            if (m_profileStatusCb) {
+                sendProfileStatus();
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+
+        case BleCmd::REQUEST_PEQ:
+            if (m_peqStatusCb) {
+                sendPeqStatus();
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+
+        case BleCmd::REQUEST_LED_PROFILE:
+            if (m_ledProfileCb) {
+                sendLedProfile(len >= 1 && payload[0] != 0);
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+
+        case BleCmd::REQUEST_TASKS:
+            if (m_taskReportCb) {
+                m_taskReportFollow = len >= 1 && payload[0] != 0;
+                sendTaskReport();
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+
+        case BleCmd::REQUEST_DEADLINE:
+            if (m_deadlineCb) {
+                sendDeadline(len >= 1 && payload[0] != 0);
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+
+        case BleCmd::REQUEST_GLITCHES:
+            if (m_glitchReadCb && m_glitchClearCb) {
+                sendGlitches();
+                if (len >= 1 && payload[0] != 0) m_glitchClearCb();
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+
+        case BleCmd::REQUEST_LIMITER:
+            if (m_limiterCb) {
+                m_limiterCb(len >= 1 && payload[0] != 0);
+            } else {
+                sendError(cmd, BleError::INVALID_CMD);
+            }
+            break;
+            
+        case BleCmd::SET_TX_BATCH:
+            if (len >= 1) {
+                m_tx.setBatching(payload[0] != 0);
+                sendAck(cmd);
+            } else {
+                sendError(cmd, BleError::INVALID_PARAM);
+            }
+            break;
+            
+        case BleCmd::SET_TELEMETRY:
+            // Frames carry the contents actually sent (what this build has)
+            if (len >= 2) {
+                uint16_t ms = payload[1] * 10;
+                if (ms < APP_LEVELS_UPDATE_MS) ms = APP_LEVELS_UPDATE_MS;
+                m_telemetryPeriodMs = ms;
+                m_telemetryContents = payload[0];
+                m_telemetryReset = true;
+                sendAck(cmd);
+            } else {
+                sendError(cmd, BleError::INVALID_PARAM);
+            }
+            break;
             
         case BleCmd::PING:
             sendPong();
@@ -934,6 +1559,18 @@ private:
     uint16_t m_mtu;  // Negotiated MTU size
     bool m_mtuExchanged;  // True after MTU exchange completes
     uint8_t m_advConfigDone;
+    esp_bd_addr_t m_remoteBda = {};
+    volatile uint8_t m_linkMode = LINK_IDLE;        // Wanted (setLinkDemand)
+    volatile uint8_t m_linkApplied = LINK_UNKNOWN;  // Last requested on this connection
+    bool m_dleRequested = false;                    // Data length asked for on this connection
+
+    // METER telemetry, per connection (SET_TELEMETRY)
+    BleTelemetry m_telemetry;                       // updateTelemetry's task only
+    volatile bool m_telemetryReset = false;
+    volatile uint8_t m_telemetryContents = 0;
+    volatile bool m_taskReportFollow = false;
+    uint8_t m_telemetryAvailable = BleTelemetry::LEVELS;
+    volatile uint16_t m_telemetryPeriodMs = APP_LEVELS_UPDATE_MS;
 
     // Service handle
     uint16_t m_serviceHandle;
@@ -942,12 +1579,11 @@ private:
     uint16_t m_cmdCharHandle;
     uint16_t m_statusCharHandle;
     uint16_t m_meterCharHandle;
+    uint16_t m_statusCccdHandle = 0;
 
-    // UUIDs (little-endian)
-    uint8_t m_uuidService[16];
-    uint8_t m_uuidCmdChar[16];
-    uint8_t m_uuidStatusChar[16];
-    uint8_t m_uuidMeterChar[16];
+    // Snapshot served by STATUS reads; long reads continue from it
+    uint8_t m_snapshot[BleSnapshot::MAX_BYTES];
+    size_t m_snapshotLen = 0;
 
     // State values
     int8_t m_eqValue[3];
@@ -957,6 +1593,8 @@ private:
     char m_nameValue[64];
     char m_fwValue[32];
 
+    BleTxScheduler m_tx;
+
     // Callbacks
     EqCallback m_eqCb;
     EqPresetCallback m_eqPresetCb;
@@ -969,4 +1607,29 @@ private:
     SoundDeleteCallback m_soundDeleteCb;
     SoundDataCallback m_soundDataCb;
     OtaCallback m_otaCb;
+    TraceCallback m_traceCb;
+    LimiterCallback m_limiterCb;
+    PeqBandCallback m_peqBandCb;
+    PeqStatusCallback m_peqStatusCb;
+    PresetCallback m_presetCb;
+    LatencyCallback m_latencyCb;
+    LedProfileCallback m_ledProfileCb;
+    OutputLayoutCallback m_outputLayoutCb;
+    TaskReportCallback m_taskReportCb;
+    GlitchReadCallback m_glitchReadCb;
+    GlitchClearCallback m_glitchClearCb;
+    DeadlineCallback m_deadlineCb;
+    ProfileSetCallback m_profileSetCb;
+    ProfileStatusCallback m_profileStatusCb;
+    FastConnectCallback m_fastConnectCb;
+    DynamicsCallback m_dynamicsCb;
+    Sound3DModeCallback m_sound3DModeCb;
+    CaptureStatusCallback m_captureStatusCb;
+    CaptureControlCallback m_captureControlCb;
+    CaptureReadCallback m_captureReadCb;
+    BulkStatusCallback m_bulkStatusCb;
+    CaptureBulkCallback m_captureBulkCb;
+    DspGraphCallback m_dspGraphCb;
+    DspGraphStatusCallback m_dspGraphStatusCb;
+    FleetReportCallback m_fleetReportCb;
 };
@@ -13,6 +13,36 @@
 #define APP_I2S_LRCK_PIN        CONFIG_I2S_LRCK_PIN
 #define APP_I2S_DATA_PIN        CONFIG_I2S_DATA_PIN
 #define APP_I2S_DEFAULT_SR      CONFIG_I2S_DEFAULT_SAMPLE_RATE
+#ifdef CONFIG_I2S_USE_APLL
+#define APP_I2S_USE_APLL        1
+#else
+#define APP_I2S_USE_APLL        0
+#endif
+#ifdef CONFIG_I2S_OUT_BITS_16
+#define APP_I2S_OUT_BITS        16
+#else
+#define APP_I2S_OUT_BITS        32
+#endif
+#define APP_I2S_OUT_SLOTS       CONFIG_I2S_OUT_SLOTS
+#ifdef CONFIG_I2S_FIXED_RATE
+#define APP_I2S_FIXED_RATE      1
+#define APP_I2S_FIXED_RATE_HZ   CONFIG_I2S_FIXED_RATE_HZ
+#else
+#define APP_I2S_FIXED_RATE      0
+#define APP_I2S_FIXED_RATE_HZ   0
+#endif
+#ifdef CONFIG_AUX_OUTPUT
+#define APP_AUX_OUTPUT          1
+#define APP_AUX_I2S_PORT        I2S_NUM_0
+#define APP_AUX_I2S_BCK_PIN     CONFIG_AUX_I2S_BCK_PIN
+#define APP_AUX_I2S_LRCK_PIN    CONFIG_AUX_I2S_LRCK_PIN
+#define APP_AUX_I2S_DATA_PIN    CONFIG_AUX_I2S_DATA_PIN
+#define APP_SUB_CROSSOVER_FREQ  ((float)CONFIG_SUB_CROSSOVER_FREQ)
+#define APP_AUX_SLOT_LEFT       CONFIG_AUX_SLOT_LEFT
+#define APP_AUX_SLOT_RIGHT      CONFIG_AUX_SLOT_RIGHT
+#else
+#define APP_AUX_OUTPUT          0
+#endif
 
 // GPIO Configuration
 #define APP_BUTTON1_GPIO        CONFIG_BUTTON1_GPIO
@@ -21,9 +51,102 @@
 
 // DSP Configuration
 #define APP_GOERTZEL_N          CONFIG_DSP_GOERTZEL_N
+#ifdef CONFIG_DSP_ANALYSIS_DECIMATE
+#define APP_DSP_ANALYSIS_DECIMATE   1
+#else
+#define APP_DSP_ANALYSIS_DECIMATE   0
+#endif
+#ifdef CONFIG_DSP_SPECTRUM
+#define APP_DSP_SPECTRUM        1
+#ifdef CONFIG_DSP_SPECTRUM_FFT_512
+#define APP_SPECTRUM_FFT_N      512
+#else
+#define APP_SPECTRUM_FFT_N      256
+#endif
+#define APP_SPECTRUM_BANDS      CONFIG_DSP_SPECTRUM_BANDS
+#ifdef CONFIG_LED_FPS
+#define APP_SPECTRUM_PERIOD_MS  (1000 / CONFIG_LED_FPS)
+#else
+#define APP_SPECTRUM_PERIOD_MS  33
+#endif
+#else
+#define APP_DSP_SPECTRUM        0
+#endif
 #define APP_CROSSOVER_LP_FREQ   ((float)CONFIG_DSP_CROSSOVER_LP_FREQ)
 #define APP_CROSSOVER_HP_FREQ   ((float)CONFIG_DSP_CROSSOVER_HP_FREQ)
 #define APP_DSP_OUT_FRAMES      CONFIG_DSP_OUT_FRAMES
+#ifdef CONFIG_DSP_Q31_PATH
+#define APP_DSP_Q31_PATH        1
+#else
+#define APP_DSP_Q31_PATH        0
+#endif
+#ifdef CONFIG_DSP_SIMD
+#define APP_DSP_SIMD            1
+#else
+#define APP_DSP_SIMD            0
+#endif
+#ifdef CONFIG_DSP_VOLUME
+#define APP_DSP_VOLUME          1
+#define APP_DSP_VOLUME_RAMP_MS  CONFIG_DSP_VOLUME_RAMP_MS
+#else
+#define APP_DSP_VOLUME          0
+#endif
+#ifdef CONFIG_DSP_LIMITER
+#define APP_DSP_LIMITER         1
+#define APP_DSP_LIMITER_LOOKAHEAD_US CONFIG_DSP_LIMITER_LOOKAHEAD_US
+#define APP_DSP_LIMITER_RELEASE_MS   CONFIG_DSP_LIMITER_RELEASE_MS
+#else
+#define APP_DSP_LIMITER         0
+#endif
+#ifdef CONFIG_DSP_DYNAMICS
+#define APP_DSP_DYNAMICS        1
+#define APP_DSP_DYNAMICS_DEFAULT CONFIG_DSP_DYNAMICS_DEFAULT
+#else
+#define APP_DSP_DYNAMICS        0
+#define APP_DSP_DYNAMICS_DEFAULT 0
+#endif
+#ifdef CONFIG_DSP_PEQ
+#define APP_DSP_PEQ             1
+#define APP_PEQ_BANDS           CONFIG_DSP_PEQ_BANDS
+#define APP_PEQ_CYCLE_BUDGET    CONFIG_DSP_PEQ_CYCLE_BUDGET
+#else
+#define APP_DSP_PEQ             0
+#endif
+#ifdef CONFIG_DSP_SILENCE_GATE
+#define APP_DSP_SILENCE_GATE    1
+#define APP_DSP_SILENCE_HOLD_MS CONFIG_DSP_SILENCE_HOLD_MS
+#else
+#define APP_DSP_SILENCE_GATE    0
+#endif
+#ifdef CONFIG_DSP_FIR
+#define APP_DSP_FIR             1
+#define APP_FIR_PARTITION       CONFIG_DSP_FIR_PARTITION
+#define APP_FIR_MAX_TAPS        CONFIG_DSP_FIR_MAX_TAPS
+#else
+#define APP_DSP_FIR             0
+#endif
+#ifdef CONFIG_DSP_BINAURAL
+#define APP_DSP_BINAURAL        1
+#define APP_DSP_BINAURAL_ANGLE  CONFIG_DSP_BINAURAL_ANGLE
+#else
+#define APP_DSP_BINAURAL        0
+#endif
+#ifdef CONFIG_MONO_SPEAKER
+#define APP_MONO_SPEAKER        1
+#else
+#define APP_MONO_SPEAKER        0
+#endif
+#ifdef CONFIG_DSP_PASSTHROUGH
+#define APP_DSP_PASSTHROUGH     1
+#else
+#define APP_DSP_PASSTHROUGH     0
+#endif
+#ifdef CONFIG_DSP_GRAPH
+#define APP_DSP_GRAPH           1
+#else
+#define APP_DSP_GRAPH           0
+#endif
+#define APP_DSP_PRESETS         16      // Preset bank slots (SET_EQ_PRESET), factory ones first
 
 // Beat Detection (converted from scaled integers)
 #define APP_BASS_AVG_ALPHA      (CONFIG_BEAT_BASS_AVG_ALPHA / 1000.0f)
@@ -32,15 +155,421 @@
 #define APP_BASS_RATIO_THRESH   (CONFIG_BEAT_RATIO_THRESH / 10.0f)
 #define APP_BEAT_MIN_INTERVAL_MS CONFIG_BEAT_MIN_INTERVAL_MS
 #define APP_BEAT_FLASH_DURATION_MS CONFIG_BEAT_FLASH_DURATION_MS
+#ifdef CONFIG_BEAT_LED_FADE
+#define APP_BEAT_LED_FADE       1
+#else
+#define APP_BEAT_LED_FADE       0
+#endif
+#ifdef CONFIG_BEAT_TRACKER
+#define APP_BEAT_TRACKER        1
+#else
+#define APP_BEAT_TRACKER        0
+#endif
 #define APP_LEVELS_UPDATE_MS    CONFIG_LEVELS_UPDATE_MS
+#define APP_TELEMETRY_STREAMING_MS 100  // Telemetry period floor while A2DP streams (one conn interval)
 
 // Device Settings
 #define APP_DEFAULT_DEVICE_NAME CONFIG_DEFAULT_DEVICE_NAME
 #define APP_FIRMWARE_VERSION    CONFIG_FIRMWARE_VERSION
+#ifdef CONFIG_TRACK_INFO
+#define APP_TRACK_INFO          1
+#else
+#define APP_TRACK_INFO          0
+#endif
 
 // Audio Buffer Configuration
 #define APP_AUDIO_POOL_COUNT    CONFIG_AUDIO_POOL_COUNT
 #define APP_AUDIO_POOL_BUF_SIZE CONFIG_AUDIO_POOL_BUF_SIZE
+#define APP_AUDIO_FAST_RING_KB  CONFIG_AUDIO_FAST_RING_KB
+#ifdef CONFIG_AUDIO_DECODE_IN_PLACE
+#define APP_AUDIO_DECODE_IN_PLACE   1
+#else
+#define APP_AUDIO_DECODE_IN_PLACE   0
+#endif
+// Pull decoding needs the jitter buffer's depth accounting (Kconfig)
+#if defined(CONFIG_AUDIO_PULL_DECODE) && defined(CONFIG_JITTER_BUFFER_ENABLE)
+#define APP_AUDIO_PULL_DECODE       1
+#define APP_AUDIO_TX_STACK          (CONFIG_AUDIO_PULL_DECODE_STACK_KB * 1024)
+#else
+#define APP_AUDIO_PULL_DECODE       0
+#define APP_AUDIO_TX_STACK          8192
+#endif
+#ifdef CONFIG_AUDIO_ENCODED_JITTER
+#define APP_AUDIO_ENCODED_JITTER    1
+#define APP_AUDIO_ENCODED_MAX_MS    CONFIG_AUDIO_ENCODED_MAX_MS
+#define APP_AUDIO_PCM_WINDOW_KB     CONFIG_AUDIO_PCM_WINDOW_KB
+#else
+#define APP_AUDIO_ENCODED_JITTER    0
+#endif
+#ifdef CONFIG_AUDIO_FAST_RING_RESERVE_KB
+#define APP_AUDIO_FAST_RING_RESERVE_KB CONFIG_AUDIO_FAST_RING_RESERVE_KB
+#else
+#define APP_AUDIO_FAST_RING_RESERVE_KB 48
+#endif
+#ifdef CONFIG_MEM_BT_RESERVE_KB
+#define APP_MEM_BT_RESERVE_KB       CONFIG_MEM_BT_RESERVE_KB
+#define APP_MEM_BUDGET_AUDIO_KB     CONFIG_MEM_BUDGET_AUDIO_KB
+#define APP_MEM_BUDGET_DSP_KB       CONFIG_MEM_BUDGET_DSP_KB
+#define APP_MEM_BUDGET_SOUND_KB     CONFIG_MEM_BUDGET_SOUND_KB
+#define APP_MEM_BUDGET_LED_KB       CONFIG_MEM_BUDGET_LED_KB
+#define APP_MEM_BUDGET_OTHER_KB     CONFIG_MEM_BUDGET_OTHER_KB
+#else
+#define APP_MEM_BT_RESERVE_KB       32
+#define APP_MEM_BUDGET_AUDIO_KB     160
+#define APP_MEM_BUDGET_DSP_KB       64
+#define APP_MEM_BUDGET_SOUND_KB     48
+#define APP_MEM_BUDGET_LED_KB       32
+#define APP_MEM_BUDGET_OTHER_KB     64
+#endif
+#ifdef CONFIG_MEM_PRESSURE_LADDER
+#define APP_MEM_PRESSURE_LADDER 1
+#define APP_MEM_PRESSURE_LIGHT_KB  CONFIG_MEM_PRESSURE_LIGHT_KB
+#define APP_MEM_PRESSURE_SHRINK_KB CONFIG_MEM_PRESSURE_SHRINK_KB
+#define APP_MEM_PRESSURE_REDUCE_KB CONFIG_MEM_PRESSURE_REDUCE_KB
+#define APP_MEM_PRESSURE_HYSTERESIS_KB CONFIG_MEM_PRESSURE_HYSTERESIS_KB
+#define APP_MEM_PRESSURE_HOLD_MS   CONFIG_MEM_PRESSURE_HOLD_MS
+#else
+#define APP_MEM_PRESSURE_LADDER 0
+#define APP_MEM_PRESSURE_LIGHT_KB  64
+#define APP_MEM_PRESSURE_SHRINK_KB 48
+#define APP_MEM_PRESSURE_REDUCE_KB 36
+#define APP_MEM_PRESSURE_HYSTERESIS_KB 8
+#define APP_MEM_PRESSURE_HOLD_MS   2000
+#endif
+#define APP_MEM_PRESSURE_POLL_MS   100
+
+// Codec profile (CODEC_PROFILE): the codecs built into the stack, for the
+// boot log; the bt component itself filters on CONFIG_CODEC_EXCLUDE_*
+#if defined(CONFIG_CODEC_PROFILE_HIFI)
+#define APP_CODEC_PROFILE_NAME  "hifi"
+#elif defined(CONFIG_CODEC_PROFILE_PHONE)
+#define APP_CODEC_PROFILE_NAME  "phone"
+#elif defined(CONFIG_CODEC_PROFILE_SBC)
+#define APP_CODEC_PROFILE_NAME  "sbc"
+#else
+#define APP_CODEC_PROFILE_NAME  "full"
+#endif
+#if defined(CONFIG_BT_A2DP_AAC_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_AAC)
+#define APP_CODEC_NAME_AAC      " AAC"
+#else
+#define APP_CODEC_NAME_AAC      ""
+#endif
+#if defined(CONFIG_BT_A2DP_APTX_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_APTX)
+#define APP_CODEC_NAME_APTX     " aptX aptX-HD aptX-LL"
+#else
+#define APP_CODEC_NAME_APTX     ""
+#endif
+#if defined(CONFIG_BT_A2DP_LDAC_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_LDAC)
+#define APP_CODEC_NAME_LDAC     " LDAC"
+#else
+#define APP_CODEC_NAME_LDAC     ""
+#endif
+#if defined(CONFIG_BT_A2DP_OPUS_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_OPUS)
+#define APP_CODEC_NAME_OPUS     " Opus"
+#else
+#define APP_CODEC_NAME_OPUS     ""
+#endif
+#if defined(CONFIG_BT_A2DP_LC3PLUS_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_LC3PLUS)
+#define APP_CODEC_NAME_LC3PLUS  " LC3plus"
+#else
+#define APP_CODEC_NAME_LC3PLUS  ""
+#endif
+#define APP_CODEC_NAMES "SBC" APP_CODEC_NAME_AAC APP_CODEC_NAME_APTX APP_CODEC_NAME_LDAC \
+                        APP_CODEC_NAME_OPUS APP_CODEC_NAME_LC3PLUS
+
+#ifdef CONFIG_CODEC_POLICY
+#define APP_CODEC_POLICY        1
+#define APP_CODEC_POLICY_LOSS_PERMILLE     CONFIG_CODEC_POLICY_LOSS_PERMILLE
+#define APP_CODEC_POLICY_UNDERRUNS_PER_MIN CONFIG_CODEC_POLICY_UNDERRUNS_PER_MIN
+#define APP_CODEC_POLICY_JITTER_MS         CONFIG_CODEC_POLICY_JITTER_MS
+#define APP_CODEC_POLICY_MIN_SESSION_S     CONFIG_CODEC_POLICY_MIN_SESSION_S
+#define APP_CODEC_POLICY_REPROBE_STREAK    CONFIG_CODEC_POLICY_REPROBE_STREAK
+#else
+#define APP_CODEC_POLICY        0
+#define APP_CODEC_POLICY_LOSS_PERMILLE     10
+#define APP_CODEC_POLICY_UNDERRUNS_PER_MIN 3
+#define APP_CODEC_POLICY_JITTER_MS         40
+#define APP_CODEC_POLICY_MIN_SESSION_S     30
+#define APP_CODEC_POLICY_REPROBE_STREAK    10
+#endif
+#ifdef CONFIG_CODEC_POLICY_RF_BAD_PCT
+#define APP_CODEC_POLICY_RF_BAD_PCT        CONFIG_CODEC_POLICY_RF_BAD_PCT
+#else
+#define APP_CODEC_POLICY_RF_BAD_PCT        100
+#endif
+
+#ifdef CONFIG_LINK_MONITOR
+#define APP_LINK_MONITOR        1
+#define APP_LINK_MONITOR_RSSI_POOR      CONFIG_LINK_MONITOR_RSSI_POOR
+#define APP_LINK_MONITOR_QUALITY_POOR   CONFIG_LINK_MONITOR_QUALITY_POOR
+#define APP_LINK_MONITOR_MARGIN_MS      CONFIG_LINK_MONITOR_MARGIN_MS
+#else
+#define APP_LINK_MONITOR        0
+#define APP_LINK_MONITOR_RSSI_POOR      10
+#define APP_LINK_MONITOR_QUALITY_POOR   200
+#define APP_LINK_MONITOR_MARGIN_MS      60
+#endif
+
+#ifdef CONFIG_PEER_STREAM_CACHE
+#define APP_PEER_STREAM_CACHE   1
+#else
+#define APP_PEER_STREAM_CACHE   0
+#endif
+
+#ifdef CONFIG_SOURCE_TAKEOVER
+#define APP_SOURCE_TAKEOVER     1
+#else
+#define APP_SOURCE_TAKEOVER     0
+#endif
+#ifdef CONFIG_SOURCE_TAKEOVER_WHILE_PLAYING
+#define APP_SOURCE_TAKEOVER_WHILE_PLAYING   1
+#else
+#define APP_SOURCE_TAKEOVER_WHILE_PLAYING   0
+#endif
+
+#ifdef CONFIG_SOUND_CACHE
+#define APP_SOUND_CACHE         1
+#define APP_SOUND_CACHE_MAX_MS  CONFIG_SOUND_CACHE_MAX_MS
+#else
+#define APP_SOUND_CACHE         0
+#define APP_SOUND_CACHE_MAX_MS  3000
+#endif
+
+#ifdef CONFIG_SOUND_ASSETS
+#define APP_SOUND_ASSETS        1
+#define APP_SOUND_ASSET_LABEL   CONFIG_SOUND_ASSET_LABEL
+#else
+#define APP_SOUND_ASSETS        0
+#define APP_SOUND_ASSET_LABEL   "sounds"
+#endif
+
+#ifdef CONFIG_SOUND_TRANSCODE
+#define APP_SOUND_TRANSCODE     1
+#else
+#define APP_SOUND_TRANSCODE     0
+#endif
+
+// Task layout: decode on one core, DSP + I2S on the other, everything
+// else (LED, UI, sound player) away from the audio core
+#define APP_DECODE_CORE         CONFIG_BT_A2DP_SINK_TASK_CORE
+#define APP_AUDIO_TX_CORE       CONFIG_AUDIO_TX_CORE
+#define APP_CONTROL_CORE        (APP_AUDIO_TX_CORE ^ 1)
+#ifdef CONFIG_AUDIO_LOAD_REPORT
+#define APP_AUDIO_LOAD_REPORT   1
+#define APP_AUDIO_LOAD_REPORT_INTERVAL_S CONFIG_AUDIO_LOAD_REPORT_INTERVAL_S
+#else
+#define APP_AUDIO_LOAD_REPORT   0
+#endif
+#ifdef CONFIG_TASK_DIAGNOSTICS
+#define APP_TASK_DIAGNOSTICS    1
+#define APP_TASK_DIAGNOSTICS_INTERVAL_S CONFIG_TASK_DIAGNOSTICS_INTERVAL_S
+#else
+#define APP_TASK_DIAGNOSTICS    0
+#endif
+#ifdef CONFIG_GLITCH_JOURNAL
+#define APP_GLITCH_JOURNAL      1
+#define APP_GLITCH_JOURNAL_ENTRIES CONFIG_GLITCH_JOURNAL_ENTRIES
+#else
+#define APP_GLITCH_JOURNAL      0
+#endif
+#ifdef CONFIG_EVENT_LOG
+#define APP_EVENT_LOG           1
+#define APP_EVENT_LOG_ENTRIES   CONFIG_EVENT_LOG_ENTRIES
+#else
+#define APP_EVENT_LOG           0
+#endif
+#ifdef CONFIG_PERF_CONSOLE
+#define APP_PERF_CONSOLE        1
+#else
+#define APP_PERF_CONSOLE        0
+#endif
+#ifdef CONFIG_PCM_CAPTURE
+#define APP_PCM_CAPTURE         1
+#define APP_PCM_CAPTURE_KB      CONFIG_PCM_CAPTURE_KB
+#define APP_PCM_CAPTURE_POST_MS CONFIG_PCM_CAPTURE_POST_MS
+#else
+#define APP_PCM_CAPTURE         0
+#endif
+#ifdef CONFIG_FLEET_REPORT
+#define APP_FLEET_REPORT        1
+#define APP_FLEET_REPORT_URL    CONFIG_FLEET_REPORT_URL
+#define APP_FLEET_REPORT_INTERVAL_H CONFIG_FLEET_REPORT_INTERVAL_H
+#else
+#define APP_FLEET_REPORT        0
+#endif
+#ifdef CONFIG_DEADLINE_MONITOR
+#define APP_DEADLINE_MONITOR    1
+#define APP_DEADLINE_BUDGET_PCT CONFIG_DEADLINE_BUDGET_PCT
+#else
+#define APP_DEADLINE_MONITOR    0
+#endif
+#ifdef CONFIG_DEADLINE_AUTO_SHED
+#define APP_DEADLINE_AUTO_SHED  1
+#define APP_DEADLINE_SHED_MISSES CONFIG_DEADLINE_SHED_MISSES
+#define APP_DEADLINE_RESTORE_S  CONFIG_DEADLINE_RESTORE_S
+#else
+#define APP_DEADLINE_AUTO_SHED  0
+#endif
+#ifdef CONFIG_DEADLINE_SHED_DECODER
+#define APP_DEADLINE_SHED_DECODER 1
+#else
+#define APP_DEADLINE_SHED_DECODER 0
+#endif
+#ifdef CONFIG_LATENCY_PROFILES
+#define APP_LATENCY_PROFILES    1
+#define APP_LATENCY_GAMING_JB_MS        CONFIG_LATENCY_GAMING_JB_MS
+#define APP_LATENCY_GAMING_LOOKAHEAD_US CONFIG_LATENCY_GAMING_LOOKAHEAD_US
+#define APP_LATENCY_GAMING_RX_QUEUE     CONFIG_LATENCY_GAMING_RX_QUEUE
+#define APP_LATENCY_HIFI_JB_MS          CONFIG_LATENCY_HIFI_JB_MS
+#else
+#define APP_LATENCY_PROFILES    0
+#endif
+#ifdef CONFIG_DELAY_REPORT
+#define APP_DELAY_REPORT        1
+#define APP_DELAY_REPORT_STEP_MS CONFIG_DELAY_REPORT_STEP_MS
+#else
+#define APP_DELAY_REPORT        0
+#endif
+#ifdef CONFIG_AUDIO_PERF_TRACE
+#define APP_AUDIO_PERF_TRACE    1
+#else
+#define APP_AUDIO_PERF_TRACE    0
+#endif
+#ifdef CONFIG_AUDIO_LATENCY_PROBE
+#define APP_AUDIO_LATENCY_PROBE 1
+#else
+#define APP_AUDIO_LATENCY_PROBE 0
+#endif
+#ifdef CONFIG_STATIC_ALLOCATION
+#define APP_STATIC_ALLOCATION   1
+#define APP_STATIC_ARENA_INTERNAL_KB CONFIG_STATIC_ARENA_INTERNAL_KB
+#ifdef CONFIG_STATIC_ARENA_PSRAM_KB
+#define APP_STATIC_ARENA_PSRAM_KB CONFIG_STATIC_ARENA_PSRAM_KB
+#endif
+#else
+#define APP_STATIC_ALLOCATION   0
+#endif
+
+// Jitter Buffer Configuration (per-codec target latency in ms)
+#ifdef CONFIG_JITTER_BUFFER_ENABLE
+#define APP_JITTER_BUFFER_ENABLE    1
+#else
+#define APP_JITTER_BUFFER_ENABLE    0
+#endif
+#define APP_JB_TARGET_SBC_MS        CONFIG_JITTER_TARGET_SBC_MS
+#define APP_JB_TARGET_AAC_MS        CONFIG_JITTER_TARGET_AAC_MS
+#define APP_JB_TARGET_APTX_MS       CONFIG_JITTER_TARGET_APTX_MS
+#define APP_JB_TARGET_APTX_LL_MS    CONFIG_JITTER_TARGET_APTX_LL_MS
+#define APP_JB_TARGET_APTX_HD_MS    CONFIG_JITTER_TARGET_APTX_HD_MS
+#define APP_JB_TARGET_LDAC_MS       CONFIG_JITTER_TARGET_LDAC_MS
+#define APP_JB_TARGET_OPUS_MS       CONFIG_JITTER_TARGET_OPUS_MS
+#define APP_JB_TARGET_LC3PLUS_MS    CONFIG_JITTER_TARGET_LC3PLUS_MS
+#ifdef CONFIG_DRIFT_COMP_ENABLE
+#define APP_DRIFT_COMP_ENABLE       1
+#else
+#define APP_DRIFT_COMP_ENABLE       0
+#endif
+#ifdef CONFIG_CODEC_BRIDGE
+#define APP_CODEC_BRIDGE            1
+#define APP_CODEC_BRIDGE_MS         CONFIG_CODEC_BRIDGE_MS
+#else
+#define APP_CODEC_BRIDGE            0
+#define APP_CODEC_BRIDGE_MS         0
+#endif
+
+// Power Management
+#if defined(CONFIG_POWER_SAVE_ENABLE) && defined(CONFIG_PM_ENABLE)
+#define APP_POWER_SAVE          1
+#define APP_POWER_MIN_FREQ_MHZ  CONFIG_POWER_MIN_FREQ_MHZ
+#define APP_POWER_I2S_PARK_MS   CONFIG_POWER_I2S_PARK_MS
+#ifdef CONFIG_FREERTOS_USE_TICKLESS_IDLE
+#define APP_POWER_LIGHT_SLEEP   1
+#else
+#define APP_POWER_LIGHT_SLEEP   0
+#endif
+#else
+#define APP_POWER_SAVE          0
+#define APP_POWER_LIGHT_SLEEP   0
+#endif
+#if APP_POWER_SAVE && defined(CONFIG_STREAM_CLOCK_SCALING)
+#define APP_STREAM_CLOCK        1
+#define APP_STREAM_CLOCK_LIGHT_MHZ CONFIG_STREAM_CLOCK_LIGHT_MHZ
+#else
+#define APP_STREAM_CLOCK        0
+#endif
+#define APP_AUDIO_IDLE_WAIT_MS  1000    // Audio task wait with nothing playing (power save)
+#ifdef CONFIG_PAGE_SCAN_POLICY
+#define APP_PAGE_SCAN_POLICY    1
+#define APP_PAGE_SCAN_FAST_S    CONFIG_PAGE_SCAN_FAST_S
+#define APP_PAGE_SCAN_SLOW_AFTER_S CONFIG_PAGE_SCAN_SLOW_AFTER_S
+#else
+#define APP_PAGE_SCAN_POLICY    0
+#endif
+
+// Multi-room Sync
+#if defined(CONFIG_SYNC_ROLE_MASTER) || defined(CONFIG_SYNC_ROLE_FOLLOWER)
+#define APP_SYNC_ENABLE         1
+#ifdef CONFIG_SYNC_ROLE_MASTER
+#define APP_SYNC_MASTER         1
+#else
+#define APP_SYNC_MASTER         0
+#endif
+#define APP_SYNC_WIFI_SSID      CONFIG_SYNC_WIFI_SSID
+#define APP_SYNC_WIFI_PASSWORD  CONFIG_SYNC_WIFI_PASSWORD
+#define APP_SYNC_GROUP          CONFIG_SYNC_GROUP
+#define APP_SYNC_PORT           CONFIG_SYNC_PORT
+#else
+#define APP_SYNC_ENABLE         0
+#define APP_SYNC_MASTER         0
+#endif
+#ifdef CONFIG_SYNC_TWS
+#define APP_SYNC_TWS            1
+#else
+#define APP_SYNC_TWS            0
+#endif
+#ifdef CONFIG_SYNC_TWS_LEFT
+#define APP_SYNC_TWS_LEFT       1
+#else
+#define APP_SYNC_TWS_LEFT       0
+#endif
+#ifdef CONFIG_SYNC_RELAY
+#define APP_SYNC_RELAY          1
+#else
+#define APP_SYNC_RELAY          0
+#endif
+#ifdef CONFIG_SYNC_MAX_FOLLOWERS
+#define APP_SYNC_MAX_FOLLOWERS  CONFIG_SYNC_MAX_FOLLOWERS
+#else
+#define APP_SYNC_MAX_FOLLOWERS  0
+#endif
+
+// WiFi ingest (lossless PCM over RTP/UDP, see net_ingest.h)
+#ifdef CONFIG_NET_INGEST_ENABLE
+#define APP_NET_INGEST                  1
+#define APP_NET_INGEST_WIFI_SSID        CONFIG_NET_INGEST_WIFI_SSID
+#define APP_NET_INGEST_WIFI_PASSWORD    CONFIG_NET_INGEST_WIFI_PASSWORD
+#define APP_NET_INGEST_PORT             CONFIG_NET_INGEST_PORT
+#define APP_NET_INGEST_TARGET_MS        CONFIG_NET_INGEST_TARGET_MS
+#else
+#define APP_NET_INGEST                  0
+#endif
+
+// Hands-free (HFP); Bluedroid's codec, PCM over HCI
+#if defined(CONFIG_HFP_ENABLE) && defined(CONFIG_BT_HFP_CLIENT_ENABLE) && defined(CONFIG_BT_HFP_AUDIO_DATA_PATH_HCI)
+#ifdef CONFIG_BT_HFP_USE_EXTERNAL_CODEC
+#error "HFP_ENABLE needs Bluedroid's mSBC codec: unset BT_HFP_USE_EXTERNAL_CODEC"
+#endif
+#define APP_HFP                 1
+#define APP_HFP_MIC_I2S_PORT    I2S_NUM_0
+#define APP_HFP_MIC_BCK_PIN     CONFIG_HFP_MIC_BCK_PIN
+#define APP_HFP_MIC_WS_PIN      CONFIG_HFP_MIC_WS_PIN
+#define APP_HFP_MIC_DATA_PIN    CONFIG_HFP_MIC_DATA_PIN
+#define APP_HFP_AEC_TAPS        CONFIG_HFP_AEC_TAPS
+#define APP_HFP_DSP_BUDGET_PCT  CONFIG_HFP_DSP_BUDGET_PCT
+#define APP_HFP_RTT_TARGET_MS   CONFIG_HFP_RTT_TARGET_MS
+#else
+#define APP_HFP                 0
+#endif
 
 // NVS Keys (not configurable, internal constants)
 #define NVS_NAMESPACE           "audio"
@@ -49,6 +578,17 @@
 #define NVS_KEY_EQ_BASS         "eq_bass"
 #define NVS_KEY_EQ_MID          "eq_mid"
 #define NVS_KEY_EQ_TREB         "eq_treb"
+#define NVS_KEY_PEQ             "peq"
+#define NVS_KEY_CODEC_POLICY    "codec_pol"
+#define NVS_KEY_PEER_STREAMS    "peer_fmt"
+#define NVS_KEY_PRESETS         "presets"
+#define NVS_KEY_OUT_LAYOUT      "out_layout"
+#define NVS_KEY_DSP_GRAPH       "dsp_graph"
+#define NVS_KEY_OTA_SESSION     "ota_sess"  // Resumable OTA progress, see OtaSession
+#define NVS_KEY_SETTINGS        "cfg"       // Packed scalar settings, see NVSSettings
+
+// Staged settings reach flash this long after the last change
+#define APP_SETTINGS_WRITE_DELAY_MS 3000
 
 // DSP Constants (fixed, not configurable)
 #define DSP_BASS_GAIN_BASE      1.0f
@@ -77,9 +617,53 @@
 #define BLE_UNIFIED_CHAR_STATUS   "12345678-1234-1234-1234-123456789002"
 #define BLE_UNIFIED_CHAR_METER    "12345678-1234-1234-1234-123456789003"
 
+// LE L2CAP bulk channel (uploads, capture downloads)
+#ifdef CONFIG_BLE_BULK_CHANNEL
+#define APP_BLE_BULK_CHANNEL        1
+#define APP_BLE_BULK_PSM            CONFIG_BLE_BULK_PSM
+#define APP_BLE_BULK_MTU            CONFIG_BLE_BULK_MTU
+#else
+#define APP_BLE_BULK_CHANNEL        0
+#define APP_BLE_BULK_PSM            0
+#define APP_BLE_BULK_MTU            0
+#endif
+#ifdef CONFIG_AVRCP_QUEUE
+#define APP_AVRCP_QUEUE             1
+#define APP_AVRCP_VOLUME_INTERVAL_MS CONFIG_AVRCP_VOLUME_INTERVAL_MS
+#else
+#define APP_AVRCP_QUEUE             0
+#define APP_AVRCP_VOLUME_INTERVAL_MS 0
+#endif
+
 // OTA Constants
-#define APP_OTA_ACK_INTERVAL        4096
+#define APP_OTA_WINDOW_CHUNKS       32      // Windowed OTA: chunks in flight past the last ack
+#define APP_OTA_ACK_EVERY           8       // Windowed OTA: ack after this many chunks
 #define APP_OTA_PRE_BEGIN_BUFFER    CONFIG_OTA_BUFFER_SIZE
+#ifdef CONFIG_OTA_RESUME
+#define APP_OTA_RESUME              1
+#define APP_OTA_RESUME_CHECKPOINT   ((CONFIG_OTA_RESUME_CHECKPOINT_KB / 4) * 4096)
+#else
+#define APP_OTA_RESUME              0
+#define APP_OTA_RESUME_CHECKPOINT   0
+#endif
+#ifdef CONFIG_OTA_DEFERRED_VALIDATION
+#define APP_OTA_DEFERRED_VALIDATION 1
+#define APP_OTA_VALIDATE_MS         (CONFIG_OTA_VALIDATE_MINUTES * 60000u)
+#ifdef CONFIG_OTA_VALIDATE_IMAGE_HASH
+#define APP_OTA_VALIDATE_IMAGE_HASH 1
+#else
+#define APP_OTA_VALIDATE_IMAGE_HASH 0
+#endif
+#else
+#define APP_OTA_DEFERRED_VALIDATION 0
+#define APP_OTA_VALIDATE_MS         0
+#define APP_OTA_VALIDATE_IMAGE_HASH 0
+#endif
+#ifdef CONFIG_PSRAM_MODE
+#define APP_OTA_STAGING_BYTES       (64 * 1024)     // Received, not yet in flash (power of two)
+#else
+#define APP_OTA_STAGING_BYTES       (16 * 1024)
+#endif
 
 // PSRAM mode flag
 #ifdef CONFIG_PSRAM_MODE
@@ -0,0 +1,126 @@
+#pragma once
+
+/*
+ * boot_graph.h
+ *
+ * Startup stages for app_main. A stage runs on its own short-lived task as
+ * soon as the stages it depends on are done, so independent bring-up work
+ * (flash mount, I2S, Bluetooth) overlaps across both cores. Completion is
+ * an event group bit: app_main waits only for the stages it needs next.
+ *
+ * Start and end of each stage are recorded for the boot trace. Times are
+ * esp_timer time, which starts in the app's startup code; ROM and
+ * second-stage bootloader time come before it.
+ */
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+enum BootStage : uint8_t {
+    BOOT_NVS = 0,       // NVS and settings
+    BOOT_STORAGE,       // SPIFFS, sound files, saved FIR IR
+    BOOT_AUDIO_OUT,     // I2S, pipeline, overlay mixer
+    BOOT_LED,           // LED driver and saved LED settings
+    BOOT_BT,            // BLE and A2DP up, connectable
+    BOOT_STAGE_COUNT
+};
+
+class BootGraph {
+public:
+    using StageFn = bool (*)();
+
+    static constexpr EventBits_t bit(BootStage s) { return (EventBits_t)1 << s; }
+
+    BootGraph() : m_events(xEventGroupCreateStatic(&m_eventsBuf)) {}
+
+    // Runs fn on a new task once every stage in `after` is done
+    void spawn(BootStage s, const char* name, StageFn fn, EventBits_t after,
+               uint32_t stackSize, int core) {
+        Stage& st = m_stages[s];
+        st.name = name;
+        st.fn = fn;
+        st.after = after;
+        st.graph = this;
+        if (xTaskCreatePinnedToCore(stageTask, name, stackSize, &st, 5, nullptr, core) != pdPASS) {
+            ESP_LOGE("Boot", "%s: task create failed, running inline", name);
+            run(st);
+        }
+    }
+
+    // Stage run by the caller itself
+    void begin(BootStage s, const char* name) {
+        m_stages[s].name = name;
+        m_stages[s].startUs = esp_timer_get_time();
+    }
+
+    void end(BootStage s, bool ok = true) {
+        m_stages[s].endUs = esp_timer_get_time();
+        m_stages[s].ok = ok;
+        xEventGroupSetBits(m_events, bit(s));
+    }
+
+    // Blocks until every stage in the mask is done; false if one failed
+    bool wait(EventBits_t stages) {
+        xEventGroupWaitBits(m_events, stages, pdFALSE, pdTRUE, portMAX_DELAY);
+        for (int i = 0; i < BOOT_STAGE_COUNT; i++) {
+            if ((stages & bit((BootStage)i)) && !m_stages[i].ok) return false;
+        }
+        return true;
+    }
+
+    // Without blocking: every stage in the mask done and none failed
+    bool succeeded(EventBits_t stages) const {
+        for (int i = 0; i < BOOT_STAGE_COUNT; i++) {
+            if ((stages & bit((BootStage)i)) && !(m_stages[i].endUs && m_stages[i].ok)) return false;
+        }
+        return true;
+    }
+
+    // One line per finished stage, then time to connectable
+    void log(const char* tag) const {
+        for (int i = 0; i < BOOT_STAGE_COUNT; i++) {
+            const Stage& st = m_stages[i];
+            if (!st.name || !st.endUs) continue;
+            ESP_LOGI(tag, "Boot: %-10s %5u - %5u ms%s", st.name,
+                     (unsigned)(st.startUs / 1000), (unsigned)(st.endUs / 1000),
+                     st.ok ? "" : " (failed)");
+        }
+        if (m_stages[BOOT_BT].endUs) {
+            ESP_LOGI(tag, "Boot: connectable at %u ms", (unsigned)(m_stages[BOOT_BT].endUs / 1000));
+        }
+    }
+
+private:
+    struct Stage {
+        const char* name = nullptr;
+        StageFn fn = nullptr;
+        EventBits_t after = 0;
+        BootGraph* graph = nullptr;
+        int64_t startUs = 0;
+        int64_t endUs = 0;
+        bool ok = false;
+    };
+
+    void run(Stage& st) {
+        if (st.after) {
+            xEventGroupWaitBits(m_events, st.after, pdFALSE, pdTRUE, portMAX_DELAY);
+        }
+        st.startUs = esp_timer_get_time();
+        bool ok = st.fn();
+        end((BootStage)(&st - m_stages), ok);
+    }
+
+    static void stageTask(void* arg) {
+        Stage* st = static_cast<Stage*>(arg);
+        st->graph->run(*st);
+        vTaskDelete(nullptr);
+    }
+
+    StaticEventGroup_t m_eventsBuf;
+    EventGroupHandle_t m_events;
+    Stage m_stages[BOOT_STAGE_COUNT];
+};
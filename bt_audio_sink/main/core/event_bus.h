@@ -0,0 +1,152 @@
+#pragma once
+
+/*
+ * event_bus.h
+ *
+ * Typed events between tasks, for edges that used to be handed over in
+ * a global flag the receiver polled (the beat flag the LED task read
+ * every frame, g_otaActive in the beat task). A task subscribes once
+ * with the events it wants and gets a mailbox; publish() puts the event
+ * into every interested mailbox and gives that task a notification, so
+ * a task blocked in ulTaskNotifyTake() reacts at once. Each event is
+ * taken exactly once; one that finds a mailbox full is counted as lost
+ * there rather than blocking the publisher.
+ *
+ * State that a task needs whenever it looks (connected, streaming) stays
+ * where it is; the bus carries the changes.
+ *
+ * publish(): any task, never an ISR. take(): the subscribing task only.
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+enum BusEvent : uint8_t {
+    BUS_CONNECTED,          // A2DP link up
+    BUS_DISCONNECTED,
+    BUS_CODEC_CONFIGURED,   // arg: sample rate
+    BUS_STREAM_STARTED,
+    BUS_STREAM_STOPPED,
+    BUS_OTA_BEGIN,
+    BUS_OTA_END,
+    BUS_BEAT,               // arg: esp_timer time (us) it is heard
+    BUS_VOLUME_CHANGED,     // arg: AVRCP volume 0-127
+    BUS_EVENT_COUNT
+};
+static_assert(BUS_EVENT_COUNT <= 32, "bus events are a 32-bit mask");
+
+#define BUS_MASK(ev) (1u << (ev))
+
+struct BusMsg {
+    uint32_t arg;
+    BusEvent type;
+};
+
+class EventBus {
+public:
+    static constexpr int MAX_SUBSCRIBERS = 4;
+    static constexpr uint32_t MAILBOX_SLOTS = 16;   // Power of two
+
+    // Bounded MPSC queue: publishers claim a cell by moving the head,
+    // each cell's sequence number says whose turn it is
+    class Mailbox {
+    public:
+        // Next event, oldest first; false when empty
+        bool take(BusMsg& msg) {
+            Cell& c = m_cells[m_tail & (MAILBOX_SLOTS - 1)];
+            if ((int32_t)(c.seq.load(std::memory_order_acquire) - (m_tail + 1)) < 0) return false;
+            msg = c.msg;
+            c.seq.store(m_tail + MAILBOX_SLOTS, std::memory_order_release);
+            m_tail++;
+            return true;
+        }
+
+        // Events that found this mailbox full
+        uint32_t lost() const { return m_lost.load(std::memory_order_relaxed); }
+
+    private:
+        friend class EventBus;
+        struct Cell {
+            std::atomic<uint32_t> seq;
+            BusMsg msg;
+        };
+
+        void init(uint32_t mask, TaskHandle_t task) {
+            for (uint32_t i = 0; i < MAILBOX_SLOTS; i++) m_cells[i].seq.store(i, std::memory_order_relaxed);
+            m_mask = mask;
+            m_task = task;
+        }
+
+        bool put(const BusMsg& msg) {
+            uint32_t pos = m_head.load(std::memory_order_relaxed);
+            Cell* c;
+            while (true) {
+                c = &m_cells[pos & (MAILBOX_SLOTS - 1)];
+                const int32_t diff = (int32_t)(c->seq.load(std::memory_order_acquire) - pos);
+                if (diff == 0) {
+                    if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    m_lost.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                } else {
+                    pos = m_head.load(std::memory_order_relaxed);
+                }
+            }
+            c->msg = msg;
+            c->seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        Cell m_cells[MAILBOX_SLOTS];
+        std::atomic<uint32_t> m_head{0};
+        uint32_t m_tail = 0;
+        std::atomic<uint32_t> m_lost{0};
+        uint32_t m_mask = 0;
+        TaskHandle_t m_task = nullptr;
+    };
+
+    static EventBus& getInstance() {
+        static EventBus instance;
+        return instance;
+    }
+
+    // The calling task's mailbox for the events in mask (BUS_MASK()s);
+    // null when all are taken. Once per task, at its start.
+    Mailbox* subscribe(uint32_t mask) {
+        const int i = m_claimed.fetch_add(1);
+        if (i >= MAX_SUBSCRIBERS) {
+            ESP_LOGE(TAG, "No mailbox left (events 0x%08x)", (unsigned)mask);
+            return nullptr;
+        }
+        m_boxes[i].init(mask, xTaskGetCurrentTaskHandle());
+        // Published from here on: the mailbox is complete before it counts
+        int expected = i;
+        while (!m_count.compare_exchange_weak(expected, i + 1, std::memory_order_release)) {
+            expected = i;
+            taskYIELD();
+        }
+        return &m_boxes[i];
+    }
+
+    void publish(BusEvent type, uint32_t arg = 0) {
+        const BusMsg msg = { arg, type };
+        const int n = m_count.load(std::memory_order_acquire);
+        for (int i = 0; i < n; i++) {
+            Mailbox& box = m_boxes[i];
+            if (!(box.m_mask & BUS_MASK(type))) continue;
+            if (box.put(msg)) xTaskNotifyGive(box.m_task);
+        }
+    }
+
+private:
+    static constexpr const char* TAG = "EventBus";
+
+    EventBus() = default;
+
+    Mailbox m_boxes[MAX_SUBSCRIBERS];
+    std::atomic<int> m_claimed{0};
+    std::atomic<int> m_count{0};
+};
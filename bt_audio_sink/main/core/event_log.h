@@ -0,0 +1,190 @@
+#pragma once
+
+/*
+ * event_log.h
+ *
+ * Binary event log for the real-time paths. The decoder, audio_tx and the
+ * stack's hooks must not format strings: a burst of drop warnings would
+ * push kilobytes through vprintf and the UART exactly when the pipeline is
+ * already behind. logEvent() instead stores a fixed record - event id,
+ * microsecond timestamp, three integer arguments - into a RAM ring: one
+ * relaxed fetch_add for the slot and five word stores, no lock, from any
+ * task. The sequence number goes in last, as in GlitchJournal, so the
+ * reader skips a slot that is still being written.
+ *
+ * A priority 1 task drains the ring every DRAIN_MS and prints the new
+ * records as base64 console lines,
+ *
+ *   ELOG:<base64 of 16-byte records>
+ *
+ * which tools/event_log_decode.py turns back into text with the formats
+ * in EVENT_LOG_EVENTS below. Records the ring overwrote before they were
+ * drained come out as one EV_LOST record with their count.
+ *
+ * Record, 16 bytes little endian:
+ *   [time_us u32, id u16, a0 u16, a1 u32, a2 u32]
+ *
+ * The ids and logEvent() are always declared, so hot paths call it
+ * unconditionally; without APP_EVENT_LOG it compiles to nothing.
+ */
+
+#include <stdint.h>
+#include "../config/app_config.h"
+
+// id, host format: a0, a1, a2 in that order; a0 is 16 bits, so counts
+// that may grow larger and rates go in a1/a2
+#define EVENT_LOG_EVENTS(X)                                                           \
+    X(EV_LOST,               "%u events lost (ring full before the drain)")           \
+    X(EV_PIPELINE_DROP,      "ring full at %u ms queued: drop %u, %u frames lost")    \
+    X(EV_STACK_LOSS,         "stack media loss reason %u: %u packets, %u ms queued")  \
+    X(EV_OUTPUT_RATE,        "output (passthrough %u): %u -> %u Hz")                  \
+    X(EV_FAST_RING_RELEASED, "low-bitrate ring released under memory pressure")       \
+    X(EV_I2S_PARKED,         "idle: I2S parked")                                      \
+    X(EV_CAPTURE_FROZEN,     "PCM capture frozen (reason %u), %u KB")                 \
+    X(EV_TRACE,              "perf trace %u (1 start, 0 stop) after %u ms")           \
+    X(EV_TRACE_POINT,        "trace point %u: p99 %u us, max %u us")                  \
+    X(EV_STREAM_BRIDGED,     "stream end held: %u ms at %u Hz")
+
+enum EventId : uint16_t {
+#define EVENT_LOG_ID(id, fmt) id,
+    EVENT_LOG_EVENTS(EVENT_LOG_ID)
+#undef EVENT_LOG_ID
+    EV_COUNT
+};
+
+#if APP_EVENT_LOG
+
+#include <string.h>
+#include <stdio.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mbedtls/base64.h"
+#include "static_alloc.h"
+
+class EventLog {
+public:
+    static constexpr uint32_t ENTRIES = APP_EVENT_LOG_ENTRIES;
+    static constexpr size_t RECORD_BYTES = 16;
+    static constexpr uint32_t DRAIN_MS = 250;
+    static constexpr int LINE_RECORDS = 24;     // 384 bytes, 512 as base64
+    static_assert((ENTRIES & (ENTRIES - 1)) == 0, "event log size must be a power of two");
+
+    static EventLog& getInstance() {
+        static EventLog instance;
+        return instance;
+    }
+
+    // At boot: starts the drain task. Records logged before are kept.
+    bool begin(BaseType_t core) {
+        if (m_started) return true;
+        m_started = StaticAlloc::createTask(drainTask, "evt_log", 3072, this, 1, nullptr, core) == pdPASS;
+        if (!m_started) ESP_LOGE(TAG, "Drain task not started");
+        return m_started;
+    }
+
+    void log(EventId id, uint32_t a0, uint32_t a1, uint32_t a2) {
+        const uint32_t seq = m_next.fetch_add(1, std::memory_order_relaxed) + 1;
+        Entry& e = m_entries[seq & (ENTRIES - 1)];
+        e.seq = 0;
+        e.timeUs = (uint32_t)esp_timer_get_time();
+        e.head = (uint32_t)id | (a0 < 0xFFFF ? a0 : 0xFFFF) << 16;
+        e.a1 = a1;
+        e.a2 = a2;
+        std::atomic_signal_fence(std::memory_order_release);
+        e.seq = seq;
+    }
+
+private:
+    static constexpr const char* TAG = "EvtLog";
+
+    struct Entry {
+        volatile uint32_t seq;      // 0 = empty or being written
+        volatile uint32_t timeUs;
+        volatile uint32_t head;     // id u16, a0 u16
+        volatile uint32_t a1;
+        volatile uint32_t a2;
+    };
+
+    EventLog() = default;
+
+    static void drainTask(void* arg) {
+        EventLog* self = static_cast<EventLog*>(arg);
+        while (true) {
+            vTaskDelay(pdMS_TO_TICKS(DRAIN_MS));
+            self->drain();
+        }
+    }
+
+    // Drain task only: everything up to the newest complete record
+    void drain() {
+        const uint32_t last = m_next.load(std::memory_order_relaxed);
+        if (last > ENTRIES && m_read < last - ENTRIES) {
+            m_lost += last - ENTRIES - m_read;      // Lapped: overwritten unread
+            m_read = last - ENTRIES;
+        }
+        while (m_read < last) {
+            const uint32_t seq = m_read + 1;
+            const Entry& e = m_entries[seq & (ENTRIES - 1)];
+            if (e.seq < seq) break;                 // Still being written
+            const uint32_t rec[4] = { e.timeUs, e.head, e.a1, e.a2 };
+            std::atomic_signal_fence(std::memory_order_acquire);
+            m_read = seq;
+            if (e.seq != seq) {                     // Overwritten, before or while copied
+                m_lost++;
+                continue;
+            }
+            if (m_lost > 0) {
+                append(rec[0], EV_LOST | (m_lost < 0xFFFF ? m_lost : 0xFFFF) << 16, 0, 0);
+                m_lost = 0;
+            }
+            append(rec[0], rec[1], rec[2], rec[3]);
+        }
+        if (m_lineRecords > 0) emit();
+    }
+
+    void append(uint32_t timeUs, uint32_t head, uint32_t a1, uint32_t a2) {
+        if (m_lineRecords == LINE_RECORDS) emit();
+        uint8_t* r = m_line + m_lineRecords++ * RECORD_BYTES;
+        put32(r, timeUs);
+        put32(r + 4, head);
+        put32(r + 8, a1);
+        put32(r + 12, a2);
+    }
+
+    void emit() {
+        size_t len = 0;
+        const int err = mbedtls_base64_encode(m_text, sizeof(m_text), &len, m_line,
+                                              (size_t)m_lineRecords * RECORD_BYTES);
+        m_lineRecords = 0;
+        if (err == 0) printf("ELOG:%.*s\n", (int)len, (const char*)m_text);
+    }
+
+    static void put32(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+
+    Entry m_entries[ENTRIES] = {};
+    std::atomic<uint32_t> m_next{0};    // Last sequence number used
+    uint32_t m_read = 0;                // Last one drained (drain task)
+    uint32_t m_lost = 0;                // Not yet reported
+    bool m_started = false;
+    int m_lineRecords = 0;
+    uint8_t m_line[LINE_RECORDS * RECORD_BYTES];
+    uint8_t m_text[(LINE_RECORDS * RECORD_BYTES + 2) / 3 * 4 + 1];
+};
+
+static inline void logEvent(EventId id, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0) {
+    EventLog::getInstance().log(id, a0, a1, a2);
+}
+
+#else
+
+static inline void logEvent(EventId, uint32_t = 0, uint32_t = 0, uint32_t = 0) {}
+
+#endif // APP_EVENT_LOG
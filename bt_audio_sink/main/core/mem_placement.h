@@ -0,0 +1,200 @@
+#pragma once
+
+/*
+ * mem_placement.h
+ *
+ * One placement policy for the heap buffers of the subsystems, instead of
+ * a fallback ladder written out at every call site. A buffer is asked for
+ * with its owner, the region it prefers, a priority and the caps it cannot
+ * do without, and goes down its region's ladder:
+ *
+ *   MEM_DMA       DMA-capable internal, internal, PSRAM
+ *   MEM_INTERNAL  internal, PSRAM
+ *   MEM_PSRAM     PSRAM, internal
+ *
+ * (required caps are added to every step, so a DMA descriptor buffer
+ * never lands outside DMA memory.)
+ *
+ * Internal RAM is budgeted. An owner may hold up to its budget
+ * (MEM_BUDGET_*_KB), and no step below MEM_PRIO_CRITICAL goes internal if
+ * that would leave less than APP_MEM_BT_RESERVE_KB free: the Bluetooth
+ * controller and host allocate at runtime and are what fails when boot
+ * buffers took everything. A step over budget is skipped, so the buffer
+ * lands further down its ladder or not at all. Critical buffers, without
+ * which nothing plays, only follow the ladder.
+ *
+ * Placements resolve as the subsystems come up at boot, in main.cpp's
+ * order, and each one is recorded; report() logs the map and every
+ * owner's internal total against its budget. Buffers that come and go with
+ * the stream (the low-bitrate ring) are placed the same way on a codec
+ * change, against what the budgets leave then.
+ *
+ * Any task, never from the audio path's hot loop; release() is fine from
+ * the audio task (the table is under a spinlock, the heap calls are not).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "../config/app_config.h"
+
+enum MemOwner : uint8_t {
+    MEM_OWNER_AUDIO,        // Rings, output slots, work buffers
+    MEM_OWNER_DSP,          // Delay lines, FIR, coefficient bundles
+    MEM_OWNER_SOUND,        // Sound player and cache
+    MEM_OWNER_LED,          // LED driver DMA buffers
+    MEM_OWNER_OTHER,        // Uploads, OTA, the rest
+    MEM_OWNER_COUNT
+};
+
+enum MemRegion : uint8_t { MEM_DMA, MEM_INTERNAL, MEM_PSRAM };
+
+enum MemPriority : uint8_t {
+    MEM_PRIO_CRITICAL,      // Ignores budgets and the BT reserve
+    MEM_PRIO_NORMAL,        // Within budget and reserve
+    MEM_PRIO_OPTIONAL,      // Same; the caller copes without it
+};
+
+class MemPlacement {
+public:
+    static constexpr int MAX_ENTRIES = 32;
+
+    // Place a buffer; nullptr when no step of the ladder had room
+    static void* alloc(const char* name, MemOwner owner, size_t bytes, MemRegion prefer,
+                       MemPriority prio = MEM_PRIO_NORMAL, uint32_t required = 0) {
+        static const Step LADDERS[3][3] = {
+            { { MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL, true }, { MALLOC_CAP_INTERNAL, true },
+              { MALLOC_CAP_SPIRAM, false } },
+            { { MALLOC_CAP_INTERNAL, true }, { MALLOC_CAP_SPIRAM, false }, { 0, false } },
+            { { MALLOC_CAP_SPIRAM, false }, { MALLOC_CAP_INTERNAL, true }, { 0, false } },
+        };
+        for (const Step& step : LADDERS[prefer]) {
+            if (!step.caps) break;
+            if (step.internal && !internalFits(owner, bytes, prio)) continue;
+            void* p = heap_caps_malloc(bytes, step.caps | required | MALLOC_CAP_8BIT);
+            if (!p) continue;
+            note(name, owner, p, bytes, step.internal);
+            if (step.internal && step.caps != LADDERS[prefer][0].caps) {
+                ESP_LOGW(TAG, "%s: %u bytes in internal RAM, not the preferred region", name, (unsigned)bytes);
+            } else if (!step.internal && prefer != MEM_PSRAM) {
+                ESP_LOGW(TAG, "%s: %u bytes in PSRAM (internal over budget or full)", name, (unsigned)bytes);
+            }
+            return p;
+        }
+        ESP_LOGE(TAG, "%s: no room for %u bytes", name, (unsigned)bytes);
+        return nullptr;
+    }
+
+    // Free a buffer from alloc(); nullptr is ignored
+    static void release(void* p) {
+        if (!p) return;
+        portENTER_CRITICAL(&s_lock);
+        for (int i = 0; i < s_count; i++) {
+            if (s_entries[i].addr != p) continue;
+            if (s_entries[i].internal) s_internal[s_entries[i].owner] -= s_entries[i].bytes;
+            s_entries[i] = s_entries[--s_count];
+            break;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        heap_caps_free(p);
+    }
+
+    // Internal bytes an owner could still place at prio: what its budget
+    // and the BT reserve leave, and the largest free block
+    static size_t internalAvailable(MemOwner owner, MemPriority prio) {
+        const size_t free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        size_t avail = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (prio == MEM_PRIO_CRITICAL) return avail;
+        const size_t reserve = (size_t)APP_MEM_BT_RESERVE_KB * 1024;
+        const size_t aboveReserve = free > reserve ? free - reserve : 0;
+        const size_t budget = budgetBytes(owner);
+        const size_t used = s_internal[owner];
+        const size_t inBudget = budget > used ? budget - used : 0;
+        if (avail > aboveReserve) avail = aboveReserve;
+        if (avail > inBudget) avail = inBudget;
+        return avail;
+    }
+
+    static size_t internalUsed(MemOwner owner) { return s_internal[owner]; }
+
+    // Whether alloc() put p in internal RAM
+    static bool isInternal(const void* p) {
+        bool internal = false;
+        portENTER_CRITICAL(&s_lock);
+        for (int i = 0; i < s_count; i++) {
+            if (s_entries[i].addr == p) internal = s_entries[i].internal;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        return internal;
+    }
+
+    // Every placement, then each owner against its internal budget
+    static void report(const char* tag) {
+        static const char* const NAMES[MEM_OWNER_COUNT] = { "audio", "dsp", "sound", "led", "other" };
+        for (int i = 0; i < s_count; i++) {
+            const Entry& e = s_entries[i];
+            ESP_LOGI(tag, "  %-8s %-6s %p %7u  %s", e.internal ? "internal" : "psram", NAMES[e.owner],
+                     e.addr, (unsigned)e.bytes, e.name);
+        }
+        for (int o = 0; o < MEM_OWNER_COUNT; o++) {
+            ESP_LOGI(tag, "Internal budget %-5s: %u of %u KB", NAMES[o],
+                     (unsigned)(s_internal[o] / 1024), (unsigned)(budgetBytes((MemOwner)o) / 1024));
+        }
+    }
+
+private:
+    static constexpr const char* TAG = "MemPlace";
+
+    struct Step {
+        uint32_t caps;
+        bool internal;
+    };
+    struct Entry {
+        const char* name;
+        void* addr;
+        size_t bytes;
+        MemOwner owner;
+        bool internal;
+    };
+
+    static size_t budgetBytes(MemOwner owner) {
+        static const uint16_t KB[MEM_OWNER_COUNT] = {
+            APP_MEM_BUDGET_AUDIO_KB, APP_MEM_BUDGET_DSP_KB, APP_MEM_BUDGET_SOUND_KB,
+            APP_MEM_BUDGET_LED_KB, APP_MEM_BUDGET_OTHER_KB,
+        };
+        return (size_t)KB[owner] * 1024;
+    }
+
+    static bool internalFits(MemOwner owner, size_t bytes, MemPriority prio) {
+        if (prio == MEM_PRIO_CRITICAL) return true;
+        if (s_internal[owner] + bytes > budgetBytes(owner)) return false;
+        const size_t free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        return free >= bytes + (size_t)APP_MEM_BT_RESERVE_KB * 1024;
+    }
+
+    // Only recorded placements count against a budget, so release()
+    // always finds what it has to give back
+    static void note(const char* name, MemOwner owner, void* p, size_t bytes, bool internal) {
+        bool full;
+        portENTER_CRITICAL(&s_lock);
+        full = s_count >= MAX_ENTRIES;
+        if (!full) {
+            s_entries[s_count++] = { name, p, bytes, owner, internal };
+            if (internal) s_internal[owner] += bytes;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        if (full) ESP_LOGW(TAG, "%s: placement table full, not budgeted", name);
+    }
+
+    static portMUX_TYPE s_lock;
+    static Entry s_entries[MAX_ENTRIES];
+    static int s_count;
+    static size_t s_internal[MEM_OWNER_COUNT];
+};
+
+inline portMUX_TYPE MemPlacement::s_lock = portMUX_INITIALIZER_UNLOCKED;
+inline MemPlacement::Entry MemPlacement::s_entries[MemPlacement::MAX_ENTRIES];
+inline int MemPlacement::s_count = 0;
+inline size_t MemPlacement::s_internal[MEM_OWNER_COUNT] = {};
@@ -0,0 +1,172 @@
+#pragma once
+
+/*
+ * page_scan_policy.h
+ *
+ * Page scan parameters by time since the last disconnect. Stack defaults
+ * scan 11.25 ms every 1.28 s whether a phone is about to come back or the
+ * speaker has been idle all day. Reconnects cluster right after power-on
+ * and after a link drops, so the radio scans almost continuously for
+ * APP_PAGE_SCAN_FAST_S, then steps back:
+ *
+ *   FAST    interlaced, 22.5 ms    up to APP_PAGE_SCAN_FAST_S
+ *   MEDIUM  interlaced, 320 ms     up to 4 x APP_PAGE_SCAN_FAST_S
+ *   IDLE    interlaced, 1.28 s     up to APP_PAGE_SCAN_SLOW_AFTER_S
+ *   DEEP    interlaced, 2.56 s     from then on
+ *
+ * Interlaced scan listens on both page train halves in one interval, so a
+ * phone is found within one interval whichever train it starts with. The
+ * window is always the minimum; only the interval moves. While connected
+ * the scan is the standard 1.28 s one (a takeover still gets through, the
+ * stream keeps its air time). forceFast() (BLE, pairing mode) opens a fast
+ * window from any state; afterwards the ladder carries on from where the
+ * clock is.
+ *
+ * Calls come from the BT, BLE, encoder and esp_timer tasks; one mutex
+ * covers the state and the stack call, so parameters always go out in
+ * the order they were decided. The stack keeps them across visibility
+ * changes (esp_bt_gap_set_page_scan_param).
+ */
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_gap_bt_api.h"
+#include "../config/app_config.h"
+
+class PageScanPolicy {
+public:
+    enum Stage : uint8_t { FAST, MEDIUM, IDLE, DEEP, CONNECTED, NONE };
+
+    static PageScanPolicy& getInstance() {
+        static PageScanPolicy instance;
+        return instance;
+    }
+
+    // After the stack is up: power-on counts as a disconnect
+    void begin() {
+        if (m_timer) return;
+        esp_timer_create_args_t args = {};
+        args.callback = onTimer;
+        args.arg = this;
+        args.name = "pscan";
+        if (!m_lock || esp_timer_create(&args, &m_timer) != ESP_OK) {
+            m_timer = nullptr;
+            ESP_LOGE(TAG, "Timer create failed - stack defaults stay");
+            return;
+        }
+        onDisconnected();
+    }
+
+    void onDisconnected() {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        m_connected = false;
+        m_epochUs = esp_timer_get_time();
+        m_fastUntilUs = 0;
+        update();
+        xSemaphoreGive(m_lock);
+    }
+
+    void onConnected() {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        m_connected = true;
+        m_fastUntilUs = 0;
+        update();
+        xSemaphoreGive(m_lock);
+    }
+
+    // Fast scan for seconds (0 = APP_PAGE_SCAN_FAST_S), connected or not
+    void forceFast(uint32_t seconds) {
+        if (seconds == 0) seconds = APP_PAGE_SCAN_FAST_S;
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        m_fastUntilUs = esp_timer_get_time() + (int64_t)seconds * 1000000;
+        update();
+        xSemaphoreGive(m_lock);
+    }
+
+    Stage stage() const { return m_stage; }
+
+private:
+    static constexpr const char* TAG = "PSCAN";
+
+    struct Params {
+        esp_bt_page_scan_type_t type;
+        uint16_t interval;          // 0.625 ms slots
+        uint16_t window;
+        const char* name;
+    };
+    static constexpr uint16_t WINDOW = 0x0012;     // 11.25 ms, the stack default
+
+    static const Params& params(Stage s) {
+        static const Params TABLE[] = {
+            { ESP_BT_PAGE_SCAN_INTERLACED, 0x0024, WINDOW, "fast" },
+            { ESP_BT_PAGE_SCAN_INTERLACED, 0x0200, WINDOW, "medium" },
+            { ESP_BT_PAGE_SCAN_INTERLACED, 0x0800, WINDOW, "idle" },
+            { ESP_BT_PAGE_SCAN_INTERLACED, 0x1000, WINDOW, "deep" },
+            { ESP_BT_PAGE_SCAN_STANDARD,   0x0800, WINDOW, "connected" },
+        };
+        return TABLE[s];
+    }
+
+    PageScanPolicy() { m_lock = xSemaphoreCreateMutex(); }
+
+    // Under m_lock: stage for now, applied if it changed, timer to the next
+    void update() {
+        if (!m_timer) return;
+        const int64_t now = esp_timer_get_time();
+        int64_t untilUs = 0;        // 0 = no change due
+        Stage s;
+        if (m_fastUntilUs > now) {
+            s = FAST;
+            untilUs = m_fastUntilUs;
+        } else if (m_connected) {
+            s = CONNECTED;
+        } else {
+            const int64_t ends[] = {
+                m_epochUs + (int64_t)APP_PAGE_SCAN_FAST_S * 1000000,
+                m_epochUs + (int64_t)APP_PAGE_SCAN_FAST_S * 4 * 1000000,
+                m_epochUs + (int64_t)APP_PAGE_SCAN_SLOW_AFTER_S * 1000000,
+            };
+            s = DEEP;
+            for (int i = 0; i < 3; i++) {
+                if (now < ends[i]) {
+                    s = (Stage)i;
+                    untilUs = ends[i];
+                    break;
+                }
+            }
+        }
+
+        if (s != m_stage) {
+            const Params& p = params(s);
+            const esp_err_t err = esp_bt_gap_set_page_scan_param(p.type, p.interval, p.window);
+            if (err == ESP_OK) {
+                m_stage = s;
+                ESP_LOGI(TAG, "Page scan %s: %s, %u ms", p.name,
+                         p.type == ESP_BT_PAGE_SCAN_INTERLACED ? "interlaced" : "standard",
+                         (unsigned)(p.interval * 625 / 1000));
+            } else {
+                ESP_LOGW(TAG, "Page scan %s not set: %s", p.name, esp_err_to_name(err));
+            }
+        }
+
+        esp_timer_stop(m_timer);
+        if (untilUs > now) esp_timer_start_once(m_timer, (uint64_t)(untilUs - now));
+    }
+
+    static void onTimer(void* arg) {
+        PageScanPolicy* self = static_cast<PageScanPolicy*>(arg);
+        xSemaphoreTake(self->m_lock, portMAX_DELAY);
+        self->update();
+        xSemaphoreGive(self->m_lock);
+    }
+
+    SemaphoreHandle_t m_lock = nullptr;     // State + stack call
+    esp_timer_handle_t m_timer = nullptr;
+    int64_t m_epochUs = 0;                  // Last disconnect (or boot)
+    int64_t m_fastUntilUs = 0;              // Forced fast window end, 0 = none
+    bool m_connected = false;
+    Stage m_stage = NONE;
+};
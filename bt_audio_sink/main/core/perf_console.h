@@ -0,0 +1,445 @@
+#pragma once
+
+/*
+ * perf_console.h
+ *
+ * Interactive performance shell on the serial console (esp_console REPL,
+ * UART or USB-serial-JTAG, whichever the console is), for triage in the
+ * field without reflashing:
+ *
+ *   pipeline stats        queue depth and target, frame and drop counters,
+ *                         end-to-end latency and perf trace histograms
+ *   dsp bench <mode>      DSP chain timed on a synthetic block, per path
+ *   codec info            active decoder and stream, decode cycles/frame
+ *   mem map               memory placements, arenas and heaps
+ *   tasks                 CPU share and stack headroom over one second
+ *   led fps               effect and sent frame rates, estimated current
+ *   trace start|stop      perf trace window summarised into the event log
+ *
+ * The REPL task sits in a UART read at the lowest priority above idle on
+ * the control core; until a line comes in it costs its stack and nothing
+ * else. Everything a command needs is made when it runs: the task
+ * diagnostics for "tasks" come and go with the command, the bench DSP
+ * instance is built on the first "dsp bench" and reused after.
+ *
+ * "trace stop" writes one EV_TRACE_POINT record per point into the binary
+ * event log (point ids as TracePoint, TRACE_COUNT for the end-to-end
+ * latency) between two EV_TRACE marks, so a window can be matched with
+ * the drops and losses logged around it.
+ */
+
+#include "../config/app_config.h"
+
+#if APP_PERF_CONSOLE
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <new>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_console.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "../audio/audio_pipeline.h"
+#include "../audio/perf_trace.h"
+#include "../dsp/dsp_processor.h"
+#include "event_log.h"
+#include "mem_placement.h"
+#include "static_alloc.h"
+#include "task_diagnostics.h"
+#ifdef CONFIG_LED_MATRIX_ENABLE
+#include "../led/led_controller.h"
+#endif
+
+class PerfConsole {
+public:
+    // Stream details only main.cpp has (codec, format, stack counters)
+    using CodecInfoCallback = void (*)();
+
+    static PerfConsole& getInstance() {
+        static PerfConsole instance;
+        return instance;
+    }
+
+    bool begin(AudioPipeline& pipeline, DSPProcessor& dsp, CodecInfoCallback codecInfo) {
+        if (m_repl) return true;
+        m_pipeline = &pipeline;
+        m_dsp = &dsp;
+        m_codecInfo = codecInfo;
+
+        esp_console_repl_config_t replCfg = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+        replCfg.prompt = "sink>";
+        replCfg.task_stack_size = STACK_BYTES;
+        replCfg.task_priority = 1;
+        replCfg.task_core_id = APP_CONTROL_CORE;
+#if CONFIG_ESP_CONSOLE_UART_DEFAULT || CONFIG_ESP_CONSOLE_UART_CUSTOM
+        esp_console_dev_uart_config_t devCfg = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+        esp_err_t err = esp_console_new_repl_uart(&devCfg, &replCfg, &m_repl);
+#elif CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+        esp_console_dev_usb_serial_jtag_config_t devCfg = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+        esp_err_t err = esp_console_new_repl_usb_serial_jtag(&devCfg, &replCfg, &m_repl);
+#else
+        esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+#endif
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Console REPL: %s", esp_err_to_name(err));
+            m_repl = nullptr;
+            return false;
+        }
+
+        static const esp_console_cmd_t COMMANDS[] = {
+            { "pipeline", "Queue, drops and latency histograms", "stats", &cmdPipeline, nullptr, nullptr, nullptr },
+            { "dsp", "Time the DSP chain on a test block", "bench <live|bypass|flat|bass_boost|3d|analysis|full>",
+              &cmdDsp, nullptr, nullptr, nullptr },
+            { "codec", "Active decoder and its cost", "info", &cmdCodec, nullptr, nullptr, nullptr },
+            { "mem", "Memory placements and heaps", "map", &cmdMem, nullptr, nullptr, nullptr },
+            { "tasks", "CPU share and stack headroom over 1 s", nullptr, &cmdTasks, nullptr, nullptr, nullptr },
+            { "led", "LED frame rates over 1 s", "fps", &cmdLed, nullptr, nullptr, nullptr },
+            { "trace", "Perf trace window into the event log", "start|stop", &cmdTrace, nullptr, nullptr, nullptr },
+        };
+        esp_console_register_help_command();
+        for (const esp_console_cmd_t& cmd : COMMANDS) esp_console_cmd_register(&cmd);
+
+        err = esp_console_start_repl(m_repl);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Console start: %s", esp_err_to_name(err));
+            return false;
+        }
+        ESP_LOGI(TAG, "Performance console on core %d, 'help' lists the commands", APP_CONTROL_CORE);
+        return true;
+    }
+
+private:
+    static constexpr const char* TAG = "PerfCon";
+    static constexpr uint32_t STACK_BYTES = 6144;   // DSP bench runs the chain on it
+    static constexpr int WARMUP_BLOCKS = 8;
+    static constexpr int TIMED_BLOCKS = 200;
+    static constexpr uint32_t WINDOW_MS = 1000;     // tasks, led fps
+    static constexpr int BAR_WIDTH = 32;
+
+    struct BenchMode {
+        const char* name;
+        bool bypass;
+        bool bassBoost;
+        uint8_t sound3D;        // DSPProcessor::Sound3DMode
+        bool analysis;
+    };
+    // As the benchmark app's DSP suite, plus the live settings
+    static constexpr BenchMode BENCH_MODES[] = {
+        {"bypass",     true,  false, 0, false},
+        {"flat",       false, false, 0, false},
+        {"bass_boost", false, true,  0, false},
+        {"3d",         false, false, 1, false},
+        {"binaural",   false, false, 2, false},
+        {"analysis",   false, false, 0, true},
+        {"full",       false, true,  1, true},
+    };
+
+    PerfConsole() = default;
+
+    static bool is(int argc, char** argv, const char* sub) {
+        return argc >= 2 && strcmp(argv[1], sub) == 0;
+    }
+
+    static int usage(const char* line) {
+        printf("usage: %s\n", line);
+        return 1;
+    }
+
+    static uint32_t cpuMhz() { return CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ; }
+
+    // One summary line, then the buckets holding samples with a bar
+    // scaled to the fullest; values are divided by div for display
+    static void printHistogram(const char* name, const TraceHistogram& h, uint32_t div) {
+        if (h.count == 0) {
+            printf("%-11s no samples\n", name);
+            return;
+        }
+        printf("%-11s n=%u min %u avg %u p50 %u p99 %u max %u us\n", name, (unsigned)h.count,
+               (unsigned)(h.min / div), (unsigned)(h.avg() / div), (unsigned)(h.percentile(50) / div),
+               (unsigned)(h.percentile(99) / div), (unsigned)(h.max / div));
+        uint32_t peak = 0;
+        for (int i = 0; i < TraceHistogram::BUCKETS; i++) {
+            if (h.bucket[i] > peak) peak = h.bucket[i];
+        }
+        static const char BAR[BAR_WIDTH + 1] = "################################";
+        for (int i = 0; i < TraceHistogram::BUCKETS; i++) {
+            if (h.bucket[i] == 0) continue;
+            int len = (int)((uint64_t)h.bucket[i] * BAR_WIDTH / peak);
+            if (len == 0) len = 1;
+            printf("  <= %8u %8u %.*s\n", (unsigned)(TraceHistogram::bucketTop(i) / div),
+                   (unsigned)h.bucket[i], len, BAR);
+        }
+    }
+
+    // -------------------------------------------------------
+    // pipeline stats
+    // -------------------------------------------------------
+    static int cmdPipeline(int argc, char** argv) {
+        if (!is(argc, argv, "stats")) return usage("pipeline stats");
+        AudioPipeline& p = *getInstance().m_pipeline;
+        const JitterBuffer& jb = p.getJitterBuffer();
+        const AudioPipeline::FrameCounts fc = p.getFrameCounts();
+        printf("queue       %u ms of %u ms target, jitter %.1f ms, ring %u%% full\n",
+               (unsigned)jb.getDepthMs(), (unsigned)jb.getTargetMs(), jb.getJitterMs(),
+               (unsigned)p.getQueueFillPercent());
+        printf("frames      in %u out %u queued %u dropped %u\n", (unsigned)fc.in, (unsigned)fc.out,
+               (unsigned)(fc.in - fc.out), (unsigned)fc.dropped);
+        printf("events      drops %u, enqueue fails %u, short writes %u, underruns %u, "
+               "stretches %u, shrinks %u\n",
+               (unsigned)p.getDropCount(), (unsigned)p.getEnqueueFailCount(), (unsigned)p.getShortWriteCount(),
+               (unsigned)jb.getUnderrunCount(), (unsigned)jb.getStretchCount(), (unsigned)jb.getShrinkCount());
+        printf("drift       %.1f ppm\n", p.getDriftPpm());
+        TraceHistogram h;
+#if APP_AUDIO_LATENCY_PROBE
+        p.latency().snapshot(h);
+        printHistogram("latency", h, 1);
+#endif
+#if APP_AUDIO_PERF_TRACE
+        for (int t = 0; t < TRACE_COUNT; t++) {
+            p.perfTrace().snapshot((TracePoint)t, h);
+            printHistogram(PerfTrace::name((TracePoint)t), h, cpuMhz());
+        }
+#endif
+        return 0;
+    }
+
+    // -------------------------------------------------------
+    // dsp bench <mode>
+    // -------------------------------------------------------
+    static int cmdDsp(int argc, char** argv) {
+        if (!is(argc, argv, "bench") || argc < 3) {
+            return usage("dsp bench <live|bypass|flat|bass_boost|3d|analysis|full>");
+        }
+        return getInstance().bench(argv[2]) ? 0 : 1;
+    }
+
+    bool bench(const char* modeName) {
+        const DSPProcessor& live = *m_dsp;
+        const BenchMode* mode = nullptr;
+        if (strcmp(modeName, "live") != 0) {
+            for (const BenchMode& m : BENCH_MODES) {
+                if (strcmp(m.name, modeName) == 0) mode = &m;
+            }
+            if (!mode) {
+                printf("unknown mode '%s'\n", modeName);
+                return false;
+            }
+        }
+
+        // Its own instance: the live one belongs to audio_tx
+        const uint32_t rate = live.getSampleRate();
+        if (!m_benchDsp) {
+            m_benchDsp = new (std::nothrow) DSPProcessor();
+            if (!m_benchDsp) {
+                printf("no memory for the bench DSP\n");
+                return false;
+            }
+            m_benchDsp->init(rate);
+        } else {
+            m_benchDsp->setSampleRate(rate);
+        }
+        DSPProcessor& dsp = *m_benchDsp;
+        if (mode) {
+            dsp.setEQ(0.0f, 0.0f, 0.0f);
+            dsp.setChannelFlip(false);
+            dsp.setBypass(mode->bypass);
+            dsp.setBassBoost(mode->bassBoost);
+            dsp.set3DMode(mode->sound3D);
+            dsp.setAnalysisEnabled(mode->analysis);
+        } else {
+            dsp.setEQ(live.getBassDB(), live.getMidDB(), live.getTrebleDB());
+            dsp.setChannelFlip(live.isChannelFlipEnabled());
+            dsp.setBypass(live.isBypassEnabled());
+            dsp.setBassBoost(live.isBassBoostEnabled());
+            dsp.set3DMode(live.get3DMode());
+            dsp.setAnalysisEnabled(live.isAnalysisEnabled());
+        }
+
+        const size_t samples = APP_DSP_OUT_FRAMES * 2;
+        float* in = (float*)heap_caps_malloc(samples * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        float* out = (float*)heap_caps_malloc(samples * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        int32_t* q31 = (int32_t*)heap_caps_malloc(samples * sizeof(int32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        const bool ok = in && out && q31;
+        if (ok) {
+            // Two tones at -6 dBFS: above the silence gate, so every stage runs
+            for (size_t i = 0; i < APP_DSP_OUT_FRAMES; i++) {
+                in[2 * i] = 0.5f * sinf(2.0f * (float)M_PI * 100.0f * i / rate);
+                in[2 * i + 1] = 0.5f * sinf(2.0f * (float)M_PI * 1000.0f * i / rate);
+            }
+            // Playback time of one block, for the load figure
+            const uint64_t blockCycles = (uint64_t)cpuMhz() * 1000000 * APP_DSP_OUT_FRAMES / rate;
+            printf("%s at %u Hz, %d frames per block, %d blocks (max includes preemption)\n",
+                   mode ? mode->name : "live", (unsigned)rate, APP_DSP_OUT_FRAMES, TIMED_BLOCKS);
+            TraceHistogram h;
+            dsp.resetAllFilters();
+            for (int b = 0; b < WARMUP_BLOCKS + TIMED_BLOCKS; b++) {
+                const uint32_t t0 = PerfTrace::now();
+                dsp.processBlock(in, out, APP_DSP_OUT_FRAMES);
+                if (b >= WARMUP_BLOCKS) h.add(PerfTrace::now() - t0);
+            }
+            printBench("float", h, blockCycles);
+#if APP_DSP_Q31_PATH
+            h = TraceHistogram();
+            dsp.resetAllFilters();
+            for (int b = 0; b < WARMUP_BLOCKS + TIMED_BLOCKS; b++) {
+                for (size_t i = 0; i < samples; i++) q31[i] = (int32_t)(in[i] * 2147483647.0f);
+                const uint32_t t0 = PerfTrace::now();
+                dsp.processBlockQ31(q31, APP_DSP_OUT_FRAMES);
+                if (b >= WARMUP_BLOCKS) h.add(PerfTrace::now() - t0);
+            }
+            printBench("q31", h, blockCycles);
+#endif
+        } else {
+            printf("no memory for the bench buffers\n");
+        }
+        heap_caps_free(in);
+        heap_caps_free(out);
+        heap_caps_free(q31);
+        return ok;
+    }
+
+    static void printBench(const char* path, const TraceHistogram& h, uint64_t blockCycles) {
+        const uint32_t mhz = cpuMhz();
+        const uint32_t loadPermille = blockCycles ? (uint32_t)((uint64_t)h.avg() * 1000 / blockCycles) : 0;
+        printf("  %-5s avg %u p99 %u max %u us, %u cycles/frame, load %u.%u%%\n", path,
+               (unsigned)(h.avg() / mhz), (unsigned)(h.percentile(99) / mhz), (unsigned)(h.max / mhz),
+               (unsigned)(h.avg() / APP_DSP_OUT_FRAMES), (unsigned)(loadPermille / 10),
+               (unsigned)(loadPermille % 10));
+    }
+
+    // -------------------------------------------------------
+    // codec info, mem map, tasks
+    // -------------------------------------------------------
+    static int cmdCodec(int argc, char** argv) {
+        if (!is(argc, argv, "info")) return usage("codec info");
+        if (getInstance().m_codecInfo) getInstance().m_codecInfo();
+        return 0;
+    }
+
+    static int cmdMem(int argc, char** argv) {
+        if (!is(argc, argv, "map")) return usage("mem map");
+        StaticAlloc::report(TAG);
+        MemPlacement::report(TAG);
+        printf("heap min free KB since boot: internal %u, DMA %u, PSRAM %u\n",
+               (unsigned)(heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) / 1024),
+               (unsigned)(heap_caps_get_minimum_free_size(MALLOC_CAP_DMA) / 1024),
+               (unsigned)(heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM) / 1024));
+        return 0;
+    }
+
+    // A diagnostics instance of its own, primed and sampled a window
+    // apart; it logs the table. CPU shares need run-time stats
+    // (TASK_DIAGNOSTICS selects them), else they show as "-".
+    static int cmdTasks(int argc, char** argv) {
+        TaskDiagnostics* diag = new (std::nothrow) TaskDiagnostics();
+        if (!diag) {
+            printf("no memory for the task table\n");
+            return 1;
+        }
+        diag->sample(0);
+        vTaskDelay(pdMS_TO_TICKS(WINDOW_MS));
+        diag->sample(WINDOW_MS / 1000);
+        delete diag;
+        return 0;
+    }
+
+    // -------------------------------------------------------
+    // led fps
+    // -------------------------------------------------------
+    static int cmdLed(int argc, char** argv) {
+        if (!is(argc, argv, "fps")) return usage("led fps");
+#ifdef CONFIG_LED_MATRIX_ENABLE
+        LedController& led = LedController::getInstance();
+        if (!led.isInitialized()) {
+            printf("LED matrix not running\n");
+            return 1;
+        }
+        LedDriver& drv = led.getDriver();
+        const uint32_t effect0 = led.effectFrames();
+        const uint32_t sent0 = drv.sentFrames();
+        const int64_t t0 = esp_timer_get_time();
+        vTaskDelay(pdMS_TO_TICKS(WINDOW_MS));
+        const uint32_t effect = led.effectFrames() - effect0;
+        const uint32_t sent = drv.sentFrames() - sent0;
+        const uint32_t ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+        printf("effect %u.%u fps, sent %u.%u fps (target %d)%s\n",
+               (unsigned)(effect * 1000 / ms), (unsigned)(effect * 10000 / ms % 10),
+               (unsigned)(sent * 1000 / ms), (unsigned)(sent * 10000 / ms % 10), LED_FPS,
+               led.isStill() ? ", still" : "");
+        printf("current     ~%u mA, power scale %u/256\n", (unsigned)drv.estimatedMa(),
+               (unsigned)drv.powerScale());
+        return 0;
+#else
+        printf("LED matrix not built in\n");
+        return 1;
+#endif
+    }
+
+    // -------------------------------------------------------
+    // trace start|stop
+    // -------------------------------------------------------
+    static int cmdTrace(int argc, char** argv) {
+        PerfConsole& self = getInstance();
+        if (is(argc, argv, "start")) {
+            self.traceStart();
+        } else if (is(argc, argv, "stop")) {
+            if (!self.m_traceStartUs) {
+                printf("no trace running\n");
+                return 1;
+            }
+            self.traceStop();
+        } else {
+            return usage("trace start|stop");
+        }
+        return 0;
+    }
+
+    void traceStart() {
+#if APP_AUDIO_PERF_TRACE
+        m_pipeline->perfTrace().reset();
+#endif
+#if APP_AUDIO_LATENCY_PROBE
+        m_pipeline->latency().reset();
+#endif
+        m_traceStartUs = esp_timer_get_time();
+        logEvent(EV_TRACE, 1);
+        printf("tracing%s\n", APP_EVENT_LOG ? "" : " (event log not built in: console only)");
+    }
+
+    void traceStop() {
+        const uint32_t ms = (uint32_t)((esp_timer_get_time() - m_traceStartUs) / 1000);
+        m_traceStartUs = 0;
+        TraceHistogram h;
+#if APP_AUDIO_PERF_TRACE
+        for (int t = 0; t < TRACE_COUNT; t++) {
+            m_pipeline->perfTrace().snapshot((TracePoint)t, h);
+            tracePoint(t, PerfTrace::name((TracePoint)t), h, cpuMhz());
+        }
+#endif
+#if APP_AUDIO_LATENCY_PROBE
+        m_pipeline->latency().snapshot(h);
+        tracePoint(TRACE_COUNT, "latency", h, 1);
+#endif
+        logEvent(EV_TRACE, 0, ms);
+        printf("trace stopped after %u ms\n", (unsigned)ms);
+    }
+
+    static void tracePoint(int id, const char* name, const TraceHistogram& h, uint32_t div) {
+        if (h.count) logEvent(EV_TRACE_POINT, (uint32_t)id, h.percentile(99) / div, h.max / div);
+        printf("%-11s n=%u p99 %u max %u us\n", name, (unsigned)h.count,
+               (unsigned)(h.percentile(99) / div), (unsigned)(h.max / div));
+    }
+
+    esp_console_repl_t* m_repl = nullptr;
+    AudioPipeline* m_pipeline = nullptr;
+    DSPProcessor* m_dsp = nullptr;
+    CodecInfoCallback m_codecInfo = nullptr;
+    DSPProcessor* m_benchDsp = nullptr;
+    int64_t m_traceStartUs = 0;
+};
+
+#endif // APP_PERF_CONSOLE
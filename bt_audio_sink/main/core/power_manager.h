@@ -0,0 +1,188 @@
+#pragma once
+
+/*
+ * power_manager.h
+ *
+ * esp_pm setup and the app's PM locks. configure() at boot lets the CPU
+ * scale down to APP_POWER_MIN_FREQ_MHZ and, with tickless idle, the chip
+ * light-sleep whenever every task is blocked. The BT controller keeps its
+ * own lock while its modem cannot sleep, so links stay up either way.
+ *
+ * Activities hold a lock per reason, so nothing has to count:
+ *   STREAM    - CPU at full clock (decode + DSP), from A2DP start to
+ *               suspend/disconnect
+ *   ANIMATION - no light sleep (frame timing), while the LEDs move
+ * set() is idempotent; each reason is set from one task only (BT
+ * callbacks, LED task). Without APP_POWER_SAVE it compiles to nothing.
+ *
+ * With APP_STREAM_CLOCK the STREAM clock is not the full one but what
+ * setStreamClock() picked for the stream (esp_pm's CPU_MAX frequency);
+ * boostStreamClock() raises it a step (80, 160, 240 MHz) under deadline
+ * pressure. Both only record the target: esp_pm is reconfigured on the
+ * esp_timer task, which then passes the clock to the ClockFn.
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include "esp_log.h"
+#include "../config/app_config.h"
+#if APP_POWER_SAVE
+#include "esp_pm.h"
+#endif
+#if APP_STREAM_CLOCK
+#include "esp_timer.h"
+#endif
+
+class PowerManager {
+public:
+    enum Reason : uint8_t {
+        STREAM    = 0x01,
+        ANIMATION = 0x02,
+    };
+
+    // esp_timer task: the STREAM clock now in effect
+    using ClockFn = void (*)(uint32_t mhz);
+
+    static constexpr uint32_t FULL_MHZ = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+
+    static PowerManager& getInstance() {
+        static PowerManager instance;
+        return instance;
+    }
+
+    void configure() {
+#if APP_POWER_SAVE
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "stream", &m_cpuLock);
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "anim", &m_awakeLock);
+
+        esp_err_t err = apply(FULL_MHZ);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "esp_pm_configure failed: %s", esp_err_to_name(err));
+            return;
+        }
+        ESP_LOGI(TAG, "Power save: %d-%d MHz, light sleep %s", APP_POWER_MIN_FREQ_MHZ,
+                 (int)FULL_MHZ, APP_POWER_LIGHT_SLEEP ? "on" : "off");
+#if APP_STREAM_CLOCK
+        esp_timer_create_args_t args = {};
+        args.callback = onClockTimer;
+        args.arg = this;
+        args.name = "pm_clock";
+        if (esp_timer_create(&args, &m_clockTimer) != ESP_OK) {
+            ESP_LOGE(TAG, "Clock timer failed, streams run at %u MHz", (unsigned)FULL_MHZ);
+            m_clockTimer = nullptr;
+        }
+#endif
+#endif
+    }
+
+    // Once, before configure()
+    void setClockCallback(ClockFn fn) { m_clockFn = fn; }
+
+    // Control tasks: the clock for the stream now set up (a new format or
+    // DSP mode); drops any boost. Rounded up to 80/160/240, at most FULL_MHZ.
+    void setStreamClock(uint32_t mhz) {
+#if APP_STREAM_CLOCK
+        m_target.store(step(mhz));
+        kick();
+#else
+        (void)mhz;
+#endif
+    }
+
+    // Any task, audio_tx included: one step up. False when the clock is
+    // already at the top (or fixed), so the caller sheds work instead.
+    bool boostStreamClock() {
+#if APP_STREAM_CLOCK
+        uint32_t cur = m_target.load();
+        if (!m_clockTimer || cur >= FULL_MHZ) return false;
+        m_target.store(step(cur + 1));
+        kick();
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // STREAM clock asked for (FULL_MHZ without APP_STREAM_CLOCK)
+    uint32_t streamClock() const {
+#if APP_STREAM_CLOCK
+        return m_target.load();
+#else
+        return FULL_MHZ;
+#endif
+    }
+
+    void set(Reason reason, bool held) {
+#if APP_POWER_SAVE
+        const uint8_t prev = held ? m_held.fetch_or(reason) : m_held.fetch_and((uint8_t)~reason);
+        if (((prev & reason) != 0) == held) return;
+        esp_pm_lock_handle_t lock = reason == STREAM ? m_cpuLock : m_awakeLock;
+        if (!lock) return;
+        if (held) {
+            esp_pm_lock_acquire(lock);
+        } else {
+            esp_pm_lock_release(lock);
+        }
+#else
+        (void)reason;
+        (void)held;
+#endif
+    }
+
+    bool isHeld(Reason reason) const { return (m_held.load() & reason) != 0; }
+
+private:
+    static constexpr const char* TAG = "PM";
+
+    PowerManager() = default;
+
+#if APP_POWER_SAVE
+    static esp_err_t apply(uint32_t maxMhz) {
+        esp_pm_config_t cfg = {};
+        cfg.max_freq_mhz = (int)maxMhz;
+        cfg.min_freq_mhz = APP_POWER_MIN_FREQ_MHZ < (int)maxMhz ? APP_POWER_MIN_FREQ_MHZ : (int)maxMhz;
+        cfg.light_sleep_enable = APP_POWER_LIGHT_SLEEP;
+        return esp_pm_configure(&cfg);
+    }
+#endif
+
+#if APP_STREAM_CLOCK
+    // The PLL frequencies every target here runs the CPU at
+    static uint32_t step(uint32_t mhz) {
+        const uint32_t s = mhz <= 80 ? 80 : mhz <= 160 ? 160 : 240;
+        return s < FULL_MHZ ? s : FULL_MHZ;
+    }
+
+    void kick() {
+        if (!m_clockTimer) return;
+        esp_timer_stop(m_clockTimer);
+        esp_timer_start_once(m_clockTimer, 0);
+    }
+
+    // esp_timer task: reconfigure when the target moved
+    static void onClockTimer(void* arg) {
+        PowerManager* self = static_cast<PowerManager*>(arg);
+        const uint32_t mhz = self->m_target.load();
+        if (mhz == self->m_applied) return;
+        const esp_err_t err = apply(mhz);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Stream clock %u MHz: %s", (unsigned)mhz, esp_err_to_name(err));
+            return;
+        }
+        self->m_applied = mhz;
+        if (self->m_clockFn) self->m_clockFn(mhz);
+    }
+#endif
+
+    std::atomic<uint8_t> m_held{0};
+    ClockFn m_clockFn = nullptr;
+#if APP_POWER_SAVE
+    esp_pm_lock_handle_t m_cpuLock = nullptr;
+    esp_pm_lock_handle_t m_awakeLock = nullptr;
+#endif
+#if APP_STREAM_CLOCK
+    esp_timer_handle_t m_clockTimer = nullptr;
+    std::atomic<uint32_t> m_target{FULL_MHZ};
+    uint32_t m_applied = FULL_MHZ;      // esp_timer task only
+#endif
+};
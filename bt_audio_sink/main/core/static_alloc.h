@@ -0,0 +1,176 @@
+#pragma once
+
+/*
+ * static_alloc.h
+ *
+ * APP_STATIC_ALLOCATION build mode: the stacks and TCBs of the long-lived
+ * tasks and the audio work buffers are carved at boot from two fixed
+ * arenas the linker places (internal DRAM .bss, and PSRAM .bss when the
+ * build allows it), never from the heap, and never given back. Transient
+ * helper work runs on the one WorkQueue task instead of tasks of its own.
+ * A configuration that fits its arenas once fits on every boot and for
+ * the whole run, so heap fragmentation can no longer fail it; one that
+ * does not fit stops at boot with the map logged.
+ *
+ * Without the mode take() returns nullptr and the callers keep their heap
+ * paths, and createTask() is xTaskCreatePinnedToCore.
+ *
+ * Everything here is meant for boot, from one task at a time; report()
+ * logs the map (and the heaps) once the long-lived parts are up.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "../config/app_config.h"
+
+#if APP_STATIC_ALLOCATION
+#include <stdlib.h>
+#include "esp_attr.h"
+#include "esp_memory_utils.h"
+#endif
+
+class StaticAlloc {
+public:
+    // Where a buffer wants to live. PSRAM falls back to internal when the
+    // build has no PSRAM arena.
+    enum Region : uint8_t { INTERNAL = 0, PSRAM };
+
+#if APP_STATIC_ALLOCATION
+    static constexpr int MAX_ENTRIES = 40;
+    static constexpr size_t ALIGN = 16;
+
+    // Arena block for a buffer; stops the boot if the arena is full
+    static void* take(const char* name, size_t bytes, Region region) {
+        Arena& arena = (region == PSRAM && HAS_PSRAM_ARENA) ? s_psram : s_internal;
+        const size_t need = (bytes + ALIGN - 1) & ~(ALIGN - 1);
+        if (arena.used + need > arena.size) {
+            ESP_LOGE(TAG, "%s: %u bytes do not fit the %s arena (%u of %u KB used)", name,
+                     (unsigned)bytes, arena.name, (unsigned)(arena.used / 1024),
+                     (unsigned)(arena.size / 1024));
+            report(TAG);
+            abort();
+        }
+        void* p = arena.base + arena.used;
+        arena.used += need;
+        note(name, p, need, arena.name);
+        return p;
+    }
+
+    // Long-lived task with its stack and TCB from the internal arena
+    // (stacks must stay in internal RAM: flash writes disable the cache)
+    static BaseType_t createTask(TaskFunction_t fn, const char* name, uint32_t stackBytes, void* arg,
+                                 UBaseType_t prio, TaskHandle_t* handle, BaseType_t core) {
+        StackType_t* stack = (StackType_t*)take(name, stackBytes, INTERNAL);
+        StaticTask_t* tcb = (StaticTask_t*)take(name, sizeof(StaticTask_t), INTERNAL);
+        TaskHandle_t h = xTaskCreateStaticPinnedToCore(fn, name, stackBytes, arg, prio, stack, tcb, core);
+        if (handle) *handle = h;
+        return h ? pdPASS : pdFAIL;
+    }
+
+    static bool owns(const void* p) {
+        return s_internal.contains(p) || s_psram.contains(p);
+    }
+
+    static bool inPsram(const void* p) { return HAS_PSRAM_ARENA && s_psram.contains(p); }
+    static constexpr bool psramArena() { return HAS_PSRAM_ARENA; }
+#else
+    static void* take(const char*, size_t, Region) { return nullptr; }
+
+    static BaseType_t createTask(TaskFunction_t fn, const char* name, uint32_t stackBytes, void* arg,
+                                 UBaseType_t prio, TaskHandle_t* handle, BaseType_t core) {
+        return xTaskCreatePinnedToCore(fn, name, stackBytes, arg, prio, handle, core);
+    }
+
+    static bool owns(const void*) { return false; }
+    static bool inPsram(const void*) { return false; }
+    static constexpr bool psramArena() { return false; }
+#endif
+
+    // Boot-time memory map: every arena block, then the heaps
+    static void report(const char* tag) {
+#if APP_STATIC_ALLOCATION
+        for (int i = 0; i < s_count; i++) {
+            const Entry& e = s_entries[i];
+            ESP_LOGI(tag, "  %-8s %p %6u  %s", e.arena, e.addr, (unsigned)e.bytes, e.name);
+        }
+        logArena(tag, s_internal);
+        if (HAS_PSRAM_ARENA) logArena(tag, s_psram);
+#endif
+        ESP_LOGI(tag, "Heap KB free/largest: internal %u/%u, DMA %u/%u, PSRAM %u/%u",
+                 kb(heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)),
+                 kb(heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)),
+                 kb(heap_caps_get_free_size(MALLOC_CAP_DMA)),
+                 kb(heap_caps_get_largest_free_block(MALLOC_CAP_DMA)),
+                 kb(heap_caps_get_free_size(MALLOC_CAP_SPIRAM)),
+                 kb(heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM)));
+    }
+
+private:
+    static constexpr const char* TAG = "StaticAlloc";
+
+    static unsigned kb(size_t bytes) { return (unsigned)(bytes / 1024); }
+
+#if APP_STATIC_ALLOCATION
+#if CONFIG_SPIRAM_ALLOW_BSS_EXT_MEM
+    static constexpr bool HAS_PSRAM_ARENA = true;
+    static constexpr size_t PSRAM_BYTES = (size_t)APP_STATIC_ARENA_PSRAM_KB * 1024;
+#else
+    static constexpr bool HAS_PSRAM_ARENA = false;
+    static constexpr size_t PSRAM_BYTES = ALIGN;
+#endif
+    static constexpr size_t INTERNAL_BYTES = (size_t)APP_STATIC_ARENA_INTERNAL_KB * 1024;
+
+    struct Arena {
+        const char* name;
+        uint8_t* base;
+        size_t size;
+        size_t used;
+
+        bool contains(const void* p) const {
+            return (const uint8_t*)p >= base && (const uint8_t*)p < base + size;
+        }
+    };
+    struct Entry {
+        const char* name;
+        const char* arena;
+        void* addr;
+        size_t bytes;
+    };
+
+    static void note(const char* name, void* addr, size_t bytes, const char* arena) {
+        if (s_count < MAX_ENTRIES) s_entries[s_count++] = { name, arena, addr, bytes };
+    }
+
+    static void logArena(const char* tag, const Arena& a) {
+        ESP_LOGI(tag, "Arena %s at %p: %u of %u KB used (%s)", a.name, a.base,
+                 (unsigned)(a.used / 1024), (unsigned)(a.size / 1024),
+                 esp_ptr_external_ram(a.base) ? "PSRAM" : "internal DRAM");
+    }
+
+    alignas(16) static uint8_t s_internalMem[INTERNAL_BYTES];
+    alignas(16) static uint8_t s_psramMem[PSRAM_BYTES];
+    static Arena s_internal;
+    static Arena s_psram;
+    static Entry s_entries[MAX_ENTRIES];
+    static int s_count;
+#endif
+};
+
+#if APP_STATIC_ALLOCATION
+alignas(16) inline uint8_t StaticAlloc::s_internalMem[StaticAlloc::INTERNAL_BYTES];
+#if CONFIG_SPIRAM_ALLOW_BSS_EXT_MEM
+alignas(16) inline EXT_RAM_BSS_ATTR uint8_t StaticAlloc::s_psramMem[StaticAlloc::PSRAM_BYTES];
+#else
+alignas(16) inline uint8_t StaticAlloc::s_psramMem[StaticAlloc::PSRAM_BYTES];
+#endif
+inline StaticAlloc::Arena StaticAlloc::s_internal = { "internal", StaticAlloc::s_internalMem,
+                                                      StaticAlloc::INTERNAL_BYTES, 0 };
+inline StaticAlloc::Arena StaticAlloc::s_psram = { "psram", StaticAlloc::s_psramMem,
+                                                   StaticAlloc::PSRAM_BYTES, 0 };
+inline StaticAlloc::Entry StaticAlloc::s_entries[StaticAlloc::MAX_ENTRIES];
+inline int StaticAlloc::s_count = 0;
+#endif
@@ -0,0 +1,217 @@
+#pragma once
+
+/*
+ * task_diagnostics.h
+ *
+ * Every task's CPU share, stack headroom and pinning, plus the internal,
+ * DMA and PSRAM heaps, sampled every few seconds by a low-priority task.
+ * Each sample is logged and kept as a compact binary report for BLE
+ * (STATUS_TASKS), so stack sizes and core pinning can be tuned from data:
+ *
+ *   [version, interval_s, tasks_total, tasks_in_report,
+ *    {free_kb u16, largest_kb u16, min_free_kb u16} x3 (internal, DMA, PSRAM),
+ *    {core, prio, cpu_permille u16, stack_free u16, name_len, name...}...]
+ *
+ * Little endian. core is 0xFF for unpinned tasks; cpu_permille is per mille
+ * of one core over the last interval, 0xFFFF on the first sample (nothing
+ * to compare against yet); stack_free is the high-water mark in bytes.
+ * Tasks are sorted by CPU, busiest first; the report ends with the last
+ * one that fits.
+ *
+ * The CPU shares need FREERTOS_GENERATE_RUN_TIME_STATS (the Kconfig option
+ * selects it). sample() runs on one task; report() may be called from any.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+class TaskDiagnostics {
+public:
+    static constexpr uint8_t VERSION = 1;
+    static constexpr int MAX_TASKS = 40;
+    static constexpr size_t MAX_REPORT = 255;
+    static constexpr uint16_t CPU_UNKNOWN = 0xFFFF;
+
+    TaskDiagnostics() : m_lock(xSemaphoreCreateMutexStatic(&m_lockBuf)) {}
+
+    void sample(uint8_t intervalS) {
+        TaskStatus_t* st = m_status;
+        configRUN_TIME_COUNTER_TYPE total = 0;
+        const int n = (int)uxTaskGetSystemState(st, MAX_TASKS, &total);
+        if (n == 0) {
+            ESP_LOGW(TAG, "More than %d tasks, not sampled", MAX_TASKS);
+            return;
+        }
+
+        // Counters share the run-time clock with total, so the ratio is
+        // independent of its unit (see TaskLoadSampler)
+        const uint32_t span = (uint32_t)total - m_lastTotal;
+        Entry entries[MAX_TASKS];
+        for (int i = 0; i < n; i++) {
+            Entry& e = entries[i];
+            e.status = &st[i];
+            e.cpu = CPU_UNKNOWN;
+            const uint32_t counter = (uint32_t)st[i].ulRunTimeCounter;
+            if (m_primed && span > 0) {
+                for (int j = 0; j < m_lastCount; j++) {
+                    if (m_last[j].number != st[i].xTaskNumber) continue;
+                    uint64_t permille = (uint64_t)(uint32_t)(counter - m_last[j].counter) * 1000 / span;
+                    e.cpu = permille < CPU_UNKNOWN ? (uint16_t)permille : CPU_UNKNOWN - 1;
+                    break;
+                }
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            m_last[i].number = st[i].xTaskNumber;
+            m_last[i].counter = (uint32_t)st[i].ulRunTimeCounter;
+        }
+        m_lastCount = n;
+        m_lastTotal = (uint32_t)total;
+        m_primed = true;
+
+        // Busiest first (unknown last); insertion sort, n is small
+        for (int i = 1; i < n; i++) {
+            Entry e = entries[i];
+            int j = i;
+            while (j > 0 && cpuKey(entries[j - 1]) < cpuKey(e)) {
+                entries[j] = entries[j - 1];
+                j--;
+            }
+            entries[j] = e;
+        }
+
+        Heap heaps[HEAP_COUNT];
+        readHeaps(heaps);
+        log(entries, n, heaps);
+
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        m_reportLen = encode(entries, n, heaps, intervalS, m_report, sizeof(m_report));
+        xSemaphoreGive(m_lock);
+    }
+
+    // Latest report; 0 before the first sample
+    size_t report(uint8_t* out, size_t cap) {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        size_t len = m_reportLen <= cap ? m_reportLen : 0;
+        memcpy(out, m_report, len);
+        xSemaphoreGive(m_lock);
+        return len;
+    }
+
+private:
+    static constexpr const char* TAG = "TaskDiag";
+    enum { HEAP_INTERNAL, HEAP_DMA, HEAP_PSRAM, HEAP_COUNT };
+
+    struct Entry {
+        const TaskStatus_t* status;
+        uint16_t cpu;
+    };
+    struct Last {
+        UBaseType_t number;
+        uint32_t counter;
+    };
+    struct Heap {
+        uint16_t freeKb;
+        uint16_t largestKb;
+        uint16_t minFreeKb;
+    };
+
+    static int32_t cpuKey(const Entry& e) { return e.cpu == CPU_UNKNOWN ? -1 : e.cpu; }
+
+    static uint8_t coreOf(const TaskStatus_t& s) {
+        const BaseType_t core = xTaskGetCoreID(s.xHandle);
+        return core == tskNO_AFFINITY ? 0xFF : (uint8_t)core;
+    }
+
+    static void readHeaps(Heap* heaps) {
+        static const uint32_t caps[HEAP_COUNT] = {
+            MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MALLOC_CAP_DMA, MALLOC_CAP_SPIRAM,
+        };
+        for (int h = 0; h < HEAP_COUNT; h++) {
+            multi_heap_info_t info;
+            heap_caps_get_info(&info, caps[h]);
+            heaps[h].freeKb = kb(info.total_free_bytes);
+            heaps[h].largestKb = kb(info.largest_free_block);
+            heaps[h].minFreeKb = kb(info.minimum_free_bytes);
+        }
+    }
+
+    static uint16_t kb(size_t bytes) {
+        bytes /= 1024;
+        return bytes < 0xFFFF ? (uint16_t)bytes : 0xFFFF;
+    }
+
+    static void log(const Entry* entries, int n, const Heap* heaps) {
+        ESP_LOGI(TAG, "Heap KB free/largest/min: internal %u/%u/%u, DMA %u/%u/%u, PSRAM %u/%u/%u",
+                 heaps[0].freeKb, heaps[0].largestKb, heaps[0].minFreeKb,
+                 heaps[1].freeKb, heaps[1].largestKb, heaps[1].minFreeKb,
+                 heaps[2].freeKb, heaps[2].largestKb, heaps[2].minFreeKb);
+        for (int i = 0; i < n; i++) {
+            const TaskStatus_t& s = *entries[i].status;
+            const uint8_t core = coreOf(s);
+            char cpu[12];
+            if (entries[i].cpu == CPU_UNKNOWN) {
+                snprintf(cpu, sizeof(cpu), "-");
+            } else {
+                snprintf(cpu, sizeof(cpu), "%u.%u%%", entries[i].cpu / 10, entries[i].cpu % 10);
+            }
+            ESP_LOGI(TAG, "  %-16s core %c prio %2u cpu %6s stack free %u", s.pcTaskName,
+                     core == 0xFF ? '-' : (char)('0' + core), (unsigned)s.uxCurrentPriority, cpu,
+                     (unsigned)s.usStackHighWaterMark);
+        }
+    }
+
+    static size_t encode(const Entry* entries, int n, const Heap* heaps, uint8_t intervalS,
+                         uint8_t* out, size_t cap) {
+        size_t idx = 0;
+        out[idx++] = VERSION;
+        out[idx++] = intervalS;
+        out[idx++] = (uint8_t)n;
+        const size_t countAt = idx++;
+        for (int h = 0; h < HEAP_COUNT; h++) {
+            idx = put16(out, idx, heaps[h].freeKb);
+            idx = put16(out, idx, heaps[h].largestKb);
+            idx = put16(out, idx, heaps[h].minFreeKb);
+        }
+        uint8_t count = 0;
+        for (int i = 0; i < n; i++) {
+            const TaskStatus_t& s = *entries[i].status;
+            const size_t nameLen = strnlen(s.pcTaskName, configMAX_TASK_NAME_LEN);
+            if (idx + 7 + nameLen > cap) break;
+            out[idx++] = coreOf(s);
+            out[idx++] = (uint8_t)s.uxCurrentPriority;
+            idx = put16(out, idx, entries[i].cpu);
+            const uint32_t stack = s.usStackHighWaterMark;
+            idx = put16(out, idx, stack < 0xFFFF ? (uint16_t)stack : 0xFFFF);
+            out[idx++] = (uint8_t)nameLen;
+            memcpy(out + idx, s.pcTaskName, nameLen);
+            idx += nameLen;
+            count++;
+        }
+        out[countAt] = count;
+        return idx;
+    }
+
+    static size_t put16(uint8_t* out, size_t idx, uint16_t v) {
+        out[idx] = (uint8_t)v;
+        out[idx + 1] = (uint8_t)(v >> 8);
+        return idx + 2;
+    }
+
+    TaskStatus_t m_status[MAX_TASKS];
+    Last m_last[MAX_TASKS];
+    int m_lastCount = 0;
+    uint32_t m_lastTotal = 0;
+    bool m_primed = false;
+
+    StaticSemaphore_t m_lockBuf;
+    SemaphoreHandle_t m_lock;
+    uint8_t m_report[MAX_REPORT];
+    size_t m_reportLen = 0;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+ * wifi_station.h
+ *
+ * WiFi station bring-up for the parts of the app that use the network
+ * next to Bluetooth (multi-room sync, WiFi ingest). Only one of them is
+ * built in at a time; the Kconfig dependencies keep it that way.
+ *
+ * Coexistence: with BT up the WiFi driver requires modem sleep, and the
+ * link is held to HT20, so WiFi keeps to a 20 MHz slice of the band the
+ * BT hopper shares. The handler gets WIFI_EVENT_STA_DISCONNECTED and
+ * IP_EVENT_STA_GOT_IP; a disconnect reconnects by itself.
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+
+class WifiStation {
+public:
+    static bool start(const char* ssid, const char* password, esp_event_handler_t handler, void* arg) {
+        esp_err_t err = esp_netif_init();
+        if (err == ESP_OK) {
+            err = esp_event_loop_create_default();
+            if (err == ESP_ERR_INVALID_STATE) err = ESP_OK;     // Already there
+        }
+        if (err == ESP_OK) {
+            esp_netif_create_default_wifi_sta();
+            wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+            err = esp_wifi_init(&cfg);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "WiFi init failed: %s", esp_err_to_name(err));
+            return false;
+        }
+        esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &onEvent, nullptr);
+        esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, handler, arg);
+        esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, handler, arg);
+
+        wifi_config_t wc = {};
+        strncpy((char*)wc.sta.ssid, ssid, sizeof(wc.sta.ssid));
+        strncpy((char*)wc.sta.password, password, sizeof(wc.sta.password));
+        esp_wifi_set_mode(WIFI_MODE_STA);
+        esp_wifi_set_config(WIFI_IF_STA, &wc);
+        err = esp_wifi_start();
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "WiFi start failed: %s", esp_err_to_name(err));
+            return false;
+        }
+        // BT coexistence requires modem sleep
+        esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+        esp_wifi_set_bandwidth(WIFI_IF_STA, WIFI_BW_HT20);
+        esp_wifi_connect();
+        return true;
+    }
+
+private:
+    static constexpr const char* TAG = "WiFi";
+
+    static void onEvent(void* arg, esp_event_base_t base, int32_t id, void* data) {
+        esp_wifi_connect();
+    }
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+/*
+ * work_queue.h
+ *
+ * Deferred helper work (a sound delete from a BLE callback, the OTA
+ * auto-finalize timer) that must not run in the caller's context. In a
+ * static allocation build the jobs run one after another on a single
+ * work_q task created at boot, so nothing is created at run time; the
+ * other builds keep giving each job a task of its own that ends with it.
+ *
+ * A job returns when done (it never deletes its task) and may block; a
+ * long one holds back the jobs queued after it.
+ */
+
+#include <stdint.h>
+#include <new>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "../config/app_config.h"
+#include "static_alloc.h"
+
+class WorkQueue {
+public:
+    typedef void (*Job)(void* arg);
+
+    static constexpr int DEPTH = 8;
+    static constexpr uint32_t STACK_BYTES = 4096;   // Covers the largest job (OTA finalize)
+
+    // Once at boot; nothing to do without the static build
+    bool begin(UBaseType_t prio, BaseType_t core) {
+#if APP_STATIC_ALLOCATION
+        if (m_queue) return true;
+        m_queue = xQueueCreateStatic(DEPTH, sizeof(Item), m_storage, &m_queueBuf);
+        return StaticAlloc::createTask(queueTask, "work_q", STACK_BYTES, this, prio, nullptr, core) == pdPASS;
+#else
+        (void)prio;
+        (void)core;
+        return true;
+#endif
+    }
+
+    // Run job(arg) off the caller. name/stackBytes/prio/core are its own
+    // task's in a dynamic build. False if it could not be queued or started.
+    bool run(Job job, void* arg, const char* name, uint32_t stackBytes, UBaseType_t prio, BaseType_t core) {
+        Item item = { job, arg };
+#if APP_STATIC_ALLOCATION
+        (void)stackBytes;
+        (void)prio;
+        (void)core;
+        if (m_queue && xQueueSend(m_queue, &item, 0) == pdTRUE) return true;
+        ESP_LOGE(TAG, "%s: work queue full", name);
+        return false;
+#else
+        Item* own = new (std::nothrow) Item(item);
+        if (own && xTaskCreatePinnedToCore(oneShotTask, name, stackBytes, own, prio, nullptr, core) == pdPASS) {
+            return true;
+        }
+        delete own;
+        ESP_LOGE(TAG, "%s: task create failed", name);
+        return false;
+#endif
+    }
+
+private:
+    static constexpr const char* TAG = "WorkQueue";
+
+    struct Item {
+        Job job;
+        void* arg;
+    };
+
+#if APP_STATIC_ALLOCATION
+    static void queueTask(void* param) {
+        WorkQueue* self = static_cast<WorkQueue*>(param);
+        Item item;
+        for (;;) {
+            if (xQueueReceive(self->m_queue, &item, portMAX_DELAY) == pdTRUE) item.job(item.arg);
+        }
+    }
+
+    QueueHandle_t m_queue = nullptr;
+    StaticQueue_t m_queueBuf;
+    uint8_t m_storage[DEPTH * sizeof(Item)];
+#else
+    static void oneShotTask(void* param) {
+        Item item = *static_cast<Item*>(param);
+        delete static_cast<Item*>(param);
+        item.job(item.arg);
+        vTaskDelete(nullptr);
+    }
+#endif
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Analysis decimator - 3rd order CIC down to ~3 kHz
+// Goertzel and the peak meter only look at 30-120 Hz, so they
+// run on this low-rate mono signal instead of every sample.
+// Integer arithmetic: the integrators wrap modulo 2^32 and the
+// combs undo it, so Q15 input with R <= 32 (R^3 = 2^15) stays
+// exact. Droop at 120 Hz is under 0.1 dB; images near multiples
+// of the output rate fold into the bands >80 dB down.
+// -----------------------------------------------------------
+
+#include <stdint.h>
+
+class AnalysisDecimator {
+public:
+    static constexpr uint32_t MAX_FACTOR = 32;
+    static constexpr uint32_t MIN_OUT_RATE = 2000;
+
+    // Largest power of two that keeps the output rate >= MIN_OUT_RATE
+    static uint32_t factorFor(uint32_t sampleRate) {
+        uint32_t r = 1;
+        while (r < MAX_FACTOR && sampleRate / (r * 2) >= MIN_OUT_RATE) r *= 2;
+        return r;
+    }
+
+    void init(uint32_t sampleRate) {
+        m_factor = factorFor(sampleRate);
+        m_outScale = 1.0f / (32768.0f * (float)(m_factor * m_factor * m_factor));
+        reset();
+    }
+
+    void reset() {
+        m_i1 = m_i2 = m_i3 = 0;
+        m_c1 = m_c2 = m_c3 = 0;
+        m_phase = 0;
+    }
+
+    uint32_t factor() const { return m_factor; }
+
+    // Feed one Q15 sample; true when a decimated sample (full scale +/-1.0)
+    // is ready in out
+    inline bool push(int32_t q15, float &out) {
+        m_i1 += (uint32_t)q15;
+        m_i2 += m_i1;
+        m_i3 += m_i2;
+        if (++m_phase < m_factor) return false;
+        m_phase = 0;
+
+        uint32_t d1 = m_i3 - m_c1; m_c1 = m_i3;
+        uint32_t d2 = d1 - m_c2;   m_c2 = d1;
+        uint32_t d3 = d2 - m_c3;   m_c3 = d2;
+        out = (float)(int32_t)d3 * m_outScale;
+        return true;
+    }
+
+    // Float input (full scale +/-1.0), saturated to Q15
+    inline bool push(float x, float &out) {
+        if (x > 0.99997f) x = 0.99997f;
+        if (x < -1.0f) x = -1.0f;
+        return push((int32_t)(x * 32768.0f), out);
+    }
+
+private:
+    uint32_t m_factor = 1;
+    float m_outScale = 1.0f / 32768.0f;
+    uint32_t m_i1 = 0, m_i2 = 0, m_i3 = 0;   // Integrators
+    uint32_t m_c1 = 0, m_c2 = 0, m_c3 = 0;   // Comb delays
+    uint32_t m_phase = 0;
+};
@@ -0,0 +1,339 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Audio Analyzer - spectrum, levels and beat off the audio path
+// audio_tx only pushes the (decimated) mono analysis signal into
+// a lock-free SPSC ring. A low-priority task drains it, runs the
+// Goertzel bank, the peak meter, beat detection and (with
+// APP_DSP_SPECTRUM) an FFT spectrum, and publishes an AnalysisResult. Readers on any core get one consistent,
+// versioned set instead of fields torn across updates.
+// Each result carries the time its newest input left the DSP. With the
+// history enabled (LED sync) the last HISTORY results are kept so a
+// reader can take the one being heard now, output latency later.
+// With APP_BEAT_TRACKER the beats come from the spectral-flux tracker
+// (beat_tracker.h) on the FFT frames instead of the Goertzel ratio, and
+// are predicted from the tempo once it locks. Either way each beat
+// carries the time it will be heard at the I2S output.
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <atomic>
+#include <new>
+#include "esp_heap_caps.h"
+#include "goertzel.h"
+#include "peak_meter.h"
+#if APP_DSP_SPECTRUM
+#include "spectrum_analyzer.h"
+#endif
+#if APP_BEAT_TRACKER
+#include "beat_tracker.h"
+#endif
+#include "../config/app_config.h"
+
+struct AnalysisResult {
+    uint32_t version = 0;                       // Publish count, 0 = nothing yet
+    float bandDB[GoertzelBank::NUM_BANDS];      // Goertzel 30/60/100 Hz
+    float bandLin[GoertzelBank::NUM_BANDS];
+    float peakDB[PeakMeter::NUM_BANDS];         // Peak meter (level display)
+    float peakLin[PeakMeter::NUM_BANDS];
+    uint32_t beatCount = 0;                     // Incremented on every beat
+    uint32_t lastBeatMs = 0;
+    uint32_t beatUs = 0;                        // When beat beatCount is heard (esp_timer, low 32 bits)
+    float tempoBpm = 0.0f;                      // Tracked tempo, 0 = no lock (APP_BEAT_TRACKER)
+    float beatPhase = 0.0f;                     // 0 on a beat to 1 before the next, at the newest input
+    uint32_t stampUs = 0;                       // Newest input left the DSP (esp_timer, low 32 bits)
+#if APP_DSP_SPECTRUM
+    float spectrum[SpectrumAnalyzer::BANDS] = {};      // FFT bands, low to high
+    float spectrumPeak[SpectrumAnalyzer::BANDS] = {};  // Peak hold of the same
+#endif
+
+    AnalysisResult() {
+        for (int i = 0; i < GoertzelBank::NUM_BANDS; i++) {
+            bandDB[i] = -120.0f;
+            bandLin[i] = 0.0f;
+        }
+        for (int i = 0; i < PeakMeter::NUM_BANDS; i++) {
+            peakDB[i] = -60.0f;
+            peakLin[i] = 0.0f;
+        }
+    }
+};
+
+class AudioAnalyzer {
+public:
+    // Analysis task period; the beat smoothing constants assume ~10 ms steps
+    static constexpr uint32_t PERIOD_MS = 10;
+    // Power of two; several periods of input at the decimated (or full) rate
+    static constexpr uint32_t RING_SIZE = APP_DSP_ANALYSIS_DECIMATE ? 512 : 4096;
+    // Delayed results kept for readHeard(): 640 ms at PERIOD_MS, more than
+    // the deepest DMA chain plus the output slots
+    static constexpr uint32_t HISTORY = 64;
+#if APP_BEAT_TRACKER
+    // Hop of the spectrum frames the beat tracker runs on
+    static constexpr uint32_t BEAT_HOP_MS = 20;
+#endif
+
+    // Any task: new analysis rate, applied by the analyzer on its next run
+    void configure(uint32_t sampleRate, uint16_t blockN) {
+        m_cfgRate = sampleRate;
+        m_cfgBlockN = blockN;
+        m_cfgGen.fetch_add(1, std::memory_order_release);
+    }
+
+    // Producer (audio_tx): one mono sample. Dropped when the analyzer has
+    // fallen behind; the audio path never waits on it.
+    inline void push(float x) {
+        const uint32_t w = m_write.load(std::memory_order_relaxed);
+        if (w - m_read.load(std::memory_order_acquire) >= RING_SIZE) return;
+        m_ring[w & (RING_SIZE - 1)] = x;
+        m_write.store(w + 1, std::memory_order_release);
+    }
+
+    // Producer (audio_tx), after a block's samples: when it left the DSP
+    // and the current estimate of how long until it is heard
+    inline void markBlock(uint32_t nowUs, uint32_t outputDelayUs) {
+        m_blockUs.store(nowUs, std::memory_order_relaxed);
+        m_outputDelayUs.store(outputDelayUs, std::memory_order_relaxed);
+    }
+    uint32_t outputDelayUs() const { return m_outputDelayUs.load(std::memory_order_relaxed); }
+
+    // Keep HISTORY results (PSRAM when present) for readHeard(), from the
+    // next publish on. Once, from one task.
+    bool enableHistory() {
+        if (m_history.load(std::memory_order_relaxed)) return true;
+        const size_t bytes = sizeof(HistorySlot) * HISTORY;
+        HistorySlot* h = (HistorySlot*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!h) h = (HistorySlot*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+        if (!h) return false;
+        for (uint32_t i = 0; i < HISTORY; i++) new (&h[i]) HistorySlot();
+        m_history.store(h, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer (analysis task): drain the ring and publish if anything came
+    // in. True when a new result was published.
+    bool run(uint32_t nowMs) {
+        const uint32_t gen = m_cfgGen.load(std::memory_order_acquire);
+        const bool reconfigured = gen != m_appliedGen;
+        if (reconfigured) {
+            m_appliedGen = gen;
+            m_goertzel.init(m_cfgRate, m_cfgBlockN);
+            m_goertzel.zeroLevels();
+            m_peakMeter.init((float)m_cfgRate);
+            m_bassSmooth = m_bassAvg = 0.0f;
+            m_rate = m_cfgRate;
+#if APP_BEAT_TRACKER
+            m_spectrum.init(m_cfgRate, BEAT_HOP_MS);
+            m_hop = m_cfgRate * BEAT_HOP_MS / 1000;
+            if (m_hop < 1) m_hop = 1;
+            m_hopPos = 0;
+            {
+                const float frameRate = (float)m_cfgRate / (float)m_hop;
+                m_tracker.init(frameRate, APP_BEAT_MIN_INTERVAL_MS * frameRate / 1000.0f);
+            }
+#elif APP_DSP_SPECTRUM
+            m_spectrum.init(m_cfgRate, APP_SPECTRUM_PERIOD_MS);
+#endif
+            // Samples still queued are from the old rate
+            m_read.store(m_write.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        uint32_t r = m_read.load(std::memory_order_relaxed);
+        const uint32_t w = m_write.load(std::memory_order_acquire);
+        if (r == w && !reconfigured) return false;
+        // Marked after the block's pushes, so at most one block newer than w
+        const uint32_t stampUs = m_blockUs.load(std::memory_order_relaxed);
+#if APP_BEAT_TRACKER
+        bool beat = false;
+        float beatSample = 0.0f;     // Samples before w
+#endif
+        for (; r != w; r++) {
+            const float x = m_ring[r & (RING_SIZE - 1)];
+            m_goertzel.processSample(x);
+            m_peakMeter.process(x);
+#if APP_DSP_SPECTRUM
+            m_spectrum.push(x);
+#endif
+#if APP_BEAT_TRACKER
+            // Spectrum and tracker frame every m_hop samples
+            if (++m_hopPos >= m_hop) {
+                m_hopPos = 0;
+                m_spectrum.compute();
+                if (m_tracker.process(m_spectrum.binPower(), 1, SpectrumAnalyzer::N / 2,
+                                      SpectrumAnalyzer::binScale())) {
+                    beat = true;
+                    beatSample = (float)(w - r - 1) + m_tracker.beatLag() * (float)m_hop;
+                }
+            }
+#endif
+        }
+        m_read.store(r, std::memory_order_release);
+
+#if APP_BEAT_TRACKER
+        if (beat) {
+            m_beatCount++;
+            m_lastBeatMs = nowMs;
+            m_beatUs = stampUs + m_outputDelayUs.load(std::memory_order_relaxed) -
+                       (uint32_t)(beatSample * 1e6f / (float)m_rate);
+        }
+#else
+        detectBeat(nowMs, stampUs);
+#endif
+#if APP_DSP_SPECTRUM && !APP_BEAT_TRACKER
+        // At the LED frame rate; the window slides over the ring input
+        if ((nowMs - m_lastSpectrumMs) >= APP_SPECTRUM_PERIOD_MS) {
+            m_lastSpectrumMs = nowMs;
+            m_spectrum.compute();
+        }
+#endif
+        publish(stampUs);
+        return true;
+    }
+
+    // Any task: latest complete result. Retries only if the analyzer
+    // published twice during the copy.
+    void read(AnalysisResult& out) const {
+        while (true) {
+            const uint32_t s1 = m_seq.load(std::memory_order_acquire);
+            out = m_result[(s1 >> 1) & 1];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint32_t s2 = m_seq.load(std::memory_order_relaxed);
+            // The slot is rewritten from seq (s1 & ~1) + 3 on
+            if (s2 - (s1 & ~1u) < 3) return;
+        }
+    }
+
+    // Any task: the newest result whose input is being heard at nowUs,
+    // i.e. that left the DSP at least the output delay ago. False without
+    // the history or before anything that old was published.
+    bool readHeard(AnalysisResult& out, uint32_t nowUs) const {
+        const HistorySlot* history = m_history.load(std::memory_order_acquire);
+        if (!history) return false;
+        const uint32_t targetUs = nowUs - m_outputDelayUs.load(std::memory_order_relaxed);
+        const uint32_t newest = m_historyCount.load(std::memory_order_acquire);
+        for (uint32_t back = 0; back < HISTORY - 1 && back < newest; back++) {
+            const HistorySlot& slot = history[(newest - 1 - back) % HISTORY];
+            const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq & 1) continue;
+            if ((int32_t)(slot.result.stampUs - targetUs) > 0) continue;
+            out = slot.result;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq) return true;
+        }
+        return false;
+    }
+
+private:
+    // Bass transient vs its running average (60 + 100 Hz bands)
+    void detectBeat(uint32_t nowMs, uint32_t stampUs) {
+        const float bass = m_goertzel.getLin(1) + m_goertzel.getLin(2);
+        if (bass >= APP_BASS_MIN_LEVEL) {
+            m_bassSmooth += APP_BASS_SMOOTH_ALPHA * (bass - m_bassSmooth);
+            m_bassAvg += APP_BASS_AVG_ALPHA * (m_bassSmooth - m_bassAvg);
+
+            float ratio = (m_bassAvg > 1e-6f) ? (m_bassSmooth / (m_bassAvg + 1e-6f)) : 0;
+            if (ratio > APP_BASS_RATIO_THRESH && (nowMs - m_lastBeatMs) > APP_BEAT_MIN_INTERVAL_MS) {
+                m_beatCount++;
+                m_lastBeatMs = nowMs;
+                m_beatUs = stampUs + m_outputDelayUs.load(std::memory_order_relaxed);
+            }
+        } else {
+            m_bassSmooth *= 0.9f;
+            m_bassAvg *= 0.999f;
+        }
+    }
+
+    // Double-buffered seqlock: seq is odd while the other slot is written,
+    // slot (seq >> 1) & 1 always holds the latest complete result
+    void publish(uint32_t stampUs) {
+        const uint32_t s = m_seq.load(std::memory_order_relaxed);
+        const uint32_t k = s >> 1;
+        m_seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        AnalysisResult& res = m_result[(k + 1) & 1];
+        res.version = k + 1;
+        for (int i = 0; i < GoertzelBank::NUM_BANDS; i++) {
+            res.bandDB[i] = m_goertzel.getDB(i);
+            res.bandLin[i] = m_goertzel.getLin(i);
+        }
+        for (int i = 0; i < PeakMeter::NUM_BANDS; i++) {
+            res.peakDB[i] = m_peakMeter.getDB(i);
+            res.peakLin[i] = m_peakMeter.getLin(i);
+        }
+        res.beatCount = m_beatCount;
+        res.lastBeatMs = m_lastBeatMs;
+        res.beatUs = m_beatUs;
+#if APP_BEAT_TRACKER
+        res.tempoBpm = m_tracker.bpm();
+        res.beatPhase = m_tracker.phase();
+#endif
+        res.stampUs = stampUs;
+#if APP_DSP_SPECTRUM
+        for (int b = 0; b < SpectrumAnalyzer::BANDS; b++) {
+            res.spectrum[b] = m_spectrum.level(b);
+            res.spectrumPeak[b] = m_spectrum.peak(b);
+        }
+#endif
+
+        m_seq.store(s + 2, std::memory_order_release);
+
+        // Same result into the history, behind a per-slot sequence
+        HistorySlot* history = m_history.load(std::memory_order_acquire);
+        if (history) {
+            const uint32_t n = m_historyCount.load(std::memory_order_relaxed);
+            HistorySlot& slot = history[n % HISTORY];
+            const uint32_t hs = slot.seq.load(std::memory_order_relaxed);
+            slot.seq.store(hs + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.result = res;
+            slot.seq.store(hs + 2, std::memory_order_release);
+            m_historyCount.store(n + 1, std::memory_order_release);
+        }
+    }
+
+    struct HistorySlot {
+        std::atomic<uint32_t> seq{0};   // Odd while being rewritten
+        AnalysisResult result;
+    };
+
+    // Ring (audio_tx -> analysis task)
+    float m_ring[RING_SIZE];
+    std::atomic<uint32_t> m_write{0};
+    std::atomic<uint32_t> m_read{0};
+
+    // Pending configuration
+    volatile uint32_t m_cfgRate = APP_I2S_DEFAULT_SR;
+    volatile uint16_t m_cfgBlockN = APP_GOERTZEL_N;
+    std::atomic<uint32_t> m_cfgGen{0};
+
+    // Analysis task state
+    uint32_t m_appliedGen = UINT32_MAX;
+    GoertzelBank m_goertzel;
+    PeakMeter m_peakMeter;
+    float m_bassSmooth = 0.0f;
+    float m_bassAvg = 0.0f;
+    uint32_t m_beatCount = 0;
+    uint32_t m_lastBeatMs = 0;
+    uint32_t m_beatUs = 0;
+    uint32_t m_rate = APP_I2S_DEFAULT_SR;
+#if APP_DSP_SPECTRUM
+    SpectrumAnalyzer m_spectrum;
+    uint32_t m_lastSpectrumMs = 0;
+#endif
+#if APP_BEAT_TRACKER
+    BeatTracker m_tracker;
+    uint32_t m_hop = 1;         // Samples per tracker frame
+    uint32_t m_hopPos = 0;
+#endif
+
+    // Block timing (audio_tx)
+    std::atomic<uint32_t> m_blockUs{0};
+    std::atomic<uint32_t> m_outputDelayUs{0};
+
+    // Published results
+    AnalysisResult m_result[2];
+    std::atomic<uint32_t> m_seq{0};
+    std::atomic<HistorySlot*> m_history{nullptr};   // HISTORY slots, null until enabled
+    std::atomic<uint32_t> m_historyCount{0};        // Results written to the history
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Band Split - one-pole low-pass bank at ascending crossovers
+// - N crossovers give N + 1 bands that sum back to the input
+//   exactly: band 0 is lp[0], band k is lp[k] - lp[k - 1], the
+//   top band is x - lp[N - 1]; no extra filter per band
+// - OnePoleBank runs per sample (analysis, meters); BandSplit
+//   fills one interleaved low-pass buffer per crossover for a
+//   block, so every consumer of the block reads the same bands
+// -----------------------------------------------------------
+
+#include <stddef.h>
+#include "fast_math.h"
+#include "../config/app_config.h"
+
+template <int CH, int N>
+struct OnePoleBank {
+    float coef[N] = {};
+    float state[N][CH] = {};
+
+    // Crossovers in Hz, ascending
+    void init(const float* fc, float sampleRate) {
+        for (int k = 0; k < N; k++) coef[k] = coefFor(fc[k], sampleRate);
+        reset();
+    }
+
+    // One crossover's coefficient, for designs kept per rate
+    static float coefFor(float fc, float sampleRate) {
+        if (sampleRate <= 0.0f) sampleRate = 44100.0f;
+        const float wc = 2.0f * DSP_PI_F * fc;
+        return wc * fast_recipsf2(wc + sampleRate);
+    }
+
+    void reset() {
+        for (int k = 0; k < N; k++) {
+            for (int c = 0; c < CH; c++) state[k][c] = 0.0f;
+        }
+    }
+
+    inline void process(int ch, float x) {
+        for (int k = 0; k < N; k++) state[k][ch] += coef[k] * (x - state[k][ch]);
+    }
+
+    // Input below crossover k
+    inline float lowpass(int k, int ch) const { return state[k][ch]; }
+};
+
+// Interleaved stereo, up to MAX_BLOCK frames per split(); Mono splits
+// the left slots only
+template <int N, size_t MAX_BLOCK>
+struct BandSplit {
+    OnePoleBank<2, N> bank;
+
+    void init(const float* fc, float sampleRate) { bank.init(fc, sampleRate); }
+    void reset() { bank.reset(); }
+
+    template <bool Mono = false>
+    void split(const float* buf, size_t frames) {
+        if (frames > MAX_BLOCK) frames = MAX_BLOCK;
+        for (int k = 0; k < N; k++) {
+            const float a = bank.coef[k];
+            float sL = bank.state[k][0];
+            float sR = bank.state[k][1];
+            float* o = m_lp[k];
+            if (Mono) {
+                for (size_t i = 0; i < frames; i++) {
+                    sL += a * (buf[2 * i] - sL);
+                    o[2 * i] = sL;
+                }
+            } else {
+                for (size_t i = 0; i < frames; i++) {
+                    sL += a * (buf[2 * i] - sL);
+                    sR += a * (buf[2 * i + 1] - sR);
+                    o[2 * i] = sL;
+                    o[2 * i + 1] = sR;
+                }
+            }
+            bank.state[k][0] = sL;
+            bank.state[k][1] = sR;
+        }
+    }
+
+    // Last split() block below crossover k, interleaved
+    const float* lowpass(int k) const { return m_lp[k]; }
+
+private:
+    float m_lp[N][2 * MAX_BLOCK];
+};
@@ -0,0 +1,307 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Beat Tracker - spectral-flux onsets, tempo and beat phase
+// - Onset strength per FFT frame: half-wave rectified rise of the
+//   log-compressed bin magnitudes (spectral flux)
+// - Onset: a local flux maximum above an adaptive threshold (the
+//   recent mean, scaled, plus a floor from the long-term mean)
+// - Tempo: autocorrelation of the last ~5 s of flux, 60-200 BPM,
+//   weighted toward 120 BPM so half/double tempo lose ties
+// - Phase: next beat predicted one period ahead, pulled toward the
+//   onsets that land near a prediction
+// Once locked, process() reports the predicted beats, so a caller
+// that knows the output delay can fire them as they are heard; until
+// then it reports the onsets themselves.
+// Positions are in frames (one per process() call) counted from
+// reset(); runs in the analysis task.
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <math.h>
+#include "fast_math.h"
+
+class BeatTracker {
+public:
+    static constexpr float MIN_BPM = 60.0f;
+    static constexpr float MAX_BPM = 200.0f;
+    static constexpr int HISTORY = 256;     // Flux frames for the tempo (5.1 s at 50 fps)
+
+    // frameRate: process() calls per second. minInterval: shortest gap
+    // between reported onsets, in frames.
+    void init(float frameRate, float minInterval) {
+        m_rate = frameRate;
+        m_minInterval = minInterval;
+        m_lagMin = (int)(frameRate * 60.0f / MAX_BPM);
+        m_lagMax = (int)(frameRate * 60.0f / MIN_BPM + 1.0f);
+        if (m_lagMax > HISTORY / 2) m_lagMax = HISTORY / 2;
+        m_lag0 = frameRate * 0.5f;          // 120 BPM
+        reset();
+    }
+
+    void reset() {
+        for (int i = 0; i < HISTORY; i++) m_flux[i] = 0.0f;
+        m_prevBins = 0;
+        m_frame = 0;
+        m_fluxMean = 0.0f;
+        m_fluxLong = 0.0f;
+        m_lastOnset = -1e9f;
+        m_lastMatch = -1e9f;
+        m_period = 0.0f;
+        m_candidate = 0.0f;
+        m_nextBeat = 0.0f;
+        m_lastBeat = -1e9f;
+        m_beatLag = 0.0f;
+    }
+
+    // One frame of bin power (bins lo..hi-1; power * scale = amplitude^2,
+    // full scale 1). True when a beat falls in it, beatLag() frames before
+    // the frame's end.
+    bool process(const float* power, int lo, int hi, float scale) {
+        const float flux = spectralFlux(power, lo, hi, scale);
+        if (m_frame >= REBASE) rebase();
+        const uint32_t n = m_frame++;
+        m_flux[n % HISTORY] = flux;
+
+        // Peak picking one frame late: n-1 must beat both neighbours
+        bool onset = false;
+        float onsetPos = 0.0f;
+        if (n >= 2) {
+            const float prev = m_flux[(n - 1) % HISTORY];
+            const float before = m_flux[(n - 2) % HISTORY];
+            const float thresh = THRESH_SCALE * m_fluxMean + THRESH_FLOOR * m_fluxLong;
+            if (prev > before && prev >= flux && prev > thresh) {
+                onsetPos = (float)n - ONSET_OFFSET;
+                onset = onsetPos - m_lastOnset >= m_minInterval;
+                if (onset) m_lastOnset = onsetPos;
+            }
+        }
+        m_fluxMean += MEAN_ALPHA * (flux - m_fluxMean);
+        m_fluxLong += LONG_ALPHA * (flux - m_fluxLong);
+
+        if ((n + 1) % TEMPO_EVERY == 0 && n + 1 >= HISTORY / 2) updateTempo();
+        if (m_period > 0.0f && onset) correctPhase(onsetPos);
+        if (m_period > 0.0f && (float)n - m_lastMatch > LOCK_TIMEOUT_S * m_rate) m_period = 0.0f;
+
+        // Frame n covers positions (n, n + 1]
+        const float end = (float)n + 1.0f;
+        if (m_period > 0.0f) {
+            bool beat = false;
+            while (m_nextBeat <= end) {
+                m_beatLag = end - m_nextBeat;
+                m_lastBeat = m_nextBeat;
+                m_nextBeat += m_period;
+                beat = true;
+            }
+            return beat;
+        }
+        if (onset) {
+            m_beatLag = end - onsetPos;
+            m_lastBeat = onsetPos;
+            return true;
+        }
+        return false;
+    }
+
+    // Frames between the last reported beat and the end of its frame
+    float beatLag() const { return m_beatLag; }
+
+    bool locked() const { return m_period > 0.0f; }
+    float bpm() const { return m_period > 0.0f ? 60.0f * m_rate / m_period : 0.0f; }
+
+    // 0 on a beat rising to 1 just before the next, at the end of the
+    // last frame; 0 without a lock
+    float phase() const {
+        if (m_period <= 0.0f) return 0.0f;
+        const float p = 1.0f - (m_nextBeat - (float)m_frame) / m_period;
+        return p < 0.0f ? 0.0f : (p >= 1.0f ? 0.0f : p);
+    }
+
+private:
+    static constexpr float COMPRESS = 1000.0f;     // log(1 + C |X|), |X| full scale = 1
+    // The compressed flux jumps in the first frame that holds an onset,
+    // whatever the window length: place it mid-frame
+    static constexpr float ONSET_OFFSET = 1.0f;
+    static constexpr float THRESH_SCALE = 1.5f;
+    static constexpr float THRESH_FLOOR = 0.5f;
+    static constexpr float MEAN_ALPHA = 0.15f;     // ~6 frames
+    static constexpr float LONG_ALPHA = 0.005f;    // ~4 s at 50 fps
+    static constexpr uint32_t TEMPO_EVERY = 25;    // Frames between tempo estimates
+    static constexpr float PRIOR_OCTAVES = 1.0f;   // Width of the 120 BPM weighting
+    static constexpr float MIN_CONFIDENCE = 0.3f;  // Tempo peak / zero-lag autocorrelation
+    static constexpr float SAME_TEMPO = 0.08f;     // Relative period change that is a refinement
+    static constexpr float PERIOD_ALPHA = 0.3f;
+    static constexpr float SWITCH_MARGIN = 1.5f;   // Score ratio a new tempo needs over the locked one
+    static constexpr float PHASE_WINDOW = 0.25f;   // Onsets within this fraction of a period steer
+    static constexpr float PHASE_ALPHA = 0.3f;
+    static constexpr float MIN_GAP = 0.5f;         // Shortest beat gap after a phase move, in periods
+    static constexpr float LOCK_TIMEOUT_S = 4.0f;  // No matching onset for this long drops the lock
+    static constexpr float GRID_DECAY = 0.8f;      // Weight of each older beat in the phase grid
+    static constexpr int MAX_BINS = 512;
+    static constexpr int ACF_LAGS = HISTORY / 2 + 2;
+    static constexpr uint32_t REBASE = 1u << 20;    // Frames; keeps float positions exact
+
+    // Shift every position back so the float ones keep sub-frame
+    // resolution over hours of play
+    void rebase() {
+        m_frame -= REBASE;
+        m_lastOnset -= (float)REBASE;
+        m_lastMatch -= (float)REBASE;
+        m_nextBeat -= (float)REBASE;
+        m_lastBeat -= (float)REBASE;
+    }
+
+    float spectralFlux(const float* power, int lo, int hi, float scale) {
+        if (hi - lo > MAX_BINS) hi = lo + MAX_BINS;
+        const int bins = hi - lo;
+        float flux = 0.0f;
+        for (int k = 0; k < bins; k++) {
+            const float m = fast_logf(1.0f + COMPRESS * sqrtf(power[lo + k] * scale));
+            if (k < m_prevBins && m > m_prevLog[k]) flux += m - m_prevLog[k];
+            m_prevLog[k] = m;
+        }
+        m_prevBins = bins;
+        return flux;
+    }
+
+    // Flux history frame i (0 = oldest), mean removed
+    float histAt(int i) const { return m_flux[(m_frame - HISTORY + i) % HISTORY] - m_histMean; }
+
+    // Tempo: best weighted autocorrelation lag of the flux history,
+    // refined to a fraction of a frame. A lag also scores half of the
+    // peak at twice it, so a beat with alternating kick and snare is
+    // not taken for half its tempo.
+    void updateTempo() {
+        float mean = 0.0f;
+        for (int i = 0; i < HISTORY; i++) mean += m_flux[i];
+        m_histMean = mean / (float)HISTORY;
+
+        float r0 = 0.0f;
+        for (int i = 0; i < HISTORY; i++) r0 += histAt(i) * histAt(i);
+        if (r0 <= 1e-9f) return;
+
+        float* acf = m_acf;
+        int top = 2 * m_lagMax + 1;
+        if (top > ACF_LAGS - 1) top = ACF_LAGS - 1;
+        for (int lag = m_lagMin - 1; lag <= top; lag++) {
+            float r = 0.0f;
+            for (int i = lag; i < HISTORY; i++) r += histAt(i) * histAt(i - lag);
+            acf[lag] = r / (float)(HISTORY - lag);
+        }
+        auto score = [&](int lag) {
+            float r = acf[lag];
+            if (2 * lag + 1 <= top) {
+                r += 0.5f * fmaxf(acf[2 * lag], fmaxf(acf[2 * lag - 1], acf[2 * lag + 1]));
+            }
+            const float oct = log2f((float)lag / m_lag0) / PRIOR_OCTAVES;
+            return r * expf(-0.5f * oct * oct);
+        };
+        int best = -1;
+        float bestScore = 0.0f;
+        for (int lag = m_lagMin; lag <= m_lagMax; lag++) {
+            const float sc = score(lag);
+            if (sc > bestScore) {
+                bestScore = sc;
+                best = lag;
+            }
+        }
+        if (best < 0 || acf[best] < MIN_CONFIDENCE * r0 / (float)HISTORY) return;
+
+        // A locked tempo holds unless another one clearly wins
+        // (half and double tempo are often close)
+        const int held = (int)(m_period + 0.5f);
+        if (m_period > 0.0f && held >= m_lagMin && held <= m_lagMax && held != best &&
+            bestScore < SWITCH_MARGIN * score(held)) {
+            best = held;
+        }
+
+        // Parabola through the peak and its neighbours
+        float period = (float)best;
+        const float a = acf[best - 1], b = acf[best], c = acf[best + 1];
+        const float den = a - 2.0f * b + c;
+        if (den < 0.0f) period += 0.5f * (a - c) / den;
+
+        if (m_period > 0.0f && fabsf(period - m_period) < SAME_TEMPO * m_period) {
+            m_period += PERIOD_ALPHA * (period - m_period);
+            m_candidate = 0.0f;
+            m_lastMatch = (float)m_frame;
+            alignPhase(false);
+        } else if (m_candidate > 0.0f && fabsf(period - m_candidate) < SAME_TEMPO * m_candidate) {
+            // Two estimates in a row agree on a new tempo: take it
+            m_period = period;
+            m_candidate = 0.0f;
+            m_lastMatch = (float)m_frame;
+            alignPhase(true);
+        } else {
+            m_candidate = period;
+        }
+    }
+
+    // Phase: the beat grid at the current period that collects the
+    // most flux over the history, recent beats weighted most. Snaps a
+    // new lock (or one that is far off) to it, else nudges toward it.
+    void alignPhase(bool snap) {
+        const float period = m_period;
+        const int steps = (int)(period + 0.5f);
+        int best = 0;
+        float bestSum = -1e30f;
+        for (int ph = 0; ph < steps; ph++) {
+            float sum = 0.0f, w = 1.0f;
+            for (float back = (float)ph; back < (float)HISTORY - 0.5f; back += period) {
+                sum += w * histAt(HISTORY - 1 - (int)(back + 0.5f));
+                w *= GRID_DECAY;
+            }
+            if (sum > bestSum) {
+                bestSum = sum;
+                best = ph;
+            }
+        }
+        float next = (float)(m_frame - best) - ONSET_OFFSET;
+        while (next <= (float)m_frame) next += period;
+
+        float err = next - m_nextBeat;
+        while (err > 0.5f * period) err -= period;
+        while (err < -0.5f * period) err += period;
+        if (snap || fabsf(err) > PHASE_WINDOW * period) {
+            m_nextBeat = next;
+        } else {
+            m_nextBeat += PHASE_ALPHA * err;
+        }
+        // A beat pulled into the past still plays this frame; one right
+        // after the last reported beat would be a double
+        while (m_nextBeat - m_lastBeat < MIN_GAP * period) m_nextBeat += period;
+    }
+
+    // Pull the prediction toward an onset near one of its beats
+    void correctPhase(float onset) {
+        float err = onset - (m_nextBeat - m_period);
+        while (err > 0.5f * m_period) err -= m_period;
+        while (err < -0.5f * m_period) err += m_period;
+        if (fabsf(err) > PHASE_WINDOW * m_period) return;
+        m_nextBeat += PHASE_ALPHA * err;
+        m_lastMatch = onset;
+    }
+
+    float m_rate = 50.0f;
+    float m_minInterval = 1.0f;
+    int m_lagMin = 15;
+    int m_lagMax = 50;
+    float m_lag0 = 25.0f;
+
+    float m_flux[HISTORY];
+    float m_prevLog[MAX_BINS];
+    float m_acf[ACF_LAGS];
+    float m_histMean = 0.0f;
+    int m_prevBins = 0;
+    uint32_t m_frame = 0;
+    float m_fluxMean = 0.0f;
+    float m_fluxLong = 0.0f;
+    float m_lastOnset = -1e9f;
+    float m_lastMatch = -1e9f;
+
+    float m_period = 0.0f;      // Frames per beat, 0 = no lock
+    float m_candidate = 0.0f;   // Tempo seen once, waiting for a second estimate
+    float m_nextBeat = 0.0f;
+    float m_lastBeat = -1e9f;
+    float m_beatLag = 0.0f;
+};
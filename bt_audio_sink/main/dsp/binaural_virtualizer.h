@@ -0,0 +1,253 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Binaural Virtualizer - headphone playback from two virtual front
+// speakers (APP_DSP_BINAURAL), the third 3D mode
+// - Each speaker reaches the near ear through the ipsilateral and the
+//   far ear through the contralateral head-related impulse response;
+//   the head is symmetric, so one pair serves both speakers:
+//     L' = hi * L + hc * R,  R' = hi * R + hc * L
+// - The pair is a spherical head model (Brown & Duda): a one-pole
+//   head shadow per ear, the interaural delay as a fractional-delay
+//   sinc and a shoulder reflection, TAPS long and designed per rate
+//   for speakers APP_DSP_BINAURAL_ANGLE degrees off centre
+// - Uniformly partitioned overlap-save as FirConvolver, at the stream
+//   rate: L and R travel as one complex signal z = L + jR, and with
+//   Z'[k] = conj(Z[M - k]) the output spectrum is
+//     Y = Hi * Z + j Hc * Z'
+//   so one forward and one inverse FFT per B frames cover both ears
+// - Latency is B frames plus the model's bulk delay (~0.3 ms)
+// - Mono input keeps its level (hi + hc has unity gain at DC)
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <type_traits>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "complex_fft.h"
+#include "fast_math.h"
+#include "../config/app_config.h"
+
+class BinauralVirtualizer {
+public:
+    static constexpr int B = 128;                   // Partition, frames of latency
+    static constexpr int M = 2 * B;
+    static constexpr int TAPS = 256;                // 5.8 ms at 44.1 kHz, 2.7 ms at 96 kHz
+    static constexpr int PARTS = TAPS / B;
+
+    // Head model (Brown & Duda 1998)
+    static constexpr float HEAD_RADIUS_M = 0.0875f;
+    static constexpr float SOUND_SPEED = 343.0f;
+    static constexpr float ALPHA_MIN = 0.1f;        // Shadow depth behind the head
+    static constexpr float THETA_MIN_DEG = 150.0f;  // Incidence of the deepest shadow
+    static constexpr float SHOULDER_MS = 1.1f;
+    static constexpr float SHOULDER_GAIN = 0.2f;
+    static constexpr int SINC_HALF = 8;             // Fractional delay half width, also the bulk delay
+
+    ~BinauralVirtualizer() {
+        if (m_spec) heap_caps_free(m_spec);
+    }
+
+    // Control task, stream paused (init and rate changes): the pair for
+    // the rate, and a restart from silence. False without memory.
+    bool setSampleRate(uint32_t sampleRate) {
+        if (!allocate()) return false;
+        if (!m_fftReady) {
+            m_fft.init();
+            m_fftReady = true;
+        }
+        if (sampleRate != m_sampleRate) {
+            float hi[TAPS], hc[TAPS];
+            const float angle = (float)APP_DSP_BINAURAL_ANGLE;
+            design(hi, (float)sampleRate, 90.0f - angle);
+            design(hc, (float)sampleRate, 90.0f + angle);
+            // Unity mono gain: both ears' DC sums to 1
+            float dc = 0.0f;
+            for (int n = 0; n < TAPS; n++) dc += hi[n] + hc[n];
+            const float norm = dc > 0.0f ? 1.0f / dc : 1.0f;
+            transform(hi, norm, false, m_spec);
+            transform(hc, norm, true, m_spec + (size_t)PARTS * 2 * M);
+            m_sampleRate = sampleRate;
+        }
+        reset();
+        return true;
+    }
+
+    // Restart from silence at the next block (audio task, or stopped)
+    void reset() { m_fresh = true; }
+
+    // Audio task: interleaved stereo in place. toFloat/fromFloat convert
+    // T to and from the float full scale (1.0 / 1.0 for float).
+    template <typename T>
+    void process(T* buf, size_t frames, float toFloat, float fromFloat) {
+        if (!m_spec || !m_sampleRate) return;
+        if (m_fresh) {
+            clearState();
+            m_fresh = false;
+        }
+        float* in = m_time + 2 * B;  // Newest half of the time buffer
+        for (size_t i = 0; i < frames; i++) {
+            in[2 * m_pos] = (float)buf[2 * i] * toFloat;
+            in[2 * m_pos + 1] = (float)buf[2 * i + 1] * toFloat;
+            buf[2 * i] = toSample<T>(m_out[2 * m_pos] * fromFloat);
+            buf[2 * i + 1] = toSample<T>(m_out[2 * m_pos + 1] * fromFloat);
+            if (++m_pos == B) {
+                m_pos = 0;
+                partition();
+            }
+        }
+    }
+
+private:
+    static constexpr const char* TAG = "Binaural";
+
+    template <typename T>
+    static inline T toSample(float v) {
+        if (std::is_floating_point<T>::value) return (T)v;
+        if (v > 2147483520.0f) v = 2147483520.0f;
+        if (v < -2147483520.0f) v = -2147483520.0f;
+        return (T)v;
+    }
+
+    // Ear response to a source at incidence theta (degrees from the
+    // ear's axis): sinc impulses at the arrival and shoulder times
+    // through the head shadow filter
+    static void design(float* h, float fs, float thetaDeg) {
+        const float theta = thetaDeg * (DSP_PI_F / 180.0f);
+        const float headDelay = HEAD_RADIUS_M / SOUND_SPEED;
+        // Arrival relative to the head centre, shifted to be >= 0
+        const float tau = (theta < DSP_PI_F * 0.5f) ? headDelay * (1.0f - cosf(theta))
+                                                     : headDelay * (1.0f + theta - DSP_PI_F * 0.5f);
+        const float direct = (float)SINC_HALF + tau * fs;
+        memset(h, 0, TAPS * sizeof(float));
+        addSinc(h, direct, 1.0f);
+        addSinc(h, direct + SHOULDER_MS * 0.001f * fs, SHOULDER_GAIN);
+
+        // Shadow (alpha s + 2 w0) / (s + 2 w0), bilinear
+        const float alpha = (1.0f + ALPHA_MIN * 0.5f) +
+                            (1.0f - ALPHA_MIN * 0.5f) * cosf(thetaDeg / THETA_MIN_DEG * DSP_PI_F);
+        const float w2 = 2.0f * SOUND_SPEED / HEAD_RADIUS_M;
+        const float k = 2.0f * fs;
+        const float a0 = k + w2;
+        const float b0 = (alpha * k + w2) / a0;
+        const float b1 = (w2 - alpha * k) / a0;
+        const float a1 = (w2 - k) / a0;
+        float x1 = 0.0f, y1 = 0.0f;
+        for (int n = 0; n < TAPS; n++) {
+            const float x = h[n];
+            const float y = b0 * x + b1 * x1 - a1 * y1;
+            x1 = x;
+            y1 = y;
+            h[n] = y;
+        }
+    }
+
+    // Hann windowed sinc centred on at
+    static void addSinc(float* h, float at, float gain) {
+        const int first = (int)ceilf(at - (float)SINC_HALF);
+        for (int n = first; n < first + 2 * SINC_HALF; n++) {
+            if (n < 0 || n >= TAPS) continue;
+            const float t = (float)n - at;
+            const float s = fabsf(t) < 1e-6f ? 1.0f : sinf(DSP_PI_F * t) / (DSP_PI_F * t);
+            const float w = 0.5f + 0.5f * cosf(DSP_PI_F * t / (float)SINC_HALF);
+            h[n] += gain * s * w;
+        }
+    }
+
+    // Partition spectra of h, scaled for the inverse transform; rotated
+    // by j for the contralateral path
+    void transform(const float* h, float norm, bool timesJ, float* spec) {
+        for (int p = 0; p < PARTS; p++) {
+            float* s = spec + (size_t)p * 2 * M;
+            memset(s, 0, 2 * M * sizeof(float));
+            for (int n = 0; n < B; n++) s[2 * n] = h[p * B + n] * norm * (1.0f / (float)M);
+            m_fft.forward(s);
+            if (timesJ) {
+                for (int k = 0; k < M; k++) {
+                    const float re = s[2 * k];
+                    s[2 * k] = -s[2 * k + 1];
+                    s[2 * k + 1] = re;
+                }
+            }
+        }
+    }
+
+    // Both pairs' spectra and the input history, one allocation (12 KB);
+    // internal RAM first, every partition reads all of it
+    bool allocate() {
+        if (m_spec) return true;
+        const size_t bytes = (size_t)3 * PARTS * 2 * M * sizeof(float);
+        float* p = (float*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!p && heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0) {
+            p = (float*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (!p) {
+            ESP_LOGE(TAG, "Buffers (%u KB) allocation failed, binaural bypassed", (unsigned)(bytes / 1024));
+            return false;
+        }
+        m_fdl = p + (size_t)2 * PARTS * 2 * M;
+        m_spec = p;
+        return true;
+    }
+
+    void clearState() {
+        memset(m_time, 0, sizeof(m_time));
+        memset(m_out, 0, sizeof(m_out));
+        memset(m_fdl, 0, (size_t)PARTS * 2 * M * sizeof(float));
+        m_pos = 0;
+        m_head = 0;
+    }
+
+    // B new frames are in: transform, multiply-accumulate both paths,
+    // transform back
+    void partition() {
+        float* x = m_fdl + (size_t)m_head * 2 * M;
+        memcpy(x, m_time, sizeof(m_time));
+        m_fft.forward(x);
+        memcpy(m_time, m_time + 2 * B, 2 * B * sizeof(float));
+
+        float* acc = m_acc;
+        memset(acc, 0, sizeof(m_acc));
+        const float* hiSpec = m_spec;
+        const float* hcSpec = m_spec + (size_t)PARTS * 2 * M;
+        int slot = m_head;
+        for (int p = 0; p < PARTS; p++) {
+            const float* X = m_fdl + (size_t)slot * 2 * M;
+            const float* Hi = hiSpec + (size_t)p * 2 * M;
+            const float* Hc = hcSpec + (size_t)p * 2 * M;
+            for (int k = 0; k < M; k++) {
+                const int m = (M - k) & (M - 1);
+                const float xr = X[2 * k], xi = X[2 * k + 1];
+                const float cr = X[2 * m], ci = -X[2 * m + 1];     // conj(Z[M - k])
+                acc[2 * k] += xr * Hi[2 * k] - xi * Hi[2 * k + 1] + cr * Hc[2 * k] - ci * Hc[2 * k + 1];
+                acc[2 * k + 1] += xr * Hi[2 * k + 1] + xi * Hi[2 * k] + cr * Hc[2 * k + 1] + ci * Hc[2 * k];
+            }
+            slot = (slot == 0) ? PARTS - 1 : slot - 1;
+        }
+        m_head = (m_head + 1 == PARTS) ? 0 : m_head + 1;
+
+        // Inverse as conj(FFT(conj(Y))); the last B outputs are valid
+        for (int k = 0; k < M; k++) acc[2 * k + 1] = -acc[2 * k + 1];
+        m_fft.forward(acc);
+        for (int n = 0; n < B; n++) {
+            m_out[2 * n] = acc[2 * (B + n)];
+            m_out[2 * n + 1] = -acc[2 * (B + n) + 1];
+        }
+    }
+
+    ComplexFft<M> m_fft;
+    bool m_fftReady = false;
+    uint32_t m_sampleRate = 0;          // Of the designed pair, 0 = none
+    float* m_spec = nullptr;            // Hi partitions, then j Hc partitions
+    float* m_fdl = nullptr;             // PARTS input spectra, ring
+
+    // Audio task state
+    volatile bool m_fresh = true;
+    int m_head = 0;
+    float m_time[2 * M];                // Previous and current B frames
+    float m_acc[2 * M];
+    float m_out[2 * B];                 // Output of the last partition
+    int m_pos = 0;
+};
@@ -6,6 +6,7 @@
 // -----------------------------------------------------------
 
 #include <math.h>
+#include <stddef.h>
 #include "fast_math.h"
 #include "../config/app_config.h"
 
@@ -24,6 +25,23 @@ public:
         return out;
     }
 
+    // Process a block of samples in place. stride selects one channel of an
+    // interleaved buffer (2 = stereo). Coefficients and state are held in
+    // locals for the whole block instead of round-tripping through memory.
+    inline void processBlock(float* buf, size_t frames, size_t stride) {
+        const float c0 = b0, c1 = b1, c2 = b2, d1 = a1, d2 = a2;
+        float s1 = z1, s2 = z2;
+        for (size_t i = 0; i < frames; i++) {
+            float in = buf[i * stride];
+            float out = c0 * in + s1;
+            s1 = c1 * in + s2 - d1 * out;
+            s2 = c2 * in - d2 * out;
+            buf[i * stride] = out;
+        }
+        z1 = s1;
+        z2 = s2;
+    }
+
     void reset() {
         z1 = 0.0f;
         z2 = 0.0f;
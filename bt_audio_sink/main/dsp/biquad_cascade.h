@@ -0,0 +1,226 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Stereo biquad cascade
+// N second-order sections sharing coefficients between L/R,
+// Transposed Direct Form II, state interleaved per section.
+//
+// Sections run one at a time over the whole block (section-major):
+// 5 coefficients + 4 states + 2 samples stay in the 16 FP registers
+// of the LX6 for the inner loop, and the expressions are written as
+// multiply-accumulate chains so GCC emits madd.s/msub.s.
+// Inactive (unity) sections are skipped entirely.
+//
+// Coefficient updates never touch the filter state: setSection() only
+// posts a target, and the next process() call interpolates from the
+// current to the target coefficients across that block. Enabling or
+// disabling a section ramps from/to unity, so EQ changes are click-free.
+//
+// process<true>() filters the left slot of each frame only, for a
+// mono signal carried in a stereo block (APP_MONO_SPEAKER); the right
+// channel's state is then unused.
+// -----------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+#include "biquad.h"
+
+template <int N>
+class BiquadCascade {
+public:
+    BiquadCascade() {
+        for (int s = 0; s < N; s++) {
+            m_cur[s] = UNITY;
+            m_target[s] = UNITY;
+            m_active[s] = false;
+            m_targetActive[s] = false;
+        }
+        reset();
+    }
+
+    // Post new coefficients for a section (any one task at a time: the
+    // sequence is a single-writer seqlock). Applied with a crossfade over
+    // the next processed block.
+    void setSection(int s, const Biquad& design, bool active) {
+        if (s < 0 || s >= N) return;
+        m_targetSeq = m_targetSeq + 1;    // Odd: write in progress
+        __asm__ __volatile__("" ::: "memory");
+        m_target[s] = {design.b0, design.b1, design.b2, design.a1, design.a2};
+        m_targetActive[s] = active;
+        __asm__ __volatile__("" ::: "memory");
+        m_targetSeq = m_targetSeq + 1;    // Even: targets complete
+    }
+
+    bool isActive(int s) const { return (s >= 0 && s < N) ? m_targetActive[s] : false; }
+
+    bool anyActive() const {
+        for (int s = 0; s < N; s++) {
+            if (m_targetActive[s]) return true;
+        }
+        return false;
+    }
+
+    // Unity as it stands: no section running or posted, no ramp to come
+    // (audio task)
+    bool isUnity() const {
+        for (int s = 0; s < N; s++) {
+            if (m_active[s] || m_targetActive[s]) return false;
+        }
+        return true;
+    }
+
+    // Clear state and jump straight to the posted coefficients (sample rate
+    // change: the old state is meaningless anyway)
+    void reset() {
+        // Sequence first: a post racing the copy then leaves it behind and
+        // is picked up by the next process()
+        const uint32_t seq = m_targetSeq & ~1u;
+        __asm__ __volatile__("" ::: "memory");
+        for (int s = 0; s < N; s++) {
+            for (int k = 0; k < 4; k++) m_z[s][k] = 0.0f;
+            m_cur[s] = m_target[s];
+            m_active[s] = m_targetActive[s];
+        }
+        m_appliedSeq = seq;
+    }
+
+    // Process an interleaved stereo block in place (Mono: left slots only)
+    template <bool Mono = false>
+    void process(float* buf, size_t frames) {
+        if (frames == 0) return;
+
+        // Pick up posted targets (seqlock). An odd sequence means a
+        // setSection() is mid-write, and a sequence that moved during the
+        // copy means the copy is torn; either way it is retried next block.
+        Coeffs to[N];
+        bool toActive[N];
+        bool ramp = false;
+        uint32_t seq = m_targetSeq;
+        if (!(seq & 1) && seq != m_appliedSeq) {
+            __asm__ __volatile__("" ::: "memory");
+            for (int s = 0; s < N; s++) {
+                to[s] = m_target[s];
+                toActive[s] = m_targetActive[s];
+            }
+            __asm__ __volatile__("" ::: "memory");
+            if (seq == m_targetSeq) {
+                m_appliedSeq = seq;
+                ramp = true;
+            }
+        }
+
+        const float inv = 1.0f / (float)frames;
+        for (int s = 0; s < N; s++) {
+            if (!ramp || (!m_active[s] && !toActive[s])) {
+                if (m_active[s]) runSection<Mono>(s, buf, frames);
+                if (ramp) m_cur[s] = to[s];
+                continue;
+            }
+
+            // Fade in from unity with clean state, fade out to unity
+            Coeffs from = m_active[s] ? m_cur[s] : UNITY;
+            Coeffs dest = toActive[s] ? to[s] : UNITY;
+            if (!m_active[s]) {
+                for (int k = 0; k < 4; k++) m_z[s][k] = 0.0f;
+            }
+            runSectionRamp<Mono>(s, buf, frames, from, dest, inv);
+            m_cur[s] = to[s];
+            m_active[s] = toActive[s];
+        }
+    }
+
+private:
+    struct Coeffs {
+        float b0, b1, b2, a1, a2;
+    };
+
+    static constexpr Coeffs UNITY = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+    template <bool Mono>
+    inline void runSection(int s, float* buf, size_t frames) {
+        const float b0 = m_cur[s].b0, b1 = m_cur[s].b1, b2 = m_cur[s].b2;
+        const float a1 = m_cur[s].a1, a2 = m_cur[s].a2;
+        float z1L = m_z[s][0], z1R = m_z[s][1];
+        float z2L = m_z[s][2], z2R = m_z[s][3];
+
+        float* p = buf;
+        if (Mono) {
+            for (size_t i = 0; i < frames; i++, p += 2) {
+                const float x = p[0];
+                const float y = z1L + b0 * x;
+                z1L = (z2L + b1 * x) - a1 * y;
+                z2L = b2 * x - a2 * y;
+                p[0] = y;
+            }
+        } else {
+            for (size_t i = 0; i < frames; i++, p += 2) {
+                const float xL = p[0];
+                const float xR = p[1];
+                const float yL = z1L + b0 * xL;
+                const float yR = z1R + b0 * xR;
+                z1L = (z2L + b1 * xL) - a1 * yL;
+                z1R = (z2R + b1 * xR) - a1 * yR;
+                z2L = b2 * xL - a2 * yL;
+                z2R = b2 * xR - a2 * yR;
+                p[0] = yL;
+                p[1] = yR;
+            }
+        }
+
+        m_z[s][0] = z1L;
+        m_z[s][1] = z1R;
+        m_z[s][2] = z2L;
+        m_z[s][3] = z2R;
+    }
+
+    // Same kernel with coefficients linearly interpolated per frame
+    template <bool Mono>
+    inline void runSectionRamp(int s, float* buf, size_t frames,
+                               const Coeffs& from, const Coeffs& to, float inv) {
+        float b0 = from.b0, b1 = from.b1, b2 = from.b2, a1 = from.a1, a2 = from.a2;
+        const float db0 = (to.b0 - from.b0) * inv, db1 = (to.b1 - from.b1) * inv;
+        const float db2 = (to.b2 - from.b2) * inv, da1 = (to.a1 - from.a1) * inv;
+        const float da2 = (to.a2 - from.a2) * inv;
+        float z1L = m_z[s][0], z1R = m_z[s][1];
+        float z2L = m_z[s][2], z2R = m_z[s][3];
+
+        float* p = buf;
+        if (Mono) {
+            for (size_t i = 0; i < frames; i++, p += 2) {
+                b0 += db0; b1 += db1; b2 += db2; a1 += da1; a2 += da2;
+                const float x = p[0];
+                const float y = z1L + b0 * x;
+                z1L = (z2L + b1 * x) - a1 * y;
+                z2L = b2 * x - a2 * y;
+                p[0] = y;
+            }
+        } else {
+            for (size_t i = 0; i < frames; i++, p += 2) {
+                b0 += db0; b1 += db1; b2 += db2; a1 += da1; a2 += da2;
+                const float xL = p[0];
+                const float xR = p[1];
+                const float yL = z1L + b0 * xL;
+                const float yR = z1R + b0 * xR;
+                z1L = (z2L + b1 * xL) - a1 * yL;
+                z1R = (z2R + b1 * xR) - a1 * yR;
+                z2L = b2 * xL - a2 * yL;
+                z2R = b2 * xR - a2 * yR;
+                p[0] = yL;
+                p[1] = yR;
+            }
+        }
+
+        m_z[s][0] = z1L;
+        m_z[s][1] = z1R;
+        m_z[s][2] = z2L;
+        m_z[s][3] = z2R;
+    }
+
+    Coeffs m_cur[N];            // Coefficients in use (audio task only)
+    Coeffs m_target[N];         // Posted by setSection()
+    float m_z[N][4];            // z1L, z1R, z2L, z2R per section
+    bool m_active[N];
+    bool m_targetActive[N];
+    volatile uint32_t m_targetSeq = 0;  // Seqlock over m_target, odd while written
+    uint32_t m_appliedSeq = 0;
+};
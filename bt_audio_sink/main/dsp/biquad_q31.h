@@ -0,0 +1,235 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Fixed-point biquads for the Q31 DSP path
+// - Samples are Q27 inside the chain (Q31 input >> 4), which leaves
+//   24 dB of headroom for EQ boost while keeping all 24 bits of an
+//   LDAC/aptX HD sample
+// - Coefficients are Q28 (range +/-8), designed in float by Biquad
+// - Direct Form I with a 64-bit accumulator: no state rounding
+//   feedback, unlike TDF-II in fixed point
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "biquad.h"
+
+// Internal sample format: Q31 input shifted down by this many bits
+#define DSP_Q31_HEADROOM_BITS   4
+#define DSP_Q_COEF_BITS         28
+
+static inline int32_t dsp_q_coef(float c) {
+    return (int32_t)lrintf(c * (float)(1 << DSP_Q_COEF_BITS));
+}
+
+static inline int32_t dsp_q_sat32(int64_t v) {
+    if (v > INT32_MAX) return INT32_MAX;
+    if (v < INT32_MIN) return INT32_MIN;
+    return (int32_t)v;
+}
+
+// Single-channel Q31 biquad (strided over an interleaved buffer)
+class BiquadQ31 {
+public:
+    void set(const Biquad& design) {
+        m_b0 = dsp_q_coef(design.b0);
+        m_b1 = dsp_q_coef(design.b1);
+        m_b2 = dsp_q_coef(design.b2);
+        m_a1 = dsp_q_coef(design.a1);
+        m_a2 = dsp_q_coef(design.a2);
+    }
+
+    void reset() {
+        m_x1 = m_x2 = m_y1 = m_y2 = 0;
+    }
+
+    inline void processBlock(int32_t* buf, size_t frames, size_t stride) {
+        const int64_t b0 = m_b0, b1 = m_b1, b2 = m_b2, a1 = m_a1, a2 = m_a2;
+        int32_t x1 = m_x1, x2 = m_x2, y1 = m_y1, y2 = m_y2;
+        for (size_t i = 0; i < frames; i++) {
+            const int32_t x = buf[i * stride];
+            int64_t acc = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+            const int32_t y = dsp_q_sat32(acc >> DSP_Q_COEF_BITS);
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+            buf[i * stride] = y;
+        }
+        m_x1 = x1;
+        m_x2 = x2;
+        m_y1 = y1;
+        m_y2 = y2;
+    }
+
+private:
+    int32_t m_b0 = 1 << DSP_Q_COEF_BITS, m_b1 = 0, m_b2 = 0, m_a1 = 0, m_a2 = 0;
+    int32_t m_x1 = 0, m_x2 = 0, m_y1 = 0, m_y2 = 0;
+};
+
+// Stereo Q31 cascade, same layout and API as BiquadCascade<N>: setSection()
+// posts a target and the next block ramps the coefficients to it
+template <int N>
+class BiquadCascadeQ31 {
+public:
+    BiquadCascadeQ31() {
+        for (int s = 0; s < N; s++) {
+            m_c[s] = UNITY;
+            m_target[s] = UNITY;
+            m_active[s] = false;
+            m_targetActive[s] = false;
+        }
+        reset();
+    }
+
+    void setSection(int s, const Biquad& design, bool active) {
+        if (s < 0 || s >= N) return;
+        m_targetSeq = m_targetSeq + 1;    // Odd: write in progress
+        __asm__ __volatile__("" ::: "memory");
+        m_target[s] = {dsp_q_coef(design.b0), dsp_q_coef(design.b1), dsp_q_coef(design.b2),
+                       dsp_q_coef(design.a1), dsp_q_coef(design.a2)};
+        m_targetActive[s] = active;
+        __asm__ __volatile__("" ::: "memory");
+        m_targetSeq = m_targetSeq + 1;    // Even: targets complete
+    }
+
+    // Clear state and jump straight to the posted coefficients
+    void reset() {
+        // Sequence first, so a post racing the copy is applied next block
+        const uint32_t seq = m_targetSeq & ~1u;
+        __asm__ __volatile__("" ::: "memory");
+        for (int s = 0; s < N; s++) {
+            for (int k = 0; k < 8; k++) m_z[s][k] = 0;
+            m_c[s] = m_target[s];
+            m_active[s] = m_targetActive[s];
+        }
+        m_appliedSeq = seq;
+    }
+
+    // Process an interleaved stereo Q27 block in place
+    void process(int32_t* buf, size_t frames) {
+        if (frames == 0) return;
+
+        // Pick up posted targets, skipped while odd and retried next block
+        // if torn (seqlock, see BiquadCascade)
+        Coeffs to[N];
+        bool toActive[N];
+        bool ramp = false;
+        uint32_t seq = m_targetSeq;
+        if (!(seq & 1) && seq != m_appliedSeq) {
+            __asm__ __volatile__("" ::: "memory");
+            for (int s = 0; s < N; s++) {
+                to[s] = m_target[s];
+                toActive[s] = m_targetActive[s];
+            }
+            __asm__ __volatile__("" ::: "memory");
+            if (seq == m_targetSeq) {
+                m_appliedSeq = seq;
+                ramp = true;
+            }
+        }
+
+        for (int s = 0; s < N; s++) {
+            if (!ramp || (!m_active[s] && !toActive[s])) {
+                if (m_active[s]) runSection(s, buf, frames);
+                if (ramp) m_c[s] = to[s];
+                continue;
+            }
+
+            // Fade in from unity with clean state, fade out to unity
+            const Coeffs from = m_active[s] ? m_c[s] : UNITY;
+            const Coeffs dest = toActive[s] ? to[s] : UNITY;
+            if (!m_active[s]) {
+                for (int k = 0; k < 8; k++) m_z[s][k] = 0;
+            }
+            runSectionRamp(s, buf, frames, from, dest);
+            m_c[s] = to[s];
+            m_active[s] = toActive[s];
+        }
+    }
+
+private:
+    struct Coeffs {
+        int32_t b0, b1, b2, a1, a2;
+    };
+
+    static constexpr Coeffs UNITY = {1 << DSP_Q_COEF_BITS, 0, 0, 0, 0};
+
+    inline void runSection(int s, int32_t* buf, size_t frames) {
+        const int64_t b0 = m_c[s].b0, b1 = m_c[s].b1, b2 = m_c[s].b2;
+        const int64_t a1 = m_c[s].a1, a2 = m_c[s].a2;
+        int32_t* z = m_z[s];
+        int32_t x1L = z[0], x2L = z[1], y1L = z[2], y2L = z[3];
+        int32_t x1R = z[4], x2R = z[5], y1R = z[6], y2R = z[7];
+
+        int32_t* p = buf;
+        for (size_t i = 0; i < frames; i++, p += 2) {
+            const int32_t xL = p[0];
+            const int32_t xR = p[1];
+            int64_t accL = b0 * xL + b1 * x1L + b2 * x2L - a1 * y1L - a2 * y2L;
+            int64_t accR = b0 * xR + b1 * x1R + b2 * x2R - a1 * y1R - a2 * y2R;
+            const int32_t yL = dsp_q_sat32(accL >> DSP_Q_COEF_BITS);
+            const int32_t yR = dsp_q_sat32(accR >> DSP_Q_COEF_BITS);
+            x2L = x1L; x1L = xL; y2L = y1L; y1L = yL;
+            x2R = x1R; x1R = xR; y2R = y1R; y1R = yR;
+            p[0] = yL;
+            p[1] = yR;
+        }
+
+        z[0] = x1L; z[1] = x2L; z[2] = y1L; z[3] = y2L;
+        z[4] = x1R; z[5] = x2R; z[6] = y1R; z[7] = y2R;
+    }
+
+    // Same kernel with the coefficients stepped linearly per frame; the
+    // last frame lands exactly on the target
+    inline void runSectionRamp(int s, int32_t* buf, size_t frames, const Coeffs& from, const Coeffs& to) {
+        const int32_t n = (int32_t)frames;
+        const int32_t db0 = step(from.b0, to.b0, n), db1 = step(from.b1, to.b1, n);
+        const int32_t db2 = step(from.b2, to.b2, n), da1 = step(from.a1, to.a1, n);
+        const int32_t da2 = step(from.a2, to.a2, n);
+        int32_t b0 = start(to.b0, db0, n), b1 = start(to.b1, db1, n), b2 = start(to.b2, db2, n);
+        int32_t a1 = start(to.a1, da1, n), a2 = start(to.a2, da2, n);
+        int32_t* z = m_z[s];
+        int32_t x1L = z[0], x2L = z[1], y1L = z[2], y2L = z[3];
+        int32_t x1R = z[4], x2R = z[5], y1R = z[6], y2R = z[7];
+
+        int32_t* p = buf;
+        for (size_t i = 0; i < frames; i++, p += 2) {
+            b0 += db0; b1 += db1; b2 += db2; a1 += da1; a2 += da2;
+            const int32_t xL = p[0];
+            const int32_t xR = p[1];
+            int64_t accL = (int64_t)b0 * xL + (int64_t)b1 * x1L + (int64_t)b2 * x2L
+                         - (int64_t)a1 * y1L - (int64_t)a2 * y2L;
+            int64_t accR = (int64_t)b0 * xR + (int64_t)b1 * x1R + (int64_t)b2 * x2R
+                         - (int64_t)a1 * y1R - (int64_t)a2 * y2R;
+            const int32_t yL = dsp_q_sat32(accL >> DSP_Q_COEF_BITS);
+            const int32_t yR = dsp_q_sat32(accR >> DSP_Q_COEF_BITS);
+            x2L = x1L; x1L = xL; y2L = y1L; y1L = yL;
+            x2R = x1R; x1R = xR; y2R = y1R; y1R = yR;
+            p[0] = yL;
+            p[1] = yR;
+        }
+
+        z[0] = x1L; z[1] = x2L; z[2] = y1L; z[3] = y2L;
+        z[4] = x1R; z[5] = x2R; z[6] = y1R; z[7] = y2R;
+    }
+
+    // Per-frame step; the difference of two Q28 values may not fit 32 bits
+    static int32_t step(int32_t from, int32_t to, int32_t n) {
+        return (int32_t)(((int64_t)to - from) / n);
+    }
+
+    // Value before the first step, within n of from
+    static int32_t start(int32_t to, int32_t inc, int32_t n) {
+        return (int32_t)(to - (int64_t)inc * n);
+    }
+
+    Coeffs m_c[N];              // Coefficients in use (audio task only)
+    Coeffs m_target[N];         // Posted by setSection()
+    int32_t m_z[N][8];          // x1, x2, y1, y2 for L then R
+    bool m_active[N];
+    bool m_targetActive[N];
+    volatile uint32_t m_targetSeq = 0;
+    uint32_t m_appliedSeq = 0;
+};
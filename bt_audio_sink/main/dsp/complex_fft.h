@@ -0,0 +1,68 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Complex FFT - in-place radix-2 DIT, size fixed at compile time
+// Data is M interleaved complex values (re, im). Forward only;
+// the inverse is conj(forward(conj(X))) / M, which callers fold
+// into their own scaling.
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <math.h>
+#include "fast_math.h"
+#include "../config/app_config.h"
+
+template <int M>
+class ComplexFft {
+public:
+    static_assert((M & (M - 1)) == 0 && M >= 4, "FFT size must be a power of two");
+
+    void init() {
+        for (int k = 0; k < M / 2; k++) {
+            m_cos[k] = cosf(2.0f * DSP_PI_F * (float)k / (float)M);
+            m_sin[k] = sinf(2.0f * DSP_PI_F * (float)k / (float)M);
+        }
+        int bits = 0;
+        while ((1 << bits) < M) bits++;
+        for (int i = 0; i < M; i++) {
+            int r = 0;
+            for (int b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits - 1 - b);
+            m_bitrev[i] = (uint16_t)r;
+        }
+    }
+
+    void forward(float* z) const {
+        for (int i = 0; i < M; i++) {
+            const int j = m_bitrev[i];
+            if (j > i) {
+                float tr = z[2 * i], ti = z[2 * i + 1];
+                z[2 * i] = z[2 * j];
+                z[2 * i + 1] = z[2 * j + 1];
+                z[2 * j] = tr;
+                z[2 * j + 1] = ti;
+            }
+        }
+        for (int len = 2; len <= M; len <<= 1) {
+            const int half = len >> 1;
+            const int step = M / len;  // W_len^m = W_M^(m*step)
+            for (int start = 0; start < M; start += len) {
+                for (int m = 0; m < half; m++) {
+                    const float wr = m_cos[m * step], wi = -m_sin[m * step];
+                    float* a = &z[2 * (start + m)];
+                    float* c = &z[2 * (start + m + half)];
+                    const float tr = wr * c[0] - wi * c[1];
+                    const float ti = wr * c[1] + wi * c[0];
+                    c[0] = a[0] - tr;
+                    c[1] = a[1] - ti;
+                    a[0] += tr;
+                    a[1] += ti;
+                }
+            }
+        }
+    }
+
+private:
+    float m_cos[M / 2];
+    float m_sin[M / 2];
+    uint16_t m_bitrev[M];
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Compile-time math for lookup tables
+// constexpr versions of the libm functions the tables are
+// built with, so a table is generated by the compiler into
+// flash (rodata) instead of filled into DRAM at boot. Double
+// precision series, evaluated only at compile time: accurate
+// to well under a table step, not for use at run time.
+// -----------------------------------------------------------
+
+#include <stdint.h>
+
+static constexpr double CM_PI = 3.14159265358979323846;
+
+// Round half away from zero, as lroundf()
+static constexpr long cm_lround(double x) {
+    return x >= 0.0 ? (long)(x + 0.5) : -(long)(-x + 0.5);
+}
+
+// sin(x), reduced to [-pi, pi], Taylor to 1e-17
+static constexpr double cm_sin(double x) {
+    const double turn = 2.0 * CM_PI;
+    x -= turn * (double)(long)(x / turn);
+    if (x > CM_PI) x -= turn;
+    if (x < -CM_PI) x += turn;
+    double term = x, sum = x;
+    for (int n = 1; n < 24; n++) {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+static constexpr double cm_cos(double x) { return cm_sin(x + CM_PI / 2.0); }
+
+static constexpr double cm_sqrt(double x) {
+    if (x <= 0.0) return 0.0;
+    double r = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 64; i++) r = 0.5 * (r + x / r);
+    return r;
+}
+
+// atan(x) for |x| <= 1: halve the angle twice, then the series
+static constexpr double cm_atanUnit(double x) {
+    for (int i = 0; i < 2; i++) x = x / (1.0 + cm_sqrt(1.0 + x * x));
+    double term = x, sum = x;
+    for (int n = 1; n < 40; n++) {
+        term *= -x * x;
+        sum += term / (2.0 * n + 1.0);
+    }
+    return 4.0 * sum;
+}
+
+static constexpr double cm_atan2(double y, double x) {
+    if (x == 0.0 && y == 0.0) return 0.0;
+    const double ay = y < 0.0 ? -y : y, ax = x < 0.0 ? -x : x;
+    double a = ay <= ax ? cm_atanUnit(ay / ax) : CM_PI / 2.0 - cm_atanUnit(ax / ay);
+    if (x < 0.0) a = CM_PI - a;
+    return y < 0.0 ? -a : a;
+}
+
+// e^x: split off the integer part, series for the rest
+static constexpr double cm_exp(double x) {
+    int k = (int)x;
+    double f = x - k;
+    double term = 1.0, sum = 1.0;
+    for (int n = 1; n < 30; n++) {
+        term *= f / n;
+        sum += term;
+    }
+    const double e = 2.71828182845904523536;
+    for (; k > 0; k--) sum *= e;
+    for (; k < 0; k++) sum /= e;
+    return sum;
+}
+
+// ln(x), x > 0: scale to [0.5, 1], then the atanh series
+static constexpr double cm_log(double x) {
+    int k = 0;
+    while (x > 1.0) { x *= 0.5; k++; }
+    while (x < 0.5) { x *= 2.0; k--; }
+    const double z = (x - 1.0) / (x + 1.0);
+    double term = z, sum = z;
+    for (int n = 1; n < 60; n++) {
+        term *= z * z;
+        sum += term / (2.0 * n + 1.0);
+    }
+    return 2.0 * sum + k * 0.69314718055994530942;
+}
+
+static constexpr double cm_pow(double x, double y) {
+    return x <= 0.0 ? 0.0 : cm_exp(y * cm_log(x));
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// -----------------------------------------------------------
+// DSP Chain - compile-time list of processing stages
+// Each stage is a policy with
+//     template <typename Ctx, typename T>
+//     static void run(Ctx& ctx, T* buf, size_t frames);
+// working on an interleaved stereo block in place. DSPChain runs
+// them in order; a stage that is not part of a mode is simply left
+// out of the list, so its code and its flag test disappear.
+// -----------------------------------------------------------
+
+#include <stddef.h>
+
+// Stage that does nothing (placeholder in conditional stage lists)
+struct DSPStageNone {
+    template <typename Ctx, typename T>
+    static inline void run(Ctx&, T*, size_t) {}
+};
+
+template <typename... Stages>
+struct DSPChain {
+    template <typename Ctx, typename T>
+    static void run(Ctx& ctx, T* buf, size_t frames) {
+        (Stages::run(ctx, buf, frames), ...);
+    }
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+// -----------------------------------------------------------
+// DSP Graph - the float chain's stage order as data (APP_DSP_GRAPH)
+// - A node list, run first to last on the block the input pass
+//   prepared (volume, analysis, mono downmix)
+// - DSPProcessor compiles it on the writer's side into one kernel
+//   call per node, picked for the parameter block's mode, and
+//   publishes that with the block: the audio task makes one indirect
+//   call per node and never looks at the list
+// - Rules: every node at most once and built in; the chain ends on
+//   the output stage, the limiter where there is one (the clamps sit
+//   behind it), else the ear routing, which clamps
+// - The built-in order (DEFAULT) runs the fused chains instead
+// - Blob, also the BLE payload: [count, node...]
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "../config/app_config.h"
+
+struct DspGraph {
+    enum Node : uint8_t {
+        NODE_TONE = 0,      // Tone EQ and loudness compensation
+        NODE_PEQ,           // Parametric EQ (APP_DSP_PEQ)
+        NODE_FIR,           // Room correction (APP_DSP_FIR)
+        NODE_DYNAMICS,      // Multiband dynamics (APP_DSP_DYNAMICS)
+        NODE_3D,            // The 3D mode set3DMode picked, while on
+        NODE_EAR,           // Split-ear crossover or full range, bass boost, flip
+        NODE_LIMITER,       // Output limiter (APP_DSP_LIMITER)
+        NODE_COUNT
+    };
+    static constexpr uint8_t MAX_NODES = NODE_COUNT;
+    static constexpr size_t BLOB_BYTES = 1 + MAX_NODES;
+
+    uint8_t count = 0;
+    uint8_t nodes[MAX_NODES] = {};
+
+    // The order DSPChain runs, less what the build leaves out
+    static DspGraph builtIn() {
+        DspGraph g;
+        for (uint8_t n = 0; n < NODE_COUNT; n++) {
+            if (available(n)) g.nodes[g.count++] = n;
+        }
+        return g;
+    }
+
+    static constexpr bool available(uint8_t node) {
+        return node == NODE_PEQ      ? APP_DSP_PEQ != 0
+             : node == NODE_FIR      ? APP_DSP_FIR != 0
+             : node == NODE_DYNAMICS ? APP_DSP_DYNAMICS != 0
+             : node == NODE_LIMITER  ? APP_DSP_LIMITER != 0
+             : node < NODE_COUNT;
+    }
+
+    bool valid() const {
+        if (count == 0 || count > MAX_NODES) return false;
+        uint8_t seen = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            const uint8_t n = nodes[i];
+            if (!available(n) || (seen & (1u << n))) return false;
+            seen |= (uint8_t)(1u << n);
+        }
+        return nodes[count - 1] == (APP_DSP_LIMITER ? NODE_LIMITER : NODE_EAR) &&
+               (seen & (1u << NODE_EAR));
+    }
+
+    bool isBuiltIn() const {
+        const DspGraph d = builtIn();
+        return count == d.count && memcmp(nodes, d.nodes, count) == 0;
+    }
+
+    size_t serialize(uint8_t* out, size_t cap) const {
+        if (cap < 1u + count) return 0;
+        out[0] = count;
+        memcpy(out + 1, nodes, count);
+        return 1u + count;
+    }
+
+    // False (out untouched) unless the blob is a valid graph
+    static bool parse(const uint8_t* in, size_t len, DspGraph& out) {
+        if (len < 1 || in[0] > MAX_NODES || len < 1u + in[0]) return false;
+        DspGraph g;
+        g.count = in[0];
+        memcpy(g.nodes, in + 1, g.count);
+        if (!g.valid()) return false;
+        out = g;
+        return true;
+    }
+
+    static const char* nodeName(uint8_t node) {
+        static const char* const NAMES[NODE_COUNT] = {"tone", "peq", "fir", "dynamics", "3d", "ear", "limiter"};
+        return node < NODE_COUNT ? NAMES[node] : "?";
+    }
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+// -----------------------------------------------------------
+// DSP preset bank - APP_DSP_PRESETS slots picked by SET_EQ_PRESET
+// - A preset covers the tone EQ, the control byte (bass boost, flip,
+//   bypass = crossover off), 3D sound and the limiter threshold;
+//   `fields` says which of them it sets. The factory presets (the
+//   app's EQ curves) set only the EQ, so the user's modes stay.
+// - Everything is resolved when a preset is stored: EQ steps are on
+//   the EqCoeffCache grid and the limiter threshold is kept linear,
+//   so DSPProcessor::applyPreset() does lookups and stores only
+// Preset wire format (BLE and NVS), 6 bytes:
+//   [fields, bass, mid, treble, modes, limiter (0.1 dB below FS)]
+//   modes: bits 0-2 as the control byte, bit 3 = 3D sound
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "eq_coeff_cache.h"
+#include "../config/app_config.h"
+
+struct DspPreset {
+    enum : uint8_t {
+        EQ       = 0x01,
+        CONTROL  = 0x02,
+        SOUND_3D = 0x04,
+        LIMITER  = 0x08,
+        ALL      = 0x0F,
+    };
+    uint8_t fields = EQ;
+    int8_t eq[3] = {0, 0, 0};           // Bass, mid, treble (phone dB)
+    uint8_t control = 0;                // Control byte bits
+    bool sound3D = false;
+    uint8_t limiterTenthDB = 3;         // Threshold below full scale
+    float limiterThreshold = 0.966f;    // Linear, from limiterTenthDB
+};
+
+class DspPresetBank {
+public:
+    static constexpr int COUNT = APP_DSP_PRESETS;
+    static constexpr int FACTORY = 12;
+    static constexpr size_t PRESET_BYTES = 6;
+    static constexpr size_t BLOB_BYTES = 1 + COUNT * PRESET_BYTES;
+    static constexpr uint8_t MAX_LIMITER_TENTH_DB = 120;   // -12 dB
+    static_assert(COUNT >= FACTORY, "preset bank smaller than the factory set");
+
+    DspPresetBank() { restoreFactory(); }
+
+    void restoreFactory() {
+        // EQ curves as in BleUnifiedProtocol.kt; the rest start flat
+        static const int8_t CURVES[FACTORY][3] = {
+            {0, 0, 0},      // Flat
+            {6, 2, 0},      // Bass Boost
+            {0, 2, 6},      // Treble Boost
+            {-2, 4, 2},     // Vocal
+            {4, 0, 4},      // Rock
+            {2, 3, 4},      // Pop
+            {3, 0, 2},      // Jazz
+            {0, 2, 3},      // Classical
+            {5, 2, 4},      // Electronic
+            {6, 0, 2},      // Hip Hop
+            {2, 3, 3},      // Acoustic
+            {4, 2, 4}       // Loudness
+        };
+        for (int i = 0; i < COUNT; i++) {
+            m_presets[i] = DspPreset();
+            if (i < FACTORY) memcpy(m_presets[i].eq, CURVES[i], 3);
+        }
+    }
+
+    // nullptr for a bad index
+    const DspPreset* get(int index) const {
+        return (index >= 0 && index < COUNT) ? &m_presets[index] : nullptr;
+    }
+
+    // Control task. Out-of-range values are clamped; false for a bad index.
+    bool set(int index, const DspPreset& preset) {
+        if (index < 0 || index >= COUNT) return false;
+        DspPreset p = preset;
+        p.fields &= DspPreset::ALL;
+        for (int b = 0; b < 3; b++) {
+            if (p.eq[b] < EqCoeffCache::MIN_DB) p.eq[b] = EqCoeffCache::MIN_DB;
+            if (p.eq[b] > EqCoeffCache::MAX_DB) p.eq[b] = EqCoeffCache::MAX_DB;
+        }
+        p.control &= 0x07;
+        if (p.limiterTenthDB > MAX_LIMITER_TENTH_DB) p.limiterTenthDB = MAX_LIMITER_TENTH_DB;
+        p.limiterThreshold = powf(10.0f, -(float)p.limiterTenthDB / 200.0f);
+        m_presets[index] = p;
+        return true;
+    }
+
+    static bool decode(const uint8_t* in, size_t len, DspPreset& out) {
+        if (len < PRESET_BYTES) return false;
+        out.fields = in[0];
+        out.eq[0] = (int8_t)in[1];
+        out.eq[1] = (int8_t)in[2];
+        out.eq[2] = (int8_t)in[3];
+        out.control = in[4] & 0x07;
+        out.sound3D = (in[4] & 0x08) != 0;
+        out.limiterTenthDB = in[5];
+        return true;
+    }
+
+    static size_t encode(const DspPreset& p, uint8_t* out) {
+        out[0] = p.fields;
+        out[1] = (uint8_t)p.eq[0];
+        out[2] = (uint8_t)p.eq[1];
+        out[3] = (uint8_t)p.eq[2];
+        out[4] = (uint8_t)(p.control | (p.sound3D ? 0x08 : 0));
+        out[5] = p.limiterTenthDB;
+        return PRESET_BYTES;
+    }
+
+    // [count, preset 6 bytes...]
+    size_t serialize(uint8_t* out, size_t cap) const {
+        if (cap < BLOB_BYTES) return 0;
+        out[0] = (uint8_t)COUNT;
+        size_t idx = 1;
+        for (int i = 0; i < COUNT; i++) idx += encode(m_presets[i], out + idx);
+        return idx;
+    }
+
+    // Slots missing from a shorter blob keep their factory values
+    bool deserialize(const uint8_t* in, size_t len) {
+        if (len < 1 || len < 1 + (size_t)in[0] * PRESET_BYTES) return false;
+        const int n = in[0] < COUNT ? in[0] : COUNT;
+        for (int i = 0; i < n; i++) {
+            DspPreset p;
+            decode(in + 1 + i * PRESET_BYTES, PRESET_BYTES, p);
+            set(i, p);
+        }
+        return true;
+    }
+
+private:
+    DspPreset m_presets[COUNT];
+};
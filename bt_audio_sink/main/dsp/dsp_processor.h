@@ -5,14 +5,82 @@
 // - 3-band EQ (bass/mid/treble shelving)
 // - Crossover split-ear mode
 // - Bass boost
-// - Goertzel frequency analysis
+// - Parametric EQ (APP_DSP_PEQ) after the tone EQ
+// - FIR room correction (APP_DSP_FIR) after the parametric EQ
+// - Multiband dynamics (APP_DSP_DYNAMICS) after the FIR
+// - 3D: the stage presence processor, or with APP_DSP_BINAURAL the
+//   binaural headphone virtualizer (set3DMode)
+// - Silence gate (APP_DSP_SILENCE_GATE): idles the chain on silence
+// - Settings (tone EQ and loudness designs, mode flags, volume,
+//   limiter threshold) form one immutable parameter block: setters
+//   build the next one under a spinlock and publish it with a single
+//   atomic swap, and the audio task adopts it at the next block
+//   boundary. A preset (applyPreset) switches everything at once, no
+//   coefficient is rewritten under a running block, and the block loop
+//   reads plain members only.
+// - Float blocks run through a DSPChain picked per block from the
+//   mode flags, so stages a mode does not use are compiled out; a
+//   custom stage order (APP_DSP_GRAPH, setGraph) is compiled into the
+//   parameter block as one kernel per node instead. The Q31 path keeps
+//   the built-in order, so the pipeline sends every format through the
+//   float path while one is set (hasCustomGraph)
+// - Feeds the mono analysis signal to AudioAnalyzer
+//   (decimated to ~3 kHz with APP_DSP_ANALYSIS_DECIMATE)
+// - Single-driver products (APP_MONO_SPEAKER): the input pass
+//   downmixes, the chain filters the left slots only (full range, no
+//   3D, split-ear or flip) and its last stage copies them to the
+//   right; the Q31 path downmixes too but keeps its stereo kernels
+// - Passthrough (APP_DSP_PASSTHROUGH): while every stage is at unity
+//   the pipeline skips the chain and keeps the PCM as it came, widened
+//   to Q31; only the silence gate and analysis look at it
+// - Designs that depend only on the sample rate are built once per
+//   rate into a bundle (rate_cache.h); a codec switch to a rate seen
+//   before copies coefficients and clears state
 // -----------------------------------------------------------
 
 #include <stdint.h>
+#include <string.h>
 #include <math.h>
+#include <array>
+#include <atomic>
+#include <type_traits>
+#include <utility>
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
 #include "biquad.h"
-#include "goertzel.h"
+#include "biquad_cascade.h"
+#include "eq_coeff_cache.h"
+#include "loudness_table.h"
+#include "rate_cache.h"
+#include "dsp_preset.h"
+#if APP_DSP_Q31_PATH
+#include "biquad_q31.h"
+#endif
+#include "audio_analyzer.h"
+#include "analysis_decimator.h"
+#include "band_split.h"
 #include "fast_math.h"
+#include "pie_kernels.h"
+#include "dsp_chain.h"
+#if APP_DSP_LIMITER
+#include "lookahead_limiter.h"
+#endif
+#if APP_DSP_PEQ
+#include "parametric_eq.h"
+#endif
+#if APP_DSP_FIR
+#include "fir_convolver.h"
+#endif
+#if APP_DSP_DYNAMICS
+#include "multiband_dynamics.h"
+#endif
+#if APP_DSP_BINAURAL
+#include "binaural_virtualizer.h"
+#endif
+#if APP_DSP_GRAPH
+#include "dsp_graph.h"
+#endif
 #include "../config/app_config.h"
 
 class DSPProcessor {
@@ -23,6 +91,7 @@ public:
     void init(uint32_t sampleRate);
     void setSampleRate(uint32_t sampleRate);
     void updateSampleRate(uint32_t sampleRate) { setSampleRate(sampleRate); }
+    uint32_t getSampleRate() const { return m_sampleRate; }
     void resetAllFilters();
 
     // EQ settings
@@ -36,23 +105,75 @@ public:
     float getTrebleDB() const { return m_eqTrebleDB; }
 
     // Control flags
-    void setBassBoost(bool enable) { m_bassBoostEnabled = enable; }
-    void setChannelFlip(bool enable) { m_channelFlipEnabled = enable; }
-    void setBypass(bool enable) { m_bypassEnabled = enable; }
-    void setAnalysisEnabled(bool enable) { m_analysisEnabled = enable; }
-    void set3DSound(bool enable) { m_3dSoundEnabled = enable; }
-
-    bool isBassBoostEnabled() const { return m_bassBoostEnabled; }
-    bool isChannelFlipEnabled() const { return m_channelFlipEnabled; }
-    bool isBypassEnabled() const { return m_bypassEnabled; }
-    bool isAnalysisEnabled() const { return m_analysisEnabled; }
-    bool is3DSoundEnabled() const { return m_3dSoundEnabled; }
+    void setBassBoost(bool enable) { setMode(MODE_BASS_BOOST, enable); }
+    void setChannelFlip(bool enable) { setMode(MODE_FLIP, enable); }
+    void setBypass(bool enable) { setMode(MODE_BYPASS, enable); }
+    void setAnalysisEnabled(bool enable) { setMode(MODE_ANALYSIS, enable); }
+    void set3DSound(bool enable) { setMode(MODE_3D, enable); }
+
+    bool isBassBoostEnabled() const { return (m_mode.load() & MODE_BASS_BOOST) != 0; }
+    bool isChannelFlipEnabled() const { return (m_mode.load() & MODE_FLIP) != 0; }
+    bool isBypassEnabled() const { return (m_mode.load() & MODE_BYPASS) != 0; }
+    bool isAnalysisEnabled() const { return (m_mode.load() & MODE_ANALYSIS) != 0; }
+    bool is3DSoundEnabled() const { return (m_mode.load() & MODE_3D) != 0; }
+
+    // What 3D runs: set3DSound turns it on and off and keeps the kind
+    enum Sound3DMode : uint8_t {
+        SOUND_3D_OFF = 0,
+        SOUND_3D_STAGE,         // Stage presence (speakers or headphones)
+        SOUND_3D_BINAURAL,      // Virtual front speakers (headphones)
+    };
+    // False for an unknown mode, binaural without APP_DSP_BINAURAL, or
+    // any 3D on a mono product
+    bool set3DMode(uint8_t mode) {
+        if (mode > SOUND_3D_BINAURAL || (mode == SOUND_3D_BINAURAL && !APP_DSP_BINAURAL)) return false;
+        if (APP_MONO_SPEAKER && mode != SOUND_3D_OFF) return false;
+        replaceMode(MODE_3D | MODE_BINAURAL, (mode != SOUND_3D_OFF ? MODE_3D : 0) |
+                                             (mode == SOUND_3D_BINAURAL ? MODE_BINAURAL : 0));
+        return true;
+    }
+    uint8_t get3DMode() const {
+        const uint8_t m = m_mode.load();
+        if (!(m & MODE_3D)) return SOUND_3D_OFF;
+        return (m & MODE_BINAURAL) ? SOUND_3D_BINAURAL : SOUND_3D_STAGE;
+    }
+
+    // Stages shed under CPU pressure (DeadlineMonitor), on top of the
+    // flags above, which keep reporting what was set. Any task, taken at
+    // the next block.
+    enum ShedStage : uint8_t {
+        SHED_3D        = 0x01,
+        SHED_ANALYSIS  = 0x02,
+        SHED_TRUE_PEAK = 0x04,  // Limiter on sample peaks only
+    };
+    void setShed(uint8_t stages);
+    uint8_t getShed() const { return m_shed.load(); }
+    // Mode the next block runs: control byte bits, 0x08 3D, 0x10 analysis,
+    // 0x20 binaural (with 0x08)
+    uint8_t activeMode() const { return withShed(m_mode.load(std::memory_order_relaxed)); }
+
+    // The fields a preset sets, together: EQ steps from the coefficient
+    // tables (crossfaded by the tone chain), modes in one store, the
+    // limiter threshold precomputed. Control task.
+    void applyPreset(const DspPreset& preset);
+
+    // True while the silence gate holds the chain idle: the last block
+    // was zeroed without processing and need not be sent to I2S
+    bool isIdle() const { return m_idle; }
 
     // Volume-based bass compensation (0-127 A2DP range)
-    // As volume decreases, bass boost increases (max +3dB at 0% volume)
+    // As volume decreases, bass boost increases (max +5dB at 0% volume),
+    // looked up in the table built for the sample rate
+    // With APP_DSP_VOLUME the same value also sets the block gain target
     void setVolume(uint8_t volume) {
+        portENTER_CRITICAL(&m_paramLock);
         m_volume = volume;
         updateBassCompensation();
+#if APP_DSP_VOLUME
+        m_staged.volumeTarget = volumeToGain(volume);
+#endif
+        publishParams();
+        portEXIT_CRITICAL(&m_paramLock);
     }
     uint8_t getVolume() const { return m_volume; }
     float getBassCompensationDB() const { return m_bassCompensationDB; }
@@ -77,30 +198,177 @@ public:
     // Process a single stereo sample (in-place)
     void processStereo(float &L, float &R);
 
-    // Get Goertzel levels (legacy - keeping for beat detection)
-    float getDB(int band) const { return m_goertzel.getDB(band); }
-    float getLin(int band) const { return m_goertzel.getLin(band); }
-    void zeroLevels() { m_goertzel.zeroLevels(); m_peakMeter.zero(); }
-    
-    // Named accessors for Goertzel bands (used for beat detection)
-    float getGoertzel30dB() const { return m_goertzel.getDB(0); }
-    float getGoertzel60dB() const { return m_goertzel.getDB(1); }
-    float getGoertzel100dB() const { return m_goertzel.getDB(2); }
-    float getGoertzel30Lin() const { return m_goertzel.getLin(0); }
-    float getGoertzel60Lin() const { return m_goertzel.getLin(1); }
-    float getGoertzel100Lin() const { return m_goertzel.getLin(2); }
-
-    // Fast peak meter levels (for BLE level display) - much more responsive
-    float getPeakDB(int band) const { return m_peakMeter.getDB(band); }
-    float getPeakLin(int band) const { return m_peakMeter.getLin(band); }
+    // Process a block of interleaved stereo frames (in may equal out).
+    // Each stage runs over the whole block and the control flags are
+    // sampled once per block. processStereo is a one-frame wrapper.
+    void processBlock(const float* in, float* out, size_t frames);
+
+#if APP_DSP_Q31_PATH
+    // Fixed-point variant for 24/32-bit sources: interleaved stereo Q31 in
+    // place. Same chain; 3D, dynamics and analysis touch the FPU.
+    void processBlockQ31(int32_t* buf, size_t frames);
+#endif
+
+#if APP_DSP_PASSTHROUGH
+    // Audio task, at a block start: adopt the pending parameters and tell
+    // whether the chain would leave the block as it is (tone and
+    // parametric EQ flat, no FIR or dynamics, full range without boost or
+    // 3D, volume settled at unity). Such a block takes processPassthrough()
+    // on its Q31 form instead of processBlock*(), limiter included; the
+    // first block after it runs from clean state.
+    bool passthrough();
+    // Silence gate and analysis on a Q31 block that stays as it is
+    void processPassthrough(int32_t* buf, size_t frames);
+#endif
+
+    // Goertzel bands, peak meter levels and beats: read a snapshot with
+    // analyzer().read(); the analysis task calls analyzer().run()
+    AudioAnalyzer& analyzer() { return m_analyzer; }
+    const AudioAnalyzer& analyzer() const { return m_analyzer; }
+    // Analyze at ~3 kHz instead of the stream rate (always on with
+    // APP_DSP_ANALYSIS_DECIMATE). Call with the stream paused.
+    void setAnalysisDecimated(bool on);
+
+#if APP_DSP_PEQ
+    // Parametric EQ bands and load (bands may be set from any task)
+    ParametricEq& peq() { return m_peq; }
+    const ParametricEq& peq() const { return m_peq; }
+#endif
+
+#if APP_DSP_FIR
+    // Room correction IR (load from any task but the audio task)
+    FirConvolver& fir() { return m_fir; }
+    const FirConvolver& fir() const { return m_fir; }
+#endif
+
+#if APP_DSP_DYNAMICS
+    // Multiband dynamics preset (MultibandDynamics::Preset), any task;
+    // false for an unknown one
+    bool setDynamicsPreset(uint8_t id) { return m_dynamics.setPreset(id); }
+    uint8_t getDynamicsPreset() const { return m_dynamics.getPreset(); }
+#endif
+
+#if APP_DSP_LIMITER
+    // Output limiter gain reduction (any task). The float and Q31 paths
+    // each have one; stats come from whichever ran last.
+    void limiterStats(LimiterStats& out) const;
+    float limiterGain() const;
+    void resetLimiterStats();
+    // Frames the limiter delays the output by
+    uint32_t limiterDelay() const { return m_limiter.delay(); }
+    // Lookahead (0 = APP_DSP_LIMITER_LOOKAHEAD_US). Re-initializes the
+    // limiters: call with the stream paused, as for a rate change.
+    void setLimiterLookaheadUs(uint32_t us);
+#endif
+
+#if APP_DSP_GRAPH
+    // Stage order of the float chain (any task but the audio task); false
+    // for an invalid graph. Taken at the next block.
+    bool setGraph(const DspGraph& graph);
+    DspGraph getGraph();
+    // True while the order is not the built-in one (audio task: pick the
+    // float path for every format)
+    bool hasCustomGraph() const { return m_graphCustom.load(std::memory_order_relaxed); }
+#endif
 
     // Get control byte for BLE
     uint8_t getControlByte() const;
     void applyControlByte(uint8_t v);
 
 private:
+    // m_mode bits; the low three are the control byte
+    enum : uint8_t {
+        MODE_BASS_BOOST = 0x01,
+        MODE_FLIP       = 0x02,
+        MODE_BYPASS     = 0x04,
+        MODE_3D         = 0x08,
+        MODE_ANALYSIS   = 0x10,
+        MODE_BINAURAL   = 0x20,     // 3D is the binaural virtualizer
+        MODE_CONTROL    = MODE_BASS_BOOST | MODE_FLIP | MODE_BYPASS,
+    };
+    void setMode(uint8_t bits, bool on) {
+        replaceMode(bits, on ? bits : 0);
+    }
+    // Replace the bits in mask with those of value
+    void replaceMode(uint8_t mask, uint8_t value) {
+        portENTER_CRITICAL(&m_paramLock);
+        m_staged.mode = (uint8_t)((m_staged.mode & ~mask) | (value & mask));
+        publishParams();
+        portEXIT_CRITICAL(&m_paramLock);
+    }
+    // mode less the shed stages
+    uint8_t withShed(uint8_t mode) const {
+        const uint8_t shed = m_shed.load(std::memory_order_relaxed);
+        const uint8_t off = ((shed & SHED_3D) ? MODE_3D : 0) | ((shed & SHED_ANALYSIS) ? MODE_ANALYSIS : 0);
+        return mode & (uint8_t)~off;
+    }
+
+    using ChainFn = void (*)(DSPProcessor&, float*, size_t);
+
+#if APP_DSP_GRAPH
+    // A custom graph compiled for one parameter block's mode; count 0
+    // runs the built-in chains
+    struct DspSchedule {
+        ChainFn run[DspGraph::MAX_NODES + 1];       // + the mono output stage
+        uint8_t count = 0;
+    };
+#endif
+
+    // Everything the setters change, as the audio task applies it at a
+    // block boundary. Never written once published.
+    struct DspParams {
+        Biquad eq[EqCoeffCache::NUM_BANDS];     // Tone EQ designs
+        Biquad bassComp;                        // Volume bass compensation
+        uint8_t sections = 0;                   // Active tone sections, bit per TONE_*
+        uint8_t mode = MODE_ANALYSIS;           // MODE_* bits
+#if APP_DSP_VOLUME
+        float volumeTarget = 1.0f;
+#endif
+#if APP_DSP_LIMITER
+        float limiterThreshold = LookaheadLimiter<float>::THRESHOLD;
+#endif
+#if APP_DSP_GRAPH
+        DspSchedule schedule;
+#endif
+    };
+    // Writers (m_paramLock held): m_staged into the back slot, which
+    // becomes the pending one in one atomic exchange
+    void publishParams();
+    // Audio task, at a block boundary: take the pending block if a newer
+    // one was published
+    void adoptParams();
+#if APP_DSP_GRAPH
+    // m_graph's kernels for p's mode into p.schedule
+    void compileSchedule(DspParams& p) const;
+    void runSchedule(float* buf, size_t frames);
+#endif
+
     void updateFilters();
-    void updateLPAlpha();
+    void updateEqFilters();
+    void stageEQ(float bassDB, float midDB, float trebleDB);
+    void restageParams();
+    void initAnalysis();
+    void initLimiter();
+    // Silence gate: true when the block is to be output as zeros unprocessed
+    template <typename T>
+    bool silenceGate(const T* in, size_t frames, T threshold);
+    // Queue one sample for the analyzer (through the decimator if enabled)
+    void analyzeSample(float mono);
+    // Same from fixed point: L/R with fracBits fractional bits
+    void analyzeStereoQ(int32_t L, int32_t R, int fracBits);
+#if APP_DSP_VOLUME
+    static float volumeToGain(uint8_t volume);
+    void updateVolumeCoef();
+    // Ramp toward the volume target fused with analysis and the copy into
+    // out (Mono: the downmix into both slots). Returns false (nothing
+    // done) when the gain is settled at unity.
+    template <bool Mono>
+    bool applyVolume(const float* in, float* out, size_t frames, bool analysis);
+#if APP_DSP_Q31_PATH
+    // Same for the Q31 path; also does the shift into the internal format
+    bool applyVolumeQ31(int32_t* buf, size_t frames, bool analysis);
+#endif
+#endif
 
     // -----------------------------------------------------------
     // Soft Clipper (replaces compressor for better sound quality)
@@ -149,9 +417,15 @@ private:
     // - Mids/Vocals/Instruments spread WIDE like a real stage
     // - Early reflections simulate room acoustics
     // - Creates depth - sounds like performers are IN FRONT of you
+    // Block based: one pass writes the widened signal into the delay
+    // line, then each tap is added as a contiguous span. Taps are
+    // fractional (linear interpolation) so their times in ms are the
+    // same at every rate; the line is sized for MAX_SAMPLE_RATE and
+    // lives in PSRAM when there is some.
     // ============================================================
     struct Immersive3DProcessor {
-        static constexpr int MAX_DELAY = 256;  // Power of 2 for fast wrap
+        static constexpr uint32_t MAX_SAMPLE_RATE = 96000;
+        static constexpr size_t MAX_BLOCK = 256;  // Frames per internal pass
         
         // === STAGE EFFECT PARAMETERS ===
         static constexpr float BASS_CROSSOVER = 180.0f;   // Hz - keep bass below this centered
@@ -169,28 +443,45 @@ private:
         // Depth enhancement
         static constexpr float DEPTH_DELAY_MS = 4.0f;     // Creates front-stage depth
         static constexpr float DEPTH_GAIN = 0.35f;
+
+        // Delay line: longest tap + interpolation sample + one block
+        static constexpr size_t LINE_SIZE = 4096;
+        static_assert(REFLECT3_MS * 0.001f * MAX_SAMPLE_RATE + 2 + MAX_BLOCK <= LINE_SIZE,
+                      "3D delay line too short for MAX_SAMPLE_RATE");
+
+        // One fractional tap: read (n - whole) and (n - whole - 1)
+        struct Tap {
+            uint32_t whole = 1;
+            float frac = 0.0f;
+            void set(float ms, float sampleRate) {
+                float d = ms * 0.001f * sampleRate;
+                if (d < 1.0f) d = 1.0f;
+                if (d > (float)(LINE_SIZE - MAX_BLOCK - 2)) d = (float)(LINE_SIZE - MAX_BLOCK - 2);
+                whole = (uint32_t)d;
+                frac = d - (float)whole;
+            }
+        };
         
-        // Delay buffers for reflections
-        float delayL[MAX_DELAY];
-        float delayR[MAX_DELAY];
-        int writeIdx = 0;
-        int reflect1Samples = 0;
-        int reflect2Samples = 0;
-        int reflect3Samples = 0;
-        int depthSamples = 0;
-        
-        // Bass extraction filter (LP for bass, HP for mids/highs)
-        float bassLpCoef = 0;
-        float bassStateL = 0, bassStateR = 0;
+        // Delay lines for reflections (planar, LINE_SIZE each)
+        float* delayL = nullptr;
+        float* delayR = nullptr;
+        uint32_t writeIdx = 0;
+        Tap reflect1, reflect2, reflect3, depth;
+
+        // Float scratch for the Q31 path
+        float scratch[2 * MAX_BLOCK];
         
-        // Mid/high presence filter (emphasize 2-6kHz for clarity)
-        float presenceHpCoef = 0;
-        float presenceStateL = 0, presenceStateR = 0;
+        // Bass below BASS_CROSSOVER (centered); mids/highs are the rest
+        BandSplit<1, MAX_BLOCK> bands;
         
         // All-pass for externalization (phase decorrelation)
         float apCoef1 = 0.6f, apCoef2 = -0.4f;
         float apState1L = 0, apState1R = 0;
         float apState2L = 0, apState2R = 0;
+
+        ~Immersive3DProcessor() {
+            if (delayL) heap_caps_free(delayL);
+        }
         
         // Soft saturation for warmth
         inline float softClip(float x) {
@@ -198,283 +489,189 @@ private:
             if (x < -1.0f) return -1.0f;
             return x * (1.5f - 0.5f * x * x);
         }
-        
-        void init(float sampleRate) {
-            // Clear delay buffers
-            for (int i = 0; i < MAX_DELAY; i++) {
-                delayL[i] = 0.0f;
-                delayR[i] = 0.0f;
+
+        // Once; both lines in one allocation, PSRAM first
+        bool allocate() {
+            if (delayL) return true;
+            const size_t bytes = 2 * LINE_SIZE * sizeof(float);
+            float* p = nullptr;
+            if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0) {
+                p = (float*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
             }
-            writeIdx = 0;
-            bassStateL = bassStateR = 0;
-            presenceStateL = presenceStateR = 0;
-            apState1L = apState1R = 0;
-            apState2L = apState2R = 0;
-            
-            // Calculate reflection delay samples
-            reflect1Samples = (int)(sampleRate * REFLECT1_MS * 0.001f);
-            reflect2Samples = (int)(sampleRate * REFLECT2_MS * 0.001f);
-            reflect3Samples = (int)(sampleRate * REFLECT3_MS * 0.001f);
-            depthSamples = (int)(sampleRate * DEPTH_DELAY_MS * 0.001f);
-            
-            // Clamp to buffer size
-            if (reflect1Samples >= MAX_DELAY) reflect1Samples = MAX_DELAY - 1;
-            if (reflect2Samples >= MAX_DELAY) reflect2Samples = MAX_DELAY - 1;
-            if (reflect3Samples >= MAX_DELAY) reflect3Samples = MAX_DELAY - 1;
-            if (depthSamples >= MAX_DELAY) depthSamples = MAX_DELAY - 1;
-            
-            // Bass LP filter coefficient (~180Hz crossover)
-            float wc = 2.0f * DSP_PI_F * BASS_CROSSOVER;
-            bassLpCoef = wc * fast_recipsf2(wc + sampleRate);
-            
-            // Presence HP filter (~300Hz to separate from bass)
-            float wcHp = 2.0f * DSP_PI_F * 300.0f;
-            presenceHpCoef = sampleRate * fast_recipsf2(wcHp + sampleRate);
+            if (!p) p = (float*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (!p) {
+                ESP_LOGE("DSP", "3D delay line (%u KB) allocation failed, 3D bypassed",
+                         (unsigned)(bytes / 1024));
+                return false;
+            }
+            delayR = p + LINE_SIZE;
+            delayL = p;  // Last: processBlock keys off delayL
+            return true;
         }
         
-        inline void process(float &L, float &R) {
-            // ========== 1. BASS/MID SEPARATION ==========
-            // Extract bass (keep centered) and mids/highs (widen)
-            bassStateL += bassLpCoef * (L - bassStateL);
-            bassStateR += bassLpCoef * (R - bassStateR);
-            
-            float bassL = bassStateL;
-            float bassR = bassStateR;
-            float bassMono = (bassL + bassR) * 0.5f;  // Center the bass!
-            
-            // Mids/highs = original minus bass
-            float midHighL = L - bassL;
-            float midHighR = R - bassR;
-            
-            // ========== 2. DRAMATIC MID/HIGH WIDENING ==========
-            // M-S processing on mids/highs only (not bass!)
-            float mid = (midHighL + midHighR) * 0.5f;
-            float side = (midHighL - midHighR) * 0.5f;
-            
-            // Progressive widening - highs wider than mids
-            // Simple approach: boost side channel significantly
-            side *= MID_WIDTH;
-            
-            // Reconstruct widened mids/highs
-            float wideL = mid + side;
-            float wideR = mid - side;
-            
-            // ========== 3. STORE IN DELAY BUFFER ==========
-            delayL[writeIdx] = wideL;
-            delayR[writeIdx] = wideR;
-            
-            // ========== 4. EARLY REFLECTIONS (Stage Acoustics) ==========
-            // Multiple short delays create sense of space/room
-            int idx1 = (writeIdx - reflect1Samples) & (MAX_DELAY - 1);
-            int idx2 = (writeIdx - reflect2Samples) & (MAX_DELAY - 1);
-            int idx3 = (writeIdx - reflect3Samples) & (MAX_DELAY - 1);
-            int depthIdx = (writeIdx - depthSamples) & (MAX_DELAY - 1);
-            
-            // Cross-channel reflections (sound bouncing around stage)
-            float ref1L = delayR[idx1] * REFLECT_GAIN1;  // From opposite side
-            float ref1R = delayL[idx1] * REFLECT_GAIN1;
-            float ref2L = delayL[idx2] * REFLECT_GAIN2;  // Same side bounce
-            float ref2R = delayR[idx2] * REFLECT_GAIN2;
-            float ref3L = delayR[idx3] * REFLECT_GAIN3;  // Cross again
-            float ref3R = delayL[idx3] * REFLECT_GAIN3;
-            
-            // Depth delay (creates front-stage positioning)
-            float depthL = delayL[depthIdx] * DEPTH_GAIN;
-            float depthR = delayR[depthIdx] * DEPTH_GAIN;
-            
-            // ========== 5. EXTERNALIZATION (Out-of-Head) ==========
-            // Cascaded all-pass filters for phase decorrelation
-            // This makes sound feel like it's OUTSIDE your head
-            float ap1OutL = apCoef1 * wideL + apState1L;
-            apState1L = wideL - apCoef1 * ap1OutL;
-            float ap1OutR = apCoef1 * wideR + apState1R;
-            apState1R = wideR - apCoef1 * ap1OutR;
-            
-            // Second stage with different coefficient
-            float ap2OutL = apCoef2 * ap1OutL + apState2L;
-            apState2L = ap1OutL - apCoef2 * ap2OutL;
-            float ap2OutR = apCoef2 * ap1OutR + apState2R;
-            apState2R = ap1OutR - apCoef2 * ap2OutR;
-            
-            // Blend original and phase-shifted for subtle effect
-            float extL = wideL * 0.5f + ap2OutL * 0.5f;
-            float extR = wideR * 0.5f + ap2OutR * 0.5f;
-            
-            // ========== 6. FINAL MIX ==========
-            // Bass: centered mono (punchy, tight)
-            // Mids/Highs: widened + reflections + depth + externalization
-            float outL = bassMono * 0.9f + extL * 0.65f + depthL + ref1L + ref2L + ref3L;
-            float outR = bassMono * 0.9f + extR * 0.65f + depthR + ref1R + ref2R + ref3R;
-            
-            // Soft clip for warmth and protection
-            L = softClip(outL);
-            R = softClip(outR);
-            
-            // Advance write index
-            writeIdx = (writeIdx + 1) & (MAX_DELAY - 1);
+        // What init() derives from the rate, kept per rate by DSPProcessor
+        struct Coeffs {
+            Tap reflect1, reflect2, reflect3, depth;
+            float bassCoef = 0.0f;
+
+            void build(float sampleRate) {
+                // Reflection taps, fractional so the times hold at any rate
+                reflect1.set(REFLECT1_MS, sampleRate);
+                reflect2.set(REFLECT2_MS, sampleRate);
+                reflect3.set(REFLECT3_MS, sampleRate);
+                depth.set(DEPTH_DELAY_MS, sampleRate);
+                // Bass/mid split (~180Hz crossover)
+                bassCoef = OnePoleBank<2, 1>::coefFor(BASS_CROSSOVER, sampleRate);
+            }
+        };
+
+        void init(float sampleRate) {
+            allocate();
+            Coeffs c;
+            c.build(sampleRate);
+            setCoeffs(c);
+            reset();
+        }
+
+        // Rate change: taps and split only, the state is left to reset()
+        void setCoeffs(const Coeffs& c) {
+            reflect1 = c.reflect1;
+            reflect2 = c.reflect2;
+            reflect3 = c.reflect3;
+            depth = c.depth;
+            bands.bank.coef[0] = c.bassCoef;
+        }
+
+        // Interleaved stereo block, in place
+        void processBlock(float* buf, size_t frames) {
+            if (!delayL) return;
+            while (frames > 0) {
+                const size_t n = frames < MAX_BLOCK ? frames : MAX_BLOCK;
+                processChunk(buf, n);
+                buf += 2 * n;
+                frames -= n;
+            }
         }
         
         void reset() {
-            for (int i = 0; i < MAX_DELAY; i++) {
-                delayL[i] = 0.0f;
-                delayR[i] = 0.0f;
-            }
+            if (delayL) memset(delayL, 0, 2 * LINE_SIZE * sizeof(float));
             writeIdx = 0;
-            bassStateL = bassStateR = 0;
-            presenceStateL = presenceStateR = 0;
+            bands.reset();
             apState1L = apState1R = 0;
             apState2L = apState2R = 0;
         }
-    };
-    
-    Immersive3DProcessor m_crossfeed;  // Keep variable name for compatibility
 
+    private:
+        static constexpr uint32_t MASK = LINE_SIZE - 1;
 
-    // -----------------------------------------------------------
-    // 3-Band Peak Meter for 30Hz, 60Hz, 100Hz display
-    // - 3 LP filters at different cutoffs to capture each sub-bass band
-    // - Instant attack, smooth release for punchy visual response
-    // - Ultra-lightweight: just 3 cascaded 1-pole LP filters
-    // -----------------------------------------------------------
-    struct PeakMeter {
-        static constexpr int NUM_BANDS = 3;  // 30Hz, 60Hz, 100Hz
-        
-        // Release envelope
-        float releaseCoef = 0.0f;
-        float releaseCoefInv = 0.0f;
-        
-        // LP filter for 30Hz band (~45Hz cutoff)
-        float lp30State = 0.0f;
-        float lp30Coef = 0.0f;
-        float lp30CoefInv = 0.0f;
-        float lp30Envelope = 0.0f;
-        float lp30PeakLin = 0.0f;
-        
-        // LP filter for 60Hz band (~80Hz cutoff)
-        float lp60State = 0.0f;
-        float lp60Coef = 0.0f;
-        float lp60CoefInv = 0.0f;
-        float lp60Envelope = 0.0f;
-        float lp60PeakLin = 0.0f;
-        
-        // LP filter for 100Hz band (~120Hz cutoff)
-        float lp100State = 0.0f;
-        float lp100Coef = 0.0f;
-        float lp100CoefInv = 0.0f;
-        float lp100Envelope = 0.0f;
-        float lp100PeakLin = 0.0f;
-        
-        // Pre-computed constant for dB conversion
-        static constexpr float DB_SCALE = 8.685889638f;  // 20/ln(10)
-        
-        void init(float sampleRate) {
-            if (sampleRate <= 0) sampleRate = 44100.0f;
-            
-            // Release time ~50ms for smooth response
-            float invSampleRate = fast_recipsf2(sampleRate);
-            float releaseMs = 50.0f;
-            float releaseSamples = releaseMs * 0.001f * sampleRate;
-            releaseCoef = expf(-fast_recipsf2(releaseSamples));
-            releaseCoefInv = 1.0f - releaseCoef;
-            
-            float dt = invSampleRate;
-            
-            // LP for 30Hz band (~45Hz cutoff)
-            float fc30 = 45.0f;
-            float rc30 = fast_recipsf2(2.0f * DSP_PI_F * fc30);
-            lp30Coef = dt * fast_recipsf2(rc30 + dt);
-            lp30CoefInv = 1.0f - lp30Coef;
-            
-            // LP for 60Hz band (~80Hz cutoff)
-            float fc60 = 80.0f;
-            float rc60 = fast_recipsf2(2.0f * DSP_PI_F * fc60);
-            lp60Coef = dt * fast_recipsf2(rc60 + dt);
-            lp60CoefInv = 1.0f - lp60Coef;
-            
-            // LP for 100Hz band (~120Hz cutoff)
-            float fc100 = 120.0f;
-            float rc100 = fast_recipsf2(2.0f * DSP_PI_F * fc100);
-            lp100Coef = dt * fast_recipsf2(rc100 + dt);
-            lp100CoefInv = 1.0f - lp100Coef;
-            
-            zero();
-        }
-        
-        // Process with 3 LP filters for 30Hz, 60Hz, 100Hz bands
-        inline void process(float x) {
-            // LP for 30Hz band (~45Hz cutoff)
-            lp30State = lp30CoefInv * lp30State + lp30Coef * x;
-            float lp30Abs = lp30State >= 0.0f ? lp30State : -lp30State;
-            if (lp30Abs > lp30Envelope) {
-                lp30Envelope = lp30Abs;
-            } else {
-                lp30Envelope = releaseCoef * lp30Envelope + releaseCoefInv * lp30Abs;
-            }
-            lp30PeakLin = lp30Envelope;
-            
-            // LP for 60Hz band (~80Hz cutoff)
-            lp60State = lp60CoefInv * lp60State + lp60Coef * x;
-            float lp60Abs = lp60State >= 0.0f ? lp60State : -lp60State;
-            if (lp60Abs > lp60Envelope) {
-                lp60Envelope = lp60Abs;
-            } else {
-                lp60Envelope = releaseCoef * lp60Envelope + releaseCoefInv * lp60Abs;
+        void processChunk(float* buf, size_t n) {
+            // ========== 1-3, 5: per-sample recursive part ==========
+            // Bass/mid separation, mid/high widening, externalization.
+            // The widened signal goes into the delay line; buf gets the
+            // dry mix (centered bass + externalized mids/highs).
+            bands.split(buf, n);
+            const float* bass = bands.lowpass(0);
+            uint32_t w = writeIdx;
+            size_t i = 0;
+            while (i < n) {
+                size_t run = LINE_SIZE - w;  // Contiguous write span
+                if (run > n - i) run = n - i;
+                float* dl = delayL + w;
+                float* dr = delayR + w;
+                for (size_t k = 0; k < run; k++, i++) {
+                    const float L = buf[2 * i];
+                    const float R = buf[2 * i + 1];
+
+                    // Bass (keep centered) and mids/highs (widen)
+                    const float bassL = bass[2 * i];
+                    const float bassR = bass[2 * i + 1];
+                    const float bassMono = (bassL + bassR) * 0.5f;  // Center the bass!
+
+                    // M-S processing on mids/highs only (not bass!)
+                    const float midHighL = L - bassL;
+                    const float midHighR = R - bassR;
+                    const float mid = (midHighL + midHighR) * 0.5f;
+                    const float side = (midHighL - midHighR) * 0.5f * MID_WIDTH;
+                    const float wideL = mid + side;
+                    const float wideR = mid - side;
+                    dl[k] = wideL;
+                    dr[k] = wideR;
+
+                    // Cascaded all-pass filters for phase decorrelation
+                    // This makes sound feel like it's OUTSIDE your head
+                    const float ap1OutL = apCoef1 * wideL + apState1L;
+                    apState1L = wideL - apCoef1 * ap1OutL;
+                    const float ap1OutR = apCoef1 * wideR + apState1R;
+                    apState1R = wideR - apCoef1 * ap1OutR;
+                    const float ap2OutL = apCoef2 * ap1OutL + apState2L;
+                    apState2L = ap1OutL - apCoef2 * ap2OutL;
+                    const float ap2OutR = apCoef2 * ap1OutR + apState2R;
+                    apState2R = ap1OutR - apCoef2 * ap2OutR;
+
+                    // Blend original and phase-shifted for subtle effect
+                    const float extL = wideL * 0.5f + ap2OutL * 0.5f;
+                    const float extR = wideR * 0.5f + ap2OutR * 0.5f;
+                    buf[2 * i] = bassMono * 0.9f + extL * 0.65f;
+                    buf[2 * i + 1] = bassMono * 0.9f + extR * 0.65f;
+                }
+                w = (w + (uint32_t)run) & MASK;
             }
-            lp60PeakLin = lp60Envelope;
-            
-            // LP for 100Hz band (~120Hz cutoff)
-            lp100State = lp100CoefInv * lp100State + lp100Coef * x;
-            float lp100Abs = lp100State >= 0.0f ? lp100State : -lp100State;
-            if (lp100Abs > lp100Envelope) {
-                lp100Envelope = lp100Abs;
-            } else {
-                lp100Envelope = releaseCoef * lp100Envelope + releaseCoefInv * lp100Abs;
+
+            // ========== 4: early reflections + depth, one span per tap ==========
+            // Cross-channel reflections (sound bouncing around stage)
+            const uint32_t start = writeIdx;
+            addTap(buf, 0, delayR, start, reflect1, REFLECT_GAIN1, n);  // From opposite side
+            addTap(buf, 1, delayL, start, reflect1, REFLECT_GAIN1, n);
+            addTap(buf, 0, delayL, start, reflect2, REFLECT_GAIN2, n);  // Same side bounce
+            addTap(buf, 1, delayR, start, reflect2, REFLECT_GAIN2, n);
+            addTap(buf, 0, delayR, start, reflect3, REFLECT_GAIN3, n);  // Cross again
+            addTap(buf, 1, delayL, start, reflect3, REFLECT_GAIN3, n);
+            // Depth delay (creates front-stage positioning)
+            addTap(buf, 0, delayL, start, depth, DEPTH_GAIN, n);
+            addTap(buf, 1, delayR, start, depth, DEPTH_GAIN, n);
+            writeIdx = w;
+
+            // ========== 6: soft clip for warmth and protection ==========
+            for (size_t k = 0; k < 2 * n; k++) {
+                buf[k] = softClip(buf[k]);
             }
-            lp100PeakLin = lp100Envelope;
-        }
-        
-        // Get dB for band: 0=30Hz, 1=60Hz, 2=100Hz
-        float getDB(int band) const {
-            float lin;
-            if (band == 0) lin = lp30PeakLin;       // 30Hz (LP ~45Hz)
-            else if (band == 1) lin = lp60PeakLin;  // 60Hz (LP ~80Hz)
-            else lin = lp100PeakLin;                 // 100Hz (LP ~120Hz)
-            
-            if (lin < 1e-6f) return -60.0f;
-            float dB = DB_SCALE * fast_logf(lin);
-            if (dB < -60.0f) return -60.0f;
-            if (dB > 0.0f) return 0.0f;
-            return dB;
         }
-        
-        float getLin(int band) const {
-            if (band == 0) return lp30PeakLin;
-            if (band == 1) return lp60PeakLin;
-            return lp100PeakLin;
-        }
-        
-        void zero() {
-            lp30State = 0.0f;
-            lp30Envelope = 0.0f;
-            lp30PeakLin = 0.0f;
-            lp60State = 0.0f;
-            lp60Envelope = 0.0f;
-            lp60PeakLin = 0.0f;
-            lp100State = 0.0f;
-            lp100Envelope = 0.0f;
-            lp100PeakLin = 0.0f;
+
+        // buf[2i + ch] += g * line[start + i - delay] (linear interpolation),
+        // split only where the span wraps around the line
+        static void addTap(float* buf, int ch, const float* line, uint32_t start,
+                           const Tap& tap, float g, size_t n) {
+            const float aOld = g * tap.frac;
+            const float aNew = g - aOld;
+            uint32_t r = (start - tap.whole - 1) & MASK;  // Older sample of each pair
+            float* out = buf + ch;
+            size_t i = 0;
+            while (i < n) {
+                size_t run = MASK - r;  // Pairs (r, r + 1) before the wrap
+                if (run > n - i) run = n - i;
+                const float* src = line + r;
+                for (size_t k = 0; k < run; k++) {
+                    out[2 * (i + k)] += aOld * src[k] + aNew * src[k + 1];
+                }
+                i += run;
+                r += (uint32_t)run;
+                if (i < n) {  // Pair straddling the wrap
+                    out[2 * i] += aOld * line[MASK] + aNew * line[0];
+                    i++;
+                    r = 0;
+                }
+            }
         }
     };
     
-    PeakMeter m_peakMeter;
+    Immersive3DProcessor m_crossfeed;  // Keep variable name for compatibility
 
     // Sample rate
     uint32_t m_sampleRate;
 
-    // EQ filters
-    Biquad m_eqBassL, m_eqBassR;
-    Biquad m_eqMidL, m_eqMidR;
-    Biquad m_eqTrebleL, m_eqTrebleR;
+    // Stereo tone chain: bass, mid, treble, volume bass compensation
+    enum { TONE_BASS = 0, TONE_MID, TONE_TREBLE, TONE_BASS_COMP, TONE_SECTIONS };
+    BiquadCascade<TONE_SECTIONS> m_toneChain;
 
     // Bass boost shelf filters (separate for L/R stereo)
     Biquad m_bassShelfL, m_bassShelfR;
@@ -482,35 +679,328 @@ private:
     // Crossover filters
     Biquad m_crossoverLPL, m_crossoverHPR;
 
-    // Goertzel frequency analysis
-    GoertzelBank m_goertzel;
+    // Frequency analysis (runs in the analysis task)
+    AudioAnalyzer m_analyzer;
+    AnalysisDecimator m_analysisDecim;  // Unless analysisDecimated()
+    bool m_analysisDecimated = false;   // Runtime choice without APP_DSP_ANALYSIS_DECIMATE
+    bool analysisDecimated() const { return APP_DSP_ANALYSIS_DECIMATE || m_analysisDecimated; }
+
+    // Everything setSampleRate() derives from the rate alone
+    struct RateFilters {
+        Biquad bassShelf;                       // Bass boost, +2 dB at 150 Hz
+        Biquad crossoverLP, crossoverHP;        // Split-ear
+        Immersive3DProcessor::Coeffs crossfeed;
+#if APP_DSP_VOLUME
+        float volumeCoef = 1.0f;                // Per-frame volume smoothing
+        static float volumeCoefFor(float fs) {
+            const float samples = (float)APP_DSP_VOLUME_RAMP_MS * 0.001f * fs;
+            return (samples > 1.0f) ? 1.0f - expf(-fast_recipsf2(samples)) : 1.0f;
+        }
+#endif
 
-    // EQ gains
+        void build(float fs) {
+            bassShelf.makeLowShelf(fs, 150.0f, 2.0f);
+            crossoverLP.makeLowPass(fs, APP_CROSSOVER_LP_FREQ);
+            crossoverHP.makeHighPass(fs, APP_CROSSOVER_HP_FREQ);
+            crossfeed.build(fs);
+#if APP_DSP_VOLUME
+            volumeCoef = volumeCoefFor(fs);
+#endif
+        }
+    };
+    // With the tone EQ and loudness tables: one bundle per rate, PSRAM
+    // first (about 5 KB each), built the first time the rate is used
+    struct RateBundle {
+        RateFilters filters;
+        EqCoeffCache eq;            // Tone EQ designs, every step
+        LoudnessTable loudness;     // Bass compensation, every volume
+
+        void build(uint32_t sampleRate) {
+            filters.build((float)sampleRate);
+            eq.build(sampleRate);
+            loudness.build(sampleRate);
+        }
+    };
+    static constexpr int RATE_BUNDLES = 4;      // 44.1, 48, 88.2 and 96 kHz
+    RateCache<RateBundle, RATE_BUNDLES> m_rateCache;
+    const RateBundle* m_rateBundle = nullptr;   // m_sampleRate's; null if none could be allocated
+    void eqBand(Biquad& out, int band) const;
+
+    // Parameter blocks: the writers' copy, and three slots passed between
+    // writers and the audio task (back, pending, front) by index. Pending
+    // carries PARAMS_FRESH until the audio task takes it.
+    static constexpr uint8_t PARAMS_SLOT = 0x03;
+    static constexpr uint8_t PARAMS_FRESH = 0x04;
+    portMUX_TYPE m_paramLock = portMUX_INITIALIZER_UNLOCKED;   // Writers
+    DspParams m_staged;
+    DspParams m_paramSlots[3];
+    uint8_t m_paramsBack = 0;                   // Writers'
+    std::atomic<uint8_t> m_paramsPending{1};
+    uint8_t m_paramsFront = 2;                  // Audio task's
+
+    // EQ gains (phone values and applied values), writers' side
+    float m_eqPhoneDB[EqCoeffCache::NUM_BANDS] = {0.0f, 0.0f, 0.0f};
     float m_eqBassDB;
     float m_eqMidDB;
     float m_eqTrebleDB;
-    bool m_eqActive;
 
-    // 1-pole low-pass state
-    float m_lpAlpha;
-    float m_lpState;
+    // Mode of the last published block (getters), and the one the audio
+    // task runs
+    std::atomic<uint8_t> m_mode;
+    uint8_t m_liveMode;
+    std::atomic<uint8_t> m_shed{0};     // ShedStage bits
 
-    // Control flags
-    bool m_bassBoostEnabled;
-    bool m_channelFlipEnabled;
-    bool m_bypassEnabled;
-    bool m_analysisEnabled;
-    bool m_3dSoundEnabled;
+#if APP_DSP_GRAPH
+    DspGraph m_graph = DspGraph::builtIn();     // Writers'
+    std::atomic<bool> m_graphCustom{false};
+    DspSchedule m_schedule;                     // Audio task's, from the live block
+#endif
     
-    // Volume-based bass compensation
+    // Volume-based bass compensation, writers' side
     uint8_t m_volume;           // Current volume (0-127)
     float m_bassCompensationDB; // Calculated bass boost in dB
-    Biquad m_bassCompL, m_bassCompR;  // Bass compensation filters
+
+#if APP_DSP_VOLUME
+    // Volume gain: target adopted from the parameter block, gain smoothed per frame
+    float m_volumeTarget = 1.0f;
+    float m_volumeGain = 1.0f;
+    float m_volumeCoef = 1.0f;
+#endif
+
+#if APP_DSP_Q31_PATH
+    // Q31 mirrors of the float filters, loaded from the same designs
+    BiquadCascadeQ31<TONE_SECTIONS> m_toneChainQ31;
+    BiquadQ31 m_crossoverLPQ31, m_crossoverHPQ31;
+    BiquadQ31 m_bassShelfQ31L, m_bassShelfQ31R;
+#endif
+
+#if APP_DSP_PEQ
+    ParametricEq m_peq;
+#endif
+
+    // Silence gate
+    uint32_t m_silentFrames = 0;
+    bool m_idle = false;
+#if APP_DSP_PASSTHROUGH
+    bool m_passthrough = false;         // Last block skipped the chain
+#endif
+
+#if APP_DSP_FIR
+    FirConvolver m_fir;
+#endif
+
+#if APP_DSP_DYNAMICS
+    MultibandDynamics m_dynamics;
+#endif
+
+#if APP_DSP_BINAURAL
+    BinauralVirtualizer m_binaural;
+#endif
+
+#if APP_DSP_LIMITER
+    // Output limiter (replaces the clipper's hard clamp)
+    LookaheadLimiter<float> m_limiter;
+#if APP_DSP_Q31_PATH
+    LookaheadLimiter<int32_t> m_limiterQ31;  // In the internal Q27 format
+    bool m_lastBlockQ31 = false;
+#endif
+#endif
 
 private:
     void updateBassCompensation();
+
+    // -----------------------------------------------------------
+    // Float chain stages (see dsp_chain.h). Mode choices are template
+    // parameters, so no stage tests a flag inside its loop.
+    // -----------------------------------------------------------
+    // With the limiter the clamp moves behind it; peaks above full
+    // scale are kept until then
+    static constexpr bool CLAMP_STAGES = APP_DSP_LIMITER == 0;
+
+    // Stages taking Mono filter the left slots only (APP_MONO_SPEAKER)
+
+    // EQ (always, regardless of bypass) + volume bass compensation
+    template <bool Mono>
+    struct StageTone {
+        static void run(DSPProcessor& d, float* buf, size_t frames) {
+            d.m_toneChain.process<Mono>(buf, frames);
+        }
+    };
+
+    template <bool Mono>
+    struct StagePeq {
+        static void run(DSPProcessor& d, float* buf, size_t frames) {
+#if APP_DSP_PEQ
+            d.m_peq.process<Mono>(buf, frames);
+#else
+            (void)d; (void)buf; (void)frames;
+#endif
+        }
+    };
+
+    // Both slots either way: the second channel rides in the imaginary
+    // part of the same FFTs
+    struct StageFir {
+        static void run(DSPProcessor& d, float* buf, size_t frames) {
+#if APP_DSP_FIR
+            d.m_fir.process(buf, frames, 1.0f, 1.0f);
+#else
+            (void)d; (void)buf; (void)frames;
+#endif
+        }
+    };
+
+    template <bool Mono>
+    struct StageDynamics {
+        static void run(DSPProcessor& d, float* buf, size_t frames) {
+#if APP_DSP_DYNAMICS
+            d.m_dynamics.process<Mono>(buf, frames, 1.0f, 1.0f);
+#else
+            (void)d; (void)buf; (void)frames;
+#endif
+        }
+    };
+
+    // The kind is chosen per block, not per chain
+    struct Stage3D {
+        static void run(DSPProcessor& d, float* buf, size_t frames) {
+#if APP_DSP_BINAURAL
+            if (d.m_liveMode & MODE_BINAURAL) {
+                d.m_binaural.process(buf, frames, 1.0f, 1.0f);
+                return;
+            }
+#endif
+            d.m_crossfeed.processBlock(buf, frames);
+        }
+    };
+
+    // Graph node: the schedule is compiled with 3D on, shedding is per block
+    struct StageSpatial {
+        static void run(DSPProcessor& d, float* buf, size_t frames) {
+            if (d.withShed(d.m_liveMode) & MODE_3D) Stage3D::run(d, buf, frames);
+        }
+    };
+
+    // Split-ear crossover: LP on L, HP on R, flip swaps which ear gets which
+    template <bool Boost, bool Flip>
+    struct StageSplitEar {
+        static void run(DSPProcessor& d, float* buf, size_t frames) {
+            d.m_crossoverLPL.processBlock(buf, frames, 2);
+            d.m_crossoverHPR.processBlock(buf + 1, frames, 2);
+            if (Boost) {
+                d.m_bassShelfL.processBlock(buf, frames, 2);
+            }
+
+            constexpr float CROSSOVER_GAIN = 1.41f;
+            constexpr float lpGain = CROSSOVER_GAIN * (Boost ? DSP_BASS_GAIN_BOOST : 1.0f);
+            constexpr float hpGain = CROSSOVER_GAIN;
+            const float ceiling = d.m_clipper.ceiling;
+            for (size_t i = 0; i < frames; i++) {
+                const float lp = buf[2 * i] * lpGain;
+                const float hp = buf[2 * i + 1] * hpGain;
+                float L = Flip ? hp : lp;
+                float R = Flip ? lp : hp;
+                if (CLAMP_STAGES) {
+                    if (L > ceiling) L = ceiling;
+                    if (L < -ceiling) L = -ceiling;
+                    if (R > ceiling) R = ceiling;
+                    if (R < -ceiling) R = -ceiling;
+                }
+                buf[2 * i] = L;
+                buf[2 * i + 1] = R;
+            }
+        }
+    };
+
+    // Bypass: full range on both ears, optional bass shelf
+    template <bool Boost, bool Mono>
+    struct StageFullRange {
+        static void run(DSPProcessor& d, float* buf, size_t frames) {
+            if (Boost) {
+                d.m_bassShelfL.processBlock(buf, frames, 2);
+                if (!Mono) d.m_bassShelfR.processBlock(buf + 1, frames, 2);
+            }
+            if (!Boost && !CLAMP_STAGES) return;  // Unity gain, nothing to clamp
+            constexpr float gain = Boost ? DSP_BASS_GAIN_BOOST : 1.0f;
+            const float ceiling = d.m_clipper.ceiling;
+            for (size_t i = 0; i < frames * 2; i += Mono ? 2 : 1) {
+                float x = buf[i] * gain;
+                if (CLAMP_STAGES) {
+                    if (x > ceiling) x = ceiling;
+                    if (x < -ceiling) x = -ceiling;
+                }
+                buf[i] = x;
+            }
+        }
+    };
+
+    template <bool Mono>
+    struct StageLimiter {
+        static void run(DSPProcessor& d, float* buf, size_t frames) {
+#if APP_DSP_LIMITER
+            d.m_limiter.process<Mono>(buf, frames);
+#if APP_DSP_Q31_PATH
+            d.m_lastBlockQ31 = false;
+#endif
+#else
+            (void)d; (void)buf; (void)frames;
+#endif
+        }
+    };
+
+    // Mono chain output: the left slots to both
+    struct StageMonoOut {
+        static void run(DSPProcessor&, float* buf, size_t frames) {
+            for (size_t i = 0; i < frames; i++) buf[2 * i + 1] = buf[2 * i];
+        }
+    };
+
+    template <bool Sound3D, bool Bypass, bool Boost, bool Flip>
+    using ChainFor = DSPChain<
+        StageTone<false>,
+        StagePeq<false>,
+        StageFir,
+        StageDynamics<false>,
+        typename std::conditional<Sound3D, Stage3D, DSPStageNone>::type,
+        typename std::conditional<Bypass, StageFullRange<Boost, false>, StageSplitEar<Boost, Flip>>::type,
+        StageLimiter<false>>;
+
+    template <bool Boost>
+    using MonoChainFor = DSPChain<
+        StageTone<true>,
+        StagePeq<true>,
+        StageFir,
+        StageDynamics<true>,
+        StageFullRange<Boost, true>,
+        StageLimiter<true>,
+        StageMonoOut>;
+
+    template <bool Sound3D, bool Bypass, bool Boost, bool Flip>
+    static void runChain(DSPProcessor& d, float* buf, size_t frames) {
+        ChainFor<Sound3D, Bypass, Boost, Flip>::run(d, buf, frames);
+    }
+
+    template <bool Boost>
+    static void runMonoChain(DSPProcessor& d, float* buf, size_t frames) {
+        MonoChainFor<Boost>::run(d, buf, frames);
+    }
+
+    // One hot path per mode, index = chainIndex(); flip only matters
+    // outside bypass
+    template <size_t... I>
+    static constexpr std::array<ChainFn, sizeof...(I)> makeChains(std::index_sequence<I...>) {
+        return {{&runChain<(I & 1) != 0, (I & 2) != 0, (I & 4) != 0, (I & 8) != 0 && (I & 2) == 0>...}};
+    }
+    static constexpr size_t chainIndex(bool sound3D, bool bypass, bool boost, bool flip) {
+        return (sound3D ? 1 : 0) | (bypass ? 2 : 0) | (boost ? 4 : 0) | (flip ? 8 : 0);
+    }
+    static const std::array<ChainFn, 16> CHAINS;
+    static constexpr ChainFn MONO_CHAINS[2] = {&runMonoChain<false>, &runMonoChain<true>};
 };
 
+inline const std::array<DSPProcessor::ChainFn, 16> DSPProcessor::CHAINS =
+    DSPProcessor::makeChains(std::make_index_sequence<16>{});
+
 // -----------------------------------------------------------
 // Implementation
 // -----------------------------------------------------------
@@ -520,220 +1010,784 @@ inline DSPProcessor::DSPProcessor()
     , m_eqBassDB(0.0f)
     , m_eqMidDB(0.0f)
     , m_eqTrebleDB(0.0f)
-    , m_eqActive(false)
-    , m_lpAlpha(0.0f)
-    , m_lpState(0.0f)
-    , m_bassBoostEnabled(false)
-    , m_channelFlipEnabled(false)
-    , m_bypassEnabled(false)
-    , m_analysisEnabled(true)
-    , m_3dSoundEnabled(false)
+    , m_mode(MODE_ANALYSIS)
+    , m_liveMode(MODE_ANALYSIS)
     , m_volume(127)
     , m_bassCompensationDB(0.0f)
 {
 }
 
+inline void DSPProcessor::setShed(uint8_t stages) {
+    m_shed.store(stages);
+#if APP_DSP_LIMITER
+    const bool truePeak = (stages & SHED_TRUE_PEAK) == 0;
+    m_limiter.setTruePeak(truePeak);
+#if APP_DSP_Q31_PATH
+    m_limiterQ31.setTruePeak(truePeak);
+#endif
+#endif
+}
+
 inline void DSPProcessor::init(uint32_t sampleRate) {
     m_sampleRate = sampleRate > 0 ? sampleRate : APP_I2S_DEFAULT_SR;
+    // Both A2DP rates up front: a codec switch between them only selects
+    // a bundle; the high rates are built on first use
+    m_rateCache.get(44100);
+    m_rateCache.get(48000);
+    m_crossfeed.allocate();
     updateFilters();
-    updateLPAlpha();
-    m_goertzel.init(m_sampleRate);
+    restageParams();
+    m_crossfeed.reset();
+    initAnalysis();
     m_clipper.init((float)m_sampleRate);
-    m_peakMeter.init((float)m_sampleRate);
-    m_crossfeed.init((float)m_sampleRate);
-    updateBassCompensation();  // Initialize bass compensation filter
+    initLimiter();
+#if APP_DSP_PEQ
+    m_peq.setSampleRate(m_sampleRate);
+#endif
+#if APP_DSP_FIR
+    m_fir.setSampleRate(m_sampleRate);
+#endif
+#if APP_DSP_DYNAMICS
+    m_dynamics.init(m_sampleRate);
+#endif
+#if APP_DSP_BINAURAL
+    m_binaural.setSampleRate(m_sampleRate);
+#endif
+#if APP_DSP_VOLUME
+    updateVolumeCoef();
+#endif
 }
 
 inline void DSPProcessor::setSampleRate(uint32_t sampleRate) {
     if (sampleRate == m_sampleRate && sampleRate != 0) return;
     m_sampleRate = sampleRate > 0 ? sampleRate : APP_I2S_DEFAULT_SR;
+    // Coefficients from the rate's bundle, the 3D taps included, and the
+    // EQ and bass compensation redesigned for it; the states (3D delay
+    // line too) are cleared once, below
     updateFilters();
-    updateLPAlpha();
-    updateBassCompensation();  // Re-initialize bass compensation filter for new sample rate
-    m_crossfeed.init((float)m_sampleRate);  // Re-initialize crossfeed for new sample rate
+    restageParams();
+    initLimiter();
+#if APP_DSP_PEQ
+    m_peq.setSampleRate(m_sampleRate);
+#endif
+#if APP_DSP_FIR
+    m_fir.setSampleRate(m_sampleRate);
+#endif
+#if APP_DSP_DYNAMICS
+    m_dynamics.init(m_sampleRate);
+#endif
+#if APP_DSP_BINAURAL
+    m_binaural.setSampleRate(m_sampleRate);
+#endif
     resetAllFilters();  // Clear all filter states to prevent noise on codec switch
-    m_goertzel.init(m_sampleRate);
+    initAnalysis();
     m_clipper.init((float)m_sampleRate);
-    m_peakMeter.init((float)m_sampleRate);
-    m_lpState = 0.0f;  // Reset filter state
+#if APP_DSP_VOLUME
+    updateVolumeCoef();
+#endif
 }
 
 inline void DSPProcessor::setEQ(float bassDB, float midDB, float trebleDB) {
+    portENTER_CRITICAL(&m_paramLock);
+    stageEQ(bassDB, midDB, trebleDB);
+    publishParams();
+    portEXIT_CRITICAL(&m_paramLock);
+}
+
+// m_paramLock held
+inline void DSPProcessor::stageEQ(float bassDB, float midDB, float trebleDB) {
     // Scale input range from ±12dB (phone) to actual audio range
     // Bass scaled more conservatively to prevent clipping
     // Mid/treble can be more aggressive as they clip less
-    m_eqBassDB = bassDB * 0.5f;
-    m_eqMidDB = midDB * 0.7f;
-    m_eqTrebleDB = trebleDB * 0.7f;
-    updateFilters();
+    m_eqPhoneDB[EqCoeffCache::BASS] = bassDB;
+    m_eqPhoneDB[EqCoeffCache::MID] = midDB;
+    m_eqPhoneDB[EqCoeffCache::TREBLE] = trebleDB;
+    m_eqBassDB = EqCoeffCache::appliedDB(EqCoeffCache::BASS, bassDB);
+    m_eqMidDB = EqCoeffCache::appliedDB(EqCoeffCache::MID, midDB);
+    m_eqTrebleDB = EqCoeffCache::appliedDB(EqCoeffCache::TREBLE, trebleDB);
+    // Only the EQ bands change: table lookup here, crossfade in the audio task
+    updateEqFilters();
+}
+
+inline void DSPProcessor::publishParams() {
+#if APP_DSP_GRAPH
+    compileSchedule(m_staged);
+#endif
+    m_paramSlots[m_paramsBack] = m_staged;
+    const uint8_t was = m_paramsPending.exchange((uint8_t)(m_paramsBack | PARAMS_FRESH), std::memory_order_acq_rel);
+    m_paramsBack = was & PARAMS_SLOT;
+    m_mode.store(m_staged.mode, std::memory_order_relaxed);
+}
+
+inline void DSPProcessor::adoptParams() {
+    if (!(m_paramsPending.load(std::memory_order_relaxed) & PARAMS_FRESH)) return;
+    m_paramsFront = m_paramsPending.exchange(m_paramsFront, std::memory_order_acq_rel) & PARAMS_SLOT;
+    const DspParams& p = m_paramSlots[m_paramsFront];
+
+    // Posted to the tone chains, crossfaded over this block
+    for (int s = TONE_BASS; s < TONE_SECTIONS; s++) {
+        const Biquad& design = s == TONE_BASS_COMP ? p.bassComp : p.eq[s - TONE_BASS];
+        const bool on = (p.sections >> s) & 1;
+        m_toneChain.setSection(s, design, on);
+#if APP_DSP_Q31_PATH
+        m_toneChainQ31.setSection(s, design, on);
+#endif
+    }
+    m_liveMode = p.mode;
+#if APP_DSP_GRAPH
+    m_schedule = p.schedule;
+#endif
+#if APP_DSP_VOLUME
+    m_volumeTarget = p.volumeTarget;
+#endif
+#if APP_DSP_LIMITER
+    m_limiter.setThreshold(p.limiterThreshold);
+#if APP_DSP_Q31_PATH
+    m_limiterQ31.setThreshold(p.limiterThreshold);
+#endif
+#endif
+}
+
+// The rate's EQ and bass compensation designs, taken at once (init and
+// rate changes, with the stream paused)
+inline void DSPProcessor::restageParams() {
+    portENTER_CRITICAL(&m_paramLock);
+    updateEqFilters();
+    updateBassCompensation();
+    publishParams();
+    portEXIT_CRITICAL(&m_paramLock);
+    adoptParams();
 }
 
 inline void DSPProcessor::updateFilters() {
     if (m_sampleRate == 0) return;
-    float fs = (float)m_sampleRate;
 
-    m_eqBassL.makeLowShelf(fs, 150.0f, m_eqBassDB);
-    m_eqBassR.makeLowShelf(fs, 150.0f, m_eqBassDB);
-    m_eqMidL.makePeakingEQ(fs, 1000.0f, 1.0f, m_eqMidDB);
-    m_eqMidR.makePeakingEQ(fs, 1000.0f, 1.0f, m_eqMidDB);
-    m_eqTrebleL.makeHighShelf(fs, 6000.0f, m_eqTrebleDB);
-    m_eqTrebleR.makeHighShelf(fs, 6000.0f, m_eqTrebleDB);
+    // Built on the rate's first use; designed in place only when no
+    // bundle could be allocated
+    m_rateBundle = m_rateCache.get(m_sampleRate);
+    RateFilters designed;
+    if (!m_rateBundle) designed.build((float)m_sampleRate);
+    const RateFilters& f = m_rateBundle ? m_rateBundle->filters : designed;
 
     // Bass boost shelf (+2 dB at 150 Hz)
-    m_bassShelfL.makeLowShelf(fs, 150.0f, 2.0f);
-    m_bassShelfR.makeLowShelf(fs, 150.0f, 2.0f);
+    m_bassShelfL = f.bassShelf;
+    m_bassShelfR = f.bassShelf;
 
     // Crossover filters
-    m_crossoverLPL.makeLowPass(fs, APP_CROSSOVER_LP_FREQ);
-    m_crossoverHPR.makeHighPass(fs, APP_CROSSOVER_HP_FREQ);
+    m_crossoverLPL = f.crossoverLP;
+    m_crossoverHPR = f.crossoverHP;
+    m_crossfeed.setCoeffs(f.crossfeed);
+#if APP_DSP_Q31_PATH
+    m_bassShelfQ31L.set(m_bassShelfL);
+    m_bassShelfQ31R.set(m_bassShelfR);
+    m_crossoverLPQ31.set(m_crossoverLPL);
+    m_crossoverHPQ31.set(m_crossoverHPR);
+#endif
+
+}
+
+// m_paramLock held
+inline void DSPProcessor::updateEqFilters() {
+    if (m_sampleRate == 0) return;
+
+    eqBand(m_staged.eq[EqCoeffCache::BASS], EqCoeffCache::BASS);
+    eqBand(m_staged.eq[EqCoeffCache::MID], EqCoeffCache::MID);
+    eqBand(m_staged.eq[EqCoeffCache::TREBLE], EqCoeffCache::TREBLE);
+
+    // Flat bands are unity, skip them in the cascade
+    uint8_t on = m_staged.sections & (uint8_t)(1u << TONE_BASS_COMP);
+    if (fabsf(m_eqBassDB) >= 0.1f) on |= 1u << TONE_BASS;
+    if (fabsf(m_eqMidDB) >= 0.1f) on |= 1u << TONE_MID;
+    if (fabsf(m_eqTrebleDB) >= 0.1f) on |= 1u << TONE_TREBLE;
+    m_staged.sections = on;
+}
 
-    // Cache EQ active state
-    m_eqActive = (fabsf(m_eqBassDB) >= 0.1f) ||
-                 (fabsf(m_eqMidDB) >= 0.1f) ||
-                 (fabsf(m_eqTrebleDB) >= 0.1f);
+inline void DSPProcessor::eqBand(Biquad& out, int band) const {
+    if (m_rateBundle) {
+        m_rateBundle->eq.get(out, band, m_sampleRate, m_eqPhoneDB[band]);
+    } else {
+        EqCoeffCache::design(out, band, (float)m_sampleRate, m_eqPhoneDB[band]);
+    }
 }
 
 inline void DSPProcessor::resetAllFilters() {
     // Reset all biquad filter states to prevent noise when sample rate changes
-    m_eqBassL.reset();
-    m_eqBassR.reset();
-    m_eqMidL.reset();
-    m_eqMidR.reset();
-    m_eqTrebleL.reset();
-    m_eqTrebleR.reset();
+    m_toneChain.reset();
+#if APP_DSP_Q31_PATH
+    m_toneChainQ31.reset();
+    m_crossoverLPQ31.reset();
+    m_crossoverHPQ31.reset();
+    m_bassShelfQ31L.reset();
+    m_bassShelfQ31R.reset();
+#endif
     m_bassShelfL.reset();
     m_bassShelfR.reset();
-    m_bassCompL.reset();
-    m_bassCompR.reset();
     m_crossoverLPL.reset();
     m_crossoverHPR.reset();
     m_crossfeed.reset();
-    m_peakMeter.zero();
-    m_lpState = 0.0f;
+#if APP_DSP_PEQ
+    m_peq.reset();
+#endif
+#if APP_DSP_FIR
+    m_fir.reset();
+#endif
+#if APP_DSP_BINAURAL
+    m_binaural.reset();
+#endif
+#if APP_DSP_DYNAMICS
+    m_dynamics.reset();
+#endif
+#if APP_DSP_LIMITER
+    m_limiter.reset();
+#if APP_DSP_Q31_PATH
+    m_limiterQ31.reset();
+#endif
+#endif
+}
+
+// Counts silent frames (every sample below threshold). Past the hold
+// time the states are flushed once and the chain idles; the first
+// block with signal runs normally again from clean state.
+template <typename T>
+inline bool DSPProcessor::silenceGate(const T* in, size_t frames, T threshold) {
+#if APP_DSP_SILENCE_GATE
+    const size_t n = frames * 2;
+    bool quiet;
+    if constexpr (std::is_same<T, int32_t>::value) {
+        quiet = vec_within_s32(in, n, threshold);
+    } else {
+        quiet = true;
+        for (size_t i = 0; i < n && quiet; i++) {
+            quiet = in[i] < threshold && in[i] > -threshold;
+        }
+    }
+    if (!quiet) {
+        m_silentFrames = 0;
+        m_idle = false;
+        return false;
+    }
+    if (m_idle) return true;
+    m_silentFrames += (uint32_t)frames;
+    if (m_silentFrames >= m_sampleRate / 1000 * APP_DSP_SILENCE_HOLD_MS) {
+        resetAllFilters();
+        m_idle = true;
+        return true;
+    }
+    return false;
+#else
+    (void)in; (void)frames; (void)threshold;
+    return false;
+#endif
 }
 
+#if APP_DSP_LIMITER
+inline void DSPProcessor::setLimiterLookaheadUs(uint32_t us) {
+    m_limiter.setLookaheadUs(us);
+#if APP_DSP_Q31_PATH
+    m_limiterQ31.setLookaheadUs(us);
+#endif
+    initLimiter();
+}
+#endif
+
+inline void DSPProcessor::initLimiter() {
+#if APP_DSP_LIMITER
+    m_limiter.init(m_sampleRate, 1.0f);
+#if APP_DSP_Q31_PATH
+    m_limiterQ31.init(m_sampleRate, (float)(1u << (31 - DSP_Q31_HEADROOM_BITS)));
+#endif
+#endif
+}
+
+#if APP_DSP_LIMITER
+inline void DSPProcessor::limiterStats(LimiterStats& out) const {
+#if APP_DSP_Q31_PATH
+    if (m_lastBlockQ31) {
+        m_limiterQ31.snapshot(out);
+        return;
+    }
+#endif
+    m_limiter.snapshot(out);
+}
+
+inline float DSPProcessor::limiterGain() const {
+#if APP_DSP_Q31_PATH
+    if (m_lastBlockQ31) return m_limiterQ31.currentGain();
+#endif
+    return m_limiter.currentGain();
+}
+
+inline void DSPProcessor::resetLimiterStats() {
+    m_limiter.resetStats();
+#if APP_DSP_Q31_PATH
+    m_limiterQ31.resetStats();
+#endif
+}
+#endif
+
 // Update bass compensation filter based on current volume
 // At low volumes, bass is perceived as quieter (equal loudness contour)
 // This compensates by boosting bass as volume decreases
+// m_paramLock held
 inline void DSPProcessor::updateBassCompensation() {
     if (m_sampleRate == 0) return;
-    
-    // Calculate bass boost: 0dB at full volume (127), +3dB at zero volume
-    // Use exponential curve for more natural perception
-    // volumePct: 0.0 (mute) to 1.0 (max)
-    float volumePct = (float)m_volume * fast_recipsf2(127.0f);
-    
-    // Exponential curve: more boost at lower volumes
-    // boost_dB = 3.0 * (1 - volumePct)^2
-    // This gives ~0dB at 100%, ~0.75dB at 50%, ~3dB at 0%
-    float factor = 1.0f - volumePct;
-    m_bassCompensationDB = 5.0f * factor * factor;
-    
-    // Update bass compensation filters (low shelf at 100Hz)
-    float fs = (float)m_sampleRate;
-    m_bassCompL.makeLowShelf(fs, 100.0f, m_bassCompensationDB);
-    m_bassCompR.makeLowShelf(fs, 100.0f, m_bassCompensationDB);
+
+    // Low shelf at 100 Hz from the table; the tone chain ramps to it
+    m_bassCompensationDB = LoudnessTable::compensationDB(m_volume);
+    if (m_rateBundle) {
+        m_rateBundle->loudness.get(m_staged.bassComp, m_volume, m_sampleRate);
+    } else {
+        LoudnessTable::design(m_staged.bassComp, (float)m_sampleRate, m_volume);
+    }
+    const uint8_t bit = (uint8_t)(1u << TONE_BASS_COMP);
+    m_staged.sections = (m_staged.sections & (uint8_t)~bit) | (m_bassCompensationDB > 0.1f ? bit : 0);
 }
 
-inline void DSPProcessor::updateLPAlpha() {
-    const float fc = 300.0f;
+#if APP_DSP_VOLUME
+// Same curve as the A2DP library's default volume control, but unity at 127
+inline float DSPProcessor::volumeToGain(uint8_t volume) {
+    constexpr float base = 1.4f;
+    constexpr float bits = 12.0f;
+    const float zeroOfs = powf(base, -bits);
+    if (volume >= 127) return 1.0f;
+    float g = (powf(base, volume * bits / 127.0f - bits) - zeroOfs) / (1.0f - zeroOfs);
+    return g < 0.0f ? 0.0f : g;
+}
 
-    if (m_sampleRate == 0) {
-        m_lpAlpha = 0.0f;
-        return;
+inline void DSPProcessor::updateVolumeCoef() {
+    m_volumeCoef = m_rateBundle ? m_rateBundle->filters.volumeCoef
+                                : RateFilters::volumeCoefFor((float)m_sampleRate);
+}
+
+template <bool Mono>
+inline bool DSPProcessor::applyVolume(const float* in, float* out, size_t frames, bool analysis) {
+    const float target = m_volumeTarget;
+    float g = m_volumeGain;
+    if (g == target && target == 1.0f) return false;
+
+    // Analysis sees post-volume audio, as it did when the BT callback
+    // scaled the PCM (the LED boost assumes that)
+    const float c = m_volumeCoef;
+    for (size_t i = 0; i < frames; i++) {
+        g += c * (target - g);
+        if (Mono) {
+            const float m = (in[2 * i] + in[2 * i + 1]) * (0.5f * g);
+            out[2 * i] = m;
+            out[2 * i + 1] = m;
+            if (analysis) analyzeSample(m);
+            continue;
+        }
+        const float L = in[2 * i] * g;
+        const float R = in[2 * i + 1] * g;
+        out[2 * i] = L;
+        out[2 * i + 1] = R;
+        if (analysis) {
+            analyzeSample((L + R) * 0.5f);
+        }
     }
+    if (fabsf(target - g) < 1e-5f) g = target;
+    m_volumeGain = g;
+    return true;
+}
 
-    float dt = fast_recipsf2((float)m_sampleRate);
-    float rc = fast_recipsf2(2.0f * DSP_PI_F * fc);
-    float alpha = fast_div(dt, rc + dt);
+#if APP_DSP_Q31_PATH
+inline bool DSPProcessor::applyVolumeQ31(int32_t* buf, size_t frames, bool analysis) {
+    const float target = m_volumeTarget;
+    float g = m_volumeGain;
+    if (g == target && target == 1.0f) return false;
 
-    if (alpha < 0.001f) alpha = 0.001f;
-    if (alpha > 0.999f) alpha = 0.999f;
+    constexpr int SHIFT = DSP_Q_COEF_BITS + DSP_Q31_HEADROOM_BITS;
+    const float c = m_volumeCoef;
+    for (size_t i = 0; i < frames; i++) {
+        g += c * (target - g);
+        const int64_t gq = dsp_q_coef(g);
+        const int32_t L = (int32_t)(((int64_t)buf[2 * i] * gq) >> SHIFT);
+        const int32_t R = (int32_t)(((int64_t)buf[2 * i + 1] * gq) >> SHIFT);
+        buf[2 * i] = L;
+        buf[2 * i + 1] = R;
+        if (analysis) {
+            analyzeStereoQ(L, R, 31 - DSP_Q31_HEADROOM_BITS);
+        }
+    }
+    if (fabsf(target - g) < 1e-5f) g = target;
+    m_volumeGain = g;
+    return true;
+}
+#endif
+#endif
+
+inline void DSPProcessor::initAnalysis() {
+    if (analysisDecimated()) {
+        // Same block duration and time constants at the decimated rate
+        m_analysisDecim.init(m_sampleRate);
+        const uint32_t r = m_analysisDecim.factor();
+        const uint32_t blockN = APP_GOERTZEL_N / r;
+        m_analyzer.configure(m_sampleRate / r, (uint16_t)(blockN < 8 ? 8 : blockN));
+    } else {
+        m_analyzer.configure(m_sampleRate, APP_GOERTZEL_N);
+    }
+}
+
+inline void DSPProcessor::setAnalysisDecimated(bool on) {
+    if (on == m_analysisDecimated) return;
+    m_analysisDecimated = on;
+    initAnalysis();
+}
 
-    m_lpAlpha = alpha;
+inline void DSPProcessor::analyzeSample(float mono) {
+    if (analysisDecimated() && !m_analysisDecim.push(mono, mono)) return;
+    m_analyzer.push(mono);
+}
+
+inline void DSPProcessor::analyzeStereoQ(int32_t L, int32_t R, int fracBits) {
+    if (analysisDecimated()) {
+        // Integer mono straight into the CIC, no float conversion per sample
+        float mono;
+        if (!m_analysisDecim.push(((L >> 1) + (R >> 1)) >> (fracBits - 15), mono)) return;
+        m_analyzer.push(mono);
+        return;
+    }
+    m_analyzer.push(((float)L + (float)R) * (0.5f / (float)(1u << fracBits)));
 }
 
 inline void DSPProcessor::processStereo(float &L, float &R) {
-    // Create mono mix for analysis (before any processing)
-    float mono = (L + R) * 0.5f;
-
-    // EQ always applies (regardless of bypass)
-    if (m_eqActive) {
-        L = m_eqBassL.process(L);
-        R = m_eqBassR.process(R);
-        L = m_eqMidL.process(L);
-        R = m_eqMidR.process(R);
-        L = m_eqTrebleL.process(L);
-        R = m_eqTrebleR.process(R);
+    float frame[2] = {L, R};
+    processBlock(frame, frame, 1);
+    L = frame[0];
+    R = frame[1];
+}
+
+inline void DSPProcessor::processBlock(const float* in, float* out, size_t frames) {
+    adoptParams();
+    if (silenceGate(in, frames, 1.0f / 32768.0f)) {
+        memset(out, 0, frames * 2 * sizeof(float));
+        return;
     }
-    
-    // Apply volume-based bass compensation (always active when volume < 100%)
-    // This compensates for the ear's reduced bass sensitivity at lower volumes
-    if (m_bassCompensationDB > 0.1f) {
-        L = m_bassCompL.process(L);
-        R = m_bassCompR.process(R);
+
+    // Mode from the block adopted above; an update published meanwhile
+    // waits for the next block, so a BLE/encoder change cannot split one
+    const uint8_t mode = withShed(m_liveMode);
+    const bool analysis = (mode & MODE_ANALYSIS) != 0;
+    const bool bassBoost = (mode & MODE_BASS_BOOST) != 0;
+#if APP_DSP_BINAURAL
+    // Binaural restarts from silence rather than from a stale history
+    if (APP_MONO_SPEAKER || (mode & (MODE_3D | MODE_BINAURAL)) != (MODE_3D | MODE_BINAURAL)) m_binaural.reset();
+#endif
+
+    bool prepared = false;
+#if APP_DSP_VOLUME
+    prepared = applyVolume<APP_MONO_SPEAKER != 0>(in, out, frames, analysis);
+#endif
+#if APP_MONO_SPEAKER
+    if (!prepared) {
+        // Downmix once, fused with analysis; the right slots carry the
+        // same for the FIR and are overwritten at the end
+        for (size_t i = 0; i < frames; i++) {
+            const float m = (in[2 * i] + in[2 * i + 1]) * 0.5f;
+            out[2 * i] = m;
+            out[2 * i + 1] = m;
+            if (analysis) analyzeSample(m);
+        }
     }
-    
-    // Apply 3D sound crossfeed effect (creates wider soundstage)
-    if (m_3dSoundEnabled) {
-        m_crossfeed.process(L, R);
+#if APP_DSP_GRAPH
+    if (m_schedule.count) {
+        runSchedule(out, frames);
+        return;
     }
+#endif
+    MONO_CHAINS[bassBoost ? 1 : 0](*this, out, frames);
+#else
+    if (!prepared) {
+        // Audio analysis (using original audio before DSP)
+        if (analysis) {
+            for (size_t i = 0; i < frames; i++) {
+                analyzeSample((in[2 * i] + in[2 * i + 1]) * 0.5f);
+            }
+        }
 
-    // Audio analysis (using original audio before DSP)
-    if (m_analysisEnabled) {
-        m_goertzel.processSample(mono);  // For beat detection
-        m_peakMeter.process(mono);       // For level display (fast response)
+        if (in != out) {
+            memcpy(out, in, frames * 2 * sizeof(float));
+        }
     }
 
-    // Crossover split-ear mode only when NOT bypassed
-    // Stereo preserved: LP applied to L channel, HP applied to R channel
-    if (!m_bypassEnabled) {
-        // Apply LP filter to LEFT channel (keeps stereo L content, low frequencies only)
-        float lpOut = m_crossoverLPL.process(L);
-        // Apply HP filter to RIGHT channel (keeps stereo R content, high frequencies only)
-        float hpOut = m_crossoverHPR.process(R);
+#if APP_DSP_GRAPH
+    if (m_schedule.count) {
+        runSchedule(out, frames);
+        return;
+    }
+#endif
+
+    // Rest of the chain: the hot path for this block's mode
+    const bool sound3D = (mode & MODE_3D) != 0;
+    const bool bypass = (mode & MODE_BYPASS) != 0;
+    const bool flip = (mode & MODE_FLIP) != 0;
+    CHAINS[chainIndex(sound3D, bypass, bassBoost, flip)](*this, out, frames);
+#endif
+}
+
+#if APP_DSP_Q31_PATH
+inline void DSPProcessor::processBlockQ31(int32_t* buf, size_t frames) {
+    adoptParams();
+    const uint8_t mode = withShed(m_liveMode);
+    const bool analysis = (mode & MODE_ANALYSIS) != 0;
+    const bool bassBoost = (mode & MODE_BASS_BOOST) != 0;
+#if APP_MONO_SPEAKER
+    // Downmixed into both slots: the stereo kernels below run full range
+    // on two equal channels
+    const bool sound3D = false;
+    const bool bypass = true;
+    const bool flip = false;
+    for (size_t i = 0; i < frames; i++) {
+        const int32_t m = (buf[2 * i] >> 1) + (buf[2 * i + 1] >> 1);
+        buf[2 * i] = m;
+        buf[2 * i + 1] = m;
+    }
+#else
+    const bool sound3D = (mode & MODE_3D) != 0;
+    const bool bypass = (mode & MODE_BYPASS) != 0;
+    const bool flip = (mode & MODE_FLIP) != 0;
+#endif
+#if APP_DSP_BINAURAL
+    // Binaural restarts from silence rather than from a stale history
+    if (!sound3D || !(mode & MODE_BINAURAL)) m_binaural.reset();
+#endif
+    const size_t n = frames * 2;
+
+    constexpr float scaleQ = (float)(1 << (31 - DSP_Q31_HEADROOM_BITS));
+    constexpr float scaleQInv = 1.0f / scaleQ;
+    // Clipper ceiling (1.0) in the internal format
+    constexpr int32_t ceilQ = (int32_t)((1u << (31 - DSP_Q31_HEADROOM_BITS)) - 1);
+
+    if (silenceGate<int32_t>(buf, frames, 1 << 16)) {
+        memset(buf, 0, n * sizeof(int32_t));
+        return;
+    }
 
-        // Apply bass boost shelf to LP channel
-        if (m_bassBoostEnabled) {
-            lpOut = m_bassShelfL.process(lpOut) * DSP_BASS_GAIN_BOOST;
+    bool prepared = false;
+#if APP_DSP_VOLUME
+    prepared = applyVolumeQ31(buf, frames, analysis);
+#endif
+    if (!prepared) {
+        // Audio analysis (using original audio before DSP)
+        if (analysis) {
+            for (size_t i = 0; i < frames; i++) {
+                analyzeStereoQ(buf[2 * i], buf[2 * i + 1], 31);
+            }
         }
 
-        // Gain compensation: each ear only gets part of the spectrum
-        constexpr float CROSSOVER_GAIN = 1.41f;
-        lpOut *= CROSSOVER_GAIN;
-        hpOut *= CROSSOVER_GAIN;
+        // Q31 -> internal Q27 (headroom for boost)
+        vec_sra_s32(buf, n, DSP_Q31_HEADROOM_BITS);
+    }
 
-        // Channel flip controls which ear gets LP vs HP
-        if (!m_channelFlipEnabled) {
-            L = lpOut;  // Left ear: low frequencies from L channel
-            R = hpOut;  // Right ear: high frequencies from R channel
-        } else {
-            L = hpOut;  // Left ear: high frequencies from R channel
-            R = lpOut;  // Right ear: low frequencies from L channel
+    m_toneChainQ31.process(buf, frames);
+#if APP_DSP_PEQ
+    m_peq.processQ31(buf, frames);
+#endif
+#if APP_DSP_FIR
+    m_fir.process(buf, frames, scaleQInv, scaleQ);
+#endif
+#if APP_DSP_DYNAMICS
+    m_dynamics.process(buf, frames, scaleQInv, scaleQ);
+#endif
+
+#if APP_DSP_BINAURAL
+    if (sound3D && (mode & MODE_BINAURAL)) {
+        m_binaural.process(buf, frames, scaleQInv, scaleQ);
+    } else
+#endif
+    if (sound3D) {
+        // 3D stays float; its soft clip keeps the result within +/-1.0
+        float* tmp = m_crossfeed.scratch;
+        constexpr size_t CHUNK = Immersive3DProcessor::MAX_BLOCK;
+        for (size_t done = 0; done < frames; done += CHUNK) {
+            const size_t m = (frames - done < CHUNK) ? frames - done : CHUNK;
+            int32_t* q = buf + 2 * done;
+            for (size_t i = 0; i < 2 * m; i++) tmp[i] = (float)q[i] * scaleQInv;
+            m_crossfeed.processBlock(tmp, m);
+            for (size_t i = 0; i < 2 * m; i++) q[i] = (int32_t)(tmp[i] * scaleQ);
         }
+    }
+
+    int64_t gainL, gainR;
+    if (!bypass) {
+        m_crossoverLPQ31.processBlock(buf, frames, 2);
+        m_crossoverHPQ31.processBlock(buf + 1, frames, 2);
+        if (bassBoost) {
+            m_bassShelfQ31L.processBlock(buf, frames, 2);
+        }
+        constexpr float CROSSOVER_GAIN = 1.41f;
+        gainL = dsp_q_coef(CROSSOVER_GAIN * (bassBoost ? DSP_BASS_GAIN_BOOST : 1.0f));
+        gainR = dsp_q_coef(CROSSOVER_GAIN);
     } else {
-        // Bypass mode: full-range stereo with optional bass boost
-        if (m_bassBoostEnabled) {
-            // Apply bass shelf to each channel independently (keeps stereo)
-            L = m_bassShelfL.process(L) * DSP_BASS_GAIN_BOOST;
-            R = m_bassShelfR.process(R) * DSP_BASS_GAIN_BOOST;
+        if (bassBoost) {
+            m_bassShelfQ31L.processBlock(buf, frames, 2);
+            m_bassShelfQ31R.processBlock(buf + 1, frames, 2);
+        }
+        gainL = gainR = dsp_q_coef(bassBoost ? DSP_BASS_GAIN_BOOST : 1.0f);
+    }
+
+    const bool swap = !bypass && flip;
+#if APP_DSP_LIMITER
+    // Gain in the internal format (kept within int32, 15x full scale),
+    // limiter, then ear routing and the shift back to Q31. The clamp
+    // below only catches the limiter's float rounding at full scale.
+    for (size_t i = 0; i < n; i++) {
+        int64_t v = ((int64_t)buf[i] * ((i & 1) ? gainR : gainL)) >> DSP_Q_COEF_BITS;
+        if (v > INT32_MAX) v = INT32_MAX;
+        if (v < -INT32_MAX) v = -INT32_MAX;
+        buf[i] = (int32_t)v;
+    }
+    m_limiterQ31.process(buf, frames);
+    m_lastBlockQ31 = true;
+#endif
+
+    // Gain, ear routing and clipper, back to Q31
+    for (size_t i = 0; i < frames; i++) {
+#if APP_DSP_LIMITER
+        int64_t l = buf[2 * i];
+        int64_t r = buf[2 * i + 1];
+#else
+        int64_t l = ((int64_t)buf[2 * i] * gainL) >> DSP_Q_COEF_BITS;
+        int64_t r = ((int64_t)buf[2 * i + 1] * gainR) >> DSP_Q_COEF_BITS;
+#endif
+        if (l > ceilQ) l = ceilQ;
+        if (l < -ceilQ) l = -ceilQ;
+        if (r > ceilQ) r = ceilQ;
+        if (r < -ceilQ) r = -ceilQ;
+        int32_t L = (int32_t)l << DSP_Q31_HEADROOM_BITS;
+        int32_t R = (int32_t)r << DSP_Q31_HEADROOM_BITS;
+        buf[2 * i] = swap ? R : L;
+        buf[2 * i + 1] = swap ? L : R;
+    }
+}
+#endif
+
+#if APP_DSP_PASSTHROUGH
+inline bool DSPProcessor::passthrough() {
+    adoptParams();
+    const uint8_t mode = withShed(m_liveMode);
+    bool flat = (mode & (MODE_BYPASS | MODE_BASS_BOOST | MODE_3D)) == MODE_BYPASS && m_toneChain.isUnity();
+#if APP_DSP_VOLUME
+    flat = flat && m_volumeGain == 1.0f && m_volumeTarget == 1.0f;
+#endif
+#if APP_DSP_PEQ
+    flat = flat && m_peq.isFlat();
+#endif
+#if APP_DSP_FIR
+    flat = flat && !m_fir.running() && m_fir.irRate() != m_sampleRate;
+#endif
+#if APP_DSP_DYNAMICS
+    flat = flat && m_dynamics.getPreset() == MultibandDynamics::OFF;
+#endif
+    // Back into the chain: stale limiter and filter history is dropped,
+    // as after the silence gate
+    if (m_passthrough && !flat) resetAllFilters();
+    m_passthrough = flat;
+    return flat;
+}
+
+inline void DSPProcessor::processPassthrough(int32_t* buf, size_t frames) {
+    if (silenceGate<int32_t>(buf, frames, 1 << 16)) {
+        memset(buf, 0, frames * 2 * sizeof(int32_t));
+        return;
+    }
+    if (!(withShed(m_liveMode) & MODE_ANALYSIS)) return;
+    // Integer mono into the CIC when analysis is decimated, the only
+    // per-sample work left
+    for (size_t i = 0; i < frames; i++) {
+        analyzeStereoQ(buf[2 * i], buf[2 * i + 1], 31);
+    }
+}
+#endif
+
+#if APP_DSP_GRAPH
+inline bool DSPProcessor::setGraph(const DspGraph& graph) {
+    if (!graph.valid()) return false;
+    portENTER_CRITICAL(&m_paramLock);
+    m_graph = graph;
+    m_graphCustom.store(!graph.isBuiltIn(), std::memory_order_relaxed);
+    publishParams();
+    portEXIT_CRITICAL(&m_paramLock);
+    return true;
+}
+
+inline DspGraph DSPProcessor::getGraph() {
+    portENTER_CRITICAL(&m_paramLock);
+    const DspGraph g = m_graph;
+    portEXIT_CRITICAL(&m_paramLock);
+    return g;
+}
+
+// The mode's instantiation of every node, chosen here once rather than
+// per block. m_paramLock held.
+inline void DSPProcessor::compileSchedule(DspParams& p) const {
+    DspSchedule& s = p.schedule;
+    s.count = 0;
+    if (!m_graphCustom.load(std::memory_order_relaxed)) return;
+    constexpr bool Mono = APP_MONO_SPEAKER != 0;
+    const bool boost = (p.mode & MODE_BASS_BOOST) != 0;
+    const bool bypass = Mono || (p.mode & MODE_BYPASS) != 0;
+    const bool flip = (p.mode & MODE_FLIP) != 0;
+    for (uint8_t i = 0; i < m_graph.count; i++) {
+        ChainFn fn = nullptr;
+        switch (m_graph.nodes[i]) {
+            case DspGraph::NODE_TONE:     fn = &StageTone<Mono>::run; break;
+            case DspGraph::NODE_PEQ:      fn = &StagePeq<Mono>::run; break;
+            case DspGraph::NODE_FIR:      fn = &StageFir::run; break;
+            case DspGraph::NODE_DYNAMICS: fn = &StageDynamics<Mono>::run; break;
+            case DspGraph::NODE_3D:
+                if (!Mono && (p.mode & MODE_3D)) fn = &StageSpatial::run;
+                break;
+            case DspGraph::NODE_EAR:
+                if (bypass) {
+                    fn = boost ? &StageFullRange<true, Mono>::run : &StageFullRange<false, Mono>::run;
+                } else if (flip) {
+                    fn = boost ? &StageSplitEar<true, true>::run : &StageSplitEar<false, true>::run;
+                } else {
+                    fn = boost ? &StageSplitEar<true, false>::run : &StageSplitEar<false, false>::run;
+                }
+                break;
+            case DspGraph::NODE_LIMITER:  fn = &StageLimiter<Mono>::run; break;
         }
+        if (fn) s.run[s.count++] = fn;
     }
+    if (Mono) s.run[s.count++] = &StageMonoOut::run;
+}
 
-    // Apply soft clipper to prevent harsh digital clipping
-    m_clipper.process(L, R);
+inline void DSPProcessor::runSchedule(float* buf, size_t frames) {
+    for (uint8_t i = 0; i < m_schedule.count; i++) m_schedule.run[i](*this, buf, frames);
 }
+#endif
 
 inline uint8_t DSPProcessor::getControlByte() const {
-    uint8_t v = 0;
-    if (m_bassBoostEnabled) v |= 0x01;
-    if (m_channelFlipEnabled) v |= 0x02;
-    if (m_bypassEnabled) v |= 0x04;
-    return v;
+    return m_mode.load() & MODE_CONTROL;
 }
 
 inline void DSPProcessor::applyControlByte(uint8_t v) {
-    m_bassBoostEnabled = (v & 0x01) != 0;
-    m_channelFlipEnabled = (v & 0x02) != 0;
-    m_bypassEnabled = (v & 0x04) != 0;
+    replaceMode(MODE_CONTROL, v);
+}
+
+// One parameter block for the whole preset
+inline void DSPProcessor::applyPreset(const DspPreset& preset) {
+    portENTER_CRITICAL(&m_paramLock);
+    if (preset.fields & DspPreset::EQ) {
+        stageEQ((float)preset.eq[0], (float)preset.eq[1], (float)preset.eq[2]);
+    }
+#if APP_DSP_LIMITER
+    if (preset.fields & DspPreset::LIMITER) {
+        m_staged.limiterThreshold = preset.limiterThreshold;
+    }
+#endif
+    uint8_t mask = 0, value = 0;
+    if (preset.fields & DspPreset::CONTROL) {
+        mask |= MODE_CONTROL;
+        value |= preset.control & MODE_CONTROL;
+    }
+    if (preset.fields & DspPreset::SOUND_3D) {
+        mask |= MODE_3D;    // On or off, of the kind set3DMode chose
+        value |= preset.sound3D ? MODE_3D : 0;
+    }
+    m_staged.mode = (uint8_t)((m_staged.mode & ~mask) | (value & mask));
+    publishParams();
+    portEXIT_CRITICAL(&m_paramLock);
 }
@@ -0,0 +1,64 @@
+#pragma once
+
+// -----------------------------------------------------------
+// EQ coefficient cache
+// The phone/encoder EQ range is discrete (integer dB, -12..+12), so
+// every band design for a sample rate is computed once
+// and setEQ() becomes a table lookup instead of powf/sinf/cosf.
+// One table per rate: DSPProcessor keeps one in each of its rate
+// bundles (rate_cache.h), so switching rates only selects a table.
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <math.h>
+#include "biquad.h"
+
+class EqCoeffCache {
+public:
+    enum Band { BASS = 0, MID, TREBLE, NUM_BANDS };
+    static constexpr int MIN_DB = -12;
+    static constexpr int MAX_DB = 12;
+    static constexpr int NUM_STEPS = MAX_DB - MIN_DB + 1;
+
+    // Design one EQ band. phoneDB is the user-facing value; the applied
+    // gain is scaled per band (bass more conservatively to avoid clipping).
+    static void design(Biquad& out, int band, float fs, float phoneDB) {
+        switch (band) {
+            case BASS:   out.makeLowShelf(fs, 150.0f, phoneDB * 0.5f); break;
+            case MID:    out.makePeakingEQ(fs, 1000.0f, 1.0f, phoneDB * 0.7f); break;
+            default:     out.makeHighShelf(fs, 6000.0f, phoneDB * 0.7f); break;
+        }
+    }
+
+    // Applied gain for a band, as used by design()
+    static float appliedDB(int band, float phoneDB) {
+        return phoneDB * (band == BASS ? 0.5f : 0.7f);
+    }
+
+    // Design every step for sampleRate, unless already done
+    void build(uint32_t sampleRate) {
+        if (sampleRate == 0 || sampleRate == m_rate) return;
+        float fs = (float)sampleRate;
+        for (int b = 0; b < NUM_BANDS; b++) {
+            for (int i = 0; i < NUM_STEPS; i++) {
+                design(m_table[b][i], b, fs, (float)(MIN_DB + i));
+            }
+        }
+        m_rate = sampleRate;
+    }
+
+    // Lookup; falls back to designing for off-grid values or another rate
+    void get(Biquad& out, int band, uint32_t sampleRate, float phoneDB) const {
+        int db = (int)lrintf(phoneDB);
+        if (sampleRate == m_rate && db >= MIN_DB && db <= MAX_DB &&
+            fabsf(phoneDB - (float)db) < 0.01f) {
+            out = m_table[band][db - MIN_DB];
+            return;
+        }
+        design(out, band, (float)sampleRate, phoneDB);
+    }
+
+private:
+    uint32_t m_rate = 0;
+    Biquad m_table[NUM_BANDS][NUM_STEPS];
+};
@@ -7,8 +7,11 @@
 
 #include <stdint.h>
 #include <math.h>
+#include "sdkconfig.h"
 
-#ifdef ESP32
+// The S3's LX7 FPU has the same recip0.s; its IDF target is checked
+// since ESP32 only comes from Arduino's config
+#if defined(ESP32) || (defined(__XTENSA__) && CONFIG_IDF_TARGET_ESP32S3)
 static __attribute__((always_inline)) inline
 float fast_recipsf2(float a) {
     float result;
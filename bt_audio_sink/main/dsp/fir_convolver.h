@@ -0,0 +1,245 @@
+#pragma once
+
+// -----------------------------------------------------------
+// FIR Convolver - room correction with a measured impulse response
+// Uniformly partitioned overlap-save convolution:
+// - The IR is cut into partitions of B = APP_FIR_PARTITION taps,
+//   each transformed once (M = 2B point FFT) when it is loaded
+// - Every B frames the newest 2B input frames are transformed,
+//   pushed into a frequency-domain delay line, multiplied with
+//   the partition spectra, summed and transformed back
+// - One IR for both channels: L and R travel as the real and
+//   imaginary part of one complex FFT (the IR is real, so the
+//   channels never mix)
+// - Latency is B frames; CPU per frame falls with larger B
+// - IR spectra in PSRAM, double buffered: a new IR is prepared
+//   outside the audio task and swapped in at a block boundary
+// - Only runs while the stream rate matches the IR's rate
+// IR blob (BLE upload / SPIFFS):
+//   ["FIR1", rate u32, taps u32, taps x float32] LE
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "complex_fft.h"
+#include "../config/app_config.h"
+
+class FirConvolver {
+public:
+    static constexpr int B = APP_FIR_PARTITION;
+    static constexpr int M = 2 * B;
+    static constexpr int MAX_PARTS = (APP_FIR_MAX_TAPS + B - 1) / B;
+    static constexpr uint32_t MAGIC = 0x31524946;      // "FIR1"
+    static constexpr size_t HEADER_BYTES = 12;
+    static constexpr size_t MAX_BLOB_BYTES = HEADER_BYTES + APP_FIR_MAX_TAPS * sizeof(float);
+    // Sound-upload type that carries an IR instead of a WAV
+    static constexpr uint8_t UPLOAD_TYPE = 0x10;
+
+    ~FirConvolver() {
+        for (int s = 0; s < 2; s++) {
+            if (m_spec[s]) heap_caps_free(m_spec[s]);
+        }
+        if (m_fdl) heap_caps_free(m_fdl);
+    }
+
+    // Not the audio task. Parses and transforms the IR into the idle
+    // slot; false on a bad blob, no memory, or a swap still pending.
+    bool loadIr(const uint8_t* blob, size_t len) {
+        uint32_t magic, rate, taps;
+        if (len < HEADER_BYTES) return false;
+        memcpy(&magic, blob, 4);
+        memcpy(&rate, blob + 4, 4);
+        memcpy(&taps, blob + 8, 4);
+        if (magic != MAGIC || rate == 0 || taps == 0 || taps > APP_FIR_MAX_TAPS ||
+            len < HEADER_BYTES + taps * sizeof(float)) {
+            ESP_LOGE(TAG, "Bad IR blob (%u bytes)", (unsigned)len);
+            return false;
+        }
+        if (!allocate()) return false;
+
+        const int cur = m_active.load(std::memory_order_acquire);
+        const int slot = (cur == 0) ? 1 : 0;
+        if (m_inUse.load(std::memory_order_acquire) == slot) {
+            ESP_LOGW(TAG, "IR swap still pending");
+            return false;
+        }
+
+        if (!m_fftReady) {
+            m_fft.init();
+            m_fftReady = true;
+        }
+        // Partition p: taps [pB, pB + B) zero padded to M, scaled by 1/M
+        // for the inverse transform
+        const int parts = (int)((taps + B - 1) / B);
+        for (int p = 0; p < parts; p++) {
+            float* h = m_spec[slot] + (size_t)p * 2 * M;
+            memset(h, 0, 2 * M * sizeof(float));
+            for (int n = 0; n < B; n++) {
+                const uint32_t k = (uint32_t)(p * B + n);
+                if (k >= taps) break;
+                float v;
+                memcpy(&v, blob + HEADER_BYTES + k * sizeof(float), sizeof(float));
+                h[2 * n] = v * (1.0f / (float)M);
+            }
+            m_fft.forward(h);
+        }
+        m_parts[slot] = parts;
+        m_rate[slot] = rate;
+        m_taps[slot] = taps;
+        m_active.store(slot, std::memory_order_release);
+        ESP_LOGI(TAG, "IR loaded: %u taps @ %u Hz, %d partitions of %d",
+                 (unsigned)taps, (unsigned)rate, parts, B);
+        return true;
+    }
+
+    // Stop convolving (any task); the spectra stay allocated
+    void clearIr() { m_active.store(-1, std::memory_order_release); }
+
+    void setSampleRate(uint32_t sampleRate) { m_sampleRate = sampleRate; }
+
+    // Audio task (or with it stopped): restart from silence
+    void reset() {
+        m_inUse.store(-1, std::memory_order_release);
+    }
+
+    bool hasIr() const { return m_active.load(std::memory_order_acquire) >= 0; }
+    // True while the IR is applied (rate matches); output is B frames late then
+    bool running() const { return m_inUse.load(std::memory_order_acquire) >= 0; }
+    uint32_t irTaps() const {
+        const int s = m_active.load(std::memory_order_acquire);
+        return s >= 0 ? m_taps[s] : 0;
+    }
+    uint32_t irRate() const {
+        const int s = m_active.load(std::memory_order_acquire);
+        return s >= 0 ? m_rate[s] : 0;
+    }
+
+    // Audio task: interleaved stereo in place. toFloat/fromFloat convert
+    // T to and from the float full scale (1.0 / 1.0 for float).
+    template <typename T>
+    void process(T* buf, size_t frames, float toFloat, float fromFloat) {
+        const int cur = m_active.load(std::memory_order_acquire);
+        if (cur < 0 || m_rate[cur] != m_sampleRate) {
+            if (m_inUse.load(std::memory_order_relaxed) >= 0) {
+                m_inUse.store(-1, std::memory_order_release);
+            }
+            return;
+        }
+        if (m_inUse.load(std::memory_order_relaxed) < 0) clearState();
+        m_inUse.store(cur, std::memory_order_release);
+
+        const int parts = m_parts[cur];
+        const float* spec = m_spec[cur];
+        float* in = m_time + 2 * B;  // Newest half of the time buffer
+        for (size_t i = 0; i < frames; i++) {
+            in[2 * m_pos] = (float)buf[2 * i] * toFloat;
+            in[2 * m_pos + 1] = (float)buf[2 * i + 1] * toFloat;
+            buf[2 * i] = toSample<T>(m_out[2 * m_pos] * fromFloat);
+            buf[2 * i + 1] = toSample<T>(m_out[2 * m_pos + 1] * fromFloat);
+            if (++m_pos == B) {
+                m_pos = 0;
+                partition(spec, parts);
+            }
+        }
+    }
+
+private:
+    static constexpr const char* TAG = "FIR";
+
+    template <typename T>
+    static inline T toSample(float v) {
+        if (std::is_floating_point<T>::value) return (T)v;
+        // Fixed point: keep within int32
+        if (v > 2147483520.0f) v = 2147483520.0f;
+        if (v < -2147483520.0f) v = -2147483520.0f;
+        return (T)v;
+    }
+
+    bool allocate() {
+        if (m_fdl) return true;
+        const size_t specBytes = (size_t)MAX_PARTS * 2 * M * sizeof(float);
+        const bool psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+        const uint32_t caps = psram ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+                                    : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        float* s0 = (float*)heap_caps_malloc(specBytes, caps);
+        float* s1 = (float*)heap_caps_malloc(specBytes, caps);
+        float* fdl = (float*)heap_caps_malloc(specBytes, caps);
+        if (!s0 || !s1 || !fdl) {
+            ESP_LOGE(TAG, "IR buffers (3 x %u KB) allocation failed",
+                     (unsigned)(specBytes / 1024));
+            if (s0) heap_caps_free(s0);
+            if (s1) heap_caps_free(s1);
+            if (fdl) heap_caps_free(fdl);
+            return false;
+        }
+        m_spec[0] = s0;
+        m_spec[1] = s1;
+        m_fdl = fdl;
+        return true;
+    }
+
+    void clearState() {
+        memset(m_time, 0, sizeof(m_time));
+        memset(m_out, 0, sizeof(m_out));
+        memset(m_fdl, 0, (size_t)MAX_PARTS * 2 * M * sizeof(float));
+        m_pos = 0;
+        m_head = 0;
+    }
+
+    // B new frames are in: transform, multiply-accumulate, transform back
+    void partition(const float* spec, int parts) {
+        float* x = m_fdl + (size_t)m_head * 2 * M;
+        memcpy(x, m_time, sizeof(m_time));
+        m_fft.forward(x);
+        // Overlap-save: the newest half becomes the oldest
+        memcpy(m_time, m_time + 2 * B, 2 * B * sizeof(float));
+
+        float* acc = m_acc;
+        memset(acc, 0, sizeof(m_acc));
+        int slot = m_head;
+        for (int p = 0; p < parts; p++) {
+            const float* X = m_fdl + (size_t)slot * 2 * M;
+            const float* H = spec + (size_t)p * 2 * M;
+            for (int k = 0; k < M; k++) {
+                const float xr = X[2 * k], xi = X[2 * k + 1];
+                const float hr = H[2 * k], hi = H[2 * k + 1];
+                acc[2 * k] += xr * hr - xi * hi;
+                acc[2 * k + 1] += xr * hi + xi * hr;
+            }
+            slot = (slot == 0) ? MAX_PARTS - 1 : slot - 1;
+        }
+        m_head = (m_head + 1 == MAX_PARTS) ? 0 : m_head + 1;
+
+        // Inverse as conj(FFT(conj(Y))); the last B outputs are valid
+        for (int k = 0; k < M; k++) acc[2 * k + 1] = -acc[2 * k + 1];
+        m_fft.forward(acc);
+        for (int n = 0; n < B; n++) {
+            m_out[2 * n] = acc[2 * (B + n)];
+            m_out[2 * n + 1] = -acc[2 * (B + n) + 1];
+        }
+    }
+
+    ComplexFft<M> m_fft;
+    bool m_fftReady = false;
+
+    // IR slots (PSRAM), written by loadIr, read by the audio task
+    float* m_spec[2] = {nullptr, nullptr};
+    int m_parts[2] = {0, 0};
+    uint32_t m_rate[2] = {0, 0};
+    uint32_t m_taps[2] = {0, 0};
+    std::atomic<int> m_active{-1};      // Slot to use, -1 = no IR
+    std::atomic<int> m_inUse{-1};       // Slot the audio task runs, -1 = idle
+
+    // Audio task state
+    uint32_t m_sampleRate = 0;
+    float* m_fdl = nullptr;             // MAX_PARTS input spectra, ring
+    int m_head = 0;
+    float m_time[2 * M];                // Previous and current B frames
+    float m_acc[2 * M];
+    float m_out[2 * B];                 // Output of the last partition
+    int m_pos = 0;
+};
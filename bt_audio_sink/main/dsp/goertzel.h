@@ -7,6 +7,7 @@
 
 #include <math.h>
 #include "fast_math.h"
+#include "const_math.h"
 #include "../config/app_config.h"
 
 class Goertzel {
@@ -15,15 +16,24 @@ public:
     float s1;
     float s2;
     float freq;
+    float cosW;     // cos/sin of the bin, for magnitude()
+    float sinW;
 
-    Goertzel() : coeff(0.0f), s1(0.0f), s2(0.0f), freq(0.0f) {}
+    Goertzel() : coeff(0.0f), s1(0.0f), s2(0.0f), freq(0.0f), cosW(1.0f), sinW(0.0f) {}
 
     void init(float f, float fs) {
+        const float w = fast_div(2.0f * DSP_PI_F * f, fs);
+        init(f, cosf(w), sinf(w));
+    }
+
+    // Bin trig already known (a generated table)
+    void init(float f, float c, float s) {
         freq = f;
         s1 = 0.0f;
         s2 = 0.0f;
-        float w = fast_div(2.0f * DSP_PI_F * f, fs);
-        coeff = 2.0f * cosf(w);
+        cosW = c;
+        sinW = s;
+        coeff = 2.0f * c;
     }
 
     void reset() {
@@ -37,10 +47,9 @@ public:
         s1 = s0;
     }
 
-    float magnitude(float fs) const {
-        float w = fast_div(2.0f * DSP_PI_F * freq, fs);
-        float real = s1 - s2 * cosf(w);
-        float imag = s2 * sinf(w);
+    float magnitude() const {
+        float real = s1 - s2 * cosW;
+        float imag = s2 * sinW;
         return sqrtf(real * real + imag * imag);
     }
 };
@@ -54,20 +63,27 @@ public:
     static constexpr int NUM_BANDS = 3;
     static constexpr float FREQS[NUM_BANDS] = {30.0f, 60.0f, 100.0f};
 
-    GoertzelBank() : m_sampleRate(0), m_count(0) {
+    GoertzelBank() : m_sampleRate(0), m_count(0), m_blockN(APP_GOERTZEL_N) {
         for (int i = 0; i < NUM_BANDS; i++) {
             m_dB[i] = -120.0f;
             m_lin[i] = 0.0f;
         }
     }
 
-    void init(uint32_t sampleRate) {
+    // blockN: samples per magnitude update (APP_GOERTZEL_N at the stream
+    // rate; scaled down when fed from the analysis decimator)
+    void init(uint32_t sampleRate, uint16_t blockN = APP_GOERTZEL_N) {
         m_sampleRate = sampleRate;
+        m_blockN = blockN ? blockN : 1;
         if (sampleRate == 0) return;
         
-        float fs = (float)sampleRate;
+        const int row = trigRow(sampleRate);
         for (int i = 0; i < NUM_BANDS; i++) {
-            m_goertzel[i].init(FREQS[i], fs);
+            if (row >= 0) {
+                m_goertzel[i].init(FREQS[i], TRIG.cosW[row][i], TRIG.sinW[row][i]);
+            } else {
+                m_goertzel[i].init(FREQS[i], (float)sampleRate);
+            }
         }
         m_count = 0;
     }
@@ -79,7 +95,7 @@ public:
         }
 
         m_count++;
-        if (m_count >= APP_GOERTZEL_N) {
+        if (m_count >= m_blockN) {
             computeMagnitudes();
         }
     }
@@ -105,14 +121,44 @@ public:
     }
 
 private:
-    void computeMagnitudes() {
-        float fs = (float)m_sampleRate;
-        if (fs <= 0.0f) fs = (float)APP_I2S_DEFAULT_SR;
+    // Rates the bank runs at: the analysis rates the decimator gives
+    // (stream rate / power of two, integer) and the stream rates
+    // themselves. Bin trig for them is generated into flash; any other
+    // rate computes it at init.
+    static constexpr uint32_t TRIG_RATES[] = { 2000, 2756, 3000, 16000, 32000, 44100, 48000, 88200, 96000 };
+    static constexpr int TRIG_ROWS = sizeof(TRIG_RATES) / sizeof(TRIG_RATES[0]);
+
+    struct TrigTable {
+        float cosW[TRIG_ROWS][NUM_BANDS];
+        float sinW[TRIG_ROWS][NUM_BANDS];
+    };
+
+    static constexpr TrigTable makeTrigTable() {
+        TrigTable t{};
+        for (int r = 0; r < TRIG_ROWS; r++) {
+            for (int i = 0; i < NUM_BANDS; i++) {
+                const double w = 2.0 * CM_PI * FREQS[i] / TRIG_RATES[r];
+                t.cosW[r][i] = (float)cm_cos(w);
+                t.sinW[r][i] = (float)cm_sin(w);
+            }
+        }
+        return t;
+    }
 
-        static const float invNormFactor = 1.0f / (float)(APP_GOERTZEL_N / 2);
+    static const TrigTable TRIG;    // Defined below the class
+
+    static int trigRow(uint32_t sampleRate) {
+        for (int r = 0; r < TRIG_ROWS; r++) {
+            if (TRIG_RATES[r] == sampleRate) return r;
+        }
+        return -1;
+    }
+
+    void computeMagnitudes() {
+        const float invNormFactor = 2.0f / (float)m_blockN;
 
         for (int i = 0; i < NUM_BANDS; i++) {
-            float mag = m_goertzel[i].magnitude(fs);
+            float mag = m_goertzel[i].magnitude();
             float norm = mag * invNormFactor;
             
             if (norm < 1e-9f) norm = 1e-9f;
@@ -131,9 +177,12 @@ private:
     Goertzel m_goertzel[NUM_BANDS];
     uint32_t m_sampleRate;
     uint16_t m_count;
+    uint16_t m_blockN;
     volatile float m_dB[NUM_BANDS];
     volatile float m_lin[NUM_BANDS];
 };
 
 // Static member initialization
 constexpr float GoertzelBank::FREQS[GoertzelBank::NUM_BANDS];
+constexpr uint32_t GoertzelBank::TRIG_RATES[];
+constexpr GoertzelBank::TrigTable GoertzelBank::TRIG = GoertzelBank::makeTrigTable();
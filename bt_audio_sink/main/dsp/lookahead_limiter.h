@@ -0,0 +1,215 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Lookahead true-peak limiter (stereo linked)
+// - Output is delayed by the lookahead (APP_DSP_LIMITER_LOOKAHEAD_US)
+// - Peaks are taken per 16-frame sub-block, on the samples and on
+//   cubic midpoints between them (2x oversampled true-peak estimate)
+// - One gain node per sub-block: the lowest gain any sub-block in
+//   the window needs, ramped so the attack spreads over the whole
+//   lookahead; exponential release toward unity
+// - Gain is interpolated linearly between nodes. Both nodes around
+//   an output sub-block cover it, so the gain never exceeds what
+//   its samples need
+// - Final clamp at the ceiling stays as a safety net
+// - setTruePeak(false) drops the midpoints (sample peaks only) for a
+//   cheaper block under CPU pressure; the delay stays the same
+// Works on interleaved stereo float or fixed point (T = int32_t,
+// given the value of full scale); process<true>() limits the left
+// slots only (mono in a stereo block, APP_MONO_SPEAKER).
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include "fast_math.h"
+#include "../config/app_config.h"
+
+// Gain reduction since the last reset (for BLE)
+struct LimiterStats {
+    float minGain = 1.0f;       // Deepest reduction (linear)
+    uint32_t nodes = 0;         // Sub-blocks seen
+    uint32_t limiting = 0;      // Sub-blocks with gain below unity
+};
+
+template <typename T>
+class LookaheadLimiter {
+public:
+    static constexpr int SUB = 16;          // Frames per gain node
+    static constexpr int MAX_AHEAD = 10;    // Lookahead sub-blocks (2 ms at 96 kHz)
+    static constexpr int RING = 256;        // Delay frames, >= (MAX_AHEAD + 2) * SUB
+    static constexpr float THRESHOLD = 0.966f;  // -0.3 dBTP
+    static_assert((MAX_AHEAD + 2) * SUB <= RING, "limiter delay ring too short");
+
+    // fullScale: value of 1.0 in T units
+    void init(uint32_t sampleRate, float fullScale) {
+        const float fs = sampleRate > 0 ? (float)sampleRate : (float)APP_I2S_DEFAULT_SR;
+        int ahead = (int)(m_lookaheadUs * 1e-6f * fs / SUB + 0.5f) - 2;
+        if (ahead < 1) ahead = 1;
+        if (ahead > MAX_AHEAD) ahead = MAX_AHEAD;
+        m_ahead = ahead;
+        m_delay = (uint32_t)((ahead + 2) * SUB);
+        for (int d = 1; d <= ahead; d++) m_ramp[d] = (float)d / (float)(ahead + 1);
+
+        const float releaseSubs = APP_DSP_LIMITER_RELEASE_MS * 0.001f * fs / SUB;
+        m_relCoef = 1.0f - expf(-fast_recipsf2(releaseSubs > 1.0f ? releaseSubs : 1.0f));
+        m_threshold = m_thresholdFrac * fullScale;
+        m_ceiling = fullScale;
+        reset();
+    }
+
+    void reset() {
+        memset(m_line, 0, sizeof(m_line));
+        memset(m_hist, 0, sizeof(m_hist));
+        for (int i = 0; i < MAX_AHEAD + 2; i++) m_req[i] = 1.0f;
+        m_reqPos = 0;
+        m_w = 0;
+        m_count = 0;
+        m_subPeak = 0.0f;
+        m_node = m_gain = 1.0f;
+        m_step = 0.0f;
+    }
+
+    // Latency in frames
+    uint32_t delay() const { return m_delay; }
+
+    // Lookahead for the next init() (0 = APP_DSP_LIMITER_LOOKAHEAD_US)
+    void setLookaheadUs(uint32_t us) { m_lookaheadUs = us ? us : APP_DSP_LIMITER_LOOKAHEAD_US; }
+
+    // Threshold as a fraction of full scale (any task, taken at the next
+    // sub-block; kept across init)
+    void setThreshold(float fraction) {
+        m_thresholdFrac = fraction;
+        m_threshold = fraction * m_ceiling;
+    }
+
+    // Interleaved stereo, in place (Mono: left slots only)
+    template <bool Mono = false>
+    void process(T* buf, size_t frames) {
+        if (m_truePeak.load(std::memory_order_relaxed)) {
+            run<true, Mono>(buf, frames);
+        } else {
+            run<false, Mono>(buf, frames);
+        }
+    }
+
+    // Midpoint (true-peak) detection on or off (any task, next block)
+    void setTruePeak(bool on) { m_truePeak.store(on, std::memory_order_relaxed); }
+
+    // Reader side (any task)
+    float currentGain() const { return m_node; }
+    void snapshot(LimiterStats& out) const { memcpy(&out, &m_stats, sizeof(out)); }
+    void resetStats() { m_statsReset.store(true, std::memory_order_release); }
+
+private:
+    template <bool TruePeak, bool Mono>
+    void run(T* buf, size_t frames) {
+        constexpr uint32_t MASK = RING - 1;
+        const float ceil = m_ceiling;
+        for (size_t i = 0; i < frames; i++) {
+            const T L = buf[2 * i];
+            const T R = Mono ? L : buf[2 * i + 1];
+
+            // Sample and midpoint (between the two previous samples) peaks
+            const float fl = (float)L, fr = (float)R;
+            float pk = Mono ? fabsf(fl) : fmaxf(fabsf(fl), fabsf(fr));
+            if (TruePeak) {
+                const float midL = 0.5625f * (m_hist[0][1] + m_hist[0][2]) - 0.0625f * (m_hist[0][0] + fl);
+                m_hist[0][0] = m_hist[0][1]; m_hist[0][1] = m_hist[0][2]; m_hist[0][2] = fl;
+                pk = fmaxf(pk, fabsf(midL));
+                if (!Mono) {
+                    const float midR = 0.5625f * (m_hist[1][1] + m_hist[1][2]) - 0.0625f * (m_hist[1][0] + fr);
+                    m_hist[1][0] = m_hist[1][1]; m_hist[1][1] = m_hist[1][2]; m_hist[1][2] = fr;
+                    pk = fmaxf(pk, fabsf(midR));
+                }
+            }
+            if (pk > m_subPeak) m_subPeak = pk;
+
+            // Delay line
+            const uint32_t w = m_w & MASK;
+            const uint32_t r = (m_w - m_delay) & MASK;
+            const T dl = m_line[2 * r];
+            const T dr = Mono ? dl : m_line[2 * r + 1];
+            m_line[2 * w] = L;
+            if (!Mono) m_line[2 * w + 1] = R;
+            m_w++;
+
+            if (m_gain >= 1.0f && m_step == 0.0f) {
+                buf[2 * i] = dl;
+                if (!Mono) buf[2 * i + 1] = dr;
+            } else {
+                buf[2 * i] = clampOut((float)dl * m_gain, ceil);
+                if (!Mono) buf[2 * i + 1] = clampOut((float)dr * m_gain, ceil);
+                m_gain += m_step;
+            }
+
+            if (++m_count == SUB) {
+                m_count = 0;
+                nextNode();
+            }
+        }
+    }
+
+    static inline T clampOut(float v, float ceil) {
+        if (v > ceil) v = ceil;
+        if (v < -ceil) v = -ceil;
+        return (T)v;
+    }
+
+    // Sub-block complete: queue its requirement, compute the next node
+    void nextNode() {
+        const float req = (m_subPeak > m_threshold) ? m_threshold / m_subPeak : 1.0f;
+        m_subPeak = 0.0f;
+        const int n = m_ahead + 2;
+        m_req[m_reqPos] = req;
+        m_reqPos = (m_reqPos + 1 == n) ? 0 : m_reqPos + 1;
+
+        // Oldest entry is the sub-block before the one this node starts;
+        // later ones are allowed proportionally more gain (attack ramp)
+        float node = m_node + (1.0f - m_node) * m_relCoef;
+        int idx = m_reqPos;
+        for (int j = 0; j < n; j++) {
+            const float q = m_req[idx];
+            const int dist = j - 1;
+            const float allowed = (dist <= 0) ? q : q + (1.0f - q) * m_ramp[dist];
+            if (allowed < node) node = allowed;
+            idx = (idx + 1 == n) ? 0 : idx + 1;
+        }
+        if (node > 0.99999f) node = 1.0f;
+
+        m_gain = m_node;
+        m_step = (node - m_node) * (1.0f / SUB);
+        m_node = node;
+
+        if (m_statsReset.exchange(false, std::memory_order_acquire)) {
+            m_stats = LimiterStats();
+        }
+        m_stats.nodes++;
+        if (node < 1.0f) m_stats.limiting++;
+        if (node < m_stats.minGain) m_stats.minGain = node;
+    }
+
+    T m_line[2 * RING];
+    float m_hist[2][3];         // Last three inputs per channel (for midpoints)
+    float m_req[MAX_AHEAD + 2]; // Required gain per sub-block, FIFO
+    float m_ramp[MAX_AHEAD + 1] = {};
+    int m_reqPos = 0;
+    int m_ahead = 1;
+    uint32_t m_delay = 3 * SUB;
+    uint32_t m_w = 0;
+    int m_count = 0;
+    float m_subPeak = 0.0f;
+    float m_threshold = THRESHOLD;
+    float m_thresholdFrac = THRESHOLD;
+    float m_ceiling = 1.0f;
+    float m_relCoef = 0.01f;
+    uint32_t m_lookaheadUs = APP_DSP_LIMITER_LOOKAHEAD_US;
+    float m_node = 1.0f;
+    float m_gain = 1.0f;
+    float m_step = 0.0f;
+
+    LimiterStats m_stats;
+    std::atomic<bool> m_statsReset{false};
+    std::atomic<bool> m_truePeak{true};
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Loudness compensation table
+// The bass compensation shelf depends only on the volume (0-127, the
+// AVRCP range) and the sample rate, so all 128 designs for the current
+// rate are computed once when the rate changes and setVolume() becomes
+// a table lookup instead of powf/sqrtf/sinf/cosf. The tone chain ramps
+// to each new design over one block, so volume sweeps stay click-free.
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include "biquad.h"
+
+class LoudnessTable {
+public:
+    static constexpr int STEPS = 128;
+    static constexpr float SHELF_HZ = 100.0f;
+    static constexpr float MAX_DB = 5.0f;   // At volume 0
+
+    // Boost for a volume: 0 dB at 127, rising with the square of the
+    // distance from it (~1.25 dB at half volume)
+    static float compensationDB(uint8_t volume) {
+        const float factor = 1.0f - (float)volume * (1.0f / 127.0f);
+        return MAX_DB * factor * factor;
+    }
+
+    static void design(Biquad& out, float fs, uint8_t volume) {
+        out.makeLowShelf(fs, SHELF_HZ, compensationDB(volume));
+    }
+
+    // Design every step for sampleRate, unless already done
+    void build(uint32_t sampleRate) {
+        if (sampleRate == 0 || sampleRate == m_rate) return;
+        const float fs = (float)sampleRate;
+        Biquad b;
+        for (int v = 0; v < STEPS; v++) {
+            design(b, fs, (uint8_t)v);
+            m_table[v] = {b.b0, b.b1, b.b2, b.a1, b.a2};
+        }
+        m_rate = sampleRate;
+    }
+
+    // Lookup; falls back to designing for another rate
+    void get(Biquad& out, uint8_t volume, uint32_t sampleRate) const {
+        if (sampleRate != m_rate || volume >= STEPS) {
+            design(out, (float)sampleRate, volume);
+            return;
+        }
+        const Coeffs& c = m_table[volume];
+        out.b0 = c.b0;
+        out.b1 = c.b1;
+        out.b2 = c.b2;
+        out.a1 = c.a1;
+        out.a2 = c.a2;
+    }
+
+private:
+    struct Coeffs {
+        float b0, b1, b2, a1, a2;
+    };
+
+    uint32_t m_rate = 0;
+    Coeffs m_table[STEPS];
+};
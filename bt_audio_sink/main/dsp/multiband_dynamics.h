@@ -0,0 +1,221 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Multiband dynamics - 3-band compressor for small enclosures
+// - Bands from a BandSplit (band_split.h) at 150 Hz and 2.5 kHz;
+//   with every gain at unity they sum back to the input exactly
+// - Stereo-linked band peaks per CONTROL frames; one-pole attack/
+//   release and the gain computer run at that rate only
+// - Each band gain ramps linearly over the next CONTROL frames and
+//   is applied in the recombine,
+//       out = g2 x + (g1 - g2) lp1 + (g0 - g1) lp0
+//   three multiplies a sample and no band buffers
+// - Presets hold per-band thresholds and ratios; only the index is
+//   saved (settings blob). Off skips the stage; switching on starts
+//   from unity, so there is no step.
+// Works on interleaved stereo float or fixed point (T = int32_t,
+// given the float conversion factors), like FirConvolver;
+// process<true>() only the left slots (APP_MONO_SPEAKER).
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <math.h>
+#include <atomic>
+#include <type_traits>
+#include "fast_math.h"
+#include "band_split.h"
+#include "../config/app_config.h"
+
+struct DynamicsPreset {
+    const char* name;
+    float thresholdDB[3];       // Low, mid, high (dBFS)
+    float ratio[3];
+    float attackMs;
+    float releaseMs;
+};
+
+class MultibandDynamics {
+public:
+    static constexpr int BANDS = 3;
+    static constexpr size_t BLOCK = 256;            // Frames per split
+    static constexpr int CONTROL = 16;              // Frames per gain step
+    static constexpr float CROSSOVER_LOW = 150.0f;
+    static constexpr float CROSSOVER_HIGH = 2500.0f;
+
+    enum Preset : uint8_t { OFF = 0, GENTLE, SMALL, TINY, PRESET_COUNT };
+
+    static const DynamicsPreset& preset(uint8_t id) {
+        static const DynamicsPreset TABLE[PRESET_COUNT] = {
+            { "off",    {  0.0f,   0.0f,  0.0f }, { 1.0f, 1.0f, 1.0f }, 10.0f, 150.0f },
+            { "gentle", {-12.0f,  -6.0f, -6.0f }, { 2.0f, 2.0f, 2.0f }, 10.0f, 150.0f },
+            { "small",  {-18.0f,  -9.0f, -6.0f }, { 4.0f, 2.5f, 2.0f },  5.0f, 120.0f },
+            { "tiny",   {-24.0f, -12.0f, -8.0f }, { 8.0f, 3.0f, 2.0f },  3.0f, 100.0f },
+        };
+        return TABLE[id < PRESET_COUNT ? id : OFF];
+    }
+
+    // Control task, stream paused (as for the other stages)
+    void init(uint32_t sampleRate) {
+        m_sampleRate = sampleRate > 0 ? (float)sampleRate : (float)APP_I2S_DEFAULT_SR;
+        const float crossovers[] = { CROSSOVER_LOW, CROSSOVER_HIGH };
+        m_split.init(crossovers, m_sampleRate);
+        m_active = PRESET_COUNT;    // Coefficients again on the next block
+        reset();
+    }
+
+    void reset() {
+        m_split.reset();
+        for (int b = 0; b < BANDS; b++) {
+            m_env[b] = 0.0f;
+            m_peak[b] = 0.0f;
+            m_gain[b] = 1.0f;
+            m_step[b] = 0.0f;
+        }
+        m_phase = 0;
+    }
+
+    // Any task; taken at the next block. False for an unknown preset.
+    bool setPreset(uint8_t id) {
+        if (id >= PRESET_COUNT) return false;
+        m_request.store(id, std::memory_order_relaxed);
+        return true;
+    }
+    uint8_t getPreset() const { return m_request.load(std::memory_order_relaxed); }
+
+    // Audio task: interleaved stereo in place (Mono: left slots only).
+    // toFloat/fromFloat convert T to and from the float full scale
+    // (1.0 / 1.0 for float).
+    template <bool Mono = false, typename T>
+    void process(T* buf, size_t frames, float toFloat, float fromFloat) {
+        const uint8_t id = m_request.load(std::memory_order_relaxed);
+        if (id != m_active) load(id);
+        if (m_active == OFF) return;
+        while (frames > 0) {
+            const size_t n = frames < BLOCK ? frames : BLOCK;
+            chunk<Mono>(buf, n, toFloat, fromFloat);
+            buf += 2 * n;
+            frames -= n;
+        }
+    }
+
+private:
+    static constexpr float DB_SCALE = 8.685889638f;     // 20/ln(10)
+
+    void load(uint8_t id) {
+        const DynamicsPreset& p = preset(id);
+        const float steps = m_sampleRate / (float)CONTROL;     // Control rate
+        m_attack = 1.0f - expf(-1000.0f / (p.attackMs * steps));
+        m_release = 1.0f - expf(-1000.0f / (p.releaseMs * steps));
+        for (int b = 0; b < BANDS; b++) {
+            m_thresholdDB[b] = p.thresholdDB[b];
+            m_slope[b] = 1.0f - fast_recipsf2(p.ratio[b]);
+        }
+        if (m_active == OFF || m_active == PRESET_COUNT) reset();
+        m_active = id;
+    }
+
+    // One gain node from the band peaks of the last CONTROL frames
+    void control() {
+        for (int b = 0; b < BANDS; b++) {
+            const float pk = m_peak[b];
+            m_peak[b] = 0.0f;
+            m_env[b] += (pk > m_env[b] ? m_attack : m_release) * (pk - m_env[b]);
+            float target = 1.0f;
+            if (m_env[b] > 1e-6f) {
+                const float over = DB_SCALE * fast_logf(m_env[b]) - m_thresholdDB[b];
+                if (over > 0.0f) target = expf(-over * m_slope[b] * (1.0f / DB_SCALE));
+            }
+            m_step[b] = (target - m_gain[b]) * (1.0f / (float)CONTROL);
+        }
+    }
+
+    template <bool Mono, typename T>
+    void chunk(T* buf, size_t n, float toFloat, float fromFloat) {
+        const float* x;
+        if (std::is_same<T, float>::value) {
+            x = (const float*)buf;
+        } else {
+            for (size_t i = 0; i < 2 * n; i++) m_x[i] = (float)buf[i] * toFloat;
+            x = m_x;
+        }
+        m_split.split<Mono>(x, n);
+        const float* lp0 = m_split.lowpass(0);
+        const float* lp1 = m_split.lowpass(1);
+
+        size_t i = 0;
+        while (i < n) {
+            if (m_phase == CONTROL) {
+                control();
+                m_phase = 0;
+            }
+            size_t m = (size_t)(CONTROL - m_phase);
+            if (m > n - i) m = n - i;
+            m_phase += (int)m;
+
+            float g0 = m_gain[0], g1 = m_gain[1], g2 = m_gain[2];
+            const float d0 = m_step[0], d1 = m_step[1], d2 = m_step[2];
+            float pk0 = m_peak[0], pk1 = m_peak[1], pk2 = m_peak[2];
+            for (size_t j = 2 * i; j < 2 * (i + m); j += 2) {
+                g0 += d0;
+                g1 += d1;
+                g2 += d2;
+                const float a = g2, b = g1 - g2, c = g0 - g1;
+                const float loL = lp0[j], lp1L = lp1[j], xL = x[j];
+                if (Mono) {
+                    pk0 = peak(pk0, loL);
+                    pk1 = peak(pk1, lp1L - loL);
+                    pk2 = peak(pk2, xL - lp1L);
+                    buf[j] = toSample<T>((a * xL + b * lp1L + c * loL) * fromFloat);
+                    continue;
+                }
+                const float loR = lp0[j + 1], lp1R = lp1[j + 1], xR = x[j + 1];
+                pk0 = peak(pk0, loL, loR);
+                pk1 = peak(pk1, lp1L - loL, lp1R - loR);
+                pk2 = peak(pk2, xL - lp1L, xR - lp1R);
+                buf[j] = toSample<T>((a * xL + b * lp1L + c * loL) * fromFloat);
+                buf[j + 1] = toSample<T>((a * xR + b * lp1R + c * loR) * fromFloat);
+            }
+            m_gain[0] = g0; m_gain[1] = g1; m_gain[2] = g2;
+            m_peak[0] = pk0; m_peak[1] = pk1; m_peak[2] = pk2;
+            i += m;
+        }
+    }
+
+    // Plain compares: fmaxf is a library call where NaNs must be handled
+    static inline float peak(float pk, float x) {
+        x = fabsf(x);
+        return x > pk ? x : pk;
+    }
+
+    static inline float peak(float pk, float l, float r) {
+        l = fabsf(l);
+        r = fabsf(r);
+        if (l > pk) pk = l;
+        if (r > pk) pk = r;
+        return pk;
+    }
+
+    template <typename T>
+    static inline T toSample(float v) {
+        if (std::is_floating_point<T>::value) return (T)v;
+        // Fixed point: keep within int32
+        if (v > 2147483520.0f) v = 2147483520.0f;
+        if (v < -2147483520.0f) v = -2147483520.0f;
+        return (T)v;
+    }
+
+    BandSplit<2, BLOCK> m_split;
+    float m_x[2 * BLOCK];               // Fixed-point input as float
+    float m_sampleRate = (float)APP_I2S_DEFAULT_SR;
+    float m_attack = 1.0f;
+    float m_release = 1.0f;
+    float m_thresholdDB[BANDS] = {};
+    float m_slope[BANDS] = {};          // 1 - 1/ratio
+    float m_env[BANDS] = {};
+    float m_peak[BANDS] = {};           // Of the current control step
+    float m_gain[BANDS] = {1.0f, 1.0f, 1.0f};
+    float m_step[BANDS] = {};           // Gain change per frame
+    int m_phase = 0;                    // Frames into the control step
+    uint8_t m_active = PRESET_COUNT;    // Loaded preset, PRESET_COUNT = none
+    std::atomic<uint8_t> m_request{APP_DSP_DYNAMICS_DEFAULT};
+};
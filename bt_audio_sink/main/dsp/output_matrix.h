@@ -0,0 +1,120 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Output fan-out for the aux I2S port (2.1, zone 2)
+// - Each aux slot (left/right word of the port) takes a role: off,
+//   sub (LR4 low-passed mono sum) or a full-range copy of the mains
+//   (zone left, right or mono)
+// - With a sub slot the mains are high-passed by the matching LR4
+//   pair (two cascaded Butterworth sections per side), so mains and
+//   sub sum flat and in phase
+// - Only what the layout uses runs: the low-pass once on the mono
+//   sum however many slots carry it, the high-pass only with a sub,
+//   zone slots are plain copies (6 biquad steps per frame at most)
+// - Works on the final Q31 output block (after slips, rate conversion
+//   and overlays), so both ports carry exactly the same frames
+// - Coefficients are designed only when the output rate changes
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include "biquad.h"
+#include "biquad_q31.h"
+
+enum OutputRole : uint8_t {
+    OUT_OFF = 0,
+    OUT_SUB,
+    OUT_ZONE_L,
+    OUT_ZONE_R,
+    OUT_ZONE_MONO,
+    OUT_ROLE_COUNT
+};
+
+class OutputMatrix {
+public:
+    static constexpr int SLOTS = 2;
+
+    // Design the crossover for an output rate (clears the state)
+    void configure(uint32_t sampleRate, float fc) {
+        Biquad lp, hp;
+        lp.makeLowPass((float)sampleRate, fc);
+        hp.makeHighPass((float)sampleRate, fc);
+        for (int s = 0; s < 2; s++) {
+            m_lp[s].set(lp);
+            m_hpL[s].set(hp);
+            m_hpR[s].set(hp);
+        }
+        m_sampleRate = sampleRate;
+        reset();
+    }
+
+    uint32_t getSampleRate() const { return m_sampleRate; }
+
+    // Roles of the aux port's left and right slot. Filters that start
+    // running begin from rest.
+    void setLayout(OutputRole left, OutputRole right) {
+        if (left == m_role[0] && right == m_role[1]) return;
+        m_role[0] = left;
+        m_role[1] = right;
+        reset();
+    }
+
+    OutputRole getRole(int slot) const { return m_role[slot]; }
+
+    void reset() {
+        for (int s = 0; s < 2; s++) {
+            m_lp[s].reset();
+            m_hpL[s].reset();
+            m_hpR[s].reset();
+        }
+    }
+
+    // Fill the interleaved aux block from the finished mains, then
+    // high-pass the mains in place when a slot carries the sub.
+    // Roles are dispatched once per block, filters run section-major.
+    void process(int32_t* mains, int32_t* aux, size_t frames) {
+        int subSlot = -1;
+        for (int s = 0; s < SLOTS; s++) {
+            int32_t* out = aux + s;
+            switch (m_role[s]) {
+                case OUT_ZONE_L:
+                    for (size_t i = 0; i < frames; i++) out[2 * i] = mains[2 * i];
+                    break;
+                case OUT_ZONE_R:
+                    for (size_t i = 0; i < frames; i++) out[2 * i] = mains[2 * i + 1];
+                    break;
+                case OUT_SUB:
+                    // A second sub slot is copied from the first below
+                    if (subSlot >= 0) break;
+                    subSlot = s;
+                    [[fallthrough]];   // The low-pass runs on the mono sum
+                case OUT_ZONE_MONO:
+                    for (size_t i = 0; i < frames; i++) {
+                        out[2 * i] = (mains[2 * i] >> 1) + (mains[2 * i + 1] >> 1);
+                    }
+                    break;
+                default:
+                    for (size_t i = 0; i < frames; i++) out[2 * i] = 0;
+                    break;
+            }
+        }
+        if (subSlot < 0) return;
+
+        int32_t* sub = aux + subSlot;
+        for (int s = 0; s < 2; s++) {
+            m_lp[s].processBlock(sub, frames, 2);
+            m_hpL[s].processBlock(mains, frames, 2);
+            m_hpR[s].processBlock(mains + 1, frames, 2);
+        }
+        if (m_role[0] == OUT_SUB && m_role[1] == OUT_SUB) {
+            for (size_t i = 0; i < frames; i++) aux[2 * i + 1] = aux[2 * i];
+        }
+    }
+
+private:
+    BiquadQ31 m_lp[2];      // Sub: mono sum, once
+    BiquadQ31 m_hpL[2];     // Mains, only with a sub
+    BiquadQ31 m_hpR[2];
+    OutputRole m_role[SLOTS] = {OUT_SUB, OUT_SUB};
+    uint32_t m_sampleRate = 0;
+};
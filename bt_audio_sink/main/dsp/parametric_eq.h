@@ -0,0 +1,210 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Parametric EQ - up to APP_PEQ_BANDS bands for room correction
+// - Peaking (with Q), low shelf and high shelf bands
+// - Runs on a BiquadCascade: disabled bands are skipped, changes
+//   crossfade over one block, so bands can be edited live
+// - Q31 mirror for the fixed-point path
+// - Cycles per block are measured and compared with a per-frame
+//   budget (APP_PEQ_CYCLE_BUDGET) for the BLE status
+// Band wire format (BLE and NVS), 7 bytes:
+//   [flags, freq u16, gain i16 (0.1 dB), q u16 (x100)] LE
+//   flags: bit 7 = enabled, bits 0-1 = type
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "esp_cpu.h"
+#include "biquad.h"
+#include "biquad_cascade.h"
+#if APP_DSP_Q31_PATH
+#include "biquad_q31.h"
+#endif
+#include "../config/app_config.h"
+
+struct PeqBand {
+    uint8_t type = 0;           // ParametricEq::Type
+    bool enabled = false;
+    uint16_t freqHz = 1000;
+    int16_t gainTenthDB = 0;
+    uint16_t q100 = 141;        // Peaking only; shelves use a fixed slope
+};
+
+// Measured cost of the last block and the worst block since reset
+struct PeqLoad {
+    uint32_t cycles = 0;            // Last block
+    uint32_t frames = 0;
+    uint32_t peakPerFrame = 0;      // Worst cycles per frame
+};
+
+class ParametricEq {
+public:
+    static constexpr int MAX_BANDS = APP_PEQ_BANDS;
+    static constexpr size_t BAND_BYTES = 7;
+    static constexpr size_t BLOB_BYTES = 1 + MAX_BANDS * BAND_BYTES;
+    static constexpr int16_t MAX_GAIN_TENTH_DB = 150;   // +/-15 dB
+    static constexpr uint16_t MIN_Q100 = 10;            // 0.1 .. 10
+    static constexpr uint16_t MAX_Q100 = 1000;
+    enum Type : uint8_t { PEAK = 0, LOW_SHELF, HIGH_SHELF, NUM_TYPES };
+
+    ParametricEq() {
+        // Disabled octave-spaced peaking bands as a starting point
+        uint32_t f = 31;
+        for (int i = 0; i < MAX_BANDS; i++) {
+            m_bands[i].freqHz = (uint16_t)f;
+            f = (f * 2 > 16000) ? 16000 : f * 2;
+        }
+    }
+
+    // Redesign every band for a new rate and clear the filter state
+    void setSampleRate(uint32_t sampleRate) {
+        if (sampleRate == 0) return;
+        m_sampleRate = sampleRate;
+        for (int i = 0; i < MAX_BANDS; i++) post(i);
+        reset();
+    }
+
+    void reset() {
+        m_cascade.reset();
+#if APP_DSP_Q31_PATH
+        m_cascadeQ31.reset();
+#endif
+        m_ran = false;
+        m_resetLoad = true;
+    }
+
+    // Any task. Out-of-range values are clamped; false for a bad index/type.
+    bool setBand(int index, const PeqBand& band) {
+        if (index < 0 || index >= MAX_BANDS || band.type >= NUM_TYPES) return false;
+        PeqBand b = band;
+        if (b.freqHz < 20) b.freqHz = 20;
+        if (b.freqHz > 20000) b.freqHz = 20000;
+        if (b.gainTenthDB > MAX_GAIN_TENTH_DB) b.gainTenthDB = MAX_GAIN_TENTH_DB;
+        if (b.gainTenthDB < -MAX_GAIN_TENTH_DB) b.gainTenthDB = -MAX_GAIN_TENTH_DB;
+        if (b.q100 < MIN_Q100) b.q100 = MIN_Q100;
+        if (b.q100 > MAX_Q100) b.q100 = MAX_Q100;
+        m_bands[index] = b;
+        post(index);
+        return true;
+    }
+
+    const PeqBand& band(int index) const { return m_bands[index]; }
+
+    int activeBands() const {
+        int n = 0;
+        for (int i = 0; i < MAX_BANDS; i++) n += m_cascade.isActive(i) ? 1 : 0;
+        return n;
+    }
+
+    static bool decodeBand(const uint8_t* p, size_t len, PeqBand& out) {
+        if (len < BAND_BYTES) return false;
+        out.enabled = (p[0] & 0x80) != 0;
+        out.type = p[0] & 0x03;
+        out.freqHz = (uint16_t)(p[1] | (p[2] << 8));
+        out.gainTenthDB = (int16_t)(p[3] | (p[4] << 8));
+        out.q100 = (uint16_t)(p[5] | (p[6] << 8));
+        return out.type < NUM_TYPES;
+    }
+
+    static void encodeBand(const PeqBand& b, uint8_t* p) {
+        p[0] = (uint8_t)((b.enabled ? 0x80 : 0) | (b.type & 0x03));
+        p[1] = (uint8_t)b.freqHz;
+        p[2] = (uint8_t)(b.freqHz >> 8);
+        p[3] = (uint8_t)b.gainTenthDB;
+        p[4] = (uint8_t)((uint16_t)b.gainTenthDB >> 8);
+        p[5] = (uint8_t)b.q100;
+        p[6] = (uint8_t)(b.q100 >> 8);
+    }
+
+    // All bands: [count, band...]; returns bytes written (0 if cap too small)
+    size_t serialize(uint8_t* out, size_t cap) const {
+        if (cap < BLOB_BYTES) return 0;
+        out[0] = (uint8_t)MAX_BANDS;
+        for (int i = 0; i < MAX_BANDS; i++) encodeBand(m_bands[i], out + 1 + i * BAND_BYTES);
+        return BLOB_BYTES;
+    }
+
+    // Inverse of serialize; a blob from a build with more bands is truncated
+    bool deserialize(const uint8_t* in, size_t len) {
+        if (len < 1 || len < 1 + (size_t)in[0] * BAND_BYTES) return false;
+        const int n = in[0] < MAX_BANDS ? in[0] : MAX_BANDS;
+        for (int i = 0; i < n; i++) {
+            PeqBand b;
+            if (decodeBand(in + 1 + i * BAND_BYTES, BAND_BYTES, b)) setBand(i, b);
+        }
+        return true;
+    }
+
+    // Audio task: interleaved stereo in place (Mono: left slots only)
+    template <bool Mono = false>
+    void process(float* buf, size_t frames) {
+        const bool active = m_cascade.anyActive();
+        if (!active && !m_ran) return;  // Keeps running one block to fade out
+        m_ran = active;
+        const uint32_t t0 = esp_cpu_get_cycle_count();
+        m_cascade.process<Mono>(buf, frames);
+        record(esp_cpu_get_cycle_count() - t0, frames);
+    }
+
+    // No band enabled and the last fade out done (audio task)
+    bool isFlat() const { return !m_ran && !m_cascade.anyActive(); }
+
+#if APP_DSP_Q31_PATH
+    // Same on the internal Q27 format (no crossfade in the Q31 cascade)
+    void processQ31(int32_t* buf, size_t frames) {
+        if (!m_cascade.anyActive()) return;
+        const uint32_t t0 = esp_cpu_get_cycle_count();
+        m_cascadeQ31.process(buf, frames);
+        record(esp_cpu_get_cycle_count() - t0, frames);
+    }
+#endif
+
+    // Reader side (any task)
+    void load(PeqLoad& out) const { memcpy(&out, &m_load, sizeof(out)); }
+    void resetLoad() { m_resetLoad = true; }
+    static constexpr uint32_t budgetPerFrame() { return APP_PEQ_CYCLE_BUDGET; }
+
+private:
+    void post(int i) {
+        if (m_sampleRate == 0) return;
+        const PeqBand& b = m_bands[i];
+        const float fs = (float)m_sampleRate;
+        // Bands at or above ~Nyquist cannot be realised; leave them out
+        const bool usable = b.enabled && b.gainTenthDB != 0 && (float)b.freqHz < 0.45f * fs;
+        Biquad d;
+        if (usable) {
+            const float gain = (float)b.gainTenthDB * 0.1f;
+            switch (b.type) {
+                case LOW_SHELF:  d.makeLowShelf(fs, (float)b.freqHz, gain); break;
+                case HIGH_SHELF: d.makeHighShelf(fs, (float)b.freqHz, gain); break;
+                default:         d.makePeakingEQ(fs, (float)b.freqHz, (float)b.q100 * 0.01f, gain); break;
+            }
+        }
+        m_cascade.setSection(i, d, usable);
+#if APP_DSP_Q31_PATH
+        m_cascadeQ31.setSection(i, d, usable);
+#endif
+    }
+
+    void record(uint32_t cycles, size_t frames) {
+        if (m_resetLoad) {
+            m_resetLoad = false;
+            m_load.peakPerFrame = 0;
+        }
+        m_load.cycles = cycles;
+        m_load.frames = (uint32_t)frames;
+        const uint32_t perFrame = frames ? cycles / (uint32_t)frames : 0;
+        if (perFrame > m_load.peakPerFrame) m_load.peakPerFrame = perFrame;
+    }
+
+    PeqBand m_bands[MAX_BANDS];
+    uint32_t m_sampleRate = 0;
+    BiquadCascade<MAX_BANDS> m_cascade;
+#if APP_DSP_Q31_PATH
+    BiquadCascadeQ31<MAX_BANDS> m_cascadeQ31;
+#endif
+    bool m_ran = false;
+    PeqLoad m_load;
+    volatile bool m_resetLoad = false;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+// -----------------------------------------------------------
+// 3-Band Peak Meter for 30Hz, 60Hz, 100Hz display
+// - 3 LP filters at different cutoffs to capture each sub-bass band
+//   (one OnePoleBank, see band_split.h)
+// - Instant attack, smooth release for punchy visual response
+// - Ultra-lightweight: just 3 parallel 1-pole LP filters
+// -----------------------------------------------------------
+
+#include <math.h>
+#include "fast_math.h"
+#include "band_split.h"
+#include "../config/app_config.h"
+
+struct PeakMeter {
+    static constexpr int NUM_BANDS = 3;  // 30Hz, 60Hz, 100Hz
+    
+    // Release envelope
+    float releaseCoef = 0.0f;
+    float releaseCoefInv = 0.0f;
+    
+    // LP cutoffs ~45Hz, ~80Hz, ~120Hz
+    OnePoleBank<1, NUM_BANDS> bank;
+    float envelope[NUM_BANDS] = {};
+    
+    // Pre-computed constant for dB conversion
+    static constexpr float DB_SCALE = 8.685889638f;  // 20/ln(10)
+    
+    void init(float sampleRate) {
+        if (sampleRate <= 0) sampleRate = 44100.0f;
+        
+        // Release time ~50ms for smooth response
+        float releaseMs = 50.0f;
+        float releaseSamples = releaseMs * 0.001f * sampleRate;
+        releaseCoef = expf(-fast_recipsf2(releaseSamples));
+        releaseCoefInv = 1.0f - releaseCoef;
+        
+        const float cutoffs[NUM_BANDS] = { 45.0f, 80.0f, 120.0f };
+        bank.init(cutoffs, sampleRate);
+        
+        zero();
+    }
+    
+    // Process with 3 LP filters for 30Hz, 60Hz, 100Hz bands
+    inline void process(float x) {
+        bank.process(0, x);
+        for (int b = 0; b < NUM_BANDS; b++) {
+            const float lp = bank.lowpass(b, 0);
+            const float a = lp >= 0.0f ? lp : -lp;
+            if (a > envelope[b]) {
+                envelope[b] = a;
+            } else {
+                envelope[b] = releaseCoef * envelope[b] + releaseCoefInv * a;
+            }
+        }
+    }
+    
+    // Get dB for band: 0=30Hz, 1=60Hz, 2=100Hz
+    float getDB(int band) const {
+        float lin = getLin(band);
+        
+        if (lin < 1e-6f) return -60.0f;
+        float dB = DB_SCALE * fast_logf(lin);
+        if (dB < -60.0f) return -60.0f;
+        if (dB > 0.0f) return 0.0f;
+        return dB;
+    }
+    
+    float getLin(int band) const {
+        if (band < 0) band = 0;
+        if (band >= NUM_BANDS) band = NUM_BANDS - 1;
+        return envelope[band];
+    }
+    
+    void zero() {
+        bank.reset();
+        for (int b = 0; b < NUM_BANDS; b++) envelope[b] = 0.0f;
+    }
+};
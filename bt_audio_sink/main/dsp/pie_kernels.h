@@ -0,0 +1,192 @@
+#pragma once
+
+/*
+ * pie_kernels.h
+ *
+ * ESP32-S3 PIE (128-bit SIMD) versions of the integer inner loops that
+ * map onto it bit for bit, selected at compile time by APP_DSP_SIMD:
+ *
+ *   vec_shl_s32          - S24_IN_32 -> Q31 (<< 8)
+ *   vec_sra_s32          - Q31 -> internal Q27 headroom (>> 4)
+ *   vec_within_s32       - silence gate scan of a Q31 block
+ *   vec_scale_u16        - LED 8.8 framebuffer fade, (v * scale) >> 8
+ *
+ * Each has a scalar *_ref twin with the exact semantics; that is what the
+ * other targets run, and what the benchmark's simd suite checks the PIE
+ * code against. PIE is integer only (8/16/32-bit lanes, no 32x32
+ * multiply), so the float and Q31 biquads, the float converters and the
+ * overlay mixer's 64-bit MACs stay scalar.
+ *
+ * The vector loops work on 16-byte aligned memory: a scalar head runs up
+ * to the first aligned element and a scalar tail finishes the block. A
+ * copy whose source and destination are not equally misaligned runs
+ * scalar. The q registers are the task's coprocessor state, saved by the
+ * kernel on a switch like the FPU's.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../config/app_config.h"
+
+static inline void vec_shl_s32_ref(int32_t* dst, const int32_t* src, size_t n, int shift) {
+    for (size_t i = 0; i < n; i++) dst[i] = (int32_t)((uint32_t)src[i] << shift);
+}
+
+static inline void vec_sra_s32_ref(int32_t* buf, size_t n, int shift) {
+    for (size_t i = 0; i < n; i++) buf[i] >>= shift;
+}
+
+// True when every sample is strictly inside (-threshold, threshold)
+static inline bool vec_within_s32_ref(const int32_t* buf, size_t n, int32_t threshold) {
+    for (size_t i = 0; i < n; i++) {
+        if (buf[i] >= threshold || buf[i] <= -threshold) return false;
+    }
+    return true;
+}
+
+static inline void vec_scale_u16_ref(uint16_t* buf, size_t n, uint8_t scale) {
+    for (size_t i = 0; i < n; i++) buf[i] = (uint16_t)((buf[i] * scale) >> 8);
+}
+
+#if APP_DSP_SIMD
+
+// Elements before the first 16-byte boundary (at most n)
+template <typename T>
+static inline size_t vec_head(const T* p, size_t n) {
+    const size_t h = ((16 - ((uintptr_t)p & 15)) & 15) / sizeof(T);
+    return h < n ? h : n;
+}
+
+static inline void vec_shl_s32(int32_t* dst, const int32_t* src, size_t n, int shift) {
+    if (((uintptr_t)dst & 15) != ((uintptr_t)src & 15)) {
+        vec_shl_s32_ref(dst, src, n, shift);
+        return;
+    }
+    const size_t h = vec_head(src, n);
+    vec_shl_s32_ref(dst, src, h, shift);
+    const int32_t* s = src + h;
+    int32_t* d = dst + h;
+    uint32_t nv = (uint32_t)((n - h) / 4);
+    const size_t done = h + nv * 4;
+    if (nv) {
+        asm volatile(
+            "wsr.sar %[sh]\n"
+            "1:\n"
+            "ee.vld.128.ip q0, %[s], 16\n"
+            "ee.vsl.32 q0, q0\n"
+            "ee.vst.128.ip q0, %[d], 16\n"
+            "addi %[nv], %[nv], -1\n"
+            "bnez %[nv], 1b\n"
+            : [s] "+r"(s), [d] "+r"(d), [nv] "+r"(nv)
+            : [sh] "r"(shift)
+            : "memory");
+    }
+    vec_shl_s32_ref(dst + done, src + done, n - done, shift);
+}
+
+static inline void vec_sra_s32(int32_t* buf, size_t n, int shift) {
+    const size_t h = vec_head(buf, n);
+    vec_sra_s32_ref(buf, h, shift);
+    const int32_t* s = buf + h;
+    int32_t* d = buf + h;
+    uint32_t nv = (uint32_t)((n - h) / 4);
+    const size_t done = h + nv * 4;
+    if (nv) {
+        asm volatile(
+            "wsr.sar %[sh]\n"
+            "1:\n"
+            "ee.vld.128.ip q0, %[s], 16\n"
+            "ee.vsr.32 q0, q0\n"
+            "ee.vst.128.ip q0, %[d], 16\n"
+            "addi %[nv], %[nv], -1\n"
+            "bnez %[nv], 1b\n"
+            : [s] "+r"(s), [d] "+r"(d), [nv] "+r"(nv)
+            : [sh] "r"(shift)
+            : "memory");
+    }
+    vec_sra_s32_ref(buf + done, n - done, shift);
+}
+
+// Running lane max/min over the aligned part, reduced once at the end.
+// Music fails the check on its first samples, so those are looked at
+// before the vector scan, which pays off on quiet blocks.
+static inline bool vec_within_s32(const int32_t* buf, size_t n, int32_t threshold) {
+    constexpr size_t EARLY = 16;
+    size_t h = EARLY < n ? EARLY : n;
+    h += vec_head(buf + h, n - h);
+    if (!vec_within_s32_ref(buf, h, threshold)) return false;
+    const int32_t* p = buf + h;
+    uint32_t nv = (uint32_t)((n - h) / 4);
+    const size_t done = h + nv * 4;
+    if (nv) {
+        alignas(16) int32_t lanes[8];     // max[4], min[4]
+        int32_t* out = lanes;
+        asm volatile(
+            "ee.vld.128.ip q0, %[p], 0\n"
+            "ee.vld.128.ip q1, %[p], 16\n"
+            "addi %[nv], %[nv], -1\n"
+            "beqz %[nv], 2f\n"
+            "1:\n"
+            "ee.vld.128.ip q2, %[p], 16\n"
+            "ee.vmax.s32 q0, q0, q2\n"
+            "ee.vmin.s32 q1, q1, q2\n"
+            "addi %[nv], %[nv], -1\n"
+            "bnez %[nv], 1b\n"
+            "2:\n"
+            "ee.vst.128.ip q0, %[o], 16\n"
+            "ee.vst.128.ip q1, %[o], 16\n"
+            : [p] "+r"(p), [nv] "+r"(nv), [o] "+r"(out)
+            :
+            : "memory");
+        for (int i = 0; i < 4; i++) {
+            if (lanes[i] >= threshold || lanes[4 + i] <= -threshold) return false;
+        }
+    }
+    return vec_within_s32_ref(buf + done, n - done, threshold);
+}
+
+// EE.VMUL.U16 shifts each 32-bit product right by SAR before keeping the
+// low 16 bits; with SAR = 8 that is the scalar expression exactly
+static inline void vec_scale_u16(uint16_t* buf, size_t n, uint8_t scale) {
+    const size_t h = vec_head(buf, n);
+    vec_scale_u16_ref(buf, h, scale);
+    const uint16_t* s = buf + h;
+    uint16_t* d = buf + h;
+    uint32_t nv = (uint32_t)((n - h) / 8);
+    const size_t done = h + nv * 8;
+    if (nv) {
+        const uint16_t factor = scale;
+        const uint16_t* fp = &factor;
+        asm volatile(
+            "movi.n a8, 8\n"
+            "wsr.sar a8\n"
+            "ee.vldbc.16 q1, %[f]\n"
+            "1:\n"
+            "ee.vld.128.ip q0, %[s], 16\n"
+            "ee.vmul.u16 q0, q0, q1\n"
+            "ee.vst.128.ip q0, %[d], 16\n"
+            "addi %[nv], %[nv], -1\n"
+            "bnez %[nv], 1b\n"
+            : [s] "+r"(s), [d] "+r"(d), [nv] "+r"(nv)
+            : [f] "r"(fp)
+            : "a8", "memory");
+    }
+    vec_scale_u16_ref(buf + done, n - done, scale);
+}
+
+#else
+
+static inline void vec_shl_s32(int32_t* dst, const int32_t* src, size_t n, int shift) {
+    vec_shl_s32_ref(dst, src, n, shift);
+}
+static inline void vec_sra_s32(int32_t* buf, size_t n, int shift) {
+    vec_sra_s32_ref(buf, n, shift);
+}
+static inline bool vec_within_s32(const int32_t* buf, size_t n, int32_t threshold) {
+    return vec_within_s32_ref(buf, n, threshold);
+}
+static inline void vec_scale_u16(uint16_t* buf, size_t n, uint8_t scale) {
+    vec_scale_u16_ref(buf, n, scale);
+}
+
+#endif
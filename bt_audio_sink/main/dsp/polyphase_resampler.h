@@ -0,0 +1,191 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Polyphase Resampler - windowed-sinc sample rate conversion
+// - TAPS-tap Kaiser-windowed sinc, tabulated at PHASES fractional
+//   positions; outputs between two table rows blend both rows
+// - Cutoff follows the lower of the two rates, so downsampling is
+//   band limited and upsampling does not leave images behind
+// - The position is an exact integer accumulator (input/output
+//   rate), so long streams never drift
+// - Block based, interleaved stereo out; mono or stereo in
+// - One table per cutoff: changing rates within a family (e.g.
+//   44.1 <-> 48 <-> 88.2 <-> 96 upwards) keeps the table
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <type_traits>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "../config/app_config.h"
+
+class PolyphaseResampler {
+public:
+    static constexpr int TAPS = 32;
+    static constexpr int PHASES = 64;
+    static constexpr float ROLLOFF = 0.90f;     // Passband edge / lower Nyquist
+    static constexpr float KAISER_BETA = 6.0f;  // ~60 dB stopband
+
+    PolyphaseResampler() { reset(); }
+    ~PolyphaseResampler() {
+        if (m_table) heap_caps_free(m_table);
+    }
+
+    PolyphaseResampler(const PolyphaseResampler&) = delete;
+    PolyphaseResampler& operator=(const PolyphaseResampler&) = delete;
+
+    // Not from the audio path of a running stream: may allocate and
+    // rebuild the table. History is kept, so a rate change mid-stream
+    // continues seamlessly; call reset() for a new stream.
+    bool init(uint32_t inRate, uint32_t outRate) {
+        if (inRate == 0 || outRate == 0) return false;
+        if (!m_table) {
+            const size_t bytes = (size_t)(PHASES + 1) * TAPS * sizeof(float);
+            m_table = (float*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (!m_table) m_table = (float*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+            if (!m_table) {
+                ESP_LOGE(TAG, "Table (%u bytes) allocation failed", (unsigned)bytes);
+                return false;
+            }
+        }
+        const float cutoff = ROLLOFF * (outRate < inRate ? (float)outRate / (float)inRate : 1.0f);
+        if (cutoff != m_cutoff) {
+            buildTable(cutoff);
+            m_cutoff = cutoff;
+        }
+        m_inRate = inRate;
+        m_outRate = outRate;
+        m_acc = 0;
+        return true;
+    }
+
+    // Start from silence
+    void reset() {
+        memset(m_hist, 0, sizeof(m_hist));
+        m_pos = 0;
+        m_acc = 0;
+    }
+
+    bool ready() const { return m_table && m_inRate; }
+    bool passthrough() const { return m_inRate == m_outRate; }
+    uint32_t inRate() const { return m_inRate; }
+    uint32_t outRate() const { return m_outRate; }
+
+    // Output frames that inFrames of input can produce at most
+    size_t maxOutput(size_t inFrames) const {
+        if (!m_inRate) return 0;
+        return (size_t)(((uint64_t)inFrames * m_outRate + m_inRate - 1) / m_inRate) + 1;
+    }
+
+    // Converts inFrames frames of inChannels (1 or 2) samples to
+    // interleaved stereo. Samples are scaled by inScale into float full
+    // scale and by outScale back out (integer outputs are clamped).
+    // Returns frames written; input past a full output is dropped, so
+    // size out with maxOutput().
+    template <typename In, typename Out>
+    size_t process(const In* in, size_t inFrames, int inChannels, float inScale,
+                   Out* out, size_t outCap, float outScale) {
+        if (!ready()) return 0;
+        const int step = inChannels == 1 ? 1 : 2;
+        size_t n = 0;
+        for (size_t i = 0; i < inFrames && n < outCap; i++) {
+            const float l = (float)in[i * step] * inScale;
+            const float r = (float)in[i * step + step - 1] * inScale;
+            m_hist[0][m_pos] = m_hist[0][m_pos + TAPS] = l;
+            m_hist[1][m_pos] = m_hist[1][m_pos + TAPS] = r;
+            if (++m_pos == TAPS) m_pos = 0;
+
+            // Every output that falls before the next input frame
+            while (m_acc < m_outRate && n < outCap) {
+                float yl, yr;
+                interpolate(yl, yr);
+                out[2 * n] = toSample<Out>(yl * outScale);
+                out[2 * n + 1] = toSample<Out>(yr * outScale);
+                n++;
+                m_acc += m_inRate;
+            }
+            // Short of output room the rest of this frame's outputs are lost
+            m_acc = (m_acc >= m_outRate) ? m_acc - m_outRate : 0;
+        }
+        return n;
+    }
+
+private:
+    static constexpr const char* TAG = "Resampler";
+
+    template <typename T>
+    static inline T toSample(float v) {
+        if (std::is_floating_point<T>::value) return (T)v;
+        // Sinc ringing can overshoot full scale
+        if (v > 2147483520.0f) v = 2147483520.0f;
+        if (v < -2147483520.0f) v = -2147483520.0f;
+        return (T)v;
+    }
+
+    // Zeroth-order modified Bessel function (Kaiser window)
+    static float besselI0(float x) {
+        float sum = 1.0f, term = 1.0f;
+        const float q = x * x * 0.25f;
+        for (int k = 1; k < 32; k++) {
+            term *= q / (float)(k * k);
+            sum += term;
+            if (term < sum * 1e-9f) break;
+        }
+        return sum;
+    }
+
+    // Row p holds the taps for an output p/PHASES past the centre
+    // frame (TAPS/2 frames behind the newest input); each row is
+    // normalised to unity DC gain
+    void buildTable(float cutoff) {
+        const float half = (float)(TAPS / 2);
+        const float norm = 1.0f / besselI0(KAISER_BETA);
+        for (int p = 0; p <= PHASES; p++) {
+            float* row = m_table + (size_t)p * TAPS;
+            const float mu = (float)p / (float)PHASES;
+            float sum = 0.0f;
+            for (int k = 0; k < TAPS; k++) {
+                const float x = (float)k - (half - 1.0f) - mu;
+                const float a = DSP_PI_F * cutoff * x;
+                const float sinc = (fabsf(a) < 1e-6f) ? 1.0f : sinf(a) / a;
+                const float w = x / half;
+                const float win = (fabsf(w) >= 1.0f) ? 0.0f
+                                  : besselI0(KAISER_BETA * sqrtf(1.0f - w * w)) * norm;
+                row[k] = cutoff * sinc * win;
+                sum += row[k];
+            }
+            const float g = 1.0f / sum;
+            for (int k = 0; k < TAPS; k++) row[k] *= g;
+        }
+    }
+
+    void interpolate(float& yl, float& yr) const {
+        // Phase from the accumulator: row index and blend between rows
+        const uint32_t scaled = m_acc * (uint32_t)PHASES;
+        const uint32_t p = scaled / m_outRate;
+        const float f = (float)(scaled - p * m_outRate) / (float)m_outRate;
+        const float* c0 = m_table + (size_t)p * TAPS;
+        const float* c1 = c0 + TAPS;
+        const float* xl = &m_hist[0][m_pos];   // Oldest to newest
+        const float* xr = &m_hist[1][m_pos];
+        float l0 = 0.0f, l1 = 0.0f, r0 = 0.0f, r1 = 0.0f;
+        for (int k = 0; k < TAPS; k++) {
+            l0 += xl[k] * c0[k];
+            l1 += xl[k] * c1[k];
+            r0 += xr[k] * c0[k];
+            r1 += xr[k] * c1[k];
+        }
+        yl = l0 + f * (l1 - l0);
+        yr = r0 + f * (r1 - r0);
+    }
+
+    float* m_table = nullptr;       // (PHASES + 1) x TAPS
+    float m_cutoff = 0.0f;
+    uint32_t m_inRate = 0;
+    uint32_t m_outRate = 0;
+    uint32_t m_acc = 0;             // Output position past the centre frame, in 1/outRate
+    float m_hist[2][2 * TAPS];      // Last TAPS frames per channel, mirrored
+    int m_pos = 0;
+};
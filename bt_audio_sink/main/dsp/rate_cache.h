@@ -0,0 +1,83 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Rate cache - per-sample-rate coefficient bundles
+// A Bundle holds what a DSP stage derives from the sample rate alone
+// (filter designs, lookup tables, time constants) and builds it in
+// build(rate). get() returns the bundle for a rate, building it the
+// first time that rate is seen; every later switch to it is a pointer
+// swap. Bundles are allocated as rates come up, PSRAM first; SLOTS
+// are kept with PSRAM (the four A2DP rates), INTERNAL_SLOTS without.
+// When all are taken the least recently used bundle is rebuilt.
+// Control task only (codec configuration, init).
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <new>
+#include "esp_heap_caps.h"
+
+template <typename Bundle, int SLOTS, int INTERNAL_SLOTS = 2>
+class RateCache {
+public:
+    static_assert(INTERNAL_SLOTS >= 1 && INTERNAL_SLOTS <= SLOTS, "bad rate cache slot counts");
+
+    RateCache() = default;
+    RateCache(const RateCache&) = delete;
+    RateCache& operator=(const RateCache&) = delete;
+
+    ~RateCache() {
+        for (int i = 0; i < SLOTS; i++) {
+            if (!m_slot[i]) continue;
+            m_slot[i]->~Bundle();
+            heap_caps_free(m_slot[i]);
+        }
+    }
+
+    // Bundle for sampleRate; null only when no slot could be allocated
+    const Bundle* get(uint32_t sampleRate) {
+        if (sampleRate == 0) return nullptr;
+        m_tick++;
+        for (int i = 0; i < SLOTS; i++) {
+            if (m_slot[i] && m_rate[i] == sampleRate) {
+                m_used[i] = m_tick;
+                return m_slot[i];
+            }
+        }
+        const int i = victim();
+        if (i < 0) return nullptr;
+        m_slot[i]->build(sampleRate);
+        m_rate[i] = sampleRate;
+        m_used[i] = m_tick;
+        m_builds++;
+        return m_slot[i];
+    }
+
+    // Bundles built so far (first use of a rate, or an evicted one again)
+    uint32_t builds() const { return m_builds; }
+
+private:
+    // A free slot (allocated here), else the least recently used one
+    int victim() {
+        const int limit = heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0 ? SLOTS : INTERNAL_SLOTS;
+        int lru = -1;
+        for (int i = 0; i < limit; i++) {
+            if (!m_slot[i]) {
+                void* p = heap_caps_malloc(sizeof(Bundle), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+                if (!p) p = heap_caps_malloc(sizeof(Bundle), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+                if (p) {
+                    m_slot[i] = new (p) Bundle();
+                    return i;
+                }
+                break;
+            }
+            if (lru < 0 || m_used[i] < m_used[lru]) lru = i;
+        }
+        return lru;
+    }
+
+    Bundle* m_slot[SLOTS] = {};
+    uint32_t m_rate[SLOTS] = {};
+    uint32_t m_used[SLOTS] = {};
+    uint32_t m_tick = 0;
+    uint32_t m_builds = 0;
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Spectrum Analyzer - real FFT on the decimated analysis signal
+// - Hann window over the last N samples (sliding, any hop)
+// - N-point real FFT as an N/2 complex radix-2 FFT + split
+// - Log-spaced bands from 30 Hz to 0.45 fs, each >= 1 bin
+// - Band level: sine amplitude equivalent (full scale = 1.0)
+// - Peak hold per band, then a smooth fall
+// Runs in the analysis task; nothing here touches audio_tx.
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <math.h>
+#include "fast_math.h"
+#include "../config/app_config.h"
+
+class SpectrumAnalyzer {
+public:
+    static constexpr int N = APP_SPECTRUM_FFT_N;
+    static constexpr int BANDS = APP_SPECTRUM_BANDS;
+    static constexpr float F_LO = 30.0f;
+    static_assert((N & (N - 1)) == 0 && N >= 64, "FFT size must be a power of two");
+    static_assert(BANDS > 0 && BANDS <= 32, "1-32 spectrum bands");
+
+    // frameMs: interval between compute() calls (peak hold timing)
+    void init(uint32_t sampleRate, uint32_t frameMs) {
+        if (!m_tablesReady) buildTables();
+        buildBands(sampleRate > 0 ? (float)sampleRate : 3000.0f);
+        m_holdFrames = (uint16_t)(PEAK_HOLD_MS / (frameMs ? frameMs : 1));
+        reset();
+    }
+
+    void reset() {
+        for (int i = 0; i < N; i++) m_hist[i] = 0.0f;
+        m_pos = 0;
+        for (int b = 0; b < BANDS; b++) {
+            m_level[b] = 0.0f;
+            m_peak[b] = 0.0f;
+            m_peakHold[b] = 0;
+        }
+    }
+
+    inline void push(float x) {
+        m_hist[m_pos] = x;
+        m_pos = (m_pos + 1) & (N - 1);
+    }
+
+    // Transform the newest N samples and update bands and peaks
+    void compute() {
+        // Window, oldest first, packed as z[n] = x[2n] + j x[2n+1]
+        for (int i = 0; i < N; i++) {
+            m_buf[i] = m_hist[(m_pos + i) & (N - 1)] * m_window[i];
+        }
+        fftHalf();
+
+        // Split into the one-sided spectrum (bin power, bins 1..N/2-1)
+        for (int k = 1; k < N / 2; k++) {
+            const float zr = m_buf[2 * k], zi = m_buf[2 * k + 1];
+            const float cr = m_buf[N - 2 * k], ci = -m_buf[N - 2 * k + 1];  // conj(Z[N/2-k])
+            const float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+            const float dr = 0.5f * (zr - cr), di = 0.5f * (zi - ci);
+            // Xo = -j * d; X = Xe + W^k Xo
+            const float or_ = di, oi = -dr;
+            const float wr = m_splitCos[k], wi = -m_splitSin[k];
+            const float xr = er + wr * or_ - wi * oi;
+            const float xi = ei + wr * oi + wi * or_;
+            m_power[k] = xr * xr + xi * xi;
+        }
+
+        for (int b = 0; b < BANDS; b++) {
+            float sum = 0.0f;
+            for (int k = m_bandLo[b]; k < m_bandHi[b]; k++) sum += m_power[k];
+            const float lin = sqrtf(sum * POWER_SCALE);
+            m_level[b] = lin;
+            if (lin >= m_peak[b]) {
+                m_peak[b] = lin;
+                m_peakHold[b] = m_holdFrames;
+            } else if (m_peakHold[b] > 0) {
+                m_peakHold[b]--;
+            } else {
+                m_peak[b] *= PEAK_FALL;
+                if (m_peak[b] < lin) m_peak[b] = lin;
+            }
+        }
+    }
+
+    float level(int band) const { return m_level[band]; }
+    float peak(int band) const { return m_peak[band]; }
+
+    // Bin power of the last compute(), bins 1..N/2-1; times binScale()
+    // it is the amplitude squared of a sine in that bin
+    const float* binPower() const { return m_power; }
+    static constexpr float binScale() { return POWER_SCALE; }
+
+private:
+    static constexpr uint32_t PEAK_HOLD_MS = 500;
+    static constexpr float PEAK_FALL = 0.9f;
+    // |X|^2 -> amplitude^2: Hann coherent gain (N/4)^2, ENBW 1.5 bins
+    static constexpr float POWER_SCALE = 16.0f / (1.5f * (float)N * (float)N);
+
+    void buildTables() {
+        for (int i = 0; i < N; i++) {
+            m_window[i] = 0.5f - 0.5f * cosf(2.0f * DSP_PI_F * (float)i / (float)N);
+        }
+        for (int k = 0; k < N / 2; k++) {
+            m_splitCos[k] = cosf(2.0f * DSP_PI_F * (float)k / (float)N);
+            m_splitSin[k] = sinf(2.0f * DSP_PI_F * (float)k / (float)N);
+        }
+        // Bit reversal for the N/2-point transform
+        const int h = N / 2;
+        int bits = 0;
+        while ((1 << bits) < h) bits++;
+        for (int i = 0; i < h; i++) {
+            int r = 0;
+            for (int b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits - 1 - b);
+            m_bitrev[i] = (uint16_t)r;
+        }
+        m_tablesReady = true;
+    }
+
+    void buildBands(float fs) {
+        const float binHz = fs / (float)N;
+        const float fHi = 0.45f * fs;
+        const float ratio = powf(fHi / F_LO, 1.0f / (float)BANDS);
+        const int maxBin = N / 2 - 1;
+        float f = F_LO;
+        int lo = (int)(F_LO / binHz + 0.5f);
+        if (lo < 1) lo = 1;
+        for (int b = 0; b < BANDS; b++) {
+            f *= ratio;
+            int hi = (int)(f / binHz + 0.5f);
+            if (hi <= lo) hi = lo + 1;  // At least one bin
+            if (hi > maxBin + 1) hi = maxBin + 1;
+            if (lo >= hi) lo = hi - 1;  // Out of bins: repeat the top one
+            m_bandLo[b] = (uint16_t)lo;
+            m_bandHi[b] = (uint16_t)hi;
+            lo = hi;
+        }
+    }
+
+    // In-place radix-2 DIT FFT of N/2 complex values in m_buf
+    void fftHalf() {
+        const int h = N / 2;
+        for (int i = 0; i < h; i++) {
+            const int j = m_bitrev[i];
+            if (j > i) {
+                float tr = m_buf[2 * i], ti = m_buf[2 * i + 1];
+                m_buf[2 * i] = m_buf[2 * j];
+                m_buf[2 * i + 1] = m_buf[2 * j + 1];
+                m_buf[2 * j] = tr;
+                m_buf[2 * j + 1] = ti;
+            }
+        }
+        for (int len = 2; len <= h; len <<= 1) {
+            const int half = len >> 1;
+            const int step = N / len;  // W_len^m = W_N^(m*step)
+            for (int start = 0; start < h; start += len) {
+                for (int m = 0; m < half; m++) {
+                    const float wr = m_splitCos[m * step], wi = -m_splitSin[m * step];
+                    float* a = &m_buf[2 * (start + m)];
+                    float* c = &m_buf[2 * (start + m + half)];
+                    const float tr = wr * c[0] - wi * c[1];
+                    const float ti = wr * c[1] + wi * c[0];
+                    c[0] = a[0] - tr;
+                    c[1] = a[1] - ti;
+                    a[0] += tr;
+                    a[1] += ti;
+                }
+            }
+        }
+    }
+
+    float m_hist[N] = {};
+    float m_buf[N];
+    float m_power[N / 2];
+    float m_window[N];
+    float m_splitCos[N / 2];
+    float m_splitSin[N / 2];
+    uint16_t m_bitrev[N / 2];
+    bool m_tablesReady = false;
+    uint32_t m_pos = 0;
+
+    uint16_t m_bandLo[BANDS];
+    uint16_t m_bandHi[BANDS];
+    float m_level[BANDS] = {};
+    float m_peak[BANDS] = {};
+    uint16_t m_peakHold[BANDS] = {};
+    uint16_t m_holdFrames = 0;
+};
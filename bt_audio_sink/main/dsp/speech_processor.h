@@ -0,0 +1,281 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Speech processor - uplink path of a hands-free call
+// Block-based: one call per mic block (an mSBC frame, 120 samples at
+// 16 kHz), in the order
+//   1. 100 Hz high-pass (mic DC and rumble)
+//   2. Echo canceller: NLMS FIR over the far-end reference, as played.
+//      The reference is pushed as it arrives from the phone and read back
+//      refDelay frames later, the playout delay the caller measured, so
+//      the filter only has to model the room and the uncertain part of
+//      that delay: with the delay a quarter filter short of the estimate
+//      the direct path lands early in the filter. Each block is filtered
+//      once as the filter stands to tell whether the near end talks
+//      (Geigel until converged, then the error against the echo return
+//      loss enhancement so far); adaptation, per sample, waits for a
+//      hangover after it.
+//   3. Wideband suppressor: one gain per block that takes out what the
+//      filter left of the echo and the noise floor between words (a gate,
+//      not a spectral noise reducer: noise under speech stays).
+// The reference ring is refilled by the downlink (any one task) and read
+// by process() (another); when the two drift apart by more than an
+// eighth of the filter, the read side is re-anchored to the delay.
+// Working buffers come from MemPlacement (DSP owner) at call start.
+// Cost: about three multiply-adds per tap and sample; setTaps() trades
+// echo tail for time.
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include "biquad.h"
+#include "fast_math.h"
+#include "../core/mem_placement.h"
+#include "../config/app_config.h"
+
+class SpeechProcessor {
+public:
+    static constexpr uint32_t REF_RING = 4096;     // Reference frames, power of two (256 ms at 16 kHz)
+
+    SpeechProcessor() = default;
+    SpeechProcessor(const SpeechProcessor&) = delete;
+    SpeechProcessor& operator=(const SpeechProcessor&) = delete;
+    ~SpeechProcessor() { deinit(); }
+
+    // Buffers for up to maxTaps and maxBlock frames per process()
+    bool init(uint32_t maxTaps, uint32_t maxBlock) {
+        deinit();
+        if (maxBlock > MAX_BLOCK) maxBlock = MAX_BLOCK;
+        m_maxTaps = maxTaps;
+        m_maxBlock = maxBlock;
+        m_w = (float*)MemPlacement::alloc("aec_w", MEM_OWNER_DSP, sizeof(float) * maxTaps, MEM_INTERNAL);
+        m_x = (float*)MemPlacement::alloc("aec_x", MEM_OWNER_DSP, sizeof(float) * (maxTaps + maxBlock),
+                                          MEM_INTERNAL);
+        m_ref = (int16_t*)MemPlacement::alloc("aec_ref", MEM_OWNER_DSP, sizeof(int16_t) * REF_RING, MEM_INTERNAL);
+        if (!m_w || !m_x || !m_ref) {
+            deinit();
+            return false;
+        }
+        m_taps = maxTaps;
+        return true;
+    }
+
+    void deinit() {
+        MemPlacement::release(m_w);
+        MemPlacement::release(m_x);
+        MemPlacement::release(m_ref);
+        m_w = m_x = nullptr;
+        m_ref = nullptr;
+    }
+
+    // New call: clear the filter, reference and gains
+    void begin(uint32_t sampleRate, uint32_t refDelayFrames) {
+        memset(m_w, 0, sizeof(float) * m_maxTaps);
+        memset(m_x, 0, sizeof(float) * (m_maxTaps + m_maxBlock));
+        memset(m_ref, 0, sizeof(int16_t) * REF_RING);
+        m_hpf.makeHighPass((float)sampleRate, 100.0f);
+        m_refWrite.store(0, std::memory_order_relaxed);
+        m_refRead = 0;
+        m_lastWrite = 0;
+        m_talkHold = 0;
+        m_talkRun = 0;
+        m_noise = 1e-6f;
+        m_gain = 1.0f;
+        m_erle = 0.0f;
+        m_reanchors = 0;
+        m_taps = m_maxTaps;
+        setReferenceDelay(refDelayFrames);
+    }
+
+    // Playout delay of the reference, in frames
+    void setReferenceDelay(uint32_t frames) {
+        const uint32_t early = m_taps / 4;
+        m_refDelay = frames > early ? frames - early : 0;
+        if (m_refDelay + m_maxBlock + m_maxTaps >= REF_RING) m_refDelay = REF_RING - m_maxBlock - m_maxTaps - 1;
+    }
+
+    // Active filter length (<= maxTaps); a shorter filter keeps the early,
+    // stronger part of the echo path
+    void setTaps(uint32_t taps) {
+        if (taps > m_maxTaps) taps = m_maxTaps;
+        if (taps < 16) taps = 16;
+        const uint32_t off = m_maxTaps - taps;
+        memset(m_w, 0, sizeof(float) * off);
+        m_taps = taps;
+    }
+    uint32_t taps() const { return m_taps; }
+
+    // Downlink: far-end speech as it heads for the speaker
+    void pushReference(const int16_t* pcm, uint32_t frames) {
+        if (!m_ref) return;
+        uint32_t w = m_refWrite.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < frames; i++) m_ref[(w + i) & (REF_RING - 1)] = pcm[i];
+        m_refWrite.store(w + frames, std::memory_order_release);
+    }
+
+    // Uplink: frames mic samples (Q31) in, cleaned speech out
+    void process(const int32_t* mic, int16_t* out, uint32_t frames) {
+        if (frames > m_maxBlock) frames = m_maxBlock;
+        const uint32_t written = alignReference(frames);
+
+        // The newest m_maxTaps reference samples precede this block in m_x;
+        // past the write side (downlink stalled) the speaker plays silence
+        const uint32_t off = m_maxTaps - m_taps;
+        float* x = m_x + off;
+        float peakX = 0.0f;
+        for (uint32_t i = 0; i < frames; i++) {
+            const uint32_t at = m_refRead + i;
+            m_x[m_maxTaps + i] = (int32_t)(written - at) > 0 ? m_ref[at & (REF_RING - 1)] * (1.0f / 32768.0f) : 0.0f;
+        }
+        for (uint32_t i = 0; i < m_taps + frames; i++) {
+            const float a = fabsf(x[i]);
+            if (a > peakX) peakX = a;
+        }
+        m_refRead += frames;
+
+        float peakD = 0.0f, ed = 0.0f;
+        for (uint32_t i = 0; i < frames; i++) {
+            const float d = m_hpf.process(mic[i] * (1.0f / 2147483648.0f));
+            m_d[i] = d;
+            ed += d * d;
+            if (fabsf(d) > peakD) peakD = fabsf(d);
+        }
+
+        // Pass 1, filter as it stands: how much of the mic it explains
+        float* w = m_w + off;
+        float ee0 = 0.0f;
+        for (uint32_t i = 0; i < frames; i++) {
+            const float* xi = x + i + 1;            // Window ending at this sample
+            float y = 0.0f;
+            for (uint32_t k = 0; k < m_taps; k++) y += w[k] * xi[k];
+            const float e = m_d[i] - y;
+            ee0 += e * e;
+        }
+
+        // Near-end talk. Until the filter has converged, the mic louder than
+        // any echo could be (Geigel); after, an error well above what the
+        // filter has been leaving. Talk that never ends is an echo path
+        // that changed: start over from the Geigel test.
+        const float erleLin = powf(10.0f, m_erle * 0.1f);
+        const bool talk = m_erle < CONVERGED_DB ? peakD > GEIGEL * peakX
+                                                : ee0 > TALK_RATIO * fast_div(ed, erleLin);
+        if (talk) {
+            m_talkHold = TALK_HOLD_BLOCKS;
+            if (++m_talkRun > PATH_CHANGE_BLOCKS) m_erle = 0.0f;
+        } else {
+            m_talkRun = 0;
+        }
+        const bool adapt = m_talkHold == 0;
+        if (m_talkHold) m_talkHold--;
+
+        // Pass 2: NLMS, per sample
+        float power = 0.0f;
+        for (uint32_t k = 0; k < m_taps; k++) power += x[k] * x[k];
+        float ey = 0.0f, ee = 0.0f;
+        const float eps = EPS_PER_TAP * m_taps;
+        for (uint32_t i = 0; i < frames; i++) {
+            const float* xi = x + i + 1;
+            power += xi[m_taps - 1] * xi[m_taps - 1] - x[i] * x[i];
+            if (power < 0.0f) power = 0.0f;
+            float y = 0.0f;
+            for (uint32_t k = 0; k < m_taps; k++) y += w[k] * xi[k];
+            const float e = m_d[i] - y;
+            m_e[i] = e;
+            ey += y * y;
+            ee += e * e;
+            if (adapt) {
+                const float step = fast_div(MU * e, power + eps);
+                for (uint32_t k = 0; k < m_taps; k++) w[k] += step * xi[k];
+            }
+        }
+        memmove(m_x, m_x + frames, sizeof(float) * m_maxTaps);
+
+        // Echo return loss enhancement, smoothed, while only the far end
+        // talks; also scales the residual echo the suppressor expects
+        if (adapt && peakX > 1e-4f && ee > 0.0f && ed > 0.0f) {
+            m_erle += 0.05f * (10.0f * log10f(ed / ee) - m_erle);
+            if (m_erle < 0.0f) m_erle = 0.0f;
+        }
+
+        // Noise floor: falls at once, rises ~9 dB/s
+        const float eBlock = ee / frames;
+        if (eBlock < m_noise) m_noise = eBlock;
+        else m_noise *= NOISE_RISE;
+        if (m_noise < 1e-10f) m_noise = 1e-10f;
+
+        const float residual = fast_div(RES_ECHO * ey, erleLin);
+        float g = 1.0f - fast_div(residual + NOISE_OVER * m_noise * frames, ee + 1e-12f);
+        if (g < GAIN_FLOOR) g = GAIN_FLOOR;
+        const float target = g < m_gain ? 0.5f * (m_gain + g) : m_gain + 0.2f * (g - m_gain);
+
+        // Ramp across the block, no zipper steps
+        const float step = (target - m_gain) / frames;
+        float gain = m_gain;
+        for (uint32_t i = 0; i < frames; i++) {
+            gain += step;
+            float v = m_e[i] * gain * (MIC_GAIN * 32768.0f);
+            if (v > 32767.0f) v = 32767.0f;
+            if (v < -32768.0f) v = -32768.0f;
+            out[i] = (int16_t)lrintf(v);
+        }
+        m_gain = target;
+    }
+
+    float erleDb() const { return m_erle; }
+    float gain() const { return m_gain; }
+    uint32_t reanchors() const { return m_reanchors; }
+
+private:
+    static constexpr uint32_t MAX_BLOCK = 240;
+    static constexpr float MU = 0.5f;               // NLMS step
+    static constexpr float EPS_PER_TAP = 1e-6f;     // Regularisation, per tap
+    static constexpr float GEIGEL = 0.6f;           // Echo path assumed >= 4.4 dB of loss
+    static constexpr float CONVERGED_DB = 10.0f;    // ERLE from which the error test takes over
+    static constexpr float TALK_RATIO = 4.0f;       // Error 6 dB above the expected residual
+    static constexpr int TALK_HOLD_BLOCKS = 8;      // 60 ms
+    static constexpr int PATH_CHANGE_BLOCKS = 667;  // 5 s
+    static constexpr float RES_ECHO = 2.0f;         // Residual echo overestimate
+    static constexpr float NOISE_OVER = 2.0f;       // Noise floor overestimate
+    static constexpr float NOISE_RISE = 1.015f;     // Per 7.5 ms block
+    static constexpr float GAIN_FLOOR = 0.1f;       // -20 dB
+    static constexpr float MIC_GAIN = 8.0f;         // +18 dB: MEMS mics sit near -26 dBFS at 94 dB SPL
+
+    // Keep the read side refDelay behind the write side. A write side
+    // that stood still is a stalled downlink, not drift: the read side
+    // runs on into silence and is pulled back once audio comes again.
+    uint32_t alignReference(uint32_t frames) {
+        const uint32_t w = m_refWrite.load(std::memory_order_acquire);
+        const bool moved = w != m_lastWrite;
+        m_lastWrite = w;
+        const uint32_t want = w - m_refDelay - frames;
+        const int32_t err = (int32_t)(m_refRead - want);
+        const int32_t slack = (int32_t)(m_taps / 8);
+        if (err < -slack || (err > slack && moved)) {
+            m_refRead = want;
+            m_reanchors++;
+        }
+        return w;
+    }
+
+    float* m_w = nullptr;           // Filter, oldest tap first
+    float* m_x = nullptr;           // Reference history + this block
+    int16_t* m_ref = nullptr;       // Reference ring
+    float m_d[MAX_BLOCK];           // High-passed mic
+    float m_e[MAX_BLOCK];           // Echo-cancelled mic
+    uint32_t m_maxTaps = 0;
+    uint32_t m_maxBlock = 0;
+    uint32_t m_taps = 0;
+    std::atomic<uint32_t> m_refWrite{0};
+    uint32_t m_refRead = 0;
+    uint32_t m_refDelay = 0;
+    uint32_t m_lastWrite = 0;
+    Biquad m_hpf;
+    int m_talkHold = 0;
+    int m_talkRun = 0;
+    float m_noise = 1e-6f;
+    float m_gain = 1.0f;
+    float m_erle = 0.0f;
+    uint32_t m_reanchors = 0;
+};
@@ -9,10 +9,13 @@
 #include <stdlib.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/i2c.h"
+#include "driver/i2c_master.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
 #include "seesaw_encoder.h"
+#include "../core/static_alloc.h"
 
 // I2C configuration
 #ifdef CONFIG_ENCODER_I2C_SDA_GPIO
@@ -33,9 +36,17 @@
     #define ENCODER_QUAD_ADDR  0x36  // SEESAW_QUAD_DEFAULT_ADDR
 #endif
 
+// Seesaw INT pin (open drain, active low); without it the task polls
+#if defined(CONFIG_ENCODER_INT_GPIO) && CONFIG_ENCODER_INT_GPIO >= 0
+    #define ENCODER_INT_GPIO  ((gpio_num_t)CONFIG_ENCODER_INT_GPIO)
+#else
+    #define ENCODER_INT_GPIO  GPIO_NUM_NC
+#endif
+
 #define ENCODER_I2C_PORT      I2C_NUM_1
 #define ENCODER_I2C_FREQ_HZ   400000  // 400kHz standard
 #define ENCODER_POLL_MS       25  // 25ms polling (reduced from 10ms to avoid audio interference)
+                                  // With INT: only while a button debounces or clicks are pending
 
 // Encoder indices
 #define ENC_VOLUME  0
@@ -65,6 +76,7 @@ typedef void (*BrightnessChangedCb)(uint8_t brightness);
 typedef void (*PairingModeCb)();
 typedef void (*EffectChangedCb)(int effectId, bool confirmed);  // confirmed=true when selection is finalized
 typedef void (*SoundMode3DCb)(bool enabled);  // 3D sound toggle callback
+typedef void (*ProfileCycleCb)();              // Next latency profile (triple click)
 
 class EncoderController {
 public:
@@ -77,23 +89,17 @@ public:
         if (m_initialized) return true;
         
         // Initialize I2C
-        i2c_config_t conf = {};
-        conf.mode = I2C_MODE_MASTER;
+        i2c_master_bus_config_t conf = {};
+        conf.i2c_port = ENCODER_I2C_PORT;
         conf.sda_io_num = ENCODER_I2C_SDA_GPIO;
         conf.scl_io_num = ENCODER_I2C_SCL_GPIO;
-        conf.sda_pullup_en = GPIO_PULLUP_ENABLE;
-        conf.scl_pullup_en = GPIO_PULLUP_ENABLE;
-        conf.master.clk_speed = ENCODER_I2C_FREQ_HZ;
-        
-        esp_err_t err = i2c_param_config(ENCODER_I2C_PORT, &conf);
-        if (err != ESP_OK) {
-            ESP_LOGE(ENC_TAG, "I2C config failed: %s", esp_err_to_name(err));
-            return false;
-        }
+        conf.clk_source = I2C_CLK_SRC_DEFAULT;
+        conf.glitch_ignore_cnt = 7;
+        conf.flags.enable_internal_pullup = true;
         
-        err = i2c_driver_install(ENCODER_I2C_PORT, I2C_MODE_MASTER, 0, 0, 0);
+        esp_err_t err = i2c_new_master_bus(&conf, &m_bus);
         if (err != ESP_OK) {
-            ESP_LOGE(ENC_TAG, "I2C driver install failed: %s", esp_err_to_name(err));
+            ESP_LOGE(ENC_TAG, "I2C bus init failed: %s", esp_err_to_name(err));
             return false;
         }
         
@@ -101,7 +107,7 @@ public:
                  ENCODER_I2C_SDA_GPIO, ENCODER_I2C_SCL_GPIO);
         
         // Initialize quad encoder (like Arduino ss.begin())
-        if (!m_encoder.begin(ENCODER_I2C_PORT, ENCODER_QUAD_ADDR)) {
+        if (!m_encoder.begin(m_bus, ENCODER_QUAD_ADDR, ENCODER_I2C_FREQ_HZ)) {
             ESP_LOGW(ENC_TAG, "Quad encoder not found at 0x%02X", ENCODER_QUAD_ADDR);
         } else {
             ESP_LOGI(ENC_TAG, "Quad encoder initialized at 0x%02X", ENCODER_QUAD_ADDR);
@@ -117,6 +123,8 @@ public:
             for (int e = 0; e < 4; e++) {
                 m_lastPos[e] = m_encoder.getPosition(e);
             }
+            
+            initInterrupt(ENCODER_INT_GPIO);
         }
         
         m_initialized = true;
@@ -133,6 +141,7 @@ public:
     void setPairingModeCallback(PairingModeCb cb) { m_pairingCb = cb; }
     void setEffectCallback(EffectChangedCb cb) { m_effectCb = cb; }
     void set3DSoundCallback(SoundMode3DCb cb) { m_3dSoundCb = cb; }
+    void setProfileCycleCallback(ProfileCycleCb cb) { m_profileCycleCb = cb; }
     
     // Set current values
     void setCurrentVolume(uint8_t volume) { m_volume = (volume <= VOLUME_MAX) ? volume : VOLUME_MAX; }
@@ -165,7 +174,7 @@ public:
         // ------ Check buttons with debounce ------
         
         // Volume button = play/pause/next/prev (with multi-click detection)
-        bool volBtnRaw = m_encoder.isButtonPressed(ENC_VOLUME);
+        bool volBtnRaw = m_encoder.buttonPressed(ENC_VOLUME);
         if (volBtnRaw) {
             if (m_btnDebounce[ENC_VOLUME] < DEBOUNCE_COUNT) m_btnDebounce[ENC_VOLUME]++;
         } else {
@@ -201,7 +210,7 @@ public:
         }
         
         // Bass button = brightness cycle (with debounce)
-        bool bassBtnRaw = m_encoder.isButtonPressed(ENC_BASS);
+        bool bassBtnRaw = m_encoder.buttonPressed(ENC_BASS);
         if (bassBtnRaw) {
             if (m_btnDebounce[ENC_BASS] < DEBOUNCE_COUNT) m_btnDebounce[ENC_BASS]++;
         } else {
@@ -226,7 +235,7 @@ public:
         m_lastBtnState[ENC_BASS] = bassBtn;
         
         // Mid button = pairing mode (with debounce)
-        bool midBtnRaw = m_encoder.isButtonPressed(ENC_MID);
+        bool midBtnRaw = m_encoder.buttonPressed(ENC_MID);
         if (midBtnRaw) {
             if (m_btnDebounce[ENC_MID] < DEBOUNCE_COUNT) m_btnDebounce[ENC_MID]++;
         } else {
@@ -245,7 +254,7 @@ public:
         m_lastBtnState[ENC_MID] = midBtn;
         
         // Treble button = effect selection mode (single click) / 3D sound toggle (double click)
-        bool trebleBtnRaw = m_encoder.isButtonPressed(ENC_TREBLE);
+        bool trebleBtnRaw = m_encoder.buttonPressed(ENC_TREBLE);
         if (trebleBtnRaw) {
             if (m_btnDebounce[ENC_TREBLE] < DEBOUNCE_COUNT) m_btnDebounce[ENC_TREBLE]++;
         } else {
@@ -283,6 +292,17 @@ public:
                         if (m_effectCb) m_effectCb(m_effectId, true);
                     }
                     m_encoder.showPixels();
+                } else if (m_trebleClickCount >= 3 && m_profileCycleCb) {
+                    // Triple click: next latency profile
+                    ESP_LOGI(ENC_TAG, "Latency profile: next (triple click)");
+                    m_profileCycleCb();
+
+                    // Flash treble LED white to indicate the profile change
+                    m_encoder.setPixelColor(ENC_TREBLE, 100, 100, 100);  // White flash
+                    m_encoder.showPixels();
+                    vTaskDelay(pdMS_TO_TICKS(200));
+                    m_encoder.setPixelColor(ENC_TREBLE, 100, 100, 0);  // Back to yellow
+                    m_encoder.showPixels();
                 } else if (m_trebleClickCount >= 2) {
                     // Double click: toggle 3D sound
                     m_3dSoundEnabled = !m_3dSoundEnabled;
@@ -411,6 +431,24 @@ public:
         }
     }
     
+    // Block until there is something to read: INT going low, or the
+    // poll period while a button debounces or a multi-click is open
+    void waitForInput() {
+        if (m_intGpio == GPIO_NUM_NC) {
+            taskYIELD();  // Give other tasks a chance
+            vTaskDelay(pdMS_TO_TICKS(ENCODER_POLL_MS));
+            return;
+        }
+        bool busy = m_volClickCount > 0 || m_trebleClickCount > 0;
+        for (int i = 0; i < 4; i++) {
+            if (m_btnDebounce[i] > 0) busy = true;
+        }
+        // INT still low: a flag is left over or came in during the read,
+        // with no edge to wake us
+        if (gpio_get_level(m_intGpio) == 0) busy = true;
+        ulTaskNotifyTake(pdTRUE, busy ? pdMS_TO_TICKS(ENCODER_POLL_MS) : portMAX_DELAY);
+    }
+    
     // Getters
     uint8_t getVolume() const { return m_volume; }
     int8_t getBass() const { return m_bass; }
@@ -421,6 +459,39 @@ public:
 private:
     EncoderController() = default;
     
+    static void IRAM_ATTR onInterrupt(void* arg) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(static_cast<TaskHandle_t>(arg), &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
+    
+    // Called from the encoder task, which the ISR notifies
+    void initInterrupt(gpio_num_t pin) {
+        if (pin == GPIO_NUM_NC) return;
+        
+        gpio_config_t io = {};
+        io.pin_bit_mask = 1ULL << pin;
+        io.mode = GPIO_MODE_INPUT;
+        io.pull_up_en = GPIO_PULLUP_ENABLE;
+        io.intr_type = GPIO_INTR_NEGEDGE;
+        esp_err_t err = gpio_config(&io);
+        if (err == ESP_OK) {
+            err = gpio_install_isr_service(0);
+            if (err == ESP_ERR_INVALID_STATE) err = ESP_OK;  // Already installed
+        }
+        if (err == ESP_OK) {
+            err = gpio_isr_handler_add(pin, onInterrupt, xTaskGetCurrentTaskHandle());
+        }
+        if (err != ESP_OK || !m_encoder.enableInterrupts()) {
+            ESP_LOGW(ENC_TAG, "Encoder INT on GPIO %d unavailable (%s), polling every %d ms",
+                     pin, esp_err_to_name(err), ENCODER_POLL_MS);
+            if (err == ESP_OK) gpio_isr_handler_remove(pin);
+            return;
+        }
+        m_intGpio = pin;
+        ESP_LOGI(ENC_TAG, "Encoder INT on GPIO %d", pin);
+    }
+    
     static int8_t clampEq(int val) {
         if (val < EQ_MIN) return EQ_MIN;
         if (val > EQ_MAX) return EQ_MAX;
@@ -428,7 +499,9 @@ private:
     }
     
     bool m_initialized = false;
+    i2c_master_bus_handle_t m_bus = nullptr;
     SeesawQuadEncoder m_encoder;
+    gpio_num_t m_intGpio = GPIO_NUM_NC;  // Set once the INT pin is armed
     
     // Last positions (like Arduino enc_positions[4])
     int32_t m_lastPos[4] = {0, 0, 0, 0};
@@ -481,24 +554,27 @@ private:
     PairingModeCb m_pairingCb = nullptr;
     EffectChangedCb m_effectCb = nullptr;
     SoundMode3DCb m_3dSoundCb = nullptr;
+    ProfileCycleCb m_profileCycleCb = nullptr;
 };
 
-// Encoder task - runs on core 0 to avoid interfering with audio on core 1
+// Encoder task - runs off the audio core (see startEncoderTask)
+// The seesaw probe retries I2C with delays, so it runs here rather than
+// holding up the caller
 inline void encoderTask(void* param) {
     EncoderController& enc = EncoderController::getInstance();
+    if (!enc.init()) {
+        ESP_LOGW(ENC_TAG, "Encoder init failed, stopping task");
+        vTaskDelete(nullptr);
+        return;
+    }
     while (true) {
         enc.poll();
-        taskYIELD();  // Give other tasks a chance
-        vTaskDelay(pdMS_TO_TICKS(ENCODER_POLL_MS));
+        enc.waitForInput();
     }
 }
 
-// Start encoder task - priority 2 (below audio tasks), pinned to core 0
-inline void startEncoderTask(int priority = 2, int stackSize = 4096) {
-    if (!EncoderController::getInstance().init()) {
-        ESP_LOGW(ENC_TAG, "Encoder init failed, not starting task");
-        return;
-    }
-    xTaskCreatePinnedToCore(encoderTask, "encoder", stackSize, nullptr, priority, nullptr, 0);
-    ESP_LOGI(ENC_TAG, "Encoder task started on core 0, priority %d", priority);
+// Start encoder task - priority 2 (below audio tasks), pinned away from the audio core
+inline void startEncoderTask(int priority = 2, int stackSize = 4096, int core = 0) {
+    StaticAlloc::createTask(encoderTask, "encoder", stackSize, nullptr, priority, nullptr, core);
+    ESP_LOGI(ENC_TAG, "Encoder task started on core %d, priority %d", core, priority);
 }
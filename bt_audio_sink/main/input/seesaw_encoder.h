@@ -10,6 +10,9 @@
  *   1. Write [regHigh, regLow] with STOP
  *   2. Delay (default 250µs)
  *   3. Read response with STOP
+ * on the i2c_master bus-device driver. The delay is an esp_timer one-shot
+ * the task sleeps on rather than a busy-wait, and poll() runs its reads
+ * as one list with pending NeoPixel writes flushed at the end.
  * 
  * Product: Adafruit Quad Rotary Encoder Breakout (Product 5752)
  * Default I2C Address: 0x36 (configurable via EEPROM)
@@ -17,8 +20,11 @@
 
 #include <stdint.h>
 #include <string.h>
-#include "driver/i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/i2c_master.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_rom_sys.h"  // For esp_rom_delay_us
 
 // ============================================================================
@@ -120,6 +126,10 @@ static const int SEESAW_QUAD_BTN_PINS[4] = {12, 14, 17, 9};
 #define SEESAW_DEFAULT_DELAY_US     250
 // Delay for encoder position reads (reduced to minimize audio interference)
 #define SEESAW_ENCODER_DELAY_US     500
+// Default SCL clock
+#define SEESAW_DEFAULT_SCL_HZ       400000
+// Per-transfer timeout
+#define SEESAW_I2C_TIMEOUT_MS       100
 
 static const char* SEESAW_TAG = "SeesawQuad";
 
@@ -139,15 +149,40 @@ public:
     /**
      * @brief Initialize the Seesaw device
      * 
-     * @param i2cPort I2C port number (I2C_NUM_0 or I2C_NUM_1)
+     * @param bus I2C master bus the breakout is on
      * @param addr I2C address of the device
+     * @param sclHz SCL clock for this device
      * @param reset Whether to perform software reset (default: true)
      * @return true if initialization successful
      */
-    bool begin(i2c_port_t i2cPort, uint8_t addr = SEESAW_QUAD_DEFAULT_ADDR, bool reset = true) {
-        m_i2cPort = i2cPort;
+    bool begin(i2c_master_bus_handle_t bus, uint8_t addr = SEESAW_QUAD_DEFAULT_ADDR,
+               uint32_t sclHz = SEESAW_DEFAULT_SCL_HZ, bool reset = true) {
+        m_bus = bus;
         m_addr = addr;
         
+        if (!m_dev) {
+            i2c_device_config_t dev = {};
+            dev.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+            dev.device_address = m_addr;
+            dev.scl_speed_hz = sclHz;
+            esp_err_t err = i2c_master_bus_add_device(m_bus, &dev, &m_dev);
+            if (err != ESP_OK) {
+                ESP_LOGE(SEESAW_TAG, "Add device 0x%02X failed: %s", m_addr, esp_err_to_name(err));
+                return false;
+            }
+        }
+        if (!m_settleTimer) {
+            // Without it the write-read delay falls back to a busy-wait
+            m_settleSem = xSemaphoreCreateBinary();
+            esp_timer_create_args_t args = {};
+            args.callback = onSettled;
+            args.arg = this;
+            args.name = "seesaw";
+            if (!m_settleSem || esp_timer_create(&args, &m_settleTimer) != ESP_OK) {
+                m_settleTimer = nullptr;
+            }
+        }
+        
         // Reset stored positions
         for (int i = 0; i < 4; i++) {
             m_positions[i] = 0;
@@ -348,21 +383,57 @@ public:
         return write8(SEESAW_ENCODER_BASE, SEESAW_ENCODER_INTENCLR + encoder, 0x01);
     }
     
+    /**
+     * @brief Drive the INT pin from all four encoders and button pins
+     *
+     * INT goes low on a detent or button change and is released once the
+     * deltas and the GPIO interrupt flags have been read, which poll()
+     * does from then on.
+     * @return true on success
+     */
+    bool enableInterrupts() {
+        bool ok = true;
+        for (int e = 0; e < 4; e++) {
+            ok = enableEncoderInterrupt(e) && ok;
+        }
+        uint8_t cmd[4];
+        u32ToBe(buttonMask(), cmd);
+        ok = write(SEESAW_GPIO_BASE, SEESAW_GPIO_INTENSET, cmd, 4) == ESP_OK && ok;
+        m_interrupts = ok;
+        return ok;
+    }
+    
     // ========================================================================
     // High-level polling interface
     // ========================================================================
     
     /**
      * @brief Poll all encoders for position changes
-     * Call this regularly in your main loop.
+     * Call this regularly in your main loop, or when INT goes low.
      * Uses delta-based reading which is more reliable and prevents wild jumps.
+     * The button GPIO bank is read once per poll; see buttonPressed().
      */
     void poll() {
         if (!m_initialized) return;
         
+        // Four deltas, the button bank and, with INT armed, the GPIO
+        // interrupt flags (reading them lets INT go back high)
+        uint8_t deltas[4][4];
+        uint8_t gpio[4];
+        uint8_t flags[4];
+        const Transfer list[] = {
+            { SEESAW_ENCODER_BASE, SEESAW_ENCODER_DELTA + 0, deltas[0], 4, SEESAW_ENCODER_DELAY_US },
+            { SEESAW_ENCODER_BASE, SEESAW_ENCODER_DELTA + 1, deltas[1], 4, SEESAW_ENCODER_DELAY_US },
+            { SEESAW_ENCODER_BASE, SEESAW_ENCODER_DELTA + 2, deltas[2], 4, SEESAW_ENCODER_DELAY_US },
+            { SEESAW_ENCODER_BASE, SEESAW_ENCODER_DELTA + 3, deltas[3], 4, SEESAW_ENCODER_DELAY_US },
+            { SEESAW_GPIO_BASE, SEESAW_GPIO_BULK, gpio, 4, SEESAW_DEFAULT_DELAY_US },
+            { SEESAW_GPIO_BASE, SEESAW_GPIO_INTFLAG, flags, 4, SEESAW_DEFAULT_DELAY_US },
+        };
+        const uint32_t ok = readList(list, m_interrupts ? 6 : 5);
+        
         for (int e = 0; e < 4; e++) {
             // Use delta reading instead of absolute position for reliability
-            int32_t delta = getEncoderDelta(e);
+            int32_t delta = (ok & (1u << e)) ? (int32_t)beToU32(deltas[e]) : 0;
             
             // Validate delta - reject wild jumps (more than ±30 in one poll)
             // Normal encoder movement should be small
@@ -376,6 +447,12 @@ public:
                 m_changed[e] = false;
             }
         }
+        
+        // A failed read counts as all buttons released (active low)
+        m_gpio = (ok & (1u << 4)) ? beToU32(gpio) : 0xFFFFFFFF;
+        
+        // Colors set during this cycle go out with it
+        if (m_pixelDirtyEnd > m_pixelDirtyStart) showPixels();
     }
     
     /**
@@ -396,6 +473,16 @@ public:
         return (encoder < 4) ? m_positions[encoder] : 0;
     }
     
+    /**
+     * @brief Button state as of the last poll
+     * @param encoder Encoder number (0-3)
+     * @return true if button was pressed (active low)
+     */
+    bool buttonPressed(uint8_t encoder) const {
+        if (encoder >= 4) return false;
+        return ((m_gpio >> SEESAW_QUAD_BTN_PINS[encoder]) & 0x1) == 0;
+    }
+    
     // ========================================================================
     // GPIO / Button Functions
     // ========================================================================
@@ -463,6 +550,8 @@ public:
     
     /**
      * @brief Set NeoPixel color for an encoder
+     * Only updates the local buffer; showPixels() or the next poll()
+     * writes every changed pixel in one transfer.
      * @param encoder Encoder number (0-3)
      * @param r Red value (0-255)
      * @param g Green value (0-255)
@@ -472,21 +561,36 @@ public:
         if (encoder >= 4) return;
         
         // GRB order, offset = encoder * 3
-        uint8_t buf[5];
-        uint16_t offset = encoder * 3;
-        buf[0] = (offset >> 8) & 0xFF;
-        buf[1] = offset & 0xFF;
-        buf[2] = g;  // GRB order
-        buf[3] = r;
-        buf[4] = b;
-        write(SEESAW_NEOPIXEL_BASE, SEESAW_NEOPIXEL_BUF, buf, 5);
+        uint8_t* px = &m_pixels[encoder * 3];
+        if (px[0] == g && px[1] == r && px[2] == b && m_pixelsSent) return;
+        px[0] = g;  // GRB order
+        px[1] = r;
+        px[2] = b;
+        if (m_pixelDirtyEnd <= m_pixelDirtyStart) {
+            m_pixelDirtyStart = encoder * 3;
+            m_pixelDirtyEnd = encoder * 3 + 3;
+        } else {
+            if (encoder * 3 < m_pixelDirtyStart) m_pixelDirtyStart = encoder * 3;
+            if (encoder * 3 + 3 > m_pixelDirtyEnd) m_pixelDirtyEnd = encoder * 3 + 3;
+        }
     }
     
     /**
      * @brief Show NeoPixels (call after setPixelColor)
+     * Writes the changed span of the buffer, then latches it.
      */
     void showPixels() {
+        if (m_pixelDirtyEnd > m_pixelDirtyStart) {
+            uint8_t buf[2 + sizeof(m_pixels)];
+            const uint8_t len = m_pixelDirtyEnd - m_pixelDirtyStart;
+            buf[0] = 0;
+            buf[1] = m_pixelDirtyStart;
+            memcpy(buf + 2, m_pixels + m_pixelDirtyStart, len);
+            write(SEESAW_NEOPIXEL_BASE, SEESAW_NEOPIXEL_BUF, buf, 2 + len);
+            m_pixelDirtyStart = m_pixelDirtyEnd = 0;
+        }
         write(SEESAW_NEOPIXEL_BASE, SEESAW_NEOPIXEL_SHOW, nullptr, 0);
+        m_pixelsSent = true;
     }
     
     /**
@@ -532,6 +636,31 @@ protected:
     // Low-level I2C functions (matching Arduino Adafruit_seesaw pattern)
     // ========================================================================
     
+    // One register read in a list run by readList()
+    struct Transfer {
+        uint8_t regHigh;
+        uint8_t regLow;
+        uint8_t* buf;
+        uint8_t num;
+        uint16_t delayUs;
+    };
+    
+    /**
+     * @brief Run a list of register reads back to back
+     * @param list Reads in bus order
+     * @param count Number of entries (max 32)
+     * @return Bitmask of the entries that read successfully
+     */
+    uint32_t readList(const Transfer* list, size_t count) {
+        uint32_t ok = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (read(list[i].regHigh, list[i].regLow, list[i].buf, list[i].num, list[i].delayUs) == ESP_OK) {
+                ok |= 1u << i;
+            }
+        }
+        return ok;
+    }
+    
     /**
      * @brief Write a single byte to a register
      * @param regHigh Module base address
@@ -576,8 +705,7 @@ protected:
         uint8_t prefix[2] = { regHigh, regLow };
         
         // Step 1: Write the register address (with STOP)
-        esp_err_t err = i2c_master_write_to_device(m_i2cPort, m_addr, prefix, 2, 
-                                                    pdMS_TO_TICKS(100));
+        esp_err_t err = i2c_master_transmit(m_dev, prefix, 2, SEESAW_I2C_TIMEOUT_MS);
         if (err != ESP_OK) {
             ESP_LOGW(SEESAW_TAG, "I2C write failed: reg=0x%02X%02X err=%s", 
                      regHigh, regLow, esp_err_to_name(err));
@@ -585,11 +713,10 @@ protected:
         }
         
         // Step 2: Delay (required for seesaw to prepare data)
-        esp_rom_delay_us(delayUs);
+        settle(delayUs);
         
         // Step 3: Read the data (new START, with STOP)
-        err = i2c_master_read_from_device(m_i2cPort, m_addr, buf, num, 
-                                          pdMS_TO_TICKS(100));
+        err = i2c_master_receive(m_dev, buf, num, SEESAW_I2C_TIMEOUT_MS);
         if (err != ESP_OK) {
             ESP_LOGW(SEESAW_TAG, "I2C read failed: reg=0x%02X%02X err=%s", 
                      regHigh, regLow, esp_err_to_name(err));
@@ -621,8 +748,7 @@ protected:
             memcpy(writeBuffer + 2, buf, num);
         }
         
-        esp_err_t err = i2c_master_write_to_device(m_i2cPort, m_addr, writeBuffer, 
-                                                    2 + num, pdMS_TO_TICKS(100));
+        esp_err_t err = i2c_master_transmit(m_dev, writeBuffer, 2 + num, SEESAW_I2C_TIMEOUT_MS);
         if (err != ESP_OK) {
             ESP_LOGW(SEESAW_TAG, "I2C write failed: reg=0x%02X%02X err=%s", 
                      regHigh, regLow, esp_err_to_name(err));
@@ -637,27 +763,30 @@ private:
      * @return true if device responds to address
      */
     bool i2cDetect() {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (m_addr << 1) | I2C_MASTER_WRITE, true);
-        i2c_master_stop(cmd);
-        esp_err_t err = i2c_master_cmd_begin(m_i2cPort, cmd, pdMS_TO_TICKS(50));
-        i2c_cmd_link_delete(cmd);
-        return (err == ESP_OK);
+        return i2c_master_probe(m_bus, m_addr, 50) == ESP_OK;
+    }
+    
+    /**
+     * @brief Give the seesaw delayUs to prepare a read, sleeping meanwhile
+     */
+    void settle(uint16_t delayUs) {
+        if (!m_settleTimer || esp_timer_start_once(m_settleTimer, delayUs) != ESP_OK) {
+            esp_rom_delay_us(delayUs);
+            return;
+        }
+        xSemaphoreTake(m_settleSem, pdMS_TO_TICKS(10));
+    }
+    
+    static void onSettled(void* arg) {
+        xSemaphoreGive(static_cast<SeesawQuadEncoder*>(arg)->m_settleSem);
     }
     
     /**
      * @brief Initialize button pullups for all 4 encoders
      */
     void initButtonPullups() {
-        // Build mask of all button pins
-        uint32_t mask = 0;
-        for (int i = 0; i < 4; i++) {
-            mask |= (1u << SEESAW_QUAD_BTN_PINS[i]);
-        }
-        
         // Set as INPUT_PULLUP (mode 2)
-        pinModeBulk(mask, 2);
+        pinModeBulk(buttonMask(), 2);
         
         ESP_LOGI(SEESAW_TAG, "Button pullups configured: pins %d, %d, %d, %d",
                  SEESAW_QUAD_BTN_PINS[0], SEESAW_QUAD_BTN_PINS[1], 
@@ -681,6 +810,7 @@ private:
         write(SEESAW_NEOPIXEL_BASE, SEESAW_NEOPIXEL_BUF_LENGTH, len, 2);
         
         // Initialize all pixels to off
+        m_pixelsSent = false;
         for (int i = 0; i < 4; i++) {
             setPixelColor(i, 0, 0, 0);
         }
@@ -689,6 +819,17 @@ private:
         ESP_LOGI(SEESAW_TAG, "NeoPixels initialized on pin %d", SEESAW_QUAD_NEOPIXEL_PIN);
     }
     
+    /**
+     * @brief Mask of all button pins
+     */
+    static uint32_t buttonMask() {
+        uint32_t mask = 0;
+        for (int i = 0; i < 4; i++) {
+            mask |= (1u << SEESAW_QUAD_BTN_PINS[i]);
+        }
+        return mask;
+    }
+    
     // ========================================================================
     // Byte order conversion helpers
     // ========================================================================
@@ -709,7 +850,10 @@ private:
     // Member variables
     // ========================================================================
     
-    i2c_port_t m_i2cPort = I2C_NUM_0;
+    i2c_master_bus_handle_t m_bus = nullptr;
+    i2c_master_dev_handle_t m_dev = nullptr;
+    esp_timer_handle_t m_settleTimer = nullptr;
+    SemaphoreHandle_t m_settleSem = nullptr;
     uint8_t m_addr = SEESAW_QUAD_DEFAULT_ADDR;
     uint8_t m_hardwareType = 0;
     bool m_initialized = false;
@@ -718,4 +862,14 @@ private:
     int32_t m_positions[4] = {0, 0, 0, 0};
     int32_t m_lastPositions[4] = {0, 0, 0, 0};
     bool m_changed[4] = {false, false, false, false};
+    
+    // GPIO bank from the last poll (all high = no buttons pressed)
+    uint32_t m_gpio = 0xFFFFFFFF;
+    bool m_interrupts = false;
+    
+    // NeoPixel buffer (GRB) and the span not yet written to the device
+    uint8_t m_pixels[4 * 3] = {};
+    uint8_t m_pixelDirtyStart = 0;
+    uint8_t m_pixelDirtyEnd = 0;
+    bool m_pixelsSent = false;
 };
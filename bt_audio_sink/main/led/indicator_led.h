@@ -0,0 +1,86 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Indicator LED - one discrete LED on an LEDC channel (BEAT_LED_FADE)
+// - flash() lights it fully and starts a hardware fade to dark over
+//   the given time, then returns: the LEDC steps the duty on its own,
+//   so no task wakes to turn the LED off or to shape the decay
+// - A flash while the last fade still runs is dropped: the ESP32's
+//   LEDC holds a duty change until the fade ends, which would block
+//   the caller, and the LED is lit then anyway
+// - Fades always end dark, so there is nothing to turn off
+// - flash(): one task (the beat task); the fade-end ISR only clears
+//   the busy flag
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <atomic>
+#include "driver/ledc.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+
+class IndicatorLed {
+public:
+    static constexpr uint32_t FREQ_HZ = 5000;
+
+    // Timer, channel and the fade service (shared by every channel, so
+    // one installed already is fine). False leaves flash() a no-op.
+    bool begin(gpio_num_t gpio, ledc_timer_t timer, ledc_channel_t channel) {
+        ledc_timer_config_t t = {};
+        t.speed_mode = MODE;
+        t.duty_resolution = RESOLUTION;
+        t.timer_num = timer;
+        t.freq_hz = FREQ_HZ;
+        t.clk_cfg = LEDC_AUTO_CLK;
+        ledc_channel_config_t c = {};
+        c.gpio_num = gpio;
+        c.speed_mode = MODE;
+        c.channel = channel;
+        c.timer_sel = timer;
+        c.duty = 0;
+        esp_err_t err = ledc_timer_config(&t);
+        if (err == ESP_OK) err = ledc_channel_config(&c);
+        if (err == ESP_OK) {
+            err = ledc_fade_func_install(0);
+            if (err == ESP_ERR_INVALID_STATE) err = ESP_OK;
+        }
+        ledc_cbs_t cbs = {};
+        cbs.fade_cb = onFadeEnd;
+        if (err == ESP_OK) err = ledc_cb_register(MODE, channel, &cbs, this);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "LED on GPIO %d: %s", (int)gpio, esp_err_to_name(err));
+            return false;
+        }
+        m_channel = channel;
+        m_ready = true;
+        return true;
+    }
+
+    // Full on, fading to dark over ms; returns at once
+    void flash(uint32_t ms) {
+        if (!m_ready || m_fading.load(std::memory_order_acquire)) return;
+        m_fading.store(true, std::memory_order_relaxed);
+        if (ledc_set_duty_and_update(MODE, m_channel, MAX_DUTY, 0) != ESP_OK ||
+            ledc_set_fade_time_and_start(MODE, m_channel, 0, ms, LEDC_FADE_NO_WAIT) != ESP_OK) {
+            m_fading.store(false, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static constexpr const char* TAG = "Indicator";
+    static constexpr ledc_mode_t MODE = LEDC_LOW_SPEED_MODE;
+    static constexpr ledc_timer_bit_t RESOLUTION = LEDC_TIMER_13_BIT;
+    static constexpr uint32_t MAX_DUTY = (1u << 13) - 1;
+
+    static bool IRAM_ATTR onFadeEnd(const ledc_cb_param_t* param, void* arg) {
+        if (param->event == LEDC_FADE_END_EVT) {
+            static_cast<IndicatorLed*>(arg)->m_fading.store(false, std::memory_order_release);
+        }
+        return false;
+    }
+
+    ledc_channel_t m_channel = LEDC_CHANNEL_0;
+    bool m_ready = false;
+    std::atomic<bool> m_fading{false};
+};
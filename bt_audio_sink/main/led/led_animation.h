@@ -0,0 +1,281 @@
+#pragma once
+
+// -----------------------------------------------------------
+// LED Animation - user-uploaded animations (LED_ANIMATION)
+// - Palette-indexed frames, each one a delta on the one before,
+//   run-length coded; decoded one frame per animation step into an
+//   index buffer, never expanded as a whole
+// - Blob, little-endian:
+//     [magic "LANM", version 1, width, height, palette entries - 1,
+//      fps, reserved, frames u16, cycle i8, reserved,
+//      speed {source, amount}, brightness {source, amount},
+//      shift {source, amount},
+//      palette (r, g, b) x entries,
+//      frames: {len u16, ops...}]
+//   Pixels are numbered row by row from the top left, whatever the
+//   wiring. Ops, from the cursor on:
+//     0x00-0x7F  skip n + 1 pixels (unchanged)
+//     0x80-0xBF  (n & 0x3F) + 1 pixels of the index that follows
+//     0xC0-0xFF  (n & 0x3F) + 1 indices follow
+//   The first frame is a delta on all index 0, and the loop starts
+//   over from there
+// - Audio bindings: source 0 none, 1 bass, 2 mid, 3 high, 4 beat
+//   intensity; amount 0-255. Speed runs the fps up to ~5x faster,
+//   brightness dims by amount where the source is quiet, shift turns
+//   the palette by amount entries at full level; cycle turns it by
+//   cycle / 16 entries per step on its own
+// - A step builds one palette lookup and writes every pixel from it:
+//   a table load and a store per pixel, plus the ops of the frames
+//   due
+// - load() validates and copies from any task; the LED task swaps the
+//   copy in at its next step
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "led_config.h"
+#include "led_effects.h"
+
+class LedAnimation {
+public:
+    // Sound-upload type that carries an animation instead of a WAV
+    static constexpr uint8_t UPLOAD_TYPE = 0x11;
+    static constexpr size_t MAX_BLOB_BYTES = (size_t)LED_ANIMATION_MAX_KB * 1024;
+    static constexpr size_t HEADER_BYTES = 20;
+    static constexpr int MAX_STEP_FRAMES = 4;       // Frames decoded per step at most
+
+    enum Source : uint8_t { SRC_NONE, SRC_BASS, SRC_MID, SRC_HIGH, SRC_BEAT, SRC_COUNT };
+
+    ~LedAnimation() {
+        heap_caps_free(m_pending.exchange(nullptr));
+        heap_caps_free(m_blob);
+    }
+
+    // Any task: a copy of a valid blob replaces the animation at the
+    // next step. False when the blob is malformed or there is no memory.
+    bool load(const uint8_t* blob, size_t len) {
+        if (!validate(blob, len)) return false;
+        uint8_t* copy = (uint8_t*)heap_caps_malloc(len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!copy) copy = (uint8_t*)heap_caps_malloc(len, MALLOC_CAP_8BIT);
+        if (!copy) {
+            ESP_LOGW(TAG, "No memory for the animation (%u bytes)", (unsigned)len);
+            return false;
+        }
+        memcpy(copy, blob, len);
+        heap_caps_free(m_pending.exchange(copy, std::memory_order_acq_rel));
+        m_loaded.store(true, std::memory_order_release);
+        ESP_LOGI(TAG, "Animation: %u frames at %u fps, %u colours, %u bytes", (unsigned)get16(blob + 10),
+                 blob[8], blob[7] + 1, (unsigned)len);
+        return true;
+    }
+
+    bool loaded() const { return m_loaded.load(std::memory_order_acquire); }
+
+    // LED task: from the first frame at the next step
+    void restart() {
+        rewind();
+        m_phase = 0;
+        m_cycle = 0;
+    }
+
+    // LED task: one animation step into the framebuffer (LED_MATRIX_COUNT
+    // pixels in wiring order). False with nothing loaded.
+    bool step(const AudioData& audio, RGB16* fb) {
+        uint8_t* next = m_pending.exchange(nullptr, std::memory_order_acq_rel);
+        if (next) {
+            heap_caps_free(m_blob);
+            m_blob = next;
+            m_entries = m_blob[7] + 1;
+            m_frames = get16(m_blob + 10);
+            restart();
+        }
+        if (!m_blob) return false;
+
+        // Frames due: fps against the step rate, sped up by the binding
+        const uint8_t* h = m_blob;
+        uint32_t rate = ((uint32_t)h[8] << 8) / LED_TICK_HZ;             // Frames per step, 8.8
+        rate += (rate * (uint32_t)h[15] * bound(h[14], audio)) >> 14;     // + up to ~4x at amount 255
+        m_phase += rate;
+        int due = (int)(m_phase >> 8);
+        m_phase &= 0xFF;
+        if (due > MAX_STEP_FRAMES) due = MAX_STEP_FRAMES;
+        for (int i = 0; i < due; i++) decodeFrame();
+
+        // Palette turned and scaled into framebuffer levels
+        m_cycle = (m_cycle + (int8_t)h[12]) % (int32_t)(m_entries << 4);
+        if (m_cycle < 0) m_cycle += (int32_t)(m_entries << 4);
+        const uint32_t shift = ((uint32_t)(m_cycle >> 4) + ((h[19] * bound(h[18], audio)) >> 8)) % m_entries;
+        uint32_t level = 256;
+        if (h[16] != SRC_NONE) level -= (h[17] * (256 - bound(h[16], audio))) >> 8;
+        const uint8_t* pal = m_blob + HEADER_BYTES;
+        for (uint32_t i = 0, src = shift; i < m_entries; i++) {
+            const uint8_t* c = pal + src * 3;
+            m_lut[i] = RGB16{(uint16_t)(c[0] * level), (uint16_t)(c[1] * level), (uint16_t)(c[2] * level)};
+            if (++src == m_entries) src = 0;
+        }
+
+        // Rows in wiring order: odd rows run right to left
+        for (int y = 0; y < LED_MATRIX_HEIGHT; y++) {
+            const uint8_t* row = m_index + y * LED_MATRIX_WIDTH;
+            RGB16* out = fb + y * LED_MATRIX_WIDTH;
+            if (y & 1) {
+                for (int x = 0; x < LED_MATRIX_WIDTH; x++) out[LED_MATRIX_WIDTH - 1 - x] = m_lut[row[x]];
+            } else {
+                for (int x = 0; x < LED_MATRIX_WIDTH; x++) out[x] = m_lut[row[x]];
+            }
+        }
+        return true;
+    }
+
+private:
+    static constexpr const char* TAG = "LedAnim";
+
+    static uint16_t get16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+    // Binding source level, 0-256
+    static uint32_t bound(uint8_t source, const AudioData& audio) {
+        float v;
+        switch (source) {
+            case SRC_BASS: v = audio.bass; break;
+            case SRC_MID:  v = audio.mid; break;
+            case SRC_HIGH: v = audio.high; break;
+            case SRC_BEAT: v = audio.beat ? audio.beatIntensity : 0.0f; break;
+            default:       return 0;
+        }
+        if (v <= 0.0f) return 0;
+        return v >= 1.0f ? 256 : (uint32_t)(v * 256.0f);
+    }
+
+    // The whole blob: header, every frame inside it, every op inside its
+    // frame and the matrix, every index inside the palette
+    static bool validate(const uint8_t* b, size_t len) {
+        if (len < HEADER_BYTES || len > MAX_BLOB_BYTES || memcmp(b, "LANM", 4) != 0 || b[4] != 1) {
+            ESP_LOGW(TAG, "Not an animation");
+            return false;
+        }
+        if (b[5] != LED_MATRIX_WIDTH || b[6] != LED_MATRIX_HEIGHT) {
+            ESP_LOGW(TAG, "Animation is %ux%u, the matrix %ux%u", b[5], b[6], LED_MATRIX_WIDTH, LED_MATRIX_HEIGHT);
+            return false;
+        }
+        const uint32_t entries = b[7] + 1u;
+        const uint32_t frames = get16(b + 10);
+        if (b[8] == 0 || b[8] > LED_TICK_HZ * MAX_STEP_FRAMES || frames == 0 ||
+            b[14] >= SRC_COUNT || b[16] >= SRC_COUNT || b[18] >= SRC_COUNT) {
+            ESP_LOGW(TAG, "Bad animation header");
+            return false;
+        }
+        size_t pos = HEADER_BYTES + entries * 3;
+        for (uint32_t f = 0; f < frames; f++) {
+            if (pos + 2 > len) break;
+            const size_t end = pos + 2 + get16(b + pos);
+            if (end > len) break;
+            pos += 2;
+            uint32_t cursor = 0;
+            while (pos < end) {
+                const uint8_t op = b[pos++];
+                const uint32_t n = (op < 0x80 ? op : (op & 0x3F)) + 1u;
+                if (cursor + n > LED_MATRIX_COUNT) return bad(f);
+                cursor += n;
+                if (op < 0x80) continue;
+                const size_t data = op < 0xC0 ? 1 : n;
+                if (pos + data > end) return bad(f);
+                for (size_t i = 0; i < data; i++) {
+                    if (b[pos + i] >= entries) return bad(f);
+                }
+                pos += data;
+            }
+            if (f + 1 == frames) return true;
+        }
+        ESP_LOGW(TAG, "Animation truncated");
+        return false;
+    }
+
+    static bool bad(uint32_t frame) {
+        ESP_LOGW(TAG, "Animation frame %u is corrupt", (unsigned)frame);
+        return false;
+    }
+
+    void rewind() {
+        m_frame = 0;
+        m_offset = HEADER_BYTES + m_entries * 3;
+        memset(m_index, 0, sizeof(m_index));
+    }
+
+    // Next frame's ops onto the index buffer; the blob was validated
+    void decodeFrame() {
+        if (m_frame == m_frames) rewind();
+        const uint8_t* p = m_blob + m_offset + 2;
+        const uint8_t* end = p + get16(m_blob + m_offset);
+        uint8_t* cur = m_index;
+        while (p < end) {
+            const uint8_t op = *p++;
+            if (op < 0x80) {
+                cur += op + 1;
+            } else if (op < 0xC0) {
+                const int n = (op & 0x3F) + 1;
+                memset(cur, *p++, n);
+                cur += n;
+            } else {
+                const int n = (op & 0x3F) + 1;
+                memcpy(cur, p, n);
+                p += n;
+                cur += n;
+            }
+        }
+        m_offset = (size_t)(end - m_blob);
+        m_frame++;
+    }
+
+    std::atomic<uint8_t*> m_pending{nullptr};
+    std::atomic<bool> m_loaded{false};
+
+    // LED task
+    uint8_t* m_blob = nullptr;
+    uint32_t m_entries = 1;
+    uint32_t m_frames = 0;
+    uint32_t m_frame = 0;           // Frames decoded since the first
+    size_t m_offset = 0;            // Of the next frame
+    uint32_t m_phase = 0;           // Fraction of a frame due, 8.8
+    int32_t m_cycle = 0;            // Palette turn, 1/16 entries
+    uint8_t m_index[LED_MATRIX_COUNT];
+    RGB16 m_lut[256];
+};
+
+// -----------------------------------------------------------
+// Custom animation effect: the uploaded LedAnimation, or a blank
+// matrix until there is one
+// -----------------------------------------------------------
+class CustomAnimationEffect : public LedEffect {
+public:
+    explicit CustomAnimationEffect(LedAnimation& anim) : m_anim(anim) {}
+
+    void init(LedDriver* driver) override {
+        LedEffect::init(driver);
+        m_anim.restart();
+    }
+
+    void update(const AudioData& audio) override {
+        m_frame++;
+        if (!m_anim.step(audio, m_driver->pixels())) m_driver->clear();
+    }
+
+    void updateDemo() override {
+        m_frame++;
+        AudioData demo;
+        const float level = sin8(m_frame * 2) * fast_recipsf2(255.0f);
+        demo.bass = level;
+        demo.mid = level * 0.7f;
+        demo.high = level * 0.4f;
+        demo.beat = (m_frame % 30 == 0);
+        demo.beatIntensity = 0.8f;
+        update(demo);
+    }
+
+    const char* getName() const override { return "Custom"; }
+
+private:
+    LedAnimation& m_anim;
+};
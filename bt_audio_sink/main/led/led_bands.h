@@ -0,0 +1,104 @@
+#pragma once
+
+// -----------------------------------------------------------
+// LED Bands - an effect's rows rendered on both cores
+// (LED_PARALLEL_RENDER)
+// - Row-separable effects (LedEffect::bandRows()) split their frame
+//   into bands of BAND_ROWS work rows; the LED task and a helper on
+//   the other core take bands off one counter until none are left
+// - The helper runs just above idle on the audio core, so it only
+//   uses the time the audio tasks leave; when they keep the core,
+//   the LED task takes the bands itself
+// - run() returns once every band is drawn: the barrier before the
+//   frame is composed, encoded and sent
+// - run(): LED task only
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "../core/static_alloc.h"
+
+class LedBands {
+public:
+    typedef void (*RowsFn)(void* ctx, int y0, int y1);
+
+    static constexpr int BAND_ROWS = 2;
+    static constexpr uint32_t STACK_BYTES = 2048;
+    static constexpr UBaseType_t PRIORITY = 1;     // Below every audio task
+
+    // From the LED task: the helper goes on the other core. False keeps
+    // run() on the calling task alone.
+    bool begin() {
+        m_done = xSemaphoreCreateBinaryStatic(&m_doneBuf);
+        const BaseType_t core = xPortGetCoreID() ^ 1;
+        if (StaticAlloc::createTask(helperTask, "led_band", STACK_BYTES, this, PRIORITY,
+                                    &m_helper, core) != pdPASS) {
+            ESP_LOGW(TAG, "No band helper: effects render on one core");
+            m_helper = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    // fn(ctx, y0, y1) over [0, rows) in bands, on both cores
+    void run(RowsFn fn, void* ctx, int rows) {
+        const int bands = (rows + BAND_ROWS - 1) / BAND_ROWS;
+        if (!m_helper || bands < 2) {
+            fn(ctx, 0, rows);
+            return;
+        }
+        m_fn = fn;
+        m_ctx = ctx;
+        m_rows = rows;
+        m_bands = bands;
+        m_finished.store(0, std::memory_order_relaxed);
+        m_left.store(bands, std::memory_order_release);
+        xTaskNotifyGive(m_helper);
+        // Whoever draws the last band ends the frame; the helper then
+        // says so, exactly once
+        if (!work()) xSemaphoreTake(m_done, portMAX_DELAY);
+    }
+
+private:
+    static constexpr const char* TAG = "LedBands";
+
+    static void helperTask(void* param) {
+        LedBands* self = static_cast<LedBands*>(param);
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            if (self->work()) xSemaphoreGive(self->m_done);
+        }
+    }
+
+    // Bands until none are left; true if this drew the frame's last.
+    // Claims count down, so a helper that wakes after the frame ended
+    // sees none left without reading the frame's fields.
+    bool work() {
+        bool last = false;
+        for (;;) {
+            const int band = m_left.fetch_sub(1, std::memory_order_acq_rel) - 1;
+            if (band < 0) break;
+            const int y0 = band * BAND_ROWS;
+            const int y1 = y0 + BAND_ROWS < m_rows ? y0 + BAND_ROWS : m_rows;
+            m_fn(m_ctx, y0, y1);
+            last = m_finished.fetch_add(1, std::memory_order_acq_rel) + 1 == m_bands;
+        }
+        return last;
+    }
+
+    TaskHandle_t m_helper = nullptr;
+    SemaphoreHandle_t m_done = nullptr;
+    StaticSemaphore_t m_doneBuf;
+
+    // The frame's work, set before m_left opens it
+    RowsFn m_fn = nullptr;
+    void* m_ctx = nullptr;
+    int m_rows = 0;
+    int m_bands = 0;
+    std::atomic<int> m_left{0};
+    std::atomic<int> m_finished{0};
+};
@@ -3,7 +3,7 @@
 // -----------------------------------------------------------
 // LED Matrix Configuration
 // 16x16 WS2812B matrix with audio-reactive effects
-// Uses SPI DMA driver for reliable LED output
+// Output through the SPI DMA driver, or I2S parallel for several strips
 // -----------------------------------------------------------
 
 #include "sdkconfig.h"
@@ -32,18 +32,119 @@
     #define LED_GPIO_PIN        GPIO_NUM_4
 #endif
 
+// Output: SPI (one strip on LED_DATA_PIN) or I2S parallel, strip 0
+// on LED_DATA_PIN and strips 1..7 on LED_PARALLEL_GPIOS
+#ifdef CONFIG_LED_OUTPUT_PARALLEL
+    #define LED_OUTPUT_PARALLEL     1
+    #define LED_PARALLEL_STRIPS     CONFIG_LED_PARALLEL_STRIPS
+    #define LED_PARALLEL_CLK_GPIO   CONFIG_LED_PARALLEL_CLK_GPIO
+    #define LED_PARALLEL_GPIOS      { CONFIG_LED_PARALLEL_GPIO_1, CONFIG_LED_PARALLEL_GPIO_2, \
+                                      CONFIG_LED_PARALLEL_GPIO_3, CONFIG_LED_PARALLEL_GPIO_4, \
+                                      CONFIG_LED_PARALLEL_GPIO_5, CONFIG_LED_PARALLEL_GPIO_6, \
+                                      CONFIG_LED_PARALLEL_GPIO_7 }
+#else
+    #define LED_OUTPUT_PARALLEL     0
+#endif
+
 #ifdef CONFIG_LED_BRIGHTNESS
     #define LED_DEFAULT_BRIGHTNESS  CONFIG_LED_BRIGHTNESS
 #else
     #define LED_DEFAULT_BRIGHTNESS  64
 #endif
 
+// Current budget the encoder holds the frames under (0: none); a
+// WS2812B idles at about 1 mA with all channels off
+#if defined(CONFIG_LED_POWER_LIMIT_MA) && CONFIG_LED_POWER_LIMIT_MA > 0
+    #define LED_POWER_LIMIT_MA      CONFIG_LED_POWER_LIMIT_MA
+    #define LED_MA_PER_CHANNEL      CONFIG_LED_MA_PER_CHANNEL
+#else
+    #define LED_POWER_LIMIT_MA      0
+    #define LED_MA_PER_CHANNEL      12
+#endif
+#define LED_IDLE_MA_PER_LED         1
+
+// Gamma 2.2 applied at encode time (colours stay linear in effects)
+#ifdef CONFIG_LED_GAMMA
+    #define LED_GAMMA           1
+#else
+    #define LED_GAMMA           0
+#endif
+
+// Temporal dithering of the fractional levels left by gamma and low
+// brightness; each effect frame is sent LED_DITHER_REFRESH times
+#ifdef CONFIG_LED_DITHER
+    #define LED_DITHER          1
+    #define LED_DITHER_REFRESH  CONFIG_LED_DITHER_REFRESH
+#else
+    #define LED_DITHER          0
+    #define LED_DITHER_REFRESH  1
+#endif
+
 #ifdef CONFIG_LED_FPS
     #define LED_FPS             CONFIG_LED_FPS
 #else
     #define LED_FPS             30
 #endif
 
+// Effects step on a fixed LED_TICK_HZ clock, apart from the frame rate;
+// frames show the last two steps interpolated, so a late frame never
+// changes the animation speed. Off: one step per frame, as sent.
+#ifdef CONFIG_LED_INTERPOLATE
+    #define LED_INTERPOLATE     1
+    #define LED_TICK_HZ         CONFIG_LED_TICK_HZ
+#else
+    #define LED_INTERPOLATE     0
+    #define LED_TICK_HZ         LED_FPS
+#endif
+// Steps caught up in one frame at most; longer stalls are dropped
+#define LED_TICK_CATCHUP        4
+
+// Effects follow the analysis of the audio being heard (output latency
+// behind the DSP) instead of the newest; TRIM adds DAC/amplifier delay
+#ifdef CONFIG_LED_AUDIO_SYNC
+    #define LED_AUDIO_SYNC      1
+    #define LED_AUDIO_SYNC_TRIM_MS  CONFIG_LED_AUDIO_SYNC_TRIM_MS
+#else
+    #define LED_AUDIO_SYNC      0
+    #define LED_AUDIO_SYNC_TRIM_MS  0
+#endif
+
+// Demo mode replays a recorded loop of effect steps instead of running
+// the effect; BLEND steps of crossfade close the loop
+#ifdef CONFIG_LED_DEMO_CACHE
+    #define LED_DEMO_CACHE          1
+    #define LED_DEMO_CACHE_SECONDS  CONFIG_LED_DEMO_CACHE_SECONDS
+#else
+    #define LED_DEMO_CACHE          0
+    #define LED_DEMO_CACHE_SECONDS  4
+#endif
+#define LED_DEMO_CACHE_BLEND        (LED_TICK_HZ / 2)
+
+// Row-separable effects render in bands on both cores (led_bands.h)
+#if defined(CONFIG_LED_PARALLEL_RENDER) && !defined(CONFIG_FREERTOS_UNICORE)
+    #define LED_PARALLEL_RENDER     1
+#else
+    #define LED_PARALLEL_RENDER     0
+#endif
+
+// User-uploaded animations (led_animation.h), the Custom effect
+#ifdef CONFIG_LED_ANIMATION
+    #define LED_ANIMATION           1
+    #define LED_ANIMATION_MAX_KB    CONFIG_LED_ANIMATION_MAX_KB
+#else
+    #define LED_ANIMATION           0
+    #define LED_ANIMATION_MAX_KB    0
+#endif
+
+// Once this many frames in a row were unchanged, the LED task stops
+// rendering at LED_FPS and waits for an event or the idle poll
+#define LED_IDLE_FRAMES         4
+#define LED_IDLE_POLL_MS        100
+
+// Effect frames in a row over the frame period before the effect
+// drops a quality level (fewer particles)
+#define LED_OVERRUN_STREAK      8
+
 // Demo mode timeout (ms without audio before switching to demo)
 #ifdef CONFIG_LED_DEMO_TIMEOUT
     #define LED_DEMO_TIMEOUT_MS     (CONFIG_LED_DEMO_TIMEOUT * 1000)
@@ -83,6 +184,7 @@ enum LedEffectId {
     LED_EFFECT_BOUNCING_BALLS,       // Balls bounce to the beat
     LED_EFFECT_LAVA_LAMP,            // Blob-like lava lamp effect
     LED_EFFECT_AMBIENT,              // Ambient mode with configurable colors, gradient, speed
+    LED_EFFECT_CUSTOM,               // Uploaded animation (LED_ANIMATION), skipped while none
     // === User-selectable effects end here ===
     LED_EFFECT_USER_COUNT,           // Number of user-selectable effects (for cycling)
     // === Internal/special effects below ===
@@ -7,18 +7,33 @@
 // -----------------------------------------------------------
 
 #include <stdint.h>
+#include <atomic>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/idf_additions.h"
-#include "nvs_flash.h"
-#include "nvs.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 
 #include "led_config.h"
 #include "led_driver_spi.h"
 #include "led_effects.h"
+#include "led_font.h"
+#include "led_text.h"
+#include "../audio/perf_trace.h"
+#ifdef CONFIG_LED_PROFILE
+#include "led_profile.h"
+#endif
+#if LED_DEMO_CACHE
+#include "led_demo_cache.h"
+#endif
+#if LED_ANIMATION
+#include "led_animation.h"
+#endif
 #include "../dsp/dsp_processor.h"
+#include "../core/power_manager.h"
+#include "../core/static_alloc.h"
+#include "../core/event_bus.h"
 
 static const char* LED_TAG = "LedController";
 
@@ -39,13 +54,21 @@ public:
         
         // Create all effects
         createEffects();
+#if LED_PARALLEL_RENDER
+        // Row-separable effects share a helper on the other core
+        if (m_bands.begin()) {
+            for (LedEffect* e : m_effects) {
+                if (e && e->bandRows() > 0) e->setBands(&m_bands);
+            }
+        }
+#endif
         
         // Play startup animation if requested
         if (playStartup) {
             playStartupAnimation();
         }
         
-        // Load saved effect from NVS
+        // Saved effect and colours (setPersistence)
         loadSettings();
         
         // Set initial effect
@@ -60,7 +83,9 @@ public:
     
     void update(float bass, float mid, float high, 
                 float bassDb, float midDb, float highDb,
-                bool beat, float beatIntensity, bool audioPlaying) {
+                bool beat, float beatIntensity, bool audioPlaying,
+                const float* bands = nullptr, const float* bandPeaks = nullptr,
+                int numBands = 0) {
         if (!m_initialized) return;
         
         // Track audio activity
@@ -80,29 +105,81 @@ public:
         LedEffect* effect = getCurrentEffect();
         if (!effect) return;
         
-        if (m_inDemoMode) {
-            effect->updateDemo();
-        } else {
-            AudioData audio;
-            audio.bass = bass;
-            audio.mid = mid;
-            audio.high = high;
-            audio.bassDB = bassDb;
-            audio.midDB = midDb;
-            audio.highDB = highDb;
-            audio.beat = beat;
-            audio.beatIntensity = beatIntensity;
-            audio.audioActive = audioPlaying;
-            effect->update(audio);
+        AudioData audio;
+        audio.bass = bass;
+        audio.mid = mid;
+        audio.high = high;
+        audio.bassDB = bassDb;
+        audio.midDB = midDb;
+        audio.highDB = highDb;
+        audio.beat = beat;
+        audio.beatIntensity = beatIntensity;
+        audio.audioActive = audioPlaying;
+        if (numBands > AudioData::MAX_BANDS) numBands = AudioData::MAX_BANDS;
+        audio.numBands = (uint8_t)numBands;
+        for (int i = 0; i < numBands; i++) {
+            audio.bands[i] = bands[i];
+            audio.bandPeaks[i] = bandPeaks[i];
         }
         
-        // Apply global brightness and show
-        m_driver.setBrightness(m_brightness);
-        m_driver.show();
+        const uint32_t t0 = PerfTrace::now();
+#if LED_INTERPOLATE
+        // Steps due since the last frame, on the fixed tick; a beat
+        // waits for the next step if none is due
+        const int64_t nowUs = esp_timer_get_time();
+        m_tickAccUs += (uint32_t)(nowUs - m_lastFrameUs);
+        m_lastFrameUs = nowUs;
+        uint32_t steps = m_tickAccUs / TICK_US;
+        m_tickAccUs -= steps * TICK_US;
+        if (steps > LED_TICK_CATCHUP) steps = LED_TICK_CATCHUP;
+        m_beatPending |= beat;
+        for (uint32_t i = 0; i < steps; i++) {
+            // The effect draws over, and reads back, its own last step
+            m_driver.loadFrame(m_steps[m_stepNew]);
+            audio.beat = m_beatPending;
+            m_beatPending = false;
+            stepEffect(effect, audio);
+            m_stepNew ^= 1;
+            m_driver.saveFrame(m_steps[m_stepNew]);
+        }
+        const uint32_t t1 = PerfTrace::now();
+        // The frame sits between the last two steps, by the time into
+        // the current one
+        m_driver.blendFrames(m_steps[m_stepNew ^ 1], m_steps[m_stepNew], (m_tickAccUs << 8) / TICK_US);
+        const uint32_t renderCycles = steps > 1 ? (t1 - t0) / steps : t1 - t0;
+#else
+        stepEffect(effect, audio);
+        const uint32_t t1 = PerfTrace::now();
+        const uint32_t renderCycles = t1 - t0;
+#endif
+        
+        // Overlays (composeLayers) go on as the frame is sent
+        const uint32_t t2 = PerfTrace::now();
+        present();
+        checkFrameBudget(effect, renderCycles, PerfTrace::now() - t2);
     }
     
+#ifdef CONFIG_LED_PROFILE
+    // Per-effect frame cost report (see LedProfile::serialize); also
+    // logged. reset clears it after the snapshot.
+    size_t profileReport(uint8_t* out, size_t cap, bool reset) {
+        uint8_t quality[LED_EFFECT_COUNT];
+        const char* names[LED_EFFECT_COUNT];
+        for (int i = 0; i < LED_EFFECT_COUNT; i++) {
+            quality[i] = m_effects[i] ? m_effects[i]->qualityLevel() : 0;
+            names[i] = m_effects[i] ? m_effects[i]->getName() : nullptr;
+        }
+        size_t len = m_profile.serialize(out, cap, FRAME_BUDGET_US, quality);
+        m_profile.log(LED_TAG, names);
+        if (reset) m_profile.reset();
+        return len;
+    }
+#endif
+    
     void nextEffect() {
-        m_currentEffect = (m_currentEffect + 1) % LED_EFFECT_USER_COUNT;
+        do {
+            m_currentEffect = (m_currentEffect + 1) % LED_EFFECT_USER_COUNT;
+        } while (!selectable(m_currentEffect));
         
         LedEffect* effect = getCurrentEffect();
         if (effect) {
@@ -111,18 +188,21 @@ public:
         }
         
         saveSettings();
+        wake();
     }
     
     void previousEffect() {
-        if (m_currentEffect == 0) {
-            m_currentEffect = LED_EFFECT_USER_COUNT - 1;
-        } else {
-            m_currentEffect--;
-            // Ensure we don't go past user-selectable effects
-            if (m_currentEffect >= LED_EFFECT_USER_COUNT) {
+        do {
+            if (m_currentEffect == 0) {
                 m_currentEffect = LED_EFFECT_USER_COUNT - 1;
+            } else {
+                m_currentEffect--;
+                // Ensure we don't go past user-selectable effects
+                if (m_currentEffect >= LED_EFFECT_USER_COUNT) {
+                    m_currentEffect = LED_EFFECT_USER_COUNT - 1;
+                }
             }
-        }
+        } while (!selectable(m_currentEffect));
         
         LedEffect* effect = getCurrentEffect();
         if (effect) {
@@ -131,6 +211,7 @@ public:
         }
         
         saveSettings();
+        wake();
     }
     
     void setEffect(int effectId, bool save = true) {
@@ -144,10 +225,23 @@ public:
             if (save) {
                 saveSettings();
             }
+            invalidateDemo();
         }
+        wake();
     }
     
     int getCurrentEffectId() const { return m_currentEffect; }
+
+#if LED_ANIMATION
+    // Any task: a new Custom effect animation (led_animation.h). False
+    // when the blob is malformed or does not fit in memory.
+    bool loadAnimation(const uint8_t* blob, size_t len) {
+        if (!m_animation.load(blob, len)) return false;
+        if (m_currentEffect == LED_EFFECT_CUSTOM) invalidateDemo();
+        wake();
+        return true;
+    }
+#endif
     
     const char* getCurrentEffectName() const {
         LedEffect* effect = const_cast<LedController*>(this)->getCurrentEffect();
@@ -161,10 +255,12 @@ public:
         if (m_currentEffect == LED_EFFECT_AMBIENT) {
             AmbientEffect* ambient = static_cast<AmbientEffect*>(m_effects[LED_EFFECT_AMBIENT]);
             if (ambient) ambient->setBrightness(brightness);
+            invalidateDemo();   // The only effect that bakes brightness in
         }
         if (save) {
             saveBrightness();
         }
+        wake();
     }
     
     // Set full LED settings (for Ambient effect): [brightness, r1, g1, b1, r2, g2, b2, gradient, speed, effectId]
@@ -183,13 +279,19 @@ public:
         
         // Save settings to NVS
         saveLedSettings();
+        invalidateDemo();
+        wake();
     }
     
     const uint8_t* getLedSettings() const { return m_ledSettings; }
     
     // Request startup animation to be played from LED task context
+    // Counts as running from here, so a waiter never sees it finished
+    // before the LED task has picked it up
     void requestStartupAnimation() {
+        m_startupAnimationRunning = true;
         m_pendingStartupAnimation = true;
+        wake();
         ESP_LOGI(LED_TAG, "Startup animation requested");
     }
     
@@ -212,49 +314,35 @@ public:
         m_startupAnimationRunning = running;
     }
     
+    // Settings are stored by the owner of the settings blob: saved is
+    // the last set it stored (nullptr = none, keep defaults), saveCb gets
+    // every change. Call before init().
+    typedef void (*SettingsSaveCb)(const uint8_t* settings, size_t len);
+    void setPersistence(const uint8_t* saved, SettingsSaveCb saveCb) {
+        m_haveSaved = saved != nullptr;
+        if (saved) memcpy(m_ledSettings, saved, sizeof(m_ledSettings));
+        m_saveCb = saveCb;
+    }
+
+    // The set carries brightness and effect too
     void saveLedSettings() {
-        nvs_handle_t handle;
-        if (nvs_open("led", NVS_READWRITE, &handle) == ESP_OK) {
-            nvs_set_blob(handle, "settings", m_ledSettings, 10);
-            nvs_commit(handle);
-            nvs_close(handle);
-            ESP_LOGI(LED_TAG, "Saved LED settings");
-        }
+        if (m_saveCb) m_saveCb(m_ledSettings, sizeof(m_ledSettings));
     }
     
     void saveBrightness() {
         // Ensure m_ledSettings is in sync
         m_ledSettings[0] = m_brightness;
-        
-        nvs_handle_t handle;
-        if (nvs_open("led", NVS_READWRITE, &handle) == ESP_OK) {
-            nvs_set_u8(handle, "bright", m_brightness);
-            nvs_set_blob(handle, "settings", m_ledSettings, 10);  // Also save blob for consistency
-            nvs_commit(handle);
-            nvs_close(handle);
-            ESP_LOGI(LED_TAG, "Saved brightness: %d", m_brightness);
-        }
+        saveLedSettings();
     }
     
     uint8_t getBrightness() const { return m_brightness; }
+    bool isInitialized() const { return m_initialized; }
     
-    // Set current volume level (0-127 A2DP range)
+    // Set current volume level (0-127 A2DP range) - triggers the volume overlay
     void setVolume(uint8_t volume) {
         m_currentVolume = volume;
-        
-        // Trigger volume overlay display
-        m_volumeOverlayActive = true;
-        m_volumeOverlayStart = xTaskGetTickCount();
         m_volumeDisplayTarget = volume;
         
-        // If brightness is 0 (or very low), temporarily boost it so volume overlay is visible
-        // This doesn't notify BLE, just affects local driver output
-        if (m_brightness < 10 && !m_volumeBrightnessOverride) {
-            m_volumeBrightnessOverride = true;
-            m_brightnessBeforeVolume = m_brightness;
-            m_driver.setBrightness(10);
-        }
-        
         // Update volume effect if active
         if (m_currentEffect == LED_EFFECT_VOLUME) {
             VolumeEffect* volEffect = static_cast<VolumeEffect*>(m_effects[LED_EFFECT_VOLUME]);
@@ -262,6 +350,7 @@ public:
                 volEffect->setVolume(volume);
             }
         }
+        postOverlay(OVERLAY_VOLUME);
     }
     
     uint8_t getVolume() const { return m_currentVolume; }
@@ -272,121 +361,7 @@ public:
         m_eqMid = mid;
         m_eqTreble = treble;
         m_eqType = changedType;  // 0=bass, 1=mid, 2=treble, 255=all
-        
-        // Trigger EQ overlay display
-        m_eqOverlayActive = true;
-        m_eqOverlayStart = xTaskGetTickCount();
-        
-        // Temporarily boost brightness if very low
-        if (m_brightness < 10 && !m_volumeBrightnessOverride) {
-            m_volumeBrightnessOverride = true;
-            m_brightnessBeforeVolume = m_brightness;
-            m_driver.setBrightness(10);
-        }
-    }
-    
-    // Check if EQ overlay should be shown
-    bool isEqOverlayActive() const {
-        if (!m_eqOverlayActive) return false;
-        TickType_t elapsed = xTaskGetTickCount() - m_eqOverlayStart;
-        return elapsed < pdMS_TO_TICKS(VOLUME_OVERLAY_DURATION_MS);
-    }
-    
-    // Get EQ overlay fade factor
-    float getEqOverlayFade() const {
-        if (!m_eqOverlayActive) return 0.0f;
-        TickType_t elapsed = xTaskGetTickCount() - m_eqOverlayStart;
-        uint32_t elapsedMs = pdTICKS_TO_MS(elapsed);
-        
-        if (elapsedMs >= VOLUME_OVERLAY_DURATION_MS) return 0.0f;
-        if (elapsedMs < VOLUME_OVERLAY_HOLD_MS) return 1.0f;
-        
-        uint32_t fadeElapsed = elapsedMs - VOLUME_OVERLAY_HOLD_MS;
-        uint32_t fadeDuration = VOLUME_OVERLAY_DURATION_MS - VOLUME_OVERLAY_HOLD_MS;
-        return 1.0f - (float)fadeElapsed * fast_recipsf2((float)fadeDuration);
-    }
-    
-    // Render EQ overlay - shows 3 vertical bars for bass/mid/treble
-    void renderEqOverlay() {
-        if (!m_initialized) return;
-        
-        float fade = getEqOverlayFade();
-        if (fade <= 0.0f) {
-            m_eqOverlayActive = false;
-            if (m_volumeBrightnessOverride && !isVolumeOverlayActive()) {
-                m_volumeBrightnessOverride = false;
-                m_driver.setBrightness(m_brightnessBeforeVolume);
-            }
-            return;
-        }
-        
-        m_driver.clear();
-        
-        // EQ range: -12 to +12 dB, map to 0-16 rows (center = 8)
-        auto mapEqToRows = [](int8_t val) -> int {
-            // Map -12..+12 to 0..16 rows (center at 8)
-            return 8 + (val * 8 / 12);
-        };
-        
-        int bassRows = mapEqToRows(m_eqBass);
-        int midRows = mapEqToRows(m_eqMid);
-        int trebleRows = mapEqToRows(m_eqTreble);
-        
-        uint8_t effectiveBrightness = (m_brightness < 10) ? 10 : m_brightness;
-        
-        // Colors for each EQ band
-        RGB_SPI bassColor = {(uint8_t)(255 * fade), 0, 0};                           // Red
-        RGB_SPI midColor = {0, 0, (uint8_t)(255 * fade)};                            // Blue  
-        RGB_SPI trebleColor = {(uint8_t)(255 * fade), (uint8_t)(255 * fade), 0};     // Yellow
-        
-        // Draw 3 bars side by side (each 4 pixels wide, 2 pixel gaps)
-        // Bass: cols 0-3, Mid: cols 6-9, Treble: cols 12-15
-        auto drawBar = [&](int startCol, int rows, RGB_SPI color, bool highlight) {
-            int centerRow = 8;  // Center line
-            int barWidth = 4;
-            
-            // Draw from center up or down based on value
-            if (rows >= centerRow) {
-                // Positive: draw from center upward
-                for (int row = centerRow; row < rows && row < LED_MATRIX_HEIGHT; row++) {
-                    int displayRow = LED_MATRIX_HEIGHT - 1 - row;
-                    for (int col = startCol; col < startCol + barWidth && col < LED_MATRIX_WIDTH; col++) {
-                        RGB_SPI c = color;
-                        if (highlight) {
-                            c.r = (uint8_t)(c.r * 1.0f);
-                            c.g = (uint8_t)(c.g * 1.0f);
-                            c.b = (uint8_t)(c.b * 1.0f);
-                        }
-                        m_driver.setPixelXY(col, displayRow, c);
-                    }
-                }
-            } else {
-                // Negative: draw from center downward
-                for (int row = rows; row < centerRow; row++) {
-                    int displayRow = LED_MATRIX_HEIGHT - 1 - row;
-                    for (int col = startCol; col < startCol + barWidth && col < LED_MATRIX_WIDTH; col++) {
-                        RGB_SPI c = {(uint8_t)(color.r * 0.5f), (uint8_t)(color.g * 0.5f), (uint8_t)(color.b * 0.5f)};  // Dimmer for negative
-                        m_driver.setPixelXY(col, displayRow, c);
-                    }
-                }
-            }
-            
-            // Draw center line marker (dim white)
-            int displayCenterRow = LED_MATRIX_HEIGHT - 1 - centerRow;
-            for (int col = startCol; col < startCol + barWidth && col < LED_MATRIX_WIDTH; col++) {
-                RGB_SPI marker = {(uint8_t)(40 * fade), (uint8_t)(40 * fade), (uint8_t)(40 * fade)};
-                m_driver.setPixelXY(col, displayCenterRow, marker);
-            }
-        };
-        
-        // Draw the 3 bars
-        drawBar(1, bassRows, bassColor, m_eqType == 0);      // Bass on left
-        drawBar(6, midRows, midColor, m_eqType == 1);        // Mid in center
-        drawBar(11, trebleRows, trebleColor, m_eqType == 2); // Treble on right
-        
-        m_driver.setBrightness(effectiveBrightness);
-        m_driver.show();
-        m_driver.setBrightness(m_brightness);
+        postOverlay(OVERLAY_EQ);
     }
     
     // -----------------------------------------------------------
@@ -394,273 +369,138 @@ public:
     // -----------------------------------------------------------
     void setPairingMode(bool active) {
         m_pairingModeActive = active;
-        m_pairingModeStart = xTaskGetTickCount();
         if (active) {
             ESP_LOGI(LED_TAG, "Pairing mode LED animation started");
         } else {
             ESP_LOGI(LED_TAG, "Pairing mode LED animation stopped");
         }
+        postOverlay(OVERLAY_PAIRING);
     }
     
     bool isPairingModeActive() const { return m_pairingModeActive; }
     
-    // Called when pairing succeeds - show 2 fast pulses then exit pairing mode
-    void showPairingSuccess() {
-        m_pairingSuccessActive = true;
-        m_pairingSuccessStart = xTaskGetTickCount();
-        m_pairingModeActive = false;  // Exit pairing mode after success animation
-        ESP_LOGI(LED_TAG, "Pairing success animation started");
-    }
-    
-    bool isPairingSuccessActive() const {
-        if (!m_pairingSuccessActive) return false;
-        TickType_t elapsed = xTaskGetTickCount() - m_pairingSuccessStart;
-        return elapsed < pdMS_TO_TICKS(PAIRING_SUCCESS_DURATION_MS);
-    }
+#if APP_TRACK_INFO
+    // -----------------------------------------------------------
+    // Track info - the text scrolls across once, under the other
+    // overlays, with the play position as a bar on the bottom row
+    // -----------------------------------------------------------
     
-    // Render pairing mode animation - slow blue pulsing
-    void renderPairingMode() {
-        if (!m_initialized) return;
-        
-        // Calculate pulse phase (0-1, repeating every PAIRING_PULSE_PERIOD_MS)
-        TickType_t elapsed = xTaskGetTickCount() - m_pairingModeStart;
-        uint32_t elapsedMs = pdTICKS_TO_MS(elapsed);
-        float phase = (float)(elapsedMs % PAIRING_PULSE_PERIOD_MS) * fast_recipsf2((float)PAIRING_PULSE_PERIOD_MS);
-        
-        // Sine wave for smooth pulsing (0.2 to 1.0 range for visibility)
-        float sineVal = sinf(phase * 2.0f * M_PI);
-        float brightness = 0.2f + 0.8f * (0.5f + 0.5f * sineVal);
-        
-        // Blue color with pulsing brightness
-        uint8_t b = (uint8_t)(255 * brightness);
-        uint8_t g = (uint8_t)(30 * brightness);  // Slight teal tint
-        RGB_SPI blueColor = {0, g, b};
-        
-        // Fill entire matrix with pulsing blue
-        m_driver.clear();
-        int totalLeds = LED_MATRIX_WIDTH * LED_MATRIX_HEIGHT;
-        for (int i = 0; i < totalLeds; i++) {
-            m_driver.setPixel(i, blueColor);
-        }
-        
-        // Use a reasonable brightness for pairing mode
-        uint8_t effectiveBrightness = (m_brightness > 0) ? m_brightness : 40;
-        m_driver.setBrightness(effectiveBrightness);
-        m_driver.show();
-        m_driver.setBrightness(m_brightness);
+    // Any task: the text is laid out into columns here, once per
+    // track; the LED task copies a window of them per frame
+    void showTrackText(const char* text) {
+        portENTER_CRITICAL(&m_trackLock);
+        m_trackPendingCols = (uint16_t)ledFontRasterize(text, m_trackPending, TRACK_STRIP_MAX);
+        portEXIT_CRITICAL(&m_trackLock);
+        postOverlay(OVERLAY_TRACK);
     }
     
-    // Render pairing success animation - 2 fast blue pulses
-    void renderPairingSuccess() {
-        if (!m_initialized) return;
-        
-        TickType_t elapsed = xTaskGetTickCount() - m_pairingSuccessStart;
-        uint32_t elapsedMs = pdTICKS_TO_MS(elapsed);
-        
-        if (elapsedMs >= PAIRING_SUCCESS_DURATION_MS) {
-            m_pairingSuccessActive = false;
+    void setTrackPosition(uint32_t posMs, uint32_t lengthMs) {
+        if (!lengthMs) {
+            m_trackBar.store(TRACK_BAR_NONE, std::memory_order_relaxed);
             return;
         }
-        
-        // 2 fast pulses: on-off-on-off pattern
-        // Each pulse: 150ms on, 100ms off = 250ms per pulse, 500ms total
-        float brightness = 0.0f;
-        if (elapsedMs < 150) {
-            brightness = 1.0f;  // First pulse ON
-        } else if (elapsedMs < 250) {
-            brightness = 0.0f;  // First pulse OFF
-        } else if (elapsedMs < 400) {
-            brightness = 1.0f;  // Second pulse ON
-        } else {
-            brightness = 0.0f;  // Second pulse OFF
-        }
-        
-        // Bright blue/cyan for success
-        uint8_t b = (uint8_t)(255 * brightness);
-        uint8_t g = (uint8_t)(200 * brightness);
-        RGB_SPI successColor = {0, g, b};
-        
-        m_driver.clear();
-        int totalLeds = LED_MATRIX_WIDTH * LED_MATRIX_HEIGHT;
-        for (int i = 0; i < totalLeds; i++) {
-            m_driver.setPixel(i, successColor);
-        }
-        
-        uint8_t effectiveBrightness = (m_brightness > 0) ? m_brightness : 60;
-        m_driver.setBrightness(effectiveBrightness);
-        m_driver.show();
-        m_driver.setBrightness(m_brightness);
+        uint64_t cols = (uint64_t)posMs * LED_MATRIX_WIDTH / lengthMs;
+        if (cols > LED_MATRIX_WIDTH) cols = LED_MATRIX_WIDTH;
+        m_trackBar.store((uint8_t)cols, std::memory_order_relaxed);
     }
+#endif
     
-    // Check if volume overlay should be shown
-    bool isVolumeOverlayActive() const {
-        if (!m_volumeOverlayActive) return false;
-        TickType_t elapsed = xTaskGetTickCount() - m_volumeOverlayStart;
-        return elapsed < pdMS_TO_TICKS(VOLUME_OVERLAY_DURATION_MS);
+    // Called when pairing succeeds - show 2 fast pulses then exit pairing mode
+    void showPairingSuccess() {
+        m_pairingModeActive = false;  // Exit pairing mode after success animation
+        ESP_LOGI(LED_TAG, "Pairing success animation started");
+        postOverlay(OVERLAY_PAIRED);
     }
     
-    // Get volume overlay fade factor (1.0 = full, 0.0 = faded out)
-    float getVolumeOverlayFade() const {
-        if (!m_volumeOverlayActive) return 0.0f;
-        TickType_t elapsed = xTaskGetTickCount() - m_volumeOverlayStart;
-        uint32_t elapsedMs = pdTICKS_TO_MS(elapsed);
-        
-        if (elapsedMs >= VOLUME_OVERLAY_DURATION_MS) {
-            return 0.0f;
-        }
-        
-        // Hold full brightness for first part, then fade
-        if (elapsedMs < VOLUME_OVERLAY_HOLD_MS) {
-            return 1.0f;
-        }
-        
-        // Fade out over remaining time
-        uint32_t fadeElapsed = elapsedMs - VOLUME_OVERLAY_HOLD_MS;
-        uint32_t fadeDuration = VOLUME_OVERLAY_DURATION_MS - VOLUME_OVERLAY_HOLD_MS;
-        return 1.0f - (float)fadeElapsed * fast_recipsf2((float)fadeDuration);
-    }
+    // -----------------------------------------------------------
+    // Overlays - layers composited over the running effect
+    // The setters above only post an event; the LED task applies
+    // events to the layer set at the start of its next frame (a
+    // sprite is redrawn there, once per change) and drops a layer when
+    // its time is up. The effect underneath keeps running; per frame a
+    // layer costs its opacity and one blend per pixel as the driver
+    // encodes.
+    // -----------------------------------------------------------
     
-    // Render volume overlay on the LED matrix
-    void renderVolumeOverlay() {
-        if (!m_initialized) return;
-        
-        float fade = getVolumeOverlayFade();
-        if (fade <= 0.0f) {
-            m_volumeOverlayActive = false;
-            // Restore original brightness if we temporarily boosted it
-            if (m_volumeBrightnessOverride) {
-                m_volumeBrightnessOverride = false;
-                m_driver.setBrightness(m_brightnessBeforeVolume);
-            }
-            return;
-        }
-        
-        // Smooth the displayed volume
-        float targetVol = m_volumeDisplayTarget * fast_recipsf2(127.0f);
-        m_volumeDisplaySmooth += (targetVol - m_volumeDisplaySmooth) * 0.3f;
-        
-        m_driver.clear();
-        
-        // Volume percentage (0-100)
-        int volumePercent = (int)(m_volumeDisplaySmooth * 100.0f + 0.5f);
-        
-        // Calculate how many rows to fill (16 rows total)
-        int filledRows = (int)(m_volumeDisplaySmooth * LED_MATRIX_HEIGHT + 0.5f);
-        
-        // Pulsing effect
-        static uint32_t volFrame = 0;
-        volFrame++;
-        float pulse = 0.85f + 0.15f * sinf(volFrame * 0.15f);
-        
-        // Use brightness setting but with minimum floor of 10 (so volume is always visible)
-        uint8_t effectiveBrightness = (m_brightness < 10) ? 10 : m_brightness;
-        // Don't scale colors by brightness - let the driver handle it via setBrightness()
-        // This prevents double-dimming when brightness is very low
-        float brightnessScale = 1.0f;
-        
-        // Draw volume bar from bottom to top
-        for (int row = 0; row < LED_MATRIX_HEIGHT; row++) {
-            int displayRow = LED_MATRIX_HEIGHT - 1 - row;  // Bottom to top
+    // LED task, once per frame before the effect renders
+    void composeLayers(TickType_t now) {
+        applyOverlayEvents(now);
+        
+        int n = 1;              // m_layerStack[0] is the black backdrop
+        uint8_t floor = 0;      // Lowest brightness the overlays show at
+        for (int id = 0; id < OVERLAY_COUNT; id++) {
+            if (!(m_overlays & (1u << id))) continue;
+            const uint32_t elapsedMs = pdTICKS_TO_MS(now - m_overlayStart[id]);
+            LedLayer& layer = m_layerStack[n];
+            layer.sprite = nullptr;
+            layer.colour = RGB_SPI();
+            layer.alpha = 255;
             
-            if (row < filledRows) {
-                // Color gradient: white -> red (bottom to top)
-                float rowPct = (float)row * fast_recipsf2((float)(LED_MATRIX_HEIGHT - 1));
-                uint8_t r, g, b;
-                
-                // White (255,255,255) at bottom, Red (255,0,0) at top
-                r = 255;
-                g = (uint8_t)(255 * (1.0f - rowPct));
-                b = (uint8_t)(255 * (1.0f - rowPct));
-                
-                // Apply pulse, fade and brightness (with minimum floor)
-                float intensity = pulse * fade * brightnessScale;
-                r = (uint8_t)(r * intensity);
-                g = (uint8_t)(g * intensity);
-                b = (uint8_t)(b * intensity);
-                
-                // Fill the row with a slight gradient from center outward
-                for (int col = 0; col < LED_MATRIX_WIDTH; col++) {
-                    // Center columns brighter
-                    float colDist = fabsf(col - (LED_MATRIX_WIDTH - 1) * 0.5f) * fast_recipsf2((LED_MATRIX_WIDTH - 1) * 0.5f);
-                    float colFade = 1.0f - colDist * 0.3f;  // 70% brightness at edges
-                    
-                    RGB_SPI color = {
-                        (uint8_t)(r * colFade),
-                        (uint8_t)(g * colFade),
-                        (uint8_t)(b * colFade)
-                    };
-                    m_driver.setPixelXY(col, displayRow, color);
+            if (id == OVERLAY_EQ || id == OVERLAY_VOLUME) {
+                if (elapsedMs >= VOLUME_OVERLAY_DURATION_MS) {
+                    m_overlays &= ~(1u << id);
+                    continue;
                 }
+                layer.alpha = overlayFade(elapsedMs);
+                if (id == OVERLAY_VOLUME) {
+                    layer.sprite = m_volumeSprite;
+                    updateVolumeSprite();
+                    // Gentle pulse, 85-100%, about 1.4 s per cycle
+                    const uint8_t pulse = 217 + ((sin8((uint8_t)((elapsedMs * 47) >> 8)) * 38) >> 8);
+                    layer.alpha = (uint8_t)((layer.alpha * pulse + 255) >> 8);
+                } else {
+                    layer.sprite = m_eqSprite;
+                }
+                if (floor < OVERLAY_MIN_BRIGHTNESS) floor = OVERLAY_MIN_BRIGHTNESS;
+#if APP_TRACK_INFO
+            } else if (id == OVERLAY_TRACK) {
+                // Enters on the right, leaves on the left
+                const int scroll = (int)(elapsedMs * TRACK_SCROLL_PX_PER_S / 1000) - LED_MATRIX_WIDTH;
+                if (scroll >= m_trackText.cols()) {
+                    m_overlays &= ~(1u << id);
+                    continue;
+                }
+                layer.sprite = m_trackSprite;
+                updateTrackSprite(scroll);
+                if (floor < OVERLAY_MIN_BRIGHTNESS) floor = OVERLAY_MIN_BRIGHTNESS;
+#endif
+            } else if (id == OVERLAY_PAIRING) {
+                // Slow blue pulse, 20-100%, slight teal tint
+                const uint8_t phase = (uint8_t)((elapsedMs % PAIRING_PULSE_PERIOD_MS) * 256 / PAIRING_PULSE_PERIOD_MS);
+                const uint8_t level = 51 + ((sin8(phase) * 204) >> 8);
+                layer.colour = RGB_SPI(0, (30 * level) >> 8, (255 * level) >> 8);
+                if (floor < PAIRING_MIN_BRIGHTNESS) floor = PAIRING_MIN_BRIGHTNESS;
+            } else {
+                if (elapsedMs >= PAIRING_SUCCESS_DURATION_MS) {
+                    m_overlays &= ~(1u << id);
+                    continue;
+                }
+                // 2 fast pulses: 150 ms on, 100 ms off, twice
+                const bool on = elapsedMs < 150 || (elapsedMs >= 250 && elapsedMs < 400);
+                if (on) layer.colour = RGB_SPI(0, 200, 255);
+                if (floor < PAIRED_MIN_BRIGHTNESS) floor = PAIRED_MIN_BRIGHTNESS;
             }
+            n++;
         }
         
-        // Temporarily set driver brightness to effective value (in case global brightness is 0)
-        // This doesn't notify BLE, just affects the driver output
-        m_driver.setBrightness(effectiveBrightness);
-        m_driver.show();
-        // Restore original brightness for next regular effect render
-        m_driver.setBrightness(m_brightness);
+        // Brightness turned (near) off: the overlays still show, at their
+        // minimum, over black instead of over the effect
+        m_outputBrightness = m_brightness;
+        int first = 1;
+        if (n > 1 && m_brightness < floor) {
+            m_outputBrightness = floor;
+            first = 0;
+        }
+        m_driver.setLayers(&m_layerStack[first], n - first);
     }
     
-    // Draw volume number on the display
-    void drawVolumeNumber(int percent, float fade) {
-        // Simple 3x5 digit font patterns (each digit is 3 wide, 5 tall)
-        static const uint8_t DIGITS[10][5] = {
-            {0b111, 0b101, 0b101, 0b101, 0b111},  // 0
-            {0b010, 0b110, 0b010, 0b010, 0b111},  // 1
-            {0b111, 0b001, 0b111, 0b100, 0b111},  // 2
-            {0b111, 0b001, 0b111, 0b001, 0b111},  // 3
-            {0b101, 0b101, 0b111, 0b001, 0b001},  // 4
-            {0b111, 0b100, 0b111, 0b001, 0b111},  // 5
-            {0b111, 0b100, 0b111, 0b101, 0b111},  // 6
-            {0b111, 0b001, 0b001, 0b001, 0b001},  // 7
-            {0b111, 0b101, 0b111, 0b101, 0b111},  // 8
-            {0b111, 0b101, 0b111, 0b001, 0b111},  // 9
-        };
-        
-        // Clamp percent
-        if (percent < 0) percent = 0;
-        if (percent > 100) percent = 100;
-        
-        // Calculate digits
-        int d1 = percent / 100;       // Hundreds (0 or 1)
-        int d2 = (percent / 10) % 10; // Tens
-        int d3 = percent % 10;        // Ones
-        
-        // Determine how many digits to show
-        int numDigits = (percent >= 100) ? 3 : (percent >= 10) ? 2 : 1;
-        int digitWidth = 3;
-        int spacing = 1;
-        int totalWidth = numDigits * digitWidth + (numDigits - 1) * spacing;
-        
-        // Center horizontally and vertically
-        int startX = (LED_MATRIX_WIDTH - totalWidth) / 2;
-        int startY = (LED_MATRIX_HEIGHT - 5) / 2;
-        
-        // White color with fade
-        uint8_t brightness = (uint8_t)(255 * fade);
-        
-        // Draw digits
-        int x = startX;
-        int digits[3] = {d1, d2, d3};
-        int startDigit = 3 - numDigits;
-        
-        for (int d = startDigit; d < 3; d++) {
-            int digit = digits[d];
-            for (int row = 0; row < 5; row++) {
-                for (int col = 0; col < 3; col++) {
-                    if (DIGITS[digit][row] & (0b100 >> col)) {
-                        int px = x + col;
-                        int py = startY + row;
-                        if (px >= 0 && px < LED_MATRIX_WIDTH && py >= 0 && py < LED_MATRIX_HEIGHT) {
-                            RGB_SPI color = {brightness, brightness, brightness};
-                            m_driver.setPixelXY(px, py, color);
-                        }
-                    }
-                }
-            }
-            x += digitWidth + spacing;
-        }
+    bool hasOverlays() const { return m_overlays != 0; }
+    
+    // Shows the effect's frame with the overlays over it
+    void present() {
+        if (!m_initialized) return;
+        m_driver.setBrightness(m_outputBrightness);
+        m_driver.show();
     }
     
     void setDemoTimeout(uint32_t timeoutMs) {
@@ -674,6 +514,7 @@ public:
         if (!demo) {
             m_lastAudioTime = xTaskGetTickCount();
         }
+        wake();
     }
     
     // OTA progress display mode
@@ -683,19 +524,54 @@ public:
         if (enabled) {
             ESP_LOGI(LED_TAG, "LED OTA mode enabled");
         }
+        wake();
     }
     
     void setOtaProgress(uint8_t percent) {
         if (percent > 100) percent = 100;
         m_otaProgress = percent;
+        wake();
     }
     
     bool isOtaMode() const { return m_otaMode; }
+
+    // Memory pressure: hold the current frame instead of running effects.
+    // OTA, pairing and overlays still render.
+    void setEffectsPaused(bool paused) {
+        if (m_effectsPaused == paused) return;
+        m_effectsPaused = paused;
+        wake();
+        ESP_LOGI(LED_TAG, "LED effects %s", paused ? "paused" : "resumed");
+    }
+
+    bool isEffectsPaused() const { return m_effectsPaused; }
+
+    // Effect frames rendered since boot (wrapping); LED task writes
+    uint32_t effectFrames() const { return m_effectFrames; }
+    
+    // LED task, woken by the setters above while it idles
+    void setTask(TaskHandle_t task) { m_task = task; }
+    void wake() {
+        if (m_task) xTaskNotifyGive(m_task);
+    }
+    
+    // Nothing new reached the LEDs for a few frames: no need to render
+    // at the frame rate until something changes
+    bool isStill() const {
+        return m_driver.unchangedFrames() >= LED_IDLE_FRAMES;
+    }
+    
+    // Between effect frames: resend the last frame if it has levels
+    // left to dither (LED_DITHER), nothing is rendered
+    void refreshOutput() {
+        if (m_initialized && m_driver.needsRefresh()) m_driver.show();
+    }
     
     // Render OTA progress bar on the LED matrix
     void renderOtaProgress() {
         if (!m_initialized) return;
         
+        m_driver.setLayers(nullptr, 0);
         m_driver.clear();
         
         // Calculate how many LEDs to light up (256 total, map 0-100% to 0-256)
@@ -749,11 +625,172 @@ private:
             delete m_effects[i];
         }
     }
+
+    // Overlays, bottom to top; ids are also bits of m_overlays
+    enum : int {
+        OVERLAY_TRACK,
+        OVERLAY_EQ,
+        OVERLAY_VOLUME,
+        OVERLAY_PAIRING,
+        OVERLAY_PAIRED,
+        OVERLAY_COUNT
+    };
+    
+    // Any task: parameters are stored first, the LED task picks them up
+    void postOverlay(int id) {
+        m_overlayEvents.fetch_or((uint8_t)(1u << id), std::memory_order_release);
+        wake();
+    }
+    
+    // LED task: (re)start or stop the overlays that were posted
+    void applyOverlayEvents(TickType_t now) {
+        const uint8_t events = m_overlayEvents.exchange(0, std::memory_order_acquire);
+        if (!events) return;
+        for (int id = 0; id < OVERLAY_COUNT; id++) {
+            if (events & (1u << id)) {
+                m_overlays |= (uint8_t)(1u << id);
+                m_overlayStart[id] = now;
+            }
+        }
+        if (events & (1u << OVERLAY_EQ)) drawEqSprite();
+#if APP_TRACK_INFO
+        if (events & (1u << OVERLAY_TRACK)) {
+            portENTER_CRITICAL(&m_trackLock);
+            const int cols = m_trackPendingCols;
+            memcpy(m_trackStrip, m_trackPending, cols);
+            portEXIT_CRITICAL(&m_trackLock);
+            // Rendered once here; each frame blits a window of it
+            if (m_trackText.set(m_trackStrip, cols, RGB_SPI(255, 255, 255), 255,
+                                SpritePx{0, 0, 0, OVERLAY_BACKING_ALPHA})) {
+                spriteClear(m_trackSprite);
+                m_trackScroll = INT16_MIN;
+                m_trackBarShown = TRACK_BAR_NONE;
+            } else {
+                m_overlays &= ~(1u << OVERLAY_TRACK);
+            }
+        }
+#endif
+        if (events & (1u << OVERLAY_PAIRED)) m_overlays &= ~(1u << OVERLAY_PAIRING);
+        if ((events & (1u << OVERLAY_PAIRING)) && !m_pairingModeActive) {
+            m_overlays &= ~(1u << OVERLAY_PAIRING);
+        }
+    }
+    
+    // Hold at full, then fade out over the rest of the overlay time
+    static uint8_t overlayFade(uint32_t elapsedMs) {
+        if (elapsedMs < VOLUME_OVERLAY_HOLD_MS) return 255;
+        const uint32_t fadeElapsed = elapsedMs - VOLUME_OVERLAY_HOLD_MS;
+        const uint32_t fadeDuration = VOLUME_OVERLAY_DURATION_MS - VOLUME_OVERLAY_HOLD_MS;
+        return (uint8_t)(255 - fadeElapsed * 255 / fadeDuration);
+    }
+    
+    static void spriteClear(SpritePx* sprite) {
+        for (int i = 0; i < LED_MATRIX_COUNT; i++) {
+            sprite[i] = SpritePx{0, 0, 0, OVERLAY_BACKING_ALPHA};
+        }
+    }
+    
+    static void spriteSet(SpritePx* sprite, int x, int y, RGB_SPI c) {
+        if (x < 0 || x >= LED_MATRIX_WIDTH || y < 0 || y >= LED_MATRIX_HEIGHT) return;
+        sprite[LedFrame::indexXY(x, y)] = SpritePx{c.r, c.g, c.b, 255};
+    }
+    
+    // Volume bar, filled bottom to top; the shown level eases toward
+    // the target and the sprite is redrawn only when a row changes
+    void updateVolumeSprite() {
+        float targetVol = m_volumeDisplayTarget * fast_recipsf2(127.0f);
+        m_volumeDisplaySmooth += (targetVol - m_volumeDisplaySmooth) * 0.3f;
+        
+        int filledRows = (int)(m_volumeDisplaySmooth * LED_MATRIX_HEIGHT + 0.5f);
+        if (filledRows == m_volumeSpriteRows) return;
+        m_volumeSpriteRows = filledRows;
+        
+        spriteClear(m_volumeSprite);
+        for (int row = 0; row < filledRows && row < LED_MATRIX_HEIGHT; row++) {
+            int displayRow = LED_MATRIX_HEIGHT - 1 - row;  // Bottom to top
+            
+            // White (255,255,255) at bottom, Red (255,0,0) at top
+            float rowPct = (float)row * fast_recipsf2((float)(LED_MATRIX_HEIGHT - 1));
+            uint8_t gb = (uint8_t)(255 * (1.0f - rowPct));
+            
+            for (int col = 0; col < LED_MATRIX_WIDTH; col++) {
+                // Center columns brighter, 70% at the edges
+                float colDist = fabsf(col - (LED_MATRIX_WIDTH - 1) * 0.5f) * fast_recipsf2((LED_MATRIX_WIDTH - 1) * 0.5f);
+                float colFade = 1.0f - colDist * 0.3f;
+                spriteSet(m_volumeSprite, col, displayRow,
+                          RGB_SPI((uint8_t)(255 * colFade), (uint8_t)(gb * colFade), (uint8_t)(gb * colFade)));
+            }
+        }
+    }
+    
+#if APP_TRACK_INFO
+    // Text window at this scroll position (one row copy per text row),
+    // and the position bar on the bottom row; each only when it moved
+    void updateTrackSprite(int scroll) {
+        if (scroll != m_trackScroll) {
+            m_trackScroll = (int16_t)scroll;
+            m_trackText.blitWindow(m_trackSprite, scroll);
+        }
+        const uint8_t bar = m_trackBar.load(std::memory_order_relaxed);
+        if (bar == m_trackBarShown) return;
+        m_trackBarShown = bar;
+        const int lit = bar == TRACK_BAR_NONE ? 0 : bar;
+        for (int x = 0; x < LED_MATRIX_WIDTH; x++) {
+            const SpritePx px = x < lit ? SpritePx{0, 90, 120, 255} : SpritePx{0, 0, 0, OVERLAY_BACKING_ALPHA};
+            m_trackSprite[LedFrame::indexXY(x, LED_MATRIX_HEIGHT - 1)] = px;
+        }
+    }
+#endif
+    
+    // 3 vertical bars for bass/mid/treble, up or down from the centre row
+    void drawEqSprite() {
+        spriteClear(m_eqSprite);
+        
+        // EQ range: -12 to +12 dB, map to 0-16 rows (center = 8)
+        auto mapEqToRows = [](int8_t val) -> int {
+            return 8 + (val * 8 / 12);
+        };
+        
+        auto drawBar = [&](int startCol, int rows, RGB_SPI color) {
+            const int centerRow = 8;
+            const int barWidth = 4;
+            
+            if (rows >= centerRow) {
+                // Positive: draw from center upward
+                for (int row = centerRow; row < rows && row < LED_MATRIX_HEIGHT; row++) {
+                    for (int col = startCol; col < startCol + barWidth; col++) {
+                        spriteSet(m_eqSprite, col, LED_MATRIX_HEIGHT - 1 - row, color);
+                    }
+                }
+            } else {
+                // Negative: draw from center downward, dimmer
+                RGB_SPI dim = color.scale(128);
+                for (int row = rows; row < centerRow; row++) {
+                    for (int col = startCol; col < startCol + barWidth; col++) {
+                        spriteSet(m_eqSprite, col, LED_MATRIX_HEIGHT - 1 - row, dim);
+                    }
+                }
+            }
+            
+            // Center line marker (dim white)
+            for (int col = startCol; col < startCol + barWidth; col++) {
+                spriteSet(m_eqSprite, col, LED_MATRIX_HEIGHT - 1 - centerRow, RGB_SPI(40, 40, 40));
+            }
+        };
+        
+        drawBar(1, mapEqToRows(m_eqBass), RGB_SPI(255, 0, 0));       // Bass on left, red
+        drawBar(6, mapEqToRows(m_eqMid), RGB_SPI(0, 0, 255));        // Mid in center, blue
+        drawBar(11, mapEqToRows(m_eqTreble), RGB_SPI(255, 255, 0));  // Treble on right, yellow
+    }
+    
     
     LedController(const LedController&) = delete;
     LedController& operator=(const LedController&) = delete;
     
     void createEffects() {
+#ifdef CONFIG_LED_PROFILE
+        m_profile.init();
+#endif
         m_effects[LED_EFFECT_SPECTRUM_BARS] = new SpectrumBarsEffect();
         m_effects[LED_EFFECT_BEAT_PULSE] = new BeatPulseEffect();
         m_effects[LED_EFFECT_RIPPLE] = new RippleEffect();
@@ -777,8 +814,20 @@ private:
         m_effects[LED_EFFECT_BOUNCING_BALLS] = new BouncingBallsEffect();
         m_effects[LED_EFFECT_LAVA_LAMP] = new LavaLampEffect();
         m_effects[LED_EFFECT_AMBIENT] = new AmbientEffect();
+#if LED_ANIMATION
+        m_effects[LED_EFFECT_CUSTOM] = new CustomAnimationEffect(m_animation);
+#endif
         m_effects[LED_EFFECT_VOLUME] = new VolumeEffect();
     }
+
+    // Cycled through: built, and the Custom effect only with an animation
+    bool selectable(int id) const {
+        if (!m_effects[id]) return false;
+#if LED_ANIMATION
+        if (id == LED_EFFECT_CUSTOM) return m_animation.loaded();
+#endif
+        return true;
+    }
     
     LedEffect* getCurrentEffect() {
         if (m_currentEffect >= 0 && m_currentEffect < LED_EFFECT_COUNT) {
@@ -788,50 +837,24 @@ private:
     }
     
     void loadSettings() {
-        nvs_handle_t handle;
-        if (nvs_open("led", NVS_READONLY, &handle) == ESP_OK) {
-            // First try to load the blob (has all settings)
-            size_t len = 10;
-            bool blobLoaded = false;
-            if (nvs_get_blob(handle, "settings", m_ledSettings, &len) == ESP_OK && len == 10) {
-                // Blob has: [brightness, r1, g1, b1, r2, g2, b2, gradient, speed, effectId]
-                m_brightness = m_ledSettings[0];
-                m_currentEffect = m_ledSettings[9];
-                if (m_currentEffect >= LED_EFFECT_COUNT) {
-                    m_currentEffect = 0;
-                }
-                blobLoaded = true;
-                ESP_LOGI(LED_TAG, "Loaded LED settings blob: effect=%d, brightness=%d", m_currentEffect, m_brightness);
-                
-                // Apply to Ambient effect
-                AmbientEffect* ambient = static_cast<AmbientEffect*>(m_effects[LED_EFFECT_AMBIENT]);
-                if (ambient) {
-                    ambient->setSettings(m_ledSettings, 10);
-                }
-            }
-            
-            // Fallback: load individual keys if blob not available (legacy support)
-            if (!blobLoaded) {
-                int32_t effect = 0;
-                if (nvs_get_i32(handle, "effect", &effect) == ESP_OK) {
-                    if (effect >= 0 && effect < LED_EFFECT_COUNT) {
-                        m_currentEffect = effect;
-                    }
-                }
-                
-                uint8_t brightness = LED_DEFAULT_BRIGHTNESS;
-                if (nvs_get_u8(handle, "bright", &brightness) == ESP_OK) {
-                    m_brightness = brightness;
-                }
-                
-                // Sync m_ledSettings with loaded values
-                m_ledSettings[0] = m_brightness;
-                m_ledSettings[9] = (uint8_t)m_currentEffect;
-                
-                ESP_LOGI(LED_TAG, "Loaded settings from keys: effect=%d, brightness=%d", m_currentEffect, m_brightness);
-            }
-            
-            nvs_close(handle);
+        if (!m_haveSaved) {
+            // Defaults; keep m_ledSettings in step with them
+            m_ledSettings[0] = m_brightness;
+            m_ledSettings[9] = (uint8_t)m_currentEffect;
+            return;
+        }
+        // [brightness, r1, g1, b1, r2, g2, b2, gradient, speed, effectId]
+        m_brightness = m_ledSettings[0];
+        m_currentEffect = m_ledSettings[9];
+        if (m_currentEffect >= LED_EFFECT_COUNT) {
+            m_currentEffect = 0;
+        }
+        ESP_LOGI(LED_TAG, "Loaded LED settings: effect=%d, brightness=%d", m_currentEffect, m_brightness);
+        
+        // Apply to Ambient effect
+        AmbientEffect* ambient = static_cast<AmbientEffect*>(m_effects[LED_EFFECT_AMBIENT]);
+        if (ambient) {
+            ambient->setSettings(m_ledSettings, 10);
         }
     }
     
@@ -839,22 +862,14 @@ private:
         // Ensure m_ledSettings is in sync
         m_ledSettings[0] = m_brightness;
         m_ledSettings[9] = (uint8_t)m_currentEffect;
-        
-        nvs_handle_t handle;
-        if (nvs_open("led", NVS_READWRITE, &handle) == ESP_OK) {
-            nvs_set_i32(handle, "effect", m_currentEffect);
-            nvs_set_u8(handle, "bright", m_brightness);
-            nvs_set_blob(handle, "settings", m_ledSettings, 10);
-            nvs_commit(handle);
-            nvs_close(handle);
-            ESP_LOGI(LED_TAG, "Saved settings: effect=%d, brightness=%d", m_currentEffect, m_brightness);
-        }
+        saveLedSettings();
     }
     
 public:
     // Startup animation - colorful spiral wipe (public so main can trigger it)
     void playStartupAnimation() {
         ESP_LOGI(LED_TAG, "Playing startup animation...");
+        m_driver.setLayers(nullptr, 0);
         
         // Fixed brightness for startup animation (15% = 38/255)
         const uint8_t startupBrightness = 38;
@@ -953,13 +968,73 @@ public:
         ESP_LOGI(LED_TAG, "Startup animation complete");
     }
     
-    LedDriverSPI m_driver;  // SPI DMA driver
+    // Effect frames (render + show) over the frame period; a run of
+    // LED_OVERRUN_STREAK drops the effect one quality level
+    void checkFrameBudget(LedEffect* effect, uint32_t renderCycles, uint32_t showCycles) {
+        const uint32_t renderUs = renderCycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+        const uint32_t showUs = showCycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+        const bool overrun = renderUs + showUs > FRAME_BUDGET_US;
+        m_effectFrames++;
+#ifdef CONFIG_LED_PROFILE
+        m_profile.record(m_currentEffect, renderUs, showUs, overrun);
+#endif
+        if (!overrun) {
+            m_overrunStreak = 0;
+            return;
+        }
+        if (++m_overrunStreak < LED_OVERRUN_STREAK) return;
+        m_overrunStreak = 0;
+        if (effect->reduceQuality()) {
+            invalidateDemo();
+            ESP_LOGW(LED_TAG, "%s: %u us per frame (budget %u), quality level %u", effect->getName(),
+                     (unsigned)(renderUs + showUs), (unsigned)FRAME_BUDGET_US, effect->qualityLevel());
+        }
+    }
+    
+    // One effect step into the framebuffer: demo (or its recorded
+    // loop) without audio, else the live effect
+    void stepEffect(LedEffect* effect, const AudioData& audio) {
+        if (m_inDemoMode) {
+#if LED_DEMO_CACHE
+            if (!m_demoCache.replay(m_driver)) {
+                effect->updateDemo();
+                m_demoCache.record(m_driver);
+            }
+#else
+            effect->updateDemo();
+#endif
+        } else {
+            effect->update(audio);
+#if LED_DEMO_CACHE
+            m_demoCache.interrupt();
+#endif
+        }
+    }
+    
+    // Recorded demo loop no longer what the effect would draw
+    void invalidateDemo() {
+#if LED_DEMO_CACHE
+        m_demoCache.invalidate();
+#endif
+    }
+    
+    static constexpr uint32_t FRAME_BUDGET_US = 1000000 / LED_FPS;
+#if LED_INTERPOLATE
+    static constexpr uint32_t TICK_US = 1000000 / LED_TICK_HZ;
+#endif
+    
+    LedDriver m_driver;     // SPI or I2S parallel DMA driver
     LedEffect* m_effects[LED_EFFECT_COUNT] = {nullptr};
+#if LED_ANIMATION
+    LedAnimation m_animation;       // The Custom effect's
+#endif
     
     int m_currentEffect = LED_EFFECT_SPECTRUM_BARS;
     uint8_t m_brightness = LED_DEFAULT_BRIGHTNESS;
     uint8_t m_currentVolume = 64;  // Current volume level (0-127)
     uint8_t m_ledSettings[10] = {128, 255, 0, 128, 0, 128, 255, 0, 50, 0};  // Default LED settings
+    bool m_haveSaved = false;
+    SettingsSaveCb m_saveCb = nullptr;
     bool m_initialized = false;
     
     bool m_inDemoMode = true;
@@ -969,40 +1044,75 @@ public:
     // OTA progress display
     bool m_otaMode = false;
     uint8_t m_otaProgress = 0;
-    
-    // Volume overlay display
+
+    volatile bool m_effectsPaused = false;
+    TaskHandle_t m_task = nullptr;
+    uint8_t m_overrunStreak = 0;
+    volatile uint32_t m_effectFrames = 0;
+#if LED_INTERPOLATE
+    // Last two effect steps (see update); the driver's framebuffer
+    // holds the interpolated frame
+    RGB16 m_steps[2][LED_MATRIX_COUNT] = {};
+    uint8_t m_stepNew = 0;
+    int64_t m_lastFrameUs = 0;
+    uint32_t m_tickAccUs = 0;
+    bool m_beatPending = false;
+#endif
+#ifdef CONFIG_LED_PROFILE
+    LedProfile m_profile;
+#endif
+#if LED_DEMO_CACHE
+    LedDemoCache m_demoCache;
+#endif
+#if LED_PARALLEL_RENDER
+    LedBands m_bands;
+#endif
+    
+    // Overlays (see composeLayers)
     static constexpr uint32_t VOLUME_OVERLAY_DURATION_MS = 2500;  // Total display time
     static constexpr uint32_t VOLUME_OVERLAY_HOLD_MS = 1500;      // Hold at full brightness
-    bool m_volumeOverlayActive = false;
-    TickType_t m_volumeOverlayStart = 0;
+    static constexpr uint32_t PAIRING_PULSE_PERIOD_MS = 2000;     // 2 seconds per pulse cycle
+    static constexpr uint32_t PAIRING_SUCCESS_DURATION_MS = 500;  // 500ms for 2 fast pulses
+    static constexpr uint8_t OVERLAY_MIN_BRIGHTNESS = 10;         // Volume / EQ
+    static constexpr uint8_t PAIRING_MIN_BRIGHTNESS = 40;
+    static constexpr uint8_t PAIRED_MIN_BRIGHTNESS = 60;
+    static constexpr uint8_t OVERLAY_BACKING_ALPHA = 160;         // Effect dimmed behind a bar sprite
+    std::atomic<uint8_t> m_overlayEvents{0};    // Posted, not yet applied
+    uint8_t m_overlays = 0;                     // Shown; LED task only
+    TickType_t m_overlayStart[OVERLAY_COUNT] = {};
+    LedLayer m_layerStack[OVERLAY_COUNT + 1] = {{nullptr, RGB_SPI(), 255}};  // [0] black backdrop
+    uint8_t m_outputBrightness = LED_DEFAULT_BRIGHTNESS;
+    SpritePx m_volumeSprite[LED_MATRIX_COUNT];
+    SpritePx m_eqSprite[LED_MATRIX_COUNT];
+#if APP_TRACK_INFO
+    static constexpr size_t TRACK_STRIP_MAX = 64 * LED_FONT_ADVANCE;   // 64 glyphs
+    static constexpr uint32_t TRACK_SCROLL_PX_PER_S = 20;
+    static constexpr uint8_t TRACK_BAR_NONE = 0xFF;
+    portMUX_TYPE m_trackLock = portMUX_INITIALIZER_UNLOCKED;
+    uint8_t m_trackPending[TRACK_STRIP_MAX];    // Laid out, under m_trackLock
+    uint16_t m_trackPendingCols = 0;
+    uint8_t m_trackStrip[TRACK_STRIP_MAX];      // Taken from pending; LED task only
+    LedTextStrip m_trackText{TRACK_STRIP_MAX, (LED_MATRIX_HEIGHT - LED_FONT_H) / 2};
+    int16_t m_trackScroll = INT16_MIN;          // Drawn into m_trackSprite
+    uint8_t m_trackBarShown = TRACK_BAR_NONE;
+    std::atomic<uint8_t> m_trackBar{TRACK_BAR_NONE};   // Lit columns
+    SpritePx m_trackSprite[LED_MATRIX_COUNT];
+#endif
+    
     uint8_t m_volumeDisplayTarget = 64;
     float m_volumeDisplaySmooth = 0.5f;
+    int m_volumeSpriteRows = -1;
     
-    // Temporary brightness override for volume overlay when user brightness is 0
-    // This allows volume overlay to be visible even when effects are disabled
-    uint8_t m_overlayBrightness = 0;
-    
-    // Flag to request startup animation from LED task context
-    volatile bool m_pendingStartupAnimation = false;
-    volatile bool m_startupAnimationRunning = false;
-    bool m_volumeBrightnessOverride = false;
-    uint8_t m_brightnessBeforeVolume = 0;
-    
-    // EQ overlay display (same timing as volume)
-    bool m_eqOverlayActive = false;
-    TickType_t m_eqOverlayStart = 0;
     int8_t m_eqBass = 0;
     int8_t m_eqMid = 0;
     int8_t m_eqTreble = 0;
     uint8_t m_eqType = 0;  // 0=bass, 1=mid, 2=treble
     
-    // Pairing mode animation
-    static constexpr uint32_t PAIRING_PULSE_PERIOD_MS = 2000;     // 2 seconds per pulse cycle
-    static constexpr uint32_t PAIRING_SUCCESS_DURATION_MS = 500;  // 500ms for 2 fast pulses
-    bool m_pairingModeActive = false;
-    TickType_t m_pairingModeStart = 0;
-    bool m_pairingSuccessActive = false;
-    TickType_t m_pairingSuccessStart = 0;
+    volatile bool m_pairingModeActive = false;
+    
+    // Flag to request startup animation from LED task context
+    volatile bool m_pendingStartupAnimation = false;
+    volatile bool m_startupAnimationRunning = false;
 };
 
 // -----------------------------------------------------------
@@ -1011,11 +1121,8 @@ public:
 
 static TaskHandle_t ledTaskHandle = nullptr;
 static volatile bool ledTaskRunning = false;
-static volatile bool ledBeatDetected = false;
 static DSPProcessor* g_ledDsp = nullptr;
 
-inline void setLedBeat(bool beat) { ledBeatDetected = beat; }
-
 // Helper struct to hold audio readings - avoids optimizer issues
 struct LedAudioReadings {
     float bass;
@@ -1025,6 +1132,10 @@ struct LedAudioReadings {
     float midDb;
     float highDb;
     bool audioPlaying;
+    uint32_t beatCount;     // Of the snapshot read (LED_AUDIO_SYNC beat edges)
+    int numBands;
+    float bands[AudioData::MAX_BANDS];
+    float bandPeaks[AudioData::MAX_BANDS];
 };
 
 // -----------------------------------------------------------
@@ -1152,20 +1263,34 @@ static void __attribute__((noinline)) readDspData(LedAudioReadings& r) {
     r.midDb = -60.0f;
     r.highDb = -60.0f;
     r.audioPlaying = false;
+    r.numBands = 0;
     
     if (g_ledDsp) {
         // Get LED audio boost factor (increases as volume decreases)
         // At low volumes, boost audio levels so LEDs can still react
         float ledBoost = g_ledDsp->getLedAudioBoost();
-        
-        r.bassDb = g_ledDsp->getGoertzel30dB();
-        r.midDb = g_ledDsp->getGoertzel60dB();
-        r.highDb = g_ledDsp->getGoertzel100dB();
+
+        // One consistent snapshot from the analysis task: with the sync,
+        // the one being heard now rather than the newest (one step
+        // ahead with LED_INTERPOLATE, which shows a step a step late)
+        AnalysisResult a;
+#if LED_AUDIO_SYNC
+        const uint32_t nowUs = (uint32_t)esp_timer_get_time() - LED_AUDIO_SYNC_TRIM_MS * 1000 +
+                               LED_INTERPOLATE * (1000000 / LED_TICK_HZ);
+        if (!g_ledDsp->analyzer().readHeard(a, nowUs)) g_ledDsp->analyzer().read(a);
+#else
+        g_ledDsp->analyzer().read(a);
+#endif
+        r.beatCount = a.beatCount;
+        
+        r.bassDb = a.bandDB[0];
+        r.midDb = a.bandDB[1];
+        r.highDb = a.bandDB[2];
         
         // Read raw linear levels
-        float rawBass = g_ledDsp->getGoertzel30Lin() + g_ledDsp->getGoertzel60Lin();
-        float rawMid = g_ledDsp->getGoertzel100Lin();
-        float rawHigh = g_ledDsp->getPeakLin(2);
+        float rawBass = a.bandLin[0] + a.bandLin[1];
+        float rawMid = a.bandLin[2];
+        float rawHigh = a.peakLin[2];
         
         // Apply LED audio boost for low volume visibility
         // This allows LEDs to react even at 1-2% volume
@@ -1186,19 +1311,27 @@ static void __attribute__((noinline)) readDspData(LedAudioReadings& r) {
         r.high = rawHigh;
         g_agc.normalize(r.bass, r.mid, r.high);
         
+#if APP_DSP_SPECTRUM
+        // FFT bands get the volume boost only; the effects map them in dB
+        r.numBands = SpectrumAnalyzer::BANDS;
+        for (int i = 0; i < SpectrumAnalyzer::BANDS; i++) {
+            float v = a.spectrum[i] * ledBoost;
+            float p = a.spectrumPeak[i] * ledBoost;
+            r.bands[i] = v > 1.0f ? 1.0f : v;
+            r.bandPeaks[i] = p > 1.0f ? 1.0f : p;
+        }
+#endif
+        
         // Very low threshold for audio detection (-90dB for 1% volume support)
         r.audioPlaying = (r.bassDb > -90.0f || r.midDb > -90.0f || r.highDb > -90.0f);
     }
 }
 
-static void ledTask(void* param) {
-    ESP_LOGI(LED_TAG, ">>> LED TASK ENTRY <<<");
-    
-    // Delay briefly to let other startup logs clear
-    vTaskDelay(pdMS_TO_TICKS(100));
-    ESP_LOGI(LED_TAG, "LED task starting on core %d...", xPortGetCoreID());
-    
+// Driver, effects and saved settings. Boot runs this ahead of the LED task
+// so BLE can read brightness and effect; the task runs it if nobody did
+inline bool initLedController() {
     LedController& controller = LedController::getInstance();
+    if (controller.isInitialized()) return true;
     
     // Initialize with configured GPIO and brightness
     #ifdef CONFIG_LED_MATRIX_GPIO
@@ -1215,8 +1348,44 @@ static void ledTask(void* param) {
         uint8_t brightness = LED_DEFAULT_BRIGHTNESS;
     #endif
     
-    if (!controller.init(gpio, brightness)) {
+    return controller.init(gpio, brightness);
+}
+
+// Next frame at the frame rate, or while the picture is still, when a
+// setter wakes the task (or at the idle poll, for audio coming back).
+// At the frame rate the last frame is resent LED_DITHER_REFRESH - 1
+// times in between, evenly spaced, for the dither.
+static inline void ledWaitNextFrame(LedController& controller, TickType_t& lastWake,
+                                    TickType_t frameDelay, bool still) {
+    // Frames on time need the chip awake; a still picture lets it sleep
+    PowerManager::getInstance().set(PowerManager::ANIMATION, !still);
+    if (still) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LED_IDLE_POLL_MS));
+        lastWake = xTaskGetTickCount();
+        return;
+    }
+#if LED_DITHER
+    const TickType_t step = frameDelay / LED_DITHER_REFRESH;
+    if (step > 0) {
+        TickType_t at = lastWake;
+        for (int i = 1; i < LED_DITHER_REFRESH; i++) {
+            vTaskDelayUntil(&at, step);
+            controller.refreshOutput();
+        }
+    }
+#endif
+    vTaskDelayUntil(&lastWake, frameDelay);
+}
+
+static void ledTask(void* param) {
+    ESP_LOGI(LED_TAG, ">>> LED TASK ENTRY <<<");
+    ESP_LOGI(LED_TAG, "LED task starting on core %d...", xPortGetCoreID());
+    
+    LedController& controller = LedController::getInstance();
+    
+    if (!initLedController()) {
         ESP_LOGE(LED_TAG, "Failed to initialize LED controller");
+        controller.setStartupAnimationRunning(false);
         vTaskDelete(nullptr);
         return;
     }
@@ -1225,6 +1394,7 @@ static void ledTask(void* param) {
         controller.setDemoTimeout(CONFIG_LED_DEMO_TIMEOUT * 1000);
     #endif
     
+    controller.setTask(xTaskGetCurrentTaskHandle());
     TickType_t lastWake = xTaskGetTickCount();
     
     #ifdef CONFIG_LED_FPS
@@ -1233,7 +1403,12 @@ static void ledTask(void* param) {
         const TickType_t frameDelay = pdMS_TO_TICKS(1000 / 30);  // 30 FPS default
     #endif
     
-    bool lastBeat = false;
+#if LED_AUDIO_SYNC
+    uint32_t lastBeatCount = 0;
+#else
+    // Beats as the beat task hears them, one event each
+    EventBus::Mailbox* events = EventBus::getInstance().subscribe(BUS_MASK(BUS_BEAT));
+#endif
     LedAudioReadings readings;
     
     while (ledTaskRunning) {
@@ -1243,52 +1418,42 @@ static void ledTask(void* param) {
             controller.playStartupAnimation();
             controller.setStartupAnimationRunning(false);
         }
+
+        // Beat events are taken every frame, also frames without effects,
+        // so none is left over for later
+        bool beat = false;
+#if !LED_AUDIO_SYNC
+        for (BusMsg msg; events && events->take(msg);) beat = true;
+#endif
         
         // Check if in OTA mode - render progress bar instead of effects
         if (controller.isOtaMode()) {
             controller.renderOtaProgress();
-            vTaskDelayUntil(&lastWake, frameDelay);
-            continue;
-        }
-        
-        // Check if pairing success animation should be shown (highest priority after OTA)
-        if (controller.isPairingSuccessActive()) {
-            controller.renderPairingSuccess();
-            vTaskDelayUntil(&lastWake, frameDelay);
-            continue;
-        }
-        
-        // Check if pairing mode animation should be shown
-        if (controller.isPairingModeActive()) {
-            controller.renderPairingMode();
-            vTaskDelayUntil(&lastWake, frameDelay);
+            ledWaitNextFrame(controller, lastWake, frameDelay, controller.isStill());
             continue;
         }
         
-        // Check if volume overlay should be shown (takes priority)
-        if (controller.isVolumeOverlayActive()) {
-            controller.renderVolumeOverlay();
-            vTaskDelayUntil(&lastWake, frameDelay);
-            continue;
-        }
+        // Volume / EQ / pairing overlays for this frame, over the effect
+        controller.composeLayers(xTaskGetTickCount());
         
-        // Check if EQ overlay should be shown
-        if (controller.isEqOverlayActive()) {
-            controller.renderEqOverlay();
-            vTaskDelayUntil(&lastWake, frameDelay);
+        // Effects paused (memory pressure): keep the last frame, overlays
+        // still go over it
+        if (controller.isEffectsPaused()) {
+            controller.present();
+            ledWaitNextFrame(controller, lastWake, frameDelay,
+                             !controller.hasOverlays() || controller.isStill());
             continue;
         }
         
         // Get audio data from DSP processor using helper to avoid ICE
         readDspData(readings);
         
-        // Detect beat edge
-        bool beat = false;
-        bool currentBeat = ledBeatDetected;
-        if (currentBeat && !lastBeat) {
-            beat = true;
-        }
-        lastBeat = currentBeat;
+#if LED_AUDIO_SYNC
+        // From the delayed snapshot: the beat task's events are on time
+        // for the beat LED, so ahead of what is heard
+        beat = readings.beatCount != lastBeatCount;
+        lastBeatCount = readings.beatCount;
+#endif
         
         // Calculate beat intensity from bass
         float beatIntensity = readings.bass;
@@ -1296,39 +1461,45 @@ static void ledTask(void* param) {
         // Update LED controller
         controller.update(readings.bass, readings.mid, readings.high, 
                           readings.bassDb, readings.midDb, readings.highDb, 
-                          beat, beatIntensity, readings.audioPlaying);
+                          beat, beatIntensity, readings.audioPlaying,
+                          readings.bands, readings.bandPeaks, readings.numBands);
         
-        vTaskDelayUntil(&lastWake, frameDelay);
+        ledWaitNextFrame(controller, lastWake, frameDelay, controller.isStill());
     }
     
     ESP_LOGI(LED_TAG, "LED task stopped");
     vTaskDelete(nullptr);
 }
 
-inline void startLedTask(DSPProcessor* dsp, int priority = 3, int stackSize = 4096) {
-    ESP_LOGI(LED_TAG, "startLedTask() called: dsp=%p, priority=%d, stack=%d", dsp, priority, stackSize);
+inline void startLedTask(DSPProcessor* dsp, int priority = 3, int stackSize = 4096, int core = 0) {
+    ESP_LOGI(LED_TAG, "startLedTask() called: dsp=%p, priority=%d, stack=%d, core=%d", dsp, priority, stackSize, core);
     ESP_LOGI(LED_TAG, "Free heap: %lu, internal: %lu, PSRAM: %lu", 
              esp_get_free_heap_size(), 
              heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT),
              heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
     if (!ledTaskRunning) {
         g_ledDsp = dsp;
+#if LED_AUDIO_SYNC
+        if (dsp && !dsp->analyzer().enableHistory()) {
+            ESP_LOGW(LED_TAG, "No memory for analysis history, LEDs follow the newest audio");
+        }
+#endif
         ledTaskRunning = true;
         
         // RMT driver requires task stack in internal RAM (not PSRAM)
-        // Using standard xTaskCreatePinnedToCore for compatibility
+        // (the static arena's in a static allocation build)
         ESP_LOGI(LED_TAG, "Creating LED task with internal RAM stack...");
-        BaseType_t ret = xTaskCreatePinnedToCore(
+        BaseType_t ret = StaticAlloc::createTask(
             ledTask, 
             "led_task", 
             stackSize, 
             nullptr, 
             priority, 
             &ledTaskHandle, 
-            0  // Core 0 - core 1 is busy with Bluetooth
+            core  // Keep off the audio core
         );
         
-        ESP_LOGI(LED_TAG, "xTaskCreatePinnedToCore returned: %d, handle=%p", ret, ledTaskHandle);
+        ESP_LOGI(LED_TAG, "LED task create returned: %d, handle=%p", ret, ledTaskHandle);
         if (ret != pdPASS) {
             ESP_LOGE(LED_TAG, "FAILED to create LED task! Error: %d", ret);
             ledTaskRunning = false;
@@ -0,0 +1,117 @@
+#pragma once
+
+// -----------------------------------------------------------
+// LED Demo Cache - demo mode replayed from recorded frames
+// (LED_DEMO_CACHE)
+// - The first LED_DEMO_CACHE_SECONDS of an effect's demo (after a
+//   settle period) are recorded as it plays; from then on the loop is
+//   replayed into the framebuffer and the effect is not run
+// - The last LED_DEMO_CACHE_BLEND frames recorded are crossfaded into
+//   the first ones, so the loop has no seam
+// - Framebuffer frames, not encoded DMA data: brightness, gamma,
+//   dither and overlays still apply when the frame is sent
+// - Invalidated (from any task) on effect, settings, brightness or
+//   quality change; recording then starts over
+// - PSRAM only: without it the demo keeps running live
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "led_config.h"
+#include "led_frame.h"
+
+class LedDemoCache {
+public:
+    static constexpr int FRAMES = LED_DEMO_CACHE_SECONDS * LED_TICK_HZ;
+    static constexpr int BLEND = LED_DEMO_CACHE_BLEND;
+    static constexpr int SETTLE = LED_TICK_HZ;    // Demo frames before recording
+    static_assert(BLEND < FRAMES, "crossfade longer than the loop");
+
+    ~LedDemoCache() {
+        if (m_frames) heap_caps_free(m_frames);
+    }
+
+    // Any task: the recorded loop no longer matches the effect
+    void invalidate() { m_generation.fetch_add(1, std::memory_order_release); }
+
+    // LED task, each demo frame: the next loop frame into frame, or
+    // false when the effect has to render it (then pass the result to
+    // record())
+    bool replay(LedFrame& frame) {
+        const uint32_t gen = m_generation.load(std::memory_order_acquire);
+        if (gen != m_recordedGen) {
+            m_recordedGen = gen;
+            m_count = -SETTLE;
+            m_pos = 0;
+        }
+        if (m_count < FRAMES + BLEND) return false;
+        frame.loadFrame(m_frames + (size_t)m_pos * LED_MATRIX_COUNT);
+        if (++m_pos == FRAMES) m_pos = 0;
+        return true;
+    }
+
+    // LED task, each live (audio) frame: a recording cut short starts
+    // over, so the loop is one continuous take
+    void interrupt() {
+        if (m_count < FRAMES + BLEND) m_count = -SETTLE;
+    }
+
+    void record(const LedFrame& frame) {
+        if (m_count < 0) {
+            m_count++;
+            return;
+        }
+        if (m_count >= FRAMES + BLEND || !alloc()) return;
+
+        if (m_count < FRAMES) {
+            frame.saveFrame(m_frames + (size_t)m_count * LED_MATRIX_COUNT);
+        } else {
+            // Frame FRAMES + j fades out over loop frame j, which fades
+            // in: the loop runs FRAMES - 1 -> FRAMES (shown as 0) -> ...
+            const int j = m_count - FRAMES;
+            const uint32_t w = (uint32_t)(j * 256 / BLEND);
+            RGB16* dst = m_frames + (size_t)j * LED_MATRIX_COUNT;
+            frame.saveFrame(m_scratch);
+            for (int i = 0; i < LED_MATRIX_COUNT; i++) {
+                dst[i].r = mix(m_scratch[i].r, dst[i].r, w);
+                dst[i].g = mix(m_scratch[i].g, dst[i].g, w);
+                dst[i].b = mix(m_scratch[i].b, dst[i].b, w);
+            }
+        }
+        if (++m_count == FRAMES + BLEND) {
+            ESP_LOGI(TAG, "Demo loop recorded: %d frames (%u KB)", FRAMES,
+                     (unsigned)(sizeof(RGB16) * LED_MATRIX_COUNT * FRAMES / 1024));
+        }
+    }
+
+private:
+    static constexpr const char* TAG = "LedDemoCache";
+
+    static inline uint16_t mix(uint16_t a, uint16_t b, uint32_t w) {
+        return (uint16_t)((a * (256 - w) + b * w) >> 8);
+    }
+
+    bool alloc() {
+        if (m_frames) return true;
+        if (m_noMemory) return false;
+        const size_t bytes = sizeof(RGB16) * LED_MATRIX_COUNT * FRAMES;
+        m_frames = (RGB16*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!m_frames) {
+            m_noMemory = true;
+            ESP_LOGW(TAG, "No PSRAM for the demo loop (%u KB), demo runs live", (unsigned)(bytes / 1024));
+            return false;
+        }
+        return true;
+    }
+
+    std::atomic<uint32_t> m_generation{0};
+    uint32_t m_recordedGen = UINT32_MAX;    // Forces a restart on first use
+    RGB16* m_frames = nullptr;              // FRAMES loop frames, PSRAM
+    RGB16 m_scratch[LED_MATRIX_COUNT];
+    int m_count = 0;                        // Frames recorded; < 0 settling
+    int m_pos = 0;                          // Next loop frame to replay
+    bool m_noMemory = false;
+};
@@ -0,0 +1,231 @@
+#pragma once
+
+// -----------------------------------------------------------
+// WS2812B LED Driver, up to 8 strips in parallel (LED_OUTPUT_PARALLEL)
+// The ESP32 I2S peripheral in LCD (i80) mode clocks one byte per
+// slot out of DMA onto 8 data pins, one strip per pin, so a frame
+// takes as long as one strip however many strips there are
+// - The matrix is split into LED_PARALLEL_STRIPS equal bands of
+//   rows: strip s carries pixels [s * N / strips, (s + 1) * N / strips)
+//   of the serpentine order, i.e. each panel chain keeps its wiring
+// - Each WS2812 bit is three slots at 2.4 MHz (high, data, low), so a
+//   pixel position is 72 bytes for all strips together
+// - Same double buffering and unchanged-frame skip as LedDriverSPI
+// esp_lcd takes whichever I2S unit audio output left free
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "esp_lcd_panel_io.h"
+#include "driver/gpio.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "led_config.h"
+#include "led_frame.h"
+#include "../core/mem_placement.h"
+
+static const char* TAG_I2S_LED = "LED_I2S";
+
+class LedDriverI2S : public LedFrame {
+public:
+    static constexpr int STRIPS = LED_PARALLEL_STRIPS;
+    static constexpr int STRIP_PIXELS = LED_MATRIX_COUNT / STRIPS;
+    static_assert(LED_MATRIX_HEIGHT % STRIPS == 0, "matrix rows must split evenly across the strips");
+
+    LedDriverI2S() {
+        m_txMutex = xSemaphoreCreateMutex();
+        m_doneSem = xSemaphoreCreateBinary();
+    }
+
+    ~LedDriverI2S() {
+        if (m_io) {
+            waitIdle();
+            esp_lcd_panel_io_del(m_io);
+        }
+        if (m_bus) esp_lcd_del_i80_bus(m_bus);
+        freeBuffers();
+        if (m_txMutex) vSemaphoreDelete(m_txMutex);
+        if (m_doneSem) vSemaphoreDelete(m_doneSem);
+    }
+
+    // pin is strip 0's data line; the others come from LED_PARALLEL_GPIOS
+    esp_err_t init(gpio_num_t pin = LED_GPIO_PIN) {
+        m_dmaBufferSize = (size_t)STRIP_PIXELS * BYTES_PER_PIXEL + RESET_BYTES;
+
+        ESP_LOGI(TAG_I2S_LED, "Initializing parallel LED driver: %d strips x %d LEDs, GPIO %d (+%d)",
+                 STRIPS, STRIP_PIXELS, pin, STRIPS - 1);
+        ESP_LOGI(TAG_I2S_LED, "DMA buffer size: 2 x %d bytes", (int)m_dmaBufferSize);
+
+        for (int i = 0; i < 2; i++) {
+            m_dmaBuffer[i] = (uint8_t*)MemPlacement::alloc("led_dma", MEM_OWNER_LED, m_dmaBufferSize,
+                                                         MEM_DMA, MEM_PRIO_NORMAL, MALLOC_CAP_DMA);
+            if (!m_dmaBuffer[i]) {
+                ESP_LOGE(TAG_I2S_LED, "Failed to allocate DMA buffer");
+                freeBuffers();
+                return ESP_ERR_NO_MEM;
+            }
+            // Reset tail stays zero; only the pixel part is encoded
+            memset(m_dmaBuffer[i], 0, m_dmaBufferSize);
+        }
+
+        // 8-bit bus: lanes without a strip still need a pin number, so
+        // they share strip 0's pin and carry a copy of its data
+        static const int extraPins[7] = LED_PARALLEL_GPIOS;
+        esp_lcd_i80_bus_config_t buscfg = {};
+        buscfg.dc_gpio_num = -1;
+        buscfg.wr_gpio_num = LED_PARALLEL_CLK_GPIO;
+        buscfg.clk_src = LCD_CLK_SRC_DEFAULT;
+        buscfg.bus_width = 8;
+        buscfg.max_transfer_bytes = m_dmaBufferSize;
+        for (int lane = 0; lane < 8; lane++) {
+            buscfg.data_gpio_nums[lane] = (lane == 0 || lane >= STRIPS) ? pin : extraPins[lane - 1];
+        }
+
+        esp_err_t err = esp_lcd_new_i80_bus(&buscfg, &m_bus);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG_I2S_LED, "I2S LCD bus init failed: %s", esp_err_to_name(err));
+            freeBuffers();
+            return err;
+        }
+
+        esp_lcd_panel_io_i80_config_t iocfg = {};
+        iocfg.cs_gpio_num = -1;
+        iocfg.pclk_hz = SLOT_HZ;
+        iocfg.trans_queue_depth = 1;
+        iocfg.on_color_trans_done = onSent;
+        iocfg.user_ctx = this;
+        iocfg.lcd_cmd_bits = 8;
+        iocfg.lcd_param_bits = 8;
+
+        err = esp_lcd_new_panel_io_i80(m_bus, &iocfg, &m_io);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG_I2S_LED, "I2S LCD io init failed: %s", esp_err_to_name(err));
+            esp_lcd_del_i80_bus(m_bus);
+            m_bus = nullptr;
+            freeBuffers();
+            return err;
+        }
+
+        // Clear all LEDs
+        m_initialized = true;
+        clear();
+        show();
+
+        ESP_LOGI(TAG_I2S_LED, "Parallel LED driver initialized successfully");
+        return ESP_OK;
+    }
+
+    // Encodes the framebuffer and queues it behind the frame still on
+    // the wire (if any); returns without waiting for this one
+    esp_err_t show() {
+        if (!m_initialized || !m_dmaBuffer[0]) {
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        uint32_t hash;
+        if (unchangedSinceSent(hash)) {
+            return ESP_OK;
+        }
+
+        if (xSemaphoreTake(m_txMutex, pdMS_TO_TICKS(5)) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+
+        beginEncode();
+        // Pixel position p of every strip at once, GRB, MSB first: the
+        // strips' colour bytes are bit-transposed so byte b has strip s's
+        // bit b in bit s. Spare lanes repeat strip 0.
+        uint8_t* out = m_dmaBuffer[m_next];
+        for (int p = 0; p < STRIP_PIXELS; p++) {
+            uint64_t g = 0, r = 0, b = 0;
+            for (int s = 0; s < STRIPS; s++) {
+                const int i = s * STRIP_PIXELS + p;
+                const RGB16 px = composed(i);
+                g |= (uint64_t)outputLevel(i, 1, px.g) << (8 * s);
+                r |= (uint64_t)outputLevel(i, 0, px.r) << (8 * s);
+                b |= (uint64_t)outputLevel(i, 2, px.b) << (8 * s);
+            }
+            for (int s = STRIPS; s < 8; s++) {
+                g |= (g & 0xFF) << (8 * s);
+                r |= (r & 0xFF) << (8 * s);
+                b |= (b & 0xFF) << (8 * s);
+            }
+            out = encodeByte(out, transpose8(g));
+            out = encodeByte(out, transpose8(r));
+            out = encodeByte(out, transpose8(b));
+        }
+        endEncode();
+
+        waitIdle();
+
+        esp_err_t err = esp_lcd_panel_io_tx_color(m_io, -1, m_dmaBuffer[m_next], m_dmaBufferSize);
+        if (err == ESP_OK) {
+            m_inFlight = true;
+            m_next ^= 1;
+            markSent(hash);
+        }
+
+        xSemaphoreGive(m_txMutex);
+        return err;
+    }
+
+    bool isInitialized() const { return m_initialized; }
+
+private:
+    static constexpr uint32_t SLOT_HZ = 2400000;            // 417 ns per slot
+    static constexpr int BYTES_PER_PIXEL = 24 * 3;
+    static constexpr size_t RESET_BYTES = 720;              // 300 us low
+
+    // 8x8 bit transpose (Hacker's Delight): row s = byte s in, column
+    // b = byte b out
+    static inline uint64_t transpose8(uint64_t x) {
+        uint64_t t;
+        t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;  x = x ^ t ^ (t << 7);
+        t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL; x = x ^ t ^ (t << 14);
+        t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL; x = x ^ t ^ (t << 28);
+        return x;
+    }
+
+    // One colour byte of every strip: per bit, all lanes high, the
+    // lanes whose bit is 1, all low
+    static inline uint8_t* encodeByte(uint8_t* out, uint64_t bits) {
+        for (int bit = 7; bit >= 0; bit--) {
+            *out++ = 0xFF;
+            *out++ = (uint8_t)(bits >> (8 * bit));
+            *out++ = 0;
+        }
+        return out;
+    }
+
+    static bool onSent(esp_lcd_panel_io_handle_t, esp_lcd_panel_io_event_data_t*, void* ctx) {
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(static_cast<LedDriverI2S*>(ctx)->m_doneSem, &woken);
+        return woken == pdTRUE;
+    }
+
+    // Waits until the queued frame is off the wire
+    void waitIdle() {
+        if (!m_inFlight) return;
+        xSemaphoreTake(m_doneSem, portMAX_DELAY);
+        m_inFlight = false;
+    }
+
+    void freeBuffers() {
+        for (int i = 0; i < 2; i++) {
+            MemPlacement::release(m_dmaBuffer[i]);
+            m_dmaBuffer[i] = nullptr;
+        }
+    }
+
+    esp_lcd_i80_bus_handle_t m_bus = nullptr;
+    esp_lcd_panel_io_handle_t m_io = nullptr;
+    uint8_t* m_dmaBuffer[2] = { nullptr, nullptr };
+    int m_next = 0;             // Buffer the next show() encodes into
+    bool m_inFlight = false;    // Queued frame not confirmed sent yet
+    size_t m_dmaBufferSize = 0;
+    bool m_initialized = false;
+    SemaphoreHandle_t m_txMutex;
+    SemaphoreHandle_t m_doneSem;
+};
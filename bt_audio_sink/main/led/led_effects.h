@@ -4,6 +4,7 @@
 // LED Effects Engine
 // Audio-reactive effects for 16x16 WS2812B matrix
 // OPTIMIZED: No divisions - all bit shifts and multiplies
+// Per-pixel geometry, sines and HSV come from led_render.h tables
 // Uses SPI DMA driver for reliable LED output
 // -----------------------------------------------------------
 
@@ -12,10 +13,21 @@
 #include <stdlib.h>
 #include "led_config.h"
 #include "led_driver_spi.h"
+#if LED_OUTPUT_PARALLEL
+#include "led_driver_i2s.h"
+#endif
+#include "led_render.h"
+#if LED_PARALLEL_RENDER
+#include "led_bands.h"
+#endif
 #include "../dsp/fast_math.h"
 
-// Use SPI driver types
+// Driver types: the output backend is picked at build time
+#if LED_OUTPUT_PARALLEL
+typedef LedDriverI2S LedDriver;
+#else
 typedef LedDriverSPI LedDriver;
+#endif
 typedef RGB_SPI RGB;
 #define Colors ColorsSPI
 
@@ -90,34 +102,29 @@ static inline uint8_t lerp8(uint8_t a, uint8_t b, uint8_t t) {
     return a + scale8(b - a, t);
 }
 
-// Fast sin8 - COMPUTED (no lookup table, saves 256 bytes RAM)
-// Uses parabolic approximation: sin(x) ≈ 4x(π-x)/π² 
+// sin8: parabolic approximation, sin(x) ≈ 4x(π-x)/π², as a table
+// generated into flash (one load instead of the folding and clamp)
 // Input: 0-255 (0-2π), Output: 0-255 (maps to -1 to +1 centered at 128)
+struct Sin8Table {
+    uint8_t v[256];
+};
+
+static constexpr Sin8Table makeSin8Table() {
+    Sin8Table t{};
+    for (int theta = 0; theta < 256; theta++) {
+        // Same half-wave for both halves: y = x * (128 - x) / 32, 0-127
+        const int x = theta & 127;
+        int y = (x * (128 - x)) >> 5;
+        if (y > 127) y = 127;
+        t.v[theta] = (uint8_t)(theta < 128 ? 128 + y : 128 - y);
+    }
+    return t;
+}
+
+static constexpr Sin8Table SIN8_TABLE = makeSin8Table();
+
 static inline uint8_t sin8(uint8_t theta) {
-    // Use symmetry: only compute 0-127, mirror for 128-255
-    uint8_t offset = theta;
-    if (theta >= 128) {
-        offset = theta - 128;  // Fold second half
-    }
-    
-    // Parabolic approximation for half-wave (0-127 -> 0 to peak to 0)
-    // y = 4 * x * (128 - x) / 128 for x in [0, 128]
-    // Simplified: y = (x * (128 - x)) >> 5 gives 0-128 range
-    // We want 0-127 peak at 64
-    uint16_t x = offset;
-    uint16_t y = (x * (128 - x)) >> 5;  // 0 at edges, ~128 at center
-    if (y > 127) y = 127;  // Clamp
-    
-    // Map to output: first half goes 128->255->128, second half 128->0->128
-    if (theta < 64) {
-        return 128 + y;  // Rising: 128 -> 255
-    } else if (theta < 128) {
-        return 128 + y;  // Falling: 255 -> 128 (y decreases)
-    } else if (theta < 192) {
-        return 128 - y;  // Below: 128 -> 0
-    } else {
-        return 128 - y;  // Rising back: 0 -> 128 (y decreases)
-    }
+    return SIN8_TABLE.v[theta];
 }
 
 static inline uint8_t cos8(uint8_t theta) {
@@ -145,6 +152,12 @@ struct AudioData {
     bool beat;          // Beat detected this frame
     float beatIntensity; // Beat strength (0-1)
     bool audioActive;   // Audio is currently playing
+
+    // FFT spectrum (log-spaced, low to high); numBands = 0 when unavailable
+    static constexpr int MAX_BANDS = 32;
+    uint8_t numBands = 0;
+    float bands[MAX_BANDS];      // Band level (linear, 0-1)
+    float bandPeaks[MAX_BANDS];  // Peak hold per band
 };
 
 // Base effect class
@@ -156,9 +169,49 @@ public:
     virtual void updateDemo() { update(AudioData{}); }  // Default demo just runs normal update
     virtual const char* getName() const = 0;
     
+    // Frame budget fallback: each level halves optional detail (particle
+    // counts). False once there is nothing left to drop.
+    bool reduceQuality() {
+        if (m_quality >= MAX_QUALITY_DROP) return false;
+        m_quality++;
+        return true;
+    }
+    uint8_t qualityLevel() const { return m_quality; }
+    
+    // Row-separable effects: work rows per frame, 0 for the rest. Their
+    // update() sets the frame's state and ends in renderAllRows(); each
+    // renderRows() call may run on either core, alongside the others,
+    // so it only reads that state and only writes its own rows.
+    virtual int bandRows() const { return 0; }
+    virtual void renderRows(int y0, int y1) { (void)y0; (void)y1; }
+#if LED_PARALLEL_RENDER
+    void setBands(LedBands* bands) { m_bands = bands; }
+#endif
+    
 protected:
+    static constexpr uint8_t MAX_QUALITY_DROP = 2;
+    
     LedDriver* m_driver = nullptr;
     uint32_t m_frame = 0;
+    uint8_t m_quality = 0;      // Kept across init(): the cost does not change
+#if LED_PARALLEL_RENDER
+    LedBands* m_bands = nullptr;
+#endif
+    
+    // Every work row of the frame, on both cores with LED_PARALLEL_RENDER
+    void renderAllRows() {
+#if LED_PARALLEL_RENDER
+        if (m_bands) {
+            m_bands->run(rowsThunk, this, bandRows());
+            return;
+        }
+#endif
+        renderRows(0, bandRows());
+    }
+    
+    static void rowsThunk(void* self, int y0, int y1) {
+        static_cast<LedEffect*>(self)->renderRows(y0, y1);
+    }
     
     // Utility: convert linear audio level to display height (0-15)
     // Uses fixed-point math: (db+60) * 15 / 60 = (db+60) / 4
@@ -179,6 +232,19 @@ protected:
         int result = (int)((db + 60.0f) * 0.25f);
         return (result > 15) ? 15 : result;
     }
+
+    // Strongest spectrum band in the [from, to) fraction of the bands
+    static float bandMax(const float* bands, int numBands, float from, float to) {
+        int lo = (int)(from * numBands);
+        int hi = (int)(to * numBands + 0.5f);
+        if (hi <= lo) hi = lo + 1;
+        if (hi > numBands) hi = numBands;
+        float v = 0.0f;
+        for (int i = lo; i < hi; i++) {
+            if (bands[i] > v) v = bands[i];
+        }
+        return v;
+    }
 };
 
 // -----------------------------------------------------------
@@ -200,10 +266,18 @@ public:
         m_driver->clear();
         m_frame++;
         
-        // Simulate 16 bands from 3 frequency inputs (interpolate)
-        // Use integer math: i/15 ≈ (i*17)>>8 for i in 0-15
+        // Real FFT bands when available, one column per 1/16 of them
         float bands[16];
-        for (int i = 0; i < 16; i++) {
+        float peaks[16];
+        const bool fft = audio.numBands > 0;
+        for (int i = 0; fft && i < 16; i++) {
+            bands[i] = bandMax(audio.bands, audio.numBands, i / 16.0f, (i + 1) / 16.0f);
+            peaks[i] = bandMax(audio.bandPeaks, audio.numBands, i / 16.0f, (i + 1) / 16.0f);
+        }
+
+        // Otherwise simulate 16 bands from 3 frequency inputs (interpolate)
+        // Use integer math: i/15 ≈ (i*17)>>8 for i in 0-15
+        for (int i = 0; !fft && i < 16; i++) {
             // pos = i * (1/15) ≈ i * 0.0667
             // For i=0-4: bass->mid, i=5-9: mid->high, i=10-15: high
             if (i < 5) {
@@ -233,8 +307,10 @@ public:
             
             int h = (int)m_heights[x];
             
-            // Update peak
-            if (h > m_peaks[x]) {
+            // Update peak (the analyzer holds the FFT peaks itself)
+            if (fft) {
+                m_peaks[x] = levelToHeight(peaks[x] * 1.5f);
+            } else if (h > m_peaks[x]) {
                 m_peaks[x] = h;
                 m_peakDecay[x] = 30;
             } else if (m_peakDecay[x] > 0) {
@@ -248,11 +324,11 @@ public:
                 int yFlip = 15 - y;  // Draw from bottom
                 RGB color;
                 if (y < 5) {
-                    color = RGB::fromHSV(96, 255, 255);  // Green
+                    color = hsv8(96, 255, 255);  // Green
                 } else if (y < 10) {
-                    color = RGB::fromHSV(64 - (y - 5) * 12, 255, 255);  // Yellow to orange
+                    color = hsv8(64 - (y - 5) * 12, 255, 255);  // Yellow to orange
                 } else {
-                    color = RGB::fromHSV(0, 255, 255);  // Red
+                    color = hsv8(0, 255, 255);  // Red
                 }
                 m_driver->setPixelXY(x, yFlip, color);
             }
@@ -305,12 +381,12 @@ public:
         
         // Background based on bass
         uint8_t bgLevel = (uint8_t)(audio.bass * 30);
-        RGB bgColor = RGB::fromHSV(m_hue + 128, 255, bgLevel);
+        RGB bgColor = hsv8(m_hue + 128, 255, bgLevel);
         m_driver->fill(bgColor);
         
         // Pulse overlay
         if (m_pulseLevel > 10) {
-            RGB pulseColor = RGB::fromHSV(m_hue, 255, m_pulseLevel);
+            RGB pulseColor = hsv8(m_hue, 255, m_pulseLevel);
             for (int i = 0; i < LED_MATRIX_COUNT; i++) {
                 RGB current = m_driver->getPixel(i);
                 m_driver->setPixel(i, current.add(pulseColor));
@@ -326,11 +402,11 @@ public:
             m_hue += 32;
         }
         
-        RGB bgColor = RGB::fromHSV(m_hue + 128, 200, 20);
+        RGB bgColor = hsv8(m_hue + 128, 200, 20);
         m_driver->fill(bgColor);
         
         if (m_pulseLevel > 10) {
-            RGB pulseColor = RGB::fromHSV(m_hue, 255, m_pulseLevel);
+            RGB pulseColor = hsv8(m_hue, 255, m_pulseLevel);
             for (int i = 0; i < LED_MATRIX_COUNT; i++) {
                 RGB current = m_driver->getPixel(i);
                 m_driver->setPixel(i, current.add(pulseColor));
@@ -384,7 +460,6 @@ public:
         }
         
         // Update and draw ripples
-        float cx = 7.5f, cy = 7.5f;
         for (int i = 0; i < MAX_RIPPLES; i++) {
             if (!m_ripples[i].active) continue;
             
@@ -397,15 +472,16 @@ public:
             // Draw ring
             float r = m_ripples[i].radius;
             uint8_t brightness = 255 - (uint8_t)(r * 15);
-            RGB color = RGB::fromHSV(m_ripples[i].hue, 255, brightness);
+            RGB color = hsv8(m_ripples[i].hue, 255, brightness);
             
+            // Pixels within one pixel of the ring, brighter the closer
+            const int rQ4 = (int)(r * 16.0f);
             for (int y = 0; y < 16; y++) {
                 for (int x = 0; x < 16; x++) {
-                    float dx = x - cx, dy = y - cy;
-                    float dist = sqrtf(dx * dx + dy * dy);
-                    if (fabsf(dist - r) < 1.0f) {
-                        float intensity = 1.0f - fabsf(dist - r);
-                        RGB c = color.scale((uint8_t)(intensity * 255));
+                    int diff = (int)centreDistQ4(x, y) - rQ4;
+                    if (diff < 0) diff = -diff;
+                    if (diff < 16) {
+                        RGB c = color.scale((uint8_t)(((16 - diff) * 255) >> 4));
                         RGB current = m_driver->getPixelXY(x, y);
                         m_driver->setPixelXY(x, y, current.add(c));
                     }
@@ -483,19 +559,7 @@ public:
         for (int y = 0; y < 16; y++) {
             for (int x = 0; x < 16; x++) {
                 int idx = y * 16 + x;
-                uint8_t heat = m_heat[idx];
-                
-                // Heat color palette
-                RGB color;
-                if (heat < 85) {
-                    color = RGB(heat * 3, 0, 0);
-                } else if (heat < 170) {
-                    color = RGB(255, (heat - 85) * 3, 0);
-                } else {
-                    color = RGB(255, 255, (heat - 170) * 3);
-                }
-                
-                m_driver->setPixelXY(x, y, color);
+                m_driver->setPixelXY(x, y, heatColor(m_heat[idx]));
             }
         }
     }
@@ -521,28 +585,36 @@ public:
     void update(const AudioData& audio) override {
         m_frame++;
         
-        uint8_t time1 = m_frame;
-        uint8_t time2 = m_frame * 2;
-        float audioMod = 1.0f + (audio.bass + audio.mid) * 0.5f;
-        
-        for (int y = 0; y < 16; y++) {
+        // Audio gain in Q8 (256 = 1.0)
+        m_audioModQ8 = 256 + (uint32_t)((audio.bass + audio.mid) * 128.0f);
+        renderAllRows();
+    }
+    
+    int bandRows() const override { return 16; }
+    
+    void renderRows(int y0, int y1) override {
+        const uint8_t time1 = m_frame;
+        const uint8_t time2 = m_frame * 2;
+        for (int y = y0; y < y1; y++) {
             for (int x = 0; x < 16; x++) {
                 uint8_t v1 = sin8(x * 16 + time1);
                 uint8_t v2 = sin8(y * 16 + time2);
                 uint8_t v3 = sin8((x + y) * 8 + m_frame);
-                uint8_t v4 = sin8(sqrtf(x * x + y * y) * 8 - m_frame);
+                uint8_t v4 = sin8((uint8_t)((offsetDistQ4(x, y) >> 1) - m_frame));  // dist * 8
                 
                 uint8_t hue = (v1 + v2 + v3 + v4) >> 2;  // /4 = >>2
-                uint8_t value = 128 + (sin8(hue + m_frame) >> 1);
-                value = (uint8_t)(value * audioMod);
+                uint32_t value = ((128 + (sin8(hue + m_frame) >> 1)) * m_audioModQ8) >> 8;
                 if (value > 255) value = 255;
                 
-                m_driver->setPixelXY(x, y, RGB::fromHSV(hue, 255, value));
+                m_driver->setPixelXY(x, y, hsv8(hue, 255, value));
             }
         }
     }
     
     const char* getName() const override { return "Plasma"; }
+    
+private:
+    uint32_t m_audioModQ8 = 256;
 };
 
 // -----------------------------------------------------------
@@ -646,8 +718,15 @@ public:
         
         // Smooth levels
         float target = level * 15.0f;
+        float targetR = target * (0.9f + 0.2f * sin8(m_frame * 3) * 0.00392f);
+        if (audio.numBands > 0) {
+            // Analysis is mono: left shows the lower half of the spectrum,
+            // right the upper half
+            target = levelToHeight(bandMax(audio.bands, audio.numBands, 0.0f, 0.5f) * 1.5f);
+            targetR = levelToHeight(bandMax(audio.bands, audio.numBands, 0.5f, 1.0f) * 1.5f);
+        }
         m_leftLevel += (target - m_leftLevel) * 0.3f;
-        m_rightLevel += (target * (0.9f + 0.2f * sin8(m_frame * 3) * 0.00392f) - m_rightLevel) * 0.3f;
+        m_rightLevel += (targetR - m_rightLevel) * 0.3f;
         
         // Peaks
         if (m_leftLevel > m_leftPeak) { m_leftPeak = m_leftLevel; m_peakHold = 30; }
@@ -669,8 +748,8 @@ public:
         // Center decoration
         uint8_t hue = m_frame;
         for (int y = 0; y < 16; y++) {
-            m_driver->setPixelXY(7, y, RGB::fromHSV(hue + y * 16, 255, 100));
-            m_driver->setPixelXY(8, y, RGB::fromHSV(hue + y * 16 + 128, 255, 100));
+            m_driver->setPixelXY(7, y, hsv8(hue + y * 16, 255, 100));
+            m_driver->setPixelXY(8, y, hsv8(hue + y * 16 + 128, 255, 100));
         }
     }
     
@@ -692,9 +771,9 @@ private:
                 int yFlip = 15 - y;
                 RGB color;
                 if (y < 10) {
-                    color = RGB::fromHSV(96 - y * 8, 255, 255);  // Green to yellow
+                    color = hsv8(96 - y * 8, 255, 255);  // Green to yellow
                 } else {
-                    color = RGB::fromHSV(0, 255, 255);  // Red
+                    color = hsv8(0, 255, 255);  // Red
                 }
                 m_driver->setPixelXY(x, yFlip, color);
             }
@@ -747,7 +826,7 @@ public:
         
         // Background glow based on bass
         uint8_t bgLevel = (uint8_t)(audio.bass * 20);
-        RGB bg = RGB::fromHSV(160, 255, bgLevel);
+        RGB bg = hsv8(160, 255, bgLevel);
         m_driver->fill(bg);
         
         for (int i = 0; i < NUM_STARS; i++) {
@@ -789,26 +868,36 @@ class WaveEffect : public LedEffect {
 public:
     void update(const AudioData& audio) override {
         m_frame++;
-        m_driver->fadeAll(200);
         
         float amp1 = 3.0f + audio.bass * 4.0f;
         float amp2 = 2.0f + audio.mid * 3.0f;
         float amp3 = 1.0f + audio.high * 2.0f;
         
+        // Each column's three wave rows; the bands fade and draw
+        // Phase in 1/65536 turns: 0.1 rad per frame, 0.4 rad per column
+        const float k = 1.0f / 127.0f;
         for (int x = 0; x < 16; x++) {
-            float t = m_frame * 0.1f + x * 0.4f;
-            
-            float y1 = 7.5f + amp1 * sinf(t);
-            float y2 = 7.5f + amp2 * sinf(t * 1.5f + 1.0f);
-            float y3 = 7.5f + amp3 * sinf(t * 2.0f + 2.0f);
+            uint16_t t = (uint16_t)(m_frame * 1043 + x * 4172);
             
-            // Draw waves
-            if ((int)y1 >= 0 && (int)y1 < 16)
-                m_driver->setPixelXY(x, (int)y1, RGB::fromHSV(0, 255, 255));    // Red - bass
-            if ((int)y2 >= 0 && (int)y2 < 16)
-                m_driver->setPixelXY(x, (int)y2, RGB::fromHSV(85, 255, 255));   // Green - mid
-            if ((int)y3 >= 0 && (int)y3 < 16)
-                m_driver->setPixelXY(x, (int)y3, RGB::fromHSV(170, 255, 255));  // Blue - high
+            m_rows[x][0] = (int8_t)(7.5f + amp1 * k * sinLut16(t));
+            m_rows[x][1] = (int8_t)(7.5f + amp2 * k * sinLut16((uint16_t)(t + (t >> 1) + 10430)));  // 1.5t + 1 rad
+            m_rows[x][2] = (int8_t)(7.5f + amp3 * k * sinLut16((uint16_t)(t * 2 + 20861)));        // 2t + 2 rad
+        }
+        renderAllRows();
+    }
+    
+    int bandRows() const override { return LED_MATRIX_HEIGHT; }
+    
+    // Faded trail, then the waves crossing these rows in bass, mid,
+    // high order (red, green, blue)
+    void renderRows(int y0, int y1) override {
+        m_driver->fadeRows(y0, y1, 200);
+        static const uint8_t hues[3] = {0, 85, 170};
+        for (int x = 0; x < 16; x++) {
+            for (int w = 0; w < 3; w++) {
+                const int y = m_rows[x][w];
+                if (y >= y0 && y < y1 && y < 16) m_driver->setPixelXY(x, y, hsv8(hues[w], 255, 255));
+            }
         }
     }
     
@@ -821,6 +910,9 @@ public:
     }
     
     const char* getName() const override { return "Wave"; }
+    
+private:
+    int8_t m_rows[16][3] = {};
 };
 
 // -----------------------------------------------------------
@@ -887,9 +979,10 @@ public:
             
             // Explode at top or when slowing
             if (m_rockets[i].vy > -0.1f || m_rockets[i].y < 4) {
-                // Create explosion
-                for (int p = 0; p < 20; p++) {
-                    for (int j = 0; j < MAX_PARTICLES; j++) {
+                // Create explosion (fewer, from a smaller pool, at reduced quality)
+                const int limit = MAX_PARTICLES >> m_quality;
+                for (int p = 0; p < (20 >> m_quality); p++) {
+                    for (int j = 0; j < limit; j++) {
                         if (!m_particles[j].active) {
                             m_particles[j].active = true;
                             m_particles[j].x = m_rockets[i].x;
@@ -926,7 +1019,7 @@ public:
             int y = (int)m_particles[i].y;
             if (x >= 0 && x < 16 && y >= 0 && y < 16) {
                 uint8_t brightness = (m_particles[i].life > 30) ? 255 : m_particles[i].life * 8;
-                m_driver->setPixelXY(x, y, RGB::fromHSV(m_particles[i].hue, 255, brightness));
+                m_driver->setPixelXY(x, y, hsv8(m_particles[i].hue, 255, brightness));
             }
         }
     }
@@ -956,27 +1049,37 @@ public:
     void update(const AudioData& audio) override {
         m_frame++;
         
-        float bassScale = 1.0f + audio.bass * 2.0f;
-        uint8_t baseHue = m_frame;
-        
-        for (int y = 0; y < 16; y++) {
+        m_bassScale = 1.0f + audio.bass * 2.0f;
+        m_val = 128 + (uint8_t)(audio.bass * 127);
+        renderAllRows();
+    }
+    
+    int bandRows() const override { return 16; }
+    
+    void renderRows(int y0, int y1) override {
+        const uint8_t baseHue = m_frame;
+        for (int y = y0; y < y1; y++) {
             for (int x = 0; x < 16; x++) {
                 uint8_t hue = baseHue + x * 8 + y * 8 + (sin8(m_frame + x * 16) >> 2);  // /4 = >>2
                 uint8_t sat = 255;
-                uint8_t val = 128 + (uint8_t)(audio.bass * 127);
+                uint8_t val = m_val;
                 
                 // Wave distortion: /32 = >>5
-                int waveOffset = (int)((sin8(m_frame * 2 + y * 20) >> 5) * bassScale);
+                int waveOffset = (int)((sin8(m_frame * 2 + y * 20) >> 5) * m_bassScale);
                 int xShift = x + waveOffset;
                 if (xShift < 0) xShift += 16;
                 if (xShift >= 16) xShift -= 16;
                 
-                m_driver->setPixelXY(xShift, y, RGB::fromHSV(hue, sat, val));
+                m_driver->setPixelXY(xShift, y, hsv8(hue, sat, val));
             }
         }
     }
     
     const char* getName() const override { return "Rainbow Wave"; }
+    
+private:
+    float m_bassScale = 1.0f;
+    uint8_t m_val = 128;
 };
 
 // -----------------------------------------------------------
@@ -1008,9 +1111,10 @@ public:
         // Burst on beat
         if (audio.beat) {
             m_hue += 40;
-            int numParticles = 20 + (int)(audio.beatIntensity * 20);
+            int numParticles = (20 + (int)(audio.beatIntensity * 20)) >> m_quality;
+            const int limit = MAX_PARTICLES >> m_quality;
             for (int i = 0; i < numParticles; i++) {
-                for (int j = 0; j < MAX_PARTICLES; j++) {
+                for (int j = 0; j < limit; j++) {
                     if (!m_particles[j].active) {
                         m_particles[j].active = true;
                         m_particles[j].x = 7.5f;
@@ -1044,7 +1148,7 @@ public:
             
             uint8_t brightness = (uint8_t)(m_particles[i].life * 255);
             m_driver->setPixelXY((int)m_particles[i].x, (int)m_particles[i].y,
-                                RGB::fromHSV(m_particles[i].hue, 255, brightness));
+                                hsv8(m_particles[i].hue, 255, brightness));
         }
         
         // Center glow based on audio
@@ -1052,7 +1156,7 @@ public:
         for (int dy = -1; dy <= 1; dy++) {
             for (int dx = -1; dx <= 1; dx++) {
                 RGB current = m_driver->getPixelXY(7 + dx, 7 + dy);
-                m_driver->setPixelXY(7 + dx, 7 + dy, current.add(RGB::fromHSV(m_hue, 255, centerBright)));
+                m_driver->setPixelXY(7 + dx, 7 + dy, current.add(hsv8(m_hue, 255, centerBright)));
             }
         }
     }
@@ -1083,22 +1187,29 @@ public:
     void update(const AudioData& audio) override {
         m_frame++;
         
-        float scale = 1.0f + audio.bass * 0.5f;
-        uint8_t hueOffset = m_frame + (uint8_t)(audio.mid * 50);
-        
-        // Only compute one quadrant, then mirror
-        for (int y = 0; y < 8; y++) {
+        // dist * 20 * (1 + bass / 2) as a Q4 multiplier
+        m_hueScale = (uint32_t)(20.0f * (1.0f + audio.bass * 0.5f) + 0.5f);
+        m_hueOffset = m_frame + (uint8_t)(audio.mid * 50);
+        m_bassLift = (uint8_t)(audio.bass * 80);
+        renderAllRows();
+    }
+    
+    // Quadrant rows: each writes one row in the top half and its
+    // mirror in the bottom
+    int bandRows() const override { return 8; }
+    
+    // Only compute one quadrant, then mirror; the quadrant is centred
+    // on (3.5, 3.5), i.e. the grid tables offset by 4
+    void renderRows(int y0, int y1) override {
+        for (int y = y0; y < y1; y++) {
             for (int x = 0; x < 8; x++) {
-                float dx = x - 3.5f;
-                float dy = y - 3.5f;
-                float angle = atan2f(dy, dx);
-                float dist = sqrtf(dx * dx + dy * dy);
+                const uint16_t dist = centreDistQ4(x + 4, y + 4);
                 
-                uint8_t hue = hueOffset + (uint8_t)(angle * 40.5f) + (uint8_t)(dist * 20 * scale);
-                uint8_t val = sin8((uint8_t)(dist * 30 - m_frame * 2));
-                val = 100 + (val >> 1) + (uint8_t)(audio.bass * 80);
+                uint8_t hue = m_hueOffset + centreAngle8(x + 4, y + 4) + (uint8_t)((dist * m_hueScale) >> 4);
+                uint8_t val = sin8((uint8_t)(((dist * 30) >> 4) - m_frame * 2));
+                val = 100 + (val >> 1) + m_bassLift;
                 
-                RGB color = RGB::fromHSV(hue, 255, val);
+                RGB color = hsv8(hue, 255, val);
                 
                 // Mirror to all 4 quadrants
                 m_driver->setPixelXY(7 - x, 7 - y, color);
@@ -1110,6 +1221,11 @@ public:
     }
     
     const char* getName() const override { return "Kaleidoscope"; }
+    
+private:
+    uint32_t m_hueScale = 20;
+    uint8_t m_hueOffset = 0;
+    uint8_t m_bassLift = 0;
 };
 
 // -----------------------------------------------------------
@@ -1125,17 +1241,22 @@ public:
         float cx = 7.5f, cy = 7.5f;
         float angleOffset = m_frame * 0.05f;
         
+        // Arm levels: spectrum thirds when available, else bass/mid/high
+        float levels[3] = {audio.bass, audio.mid, audio.high};
+        if (audio.numBands > 0) {
+            for (int arm = 0; arm < 3; arm++) {
+                float v = bandMax(audio.bands, audio.numBands, arm / 3.0f, (arm + 1) / 3.0f);
+                levels[arm] = (levelToHeight(v * 1.5f) + 1) * (1.0f / 16.0f);
+            }
+        }
+
         // Draw spiral arms
         for (int arm = 0; arm < 3; arm++) {
             float armAngle = angleOffset + arm * 2.0944f;  // 120 degrees apart
-            float* level;
-            uint8_t baseHue;
-            
-            if (arm == 0) { level = (float*)&audio.bass; baseHue = 0; }      // Red for bass
-            else if (arm == 1) { level = (float*)&audio.mid; baseHue = 85; } // Green for mid
-            else { level = (float*)&audio.high; baseHue = 170; }             // Blue for high
+            // Red for bass, green for mid, blue for high
+            uint8_t baseHue = (uint8_t)(arm * 85);
             
-            float armLength = 2.0f + (*level) * 6.0f;
+            float armLength = 2.0f + levels[arm] * 6.0f;
             
             for (float r = 0; r < armLength; r += 0.3f) {
                 float angle = armAngle + r * 0.5f;
@@ -1144,7 +1265,7 @@ public:
                 
                 if (x >= 0 && x < 16 && y >= 0 && y < 16) {
                     uint8_t brightness = 255 - (uint8_t)(r * 30);
-                    RGB color = RGB::fromHSV(baseHue + (uint8_t)(r * 10), 255, brightness);
+                    RGB color = hsv8(baseHue + (uint8_t)(r * 10), 255, brightness);
                     RGB current = m_driver->getPixelXY(x, y);
                     m_driver->setPixelXY(x, y, current.add(color));
                 }
@@ -1186,13 +1307,9 @@ public:
         }
         m_ringLevels[0] = audio.bass;
         
-        float cx = 7.5f, cy = 7.5f;
-        
         for (int y = 0; y < 16; y++) {
             for (int x = 0; x < 16; x++) {
-                float dx = x - cx, dy = y - cy;
-                float dist = sqrtf(dx * dx + dy * dy);
-                int ring = (int)dist;
+                int ring = centreDistQ4(x, y) >> 4;
                 
                 if (ring < 8) {
                     float level = m_ringLevels[ring];
@@ -1203,7 +1320,7 @@ public:
                     // /5 ≈ (*51)>>8, but we want /5 of 0-255 = 0-51
                     brightness = (brightness * (200 + ((sin8(m_frame * 3 + ring * 30) * 51) >> 8))) >> 8;
                     
-                    m_driver->setPixelXY(x, y, RGB::fromHSV(hue, 255, brightness));
+                    m_driver->setPixelXY(x, y, hsv8(hue, 255, brightness));
                 }
             }
         }
@@ -1280,7 +1397,7 @@ public:
             int headX = (int)m.x;
             int headY = (int)m.y;
             if (headY >= 0 && headY < 16) {
-                m_driver->setPixelXY(headX, headY, RGB::fromHSV(m.hue, 200, 255));
+                m_driver->setPixelXY(headX, headY, hsv8(m.hue, 200, 255));
             }
             
             // Draw tail
@@ -1288,7 +1405,7 @@ public:
                 int tailY = headY - t;
                 if (tailY >= 0 && tailY < 16) {
                     uint8_t brightness = 255 - (t * 255 / m.tailLength);
-                    m_driver->setPixelXY(headX, tailY, RGB::fromHSV(m.hue, 255, brightness));
+                    m_driver->setPixelXY(headX, tailY, hsv8(m.hue, 255, brightness));
                 }
             }
             
@@ -1360,15 +1477,15 @@ public:
         
         for (int y = 0; y < 16; y++) {
             for (int x = 0; x < 16; x++) {
-                // Distance from center for radial gradient
-                float dx = x - 7.5f, dy = y - 7.5f;
-                float dist = sqrtf(dx * dx + dy * dy);
-                float falloff = 1.0f - (dist * fast_recipsf2(11.0f));
-                if (falloff < 0.1f) falloff = 0.1f;
+                // Distance from center for radial gradient: 1 - dist / 11,
+                // floored at 0.1 (255 / (11 * 16) ~ 23 / 16 per Q4 step)
+                const uint16_t dist = centreDistQ4(x, y);
+                int falloff = 255 - ((dist * 23) >> 4);
+                if (falloff < 25) falloff = 25;
                 
-                uint8_t pixelBright = scale8(brightness, (uint8_t)(falloff * 255));
-                uint8_t hueOffset = (uint8_t)(dist * 3);
-                m_driver->setPixelXY(x, y, RGB::fromHSV(m_hue + hueOffset, 220, pixelBright));
+                uint8_t pixelBright = scale8(brightness, (uint8_t)falloff);
+                uint8_t hueOffset = (uint8_t)((dist * 3) >> 4);
+                m_driver->setPixelXY(x, y, hsv8(m_hue + hueOffset, 220, pixelBright));
             }
         }
     }
@@ -1404,31 +1521,32 @@ public:
         
         // Rotation speed based on audio
         float rotSpeed = 0.05f + audio.mid * 0.15f;
-        float phase = m_frame * rotSpeed;
+        // Phase in 1/65536 turns (10430 per radian)
+        uint16_t phase = (uint16_t)fmodf(m_frame * rotSpeed * 10430.38f, 65536.0f);
         
         // Helix parameters
-        float amplitude = 4.0f + audio.bass * 3.0f;
+        float amplitude = (4.0f + audio.bass * 3.0f) * (1.0f / 127.0f);
         
         for (int y = 0; y < 16; y++) {
-            // First strand
-            float angle1 = phase + y * 0.5f;
-            int x1 = 8 + (int)(amplitude * sinf(angle1));
+            // First strand (0.5 rad per row)
+            uint16_t angle1 = (uint16_t)(phase + y * 5215);
+            int x1 = 8 + (int)(amplitude * sinLut16(angle1));
             
             // Second strand (180 degrees offset)
-            float angle2 = phase + y * 0.5f + 3.14159f;
-            int x2 = 8 + (int)(amplitude * sinf(angle2));
+            uint16_t angle2 = (uint16_t)(angle1 + 32768);
+            int x2 = 8 + (int)(amplitude * sinLut16(angle2));
             
             // Clamp to matrix
             if (x1 >= 0 && x1 < 16) {
                 uint8_t hue = (uint8_t)(audio.bass * 60);  // Red for bass
                 uint8_t brightness = 180 + (uint8_t)(audio.bass * 75);
-                m_driver->setPixelXY(x1, y, RGB::fromHSV(hue, 255, brightness));
+                m_driver->setPixelXY(x1, y, hsv8(hue, 255, brightness));
             }
             
             if (x2 >= 0 && x2 < 16) {
                 uint8_t hue = 160 + (uint8_t)(audio.high * 60);  // Blue for high
                 uint8_t brightness = 180 + (uint8_t)(audio.high * 75);
-                m_driver->setPixelXY(x2, y, RGB::fromHSV(hue, 255, brightness));
+                m_driver->setPixelXY(x2, y, hsv8(hue, 255, brightness));
             }
             
             // Draw connecting rungs every 4 rows
@@ -1438,7 +1556,7 @@ public:
                 for (int rx = minX + 1; rx < maxX; rx++) {
                     if (rx >= 0 && rx < 16) {
                         uint8_t brightness = 60 + (uint8_t)(audio.mid * 100);
-                        m_driver->setPixelXY(rx, y, RGB::fromHSV(96, 200, brightness));  // Green rungs
+                        m_driver->setPixelXY(rx, y, hsv8(96, 200, brightness));  // Green rungs
                     }
                 }
             }
@@ -1503,7 +1621,7 @@ public:
                 int dist = (ly > 8) ? (ly - 8) : (8 - ly);
                 uint8_t hue = 160 - dist * 15;  // Blue to green to yellow
                 uint8_t brightness = 150 + dist * 13;
-                m_driver->setPixelXY(x, ly, RGB::fromHSV(hue, 255, brightness));
+                m_driver->setPixelXY(x, ly, hsv8(hue, 255, brightness));
             }
         }
         
@@ -1609,7 +1727,7 @@ public:
                     if (dx * dx + dy * dy <= b.radius * b.radius) {
                         int px = cx + dx, py = cy + dy;
                         if (px >= 0 && px < 16 && py >= 0 && py < 16) {
-                            m_driver->setPixelXY(px, py, RGB::fromHSV(b.hue, 255, brightness));
+                            m_driver->setPixelXY(px, py, hsv8(b.hue, 255, brightness));
                         }
                     }
                 }
@@ -1699,27 +1817,39 @@ public:
             b.hue += (audio.beat ? 5 : 1);
         }
         
-        // Render metaballs
+        // Blob centres split into a whole pixel and a 1/16 fraction; the
+        // fraction is the same for every pixel, so a pixel's distance is
+        // the bilinear blend of the four whole-pixel offsets around it
+        int bx[NUM_BLOBS], by[NUM_BLOBS], fx[NUM_BLOBS], fy[NUM_BLOBS], rQ4[NUM_BLOBS];
+        for (int i = 0; i < NUM_BLOBS; i++) {
+            const int px = (int)(m_blobs[i].x * 16.0f), py = (int)(m_blobs[i].y * 16.0f);
+            bx[i] = px >> 4; fx[i] = px & 15;
+            by[i] = py >> 4; fy[i] = py & 15;
+            rQ4[i] = (int)(m_blobs[i].radius * 16.0f);
+        }
+        
+        // Render metaballs: field = sum of radius / (dist + 0.5), in Q12
         for (int y = 0; y < 16; y++) {
             for (int x = 0; x < 16; x++) {
-                float sum = 0;
-                float hueSum = 0;
-                float hueWeight = 0;
+                uint32_t sum = 0;
+                uint32_t hueSum = 0;
                 
                 for (int i = 0; i < NUM_BLOBS; i++) {
-                    float dx = x - m_blobs[i].x;
-                    float dy = y - m_blobs[i].y;
-                    float dist = sqrtf(dx * dx + dy * dy);
-                    float influence = m_blobs[i].radius / (dist + 0.5f);
+                    const int dx = x - bx[i], dy = y - by[i];
+                    const uint32_t d00 = offsetDistQ4(dx, dy), d10 = offsetDistQ4(dx - 1, dy);
+                    const uint32_t d01 = offsetDistQ4(dx, dy - 1), d11 = offsetDistQ4(dx - 1, dy - 1);
+                    const uint32_t top = d00 * (16 - fx[i]) + d10 * fx[i];
+                    const uint32_t bottom = d01 * (16 - fx[i]) + d11 * fx[i];
+                    const uint16_t dist = (uint16_t)((top * (16 - fy[i]) + bottom * fy[i]) >> 8);
+                    const uint32_t influence = (rQ4[i] * recipDistQ12(dist)) >> 4;
                     sum += influence;
                     hueSum += m_blobs[i].hue * influence;
-                    hueWeight += influence;
                 }
                 
-                if (sum > 1.0f) {
-                    uint8_t avgHue = (uint8_t)(hueSum / hueWeight);
-                    uint8_t brightness = (sum > 2.0f) ? 255 : (uint8_t)((sum - 1.0f) * 255);
-                    m_driver->setPixelXY(x, y, RGB::fromHSV(avgHue, 200, brightness));
+                if (sum > 4096) {
+                    uint8_t avgHue = (uint8_t)(hueSum / sum);
+                    uint8_t brightness = (sum > 8192) ? 255 : (uint8_t)(((sum - 4096) * 255) >> 12);
+                    m_driver->setPixelXY(x, y, hsv8(avgHue, 200, brightness));
                 } else {
                     m_driver->setPixelXY(x, y, RGB(0, 0, 0));
                 }
@@ -1977,7 +2107,7 @@ public:
                     if (brightness > 1.0f) brightness = 1.0f;
                     
                     uint8_t v = (uint8_t)(brightness * 255);
-                    RGB color = RGB::fromHSV(hue, 255, v);
+                    RGB color = hsv8(hue, 255, v);
                     m_driver->setPixelXY(x, y, color);
                 }
             } else if (rowFromBottom == litRows && litRows < totalRows) {
@@ -1985,7 +2115,7 @@ public:
                 uint8_t hue = (litRows < totalRows / 2) ? 96 : 
                               (litRows < totalRows * 3 / 4) ? 64 : 32;
                 uint8_t v = 60 + (uint8_t)(pulse * 40);
-                RGB color = RGB::fromHSV(hue, 255, v);
+                RGB color = hsv8(hue, 255, v);
                 for (int x = 0; x < LED_MATRIX_WIDTH; x++) {
                     m_driver->setPixelXY(x, y, color);
                 }
@@ -0,0 +1,398 @@
+#pragma once
+
+// -----------------------------------------------------------
+// LED Frame - the pixel side shared by the output drivers
+// Framebuffer in serpentine wiring order, XY access, global
+// brightness, the gamma curve (LED_GAMMA) and the unchanged-frame
+// check; a driver adds encoding and transmission (show())
+// - Channels are kept as 8.8 fixed point, so fadeAll() and dim
+//   colours keep their fraction instead of stepping
+// - Gamma and brightness give a level with 8 fractional bits; with
+//   LED_DITHER the fraction is carried per channel from one sent
+//   frame to the next (temporal dithering), so at low brightness
+//   the average over a few refreshes is exact. Drivers resend such
+//   a frame from refresh() between effect frames.
+// - Overlay layers (setLayers()) are blended over the framebuffer as
+//   it is encoded, so what the effect drew, and reads back, is never
+//   touched by them
+// - Power limit (LED_POWER_LIMIT_MA): every byte sent is summed as it
+//   is encoded, which gives the frame's current; the next frames are
+//   sent at a power scale under the brightness that keeps that under
+//   the budget. Down at once, up by a sixteenth of the way per frame.
+//   The scale goes into the level table like brightness, so the pass
+//   costs one add per channel.
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "led_config.h"
+#include "../dsp/pie_kernels.h"
+#include "../dsp/const_math.h"
+
+// RGB structure
+struct RGB_SPI {
+    uint8_t r, g, b;
+    
+    constexpr RGB_SPI() : r(0), g(0), b(0) {}
+    constexpr RGB_SPI(uint8_t _r, uint8_t _g, uint8_t _b) : r(_r), g(_g), b(_b) {}
+    
+    // Scale brightness (no division)
+    RGB_SPI scale(uint8_t brightness) const {
+        return RGB_SPI(
+            (r * brightness + 128) >> 8,
+            (g * brightness + 128) >> 8,
+            (b * brightness + 128) >> 8
+        );
+    }
+    
+    // HSV to RGB conversion (no division)
+    static constexpr RGB_SPI fromHSV(uint8_t h, uint8_t s, uint8_t v) {
+        if (s == 0) return RGB_SPI(v, v, v);
+        
+        uint8_t region = (h * 6) >> 8;  // h/43 approx
+        uint8_t remainder = (h * 6) - (region << 8);
+        
+        uint8_t p = (v * (255 - s) + 128) >> 8;
+        uint8_t q = (v * (255 - ((s * remainder + 128) >> 8)) + 128) >> 8;
+        uint8_t t = (v * (255 - ((s * (255 - remainder) + 128) >> 8)) + 128) >> 8;
+        
+        switch (region) {
+            case 0:  return RGB_SPI(v, t, p);
+            case 1:  return RGB_SPI(q, v, p);
+            case 2:  return RGB_SPI(p, v, t);
+            case 3:  return RGB_SPI(p, q, v);
+            case 4:  return RGB_SPI(t, p, v);
+            default: return RGB_SPI(v, p, q);
+        }
+    }
+    
+    RGB_SPI add(const RGB_SPI& other) const {
+        return RGB_SPI(
+            (r + other.r > 255) ? 255 : r + other.r,
+            (g + other.g > 255) ? 255 : g + other.g,
+            (b + other.b > 255) ? 255 : b + other.b
+        );
+    }
+};
+
+// Colour byte -> linear level in 8.8, generated into flash
+struct LedGammaTable {
+    uint16_t level[256];
+};
+
+static constexpr LedGammaTable makeLedGammaTable() {
+    LedGammaTable t{};
+    for (int v = 0; v < 256; v++) {
+#if LED_GAMMA
+        t.level[v] = (uint16_t)(cm_pow(v / 255.0, 2.2) * 65280.0 + 0.5);
+#else
+        t.level[v] = (uint16_t)(v << 8);
+#endif
+    }
+    return t;
+}
+
+static constexpr LedGammaTable LED_GAMMA_TABLE = makeLedGammaTable();
+
+// One framebuffer pixel: 8.8 fixed point per channel
+struct RGB16 {
+    uint16_t r, g, b;
+};
+
+// One overlay sprite pixel, in framebuffer (wiring) order: colour and
+// coverage, 0 transparent
+struct SpritePx {
+    uint8_t r, g, b, a;
+};
+
+// Overlay layer: a sprite, or one colour over the whole matrix,
+// at an opacity that scales the sprite's coverage
+struct LedLayer {
+    const SpritePx* sprite;     // nullptr: colour everywhere
+    RGB_SPI colour;
+    uint8_t alpha;
+};
+
+class LedFrame {
+public:
+    LedFrame() {
+#if LED_DITHER
+        // Spread the starting error so equal levels do not flip together
+        for (int i = 0; i < LED_MATRIX_COUNT; i++) {
+            for (int c = 0; c < 3; c++) m_carry[i][c] = (uint8_t)(i * 97 + c * 59);
+        }
+#endif
+    }
+    
+    void clear() {
+        for (int i = 0; i < LED_MATRIX_COUNT; i++) {
+            m_framebuffer[i] = RGB16{0, 0, 0};
+        }
+    }
+    
+    void fill(RGB_SPI color) {
+        const RGB16 c = widen(color);
+        for (int i = 0; i < LED_MATRIX_COUNT; i++) {
+            m_framebuffer[i] = c;
+        }
+    }
+    
+    RGB_SPI getPixel(int index) {
+        if (index >= 0 && index < LED_MATRIX_COUNT) {
+            return narrow(m_framebuffer[index]);
+        }
+        return RGB_SPI();
+    }
+    
+    void setPixel(int index, RGB_SPI color) {
+        if (index >= 0 && index < LED_MATRIX_COUNT) {
+            m_framebuffer[index] = widen(color);
+        }
+    }
+    
+    void setPixelXY(int x, int y, RGB_SPI color) {
+        if (x < 0 || x >= LED_MATRIX_WIDTH || y < 0 || y >= LED_MATRIX_HEIGHT) return;
+        m_framebuffer[indexXY(x, y)] = widen(color);
+    }
+    
+    RGB_SPI getPixelXY(int x, int y) {
+        if (x < 0 || x >= LED_MATRIX_WIDTH || y < 0 || y >= LED_MATRIX_HEIGHT) {
+            return RGB_SPI();
+        }
+        return narrow(m_framebuffer[indexXY(x, y)]);
+    }
+    
+    void setBrightness(uint8_t brightness) {
+        m_brightness = brightness;
+    }
+    
+    uint8_t getBrightness() const {
+        return m_brightness;
+    }
+    
+    // Estimated current of the last frame sent, and the scale (0-256)
+    // the power limit holds the brightness at
+    uint32_t estimatedMa() const { return m_estimatedMa; }
+    uint16_t powerScale() const { return m_powerScale; }
+    
+    // On the 8.8 values, truncating, so a fade always reaches black
+    void fadeAll(uint8_t scale) {
+        // The channels are contiguous uint16, faded as one run
+        static_assert(sizeof(RGB16) == 3 * sizeof(uint16_t), "RGB16 must be packed channels");
+        vec_scale_u16(reinterpret_cast<uint16_t*>(m_framebuffer), (size_t)LED_MATRIX_COUNT * 3, scale);
+    }
+    
+    // fadeAll() on rows [y0, y1) only: a row is contiguous whatever the
+    // wiring, so bands on both cores fade their own
+    void fadeRows(int y0, int y1, uint8_t scale) {
+        vec_scale_u16(reinterpret_cast<uint16_t*>(m_framebuffer + y0 * LED_MATRIX_WIDTH),
+                      (size_t)(y1 - y0) * LED_MATRIX_WIDTH * 3, scale);
+    }
+    
+    // Whole framebuffer out / in (LED_MATRIX_COUNT pixels)
+    void saveFrame(RGB16* dst) const {
+        memcpy(dst, m_framebuffer, sizeof(m_framebuffer));
+    }
+    
+    void loadFrame(const RGB16* src) {
+        memcpy(m_framebuffer, src, sizeof(m_framebuffer));
+    }
+
+    // Framebuffer itself, for writers of whole frames
+    RGB16* pixels() { return m_framebuffer; }
+
+    // Framebuffer from a to b by t (0 a, 256 b), on the 8.8 values
+    void blendFrames(const RGB16* a, const RGB16* b, uint32_t t) {
+        const uint16_t* pa = reinterpret_cast<const uint16_t*>(a);
+        const uint16_t* pb = reinterpret_cast<const uint16_t*>(b);
+        uint16_t* out = reinterpret_cast<uint16_t*>(m_framebuffer);
+        for (int i = 0; i < LED_MATRIX_COUNT * 3; i++) {
+            out[i] = (uint16_t)((int32_t)pa[i] + ((((int32_t)pb[i] - (int32_t)pa[i]) * (int32_t)t) >> 8));
+        }
+    }
+    
+    // Layers shown over the framebuffer from the next show(), bottom
+    // first; the array must stay valid until it is replaced
+    void setLayers(const LedLayer* layers, int count) {
+        m_layers = layers;
+        m_layerCount = count;
+    }
+    
+    // Framebuffer index of a pixel, for drawing sprites
+    static int indexXY(int x, int y) {
+        return (y & 1) ? y * LED_MATRIX_WIDTH + (LED_MATRIX_WIDTH - 1 - x)
+                       : y * LED_MATRIX_WIDTH + x;
+    }
+    
+    // show() calls in a row that found nothing new to send
+    uint16_t unchangedFrames() const { return m_unchangedFrames; }
+    // Frames sent to the LEDs since boot (wrapping)
+    uint32_t sentFrames() const { return m_sentFrames; }
+    
+    // Last frame sent has fractional levels: it needs refresh() to
+    // dither them
+    bool needsRefresh() const { return m_fractional; }
+    
+protected:
+    // Same picture as on the LEDs already (same pixels and brightness,
+    // nothing left to dither): counted, and the driver sends nothing.
+    // hash is for markSent().
+    bool unchangedSinceSent(uint32_t& hash) {
+        hash = frameHash();
+        if (hash != m_sentHash || levelBrightness() != m_sentBrightness || m_fractional) return false;
+        if (m_unchangedFrames < UINT16_MAX) m_unchangedFrames++;
+        return true;
+    }
+    
+    void markSent(uint32_t hash) {
+        m_sentHash = hash;
+        m_sentBrightness = m_lutBrightness;   // As encoded, before endEncode() moved the scale
+        m_unchangedFrames = 0;
+        m_sentFrames++;
+    }
+    
+    // Call before encoding a frame: level table for the brightness
+    void beginEncode() {
+        const int brightness = levelBrightness();
+        if (m_lutBrightness != brightness) {
+            const uint16_t* gamma = gammaTable();
+            for (int v = 0; v < 256; v++) {
+                m_levelLut[v] = (uint16_t)((gamma[v] * brightness) >> 8);
+            }
+            m_levelLut[256] = m_levelLut[255];
+            m_lutBrightness = brightness;
+        }
+        m_fractionSeen = 0;
+        m_levelSum = 0;
+    }
+    
+    // And after: whether the frame left fractions to dither, and the
+    // power scale for the next one
+    void endEncode() {
+        m_fractional = m_fractionSeen != 0;
+        m_estimatedMa = IDLE_MA + m_levelSum * LED_MA_PER_CHANNEL / 255;
+#if LED_POWER_LIMIT_MA
+        // What the frame would sum to unscaled, against what the budget allows
+        const uint32_t unscaled = m_levelSum * 256 / m_powerScale;
+        uint32_t want = 256;
+        if (unscaled > BUDGET_SUM) want = BUDGET_SUM > 0 ? BUDGET_SUM * 256 / unscaled : 0;
+        if (want < 1) want = 1;
+        if (want < m_powerScale) {
+            m_powerScale = (uint16_t)want;
+        } else if (want > m_powerScale) {
+            const uint32_t step = (want - m_powerScale + 15) >> 4;
+            m_powerScale = (uint16_t)(m_powerScale + step);
+        }
+#endif
+    }
+    
+    // Byte to send for channel c (0 r, 1 g, 2 b) of pixel i
+    inline uint8_t outputLevel(int i, int c, uint16_t v) {
+        // Level table entries either side, interpolated by the fraction
+        const uint16_t a = m_levelLut[v >> 8];
+        const uint16_t b = m_levelLut[(v >> 8) + 1];
+        const uint16_t lv = (uint16_t)(a + (((b - a) * (v & 0xFF)) >> 8));
+#if LED_DITHER
+        m_fractionSeen |= lv & 0xFF;
+        const uint16_t sum = lv + m_carry[i][c];
+        m_carry[i][c] = (uint8_t)sum;
+        const uint8_t out = (uint8_t)(sum >> 8);
+#else
+        (void)i; (void)c;
+        const uint8_t out = (uint8_t)((lv + 128) >> 8);
+#endif
+        m_levelSum += out;
+        return out;
+    }
+    
+    // Pixel i as sent: the framebuffer with the layers over it
+    inline RGB16 composed(int i) const {
+        RGB16 v = m_framebuffer[i];
+        for (int l = 0; l < m_layerCount; l++) {
+            const LedLayer& layer = m_layers[l];
+            uint32_t a = layer.alpha;
+            uint8_t r = layer.colour.r, g = layer.colour.g, b = layer.colour.b;
+            if (layer.sprite) {
+                const SpritePx& s = layer.sprite[i];
+                a = (a * s.a + 255) >> 8;
+                r = s.r;
+                g = s.g;
+                b = s.b;
+            }
+            if (a == 0) continue;
+            a += a >> 7;    // 0-256, so 255 is opaque
+            v.r = blend16(v.r, r, a);
+            v.g = blend16(v.g, g, a);
+            v.b = blend16(v.b, b, a);
+        }
+        return v;
+    }
+    
+    alignas(16) RGB16 m_framebuffer[LED_MATRIX_COUNT];
+    uint8_t m_brightness = LED_DEFAULT_BRIGHTNESS;
+    
+private:
+    static constexpr uint32_t IDLE_MA = (uint32_t)LED_IDLE_MA_PER_LED * LED_MATRIX_COUNT;
+#if LED_POWER_LIMIT_MA
+    // Sum of the bytes sent that the budget allows, above the idle current
+    static constexpr uint32_t BUDGET_SUM =
+        LED_POWER_LIMIT_MA > IDLE_MA ? (LED_POWER_LIMIT_MA - IDLE_MA) * 255 / LED_MA_PER_CHANNEL : 0;
+#endif
+    
+    // Brightness the level table is built for: the user's, under the power limit
+    int levelBrightness() const { return (m_brightness * m_powerScale + 128) >> 8; }
+    
+    static inline uint16_t blend16(uint16_t under, uint8_t over, uint32_t a) {
+        return (uint16_t)((int32_t)under + (((((int32_t)over << 8) - (int32_t)under) * (int32_t)a) >> 8));
+    }
+    
+    static RGB16 widen(RGB_SPI c) {
+        return RGB16{(uint16_t)(c.r << 8), (uint16_t)(c.g << 8), (uint16_t)(c.b << 8)};
+    }
+    
+    static RGB_SPI narrow(const RGB16& c) {
+        return RGB_SPI(c.r >> 8, c.g >> 8, c.b >> 8);
+    }
+    
+    // Colour byte -> linear level in 8.8 (255 -> 255.0)
+    static const uint16_t* gammaTable() { return LED_GAMMA_TABLE.level; }
+    
+    // FNV-1a over the framebuffer and the layers
+    uint32_t frameHash() const {
+        uint32_t h = hashBytes(2166136261u, m_framebuffer, sizeof(m_framebuffer));
+        for (int l = 0; l < m_layerCount; l++) {
+            const LedLayer& layer = m_layers[l];
+            const uint8_t params[4] = {layer.colour.r, layer.colour.g, layer.colour.b, layer.alpha};
+            h = hashBytes(h, params, sizeof(params));
+            if (layer.sprite) h = hashBytes(h, layer.sprite, sizeof(SpritePx) * LED_MATRIX_COUNT);
+        }
+        return h;
+    }
+    
+    static uint32_t hashBytes(uint32_t h, const void* data, size_t len) {
+        const uint8_t* p = (const uint8_t*)data;
+        for (size_t i = 0; i < len; i++) {
+            h = (h ^ p[i]) * 16777619u;
+        }
+        return h;
+    }
+    
+    const LedLayer* m_layers = nullptr;
+    int m_layerCount = 0;
+    uint16_t m_levelLut[257];   // 8.8 level per colour byte at m_lutBrightness
+    int m_lutBrightness = -1;
+    uint8_t m_fractionSeen = 0;
+    bool m_fractional = false;
+    uint32_t m_levelSum = 0;        // Bytes sent this frame, summed
+    uint32_t m_estimatedMa = 0;
+    uint16_t m_powerScale = 256;
+#if LED_DITHER
+    uint8_t m_carry[LED_MATRIX_COUNT][3];   // Dither error per channel
+#endif
+    uint32_t m_sentHash = 0;
+    int m_sentBrightness = -1;  // -1: nothing sent yet
+    uint16_t m_unchangedFrames = 0;
+    uint32_t m_sentFrames = 0;
+};
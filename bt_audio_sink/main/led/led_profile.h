@@ -0,0 +1,122 @@
+#pragma once
+
+// -----------------------------------------------------------
+// LED Profile - per-effect frame cost (CONFIG_LED_PROFILE)
+// - Render (effect update) and show (encode + SPI queue) time of
+//   every effect frame, as microsecond histograms per effect
+// - Frames whose render + show went over the frame budget,
+//   counted per effect
+// - Written by the LED task only; a reader's snapshot may be one
+//   frame stale, and reset is applied by the LED task (as PerfTrace)
+// - Histograms live in PSRAM when there is some: ~14 KB
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "led_config.h"
+#include "../audio/perf_trace.h"
+
+class LedProfile {
+public:
+    struct Stats {
+        TraceHistogram render;
+        TraceHistogram show;
+        uint32_t overruns = 0;
+    };
+
+    bool init() {
+        if (m_stats) return true;
+        const size_t bytes = sizeof(Stats) * LED_EFFECT_COUNT;
+        m_stats = (Stats*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!m_stats) m_stats = (Stats*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+        if (!m_stats) {
+            ESP_LOGW(TAG, "No memory for LED profile");
+            return false;
+        }
+        for (int i = 0; i < LED_EFFECT_COUNT; i++) new (&m_stats[i]) Stats();
+        return true;
+    }
+
+    // LED task, once per effect frame
+    void record(int effect, uint32_t renderUs, uint32_t showUs, bool overrun) {
+        if (!m_stats || effect < 0 || effect >= LED_EFFECT_COUNT) return;
+        if (m_resetReq.exchange(false, std::memory_order_acquire)) {
+            for (int i = 0; i < LED_EFFECT_COUNT; i++) m_stats[i] = Stats();
+        }
+        Stats& s = m_stats[effect];
+        s.render.add(renderUs);
+        s.show.add(showUs);
+        if (overrun) s.overruns++;
+    }
+
+    // Any task: cleared by the LED task on its next frame
+    void reset() { m_resetReq.store(true, std::memory_order_release); }
+
+    // [budget_us u16, n, {id, frames u16, render avg, p99, max u16,
+    //  show avg, max u16, overruns u16, quality}...] little-endian,
+    // effects that rendered, worst render max first, as many as fit
+    size_t serialize(uint8_t* out, size_t cap, uint32_t budgetUs, const uint8_t* quality) const {
+        if (!m_stats || cap < 3) return 0;
+        size_t idx = 0;
+        put16(out, idx, budgetUs);
+        const size_t countAt = idx++;
+        uint8_t n = 0;
+
+        bool taken[LED_EFFECT_COUNT] = {};
+        while (idx + ENTRY_BYTES <= cap) {
+            int worst = -1;
+            for (int i = 0; i < LED_EFFECT_COUNT; i++) {
+                if (taken[i] || m_stats[i].render.count == 0) continue;
+                if (worst < 0 || m_stats[i].render.max > m_stats[worst].render.max) worst = i;
+            }
+            if (worst < 0) break;
+            taken[worst] = true;
+
+            Stats s;
+            memcpy(&s, &m_stats[worst], sizeof(s));
+            out[idx++] = (uint8_t)worst;
+            put16(out, idx, s.render.count);
+            put16(out, idx, s.render.avg());
+            put16(out, idx, s.render.percentile(99));
+            put16(out, idx, s.render.max);
+            put16(out, idx, s.show.avg());
+            put16(out, idx, s.show.max);
+            put16(out, idx, s.overruns);
+            out[idx++] = quality[worst];
+            n++;
+        }
+        out[countAt] = n;
+        return idx;
+    }
+
+    void log(const char* tag, const char* const* names) const {
+        if (!m_stats) return;
+        for (int i = 0; i < LED_EFFECT_COUNT; i++) {
+            const Stats& s = m_stats[i];
+            if (s.render.count == 0) continue;
+            ESP_LOGI(tag, "LED %-14s n=%u render avg %u p99 %u max %u us, show avg %u max %u us, over %u",
+                     names[i] ? names[i] : "?", (unsigned)s.render.count,
+                     (unsigned)s.render.avg(), (unsigned)s.render.percentile(99), (unsigned)s.render.max,
+                     (unsigned)s.show.avg(), (unsigned)s.show.max, (unsigned)s.overruns);
+        }
+    }
+
+    static constexpr size_t ENTRY_BYTES = 1 + 7 * 2 + 1;
+
+private:
+    static constexpr const char* TAG = "LedProfile";
+
+    // Saturating: counts and times past 65535 read as 65535
+    static void put16(uint8_t* out, size_t& idx, uint32_t v) {
+        if (v > 0xFFFF) v = 0xFFFF;
+        out[idx++] = (uint8_t)v;
+        out[idx++] = (uint8_t)(v >> 8);
+    }
+
+    Stats* m_stats = nullptr;
+    std::atomic<bool> m_resetReq{false};
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+// -----------------------------------------------------------
+// LED Render Toolkit - lookup tables shared by the effects
+// - Generated at compile time into flash, so effects do no
+//   per-pixel trig, square roots or HSV sector math and nothing
+//   is built at boot
+// - Geometry is for the 16x16 grid the effects draw on, centred
+//   between the middle four pixels (7.5, 7.5)
+// - Distances are Q4 fixed point (16 = one pixel); angles are
+//   0-255 per turn, the same units as sin8() and hue
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <math.h>
+#include "led_config.h"
+#include "led_driver_spi.h"
+#include "../dsp/const_math.h"
+
+static constexpr int LED_FX_SIZE = 16;              // Effect grid edge
+static constexpr int LED_FX_MAX_DIST_Q4 = 340;      // > corner-to-corner in Q4
+
+struct LedRenderTables {
+    uint8_t hue[256][3];                            // fromHSV(h, 255, 255)
+    int8_t sin[256];                                // sin, -127..127
+    uint16_t centreDist[LED_FX_SIZE][LED_FX_SIZE];  // From (7.5, 7.5), Q4
+    uint8_t centreAngle[LED_FX_SIZE][LED_FX_SIZE];  // atan2 around the centre
+    uint16_t offsetDist[LED_FX_SIZE][LED_FX_SIZE];  // sqrt(dx^2 + dy^2), Q4
+    uint16_t recipDist[LED_FX_MAX_DIST_Q4 + 1];     // 1 / (d + 0.5), Q12
+    RGB_SPI heat[256];                              // Fire palette
+};
+
+static constexpr LedRenderTables makeLedRenderTables() {
+    LedRenderTables t{};
+    const double turn = 2.0 * CM_PI;
+    for (int i = 0; i < 256; i++) {
+        const RGB_SPI c = RGB_SPI::fromHSV((uint8_t)i, 255, 255);
+        t.hue[i][0] = c.r;
+        t.hue[i][1] = c.g;
+        t.hue[i][2] = c.b;
+        t.sin[i] = (int8_t)cm_lround(127.0 * cm_sin(turn * i / 256.0));
+
+        const uint8_t h = (uint8_t)i;
+        if (h < 85) {
+            t.heat[i] = RGB_SPI(h * 3, 0, 0);
+        } else if (h < 170) {
+            t.heat[i] = RGB_SPI(255, (h - 85) * 3, 0);
+        } else {
+            t.heat[i] = RGB_SPI(255, 255, (h - 170) * 3);
+        }
+    }
+    for (int y = 0; y < LED_FX_SIZE; y++) {
+        for (int x = 0; x < LED_FX_SIZE; x++) {
+            const double dx = x - 7.5, dy = y - 7.5;
+            t.centreDist[y][x] = (uint16_t)cm_lround(cm_sqrt(dx * dx + dy * dy) * 16.0);
+            t.centreAngle[y][x] = (uint8_t)(cm_lround(cm_atan2(dy, dx) * (256.0 / turn)) & 0xFF);
+            t.offsetDist[y][x] = (uint16_t)cm_lround(cm_sqrt((double)(x * x + y * y)) * 16.0);
+        }
+    }
+    for (int d = 0; d <= LED_FX_MAX_DIST_Q4; d++) {
+        t.recipDist[d] = (uint16_t)(65536 / (d + 8));
+    }
+    return t;
+}
+
+static constexpr LedRenderTables s_ledTables = makeLedRenderTables();
+
+// HSV to RGB through the hue table: saturation blends toward white,
+// value scales, both by multiply-shift
+static inline RGB_SPI hsv8(uint8_t h, uint8_t s, uint8_t v) {
+    const uint8_t* c = s_ledTables.hue[h];
+    uint16_t r = c[0], g = c[1], b = c[2];
+    if (s != 255) {
+        const uint16_t w = 255 - s;
+        r += ((255 - r) * w + 128) >> 8;
+        g += ((255 - g) * w + 128) >> 8;
+        b += ((255 - b) * w + 128) >> 8;
+    }
+    return RGB_SPI((r * v + 128) >> 8, (g * v + 128) >> 8, (b * v + 128) >> 8);
+}
+
+// True sine, angle 0-255 per turn, -127..127
+static inline int8_t sinLut8(uint8_t angle) { return s_ledTables.sin[angle]; }
+
+// Same from a 16-bit phase (65536 per turn), for smooth slow motion
+static inline int8_t sinLut16(uint16_t phase) { return s_ledTables.sin[phase >> 8]; }
+
+// Distance / angle of an effect-grid pixel from the centre
+static inline uint16_t centreDistQ4(int x, int y) { return s_ledTables.centreDist[y][x]; }
+static inline uint8_t centreAngle8(int x, int y) { return s_ledTables.centreAngle[y][x]; }
+
+// Length of an integer offset, |dx|, |dy| < 16
+static inline uint16_t offsetDistQ4(int dx, int dy) {
+    return s_ledTables.offsetDist[dy < 0 ? -dy : dy][dx < 0 ? -dx : dx];
+}
+
+// 1 / (d + 0.5) in Q12 for a Q4 distance
+static inline uint16_t recipDistQ12(uint16_t distQ4) {
+    return s_ledTables.recipDist[distQ4 > LED_FX_MAX_DIST_Q4 ? LED_FX_MAX_DIST_Q4 : distQ4];
+}
+
+static inline const RGB_SPI& heatColor(uint8_t heat) { return s_ledTables.heat[heat]; }
@@ -0,0 +1,94 @@
+#pragma once
+
+// -----------------------------------------------------------
+// LED Text Strip - overlay text rendered once, blitted per frame
+// - Glyph columns from ledFontRasterize() are expanded once per text
+//   change into sprite pixels: glyph pixels in one colour and alpha,
+//   the rest a backing pixel
+// - Each row is kept in the matrix's serpentine order (odd rows right
+//   to left, as LedFrame::indexXY) and padded with a matrix width of
+//   backing on both sides, so any scroll position from -width to the
+//   text's end is one memcpy per row into the sprite
+// - Rows above or below the matrix are clipped; the scroll position is
+//   clamped to the padded strip
+// - Pixels from PSRAM when there is some, allocated on first use
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "led_config.h"
+#include "led_frame.h"
+#include "led_font.h"
+
+class LedTextStrip {
+public:
+    static constexpr int PAD = LED_MATRIX_WIDTH;    // Backing columns each side
+
+    // maxCols glyph columns, LED_FONT_H rows from matrix row top
+    LedTextStrip(int maxCols, int top) : m_maxCols(maxCols), m_top(top) {}
+    ~LedTextStrip() {
+        if (m_px) heap_caps_free(m_px);
+    }
+
+    // Expand glyph columns (bit 0 the top row); false without memory.
+    // LED task.
+    bool set(const uint8_t* columns, int cols, RGB_SPI colour, uint8_t alpha, SpritePx back) {
+        if (!alloc()) return false;
+        if (cols > m_maxCols) cols = m_maxCols;
+        m_cols = cols;
+        const SpritePx on = {colour.r, colour.g, colour.b, alpha};
+        for (int y = 0; y < LED_FONT_H; y++) {
+            SpritePx* row = m_px + y * stride();
+            for (int i = 0; i < stride(); i++) row[i] = back;
+            const bool reversed = ((m_top + y) & 1) != 0;
+            for (int c = 0; c < cols; c++) {
+                if (columns[c] & (1u << y)) row[slot(c, reversed)] = on;
+            }
+        }
+        return true;
+    }
+
+    int cols() const { return m_cols; }
+
+    // The matrix-wide window from strip column scroll into the text rows
+    // of a matrix sprite. LED task.
+    void blitWindow(SpritePx* sprite, int scroll) const {
+        if (!m_px) return;
+        if (scroll < -PAD) scroll = -PAD;
+        if (scroll > m_cols) scroll = m_cols;
+        for (int y = 0; y < LED_FONT_H; y++) {
+            const int row = m_top + y;
+            if (row < 0 || row >= LED_MATRIX_HEIGHT) continue;
+            const SpritePx* src = m_px + y * stride();
+            // Odd rows: the window's last column lands on the row's first LED
+            src += (row & 1) ? slot(scroll + LED_MATRIX_WIDTH - 1, true) : slot(scroll, false);
+            memcpy(sprite + row * LED_MATRIX_WIDTH, src, LED_MATRIX_WIDTH * sizeof(SpritePx));
+        }
+    }
+
+private:
+    static constexpr const char* TAG = "LedText";
+
+    int stride() const { return m_maxCols + 2 * PAD; }
+    int slot(int col, bool reversed) const {
+        return reversed ? stride() - 1 - (PAD + col) : PAD + col;
+    }
+
+    bool alloc() {
+        if (m_px) return true;
+        const size_t bytes = (size_t)stride() * LED_FONT_H * sizeof(SpritePx);
+        if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0) {
+            m_px = (SpritePx*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (!m_px) m_px = (SpritePx*)heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!m_px) ESP_LOGW(TAG, "No memory for overlay text (%u KB)", (unsigned)(bytes / 1024));
+        return m_px != nullptr;
+    }
+
+    const int m_maxCols;
+    const int m_top;
+    SpritePx* m_px = nullptr;
+    int m_cols = 0;
+};
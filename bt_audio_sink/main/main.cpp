@@ -12,12 +12,12 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/gpio.h"
-#include "driver/i2s.h"
 #include "nvs_flash.h"
 #include "esp_log.h"
 #include "esp_ota_ops.h"
 #include "esp_partition.h"
 #include "esp_bt_device.h"
+#include "esp_bt_main.h"
 #include "BluetoothA2DPSink.h"
 
 // Modular components
@@ -28,8 +28,57 @@
 #include "audio/audio_pipeline.h"
 #include "audio/sound_player.h"
 #include "audio/overlay_mixer.h"
+#include "audio/memory_pressure.h"
+#include "audio/codec_policy.h"
+#include "audio/link_monitor.h"
+#include "audio/peer_stream_cache.h"
 #include "ble/ble_unified.h"
 #include "ota/idf_update.h"
+#include "ota/ota_window.h"
+#include "ota/ota_writer.h"
+#include "ota/ota_validator.h"
+#include "core/boot_graph.h"
+#include "core/power_manager.h"
+#include "core/static_alloc.h"
+#include "core/mem_placement.h"
+#include "core/event_bus.h"
+#include "core/work_queue.h"
+#include "core/event_log.h"
+#include "audio/sync_link.h"
+#include "audio/net_ingest.h"
+#if APP_TRACK_INFO
+#include "audio/track_metadata.h"
+#endif
+#if APP_TASK_DIAGNOSTICS
+#include "core/task_diagnostics.h"
+#endif
+#if APP_GLITCH_JOURNAL
+#include "audio/glitch_journal.h"
+#endif
+#if APP_LATENCY_PROFILES
+#include "audio/latency_profile.h"
+#endif
+#if APP_DELAY_REPORT
+#include "audio/delay_report.h"
+#endif
+#if APP_PAGE_SCAN_POLICY
+#include "core/page_scan_policy.h"
+#endif
+#if APP_BLE_BULK_CHANNEL
+#include "ble/ble_bulk.h"
+#endif
+#if APP_HFP
+#include "audio/hfp_link.h"
+#endif
+#if APP_PERF_CONSOLE
+#include "core/perf_console.h"
+#endif
+#if APP_FLEET_REPORT
+#include "ota/fleet_report.h"
+#endif
+#if APP_AVRCP_QUEUE
+#include "audio/avrcp_queue.h"
+#endif
 
 // SPIFFS for sound storage
 #include "esp_spiffs.h"
@@ -39,6 +88,9 @@
 // LED Matrix support
 #ifdef CONFIG_LED_MATRIX_ENABLE
 #include "led/led_controller.h"
+#if APP_BEAT_LED_FADE
+#include "led/indicator_led.h"
+#endif
 #endif
 
 // Encoder support
@@ -59,6 +111,19 @@ static OverlayMixer    g_overlayMixer;
 static BleUnifiedService g_ble;
 static BluetoothA2DPSink g_a2dp;
 static IdfUpdate       g_update;
+static MemoryPressure  g_memPressure;
+static CodecPolicy     g_codecPolicy;
+#if APP_LINK_MONITOR
+static LinkMonitor     g_link;
+#endif
+static BootGraph       g_boot;
+static PeerStreamCache g_peerStreams;
+#if APP_TASK_DIAGNOSTICS
+static TaskDiagnostics g_taskDiag;
+#endif
+#if APP_DSP_VOLUME
+static A2DPNoVolumeControl g_sinkVolumeBypass;  // Volume is applied in g_dsp instead
+#endif
 
 // Sound player reference (singleton)
 #define g_sound SoundPlayer::getInstance()
@@ -69,13 +134,48 @@ static volatile SoundType g_soundUploadType = SOUND_STARTUP;
 static volatile uint32_t g_soundUploadSize = 0;
 static volatile uint32_t g_soundUploadReceived = 0;
 static uint8_t*          g_soundUploadBuf = nullptr;
+#if APP_DSP_FIR
+// Uploads of type FirConvolver::UPLOAD_TYPE carry a room correction IR
+static volatile bool     g_soundUploadIsIr = false;
+static const char*       FIR_IR_PATH = "/spiffs/fir_ir.bin";
+#endif
+#ifdef CONFIG_LED_ANIMATION
+// Uploads of type LedAnimation::UPLOAD_TYPE carry the Custom LED effect
+static volatile bool     g_soundUploadIsAnim = false;
+static const char*       LED_ANIM_PATH = "/spiffs/led_anim.bin";
+#endif
 
 // Audio state
 static volatile uint8_t  g_bitsPerSample = 16;
+static volatile SampleFmt g_sampleFmt = SAMPLE_FMT_S16;
 static volatile uint8_t  g_channels = 2;
 static volatile uint32_t g_sampleRate = APP_I2S_DEFAULT_SAMPLE_RATE;
 static volatile bool     g_otaActive = false;
 static volatile int64_t  g_otaCheckPassedTime = 0;  // Timestamp when CHECK passed (0 = not passed)
+static volatile bool     g_audioStreaming = false;  // A2DP audio started
+#if APP_AUDIO_PERF_TRACE
+// Stack's media counters at the last trace reset (they restart with
+// every codec configuration on their own)
+static esp_a2d_sink_rx_stats_t g_traceRxBase = {};
+#endif
+
+// BLE connection parameters follow the radio's other users: long
+// intervals while A2DP streams, short ones for OTA / sound uploads
+static void bleLinkUpdate() {
+    g_ble.setLinkDemand(g_audioStreaming, g_otaActive || g_soundUploadActive);
+}
+
+static void setOtaActive(bool active) {
+    const bool changed = g_otaActive != active;
+    g_otaActive = active;
+    bleLinkUpdate();
+    if (changed) EventBus::getInstance().publish(active ? BUS_OTA_BEGIN : BUS_OTA_END);
+}
+
+static void setSoundUploadActive(bool active) {
+    g_soundUploadActive = active;
+    bleLinkUpdate();
+}
 
 // Pairing mode coordination flag - prevents disconnect callback from clearing pairing mode
 static volatile bool     g_pairingModeActive = false;  // True while in pairing mode (discoverable)
@@ -88,6 +188,34 @@ static const int64_t     CODEC_SWITCH_TIMEOUT_US = 5000000;  // 5 seconds - if r
 static volatile int64_t  g_lastCodecConfigTime = 0;    // Timestamp of last codec config
 static volatile bool     g_connectedSoundPending = false;  // True if waiting to play connected sound
 static const int64_t     CODEC_STABLE_DELAY_US = 400000;   // 400ms - wait this long after last codec config
+static const int64_t     PEER_FORMAT_STABLE_DELAY_US = 100000;  // 100ms - when the config matched the peer's cached format
+static esp_timer_handle_t g_connectedSoundTimer = nullptr;  // Restarted by each codec config
+
+// Event-driven control tasks: buttonsTask waits on these notification
+// bits, beatTask on a give from the analysis task per published result
+enum : uint32_t {
+    BTN_EVT_EDGE            = 0x00000001,   // << button pin index
+    BTN_EVT_SETTLED         = 0x00000100,   // << button pin index
+    BTN_EVT_CONNECTED_SOUND = 0x00010000,
+};
+static TaskHandle_t g_buttonsTaskHandle = nullptr;
+static TaskHandle_t g_beatTaskHandle = nullptr;
+
+// Fast reconnect: stream format set up from the peer's cache before its codec config arrives
+static volatile bool     g_streamPreset = false;
+static PeerStreamCache::Format g_streamPresetFmt = {};
+
+#if APP_NET_INGEST
+// WiFi ingest playing: the output runs its format, A2DP's waits here
+static volatile bool     g_ingestOwnsOutput = false;
+static PeerStreamCache::Format g_ingestSavedFmt = {};
+#endif
+
+#if APP_HFP
+// Hands-free call: the output plays the call, A2DP waits in this format
+static volatile bool     g_voiceActive = false;
+static PeerStreamCache::Format g_voiceSavedFmt = {};
+#endif
 
 // Connection timestamp - to ignore initial volume report from phone
 static volatile int64_t  g_lastConnectTime = 0;        // Timestamp of last A2DP connection
@@ -105,6 +233,19 @@ static volatile bool g_pauseBleNotifications = false;
 static volatile bool g_soundDeletePending = false;
 static volatile SoundType g_soundDeleteType = SOUND_STARTUP;
 
+// Deferred helper jobs (sound delete, OTA auto-finalize)
+static WorkQueue g_work;
+
+#if APP_AVRCP_QUEUE
+// AVRCP commands and knob volume to the phone, off the input tasks
+static AvrcpQueue g_avrcp;
+#endif
+
+#if APP_BEAT_LED_FADE
+// Beat LED on an LEDC fade; a fade under way when OTA starts ends dark
+static IndicatorLed g_beatLed;
+#endif
+
 // Beat detection state
 static float smooth30_dB = -60.0f;
 static float smooth60_dB = -60.0f;
@@ -113,6 +254,12 @@ static float smooth100_dB = -60.0f;
 // -----------------------------------------------------------
 // Control helpers
 // -----------------------------------------------------------
+// I2S clock for a stream rate: the stream's own, or the fixed rate
+// the pipeline resamples every stream to
+static uint32_t i2sRateFor(uint32_t rate) {
+    return APP_I2S_FIXED_RATE ? APP_I2S_FIXED_RATE_HZ : rate;
+}
+
 static uint8_t getControlByte() {
     uint8_t b = 0;
     if (g_dsp.isBassBoostEnabled()) b |= 0x01;
@@ -144,49 +291,133 @@ static void applyEq(int8_t bass, int8_t mid, int8_t treble, bool notifyBle = tru
     #endif
 }
 
+// Streaming CPU clock (APP_STREAM_CLOCK): SBC, AAC and aptX up to 48 kHz
+// at the light clock, everything else and binaural 3D at the full one.
+// Set with the stream format and again when 3D changes.
+static a2dp_codec_id_t g_clockCodec = A2DP_CODEC_ID_SBC;
+
+static void updateStreamClock(a2dp_codec_id_t codec, uint32_t rate) {
+#if APP_STREAM_CLOCK
+    g_clockCodec = codec;
+    bool light = false;
+    switch (codec) {
+        case A2DP_CODEC_ID_SBC:
+        case A2DP_CODEC_ID_AAC:
+        case A2DP_CODEC_ID_APTX:
+        case A2DP_CODEC_ID_APTX_LL: light = true; break;
+        default:                    break;
+    }
+    if (rate > 48000 || g_dsp.get3DMode() == DSPProcessor::SOUND_3D_BINAURAL) light = false;
+    PowerManager::getInstance().setStreamClock(light ? APP_STREAM_CLOCK_LIGHT_MHZ : PowerManager::FULL_MHZ);
+#else
+    (void)codec;
+    (void)rate;
+#endif
+}
+
+static void refreshStreamClock() { updateStreamClock(g_clockCodec, g_sampleRate); }
+
 // -----------------------------------------------------------
 // Encoder callbacks (hardware rotary encoders)
 // -----------------------------------------------------------
 #ifdef CONFIG_ENCODER_ENABLE
+#ifdef CONFIG_ENCODER_CLICK
+// Short tick on the overlay click voice per detent; rendered once per I2S rate
+static void playDetentClick() {
+    static constexpr size_t MAX_FRAMES = 96 * 4;  // 4 ms at up to 96 kHz
+    static int32_t click[MAX_FRAMES * 2];
+    static uint32_t clickRate = 0;
+    static size_t clickFrames = 0;
+    if (g_sound.isMuted()) return;
+    
+    const uint32_t rate = g_i2s.getSampleRate();
+    if (rate != clickRate) {
+        clickFrames = rate * 4 / 1000;
+        if (clickFrames > MAX_FRAMES) clickFrames = MAX_FRAMES;
+        for (size_t i = 0; i < clickFrames; i++) {
+            const float t = (float)i / (float)rate;
+            const float s = sinf(2.0f * (float)M_PI * 3000.0f * t) * expf(-t * 1500.0f);
+            click[i * 2] = click[i * 2 + 1] = (int32_t)(s * 0.25f * 2147483647.0f);
+        }
+        clickRate = rate;
+    }
+    g_overlayMixer.pushSamples(OVERLAY_VOICE_CLICK, click, clickFrames);
+    g_pipeline.wake();
+}
+#endif
+
 static void onEncoderVolume(uint8_t volume) {
     // Volume encoder: set absolute volume (0-127)
+    #if APP_AVRCP_QUEUE
+    g_avrcp.setVolume(volume);
+    #else
     g_a2dp.set_volume(volume);
+    #endif
+    #if APP_DSP_VOLUME
+    g_dsp.setVolume(volume);
+    #endif
+    EventBus::getInstance().publish(BUS_VOLUME_CHANGED, volume);
     
     // Update LED effect with volume level
     #ifdef CONFIG_LED_MATRIX_ENABLE
     LedController::getInstance().setVolume(volume);
     #endif
     
+    #ifdef CONFIG_ENCODER_CLICK
+    playDetentClick();
+    #endif
+    
     ESP_LOGI(TAG, "Encoder volume: %d", volume);
 }
 
+#if APP_AVRCP_QUEUE
+// AVRCP task: a knob command went out, or could not
+static void onAvrcpDone(uint8_t cmd, bool ok) {
+    ESP_LOGI(TAG, "AVRCP 0x%02X %s", cmd, ok ? "sent" : "not sent");
+}
+#endif
+
+// Passthrough command for the knobs: queued, or sent in this task
+static void sendAvrcp(uint8_t cmd) {
+    #if APP_AVRCP_QUEUE
+    g_avrcp.send(cmd, onAvrcpDone);
+    #else
+    switch (cmd) {
+        case ESP_AVRC_PT_CMD_PLAY:     g_a2dp.play(); break;
+        case ESP_AVRC_PT_CMD_PAUSE:    g_a2dp.pause(); break;
+        case ESP_AVRC_PT_CMD_FORWARD:  g_a2dp.next(); break;
+        case ESP_AVRC_PT_CMD_BACKWARD: g_a2dp.previous(); break;
+        default: break;
+    }
+    #endif
+}
+
 static void onEncoderPlayPause() {
     // Volume encoder button single click: toggle play/pause
     static bool isPlaying = true;
-    if (isPlaying) {
-        g_a2dp.pause();
-    } else {
-        g_a2dp.play();
-    }
+    sendAvrcp(isPlaying ? ESP_AVRC_PT_CMD_PAUSE : ESP_AVRC_PT_CMD_PLAY);
     isPlaying = !isPlaying;
     ESP_LOGI(TAG, "Encoder: %s", isPlaying ? "play" : "pause");
 }
 
 static void onEncoderNextTrack() {
     // Volume encoder button double click: next track
-    g_a2dp.next();
+    sendAvrcp(ESP_AVRC_PT_CMD_FORWARD);
     ESP_LOGI(TAG, "Encoder: next track");
 }
 
 static void onEncoderPrevTrack() {
     // Volume encoder button triple click: previous track
-    g_a2dp.previous();
+    sendAvrcp(ESP_AVRC_PT_CMD_BACKWARD);
     ESP_LOGI(TAG, "Encoder: previous track");
 }
 
 static void onEncoderEq(int8_t bass, int8_t mid, int8_t treble) {
     // EQ encoders: apply new values and sync to app
     applyEq(bass, mid, treble);
+    #ifdef CONFIG_ENCODER_CLICK
+    playDetentClick();
+    #endif
     
     // Show EQ overlay on LED matrix
     #ifdef CONFIG_LED_MATRIX_ENABLE
@@ -236,13 +467,16 @@ static void onEncoderPairingMode() {
     
     // Reset I2S to default sample rate for sound playback
     g_sampleRate = APP_I2S_DEFAULT_SAMPLE_RATE;
-    g_i2s.updateClock(APP_I2S_DEFAULT_SAMPLE_RATE);
+    g_i2s.updateClock(i2sRateFor(APP_I2S_DEFAULT_SAMPLE_RATE));
     g_dsp.setSampleRate(APP_I2S_DEFAULT_SAMPLE_RATE);
     
     // Enable discoverable mode for new device pairing
     // ESP_BT_GENERAL_DISCOVERABLE = visible to all devices for pairing
     ESP_LOGI(TAG, "Entering pairing mode - device is now discoverable");
     g_a2dp.set_discoverability(ESP_BT_GENERAL_DISCOVERABLE);
+#if APP_PAGE_SCAN_POLICY
+    PageScanPolicy::getInstance().forceFast(0);     // The new phone connects as soon as it has paired
+#endif
     
     // Play pairing sound (exclusive mode - no A2DP during pairing anyway)
     // Use actual I2S sample rate to ensure proper resampling
@@ -286,6 +520,7 @@ static void onEncoder3DSound(bool enabled) {
     // Treble encoder button double-click: toggle 3D sound effect
     g_dsp.set3DSound(enabled);
     g_settings.save3DSound(enabled);
+    refreshStreamClock();
     
     // Play a subtle feedback sound
     if (g_a2dpConnected && g_sound.hasSound(enabled ? SOUND_STARTUP : SOUND_STARTUP)) {
@@ -326,35 +561,61 @@ static void onBleEq(int8_t bass, int8_t mid, int8_t treble) {
     ESP_LOGI(TAG, "BLE EQ: %d/%d/%d", bass, mid, treble);
 }
 
-// EQ preset values (matches BleUnifiedProtocol.kt)
-static const int8_t EQ_PRESETS[][3] = {
-    {0, 0, 0},      // Flat
-    {6, 2, 0},      // Bass Boost
-    {0, 2, 6},      // Treble Boost
-    {-2, 4, 2},     // Vocal
-    {4, 0, 4},      // Rock
-    {2, 3, 4},      // Pop
-    {3, 0, 2},      // Jazz
-    {0, 2, 3},      // Classical
-    {5, 2, 4},      // Electronic
-    {6, 0, 2},      // Hip Hop
-    {2, 3, 3},      // Acoustic
-    {4, 2, 4}       // Loudness
-};
-static const size_t EQ_PRESET_COUNT = sizeof(EQ_PRESETS) / sizeof(EQ_PRESETS[0]);
+// DSP presets: BLE 0x02 applies one (the factory ones match the EQ
+// curves of BleUnifiedProtocol.kt), 0x0B stores one (saved to NVS)
+static DspPresetBank g_presets;
 
 static void onBleEqPreset(uint8_t presetId) {
-    if (presetId >= EQ_PRESET_COUNT) {
+    const DspPreset* p = g_presets.get(presetId);
+    if (!p) {
         ESP_LOGW(TAG, "Invalid EQ preset: %d", presetId);
         return;
     }
-    int8_t bass = EQ_PRESETS[presetId][0];
-    int8_t mid = EQ_PRESETS[presetId][1];
-    int8_t treble = EQ_PRESETS[presetId][2];
-    applyEq(bass, mid, treble, false);  // Don't notify back - command came from phone
-    ESP_LOGI(TAG, "BLE EQ preset %d: %d/%d/%d", presetId, bass, mid, treble);
+    g_dsp.applyPreset(*p);
+
+    // Settings and the other views follow; the EQ is not notified back
+    // (command came from phone), modes it may not know about are
+    if (p->fields & DspPreset::EQ) {
+        g_settings.saveEQ(p->eq[0], p->eq[1], p->eq[2]);
+        #ifdef CONFIG_ENCODER_ENABLE
+        EncoderController::getInstance().setCurrentEq(p->eq[0], p->eq[1], p->eq[2]);
+        #endif
+    }
+    if (p->fields & DspPreset::CONTROL) {
+        const uint8_t b = getControlByte();
+        g_settings.saveControl(b & 0x01, b & 0x02, b & 0x04);
+        g_ble.updateControl(b);
+    }
+    if (p->fields & DspPreset::SOUND_3D) {
+        g_settings.save3DSound(p->sound3D);
+        refreshStreamClock();
+        #ifdef CONFIG_ENCODER_ENABLE
+        EncoderController::getInstance().setCurrent3DSound(p->sound3D);
+        #endif
+    }
+    ESP_LOGI(TAG, "BLE EQ preset %d: %d/%d/%d (fields 0x%02x)",
+             presetId, p->eq[0], p->eq[1], p->eq[2], p->fields);
+}
+
+static bool onBleStorePreset(uint8_t slot, const uint8_t* data, size_t len) {
+    DspPreset preset;
+    if (!DspPresetBank::decode(data, len, preset)) return false;
+    if (!g_presets.set(slot, preset)) return false;
+    uint8_t blob[DspPresetBank::BLOB_BYTES];
+    size_t n = g_presets.serialize(blob, sizeof(blob));
+    g_settings.savePresets(blob, n);
+    return true;
 }
 
+#if APP_AUX_OUTPUT
+static bool onBleOutputLayout(uint8_t left, uint8_t right) {
+    if (!g_pipeline.setOutputLayout(left, right)) return false;
+    const uint8_t layout[2] = {left, right};
+    g_settings.saveOutputLayout(layout);
+    return true;
+}
+#endif
+
 static void onBleName(const char* name, size_t len) {
     g_settings.saveDeviceName(name);
     // Update Classic Bluetooth (A2DP) device name
@@ -364,6 +625,11 @@ static void onBleName(const char* name, size_t len) {
 }
 
 #ifdef CONFIG_LED_MATRIX_ENABLE
+// LED controller settings live in the settings blob
+static void onLedSettingsChanged(const uint8_t* settings, size_t len) {
+    g_settings.saveLedSettings(settings, len);
+}
+
 static void onBleLedEffect(uint8_t effectId) {
     LedController::getInstance().setEffect(effectId);
     g_settings.saveLedEffect(effectId);
@@ -449,13 +715,32 @@ static void onBleLedBrightness(uint8_t brightness100) {
 static volatile uint32_t g_otaReceived = 0;
 static volatile uint32_t g_otaTotalSize = 0;
 
-// OTA sequence number tracking for reordering
-static uint16_t g_otaExpectedSeq = 0;
-static const size_t OTA_REORDER_SLOTS = 32;
-static const size_t OTA_MAX_CHUNK = 514;  // 512 data + 2 seq
-static uint8_t g_otaReorderBuf[OTA_REORDER_SLOTS][OTA_MAX_CHUNK];
-static size_t g_otaReorderLen[OTA_REORDER_SLOTS];
-static bool g_otaReorderValid[OTA_REORDER_SLOTS];
+// Windowed OTA (BEGIN flag bit 0): sequenced chunks, reordered and acked
+static OtaWindow g_otaWindow;
+// Received image bytes, staged for the flash writer task
+static OtaWriter g_otaWriter;
+
+// Window the phone may use: as much as the staging ring can still take
+static uint8_t otaCredit() {
+    return g_otaWriter.active() ? g_otaWriter.credit(OtaWindow::WINDOW, OtaWindow::MAX_CHUNK)
+                                : (uint8_t)OtaWindow::WINDOW;
+}
+
+// Writer task: staging has room again after a short credit
+static void onOtaStagingSpace() {
+    if (g_otaWindow.active()) g_ble.sendOtaAck(g_otaWindow.nextSeq(), otaCredit());
+#if APP_BLE_BULK_CHANNEL
+    BleBulkChannel::getInstance().refill();
+#endif
+}
+
+// Everything staged reaches flash before the image is closed
+static void otaFinishStaging() {
+    if (g_otaWriter.active() && !g_otaWriter.drain(pdMS_TO_TICKS(5000))) {
+        ESP_LOGE(TAG, "OTA staging did not drain");
+    }
+    g_otaWriter.end();
+}
 
 // Parse OTA control command - supports both binary and ASCII protocols
 // Binary: 0x01 + 4-byte size (BEGIN), 0x03 (END), 0x04 (ABORT)
@@ -475,8 +760,12 @@ static void onBleOtaCtrl(const uint8_t* data, size_t len) {
         ESP_LOGI(TAG, "OTA BEGIN (ASCII): %u bytes", (unsigned)size);
         
         // Pause phone playback via AVRCP, disable audio, stop I2S
+        #if APP_AVRCP_QUEUE
+        g_avrcp.send(ESP_AVRC_PT_CMD_PAUSE);  // Goes out from the avrcp task
+        #else
         g_a2dp.pause();  // Send AVRCP pause to phone
         vTaskDelay(pdMS_TO_TICKS(50));  // Brief delay for AVRCP command
+        #endif
         g_a2dp.set_output_active(false);
         g_i2s.stop();  // Stop I2S to free resources
         
@@ -486,20 +775,21 @@ static void onBleOtaCtrl(const uint8_t* data, size_t len) {
         LedController::getInstance().setOtaProgress(0);
         #endif
         
-        g_otaActive = true;
+        setOtaActive(true);
         g_otaReceived = 0;
         g_otaTotalSize = size;
-        g_otaExpectedSeq = 0;
-        memset(g_otaReorderValid, 0, sizeof(g_otaReorderValid));
+        g_otaWindow.end();
+        g_otaWriter.end();
         if (!g_update.begin(size)) {
             ESP_LOGE(TAG, "OTA begin failed: %s", g_update.errorString());
             g_ble.notifyOtaCtrl("BEGIN_ERR");
-            g_otaActive = false;
+            setOtaActive(false);
             #ifdef CONFIG_LED_MATRIX_ENABLE
             LedController::getInstance().setOtaMode(false);
             #endif
             g_i2s.start();
         } else {
+            g_otaWriter.begin(&g_update, onOtaStagingSpace);
             ESP_LOGI(TAG, "OTA begin OK, waiting for data...");
             g_ble.notifyOtaCtrl("BEGIN_OK");
         }
@@ -531,6 +821,7 @@ static void onBleOtaCtrl(const uint8_t* data, size_t len) {
             ESP_LOGW(TAG, "OTA incomplete: missing %u bytes", (unsigned)(g_otaTotalSize - g_otaReceived));
         }
         
+        otaFinishStaging();
         if (g_update.end(true)) {
             g_ble.notifyOtaCtrl("END_OK");
             ESP_LOGI(TAG, "OTA complete, restarting...");
@@ -540,7 +831,9 @@ static void onBleOtaCtrl(const uint8_t* data, size_t len) {
             ESP_LOGE(TAG, "OTA end failed: %s", g_update.errorString());
             g_ble.notifyOtaCtrl("END_ERR");
         }
-        g_otaActive = false;
+        setOtaActive(false);
+        g_otaWindow.end();
+        g_otaWriter.end();
         return;
     }
     
@@ -565,14 +858,15 @@ static void onBleOtaCtrl(const uint8_t* data, size_t len) {
             g_otaCheckPassedTime = esp_timer_get_time();
             ESP_LOGI(TAG, "Starting auto-finalize timer (3s timeout)");
             
-            // Start a task to auto-finalize if no END received within 3 seconds
-            xTaskCreate([](void* param) {
+            // Auto-finalize if no END received within 3 seconds
+            g_work.run([](void* param) {
                 vTaskDelay(pdMS_TO_TICKS(3000));
                 
                 // Check if CHECK passed but no END was received (g_otaActive still true)
                 if (g_otaActive && g_otaCheckPassedTime > 0) {
                     ESP_LOGW(TAG, "OTA: No END received after CHECK passed, auto-finalizing...");
                     
+                    otaFinishStaging();
                     if (g_update.end(true)) {
                         ESP_LOGI(TAG, "OTA auto-finalize complete, rebooting in 1s");
                         g_ble.notifyOtaCtrl("END_OK");
@@ -582,11 +876,10 @@ static void onBleOtaCtrl(const uint8_t* data, size_t len) {
                         ESP_LOGE(TAG, "OTA auto-finalize failed: %s", g_update.errorString());
                         g_ble.notifyOtaCtrl("END_ERR");
                     }
-                    g_otaActive = false;
+                    setOtaActive(false);
                     g_otaCheckPassedTime = 0;
                 }
-                vTaskDelete(NULL);
-            }, "ota_auto_end", 4096, NULL, 5, NULL);
+            }, nullptr, "ota_auto_end", 4096, 5, tskNO_AFFINITY);
         } else {
             // Report how many bytes we're missing
             char resp[32];
@@ -599,7 +892,9 @@ static void onBleOtaCtrl(const uint8_t* data, size_t len) {
     
     if (data[0] == 'A' && len >= 5 && memcmp(data, "ABORT", 5) == 0) {
         ESP_LOGW(TAG, "OTA ABORT (ASCII)");
-        g_otaActive = false;
+        setOtaActive(false);
+        g_otaWindow.end();
+        g_otaWriter.end();
         g_otaReceived = 0;
         g_ble.notifyOtaCtrl("ABORT_OK");
         return;
@@ -608,13 +903,21 @@ static void onBleOtaCtrl(const uint8_t* data, size_t len) {
     // Binary protocol fallback
     uint8_t cmd = data[0];
     
-    if (cmd == 0x01 && len >= 5) { // BEGIN
+    if (cmd == 0x01 && len >= 5) { // BEGIN [+ flags [+ sha256]]
         uint32_t size = data[1] | (data[2] << 8) | (data[3] << 16) | (data[4] << 24);
-        ESP_LOGI(TAG, "OTA BEGIN (binary): %u bytes", (unsigned)size);
+        const bool windowed = len >= 6 && (data[5] & 0x01);
+        // Resumable: the image digest identifies the transfer to pick up
+        const uint8_t* imageSha = (len >= 6 + OtaStream::DIGEST_BYTES && (data[5] & 0x02)) ? data + 6 : nullptr;
+        ESP_LOGI(TAG, "OTA BEGIN (binary): %u bytes%s%s", (unsigned)size, windowed ? ", windowed" : "",
+                 imageSha ? ", resumable" : "");
         
         // Pause phone playback via AVRCP, disable audio, stop I2S
+        #if APP_AVRCP_QUEUE
+        g_avrcp.send(ESP_AVRC_PT_CMD_PAUSE);  // Goes out from the avrcp task
+        #else
         g_a2dp.pause();  // Send AVRCP pause to phone
         vTaskDelay(pdMS_TO_TICKS(50));  // Brief delay for AVRCP command
+        #endif
         g_a2dp.set_output_active(false);
         g_i2s.stop();  // Stop I2S to free resources
         
@@ -624,22 +927,39 @@ static void onBleOtaCtrl(const uint8_t* data, size_t len) {
         LedController::getInstance().setOtaProgress(0);
         #endif
         
-        g_otaActive = true;
+        setOtaActive(true);
         g_otaReceived = 0;
         g_otaTotalSize = size;
-        g_otaExpectedSeq = 0;
-        memset(g_otaReorderValid, 0, sizeof(g_otaReorderValid));
-        if (!g_update.begin(size)) {
+        g_otaWindow.end();
+        g_otaWriter.end();
+        if (!g_update.begin(size, nullptr, imageSha)) {
             ESP_LOGE(TAG, "OTA begin failed: %s", g_update.errorString());
             g_ble.notifyOtaCtrl("BEGIN_ERR");
-            g_otaActive = false;
+            setOtaActive(false);
             #ifdef CONFIG_LED_MATRIX_ENABLE
             LedController::getInstance().setOtaMode(false);
             #endif
             g_i2s.start();
         } else {
-            ESP_LOGI(TAG, "OTA begin OK, waiting for data...");
-            g_ble.notifyOtaCtrl("BEGIN_OK");
+            g_otaWriter.begin(&g_update, onOtaStagingSpace);
+            // A resumed update has everything before its offset in flash
+            g_otaReceived = (uint32_t)g_update.resumeOffset();
+            ESP_LOGI(TAG, "OTA begin OK, waiting for data from %u...", (unsigned)g_otaReceived);
+            if (imageSha) {
+                g_ble.sendOtaReady(g_otaReceived);
+            } else {
+                g_ble.notifyOtaCtrl("BEGIN_OK");
+            }
+            // The first ack (next 0) tells the phone it may stream; without
+            // it (no memory for the window) it keeps to acked writes.
+            // Sequence numbers count from the resume offset.
+            if (windowed) {
+                if (g_otaWindow.begin()) {
+                    g_ble.sendOtaAck(0, otaCredit());
+                } else {
+                    ESP_LOGW(TAG, "OTA window: no memory, unwindowed");
+                }
+            }
         }
     } else if (cmd == 0x03) { // END
         ESP_LOGI(TAG, "OTA END (binary) received, flushing remaining data...");
@@ -661,6 +981,7 @@ static void onBleOtaCtrl(const uint8_t* data, size_t len) {
             ESP_LOGW(TAG, "OTA incomplete: missing %u bytes", (unsigned)(g_otaTotalSize - g_otaReceived));
         }
         
+        otaFinishStaging();
         if (g_update.end(true)) {
             g_ble.notifyOtaCtrl("END_OK");
             ESP_LOGI(TAG, "OTA complete, restarting...");
@@ -670,24 +991,33 @@ static void onBleOtaCtrl(const uint8_t* data, size_t len) {
             ESP_LOGE(TAG, "OTA end failed: %s", g_update.errorString());
             g_ble.notifyOtaCtrl("END_ERR");
         }
-        g_otaActive = false;
+        setOtaActive(false);
+        g_otaWindow.end();
+        g_otaWriter.end();
     } else if (cmd == 0x04) { // ABORT
         ESP_LOGW(TAG, "OTA ABORT (binary)");
-        g_otaActive = false;
+        setOtaActive(false);
+        g_otaWindow.end();
+        g_otaWriter.end();
         g_otaReceived = 0;
     } else {
         ESP_LOGW(TAG, "OTA CTRL unknown cmd: 0x%02X (char='%c')", cmd, (cmd >= 32 && cmd < 127) ? cmd : '?');
     }
 }
 
-static void onBleOtaData(const uint8_t* data, size_t len) {
-    if (!g_otaActive || len == 0) return;
-    
-    // Ignore 1-byte flush packets (used by Android to sync at end)
-    if (len == 1) return;
-    
-    // Direct write - rely on BLE ACK for ordering
-    g_update.write(data, len);
+// In-order OTA data to the writer task (flash directly without one),
+// with progress. False when staging has no room for it.
+static bool otaWrite(const uint8_t* data, size_t len) {
+    if (g_otaWriter.active()) {
+        // Unwindowed senders have no other flow control: wait for room
+        const TickType_t wait = g_otaWindow.active() ? 0 : pdMS_TO_TICKS(2000);
+        if (!g_otaWriter.push(data, len, wait)) {
+            if (!g_otaWindow.active()) ESP_LOGE(TAG, "OTA staging full, %u bytes lost", (unsigned)len);
+            return false;
+        }
+    } else {
+        g_update.write(data, len);
+    }
     g_otaReceived += len;
     
     // Calculate and update progress
@@ -704,34 +1034,69 @@ static void onBleOtaData(const uint8_t* data, size_t len) {
         ESP_LOGI(TAG, "OTA: %3u%% (%u / %u bytes)", pct, (unsigned)g_otaReceived, (unsigned)g_otaTotalSize);
         lastPctLogged = pct;
     }
+    return true;
+}
+
+static void onBleOtaData(const uint8_t* data, size_t len) {
+    if (!g_otaActive || len == 0) return;
+    
+    // Ignore 1-byte flush packets (used by Android to sync at end)
+    if (len == 1) return;
+    
+    // Direct write - rely on BLE ACK for ordering
+    otaWrite(data, len);
+}
+
+// Windowed OTA chunk: [seq u16 LE, data...], written without response
+static void onBleOtaWindowData(const uint8_t* data, size_t len) {
+    if (!g_otaActive || len < 3) return;
+    const uint16_t seq = data[0] | (data[1] << 8);
+    g_otaWindow.accept(seq, data + 2, len - 2, otaWrite);
+    // Also ack the tail of the image, which may not fill an ack interval
+    const bool done = g_otaTotalSize > 0 && g_otaReceived >= g_otaTotalSize;
+    if (g_otaWindow.takeAckDue() || done) {
+        g_ble.sendOtaAck(g_otaWindow.nextSeq(), otaCredit());
+    }
 }
 
 // Unified OTA callback - handles all OTA commands from ble_unified protocol
 static void onBleOtaUnified(uint8_t cmd, const uint8_t* data, size_t len) {
     // Translate unified protocol commands to existing handlers
-    // BleCmd::OTA_BEGIN (0x20) -> binary 0x01 + 4-byte size
-    // BleCmd::OTA_DATA  (0x21) -> raw data (no seq prefix in unified)
+    // BleCmd::OTA_BEGIN (0x20) -> binary 0x01 + 4-byte size [+ flags]
+    // BleCmd::OTA_DATA  (0x21) -> raw data, or sequenced when windowed
     // BleCmd::OTA_END   (0x22) -> ASCII "END"
     // BleCmd::OTA_ABORT (0x23) -> ASCII "ABORT"
     
     switch (cmd) {
-        case 0x20: {  // OTA_BEGIN - [size_lo, size_mid, size_hi, size_hhi]
+        case 0x20: {  // OTA_BEGIN - [size u32, (flags), (sha256 x32)]
             if (len >= 4) {
-                uint8_t pkt[5] = { 0x01, data[0], data[1], data[2], data[3] };
-                onBleOtaCtrl(pkt, 5);
+                uint8_t pkt[6 + OtaStream::DIGEST_BYTES] = { 0x01, data[0], data[1], data[2], data[3],
+                                                             (uint8_t)(len >= 5 ? data[4] : 0) };
+                size_t pktLen = 6;
+                if (len >= 5 + OtaStream::DIGEST_BYTES) {
+                    memcpy(pkt + 6, data + 5, OtaStream::DIGEST_BYTES);
+                    pktLen += OtaStream::DIGEST_BYTES;
+                }
+                onBleOtaCtrl(pkt, pktLen);
             } else {
                 g_ble.sendOtaFailed(BleError::INVALID_PARAM);
             }
             break;
         }
-        case 0x21: {  // OTA_DATA - [seq, data...]
+        case 0x21: {  // OTA_DATA - [seq, data...], windowed [seq u16, data...]
+            if (g_otaWindow.active()) {
+                onBleOtaWindowData(data, len);
+                break;
+            }
             // Skip sequence byte if present, write raw data
             if (len > 1) {
                 onBleOtaData(data + 1, len - 1);
             }
             break;
         }
-        case 0x22: {  // OTA_END
+        case 0x22: {  // OTA_END - [(sha256 x32)]
+            // With a digest the image must match it to be activated
+            if (len >= OtaStream::DIGEST_BYTES) g_update.setSHA256(data);
             onBleOtaCtrl((const uint8_t*)"END", 3);
             break;
         }
@@ -754,14 +1119,20 @@ static void onBleOtaUnified(uint8_t cmd, const uint8_t* data, size_t len) {
 //   CMD [0x02]        = Request status (reply: status byte)
 // 
 // Upload protocol (on SoundData characteristic):
-//   START: [0x01][soundType][size(4)][reserved(4)] -> ACK: 0xA1
+//   START: [0x01][soundType][size(4)][flags][reserved(3)] -> ACK: 0xA1
 //   DATA:  [0x02][seq(2)][len(2)][payload...]      -> ACK: 0xA2
 //   END:   [0x03]                                  -> ACK: 0xA3
 //   ERROR responses: 0xE0+code
 // NOTE: ACKs use 0xAx to avoid conflict with muted status (0x80-0x8F)
+//
+// Windowed upload (START flags bit 0): SOUND_UP_DATA chunks carry a u16
+// sequence number and go out without waiting for SOUND_READY; they land
+// in the PSRAM upload buffer and SOUND_ACK reports progress as for OTA.
+// Flash is only touched once, by soundSaveTask after END.
 
 // Sound upload state
 static volatile uint16_t g_soundUploadExpectedSeq = 0;
+static OtaWindow g_soundWindow;
 static TaskHandle_t g_soundSaveTaskHandle = nullptr;
 static volatile uint8_t g_soundSaveResult = 0;  // 0=pending, 0xA3=success, 0xE4+=error
 
@@ -780,9 +1151,13 @@ static void notifySoundAck(uint8_t code);
 static void preallocSoundSaveStack() {
     if (g_soundSaveTaskStack) return;  // Already allocated
     
-    g_soundSaveTaskStack = (StackType_t*)heap_caps_malloc(
-        SOUND_SAVE_STACK_SIZE * sizeof(StackType_t), 
-        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    g_soundSaveTaskStack = (StackType_t*)StaticAlloc::take(
+        "snd_save", SOUND_SAVE_STACK_SIZE * sizeof(StackType_t), StaticAlloc::INTERNAL);
+    if (!g_soundSaveTaskStack) {
+        g_soundSaveTaskStack = (StackType_t*)heap_caps_malloc(
+            SOUND_SAVE_STACK_SIZE * sizeof(StackType_t), 
+            MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
     
     if (g_soundSaveTaskStack) {
         ESP_LOGI(TAG, "Sound save stack pre-allocated in internal RAM: %u bytes", 
@@ -800,6 +1175,17 @@ static void soundSaveTask(void* param) {
     uint8_t* buf = g_soundUploadBuf;
     uint32_t size = g_soundUploadReceived;
     SoundType type = g_soundUploadType;
+#if APP_DSP_FIR
+    const bool isIr = g_soundUploadIsIr;
+#else
+    const bool isIr = false;
+#endif
+#ifdef CONFIG_LED_ANIMATION
+    const bool isAnim = g_soundUploadIsAnim;
+#else
+    const bool isAnim = false;
+#endif
+    const bool isRaw = isIr || isAnim;     // Stored as uploaded, not a sound
     
     ESP_LOGI(TAG, "Sound save task started: type=%d, size=%u, buf=%p", 
              type, (unsigned)size, buf);
@@ -809,8 +1195,9 @@ static void soundSaveTask(void* param) {
         goto notify_and_cleanup;
     }
     
-    // Validate WAV header minimally
-    if (size < 44) {
+    // Validate WAV header minimally (an IR or animation was validated when
+    // it was loaded)
+    if (size < 44 && !isRaw) {
         ESP_LOGE(TAG, "Sound save task: data too small for WAV");
         result = 0x08;  // Error: data too small
         goto notify_and_cleanup;
@@ -820,8 +1207,30 @@ static void soundSaveTask(void* param) {
     // This prevents BLE stack congestion that causes disconnects
     g_pauseBleNotifications = true;
     
-    // Yield to let BLE stack finish any pending operations
-    vTaskDelay(pdMS_TO_TICKS(200));
+    // PCM is stored as stereo S16 at the I2S rate, so playback needs no
+    // resampling; IMA ADPCM is stored as uploaded
+    if (!isRaw) {
+        uint8_t* canonical = nullptr;
+        size_t canonicalSize = 0;
+        if (g_sound.transcode(buf, size, canonical, canonicalSize)) {
+            heap_caps_free(buf);
+            buf = canonical;
+            size = canonicalSize;
+        }
+    }
+    
+    // Raw asset partition: no filesystem, erased a few sectors ahead of
+    // the writes, so far shorter pauses than the SPIFFS path below
+    if (!isRaw && g_sound.hasAssetStore()) {
+        if (type >= SOUND_TYPE_COUNT) {
+            ESP_LOGE(TAG, "Invalid sound type: %d", type);
+            result = 0x09;  // Error: invalid type
+            goto notify_and_cleanup;
+        }
+        ESP_LOGI(TAG, "Sound save task: writing to asset partition...");
+        result = g_sound.saveSound(type, buf, size, 30) ? 0 : 0x04;  // 0x04: write failed
+        goto notify_and_cleanup;
+    }
     
     ESP_LOGI(TAG, "Sound save task: writing to SPIFFS...");
     
@@ -849,12 +1258,19 @@ static void soundSaveTask(void* param) {
     // Write file in chunks to avoid watchdog issues
     {
         // Use path from SOUND_PATHS array for consistency
-        if (type >= SOUND_TYPE_COUNT) {
+        if (type >= SOUND_TYPE_COUNT && !isRaw) {
             ESP_LOGE(TAG, "Invalid sound type: %d", type);
             result = 0x09;  // Error: invalid type
             goto notify_and_cleanup;
         }
+#if APP_DSP_FIR
+        const char* path = isIr ? FIR_IR_PATH : SOUND_PATHS[type];
+#else
         const char* path = SOUND_PATHS[type];
+#endif
+#ifdef CONFIG_LED_ANIMATION
+        if (isAnim) path = LED_ANIM_PATH;
+#endif
         ESP_LOGI(TAG, "Sound save: type=%d, path=%s, size=%u", type, path, (unsigned)size);
         
         // Try to delete existing file first
@@ -892,11 +1308,10 @@ static void soundSaveTask(void* param) {
             written += w;
             fflush(f);  // Force flush to flash after each sector
             
-            // Long delay after each sector to let BT stack fully recover
-            // Flash erase blocks bus for ~50-100ms, so we give 150ms recovery
-            // This makes saves slow (~150ms per 4KB = ~4 sec for 100KB file)
-            // but prevents audio disruption
-            vTaskDelay(pdMS_TO_TICKS(150));
+            // While A2DP streams, let the BT stack recover after each sector:
+            // the erase blocks the bus for ~50-100ms. Without audio the
+            // file is written at full speed.
+            vTaskDelay(pdMS_TO_TICKS(g_audioStreaming ? 150 : 1));
         }
         
         // Ensure all data is flushed to flash
@@ -919,13 +1334,10 @@ notify_and_cleanup:
         heap_caps_free(buf);
     }
     g_soundUploadBuf = nullptr;
-    g_soundUploadActive = false;
+    setSoundUploadActive(false);
     g_soundUploadSize = 0;
     g_soundUploadReceived = 0;
     
-    // Longer delay before sending notification to let BLE stack recover
-    vTaskDelay(pdMS_TO_TICKS(200));
-    
     // Send result notification using proper unified protocol response
     if (result == 0) {
         ESP_LOGI(TAG, "Sound save complete, sending SOUND_COMPLETE (0x32)");
@@ -936,7 +1348,6 @@ notify_and_cleanup:
     }
     
     // Send updated sound status (which sounds are present, muted, etc.)
-    vTaskDelay(pdMS_TO_TICKS(150));
     g_ble.updateSoundStatus(g_sound.getStatus());
     
     g_soundSaveTaskHandle = nullptr;
@@ -964,8 +1375,8 @@ static void onBleSoundMute(bool muted) {
     ESP_LOGI(TAG, "Sound mute set: %s", muted ? "MUTED" : "UNMUTED");
 }
 
-// Task to delete sound file (deferred from BLE callback to avoid crash)
-static void soundDeleteTask(void* param) {
+// Job to delete sound file (deferred from BLE callback to avoid crash)
+static void soundDeleteJob(void* param) {
     SoundType type = g_soundDeleteType;
     
     // Pause BLE meter notifications during critical SPIFFS operation
@@ -1002,16 +1413,15 @@ static void soundDeleteTask(void* param) {
     
     g_soundDeletePending = false;
     ESP_LOGI(TAG, "Sound deleted: type=%d", type);
-    vTaskDelete(NULL);
 }
 
 static void onBleSoundDelete(uint8_t soundType) {
     SoundType type = (SoundType)(soundType & 0x03);
     if (type <= SOUND_MAX_VOLUME && !g_soundDeletePending) {
-        // Defer delete to separate task to avoid crashing from BLE callback
+        // Defer delete off the BLE callback to avoid crashing from it
         g_soundDeletePending = true;
         g_soundDeleteType = type;
-        xTaskCreatePinnedToCore(soundDeleteTask, "snd_del", 2048, nullptr, 1, nullptr, 1);
+        if (!g_work.run(soundDeleteJob, nullptr, "snd_del", 2048, 1, 1)) g_soundDeletePending = false;
         ESP_LOGI(TAG, "Sound delete queued: type=%d", type);
     }
 }
@@ -1040,10 +1450,10 @@ static void onBleSoundCtrl(const uint8_t* data, size_t len) {
     if (cmd == 0x01 && len >= 2) {
         SoundType type = (SoundType)(data[1] & 0x03);
         if (type <= SOUND_MAX_VOLUME && !g_soundDeletePending) {
-            // Defer delete to separate task to avoid crashing from BLE callback
+            // Defer delete off the BLE callback to avoid crashing from it
             g_soundDeletePending = true;
             g_soundDeleteType = type;
-            xTaskCreatePinnedToCore(soundDeleteTask, "snd_del", 2048, nullptr, 1, nullptr, 1);
+            if (!g_work.run(soundDeleteJob, nullptr, "snd_del", 2048, 1, 1)) g_soundDeletePending = false;
             ESP_LOGI(TAG, "Sound delete queued (legacy): type=%d", type);
         }
         return;
@@ -1060,8 +1470,8 @@ static void onBleSoundData(const uint8_t* data, size_t len) {
     if (len < 1) return;
     
     uint8_t pktType = data[0];
-    ESP_LOGI(TAG, "Sound DATA packet: pktType=0x%02X, len=%d", pktType, (int)len);
-    ESP_LOG_BUFFER_HEX(TAG, data, len > 16 ? 16 : len);  // Dump first 16 bytes
+    ESP_LOGD(TAG, "Sound DATA packet: pktType=0x%02X, len=%d", pktType, (int)len);
+    ESP_LOG_BUFFER_HEX_LEVEL(TAG, data, len > 16 ? 16 : len, ESP_LOG_DEBUG);  // Dump first 16 bytes
     
     // START packet: [0x01][soundType][size(4)][reserved(4)]
     if (pktType == 0x01 && len >= 6) {
@@ -1071,8 +1481,21 @@ static void onBleSoundData(const uint8_t* data, size_t len) {
         
         ESP_LOGI(TAG, "Sound START parsed: raw_byte1=0x%02X, type=%d, size=%u", rawType, type, (unsigned)size);
         
+        uint32_t maxSize = 200 * 1024;
+#if APP_DSP_FIR
+        g_soundUploadIsIr = (rawType == FirConvolver::UPLOAD_TYPE);
+        if (g_soundUploadIsIr) maxSize = FirConvolver::MAX_BLOB_BYTES;
+        bool typeOk = rawType <= 3 || g_soundUploadIsIr;
+#else
+        bool typeOk = rawType <= 3;
+#endif
+#ifdef CONFIG_LED_ANIMATION
+        g_soundUploadIsAnim = (rawType == LedAnimation::UPLOAD_TYPE);
+        if (g_soundUploadIsAnim) maxSize = LedAnimation::MAX_BLOB_BYTES;
+        typeOk = typeOk || g_soundUploadIsAnim;
+#endif
         // Validate type - reject if raw value > 3 (indicates invalid value like -1/0xFF)
-        if (rawType > 3) {
+        if (!typeOk) {
             ESP_LOGE(TAG, "Invalid sound type: 0x%02X (must be 0-3)", rawType);
             g_ble.sendSoundFailed(0x09);  // Error: invalid type
             return;
@@ -1084,9 +1507,9 @@ static void onBleSoundData(const uint8_t* data, size_t len) {
             g_soundUploadBuf = nullptr;
         }
         
-        // Validate size (max 200KB)
-        if (size > 200 * 1024) {
-            ESP_LOGE(TAG, "Sound too large: %u bytes (max 200KB)", (unsigned)size);
+        // Validate size (max 200KB, or the largest IR)
+        if (size > maxSize) {
+            ESP_LOGE(TAG, "Sound too large: %u bytes (max %u)", (unsigned)size, (unsigned)maxSize);
             g_ble.sendSoundFailed(0x01);  // Error: too large
             return;
         }
@@ -1107,7 +1530,16 @@ static void onBleSoundData(const uint8_t* data, size_t len) {
         g_soundUploadSize = size;
         g_soundUploadReceived = 0;
         g_soundUploadExpectedSeq = 0;
-        g_soundUploadActive = true;
+        setSoundUploadActive(true);
+        
+        // Windowed: the whole file fits the buffer, so the window is never cut
+        const bool windowed = len >= 7 && (data[6] & 0x01);
+        g_soundWindow.end();
+        if (windowed && g_soundWindow.begin()) {
+            g_ble.sendSoundAck(0, OtaWindow::WINDOW);
+            ESP_LOGI(TAG, "Sound upload started (windowed, %d chunks)", OtaWindow::WINDOW);
+            return;
+        }
         
         g_ble.sendSoundReady();  // Ready for data chunks
         ESP_LOGI(TAG, "Sound upload started, sent SOUND_READY (0x31)");
@@ -1156,8 +1588,32 @@ static void onBleSoundData(const uint8_t* data, size_t len) {
     if (pktType == 0x03) {
         ESP_LOGI(TAG, "Sound END: received %u / %u bytes", 
                  (unsigned)g_soundUploadReceived, (unsigned)g_soundUploadSize);
+        g_soundWindow.end();
         
         if (g_soundUploadActive && g_soundUploadBuf && g_soundUploadReceived > 0) {
+#if APP_DSP_FIR
+            // Apply the IR right away; the save task only persists it
+            if (g_soundUploadIsIr && !g_dsp.fir().loadIr(g_soundUploadBuf, g_soundUploadReceived)) {
+                g_ble.sendSoundFailed(0x0A);  // Error: bad IR or busy
+                heap_caps_free(g_soundUploadBuf);
+                g_soundUploadBuf = nullptr;
+                setSoundUploadActive(false);
+                return;
+            }
+#endif
+#ifdef CONFIG_LED_ANIMATION
+            // Shown right away as the Custom effect; the save task persists it
+            if (g_soundUploadIsAnim) {
+                if (!LedController::getInstance().loadAnimation(g_soundUploadBuf, g_soundUploadReceived)) {
+                    g_ble.sendSoundFailed(0x0B);  // Error: bad animation or no memory
+                    heap_caps_free(g_soundUploadBuf);
+                    g_soundUploadBuf = nullptr;
+                    setSoundUploadActive(false);
+                    return;
+                }
+                LedController::getInstance().setEffect(LED_EFFECT_CUSTOM);
+            }
+#endif
             // Defer save to separate task to avoid crashing from BLE callback
             // The task will send ACK and cleanup
             if (g_soundSaveTaskHandle == nullptr) {
@@ -1188,7 +1644,7 @@ static void onBleSoundData(const uint8_t* data, size_t len) {
                             heap_caps_free(g_soundUploadBuf);
                             g_soundUploadBuf = nullptr;
                         }
-                        g_soundUploadActive = false;
+                        setSoundUploadActive(false);
                     }
                 } else {
                     // Fallback to dynamic allocation (may fail if internal RAM is low)
@@ -1202,7 +1658,7 @@ static void onBleSoundData(const uint8_t* data, size_t len) {
                             heap_caps_free(g_soundUploadBuf);
                             g_soundUploadBuf = nullptr;
                         }
-                        g_soundUploadActive = false;
+                        setSoundUploadActive(false);
                     }
                 }
             } else {
@@ -1211,21 +1667,42 @@ static void onBleSoundData(const uint8_t* data, size_t len) {
             }
         } else {
             g_ble.sendSoundFailed(0x05);  // Error: no data
-            g_soundUploadActive = false;
+            setSoundUploadActive(false);
         }
         return;
     }
 }
 
+// In-order windowed sound data into the upload buffer
+static bool soundWindowWrite(const uint8_t* data, size_t len) {
+    const uint32_t spaceLeft = g_soundUploadSize - g_soundUploadReceived;
+    if (len > spaceLeft) len = spaceLeft;
+    memcpy(g_soundUploadBuf + g_soundUploadReceived, data, len);
+    g_soundUploadReceived += len;
+    return true;
+}
+
+// Windowed sound chunk: [seq u16 LE, data...], written without response
+static void onBleSoundWindowData(const uint8_t* data, size_t len) {
+    if (!g_soundUploadActive || !g_soundUploadBuf || len < 3) return;
+    const uint16_t seq = data[0] | (data[1] << 8);
+    g_soundWindow.accept(seq, data + 2, len - 2, soundWindowWrite);
+    // Also ack the tail of the file, which may not fill an ack interval
+    const bool done = g_soundUploadReceived >= g_soundUploadSize;
+    if (g_soundWindow.takeAckDue() || done) {
+        g_ble.sendSoundAck(g_soundWindow.nextSeq(), OtaWindow::WINDOW);
+    }
+}
+
 // Unified sound upload callback - adapts from BleCmd:: format to legacy format
 static void onBleSoundUpload(uint8_t cmd, const uint8_t* data, size_t len) {
     // The unified protocol uses a simplified format:
-    // BleCmd::SOUND_UP_START (0x12): [type, size_lo, size_mid, size_hi] (4 bytes, 3-byte size)
-    // BleCmd::SOUND_UP_DATA  (0x13): [seq(1), data...] (1 + N bytes)
+    // BleCmd::SOUND_UP_START (0x12): [type, size_lo, size_mid, size_hi, (flags)] (4-5 bytes, 3-byte size)
+    // BleCmd::SOUND_UP_DATA  (0x13): [seq(1), data...] (1 + N bytes), windowed [seq u16, data...]
     // BleCmd::SOUND_UP_END   (0x14): (no payload)
     //
     // Legacy format expected by onBleSoundData:
-    // START: [0x01][type][size(4 bytes LE)] (6 bytes minimum)
+    // START: [0x01][type][size(4 bytes LE)][flags] (6 bytes minimum)
     // DATA:  [0x02][seq_lo][seq_hi][len_lo][len_hi][payload...] (5 + N bytes)
     // END:   [0x03] (1 byte)
     
@@ -1238,17 +1715,22 @@ static void onBleSoundUpload(uint8_t cmd, const uint8_t* data, size_t len) {
                 ESP_LOGE(TAG, "SOUND_UP_START too short: %u bytes", (unsigned)len);
                 return;
             }
-            uint8_t pkt[6];
+            uint8_t pkt[7];
             pkt[0] = 0x01;      // pktType = START
             pkt[1] = data[0];   // soundType
             pkt[2] = data[1];   // size_lo
             pkt[3] = data[2];   // size_mid
             pkt[4] = data[3];   // size_hi
             pkt[5] = 0;         // size_hh (pad to 4-byte size, assuming <16MB)
-            onBleSoundData(pkt, 6);
+            pkt[6] = (len >= 5) ? data[4] : 0;  // flags
+            onBleSoundData(pkt, 7);
             break;
         }
         case 0x13: {  // SOUND_UP_DATA
+            if (g_soundWindow.active()) {
+                onBleSoundWindowData(data, len);
+                break;
+            }
             // Convert from [seq(1)][data...] to [0x02][seq_lo][seq_hi][len_lo][len_hi][data...]
             if (len < 1) return;
             
@@ -1280,6 +1762,37 @@ static void onBleSoundUpload(uint8_t cmd, const uint8_t* data, size_t len) {
     }
 }
 
+#if APP_BLE_BULK_CHANNEL
+// -----------------------------------------------------------
+// BLE bulk channel: OTA and sound upload data as L2CAP SDUs,
+// started and ended over GATT as before
+// -----------------------------------------------------------
+
+// Host task: credits only cover what staging can take, so the
+// writer never waits (without one the flash write holds the host)
+static void onBulkData(uint8_t kind, const uint8_t* data, size_t len) {
+    if (len == 0) return;
+    if (kind == BleCmd::OTA_DATA && g_otaActive) {
+        otaWrite(data, len);
+    } else if (kind == BleCmd::SOUND_UP_DATA && g_soundUploadActive && g_soundUploadBuf) {
+        soundWindowWrite(data, len);
+    } else {
+        ESP_LOGW(TAG, "Bulk: %u bytes of 0x%02X dropped, no transfer", (unsigned)len, kind);
+    }
+}
+
+// OTA data is bounded by the staging ring; sound goes to a buffer
+// holding the whole file
+static uint16_t bulkCredit(uint16_t mps) {
+    return g_otaWriter.active() ? g_otaWriter.credit(BleBulkChannel::MAX_CREDITS, mps)
+                                : BleBulkChannel::MAX_CREDITS;
+}
+
+static size_t onBleBulkStatus(uint8_t* out, size_t cap) {
+    return BleBulkChannel::getInstance().status(out, cap);
+}
+#endif
+
 // -----------------------------------------------------------
 // A2DP callbacks
 // -----------------------------------------------------------
@@ -1296,95 +1809,1189 @@ static const char* getCodecName(esp_a2d_mct_t type) {
     }
 }
 
-static void onCodecConfig(uint32_t rate, uint8_t bps, uint8_t channels) {
-    if (rate == 0) rate = 44100;
-    
-    // Get codec type (the library's codec_config.c already logs vendor ID details)
-    esp_a2d_mct_t codecType = g_a2dp.get_audio_type();
-    const char* codecName = getCodecName(codecType);
-    
-    ESP_LOGI(TAG, "========================================");
-    ESP_LOGI(TAG, "CODEC CONFIGURATION RECEIVED");
-    ESP_LOGI(TAG, "========================================");
-    ESP_LOGI(TAG, "  Codec type: %s (0x%02X)", codecName, codecType);
-    ESP_LOGI(TAG, "  Sample rate: %u Hz", (unsigned)rate);
-    ESP_LOGI(TAG, "  Bits/sample: %u", (unsigned)bps);
-    ESP_LOGI(TAG, "  Channels: %u", (unsigned)channels);
-    
-    // Note: For vendor codecs, check CODEC_CONFIG log above which shows:
-    // - "configure LDAC codec" for LDAC (Vendor ID: 0x012D, Codec ID: 0x00AA)
-    // - "configure aptX codec" for aptX (Vendor ID: 0x004F, Codec ID: 0x0001)
-    // - "configure aptX-HD codec" for aptX-HD (Vendor ID: 0x00D7, Codec ID: 0x0024)
-    
-    ESP_LOGI(TAG, "========================================");
-    
-    // Pause pipeline during codec reconfiguration to prevent race conditions
-    g_pipeline.clear();
-    
-    g_sampleRate = rate;
-    g_bitsPerSample = bps;
-    g_channels = channels;
-    g_i2s.updateClock(rate);
-    g_dsp.setSampleRate(rate);
-    
-    // Mark that we need to play connected sound after codec stabilizes
-    g_lastCodecConfigTime = esp_timer_get_time();
-    g_connectedSoundPending = true;
-    
-    // Small delay to let I2S stabilize after clock change
-    vTaskDelay(pdMS_TO_TICKS(20));
-    
-    // Note: Connected sound is now played by buttonsTask after codec is stable
+#if APP_LATENCY_PROFILES
+static volatile uint8_t g_latencyProfile = LATENCY_PROFILE_BALANCED;
+#endif
+
+// Per-codec jitter buffer target (Kconfig)
+static uint32_t codecJitterTargetMs(a2dp_codec_id_t codec) {
+    switch (codec) {
+        case A2DP_CODEC_ID_AAC:     return APP_JB_TARGET_AAC_MS;
+        case A2DP_CODEC_ID_APTX:    return APP_JB_TARGET_APTX_MS;
+        case A2DP_CODEC_ID_APTX_LL: return APP_JB_TARGET_APTX_LL_MS;
+        case A2DP_CODEC_ID_APTX_HD: return APP_JB_TARGET_APTX_HD_MS;
+        case A2DP_CODEC_ID_LDAC:    return APP_JB_TARGET_LDAC_MS;
+        case A2DP_CODEC_ID_OPUS:    return APP_JB_TARGET_OPUS_MS;
+        case A2DP_CODEC_ID_LC3PLUS: return APP_JB_TARGET_LC3PLUS_MS;
+        case A2DP_CODEC_ID_SBC:
+        default:                    return APP_JB_TARGET_SBC_MS;
+    }
 }
 
-static void onStreamData(const uint8_t* data, uint32_t len) {
-    g_pipeline.enqueue(data, len, g_bitsPerSample, g_channels);
+// Jitter buffer target for the latency profile, used until measured jitter raises it
+static uint32_t jitterTargetForCodec(a2dp_codec_id_t codec) {
+#if APP_LATENCY_PROFILES
+    return LatencyProfile::get(g_latencyProfile).jitterTarget(codecJitterTargetMs(codec));
+#else
+    return codecJitterTargetMs(codec);
+#endif
 }
 
-static void onConnectionState(esp_a2d_connection_state_t state, void* user) {
-    const char* stateStr = "Unknown";
-    switch (state) {
-        case ESP_A2D_CONNECTION_STATE_DISCONNECTED: stateStr = "DISCONNECTED"; break;
-        case ESP_A2D_CONNECTION_STATE_CONNECTING:   stateStr = "CONNECTING"; break;
-        case ESP_A2D_CONNECTION_STATE_CONNECTED:    stateStr = "CONNECTED"; break;
-        case ESP_A2D_CONNECTION_STATE_DISCONNECTING: stateStr = "DISCONNECTING"; break;
+// PCM layout each decoder delivers for its bits/sample
+static SampleFmt sampleFmtForCodec(a2dp_codec_id_t codec, uint8_t bps) {
+    if (bps <= 16) return SAMPLE_FMT_S16;
+    switch (codec) {
+        case A2DP_CODEC_ID_LC3PLUS: return SAMPLE_FMT_S24_IN_32;   // LC3_PCM_FORMAT_S24
+        default:                    return SAMPLE_FMT_S32;         // LDAC S32, aptX decode32
     }
-    
-    ESP_LOGI(TAG, ">>> A2DP Connection: %s", stateStr);
-    
-    // Set connection timestamp early (on CONNECTING) to ensure grace period works
-    // Volume events can arrive before CONNECTED state
-    if (state == ESP_A2D_CONNECTION_STATE_CONNECTING) {
-        g_lastConnectTime = esp_timer_get_time();
+}
+
+// I2S DMA chain depth per codec: low-latency codecs get a short chain,
+// high-bitrate ones a deep chain to ride out decode stalls
+static I2SLatencyClass codecI2sLatency(a2dp_codec_id_t codec) {
+    switch (codec) {
+        case A2DP_CODEC_ID_APTX_LL:
+        case A2DP_CODEC_ID_OPUS:
+        case A2DP_CODEC_ID_LC3PLUS: return I2S_LATENCY_LOW;
+        case A2DP_CODEC_ID_AAC:
+        case A2DP_CODEC_ID_APTX_HD:
+        case A2DP_CODEC_ID_LDAC:    return I2S_LATENCY_DEEP;
+        case A2DP_CODEC_ID_SBC:
+        case A2DP_CODEC_ID_APTX:
+        default:                    return I2S_LATENCY_STANDARD;
     }
-    
-    if (state == ESP_A2D_CONNECTION_STATE_DISCONNECTED) {
-        // Mark as disconnected
-        g_a2dpConnected = false;
-        
-        // Record disconnect time for codec switch detection
-        g_lastDisconnectTime = esp_timer_get_time();
-        
-        // Cancel any pending connected sound
-        g_connectedSoundPending = false;
-        
-        ESP_LOGW(TAG, "A2DP disconnected - waiting for phone to reconnect with new codec...");
-        g_pipeline.clear();
-        g_i2s.zeroDMA();  // Clear any stale audio data
-        
-        // Only reset sample rate and discoverability if NOT in pairing mode
-        // (pairing mode handler sets these intentionally and they should persist)
-        if (!g_pairingModeActive) {
-            g_sampleRate = APP_I2S_DEFAULT_SAMPLE_RATE;  // Reset sample rate for sound effects
-            g_i2s.updateClock(APP_I2S_DEFAULT_SAMPLE_RATE);
-            g_dsp.setSampleRate(APP_I2S_DEFAULT_SAMPLE_RATE);
-            
-            // The library sets connectable=true on disconnect, but we want to stay non-discoverable
-            // Wait for library to finish, then disable discoverable mode again
-            vTaskDelay(pdMS_TO_TICKS(50));
-            g_a2dp.set_discoverability(ESP_BT_NON_DISCOVERABLE);
-            ESP_LOGI(TAG, "Discoverability disabled - press pairing button for new devices");
-            
+}
+
+// The latency profile may force one chain for every codec
+static I2SLatencyClass i2sLatencyForCodec(a2dp_codec_id_t codec) {
+#if APP_LATENCY_PROFILES
+    return LatencyProfile::get(g_latencyProfile).i2sLatency(codecI2sLatency(codec));
+#else
+    return codecI2sLatency(codec);
+#endif
+}
+
+#if APP_AUDIO_LATENCY_PROBE
+// -----------------------------------------------------------
+// Latency probe: Bluedroid stamps packets on arrival, the
+// pipeline times the stamped frame out of the I2S DMA
+// -----------------------------------------------------------
+static a2dp_codec_id_t g_latencyCodec = A2DP_CODEC_ID_SBC;
+
+extern "C" void esp_a2d_sink_media_stamp_hook(uint32_t rtp_ts, uint32_t arrival_us) {
+    g_pipeline.stampNextWrite(rtp_ts, arrival_us);
+}
+
+// Summary of the codec just measured, before its stats are reset
+static void logLatency() {
+    TraceHistogram h;
+    g_pipeline.latency().snapshot(h);
+    if (h.count == 0) return;
+    ESP_LOGI(TAG, "Latency %s: n=%u min %.1f avg %.1f p99 %.1f max %.1f ms (jitter target %u ms, DMA %u us)",
+             get_codec_id_name(g_latencyCodec), (unsigned)h.count,
+             h.min / 1000.0f, h.avg() / 1000.0f, h.percentile(99) / 1000.0f, h.max / 1000.0f,
+             (unsigned)jitterTargetForCodec(g_latencyCodec), (unsigned)g_i2s.getDmaLatencyUs());
+}
+
+static size_t onBleLatency(uint8_t* out, size_t cap) {
+    if (cap < 1 + LatencyProbe::SUMMARY_BYTES) return 0;
+    out[0] = (uint8_t)g_latencyCodec;
+    size_t n = g_pipeline.latency().serialize(out + 1, cap - 1);
+    return n ? 1 + n : 0;
+}
+#endif
+
+// I2S, DSP filters and jitter buffer for one stream format
+static void applyStreamFormat(const PeerStreamCache::Format& fmt) {
+    g_sampleRate = fmt.sampleRate;
+    g_bitsPerSample = fmt.bitsPerSample;
+    g_sampleFmt = sampleFmtForCodec(fmt.codec, fmt.bitsPerSample);
+    g_channels = fmt.channels;
+    g_i2s.reconfigure(i2sRateFor(fmt.sampleRate), i2sLatencyForCodec(fmt.codec));
+    g_dsp.setSampleRate(fmt.sampleRate);
+    g_pipeline.setStreamFormat(fmt.sampleRate, g_sampleFmt, fmt.channels, jitterTargetForCodec(fmt.codec));
+    updateStreamClock(fmt.codec, fmt.sampleRate);
+#if APP_SYNC_MASTER
+    SyncLink::getInstance().setSampleRate(fmt.sampleRate);
+#endif
+}
+
+// Playout delay from a packet's arrival, from the current settings
+struct LatencyEstimate {
+    uint32_t jitterUs;      // Jitter buffer target
+    uint32_t dmaUs;         // I2S DMA chain
+    uint32_t limiterUs;     // Limiter lookahead
+    uint32_t totalUs() const { return jitterUs + dmaUs + limiterUs; }
+};
+
+static LatencyEstimate estimateLatency() {
+    LatencyEstimate e = { g_pipeline.getJitterBuffer().getTargetMs() * 1000, g_i2s.getDmaLatencyUs(), 0 };
+#if APP_DSP_LIMITER
+    if (g_sampleRate) e.limiterUs = (uint32_t)((uint64_t)g_dsp.limiterDelay() * 1000000 / g_sampleRate);
+#endif
+    return e;
+}
+
+#if APP_DELAY_REPORT
+// -----------------------------------------------------------
+// AVDTP delay report (see delay_report.h): measured latency once
+// the probe has enough packets, else the estimate
+// -----------------------------------------------------------
+static DelayReporter g_delayReport;
+static esp_timer_handle_t g_delayReportTimer = nullptr;
+
+static void reportDelay(bool force) {
+    uint32_t us = estimateLatency().totalUs();
+#if APP_AUDIO_LATENCY_PROBE
+    TraceHistogram h;
+    g_pipeline.latency().snapshot(h);
+    if (h.count >= DelayReporter::MIN_PROBE_PACKETS) us = h.avg();
+#endif
+    g_delayReport.update(us, force);
+}
+
+// Once a second: follows the jitter target as measured jitter moves it
+static void onDelayReportTick(void* arg) {
+    if (g_audioStreaming) reportDelay(false);
+}
+#endif
+
+#if APP_LATENCY_PROFILES
+// -----------------------------------------------------------
+// Latency profiles (see latency_profile.h): BLE 0x0D / 0xF9 and
+// the treble triple click. Applied to the running stream at once;
+// the codecs offered change from the next connection.
+// -----------------------------------------------------------
+static void applyLatencyProfile(uint8_t id, bool save) {
+    if (id >= LATENCY_PROFILE_COUNT) return;
+    const LatencyProfile& profile = LatencyProfile::get(id);
+    g_latencyProfile = id;
+    esp_a2d_sink_set_rx_queue_limit(profile.rxQueueLimit);
+
+    // Limiter and analysis restart, like on a codec change
+    g_pipeline.clear();
+#if APP_DSP_LIMITER
+    g_dsp.setLimiterLookaheadUs(profile.limiterLookaheadUs);
+#endif
+    g_dsp.setAnalysisDecimated(profile.decimateAnalysis);
+    if (g_a2dpConnected) {
+        applyStreamFormat({ g_a2dp.get_codec_id(), g_sampleRate, g_bitsPerSample, g_channels });
+    }
+#if APP_AUDIO_LATENCY_PROBE
+    g_pipeline.latency().reset();   // Measured under the previous profile
+#endif
+#if APP_DELAY_REPORT
+    reportDelay(true);
+#endif
+    ESP_LOGI(TAG, "Latency profile: %s", profile.name);
+    if (save) g_settings.saveLatencyProfile(id);
+}
+
+static bool onBleLatencyProfile(uint8_t id) {
+    if (id >= LATENCY_PROFILE_COUNT) return false;
+    applyLatencyProfile(id, true);
+    return true;
+}
+
+// Estimate from the jitter target, the DMA chain and the limiter
+// lookahead, next to the measured average when the probe is built in
+static size_t onBleProfileStatus(uint8_t* out, size_t cap) {
+    if (cap < 11) return 0;
+    const LatencyEstimate e = estimateLatency();
+    const uint32_t jitterUs = e.jitterUs;
+    const uint32_t dmaUs = e.dmaUs;
+    const uint32_t limiterUs = e.limiterUs;
+    uint32_t measuredUs = 0;
+#if APP_AUDIO_LATENCY_PROBE
+    TraceHistogram h;
+    g_pipeline.latency().snapshot(h);
+    measuredUs = h.avg();
+#endif
+    const uint32_t estUs = e.totalUs();
+    const uint32_t fields[5] = { estUs, measuredUs, jitterUs, dmaUs, limiterUs };
+    out[0] = g_latencyProfile;
+    for (int i = 0; i < 5; i++) {
+        const uint32_t v = fields[i] / 100;
+        const uint16_t v16 = v < 0xFFFF ? (uint16_t)v : 0xFFFF;
+        out[1 + 2 * i] = (uint8_t)v16;
+        out[2 + 2 * i] = (uint8_t)(v16 >> 8);
+    }
+    ESP_LOGI(TAG, "Latency profile %s: est %.1f ms (jitter %.1f, DMA %.1f, limiter %.1f), measured %.1f ms",
+             LatencyProfile::get(g_latencyProfile).name, estUs / 1000.0f, jitterUs / 1000.0f,
+             dmaUs / 1000.0f, limiterUs / 1000.0f, measuredUs / 1000.0f);
+    return 11;
+}
+
+#ifdef CONFIG_ENCODER_ENABLE
+static void onEncoderProfileCycle() {
+    // Treble encoder button triple-click: balanced -> gaming -> hi-fi
+    applyLatencyProfile((uint8_t)((g_latencyProfile + 1) % LATENCY_PROFILE_COUNT), true);
+    g_ble.sendProfileStatus();
+}
+#endif
+#endif
+
+#if APP_DSP_DYNAMICS
+static bool onBleDynamics(uint8_t preset) {
+    if (!g_dsp.setDynamicsPreset(preset)) return false;
+    g_settings.saveDynamicsPreset(preset);
+    ESP_LOGI(TAG, "Dynamics: %s", MultibandDynamics::preset(preset).name);
+    return true;
+}
+#endif
+
+// 3D off keeps the kind, so the encoder's toggle brings back the last one
+static bool onBle3DMode(uint8_t mode) {
+    if (mode == DSPProcessor::SOUND_3D_OFF) {
+        g_dsp.set3DSound(false);
+    } else if (!g_dsp.set3DMode(mode)) {
+        return false;
+    } else {
+        g_settings.save3DBinaural(mode == DSPProcessor::SOUND_3D_BINAURAL);
+    }
+    g_settings.save3DSound(mode != DSPProcessor::SOUND_3D_OFF);
+    refreshStreamClock();
+    #ifdef CONFIG_ENCODER_ENABLE
+    EncoderController::getInstance().setCurrent3DSound(mode != DSPProcessor::SOUND_3D_OFF);
+    #endif
+    ESP_LOGI(TAG, "3D mode: %u", mode);
+    return true;
+}
+
+#if APP_DSP_GRAPH
+static void logDspGraph(const char* what, const DspGraph& g) {
+    char names[64];
+    size_t n = 0;
+    names[0] = '\0';
+    for (uint8_t i = 0; i < g.count; i++) {
+        n += snprintf(names + n, sizeof(names) - n, "%s%s", i ? " > " : "", DspGraph::nodeName(g.nodes[i]));
+        if (n >= sizeof(names)) break;
+    }
+    ESP_LOGI(TAG, "%s: %s", what, names);
+}
+
+static bool onBleDspGraph(const uint8_t* blob, size_t len) {
+    DspGraph g;
+    if (!DspGraph::parse(blob, len, g) || !g_dsp.setGraph(g)) return false;
+    uint8_t out[DspGraph::BLOB_BYTES];
+    g_settings.saveDspGraph(out, g.serialize(out, sizeof(out)));
+    logDspGraph("DSP stage order", g);
+    return true;
+}
+
+static size_t onBleDspGraphStatus(uint8_t* out, size_t cap) {
+    return g_dsp.getGraph().serialize(out, cap);
+}
+#endif
+
+#if APP_SYNC_ENABLE
+// Multi-room follower: the master sends S16 at its stream rate, stereo or
+// (TWS) this unit's channel only
+static void onSyncFormat(uint32_t rate, uint8_t channels) {
+    ESP_LOGI(TAG, "Following the master's stream: %u Hz, %u ch", (unsigned)rate, (unsigned)channels);
+    g_pipeline.clear();
+    applyStreamFormat({ A2DP_CODEC_ID_SBC, rate, 16, channels });
+    PowerManager::getInstance().set(PowerManager::STREAM, true);
+}
+#endif
+
+#if APP_NET_INGEST
+// WiFi ingest (see net_ingest.h): its own format and fixed jitter target
+// while it plays; the A2DP stream's format back when it ends
+static void onIngestFormat(uint32_t rate, SampleFmt fmt, uint8_t channels) {
+    if (rate == 0) {
+        if (g_ingestOwnsOutput && g_ingestSavedFmt.sampleRate) {
+#if APP_HFP
+            if (g_voiceActive) g_voiceSavedFmt = g_ingestSavedFmt;   // The call puts it back
+            else
+#endif
+            {
+                g_pipeline.clear();
+                applyStreamFormat(g_ingestSavedFmt);
+            }
+        }
+        g_ingestOwnsOutput = false;
+        PowerManager::getInstance().set(PowerManager::STREAM, g_audioStreaming);
+        return;
+    }
+    if (!g_ingestOwnsOutput) {
+        g_ingestSavedFmt = { g_a2dp.get_codec_id(), g_sampleRate, g_bitsPerSample, g_channels };
+    }
+    g_ingestOwnsOutput = true;
+    g_pipeline.clear();
+    g_sampleRate = rate;
+    g_bitsPerSample = fmt == SAMPLE_FMT_S16 ? 16 : 24;
+    g_sampleFmt = fmt;
+    g_channels = channels;
+    g_i2s.reconfigure(i2sRateFor(rate), I2S_LATENCY_STANDARD);
+    g_dsp.setSampleRate(rate);
+    g_pipeline.setStreamFormat(rate, fmt, channels, APP_NET_INGEST_TARGET_MS);
+    updateStreamClock(A2DP_CODEC_ID_SBC, rate);    // PCM, no decoder
+    PowerManager::getInstance().set(PowerManager::STREAM, true);
+}
+#endif
+
+#if APP_PEER_STREAM_CACHE
+// Known peer linking up: set its last format up now, so a matching codec
+// config finds nothing left to do
+static void presetPeerStream() {
+    PeerStreamCache::Format fmt;
+    if (!g_peerStreams.lookup(*g_a2dp.get_current_peer_address(), fmt)) return;
+#if APP_NET_INGEST
+    if (g_ingestOwnsOutput) return;     // Left to the codec config
+#endif
+    ESP_LOGI(TAG, "Known peer: presetting %s %u Hz %u-bit %uch",
+             get_codec_id_name(fmt.codec), (unsigned)fmt.sampleRate,
+             (unsigned)fmt.bitsPerSample, (unsigned)fmt.channels);
+    g_pipeline.clear();
+    applyStreamFormat(fmt);
+    g_streamPresetFmt = fmt;
+    g_streamPreset = true;
+}
+#endif
+
+static void onCodecConfig(uint32_t rate, uint8_t bps, uint8_t channels) {
+    if (rate == 0) rate = 44100;
+    
+    // Get codec type (the library's codec_config.c already logs vendor ID details)
+    esp_a2d_mct_t codecType = g_a2dp.get_audio_type();
+    const char* codecName = getCodecName(codecType);
+    
+    ESP_LOGI(TAG, "========================================");
+    ESP_LOGI(TAG, "CODEC CONFIGURATION RECEIVED");
+    ESP_LOGI(TAG, "========================================");
+    ESP_LOGI(TAG, "  Codec type: %s (0x%02X)", codecName, codecType);
+    ESP_LOGI(TAG, "  Codec: %s", get_codec_id_name(g_a2dp.get_codec_id()));
+    ESP_LOGI(TAG, "  Sample rate: %u Hz", (unsigned)rate);
+    ESP_LOGI(TAG, "  Bits/sample: %u (%s)", (unsigned)bps,
+             sampleFmtName(sampleFmtForCodec(g_a2dp.get_codec_id(), bps)));
+    ESP_LOGI(TAG, "  Channels: %u", (unsigned)channels);
+    
+    // Note: For vendor codecs, check CODEC_CONFIG log above which shows:
+    // - "configure LDAC codec" for LDAC (Vendor ID: 0x012D, Codec ID: 0x00AA)
+    // - "configure aptX codec" for aptX (Vendor ID: 0x004F, Codec ID: 0x0001)
+    // - "configure aptX-HD codec" for aptX-HD (Vendor ID: 0x00D7, Codec ID: 0x0024)
+    
+    ESP_LOGI(TAG, "========================================");
+    
+#if APP_AUDIO_LATENCY_PROBE
+    logLatency();  // Previous stream, while its DMA geometry is still set
+#endif
+
+#if APP_GLITCH_JOURNAL
+    GlitchJournal::getInstance().setCodec((uint8_t)g_a2dp.get_codec_id());
+#endif
+
+    const PeerStreamCache::Format fmt = { g_a2dp.get_codec_id(), rate, bps, channels };
+    const bool preset = g_streamPreset && g_streamPresetFmt == fmt;
+    g_streamPreset = false;
+#if APP_NET_INGEST
+    // Set up for A2DP below; ingest takes the output back with its next
+    // packet unless A2DP starts first
+    const bool ingestPlaying = g_ingestOwnsOutput;
+    g_ingestOwnsOutput = false;
+#endif
+#if APP_HFP
+    if (g_voiceActive) {
+        // The call owns the output; this is what it goes back to
+        g_voiceSavedFmt = fmt;
+        ESP_LOGI(TAG, "In a call - stream format applied when it ends");
+    } else
+#endif
+    if (preset) {
+        // Already set up on link-up; nothing has played into it yet
+        ESP_LOGI(TAG, "Stream format matches the peer's last one - no reconfiguration");
+    } else {
+        // Pause pipeline during codec reconfiguration to prevent race conditions
+#if APP_CODEC_BRIDGE
+        // (what the old codec left queued plays on into the new stream)
+        g_pipeline.bridgeStream();
+#else
+        g_pipeline.clear();
+#endif
+        applyStreamFormat(fmt);
+    }
+#if APP_NET_INGEST
+    if (ingestPlaying) NetIngest::getInstance().reannounce();
+#endif
+#if APP_PEER_STREAM_CACHE
+    if (g_peerStreams.remember(*g_a2dp.get_current_peer_address(), fmt)) {
+        uint8_t blob[PeerStreamCache::BLOB_BYTES];
+        size_t n = g_peerStreams.serialize(blob, sizeof(blob));
+        g_settings.savePeerStreams(blob, n);
+    }
+#endif
+#if APP_AUDIO_PERF_TRACE
+    g_pipeline.perfTrace().reset();  // Histograms describe one codec at a time
+    g_traceRxBase = {};
+#endif
+#if APP_AUDIO_LATENCY_PROBE
+    g_latencyCodec = g_a2dp.get_codec_id();
+    g_pipeline.latency().reset();
+#endif
+    
+#if APP_CODEC_POLICY
+    g_codecPolicy.begin(*g_a2dp.get_current_peer_address(), g_a2dp.get_codec_id(),
+                        g_pipeline.getJitterBuffer().getUnderrunCount());
+#endif
+#if APP_DELAY_REPORT
+    reportDelay(true);  // Kept by the stack for the stream about to open
+#endif
+    
+    // Play the connected sound once the codec has been stable this long;
+    // another config before then restarts the wait
+    g_lastCodecConfigTime = esp_timer_get_time();
+    g_connectedSoundPending = true;
+    esp_timer_stop(g_connectedSoundTimer);
+    esp_timer_start_once(g_connectedSoundTimer, preset ? PEER_FORMAT_STABLE_DELAY_US : CODEC_STABLE_DELAY_US);
+    EventBus::getInstance().publish(BUS_CODEC_CONFIGURED, g_sampleRate);
+    
+    // No settling delay needed: updateClock() restarts the DMA on preloaded silence
+}
+
+// bits/channels are the sink's last configured format, read once per packet
+static void onStreamData(const uint8_t* data, uint32_t len, uint8_t bits, uint8_t channels, uint32_t frames) {
+#if APP_HFP
+    if (g_voiceActive) frames = 0;   // Media the phone still sends during a call
+#endif
+    if (frames == 0) {
+#if APP_AUDIO_DECODE_IN_PLACE
+        g_pipeline.returnPcmBuffer(data);
+#endif
+        return;
+    }
+    g_pipeline.enqueue(data, len, sampleFmtForCodec(g_a2dp.get_codec_id(), bits), channels);
+}
+
+#if APP_HFP
+// -----------------------------------------------------------
+// Hands-free calls (see hfp_link.h): the output switches to the
+// call's rate, mono, with the voice DMA geometry and a jitter
+// target from the round trip budget; back to the media stream's
+// format when the call audio closes. No reboot, no reallocation
+// beyond what a codec change does.
+// -----------------------------------------------------------
+static HfpLink::VoicePath onVoiceStart(uint32_t rate) {
+    const int64_t t0 = esp_timer_get_time();
+    g_voiceSavedFmt = { g_a2dp.get_codec_id(), g_sampleRate, g_bitsPerSample, g_channels };
+    g_voiceActive = true;
+    g_pipeline.clear();
+    g_sampleRate = rate;
+    g_bitsPerSample = 16;
+    g_sampleFmt = SAMPLE_FMT_S16;
+    g_channels = 1;
+    g_i2s.reconfigure(i2sRateFor(rate), I2S_LATENCY_VOICE);
+    g_dsp.setSampleRate(rate);
+    const LatencyEstimate e = estimateLatency();
+    const uint32_t outputUs = e.dmaUs + e.limiterUs;
+    const uint32_t jitterMs = HfpLink::jitterBudgetMs(rate, outputUs);
+    g_pipeline.setStreamFormat(rate, SAMPLE_FMT_S16, 1, jitterMs);
+    updateStreamClock(A2DP_CODEC_ID_SBC, rate);    // CVSD/mSBC
+    PowerManager::getInstance().set(PowerManager::STREAM, true);
+#if APP_NET_INGEST
+    NetIngest::getInstance().setLocalStream(true);
+#endif
+    ESP_LOGI(TAG, "Output switched to the call in %u us", (unsigned)(esp_timer_get_time() - t0));
+    return { jitterMs * 1000 + outputUs, i2sRateFor(rate) == rate };
+}
+
+static void onVoiceStop() {
+    const int64_t t0 = esp_timer_get_time();
+    g_voiceActive = false;
+    g_pipeline.clear();
+    if (g_voiceSavedFmt.sampleRate) applyStreamFormat(g_voiceSavedFmt);
+    PowerManager::getInstance().set(PowerManager::STREAM, g_audioStreaming);
+#if APP_NET_INGEST
+    NetIngest::getInstance().setLocalStream(g_audioStreaming);
+#endif
+    ESP_LOGI(TAG, "Output back to the media stream in %u us", (unsigned)(esp_timer_get_time() - t0));
+}
+
+static void onVoiceDownlink(const int16_t* pcm, uint32_t frames) {
+    g_pipeline.enqueue((const uint8_t*)pcm, frames * sizeof(int16_t), SAMPLE_FMT_S16, 1);
+}
+
+// HFP speaker gain 0-15 onto the AVRCP scale
+static void onVoiceVolume(uint8_t volume) {
+    const uint8_t v = (uint8_t)((volume > 15 ? 15 : volume) * 127 / 15);
+#if APP_DSP_VOLUME
+    g_dsp.setVolume(v);
+#endif
+    EventBus::getInstance().publish(BUS_VOLUME_CHANGED, v);
+    ESP_LOGI(TAG, "Call volume %u/15", (unsigned)volume);
+}
+#endif
+
+#if APP_AUDIO_DECODE_IN_PLACE
+// Bluedroid decodes each batch into ring space the pipeline lends it; the
+// batch comes back through onStreamData() with the same pointer
+extern "C" unsigned char* esp_a2d_sink_pcm_buffer_hook(size_t min_len, size_t* size) {
+    return g_pipeline.lendPcmBuffer(min_len, size);
+}
+
+extern "C" void esp_a2d_sink_pcm_buffer_return_hook(unsigned char* buf) {
+    g_pipeline.returnPcmBuffer(buf);
+}
+#endif
+
+#if APP_AUDIO_PULL_DECODE
+// Pull decoding: packets wait in Bluedroid's queue and audio_tx decodes
+// them when its output needs the next block; each arrival wakes it
+extern "C" void esp_a2d_sink_pull_ready_hook(uint16_t queued) {
+    g_pipeline.onPacketQueued();
+}
+#endif
+
+#if APP_AUDIO_PERF_TRACE
+// -----------------------------------------------------------
+// Perf trace: Bluedroid reports decode cycles per media packet
+// (weak no-op in btc_a2dp_sink.c); BLE 0xF1 reads the summary
+// -----------------------------------------------------------
+extern "C" void esp_a2d_sink_decode_trace_hook(uint32_t cycles) {
+    g_pipeline.perfTrace().span(TRACE_DECODE, cycles);
+}
+
+static PerfTrace::Media traceMedia(const esp_a2d_sink_rx_stats_t& rx) {
+    if (rx.received < g_traceRxBase.received) g_traceRxBase = {};
+    PerfTrace::Media m;
+    m.packets = rx.received - g_traceRxBase.received;
+    m.bytes = rx.bytes - g_traceRxBase.bytes;
+    m.maxLen = rx.max_len;
+    m.mtu = rx.mtu;
+    m.frames = (rx.pcm_bytes - g_traceRxBase.pcm_bytes) / (sampleFmtBytes(g_sampleFmt) * g_channels);
+    return m;
+}
+
+// STATUS_TRACE's payload (also logged); rx: the stack's counters read
+static size_t traceReport(uint8_t* buf, size_t cap, esp_a2d_sink_rx_stats_t& rx) {
+    if (cap < 3) return 0;
+    const uint32_t mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    buf[0] = (uint8_t)mhz;
+    buf[1] = (uint8_t)(mhz >> 8);
+    buf[2] = (uint8_t)g_a2dp.get_codec_id();
+    size_t len = 3 + g_pipeline.perfTrace().serialize(buf + 3, cap - 3);
+    g_pipeline.perfTrace().log(TAG, mhz);
+    if (esp_a2d_sink_get_rx_stats(&rx) == ESP_OK) {
+        const PerfTrace::Media media = traceMedia(rx);
+        len += PerfTrace::serializeMedia(media, buf + len, cap - len);
+        PerfTrace::logMedia(TAG, media);
+    }
+    return len;
+}
+
+static void onBleTrace(bool reset) {
+    uint8_t buf[3 + (TRACE_COUNT + 1) * PerfTrace::ENTRY_BYTES];
+    esp_a2d_sink_rx_stats_t rx;
+    const size_t len = traceReport(buf, sizeof(buf), rx);
+    g_ble.sendTrace(buf, len);
+    if (reset) {
+        g_pipeline.perfTrace().reset();
+        g_traceRxBase = rx;
+    }
+}
+#endif
+
+#if APP_PERF_CONSOLE
+// -----------------------------------------------------------
+// Performance console: "codec info" (the rest it reads itself)
+// -----------------------------------------------------------
+static void onConsoleCodecInfo() {
+    const a2dp_codec_id_t codec = g_a2dp.get_codec_id();
+    printf("codec       %s, %u Hz, %s, %u ch%s\n", get_codec_id_name(codec), (unsigned)g_sampleRate,
+           sampleFmtName(g_sampleFmt), (unsigned)g_channels, g_a2dp.is_connected() ? "" : " (not connected)");
+    printf("jitter      target %u ms\n", (unsigned)jitterTargetForCodec(codec));
+#if APP_AUDIO_PERF_TRACE
+    // Per frame from the two averages: a console trace resets the
+    // histogram but not the media counters
+    TraceHistogram h;
+    g_pipeline.perfTrace().snapshot(TRACE_DECODE, h);
+    esp_a2d_sink_rx_stats_t rx;
+    if (h.count == 0 || esp_a2d_sink_get_rx_stats(&rx) != ESP_OK) {
+        printf("decode      no packets traced\n");
+        return;
+    }
+    const PerfTrace::Media media = traceMedia(rx);
+    const uint32_t mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    printf("decode      packet avg %u p99 %u max %u us, %u cycles/frame\n", (unsigned)(h.avg() / mhz),
+           (unsigned)(h.percentile(99) / mhz), (unsigned)(h.max / mhz),
+           media.frames ? (unsigned)((uint64_t)h.avg() * media.packets / media.frames) : 0u);
+    PerfTrace::logMedia(TAG, media);
+#else
+    printf("decode      cost needs AUDIO_PERF_TRACE\n");
+#endif
+}
+#endif
+
+#if APP_MEM_PRESSURE_LADDER
+// -----------------------------------------------------------
+// Memory pressure ladder: features go one tier at a time before
+// Bluedroid may drop queued packets (weak default always drops)
+// -----------------------------------------------------------
+static bool g_memPressure3D = false;   // 3D sound was on when REDUCE took it
+
+extern "C" bool esp_a2d_sink_memory_pressure_hook(size_t free_internal, bool alloc_failed) {
+    (void)free_internal;
+    return g_memPressure.allowShed(alloc_failed);
+}
+
+static void onMemoryTier(MemoryTier tier, MemoryTier prev) {
+    #ifdef CONFIG_LED_MATRIX_ENABLE
+    LedController::getInstance().setEffectsPaused(tier >= MEM_TIER_LIGHT);
+    #endif
+    // BLE level notifications follow g_memPressure.tier() in beatTask
+    if (tier == MEM_TIER_SHRINK && prev < tier) {
+        g_pipeline.releaseFastRing();
+    } else if (prev == MEM_TIER_SHRINK && tier < prev) {
+        g_pipeline.restoreFastRing();
+    }
+    if (tier == MEM_TIER_REDUCE && prev < tier) {
+        g_memPressure3D = g_dsp.is3DSoundEnabled();
+        g_dsp.set3DSound(false);
+        g_dsp.setAnalysisEnabled(false);
+    } else if (prev == MEM_TIER_REDUCE && tier < prev) {
+        g_dsp.setAnalysisEnabled(true);
+        if (g_memPressure3D) g_dsp.set3DSound(true);
+        refreshStreamClock();
+    }
+}
+
+static void memPressureTask(void* arg) {
+    while (true) {
+        g_memPressure.wait(pdMS_TO_TICKS(APP_MEM_PRESSURE_POLL_MS));
+        g_memPressure.poll();
+    }
+}
+#endif
+
+#if APP_TASK_DIAGNOSTICS
+// -----------------------------------------------------------
+// Task diagnostics: CPU, stack and heap logged every interval;
+// BLE 0xF6 reads the latest report or follows every sample
+// -----------------------------------------------------------
+static size_t onBleTaskReport(uint8_t* out, size_t cap) {
+    return g_taskDiag.report(out, cap);
+}
+
+static void taskDiagTask(void* arg) {
+    while (true) {
+        g_taskDiag.sample(APP_TASK_DIAGNOSTICS_INTERVAL_S);
+        if (g_ble.taskReportFollowed()) g_ble.sendTaskReport();
+        vTaskDelay(pdMS_TO_TICKS(APP_TASK_DIAGNOSTICS_INTERVAL_S * 1000));
+    }
+}
+#endif
+
+#if APP_GLITCH_JOURNAL || APP_EVENT_LOG || APP_PCM_CAPTURE
+// -----------------------------------------------------------
+// Media packets the stack lost (BTU and decoder tasks): into the
+// event log, the glitch journal and the PCM capture markers,
+// never a formatted log line
+// -----------------------------------------------------------
+extern "C" void esp_a2d_sink_media_loss_hook(esp_a2d_sink_media_loss_t reason, uint32_t packets) {
+    const uint32_t queuedMs = g_pipeline.getBufferedMs();
+    logEvent(EV_STACK_LOSS, (uint32_t)reason, packets, queuedMs);
+#if APP_GLITCH_JOURNAL || APP_PCM_CAPTURE
+    static const GlitchType types[] = { GLITCH_DECODE_ERROR, GLITCH_QUEUE_FULL, GLITCH_MEMORY_FLUSH };
+    if ((unsigned)reason >= sizeof(types) / sizeof(types[0])) return;
+#endif
+#if APP_GLITCH_JOURNAL
+    GlitchJournal::getInstance().record(types[reason], queuedMs);
+#endif
+#if APP_PCM_CAPTURE
+    PcmCapture::getInstance().mark(types[reason], queuedMs);
+#endif
+}
+#endif
+
+#if APP_GLITCH_JOURNAL
+// -----------------------------------------------------------
+// Glitch journal: the pipeline records its own glitches, the
+// stack's media losses come in above; BLE 0xF7 dumps it
+// -----------------------------------------------------------
+
+static size_t onBleGlitchRead(uint32_t& seq, uint8_t* out, size_t cap) {
+    return GlitchJournal::getInstance().read(seq, out, cap);
+}
+
+static void onBleGlitchClear() {
+    GlitchJournal::getInstance().clear();
+}
+#endif
+
+#if APP_PCM_CAPTURE
+// -----------------------------------------------------------
+// PCM capture: BLE 0xFA reports it, freezes or re-arms it and
+// reads the frozen image
+// -----------------------------------------------------------
+
+static size_t onBleCaptureStatus(uint8_t* out, size_t cap) {
+    if (cap < 10) return 0;
+    const PcmCapture& c = PcmCapture::getInstance();
+    const uint32_t fields[2] = { c.imageBytes(), c.spanMs() };
+    out[0] = c.state();
+    out[1] = c.reason();
+    for (int i = 0; i < 2; i++) {
+        out[2 + 4 * i] = (uint8_t)fields[i];
+        out[3 + 4 * i] = (uint8_t)(fields[i] >> 8);
+        out[4 + 4 * i] = (uint8_t)(fields[i] >> 16);
+        out[5 + 4 * i] = (uint8_t)(fields[i] >> 24);
+    }
+    return 10;
+}
+
+static void onBleCaptureControl(bool freeze) {
+    if (freeze) {
+        PcmCapture::getInstance().freeze();
+    } else {
+        PcmCapture::getInstance().rearm();
+    }
+}
+
+static size_t onBleCaptureRead(uint32_t offset, uint8_t* out, size_t cap) {
+    return PcmCapture::getInstance().read(offset, out, cap);
+}
+
+#if APP_BLE_BULK_CHANNEL
+// Read op over the bulk channel while it is open: SDUs of
+// [STATUS_CAPTURE, 3, offset u32, image bytes...] as the GATT
+// notifications, as many per request as one write burst takes.
+// GATT task.
+static bool onBleCaptureBulk(uint32_t offset, uint8_t count) {
+    static uint8_t s_sdu[APP_BLE_BULK_MTU];
+    BleBulkChannel& bulk = BleBulkChannel::getInstance();
+    const size_t sdu = bulk.maxSdu();
+    if (sdu <= 6) return false;
+    const size_t part = sdu - 6;
+    const uint8_t window = bulk.window(sdu);
+    if (count == 0 || count > window) count = window;
+    for (uint8_t i = 0; i < count; i++) {
+        const size_t n = onBleCaptureRead(offset, &s_sdu[6], part);
+        s_sdu[0] = BleResp::STATUS_CAPTURE;
+        s_sdu[1] = 3;
+        s_sdu[2] = (uint8_t)offset;
+        s_sdu[3] = (uint8_t)(offset >> 8);
+        s_sdu[4] = (uint8_t)(offset >> 16);
+        s_sdu[5] = (uint8_t)(offset >> 24);
+        // Congested part way: the client asks again from what it got
+        if (!bulk.write(s_sdu, 6 + n)) return i > 0;
+        if (n < part) break;
+        offset += (uint32_t)n;
+    }
+    return true;
+}
+#endif
+#endif
+
+#if APP_CODEC_POLICY || APP_LATENCY_PROFILES
+// -----------------------------------------------------------
+// Codecs offered on AVDTP discover: the latency profile hides
+// its unwanted codecs from everyone, the codec policy those that
+// streamed badly from that peer (weak default offers every endpoint)
+// -----------------------------------------------------------
+extern "C" bool esp_a2d_sink_sep_offer_hook(esp_bd_addr_t peer_bda, const uint8_t* codec_info) {
+    // codec_info: [length, media type, codec type, elements...]
+    esp_a2d_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.audio_cfg.mcc.type = codec_info[2];
+    size_t len = codec_info[0] > 2 ? codec_info[0] - 2 : 0;
+    len = len < sizeof(param.audio_cfg.mcc.cie) ? len : sizeof(param.audio_cfg.mcc.cie);
+    memcpy(&param.audio_cfg.mcc.cie, codec_info + 3, len);
+    const a2dp_codec_id_t codec = get_codec_id(&param);
+#if APP_LATENCY_PROFILES
+    const LatencyProfile& profile = LatencyProfile::get(g_latencyProfile);
+    if (!profile.offers(codec)) {
+        ESP_LOGI(TAG, "%s not offered in the %s profile", get_codec_id_name(codec), profile.name);
+        return false;
+    }
+#endif
+#if APP_CODEC_POLICY
+    return g_codecPolicy.offer(peer_bda, codec);
+#else
+    (void)peer_bda;
+    return true;
+#endif
+}
+#endif
+
+#if APP_CODEC_POLICY
+// -----------------------------------------------------------
+// Codec policy: streams are scored per peer, and codecs that
+// streamed badly are not offered to that peer on AVDTP discover
+// -----------------------------------------------------------
+static void codecPolicyTask(void* arg) {
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        esp_a2d_sink_rx_stats_t rx;
+        if (esp_a2d_sink_get_rx_stats(&rx) == ESP_OK) {
+            const JitterBuffer& jb = g_pipeline.getJitterBuffer();
+#if APP_LINK_MONITOR
+            const bool rfDegraded = g_link.rfDegraded();
+#else
+            const bool rfDegraded = false;
+#endif
+            g_codecPolicy.sample(rx, jb.getUnderrunCount(), jb.getJitterMs(), rfDegraded);
+        }
+        if (g_codecPolicy.takeDirty()) {
+            uint8_t blob[CodecPolicy::BLOB_BYTES];
+            size_t n = g_codecPolicy.serialize(blob, sizeof(blob));
+            g_settings.saveCodecPolicy(blob, n);
+        }
+    }
+}
+#endif
+
+#if APP_LINK_MONITOR
+// -----------------------------------------------------------
+// Link monitor: once a second the last RSSI / link quality
+// readings and the stream's counters tell RF glitches from CPU
+// ones; a poor link deepens the jitter buffer
+// -----------------------------------------------------------
+static void linkMonitorTask(void* arg) {
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        if (!g_a2dp.is_connected()) continue;
+        esp_a2d_sink_rx_stats_t rx;
+        esp_a2d_sink_link_stats_t link;
+        if (esp_a2d_sink_get_rx_stats(&rx) != ESP_OK || esp_a2d_sink_get_link_stats(&link) != ESP_OK) continue;
+        g_link.sample(link, rx, esp_a2d_sink_get_queued(), g_pipeline.getJitterBuffer().getUnderrunCount());
+        g_pipeline.setLinkMarginMs(g_link.jitterMarginMs());
+        esp_a2d_sink_read_link(*g_a2dp.get_current_peer_address());
+    }
+}
+#endif
+
+#if APP_DEADLINE_MONITOR
+// -----------------------------------------------------------
+// Deadline monitor: BLE 0xF8 reads block misses per DSP mode
+// (also logged), optionally clearing them
+// -----------------------------------------------------------
+static size_t onBleDeadline(uint8_t* out, size_t cap, bool reset) {
+    DeadlineMonitor& deadline = g_pipeline.deadline();
+    const size_t len = deadline.report(out, cap);
+    deadline.log(TAG);
+    if (reset) deadline.reset();
+    return len;
+}
+#endif
+
+#if APP_FLEET_REPORT
+// -----------------------------------------------------------
+// Fleet report: the diagnostics the BLE requests read, in one
+// batch handed to recovery for the WiFi upload; BLE 0xFD or the
+// schedule (idle only) starts it, the result is read at boot
+// -----------------------------------------------------------
+static TaskHandle_t g_fleetTaskHandle = nullptr;
+
+static void buildFleetReport(FleetReport& report) {
+    size_t room;
+    uint8_t* p;
+#if APP_AUDIO_PERF_TRACE
+    p = report.item(room);
+    esp_a2d_sink_rx_stats_t rx;
+    report.commit(FleetReport::TAG_TRACE, traceReport(p, room, rx));
+#endif
+#if APP_AUDIO_LATENCY_PROBE
+    p = report.item(room);
+    report.commit(FleetReport::TAG_LATENCY, onBleLatency(p, room));
+#endif
+#if APP_LATENCY_PROFILES
+    p = report.item(room);
+    report.commit(FleetReport::TAG_PROFILE, onBleProfileStatus(p, room));
+#endif
+#if APP_DEADLINE_MONITOR
+    p = report.item(room);
+    report.commit(FleetReport::TAG_DEADLINE, onBleDeadline(p, room, false));
+#endif
+#if APP_TASK_DIAGNOSTICS
+    p = report.item(room);
+    report.commit(FleetReport::TAG_TASKS, onBleTaskReport(p, room));
+#endif
+#if APP_LINK_MONITOR
+    p = report.item(room);
+    if (room >= 10) {
+        const LinkMonitor::Snapshot link = g_link.snapshot();
+        p[0] = (uint8_t)link.rssi;
+        p[1] = link.quality;
+        p[2] = link.rfLevel;
+        p[3] = (uint8_t)link.queued;
+        p[4] = (uint8_t)(link.queued >> 8);
+        p[5] = (uint8_t)link.rfGlitches;
+        p[6] = (uint8_t)(link.rfGlitches >> 8);
+        p[7] = (uint8_t)link.cpuGlitches;
+        p[8] = (uint8_t)(link.cpuGlitches >> 8);
+        p[9] = (uint8_t)link.last;
+        report.commit(FleetReport::TAG_LINK, 10);
+    }
+#endif
+#if APP_GLITCH_JOURNAL
+    // Last: the journal takes what room is left, oldest entries first
+    p = report.item(room);
+    uint32_t seq = 0;
+    report.commit(FleetReport::TAG_GLITCHES, GlitchJournal::getInstance().read(seq, p, room));
+#endif
+    (void)room;
+    (void)p;
+}
+
+// Stage the batch and reboot into recovery; returns only on failure
+static void sendFleetReport() {
+    const esp_partition_t* recovery = esp_partition_find_first(
+        ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_2, "recovery");
+    uint8_t* buf = (uint8_t*)malloc(FleetReport::MAX_BYTES);
+    FleetReport report;
+    if (!recovery || !buf ||
+        !report.begin(buf, FleetReport::MAX_BYTES, APP_FW_VERSION, (uint8_t)esp_reset_reason(),
+                      (uint32_t)(esp_timer_get_time() / 1000000))) {
+        ESP_LOGW(TAG, "Fleet report: %s", recovery ? "no memory" : "no recovery partition");
+        free(buf);
+        return;
+    }
+    buildFleetReport(report);
+    const bool staged = FleetReport::stage(buf, report.size(), APP_FLEET_REPORT_URL,
+                                           esp_ota_get_running_partition()->label);
+    free(buf);
+    if (!staged || esp_ota_set_boot_partition(recovery) != ESP_OK) {
+        ESP_LOGW(TAG, "Fleet report: could not hand it to recovery");
+        return;
+    }
+    ESP_LOGW(TAG, "Fleet report: %u bytes, rebooting to upload", (unsigned)report.size());
+    vTaskDelay(pdMS_TO_TICKS(200));     // BLE ack and log out first
+    esp_restart();
+}
+
+static void onBleFleetReport() {
+    if (g_fleetTaskHandle) xTaskNotifyGive(g_fleetTaskHandle);
+}
+
+// At boot: how the last upload went; a delivered journal starts over
+static void fleetReportResult() {
+    int32_t result;
+    if (!FleetReport::takeResult(result)) return;
+    if (result >= 200 && result < 300) {
+        ESP_LOGI(TAG, "Fleet report delivered (HTTP %d)", (int)result);
+#if APP_GLITCH_JOURNAL
+        GlitchJournal::getInstance().clear();
+#endif
+    } else {
+        ESP_LOGW(TAG, "Fleet report not delivered (%s %d)", result > 0 ? "HTTP" : "result", (int)result);
+    }
+}
+
+// Woken on demand; otherwise checks the schedule once a minute
+static void fleetReportTask(void* arg) {
+    const int64_t dueUs = (int64_t)APP_FLEET_REPORT_INTERVAL_H * 3600 * 1000000;
+    while (true) {
+        const bool asked = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(60 * 1000)) > 0;
+        if (asked || (dueUs > 0 && esp_timer_get_time() >= dueUs && !g_a2dp.is_connected())) {
+            sendFleetReport();
+        }
+    }
+}
+#endif
+
+#ifdef CONFIG_LED_PROFILE
+// -----------------------------------------------------------
+// LED profile: BLE 0xF4 reads per-effect frame cost (also logged),
+// optionally clearing it
+// -----------------------------------------------------------
+static size_t onBleLedProfile(uint8_t* out, size_t cap, bool reset) {
+    return LedController::getInstance().profileReport(out, cap, reset);
+}
+#endif
+
+#if APP_DSP_PEQ
+// -----------------------------------------------------------
+// Parametric EQ: BLE 0x08 sets a band (saved to NVS), 0xF3 reads
+// the bands and the measured load
+// -----------------------------------------------------------
+static bool onBlePeqBand(uint8_t index, const uint8_t* data, size_t len) {
+    PeqBand band;
+    if (!ParametricEq::decodeBand(data, len, band)) return false;
+    if (!g_dsp.peq().setBand(index, band)) return false;
+    uint8_t blob[ParametricEq::BLOB_BYTES];
+    size_t n = g_dsp.peq().serialize(blob, sizeof(blob));
+    g_settings.savePeq(blob, n);
+    return true;
+}
+
+static size_t onBlePeqStatus(uint8_t* out, size_t cap) {
+    constexpr size_t HEAD = 11;
+    if (cap < HEAD + ParametricEq::BLOB_BYTES) return 0;
+    PeqLoad load;
+    g_dsp.peq().load(load);
+    const uint32_t perFrame = load.frames ? load.cycles / load.frames : 0;
+    const uint32_t peak = load.peakPerFrame > 0xFFFF ? 0xFFFF : load.peakPerFrame;
+    const uint32_t budget = ParametricEq::budgetPerFrame();
+    out[0] = (uint8_t)g_dsp.peq().activeBands();
+    for (int i = 0; i < 4; i++) out[1 + i] = (uint8_t)(load.cycles >> (8 * i));
+    out[5] = (uint8_t)perFrame;
+    out[6] = (uint8_t)(perFrame >> 8);
+    out[7] = (uint8_t)peak;
+    out[8] = (uint8_t)(peak >> 8);
+    out[9] = (uint8_t)budget;
+    out[10] = (uint8_t)(budget >> 8);
+    if (peak > budget) {
+        ESP_LOGW(TAG, "Parametric EQ over budget: %u cycles/frame (budget %u)",
+                 (unsigned)peak, (unsigned)budget);
+    }
+    g_dsp.peq().resetLoad();
+    return HEAD + g_dsp.peq().serialize(out + HEAD, cap - HEAD);
+}
+#endif
+
+#if APP_DSP_LIMITER
+// -----------------------------------------------------------
+// Limiter gain reduction: BLE 0xF2 reads it (0.1 dB units)
+// -----------------------------------------------------------
+static uint16_t gainReductionTenthDB(float gain) {
+    if (gain >= 1.0f) return 0;
+    if (gain < 1e-6f) gain = 1e-6f;
+    return (uint16_t)(-200.0f * log10f(gain) + 0.5f);
+}
+
+static void onBleLimiter(bool reset) {
+    LimiterStats st;
+    g_dsp.limiterStats(st);
+    const uint16_t now = gainReductionTenthDB(g_dsp.limiterGain());
+    const uint16_t max = gainReductionTenthDB(st.minGain);
+    const uint16_t active = st.nodes ? (uint16_t)((uint64_t)st.limiting * 1000 / st.nodes) : 0;
+    const uint8_t buf[6] = {
+        (uint8_t)now, (uint8_t)(now >> 8),
+        (uint8_t)max, (uint8_t)(max >> 8),
+        (uint8_t)active, (uint8_t)(active >> 8),
+    };
+    ESP_LOGI(TAG, "Limiter: GR now %.1f dB, max %.1f dB, active %u.%u%%",
+             now * 0.1f, max * 0.1f, (unsigned)(active / 10), (unsigned)(active % 10));
+    g_ble.sendLimiter(buf, sizeof(buf));
+    if (reset) g_dsp.resetLimiterStats();
+}
+#endif
+
+#if APP_SOURCE_TAKEOVER
+// -----------------------------------------------------------
+// Source takeover: Bluedroid carries one A2DP stream, so a
+// bonded phone opening a link while another is connected gets
+// the stream - fade out, drop the current A2DP link, connect
+// to the newcomer over the ACL it already has up
+// -----------------------------------------------------------
+#define TAKEOVER_FADE_US        30000       // One block ramps out, then the link drops
+#define TAKEOVER_TIMEOUT_US     5000000     // Give up if the handoff never finished
+
+static esp_bd_addr_t g_takeoverPeer;
+static volatile bool g_takeoverPending = false;
+static int64_t g_takeoverStartUs = 0;
+static esp_timer_handle_t g_takeoverTimer = nullptr;
+
+static bool isBondedPeer(const esp_bd_addr_t bda) {
+    esp_bd_addr_t list[8];
+    int n = sizeof(list) / sizeof(list[0]);
+    if (esp_bt_gap_get_bond_device_list(&n, list) != ESP_OK) return false;
+    for (int i = 0; i < n; i++) {
+        if (memcmp(list[i], bda, ESP_BD_ADDR_LEN) == 0) return true;
+    }
+    return false;
+}
+
+// BT task: a device completed an ACL link
+static void onAclConnected(esp_bd_addr_t bda) {
+    if (!g_a2dpConnected) return;   // Nothing to hand over; it connects as usual
+    if (memcmp(bda, *g_a2dp.get_current_peer_address(), ESP_BD_ADDR_LEN) == 0) return;
+    if (g_takeoverPending && esp_timer_get_time() - g_takeoverStartUs < TAKEOVER_TIMEOUT_US) return;
+    if (!isBondedPeer(bda)) return;
+    if (g_audioStreaming && !APP_SOURCE_TAKEOVER_WHILE_PLAYING) {
+        ESP_LOGI(TAG, "Takeover: current phone is playing, keeping it");
+        return;
+    }
+    memcpy(g_takeoverPeer, bda, ESP_BD_ADDR_LEN);
+    g_takeoverStartUs = esp_timer_get_time();
+    g_takeoverPending = true;
+    ESP_LOGI(TAG, "Takeover: switching to %02x:%02x:%02x:%02x:%02x:%02x",
+             bda[0], bda[1], bda[2], bda[3], bda[4], bda[5]);
+    g_pipeline.fadeOut();
+    esp_timer_stop(g_takeoverTimer);
+    esp_timer_start_once(g_takeoverTimer, TAKEOVER_FADE_US);
+}
+
+static void onTakeoverFaded(void* arg) {
+    g_a2dp.disconnect();    // DISCONNECTED connects to g_takeoverPeer
+}
+#endif
+
+static void onConnectionState(esp_a2d_connection_state_t state, void* user) {
+    const char* stateStr = "Unknown";
+    switch (state) {
+        case ESP_A2D_CONNECTION_STATE_DISCONNECTED: stateStr = "DISCONNECTED"; break;
+        case ESP_A2D_CONNECTION_STATE_CONNECTING:   stateStr = "CONNECTING"; break;
+        case ESP_A2D_CONNECTION_STATE_CONNECTED:    stateStr = "CONNECTED"; break;
+        case ESP_A2D_CONNECTION_STATE_DISCONNECTING: stateStr = "DISCONNECTING"; break;
+    }
+    
+    ESP_LOGI(TAG, ">>> A2DP Connection: %s", stateStr);
+    
+    // Set connection timestamp early (on CONNECTING) to ensure grace period works
+    // Volume events can arrive before CONNECTED state
+    if (state == ESP_A2D_CONNECTION_STATE_CONNECTING) {
+        g_lastConnectTime = esp_timer_get_time();
+#if APP_PEER_STREAM_CACHE
+        presetPeerStream();
+#endif
+    }
+    
+    if (state == ESP_A2D_CONNECTION_STATE_DISCONNECTED) {
+        // Mark as disconnected
+        g_a2dpConnected = false;
+        EventBus::getInstance().publish(BUS_DISCONNECTED);
+        
+        // Record disconnect time for codec switch detection
+        g_lastDisconnectTime = esp_timer_get_time();
+#if APP_CODEC_POLICY
+        g_codecPolicy.end();
+#endif
+        
+        
+        // Cancel any pending connected sound
+        g_connectedSoundPending = false;
+        esp_timer_stop(g_connectedSoundTimer);
+        
+        // Don't hold settings back while nothing is playing
+        SettingsWriter::getInstance().requestFlush();
+        g_streamPreset = false;
+        PowerManager::getInstance().set(PowerManager::STREAM, false);
+        
+        ESP_LOGW(TAG, "A2DP disconnected - waiting for phone to reconnect with new codec...");
+#if APP_CODEC_BRIDGE
+        // A codec switch by reconnect: the buffered audio bridges the gap
+        g_pipeline.bridgeStream();
+        if (!g_pipeline.bridging()) g_i2s.zeroDMA();
+#else
+        g_pipeline.clear();
+        g_i2s.zeroDMA();  // Clear any stale audio data
+#endif
+
+#if APP_SOURCE_TAKEOVER
+        if (g_takeoverPending) {
+            g_takeoverPending = false;
+            g_a2dp.connect_to(g_takeoverPeer);
+            return;     // Stay as we are: the next link is already on its way
+        }
+#endif
+#if APP_PAGE_SCAN_POLICY
+        PageScanPolicy::getInstance().onDisconnected();
+#endif
+        
+        // Only reset sample rate and discoverability if NOT in pairing mode
+        // (pairing mode handler sets these intentionally and they should persist)
+        if (!g_pairingModeActive) {
+            g_sampleRate = APP_I2S_DEFAULT_SAMPLE_RATE;  // Reset sample rate for sound effects
+            g_i2s.updateClock(i2sRateFor(APP_I2S_DEFAULT_SAMPLE_RATE));
+            g_dsp.setSampleRate(APP_I2S_DEFAULT_SAMPLE_RATE);
+            
+            // The library sets connectable=true on disconnect, but we want to stay non-discoverable
+            // Wait for library to finish, then disable discoverable mode again
+            vTaskDelay(pdMS_TO_TICKS(50));
+            g_a2dp.set_discoverability(ESP_BT_NON_DISCOVERABLE);
+            ESP_LOGI(TAG, "Discoverability disabled - press pairing button for new devices");
+            
             // Stop pairing animation if running (only if not intentionally in pairing mode)
             #ifdef CONFIG_LED_MATRIX_ENABLE
             LedController::getInstance().setPairingMode(false);
@@ -1397,6 +3004,13 @@ static void onConnectionState(esp_a2d_connection_state_t state, void* user) {
         
         // Mark as connected
         g_a2dpConnected = true;
+        EventBus::getInstance().publish(BUS_CONNECTED);
+#if APP_PAGE_SCAN_POLICY
+        PageScanPolicy::getInstance().onConnected();
+#endif
+#if APP_DELAY_REPORT
+        reportDelay(true);  // Stream open now: goes out at once
+#endif
         
         // Record connection time - used to ignore initial volume report from phone
         g_lastConnectTime = esp_timer_get_time();
@@ -1422,8 +3036,8 @@ static void onConnectionState(esp_a2d_connection_state_t state, void* user) {
             g_sound.stop();
         }
         
-        // Connected sound is now played by buttonsTask after codec stabilizes
-        // (see g_connectedSoundPending flag set in onCodecConfig)
+        // Connected sound is played by buttonsTask after codec stabilizes
+        // (see g_connectedSoundTimer started in onCodecConfig)
         
         // Show pairing success animation if we were in pairing mode
         #ifdef CONFIG_LED_MATRIX_ENABLE
@@ -1445,15 +3059,39 @@ static void onAudioState(esp_a2d_audio_state_t state, void* user) {
     }
     
     ESP_LOGI(TAG, ">>> A2DP Audio State: %s", stateStr);
+    g_audioStreaming = state == ESP_A2D_AUDIO_STATE_STARTED;
+#if APP_HFP
+    // Phones suspend A2DP for a call; the call holds the stream clocks
+    PowerManager::getInstance().set(PowerManager::STREAM, g_audioStreaming || g_voiceActive);
+#else
+    PowerManager::getInstance().set(PowerManager::STREAM, g_audioStreaming);
+#endif
+#if APP_DELAY_REPORT
+    if (g_audioStreaming) reportDelay(true);
+#endif
+#if APP_SYNC_ENABLE
+    SyncLink::getInstance().setLocalStream(g_audioStreaming);
+#endif
+#if APP_NET_INGEST
+#if APP_HFP
+    NetIngest::getInstance().setLocalStream(g_audioStreaming || g_voiceActive);
+#else
+    NetIngest::getInstance().setLocalStream(g_audioStreaming);
+#endif
+#endif
+    bleLinkUpdate();
+    EventBus::getInstance().publish(g_audioStreaming ? BUS_STREAM_STARTED : BUS_STREAM_STOPPED);
     
     if (state == ESP_A2D_AUDIO_STATE_STOPPED || state == ESP_A2D_AUDIO_STATE_REMOTE_SUSPEND) {
         smooth30_dB = smooth60_dB = smooth100_dB = -60.0f;
-        g_pipeline.clear();
+        g_pipeline.endStream();
     }
 }
 
 // -----------------------------------------------------------
-// Audio TX task - highest priority for smooth playback
+// Audio TX task - highest priority for smooth playback, alone on
+// APP_AUDIO_TX_CORE; the decoder feeds it through the PCM ring from
+// APP_DECODE_CORE, or with APP_AUDIO_PULL_DECODE runs in it
 // -----------------------------------------------------------
 static void audioTxTask(void* arg) {
     while (true) {
@@ -1462,61 +3100,116 @@ static void audioTxTask(void* arg) {
 }
 
 // -----------------------------------------------------------
-// Button handling task
+// Button handling task - sleeps until a button edge, its debounce
+// timer or the connected sound timer wakes it
 // -----------------------------------------------------------
+static constexpr uint32_t BUTTON_DEBOUNCE_MS = 25;
+static constexpr int MAX_BUTTON_PINS = 3;
+
+struct ButtonPin {
+    gpio_num_t gpio;
+    esp_timer_handle_t debounce;    // Restarted by each edge
+};
+static ButtonPin g_buttonPins[MAX_BUTTON_PINS];
+static int g_numButtonPins = 0;
+
+static void IRAM_ATTR onButtonEdge(void* arg) {
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(g_buttonsTaskHandle, BTN_EVT_EDGE << (uint32_t)(uintptr_t)arg, eSetBits, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+static void onButtonSettled(void* arg) {
+    xTaskNotify(g_buttonsTaskHandle, BTN_EVT_SETTLED << (uint32_t)(uintptr_t)arg, eSetBits);
+}
+
+static void onConnectedSoundDue(void* arg) {
+    if (g_buttonsTaskHandle) xTaskNotify(g_buttonsTaskHandle, BTN_EVT_CONNECTED_SOUND, eSetBits);
+}
+
+// Index of gpio in g_buttonPins, arming its edge interrupt and debounce
+// timer the first time (buttons may share a pin)
+static int addButtonPin(gpio_num_t gpio) {
+    for (int i = 0; i < g_numButtonPins; i++) {
+        if (g_buttonPins[i].gpio == gpio) return i;
+    }
+    const int i = g_numButtonPins++;
+    g_buttonPins[i].gpio = gpio;
+
+    gpio_config_t btn = {};
+    btn.intr_type = GPIO_INTR_ANYEDGE;
+    btn.mode = GPIO_MODE_INPUT;
+    btn.pin_bit_mask = (1ULL << gpio);
+    btn.pull_up_en = GPIO_PULLUP_ENABLE;
+    gpio_config(&btn);
+
+    esp_timer_create_args_t args = {};
+    args.callback = onButtonSettled;
+    args.arg = (void*)(uintptr_t)i;
+    args.name = "btn_debounce";
+    esp_timer_create(&args, &g_buttonPins[i].debounce);
+    gpio_isr_handler_add(gpio, onButtonEdge, (void*)(uintptr_t)i);
+    return i;
+}
+
+static void playConnectedSound() {
+    if (!g_connectedSoundPending) return;  // Disconnected meanwhile
+    g_connectedSoundPending = false;
+
+    // Check if this is a codec switch (rapid reconnect) - don't play sound
+    int64_t timeSinceDisconnect = g_lastCodecConfigTime - g_lastDisconnectTime;
+    bool isCodecSwitch = (g_lastDisconnectTime > 0) && (timeSinceDisconnect < CODEC_SWITCH_TIMEOUT_US);
+
+    if (isCodecSwitch) {
+        ESP_LOGI(TAG, "Codec switch detected - skipping connected sound");
+    } else {
+        ESP_LOGI(TAG, "Codec stable for %lld ms - playing connected sound at %u Hz",
+                 (esp_timer_get_time() - g_lastCodecConfigTime) / 1000, (unsigned)g_i2s.getSampleRate());
+        // Use EXCLUSIVE mode - takes over I2S, no mixing
+        g_sound.play(SOUND_CONNECTED, g_i2s.getSampleRate(), SOUND_MODE_EXCLUSIVE);
+    }
+}
+
 static void buttonsTask(void* arg) {
-    bool lastBtn1 = true, btn1Pressed = false;
-    uint32_t debounce1 = 0, pressStart1 = 0;
-    bool lastBtn2 = true, btn2State = true;
-    uint32_t debounce2 = 0;
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {  // INVALID_STATE: already installed
+        ESP_LOGE(TAG, "GPIO ISR service failed: %s", esp_err_to_name(err));
+    }
+    const int pin1 = addButtonPin((gpio_num_t)APP_BUTTON1_GPIO);
+    const int pin2 = addButtonPin((gpio_num_t)APP_BUTTON2_GPIO);
+    bool btn1Pressed = false;
+    uint32_t pressStart1 = 0;
+    bool btn2State = true;
     
     // LED effect button (can be separate or shared with button 2)
     #ifdef CONFIG_LED_MATRIX_ENABLE
-    bool lastBtnLed = true, btnLedState = true;
-    uint32_t debounceLed = 0;
     #ifdef CONFIG_LED_EFFECT_BUTTON_GPIO
-        const gpio_num_t ledBtnGpio = (gpio_num_t)CONFIG_LED_EFFECT_BUTTON_GPIO;
-        // Only init if different from existing buttons
-        if (ledBtnGpio != APP_BUTTON1_GPIO && ledBtnGpio != APP_BUTTON2_GPIO) {
-            gpio_config_t ledBtn = {};
-            ledBtn.intr_type = GPIO_INTR_DISABLE;
-            ledBtn.mode = GPIO_MODE_INPUT;
-            ledBtn.pin_bit_mask = (1ULL << ledBtnGpio);
-            ledBtn.pull_up_en = GPIO_PULLUP_ENABLE;
-            gpio_config(&ledBtn);
-        }
+        const int pinLed = addButtonPin((gpio_num_t)CONFIG_LED_EFFECT_BUTTON_GPIO);
     #else
-        const gpio_num_t ledBtnGpio = (gpio_num_t)19;  // Default
+        const int pinLed = addButtonPin((gpio_num_t)19);  // Default
     #endif
+    bool btnLedState = true;
     #endif
 
     while (true) {
+        uint32_t events = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
         uint32_t now = (uint32_t)(esp_timer_get_time() / 1000);
         
-        // Check if connected sound is pending and codec has stabilized
-        if (g_connectedSoundPending) {
-            int64_t timeSinceCodecConfig = esp_timer_get_time() - g_lastCodecConfigTime;
-            if (timeSinceCodecConfig >= CODEC_STABLE_DELAY_US) {
-                g_connectedSoundPending = false;
-                
-                // Check if this is a codec switch (rapid reconnect) - don't play sound
-                int64_t timeSinceDisconnect = g_lastCodecConfigTime - g_lastDisconnectTime;
-                bool isCodecSwitch = (g_lastDisconnectTime > 0) && (timeSinceDisconnect < CODEC_SWITCH_TIMEOUT_US);
-                
-                if (isCodecSwitch) {
-                    ESP_LOGI(TAG, "Codec switch detected - skipping connected sound");
-                } else {
-                    ESP_LOGI(TAG, "Codec stable for %lld ms - playing connected sound at %u Hz",
-                             timeSinceCodecConfig / 1000, (unsigned)g_i2s.getSampleRate());
-                    // Use EXCLUSIVE mode - takes over I2S, no mixing
-                    g_sound.play(SOUND_CONNECTED, g_i2s.getSampleRate(), SOUND_MODE_EXCLUSIVE);
-                }
+        // Level is read once a pin has been quiet for BUTTON_DEBOUNCE_MS
+        for (int i = 0; i < g_numButtonPins; i++) {
+            if (events & (BTN_EVT_EDGE << i)) {
+                esp_timer_stop(g_buttonPins[i].debounce);
+                esp_timer_start_once(g_buttonPins[i].debounce, BUTTON_DEBOUNCE_MS * 1000);
             }
         }
         
-        bool r1 = gpio_get_level((gpio_num_t)APP_BUTTON1_GPIO);
-        if (r1 != lastBtn1) debounce1 = now;
-        if ((now - debounce1) > 25) {
+        if (events & BTN_EVT_CONNECTED_SOUND) {
+            playConnectedSound();
+        }
+        
+        if (events & (BTN_EVT_SETTLED << pin1)) {
+            bool r1 = gpio_get_level((gpio_num_t)APP_BUTTON1_GPIO);
             if (!btn1Pressed && r1 == 0) {
                 btn1Pressed = true;
                 pressStart1 = now;
@@ -1533,129 +3226,415 @@ static void buttonsTask(void* arg) {
                 g_ble.updateControl(getControlByte());
             }
         }
-        lastBtn1 = r1;
 
-        bool r2 = gpio_get_level((gpio_num_t)APP_BUTTON2_GPIO);
-        if (r2 != lastBtn2) debounce2 = now;
-        if ((now - debounce2) > 25 && r2 != btn2State) {
-            btn2State = r2;
-            if (r2 == 1) {
-                g_dsp.setBypass(!g_dsp.isBypassEnabled());
-                g_settings.saveControl(g_dsp.isBassBoostEnabled(),
-                                       g_dsp.isChannelFlipEnabled(),
-                                       g_dsp.isBypassEnabled());
-                g_ble.updateControl(getControlByte());
+        if (events & (BTN_EVT_SETTLED << pin2)) {
+            bool r2 = gpio_get_level((gpio_num_t)APP_BUTTON2_GPIO);
+            if (r2 != btn2State) {
+                btn2State = r2;
+                if (r2 == 1) {
+                    g_dsp.setBypass(!g_dsp.isBypassEnabled());
+                    g_settings.saveControl(g_dsp.isBassBoostEnabled(),
+                                           g_dsp.isChannelFlipEnabled(),
+                                           g_dsp.isBypassEnabled());
+                    g_ble.updateControl(getControlByte());
+                }
             }
         }
-        lastBtn2 = r2;
 
         // LED effect cycle button
         #ifdef CONFIG_LED_MATRIX_ENABLE
-        bool rLed = gpio_get_level(ledBtnGpio);
-        if (rLed != lastBtnLed) debounceLed = now;
-        if ((now - debounceLed) > 25 && rLed != btnLedState) {
-            btnLedState = rLed;
-            if (rLed == 1) {  // Button released
-                LedController::getInstance().nextEffect();
-                uint8_t newEffect = LedController::getInstance().getCurrentEffectId();
-                g_settings.saveLedEffect(newEffect);
-                g_ble.updateLedEffect(newEffect);
-                ESP_LOGI(TAG, "LED effect: %s", LedController::getInstance().getCurrentEffectName());
+        if (events & (BTN_EVT_SETTLED << pinLed)) {
+            bool rLed = gpio_get_level(g_buttonPins[pinLed].gpio);
+            if (rLed != btnLedState) {
+                btnLedState = rLed;
+                if (rLed == 1) {  // Button released
+                    LedController::getInstance().nextEffect();
+                    uint8_t newEffect = LedController::getInstance().getCurrentEffectId();
+                    g_settings.saveLedEffect(newEffect);
+                    g_ble.updateLedEffect(newEffect);
+                    ESP_LOGI(TAG, "LED effect: %s", LedController::getInstance().getCurrentEffectName());
+                }
             }
         }
-        lastBtnLed = rLed;
         #endif
+    }
+}
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+// -----------------------------------------------------------
+// Audio analysis task: drains the DSP analysis ring, runs the
+// Goertzel bank, peak meter and beat detector off audio_tx
+// -----------------------------------------------------------
+static void analysisTask(void* arg) {
+    while (true) {
+        if (g_dsp.analyzer().run((uint32_t)(esp_timer_get_time() / 1000)) && g_beatTaskHandle) {
+            xTaskNotifyGive(g_beatTaskHandle);
+        }
+        vTaskDelay(pdMS_TO_TICKS(AudioAnalyzer::PERIOD_MS));
     }
 }
 
+// METER telemetry frame from the analysis snapshot and pipeline stats
+static void sendTelemetry(const AnalysisResult& analysis, const uint8_t levels[3]) {
+    TelemetryInput t;
+    memcpy(t.levels, levels, 3);
+#if APP_DSP_SPECTRUM
+    t.numBands = SpectrumAnalyzer::BANDS;
+    for (int i = 0; i < SpectrumAnalyzer::BANDS; i++) t.bands[i] = analysis.spectrum[i];
+#endif
+#if APP_DSP_LIMITER
+    t.grTenthDb = gainReductionTenthDB(g_dsp.limiterGain());
+#endif
+    t.queuePct = g_pipeline.getQueueFillPercent();
+    t.bufferedMs = (uint16_t)g_pipeline.getBufferedMs();
+    t.codec = (uint8_t)g_a2dp.get_codec_id();
+    t.drops = (uint16_t)g_pipeline.getDropCount();
+    t.shortWrites = (uint16_t)g_pipeline.getShortWriteCount();
+#if APP_LINK_MONITOR
+    const LinkMonitor::Snapshot link = g_link.snapshot();
+    t.rssi = link.rssi;
+    t.linkQuality = link.quality;
+    t.rfLevel = link.rfLevel;
+    t.queuedPackets = (uint8_t)(link.queued < 255 ? link.queued : 255);
+    t.rfGlitches = link.rfGlitches;
+    t.cpuGlitches = link.cpuGlitches;
+    t.glitchCause = link.last;
+#endif
+    g_ble.updateTelemetry(t);
+}
+
 // -----------------------------------------------------------
-// Beat detection + levels task
+// Beat flash + levels task (reads the analysis snapshot). Woken per
+// analysis result; with no audio only while the beat LED is lit (GPIO
+// flash, not the LEDC fade), a beat is still due or the BLE levels
+// are still falling back to the floor. The analysis runs ahead of the output, so each beat waits
+// for the time it is heard.
 // -----------------------------------------------------------
 static void beatTask(void* arg) {
     uint32_t lastLevelMs = 0;
-    uint32_t lastBeatMs = 0;
+    uint32_t lastTelemetryMs = 0;
+    uint32_t lastBeatCount = 0;
+#if !APP_BEAT_LED_FADE
     bool flashActive = false;
     uint32_t flashOffMs = 0;
-    float bassSmooth = 0, bassAvg = 0;
+#endif
+    AnalysisResult analysis;
+    // Beats seen but not heard yet (a few output delays at 200 BPM)
+    constexpr uint32_t DUE_SLOTS = 8;
+    uint32_t dueUs[DUE_SLOTS];
+    uint32_t dueHead = 0, dueTail = 0;
+    // OTA turns the beat LED and level updates off as it starts
+    EventBus::Mailbox* events = EventBus::getInstance().subscribe(BUS_MASK(BUS_OTA_BEGIN) | BUS_MASK(BUS_OTA_END));
+    bool ota = false;
+
+    while (true) {
+        for (BusMsg msg; events && events->take(msg);) ota = msg.type == BUS_OTA_BEGIN;
+        g_dsp.analyzer().read(analysis);
+        if (analysis.beatCount != lastBeatCount) {
+            if (dueTail - dueHead == DUE_SLOTS) dueHead++;
+            dueUs[dueTail++ % DUE_SLOTS] = analysis.beatUs;
+        }
+        lastBeatCount = analysis.beatCount;
+        const uint32_t nowUs = (uint32_t)esp_timer_get_time();
+        uint32_t now = nowUs / 1000;
+        bool newBeat = false;
+        while (dueHead != dueTail && (int32_t)(nowUs - dueUs[dueHead % DUE_SLOTS]) >= 0) {
+            dueHead++;
+            newBeat = true;
+        }
+
+        if (!ota) {
+            if (newBeat) {
+#if APP_BEAT_LED_FADE
+                g_beatLed.flash(APP_BEAT_FLASH_DURATION_MS);
+#else
+                gpio_set_level((gpio_num_t)APP_BEAT_LED_GPIO, 1);
+                flashActive = true;
+                flashOffMs = now + APP_BEAT_FLASH_DURATION_MS;
+#endif
+                EventBus::getInstance().publish(BUS_BEAT, nowUs);
+            }
+
+#if !APP_BEAT_LED_FADE
+            if (flashActive && now >= flashOffMs) {
+                gpio_set_level((gpio_num_t)APP_BEAT_LED_GPIO, 0);
+                flashActive = false;
+            }
+#endif
+
+            // Update BLE levels every 50ms
+            if ((now - lastLevelMs) >= APP_LEVELS_UPDATE_MS) {
+                lastLevelMs = now;
+                
+                bool audioStopped = (now - g_pipeline.getLastProcessMs()) > 100;
+                if (audioStopped) {
+                    smooth30_dB = smooth30_dB * 0.85f + (-60.0f) * 0.15f;
+                    smooth60_dB = smooth60_dB * 0.85f + (-60.0f) * 0.15f;
+                    smooth100_dB = smooth100_dB * 0.85f + (-60.0f) * 0.15f;
+                } else {
+                    // Use fast peak meter for responsive level display
+                    // Less smoothing = more reactive to beats
+                    smooth30_dB += 0.6f * (analysis.peakDB[0] - smooth30_dB);
+                    smooth60_dB += 0.6f * (analysis.peakDB[1] - smooth60_dB);
+                    smooth100_dB += 0.6f * (analysis.peakDB[2] - smooth100_dB);
+                }
+
+                // Convert dB to display position (0-100)
+                // Range: -60dB to 0dB maps to 0-100 (phone max is 120)
+                auto dbToPos = [](float dB) -> int {
+                    // Clamp to range
+                    if (dB < -60.0f) dB = -60.0f;
+                    if (dB > 0.0f) dB = 0.0f;
+                    // Map -60..0 to 0..100
+                    int v = (int)roundf((dB + 60.0f) * (100.0f / 60.0f));
+                    return (v < 0) ? 0 : ((v > 100) ? 100 : v);
+                };
+
+                if (g_ble.isConnected() && !g_pauseBleNotifications &&
+                    g_memPressure.tier() < MEM_TIER_LIGHT) {
+                    const uint8_t levels[3] = {
+                        (uint8_t)dbToPos(smooth30_dB), (uint8_t)dbToPos(smooth60_dB), (uint8_t)dbToPos(smooth100_dB),
+                    };
+                    if (!g_ble.telemetryContents()) {
+                        g_ble.updateLevels(levels[0], levels[1], levels[2]);
+                    } else if ((now - lastTelemetryMs) >= g_ble.telemetryPeriodMs(g_audioStreaming)) {
+                        lastTelemetryMs = now;
+                        sendTelemetry(analysis, levels);
+                    }
+                }
+            }
+        }
+#if !APP_BEAT_LED_FADE
+        else {
+            gpio_set_level((gpio_num_t)APP_BEAT_LED_GPIO, 0);
+            flashActive = false;
+        }
+#endif
+
+        // Idle wakeups: turning the flash off, a beat falling due, and
+        // level updates while they decay or telemetry is on
+        TickType_t wait = portMAX_DELAY;
+#if !APP_BEAT_LED_FADE
+        if (flashActive) {
+            wait = pdMS_TO_TICKS((int32_t)(flashOffMs - now) > 0 ? flashOffMs - now : 0) + 1;
+        }
+#endif
+        if (dueHead != dueTail) {
+            const int32_t dueMs = (int32_t)(dueUs[dueHead % DUE_SLOTS] - nowUs) / 1000;
+            const TickType_t dueWait = pdMS_TO_TICKS(dueMs > 0 ? dueMs : 0) + 1;
+            if (dueWait < wait) wait = dueWait;
+        }
+        const bool decaying = smooth30_dB > -59.0f || smooth60_dB > -59.0f || smooth100_dB > -59.0f;
+        const bool telemetry = g_ble.isConnected() && g_ble.telemetryContents();
+        if ((decaying || telemetry) && wait > pdMS_TO_TICKS(APP_LEVELS_UPDATE_MS)) {
+            wait = pdMS_TO_TICKS(APP_LEVELS_UPDATE_MS);
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+#if APP_AUDIO_LOAD_REPORT
+// -----------------------------------------------------------
+// CPU load report: pipeline stages plus, with run-time stats,
+// the decoder/audio tasks and both idle tasks
+// -----------------------------------------------------------
+static void loadReportTask(void* arg) {
+    static const char* const kTasks[] = { "A2DP_DECODER", "BtAppT", "audio_tx", "IDLE0", "IDLE1" };
+    TaskLoadSampler tasks(kTasks, sizeof(kTasks) / sizeof(kTasks[0]));
+    const uint32_t windowUs = APP_AUDIO_LOAD_REPORT_INTERVAL_S * 1000000u;
+    float pct[TaskLoadSampler::MAX_TASKS];
+    uint32_t lastShort = g_pipeline.getShortWriteCount();
+    AudioPipeline::FrameCounts last = g_pipeline.getFrameCounts();
+
+    tasks.sample(pct);  // prime
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(APP_AUDIO_LOAD_REPORT_INTERVAL_S * 1000));
+
+        char line[160];
+        int n = 0;
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            uint32_t busyUs, peakUs;
+            g_pipeline.takeStageLoad((PipelineStage)s, busyUs, peakUs);
+            n += snprintf(line + n, sizeof(line) - n, "%s %.1f%% (peak %u us) ",
+                          AudioPipeline::stageName((PipelineStage)s),
+                          busyUs * 100.0f / windowUs, (unsigned)peakUs);
+            if (n >= (int)sizeof(line)) break;
+        }
+        uint32_t shortWrites = g_pipeline.getShortWriteCount();
+        ESP_LOGI(TAG, "Load: %s| short writes +%u", line, (unsigned)(shortWrites - lastShort));
+        lastShort = shortWrites;
+        const AudioPipeline::FrameCounts frames = g_pipeline.getFrameCounts();
+        ESP_LOGI(TAG, "Frames: in +%u, out +%u, dropped +%u", (unsigned)(frames.in - last.in),
+                 (unsigned)(frames.out - last.out), (unsigned)(frames.dropped - last.dropped));
+        last = frames;
+
+        if (tasks.sample(pct)) {
+            n = 0;
+            for (int i = 0; i < tasks.count() && n < (int)sizeof(line); i++) {
+                if (pct[i] < 0.0f) continue;
+                n += snprintf(line + n, sizeof(line) - n, "%s %.1f%% ", tasks.name(i), pct[i]);
+            }
+            ESP_LOGI(TAG, "Tasks: %s", line);
+        }
+    }
+}
+#endif
+
+// -----------------------------------------------------------
+#if APP_OTA_DEFERRED_VALIDATION
+// OtaValidator health check (esp_timer task): audio output and Bluetooth
+// came up and are still up, and a running stream is still being played.
+// An idle unit passes; nothing is asked of the user.
+static OtaValidator::Health otaHealth() {
+    static uint32_t lastWrites = 0;
+    if (!g_boot.succeeded(BootGraph::bit(BOOT_AUDIO_OUT) | BootGraph::bit(BOOT_BT))) {
+        return OtaValidator::HEALTH_BAD;
+    }
+    if (esp_bluedroid_get_status() != ESP_BLUEDROID_STATUS_ENABLED) return OtaValidator::HEALTH_BAD;
+    const uint32_t writes = g_pipeline.getWriteCount();
+    const bool stalled = g_audioStreaming && writes == lastWrites;
+    lastWrites = writes;
+    return stalled ? OtaValidator::HEALTH_BAD : OtaValidator::HEALTH_OK;
+}
+#endif
+
+// Boot stages (see BootGraph): flash storage, audio output and the
+// LED driver come up on their own tasks while app_main brings
+// Bluetooth up
+// -----------------------------------------------------------
+// SPIFFS, the sound player's file scan and the saved room correction IR
+static bool bootStorage() {
+    esp_vfs_spiffs_conf_t spiffsConf = {
+        .base_path = "/spiffs",
+        .partition_label = "spiffs",  // Must match partition table name
+        .max_files = 5,
+        .format_if_mount_failed = true
+    };
+    esp_err_t ret = esp_vfs_spiffs_register(&spiffsConf);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "SPIFFS mounted");
+        size_t total = 0, used = 0;
+        esp_spiffs_info("spiffs", &total, &used);
+        ESP_LOGI(TAG, "SPIFFS: %u KB total, %u KB used", (unsigned)(total / 1024), (unsigned)(used / 1024));
+    } else {
+        ESP_LOGW(TAG, "SPIFFS mount failed: %s", esp_err_to_name(ret));
+    }
+
+    // Initialize sound player (sets muted state and scans SPIFFS for existing sounds)
+    bool soundMuted = g_settings.loadSoundMuted();
+    g_sound.init(i2sRateFor(APP_I2S_DEFAULT_SAMPLE_RATE));
+    g_sound.setMuted(soundMuted);
+    ESP_LOGI(TAG, "Sound player initialized: muted=%d, status=0x%02X", soundMuted, g_sound.getStatus());
+
+#if APP_SOUND_ASSETS
+    // Sounds left on SPIFFS by older firmware move to the asset partition;
+    // a low-priority job, so boot and the first connection are not held up
+    if (g_sound.hasAssetStore()) {
+        g_work.run([](void*) {
+            const int moved = g_sound.migrateToAssets(30);
+            if (moved > 0) ESP_LOGI(TAG, "Moved %d sound(s) from SPIFFS to the asset partition", moved);
+        }, nullptr, "snd_mig", 3072, 1, 1);
+    }
+#endif
+
+#if APP_DSP_FIR
+    // Room correction IR saved by a previous upload
+    if (FILE* f = fopen(FIR_IR_PATH, "rb")) {
+        uint8_t* blob = (uint8_t*)heap_caps_malloc(FirConvolver::MAX_BLOB_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!blob) blob = (uint8_t*)heap_caps_malloc(FirConvolver::MAX_BLOB_BYTES, MALLOC_CAP_8BIT);
+        if (blob) {
+            size_t len = fread(blob, 1, FirConvolver::MAX_BLOB_BYTES, f);
+            g_dsp.fir().loadIr(blob, len);
+            heap_caps_free(blob);
+        }
+        fclose(f);
+    }
+#endif
+
+#ifdef CONFIG_LED_ANIMATION
+    // Custom LED effect from a previous upload; the controller keeps its
+    // own copy, so this may run before the LED stage is up
+    if (FILE* f = fopen(LED_ANIM_PATH, "rb")) {
+        uint8_t* blob = (uint8_t*)heap_caps_malloc(LedAnimation::MAX_BLOB_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!blob) blob = (uint8_t*)heap_caps_malloc(LedAnimation::MAX_BLOB_BYTES, MALLOC_CAP_8BIT);
+        if (blob) {
+            size_t len = fread(blob, 1, LedAnimation::MAX_BLOB_BYTES, f);
+            LedController::getInstance().loadAnimation(blob, len);
+            heap_caps_free(blob);
+        }
+        fclose(f);
+    }
+#endif
+    return true;  // Sounds, the IR and the animation are optional
+}
 
-    while (true) {
-        uint32_t now = (uint32_t)(esp_timer_get_time() / 1000);
+// I2S, audio pipeline and overlay mixer; A2DP must not start before these
+static bool bootAudioOut() {
+    if (g_i2s.init(i2sRateFor(APP_I2S_DEFAULT_SAMPLE_RATE)) != ESP_OK) {
+        ESP_LOGE(TAG, "I2S init failed");
+        return false;
+    }
 
-        if (!g_otaActive) {
-            float bass = g_dsp.getGoertzel60Lin() + g_dsp.getGoertzel100Lin();
+    // Set up I2S sample rate change callback to notify SoundPlayer
+    g_i2s.setSampleRateCallback([](uint32_t newRate) {
+        g_sound.setTargetSampleRate(newRate);
+    });
 
-            if (bass >= APP_BASS_MIN_LEVEL) {
-                bassSmooth += APP_BASS_SMOOTH_ALPHA * (bass - bassSmooth);
-                bassAvg += APP_BASS_AVG_ALPHA * (bassSmooth - bassAvg);
-                
-                float ratio = (bassAvg > 1e-6f) ? (bassSmooth / (bassAvg + 1e-6f)) : 0;
-                if (ratio > APP_BASS_RATIO_THRESH && (now - lastBeatMs) > APP_BEAT_MIN_INTERVAL_MS) {
-                    gpio_set_level((gpio_num_t)APP_BEAT_LED_GPIO, 1);
-                    flashActive = true;
-                    flashOffMs = now + APP_BEAT_FLASH_DURATION_MS;
-                    lastBeatMs = now;
-                    
-                    // Signal beat to LED matrix
-                    #ifdef CONFIG_LED_MATRIX_ENABLE
-                    setLedBeat(true);
-                    #endif
-                }
-            } else {
-                bassSmooth *= 0.9f;
-                bassAvg *= 0.999f;
-            }
+#if APP_DEADLINE_SHED_DECODER
+    // Past the DSP stages, deadline misses step the A2DP decoder down
+    g_pipeline.deadline().setDecodeLevelCallback([](uint8_t level) {
+        esp_a2d_sink_set_decode_level(level);
+    });
+#endif
+#if APP_STREAM_CLOCK && APP_DEADLINE_MONITOR
+    // Before any of that, they raise the streaming clock; the budget follows it
+    g_pipeline.deadline().setClockBoostCallback([]() {
+        return PowerManager::getInstance().boostStreamClock();
+    });
+    PowerManager::getInstance().setClockCallback([](uint32_t mhz) {
+        g_pipeline.deadline().setCpuMhz(mhz);
+    });
+#endif
 
-            if (flashActive && now >= flashOffMs) {
-                gpio_set_level((gpio_num_t)APP_BEAT_LED_GPIO, 0);
-                flashActive = false;
-                
-                // Clear beat signal
-                #ifdef CONFIG_LED_MATRIX_ENABLE
-                setLedBeat(false);
-                #endif
-            }
+    // Initialize audio pipeline
+    if (!g_pipeline.init()) {
+        ESP_LOGE(TAG, "Audio pipeline init failed");
+        return false;
+    }
+#if APP_PCM_CAPTURE
+    PcmCapture::getInstance().begin();      // PSRAM the ring left
+#endif
 
-            // Update BLE levels every 50ms
-            if ((now - lastLevelMs) >= APP_LEVELS_UPDATE_MS) {
-                lastLevelMs = now;
-                
-                bool audioStopped = (now - g_pipeline.getLastProcessMs()) > 100;
-                if (audioStopped) {
-                    smooth30_dB = smooth30_dB * 0.85f + (-60.0f) * 0.15f;
-                    smooth60_dB = smooth60_dB * 0.85f + (-60.0f) * 0.15f;
-                    smooth100_dB = smooth100_dB * 0.85f + (-60.0f) * 0.15f;
-                } else {
-                    // Use fast peak meter for responsive level display
-                    // Less smoothing = more reactive to beats
-                    smooth30_dB += 0.6f * (g_dsp.getPeakDB(0) - smooth30_dB);
-                    smooth60_dB += 0.6f * (g_dsp.getPeakDB(1) - smooth60_dB);
-                    smooth100_dB += 0.6f * (g_dsp.getPeakDB(2) - smooth100_dB);
-                }
+    // Initialize overlay mixer for sound effects during playback
+    if (!g_overlayMixer.init()) {
+        ESP_LOGE(TAG, "Overlay mixer init failed");
+        return false;
+    }
+    g_pipeline.setOverlayMixer(&g_overlayMixer);
 
-                // Convert dB to display position (0-100)
-                // Range: -60dB to 0dB maps to 0-100 (phone max is 120)
-                auto dbToPos = [](float dB) -> int {
-                    // Clamp to range
-                    if (dB < -60.0f) dB = -60.0f;
-                    if (dB > 0.0f) dB = 0.0f;
-                    // Map -60..0 to 0..100
-                    int v = (int)roundf((dB + 60.0f) * (100.0f / 60.0f));
-                    return (v < 0) ? 0 : ((v > 100) ? 100 : v);
-                };
+#if APP_AUX_OUTPUT
+    // Aux slot roles: the last BLE layout, else the Kconfig one
+    uint8_t layout[2] = {APP_AUX_SLOT_LEFT, APP_AUX_SLOT_RIGHT};
+    if (!g_settings.loadOutputLayout(layout) || !g_pipeline.setOutputLayout(layout[0], layout[1])) {
+        g_pipeline.setOutputLayout(APP_AUX_SLOT_LEFT, APP_AUX_SLOT_RIGHT);
+    }
+#endif
 
-                if (g_ble.isConnected() && !g_pauseBleNotifications) {
-                    g_ble.updateLevels(dbToPos(smooth30_dB), dbToPos(smooth60_dB), dbToPos(smooth100_dB));
-                }
-            }
-        } else {
-            gpio_set_level((gpio_num_t)APP_BEAT_LED_GPIO, 0);
-        }
+    return true;
+}
 
-        vTaskDelay(pdMS_TO_TICKS(10));
-    }
+#ifdef CONFIG_LED_MATRIX_ENABLE
+// LED controller first, so BLE can read its settings, then its task
+static bool bootLed() {
+    if (!initLedController()) return false;
+    #if APP_HAS_PSRAM
+    startLedTask(&g_dsp, 3, 8192, APP_CONTROL_CORE);  // 8KB stack - PSRAM available
+    #else
+    startLedTask(&g_dsp, 3, 4096, APP_CONTROL_CORE);  // 4KB stack - no PSRAM, conserve memory
+    #endif
+    ESP_LOGI(TAG, "LED matrix started on GPIO %d", CONFIG_LED_MATRIX_GPIO);
+    return true;
 }
+#endif
 
 // -----------------------------------------------------------
 // app_main
@@ -1714,14 +3693,22 @@ extern "C" void app_main(void) {
     // ========================================================================
 
     // NVS init
+    g_boot.begin(BOOT_NVS, "nvs");
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
         ESP_ERROR_CHECK(nvs_flash_init());
     }
     ESP_LOGI(TAG, "Booting ESP32 A2DP Sink + BLE + DSP...");
+#if APP_GLITCH_JOURNAL
+    GlitchJournal::getInstance().begin();
+#endif
+#if APP_FLEET_REPORT
+    fleetReportResult();
+#endif
 
-    // OTA validation
+#if !APP_OTA_DEFERRED_VALIDATION
+    // OTA validation (deferred: OtaValidator once the system is up)
     const esp_partition_t* running = esp_ota_get_running_partition();
     esp_ota_img_states_t state;
     if (esp_ota_get_state_partition(running, &state) == ESP_OK) {
@@ -1730,89 +3717,103 @@ extern "C" void app_main(void) {
             ESP_LOGI(TAG, "OTA validated");
         }
     }
-
-    // Initialize SPIFFS for sound storage
-    esp_vfs_spiffs_conf_t spiffsConf = {
-        .base_path = "/spiffs",
-        .partition_label = "spiffs",  // Must match partition table name
-        .max_files = 5,
-        .format_if_mount_failed = true
-    };
-    ret = esp_vfs_spiffs_register(&spiffsConf);
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "SPIFFS mounted");
-        size_t total = 0, used = 0;
-        esp_spiffs_info("spiffs", &total, &used);
-        ESP_LOGI(TAG, "SPIFFS: %u KB total, %u KB used", (unsigned)(total / 1024), (unsigned)(used / 1024));
-    } else {
-        ESP_LOGW(TAG, "SPIFFS mount failed: %s", esp_err_to_name(ret));
-    }
+#endif
 
     // Pre-allocate sound save task stack from internal RAM while memory is available
     // This must be done early before audio buffers consume internal RAM
     preallocSoundSaveStack();
+    g_sound.reserveTaskStack();
+    g_work.begin(2, APP_CONTROL_CORE);
+#if APP_AVRCP_QUEUE
+    g_avrcp.begin(g_a2dp, 4, APP_CONTROL_CORE);
+#endif
+#if APP_EVENT_LOG
+    EventLog::getInstance().begin(APP_CONTROL_CORE);
+#endif
 
-    // Load settings
+    // Load settings; saves are written back by the settings writer
     g_settings.load();
+    SettingsWriter::getInstance().begin(APP_CONTROL_CORE);
     bool bassBoost, channelFlip, bypass;
     int8_t eqBass, eqMid, eqTreble;
     std::string deviceName;
-    bool soundMuted;
     g_settings.getControl(bassBoost, channelFlip, bypass);
     g_settings.getEQ(eqBass, eqMid, eqTreble);
     g_settings.getDeviceName(deviceName);
-    soundMuted = g_settings.loadSoundMuted();
-
-    // Initialize sound player (sets muted state and scans SPIFFS for existing sounds)
-    g_sound.init(APP_I2S_DEFAULT_SAMPLE_RATE);
-    g_sound.setMuted(soundMuted);
-    ESP_LOGI(TAG, "Sound player initialized: muted=%d, status=0x%02X", soundMuted, g_sound.getStatus());
+#if APP_CODEC_POLICY
+    {
+        uint8_t blob[CodecPolicy::BLOB_BYTES];
+        size_t len = sizeof(blob);
+        if (g_settings.loadCodecPolicy(blob, len) && g_codecPolicy.deserialize(blob, len)) {
+            ESP_LOGI(TAG, "Codec policy: %d peers", g_codecPolicy.peerCount());
+        }
+    }
+#endif
+#if APP_PEER_STREAM_CACHE
+    {
+        uint8_t blob[PeerStreamCache::BLOB_BYTES];
+        size_t len = sizeof(blob);
+        if (g_settings.loadPeerStreams(blob, len) && g_peerStreams.deserialize(blob, len)) {
+            ESP_LOGI(TAG, "Peer stream cache: %d peers", g_peerStreams.peerCount());
+        }
+    }
+#endif
+    g_boot.end(BOOT_NVS);
 
-    // Initialize DSP
-    g_dsp.setSampleRate(APP_I2S_DEFAULT_SAMPLE_RATE);
+    // Initialize DSP (setSampleRate skips the default rate)
+    g_dsp.init(APP_I2S_DEFAULT_SAMPLE_RATE);
     g_dsp.setEQ(eqBass, eqMid, eqTreble, APP_I2S_DEFAULT_SAMPLE_RATE);
     g_dsp.setBassBoost(bassBoost);
     g_dsp.setChannelFlip(channelFlip);
     g_dsp.setBypass(bypass);
-
-    // Initialize I2S
-    if (g_i2s.init(APP_I2S_DEFAULT_SAMPLE_RATE) != ESP_OK) {
-        ESP_LOGE(TAG, "I2S init failed");
-        return;
+    if (g_settings.load3DBinaural()) {
+        // The kind only; 3D itself follows with the encoder
+        g_dsp.set3DMode(DSPProcessor::SOUND_3D_BINAURAL);
+        g_dsp.set3DSound(false);
     }
-    
-    // Set up I2S sample rate change callback to notify SoundPlayer
-    g_i2s.setSampleRateCallback([](uint32_t newRate) {
-        g_sound.setTargetSampleRate(newRate);
-    });
-
-    // Set up sound player I2S write function (after I2S init)
-    g_sound.setI2SWriteFunc([](const uint8_t* data, size_t len) -> size_t {
-        return g_i2s.write(data, len);
-    });
-
-    // Initialize audio pipeline
-    if (!g_pipeline.init()) {
-        ESP_LOGE(TAG, "Audio pipeline init failed");
-        return;
+#if APP_DSP_DYNAMICS
+    g_dsp.setDynamicsPreset(g_settings.loadDynamicsPreset());
+#endif
+#if APP_DSP_PEQ
+    {
+        uint8_t blob[ParametricEq::BLOB_BYTES];
+        size_t len = sizeof(blob);
+        if (g_settings.loadPeq(blob, len) && g_dsp.peq().deserialize(blob, len)) {
+            ESP_LOGI(TAG, "Parametric EQ: %d active bands", g_dsp.peq().activeBands());
+        }
     }
-    
-    // Initialize overlay mixer for sound effects during playback
-    if (!g_overlayMixer.init()) {
-        ESP_LOGE(TAG, "Overlay mixer init failed");
-        return;
+#endif
+#if APP_DSP_GRAPH
+    {
+        uint8_t blob[DspGraph::BLOB_BYTES];
+        size_t len = sizeof(blob);
+        DspGraph g;
+        if (g_settings.loadDspGraph(blob, len) && DspGraph::parse(blob, len, g) && g_dsp.setGraph(g) &&
+            !g.isBuiltIn()) {
+            logDspGraph("DSP stage order", g);
+        }
     }
-    g_pipeline.setOverlayMixer(&g_overlayMixer);
-    
-    // Set up sound player overlay push function for mixing with BT audio
-    g_sound.setOverlayPushFunc([](const int32_t* samples, size_t frames) {
-        g_overlayMixer.pushSamples(samples, frames);
-    });
-    
-    // Set callback to skip I2S writes when exclusive sound is playing
-    g_pipeline.setSkipWriteCallback([]() -> bool {
-        return g_sound.isExclusivePlaying();
-    });
+#endif
+    {
+        uint8_t blob[DspPresetBank::BLOB_BYTES];
+        size_t len = sizeof(blob);
+        if (g_settings.loadPresets(blob, len) && g_presets.deserialize(blob, len)) {
+            ESP_LOGI(TAG, "DSP presets loaded");
+        }
+    }
+
+    // Flash, I2S and the LED driver do not depend on each other or on
+    // Bluetooth: bring them up on both cores while this task starts BT
+    g_boot.spawn(BOOT_STORAGE, "boot_fs", bootStorage, 0, 4096, APP_CONTROL_CORE);
+    g_boot.spawn(BOOT_AUDIO_OUT, "boot_i2s", bootAudioOut, 0, 4096, APP_AUDIO_TX_CORE);
+    #ifdef CONFIG_LED_MATRIX_ENABLE
+    {
+        uint8_t led[NVSSettings::LED_SETTINGS_LEN];
+        const bool haveLed = g_settings.getLedSettings(led);
+        LedController::getInstance().setPersistence(haveLed ? led : nullptr, onLedSettingsChanged);
+    }
+    g_boot.spawn(BOOT_LED, "boot_led", bootLed, 0, 4096, APP_CONTROL_CORE);
+    #endif
 
     // GPIO init (buttons + LED)
     gpio_config_t io = {};
@@ -1820,67 +3821,41 @@ extern "C" void app_main(void) {
     io.mode = GPIO_MODE_INPUT;
     io.pin_bit_mask = (1ULL << APP_BUTTON1_GPIO) | (1ULL << APP_BUTTON2_GPIO);
     io.pull_up_en = GPIO_PULLUP_ENABLE;
-    gpio_config(&io);
+    gpio_config(&io);   // Edge interrupts are added by buttonsTask
+
+    // Connected sound, armed by onCodecConfig
+    esp_timer_create_args_t soundTimer = {};
+    soundTimer.callback = onConnectedSoundDue;
+    soundTimer.name = "conn_sound";
+    esp_timer_create(&soundTimer, &g_connectedSoundTimer);
+#if APP_DELAY_REPORT
+    esp_timer_create_args_t delayTimer = {};
+    delayTimer.callback = onDelayReportTick;
+    delayTimer.name = "delay_rpt";
+    esp_timer_create(&delayTimer, &g_delayReportTimer);
+    esp_timer_start_periodic(g_delayReportTimer, 1000000);
+#endif
+#if APP_SOURCE_TAKEOVER
+    esp_timer_create_args_t takeoverTimer = {};
+    takeoverTimer.callback = onTakeoverFaded;
+    takeoverTimer.name = "takeover";
+    esp_timer_create(&takeoverTimer, &g_takeoverTimer);
+#endif
 
+#if APP_BEAT_LED_FADE
+    g_beatLed.begin((gpio_num_t)APP_BEAT_LED_GPIO, LEDC_TIMER_0, LEDC_CHANNEL_0);
+#else
     gpio_config_t led = {};
     led.mode = GPIO_MODE_OUTPUT;
     led.pin_bit_mask = (1ULL << APP_BEAT_LED_GPIO);
     gpio_config(&led);
     gpio_set_level((gpio_num_t)APP_BEAT_LED_GPIO, 0);
-
-    // ========================================================================
-    // STARTUP SEQUENCE: Play startup sound + LED animation BEFORE BLE/A2DP
-    // Both must complete before initializing anything else
-    // ========================================================================
-    
-    // Start LED matrix task first (needed for startup animation)
-    #ifdef CONFIG_LED_MATRIX_ENABLE
-    #if APP_HAS_PSRAM
-    startLedTask(&g_dsp, 3, 8192);  // 8KB stack - PSRAM available
-    #else
-    startLedTask(&g_dsp, 3, 4096);  // 4KB stack - no PSRAM, conserve memory
-    #endif
-    ESP_LOGI(TAG, "LED matrix started on GPIO %d", CONFIG_LED_MATRIX_GPIO);
-    
-    // Give LED task time to initialize before requesting animation
-    vTaskDelay(pdMS_TO_TICKS(100));
-    
-    // Start startup sound and LED animation together
-    bool hasStartupSound = g_sound.hasSound(SOUND_STARTUP);
-    if (hasStartupSound) {
-        ESP_LOGI(TAG, "Playing startup sound + animation...");
-        g_sound.play(SOUND_STARTUP, g_i2s.getSampleRate(), SOUND_MODE_EXCLUSIVE);
-    } else {
-        ESP_LOGI(TAG, "Playing startup animation (no sound)...");
-    }
-    LedController::getInstance().requestStartupAnimation();
-    
-    // Small delay to ensure animation starts (flag is set before playStartupAnimation runs)
-    vTaskDelay(pdMS_TO_TICKS(50));
-    
-    // Wait for BOTH sound AND LED animation to complete
-    while (g_sound.isPlaying() || LedController::getInstance().isStartupAnimationRunning()) {
-        vTaskDelay(pdMS_TO_TICKS(50));
-    }
-    ESP_LOGI(TAG, "Startup sequence complete - sound and LED animation finished");
-    
-    #else
-    // No LED matrix - just play startup sound and wait for completion
-    if (g_sound.hasSound(SOUND_STARTUP)) {
-        ESP_LOGI(TAG, "Playing startup sound...");
-        g_sound.play(SOUND_STARTUP, g_i2s.getSampleRate(), SOUND_MODE_EXCLUSIVE);
-        while (g_sound.isPlaying()) {
-            vTaskDelay(pdMS_TO_TICKS(50));
-        }
-        ESP_LOGI(TAG, "Startup sound complete");
-    }
-    #endif
-    // ========================================================================
-    // END STARTUP SEQUENCE - Now initialize BLE, A2DP, and other services
-    // ========================================================================
+#endif
 
     // Initialize BLE
+    g_boot.begin(BOOT_BT, "bt");
     #ifdef CONFIG_LED_MATRIX_ENABLE
+    g_boot.wait(BootGraph::bit(BOOT_LED));  // Brightness and effect come from the LED settings
     // Unified BLE callbacks: EQ, EqPreset, Control, Name, LED, LedEffect, LedBright, SoundMute, SoundDelete, SoundData, OTA
     g_ble.setCallbacks(
         onBleEq,            // EqCallback
@@ -1915,32 +3890,108 @@ extern "C" void app_main(void) {
     );
     g_ble.init(deviceName.c_str(), APP_FW_VERSION, getControlByte(), eqBass, eqMid, eqTreble);
     #endif
-    
-    // Initialize BLE sound status with current sound player status
-    // This ensures the correct status is sent when a client connects
-    g_ble.setSoundStatus(g_sound.getStatus());
+#if APP_AUDIO_PERF_TRACE
+    g_ble.setTraceCallback(onBleTrace);
+#endif
+#if APP_AUDIO_LATENCY_PROBE
+    g_ble.setLatencyCallback(onBleLatency);
+#endif
+    g_ble.setTelemetryAvailable(BleTelemetry::LEVELS | BleTelemetry::QUEUE | BleTelemetry::CODEC
+                                | (APP_DSP_SPECTRUM ? BleTelemetry::SPECTRUM : 0)
+                                | (APP_DSP_LIMITER ? BleTelemetry::LIMITER : 0)
+                                | (APP_LINK_MONITOR ? BleTelemetry::LINK : 0));
+#if APP_DSP_LIMITER
+    g_ble.setLimiterCallback(onBleLimiter);
+#endif
+    g_ble.setPresetCallback(onBleStorePreset);
+#if APP_AUX_OUTPUT
+    g_ble.setOutputLayoutCallback(onBleOutputLayout);
+#endif
+#if APP_DSP_PEQ
+    g_ble.setPeqCallbacks(onBlePeqBand, onBlePeqStatus);
+#endif
+#ifdef CONFIG_LED_PROFILE
+    g_ble.setLedProfileCallback(onBleLedProfile);
+#endif
+#if APP_TASK_DIAGNOSTICS
+    g_ble.setTaskReportCallback(onBleTaskReport);
+#endif
+#if APP_GLITCH_JOURNAL
+    g_ble.setGlitchCallbacks(onBleGlitchRead, onBleGlitchClear);
+#endif
+#if APP_PCM_CAPTURE
+    g_ble.setCaptureCallbacks(onBleCaptureStatus, onBleCaptureControl, onBleCaptureRead);
+#endif
+#if APP_BLE_BULK_CHANNEL
+    BleBulkChannel::getInstance().begin(onBulkData, bulkCredit);
+#if APP_PCM_CAPTURE
+    g_ble.setBulkCallbacks(onBleBulkStatus, onBleCaptureBulk);
+#else
+    g_ble.setBulkCallbacks(onBleBulkStatus, nullptr);
+#endif
+#endif
+#if APP_DEADLINE_MONITOR
+    g_ble.setDeadlineCallback(onBleDeadline);
+#endif
+#if APP_LATENCY_PROFILES
+    g_ble.setProfileCallbacks(onBleLatencyProfile, onBleProfileStatus);
+#endif
+#if APP_DSP_DYNAMICS
+    g_ble.setDynamicsCallback(onBleDynamics);
+#endif
+    g_ble.setSound3DModeCallback(onBle3DMode);
+#if APP_DSP_GRAPH
+    g_ble.setDspGraphCallbacks(onBleDspGraph, onBleDspGraphStatus);
+#endif
+#if APP_FLEET_REPORT
+    g_ble.setFleetReportCallback(onBleFleetReport);
+#endif
+#if APP_PAGE_SCAN_POLICY
+    g_ble.setFastConnectCallback([](uint8_t seconds) {
+        PageScanPolicy::getInstance().forceFast(seconds);
+    });
+#endif
 
     // ========================================================================
     // A2DP Initialization
     // ========================================================================
     
-    // Delay before A2DP initialization to avoid AVRCP race condition
-    // ESP-IDF Bluetooth stack has a bug where simultaneous AVRCP connection attempts
-    // can crash in bta_av_rc_create - waiting allows the phone's connection attempt
-    // to start first and avoids the race condition
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    // Codec config and stream callbacks go straight to I2S and the pipeline
+    if (!g_boot.wait(BootGraph::bit(BOOT_AUDIO_OUT))) {
+        ESP_LOGE(TAG, "Audio output init failed");
+        return;
+    }
+#if APP_LATENCY_PROFILES
+    // Before the first discovery, so the offered codecs match it
+    applyLatencyProfile(g_settings.loadLatencyProfile(), false);
+#endif
     
     // Start A2DP
     g_a2dp.set_output_active(false);
-    g_a2dp.set_stream_reader(onStreamData, false);
+    g_a2dp.set_stream_reader_fmt(onStreamData, false);
+#if APP_AUDIO_PULL_DECODE
+    g_pipeline.setPullSource({esp_a2d_sink_pull_decode, esp_a2d_sink_get_queued});
+    esp_a2d_sink_set_pull_decode(true);
+#endif
     g_a2dp.set_codec_config_callback(onCodecConfig);
     g_a2dp.set_auto_reconnect(true);
-    g_a2dp.set_task_core(0);
+    g_a2dp.set_task_core(APP_DECODE_CORE);
     g_a2dp.set_on_connection_state_changed(onConnectionState);
+#if APP_SOURCE_TAKEOVER
+    g_a2dp.set_on_acl_connected(onAclConnected);
+#endif
     g_a2dp.set_on_audio_state_changed(onAudioState);
+    #if APP_DSP_VOLUME
+    // Keep the sink's int16 volume pass out of the BT callback
+    g_a2dp.set_volume_control(&g_sinkVolumeBypass);
+    #endif
     
     // Volume change callback - sync with LED and encoder controller
     g_a2dp.set_avrc_rn_volumechange([](int volume) {
+        #if APP_DSP_VOLUME
+        g_dsp.setVolume((uint8_t)volume);
+        #endif
+        EventBus::getInstance().publish(BUS_VOLUME_CHANGED, (uint32_t)volume);
         #ifdef CONFIG_LED_MATRIX_ENABLE
         LedController::getInstance().setVolume((uint8_t)volume);
         #endif
@@ -1977,28 +4028,98 @@ extern "C" void app_main(void) {
         }
     });
     
-    g_a2dp.start(deviceName.c_str());
-    
-    // Wait for A2DP stack to fully initialize before changing discoverability
-    // The library sets connectable=true during init, we need to override after
-    // Longer delay to allow AVRCP connection to stabilize (ESP-IDF race condition workaround)
-    vTaskDelay(pdMS_TO_TICKS(500));
+    #if APP_TRACK_INFO
+    // Title/artist once per track (cached by UID), scrolled on the matrix
+    TrackMetadata::getInstance().begin(g_a2dp,
+        [](const char* text) { LedController::getInstance().showTrackText(text); },
+        [](uint32_t posMs, uint32_t lengthMs) {
+            LedController::getInstance().setTrackPosition(posMs, lengthMs);
+        });
+    #endif
     
     // Disable discoverable mode at startup - only allow auto-reconnect from paired devices
     // User must press middle encoder button to enter pairing mode for new devices
     // ESP_BT_NON_DISCOVERABLE = connectable (for reconnect) but not visible for new pairings
+    // Set before start(): the library applies it when the stack comes up
     g_a2dp.set_discoverability(ESP_BT_NON_DISCOVERABLE);
+
+    // No delay for the AVRCP race (simultaneous AVRCP connection attempts can
+    // crash in bta_av_rc_create): the library is connectable at once but holds
+    // its own reconnect back for its reconnect delay, so the phone goes first
+    g_a2dp.start(deviceName.c_str());
+#if APP_HFP
+    HfpLink::getInstance().begin({ onVoiceStart, onVoiceStop, onVoiceDownlink, onVoiceVolume });
+#endif
+#if APP_PAGE_SCAN_POLICY
+    PageScanPolicy::getInstance().begin();
+#endif
+    g_boot.end(BOOT_BT);
     ESP_LOGI(TAG, "A2DP started as '%s' - discoverability DISABLED (reconnect only)", deviceName.c_str());
 
+    // Sound player: file scan done, then wired to the mixer
+    g_boot.wait(BootGraph::bit(BOOT_STORAGE));
+    g_sound.setOverlayPushFunc([](const int32_t* samples, size_t frames, bool exclusive) -> size_t {
+        const size_t queued = g_overlayMixer.pushSamples(exclusive ? OVERLAY_VOICE_EXCLUSIVE : OVERLAY_VOICE_PROMPT,
+                                                         samples, frames);
+        g_pipeline.wake();
+        return queued;
+    });
+
+    // Initialize BLE sound status with current sound player status
+    // This ensures the correct status is sent when a client connects
+    g_ble.setSoundStatus(g_sound.getStatus());
+    g_boot.log(TAG);
+    ESP_LOGI(TAG, "Codec profile %s: %s", APP_CODEC_PROFILE_NAME, APP_CODEC_NAMES);
+
+    // Startup sound and LED animation play alongside the rest of boot; a
+    // phone connecting meanwhile does not wait for them
+    #ifdef CONFIG_LED_MATRIX_ENABLE
+    if (g_sound.hasSound(SOUND_STARTUP)) {
+        ESP_LOGI(TAG, "Playing startup sound + animation...");
+        g_sound.play(SOUND_STARTUP, g_i2s.getSampleRate(), SOUND_MODE_EXCLUSIVE);
+    } else {
+        ESP_LOGI(TAG, "Playing startup animation (no sound)...");
+    }
+    LedController::getInstance().requestStartupAnimation();
+    #else
+    if (g_sound.hasSound(SOUND_STARTUP)) {
+        ESP_LOGI(TAG, "Playing startup sound...");
+        g_sound.play(SOUND_STARTUP, g_i2s.getSampleRate(), SOUND_MODE_EXCLUSIVE);
+    }
+    #endif
+
     // Log memory status before starting tasks
     ESP_LOGI(TAG, "Free heap: internal=%u KB, PSRAM=%u KB",
              (unsigned)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT) / 1024),
              (unsigned)(heap_caps_get_free_size(MALLOC_CAP_SPIRAM) / 1024));
 
     // Start audio processing task
-    xTaskCreatePinnedToCore(audioTxTask, "audio_tx", 8192, nullptr, configMAX_PRIORITIES - 2, nullptr, 1);
-    xTaskCreate(buttonsTask, "buttons", 2048, nullptr, 5, nullptr);
-    xTaskCreate(beatTask, "beat", 2048, nullptr, 4, nullptr);
+    ESP_LOGI(TAG, "Task layout: decode core %d, audio_tx core %d, control core %d",
+             APP_AUDIO_PULL_DECODE ? APP_AUDIO_TX_CORE : APP_DECODE_CORE, APP_AUDIO_TX_CORE, APP_CONTROL_CORE);
+    StaticAlloc::createTask(audioTxTask, "audio_tx", APP_AUDIO_TX_STACK, nullptr, configMAX_PRIORITIES - 2, nullptr,
+                            APP_AUDIO_TX_CORE);
+    StaticAlloc::createTask(buttonsTask, "buttons", 2048, nullptr, 5, &g_buttonsTaskHandle, APP_CONTROL_CORE);
+    StaticAlloc::createTask(beatTask, "beat", 2048, nullptr, 4, &g_beatTaskHandle, APP_CONTROL_CORE);
+    StaticAlloc::createTask(analysisTask, "analysis", 3072, nullptr, 2, nullptr, APP_CONTROL_CORE);
+    #if APP_AUDIO_LOAD_REPORT
+    StaticAlloc::createTask(loadReportTask, "load_rpt", 3072, nullptr, 1, nullptr, APP_CONTROL_CORE);
+    #endif
+    #if APP_MEM_PRESSURE_LADDER
+    g_memPressure.setTierCallback(onMemoryTier);
+    StaticAlloc::createTask(memPressureTask, "mem_gov", 3072, nullptr, 3, nullptr, APP_CONTROL_CORE);
+    #endif
+    #if APP_CODEC_POLICY
+    StaticAlloc::createTask(codecPolicyTask, "codec_pol", 3072, nullptr, 1, nullptr, APP_CONTROL_CORE);
+    #endif
+    #if APP_LINK_MONITOR
+    StaticAlloc::createTask(linkMonitorTask, "link_mon", 3072, nullptr, 1, nullptr, APP_CONTROL_CORE);
+    #endif
+    #if APP_TASK_DIAGNOSTICS
+    StaticAlloc::createTask(taskDiagTask, "task_diag", 3072, nullptr, 1, nullptr, APP_CONTROL_CORE);
+    #endif
+    #if APP_FLEET_REPORT
+    StaticAlloc::createTask(fleetReportTask, "fleet_rpt", 4096, nullptr, 1, &g_fleetTaskHandle, APP_CONTROL_CORE);
+    #endif
 
     // Initialize and start encoder task
     #ifdef CONFIG_ENCODER_ENABLE
@@ -2013,6 +4134,9 @@ extern "C" void app_main(void) {
         enc.setPairingModeCallback(onEncoderPairingMode);
         enc.setEffectCallback(onEncoderEffectChange);
         enc.set3DSoundCallback(onEncoder3DSound);
+        #if APP_LATENCY_PROFILES
+        enc.setProfileCycleCallback(onEncoderProfileCycle);
+        #endif
         
         // Set initial values from NVS
         enc.setCurrentVolume((uint8_t)g_a2dp.get_volume());  // Get current volume (0-127)
@@ -2032,11 +4156,35 @@ extern "C" void app_main(void) {
         enc.setMaxEffect(LED_EFFECT_COUNT);
         #endif
         
-        startEncoderTask();  // Uses default priority 2, pinned to core 0
+        startEncoderTask(2, 4096, APP_CONTROL_CORE);
         ESP_LOGI(TAG, "Encoder controller started on I2C SDA=%d, SCL=%d",
                  ENCODER_I2C_SDA_GPIO, ENCODER_I2C_SCL_GPIO);
     }
     #endif
 
+    #if APP_SYNC_ENABLE
+    if (!SyncLink::getInstance().begin(g_pipeline, onSyncFormat)) {
+        ESP_LOGE(TAG, "Multi-room sync failed to start");
+    }
+    #endif
+    #if APP_NET_INGEST
+    if (!NetIngest::getInstance().begin(g_pipeline, onIngestFormat)) {
+        ESP_LOGE(TAG, "WiFi ingest failed to start");
+    }
+    #endif
+    #if APP_PERF_CONSOLE
+    PerfConsole::getInstance().begin(g_pipeline, g_dsp, onConsoleCodecInfo);
+    #endif
+
+    // Clock scaling and light sleep from here on: bring-up ran at full clock
+    PowerManager::getInstance().configure();
+
+    // Where the long-lived parts ended up
+    StaticAlloc::report(TAG);
+    MemPlacement::report(TAG);
     ESP_LOGI(TAG, "System ready");
+
+    #if APP_OTA_DEFERRED_VALIDATION
+    OtaValidator::getInstance().begin(g_work, otaHealth);
+    #endif
 }
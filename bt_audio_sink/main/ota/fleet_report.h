@@ -0,0 +1,148 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Fleet Report - a unit's performance batch for the fleet
+// dashboards, shared by the app (APP_FLEET_REPORT) and the recovery
+// app, which uploads it over WiFi
+// - The app has no WiFi of its own to spare: it builds the batch,
+//   stages it in NVS with the endpoint and the partition to come back
+//   to, and reboots into recovery; recovery POSTs it, stores the HTTP
+//   status and boots the app again, which reads the result
+// - Batch (application/octet-stream): [magic u16, version, reset
+//   reason, uptime_s u32, fw_len, fw..., {tag, len u16, value...}...]
+//   little endian; tags are the BLE STATUS_* ids with the same payload
+//   (ble_unified.h), items without one start at 0x80, unknown tags are
+//   skipped by length
+// - One report staged at a time; staging replaces one not sent yet
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "nvs.h"
+
+class FleetReport {
+public:
+    static constexpr uint16_t MAGIC = 0x5246;           // "FR"
+    static constexpr uint8_t VERSION = 1;
+    static constexpr size_t MAX_BYTES = 4096;           // NVS blob, one POST
+    static constexpr size_t URL_BYTES = 128;
+    static constexpr size_t LABEL_BYTES = 17;           // Partition label + NUL
+
+    static constexpr uint8_t TAG_TRACE     = 0x07;      // STATUS_TRACE
+    static constexpr uint8_t TAG_TASKS     = 0x0B;      // STATUS_TASKS
+    static constexpr uint8_t TAG_GLITCHES  = 0x0C;      // Journal entries, oldest first, no frag byte
+    static constexpr uint8_t TAG_DEADLINE  = 0x0D;      // STATUS_DEADLINE
+    static constexpr uint8_t TAG_PROFILE   = 0x0E;      // STATUS_PROFILE
+    static constexpr uint8_t TAG_LATENCY   = 0x80;      // As the BLE snapshot's
+    static constexpr uint8_t TAG_LINK      = 0x81;      // [rssi, quality, rf_level, queued u16, rf_glitches u16, cpu_glitches u16, last]
+
+    // Upload result, besides an HTTP status
+    static constexpr int32_t RESULT_NO_WIFI = -1;       // No stored network, or it did not connect
+    static constexpr int32_t RESULT_NO_SEND = -2;       // Connected, request failed
+
+    // ---- Building (app) ----
+
+    // Header into out; false if cap cannot hold it
+    bool begin(uint8_t* out, size_t cap, const char* fw, uint8_t resetReason, uint32_t uptimeS) {
+        const size_t fwLen = strnlen(fw, 32);
+        m_out = out;
+        m_cap = cap;
+        m_len = 0;
+        if (cap < 9 + fwLen) return false;
+        out[0] = (uint8_t)MAGIC;
+        out[1] = (uint8_t)(MAGIC >> 8);
+        out[2] = VERSION;
+        out[3] = resetReason;
+        put32(out + 4, uptimeS);
+        out[8] = (uint8_t)fwLen;
+        memcpy(out + 9, fw, fwLen);
+        m_len = 9 + fwLen;
+        return true;
+    }
+
+    // Room for the next item's value, room bytes of it; commit() what was
+    // written (nothing, to leave the item out)
+    uint8_t* item(size_t& room) {
+        room = m_len + ITEM_HEADER < m_cap ? m_cap - m_len - ITEM_HEADER : 0;
+        if (room > 0xFFFF) room = 0xFFFF;
+        return m_out + m_len + ITEM_HEADER;
+    }
+
+    void commit(uint8_t tag, size_t len) {
+        if (len == 0) return;
+        m_out[m_len] = tag;
+        m_out[m_len + 1] = (uint8_t)len;
+        m_out[m_len + 2] = (uint8_t)(len >> 8);
+        m_len += ITEM_HEADER + len;
+    }
+
+    size_t size() const { return m_len; }
+
+    // ---- Hand-off through NVS ----
+
+    // App: the batch, where it goes and the partition recovery boots back to
+    static bool stage(const uint8_t* data, size_t len, const char* url, const char* returnLabel) {
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) return false;
+        esp_err_t err = nvs_set_str(h, KEY_URL, url);
+        if (err == ESP_OK) err = nvs_set_str(h, KEY_RETURN, returnLabel);
+        if (err == ESP_OK) nvs_erase_key(h, KEY_RESULT);
+        if (err == ESP_OK) err = nvs_set_blob(h, KEY_REPORT, data, len);
+        if (err == ESP_OK) err = nvs_commit(h);
+        nvs_close(h);
+        return err == ESP_OK;
+    }
+
+    // Recovery: the staged batch (len bytes into data, MAX_BYTES), erased
+    // from NVS at once so a crash mid-upload cannot loop; false if none
+    static bool take(uint8_t* data, size_t& len, char* url, char* returnLabel) {
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) return false;
+        len = MAX_BYTES;
+        size_t urlLen = URL_BYTES, labelLen = LABEL_BYTES;
+        const bool ok = nvs_get_blob(h, KEY_REPORT, data, &len) == ESP_OK &&
+                        nvs_get_str(h, KEY_URL, url, &urlLen) == ESP_OK &&
+                        nvs_get_str(h, KEY_RETURN, returnLabel, &labelLen) == ESP_OK;
+        if (nvs_erase_key(h, KEY_REPORT) == ESP_OK) nvs_commit(h);
+        nvs_close(h);
+        return ok;
+    }
+
+    // Recovery: an HTTP status or RESULT_*
+    static void putResult(int32_t result) {
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) return;
+        if (nvs_set_i32(h, KEY_RESULT, result) == ESP_OK) nvs_commit(h);
+        nvs_close(h);
+    }
+
+    // App, at boot: the last upload's result, once; false if none came in
+    static bool takeResult(int32_t& result) {
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) return false;
+        const bool ok = nvs_get_i32(h, KEY_RESULT, &result) == ESP_OK;
+        if (ok && nvs_erase_key(h, KEY_RESULT) == ESP_OK) nvs_commit(h);
+        nvs_close(h);
+        return ok;
+    }
+
+private:
+    static constexpr size_t ITEM_HEADER = 3;
+    static constexpr const char* NVS_NAMESPACE = "fleet";
+    static constexpr const char* KEY_REPORT = "report";
+    static constexpr const char* KEY_URL = "url";
+    static constexpr const char* KEY_RETURN = "return";
+    static constexpr const char* KEY_RESULT = "result";
+
+    static void put32(uint8_t* p, uint32_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+
+    uint8_t* m_out = nullptr;
+    size_t m_cap = 0;
+    size_t m_len = 0;
+};
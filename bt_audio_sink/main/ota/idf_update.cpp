@@ -5,25 +5,10 @@
 #include "esp_log.h"
 #include "esp_app_format.h"
 
-#include "mbedtls/md5.h"
+#include "ota_session.h"
 
 static const char *TAG_UPDATE = "IDF_UPDATE";
 
-static int md5_starts(mbedtls_md5_context *ctx) {
-    mbedtls_md5_starts(ctx);
-    return 0;
-}
-
-static int md5_update(mbedtls_md5_context *ctx, const uint8_t *data, size_t len) {
-    mbedtls_md5_update(ctx, data, len);
-    return 0;
-}
-
-static int md5_finish(mbedtls_md5_context *ctx, uint8_t out16[16]) {
-    mbedtls_md5_finish(ctx, out16);
-    return 0;
-}
-
 IdfUpdate::IdfUpdate() {
     reset_();
 }
@@ -32,7 +17,12 @@ void IdfUpdate::onProgress(ProgressCb cb) {
     _progressCb = cb;
 }
 
-bool IdfUpdate::begin(size_t size, const char *label) {
+bool IdfUpdate::begin(size_t size, const char *label, const uint8_t *imageSha256) {
+    // An update left running (the link dropped) gives its handle back;
+    // its saved session stays for a resume
+    if (_running && _otaHandle != 0) {
+        esp_ota_abort(_otaHandle);
+    }
     reset_();
 
     if (size == 0) {
@@ -87,6 +77,24 @@ bool IdfUpdate::begin(size_t size, const char *label) {
         return false;
     }
 
+    if (imageSha256) {
+        setSHA256(imageSha256);
+    }
+#if APP_OTA_RESUME
+    if (imageSha256) {
+        _resumable = true;
+        _checkpointAt = APP_OTA_RESUME_CHECKPOINT;
+        OtaSession s;
+        if (OtaSession::load(s) && memcmp(s.sha256, imageSha256, sizeof(s.sha256)) == 0 &&
+            s.size == _expectedSize && s.partition == part->address &&
+            s.committed > 0 && s.committed < s.size && resume_(part, s.committed)) {
+            return true;
+        }
+    }
+    // Whatever was saved describes a slot that is about to be rewritten
+    OtaSession::clear();
+#endif
+
     esp_ota_handle_t otaHandle = 0;
     esp_err_t err = esp_ota_begin(part, OTA_WITH_SEQUENTIAL_WRITES, &otaHandle);
     if (err != ESP_OK) {
@@ -99,42 +107,134 @@ bool IdfUpdate::begin(size_t size, const char *label) {
     _otaHandle = otaHandle;
     _partition = part;
 
-    // MD5 context is always initialized; verification is optional.
-    mbedtls_md5_init(&_md5Ctx);
-    _md5CtxInit = true;
-    (void)md5_starts(&_md5Ctx);
+    // Digest is always computed; verification is optional.
+    _stream.begin();
 
     _running = true;
     ESP_LOGI(TAG_UPDATE, "begin ok slot='%s' addr=0x%08X size=%u", part->label, (unsigned)part->address, (unsigned)_expectedSize);
     return true;
 }
 
-bool IdfUpdate::setMD5(const char *expected_md5_hex) {
-    if (!expected_md5_hex) {
+// Re-enters a slot mid-image. The bytes before offset are taken as
+// written and hashed back from flash, so end() still checks the digest
+// of the whole image. False leaves nothing open (begin starts over).
+bool IdfUpdate::resume_(const esp_partition_t *part, size_t offset) {
+    esp_ota_handle_t otaHandle = 0;
+    esp_err_t err = esp_ota_resume(part, OTA_WITH_SEQUENTIAL_WRITES, offset, &otaHandle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG_UPDATE, "esp_ota_resume failed: %s, starting over", esp_err_to_name(err));
+        return false;
+    }
+
+    _stream.begin();
+    for (size_t at = 0; at < offset && err == ESP_OK; at += kBlockSize) {
+        const size_t n = (offset - at < kBlockSize) ? (offset - at) : kBlockSize;
+        err = esp_partition_read(part, at, _buf, n);
+        if (err == ESP_OK) {
+            _stream.update(_buf, n, [](const uint8_t *, size_t) { return true; });
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG_UPDATE, "Slot read failed: %s, starting over", esp_err_to_name(err));
+        esp_ota_abort(otaHandle);
+        _stream.reset();
+        return false;
+    }
+
+    _otaHandle = otaHandle;
+    _partition = part;
+    _progress = offset;
+    _resumeOffset = offset;
+    _checkpointAt = offset + APP_OTA_RESUME_CHECKPOINT;
+    _headerVerified = true;     // Checked when the image started
+    _running = true;
+    ESP_LOGI(TAG_UPDATE, "resume ok slot='%s' at %u / %u", part->label, (unsigned)offset, (unsigned)_expectedSize);
+    return true;
+}
+
+// Flash holds the image up to _progress
+void IdfUpdate::checkpoint_() {
+    OtaSession s;
+    memcpy(s.sha256, _digestExpected, sizeof(s.sha256));
+    s.size = (uint32_t)_expectedSize;
+    s.partition = (uint32_t)_partition->address;
+    s.committed = (uint32_t)_progress;
+    OtaSession::save(s);
+    _checkpointAt = _progress + APP_OTA_RESUME_CHECKPOINT;
+}
+
+bool IdfUpdate::setSHA256(const char *expected_sha256_hex) {
+    if (!expected_sha256_hex) {
         abort_(UPDATE_ERROR_BAD_ARGUMENT);
         return false;
     }
 
-    uint8_t tmp[16];
-    if (!parse_md5_hex_(expected_md5_hex, tmp)) {
+    uint8_t tmp[OtaStream::DIGEST_BYTES];
+    if (!parse_hex_(expected_sha256_hex, tmp, sizeof(tmp))) {
         abort_(UPDATE_ERROR_BAD_ARGUMENT);
         return false;
     }
 
-    memcpy(_md5Expected, tmp, sizeof(_md5Expected));
-    _md5ExpectedSet = true;
-    _md5Enabled = true;
+    setSHA256(tmp);
     return true;
 }
 
+void IdfUpdate::setSHA256(const uint8_t expected[OtaStream::DIGEST_BYTES]) {
+    memcpy(_digestExpected, expected, sizeof(_digestExpected));
+    _digestExpectedSet = true;
+}
+
 size_t IdfUpdate::write(const uint8_t *data, size_t len) {
     if (!data || len == 0) return 0;
     if (!_running || hasError()) return 0;
 
+    // First byte tells a delta patch or compressed image from an app image
+    if (!_headerVerified && _format == FORMAT_IMAGE) {
+        if (data[0] == OtaDelta::MAGIC[0]) {
+            if (!startDelta_()) {
+                return 0;
+            }
+            _resumable = false;     // Patch state cannot be re-entered
+        } else if (data[0] == OtaCompressed::MAGIC[0]) {
+            _compressed.begin();
+            _resumable = false;
+            _format = FORMAT_COMPRESSED;
+            _expectedSize = 0;      // Known once the header is in
+        }
+    }
+
+    bool ok = true;
+    if (_format == FORMAT_DELTA) {
+        ok = _delta.feed(data, len, [this](const uint8_t *p, size_t n) {
+            return targetKnown_(_delta.targetSize()) && append_(p, n);
+        });
+        if (ok && _delta.headerReady()) {
+            ok = targetKnown_(_delta.targetSize());
+            if (ok && !_digestExpectedSet) setSHA256(_delta.targetSha256());
+        }
+    } else if (_format == FORMAT_COMPRESSED) {
+        ok = _compressed.feed(data, len, [this](const uint8_t *p, size_t n) {
+            return targetKnown_(_compressed.imageSize()) && append_(p, n);
+        });
+        if (ok && _compressed.headerReady()) {
+            ok = targetKnown_(_compressed.imageSize());
+        }
+    } else {
+        ok = append_(data, len);
+    }
+
+    if (!ok) {
+        if (!hasError()) abort_(_format == FORMAT_DELTA ? UPDATE_ERROR_DELTA : UPDATE_ERROR_STREAM);
+        return 0;
+    }
+    return len;
+}
+
+bool IdfUpdate::append_(const uint8_t *data, size_t len) {
     // Header verification (first byte written)
     if (!_headerVerified) {
         if (!verifyHeader_(data[0])) {
-            return 0;
+            return false;
         }
         _headerVerified = true;
     }
@@ -149,22 +249,56 @@ size_t IdfUpdate::write(const uint8_t *data, size_t len) {
 
         if (_bufLen == kBlockSize) {
             if (!flush_()) {
-                break;
+                return false;
             }
         }
 
         if (_expectedSize && (_progress + _bufLen) > _expectedSize) {
             abort_(UPDATE_ERROR_SIZE);
-            break;
+            return false;
         }
     }
 
-    return consumed;
+    return true;
+}
+
+bool IdfUpdate::startDelta_() {
+    if (!_delta.begin(esp_ota_get_running_partition())) {
+        abort_(UPDATE_ERROR_DELTA);
+        return false;
+    }
+    _format = FORMAT_DELTA;
+    _expectedSize = 0;      // Known once the patch header is in
+    return true;
+}
+
+// Size of the image a patch or compressed stream unpacks to
+bool IdfUpdate::targetKnown_(size_t size) {
+    if (_expectedSize == size) return true;
+    if (size > _partition->size) {
+        ESP_LOGE(TAG_UPDATE, "Image too large for slot '%s' (%u > %u)", _partition->label, (unsigned)size, (unsigned)_partition->size);
+        abort_(UPDATE_ERROR_SPACE);
+        return false;
+    }
+    _expectedSize = size;
+    return true;
 }
 
 bool IdfUpdate::end(bool evenIfRemaining) {
     if (hasError() || !_running) return false;
 
+    if (_format == FORMAT_DELTA && !_delta.done()) {
+        ESP_LOGE(TAG_UPDATE, "Delta patch incomplete");
+        abort_(UPDATE_ERROR_DELTA);
+        return false;
+    }
+
+    if (_format == FORMAT_COMPRESSED && !_compressed.done()) {
+        ESP_LOGE(TAG_UPDATE, "Compressed image incomplete");
+        abort_(UPDATE_ERROR_STREAM);
+        return false;
+    }
+
     if (!flush_()) {
         return false;
     }
@@ -174,22 +308,16 @@ bool IdfUpdate::end(bool evenIfRemaining) {
         return false;
     }
 
-    // MD5 verify (optional)
-    if (_md5CtxInit && !_md5Finalized) {
-        (void)md5_finish(&_md5Ctx, _md5Actual);
-        _md5Finalized = true;
+    // SHA-256 verify (optional); a plaintext stream has no tail to emit
+    if (!_digestFinalized) {
+        _stream.finish([](const uint8_t *, size_t) { return true; }, _digestActual);
+        _digestFinalized = true;
     }
 
-    if (_md5Enabled && _md5ExpectedSet) {
-        if (!_md5Finalized) {
-            abort_(UPDATE_ERROR_MD5);
-            return false;
-        }
-        if (memcmp(_md5Expected, _md5Actual, sizeof(_md5Expected)) != 0) {
-            ESP_LOGE(TAG_UPDATE, "MD5 mismatch");
-            abort_(UPDATE_ERROR_MD5);
-            return false;
-        }
+    if (_digestExpectedSet && memcmp(_digestExpected, _digestActual, sizeof(_digestExpected)) != 0) {
+        ESP_LOGE(TAG_UPDATE, "SHA-256 mismatch");
+        abort_(UPDATE_ERROR_DIGEST);
+        return false;
     }
 
     esp_err_t err = esp_ota_end(_otaHandle);
@@ -209,6 +337,12 @@ bool IdfUpdate::end(bool evenIfRemaining) {
     }
 
     _running = false;
+    _delta.end();
+    _compressed.end();
+    if (_resumable) {
+        OtaSession::clear();
+        _resumable = false;
+    }
     ESP_LOGI(TAG_UPDATE, "end ok");
     return true;
 }
@@ -226,12 +360,13 @@ const char *IdfUpdate::errorString() const {
     case UPDATE_ERROR_SPACE: return "SPACE";
     case UPDATE_ERROR_SIZE: return "SIZE";
     case UPDATE_ERROR_STREAM: return "STREAM";
-    case UPDATE_ERROR_MD5: return "MD5";
+    case UPDATE_ERROR_DIGEST: return "DIGEST";
     case UPDATE_ERROR_MAGIC_BYTE: return "MAGIC_BYTE";
     case UPDATE_ERROR_ACTIVATE: return "ACTIVATE";
     case UPDATE_ERROR_NO_PARTITION: return "NO_PARTITION";
     case UPDATE_ERROR_BAD_ARGUMENT: return "BAD_ARGUMENT";
     case UPDATE_ERROR_ABORT: return "ABORT";
+    case UPDATE_ERROR_DELTA: return "DELTA";
     default: return "UNKNOWN";
     }
 }
@@ -250,16 +385,19 @@ void IdfUpdate::reset_() {
 
     _bufLen = 0;
 
-    _md5Enabled = false;
-    _md5ExpectedSet = false;
-    memset(_md5Expected, 0, sizeof(_md5Expected));
-    memset(_md5Actual, 0, sizeof(_md5Actual));
-    _md5Finalized = false;
+    _delta.end();
+    _compressed.end();
+    _format = FORMAT_IMAGE;
 
-    if (_md5CtxInit) {
-        mbedtls_md5_free(&_md5Ctx);
-        _md5CtxInit = false;
-    }
+    _resumable = false;
+    _resumeOffset = 0;
+    _checkpointAt = 0;
+
+    _digestExpectedSet = false;
+    memset(_digestExpected, 0, sizeof(_digestExpected));
+    memset(_digestActual, 0, sizeof(_digestActual));
+    _digestFinalized = false;
+    _stream.reset();
 }
 
 void IdfUpdate::abort_(Error err) {
@@ -268,13 +406,17 @@ void IdfUpdate::abort_(Error err) {
         esp_ota_abort(_otaHandle);
     }
 
+    // Failed or cancelled: nothing to come back to
+    if (_resumable) {
+        OtaSession::clear();
+        _resumable = false;
+    }
+
     _error = err;
     _running = false;
-
-    if (_md5CtxInit) {
-        mbedtls_md5_free(&_md5Ctx);
-        _md5CtxInit = false;
-    }
+    _stream.reset();
+    _delta.end();
+    _compressed.end();
 
     _otaHandle = 0;
     _partition = nullptr;
@@ -289,7 +431,12 @@ bool IdfUpdate::flush_() {
         return false;
     }
 
-    esp_err_t err = esp_ota_write(_otaHandle, _buf, _bufLen);
+    // Plaintext stream: hashes the block and hands it straight back
+    esp_err_t err = ESP_OK;
+    _stream.update(_buf, _bufLen, [&](const uint8_t *data, size_t len) {
+        err = esp_ota_write(_otaHandle, data, len);
+        return err == ESP_OK;
+    });
     if (err != ESP_OK) {
         _lastEspErr = err;
         ESP_LOGE(TAG_UPDATE, "esp_ota_write failed: %s", esp_err_to_name(err));
@@ -297,13 +444,13 @@ bool IdfUpdate::flush_() {
         return false;
     }
 
-    if (_md5CtxInit) {
-        (void)md5_update(&_md5Ctx, _buf, _bufLen);
-    }
-
     _progress += _bufLen;
     _bufLen = 0;
 
+    if (_resumable && _progress >= _checkpointAt && _progress < _expectedSize) {
+        checkpoint_();
+    }
+
     if (_progressCb) {
         _progressCb(_progress, _expectedSize);
     }
@@ -320,9 +467,9 @@ bool IdfUpdate::verifyHeader_(uint8_t firstByte) {
     return true;
 }
 
-bool IdfUpdate::parse_md5_hex_(const char *hex, uint8_t out16[16]) {
+bool IdfUpdate::parse_hex_(const char *hex, uint8_t *out, size_t outLen) {
     if (!hex) return false;
-    if (strlen(hex) != 32) return false;
+    if (strlen(hex) != outLen * 2) return false;
 
     auto nib = [](char c) -> int {
         if (c >= '0' && c <= '9') return c - '0';
@@ -331,11 +478,11 @@ bool IdfUpdate::parse_md5_hex_(const char *hex, uint8_t out16[16]) {
         return -1;
     };
 
-    for (int i = 0; i < 16; i++) {
+    for (size_t i = 0; i < outLen; i++) {
         int hi = nib(hex[i * 2]);
         int lo = nib(hex[i * 2 + 1]);
         if (hi < 0 || lo < 0) return false;
-        out16[i] = (uint8_t)((hi << 4) | lo);
+        out[i] = (uint8_t)((hi << 4) | lo);
     }
     return true;
 }
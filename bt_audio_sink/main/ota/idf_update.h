@@ -7,7 +7,9 @@
 #include "esp_ota_ops.h"
 #include "esp_partition.h"
 
-#include "mbedtls/md5.h"
+#include "ota_compressed.h"
+#include "ota_delta.h"
+#include "ota_stream.h"
 
 class IdfUpdate {
 public:
@@ -19,12 +21,13 @@ public:
         UPDATE_ERROR_SPACE        = 4,
         UPDATE_ERROR_SIZE         = 5,
         UPDATE_ERROR_STREAM       = 6,
-        UPDATE_ERROR_MD5          = 7,
+        UPDATE_ERROR_DIGEST       = 7,
         UPDATE_ERROR_MAGIC_BYTE   = 8,
         UPDATE_ERROR_ACTIVATE     = 9,
         UPDATE_ERROR_NO_PARTITION = 10,
         UPDATE_ERROR_BAD_ARGUMENT = 11,
         UPDATE_ERROR_ABORT        = 12,
+        UPDATE_ERROR_DELTA        = 13,
     };
 
     using ProgressCb = void (*)(size_t written, size_t total);
@@ -35,9 +38,20 @@ public:
 
     // Starts an OTA update for the next update partition.
     // If label is provided, tries to use that app partition label.
-    bool begin(size_t size, const char *label = nullptr);
+    // With imageSha256 (the digest the image must have, checked in end())
+    // the update is resumable (APP_OTA_RESUME): progress is saved as it
+    // goes (ota_session.h), and a session saved for the same image, size
+    // and slot is re-entered at its offset, see resumeOffset().
+    bool begin(size_t size, const char *label = nullptr, const uint8_t *imageSha256 = nullptr);
+
+    // Image offset the sender continues from: 0, or where a resumed
+    // update left off (everything before it is in flash and hashed)
+    size_t resumeOffset() const { return _resumeOffset; }
 
     // Writes firmware bytes. Returns number of bytes consumed.
+    // A delta patch (ota_delta.h) is applied against the running app and
+    // a compressed image (ota_compressed.h) inflated; size() and
+    // progress() then count image bytes once the stream header is in.
     size_t write(const uint8_t *data, size_t len);
 
     // Finalizes update, validates and sets boot partition.
@@ -45,8 +59,13 @@ public:
 
     void abort();
 
-    // Optional MD5 verification. Provide hex string (32 chars).
-    bool setMD5(const char *expected_md5_hex);
+    // Optional SHA-256 verification of the image, checked in end().
+    // Hex string (64 chars) or the 32 digest bytes.
+    bool setSHA256(const char *expected_sha256_hex);
+    void setSHA256(const uint8_t expected[OtaStream::DIGEST_BYTES]);
+
+    // SHA-256 of everything written, valid after end()
+    const uint8_t *digest() const { return _digestActual; }
 
     Error getError() const { return _error; }
     esp_err_t lastEspErr() const { return _lastEspErr; }
@@ -67,8 +86,13 @@ private:
     void reset_();
     void abort_(Error err);
     bool flush_();
+    bool append_(const uint8_t *data, size_t len);
+    bool startDelta_();
+    bool targetKnown_(size_t size);
     bool verifyHeader_(uint8_t firstByte);
-    bool parse_md5_hex_(const char *hex, uint8_t out16[16]);
+    bool resume_(const esp_partition_t *part, size_t offset);
+    void checkpoint_();
+    bool parse_hex_(const char *hex, uint8_t *out, size_t outLen);
 
 private:
     Error _error = UPDATE_ERROR_OK;
@@ -90,12 +114,22 @@ private:
     uint8_t _buf[kBlockSize];
     size_t _bufLen = 0;
 
-    // MD5
-    bool _md5Enabled = false;
-    bool _md5ExpectedSet = false;
-    uint8_t _md5Expected[16] = {0};
-    uint8_t _md5Actual[16] = {0};
-    bool _md5Finalized = false;
-    mbedtls_md5_context _md5Ctx;
-    bool _md5CtxInit = false;
+    // What write() is fed
+    enum Format : uint8_t { FORMAT_IMAGE, FORMAT_DELTA, FORMAT_COMPRESSED };
+    Format _format = FORMAT_IMAGE;
+    OtaDelta _delta;
+    OtaCompressed _compressed;
+
+    // Resume (APP_OTA_RESUME): progress of a plain image goes to NVS
+    // every APP_OTA_RESUME_CHECKPOINT bytes
+    bool _resumable = false;
+    size_t _resumeOffset = 0;
+    size_t _checkpointAt = 0;
+
+    // Digest (plaintext OtaStream, SHA-256 on the hardware engine)
+    OtaStream _stream;
+    bool _digestExpectedSet = false;
+    uint8_t _digestExpected[OtaStream::DIGEST_BYTES] = {0};
+    uint8_t _digestActual[OtaStream::DIGEST_BYTES] = {0};
+    bool _digestFinalized = false;
 };
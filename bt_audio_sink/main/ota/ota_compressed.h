@@ -0,0 +1,101 @@
+#pragma once
+
+// -----------------------------------------------------------
+// OTA Compressed - full app image sent raw-deflated
+// (tools/ota_compress.py) and inflated on the fly, so the link carries
+// roughly 40% less without any staging in flash
+// Layout, little-endian:
+//   header (HEADER_BYTES, not compressed)
+//     magic "ZIMG", version u8, window_bits u8, reserved u16,
+//     image_size u32
+//   raw deflate stream of the image, window of 2^window_bits bytes
+// - The window is capped at MAX_WINDOW_BITS (4 KB), so the inflate
+//   ring is no bigger than IdfUpdate's block buffer
+// - The first byte ('Z') can never start an app image (0xE9) or a
+//   delta patch ('B'), which is how IdfUpdate tells them apart
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "esp_log.h"
+#include "ota_inflate.h"
+
+class OtaCompressed {
+public:
+    static constexpr size_t HEADER_BYTES = 12;
+    static constexpr uint8_t MAGIC[4] = { 'Z', 'I', 'M', 'G' };
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint8_t MAX_WINDOW_BITS = 12;
+
+    void begin() {
+        m_inflate.end();
+        m_headerLen = 0;
+        m_produced = 0;
+        m_failed = false;
+    }
+
+    void end() { m_inflate.end(); }
+
+    bool headerReady() const { return m_headerLen == HEADER_BYTES && m_inflate.active(); }
+    bool done() const { return m_inflate.done() && m_produced == m_imageSize; }
+    uint32_t imageSize() const { return m_imageSize; }
+
+    // Compressed bytes in; image bytes out through sink(data, len),
+    // which returns false to stop. False on a bad stream.
+    template <typename Sink>
+    bool feed(const uint8_t* data, size_t len, Sink&& sink) {
+        if (m_failed) return false;
+
+        if (m_headerLen < HEADER_BYTES) {
+            size_t n = HEADER_BYTES - m_headerLen;
+            if (n > len) n = len;
+            memcpy(m_header + m_headerLen, data, n);
+            m_headerLen += n;
+            data += n;
+            len -= n;
+            if (m_headerLen < HEADER_BYTES) return true;
+            if (!checkHeader()) return fail();
+        }
+
+        const bool ok = m_inflate.feed(data, len, [&](const uint8_t* p, size_t n) {
+            if (n > m_imageSize - m_produced) {
+                ESP_LOGE(TAG, "Inflates past its %u byte image", (unsigned)m_imageSize);
+                return false;
+            }
+            m_produced += n;
+            return sink(p, n);
+        });
+        return ok ? true : fail();
+    }
+
+private:
+    static constexpr const char* TAG = "OTA_COMP";
+
+    bool fail() {
+        m_failed = true;
+        return false;
+    }
+
+    bool checkHeader() {
+        const uint8_t windowBits = m_header[5];
+        if (memcmp(m_header, MAGIC, sizeof(MAGIC)) != 0 || m_header[4] != VERSION) {
+            ESP_LOGE(TAG, "Not a compressed image (version %u)", m_header[4]);
+            return false;
+        }
+        if (windowBits < 9 || windowBits > MAX_WINDOW_BITS) {
+            ESP_LOGE(TAG, "Unsupported window of 2^%u bytes (max %u)", windowBits, 1u << MAX_WINDOW_BITS);
+            return false;
+        }
+        m_imageSize = m_header[8] | (m_header[9] << 8) | (m_header[10] << 16) | ((uint32_t)m_header[11] << 24);
+        if (!m_inflate.begin((size_t)1 << windowBits)) return false;
+        ESP_LOGI(TAG, "Compressed OTA: %u byte image, %u byte window", (unsigned)m_imageSize, 1u << windowBits);
+        return true;
+    }
+
+    OtaInflate m_inflate;
+    uint8_t m_header[HEADER_BYTES];
+    size_t m_headerLen = 0;
+    uint32_t m_imageSize = 0;
+    uint32_t m_produced = 0;        // Image bytes out so far
+    bool m_failed = false;
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+// -----------------------------------------------------------
+// OTA Delta - applies a binary patch (tools/ota_delta.py) against the
+// running app while it streams in, so a small change ships as a few
+// KB instead of the whole image
+// Patch layout, little-endian:
+//   header (HEADER_BYTES, not compressed)
+//     magic "BTDP", version u8, flags u8, reserved u16,
+//     base_size u32, target_size u32,
+//     base_sha256[32]   digest appended to the base image, i.e. what
+//                       esp_partition_get_sha256() gives for it
+//     target_sha256[32] SHA-256 of the whole target image
+//   raw deflate stream of ops
+//     ADD  0x00 [len u32] [len bytes]             new bytes
+//     DIFF 0x01 [len u32] [src u32] [len bytes]   base[src + i] + byte (mod 256)
+//     END  0xFF
+// - The first byte ('B') can never start an app image (0xE9), which
+//   is how IdfUpdate tells the two apart
+// - Inflate (OtaInflate) needs the full 32 KB dictionary plus state;
+//   base reads go through a 4 KB buffer. All of it is allocated per
+//   update, in PSRAM when there is some
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "ota_inflate.h"
+
+class OtaDelta {
+public:
+    static constexpr size_t HEADER_BYTES = 80;
+    static constexpr uint8_t MAGIC[4] = { 'B', 'T', 'D', 'P' };
+    static constexpr uint8_t VERSION = 1;
+
+    ~OtaDelta() { end(); }
+
+    // base: the partition the patch was made against (the running app)
+    bool begin(const esp_partition_t* base) {
+        end();
+        m_baseBuf = (uint8_t*)heap_caps_malloc(BASE_CHUNK, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!m_baseBuf) m_baseBuf = (uint8_t*)heap_caps_malloc(BASE_CHUNK, MALLOC_CAP_8BIT);
+        if (!m_baseBuf || !m_inflate.begin(TINFL_LZ_DICT_SIZE)) {
+            ESP_LOGE(TAG, "No memory for delta OTA");
+            end();
+            return false;
+        }
+        m_base = base;
+        m_headerLen = 0;
+        m_state = S_OP;
+        m_produced = 0;
+        m_failed = false;
+        return true;
+    }
+
+    void end() {
+        if (m_baseBuf) heap_caps_free(m_baseBuf);
+        m_baseBuf = nullptr;
+        m_inflate.end();
+    }
+
+    bool active() const { return m_baseBuf != nullptr; }
+    bool headerReady() const { return m_headerLen == HEADER_BYTES; }
+    bool done() const { return m_state == S_DONE && m_produced == m_targetSize; }
+    uint32_t targetSize() const { return m_targetSize; }
+    const uint8_t* targetSha256() const { return m_header + 48; }
+
+    // Patch bytes in; target bytes out through sink(data, len), which
+    // returns false to stop. False on a bad patch or a base mismatch.
+    template <typename Sink>
+    bool feed(const uint8_t* data, size_t len, Sink&& sink) {
+        if (!m_baseBuf || m_failed) return false;
+
+        if (m_headerLen < HEADER_BYTES) {
+            size_t n = HEADER_BYTES - m_headerLen;
+            if (n > len) n = len;
+            memcpy(m_header + m_headerLen, data, n);
+            m_headerLen += n;
+            data += n;
+            len -= n;
+            if (m_headerLen < HEADER_BYTES) return true;
+            if (!checkHeader()) return fail();
+        }
+
+        if (m_state == S_DONE) return true;
+        const bool ok = m_inflate.feed(data, len, [&](const uint8_t* p, size_t n) {
+            return applyOps(p, n, sink);
+        });
+        return ok ? true : fail();
+    }
+
+private:
+    static constexpr const char* TAG = "OTA_DELTA";
+    static constexpr uint8_t OP_ADD = 0x00;
+    static constexpr uint8_t OP_DIFF = 0x01;
+    static constexpr uint8_t OP_END = 0xFF;
+    static constexpr size_t BASE_CHUNK = 4096;
+
+    enum State : uint8_t { S_OP, S_ARGS, S_DATA, S_DONE };
+
+    static uint32_t le32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    bool fail() {
+        m_failed = true;
+        return false;
+    }
+
+    bool checkHeader() {
+        if (memcmp(m_header, MAGIC, sizeof(MAGIC)) != 0 || m_header[4] != VERSION) {
+            ESP_LOGE(TAG, "Not a delta patch (version %u)", m_header[4]);
+            return false;
+        }
+        m_baseSize = le32(m_header + 8);
+        m_targetSize = le32(m_header + 12);
+        if (!m_base || m_baseSize > m_base->size) {
+            ESP_LOGE(TAG, "Base image does not fit the running partition");
+            return false;
+        }
+        uint8_t sha[32];
+        esp_err_t err = esp_partition_get_sha256(m_base, sha);
+        if (err != ESP_OK || memcmp(sha, m_header + 16, sizeof(sha)) != 0) {
+            ESP_LOGE(TAG, "Patch is for another base image (%s)", esp_err_to_name(err));
+            return false;
+        }
+        ESP_LOGI(TAG, "Delta OTA: base %u bytes from '%s', target %u bytes",
+                 (unsigned)m_baseSize, m_base->label, (unsigned)m_targetSize);
+        return true;
+    }
+
+    // Inflated op stream; may end anywhere inside an op
+    template <typename Sink>
+    bool applyOps(const uint8_t* p, size_t n, Sink& sink) {
+        while (n > 0) {
+            switch (m_state) {
+            case S_OP:
+                m_op = *p++;
+                n--;
+                if (m_op == OP_END) {
+                    m_state = S_DONE;
+                } else if (m_op == OP_ADD || m_op == OP_DIFF) {
+                    m_argLen = 0;
+                    m_state = S_ARGS;
+                } else {
+                    ESP_LOGE(TAG, "Bad op 0x%02X", m_op);
+                    return false;
+                }
+                break;
+
+            case S_ARGS: {
+                const size_t need = (m_op == OP_DIFF) ? 8 : 4;
+                size_t take = need - m_argLen;
+                if (take > n) take = n;
+                memcpy(m_args + m_argLen, p, take);
+                m_argLen += take;
+                p += take;
+                n -= take;
+                if (m_argLen < need) break;
+                m_left = le32(m_args);
+                m_src = (m_op == OP_DIFF) ? le32(m_args + 4) : 0;
+                if (m_left > m_targetSize - m_produced ||
+                    (m_op == OP_DIFF && (m_src > m_baseSize || m_left > m_baseSize - m_src))) {
+                    ESP_LOGE(TAG, "Op out of range");
+                    return false;
+                }
+                m_state = m_left ? S_DATA : S_OP;
+                break;
+            }
+
+            case S_DATA: {
+                size_t take = (m_left < n) ? m_left : n;
+                if (m_op == OP_ADD) {
+                    if (!sink(p, take)) return false;
+                } else if (!applyDiff(p, take, sink)) {
+                    return false;
+                }
+                m_produced += take;
+                m_left -= take;
+                p += take;
+                n -= take;
+                if (m_left == 0) m_state = S_OP;
+                break;
+            }
+
+            case S_DONE:
+                return true;        // Anything after END is ignored
+            }
+        }
+        return true;
+    }
+
+    template <typename Sink>
+    bool applyDiff(const uint8_t* diff, size_t n, Sink& sink) {
+        while (n > 0) {
+            const size_t take = (n < BASE_CHUNK) ? n : BASE_CHUNK;
+            uint8_t* b = m_baseBuf;
+            if (esp_partition_read(m_base, m_src, b, take) != ESP_OK) {
+                ESP_LOGE(TAG, "Base read failed at 0x%x", (unsigned)m_src);
+                return false;
+            }
+            for (size_t i = 0; i < take; i++) b[i] += diff[i];
+            if (!sink(b, take)) return false;
+            m_src += take;
+            diff += take;
+            n -= take;
+        }
+        return true;
+    }
+
+    OtaInflate m_inflate;
+    uint8_t* m_baseBuf = nullptr;
+    const esp_partition_t* m_base = nullptr;
+    uint8_t m_header[HEADER_BYTES];
+    size_t m_headerLen = 0;
+    uint32_t m_baseSize = 0;
+    uint32_t m_targetSize = 0;
+    State m_state = S_OP;
+    uint8_t m_op = 0;
+    uint8_t m_args[8];
+    size_t m_argLen = 0;
+    uint32_t m_left = 0;            // Bytes of the current op still to come
+    uint32_t m_src = 0;             // DIFF: base offset of the next byte
+    uint32_t m_produced = 0;        // Target bytes out so far
+    bool m_failed = false;
+};
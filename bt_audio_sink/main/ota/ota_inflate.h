@@ -0,0 +1,93 @@
+#pragma once
+
+// -----------------------------------------------------------
+// OTA Inflate - streaming raw-deflate decoder (ROM miniz tinfl) shared
+// by delta patches and compressed images
+// - The output ring doubles as the LZ dictionary, so it has to be at
+//   least the compressor's window: 32 KB for a default deflate stream,
+//   4 KB for one made with a 12-bit window
+// - Decoder state (~11 KB) and ring are one allocation per update, in
+//   PSRAM when there is some
+// - sink(data, len) receives inflated bytes in order and returns false
+//   to stop
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "miniz.h"
+
+class OtaInflate {
+public:
+    OtaInflate() = default;
+    OtaInflate(const OtaInflate&) = delete;
+    OtaInflate& operator=(const OtaInflate&) = delete;
+    ~OtaInflate() { end(); }
+
+    // dictBytes: power of two, at least the stream's window
+    bool begin(size_t dictBytes) {
+        end();
+        if (dictBytes == 0 || (dictBytes & (dictBytes - 1)) != 0 || dictBytes > TINFL_LZ_DICT_SIZE) {
+            return false;
+        }
+        const size_t bytes = sizeof(tinfl_decompressor) + dictBytes;
+        m_inflator = (tinfl_decompressor*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!m_inflator) m_inflator = (tinfl_decompressor*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+        if (!m_inflator) {
+            ESP_LOGE(TAG, "No memory for a %u byte inflate window", (unsigned)dictBytes);
+            return false;
+        }
+        tinfl_init(m_inflator);
+        m_dict = (uint8_t*)(m_inflator + 1);
+        m_dictBytes = dictBytes;
+        m_dictOfs = 0;
+        m_done = false;
+        return true;
+    }
+
+    void end() {
+        if (m_inflator) heap_caps_free(m_inflator);
+        m_inflator = nullptr;
+        m_dict = nullptr;
+    }
+
+    bool active() const { return m_inflator != nullptr; }
+
+    // The deflate stream has ended; later input is ignored
+    bool done() const { return m_done; }
+
+    template <typename Sink>
+    bool feed(const uint8_t* data, size_t len, Sink&& sink) {
+        if (!m_inflator) return false;
+        while (!m_done) {
+            size_t inBytes = len;
+            size_t outBytes = m_dictBytes - m_dictOfs;
+            const tinfl_status st = tinfl_decompress(m_inflator, data, &inBytes, m_dict, m_dict + m_dictOfs,
+                                                     &outBytes, TINFL_FLAG_HAS_MORE_INPUT);
+            data += inBytes;
+            len -= inBytes;
+            if (outBytes > 0) {
+                if (!sink(m_dict + m_dictOfs, outBytes)) return false;
+                m_dictOfs = (m_dictOfs + outBytes) & (m_dictBytes - 1);
+            }
+            if (st < 0) {
+                ESP_LOGE(TAG, "Stream does not inflate (%d)", (int)st);
+                return false;
+            }
+            if (st == TINFL_STATUS_DONE) m_done = true;
+            // Output left over (ring end) comes out on the next pass
+            else if (st != TINFL_STATUS_HAS_MORE_OUTPUT && len == 0) break;
+        }
+        return true;
+    }
+
+private:
+    static constexpr const char* TAG = "OTA_INFLATE";
+
+    tinfl_decompressor* m_inflator = nullptr;   // Ring follows it
+    uint8_t* m_dict = nullptr;
+    size_t m_dictBytes = 0;
+    size_t m_dictOfs = 0;
+    bool m_done = false;
+};
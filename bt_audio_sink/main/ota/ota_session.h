@@ -0,0 +1,57 @@
+#pragma once
+
+// -----------------------------------------------------------
+// OTA Session - where an interrupted update can pick up again
+// - One NVS record: the image's SHA-256 (sent with a resumable
+//   OTA_BEGIN), its size, the target slot and how many bytes of it
+//   are known to be in flash
+// - IdfUpdate saves it every APP_OTA_RESUME_CHECKPOINT bytes of a
+//   plain image, and drops it once the update ends, fails or is
+//   aborted; a dropped link or a reset leaves it in place
+// - A BEGIN for the same image, size and slot resumes at the saved
+//   offset instead of starting from zero
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "nvs.h"
+#include "esp_log.h"
+#include "../config/app_config.h"
+#include "ota_stream.h"
+
+struct OtaSession {
+    static constexpr uint8_t VERSION = 1;
+
+    uint8_t version = VERSION;
+    uint8_t sha256[OtaStream::DIGEST_BYTES] = {};
+    uint32_t size = 0;
+    uint32_t partition = 0;     // Flash address of the target slot
+    uint32_t committed = 0;     // Image bytes in flash
+
+    // False without a usable record
+    static bool load(OtaSession& s) {
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &h) != ESP_OK) return false;
+        size_t len = sizeof(s);
+        const esp_err_t err = nvs_get_blob(h, NVS_KEY_OTA_SESSION, &s, &len);
+        nvs_close(h);
+        return err == ESP_OK && len == sizeof(s) && s.version == VERSION;
+    }
+
+    static bool save(const OtaSession& s) {
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) return false;
+        esp_err_t err = nvs_set_blob(h, NVS_KEY_OTA_SESSION, &s, sizeof(s));
+        if (err == ESP_OK) err = nvs_commit(h);
+        nvs_close(h);
+        if (err != ESP_OK) ESP_LOGW("OTA_SESSION", "Checkpoint not saved: %s", esp_err_to_name(err));
+        return err == ESP_OK;
+    }
+
+    static void clear() {
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) return;
+        if (nvs_erase_key(h, NVS_KEY_OTA_SESSION) == ESP_OK) nvs_commit(h);
+        nvs_close(h);
+    }
+};
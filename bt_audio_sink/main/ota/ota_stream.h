@@ -0,0 +1,157 @@
+#pragma once
+
+// -----------------------------------------------------------
+// OTA Stream - decrypt / digest stage for firmware images, shared by
+// the BLE OTA path (IdfUpdate) and the recovery app's WiFi download
+// - Optional AES-256-CBC: the first 16 bytes of the stream are the
+//   IV, PKCS#7 padding is checked and stripped in finish()
+// - SHA-256 of the plaintext, i.e. of what goes to flash
+// - Whole runs of blocks (up to RUN_BYTES) go through one mbedtls
+//   call; mbedtls drives the ESP32 AES and SHA engines
+//   (CONFIG_MBEDTLS_HARDWARE_AES / _SHA), so per-call overhead, not
+//   the cipher, is what large runs save
+// - sink(data, len) receives plaintext in order and returns false to
+//   stop the stream
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mbedtls/aes.h"
+#include "mbedtls/sha256.h"
+
+class OtaStream {
+public:
+    static constexpr size_t BLOCK = 16;
+    static constexpr size_t KEY_BYTES = 32;
+    static constexpr size_t DIGEST_BYTES = 32;
+    static constexpr size_t RUN_BYTES = 4096;
+
+    OtaStream() = default;
+    OtaStream(const OtaStream&) = delete;
+    OtaStream& operator=(const OtaStream&) = delete;
+    ~OtaStream() { reset(); }
+
+    // key: AES-256 key, or nullptr for a plaintext stream (which needs
+    // no output buffer). False if the buffer cannot be had.
+    bool begin(const uint8_t* key = nullptr) {
+        reset();
+        if (key) {
+            m_out = (uint8_t*)malloc(BLOCK + RUN_BYTES);
+            if (!m_out) return false;
+        }
+        mbedtls_sha256_init(&m_sha);
+        mbedtls_sha256_starts(&m_sha, 0);
+        m_shaInit = true;
+        if (key) {
+            mbedtls_aes_init(&m_aes);
+            mbedtls_aes_setkey_dec(&m_aes, key, KEY_BYTES * 8);
+            m_aesInit = true;
+        }
+        m_ivLen = 0;
+        m_carryLen = 0;
+        m_held = false;
+        return true;
+    }
+
+    bool encrypted() const { return m_aesInit; }
+
+    template <typename Sink>
+    bool update(const uint8_t* data, size_t len, Sink&& sink) {
+        if (!m_shaInit) return false;
+        if (!m_aesInit) return emit(data, len, sink);
+
+        // IV first
+        while (m_ivLen < BLOCK && len > 0) {
+            m_iv[m_ivLen++] = *data++;
+            len--;
+        }
+
+        // Finish a block split across calls
+        if (m_carryLen > 0 && len > 0) {
+            size_t n = BLOCK - m_carryLen;
+            if (n > len) n = len;
+            memcpy(m_carry + m_carryLen, data, n);
+            m_carryLen += n;
+            data += n;
+            len -= n;
+            if (m_carryLen < BLOCK) return true;
+            m_carryLen = 0;
+            if (!decryptRun(m_carry, BLOCK, sink)) return false;
+        }
+
+        // Whole blocks straight from the input
+        while (len >= BLOCK) {
+            size_t n = len & ~(BLOCK - 1);
+            if (n > RUN_BYTES) n = RUN_BYTES;
+            if (!decryptRun(data, n, sink)) return false;
+            data += n;
+            len -= n;
+        }
+
+        memcpy(m_carry, data, len);
+        m_carryLen = len;
+        return true;
+    }
+
+    // Last plaintext (padding stripped) to sink, digest out; false if
+    // the ciphertext was not whole blocks or the padding is bad
+    template <typename Sink>
+    bool finish(Sink&& sink, uint8_t digest[DIGEST_BYTES]) {
+        if (!m_shaInit) return false;
+        bool ok = true;
+        if (m_aesInit) {
+            ok = m_carryLen == 0 && m_held;
+            if (ok) {
+                const uint8_t pad = m_out[BLOCK - 1];
+                ok = pad >= 1 && pad <= BLOCK;
+                for (size_t i = BLOCK - pad; ok && i < BLOCK; i++) ok = m_out[i] == pad;
+                if (ok) ok = emit(m_out, BLOCK - pad, sink);
+            }
+        }
+        mbedtls_sha256_finish(&m_sha, digest);
+        reset();
+        return ok;
+    }
+
+    void reset() {
+        if (m_shaInit) mbedtls_sha256_free(&m_sha);
+        if (m_aesInit) mbedtls_aes_free(&m_aes);
+        m_shaInit = false;
+        m_aesInit = false;
+        free(m_out);
+        m_out = nullptr;
+    }
+
+private:
+    // One run of ciphertext blocks. The last plaintext block is held
+    // back (m_out[0..16)) until more follows, as it may be padding.
+    template <typename Sink>
+    bool decryptRun(const uint8_t* in, size_t n, Sink&& sink) {
+        mbedtls_aes_crypt_cbc(&m_aes, MBEDTLS_AES_DECRYPT, n, m_iv, in, m_out + BLOCK);
+        const uint8_t* from = m_held ? m_out : m_out + BLOCK;
+        const size_t count = (m_held ? BLOCK : 0) + n - BLOCK;
+        if (count > 0 && !emit(from, count, sink)) return false;
+        memcpy(m_out, m_out + n, BLOCK);
+        m_held = true;
+        return true;
+    }
+
+    template <typename Sink>
+    bool emit(const uint8_t* data, size_t len, Sink&& sink) {
+        if (len == 0) return true;
+        mbedtls_sha256_update(&m_sha, data, len);
+        return sink(data, len);
+    }
+
+    mbedtls_sha256_context m_sha;
+    mbedtls_aes_context m_aes;
+    bool m_shaInit = false;
+    bool m_aesInit = false;
+    uint8_t m_iv[BLOCK];
+    size_t m_ivLen = 0;
+    uint8_t m_carry[BLOCK];
+    size_t m_carryLen = 0;
+    bool m_held = false;                    // m_out[0..16) holds a block
+    uint8_t* m_out = nullptr;               // Encrypted only: held block + run
+};
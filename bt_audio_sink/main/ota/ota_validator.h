@@ -0,0 +1,144 @@
+#pragma once
+
+// -----------------------------------------------------------
+// OTA Validator - post-update checks off the boot path
+// (APP_OTA_DEFERRED_VALIDATION)
+// - An image the bootloader started as pending verification boots
+//   like any other; validation starts only once the system is up
+// - First (APP_OTA_VALIDATE_IMAGE_HASH) the whole image is read back
+//   and its checksum and appended SHA-256 verified, as a work queue job
+// - Then the app's health check runs every CHECK_PERIOD_MS from an
+//   esp_timer; MAX_BAD failures in a row roll the update back, and
+//   APP_OTA_VALIDATE_MS of passing checks mark it valid
+// - A reset or crash before then also rolls back: the bootloader
+//   does not start a pending image twice
+// - The flash writes (otadata) run on the work queue, never in the
+//   timer callback
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_image_format.h"
+#include "../config/app_config.h"
+#include "../core/work_queue.h"
+
+class OtaValidator {
+public:
+    enum Health : uint8_t { HEALTH_OK, HEALTH_BAD };
+    using HealthFn = Health (*)();
+
+    static constexpr uint32_t CHECK_PERIOD_MS = 5000;
+    static constexpr uint32_t MAX_BAD = 3;
+
+    static OtaValidator& getInstance() {
+        static OtaValidator instance;
+        return instance;
+    }
+
+    // Once the system is up. False when the running image is not pending
+    // verification (nothing to do) or the checks could not be started.
+    bool begin(WorkQueue& work, HealthFn health) {
+        const esp_partition_t* running = esp_ota_get_running_partition();
+        esp_ota_img_states_t state;
+        if (!running || esp_ota_get_state_partition(running, &state) != ESP_OK ||
+            state != ESP_OTA_IMG_PENDING_VERIFY) {
+            return false;
+        }
+        m_work = &work;
+        m_health = health;
+        m_running = running;
+        ESP_LOGI(TAG, "Update pending verification, checking for %u s",
+                 (unsigned)(APP_OTA_VALIDATE_MS / 1000));
+        if (APP_OTA_VALIDATE_IMAGE_HASH) {
+            return queue(hashJob, "ota_hash");
+        }
+        return startChecks();
+    }
+
+private:
+    static constexpr const char* TAG = "OtaValidate";
+
+    OtaValidator() = default;
+
+    bool queue(WorkQueue::Job job, const char* name) {
+        if (m_work->run(job, this, name, 4096, 1, APP_CONTROL_CORE)) return true;
+        ESP_LOGE(TAG, "%s could not be queued, the update stays pending", name);
+        return false;
+    }
+
+    bool startChecks() {
+        esp_timer_create_args_t args = {};
+        args.callback = onCheck;
+        args.arg = this;
+        args.name = "ota_check";
+        if (!m_timer && esp_timer_create(&args, &m_timer) != ESP_OK) {
+            ESP_LOGE(TAG, "Health check timer failed, the update stays pending");
+            return false;
+        }
+        m_passedMs = 0;
+        m_bad = 0;
+        return esp_timer_start_periodic(m_timer, (uint64_t)CHECK_PERIOD_MS * 1000) == ESP_OK;
+    }
+
+    // Work queue: the image as written, then the health checks
+    static void hashJob(void* arg) {
+        OtaValidator* self = static_cast<OtaValidator*>(arg);
+        const esp_partition_pos_t pos = { self->m_running->address, self->m_running->size };
+        esp_image_metadata_t data;
+        const int64_t t0 = esp_timer_get_time();
+        const esp_err_t err = esp_image_verify(ESP_IMAGE_VERIFY_SILENT, &pos, &data);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Image verification failed (%s)", esp_err_to_name(err));
+            rollbackJob(self);
+            return;
+        }
+        ESP_LOGI(TAG, "Image verified, %u KB in %u ms", (unsigned)(data.image_len / 1024),
+                 (unsigned)((esp_timer_get_time() - t0) / 1000));
+        self->startChecks();
+    }
+
+    // esp_timer task: one health check
+    static void onCheck(void* arg) {
+        OtaValidator* self = static_cast<OtaValidator*>(arg);
+        if (self->m_health() == HEALTH_BAD) {
+            if (++self->m_bad < MAX_BAD) return;
+            ESP_LOGE(TAG, "Health check failed %u times in a row", (unsigned)MAX_BAD);
+            self->finish(rollbackJob, "ota_rollback");
+            return;
+        }
+        self->m_bad = 0;
+        self->m_passedMs += CHECK_PERIOD_MS;
+        if (self->m_passedMs >= APP_OTA_VALIDATE_MS) self->finish(markValidJob, "ota_valid");
+    }
+
+    void finish(WorkQueue::Job job, const char* name) {
+        esp_timer_stop(m_timer);
+        queue(job, name);
+    }
+
+    static void markValidJob(void*) {
+        const esp_err_t err = esp_ota_mark_app_valid_cancel_rollback();
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "OTA validated");
+        } else {
+            ESP_LOGE(TAG, "Marking the update valid failed: %s", esp_err_to_name(err));
+        }
+    }
+
+    static void rollbackJob(void*) {
+        ESP_LOGE(TAG, "Rolling back to the previous image");
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+        // Only returns when there is no image to go back to
+        ESP_LOGE(TAG, "No previous image, keeping this one");
+    }
+
+    WorkQueue* m_work = nullptr;
+    HealthFn m_health = nullptr;
+    const esp_partition_t* m_running = nullptr;
+    esp_timer_handle_t m_timer = nullptr;
+    uint32_t m_passedMs = 0;        // esp_timer task only
+    uint32_t m_bad = 0;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+// -----------------------------------------------------------
+// OTA Window - sequenced OTA chunks over write-without-response
+// - The phone numbers chunks (u16, wrapping) and keeps up to WINDOW
+//   of them in flight past the last acknowledged sequence number
+// - Chunks that arrive ahead of a missing one wait in a slot (one per
+//   sequence number in the window) and are delivered in order once
+//   the gap is filled
+// - Acknowledged every ACK_EVERY chunks delivered, and at once on the
+//   first chunk past a gap, a duplicate or a chunk outside the window,
+//   so the phone can go back to the first missing chunk
+// - Slots (WINDOW x MAX_CHUNK) live in PSRAM when there is some, only
+//   while an update runs
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "../config/app_config.h"
+
+class OtaWindow {
+public:
+    static constexpr int WINDOW = APP_OTA_WINDOW_CHUNKS;
+    static constexpr int ACK_EVERY = APP_OTA_ACK_EVERY;
+    static constexpr size_t MAX_CHUNK = 512;
+    static_assert(ACK_EVERY <= WINDOW, "ack interval longer than the window");
+
+    ~OtaWindow() { end(); }
+
+    bool begin() {
+        end();
+        const size_t bytes = (size_t)WINDOW * MAX_CHUNK;
+        m_slots = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!m_slots) m_slots = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+        if (!m_slots) return false;
+        memset(m_len, 0, sizeof(m_len));
+        m_next = 0;
+        m_sinceAck = 0;
+        m_ackDue = false;
+        m_gapReported = false;
+        return true;
+    }
+
+    void end() {
+        if (m_slots) heap_caps_free(m_slots);
+        m_slots = nullptr;
+    }
+
+    bool active() const { return m_slots != nullptr; }
+
+    // One chunk; in-order data (this chunk and any waiting behind it)
+    // goes to sink(data, len), which returns false when it cannot take
+    // it now. Returns false if the chunk was dropped.
+    template <typename Sink>
+    bool accept(uint16_t seq, const uint8_t* data, size_t len, Sink&& sink) {
+        if (!m_slots || len == 0 || len > MAX_CHUNK) return false;
+        const uint16_t ahead = (uint16_t)(seq - m_next);
+        if (ahead >= WINDOW) {
+            // Already delivered (a resend) or past the window
+            m_ackDue = true;
+            return false;
+        }
+        if (ahead > 0) {
+            if (!m_gapReported) {
+                m_gapReported = true;
+                m_ackDue = true;
+            }
+            const int slot = seq % WINDOW;
+            memcpy(m_slots + (size_t)slot * MAX_CHUNK, data, len);
+            m_len[slot] = (uint16_t)len;
+            return true;
+        }
+
+        if (!sink(data, len)) {
+            // No room downstream: the phone resends from m_next
+            m_ackDue = true;
+            return false;
+        }
+        m_len[seq % WINDOW] = 0;    // A copy left waiting after a refused drain
+        m_gapReported = false;
+        advance();
+        for (;;) {
+            const int slot = m_next % WINDOW;
+            if (m_len[slot] == 0) break;
+            if (!sink(m_slots + (size_t)slot * MAX_CHUNK, m_len[slot])) {
+                m_ackDue = true;
+                break;
+            }
+            m_len[slot] = 0;
+            advance();
+        }
+        return true;
+    }
+
+    // An acknowledgement (nextSeq()) should be sent now; clears the flag
+    bool takeAckDue() {
+        const bool due = m_ackDue;
+        m_ackDue = false;
+        return due;
+    }
+
+    // First sequence number not delivered yet
+    uint16_t nextSeq() const { return m_next; }
+
+private:
+    void advance() {
+        m_next++;
+        if (++m_sinceAck >= ACK_EVERY) {
+            m_sinceAck = 0;
+            m_ackDue = true;
+        }
+    }
+
+    uint8_t* m_slots = nullptr;
+    uint16_t m_len[WINDOW];     // 0 = slot empty
+    uint16_t m_next = 0;
+    int m_sinceAck = 0;
+    bool m_ackDue = false;
+    bool m_gapReported = false; // Ack sent for the current gap
+};
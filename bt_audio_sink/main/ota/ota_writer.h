@@ -0,0 +1,162 @@
+#pragma once
+
+// -----------------------------------------------------------
+// OTA Writer - flash writes off the BLE callback
+// - Received image bytes go into a staging ring (PSRAM when there is
+//   some) and a writer task feeds them to IdfUpdate, so sector erases
+//   and programming (tens of ms each) no longer hold up the Bluedroid
+//   task: reception and flash writing overlap
+// - One producer (the BLE callback) and one consumer (the writer
+//   task); positions only grow, the ring index is position % size
+// - credit() turns free ring space into the windowed OTA window; when
+//   it had to shrink, onSpace runs (writer task) once half the ring
+//   is free again so the phone can get a fresh ack
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "../config/app_config.h"
+#include "idf_update.h"
+
+class OtaWriter {
+public:
+    using SpaceCb = void (*)();
+
+    static constexpr size_t RING_BYTES = APP_OTA_STAGING_BYTES;
+    static_assert((RING_BYTES & (RING_BYTES - 1)) == 0, "staging ring must be a power of two");
+
+    // Ring and (first time) writer task; false leaves writes to the caller
+    bool begin(IdfUpdate* update, SpaceCb onSpace) {
+        end();
+        m_ring = (uint8_t*)heap_caps_malloc(RING_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!m_ring) m_ring = (uint8_t*)heap_caps_malloc(RING_BYTES, MALLOC_CAP_8BIT);
+        if (!m_ring) {
+            ESP_LOGW(TAG, "No memory for OTA staging");
+            return false;
+        }
+        m_update = update;
+        m_onSpace = onSpace;
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+        m_failed = false;
+        m_throttled = false;
+        if (!m_task) {
+            // Stack in internal RAM: flash writes run with the cache off
+            xTaskCreatePinnedToCore(taskEntry, "ota_wr", 4096, this, 5, &m_task, APP_CONTROL_CORE);
+        }
+        return m_task != nullptr;
+    }
+
+    // Drops anything not written yet and frees the ring
+    void end() {
+        if (!m_ring) return;
+        m_failed = true;            // Writer skips what is left
+        kick();
+        while (pending() > 0) vTaskDelay(pdMS_TO_TICKS(5));
+        heap_caps_free(m_ring);
+        m_ring = nullptr;
+    }
+
+    bool active() const { return m_ring != nullptr; }
+
+    // Write failed in the writer task (IdfUpdate has the error)
+    bool failed() const { return m_failed; }
+
+    size_t pending() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    size_t freeBytes() const { return RING_BYTES - pending(); }
+
+    // Producer: queues len bytes, waiting up to wait for room
+    bool push(const uint8_t* data, size_t len, TickType_t wait) {
+        if (!m_ring || len > RING_BYTES) return false;
+        const TickType_t start = xTaskGetTickCount();
+        while (freeBytes() < len) {
+            if (xTaskGetTickCount() - start >= wait) return false;
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+        const uint32_t head = m_head.load(std::memory_order_relaxed);
+        const size_t at = head % RING_BYTES;
+        const size_t first = (len < RING_BYTES - at) ? len : RING_BYTES - at;
+        memcpy(m_ring + at, data, first);
+        if (first < len) memcpy(m_ring, data + first, len - first);
+        m_head.store(head + (uint32_t)len, std::memory_order_release);
+        kick();
+        return true;
+    }
+
+    // Chunks of chunkBytes the ring can take, at most maxChunks
+    uint8_t credit(int maxChunks, size_t chunkBytes) {
+        size_t n = freeBytes() / chunkBytes;
+        if (n < (size_t)maxChunks) {
+            m_throttled = true;
+            return (uint8_t)n;
+        }
+        return (uint8_t)maxChunks;
+    }
+
+    // Waits until everything queued is in flash; false on timeout
+    bool drain(TickType_t wait) {
+        const TickType_t start = xTaskGetTickCount();
+        kick();
+        while (pending() > 0) {
+            if (xTaskGetTickCount() - start >= wait) return false;
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        return true;
+    }
+
+private:
+    static constexpr const char* TAG = "OTA_WR";
+    static constexpr size_t WRITE_BYTES = 4096;     // Per IdfUpdate::write, one sector
+
+    void kick() {
+        if (m_task) xTaskNotifyGive(m_task);
+    }
+
+    static void taskEntry(void* arg) {
+        OtaWriter* self = static_cast<OtaWriter*>(arg);
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            self->writeQueued();
+        }
+    }
+
+    void writeQueued() {
+        for (;;) {
+            const uint32_t head = m_head.load(std::memory_order_acquire);
+            const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+            if (head == tail) return;
+
+            const size_t at = tail % RING_BYTES;
+            size_t n = head - tail;
+            if (n > RING_BYTES - at) n = RING_BYTES - at;
+            if (n > WRITE_BYTES) n = WRITE_BYTES;
+            if (!m_failed && m_update->write(m_ring + at, n) != n) {
+                ESP_LOGE(TAG, "Flash write failed: %s", m_update->errorString());
+                m_failed = true;
+            }
+            m_tail.store(tail + (uint32_t)n, std::memory_order_release);
+
+            if (m_throttled && freeBytes() >= RING_BYTES / 2) {
+                m_throttled = false;
+                if (m_onSpace && !m_failed) m_onSpace();
+            }
+        }
+    }
+
+    uint8_t* m_ring = nullptr;
+    IdfUpdate* m_update = nullptr;
+    SpaceCb m_onSpace = nullptr;
+    TaskHandle_t m_task = nullptr;
+    std::atomic<uint32_t> m_head{0};    // Producer: bytes queued
+    std::atomic<uint32_t> m_tail{0};    // Writer: bytes written
+    volatile bool m_failed = false;
+    volatile bool m_throttled = false;  // A credit was cut short
+};
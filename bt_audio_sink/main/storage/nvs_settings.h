@@ -2,17 +2,38 @@
 
 // -----------------------------------------------------------
 // NVS Settings - persistent storage for device configuration
+// Scalar settings, the LED ones included, live in RAM and go to flash
+// as one packed blob (NVS_KEY_SETTINGS) through SettingsWriter, a few
+// seconds after the last change. Boot reads just that blob; a
+// commit replaces the whole set at once.
+// Blob v3, little-endian:
+//   [version, ctrl, eq bass, eq mid, eq treble,
+//    flags (bit0 sound muted, bit1 3D sound, bit2 LED settings valid,
+//           bits3-4 latency profile, bit5 binaural 3D),
+//    dynamics preset (see MultibandDynamics),
+//    LED settings (LED_SETTINGS_LEN, see LedController),
+//    name len, name..., crc32 of everything before it]
+// v2 is the same without the dynamics byte; it loads with the default.
+// With no valid blob the per-key values of older firmware (and its
+// "led" namespace blob) are read once and saved as a blob.
 // -----------------------------------------------------------
 
 #include <string>
 #include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "esp_log.h"
+#include "esp_rom_crc.h"
 #include "../config/app_config.h"
+#include "settings_writer.h"
 
 class NVSSettings {
 public:
+    static constexpr size_t LED_SETTINGS_LEN = 10;
+
     // Settings structure
     struct Settings {
         std::string deviceName;
@@ -20,6 +41,13 @@ public:
         int8_t eqBassDB;
         int8_t eqMidDB;
         int8_t eqTrebleDB;
+        bool soundMuted;
+        bool sound3D;
+        bool sound3DBinaural;     // 3D kind: binaural, else stage presence
+        bool haveLed;             // ledSettings came from flash or the LED controller
+        uint8_t latencyProfile;   // LatencyProfileId
+        uint8_t dynamicsPreset;   // MultibandDynamics::Preset
+        uint8_t ledSettings[LED_SETTINGS_LEN];
 
         Settings() 
             : deviceName(APP_DEFAULT_DEVICE_NAME)
@@ -27,10 +55,19 @@ public:
             , eqBassDB(0)
             , eqMidDB(0)
             , eqTrebleDB(0) 
+            , soundMuted(false)
+            , sound3D(false)
+            , sound3DBinaural(false)
+            , haveLed(false)
+            , latencyProfile(0)
+            , dynamicsPreset(APP_DSP_DYNAMICS_DEFAULT)
+            , ledSettings{}
         {}
     };
 
-    NVSSettings() {}
+    NVSSettings() {
+        m_lock = xSemaphoreCreateMutex();
+    }
 
     // Load all settings from NVS (stores internally)
     bool load() {
@@ -51,7 +88,9 @@ public:
     }
 
     void getDeviceName(std::string &name) const {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
         name = m_settings.deviceName;
+        xSemaphoreGive(m_lock);
     }
 
     // Save control flags
@@ -60,7 +99,6 @@ public:
         if (bassBoost) ctrl |= 0x01;
         if (channelFlip) ctrl |= 0x02;
         if (bypass) ctrl |= 0x04;
-        m_settings.controlByte = ctrl;
         return saveControl(ctrl);
     }
 
@@ -74,6 +112,21 @@ public:
             return false;
         }
 
+        uint8_t blob[BLOB_MAX];
+        size_t blobLen = sizeof(blob);
+        err = nvs_get_blob(h, NVS_KEY_SETTINGS, blob, &blobLen);
+        if (err == ESP_OK && unpack(blob, blobLen, settings)) {
+            nvs_close(h);
+            // Already on flash; staged so later changes compare against it
+            SettingsWriter::getInstance().stage(NVS_NAMESPACE, NVS_KEY_SETTINGS, blob, blobLen);
+            logLoaded(settings);
+            return true;
+        }
+        if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGW(TAG, "Settings blob unusable (%s), reading legacy keys", esp_err_to_name(err));
+        }
+
+        // Per-key values from older firmware
         // Device name
         char buf[32];
         size_t len = sizeof(buf);
@@ -96,124 +149,338 @@ public:
         if (nvs_get_i8(h, NVS_KEY_EQ_MID, &m) == ESP_OK) settings.eqMidDB = m;
         if (nvs_get_i8(h, NVS_KEY_EQ_TREB, &t) == ESP_OK) settings.eqTrebleDB = t;
 
+        uint8_t u8 = 0;
+        if (nvs_get_u8(h, "sound_muted", &u8) == ESP_OK) settings.soundMuted = u8 != 0;
+        if (nvs_get_u8(h, "3d_sound", &u8) == ESP_OK) settings.sound3D = u8 != 0;
+
         nvs_close(h);
 
-        ESP_LOGI(TAG, "NVS loaded: name='%s', ctrl=0x%02x, EQ(b,m,t)=(%d,%d,%d)",
-                 settings.deviceName.c_str(), settings.controlByte,
-                 settings.eqBassDB, settings.eqMidDB, settings.eqTrebleDB);
+        // LED controller's own blob; its byte 9 replaces the old
+        // "led_effect" key
+        if (nvs_open("led", NVS_READONLY, &h) == ESP_OK) {
+            size_t ledLen = LED_SETTINGS_LEN;
+            settings.haveLed = nvs_get_blob(h, "settings", settings.ledSettings, &ledLen) == ESP_OK &&
+                               ledLen == LED_SETTINGS_LEN;
+            nvs_close(h);
+        }
+
+        // Migrated: the blob replaces these from the next boot on
+        blobLen = pack(settings, blob);
+        SettingsWriter::getInstance().stage(NVS_NAMESPACE, NVS_KEY_SETTINGS, blob, blobLen);
+        ESP_LOGI(TAG, "Migrating legacy settings keys to one blob");
+        logLoaded(settings);
         return true;
     }
 
     // Save control byte
     bool saveControl(uint8_t ctrl) {
-        nvs_handle_t h;
-        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) return false;
-        nvs_set_u8(h, NVS_KEY_CTRL, ctrl);
-        nvs_commit(h);
-        nvs_close(h);
-        return true;
+        return update([&](Settings& s) { s.controlByte = ctrl; });
     }
 
     // Save EQ settings
     bool saveEQ(int8_t bass, int8_t mid, int8_t treble) {
+        return update([&](Settings& s) {
+            s.eqBassDB = bass;
+            s.eqMidDB = mid;
+            s.eqTrebleDB = treble;
+        });
+    }
+
+    // Save device name
+    bool saveDeviceName(const std::string &name) {
+        return update([&](Settings& s) { s.deviceName = name; });
+    }
+    
+    bool saveDeviceName(const char* name) {
+        return saveDeviceName(std::string(name));
+    }
+
+    // Parametric EQ bands (opaque blob, see ParametricEq::serialize)
+    bool loadPeq(uint8_t* blob, size_t &len) {
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &h) != ESP_OK) return false;
+        esp_err_t err = nvs_get_blob(h, NVS_KEY_PEQ, blob, &len);
+        nvs_close(h);
+        return err == ESP_OK;
+    }
+
+    bool savePeq(const uint8_t* blob, size_t len) {
         nvs_handle_t h;
         if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) {
-            ESP_LOGE(TAG, "saveEQ: NVS open failed!");
+            ESP_LOGE(TAG, "savePeq: NVS open failed!");
             return false;
         }
-        nvs_set_i8(h, NVS_KEY_EQ_BASS, bass);
-        nvs_set_i8(h, NVS_KEY_EQ_MID, mid);
-        nvs_set_i8(h, NVS_KEY_EQ_TREB, treble);
+        nvs_set_blob(h, NVS_KEY_PEQ, blob, len);
         esp_err_t err = nvs_commit(h);
         nvs_close(h);
-        
-        // Update in-memory cache
-        m_settings.eqBassDB = bass;
-        m_settings.eqMidDB = mid;
-        m_settings.eqTrebleDB = treble;
-        
-        ESP_LOGI(TAG, "saveEQ: saved EQ(%d,%d,%d) to NVS, commit=%s", 
-                 bass, mid, treble, esp_err_to_name(err));
         return err == ESP_OK;
     }
 
-    // Save device name
-    bool saveDeviceName(const std::string &name) {
-        m_settings.deviceName = name;
+    // DSP preset bank (opaque blob, see DspPresetBank::serialize)
+    bool loadPresets(uint8_t* blob, size_t &len) {
         nvs_handle_t h;
-        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) return false;
-        nvs_set_str(h, NVS_KEY_DEVNAME, name.c_str());
-        nvs_commit(h);
+        if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &h) != ESP_OK) return false;
+        esp_err_t err = nvs_get_blob(h, NVS_KEY_PRESETS, blob, &len);
         nvs_close(h);
-        return true;
+        return err == ESP_OK;
     }
-    
-    bool saveDeviceName(const char* name) {
-        return saveDeviceName(std::string(name));
+
+    bool savePresets(const uint8_t* blob, size_t len) {
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) {
+            ESP_LOGE(TAG, "savePresets: NVS open failed!");
+            return false;
+        }
+        nvs_set_blob(h, NVS_KEY_PRESETS, blob, len);
+        esp_err_t err = nvs_commit(h);
+        nvs_close(h);
+        return err == ESP_OK;
     }
 
-    // Load LED effect from NVS
-    uint8_t loadLedEffect() {
+    // Codec policy peer records (opaque blob, see CodecPolicy::serialize)
+    bool loadCodecPolicy(uint8_t* blob, size_t &len) {
         nvs_handle_t h;
-        if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &h) != ESP_OK) return 0;
-        uint8_t effect = 0;
-        nvs_get_u8(h, "led_effect", &effect);
+        if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &h) != ESP_OK) return false;
+        esp_err_t err = nvs_get_blob(h, NVS_KEY_CODEC_POLICY, blob, &len);
         nvs_close(h);
-        return effect;
+        return err == ESP_OK;
     }
 
-    // Save LED effect to NVS
-    bool saveLedEffect(uint8_t effect) {
+    bool saveCodecPolicy(const uint8_t* blob, size_t len) {
         nvs_handle_t h;
-        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) return false;
-        nvs_set_u8(h, "led_effect", effect);
-        nvs_commit(h);
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) {
+            ESP_LOGE(TAG, "saveCodecPolicy: NVS open failed!");
+            return false;
+        }
+        nvs_set_blob(h, NVS_KEY_CODEC_POLICY, blob, len);
+        esp_err_t err = nvs_commit(h);
         nvs_close(h);
-        return true;
+        return err == ESP_OK;
     }
 
-    // Load sound muted state from NVS
-    bool loadSoundMuted() {
+    // Aux output slot roles [left, right] (see OutputMatrix)
+    bool loadOutputLayout(uint8_t layout[2]) {
         nvs_handle_t h;
         if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &h) != ESP_OK) return false;
-        uint8_t muted = 0;
-        nvs_get_u8(h, "sound_muted", &muted);
+        size_t len = 2;
+        esp_err_t err = nvs_get_blob(h, NVS_KEY_OUT_LAYOUT, layout, &len);
         nvs_close(h);
-        return muted != 0;
+        return err == ESP_OK && len == 2;
     }
 
-    // Save sound muted state to NVS
-    bool saveSoundMuted(bool muted) {
+    bool saveOutputLayout(const uint8_t layout[2]) {
         nvs_handle_t h;
-        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) return false;
-        nvs_set_u8(h, "sound_muted", muted ? 1 : 0);
-        nvs_commit(h);
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) {
+            ESP_LOGE(TAG, "saveOutputLayout: NVS open failed!");
+            return false;
+        }
+        nvs_set_blob(h, NVS_KEY_OUT_LAYOUT, layout, 2);
+        esp_err_t err = nvs_commit(h);
         nvs_close(h);
-        return true;
+        return err == ESP_OK;
     }
 
-    // Load 3D sound enabled state from NVS
-    bool load3DSound() {
+    // DSP stage order (opaque blob, see DspGraph::serialize)
+    bool loadDspGraph(uint8_t* blob, size_t &len) {
         nvs_handle_t h;
         if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &h) != ESP_OK) return false;
-        uint8_t enabled = 0;
-        nvs_get_u8(h, "3d_sound", &enabled);
+        esp_err_t err = nvs_get_blob(h, NVS_KEY_DSP_GRAPH, blob, &len);
         nvs_close(h);
-        return enabled != 0;
+        return err == ESP_OK;
     }
 
-    // Save 3D sound enabled state to NVS
-    bool save3DSound(bool enabled) {
+    bool saveDspGraph(const uint8_t* blob, size_t len) {
         nvs_handle_t h;
-        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) return false;
-        nvs_set_u8(h, "3d_sound", enabled ? 1 : 0);
-        nvs_commit(h);
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) {
+            ESP_LOGE(TAG, "saveDspGraph: NVS open failed!");
+            return false;
+        }
+        nvs_set_blob(h, NVS_KEY_DSP_GRAPH, blob, len);
+        esp_err_t err = nvs_commit(h);
         nvs_close(h);
-        ESP_LOGI(TAG, "save3DSound: saved %s to NVS", enabled ? "ON" : "OFF");
-        return true;
+        return err == ESP_OK;
+    }
+
+    // Last stream format per peer (opaque blob, see PeerStreamCache::serialize)
+    bool loadPeerStreams(uint8_t* blob, size_t &len) {
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &h) != ESP_OK) return false;
+        esp_err_t err = nvs_get_blob(h, NVS_KEY_PEER_STREAMS, blob, &len);
+        nvs_close(h);
+        return err == ESP_OK;
+    }
+
+    bool savePeerStreams(const uint8_t* blob, size_t len) {
+        nvs_handle_t h;
+        if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &h) != ESP_OK) {
+            ESP_LOGE(TAG, "savePeerStreams: NVS open failed!");
+            return false;
+        }
+        nvs_set_blob(h, NVS_KEY_PEER_STREAMS, blob, len);
+        esp_err_t err = nvs_commit(h);
+        nvs_close(h);
+        return err == ESP_OK;
+    }
+
+    // LED controller settings (see LedController::setPersistence); false
+    // when nothing was ever saved, so the controller keeps its defaults
+    bool getLedSettings(uint8_t out[LED_SETTINGS_LEN]) const {
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        const bool have = m_settings.haveLed;
+        memcpy(out, m_settings.ledSettings, LED_SETTINGS_LEN);
+        xSemaphoreGive(m_lock);
+        return have;
+    }
+
+    bool saveLedSettings(const uint8_t* data, size_t len) {
+        if (len != LED_SETTINGS_LEN) return false;
+        return update([&](Settings& s) {
+            memcpy(s.ledSettings, data, LED_SETTINGS_LEN);
+            s.haveLed = true;
+        });
+    }
+
+    // LED effect: byte 9 of the LED settings (from load())
+    uint8_t loadLedEffect() const {
+        return m_settings.haveLed ? m_settings.ledSettings[9] : 0;
+    }
+
+    // The LED controller saves its whole set on an effect change; this
+    // only keeps the cached copy in step until it does
+    bool saveLedEffect(uint8_t effect) {
+        return update([&](Settings& s) {
+            if (s.haveLed) s.ledSettings[9] = effect;
+        });
+    }
+
+    // Sound muted state (from load())
+    bool loadSoundMuted() const {
+        return m_settings.soundMuted;
+    }
+
+    bool saveSoundMuted(bool muted) {
+        return update([&](Settings& s) { s.soundMuted = muted; });
+    }
+
+    // 3D sound enabled state (from load())
+    bool load3DSound() const {
+        return m_settings.sound3D;
+    }
+
+    bool save3DSound(bool enabled) {
+        return update([&](Settings& s) { s.sound3D = enabled; });
+    }
+
+    // 3D kind, kept while 3D is off (from load())
+    bool load3DBinaural() const {
+        return m_settings.sound3DBinaural;
+    }
+
+    bool save3DBinaural(bool binaural) {
+        return update([&](Settings& s) { s.sound3DBinaural = binaural; });
+    }
+
+    // Latency profile (from load())
+    uint8_t loadLatencyProfile() const {
+        return m_settings.latencyProfile;
+    }
+
+    bool saveLatencyProfile(uint8_t profile) {
+        return update([&](Settings& s) { s.latencyProfile = profile & 0x03; });
+    }
+
+    // Multiband dynamics preset (from load())
+    uint8_t loadDynamicsPreset() const {
+        return m_settings.dynamicsPreset;
+    }
+
+    bool saveDynamicsPreset(uint8_t preset) {
+        return update([&](Settings& s) { s.dynamicsPreset = preset; });
     }
 
 private:
     static constexpr const char* TAG = "NVS";
+    static constexpr uint8_t BLOB_VERSION = 3;
+    static constexpr size_t OFS_DYNAMICS = 6;
+    static constexpr size_t OFS_LED = 7;
+    static constexpr size_t OFS_NAME_LEN = OFS_LED + LED_SETTINGS_LEN;
+    static constexpr size_t BLOB_HEADER = OFS_NAME_LEN + 1;
+    static constexpr size_t DEVICE_NAME_MAX = 31;
+    static constexpr size_t CRC_LEN = 4;
+    static constexpr size_t BLOB_MAX = BLOB_HEADER + DEVICE_NAME_MAX + CRC_LEN;
+    static_assert(BLOB_MAX <= SettingsWriter::MAX_BLOB, "settings blob outgrew the writer slot");
+
+    // Change the cached settings and stage the packed blob
+    template <typename Fn>
+    bool update(Fn&& fn) {
+        uint8_t blob[BLOB_MAX];
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        fn(m_settings);
+        const size_t len = pack(m_settings, blob);
+        xSemaphoreGive(m_lock);
+        return SettingsWriter::getInstance().stage(NVS_NAMESPACE, NVS_KEY_SETTINGS, blob, len);
+    }
+
+    static size_t pack(const Settings& s, uint8_t* out) {
+        size_t nameLen = s.deviceName.size();
+        if (nameLen > DEVICE_NAME_MAX) nameLen = DEVICE_NAME_MAX;
+        out[0] = BLOB_VERSION;
+        out[1] = s.controlByte;
+        out[2] = (uint8_t)s.eqBassDB;
+        out[3] = (uint8_t)s.eqMidDB;
+        out[4] = (uint8_t)s.eqTrebleDB;
+        out[5] = (s.soundMuted ? 0x01 : 0) | (s.sound3D ? 0x02 : 0) | (s.haveLed ? 0x04 : 0) |
+                 (uint8_t)((s.latencyProfile & 0x03) << 3) | (s.sound3DBinaural ? 0x20 : 0);
+        out[OFS_DYNAMICS] = s.dynamicsPreset;
+        memcpy(out + OFS_LED, s.ledSettings, LED_SETTINGS_LEN);
+        out[OFS_NAME_LEN] = (uint8_t)nameLen;
+        memcpy(out + BLOB_HEADER, s.deviceName.data(), nameLen);
+        const size_t len = BLOB_HEADER + nameLen;
+        const uint32_t crc = esp_rom_crc32_le(0, out, len);
+        for (size_t i = 0; i < CRC_LEN; i++) out[len + i] = (uint8_t)(crc >> (8 * i));
+        return len + CRC_LEN;
+    }
+
+    static bool unpack(const uint8_t* in, size_t len, Settings& s) {
+        // v2: no dynamics byte, everything after it one earlier
+        const size_t shift = (len > 0 && in[0] == 2) ? 1 : 0;
+        const size_t header = BLOB_HEADER - shift;
+        const size_t ofsName = OFS_NAME_LEN - shift;
+        if (len < header + CRC_LEN || (in[0] != BLOB_VERSION && !shift) ||
+            len != header + in[ofsName] + CRC_LEN) {
+            ESP_LOGW(TAG, "Settings blob not understood (%u bytes, v%u)", (unsigned)len, len ? in[0] : 0);
+            return false;
+        }
+        const size_t body = len - CRC_LEN;
+        const uint32_t crc = in[body] | (in[body + 1] << 8) | (in[body + 2] << 16) | ((uint32_t)in[body + 3] << 24);
+        if (esp_rom_crc32_le(0, in, body) != crc) {
+            ESP_LOGW(TAG, "Settings blob CRC mismatch");
+            return false;
+        }
+        s.controlByte = in[1];
+        s.eqBassDB = (int8_t)in[2];
+        s.eqMidDB = (int8_t)in[3];
+        s.eqTrebleDB = (int8_t)in[4];
+        s.soundMuted = (in[5] & 0x01) != 0;
+        s.sound3D = (in[5] & 0x02) != 0;
+        s.haveLed = (in[5] & 0x04) != 0;
+        s.latencyProfile = (in[5] >> 3) & 0x03;
+        s.sound3DBinaural = (in[5] & 0x20) != 0;
+        s.dynamicsPreset = shift ? APP_DSP_DYNAMICS_DEFAULT : in[OFS_DYNAMICS];
+        memcpy(s.ledSettings, in + OFS_LED - shift, LED_SETTINGS_LEN);
+        if (in[ofsName] > 0) {
+            s.deviceName.assign((const char*)in + header, in[ofsName]);
+        } else {
+            s.deviceName = APP_DEFAULT_DEVICE_NAME;
+        }
+        return true;
+    }
+
+    static void logLoaded(const Settings& s) {
+        ESP_LOGI(TAG, "NVS loaded: name='%s', ctrl=0x%02x, EQ(b,m,t)=(%d,%d,%d)",
+                 s.deviceName.c_str(), s.controlByte, s.eqBassDB, s.eqMidDB, s.eqTrebleDB);
+    }
+
+    SemaphoreHandle_t m_lock = nullptr;    // m_settings, written from several tasks
     Settings m_settings;
 };
@@ -0,0 +1,163 @@
+#pragma once
+
+// -----------------------------------------------------------
+// Settings Writer - write-back cache in front of NVS
+// - Callers stage a whole blob per (namespace, key); nothing touches
+//   flash until APP_SETTINGS_WRITE_DELAY_MS after the last change, so a
+//   knob being turned costs one commit instead of one per detent
+// - One writer task commits every dirty blob, one nvs_commit per
+//   namespace
+// - requestFlush() skips the wait (disconnect); flush() writes from the
+//   caller, and runs as a shutdown handler so esp_restart() loses nothing
+// -----------------------------------------------------------
+
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "../config/app_config.h"
+#include "../core/static_alloc.h"
+
+class SettingsWriter {
+public:
+    static constexpr int MAX_SLOTS = 4;
+    static constexpr size_t MAX_BLOB = 64;
+
+    static SettingsWriter& getInstance() {
+        static SettingsWriter instance;
+        return instance;
+    }
+
+    // Writer task; changes staged before this are written on its first pass
+    void begin(int core) {
+        if (m_task) return;
+        StaticAlloc::createTask(writerTask, "nvs_wb", 3072, this, 1, &m_task, core);
+        esp_register_shutdown_handler(onShutdown);
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        bool dirty = false;
+        for (int i = 0; i < m_numSlots; i++) dirty = dirty || m_slots[i].dirty;
+        xSemaphoreGive(m_lock);
+        if (dirty) xTaskNotify(m_task, EVT_CHANGED, eSetBits);
+    }
+
+    // Copy of the blob to write; unchanged content is not rewritten
+    bool stage(const char* ns, const char* key, const void* data, size_t len) {
+        if (len > MAX_BLOB) return false;
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        Slot* slot = find(ns, key);
+        const bool changed = slot && (slot->len != len || memcmp(slot->data, data, len) != 0);
+        if (changed) {
+            memcpy(slot->data, data, len);
+            slot->len = len;
+            slot->dirty = true;
+        }
+        xSemaphoreGive(m_lock);
+        if (!slot) {
+            ESP_LOGE(TAG, "No slot for %s/%s", ns, key);
+            return false;
+        }
+        if (changed && m_task) xTaskNotify(m_task, EVT_CHANGED, eSetBits);
+        return true;
+    }
+
+    // Write now from the writer task (does not wait for it)
+    void requestFlush() {
+        if (m_task) xTaskNotify(m_task, EVT_FLUSH, eSetBits);
+    }
+
+    // Write every dirty blob from the calling task
+    void flush() {
+        xSemaphoreTake(m_flushLock, portMAX_DELAY);
+        Slot pending[MAX_SLOTS];
+        int n = 0;
+        xSemaphoreTake(m_lock, portMAX_DELAY);
+        for (int i = 0; i < m_numSlots; i++) {
+            if (!m_slots[i].dirty) continue;
+            pending[n++] = m_slots[i];
+            m_slots[i].dirty = false;       // Staged again meanwhile = dirty again
+        }
+        xSemaphoreGive(m_lock);
+
+        for (int i = 0; i < n; i++) {
+            if (!pending[i].ns) continue;   // Written with an earlier slot's namespace
+            nvs_handle_t h;
+            esp_err_t err = nvs_open(pending[i].ns, NVS_READWRITE, &h);
+            if (err == ESP_OK) {
+                for (int j = i; j < n; j++) {
+                    if (!pending[j].ns || strcmp(pending[j].ns, pending[i].ns) != 0) continue;
+                    if (err == ESP_OK) err = nvs_set_blob(h, pending[j].key, pending[j].data, pending[j].len);
+                    if (j != i) pending[j].ns = nullptr;
+                }
+                if (err == ESP_OK) err = nvs_commit(h);
+                nvs_close(h);
+            }
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Commit to '%s' failed: %s", pending[i].ns, esp_err_to_name(err));
+            } else {
+                ESP_LOGI(TAG, "Committed '%s'", pending[i].ns);
+            }
+        }
+        xSemaphoreGive(m_flushLock);
+    }
+
+private:
+    static constexpr const char* TAG = "NVS_WB";
+
+    enum : uint32_t {
+        EVT_CHANGED = 0x01,
+        EVT_FLUSH   = 0x02,
+    };
+
+    struct Slot {
+        const char* ns;             // String literals, compared by content
+        const char* key;
+        uint8_t data[MAX_BLOB];
+        size_t len;
+        bool dirty;
+    };
+
+    SettingsWriter() {
+        m_lock = xSemaphoreCreateMutex();
+        m_flushLock = xSemaphoreCreateMutex();
+    }
+
+    Slot* find(const char* ns, const char* key) {
+        for (int i = 0; i < m_numSlots; i++) {
+            if (strcmp(m_slots[i].ns, ns) == 0 && strcmp(m_slots[i].key, key) == 0) return &m_slots[i];
+        }
+        if (m_numSlots == MAX_SLOTS) return nullptr;
+        Slot* slot = &m_slots[m_numSlots++];
+        slot->ns = ns;
+        slot->key = key;
+        slot->len = 0;
+        slot->dirty = false;
+        return slot;
+    }
+
+    static void writerTask(void* arg) {
+        SettingsWriter* self = static_cast<SettingsWriter*>(arg);
+        uint32_t events = 0;
+        while (true) {
+            xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+            // Every further change restarts the wait
+            while (!(events & EVT_FLUSH) &&
+                   xTaskNotifyWait(0, UINT32_MAX, &events, pdMS_TO_TICKS(APP_SETTINGS_WRITE_DELAY_MS)) == pdTRUE) {
+            }
+            self->flush();
+        }
+    }
+
+    static void onShutdown() {
+        getInstance().flush();
+    }
+
+    SemaphoreHandle_t m_lock = nullptr;         // Slots
+    SemaphoreHandle_t m_flushLock = nullptr;    // One flush at a time
+    TaskHandle_t m_task = nullptr;
+    Slot m_slots[MAX_SLOTS];
+    int m_numSlots = 0;
+};
@@ -6,7 +6,10 @@
  * - WiFi AP mode with captive portal for configuration
  * - Professional web UI for WiFi setup and OTA
  * - Encrypted OTA from Google Drive (AES-256-CBC)
- * - Streaming download+flash (no full download required)
+ * - Streaming download+flash (no full download required): the HTTP
+ *   reader and the decrypt/flash writer run as separate tasks, the
+ *   writer erasing ahead while it waits, and a dropped connection is
+ *   resumed with a Range request
  * - Automatic boot to main partition after power cycle
  */
 
@@ -20,11 +23,14 @@
 extern "C" {
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_ota_ops.h"
 #include "esp_partition.h"
+#include "spi_flash_mmap.h"
 #include "esp_timer.h"
 #include "nvs_flash.h"
 #include "nvs.h"
@@ -46,6 +52,11 @@ extern "C" {
 #include "esp_heap_caps.h"
 }
 
+// Decrypt / digest stage shared with the main app's OTA path
+#include "ota_stream.h"
+// Fleet report hand-off from the main app (maintenance boot)
+#include "fleet_report.h"
+
 static const char* TAG = "RECOVERY";
 
 // ============================================================
@@ -344,8 +355,7 @@ static const uint8_t AES_KEY[32] = {
 };
 
 // IV will be read from the first 16 bytes of encrypted firmware
-static const size_t AES_BLOCK_SIZE = 16;
-static const size_t AES_KEY_SIZE = 32;
+static_assert(sizeof(AES_KEY) == OtaStream::KEY_BYTES, "AES-256 key expected");
 
 // ============================================================
 // State Management
@@ -353,6 +363,7 @@ static const size_t AES_KEY_SIZE = 32;
 static EventGroupHandle_t s_wifi_event_group;
 static const int WIFI_CONNECTED_BIT = BIT0;
 static const int WIFI_FAIL_BIT = BIT1;
+static const int WEB_START_BIT = BIT2;     // First client: bring up DNS + httpd
 
 static httpd_handle_t s_server = NULL;
 static bool s_wifi_connected = false;
@@ -476,638 +487,29 @@ static void stop_dns_server() {
 }
 
 // ============================================================
-// HTML/CSS/JS for Web UI
+// Web UI assets
 // ============================================================
-static const char* HTML_HEADER = R"rawliteral(
-<!DOCTYPE html>
-<html lang="en">
-<head>
-    <meta charset="UTF-8">
-    <meta name="viewport" content="width=device-width, initial-scale=1.0">
-    <title>ESP32 Recovery Mode</title>
-    <style>
-        * {
-            margin: 0;
-            padding: 0;
-            box-sizing: border-box;
-        }
-        
-        body {
-            font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif;
-            background: linear-gradient(135deg, #1a1a2e 0%, #16213e 50%, #0f3460 100%);
-            min-height: 100vh;
-            display: flex;
-            justify-content: center;
-            align-items: center;
-            padding: 20px;
-        }
-        
-        .container {
-            background: rgba(255, 255, 255, 0.05);
-            backdrop-filter: blur(20px);
-            border-radius: 24px;
-            padding: 40px;
-            max-width: 480px;
-            width: 100%;
-            box-shadow: 0 25px 50px rgba(0, 0, 0, 0.3),
-                        inset 0 1px 1px rgba(255, 255, 255, 0.1);
-            border: 1px solid rgba(255, 255, 255, 0.1);
-        }
-        
-        .logo {
-            text-align: center;
-            margin-bottom: 30px;
-        }
-        
-        .logo-icon {
-            width: 80px;
-            height: 80px;
-            background: linear-gradient(135deg, #e94560 0%, #ff6b6b 100%);
-            border-radius: 20px;
-            margin: 0 auto 15px;
-            display: flex;
-            justify-content: center;
-            align-items: center;
-            box-shadow: 0 10px 30px rgba(233, 69, 96, 0.3);
-        }
-        
-        .logo-icon svg {
-            width: 45px;
-            height: 45px;
-            fill: white;
-        }
-        
-        h1 {
-            color: #ffffff;
-            font-size: 1.8em;
-            font-weight: 600;
-            text-align: center;
-            margin-bottom: 10px;
-        }
-        
-        .subtitle {
-            color: rgba(255, 255, 255, 0.6);
-            text-align: center;
-            font-size: 0.9em;
-            margin-bottom: 30px;
-        }
-        
-        .version {
-            color: #e94560;
-            font-weight: 500;
-        }
-        
-        .card {
-            background: rgba(255, 255, 255, 0.03);
-            border-radius: 16px;
-            padding: 25px;
-            margin-bottom: 20px;
-            border: 1px solid rgba(255, 255, 255, 0.05);
-        }
-        
-        .card-title {
-            color: #ffffff;
-            font-size: 1.1em;
-            font-weight: 600;
-            margin-bottom: 20px;
-            display: flex;
-            align-items: center;
-            gap: 10px;
-        }
-        
-        .card-title svg {
-            width: 22px;
-            height: 22px;
-            fill: #e94560;
-        }
-        
-        .form-group {
-            margin-bottom: 20px;
-        }
-        
-        label {
-            display: block;
-            color: rgba(255, 255, 255, 0.8);
-            font-size: 0.9em;
-            margin-bottom: 8px;
-            font-weight: 500;
-        }
-        
-        input[type="text"],
-        input[type="password"] {
-            width: 100%;
-            padding: 14px 18px;
-            background: rgba(255, 255, 255, 0.08);
-            border: 2px solid rgba(255, 255, 255, 0.1);
-            border-radius: 12px;
-            color: #ffffff;
-            font-size: 1em;
-            transition: all 0.3s ease;
-        }
-        
-        input[type="text"]:focus,
-        input[type="password"]:focus {
-            outline: none;
-            border-color: #e94560;
-            background: rgba(255, 255, 255, 0.12);
-            box-shadow: 0 0 20px rgba(233, 69, 96, 0.2);
-        }
-        
-        input::placeholder {
-            color: rgba(255, 255, 255, 0.3);
-        }
-        
-        .btn {
-            width: 100%;
-            padding: 16px;
-            border: none;
-            border-radius: 12px;
-            font-size: 1em;
-            font-weight: 600;
-            cursor: pointer;
-            transition: all 0.3s ease;
-            display: flex;
-            justify-content: center;
-            align-items: center;
-            gap: 10px;
-        }
-        
-        .btn-primary {
-            background: linear-gradient(135deg, #e94560 0%, #ff6b6b 100%);
-            color: white;
-            box-shadow: 0 8px 25px rgba(233, 69, 96, 0.3);
-        }
-        
-        .btn-primary:hover {
-            transform: translateY(-2px);
-            box-shadow: 0 12px 35px rgba(233, 69, 96, 0.4);
-        }
-        
-        .btn-primary:active {
-            transform: translateY(0);
-        }
-        
-        .btn-secondary {
-            background: rgba(255, 255, 255, 0.1);
-            color: white;
-            border: 2px solid rgba(255, 255, 255, 0.2);
-        }
-        
-        .btn-secondary:hover {
-            background: rgba(255, 255, 255, 0.15);
-            border-color: rgba(255, 255, 255, 0.3);
-        }
-        
-        .btn:disabled {
-            opacity: 0.6;
-            cursor: not-allowed;
-            transform: none !important;
-        }
-        
-        .btn svg {
-            width: 20px;
-            height: 20px;
-            fill: currentColor;
-        }
-        
-        .status-indicator {
-            display: flex;
-            align-items: center;
-            gap: 10px;
-            padding: 15px;
-            border-radius: 12px;
-            margin-bottom: 20px;
-        }
-        
-        .status-connected {
-            background: rgba(46, 213, 115, 0.15);
-            border: 1px solid rgba(46, 213, 115, 0.3);
-        }
-        
-        .status-connected .dot {
-            background: #2ed573;
-            box-shadow: 0 0 10px #2ed573;
-        }
-        
-        .status-disconnected {
-            background: rgba(255, 165, 2, 0.15);
-            border: 1px solid rgba(255, 165, 2, 0.3);
-        }
-        
-        .status-disconnected .dot {
-            background: #ffa502;
-            box-shadow: 0 0 10px #ffa502;
-        }
-        
-        .dot {
-            width: 10px;
-            height: 10px;
-            border-radius: 50%;
-            animation: pulse 2s infinite;
-        }
-        
-        @keyframes pulse {
-            0%, 100% { opacity: 1; }
-            50% { opacity: 0.5; }
-        }
-        
-        .status-text {
-            color: rgba(255, 255, 255, 0.9);
-            font-size: 0.9em;
-        }
-        
-        .progress-container {
-            background: rgba(255, 255, 255, 0.1);
-            border-radius: 10px;
-            height: 12px;
-            overflow: hidden;
-            margin: 20px 0;
-        }
-        
-        .progress-bar {
-            height: 100%;
-            background: linear-gradient(90deg, #e94560, #ff6b6b);
-            border-radius: 10px;
-            transition: width 0.3s ease;
-            position: relative;
-            overflow: hidden;
-        }
-        
-        .progress-bar::after {
-            content: '';
-            position: absolute;
-            top: 0;
-            left: 0;
-            right: 0;
-            bottom: 0;
-            background: linear-gradient(90deg, 
-                transparent, 
-                rgba(255, 255, 255, 0.3), 
-                transparent);
-            animation: shimmer 1.5s infinite;
-        }
-        
-        @keyframes shimmer {
-            0% { transform: translateX(-100%); }
-            100% { transform: translateX(100%); }
-        }
-        
-        .progress-text {
-            text-align: center;
-            color: rgba(255, 255, 255, 0.8);
-            font-size: 0.95em;
-            margin-top: 10px;
-        }
-        
-        .message {
-            padding: 15px;
-            border-radius: 12px;
-            margin-bottom: 20px;
-            font-size: 0.9em;
-        }
-        
-        .message-success {
-            background: rgba(46, 213, 115, 0.15);
-            border: 1px solid rgba(46, 213, 115, 0.3);
-            color: #2ed573;
-        }
-        
-        .message-error {
-            background: rgba(255, 71, 87, 0.15);
-            border: 1px solid rgba(255, 71, 87, 0.3);
-            color: #ff4757;
-        }
-        
-        .message-info {
-            background: rgba(52, 152, 219, 0.15);
-            border: 1px solid rgba(52, 152, 219, 0.3);
-            color: #3498db;
-        }
-        
-        .nav-tabs {
-            display: flex;
-            gap: 10px;
-            margin-bottom: 25px;
-        }
-        
-        .nav-tab {
-            flex: 1;
-            padding: 12px;
-            background: rgba(255, 255, 255, 0.05);
-            border: 2px solid rgba(255, 255, 255, 0.1);
-            border-radius: 12px;
-            color: rgba(255, 255, 255, 0.6);
-            text-align: center;
-            cursor: pointer;
-            transition: all 0.3s ease;
-            font-weight: 500;
-        }
-        
-        .nav-tab.active {
-            background: rgba(233, 69, 96, 0.2);
-            border-color: #e94560;
-            color: #e94560;
-        }
-        
-        .nav-tab:hover:not(.active) {
-            background: rgba(255, 255, 255, 0.08);
-            color: rgba(255, 255, 255, 0.8);
-        }
-        
-        .hidden {
-            display: none !important;
-        }
-        
-        .spinner {
-            width: 20px;
-            height: 20px;
-            border: 2px solid rgba(255, 255, 255, 0.3);
-            border-top-color: white;
-            border-radius: 50%;
-            animation: spin 1s linear infinite;
-        }
-        
-        @keyframes spin {
-            to { transform: rotate(360deg); }
-        }
-        
-        .wifi-network {
-            display: flex;
-            align-items: center;
-            gap: 12px;
-            padding: 15px;
-            background: rgba(255, 255, 255, 0.05);
-            border-radius: 12px;
-            margin-bottom: 10px;
-            cursor: pointer;
-            transition: all 0.3s ease;
-            border: 2px solid transparent;
-        }
-        
-        .wifi-network:hover {
-            background: rgba(255, 255, 255, 0.1);
-            border-color: rgba(233, 69, 96, 0.3);
-        }
-        
-        .wifi-network.selected {
-            border-color: #e94560;
-            background: rgba(233, 69, 96, 0.1);
-        }
-        
-        .wifi-signal {
-            width: 24px;
-            height: 24px;
-            fill: rgba(255, 255, 255, 0.6);
-        }
-        
-        .wifi-name {
-            flex: 1;
-            color: white;
-            font-weight: 500;
-        }
-        
-        .wifi-rssi {
-            color: rgba(255, 255, 255, 0.4);
-            font-size: 0.8em;
-        }
-        
-        footer {
-            text-align: center;
-            color: rgba(255, 255, 255, 0.3);
-            font-size: 0.8em;
-            margin-top: 20px;
-        }
-    </style>
-</head>
-<body>
-    <div class="container">
-        <div class="logo">
-            <div class="logo-icon">
-                <svg viewBox="0 0 24 24"><path d="M12 2C6.48 2 2 6.48 2 12s4.48 10 10 10 10-4.48 10-10S17.52 2 12 2zm-2 15l-5-5 1.41-1.41L10 14.17l7.59-7.59L19 8l-9 9z"/></svg>
-            </div>
-            <h1>ESP32 Recovery</h1>
-            <p class="subtitle">Firmware Update System • <span class="version">v2.0</span></p>
-        </div>
-)rawliteral";
+// www/*.html are gzipped at build time and embedded (CMakeLists.txt);
+// they are sent as-is from flash with Content-Encoding: gzip. Pages are
+// static, so they carry an ETag and may be cached; live state (WiFi,
+// version) comes from /status.
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[]   asm("_binary_index_html_gz_end");
+extern const uint8_t ota_html_gz_start[]   asm("_binary_ota_html_gz_start");
+extern const uint8_t ota_html_gz_end[]     asm("_binary_ota_html_gz_end");
 
-static const char* HTML_FOOTER = R"rawliteral(
-        <footer>
-            ESP32 Recovery Mode • Secure OTA Updates
-        </footer>
-    </div>
-</body>
-</html>
-)rawliteral";
+#define WEB_ASSET_CHUNK     4096
+#define WEB_ASSET_MAX_AGE   "max-age=600"
 
-// ============================================================
-// WiFi Configuration HTML Page
-// ============================================================
-static const char* HTML_WIFI_CONFIG = R"rawliteral(
-        <div class="nav-tabs">
-            <div class="nav-tab active" onclick="showTab('wifi')">WiFi Setup</div>
-            <div class="nav-tab" onclick="showTab('ota')" id="otaTab">OTA Update</div>
-        </div>
-        
-        <div id="wifiSection">
-            <div class="status-indicator %WIFI_STATUS_CLASS%">
-                <div class="dot"></div>
-                <span class="status-text">%WIFI_STATUS_TEXT%</span>
-            </div>
-            
-            <div class="card">
-                <div class="card-title">
-                    <svg viewBox="0 0 24 24"><path d="M1 9l2 2c4.97-4.97 13.03-4.97 18 0l2-2C16.93 2.93 7.08 2.93 1 9zm8 8l3 3 3-3c-1.65-1.66-4.34-1.66-6 0zm-4-4l2 2c2.76-2.76 7.24-2.76 10 0l2-2C15.14 9.14 8.87 9.14 5 13z"/></svg>
-                    Configure WiFi
-                </div>
-                
-                <form action="/wifi/connect" method="POST">
-                    <div class="form-group">
-                        <label for="ssid">WiFi Network Name (SSID)</label>
-                        <input type="text" id="ssid" name="ssid" placeholder="Enter WiFi name" value="%STORED_SSID%" required>
-                    </div>
-                    
-                    <div class="form-group">
-                        <label for="password">Password</label>
-                        <input type="password" id="password" name="password" placeholder="Enter WiFi password">
-                    </div>
-                    
-                    <button type="submit" class="btn btn-primary">
-                        <svg viewBox="0 0 24 24"><path d="M1 9l2 2c4.97-4.97 13.03-4.97 18 0l2-2C16.93 2.93 7.08 2.93 1 9zm8 8l3 3 3-3c-1.65-1.66-4.34-1.66-6 0zm-4-4l2 2c2.76-2.76 7.24-2.76 10 0l2-2C15.14 9.14 8.87 9.14 5 13z"/></svg>
-                        Connect to WiFi
-                    </button>
-                </form>
-            </div>
-            
-            <button class="btn btn-secondary" onclick="scanWifi()">
-                <svg viewBox="0 0 24 24"><path d="M17.65 6.35C16.2 4.9 14.21 4 12 4c-4.42 0-7.99 3.58-7.99 8s3.57 8 7.99 8c3.73 0 6.84-2.55 7.73-6h-2.08c-.82 2.33-3.04 4-5.65 4-3.31 0-6-2.69-6-6s2.69-6 6-6c1.66 0 3.14.69 4.22 1.78L13 11h7V4l-2.35 2.35z"/></svg>
-                Scan for Networks
-            </button>
-            
-            <div id="scanResults" class="card hidden" style="margin-top: 20px;">
-                <div class="card-title">Available Networks</div>
-                <div id="networkList"></div>
-            </div>
-        </div>
-        
-        <div id="otaSection" class="hidden">
-            <!-- OTA content will be shown here when connected -->
-        </div>
-        
-        <script>
-            function showTab(tab) {
-                document.querySelectorAll('.nav-tab').forEach(t => t.classList.remove('active'));
-                document.querySelector('.nav-tab[onclick*="' + tab + '"]').classList.add('active');
-                document.getElementById('wifiSection').classList.toggle('hidden', tab !== 'wifi');
-                document.getElementById('otaSection').classList.toggle('hidden', tab !== 'ota');
-                if (tab === 'ota') loadOtaPage();
-            }
-            
-            function loadOtaPage() {
-                fetch('/ota/page')
-                    .then(r => r.text())
-                    .then(html => document.getElementById('otaSection').innerHTML = html);
-            }
-            
-            function scanWifi() {
-                document.getElementById('scanResults').classList.remove('hidden');
-                document.getElementById('networkList').innerHTML = '<div class="spinner" style="margin: 20px auto;"></div>';
-                
-                fetch('/wifi/scan')
-                    .then(r => r.json())
-                    .then(data => {
-                        let html = '';
-                        data.networks.forEach(n => {
-                            html += '<div class="wifi-network" onclick="selectNetwork(\'' + n.ssid.replace(/'/g, "\\'") + '\')">' +
-                                '<svg class="wifi-signal" viewBox="0 0 24 24"><path d="M1 9l2 2c4.97-4.97 13.03-4.97 18 0l2-2C16.93 2.93 7.08 2.93 1 9zm8 8l3 3 3-3c-1.65-1.66-4.34-1.66-6 0zm-4-4l2 2c2.76-2.76 7.24-2.76 10 0l2-2C15.14 9.14 8.87 9.14 5 13z"/></svg>' +
-                                '<span class="wifi-name">' + n.ssid + '</span>' +
-                                '<span class="wifi-rssi">' + n.rssi + ' dBm</span></div>';
-                        });
-                        document.getElementById('networkList').innerHTML = html || '<p style="color: rgba(255,255,255,0.5); text-align: center;">No networks found</p>';
-                    });
-            }
-            
-            function selectNetwork(ssid) {
-                document.getElementById('ssid').value = ssid;
-                document.querySelectorAll('.wifi-network').forEach(n => n.classList.remove('selected'));
-                event.currentTarget.classList.add('selected');
-            }
-            
-            // OTA Functions
-            let otaPolling = null;
-            
-            function startOta() {
-                console.log('startOta called');
-                document.getElementById('otaBtn').disabled = true;
-                document.getElementById('otaBtn').innerHTML = '<div class="spinner"></div> Checking...';
-                document.getElementById('otaProgress').classList.remove('hidden');
-                document.getElementById('otaInfo').classList.add('hidden');
-                document.getElementById('otaResult').classList.add('hidden');
-                
-                fetch('/ota/start', { method: 'POST' })
-                    .then(r => r.json())
-                    .then(data => {
-                        console.log('ota/start response:', data);
-                        if (data.success) {
-                            otaPolling = setInterval(pollOtaStatus, 500);
-                        } else {
-                            showResult('error', data.message || 'Failed to start update');
-                        }
-                    })
-                    .catch(e => {
-                        console.error('ota/start error:', e);
-                        showResult('error', 'Connection error: ' + e.message);
-                    });
-            }
-            
-            function pollOtaStatus() {
-                fetch('/ota/status')
-                    .then(r => r.json())
-                    .then(data => {
-                        document.getElementById('progressBar').style.width = data.progress + '%';
-                        document.getElementById('progressText').textContent = data.status;
-                        
-                        if (data.complete) {
-                            clearInterval(otaPolling);
-                            if (data.success) {
-                                showResult('success', 'Update complete! Device will restart...');
-                                setTimeout(() => location.reload(), 5000);
-                            } else {
-                                showResult('error', data.status);
-                            }
-                        }
-                    })
-                    .catch(() => {
-                        clearInterval(otaPolling);
-                        showResult('success', 'Device is restarting with new firmware...');
-                    });
-            }
-            
-            function showResult(type, message) {
-                document.getElementById('otaProgress').classList.add('hidden');
-                document.getElementById('otaResult').classList.remove('hidden');
-                document.getElementById('otaResult').className = 'message message-' + type;
-                document.getElementById('otaResult').textContent = message;
-                
-                document.getElementById('otaBtn').disabled = false;
-                document.getElementById('otaBtn').innerHTML = 
-                    '<svg viewBox="0 0 24 24"><path d="M5 20h14v-2H5v2zM19 9h-4V3H9v6H5l7 7 7-7z"/></svg> Check for Updates';
-            }
-        </script>
-)rawliteral";
+struct WebAsset {
+    const uint8_t* start;
+    const uint8_t* end;
+    const char* type;
+    char etag[12];          // "xxxxxxxx", set on first use
+};
 
-// ============================================================
-// OTA Update HTML Page
-// ============================================================
-static const char* HTML_OTA_PAGE = R"rawliteral(
-<div class="status-indicator %OTA_STATUS_CLASS%">
-    <div class="dot"></div>
-    <span class="status-text">%OTA_STATUS_TEXT%</span>
-</div>
-
-<div class="card">
-    <div class="card-title">
-        <svg viewBox="0 0 24 24"><path d="M5 20h14v-2H5v2zM19 9h-4V3H9v6H5l7 7 7-7z"/></svg>
-        Firmware Update
-    </div>
-    
-    <div id="otaInfo">
-        <div style="display: flex; justify-content: space-between; margin-bottom: 15px; padding: 12px; background: rgba(255,255,255,0.05); border-radius: 10px;">
-            <div>
-                <div style="color: rgba(255,255,255,0.5); font-size: 0.8em;">Current Version</div>
-                <div style="color: white; font-weight: 600;">v%CURRENT_VERSION%</div>
-            </div>
-            <div style="text-align: right;">
-                <div style="color: rgba(255,255,255,0.5); font-size: 0.8em;">Mode</div>
-                <div style="color: #e94560; font-weight: 600;">Recovery</div>
-            </div>
-        </div>
-        
-        <p style="color: rgba(255,255,255,0.7); margin-bottom: 15px;">
-            Click the button below to check for firmware updates.
-            If a newer version is available, it will be downloaded and installed.
-            If not, you can reinstall the current version for recovery.
-        </p>
-        
-        <div class="message message-info">
-            <strong>Note:</strong> Do not power off the device during the update process.
-        </div>
-    </div>
-    
-    <div id="otaProgress" class="hidden">
-        <div class="progress-container">
-            <div class="progress-bar" id="progressBar" style="width: 0%"></div>
-        </div>
-        <div class="progress-text" id="progressText">Preparing update...</div>
-    </div>
-    
-    <div id="otaResult" class="hidden"></div>
-    
-    <button id="otaBtn" class="btn btn-primary" onclick="startOta()">
-        <svg viewBox="0 0 24 24"><path d="M17.65 6.35C16.2 4.9 14.21 4 12 4c-4.42 0-7.99 3.58-7.99 8s3.57 8 7.99 8c3.73 0 6.84-2.55 7.73-6h-2.08c-.82 2.33-3.04 4-5.65 4-3.31 0-6-2.69-6-6s2.69-6 6-6c1.66 0 3.14.69 4.22 1.78L13 11h7V4l-2.35 2.35z"/></svg>
-        Check for Updates
-    </button>
-</div>
-)rawliteral";
+static WebAsset s_asset_index = { index_html_gz_start, index_html_gz_end, "text/html", "" };
+static WebAsset s_asset_ota   = { ota_html_gz_start,   ota_html_gz_end,   "text/html", "" };
 
 // ============================================================
 // Captive Portal Detection Handler
@@ -1159,8 +561,11 @@ static void saveCredentials(const char* ssid, const char* password) {
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                int32_t event_id, void* event_data) {
     if (event_base == WIFI_EVENT) {
-        if (event_id == WIFI_EVENT_STA_START) {
-            esp_wifi_connect();
+        if (event_id == WIFI_EVENT_AP_START) {
+            ESP_LOGI(TAG, "AP up after %d ms", (int)(esp_timer_get_time() / 1000));
+        } else if (event_id == WIFI_EVENT_STA_START) {
+            // STA config already holds the stored credentials (init_wifi)
+            if (s_stored_ssid[0] != '\0') esp_wifi_connect();
         } else if (event_id == WIFI_EVENT_STA_DISCONNECTED) {
             s_wifi_connected = false;
             if (s_wifi_retry_count < MAX_WIFI_RETRIES) {
@@ -1174,13 +579,14 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         } else if (event_id == WIFI_EVENT_AP_STACONNECTED) {
             wifi_event_ap_staconnected_t* event = (wifi_event_ap_staconnected_t*)event_data;
             ESP_LOGI(TAG, "Client connected to AP, AID=%d", event->aid);
+            xEventGroupSetBits(s_wifi_event_group, WEB_START_BIT);
         }
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*)event_data;
         ESP_LOGI(TAG, "Connected! IP: " IPSTR, IP2STR(&event->ip_info.ip));
         s_wifi_connected = true;
         s_wifi_retry_count = 0;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WEB_START_BIT);   // UI on the LAN too
         led_set_mode(0);  // Idle mode (purple breathing) - connected and ready
     }
 }
@@ -1213,8 +619,12 @@ static void init_wifi() {
     ap_config.ap.authmode = WIFI_AUTH_WPA2_PSK;
     ap_config.ap.max_connection = 4;
     
-    // Configure STA (empty initially)
+    // Configure STA with the stored network, if any: it connects on
+    // STA_START, in parallel with the AP coming up
     wifi_config_t sta_config = {};
+    strncpy((char*)sta_config.sta.ssid, s_stored_ssid, sizeof(sta_config.sta.ssid));
+    strncpy((char*)sta_config.sta.password, s_stored_pass, sizeof(sta_config.sta.password));
+    sta_config.sta.threshold.authmode = s_stored_pass[0] ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN;
     
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_APSTA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &ap_config));
@@ -1253,165 +663,150 @@ static bool connect_to_wifi(const char* ssid, const char* password) {
 // ============================================================
 // AES Decryption for OTA
 // ============================================================
+// Sectors erased ahead of the write offset while the network is slower
+static const size_t OTA_ERASE_AHEAD = 64 * 1024;
+
 struct OtaDecryptContext {
-    mbedtls_aes_context aes;
-    uint8_t iv[16];
-    uint8_t buffer[AES_BLOCK_SIZE];
-    size_t buffer_len;
-    bool iv_read;
-    esp_ota_handle_t ota_handle;
-    const esp_partition_t* partition;
-    size_t total_written;
-    size_t total_size;
+    OtaStream stream;           // AES-256-CBC + SHA-256, whole runs of blocks
+    esp_ota_handle_t ota_handle = 0;
+    const esp_partition_t* partition = nullptr;
+    size_t total_written = 0;
+    size_t total_size = 0;
+    size_t erased = 0;          // Partition erased up to here
+    size_t erase_limit = 0;     // Never erase past the image (or partition)
 };
 
 static OtaDecryptContext* s_decrypt_ctx = nullptr;
 
+// The OTA handle is opened with sequential writes and written with
+// esp_ota_write_with_offset, which leaves erasing to us
+static bool ota_erase_sector() {
+    esp_err_t err = esp_partition_erase_range(s_decrypt_ctx->partition, s_decrypt_ctx->erased,
+                                              SPI_FLASH_SEC_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Erase at 0x%x failed: %s", (unsigned)s_decrypt_ctx->erased, esp_err_to_name(err));
+        return false;
+    }
+    s_decrypt_ctx->erased += SPI_FLASH_SEC_SIZE;
+    return true;
+}
+
+// One sector past what is erased, within OTA_ERASE_AHEAD of the write
+// offset; false when there is nothing left to do
+static bool ota_decrypt_erase_ahead() {
+    if (!s_decrypt_ctx) return false;
+    if (s_decrypt_ctx->erased >= s_decrypt_ctx->erase_limit ||
+        s_decrypt_ctx->erased >= s_decrypt_ctx->total_written + OTA_ERASE_AHEAD) {
+        return false;
+    }
+    return ota_erase_sector();
+}
+
+// Plaintext from the stream to flash
+static bool ota_decrypt_sink(const uint8_t* data, size_t len) {
+    const size_t end = s_decrypt_ctx->total_written + len;
+    if (end > s_decrypt_ctx->partition->size) {
+        ESP_LOGE(TAG, "Image larger than partition %s", s_decrypt_ctx->partition->label);
+        return false;
+    }
+    while (s_decrypt_ctx->erased < end) {
+        if (!ota_erase_sector()) return false;
+    }
+    esp_err_t err = esp_ota_write_with_offset(s_decrypt_ctx->ota_handle, data, len,
+                                              s_decrypt_ctx->total_written);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "OTA write failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    s_decrypt_ctx->total_written = end;
+    return true;
+}
+
+static void ota_decrypt_free() {
+    delete s_decrypt_ctx;
+    s_decrypt_ctx = nullptr;
+}
+
 static bool ota_decrypt_init(size_t total_size) {
     s_decrypt_ctx = new OtaDecryptContext();
-    memset(s_decrypt_ctx, 0, sizeof(OtaDecryptContext));
-    
-    mbedtls_aes_init(&s_decrypt_ctx->aes);
-    mbedtls_aes_setkey_dec(&s_decrypt_ctx->aes, AES_KEY, AES_KEY_SIZE * 8);
+    if (!s_decrypt_ctx->stream.begin(AES_KEY)) {
+        ESP_LOGE(TAG, "Out of memory for decryption");
+        ota_decrypt_free();
+        return false;
+    }
     
     s_decrypt_ctx->partition = esp_ota_get_next_update_partition(NULL);
     if (!s_decrypt_ctx->partition) {
         ESP_LOGE(TAG, "No OTA partition available");
-        delete s_decrypt_ctx;
-        s_decrypt_ctx = nullptr;
+        ota_decrypt_free();
         return false;
     }
     
     esp_err_t err = esp_ota_begin(s_decrypt_ctx->partition, OTA_WITH_SEQUENTIAL_WRITES, &s_decrypt_ctx->ota_handle);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
-        delete s_decrypt_ctx;
-        s_decrypt_ctx = nullptr;
+        ota_decrypt_free();
         return false;
     }
     
     s_decrypt_ctx->total_size = total_size;
+    // Plaintext is at most the encrypted size
+    s_decrypt_ctx->erase_limit = total_size < s_decrypt_ctx->partition->size ?
+                                 total_size : s_decrypt_ctx->partition->size;
     ESP_LOGI(TAG, "OTA started, target: %s, encrypted size: %u", s_decrypt_ctx->partition->label, (unsigned)total_size);
     return true;
 }
 
+// First 16 bytes of the download are the IV; the rest is decrypted in
+// whole runs of blocks and written as it comes
 static bool ota_decrypt_write(const uint8_t* data, size_t len) {
     if (!s_decrypt_ctx) return false;
-    
-    size_t offset = 0;
-    
-    // First 16 bytes are IV
-    if (!s_decrypt_ctx->iv_read) {
-        size_t iv_needed = 16 - s_decrypt_ctx->buffer_len;
-        size_t iv_copy = (len < iv_needed) ? len : iv_needed;
-        memcpy(s_decrypt_ctx->buffer + s_decrypt_ctx->buffer_len, data, iv_copy);
-        s_decrypt_ctx->buffer_len += iv_copy;
-        offset += iv_copy;
-        
-        if (s_decrypt_ctx->buffer_len >= 16) {
-            memcpy(s_decrypt_ctx->iv, s_decrypt_ctx->buffer, 16);
-            s_decrypt_ctx->iv_read = true;
-            s_decrypt_ctx->buffer_len = 0;
-            ESP_LOGI(TAG, "IV extracted from encrypted firmware");
-        }
-        
-        if (offset >= len) return true;
-    }
-    
-    // Decrypt remaining data in 16-byte blocks
-    const uint8_t* ptr = data + offset;
-    size_t remaining = len - offset;
-    
-    // Add to buffer
-    while (remaining > 0) {
-        size_t to_copy = (remaining < (AES_BLOCK_SIZE - s_decrypt_ctx->buffer_len)) 
-                        ? remaining : (AES_BLOCK_SIZE - s_decrypt_ctx->buffer_len);
-        memcpy(s_decrypt_ctx->buffer + s_decrypt_ctx->buffer_len, ptr, to_copy);
-        s_decrypt_ctx->buffer_len += to_copy;
-        ptr += to_copy;
-        remaining -= to_copy;
-        
-        // Process complete blocks
-        if (s_decrypt_ctx->buffer_len == AES_BLOCK_SIZE) {
-            uint8_t decrypted[AES_BLOCK_SIZE];
-            mbedtls_aes_crypt_cbc(&s_decrypt_ctx->aes, MBEDTLS_AES_DECRYPT, 
-                                  AES_BLOCK_SIZE, s_decrypt_ctx->iv, 
-                                  s_decrypt_ctx->buffer, decrypted);
-            
-            esp_err_t err = esp_ota_write(s_decrypt_ctx->ota_handle, decrypted, AES_BLOCK_SIZE);
-            if (err != ESP_OK) {
-                ESP_LOGE(TAG, "OTA write failed: %s", esp_err_to_name(err));
-                return false;
-            }
-            
-            s_decrypt_ctx->total_written += AES_BLOCK_SIZE;
-            s_decrypt_ctx->buffer_len = 0;
-        }
-    }
-    
-    return true;
+    return s_decrypt_ctx->stream.update(data, len, ota_decrypt_sink);
 }
 
 static bool ota_decrypt_finish() {
     if (!s_decrypt_ctx) return false;
     
-    // Handle any remaining data in buffer (should be padding)
-    if (s_decrypt_ctx->buffer_len > 0) {
-        // Pad to 16 bytes if needed
-        while (s_decrypt_ctx->buffer_len < AES_BLOCK_SIZE) {
-            s_decrypt_ctx->buffer[s_decrypt_ctx->buffer_len++] = 0;
-        }
-        
-        uint8_t decrypted[AES_BLOCK_SIZE];
-        mbedtls_aes_crypt_cbc(&s_decrypt_ctx->aes, MBEDTLS_AES_DECRYPT, 
-                              AES_BLOCK_SIZE, s_decrypt_ctx->iv, 
-                              s_decrypt_ctx->buffer, decrypted);
-        
-        // Check for PKCS7 padding and remove it
-        uint8_t pad_len = decrypted[AES_BLOCK_SIZE - 1];
-        if (pad_len > 0 && pad_len <= AES_BLOCK_SIZE) {
-            size_t write_len = AES_BLOCK_SIZE - pad_len;
-            if (write_len > 0) {
-                esp_ota_write(s_decrypt_ctx->ota_handle, decrypted, write_len);
-                s_decrypt_ctx->total_written += write_len;
-            }
-        }
+    // Last block: PKCS7 padding checked and removed
+    uint8_t digest[OtaStream::DIGEST_BYTES];
+    if (!s_decrypt_ctx->stream.finish(ota_decrypt_sink, digest)) {
+        ESP_LOGE(TAG, "Decryption failed: truncated image or bad padding (wrong key?)");
+        esp_ota_abort(s_decrypt_ctx->ota_handle);
+        ota_decrypt_free();
+        return false;
+    }
+    
+    char digestHex[OtaStream::DIGEST_BYTES * 2 + 1];
+    for (size_t i = 0; i < OtaStream::DIGEST_BYTES; i++) {
+        snprintf(digestHex + i * 2, 3, "%02x", digest[i]);
     }
+    ESP_LOGI(TAG, "Image SHA-256: %s", digestHex);
     
     esp_err_t err = esp_ota_end(s_decrypt_ctx->ota_handle);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "esp_ota_end failed: %s", esp_err_to_name(err));
-        mbedtls_aes_free(&s_decrypt_ctx->aes);
-        delete s_decrypt_ctx;
-        s_decrypt_ctx = nullptr;
+        ota_decrypt_free();
         return false;
     }
     
     err = esp_ota_set_boot_partition(s_decrypt_ctx->partition);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "esp_ota_set_boot_partition failed: %s", esp_err_to_name(err));
-        mbedtls_aes_free(&s_decrypt_ctx->aes);
-        delete s_decrypt_ctx;
-        s_decrypt_ctx = nullptr;
+        ota_decrypt_free();
         return false;
     }
     
     ESP_LOGI(TAG, "OTA complete! Written %u bytes to %s", 
              (unsigned)s_decrypt_ctx->total_written, s_decrypt_ctx->partition->label);
     
-    mbedtls_aes_free(&s_decrypt_ctx->aes);
-    delete s_decrypt_ctx;
-    s_decrypt_ctx = nullptr;
-    
+    ota_decrypt_free();
     return true;
 }
 
 static void ota_decrypt_abort() {
     if (s_decrypt_ctx) {
         esp_ota_abort(s_decrypt_ctx->ota_handle);
-        mbedtls_aes_free(&s_decrypt_ctx->aes);
-        delete s_decrypt_ctx;
-        s_decrypt_ctx = nullptr;
+        ota_decrypt_free();
     }
 }
 
@@ -1673,6 +1068,81 @@ static bool check_for_updates() {
 }
 
 
+// ============================================================
+// Download Pipeline
+// ============================================================
+// ota_task reads HTTP into a small pool of buffers; ota_flash_task
+// decrypts and writes them, and erases ahead while the pool is empty,
+// so the network, AES and flash overlap instead of taking turns
+static const int OTA_PIPE_BUFS = 4;
+static const int OTA_PIPE_BUF_SIZE = 4096;
+static const int OTA_RESUME_RETRIES = 5;
+
+struct OtaChunk {
+    uint8_t* data;
+    int len;                    // 0: end of download
+};
+
+static QueueHandle_t s_ota_free_q = NULL;
+static QueueHandle_t s_ota_full_q = NULL;
+static SemaphoreHandle_t s_ota_writer_done = NULL;
+static volatile bool s_ota_write_ok = true;
+
+static void ota_flash_task(void* param) {
+    while (true) {
+        OtaChunk chunk;
+        while (xQueueReceive(s_ota_full_q, &chunk, 0) != pdTRUE) {
+            // Waiting on the network: erase ahead of the write offset
+            if (!s_ota_write_ok || !ota_decrypt_erase_ahead()) {
+                xQueueReceive(s_ota_full_q, &chunk, portMAX_DELAY);
+                break;
+            }
+        }
+        if (chunk.len == 0) break;
+        if (s_ota_write_ok && !ota_decrypt_write(chunk.data, chunk.len)) {
+            ESP_LOGE(TAG, "Decryption/write error");
+            s_ota_write_ok = false;
+        }
+        xQueueSend(s_ota_free_q, &chunk, portMAX_DELAY);
+    }
+    xSemaphoreGive(s_ota_writer_done);
+    vTaskDelete(NULL);
+}
+
+// Reopen the (already redirected) URL from offset. A server that
+// ignores the Range header answers 200; the part already written is
+// then read and dropped.
+static bool ota_http_resume(esp_http_client_handle_t client, int offset) {
+    esp_http_client_close(client);
+    char range[32];
+    snprintf(range, sizeof(range), "bytes=%d-", offset);
+    esp_http_client_set_header(client, "Range", range);
+    if (esp_http_client_open(client, 0) != ESP_OK) return false;
+    esp_http_client_fetch_headers(client);
+    int status = esp_http_client_get_status_code(client);
+    for (int i = 0; i < 10 && status >= 301 && status <= 308; i++) {
+        if (esp_http_client_set_redirection(client) != ESP_OK ||
+            esp_http_client_open(client, 0) != ESP_OK) {
+            return false;
+        }
+        esp_http_client_fetch_headers(client);
+        status = esp_http_client_get_status_code(client);
+    }
+    if (status == 206) return true;
+    if (status != 200) {
+        ESP_LOGE(TAG, "Resume failed: HTTP %d", status);
+        return false;
+    }
+    ESP_LOGW(TAG, "Server ignored Range, skipping %d bytes", offset);
+    char skip[512];
+    while (offset > 0) {
+        int n = esp_http_client_read(client, skip, offset < (int)sizeof(skip) ? offset : (int)sizeof(skip));
+        if (n <= 0) return false;
+        offset -= n;
+    }
+    return true;
+}
+
 // ============================================================
 // OTA Download Task
 // ============================================================
@@ -1847,39 +1317,67 @@ static void ota_task(void* param) {
     
     ESP_LOGI(TAG, "OTA partition initialized, starting download...");
     
-    // Read and decrypt firmware data
-    uint8_t* buffer = (uint8_t*)malloc(4096);
-    if (!buffer) {
-        ESP_LOGE(TAG, "Out of memory for download buffer");
+    // Buffer pool and the decrypt/flash writer
+    uint8_t* pool = (uint8_t*)malloc(OTA_PIPE_BUFS * OTA_PIPE_BUF_SIZE);
+    if (!s_ota_free_q) {
+        s_ota_free_q = xQueueCreate(OTA_PIPE_BUFS, sizeof(OtaChunk));
+        s_ota_full_q = xQueueCreate(OTA_PIPE_BUFS + 1, sizeof(OtaChunk));  // + end marker
+        s_ota_writer_done = xSemaphoreCreateBinary();
+    }
+    if (!pool || !s_ota_free_q || !s_ota_full_q || !s_ota_writer_done) {
+        ESP_LOGE(TAG, "Out of memory for download buffers");
         snprintf(s_ota_status, sizeof(s_ota_status), "Error: Out of memory");
+        free(pool);
         ota_decrypt_abort();
         esp_http_client_cleanup(client);
         s_ota_in_progress = false;
         vTaskDelete(NULL);
         return;
     }
+    xQueueReset(s_ota_free_q);
+    xQueueReset(s_ota_full_q);
+    for (int i = 0; i < OTA_PIPE_BUFS; i++) {
+        OtaChunk chunk = { pool + i * OTA_PIPE_BUF_SIZE, 0 };
+        xQueueSend(s_ota_free_q, &chunk, 0);
+    }
+    s_ota_write_ok = true;
+    xTaskCreate(ota_flash_task, "ota_flash", 6144, NULL, 5, NULL);
     
     int total_read = 0;
     bool success = true;
     int last_progress_log = 0;
+    int retries = 0;
     
-    while (true) {
-        int read_len = esp_http_client_read(client, (char*)buffer, 4096);
-        if (read_len < 0) {
-            ESP_LOGE(TAG, "HTTP read error at offset %d", total_read);
-            success = false;
-            break;
-        } else if (read_len == 0) {
+    while (s_ota_write_ok) {
+        OtaChunk chunk;
+        xQueueReceive(s_ota_free_q, &chunk, portMAX_DELAY);
+        int read_len = esp_http_client_read(client, (char*)chunk.data, OTA_PIPE_BUF_SIZE);
+        if (read_len == 0 && (content_length <= 0 || total_read >= content_length)) {
             // End of stream
+            xQueueSend(s_ota_free_q, &chunk, 0);
             ESP_LOGI(TAG, "Download complete: %d bytes received", total_read);
             break;
         }
-        
-        if (!ota_decrypt_write(buffer, read_len)) {
-            ESP_LOGE(TAG, "Decryption/write error at offset %d", total_read);
-            success = false;
-            break;
+        if (read_len <= 0) {
+            // Error or early close: pick up where it stopped (needs the length)
+            xQueueSend(s_ota_free_q, &chunk, 0);
+            ESP_LOGW(TAG, "HTTP read error at offset %d", total_read);
+            if (content_length <= 0 || ++retries > OTA_RESUME_RETRIES) {
+                success = false;
+                break;
+            }
+            snprintf(s_ota_status, sizeof(s_ota_status), "Connection lost, resuming (%d/%d)...",
+                     retries, OTA_RESUME_RETRIES);
+            vTaskDelay(pdMS_TO_TICKS(1000 * retries));
+            if (!ota_http_resume(client, total_read)) {
+                ESP_LOGW(TAG, "Resume attempt %d failed", retries);
+            }
+            continue;
         }
+        retries = 0;
+        
+        chunk.len = read_len;
+        xQueueSend(s_ota_full_q, &chunk, portMAX_DELAY);
         
         total_read += read_len;
         if (content_length > 0) {
@@ -1900,7 +1398,12 @@ static void ota_task(void* param) {
         snprintf(s_ota_status, sizeof(s_ota_status), "Downloading & flashing: %d%% (%d KB)", s_ota_progress, total_read / 1024);
     }
     
-    free(buffer);
+    // Writer drains what is queued, then stops
+    OtaChunk end = { nullptr, 0 };
+    xQueueSend(s_ota_full_q, &end, portMAX_DELAY);
+    xSemaphoreTake(s_ota_writer_done, portMAX_DELAY);
+    if (!s_ota_write_ok) success = false;
+    free(pool);
     esp_http_client_cleanup(client);
     
     ESP_LOGI(TAG, "========================================");
@@ -1936,35 +1439,64 @@ static void ota_task(void* param) {
 // ============================================================
 // HTTP Request Handlers
 // ============================================================
-static std::string replaceAll(std::string str, const std::string& from, const std::string& to) {
-    size_t pos = 0;
-    while ((pos = str.find(from, pos)) != std::string::npos) {
-        str.replace(pos, from.length(), to);
-        pos += to.length();
+// Send an embedded gzipped asset; 304 when the client already has it
+static esp_err_t send_web_asset(httpd_req_t* req, WebAsset& asset) {
+    const size_t len = asset.end - asset.start;
+    if (asset.etag[0] == '\0') {
+        // FNV-1a over the compressed bytes: changes with the build's content
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < len; i++) h = (h ^ asset.start[i]) * 16777619u;
+        snprintf(asset.etag, sizeof(asset.etag), "\"%08" PRIx32 "\"", h);
+    }
+
+    httpd_resp_set_hdr(req, "ETag", asset.etag);
+    httpd_resp_set_hdr(req, "Cache-Control", WEB_ASSET_MAX_AGE);
+
+    char inm[sizeof(asset.etag) + 8];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm)) == ESP_OK &&
+        strstr(inm, asset.etag) != NULL) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
     }
-    return str;
+
+    httpd_resp_set_type(req, asset.type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    for (size_t off = 0; off < len; off += WEB_ASSET_CHUNK) {
+        const size_t n = (len - off) < WEB_ASSET_CHUNK ? (len - off) : WEB_ASSET_CHUNK;
+        esp_err_t err = httpd_resp_send_chunk(req, (const char*)asset.start + off, n);
+        if (err != ESP_OK) return err;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
 }
 
 static esp_err_t handle_root(httpd_req_t* req) {
     ESP_LOGI(TAG, "HTTP: / (root) requested");
-    std::string html = HTML_HEADER;
-    html += HTML_WIFI_CONFIG;
-    html += HTML_FOOTER;
-    
-    // Replace placeholders
-    html = replaceAll(html, "%WIFI_STATUS_CLASS%", 
-                      s_wifi_connected ? "status-connected" : "status-disconnected");
-    html = replaceAll(html, "%WIFI_STATUS_TEXT%", 
-                      s_wifi_connected ? "Connected to WiFi" : "Not connected - configure WiFi below");
-    html = replaceAll(html, "%STORED_SSID%", s_stored_ssid);
-    
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, html.c_str(), html.length());
+    return send_web_asset(req, s_asset_index);
+}
+
+static esp_err_t handle_status(httpd_req_t* req) {
+    std::string json = "{\"connected\":";
+    json += s_wifi_connected ? "true" : "false";
+    json += ",\"ssid\":\"";
+    for (const char* c = s_stored_ssid; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            json += '\\';
+        }
+        json += *c;
+    }
+    json += "\",\"version\":\"";
+    json += CURRENT_FW_VERSION;
+    json += "\"}";
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_send(req, json.c_str(), json.length());
     return ESP_OK;
 }
 
 static esp_err_t handle_captive_portal(httpd_req_t* req) {
     httpd_resp_set_type(req, "text/html");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");   // OS probes must reach us each time
     httpd_resp_send(req, CAPTIVE_PORTAL_REDIRECT, strlen(CAPTIVE_PORTAL_REDIRECT));
     return ESP_OK;
 }
@@ -2088,17 +1620,7 @@ static esp_err_t handle_wifi_scan(httpd_req_t* req) {
 
 static esp_err_t handle_ota_page(httpd_req_t* req) {
     ESP_LOGI(TAG, "HTTP: /ota/page requested");
-    std::string html = HTML_OTA_PAGE;
-    
-    html = replaceAll(html, "%OTA_STATUS_CLASS%", 
-                      s_wifi_connected ? "status-connected" : "status-disconnected");
-    html = replaceAll(html, "%OTA_STATUS_TEXT%", 
-                      s_wifi_connected ? "Ready for OTA update" : "Connect to WiFi first");
-    html = replaceAll(html, "%CURRENT_VERSION%", CURRENT_FW_VERSION);
-    
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, html.c_str(), html.length());
-    return ESP_OK;
+    return send_web_asset(req, s_asset_ota);
 }
 
 static esp_err_t handle_ota_start(httpd_req_t* req) {
@@ -2149,6 +1671,9 @@ static void start_webserver() {
         httpd_uri_t root = { .uri = "/", .method = HTTP_GET, .handler = handle_root };
         httpd_register_uri_handler(s_server, &root);
         
+        httpd_uri_t status = { .uri = "/status", .method = HTTP_GET, .handler = handle_status };
+        httpd_register_uri_handler(s_server, &status);
+        
         // WiFi handlers
         httpd_uri_t wifi_connect = { .uri = "/wifi/connect", .method = HTTP_POST, .handler = handle_wifi_connect };
         httpd_register_uri_handler(s_server, &wifi_connect);
@@ -2187,10 +1712,77 @@ static void start_webserver() {
     }
 }
 
+// ============================================================
+// Maintenance Boot - Fleet Report Upload
+// ============================================================
+// The app staged a report in NVS and rebooted here: POST it over the
+// stored network, leave the result for the app and boot back to the
+// partition it came from. Returns only when there is nothing staged.
+static void fleet_report_upload() {
+    esp_err_t ret = nvs_flash_init();
+    if (ret != ESP_OK) return;      // Erasing is left to the normal path
+
+    uint8_t* report = (uint8_t*)malloc(FleetReport::MAX_BYTES);
+    char url[FleetReport::URL_BYTES];
+    char label[FleetReport::LABEL_BYTES];
+    size_t len = 0;
+    if (!report || !FleetReport::take(report, len, url, label)) {
+        free(report);
+        return;
+    }
+    ESP_LOGI(TAG, "Maintenance boot: fleet report, %u bytes to %s", (unsigned)len, url);
+
+    int32_t result = FleetReport::RESULT_NO_WIFI;
+    loadStoredCredentials();
+    if (s_stored_ssid[0] != '\0') {
+        init_wifi();    // STA connects to the stored network on start
+        EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
+                                               WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
+                                               pdFALSE, pdFALSE, pdMS_TO_TICKS(20000));
+        if (bits & WIFI_CONNECTED_BIT) {
+            esp_http_client_config_t config = {};
+            config.url = url;
+            config.method = HTTP_METHOD_POST;
+            config.timeout_ms = 15000;
+            config.crt_bundle_attach = esp_crt_bundle_attach;
+
+            result = FleetReport::RESULT_NO_SEND;
+            esp_http_client_handle_t client = esp_http_client_init(&config);
+            if (client) {
+                esp_http_client_set_header(client, "Content-Type", "application/octet-stream");
+                esp_http_client_set_post_field(client, (const char*)report, (int)len);
+                esp_err_t err = esp_http_client_perform(client);
+                if (err == ESP_OK) {
+                    result = esp_http_client_get_status_code(client);
+                } else {
+                    ESP_LOGE(TAG, "Fleet report upload failed: %s", esp_err_to_name(err));
+                }
+                esp_http_client_cleanup(client);
+            }
+        }
+    }
+    free(report);
+    FleetReport::putResult(result);
+    ESP_LOGI(TAG, "Fleet report result: %d", (int)result);
+
+    // Failing that, a plain restart: nothing is staged any more, so the
+    // boot check below picks the main firmware as usual
+    const esp_partition_t* app = esp_partition_find_first(
+        ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!app || esp_ota_set_boot_partition(app) != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot boot back to %s", label);
+    }
+    vTaskDelay(pdMS_TO_TICKS(100));
+    esp_restart();
+}
+
 // ============================================================
 // Main
 // ============================================================
 extern "C" void app_main(void) {
+    // A report staged by the main app comes first: upload and go back
+    fleet_report_upload();
+
     // ----------------------------------------------------------------
     // Boot check: Only stay in recovery if GPIO 18 is held
     // Otherwise, return to main firmware partition
@@ -2274,30 +1866,22 @@ extern "C" void app_main(void) {
         ESP_LOGI(TAG, "OTA target: %s (%u KB)", next->label, (unsigned)(next->size / 1024));
     }
     
-    // Initialize WiFi
-    init_wifi();
-    
-    // Start DNS server for captive portal
-    start_dns_server();
-    
-    // Start web server
-    start_webserver();
-    
-    // Try to connect to stored WiFi if available
-    if (strlen(s_stored_ssid) > 0) {
+    // Initialize WiFi: AP, plus STA connecting to the stored network
+    if (s_stored_ssid[0] != '\0') {
         ESP_LOGI(TAG, "Attempting to connect to stored WiFi: %s", s_stored_ssid);
-        // Connect in background so we don't block
-        xTaskCreate([](void* param) {
-            vTaskDelay(pdMS_TO_TICKS(2000));  // Wait for AP to stabilize
-            connect_to_wifi(s_stored_ssid, s_stored_pass);
-            vTaskDelete(NULL);
-        }, "auto_connect", 4096, NULL, 5, NULL);
     }
+    init_wifi();
     
     ESP_LOGI(TAG, "Ready!");
     ESP_LOGI(TAG, "Connect to WiFi: %s (password: %s)", AP_SSID, AP_PASSWORD);
     ESP_LOGI(TAG, "Then open http://192.168.4.1 in your browser");
     
+    // DNS and web server start with the first client (AP association or
+    // STA address); nothing needs them before that
+    xEventGroupWaitBits(s_wifi_event_group, WEB_START_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
+    start_dns_server();
+    start_webserver();
+    
     // Main loop - just keep running
     while (true) {
         vTaskDelay(pdMS_TO_TICKS(1000));
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""Converts a btsnoop HCI log of an A2DP stream into a benchmark capture.
+
+Takes the codec configuration from the AVDTP SET_CONFIGURATION (or
+RECONFIGURE) the source sent, and the media packets received on the AVDTP
+media channel after it, RTP header included. Only the first stream is
+written; a later configuration ends the capture.
+
+    python tools/btsnoop_to_a2dp.py btsnoop_hci.log benchmark/captures/aptx.a2dp
+"""
+
+import struct
+import sys
+
+MAGIC = b'A2DC'
+VERSION = 1
+
+DATALINK_H1 = 1001     # HCI packets, type from the record flags
+DATALINK_H4 = 1002     # HCI UART, type in the first byte
+
+HCI_ACL = 0x02
+L2CAP_SIGNALLING_CID = 0x0001
+L2CAP_CONN_REQ = 0x02
+L2CAP_CONN_RSP = 0x03
+PSM_AVDTP = 0x0019
+
+AVDT_SIG_SETCONFIG = 0x03
+AVDT_SIG_RECONFIG = 0x07
+AVDT_MSG_TYPE_CMD = 0
+AVDT_CAT_CODEC = 0x07
+
+
+def read_records(path):
+    """(received, hci packet type, payload) for every record of the log"""
+    with open(path, 'rb') as f:
+        header = f.read(16)
+        if header[:8] != b'btsnoop\0':
+            raise ValueError('%s: not a btsnoop log' % path)
+        _, datalink = struct.unpack('>II', header[8:])
+        while True:
+            rec = f.read(24)
+            if len(rec) < 24:
+                return
+            _, incl_len, flags, _, _ = struct.unpack('>IIIIQ', rec)
+            data = f.read(incl_len)
+            received = bool(flags & 1)
+            if datalink == DATALINK_H4:
+                if data:
+                    yield received, data[0], data[1:]
+            elif datalink == DATALINK_H1:
+                yield received, (0x04 if flags & 2 else HCI_ACL), data
+            else:
+                raise ValueError('%s: unsupported datalink %d' % (path, datalink))
+
+
+def l2cap_frames(path):
+    """(received, acl handle, cid, payload) of reassembled L2CAP frames"""
+    pending = {}
+    for received, kind, data in read_records(path):
+        if kind != HCI_ACL or len(data) < 4:
+            continue
+        hdr, length = struct.unpack('<HH', data[:4])
+        handle = hdr & 0x0fff
+        pb = (hdr >> 12) & 0x3
+        body = data[4:4 + length]
+        key = (received, handle)
+        if pb == 0x1:
+            if key not in pending:
+                continue
+            pending[key] += body
+        else:
+            pending[key] = body
+        frame = pending[key]
+        if len(frame) >= 4:
+            l2len, cid = struct.unpack('<HH', frame[:4])
+            if len(frame) >= 4 + l2len:
+                del pending[key]
+                yield received, handle, cid, frame[4:4 + l2len]
+
+
+class Avdtp:
+    """AVDTP channels of each ACL link, signalling first, media next"""
+
+    def __init__(self):
+        self.requests = {}      # (handle, ident) -> requester is sink
+        self.channels = {}      # handle -> [(sink cid, source cid)]
+
+    def signalling(self, received, handle, payload):
+        while len(payload) >= 4:
+            code, ident, length = struct.unpack('<BBH', payload[:4])
+            body = payload[4:4 + length]
+            payload = payload[4 + length:]
+            if code == L2CAP_CONN_REQ and len(body) >= 4:
+                psm, _ = struct.unpack('<HH', body[:4])
+                if psm == PSM_AVDTP:
+                    self.requests[(handle, ident)] = not received
+            elif code == L2CAP_CONN_RSP and len(body) >= 8:
+                by_sink = self.requests.pop((handle, ident), None)
+                dcid, scid, result, _ = struct.unpack('<HHHH', body[:8])
+                if by_sink is None or result != 0:
+                    continue
+                # Destination CID is the responder's, source CID the requester's
+                pair = (scid, dcid) if by_sink else (dcid, scid)
+                self.channels.setdefault(handle, []).append(pair)
+
+    def kind(self, handle, cid, received):
+        for i, (sink_cid, source_cid) in enumerate(self.channels.get(handle, [])[:2]):
+            if cid == (sink_cid if received else source_cid):
+                return 'signalling' if i == 0 else 'media'
+        return None
+
+
+def codec_info_of(payload):
+    """LOSC-prefixed codec info of a SET_CONFIGURATION/RECONFIGURE command"""
+    if len(payload) < 3:
+        return None
+    msg_type = payload[0] & 0x3
+    packet_type = (payload[0] >> 2) & 0x3
+    signal = payload[1] & 0x3f
+    if packet_type != 0 or msg_type != AVDT_MSG_TYPE_CMD:
+        return None
+    if signal == AVDT_SIG_SETCONFIG:
+        caps = payload[4:]
+    elif signal == AVDT_SIG_RECONFIG:
+        caps = payload[3:]
+    else:
+        return None
+    while len(caps) >= 2:
+        category, losc = caps[0], caps[1]
+        if category == AVDT_CAT_CODEC:
+            return bytes([losc]) + caps[2:2 + losc]
+        caps = caps[2 + losc:]
+    return None
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(__doc__.strip())
+        return 2
+    avdtp = Avdtp()
+    codec_info = None
+    packets = []
+    for received, handle, cid, payload in l2cap_frames(sys.argv[1]):
+        if cid == L2CAP_SIGNALLING_CID:
+            avdtp.signalling(received, handle, payload)
+            continue
+        kind = avdtp.kind(handle, cid, received)
+        if kind == 'signalling':
+            info = codec_info_of(payload)
+            if info is not None:
+                if packets:
+                    break
+                codec_info = info
+        elif kind == 'media' and received and codec_info is not None:
+            packets.append(payload)
+
+    if codec_info is None or not packets:
+        print('%s: no A2DP stream found' % sys.argv[1])
+        return 1
+    with open(sys.argv[2], 'wb') as f:
+        f.write(MAGIC + bytes([VERSION, len(codec_info)]) + codec_info)
+        for pkt in packets:
+            f.write(struct.pack('<H', len(pkt)) + pkt)
+    print('%s: codec type 0x%02x, %d packets' % (sys.argv[2], codec_info[2], len(packets)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
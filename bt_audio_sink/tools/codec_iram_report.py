@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""IRAM/DRAM cost of the codec IRAM profile (main/linker_codec_iram.lf).
+
+Reads the linker map of a build and, for every [mapping:codec_iram_*]
+fragment, sums the input sections of its objects that landed in IRAM
+(.iram0.text) or DRAM (.dram0.data), including IRAM_ATTR/DRAM_ATTR code
+and data those objects carry themselves.
+
+    python tools/codec_iram_report.py build/bt_audio_sink.map
+"""
+
+import os
+import re
+import sys
+
+LF = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'main', 'linker_codec_iram.lf')
+
+IRAM_OUT = '.iram0.text'
+DRAM_OUT = '.dram0.data'
+
+# Section name without the placement-specific prefix
+PREFIX = re.compile(r'^\.(literal|text|rodata|iram1|dram1)\.')
+
+
+def parse_fragments(path):
+    """{codec: {object: set(symbols) or None for the whole object}}"""
+    codecs = {}
+    current = None
+    with open(path) as f:
+        for line in f:
+            line = line.split('#', 1)[0].strip()
+            m = re.match(r'^\[mapping:codec_iram_(\w+)\]$', line)
+            if m:
+                current = codecs.setdefault(m.group(1), {})
+                continue
+            if current is None or not line.endswith(')') or line.startswith('if '):
+                continue
+            entry = line.rsplit('(', 1)[0].strip()
+            if ':' in entry:
+                obj, sym = (s.strip() for s in entry.split(':', 1))
+                syms = current.setdefault(obj, set())
+                if syms is not None:
+                    syms.add(sym)
+            else:
+                current[entry] = None
+    return codecs
+
+
+def parse_map(path):
+    """[(output section, input section, size, object file)] from libbt.a"""
+    placed = []
+    out = None
+    pending = None
+    with open(path) as f:
+        for raw in f:
+            line = raw.rstrip('\n')
+            m = re.match(r'^(\.\S+)', line)
+            if m:
+                out = m.group(1).split()[0]
+                pending = None
+                continue
+            m = re.match(r'^ (\.\S+)\s*$', line)
+            if m:
+                pending = m.group(1)     # Long name, address and size follow
+                continue
+            m = re.match(r'^ (\.\S+)?\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+\S*libbt\.a\(([^)]+)\)', line)
+            if m:
+                name = m.group(1) or pending
+                pending = None
+                if name and out in (IRAM_OUT, DRAM_OUT):
+                    placed.append((out, name, int(m.group(3), 16), m.group(4)))
+                continue
+            pending = None
+    return placed
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(__doc__.strip())
+        return 2
+    codecs = parse_fragments(LF)
+    placed = parse_map(sys.argv[1])
+
+    total_iram = total_dram = 0
+    print('%-6s %10s %10s' % ('codec', 'IRAM', 'DRAM'))
+    for codec, objects in codecs.items():
+        iram = dram = 0
+        for out, name, size, objfile in placed:
+            obj = objfile.split('.', 1)[0]
+            if obj not in objects:
+                continue
+            syms = objects[obj]
+            base = PREFIX.sub('', name)
+            attr = name.startswith(('.iram1', '.dram1'))
+            if syms is not None and not attr and base not in syms:
+                continue
+            if out == IRAM_OUT:
+                iram += size
+            else:
+                dram += size
+        total_iram += iram
+        total_dram += dram
+        print('%-6s %10d %10d' % (codec, iram, dram))
+    print('%-6s %10d %10d' % ('total', total_iram, total_dram))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Image size, memory and boot time per codec profile (CODEC_PROFILE).
+
+Builds the app once per profile, each in its own build directory with the
+profile set on top of the project's sdkconfig defaults, and prints the
+application binary size with the flash and IRAM/DRAM use esp-idf-size
+reports for it:
+
+    python tools/codec_profile_report.py
+    python tools/codec_profile_report.py --profiles full sbc --defaults sdkconfig.defaults
+
+Boot time comes from console captures of each build (idf.py -B <dir> flash
+monitor), read for the BootGraph lines "Boot: connectable at N ms":
+
+    python tools/codec_profile_report.py --no-build --boot-log full=full.log sbc=sbc.log
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+
+PROJECT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+PROFILES = ('full', 'hifi', 'phone', 'sbc')
+CONNECTABLE = re.compile(r'Boot: connectable at (\d+) ms')
+CODECS = re.compile(r'Codec profile (\w+): (.*)$')
+
+
+def build_dir(args, profile):
+    return os.path.join(args.build_root, 'build_profile_' + profile)
+
+
+def build(args, profile):
+    out = build_dir(args, profile)
+    os.makedirs(out, exist_ok=True)
+    overlay = os.path.join(out, 'sdkconfig.profile')
+    with open(overlay, 'w') as f:
+        f.write('CONFIG_CODEC_PROFILE_%s=y\n' % profile.upper())
+    defaults = [d for d in args.defaults if os.path.exists(os.path.join(PROJECT, d))]
+    defaults = [os.path.join(PROJECT, d) for d in defaults] + [overlay]
+    # A fresh sdkconfig per build dir, so the profile is not overridden by
+    # whatever the last menuconfig saved
+    sdkconfig = os.path.join(out, 'sdkconfig')
+    if os.path.exists(sdkconfig):
+        os.remove(sdkconfig)
+    cmd = ['idf.py', '-C', PROJECT, '-B', out,
+           '-D', 'SDKCONFIG=' + sdkconfig,
+           '-D', 'SDKCONFIG_DEFAULTS=' + ';'.join(defaults), 'build']
+    print('== %s: %s' % (profile, ' '.join(cmd)), file=sys.stderr)
+    subprocess.run(cmd, check=True, stdout=None if args.verbose else subprocess.DEVNULL)
+
+
+def image_size(out):
+    with open(os.path.join(out, 'project_description.json')) as f:
+        desc = json.load(f)
+    return os.path.getsize(os.path.join(out, desc['app_bin']))
+
+
+def memory(out):
+    """{'flash': bytes, 'iram': bytes, 'dram': bytes} from esp-idf-size"""
+    res = subprocess.run(['idf.py', '-C', PROJECT, '-B', out, 'size', '--format', 'json2'],
+                         check=True, capture_output=True, text=True)
+    text = res.stdout[res.stdout.find('{'):]
+    data = json.loads(text)
+    used = {'flash': 0, 'iram': 0, 'dram': 0}
+    for region in data.get('layout', []):
+        name = region.get('name', '').lower()
+        for key in used:
+            if name.startswith(key):
+                used[key] += region.get('used', 0)
+    return used
+
+
+def boot_log(path):
+    """(connectable ms, codec list) from the last boot in a capture"""
+    ms, codecs = None, ''
+    with open(path, errors='replace') as f:
+        for line in f:
+            m = CONNECTABLE.search(line)
+            if m:
+                ms = int(m.group(1))
+            m = CODECS.search(line)
+            if m:
+                codecs = m.group(2).strip()
+    return ms, codecs
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('--profiles', nargs='+', choices=PROFILES, default=list(PROFILES))
+    ap.add_argument('--defaults', nargs='+', default=['sdkconfig.defaults'],
+                    help='sdkconfig defaults under the project, before the profile')
+    ap.add_argument('--build-root', default=PROJECT, help='where the build_profile_* dirs go')
+    ap.add_argument('--no-build', action='store_true', help='report on existing builds only')
+    ap.add_argument('--boot-log', nargs='+', default=[], metavar='PROFILE=LOG',
+                    help='console capture of a boot of that profile')
+    ap.add_argument('--verbose', action='store_true', help='show the build output')
+    args = ap.parse_args()
+
+    logs = {}
+    for item in args.boot_log:
+        profile, _, path = item.partition('=')
+        if profile not in PROFILES or not path:
+            ap.error('--boot-log wants PROFILE=LOG, got %r' % item)
+        logs[profile] = path
+
+    rows = []
+    for profile in args.profiles:
+        out = build_dir(args, profile)
+        if not args.no_build:
+            build(args, profile)
+        if not os.path.exists(os.path.join(out, 'project_description.json')):
+            print('%s: no build in %s' % (profile, out), file=sys.stderr)
+            continue
+        mem = memory(out)
+        ms, codecs = boot_log(logs[profile]) if profile in logs else (None, '')
+        rows.append((profile, image_size(out), mem, ms, codecs))
+    if not rows:
+        sys.exit('nothing to report')
+
+    base = rows[0]
+    print('%-8s %10s %9s %9s %9s %10s  %s' % ('profile', 'image', 'flash', 'iram', 'dram',
+                                              'connect', 'codecs'))
+    for profile, size, mem, ms, codecs in rows:
+        delta = '' if profile == base[0] else ' (%+d)' % (size - base[1])
+        print('%-8s %10d %9d %9d %9d %10s  %s%s' % (
+            profile, size, mem['flash'], mem['iram'], mem['dram'],
+            '%d ms' % ms if ms is not None else '-', codecs, delta))
+
+
+if __name__ == '__main__':
+    main()
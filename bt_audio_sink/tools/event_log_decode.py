@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Binary event log (main/core/event_log.h) back to text.
+
+Reads a console capture (or stdin) and decodes its ELOG: lines with the
+event formats from the firmware header:
+
+    idf.py monitor | tee console.log
+    python tools/event_log_decode.py console.log
+    python tools/event_log_decode.py --all console.log     # other lines too
+
+Times are seconds since boot; the device's 32-bit microsecond stamps are
+unwrapped in the order the records come.
+"""
+
+import argparse
+import base64
+import os
+import re
+import struct
+import sys
+
+RECORD = struct.Struct('<IHHII')     # time_us, id, a0, a1, a2
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                      '..', 'main', 'core', 'event_log.h')
+LINE = re.compile(r'ELOG:([A-Za-z0-9+/=]+)')
+
+
+def load_events(path):
+    with open(path) as f:
+        text = f.read()
+    start = text.find('#define EVENT_LOG_EVENTS(X)')
+    if start < 0:
+        sys.exit('%s: no EVENT_LOG_EVENTS table' % path)
+    body = []
+    for line in text[start:].splitlines()[1:]:
+        body.append(line)
+        if not line.rstrip().endswith('\\'):
+            break
+    events = re.findall(r'X\((\w+),\s*"((?:[^"\\]|\\.)*)"\)', '\n'.join(body))
+    if not events:
+        sys.exit('%s: empty EVENT_LOG_EVENTS table' % path)
+    return events
+
+
+def decode(lines, events, show_all, out):
+    wraps = 0
+    last_us = None
+    for line in lines:
+        m = LINE.search(line)
+        if not m:
+            if show_all:
+                out.write(line)
+            continue
+        try:
+            data = base64.b64decode(m.group(1), validate=True)
+        except ValueError:
+            out.write('? bad ELOG line: %s' % line)
+            continue
+        for off in range(0, len(data) - RECORD.size + 1, RECORD.size):
+            time_us, eid, a0, a1, a2 = RECORD.unpack_from(data, off)
+            if last_us is not None and time_us < last_us and last_us - time_us > 1 << 31:
+                wraps += 1
+            last_us = time_us
+            seconds = ((wraps << 32) + time_us) / 1e6
+            if eid < len(events):
+                name, fmt = events[eid]
+                args = (a0, a1, a2)[:fmt.count('%u')]
+                text = fmt % args
+            else:
+                name, text = 'EV_%d' % eid, 'args %u %u %u' % (a0, a1, a2)
+            out.write('%12.6f  %-22s %s\n' % (seconds, name, text))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('log', nargs='?', help='console capture (default: stdin)')
+    ap.add_argument('--header', default=HEADER, help='event_log.h with the event table')
+    ap.add_argument('--all', action='store_true', help='pass other console lines through')
+    args = ap.parse_args()
+
+    events = load_events(args.header)
+    if args.log:
+        with open(args.log, errors='replace') as f:
+            decode(f, events, args.all, sys.stdout)
+    else:
+        decode(sys.stdin, events, args.all, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
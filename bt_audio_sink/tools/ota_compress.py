@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Compressed OTA images (main/ota/ota_compressed.h).
+
+Raw-deflates an app image with a small window, checks that it inflates
+back, and reports the saving:
+
+    python tools/ota_compress.py app.bin app.zimg
+    python tools/ota_compress.py --window-bits 10 app.bin app.zimg
+
+The result is sent like a full image (OTA_BEGIN with the size of the
+.zimg file). The device inflates it with a ring of 2^window_bits bytes,
+which it caps at 4 KB.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+MAGIC = b'ZIMG'
+VERSION = 1
+HEADER = struct.Struct('<4sBBHI')     # 12 bytes
+MAX_WINDOW_BITS = 12
+
+
+def compress(image, window_bits):
+    if len(image) == 0 or image[0] != 0xE9:
+        sys.exit('input is not an app image')
+    comp = zlib.compressobj(9, zlib.DEFLATED, -window_bits, 9)
+    body = comp.compress(image) + comp.flush()
+    return HEADER.pack(MAGIC, VERSION, window_bits, 0, len(image)) + body
+
+
+def decompress(data):
+    magic, version, window_bits, _, size = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        sys.exit('not a compressed image')
+    image = zlib.decompress(data[HEADER.size:], -window_bits)
+    if len(image) != size:
+        sys.exit('inflates to %d bytes, header says %d' % (len(image), size))
+    return image
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--window-bits', type=int, default=MAX_WINDOW_BITS,
+                        help='deflate window, 9..%d (default %%(default)s)' % MAX_WINDOW_BITS)
+    parser.add_argument('image')
+    parser.add_argument('out')
+    args = parser.parse_args()
+    if not 9 <= args.window_bits <= MAX_WINDOW_BITS:
+        sys.exit('window bits must be 9..%d' % MAX_WINDOW_BITS)
+
+    with open(args.image, 'rb') as f:
+        image = f.read()
+    data = compress(image, args.window_bits)
+    if decompress(data) != image:
+        sys.exit('round trip failed')
+    with open(args.out, 'wb') as f:
+        f.write(data)
+    print('%s: %d bytes, %.0f%% smaller than the %d-byte image'
+          % (args.out, len(data), 100.0 * (len(image) - len(data)) / len(image), len(image)))
+
+
+if __name__ == '__main__':
+    main()
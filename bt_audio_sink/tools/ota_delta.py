@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""Delta OTA patches (main/ota/ota_delta.h) between two app images.
+
+Makes a patch that turns the base image (the firmware running on the
+device) into the target image, checks it by applying it, and reports
+the size against the full image:
+
+    python tools/ota_delta.py base.bin target.bin update.patch
+    python tools/ota_delta.py --apply base.bin update.patch out.bin
+
+The patch is sent like a full image (OTA_BEGIN with its size). The
+device checks the base digest before writing anything, and checks the
+target digest when the patch ends.
+
+Matching is bsdiff-like: exact seeds of SEED bytes, each extended for
+as long as it matches more than it differs. The differences go into a
+DIFF op as bytewise deltas, which are mostly zero for code that only
+moved. Anything left over goes into an ADD op. The op stream is
+raw-deflated for the ROM inflater.
+"""
+
+import hashlib
+import struct
+import sys
+import zlib
+
+MAGIC = b'BTDP'
+VERSION = 1
+HEADER = struct.Struct('<4sBBHII32s32s')   # 80 bytes
+
+OP_ADD = 0x00
+OP_DIFF = 0x01
+OP_END = 0xFF
+
+SEED = 16           # Exact match that starts a DIFF
+INDEX_STEP = 4      # Base offsets indexed; seeds are found at any alignment
+GIVE_UP = 32        # Mismatches beyond the best point that end a DIFF
+MIN_DIFF = 24       # Shorter DIFF ops cost more than their ADD
+
+
+def base_digest(image):
+    """The digest ESP-IDF appends to an app image, as esp_partition_get_sha256 reports it"""
+    if len(image) < 64 or image[0] != 0xE9:
+        sys.exit('base is not an app image')
+    digest = image[-32:]
+    if hashlib.sha256(image[:-32]).digest() != digest:
+        sys.exit('base image has no appended SHA-256 (CONFIG_APP_..._HASH disabled?)')
+    return digest
+
+
+def build_index(base):
+    index = {}
+    for i in range(0, len(base) - SEED + 1, INDEX_STEP):
+        index.setdefault(base[i:i + SEED], i)
+    return index
+
+
+def extend(base, target, src, pos):
+    """Length of the DIFF at (src, pos) maximising matches - mismatches"""
+    limit = min(len(base) - src, len(target) - pos)
+    best_len = best = score = 0
+    i = 0
+    while i < limit:
+        # Equal runs in slices first: far faster than bytewise in Python
+        run = 0
+        while i + run + 64 <= limit and base[src + i + run:src + i + run + 64] == target[pos + i + run:pos + i + run + 64]:
+            run += 64
+        if run:
+            i += run
+            score += run
+        elif base[src + i] == target[pos + i]:
+            i += 1
+            score += 1
+        else:
+            i += 1
+            score -= 1
+        if score > best:
+            best, best_len = score, i
+        elif best - score > GIVE_UP:
+            break
+    return best_len
+
+
+def make_ops(base, target):
+    index = build_index(base)
+    ops = []
+    lit = 0             # Start of target bytes not covered yet
+    pos = 0
+    end = len(target) - SEED
+    while pos <= end:
+        src = index.get(target[pos:pos + SEED])
+        if src is None:
+            pos += 1
+            continue
+        # Grow back into the pending literal while bytes match
+        while pos > lit and src > 0 and base[src - 1] == target[pos - 1]:
+            pos -= 1
+            src -= 1
+        n = extend(base, target, src, pos)
+        if n < MIN_DIFF:
+            pos += 1
+            continue
+        if pos > lit:
+            ops.append((OP_ADD, target[lit:pos]))
+        delta = bytes((t - b) & 0xFF for t, b in zip(target[pos:pos + n], base[src:src + n]))
+        ops.append((OP_DIFF, src, delta))
+        pos += n
+        lit = pos
+    if lit < len(target):
+        ops.append((OP_ADD, target[lit:]))
+    return ops
+
+
+def encode(ops):
+    out = bytearray()
+    for op in ops:
+        if op[0] == OP_ADD:
+            out += struct.pack('<BI', OP_ADD, len(op[1])) + op[1]
+        else:
+            out += struct.pack('<BII', OP_DIFF, len(op[2]), op[1]) + op[2]
+    out.append(OP_END)
+    comp = zlib.compressobj(9, zlib.DEFLATED, -15, 9)
+    return comp.compress(bytes(out)) + comp.flush()
+
+
+def make_patch(base, target):
+    header = HEADER.pack(MAGIC, VERSION, 0, 0, len(base), len(target),
+                         base_digest(base), hashlib.sha256(target).digest())
+    return header + encode(make_ops(base, target))
+
+
+def apply_patch(base, patch):
+    magic, version, _, _, base_size, target_size, base_sha, target_sha = HEADER.unpack_from(patch)
+    if magic != MAGIC or version != VERSION:
+        sys.exit('not a delta patch')
+    if base_size != len(base) or base_digest(base) != base_sha:
+        sys.exit('patch is for another base image')
+    ops = zlib.decompress(patch[HEADER.size:], -15)
+    out = bytearray()
+    i = 0
+    while ops[i] != OP_END:
+        op = ops[i]
+        if op == OP_ADD:
+            (n,) = struct.unpack_from('<I', ops, i + 1)
+            i += 5
+            out += ops[i:i + n]
+        elif op == OP_DIFF:
+            n, src = struct.unpack_from('<II', ops, i + 1)
+            i += 9
+            out += bytes((b + d) & 0xFF for b, d in zip(base[src:src + n], ops[i:i + n]))
+        else:
+            sys.exit('bad op 0x%02X' % op)
+        i += n
+    if len(out) != target_size or hashlib.sha256(out).digest() != target_sha:
+        sys.exit('patch does not produce its target')
+    return bytes(out)
+
+
+def read(path):
+    with open(path, 'rb') as f:
+        return f.read()
+
+
+def main(argv):
+    if len(argv) == 5 and argv[1] == '--apply':
+        with open(argv[4], 'wb') as f:
+            f.write(apply_patch(read(argv[2]), read(argv[3])))
+        return
+    if len(argv) != 4:
+        sys.exit(__doc__)
+    base, target = read(argv[1]), read(argv[2])
+    patch = make_patch(base, target)
+    apply_patch(base, patch)
+    with open(argv[3], 'wb') as f:
+        f.write(patch)
+    print('%s: %d bytes, %.1fx smaller than the %d-byte image'
+          % (argv[3], len(patch), len(target) / len(patch), len(target)))
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""Frozen PCM capture image (main/audio/pcm_capture.h) to WAV files.
+
+Reads an image saved from BLE request 0xFA (op 3 reads, concatenated by
+offset) and writes the pre-DSP stream and the post-DSP output as WAV
+files, with the glitch markers listed against the trigger:
+
+    python tools/pcm_capture_to_wav.py capture.bin
+    python tools/pcm_capture_to_wav.py capture.bin -o out/ --prefix glitch1
+
+Each stream starts a new file whenever its format or rate changed
+within the capture (capture_pre_0.wav, capture_pre_1.wav, ...).
+Post-DSP blocks are Q31 stereo and come out as 32-bit WAV; 24-bit input
+is written left-justified in 32 bits as well.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import wave
+
+HEADER = struct.Struct('<4sBBHIII')     # magic, version, reason, markers, records, trigger, image
+RECORD = struct.Struct('<IBBBxIII')     # bytes, kind, fmt, channels, time_us, rate, frame_index
+MARKER = struct.Struct('<IBxH')         # time_us, type, queue_ms
+
+KIND_PRE, KIND_POST = 1, 2
+FMT_NAMES = ('s16', 's24', 's24in32', 's32')
+MARK_NAMES = {1: 'underrun', 2: 'drop', 3: 'short write', 4: 'decode error', 5: 'queue full',
+              6: 'memory flush', 0x80: 'deadline miss', 0x81: 'manual'}
+
+
+def glitch_names(path):
+    """GlitchType values from the firmware header, if it is there"""
+    names = dict(MARK_NAMES)
+    try:
+        with open(path) as f:
+            text = f.read()
+    except OSError:
+        return names
+    start = text.find('enum GlitchType')
+    if start < 0:
+        return names
+    body = text[text.find('{', start) + 1:text.find('}', start)]
+    value = 0
+    for item in body.split(','):
+        item = item.split('//')[0].strip()
+        if not item.startswith('GLITCH_'):
+            continue
+        name, _, expr = item.partition('=')
+        if expr.strip():
+            value = int(expr.strip(), 0)
+        names[value] = name.strip()[len('GLITCH_'):].lower().replace('_', ' ')
+        value += 1
+    return names
+
+
+def to_s32(fmt, data):
+    """Interleaved samples of a pre-DSP format as (sample width, bytes)"""
+    if fmt == 0:
+        return 2, data
+    if fmt == 1:
+        return 3, data
+    if fmt == 2:
+        n = len(data) // 4
+        vals = struct.unpack('<%di' % n, data[:n * 4])
+        # Right-justified 24 bits: sign-extend from bit 23, then to the top
+        return 4, struct.pack('<%di' % n, *[(((v & 0xFFFFFF) ^ 0x800000) - 0x800000) << 8
+                                              for v in vals])
+    return 4, data
+
+
+def parse(image):
+    if len(image) < HEADER.size:
+        sys.exit('image too short (%d bytes)' % len(image))
+    magic, version, reason, markers, records, trigger_us, image_bytes = HEADER.unpack_from(image)
+    if magic != b'ACAP':
+        sys.exit('not a capture image (magic %r)' % magic)
+    if version != 1:
+        sys.exit('capture image version %d, this tool reads 1' % version)
+    if len(image) < image_bytes:
+        sys.exit('image truncated: %d of %d bytes' % (len(image), image_bytes))
+
+    blocks = []
+    off = HEADER.size
+    end = HEADER.size + records
+    while off + RECORD.size <= end:
+        size, kind, fmt, channels, time_us, rate, index = RECORD.unpack_from(image, off)
+        pcm = image[off + RECORD.size:off + RECORD.size + size]
+        blocks.append((kind, fmt, channels, time_us, rate, index, pcm))
+        off += RECORD.size + ((size + 3) & ~3)
+
+    marks = [MARKER.unpack_from(image, end + i * MARKER.size) for i in range(markers)]
+    return reason, trigger_us, blocks, marks
+
+
+def write_wav(path, channels, rate, width, frames):
+    with wave.open(path, 'wb') as w:
+        w.setnchannels(channels)
+        w.setsampwidth(width)
+        w.setframerate(rate)
+        w.writeframes(b''.join(frames))
+    print('wrote %s: %d ch, %d Hz, %d bit' % (path, channels, rate, width * 8))
+
+
+def rel_ms(time_us, trigger_us):
+    """Signed ms from the trigger, across a 32-bit wrap"""
+    d = (time_us - trigger_us) & 0xFFFFFFFF
+    if d >= 1 << 31:
+        d -= 1 << 32
+    return d / 1000.0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('image', help='capture image read over BLE')
+    ap.add_argument('-o', '--out', default='.', help='output directory')
+    ap.add_argument('--prefix', default='capture', help='output file name prefix')
+    ap.add_argument('--header', default=os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                                     '..', 'main', 'audio', 'glitch_journal.h'),
+                    help='glitch_journal.h with the GlitchType names')
+    args = ap.parse_args()
+
+    with open(args.image, 'rb') as f:
+        image = f.read()
+    reason, trigger_us, blocks, marks = parse(image)
+    names = glitch_names(args.header)
+    os.makedirs(args.out, exist_ok=True)
+
+    parts = {KIND_PRE: [], KIND_POST: []}      # kind: [(fmt, channels, rate, [bytes])]
+    for kind, fmt, channels, time_us, rate, index, pcm in blocks:
+        if kind not in parts:
+            continue
+        runs = parts[kind]
+        if not runs or runs[-1][:3] != (fmt, channels, rate):
+            runs.append((fmt, channels, rate, []))
+        runs[-1][3].append(to_s32(fmt, pcm)[1] if kind == KIND_PRE else pcm)
+
+    for kind, tag in ((KIND_PRE, 'pre'), (KIND_POST, 'post')):
+        for i, (fmt, channels, rate, frames) in enumerate(parts[kind]):
+            width = to_s32(fmt, b'')[0] if kind == KIND_PRE else 4
+            print('%s-DSP part %d: %s' % (tag, i, FMT_NAMES[fmt] if fmt < len(FMT_NAMES) else fmt))
+            write_wav(os.path.join(args.out, '%s_%s_%d.wav' % (args.prefix, tag, i)),
+                      channels, rate, width, frames)
+
+    span = rel_ms(blocks[-1][3], blocks[0][3]) if blocks else 0.0
+    print('frozen by %s, %.1f ms captured, %d blocks' %
+          (names.get(reason, 'type %d' % reason), span, len(blocks)))
+    start = rel_ms(blocks[0][3], trigger_us) if blocks else 0.0
+    for time_us, mtype, queue_ms in sorted(marks, key=lambda m: rel_ms(m[0], trigger_us)):
+        at = rel_ms(time_us, trigger_us)
+        print('%+10.1f ms  (%8.1f ms into the files)  %-14s %u ms queued' %
+              (at, at - start, names.get(mtype, 'type %d' % mtype), queue_ms))
+
+
+if __name__ == '__main__':
+    main()
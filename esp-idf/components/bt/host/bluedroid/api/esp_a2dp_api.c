@@ -11,6 +11,7 @@
 #include "esp_bt_main.h"
 #include "btc/btc_manage.h"
 #include "btc_av.h"
+#include "btc_a2dp_sink.h"
 
 #if BTC_AV_INCLUDED
 
@@ -262,6 +263,80 @@ esp_err_t esp_a2d_sink_get_delay_value(void)
     stat = btc_transfer_context(&msg, NULL, 0, NULL, NULL);
     return (stat == BT_STATUS_SUCCESS) ? ESP_OK : ESP_FAIL;
 }
+
+esp_err_t esp_a2d_sink_get_rx_stats(esp_a2d_sink_rx_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    tBTC_A2DP_SINK_RX_STATS rx;
+    if (!btc_a2dp_sink_get_rx_stats(&rx)) {
+        memset(stats, 0, sizeof(*stats));
+        return ESP_ERR_INVALID_STATE;
+    }
+    stats->received = rx.received;
+    stats->dropped = rx.dropped;
+    stats->lost = rx.lost;
+    stats->concealed = rx.concealed;
+    stats->bytes = rx.bytes;
+    stats->pcm_bytes = rx.pcm_bytes;
+    stats->max_len = rx.max_len;
+    stats->mtu = rx.mtu;
+    return ESP_OK;
+}
+
+esp_err_t esp_a2d_sink_read_link(esp_bd_addr_t remote_bda)
+{
+    if (esp_bluedroid_get_status() != ESP_BLUEDROID_STATUS_ENABLED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    btc_a2dp_sink_read_link(remote_bda);
+    return ESP_OK;
+}
+
+esp_err_t esp_a2d_sink_get_link_stats(esp_a2d_sink_link_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    tBTC_A2DP_SINK_LINK_STATS link;
+    btc_a2dp_sink_get_link_stats(&link);
+    stats->rssi = link.rssi;
+    stats->link_quality = link.link_quality;
+    stats->rssi_readings = link.rssi_readings;
+    stats->quality_readings = link.quality_readings;
+    return ESP_OK;
+}
+
+esp_err_t esp_a2d_sink_set_rx_queue_limit(uint16_t packets)
+{
+    btc_a2dp_sink_set_rx_queue_limit(packets);
+    return ESP_OK;
+}
+
+esp_err_t esp_a2d_sink_set_decode_level(uint8_t level)
+{
+    btc_a2dp_sink_set_decode_level(level);
+    return ESP_OK;
+}
+
+esp_err_t esp_a2d_sink_set_pull_decode(bool enable)
+{
+    btc_a2dp_sink_set_pull_mode(enable);
+    return ESP_OK;
+}
+
+uint16_t esp_a2d_sink_pull_decode(uint16_t max_packets)
+{
+    return btc_a2dp_sink_pull_decode(max_packets);
+}
+
+uint16_t esp_a2d_sink_get_queued(void)
+{
+    return btc_a2dp_sink_get_queue_depth();
+}
 #endif /* BTC_AV_SINK_INCLUDED */
 
 esp_err_t esp_a2d_register_callback(esp_a2d_cb_t callback)
@@ -0,0 +1,163 @@
+/*
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include "esp_bt_main.h"
+#include "esp_ble_l2cap_coc_api.h"
+#include "common/bt_target.h"
+#include "common/bt_defs.h"
+#include "osi/allocator.h"
+#include "stack/l2c_api.h"
+#include "stack/l2cdefs.h"
+
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+
+/* The server: one channel at a time, state on the BTU task only */
+static esp_ble_l2cap_coc_cb_t s_coc_cb;
+static tL2CAP_LE_CFG_INFO s_coc_cfg;
+static UINT16 s_coc_lcid;
+
+static void coc_connect_ind(BD_ADDR bd_addr, UINT16 lcid, UINT16 psm, UINT8 id)
+{
+    esp_ble_l2cap_coc_cb_param_t param;
+    tL2CAP_LE_CFG_INFO cfg = s_coc_cfg;
+    tL2CAP_LE_CFG_INFO peer_cfg;
+    UINT16 result = (s_coc_lcid == 0) ? L2CAP_CONN_OK : L2CAP_LE_RESULT_NO_RESOURCES;
+    UNUSED(psm);
+
+    if (!L2CA_ConnectLECocRsp(bd_addr, id, lcid, result, 0, &cfg) || result != L2CAP_CONN_OK ||
+        !L2CA_GetPeerLECocConfig(lcid, &peer_cfg)) {
+        return;
+    }
+
+    s_coc_lcid = lcid;
+    memset(&param, 0, sizeof(param));
+    param.open.lcid = lcid;
+    memcpy(param.open.bda, bd_addr, sizeof(esp_bd_addr_t));
+    param.open.peer_mtu = peer_cfg.mtu;
+    param.open.peer_mps = peer_cfg.mps;
+    s_coc_cb(ESP_BLE_L2CAP_COC_OPEN_EVT, &param);
+}
+
+static void coc_data_ind(UINT16 lcid, BT_HDR *p_buf)
+{
+    esp_ble_l2cap_coc_cb_param_t param;
+
+    if (lcid == s_coc_lcid) {
+        param.data.lcid = lcid;
+        param.data.data = (const uint8_t *)(p_buf + 1) + p_buf->offset;
+        param.data.len = p_buf->len;
+        param.data.frames = p_buf->layer_specific;
+        s_coc_cb(ESP_BLE_L2CAP_COC_DATA_EVT, &param);
+    }
+    osi_free(p_buf);
+}
+
+static void coc_congestion(UINT16 lcid, BOOLEAN congested)
+{
+    esp_ble_l2cap_coc_cb_param_t param;
+
+    if (lcid != s_coc_lcid) {
+        return;
+    }
+    param.cong.lcid = lcid;
+    param.cong.congested = congested;
+    s_coc_cb(ESP_BLE_L2CAP_COC_CONG_EVT, &param);
+}
+
+static void coc_disconnect_ind(UINT16 lcid, BOOLEAN ack_needed)
+{
+    esp_ble_l2cap_coc_cb_param_t param;
+    UNUSED(ack_needed);
+
+    if (lcid != s_coc_lcid) {
+        return;
+    }
+    s_coc_lcid = 0;
+    param.close.lcid = lcid;
+    s_coc_cb(ESP_BLE_L2CAP_COC_CLOSE_EVT, &param);
+}
+
+esp_err_t esp_ble_l2cap_coc_server_register(uint16_t psm, uint16_t mtu, uint16_t mps, uint16_t credits,
+                                            esp_ble_l2cap_coc_cb_t callback)
+{
+    static tL2CAP_APPL_INFO appl_info;
+    ESP_BLUEDROID_STATUS_CHECK(ESP_BLUEDROID_STATUS_ENABLED);
+
+    if (callback == NULL || !L2C_IS_VALID_LE_PSM(psm) || mtu < 23 || mps < 23 || mps > 65533) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_coc_cb = callback;
+    s_coc_cfg.mtu = mtu;
+    s_coc_cfg.mps = mps;
+    s_coc_cfg.credits = credits;
+
+    memset(&appl_info, 0, sizeof(appl_info));
+    appl_info.pL2CA_ConnectInd_Cb = coc_connect_ind;
+    appl_info.pL2CA_DataInd_Cb = coc_data_ind;
+    appl_info.pL2CA_CongestionStatus_Cb = coc_congestion;
+    appl_info.pL2CA_DisconnectInd_Cb = coc_disconnect_ind;
+
+    return (L2CA_RegisterLECoc(psm, &appl_info) == psm) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_ble_l2cap_coc_give_credits(uint16_t lcid, uint16_t credits)
+{
+    ESP_BLUEDROID_STATUS_CHECK(ESP_BLUEDROID_STATUS_ENABLED);
+
+    return L2CA_LECocPost(L2CA_LE_COC_OP_CREDITS, lcid, credits, NULL) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_ble_l2cap_coc_write(uint16_t lcid, const uint8_t *data, uint16_t len)
+{
+    BT_HDR *p_buf;
+    ESP_BLUEDROID_STATUS_CHECK(ESP_BLUEDROID_STATUS_ENABLED);
+
+    if ((p_buf = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + len)) == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    p_buf->event = 0;
+    p_buf->offset = 0;
+    p_buf->len = len;
+    p_buf->layer_specific = 0;
+    memcpy(p_buf + 1, data, len);
+
+    return L2CA_LECocPost(L2CA_LE_COC_OP_WRITE, lcid, 0, p_buf) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_ble_l2cap_coc_disconnect(uint16_t lcid)
+{
+    ESP_BLUEDROID_STATUS_CHECK(ESP_BLUEDROID_STATUS_ENABLED);
+
+    return L2CA_LECocPost(L2CA_LE_COC_OP_DISCONNECT, lcid, 0, NULL) ? ESP_OK : ESP_FAIL;
+}
+
+#else
+
+esp_err_t esp_ble_l2cap_coc_server_register(uint16_t psm, uint16_t mtu, uint16_t mps, uint16_t credits,
+                                            esp_ble_l2cap_coc_cb_t callback)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_ble_l2cap_coc_give_credits(uint16_t lcid, uint16_t credits)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_ble_l2cap_coc_write(uint16_t lcid, const uint8_t *data, uint16_t len)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_ble_l2cap_coc_disconnect(uint16_t lcid)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif  ///BLE_L2CAP_COC_INCLUDED == TRUE
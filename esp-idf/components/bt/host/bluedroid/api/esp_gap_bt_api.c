@@ -497,6 +497,31 @@ esp_err_t esp_bt_gap_get_page_timeout(void)
     return (btc_transfer_context(&msg, NULL, 0, NULL, NULL) == BT_STATUS_SUCCESS ? ESP_OK : ESP_FAIL);
 }
 
+esp_err_t esp_bt_gap_set_page_scan_param(esp_bt_page_scan_type_t type, uint16_t interval, uint16_t window)
+{
+    btc_msg_t msg;
+    btc_gap_bt_args_t arg;
+
+    if (esp_bluedroid_get_status() != ESP_BLUEDROID_STATUS_ENABLED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (type > ESP_BT_PAGE_SCAN_INTERLACED ||
+        interval < HCI_MIN_PAGESCAN_INTERVAL || interval > HCI_MAX_PAGESCAN_INTERVAL ||
+        window < HCI_MIN_PAGESCAN_WINDOW || window > HCI_MAX_PAGESCAN_WINDOW ||
+        window > interval) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    msg.sig = BTC_SIG_API_CALL;
+    msg.pid = BTC_PID_GAP_BT;
+    msg.act = BTC_GAP_BT_ACT_SET_PAGE_SCAN_PARAM;
+
+    arg.set_page_scan.type = type;
+    arg.set_page_scan.interval = interval;
+    arg.set_page_scan.window = window;
+    return (btc_transfer_context(&msg, &arg, sizeof(btc_gap_bt_args_t), NULL, NULL) == BT_STATUS_SUCCESS ? ESP_OK : ESP_FAIL);
+}
+
 esp_err_t esp_bt_gap_set_acl_pkt_types(esp_bd_addr_t remote_bda, uint16_t pkt_types)
 {
     btc_msg_t msg;
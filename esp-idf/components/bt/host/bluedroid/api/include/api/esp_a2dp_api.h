@@ -513,8 +513,11 @@ esp_err_t esp_a2d_sink_disconnect(esp_bd_addr_t remote_bda);
  *
  * @brief           Set delay reporting value. The delay value of sink is caused by buffering (including
  *                  protocol stack and application layer), decoding and rendering. The default delay
- *                  value is 120ms, if the set value is less than 120ms, the setting will fail. This API
- *                  must be called after esp_a2d_sink_init() and before esp_a2d_sink_deinit().
+ *                  value is 120ms; any non-zero value may be set, so a sink that measures its own
+ *                  latency can report it exactly. The value is reported to the connected source at
+ *                  once if it configured delay reporting, and to every source configuring a stream
+ *                  after that. This API must be called after esp_a2d_sink_init() and before
+ *                  esp_a2d_sink_deinit().
  *
  * @param[in]       delay_value: reporting value is in 1/10 millisecond
  *
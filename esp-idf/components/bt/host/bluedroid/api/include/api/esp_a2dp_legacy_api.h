@@ -56,6 +56,258 @@ typedef int32_t (* esp_a2d_source_data_cb_t)(uint8_t *buf, int32_t len);
  */
 esp_err_t esp_a2d_sink_register_data_callback(esp_a2d_sink_data_cb_t callback);
 
+/**
+ * @brief           Decode timing hook, called in the A2DP sink task after every media packet
+ *                  the decoder processed, with the CPU cycles (esp_cpu_get_cycle_count) the
+ *                  decoder spent on it. The stack provides an empty weak definition; define
+ *                  it in the application to collect decode statistics. It must not block.
+ *
+ * @param[in]       cycles: CPU cycles spent in decode_packet() for this packet
+ *
+ */
+void esp_a2d_sink_decode_trace_hook(uint32_t cycles);
+
+/**
+ * @brief           Media timing hook, called in the A2DP sink task just before a media packet
+ *                  is decoded. The stack provides an empty weak definition; define it in the
+ *                  application to follow packets through its own buffering. It must not block.
+ *
+ * @param[in]       rtp_ts: RTP timestamp from the packet's media header
+ * @param[in]       arrival_us: low 32 bits of esp_timer_get_time() when the packet was
+ *                  queued to the sink task (btc_a2dp_sink_enque_buf)
+ *
+ */
+void esp_a2d_sink_media_stamp_hook(uint32_t rtp_ts, uint32_t arrival_us);
+
+/**
+ * @brief           PCM buffer hook, called in the A2DP sink task at the start of every decode
+ *                  batch. The application may lend a buffer of at least min_len bytes; the
+ *                  batch is then decoded straight into it and delivered through the data
+ *                  callback with that same pointer, so it needs no copy there. A lent buffer
+ *                  that ends up unused is given back with esp_a2d_sink_pcm_buffer_return_hook.
+ *                  The stack provides a weak definition that lends nothing (the sink decodes
+ *                  into its own buffer). It must not block.
+ *
+ * @param[in]       min_len: PCM bytes one media packet of the current codec may need
+ * @param[out]      size: usable size of the returned buffer
+ *
+ * @return          the buffer, or NULL to decode into the sink's own buffer
+ *
+ */
+unsigned char *esp_a2d_sink_pcm_buffer_hook(size_t min_len, size_t *size);
+
+/**
+ * @brief           Gives back a buffer from esp_a2d_sink_pcm_buffer_hook that was not delivered
+ *                  (the batch was empty or flushed). The stack provides an empty weak definition.
+ *
+ * @param[in]       buf: the buffer esp_a2d_sink_pcm_buffer_hook returned
+ *
+ */
+void esp_a2d_sink_pcm_buffer_return_hook(unsigned char *buf);
+
+/**
+ * @brief           Memory pressure hook, called before the A2DP sink drops queued media
+ *                  packets to free internal RAM: from btc_a2dp_sink_enque_buf when free
+ *                  internal RAM is low, and from the HCI layer when an allocation failed.
+ *                  The stack provides a weak definition that always allows the drop; define
+ *                  it in the application to relieve memory elsewhere first. When it returns
+ *                  false after a failed allocation the sink still drops a couple of packets so
+ *                  the allocation can be retried. It must not block.
+ *
+ * @param[in]       free_internal: free internal RAM in bytes
+ * @param[in]       alloc_failed: true if a lower-layer allocation just failed
+ *
+ * @return          true to let the sink drop packets now, false to keep them
+ *
+ */
+bool esp_a2d_sink_memory_pressure_hook(size_t free_internal, bool alloc_failed);
+
+/**
+ * @brief           Why media packets were lost, see esp_a2d_sink_media_loss_hook
+ */
+typedef enum {
+    ESP_A2D_SINK_MEDIA_LOSS_DECODE = 0,     /*!< The decoder rejected the packet */
+    ESP_A2D_SINK_MEDIA_LOSS_QUEUE_FULL,     /*!< Dropped on arrival, the sink queue was full */
+    ESP_A2D_SINK_MEDIA_LOSS_MEMORY,         /*!< Queued packets shed to free internal RAM */
+} esp_a2d_sink_media_loss_t;
+
+/**
+ * @brief           Media loss hook, called whenever the A2DP sink loses media packets: in the
+ *                  sink task for a decoder error, in the caller of btc_a2dp_sink_enque_buf for
+ *                  a full queue or memory pressure, and in the HCI layer's context when it
+ *                  sheds packets after an allocation failure. The stack provides an empty weak
+ *                  definition; define it in the application to log losses. It must not block.
+ *
+ * @param[in]       reason: why the packets were lost
+ * @param[in]       packets: number of packets lost
+ *
+ */
+void esp_a2d_sink_media_loss_hook(esp_a2d_sink_media_loss_t reason, uint32_t packets);
+
+/**
+ * @brief           Stream endpoint hook, called when a peer discovers the sink's stream endpoints,
+ *                  once per codec endpoint that is not in use. Endpoints it declines are reported
+ *                  to that peer as in use, so the peer configures one of the others. The SBC
+ *                  endpoint is always offered and not passed to the hook. The stack provides a
+ *                  weak definition that offers every endpoint. It must not block.
+ *
+ * @param[in]       peer_bda: address of the discovering peer
+ * @param[in]       codec_info: codec information of the endpoint, starting with its length
+ *                  (AVDTP media codec capability: length, media type, codec type, elements)
+ *
+ * @return          true to offer the endpoint to this peer
+ *
+ */
+bool esp_a2d_sink_sep_offer_hook(esp_bd_addr_t peer_bda, const uint8_t *codec_info);
+
+/**
+ * @brief           A2DP sink media packet statistics of the current stream, reset on every
+ *                  codec configuration
+ */
+typedef struct {
+    uint32_t received;              /*!< Media packets received */
+    uint32_t dropped;               /*!< Packets the sink dropped (queue full, memory pressure) */
+    uint32_t lost;                  /*!< Packets missing from the RTP sequence (needs PLC) */
+    uint32_t concealed;             /*!< Packets concealed by PLC */
+    uint32_t bytes;                 /*!< Media payload bytes received (wraps) */
+    uint32_t pcm_bytes;             /*!< PCM bytes decoded from them (wraps) */
+    uint16_t max_len;               /*!< Largest media payload received, in bytes */
+    uint16_t mtu;                   /*!< L2CAP MTU the sink asked for on the media channel */
+} esp_a2d_sink_rx_stats_t;
+
+/**
+ * @brief           Get the media packet statistics of the current stream. Safe to call from any
+ *                  task; the counters are read without locking.
+ *
+ * @param[out]      stats: statistics, zeroed if the sink is not running
+ *
+ * @return
+ *                  - ESP_OK: success
+ *                  - ESP_ERR_INVALID_STATE: the sink media task is not running
+ *                  - ESP_ERR_INVALID_ARG: stats is NULL
+ *
+ */
+esp_err_t esp_a2d_sink_get_rx_stats(esp_a2d_sink_rx_stats_t *stats);
+
+/**
+ * @brief           Last radio readings of the source's BR/EDR link, from esp_a2d_sink_read_link
+ */
+typedef struct {
+    int8_t rssi;                    /*!< dB outside the golden receive power range, 0 inside it */
+    uint8_t link_quality;           /*!< 0-255, controller specific, higher is better */
+    uint16_t rssi_readings;         /*!< RSSI readings completed (wraps) */
+    uint16_t quality_readings;      /*!< Link quality readings completed (wraps) */
+} esp_a2d_sink_link_stats_t;
+
+/**
+ * @brief           Start an RSSI and a link quality reading of the ACL link to the source. The
+ *                  results arrive a few milliseconds later in esp_a2d_sink_get_link_stats; a
+ *                  reading still outstanding makes the new one fail without notice. Safe to call
+ *                  from any task, at most every few hundred milliseconds.
+ *
+ * @param[in]       remote_bda: address of the connected source
+ *
+ * @return
+ *                  - ESP_OK: readings requested
+ *                  - ESP_ERR_INVALID_STATE: Bluedroid is not enabled
+ *
+ */
+esp_err_t esp_a2d_sink_read_link(esp_bd_addr_t remote_bda);
+
+/**
+ * @brief           Get the last link readings. Safe to call from any task; the counts change
+ *                  when a reading completes, so a reader can tell fresh values from old ones.
+ *
+ * @param[out]      stats: readings
+ *
+ * @return
+ *                  - ESP_OK: success
+ *                  - ESP_ERR_INVALID_ARG: stats is NULL
+ *
+ */
+esp_err_t esp_a2d_sink_get_link_stats(esp_a2d_sink_link_stats_t *stats);
+
+/**
+ * @brief           Limit how many media packets the sink queues ahead of its decoder. Packets
+ *                  arriving at a full queue are dropped (and counted as dropped), so a lower
+ *                  limit bounds the latency a backlog can add at the cost of drops after a
+ *                  stall. Safe to call from any task, at any time; takes effect with the next
+ *                  packet and is kept across streams.
+ *
+ * @param[in]       packets: queue depth, 0 or above the default for the default (150, or
+ *                  CONFIG_AUDIO_ENCODED_QUEUE_PACKETS with CONFIG_AUDIO_ENCODED_JITTER)
+ *
+ * @return
+ *                  - ESP_OK: success
+ *
+ */
+esp_err_t esp_a2d_sink_set_rx_queue_limit(uint16_t packets);
+
+/**
+ * @brief           Trade decoded audio quality for decoder CPU time, for a sink that cannot keep
+ *                  up. 0 is full quality; each level above is cheaper and degrades in the least
+ *                  audible way the codec allows (LDAC: 1 stops decoding above about 20 kHz, 2
+ *                  above about 18 kHz). Codecs without such a step ignore it, and levels past a
+ *                  codec's last step act as its last. Safe to call from any task, at any time;
+ *                  takes effect with the next packet and is kept across streams.
+ *
+ * @param[in]       level: complexity level, 0 for full quality
+ *
+ * @return
+ *                  - ESP_OK: success
+ *
+ */
+esp_err_t esp_a2d_sink_set_decode_level(uint8_t level);
+
+/**
+ * @brief           Pull decoding: media packets stay queued (up to the rx queue limit) until the
+ *                  application decodes them with esp_a2d_sink_pull_decode, typically from the
+ *                  task that feeds the audio output, when it needs the next block. That task then
+ *                  needs the stack a decoder uses (see the A2DP sink task's). The sink task only
+ *                  handles control events meanwhile. Packets queued when pull decoding ends are
+ *                  decoded by the sink task as usual. Safe to call from any task; kept across
+ *                  streams.
+ *
+ * @param[in]       enable: true to decode on demand, false to decode as packets arrive (default)
+ *
+ * @return
+ *                  - ESP_OK: success
+ *
+ */
+esp_err_t esp_a2d_sink_set_pull_decode(bool enable);
+
+/**
+ * @brief           Pull decoding: decode up to max_packets of the queued media packets on the
+ *                  calling task. Their PCM goes to the data callback before this returns, in the
+ *                  same batches the sink task would deliver. Never waits: while the sink task
+ *                  reconfigures the decoder nothing is decoded.
+ *
+ * @param[in]       max_packets: most packets to decode
+ *
+ * @return          packets decoded, 0 if none were queued or pull decoding is off
+ *
+ */
+uint16_t esp_a2d_sink_pull_decode(uint16_t max_packets);
+
+/**
+ * @brief           Media packets queued ahead of the decoder. Safe to call from any task.
+ *
+ * @return          queued packets, 0 if the sink is not running
+ *
+ */
+uint16_t esp_a2d_sink_get_queued(void);
+
+/**
+ * @brief           Pull decoding hook, called in the caller of btc_a2dp_sink_enque_buf after a
+ *                  media packet was queued while pull decoding is on. The stack provides an
+ *                  empty weak definition; define it in the application to wake the task that
+ *                  decodes. It must not block.
+ *
+ * @param[in]       queued: packets now queued
+ *
+ */
+void esp_a2d_sink_pull_ready_hook(uint16_t queued);
+
 /**
  * @brief           [Deprecated] Register A2DP source data input function. For now, the input should be PCM data stream.
  *                  This function should be called only after esp_bluedroid_enable() completes
@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __ESP_BLE_L2CAP_COC_API_H__
+#define __ESP_BLE_L2CAP_COC_API_H__
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_bt_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LE L2CAP connection oriented channel (credit based) callback events
+ */
+typedef enum {
+    ESP_BLE_L2CAP_COC_OPEN_EVT = 0,     /*!< A peer opened the channel */
+    ESP_BLE_L2CAP_COC_DATA_EVT,         /*!< An SDU arrived */
+    ESP_BLE_L2CAP_COC_CONG_EVT,         /*!< The send queue filled up or drained */
+    ESP_BLE_L2CAP_COC_CLOSE_EVT,        /*!< The channel closed */
+} esp_ble_l2cap_coc_cb_event_t;
+
+/**
+ * @brief LE L2CAP connection oriented channel callback parameters
+ */
+typedef union {
+    /**
+     * @brief ESP_BLE_L2CAP_COC_OPEN_EVT
+     */
+    struct ble_l2cap_coc_open_evt_param {
+        uint16_t lcid;                  /*!< Local channel ID */
+        esp_bd_addr_t bda;              /*!< Peer address */
+        uint16_t peer_mtu;              /*!< Largest SDU the peer accepts */
+        uint16_t peer_mps;              /*!< Largest K-frame the peer accepts */
+    } open;                             /*!< ESP_BLE_L2CAP_COC_OPEN_EVT */
+
+    /**
+     * @brief ESP_BLE_L2CAP_COC_DATA_EVT
+     */
+    struct ble_l2cap_coc_data_evt_param {
+        uint16_t lcid;                  /*!< Local channel ID */
+        const uint8_t *data;            /*!< The SDU, valid during the callback only */
+        uint16_t len;                   /*!< Its length */
+        uint16_t frames;                /*!< K-frames (credits) it took */
+    } data;                             /*!< ESP_BLE_L2CAP_COC_DATA_EVT */
+
+    /**
+     * @brief ESP_BLE_L2CAP_COC_CONG_EVT
+     */
+    struct ble_l2cap_coc_cong_evt_param {
+        uint16_t lcid;                  /*!< Local channel ID */
+        bool congested;                 /*!< Writes fail until it clears */
+    } cong;                             /*!< ESP_BLE_L2CAP_COC_CONG_EVT */
+
+    /**
+     * @brief ESP_BLE_L2CAP_COC_CLOSE_EVT
+     */
+    struct ble_l2cap_coc_close_evt_param {
+        uint16_t lcid;                  /*!< Local channel ID */
+    } close;                            /*!< ESP_BLE_L2CAP_COC_CLOSE_EVT */
+} esp_ble_l2cap_coc_cb_param_t;
+
+/**
+ * @brief LE L2CAP connection oriented channel callback. Runs on the
+ *        Bluetooth host task: it must not block.
+ */
+typedef void (*esp_ble_l2cap_coc_cb_t)(esp_ble_l2cap_coc_cb_event_t event, esp_ble_l2cap_coc_cb_param_t *param);
+
+/**
+ * @brief           Accept LE credit based connections on an LE PSM, one
+ *                  channel at a time. Call once after esp_bluedroid_enable(),
+ *                  before advertising the PSM to peers.
+ *
+ * @param[in]       psm: LE PSM, 0x0080 to 0x00FF for a dynamic one
+ * @param[in]       mtu: largest SDU accepted
+ * @param[in]       mps: largest K-frame accepted
+ * @param[in]       credits: K-frames the peer may send before more are given
+ * @param[in]       callback: events of the channel
+ *
+ * @return
+ *                  - ESP_OK: success
+ *                  - ESP_ERR_INVALID_ARG: bad PSM or configuration
+ *                  - ESP_ERR_NOT_SUPPORTED: built without LE L2CAP COC
+ *                  - ESP_FAIL: registration failed
+ */
+esp_err_t esp_ble_l2cap_coc_server_register(uint16_t psm, uint16_t mtu, uint16_t mps, uint16_t credits,
+                                            esp_ble_l2cap_coc_cb_t callback);
+
+/**
+ * @brief           Give the peer more credits, one per K-frame it may send
+ *
+ * @return          ESP_OK if the call was queued
+ */
+esp_err_t esp_ble_l2cap_coc_give_credits(uint16_t lcid, uint16_t credits);
+
+/**
+ * @brief           Send one SDU of at most the peer's MTU. The data is
+ *                  copied; a congestion event tells when to hold back.
+ *
+ * @return          ESP_OK if the SDU was queued
+ */
+esp_err_t esp_ble_l2cap_coc_write(uint16_t lcid, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief           Close the channel; ESP_BLE_L2CAP_COC_CLOSE_EVT follows
+ *
+ * @return          ESP_OK if the call was queued
+ */
+esp_err_t esp_ble_l2cap_coc_disconnect(uint16_t lcid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ESP_BLE_L2CAP_COC_API_H__ */
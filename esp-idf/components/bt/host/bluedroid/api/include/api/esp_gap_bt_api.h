@@ -54,6 +54,12 @@ typedef enum {
     ESP_BT_GENERAL_DISCOVERABLE,        /*!< General Discoverable */
 } esp_bt_discovery_mode_t;
 
+/// Page scan type
+typedef enum {
+    ESP_BT_PAGE_SCAN_STANDARD,          /*!< Standard page scan */
+    ESP_BT_PAGE_SCAN_INTERLACED,        /*!< Interlaced page scan, scans both train halves in one interval */
+} esp_bt_page_scan_type_t;
+
 /// Bluetooth Device Property type
 typedef enum {
     ESP_BT_GAP_DEV_PROP_BDNAME = 1,                 /*!< Bluetooth device name, value type is int8_t [] */
@@ -951,6 +957,25 @@ esp_err_t esp_bt_gap_set_page_timeout(uint16_t page_to);
  */
 esp_err_t esp_bt_gap_get_page_timeout(void);
 
+/**
+ * @brief           Set the page scan type, interval and window
+ *                  The values are kept and applied whenever the device is connectable,
+ *                  and take effect at once if it already is. No event is reported.
+ *
+ * @param[in]       type: Standard or interlaced page scan. Interlaced only shortens
+ *                        the connection time when window is no more than half of interval.
+ * @param[in]       interval: Time between the starts of two page scans. The valid range is
+ *                            0x0012 ~ 0x1000, the default value is 0x0800, unit is 0.625ms.
+ * @param[in]       window: Duration of one page scan. The valid range is 0x0011 ~ 0x1000
+ *                          and no more than interval, the default value is 0x0012, unit is 0.625ms.
+ *
+ * @return          - ESP_OK: success
+ *                  - ESP_ERR_INVALID_STATE: if bluetooth stack is not yet enabled
+ *                  - ESP_ERR_INVALID_ARG: if a parameter is out of range
+ *                  - other: failed
+ */
+esp_err_t esp_bt_gap_set_page_scan_param(esp_bt_page_scan_type_t type, uint16_t interval, uint16_t window);
+
 /**
  * @brief           Set ACL packet types
  *                  An ESP_BT_GAP_SET_ACL_PPKT_TYPES_EVT event will reported to
@@ -911,6 +911,34 @@ void bta_dm_set_page_timeout (tBTA_DM_MSG *p_data)
     BTM_WritePageTimeout(p_data->set_page_timeout.page_to, p_data->set_page_timeout.set_page_to_cb);
 }
 
+/*******************************************************************************
+**
+** Function         bta_dm_set_page_scan
+**
+** Description      Sets page scan type, interval and window; kept for the
+**                  next visibility change and applied now if connectable
+**
+**
+** Returns          void
+**
+*******************************************************************************/
+void bta_dm_set_page_scan (tBTA_DM_MSG *p_data)
+{
+    UINT16 conn_mode;
+
+    bta_dm_cb.page_scan_interval = p_data->set_page_scan.interval;
+    bta_dm_cb.page_scan_window = p_data->set_page_scan.window;
+
+    if (BTM_SetPageScanType(p_data->set_page_scan.scan_type) != BTM_SUCCESS) {
+        APPL_TRACE_WARNING("%s: scan type %d not applied\n", __func__, p_data->set_page_scan.scan_type);
+    }
+
+    conn_mode = BTM_ReadConnectability(NULL, NULL) & BTM_CONNECTABLE_MASK;
+    if (conn_mode == BTM_CONNECTABLE) {
+        BTM_SetConnectability(conn_mode, bta_dm_cb.page_scan_window, bta_dm_cb.page_scan_interval);
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         bta_dm_get_page_timeout
@@ -1017,6 +1045,17 @@ void bta_dm_read_rssi(tBTA_DM_MSG *p_data)
     }
 }
 
+#if (CLASSIC_BT_INCLUDED == TRUE)
+void bta_dm_read_link_quality(tBTA_DM_MSG *p_data)
+{
+    if (p_data->link_quality.read_link_quality_cb != NULL) {
+        BTM_ReadLinkQuality(p_data->link_quality.remote_addr, p_data->link_quality.read_link_quality_cb);
+    } else {
+        APPL_TRACE_ERROR("%s(), the callback function can't be NULL.", __func__);
+    }
+}
+#endif
+
 #if (CLASSIC_BT_INCLUDED == TRUE)
 /*******************************************************************************
 **
@@ -391,6 +391,31 @@ void BTA_DmSetPageTimeout(UINT16 page_to, tBTM_CMPL_CB *p_cb)
     }
 }
 
+/*******************************************************************************
+**
+** Function         BTA_DmSetPageScanParam
+**
+** Description      This function sets the page scan type, interval and window
+**                  used whenever the device is connectable.
+**
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTA_DmSetPageScanParam(UINT8 scan_type, UINT16 interval, UINT16 window)
+{
+    tBTA_DM_API_PAGE_SCAN_SET *p_msg;
+
+    if ((p_msg = (tBTA_DM_API_PAGE_SCAN_SET *) osi_malloc(sizeof(tBTA_DM_API_PAGE_SCAN_SET))) != NULL) {
+        p_msg->hdr.event = BTA_DM_API_PAGE_SCAN_SET_EVT;
+        p_msg->scan_type = scan_type;
+        p_msg->interval = interval;
+        p_msg->window = window;
+
+        bta_sys_sendmsg(p_msg);
+    }
+}
+
 /*******************************************************************************
 **
 ** Function         BTA_DmGetPageTimeout
@@ -580,6 +605,19 @@ void BTA_DmReadRSSI(BD_ADDR remote_addr, tBTA_TRANSPORT transport, tBTA_CMPL_CB
     }
 }
 
+#if (CLASSIC_BT_INCLUDED == TRUE)
+void BTA_DmReadLinkQuality(BD_ADDR remote_addr, tBTA_CMPL_CB *cmpl_cb)
+{
+    tBTA_DM_API_READ_LINK_QUALITY *p_msg;
+    if ((p_msg = (tBTA_DM_API_READ_LINK_QUALITY *)osi_malloc(sizeof(tBTA_DM_API_READ_LINK_QUALITY))) != NULL) {
+        p_msg->hdr.event = BTA_DM_API_READ_LINK_QUALITY_EVT;
+        memcpy(p_msg->remote_addr, remote_addr, sizeof(BD_ADDR));
+        p_msg->read_link_quality_cb = cmpl_cb;
+        bta_sys_sendmsg(p_msg);
+    }
+}
+#endif
+
 #if (CLASSIC_BT_INCLUDED == TRUE)
 /*******************************************************************************
 **
@@ -67,6 +67,7 @@ enum {
     BTA_DM_API_CONFIG_EIR_EVT,
     BTA_DM_API_PAGE_TO_SET_EVT,
     BTA_DM_API_PAGE_TO_GET_EVT,
+    BTA_DM_API_PAGE_SCAN_SET_EVT,
     BTA_DM_API_SET_ACL_PKT_TYPES_EVT,
 #if (ENC_KEY_SIZE_CTRL_MODE != ENC_KEY_SIZE_CTRL_MODE_NONE)
     BTA_DM_API_SET_MIN_ENC_KEY_SIZE_EVT,
@@ -221,6 +222,9 @@ enum {
     BTA_DM_API_BLE_READ_ADV_TX_POWER_EVT,
 #endif // #if (BLE_HOST_READ_TX_POWER_EN == TRUE)
     BTA_DM_API_READ_RSSI_EVT,
+#if (CLASSIC_BT_INCLUDED == TRUE)
+    BTA_DM_API_READ_LINK_QUALITY_EVT,
+#endif
 #if BLE_INCLUDED == TRUE
     BTA_DM_API_UPDATE_DUPLICATE_EXCEPTIONAL_LIST_EVT,
 #endif
@@ -425,6 +429,14 @@ typedef struct {
     tBTM_CMPL_CB        *get_page_to_cb;
 } tBTA_DM_API_PAGE_TO_GET;
 
+/* data type for BTA_DM_API_PAGE_SCAN_SET_EVT */
+typedef struct {
+    BT_HDR              hdr;
+    UINT8               scan_type;
+    UINT16              interval;
+    UINT16              window;
+} tBTA_DM_API_PAGE_SCAN_SET;
+
 /* data type for BTA_DM_API_SET_ACL_PKT_TYPES_EVT */
 typedef struct {
     BT_HDR              hdr;
@@ -491,6 +503,14 @@ typedef struct {
     tBTA_CMPL_CB  *read_rssi_cb;
 }tBTA_DM_API_READ_RSSI;
 
+#if (CLASSIC_BT_INCLUDED == TRUE)
+typedef struct {
+    BT_HDR        hdr;
+    BD_ADDR       remote_addr;
+    tBTA_CMPL_CB  *read_link_quality_cb;
+}tBTA_DM_API_READ_LINK_QUALITY;
+#endif
+
 typedef struct {
     BT_HDR            hdr;
     BD_ADDR          remote_addr;
@@ -1629,6 +1649,7 @@ typedef union {
     tBTA_DM_API_SET_AFH_CHANNELS set_afh_channels;
     tBTA_DM_API_PAGE_TO_SET set_page_timeout;
     tBTA_DM_API_PAGE_TO_GET get_page_timeout;
+    tBTA_DM_API_PAGE_SCAN_SET set_page_scan;
     tBTA_DM_API_SET_ACL_PKT_TYPES set_acl_pkt_types;
 #if (ENC_KEY_SIZE_CTRL_MODE != ENC_KEY_SIZE_CTRL_MODE_NONE)
     tBTA_DM_API_SET_MIN_ENC_KEY_SIZE set_min_enc_key_size;
@@ -1645,6 +1666,9 @@ typedef union {
 #endif // #if (BLE_HOST_READ_TX_POWER_EN == TRUE)
 #endif  ///BLE_INCLUDED == TRUE
     tBTA_DM_API_READ_RSSI rssi;
+#if (CLASSIC_BT_INCLUDED == TRUE)
+    tBTA_DM_API_READ_LINK_QUALITY link_quality;
+#endif
 
     tBTA_DM_API_READ_CH_MAP ch_map;
 
@@ -2247,6 +2271,7 @@ extern void bta_dm_send_vendor_hci(tBTA_DM_MSG *p_data);
 extern void bta_dm_config_eir (tBTA_DM_MSG *p_data);
 extern void bta_dm_set_page_timeout (tBTA_DM_MSG *p_data);
 extern void bta_dm_get_page_timeout (tBTA_DM_MSG *p_data);
+extern void bta_dm_set_page_scan (tBTA_DM_MSG *p_data);
 extern void bta_dm_set_acl_pkt_types (tBTA_DM_MSG *p_data);
 #if (ENC_KEY_SIZE_CTRL_MODE != ENC_KEY_SIZE_CTRL_MODE_NONE)
 extern void bta_dm_set_min_enc_key_size (tBTA_DM_MSG *p_data);
@@ -2259,6 +2284,9 @@ extern void bta_dm_update_white_list(tBTA_DM_MSG *p_data);
 extern void bta_dm_clear_white_list(tBTA_DM_MSG *p_data);
 extern void bta_dm_ble_read_adv_tx_power(tBTA_DM_MSG *p_data);
 extern void bta_dm_read_rssi(tBTA_DM_MSG *p_data);
+#if (CLASSIC_BT_INCLUDED == TRUE)
+extern void bta_dm_read_link_quality(tBTA_DM_MSG *p_data);
+#endif
 extern void bta_dm_read_ble_channel_map(tBTA_DM_MSG *p_data);
 #if (CLASSIC_BT_INCLUDED == TRUE)
 extern void bta_dm_set_visibility (tBTA_DM_MSG *p_data);
@@ -450,6 +450,7 @@ typedef tBTM_VSC_CMPL tBTA_VSC_CMPL;
 typedef tBTM_TX_POWER_RESULTS tBTA_TX_POWER_RESULTS;
 
 typedef tBTM_RSSI_RESULTS tBTA_RSSI_RESULTS;
+typedef tBTM_LINK_QUALITY_RESULTS tBTA_LINK_QUALITY_RESULTS;
 
 typedef tBTM_BLE_CH_MAP_RESULTS tBTA_BLE_CH_MAP_RESULTS;
 
@@ -2023,6 +2024,19 @@ void BTA_DmSetPageTimeout(UINT16 page_to, tBTM_CMPL_CB *p_cb);
 *******************************************************************************/
 void BTA_DmGetPageTimeout(tBTM_CMPL_CB *p_cb);
 
+/*******************************************************************************
+**
+** Function         BTA_DmSetPageScanParam
+**
+** Description      This function sets the page scan type, interval and window
+**                  used whenever the device is connectable.
+**
+**
+** Returns          void
+**
+*******************************************************************************/
+void BTA_DmSetPageScanParam(UINT8 scan_type, UINT16 interval, UINT16 window);
+
 /*******************************************************************************
 **
 ** Function         BTA_DmSetAclPktTypes
@@ -2070,6 +2084,20 @@ extern void BTA_DmBleReadAdvTxPower(tBTA_CMPL_CB *cmpl_cb);
 #endif  ///BLE_INCLUDED == TRUE
 
 extern void BTA_DmReadRSSI(BD_ADDR remote_addr, tBTA_TRANSPORT transport, tBTA_CMPL_CB *cmpl_cb);
+
+#if (CLASSIC_BT_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         BTA_DmReadLinkQuality
+**
+** Description      Read the link quality of the BR/EDR ACL to remote_addr;
+**                  cmpl_cb gets a tBTA_LINK_QUALITY_RESULTS
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void BTA_DmReadLinkQuality(BD_ADDR remote_addr, tBTA_CMPL_CB *cmpl_cb);
+#endif
 extern void BTA_DmBleReadChannelMap(BD_ADDR remote_device, tBTA_CMPL_CB *p_callback);
 
 /*******************************************************************************
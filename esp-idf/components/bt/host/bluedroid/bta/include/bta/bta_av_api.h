@@ -102,8 +102,14 @@ typedef UINT8 tBTA_AV_HNDL;
 
 #ifndef BTA_AV_MAX_A2DP_MTU
 /*#define BTA_AV_MAX_A2DP_MTU     668 //224 (DM5) * 3 - 4(L2CAP header) */
+#ifdef CONFIG_A2DP_SINK_MEDIA_MTU
+/* L2CAP MTU the media channel asks for; a source fills packets up to it,
+ * so a larger one carries more codec frames per packet */
+#define BTA_AV_MAX_A2DP_MTU     CONFIG_A2DP_SINK_MEDIA_MTU
+#else
 #define BTA_AV_MAX_A2DP_MTU     1008
 #endif
+#endif
 
 #ifndef BTA_AV_MAX_VDP_MTU
 #define BTA_AV_MAX_VDP_MTU      1008
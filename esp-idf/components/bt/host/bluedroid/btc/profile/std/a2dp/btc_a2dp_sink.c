@@ -12,6 +12,7 @@
 #include "common/bt_target.h"
 #include "common/bt_trace.h"
 #include <string.h>
+#include <math.h>
 #include <stdint.h>
 #include "common/bt_defs.h"
 #include "osi/allocator.h"
@@ -19,6 +20,11 @@
 #include "osi/thread.h"
 #include "osi/fixed_queue.h"
 #include "stack/a2d_api.h"
+#include "stack/a2dp_codec_api.h"
+#include "stack/a2dp_vendor.h"
+#include "stack/a2dp_vendor_aptx_constants.h"
+#include "stack/a2dp_vendor_aptx_ll_constants.h"
+#include "stack/a2dp_vendor_opus_constants.h"
 #include "bta/bta_av_api.h"
 #include "bta/bta_av_ci.h"
 #include "btc_av_co.h"
@@ -33,14 +39,15 @@
 #include "osi/future.h"
 #include <assert.h>
 #include "esp_heap_caps.h"  // For heap_caps_get_free_size/largest_free_block
+#include "esp_cpu.h"        // Cycle counter for esp_a2d_sink_decode_trace_hook
+#include "esp_timer.h"      // Arrival stamp for esp_a2d_sink_media_stamp_hook
 
 #if (BTC_AV_SINK_INCLUDED == TRUE)
 
-#if (defined(APTX_DEC_INCLUDED) && APTX_DEC_INCLUDED == TRUE)
-#define BT_A2DP_SINK_BUF_SIZE   (64*1024)
-#else
+/* Decode buffer for codecs without a known per-packet bound (LDAC, Opus,
+ * LC3plus); the others get BTC_A2DP_SNK_DECODE_BUF_PACKETS worst-case packets
+ * (see btc_a2dp_sink_packet_pcm_max), sized at decoder reset. */
 #define BT_A2DP_SINK_BUF_SIZE   (64*1024)
-#endif
 
 /*****************************************************************************
  **  Constants
@@ -83,10 +90,46 @@ enum {
 /* Increased from 25 to 150 to handle SPIFFS write/delete stalls during flash erase
    150 frames is equivalent to ~600ms of buffering at 44.1kHz
    This prevents packet drops when SPIFFS operations block the CPU */
+#if CONFIG_AUDIO_ENCODED_JITTER
+/* The application keeps its jitter buffer here, encoded, in the PSRAM slab
+ * below; only a short PCM window is decoded ahead of its output */
+#define MAX_OUTPUT_A2DP_SNK_FRAME_QUEUE_SZ     (CONFIG_AUDIO_ENCODED_QUEUE_PACKETS)
+#else
 #define MAX_OUTPUT_A2DP_SNK_FRAME_QUEUE_SZ     (150)
+#endif
+
+/* RxSbcQ must hold the whole queue, which may be deeper than the default */
+#if MAX_OUTPUT_A2DP_SNK_FRAME_QUEUE_SZ > QUEUE_SIZE_MAX
+#define BTC_A2DP_SNK_RX_QUEUE_CAPACITY         (MAX_OUTPUT_A2DP_SNK_FRAME_QUEUE_SZ)
+#else
+#define BTC_A2DP_SNK_RX_QUEUE_CAPACITY         (QUEUE_SIZE_MAX)
+#endif
 
 #define BTC_A2DP_SNK_DATA_QUEUE_IDX            (1)
 
+/* Queue depth at which arriving packets are dropped; the application may
+ * lower it (esp_a2d_sink_set_rx_queue_limit) to bound the latency a
+ * backlog can add. Kept outside the local params so it survives restarts. */
+static UINT16 btc_a2dp_sink_rx_queue_limit = MAX_OUTPUT_A2DP_SNK_FRAME_QUEUE_SZ;
+
+/* Last radio readings of the source's ACL (esp_a2d_sink_read_link), written
+ * by the BTU task as they complete */
+static tBTC_A2DP_SINK_LINK_STATS btc_a2dp_sink_link;
+
+/* Decoder complexity level the application asked for
+ * (esp_a2d_sink_set_decode_level); the media task hands it to the decoder
+ * before its next packet. Also kept across restarts. */
+static volatile UINT8 btc_a2dp_sink_decode_level;
+#define BTC_A2DP_SNK_DECODE_LEVEL_UNSET        (0xFF)
+
+/* Pull mode (esp_a2d_sink_set_pull_decode): packets stay queued until the
+ * application's output task decodes them (btc_a2dp_sink_pull_decode), the
+ * media task only handles control events. The decoder state is shared
+ * between the two, so every decode and reconfiguration holds the lock.
+ * Both are kept across restarts. */
+static volatile BOOLEAN btc_a2dp_sink_pull_mode;
+static osi_mutex_t btc_a2dp_sink_decode_lock;
+
 #define A2DP_TASK_NAME                   "A2DP_DECODER"
 #if CONFIG_SPIRAM
 #define A2DP_TASK_STACK_SIZE             (50 * 1024)
@@ -94,11 +137,72 @@ enum {
 #define A2DP_TASK_STACK_SIZE             (BTC_TASK_STACK_SIZE)
 #endif
 #define A2DP_TASK_PRIO                   (BT_TASK_MAX_PRIORITIES - 6)
-#define A2DP_TASK_PINNED_TO_CORE         (1)
+#define A2DP_TASK_PINNED_TO_CORE         (UC_BT_A2DP_SINK_TASK_CORE)
 #define A2DP_TASK_WORKQUEUE_NUM          (2)
 #define A2DP_TASK_WORKQUEUE0_LEN         (1)
 #define A2DP_TASK_WORKQUEUE1_LEN         (5)
 
+/* Batch decode: packets already waiting in RxSbcQ are decoded back-to-back
+ * into decode_buf and delivered to the app as one contiguous PCM callback.
+ * Only the existing backlog is batched, so this never adds latency. A batch is
+ * flushed after BATCH_MAX packets or once less than the codec's worst-case
+ * packet (BATCH_HEADROOM where unknown) is left for the next packet's output.
+ * Set BATCH_MAX to 1 to disable. */
+#ifndef BTC_A2DP_SNK_DECODE_BATCH_MAX
+#define BTC_A2DP_SNK_DECODE_BATCH_MAX          (8)
+#endif
+#define BTC_A2DP_SNK_DECODE_BATCH_HEADROOM     (24 * 1024)
+/* Worst-case packets the decode buffer holds for codecs with a known bound */
+#ifndef BTC_A2DP_SNK_DECODE_BUF_PACKETS
+#define BTC_A2DP_SNK_DECODE_BUF_PACKETS        (4)
+#endif
+
+/* RX slab: fixed-size slots for queued media packets, sized at decoder reset
+ * from the queue depth and the AVDTP media MTU. Each packet is copied into a
+ * slot on the BTU thread and the lower-layer buffer freed, so it only pays
+ * off when the queue is deep enough that parking it in PSRAM matters: the
+ * encoded jitter buffer. Otherwise packets take the zero-copy handoff, as do
+ * the ones that don't fit a slot. */
+#ifndef BTC_A2DP_SNK_RX_SLAB_INCLUDED
+#if CONFIG_AUDIO_ENCODED_JITTER
+#define BTC_A2DP_SNK_RX_SLAB_INCLUDED          TRUE
+#else
+#define BTC_A2DP_SNK_RX_SLAB_INCLUDED          FALSE
+#endif
+#endif
+/* Room for HCI/L2CAP/AVDTP headers kept in front of the payload (BT_HDR offset) */
+#define BTC_A2DP_SNK_RX_SLAB_HDR_ROOM          (64)
+#if CONFIG_SPIRAM
+#define BTC_A2DP_SNK_RX_SLAB_SLOTS             (MAX_OUTPUT_A2DP_SNK_FRAME_QUEUE_SZ)
+#define BTC_A2DP_SNK_RX_SLAB_CAPS              (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define BTC_A2DP_SNK_RX_SLAB_SLOTS             (32)
+#define BTC_A2DP_SNK_RX_SLAB_CAPS              (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+
+/* Packet-loss concealment on the decoded PCM, for every codec. Lost packets
+ * (RTP sequence gaps, or packets the sink dropped itself when the codec has
+ * no RTP header) are replaced by the last good PCM repeated at its best
+ * matching period and faded out over PLC_MAX_BLOCKS packets; the first good
+ * packet after a loss is cross-faded in over PLC_OLA samples. Longer outages
+ * stay silent. */
+#ifndef BTC_A2DP_SNK_PLC_INCLUDED
+#if CONFIG_A2DP_SINK_PLC
+#define BTC_A2DP_SNK_PLC_INCLUDED              TRUE
+#else
+#define BTC_A2DP_SNK_PLC_INCLUDED              FALSE
+#endif
+#endif
+#define BTC_A2DP_SNK_PLC_HIST_SIZE             (8 * 1024)  /* bytes of PCM history */
+#define BTC_A2DP_SNK_PLC_MAX_BLOCKS            (4)         /* concealed packets per outage */
+/* Lengths below are interleaved samples; lags step by 2 to stay channel aligned */
+#define BTC_A2DP_SNK_PLC_MATCH                 (128)       /* pattern-match template */
+#define BTC_A2DP_SNK_PLC_MIN_LAG               (64)
+#define BTC_A2DP_SNK_PLC_MAX_LAG               (1024)
+#define BTC_A2DP_SNK_PLC_OLA                   (64)        /* cross-fade into good audio */
+/* Larger sequence jumps are a restarted stream, not loss */
+#define BTC_A2DP_SNK_PLC_MAX_GAP               (64)
+
 typedef struct {
     uint32_t sig;
     void *param;
@@ -110,17 +214,52 @@ typedef struct {
     fixed_queue_t *RxSbcQ;
 } tBTC_A2DP_SINK_CB;
 
-// typedef struct {
-//     uint16_t expected_seq_num;
-//     bool seq_num_recount;
-// } a2dp_sink_media_pkt_seq_num_t;
+typedef struct {
+    UINT8       *hist;          /* last hist_fill bytes of decoded PCM, at the end of the buffer */
+    UINT32      hist_fill;
+    UINT32      pkt_bytes;      /* PCM decoded from the current packet so far */
+    UINT32      blk_bytes;      /* PCM decoded from the last good packet */
+    UINT32      period;         /* repetition period of the concealment, in samples */
+    UINT32      phase;          /* next sample within the period */
+    UINT32      concealed;      /* packets concealed since the decoder was configured */
+    UINT32      head_dropped;   /* queued packets dropped ahead of the next one to decode */
+    UINT16      tail_dropped;   /* packets dropped since the last one queued */
+    UINT16      expected_seq;
+    BOOLEAN     seq_valid;
+    BOOLEAN     has_seq;        /* media packets start with an RTP header */
+    UINT8       smpl_bytes;     /* 2 for s16 codecs, 4 for s32 containers */
+    UINT8       nbf;            /* packets concealed in the current outage */
+} tBTC_A2DP_SINK_PLC;
+
+typedef struct {
+    UINT8       *pool;          /* slot_count * slot_size bytes of backing store */
+    UINT16      *free_stack;    /* indices of free slots */
+    UINT16      slot_size;
+    UINT16      slot_count;
+    UINT16      free_top;       /* number of entries in free_stack */
+    osi_mutex_t lock;           /* alloc on BTU thread, free on media/HCI threads */
+    tBTC_A2DP_SINK_SLAB_STATS stats;
+} tBTC_A2DP_SINK_SLAB;
 
 typedef struct {
     tBTC_A2DP_SINK_CB   btc_aa_snk_cb;
     osi_thread_t        *btc_aa_snk_task_hdl;
     const tA2DP_DECODER_INTERFACE* decoder;
-    unsigned char *decode_buf;  // Allocated from internal RAM
-    // a2dp_sink_media_pkt_seq_num_t   media_pkt_seq_num;
+    unsigned char *decode_buf;  // Allocated from internal RAM, sized per codec
+    size_t decode_buf_size;
+    size_t decode_headroom;     // Room one packet's PCM may need
+    BOOLEAN batch_active;       // decode callbacks accumulate into the batch buffer
+    size_t batch_fill;          // PCM bytes accumulated in the batch buffer
+    unsigned char *lent_buf;    // App buffer lent for this batch, NULL = decode_buf
+    size_t lent_size;
+    UINT8 decode_level;         // Level the decoder runs at, UNSET after configure
+#if (BTC_A2DP_SNK_RX_SLAB_INCLUDED == TRUE)
+    tBTC_A2DP_SINK_SLAB rx_slab;
+#endif
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+    tBTC_A2DP_SINK_PLC plc;
+#endif
+    tBTC_A2DP_SINK_RX_STATS rx_stats;   /* since the last decoder reset */
 } a2dp_sink_local_param_t;
 
 static void btc_a2dp_sink_thread_init(UNUSED_ATTR void *context);
@@ -130,14 +269,35 @@ static void btc_a2dp_sink_rx_flush(void);
 /* Handle incoming media packets A2DP SINK streaming*/
 static void btc_a2dp_sink_handle_inc_media(BT_HDR *p_msg);
 static void btc_a2dp_sink_handle_decoder_reset(tBTC_MEDIA_SINK_CFG_UPDATE *p_msg);
+static void btc_a2dp_sink_configure_decoder(tBTC_MEDIA_SINK_CFG_UPDATE *p_msg);
 static void btc_a2dp_sink_handle_clear_track(void);
 static BOOLEAN btc_a2dp_sink_clear_track(void);
 
 static void btc_a2dp_sink_data_ready(void *context);
 
-/* Free function for queued buffers */
+#if (BTC_A2DP_SNK_RX_SLAB_INCLUDED == TRUE)
+static void btc_a2dp_sink_slab_init(void);
+static void btc_a2dp_sink_slab_deinit(void);
+static void btc_a2dp_sink_slab_reset(UINT16 slot_size);
+static BT_HDR *btc_a2dp_sink_slab_enque(BT_HDR *p_pkt);
+static BOOLEAN btc_a2dp_sink_slab_free(void *buf);
+#endif
+
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+static void btc_a2dp_sink_plc_reset(const UINT8 *p_codec_info);
+static BOOLEAN btc_a2dp_sink_plc_check_loss(BT_HDR *p_msg);
+static void btc_a2dp_sink_plc_good(unsigned char *data, uint32_t len);
+#endif
+static BOOLEAN btc_a2dp_sink_sep_filter(BD_ADDR bd_addr, UINT8 tsep, const UINT8 *p_codec_info);
+
+/* Free function for queued buffers - slab slot or lower-layer heap buffer */
 static void btc_a2dp_sink_free_buf(void *buf) {
     if (buf) {
+#if (BTC_A2DP_SNK_RX_SLAB_INCLUDED == TRUE)
+        if (btc_a2dp_sink_slab_free(buf)) {
+            return;
+        }
+#endif
         osi_free(buf);
     }
 }
@@ -151,6 +311,67 @@ static a2dp_sink_local_param_t *a2dp_sink_local_param_ptr;
 #define a2dp_sink_local_param (*a2dp_sink_local_param_ptr)
 #endif ///A2D_DYNAMIC_MEMORY == FALSE
 
+/* Overridden by the application when it traces decode time */
+void __attribute__((weak)) esp_a2d_sink_decode_trace_hook(uint32_t cycles)
+{
+    (void)cycles;
+}
+
+/* Overridden by the application when it measures end-to-end latency */
+void __attribute__((weak)) esp_a2d_sink_media_stamp_hook(uint32_t rtp_ts, uint32_t arrival_us)
+{
+    (void)rtp_ts;
+    (void)arrival_us;
+}
+
+/* Overridden by the application when it withholds codecs from some peers */
+bool __attribute__((weak)) esp_a2d_sink_sep_offer_hook(esp_bd_addr_t peer_bda, const uint8_t *codec_info)
+{
+    (void)peer_bda;
+    (void)codec_info;
+    return true;
+}
+
+/* Overridden by the application when it degrades other subsystems before
+ * media packets; by default the sink sheds packets whenever memory is low */
+bool __attribute__((weak)) esp_a2d_sink_memory_pressure_hook(size_t free_internal, bool alloc_failed)
+{
+    (void)free_internal;
+    (void)alloc_failed;
+    return true;
+}
+
+/* Overridden by the application when it journals media losses */
+void __attribute__((weak)) esp_a2d_sink_media_loss_hook(esp_a2d_sink_media_loss_t reason, uint32_t packets)
+{
+    (void)reason;
+    (void)packets;
+}
+
+/* Overridden by the application when it lends its own buffers for decoding */
+unsigned char * __attribute__((weak)) esp_a2d_sink_pcm_buffer_hook(size_t min_len, size_t *size)
+{
+    (void)min_len;
+    (void)size;
+    return NULL;
+}
+
+void __attribute__((weak)) esp_a2d_sink_pcm_buffer_return_hook(unsigned char *buf)
+{
+    (void)buf;
+}
+
+/* Overridden by the application when it decodes in pull mode */
+void __attribute__((weak)) esp_a2d_sink_pull_ready_hook(uint16_t queued)
+{
+    (void)queued;
+}
+
+/* The headroom in front of a media payload starts with the RTP timestamp
+ * (bta_av_stream_data_cback); the arrival time goes in the next word. AVDTP
+ * always leaves more room than that, the check is for safety only. */
+#define BTC_A2DP_SNK_STAMP_MIN_OFFSET   (2 * sizeof(UINT32))
+
 void btc_a2dp_sink_reg_data_cb(esp_a2d_sink_data_cb_t callback)
 {
     // todo: critical section protection
@@ -165,6 +386,97 @@ static inline void btc_a2d_data_cb_to_app(unsigned char *data, uint32_t len)
     }
 }
 
+/* Where the batch accumulates: the buffer the app lent for it, else decode_buf */
+static inline unsigned char *btc_a2dp_sink_batch_buf(void)
+{
+    return a2dp_sink_local_param.lent_buf ? a2dp_sink_local_param.lent_buf : a2dp_sink_local_param.decode_buf;
+}
+
+static inline size_t btc_a2dp_sink_batch_size(void)
+{
+    return a2dp_sink_local_param.lent_buf ? a2dp_sink_local_param.lent_size : a2dp_sink_local_param.decode_buf_size;
+}
+
+/* At the start of a batch, ask the app for a buffer to decode into, so the
+ * PCM lands where the app keeps it and the batch is delivered in place */
+static void btc_a2dp_sink_batch_lend(void)
+{
+    if (!a2dp_sink_local_param.batch_active || a2dp_sink_local_param.batch_fill > 0 ||
+        a2dp_sink_local_param.lent_buf != NULL || bt_aa_snk_data_cb == NULL) {
+        return;
+    }
+    size_t size = 0;
+    unsigned char *buf = esp_a2d_sink_pcm_buffer_hook(a2dp_sink_local_param.decode_headroom, &size);
+    if (buf == NULL) {
+        return;
+    }
+    if (size < a2dp_sink_local_param.decode_headroom) {
+        esp_a2d_sink_pcm_buffer_return_hook(buf);
+        return;
+    }
+    a2dp_sink_local_param.lent_buf = buf;
+    a2dp_sink_local_param.lent_size = size;
+}
+
+/* Deliver the accumulated batch (if any) to the app; a lent buffer goes
+ * back with it, or unused */
+static void btc_a2dp_sink_batch_flush(void)
+{
+    unsigned char *lent = a2dp_sink_local_param.lent_buf;
+    size_t fill = a2dp_sink_local_param.batch_fill;
+
+    a2dp_sink_local_param.lent_buf = NULL;
+    a2dp_sink_local_param.batch_fill = 0;
+    if (fill > 0) {
+        btc_a2d_data_cb_to_app(lent ? lent : a2dp_sink_local_param.decode_buf, (uint32_t)fill);
+    } else if (lent) {
+        esp_a2d_sink_pcm_buffer_return_hook(lent);
+    }
+}
+
+/* Throw the batch away (flush, reconfiguration) */
+static void btc_a2dp_sink_batch_drop(void)
+{
+    a2dp_sink_local_param.batch_fill = 0;
+    a2dp_sink_local_param.batch_active = FALSE;
+    btc_a2dp_sink_batch_flush();
+}
+
+/* PCM output. Outside a batch it forwards straight to the app. Inside a
+ * batch, decoders that wrote in place at the batch tail are simply accounted
+ * for; decoders with their own output buffer (AAC) are appended. */
+static void btc_a2dp_sink_output(unsigned char *data, uint32_t len)
+{
+    if (!a2dp_sink_local_param.batch_active || len == 0) {
+        btc_a2d_data_cb_to_app(data, len);
+        return;
+    }
+
+    unsigned char *tail = btc_a2dp_sink_batch_buf() + a2dp_sink_local_param.batch_fill;
+    if (data != tail) {
+        if (len > btc_a2dp_sink_batch_size() - a2dp_sink_local_param.batch_fill) {
+            btc_a2dp_sink_batch_flush();
+            if (len > a2dp_sink_local_param.decode_buf_size) {
+                btc_a2d_data_cb_to_app(data, len);
+                return;
+            }
+            tail = a2dp_sink_local_param.decode_buf;
+        }
+        memmove(tail, data, len);
+    }
+    a2dp_sink_local_param.batch_fill += len;
+}
+
+/* Decoder output callback */
+static void btc_a2dp_sink_decoded_data_cb(unsigned char *data, uint32_t len)
+{
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+    btc_a2dp_sink_plc_good(data, len);
+#endif
+    a2dp_sink_local_param.rx_stats.pcm_bytes += len;
+    btc_a2dp_sink_output(data, len);
+}
+
 /*****************************************************************************
  **  Misc helper functions
  *****************************************************************************/
@@ -231,6 +543,11 @@ bool btc_a2dp_sink_startup(void)
     memset((void *)a2dp_sink_local_param_ptr, 0, sizeof(a2dp_sink_local_param_t));
 #endif
 
+    if (!osi_mutex_valid(&btc_a2dp_sink_decode_lock) && osi_mutex_new(&btc_a2dp_sink_decode_lock) != 0) {
+        APPL_TRACE_ERROR("%s decode lock failed!", __func__);
+        return false;
+    }
+
     APPL_TRACE_EVENT("## A2DP SINK START MEDIA THREAD ##");
 
     const size_t workqueue_len[] = {A2DP_TASK_WORKQUEUE0_LEN, A2DP_TASK_WORKQUEUE1_LEN};
@@ -269,6 +586,7 @@ bool btc_a2dp_sink_startup(void)
 
     APPL_TRACE_EVENT("## A2DP SINK MEDIA THREAD STARTED ##\n");
 
+    AVDT_SetSepFilter(btc_a2dp_sink_sep_filter);
     return true;
 
 error_exit:;
@@ -291,6 +609,8 @@ void btc_a2dp_sink_shutdown(void)
 {
     APPL_TRACE_EVENT("## A2DP SINK STOP MEDIA THREAD ##\n");
 
+    AVDT_SetSepFilter(NULL);
+
     // Exit thread
     btc_a2dp_sink_state = BTC_A2DP_SINK_STATE_SHUTTING_DOWN;
 
@@ -381,10 +701,14 @@ static BOOLEAN btc_a2dp_sink_clear_track(void)
 void btc_a2dp_sink_set_rx_flush(BOOLEAN enable)
 {
     APPL_TRACE_EVENT("## DROP RX %d ##\n", enable);
-    // if (enable == FALSE) {
-    //     a2dp_sink_local_param.media_pkt_seq_num.expected_seq_num = 0x1;
-    //     a2dp_sink_local_param.media_pkt_seq_num.seq_num_recount = true;
-    // }
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+    if (enable == FALSE) {
+        /* Resumed stream: some sources restart their sequence numbers */
+        a2dp_sink_local_param.plc.seq_valid = FALSE;
+        a2dp_sink_local_param.plc.hist_fill = 0;
+        a2dp_sink_local_param.plc.nbf = 0;
+    }
+#endif
     a2dp_sink_local_param.btc_aa_snk_cb.rx_flush = enable;
 }
 
@@ -418,21 +742,22 @@ void btc_a2dp_sink_reset_decoder(UINT8 *p_av)
                     btc_a2dp_sink_ctrl, p_buf, 0, OSI_THREAD_MAX_TIMEOUT);
 }
 
-static void btc_a2dp_sink_data_ready(UNUSED_ATTR void *context)
+/* Decode up to max_packets queued packets on the calling task, batched as
+ * configured. The caller holds btc_a2dp_sink_decode_lock. Returns the
+ * packets decoded, or -1 when the sink stopped or the queue was flushed
+ * meanwhile. */
+static int btc_a2dp_sink_decode_queued(int max_packets)
 {
     BT_HDR *p_msg;
-    int nb_of_msgs_to_process = 0;
-
-    if (a2dp_sink_local_param.btc_aa_snk_cb.rx_flush == TRUE) {
-        btc_a2dp_sink_flush_q(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
-        return;
-    }
+    int decoded = 0;
+    int batched = 0;
 
-    nb_of_msgs_to_process = fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
-    APPL_TRACE_DEBUG("nb:%d", nb_of_msgs_to_process);
-    while (nb_of_msgs_to_process > 0) {
+    a2dp_sink_local_param.batch_fill = 0;
+    a2dp_sink_local_param.batch_active = (BTC_A2DP_SNK_DECODE_BATCH_MAX > 1);
+    while (decoded < max_packets) {
         if (btc_a2dp_sink_state != BTC_A2DP_SINK_STATE_ON){
-            return;
+            btc_a2dp_sink_batch_drop();
+            return -1;
         }
         p_msg = (BT_HDR *)fixed_queue_dequeue(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ, 0);
         if ( p_msg == NULL ) {
@@ -445,15 +770,47 @@ static void btc_a2dp_sink_data_ready(UNUSED_ATTR void *context)
          * and has been observed to crash inside the AAC decoder.
          */
         if (a2dp_sink_local_param.btc_aa_snk_cb.rx_flush == TRUE) {
-            osi_free(p_msg);
+            /* PCM already batched belongs to the flushed stream - drop it too */
+            btc_a2dp_sink_batch_drop();
+            btc_a2dp_sink_free_buf(p_msg);
             btc_a2dp_sink_flush_q(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
-            return;
+            return -1;
         }
 
         btc_a2dp_sink_handle_inc_media(p_msg);
-        /* p_msg is allocated with osi_malloc() in btc_a2dp_sink_enque_buf() */
-        osi_free(p_msg);
-        nb_of_msgs_to_process--;
+        /* p_msg is a slab slot or the lower-layer buffer from btc_a2dp_sink_enque_buf() */
+        btc_a2dp_sink_free_buf(p_msg);
+        decoded++;
+
+        if (++batched >= BTC_A2DP_SNK_DECODE_BATCH_MAX ||
+            btc_a2dp_sink_batch_size() - a2dp_sink_local_param.batch_fill < a2dp_sink_local_param.decode_headroom) {
+            btc_a2dp_sink_batch_flush();
+            batched = 0;
+        }
+    }
+    btc_a2dp_sink_batch_flush();
+    a2dp_sink_local_param.batch_active = FALSE;
+    return decoded;
+}
+
+static void btc_a2dp_sink_data_ready(UNUSED_ATTR void *context)
+{
+    if (a2dp_sink_local_param.btc_aa_snk_cb.rx_flush == TRUE) {
+        btc_a2dp_sink_flush_q(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
+        return;
+    }
+    /* The application's task decodes (btc_a2dp_sink_pull_decode) */
+    if (btc_a2dp_sink_pull_mode) {
+        return;
+    }
+
+    int nb_of_msgs_to_process = fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
+    APPL_TRACE_DEBUG("nb:%d", nb_of_msgs_to_process);
+    osi_mutex_lock(&btc_a2dp_sink_decode_lock, OSI_MUTEX_MAX_TIMEOUT);
+    int decoded = btc_a2dp_sink_decode_queued(nb_of_msgs_to_process);
+    osi_mutex_unlock(&btc_a2dp_sink_decode_lock);
+    if (decoded < 0) {
+        return;
     }
     APPL_TRACE_DEBUG(" Process Frames - ");
 
@@ -462,6 +819,75 @@ static void btc_a2dp_sink_data_ready(UNUSED_ATTR void *context)
     }
 }
 
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_packet_pcm_max
+ **
+ ** Description      Worst-case PCM bytes one media packet of this codec
+ **                  decodes to, for the codecs with a known bound
+ **
+ ** Returns          bytes, 0 if unknown
+ **
+ *******************************************************************************/
+static size_t btc_a2dp_sink_packet_pcm_max(const uint8_t *codec_info)
+{
+    switch (A2DP_SinkCodecIndex(codec_info)) {
+    case BTAV_A2DP_CODEC_INDEX_SINK_SBC:
+        /* Up to 15 frames of 16 blocks x 8 subbands, stereo S16 */
+        return 15 * 16 * 8 * 2 * sizeof(int16_t);
+#if (defined(AAC_DEC_INCLUDED) && AAC_DEC_INCLUDED == TRUE)
+    case BTAV_A2DP_CODEC_INDEX_SINK_AAC:
+        /* Appended one access unit at a time from the decoder's own buffer */
+        return 2048 * 2 * sizeof(int16_t);
+#endif
+#if (defined(APTX_DEC_INCLUDED) && APTX_DEC_INCLUDED == TRUE)
+    case BTAV_A2DP_CODEC_INDEX_SINK_APTX:
+    case BTAV_A2DP_CODEC_INDEX_SINK_APTX_HD:
+    case BTAV_A2DP_CODEC_INDEX_SINK_APTX_LL:
+        /* 4:1 on S16 (HD 16:3 on S24), decoded to S32: at most 8x the MTU */
+        return BTA_AV_MAX_A2DP_MTU * 8;
+#endif
+    default:
+        return 0;
+    }
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_decode_buf_reset
+ **
+ ** Description      Size the decode buffer for a codec. Codecs with a small
+ **                  per-packet bound leave the rest of the 64 KB to the app.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btc_a2dp_sink_decode_buf_reset(const uint8_t *codec_info)
+{
+    size_t packet = btc_a2dp_sink_packet_pcm_max(codec_info);
+    size_t size = packet ? packet * BTC_A2DP_SNK_DECODE_BUF_PACKETS : BT_A2DP_SINK_BUF_SIZE;
+    if (size > BT_A2DP_SINK_BUF_SIZE) {
+        size = BT_A2DP_SINK_BUF_SIZE;
+    }
+
+    a2dp_sink_local_param.batch_fill = 0;
+    a2dp_sink_local_param.decode_headroom = packet ? packet : BTC_A2DP_SNK_DECODE_BATCH_HEADROOM;
+    if (size == a2dp_sink_local_param.decode_buf_size && a2dp_sink_local_param.decode_buf) {
+        return;
+    }
+
+    /* Free first, so growing back does not need both at once */
+    osi_free(a2dp_sink_local_param.decode_buf);
+    a2dp_sink_local_param.decode_buf = (unsigned char *)osi_malloc(size);
+    a2dp_sink_local_param.decode_buf_size = a2dp_sink_local_param.decode_buf ? size : 0;
+    if (!a2dp_sink_local_param.decode_buf) {
+        APPL_TRACE_ERROR("%s: no %u bytes for the decode buffer", __func__, (unsigned)size);
+        return;
+    }
+    APPL_TRACE_EVENT("%s: decode buffer %u bytes for %s", __func__, (unsigned)size,
+                     A2DP_CodecName(codec_info));
+}
+
 /*******************************************************************************
  **
  ** Function         btc_a2dp_sink_handle_decoder_reset
@@ -472,6 +898,14 @@ static void btc_a2dp_sink_data_ready(UNUSED_ATTR void *context)
  **
  *******************************************************************************/
 static void btc_a2dp_sink_handle_decoder_reset(tBTC_MEDIA_SINK_CFG_UPDATE *p_msg)
+{
+    /* A pull decode on the application's task decodes nothing until this is done */
+    osi_mutex_lock(&btc_a2dp_sink_decode_lock, OSI_MUTEX_MAX_TIMEOUT);
+    btc_a2dp_sink_configure_decoder(p_msg);
+    osi_mutex_unlock(&btc_a2dp_sink_decode_lock);
+}
+
+static void btc_a2dp_sink_configure_decoder(tBTC_MEDIA_SINK_CFG_UPDATE *p_msg)
 {
     const tA2DP_DECODER_INTERFACE* decoder = A2DP_GetDecoderInterface(p_msg->codec_info);
     if (!decoder) {
@@ -480,17 +914,38 @@ static void btc_a2dp_sink_handle_decoder_reset(tBTC_MEDIA_SINK_CFG_UPDATE *p_msg
         return;
     }
 
-    if (decoder != a2dp_sink_local_param.decoder) {
+#if (BTC_A2DP_SNK_RX_SLAB_INCLUDED == TRUE)
+    /* Packets queued for the old configuration are stale; drop them and
+     * rebuild the slab for the new codec. Every codec's media packets are
+     * bounded by the AVDTP media MTU we advertise. */
+    btc_a2dp_sink_slab_reset(sizeof(BT_HDR) + BTC_A2DP_SNK_RX_SLAB_HDR_ROOM + BTA_AV_MAX_A2DP_MTU);
+    APPL_TRACE_EVENT("%s: rx slab %u x %u bytes for %s", __func__,
+                     a2dp_sink_local_param.rx_slab.slot_count,
+                     a2dp_sink_local_param.rx_slab.slot_size,
+                     A2DP_CodecName(p_msg->codec_info));
+#endif
+
+    btc_a2dp_sink_decode_buf_reset(p_msg->codec_info);
+
+    /* Decoders hold their state only between init and cleanup; the free
+     * internal heap around the switch is each one's footprint. */
+    bool switched = (decoder != a2dp_sink_local_param.decoder);
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t free_released = free_before;
+
+    if (switched) {
         // De-initialize previous decoder
         if (a2dp_sink_local_param.decoder && a2dp_sink_local_param.decoder->decoder_cleanup) {
             a2dp_sink_local_param.decoder->decoder_cleanup();
         }
+        free_released = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
 
         // Initialize new decoder
         a2dp_sink_local_param.decoder = decoder;
         if (a2dp_sink_local_param.decoder->decoder_init &&
-            !a2dp_sink_local_param.decoder->decoder_init(btc_a2d_data_cb_to_app)) {
+            !a2dp_sink_local_param.decoder->decoder_init(btc_a2dp_sink_decoded_data_cb)) {
             APPL_TRACE_ERROR("%s: Decoder failed to initialize", __func__);
+            a2dp_sink_local_param.decoder = NULL;
             return;
         }
     } else {
@@ -502,6 +957,21 @@ static void btc_a2dp_sink_handle_decoder_reset(tBTC_MEDIA_SINK_CFG_UPDATE *p_msg
     if (a2dp_sink_local_param.decoder->decoder_configure){
         a2dp_sink_local_param.decoder->decoder_configure(p_msg->codec_info);
     }
+    a2dp_sink_local_param.decode_level = BTC_A2DP_SNK_DECODE_LEVEL_UNSET;
+
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+    btc_a2dp_sink_plc_reset(p_msg->codec_info);
+#endif
+    memset(&a2dp_sink_local_param.rx_stats, 0, sizeof(a2dp_sink_local_param.rx_stats));
+
+    if (switched) {
+        size_t free_after = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        APPL_TRACE_EVENT("%s: %s decoder uses %d bytes internal RAM (previous released %d, free %u)",
+                         __func__, A2DP_CodecName(p_msg->codec_info),
+                         (int)free_released - (int)free_after,
+                         (int)free_released - (int)free_before,
+                         (unsigned)free_after);
+    }
 }
 
 /*******************************************************************************
@@ -527,30 +997,60 @@ static void btc_a2dp_sink_handle_inc_media(BT_HDR *p_msg)
         return;
     }
 
-    // if (p_msg->layer_specific != a2dp_sink_local_param.media_pkt_seq_num.expected_seq_num) {
-    //     /* Because the sequence number of some devices is not recounted */
-    //     if (!a2dp_sink_local_param.media_pkt_seq_num.seq_num_recount ||
-    //             a2dp_sink_local_param.media_pkt_seq_num.expected_seq_num != 0x1) {
-    //         APPL_TRACE_WARNING("Sequence numbers error, recv:0x%x, expect:0x%x, recount:0x%x",
-    //                             p_msg->layer_specific, a2dp_sink_local_param.media_pkt_seq_num.expected_seq_num,
-    //                             a2dp_sink_local_param.media_pkt_seq_num.seq_num_recount);
-    //     }
-    // }
-    // a2dp_sink_local_param.media_pkt_seq_num.expected_seq_num  = p_msg->layer_specific + 1;
-    // a2dp_sink_local_param.media_pkt_seq_num.seq_num_recount = false;
+    // no decoder state (codec failed to initialize, or no decode buffer)
+    if (!a2dp_sink_local_param.decoder || !a2dp_sink_local_param.decode_buf) {
+        return;
+    }
+
+    btc_a2dp_sink_batch_lend();
+
+    UINT8 level = btc_a2dp_sink_decode_level;
+    if (level != a2dp_sink_local_param.decode_level) {
+        if (a2dp_sink_local_param.decoder->decoder_set_level) {
+            a2dp_sink_local_param.decoder->decoder_set_level(level);
+        }
+        a2dp_sink_local_param.decode_level = level;
+    }
+
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+    /* Conceal whatever went missing in front of this packet. A late or
+     * duplicate one has been played or concealed already: not decoded, the
+     * caller frees it. */
+    if (btc_a2dp_sink_plc_check_loss(p_msg)) {
+        return;
+    }
+#endif
 
     if (a2dp_sink_local_param.decoder->decode_packet_header) {
         ssize_t res = a2dp_sink_local_param.decoder->decode_packet_header(p_msg);
         if (res < 0) {
+            esp_a2d_sink_media_loss_hook(ESP_A2D_SINK_MEDIA_LOSS_DECODE, 1);
             return;
         }
     }
 
+    if (p_msg->offset >= BTC_A2DP_SNK_STAMP_MIN_OFFSET) {
+        const UINT32 *stamp = (const UINT32 *)(p_msg + 1);
+        esp_a2d_sink_media_stamp_hook(stamp[0], stamp[1]);
+    }
+
     if (a2dp_sink_local_param.decoder->decode_packet) {
-        unsigned char* buf = a2dp_sink_local_param.decode_buf;
-        size_t buf_len = BT_A2DP_SINK_BUF_SIZE;
-        a2dp_sink_local_param.decoder->decode_packet(p_msg, buf, buf_len);
+        /* In batch mode decode in place behind the PCM already accumulated */
+        unsigned char* buf = btc_a2dp_sink_batch_buf() + a2dp_sink_local_param.batch_fill;
+        size_t buf_len = btc_a2dp_sink_batch_size() - a2dp_sink_local_param.batch_fill;
+        uint32_t start = esp_cpu_get_cycle_count();
+        bool decoded = a2dp_sink_local_param.decoder->decode_packet(p_msg, buf, buf_len);
+        esp_a2d_sink_decode_trace_hook(esp_cpu_get_cycle_count() - start);
+        if (!decoded) {
+            esp_a2d_sink_media_loss_hook(ESP_A2D_SINK_MEDIA_LOSS_DECODE, 1);
+        }
+    }
+
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+    if (a2dp_sink_local_param.plc.pkt_bytes > 0) {
+        a2dp_sink_local_param.plc.blk_bytes = a2dp_sink_local_param.plc.pkt_bytes;
     }
+#endif
 }
 
 /*******************************************************************************
@@ -601,8 +1101,8 @@ static void btc_a2dp_sink_rx_flush(void)
  **
  ** Function         btc_a2dp_sink_enque_buf
  **
- ** Description      This function is called by the av_co to fill A2DP Sink Queue
- **
+ ** Description      This function is called by the av_co to fill A2DP Sink Queue.
+ **                  Takes ownership of p_pkt and queues it without copying.
  **
  ** Returns          size of the queue
  *******************************************************************************/
@@ -613,8 +1113,6 @@ static void btc_a2dp_sink_rx_flush(void)
 
 UINT8 btc_a2dp_sink_enque_buf(BT_HDR *p_pkt)
 {
-    BT_HDR *p_msg;
-
     if (btc_a2dp_sink_state != BTC_A2DP_SINK_STATE_ON){
         osi_free(p_pkt);  /* Free original - caller expects us to take ownership */
         return 0;
@@ -625,8 +1123,19 @@ UINT8 btc_a2dp_sink_enque_buf(BT_HDR *p_pkt)
         return fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
     }
 
-    if (fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ) >= MAX_OUTPUT_A2DP_SNK_FRAME_QUEUE_SZ) {
-        APPL_TRACE_WARNING("Pkt dropped\n");
+    a2dp_sink_local_param.rx_stats.received++;
+    a2dp_sink_local_param.rx_stats.bytes += p_pkt->len;
+    if (p_pkt->len > a2dp_sink_local_param.rx_stats.max_len) {
+        a2dp_sink_local_param.rx_stats.max_len = p_pkt->len;
+    }
+
+    if (fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ) >= btc_a2dp_sink_rx_queue_limit) {
+        /* Reported through the hook: no log line on the BTU task */
+        __atomic_fetch_add(&a2dp_sink_local_param.rx_stats.dropped, 1, __ATOMIC_RELAXED);
+        esp_a2d_sink_media_loss_hook(ESP_A2D_SINK_MEDIA_LOSS_QUEUE_FULL, 1);
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+        a2dp_sink_local_param.plc.tail_dropped++;
+#endif
         osi_free(p_pkt);  /* Free original - caller expects us to take ownership */
         return fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
     }
@@ -635,47 +1144,78 @@ UINT8 btc_a2dp_sink_enque_buf(BT_HDR *p_pkt)
      * flush some buffers BEFORE we hit critical allocation failures.
      * This keeps the HCI layer healthy during high-bandwidth streaming. */
     size_t free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-    if (free_internal < (MEMORY_PRESSURE_THRESHOLD_KB * 1024)) {
+#if (BTC_A2DP_SNK_RX_SLAB_INCLUDED == TRUE)
+    /* Slab-held packets give no heap back when dropped */
+    BOOLEAN heap_held = (a2dp_sink_local_param.rx_slab.pool == NULL);
+#else
+    BOOLEAN heap_held = TRUE;
+#endif
+    if (heap_held && free_internal < (MEMORY_PRESSURE_THRESHOLD_KB * 1024) &&
+            esp_a2d_sink_memory_pressure_hook(free_internal, false)) {
         /* Low memory - drop oldest packets from queue to make room */
         int queue_len = fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
         if (queue_len > 10) {
             /* Drop half the queue to recover quickly */
             int to_drop = queue_len / 2;
-            APPL_TRACE_WARNING("Low memory (%u KB free), dropping %d oldest packets", 
-                             (unsigned)(free_internal / 1024), to_drop);
             for (int i = 0; i < to_drop; i++) {
                 void *buf = fixed_queue_dequeue(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ, 0);
-                if (buf) {
-                    osi_free(buf);
-                }
+                btc_a2dp_sink_free_buf(buf);
             }
+            __atomic_fetch_add(&a2dp_sink_local_param.rx_stats.dropped, (UINT32)to_drop, __ATOMIC_RELAXED);
+            esp_a2d_sink_media_loss_hook(ESP_A2D_SINK_MEDIA_LOSS_MEMORY, (uint32_t)to_drop);
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+            __atomic_fetch_add(&a2dp_sink_local_param.plc.head_dropped, (UINT32)to_drop, __ATOMIC_RELAXED);
+#endif
         }
     }
 
     APPL_TRACE_DEBUG("btc_a2dp_sink_enque_buf + ");
 
-    /* allocate and Queue this buffer in internal RAM */
-    size_t alloc_size = sizeof(BT_HDR) + p_pkt->offset + p_pkt->len;
-    p_msg = (BT_HDR *) osi_malloc(alloc_size);
-    if (p_msg != NULL) {
-        memcpy(p_msg, p_pkt, alloc_size);
-        /* Non-blocking: never stall the BT stack thread. If the queue is full,
-         * drop this packet rather than blocking and causing stutter.
-         */
-        if (!fixed_queue_enqueue(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ, p_msg, 0)) {
-            osi_free(p_msg);
-            osi_free(p_pkt);
-            return fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
-        }
+    /* Arrival time travels with the packet (the slab copy keeps the headroom) */
+    if (p_pkt->offset >= BTC_A2DP_SNK_STAMP_MIN_OFFSET) {
+        ((UINT32 *)(p_pkt + 1))[1] = (UINT32)esp_timer_get_time();
+    }
+
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+    /* Drops right before this packet, for codecs without an RTP sequence;
+     * with one, layer_specific stays as the lower layers set it */
+    if (!a2dp_sink_local_param.plc.has_seq) {
+        p_pkt->layer_specific = a2dp_sink_local_param.plc.tail_dropped;
+    }
+    a2dp_sink_local_param.plc.tail_dropped = 0;
+#endif
+
+#if (BTC_A2DP_SNK_RX_SLAB_INCLUDED == TRUE)
+    /* Park the packet in a fixed slab slot and release the lower-layer buffer
+     * right away, so no long-lived heap blocks pile up in internal RAM while
+     * the queue is deep. */
+    p_pkt = btc_a2dp_sink_slab_enque(p_pkt);
+    if (p_pkt == NULL) {
         osi_thread_post_event(a2dp_sink_local_param.btc_aa_snk_cb.data_ready_event, 0);
-        /* Free original packet from lower layer after making our copy */
-        osi_free(p_pkt);
-    } else {
-        /* let caller deal with a failed allocation */
-        APPL_TRACE_WARNING("btc_a2dp_sink_enque_buf No Buffer left - ");
-        /* Allocation failed: still free original to avoid leaking lower-layer packet */
-        osi_free(p_pkt);
+        return fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
+    }
+#endif
+
+    /* Zero-copy handoff: the lower layer already allocated p_pkt to the exact
+     * reassembled AVDTP size, so queue it as-is and let the media task free it
+     * after decoding. This keeps the BTU thread free of malloc/memcpy on the
+     * media path. Non-blocking: never stall the BT stack thread; if the queue
+     * is full, drop this packet rather than blocking and causing stutter.
+     */
+    if (!fixed_queue_enqueue(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ, p_pkt, 0)) {
+        __atomic_fetch_add(&a2dp_sink_local_param.rx_stats.dropped, 1, __ATOMIC_RELAXED);
+        esp_a2d_sink_media_loss_hook(ESP_A2D_SINK_MEDIA_LOSS_QUEUE_FULL, 1);
+        btc_a2dp_sink_free_buf(p_pkt);
+        return fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
     }
+    if (btc_a2dp_sink_pull_mode) {
+        /* No handoff to the media task: the application decodes when its
+         * output needs the next block */
+        UINT16 queued = (UINT16)fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
+        esp_a2d_sink_pull_ready_hook(queued);
+        return (UINT8)queued;
+    }
+    osi_thread_post_event(a2dp_sink_local_param.btc_aa_snk_cb.data_ready_event, 0);
     return fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
 }
 
@@ -697,9 +1237,7 @@ static void btc_a2dp_sink_flush_q(fixed_queue_t *p_q)
 {
     while (! fixed_queue_is_empty(p_q)) {
         void *buf = fixed_queue_dequeue(p_q, 0);
-        if (buf) {
-            osi_free(buf);
-        }
+        btc_a2dp_sink_free_buf(buf);
     }
 }
 
@@ -715,17 +1253,30 @@ static void btc_a2dp_sink_thread_init(UNUSED_ATTR void *context)
     osi_event_bind(data_event, a2dp_sink_local_param.btc_aa_snk_task_hdl, BTC_A2DP_SNK_DATA_QUEUE_IDX);
     a2dp_sink_local_param.btc_aa_snk_cb.data_ready_event = data_event;
 
-    a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ = fixed_queue_new(QUEUE_SIZE_MAX);
+    a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ = fixed_queue_new(BTC_A2DP_SNK_RX_QUEUE_CAPACITY);
+
+    /* Sized for each codec at decoder reset */
+    a2dp_sink_local_param.decode_buf = NULL;
+    a2dp_sink_local_param.decode_buf_size = 0;
+    a2dp_sink_local_param.batch_fill = 0;
+    a2dp_sink_local_param.lent_buf = NULL;
+
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+    /* Without history the sink simply runs without concealment */
+    memset(&a2dp_sink_local_param.plc, 0, sizeof(a2dp_sink_local_param.plc));
+    a2dp_sink_local_param.plc.hist = (UINT8 *)osi_malloc(BTC_A2DP_SNK_PLC_HIST_SIZE);
+#endif
 
-    a2dp_sink_local_param.decode_buf = (unsigned char *)osi_malloc(BT_A2DP_SINK_BUF_SIZE);
-    assert(a2dp_sink_local_param.decode_buf != NULL);
+#if (BTC_A2DP_SNK_RX_SLAB_INCLUDED == TRUE)
+    btc_a2dp_sink_slab_init();
+#endif
 
     btc_a2dp_control_init();
 }
 
 static void btc_a2dp_sink_thread_cleanup(UNUSED_ATTR void *context)
 {
-
+    osi_mutex_lock(&btc_a2dp_sink_decode_lock, OSI_MUTEX_MAX_TIMEOUT);
     if (a2dp_sink_local_param.decoder && a2dp_sink_local_param.decoder->decoder_cleanup) {
         a2dp_sink_local_param.decoder->decoder_cleanup();
         a2dp_sink_local_param.decoder = NULL;
@@ -734,6 +1285,7 @@ static void btc_a2dp_sink_thread_cleanup(UNUSED_ATTR void *context)
     btc_a2dp_control_set_datachnl_stat(FALSE);
     /* Clear task flag */
     btc_a2dp_sink_state = BTC_A2DP_SINK_STATE_OFF;
+    osi_mutex_unlock(&btc_a2dp_sink_decode_lock);
 
     btc_a2dp_control_cleanup();
 
@@ -741,6 +1293,10 @@ static void btc_a2dp_sink_thread_cleanup(UNUSED_ATTR void *context)
 
     a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ = NULL;
 
+#if (BTC_A2DP_SNK_RX_SLAB_INCLUDED == TRUE)
+    btc_a2dp_sink_slab_deinit();
+#endif
+
     osi_event_delete(a2dp_sink_local_param.btc_aa_snk_cb.data_ready_event);
     a2dp_sink_local_param.btc_aa_snk_cb.data_ready_event = NULL;
 
@@ -749,16 +1305,29 @@ static void btc_a2dp_sink_thread_cleanup(UNUSED_ATTR void *context)
         osi_free(a2dp_sink_local_param.decode_buf);
         a2dp_sink_local_param.decode_buf = NULL;
     }
+    a2dp_sink_local_param.decode_buf_size = 0;
+
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+    osi_free(a2dp_sink_local_param.plc.hist);
+    a2dp_sink_local_param.plc.hist = NULL;
+#endif
 }
 
+/* Packets shed on an allocation failure the application asked to ride out:
+ * just enough for the failed HCI allocation to be retried */
+#define BTC_A2DP_SNK_PRESSURE_MIN_SHED  2
+
 /*******************************************************************************
  **
  ** Function         btc_a2dp_sink_on_memory_pressure
  **
  ** Description      Called by HCI layer when memory allocation fails.
- **                  Immediately flushes queued audio packets to free internal RAM.
- **                  This is a synchronous flush - directly clears the queue without
- **                  posting a message (which might also fail due to low memory).
+ **                  Drops the oldest queued audio packets to free internal RAM:
+ **                  half the queue, or only a couple of packets while the
+ **                  application (esp_a2d_sink_memory_pressure_hook) is still
+ **                  degrading other subsystems. This is synchronous - the queue
+ **                  is trimmed directly without posting a message (which might
+ **                  also fail due to low memory).
  **
  ** Returns          void
  **
@@ -776,31 +1345,38 @@ void btc_a2dp_sink_on_memory_pressure(void)
         return;
     }
 
-    /* Enable flush mode to discard new incoming packets */
-    a2dp_sink_local_param.btc_aa_snk_cb.rx_flush = TRUE;
+    if (a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ == NULL) {
+        APPL_TRACE_WARNING("%s: RxSbcQ is NULL!", __func__);
+        return;
+    }
 
-    /* Directly flush the queue - don't post a message since we're low on memory */
-    if (a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ != NULL) {
-        int queue_len = fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
-        APPL_TRACE_WARNING("%s: Queue has %d packets", __func__, queue_len);
-        
-        int flushed = 0;
-        while (!fixed_queue_is_empty(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ)) {
-            void *buf = fixed_queue_dequeue(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ, 0);
-            if (buf) {
-                osi_free(buf);
-                flushed++;
-            }
+    /* Directly trim the queue - don't post a message since we're low on memory.
+     * Oldest first, so what is left still plays in order. */
+    int queue_len = fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
+    int to_drop = queue_len - queue_len / 2;
+    if (!esp_a2d_sink_memory_pressure_hook(free_internal, true)) {
+        to_drop = queue_len < BTC_A2DP_SNK_PRESSURE_MIN_SHED ? queue_len : BTC_A2DP_SNK_PRESSURE_MIN_SHED;
+    }
+
+    int flushed = 0;
+    while (flushed < to_drop) {
+        void *buf = fixed_queue_dequeue(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ, 0);
+        if (buf == NULL) {
+            break;
         }
-        APPL_TRACE_WARNING("%s: Flushed %d packets, internal RAM now: %u bytes", 
-                          __func__, flushed, 
-                          (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
-    } else {
-        APPL_TRACE_WARNING("%s: RxSbcQ is NULL!", __func__);
+        btc_a2dp_sink_free_buf(buf);
+        flushed++;
     }
-    
-    /* Re-enable rx after a short delay - let memory stabilize */
-    a2dp_sink_local_param.btc_aa_snk_cb.rx_flush = FALSE;
+    __atomic_fetch_add(&a2dp_sink_local_param.rx_stats.dropped, (UINT32)flushed, __ATOMIC_RELAXED);
+    if (flushed > 0) {
+        esp_a2d_sink_media_loss_hook(ESP_A2D_SINK_MEDIA_LOSS_MEMORY, (uint32_t)flushed);
+    }
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+    __atomic_fetch_add(&a2dp_sink_local_param.plc.head_dropped, (UINT32)flushed, __ATOMIC_RELAXED);
+#endif
+    APPL_TRACE_WARNING("%s: Dropped %d of %d packets, internal RAM now: %u bytes", 
+                      __func__, flushed, queue_len,
+                      (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
 }
 
 /*******************************************************************************
@@ -812,13 +1388,691 @@ void btc_a2dp_sink_on_memory_pressure(void)
  ** Returns          Number of packets in queue, or 0 if queue not initialized
  **
  *******************************************************************************/
-UINT8 btc_a2dp_sink_get_queue_depth(void)
+UINT16 btc_a2dp_sink_get_queue_depth(void)
 {
     if (btc_a2dp_sink_state != BTC_A2DP_SINK_STATE_ON ||
         a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ == NULL) {
         return 0;
     }
-    return (UINT8)fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
+    return (UINT16)fixed_queue_length(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
+}
+
+#if (BTC_A2DP_SNK_RX_SLAB_INCLUDED == TRUE)
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_slab_init
+ **
+ ** Description      Create the RX slab lock. Backing store is allocated lazily
+ **                  at decoder reset, once the codec is known.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btc_a2dp_sink_slab_init(void)
+{
+    tBTC_A2DP_SINK_SLAB *slab = &a2dp_sink_local_param.rx_slab;
+
+    memset(slab, 0, sizeof(*slab));
+    if (osi_mutex_new(&slab->lock) != 0) {
+        APPL_TRACE_ERROR("%s: slab mutex create failed", __func__);
+    }
+}
+
+static void btc_a2dp_sink_slab_release_pool(tBTC_A2DP_SINK_SLAB *slab)
+{
+    if (slab->pool) {
+        heap_caps_free(slab->pool);
+        slab->pool = NULL;
+    }
+    if (slab->free_stack) {
+        heap_caps_free(slab->free_stack);
+        slab->free_stack = NULL;
+    }
+    slab->slot_count = 0;
+    slab->slot_size = 0;
+    slab->free_top = 0;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_slab_deinit
+ **
+ ** Description      Release the RX slab. RxSbcQ must already be drained.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btc_a2dp_sink_slab_deinit(void)
+{
+    tBTC_A2DP_SINK_SLAB *slab = &a2dp_sink_local_param.rx_slab;
+
+    if (!osi_mutex_valid(&slab->lock)) {
+        return;
+    }
+    osi_mutex_lock(&slab->lock, OSI_MUTEX_MAX_TIMEOUT);
+    btc_a2dp_sink_slab_release_pool(slab);
+    osi_mutex_unlock(&slab->lock);
+    osi_mutex_free(&slab->lock);
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_slab_reset
+ **
+ ** Description      Drop queued packets and (re)build the slab for slot_size
+ **                  byte packets, clearing the statistics. Called on codec
+ **                  change; holding the lock keeps the BTU thread from parking
+ **                  packets in the slab while it is rebuilt.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btc_a2dp_sink_slab_reset(UINT16 slot_size)
+{
+    tBTC_A2DP_SINK_SLAB *slab = &a2dp_sink_local_param.rx_slab;
+
+    if (!osi_mutex_valid(&slab->lock)) {
+        return;
+    }
+    slot_size = (slot_size + 3) & ~3;
+
+    osi_mutex_lock(&slab->lock, OSI_MUTEX_MAX_TIMEOUT);
+    while (!fixed_queue_is_empty(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ)) {
+        UINT8 *buf = (UINT8 *)fixed_queue_dequeue(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ, 0);
+        if (buf && (slab->pool == NULL || buf < slab->pool ||
+                    buf >= slab->pool + (size_t)slab->slot_count * slab->slot_size)) {
+            osi_free(buf);
+        }
+    }
+
+    if (slab->pool == NULL || slab->slot_size != slot_size) {
+        btc_a2dp_sink_slab_release_pool(slab);
+        slab->pool = (UINT8 *)heap_caps_malloc((size_t)slot_size * BTC_A2DP_SNK_RX_SLAB_SLOTS,
+                                               BTC_A2DP_SNK_RX_SLAB_CAPS);
+        slab->free_stack = (UINT16 *)heap_caps_malloc(sizeof(UINT16) * BTC_A2DP_SNK_RX_SLAB_SLOTS,
+                                                      MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (slab->pool == NULL || slab->free_stack == NULL) {
+            APPL_TRACE_WARNING("%s: no memory for %u byte slab, using heap buffers", __func__,
+                               (unsigned)(slot_size * BTC_A2DP_SNK_RX_SLAB_SLOTS));
+            btc_a2dp_sink_slab_release_pool(slab);
+        } else {
+            slab->slot_size = slot_size;
+            slab->slot_count = BTC_A2DP_SNK_RX_SLAB_SLOTS;
+        }
+    }
+
+    for (UINT16 i = 0; i < slab->slot_count; i++) {
+        slab->free_stack[i] = slab->slot_count - 1 - i;
+    }
+    slab->free_top = slab->slot_count;
+    memset(&slab->stats, 0, sizeof(slab->stats));
+    slab->stats.slot_size = slab->slot_size;
+    slab->stats.slot_count = slab->slot_count;
+    osi_mutex_unlock(&slab->lock);
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_slab_enque
+ **
+ ** Description      Copy p_pkt into a free slot and queue the slot, freeing
+ **                  p_pkt. Alloc, copy and enqueue happen under the slab lock
+ **                  so a concurrent reset can never see a slot in flight.
+ **
+ ** Returns          NULL if the packet was consumed (queued or dropped), or
+ **                  p_pkt untouched if it has to go through the heap path
+ **
+ *******************************************************************************/
+static BT_HDR *btc_a2dp_sink_slab_enque(BT_HDR *p_pkt)
+{
+    tBTC_A2DP_SINK_SLAB *slab = &a2dp_sink_local_param.rx_slab;
+    size_t size = sizeof(BT_HDR) + p_pkt->offset + p_pkt->len;
+    BOOLEAN lost = FALSE;
+
+    if (!osi_mutex_valid(&slab->lock)) {
+        return p_pkt;
+    }
+    osi_mutex_lock(&slab->lock, OSI_MUTEX_MAX_TIMEOUT);
+    if (slab->pool == NULL) {
+        /* not sized yet */
+    } else if (size > slab->slot_size) {
+        slab->stats.oversize++;
+    } else if (slab->free_top == 0) {
+        slab->stats.exhausted++;
+    } else {
+        UINT16 idx = slab->free_stack[--slab->free_top];
+        BT_HDR *p_slot = (BT_HDR *)(slab->pool + (size_t)idx * slab->slot_size);
+
+        memcpy(p_slot, p_pkt, size);
+        osi_free(p_pkt);
+        if (!fixed_queue_enqueue(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ, p_slot, 0)) {
+            slab->free_stack[slab->free_top++] = idx;
+            lost = TRUE;
+        } else {
+            slab->stats.allocs++;
+            slab->stats.in_use = slab->slot_count - slab->free_top;
+            if (slab->stats.in_use > slab->stats.high_water) {
+                slab->stats.high_water = slab->stats.in_use;
+            }
+        }
+        p_pkt = NULL;
+    }
+    osi_mutex_unlock(&slab->lock);
+    if (lost) {
+        __atomic_fetch_add(&a2dp_sink_local_param.rx_stats.dropped, 1, __ATOMIC_RELAXED);
+        esp_a2d_sink_media_loss_hook(ESP_A2D_SINK_MEDIA_LOSS_QUEUE_FULL, 1);
+    }
+    return p_pkt;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_slab_free
+ **
+ ** Description      Return buf to the slab if it is one of its slots
+ **
+ ** Returns          TRUE if buf belonged to the slab
+ **
+ *******************************************************************************/
+static BOOLEAN btc_a2dp_sink_slab_free(void *buf)
+{
+    tBTC_A2DP_SINK_SLAB *slab = &a2dp_sink_local_param.rx_slab;
+    BOOLEAN owned = FALSE;
+
+    if (!osi_mutex_valid(&slab->lock)) {
+        return FALSE;
+    }
+    osi_mutex_lock(&slab->lock, OSI_MUTEX_MAX_TIMEOUT);
+    if (slab->pool != NULL && (UINT8 *)buf >= slab->pool &&
+        (UINT8 *)buf < slab->pool + (size_t)slab->slot_count * slab->slot_size) {
+        UINT16 idx = (UINT16)(((UINT8 *)buf - slab->pool) / slab->slot_size);
+        if (slab->free_top < slab->slot_count) {
+            slab->free_stack[slab->free_top++] = idx;
+        }
+        slab->stats.in_use = slab->slot_count - slab->free_top;
+        owned = TRUE;
+    }
+    osi_mutex_unlock(&slab->lock);
+    return owned;
+}
+#endif /* BTC_A2DP_SNK_RX_SLAB_INCLUDED */
+
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+static inline float btc_a2dp_sink_plc_get(const UINT8 *p, UINT32 i, UINT8 smpl_bytes)
+{
+    return (smpl_bytes == 2) ? (float)((const INT16 *)p)[i] : (float)((const INT32 *)p)[i];
+}
+
+static inline void btc_a2dp_sink_plc_put(UINT8 *p, UINT32 i, UINT8 smpl_bytes, float v)
+{
+    if (smpl_bytes == 2) {
+        ((INT16 *)p)[i] = (INT16)(v > 32767.0f ? 32767.0f : (v < -32768.0f ? -32768.0f : v));
+    } else {
+        /* 2147483520 is the largest float below 2^31 */
+        ((INT32 *)p)[i] = (INT32)(v > 2147483520.0f ? 2147483520.0f : (v < -2147483648.0f ? -2147483648.0f : v));
+    }
+}
+
+/* Concealment sample at the current phase of the periodic extension */
+static inline float btc_a2dp_sink_plc_next(tBTC_A2DP_SINK_PLC *plc, const UINT8 *hist, UINT32 nsmpl)
+{
+    float v = btc_a2dp_sink_plc_get(hist, nsmpl - plc->period + plc->phase, plc->smpl_bytes);
+    if (++plc->phase == plc->period) {
+        plc->phase = 0;
+    }
+    return v;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_plc_reset
+ **
+ ** Description      Restart concealment for a newly configured codec. Only
+ **                  the s16 codecs (SBC, AAC, Opus) differ from the s32
+ **                  containers of the vendor codecs; raw aptX and aptX-LL
+ **                  packets carry no RTP header.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btc_a2dp_sink_plc_reset(const UINT8 *p_codec_info)
+{
+    tBTC_A2DP_SINK_PLC *plc = &a2dp_sink_local_param.plc;
+
+    plc->hist_fill = 0;
+    plc->pkt_bytes = 0;
+    plc->blk_bytes = 0;
+    plc->concealed = 0;
+    plc->nbf = 0;
+    plc->seq_valid = FALSE;
+    plc->smpl_bytes = 2;
+    plc->has_seq = TRUE;
+    if (A2DP_GetCodecType(p_codec_info) == A2D_MEDIA_CT_NON_A2DP) {
+        uint32_t vendor_id = A2DP_VendorCodecGetVendorId(p_codec_info);
+        if (vendor_id != A2DP_OPUS_VENDOR_ID) {
+            plc->smpl_bytes = 4;
+        }
+        if (vendor_id == A2DP_APTX_VENDOR_ID || vendor_id == A2DP_APTX_LL_VENDOR_ID) {
+            plc->has_seq = FALSE;
+        }
+    }
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_plc_match
+ **
+ ** Description      Find the period, between MIN_LAG and MAX_LAG samples,
+ **                  whose waveform best matches the end of the history
+ **                  (normalized cross-correlation of the last MATCH samples)
+ **
+ ** Returns          period in interleaved samples
+ **
+ *******************************************************************************/
+static UINT32 btc_a2dp_sink_plc_match(const UINT8 *hist, UINT32 nsmpl, UINT8 smpl_bytes)
+{
+    const UINT32 tmpl = nsmpl - BTC_A2DP_SNK_PLC_MATCH;
+    UINT32 max_lag = tmpl < BTC_A2DP_SNK_PLC_MAX_LAG ? tmpl : BTC_A2DP_SNK_PLC_MAX_LAG;
+    UINT32 best = BTC_A2DP_SNK_PLC_MIN_LAG;
+    float best_c = -2.0f;
+    float ex = 0.0f;
+
+    for (UINT32 i = 0; i < BTC_A2DP_SNK_PLC_MATCH; i++) {
+        float x = btc_a2dp_sink_plc_get(hist, tmpl + i, smpl_bytes);
+        ex += x * x;
+    }
+    for (UINT32 lag = BTC_A2DP_SNK_PLC_MIN_LAG; lag <= max_lag; lag += 2) {
+        float num = 0.0f;
+        float ey = 0.0f;
+        for (UINT32 i = 0; i < BTC_A2DP_SNK_PLC_MATCH; i++) {
+            float x = btc_a2dp_sink_plc_get(hist, tmpl + i, smpl_bytes);
+            float y = btc_a2dp_sink_plc_get(hist, tmpl - lag + i, smpl_bytes);
+            num += x * y;
+            ey += y * y;
+        }
+        if (ex > 0.0f && ey > 0.0f) {
+            float c = num / sqrtf(ex * ey);
+            if (c > best_c) {
+                best_c = c;
+                best = lag;
+            }
+        }
+    }
+    return best;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_plc_conceal
+ **
+ ** Description      Output |lost| packets of concealment, each as long as
+ **                  the last good packet, at the batch tail of decode_buf.
+ **                  The gain falls linearly to zero over MAX_BLOCKS packets.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btc_a2dp_sink_plc_conceal(UINT32 lost)
+{
+    tBTC_A2DP_SINK_PLC *plc = &a2dp_sink_local_param.plc;
+    const UINT8 w = plc->smpl_bytes;
+    const UINT32 len = plc->blk_bytes;
+    const UINT32 nsmpl = plc->hist_fill / w;
+
+    if (plc->hist == NULL || a2dp_sink_local_param.decode_buf == NULL || len == 0 ||
+        len + a2dp_sink_local_param.decode_headroom > a2dp_sink_local_param.decode_buf_size ||
+        nsmpl < BTC_A2DP_SNK_PLC_MATCH + BTC_A2DP_SNK_PLC_MIN_LAG) {
+        return;
+    }
+    const UINT8 *hist = plc->hist + BTC_A2DP_SNK_PLC_HIST_SIZE - plc->hist_fill;
+    if (plc->nbf == 0) {
+        plc->period = btc_a2dp_sink_plc_match(hist, nsmpl, w);
+        plc->phase = 0;
+    }
+    if (lost > (UINT32)(BTC_A2DP_SNK_PLC_MAX_BLOCKS - plc->nbf)) {
+        lost = BTC_A2DP_SNK_PLC_MAX_BLOCKS - plc->nbf;
+    }
+
+    while (lost-- > 0) {
+        /* Leave the packet that follows its usual decode headroom */
+        if (btc_a2dp_sink_batch_size() - a2dp_sink_local_param.batch_fill < len + a2dp_sink_local_param.decode_headroom) {
+            btc_a2dp_sink_batch_flush();
+        }
+        UINT8 *out = btc_a2dp_sink_batch_buf() + a2dp_sink_local_param.batch_fill;
+        const UINT32 n = len / w;
+        const float g0 = 1.0f - (float)plc->nbf / BTC_A2DP_SNK_PLC_MAX_BLOCKS;
+        const float dg = -1.0f / BTC_A2DP_SNK_PLC_MAX_BLOCKS / n;
+
+        for (UINT32 i = 0; i < n; i++) {
+            btc_a2dp_sink_plc_put(out, i, w, (g0 + dg * i) * btc_a2dp_sink_plc_next(plc, hist, nsmpl));
+        }
+        plc->nbf++;
+        plc->concealed++;
+        btc_a2dp_sink_output(out, len);
+    }
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_plc_check_loss
+ **
+ ** Description      Count the packets lost in front of p_msg: the RTP
+ **                  sequence gap, or for codecs without one, the packets the
+ **                  sink dropped itself. Called before the packet is decoded.
+ **
+ ** Returns          TRUE if p_msg is late or a duplicate and must be skipped
+ **
+ *******************************************************************************/
+static BOOLEAN btc_a2dp_sink_plc_check_loss(BT_HDR *p_msg)
+{
+    tBTC_A2DP_SINK_PLC *plc = &a2dp_sink_local_param.plc;
+    UINT32 head = __atomic_exchange_n(&plc->head_dropped, 0, __ATOMIC_RELAXED);
+    UINT32 lost = 0;
+
+    plc->pkt_bytes = 0;
+    if (plc->has_seq) {
+        const UINT8 *rtp = (const UINT8 *)(p_msg + 1) + p_msg->offset;
+        if (p_msg->len < 4) {
+            return FALSE;
+        }
+        UINT16 seq = (UINT16)((rtp[2] << 8) | rtp[3]);
+        INT16 gap = (INT16)(seq - plc->expected_seq);
+        if (plc->seq_valid && gap < 0) {
+            /* Late or duplicate packet, keep waiting for the expected one */
+            return TRUE;
+        }
+        if (plc->seq_valid && gap > 0) {
+            if (gap <= BTC_A2DP_SNK_PLC_MAX_GAP) {
+                APPL_TRACE_DEBUG("%s: seq 0x%x, expected 0x%x", __func__, seq, plc->expected_seq);
+                lost = (UINT32)gap;
+                a2dp_sink_local_param.rx_stats.lost += lost;
+            } else {
+                APPL_TRACE_WARNING("Sequence numbers error, recv:0x%x, expect:0x%x",
+                                   seq, plc->expected_seq);
+            }
+        }
+        plc->expected_seq = seq + 1;
+        plc->seq_valid = TRUE;
+    } else {
+        lost = head + p_msg->layer_specific;
+    }
+
+    if (lost > 0) {
+        btc_a2dp_sink_plc_conceal(lost);
+    }
+    return FALSE;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_plc_good
+ **
+ ** Description      Decoded PCM on its way out: cross-fade it in after a
+ **                  loss and append it to the history
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+static void btc_a2dp_sink_plc_good(unsigned char *data, uint32_t len)
+{
+    tBTC_A2DP_SINK_PLC *plc = &a2dp_sink_local_param.plc;
+    const UINT8 w = plc->smpl_bytes;
+
+    if (plc->hist == NULL || len == 0) {
+        return;
+    }
+
+    if (plc->nbf > 0) {
+        const UINT32 nsmpl = plc->hist_fill / w;
+        const UINT8 *hist = plc->hist + BTC_A2DP_SNK_PLC_HIST_SIZE - plc->hist_fill;
+        const float g = 1.0f - (float)plc->nbf / BTC_A2DP_SNK_PLC_MAX_BLOCKS;
+        UINT32 n = len / w;
+
+        if (n > BTC_A2DP_SNK_PLC_OLA) {
+            n = BTC_A2DP_SNK_PLC_OLA;
+        }
+        for (UINT32 i = 0; i < n; i++) {
+            float a = (float)(i + 1) / (n + 1);
+            float v = a * btc_a2dp_sink_plc_get(data, i, w) +
+                      (1.0f - a) * g * btc_a2dp_sink_plc_next(plc, hist, nsmpl);
+            btc_a2dp_sink_plc_put(data, i, w, v);
+        }
+        APPL_TRACE_DEBUG("%s: recovered after %d concealed packets (%u total)",
+                         __func__, plc->nbf, (unsigned)plc->concealed);
+        plc->nbf = 0;
+    }
+
+    plc->pkt_bytes += len;
+    if (len >= BTC_A2DP_SNK_PLC_HIST_SIZE) {
+        memcpy(plc->hist, data + len - BTC_A2DP_SNK_PLC_HIST_SIZE, BTC_A2DP_SNK_PLC_HIST_SIZE);
+        plc->hist_fill = BTC_A2DP_SNK_PLC_HIST_SIZE;
+    } else {
+        UINT32 keep = BTC_A2DP_SNK_PLC_HIST_SIZE - len;
+        if (keep > plc->hist_fill) {
+            keep = plc->hist_fill;
+        }
+        memmove(plc->hist + BTC_A2DP_SNK_PLC_HIST_SIZE - len - keep,
+                plc->hist + BTC_A2DP_SNK_PLC_HIST_SIZE - keep, keep);
+        memcpy(plc->hist + BTC_A2DP_SNK_PLC_HIST_SIZE - len, data, len);
+        plc->hist_fill = keep + len;
+    }
+}
+#endif /* BTC_A2DP_SNK_PLC_INCLUDED */
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_get_slab_stats
+ **
+ ** Description      Snapshot the RX slab statistics
+ **
+ ** Returns          TRUE if the slab is enabled and stats were filled in
+ **
+ *******************************************************************************/
+BOOLEAN btc_a2dp_sink_get_slab_stats(tBTC_A2DP_SINK_SLAB_STATS *p_stats)
+{
+    if (p_stats == NULL) {
+        return FALSE;
+    }
+    memset(p_stats, 0, sizeof(*p_stats));
+#if (BTC_A2DP_SNK_RX_SLAB_INCLUDED == TRUE)
+    if (btc_a2dp_sink_state != BTC_A2DP_SINK_STATE_ON ||
+        !osi_mutex_valid(&a2dp_sink_local_param.rx_slab.lock)) {
+        return FALSE;
+    }
+    osi_mutex_lock(&a2dp_sink_local_param.rx_slab.lock, OSI_MUTEX_MAX_TIMEOUT);
+    *p_stats = a2dp_sink_local_param.rx_slab.stats;
+    osi_mutex_unlock(&a2dp_sink_local_param.rx_slab.lock);
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_get_rx_stats
+ **
+ ** Description      Snapshot the media packet statistics of the current stream
+ **
+ ** Returns          TRUE if the sink is running and stats were filled in
+ **
+ *******************************************************************************/
+BOOLEAN btc_a2dp_sink_get_rx_stats(tBTC_A2DP_SINK_RX_STATS *p_stats)
+{
+    if (p_stats == NULL) {
+        return FALSE;
+    }
+    memset(p_stats, 0, sizeof(*p_stats));
+    if (btc_a2dp_sink_state != BTC_A2DP_SINK_STATE_ON) {
+        return FALSE;
+    }
+    *p_stats = a2dp_sink_local_param.rx_stats;
+    p_stats->mtu = BTA_AV_MAX_A2DP_MTU;
+#if (BTC_A2DP_SNK_PLC_INCLUDED == TRUE)
+    p_stats->concealed = a2dp_sink_local_param.plc.concealed;
+#endif
+    return TRUE;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_set_rx_queue_limit
+ **
+ ** Description      Set the queue depth at which arriving media packets are
+ **                  dropped; 0 or anything above the default restores it
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btc_a2dp_sink_set_rx_queue_limit(UINT16 packets)
+{
+    if (packets == 0 || packets > MAX_OUTPUT_A2DP_SNK_FRAME_QUEUE_SZ) {
+        packets = MAX_OUTPUT_A2DP_SNK_FRAME_QUEUE_SZ;
+    }
+    btc_a2dp_sink_rx_queue_limit = packets;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_set_decode_level
+ **
+ ** Description      Set the decoder complexity level; the media task passes
+ **                  it to the decoder before the next packet
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btc_a2dp_sink_set_decode_level(UINT8 level)
+{
+    /* Past every codec's last step anyway; keeps UNSET free */
+    if (level >= BTC_A2DP_SNK_DECODE_LEVEL_UNSET) {
+        level = BTC_A2DP_SNK_DECODE_LEVEL_UNSET - 1;
+    }
+    btc_a2dp_sink_decode_level = level;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_set_pull_mode
+ **
+ ** Description      Switch between decoding on the media task as packets
+ **                  arrive and decoding on the application's task on demand.
+ **                  Packets queued when pull mode ends are handed to the
+ **                  media task.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btc_a2dp_sink_set_pull_mode(BOOLEAN enable)
+{
+    btc_a2dp_sink_pull_mode = enable;
+    if (!enable && btc_a2dp_sink_state == BTC_A2DP_SINK_STATE_ON &&
+            !fixed_queue_is_empty(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ)) {
+        osi_thread_post_event(a2dp_sink_local_param.btc_aa_snk_cb.data_ready_event, 0);
+    }
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_pull_decode
+ **
+ ** Description      Pull mode: decode up to max_packets queued packets on the
+ **                  calling task; their PCM goes to the data callback before
+ **                  this returns. Does not wait for the decoder: while the
+ **                  media task reconfigures it nothing is decoded.
+ **
+ ** Returns          Packets decoded
+ **
+ *******************************************************************************/
+UINT16 btc_a2dp_sink_pull_decode(UINT16 max_packets)
+{
+    if (!btc_a2dp_sink_pull_mode || btc_a2dp_sink_state != BTC_A2DP_SINK_STATE_ON ||
+            max_packets == 0) {
+        return 0;
+    }
+    if (osi_mutex_lock(&btc_a2dp_sink_decode_lock, 0) != 0) {
+        return 0;
+    }
+    int decoded = 0;
+    if (btc_a2dp_sink_state == BTC_A2DP_SINK_STATE_ON) {
+        if (a2dp_sink_local_param.btc_aa_snk_cb.rx_flush == TRUE) {
+            btc_a2dp_sink_flush_q(a2dp_sink_local_param.btc_aa_snk_cb.RxSbcQ);
+        } else {
+            decoded = btc_a2dp_sink_decode_queued(max_packets);
+        }
+    }
+    osi_mutex_unlock(&btc_a2dp_sink_decode_lock);
+    return decoded > 0 ? (UINT16)decoded : 0;
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_sep_filter
+ **
+ ** Description      AVDT discover filter: lets esp_a2d_sink_sep_offer_hook
+ **                  withhold sink endpoints from a peer. SBC, the mandatory
+ **                  codec, is always offered.
+ **
+ ** Returns          TRUE to offer the endpoint to bd_addr
+ **
+ *******************************************************************************/
+static BOOLEAN btc_a2dp_sink_sep_filter(BD_ADDR bd_addr, UINT8 tsep, const UINT8 *p_codec_info)
+{
+    if (tsep != AVDT_TSEP_SNK || A2DP_GetCodecType(p_codec_info) == A2D_MEDIA_CT_SBC) {
+        return TRUE;
+    }
+    return esp_a2d_sink_sep_offer_hook(bd_addr, p_codec_info) ? TRUE : FALSE;
+}
+
+/* BTU task: one RSSI reading completed */
+static void btc_a2dp_sink_rssi_cmpl(void *p_data)
+{
+    tBTA_RSSI_RESULTS *result = (tBTA_RSSI_RESULTS *)p_data;
+    if (result != NULL && result->status == BTM_SUCCESS) {
+        btc_a2dp_sink_link.rssi = result->rssi;
+        btc_a2dp_sink_link.rssi_readings++;
+    }
+}
+
+/* BTU task: one link quality reading completed */
+static void btc_a2dp_sink_link_quality_cmpl(void *p_data)
+{
+    tBTA_LINK_QUALITY_RESULTS *result = (tBTA_LINK_QUALITY_RESULTS *)p_data;
+    if (result != NULL && result->status == BTM_SUCCESS) {
+        btc_a2dp_sink_link.link_quality = result->link_quality;
+        btc_a2dp_sink_link.quality_readings++;
+    }
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_read_link
+ **
+ ** Description      Start an RSSI and a link quality reading of the BR/EDR
+ **                  ACL to bd_addr; the results land in the link statistics.
+ **                  A reading still outstanding makes the new one fail.
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btc_a2dp_sink_read_link(BD_ADDR bd_addr)
+{
+    BTA_DmReadRSSI(bd_addr, BTA_TRANSPORT_BR_EDR, btc_a2dp_sink_rssi_cmpl);
+    BTA_DmReadLinkQuality(bd_addr, btc_a2dp_sink_link_quality_cmpl);
+}
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_get_link_stats
+ **
+ ** Description      Snapshot the last link readings
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btc_a2dp_sink_get_link_stats(tBTC_A2DP_SINK_LINK_STATS *p_stats)
+{
+    *p_stats = btc_a2dp_sink_link;
 }
 
 #endif /* BTC_AV_SINK_INCLUDED */
@@ -54,9 +54,6 @@ bool g_a2dp_sink_ongoing_deinit;
 #define BTC_AV_SERVICE_NAME "Advanced Audio"
 
 #define BTC_TIMEOUT_AV_OPEN_ON_RC_SECS  2
-/* Max audio per 3-DH5 EDR packet: 23.2ms
-  jitter buffer: 5(JITTER_BUFFER_WATER_LEVEL) */
-#define BTC_DELAY_REPORT_DFT_VALUE      1200  // 120ms
 
 typedef enum {
     BTC_AV_STATE_IDLE = 0x0,
@@ -1768,7 +1765,9 @@ static void btc_a2d_sink_set_delay_value(UINT16 delay_value)
 {
     esp_a2d_cb_param_t param;
 
-    if (delay_value <= BTC_DELAY_REPORT_DFT_VALUE) {
+    /* Any measured value is valid; a sink with little buffering reports
+     * less than the stack's 120 ms default */
+    if (delay_value == 0) {
         param.a2d_set_delay_value_stat.delay_value = 0;
         param.a2d_set_delay_value_stat.set_state = ESP_A2D_SET_INVALID_PARAMS;
         btc_a2d_cb_to_app(ESP_A2D_SNK_SET_DELAY_VALUE_EVT, &param);
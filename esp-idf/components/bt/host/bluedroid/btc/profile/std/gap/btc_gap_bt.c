@@ -941,6 +941,7 @@ void btc_gap_bt_arg_deep_copy(btc_msg_t *msg, void *p_dest, void *p_src)
     case BTC_GAP_BT_ACT_SET_QOS:
     case BTC_GAP_BT_ACT_SET_PAGE_TIMEOUT:
     case BTC_GAP_BT_ACT_GET_PAGE_TIMEOUT:
+    case BTC_GAP_BT_ACT_SET_PAGE_SCAN_PARAM:
     case BTC_GAP_BT_ACT_SET_ACL_PKT_TYPES:
     case BTC_GAP_BT_ACT_GET_DEV_NAME:
 #if (ENC_KEY_SIZE_CTRL_MODE != ENC_KEY_SIZE_CTRL_MODE_NONE)
@@ -1024,6 +1025,7 @@ void btc_gap_bt_arg_deep_free(btc_msg_t *msg)
     case BTC_GAP_BT_ACT_SET_QOS:
     case BTC_GAP_BT_ACT_SET_PAGE_TIMEOUT:
     case BTC_GAP_BT_ACT_GET_PAGE_TIMEOUT:
+    case BTC_GAP_BT_ACT_SET_PAGE_SCAN_PARAM:
     case BTC_GAP_BT_ACT_SET_ACL_PKT_TYPES:
     case BTC_GAP_BT_ACT_GET_DEV_NAME:
 #if (ENC_KEY_SIZE_CTRL_MODE != ENC_KEY_SIZE_CTRL_MODE_NONE)
@@ -1142,6 +1144,10 @@ void btc_gap_bt_call_handler(btc_msg_t *msg)
         btc_gap_get_page_timeout();
         break;
     }
+    case BTC_GAP_BT_ACT_SET_PAGE_SCAN_PARAM: {
+        BTA_DmSetPageScanParam(arg->set_page_scan.type, arg->set_page_scan.interval, arg->set_page_scan.window);
+        break;
+    }
     case BTC_GAP_BT_ACT_SET_ACL_PKT_TYPES: {
         btc_gap_set_acl_pkt_types(arg);
         break;
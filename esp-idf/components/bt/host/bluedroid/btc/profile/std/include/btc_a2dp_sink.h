@@ -145,7 +145,131 @@ void btc_a2dp_sink_on_memory_pressure(void);
  ** Returns          Number of packets in queue, or 0 if queue not initialized
  **
  *******************************************************************************/
-UINT8 btc_a2dp_sink_get_queue_depth(void);
+UINT16 btc_a2dp_sink_get_queue_depth(void);
+
+/* RX packet slab statistics, reset on every codec change */
+typedef struct {
+    UINT16 slot_size;       /* bytes per slot, 0 if the slab is not allocated */
+    UINT16 slot_count;
+    UINT16 in_use;          /* slots currently queued */
+    UINT16 high_water;      /* most slots in use at once since the last reset */
+    UINT32 allocs;          /* packets parked in the slab */
+    UINT32 exhausted;       /* packets that found no free slot */
+    UINT32 oversize;        /* packets larger than a slot */
+} tBTC_A2DP_SINK_SLAB_STATS;
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_get_slab_stats
+ **
+ ** Description      Get a snapshot of the RX packet slab statistics
+ **
+ ** Returns          TRUE if the slab is enabled and p_stats was filled in
+ **
+ *******************************************************************************/
+BOOLEAN btc_a2dp_sink_get_slab_stats(tBTC_A2DP_SINK_SLAB_STATS *p_stats);
+
+/* Media packet statistics of the current stream, reset on every codec change */
+typedef struct {
+    UINT32 received;        /* packets handed to the sink by AVDTP */
+    UINT32 dropped;         /* packets the sink dropped (queue full, memory pressure) */
+    UINT32 lost;            /* packets missing from the RTP sequence (needs PLC) */
+    UINT32 concealed;       /* packets concealed by PLC */
+    UINT32 bytes;           /* media payload bytes received */
+    UINT32 pcm_bytes;       /* PCM bytes the decoder produced */
+    UINT16 max_len;         /* largest media payload received */
+    UINT16 mtu;             /* L2CAP MTU of the media channel */
+} tBTC_A2DP_SINK_RX_STATS;
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_get_rx_stats
+ **
+ ** Description      Get a snapshot of the media packet statistics
+ **
+ ** Returns          TRUE if the sink is running and p_stats was filled in
+ **
+ *******************************************************************************/
+BOOLEAN btc_a2dp_sink_get_rx_stats(tBTC_A2DP_SINK_RX_STATS *p_stats);
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_set_rx_queue_limit
+ **
+ ** Description      Set the queue depth at which arriving media packets are
+ **                  dropped (0 = default)
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btc_a2dp_sink_set_rx_queue_limit(UINT16 packets);
+
+/* Last radio readings of the source's ACL; the counts tell fresh readings
+ * from repeated ones */
+typedef struct {
+    INT8   rssi;            /* dB outside the golden receive power range, 0 inside */
+    UINT8  link_quality;    /* 0-255, controller specific, higher is better */
+    UINT16 rssi_readings;   /* RSSI readings completed (wraps) */
+    UINT16 quality_readings;/* link quality readings completed (wraps) */
+} tBTC_A2DP_SINK_LINK_STATS;
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_read_link
+ **
+ ** Description      Start an RSSI and a link quality reading of the BR/EDR
+ **                  ACL to bd_addr
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btc_a2dp_sink_read_link(BD_ADDR bd_addr);
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_get_link_stats
+ **
+ ** Description      Snapshot the last link readings
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btc_a2dp_sink_get_link_stats(tBTC_A2DP_SINK_LINK_STATS *p_stats);
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_set_decode_level
+ **
+ ** Description      Set the decoder complexity level (0 = full quality)
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btc_a2dp_sink_set_decode_level(UINT8 level);
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_set_pull_mode
+ **
+ ** Description      Decode on the application's task on demand (TRUE) or on
+ **                  the media task as packets arrive (FALSE, the default)
+ **
+ ** Returns          void
+ **
+ *******************************************************************************/
+void btc_a2dp_sink_set_pull_mode(BOOLEAN enable);
+
+/*******************************************************************************
+ **
+ ** Function         btc_a2dp_sink_pull_decode
+ **
+ ** Description      Pull mode: decode up to max_packets queued packets on the
+ **                  calling task
+ **
+ ** Returns          Packets decoded
+ **
+ *******************************************************************************/
+UINT16 btc_a2dp_sink_pull_decode(UINT16 max_packets);
 
 #endif /* #if BTC_AV_SINK_INCLUDED */
 
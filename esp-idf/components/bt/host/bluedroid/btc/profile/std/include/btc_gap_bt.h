@@ -68,6 +68,7 @@ typedef enum {
 #endif
     BTC_GAP_BT_ACT_SET_DEV_NAME,
     BTC_GAP_BT_ACT_GET_DEV_NAME,
+    BTC_GAP_BT_ACT_SET_PAGE_SCAN_PARAM,
 } btc_gap_bt_act_t;
 
 /* btc_bt_gap_args_t */
@@ -169,6 +170,13 @@ typedef union {
         uint16_t page_to;
     } set_page_to;
 
+    // BTC_GAP_BT_ACT_SET_PAGE_SCAN_PARAM
+    struct set_page_scan_args {
+        esp_bt_page_scan_type_t type;
+        uint16_t interval;
+        uint16_t window;
+    } set_page_scan;
+
     // BTC_GAP_BT_ACT_SET_ACL_PKT_TYPES
     struct set_acl_pkt_types_args {
         bt_bdaddr_t bda;
@@ -21,6 +21,12 @@
 #define UC_BTU_TASK_STACK_SIZE              4096
 #endif
 
+#ifdef CONFIG_BT_A2DP_SINK_TASK_CORE
+#define UC_BT_A2DP_SINK_TASK_CORE           CONFIG_BT_A2DP_SINK_TASK_CORE
+#else
+#define UC_BT_A2DP_SINK_TASK_CORE           1
+#endif
+
 
 /**********************************************************
  * Profile reference
@@ -57,31 +63,33 @@
 #define UC_BT_AVRCP_ENABLED                 FALSE
 #define UC_BT_AVRCP_CT_COVER_ART_ENABLED    FALSE
 #endif
-#ifdef CONFIG_BT_A2DP_APTX_DECODER
+/* A codec left out by the application's codec profile (CODEC_EXCLUDE_*,
+ * see the bt CMakeLists) is not built even with its decoder option on */
+#if defined(CONFIG_BT_A2DP_APTX_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_APTX)
 #define UC_BT_A2DP_APTX_DECODER_ENABLED    CONFIG_BT_A2DP_APTX_DECODER
 #else
 #define UC_BT_A2DP_APTX_DECODER_ENABLED    FALSE
 #endif
 
-#ifdef CONFIG_BT_A2DP_LDAC_DECODER
+#if defined(CONFIG_BT_A2DP_LDAC_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_LDAC)
 #define UC_BT_A2DP_LDAC_DECODER_ENABLED    CONFIG_BT_A2DP_LDAC_DECODER
 #else
 #define UC_BT_A2DP_LDAC_DECODER_ENABLED    FALSE
 #endif
 
-#ifdef CONFIG_BT_A2DP_OPUS_DECODER
+#if defined(CONFIG_BT_A2DP_OPUS_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_OPUS)
 #define UC_BT_A2DP_OPUS_DECODER_ENABLED    CONFIG_BT_A2DP_OPUS_DECODER
 #else
 #define UC_BT_A2DP_OPUS_DECODER_ENABLED    FALSE
 #endif
 
-#ifdef CONFIG_BT_A2DP_LC3PLUS_DECODER
+#if defined(CONFIG_BT_A2DP_LC3PLUS_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_LC3PLUS)
 #define UC_BT_A2DP_LC3PLUS_DECODER_ENABLED    CONFIG_BT_A2DP_LC3PLUS_DECODER
 #else
 #define UC_BT_A2DP_LC3PLUS_DECODER_ENABLED    FALSE
 #endif
 
-#ifdef CONFIG_BT_A2DP_AAC_DECODER
+#if defined(CONFIG_BT_A2DP_AAC_DECODER) && !defined(CONFIG_CODEC_EXCLUDE_AAC)
 #define UC_BT_A2DP_AAC_DECODER_ENABLED    CONFIG_BT_A2DP_AAC_DECODER
 #else
 #define UC_BT_A2DP_AAC_DECODER_ENABLED    FALSE
@@ -581,10 +589,20 @@
 
 #ifdef CONFIG_BT_GATTS_ROBUST_CACHING_ENABLED
 #define UC_BT_GATTS_ROBUST_CACHING_ENABLED      CONFIG_BT_GATTS_ROBUST_CACHING_ENABLED
+#elif defined(CONFIG_BLE_GATT_CACHING)
+/* Asked for by the application (BLE_GATT_CACHING) */
+#define UC_BT_GATTS_ROBUST_CACHING_ENABLED      TRUE
 #else
 #define UC_BT_GATTS_ROBUST_CACHING_ENABLED      FALSE
 #endif
 
+#ifdef CONFIG_BLE_BULK_CHANNEL
+/* Asked for by the application (BLE_BULK_CHANNEL) */
+#define UC_BT_BLE_L2CAP_COC_ENABLED             TRUE
+#else
+#define UC_BT_BLE_L2CAP_COC_ENABLED             FALSE
+#endif
+
 #ifdef CONFIG_BT_GATTS_DEVICE_NAME_WRITABLE
 #define UC_BT_GATTS_DEVICE_NAME_WRITABLE        CONFIG_BT_GATTS_DEVICE_NAME_WRITABLE
 #else
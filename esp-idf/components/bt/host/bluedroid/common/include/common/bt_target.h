@@ -1400,6 +1400,9 @@
 #endif
 
 /* Support status of L2CAP connection-oriented dynamic channels over LE transport with dynamic CID */
+#if (UC_BT_BLE_L2CAP_COC_ENABLED == TRUE) && (BLE_INCLUDED == TRUE)
+#define BLE_L2CAP_COC_INCLUDED          TRUE
+#endif
 #ifndef BLE_L2CAP_COC_INCLUDED
 #define BLE_L2CAP_COC_INCLUDED          FALSE // LE COC not use by default
 #endif
@@ -2308,31 +2311,31 @@
 /* Number of simultaneous stream endpoints. */
 #ifndef AVDT_NUM_SEPS
 
-# ifdef CONFIG_BT_A2DP_APTX_DECODER
+# if (UC_BT_A2DP_APTX_DECODER_ENABLED == TRUE)
 #  define AVDT_APTX_SEPS	(3)
 # else
 #  define AVDT_APTX_SEPS	(0)
-# endif /* CONFIG_BT_A2DP_APTX_DECODER */
-# ifdef CONFIG_BT_A2DP_LDAC_DECODER
+# endif /* (UC_BT_A2DP_APTX_DECODER_ENABLED == TRUE) */
+# if (UC_BT_A2DP_LDAC_DECODER_ENABLED == TRUE)
 #  define AVDT_LDAC_SEPS	(1)
 # else
 #  define AVDT_LDAC_SEPS	(0)
-# endif /* CONFIG_BT_A2DP_LDAC_DECODER */
-# ifdef CONFIG_BT_A2DP_OPUS_DECODER
+# endif /* (UC_BT_A2DP_LDAC_DECODER_ENABLED == TRUE) */
+# if (UC_BT_A2DP_OPUS_DECODER_ENABLED == TRUE)
 #  define AVDT_OPUS_SEPS	(1)
 # else
 #  define AVDT_OPUS_SEPS	(0)
-# endif /* CONFIG_BT_A2DP_OPUS_DECODER */
-# ifdef CONFIG_BT_A2DP_LC3PLUS_DECODER
+# endif /* (UC_BT_A2DP_OPUS_DECODER_ENABLED == TRUE) */
+# if (UC_BT_A2DP_LC3PLUS_DECODER_ENABLED == TRUE)
 #  define AVDT_LC3PLUS_SEPS	(1)
 # else
 #  define AVDT_LC3PLUS_SEPS	(0)
-# endif /* CONFIG_BT_A2DP_LC3PLUS_DECODER */
-# ifdef CONFIG_BT_A2DP_AAC_DECODER
+# endif /* (UC_BT_A2DP_LC3PLUS_DECODER_ENABLED == TRUE) */
+# if (UC_BT_A2DP_AAC_DECODER_ENABLED == TRUE)
 #  define AVDT_AAC_SEPS	(1)
 # else
 #  define AVDT_AAC_SEPS	(0)
-# endif /* CONFIG_BT_A2DP_AAC_DECODER */
+# endif /* (UC_BT_A2DP_AAC_DECODER_ENABLED == TRUE) */
 
 #define AVDT_NUM_SEPS      (3 \
 							+ AVDT_APTX_SEPS \
@@ -80,6 +80,14 @@ int aac_decoder_decode(aac_decoder_t *dec,
                        const uint8_t *data, int len,
                        int16_t *pcm_out, int *samples_out);
 
+/**
+ * Decode one raw AAC frame that starts bit_offset bits (0-7, from the MSB)
+ * into data[0], as located in place by latm_parse_payload()
+ */
+int aac_decoder_decode_bits(aac_decoder_t *dec,
+                            const uint8_t *data, int len, int bit_offset,
+                            int16_t *pcm_out, int *samples_out);
+
 /**
  * Deinitialize decoder
  */
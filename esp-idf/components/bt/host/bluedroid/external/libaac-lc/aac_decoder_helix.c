@@ -4,8 +4,9 @@
  * Wrapper around the RealNetworks Helix AAC decoder for ESP32.
  * This provides the aac_decoder.h interface using libhelix-aac.
  * 
- * Memory optimization: Uses static pre-allocated buffers to avoid
- * dynamic allocation and reduce memory fragmentation.
+ * Memory: the Helix state is one block, allocated in aac_decoder_init and
+ * freed in aac_decoder_deinit, so it only occupies RAM while AAC is the
+ * active codec.
  */
 
 #include <string.h>
@@ -14,6 +15,7 @@
 
 #include "aac_decoder.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 
 /* Include libhelix-aac headers */
 #include "aacdec.h"
@@ -23,20 +25,19 @@
 #define TAG "AAC_HELIX"
 
 /*******************************************************************************
- * Static Memory Pool - Pre-allocated to avoid malloc
+ * Decoder Memory Block
  * 
  * Memory layout:
  *   - AACDecInfo: ~100 bytes
  *   - PSInfoBase: ~26KB (includes coef[2][1024], overlap[2][1024], etc.)
  * 
- * Total: ~27KB static allocation
+ * Total: ~27KB, internal RAM preferred (touched on every frame)
  ******************************************************************************/
 
 /* Align to 8 bytes for safety */
 #define HELIX_BUFFER_SIZE (sizeof(AACDecInfo) + sizeof(PSInfoBase) + 64)
 
-/* Static buffer - placed in DRAM */
-static uint8_t s_helix_buffer[HELIX_BUFFER_SIZE] __attribute__((aligned(8)));
+static uint8_t *s_helix_buffer = NULL;
 static HAACDecoder s_helix_dec = NULL;
 static AACFrameInfo s_frame_info = {0};
 static bool s_initialized = false;
@@ -59,16 +60,23 @@ int aac_decoder_init(aac_decoder_t *dec)
         s_initialized = false;
     }
     
-    /* Clear static buffer */
-    memset(s_helix_buffer, 0, sizeof(s_helix_buffer));
-    
-    /* Initialize using pre-allocated buffer */
-    void *ptr = s_helix_buffer;
-    int size = sizeof(s_helix_buffer);
+    if (!s_helix_buffer) {
+        s_helix_buffer = heap_caps_malloc(HELIX_BUFFER_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!s_helix_buffer) {
+            s_helix_buffer = heap_caps_malloc(HELIX_BUFFER_SIZE, MALLOC_CAP_8BIT);
+        }
+        if (!s_helix_buffer) {
+            ESP_LOGE(TAG, "Failed to allocate helix AAC state (%u bytes)", (unsigned)HELIX_BUFFER_SIZE);
+            return AAC_ERR_NOMEM;
+        }
+    }
+    memset(s_helix_buffer, 0, HELIX_BUFFER_SIZE);
     
-    s_helix_dec = AACInitDecoderPre(ptr, size);
+    s_helix_dec = AACInitDecoderPre(s_helix_buffer, HELIX_BUFFER_SIZE);
     if (!s_helix_dec) {
-        ESP_LOGE(TAG, "Failed to init helix AAC decoder (static buffer)");
+        ESP_LOGE(TAG, "Failed to init helix AAC decoder");
+        heap_caps_free(s_helix_buffer);
+        s_helix_buffer = NULL;
         return AAC_ERR_NOMEM;
     }
     
@@ -78,7 +86,7 @@ int aac_decoder_init(aac_decoder_t *dec)
     dec->sample_rate = 44100;
     dec->channels = 2;
     
-    ESP_LOGI(TAG, "Helix AAC decoder initialized (static buffer: %u bytes)", sizeof(s_helix_buffer));
+    ESP_LOGI(TAG, "Helix AAC decoder initialized (%u bytes)", (unsigned)HELIX_BUFFER_SIZE);
     return AAC_OK;
 }
 
@@ -107,6 +115,12 @@ int aac_decoder_configure(aac_decoder_t *dec, int sample_rate, int channels)
 
 int aac_decoder_decode(aac_decoder_t *dec, const uint8_t *data, int len, 
                        int16_t *pcm_out, int *samples_out)
+{
+    return aac_decoder_decode_bits(dec, data, len, 0, pcm_out, samples_out);
+}
+
+int aac_decoder_decode_bits(aac_decoder_t *dec, const uint8_t *data, int len, int bit_offset,
+                            int16_t *pcm_out, int *samples_out)
 {
     if (!dec || !data || len < 1 || !pcm_out || !samples_out) {
         return AAC_ERR_PARAM;
@@ -126,12 +140,12 @@ int aac_decoder_decode(aac_decoder_t *dec, const uint8_t *data, int len,
         ESP_LOGI(TAG, "Decode #%lu: %d bytes", (unsigned long)call_count, len);
     }
     
-    /* Set up input pointers */
+    /* Set up input pointers; a frame starting mid-byte spans one more byte */
     unsigned char *inbuf = (unsigned char *)data;
-    int bytes_left = len;
+    int bytes_left = len + (bit_offset ? 1 : 0);
     
     /* Decode AAC frame */
-    int err = AACDecode(s_helix_dec, &inbuf, &bytes_left, pcm_out);
+    int err = AACDecodeBits(s_helix_dec, &inbuf, &bytes_left, bit_offset, pcm_out);
     
     if (err == ERR_AAC_NONE) {
         /* Get frame info */
@@ -161,9 +175,12 @@ int aac_decoder_decode(aac_decoder_t *dec, const uint8_t *data, int len,
 
 void aac_decoder_deinit(aac_decoder_t *dec)
 {
-    /* Static buffer - no need to free, just mark as uninitialized */
     s_helix_dec = NULL;
     s_initialized = false;
+    if (s_helix_buffer) {
+        heap_caps_free(s_helix_buffer);
+        s_helix_buffer = NULL;
+    }
     
     memset(&s_frame_info, 0, sizeof(s_frame_info));
     
@@ -289,6 +289,27 @@ int AACFlushCodec(HAACDecoder hAACDecoder)
  *                just call AACDecode again with more data in inbuf
  **************************************************************************************/
 int AACDecode(HAACDecoder hAACDecoder, unsigned char **inbuf, int *bytesLeft, short *outbuf)
+{
+	return AACDecodeBits(hAACDecoder, inbuf, bytesLeft, 0, outbuf);
+}
+
+/**************************************************************************************
+ * Function:    AACDecodeBits
+ *
+ * Description: decode AAC frame that starts inside the first byte of inbuf
+ *
+ * Inputs:      as AACDecode, plus
+ *              bit position (0-7, 0 = MSB) of the frame in the first byte of inbuf
+ *
+ * Outputs:     as AACDecode
+ *
+ * Return:      0 if successful, error code (< 0) if error
+ *
+ * Notes:       lets a transport parser (LATM) hand over a raw data block in
+ *                place, without realigning it to a byte boundary first;
+ *                only valid for raw blocks (AACSetRawBlockParams)
+ **************************************************************************************/
+int AACDecodeBits(HAACDecoder hAACDecoder, unsigned char **inbuf, int *bytesLeft, int bitOffsetStart, short *outbuf)
 {
 	int err, offset, bitOffset, bitsAvail;
 	int ch, baseChan, elementChans;
@@ -300,6 +321,8 @@ int AACDecode(HAACDecoder hAACDecoder, unsigned char **inbuf, int *bytesLeft, sh
 
 	if (!aacDecInfo)
 		return ERR_AAC_NULL_POINTER;
+	if (bitOffsetStart < 0 || bitOffsetStart > 7 || (bitOffsetStart && aacDecInfo->format != AAC_FF_RAW))
+		return ERR_AAC_INVALID_FRAME;
 
 	/* make local copies (see "Notes" above) */
 	inptr = *inbuf;
@@ -363,7 +386,8 @@ int AACDecode(HAACDecoder hAACDecoder, unsigned char **inbuf, int *bytesLeft, sh
 	aacDecInfo->tnsUsed = 0;
 	aacDecInfo->pnsUsed = 0;
 
-	bitOffset = 0;
+	bitOffset = bitOffsetStart;
+	bitsAvail -= bitOffsetStart;
 	baseChan = 0;
 #ifdef AAC_ENABLE_SBR	
 	baseChanSBR = 0;
@@ -153,6 +153,7 @@ HAACDecoder AACInitDecoder(void);
 HAACDecoder AACInitDecoderPre(void *ptr, int sz);
 void AACFreeDecoder(HAACDecoder hAACDecoder);
 int AACDecode(HAACDecoder hAACDecoder, unsigned char **inbuf, int *bytesLeft, short *outbuf);
+int AACDecodeBits(HAACDecoder hAACDecoder, unsigned char **inbuf, int *bytesLeft, int bitOffsetStart, short *outbuf);
 
 int AACFindSyncWord(unsigned char *buf, int nBytes);
 void AACGetLastFrameInfo(HAACDecoder hAACDecoder, AACFrameInfo *aacFrameInfo);
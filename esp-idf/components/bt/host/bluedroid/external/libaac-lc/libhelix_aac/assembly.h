@@ -500,6 +500,84 @@ static __inline Word64 MADD64(Word64 sum64, int x, int y)
 	return sum64;
 }
 
+/* toolchain:           xtensa gcc (ESP-IDF)
+ * target architecture: Xtensa LX6/LX7 (ESP32, ESP32-S3), which have the
+ *                      MUL32_HIGH, NSA, CLAMPS and ABS options
+ */
+#elif defined(__GNUC__) && defined(__XTENSA__)
+
+#include <xtensa/config/core-isa.h>
+
+#if !XCHAL_HAVE_MUL32_HIGH || !XCHAL_HAVE_NSA || !XCHAL_HAVE_CLAMPS || !XCHAL_HAVE_ABS
+#error assembly.h: Xtensa core without MUL32_HIGH, NSA, CLAMPS or ABS
+#endif
+
+typedef long long Word64;
+
+/* The C form depends on GCC spotting the widening multiply; written out
+ * it is one MULSH (MULL + MULSH for MADD64) at any optimization level */
+static __inline__ int MULSHIFT32(int x, int y)
+{
+	int z;
+
+	__asm__ ("mulsh %0, %1, %2" : "=r" (z) : "r" (x), "r" (y));
+
+	return z;
+}
+
+static __inline short CLIPTOSHORT(int x)
+{
+	/* clamp to [-2^15, 2^15 - 1] */
+	__asm__ ("clamps %0, %1, 15" : "=r" (x) : "r" (x));
+
+	return (short)x;
+}
+
+static __inline int FASTABS(int x) 
+{
+	/* like the generic version, 0x80000000 stays 0x80000000 */
+	__asm__ ("abs %0, %1" : "=r" (x) : "r" (x));
+
+	return x;
+}
+
+static __inline int CLZ(int x)
+{
+	int numZeros;
+
+	/* NSAU of 0 is 32, as the generic version returns */
+	__asm__ ("nsau %0, %1" : "=r" (numZeros) : "r" (x));
+
+	return numZeros;
+}
+
+typedef union _U64 {
+	Word64 w64;
+	struct {
+		/* Xtensa in ESP32 = little endian */
+		unsigned int lo32;
+		signed int   hi32;
+	} r;
+} U64;
+
+static __inline Word64 MADD64(Word64 sum64, int x, int y)
+{
+	U64 u;
+	unsigned int lo;
+	int hi;
+
+	u.w64 = sum64;
+	__asm__ ("mull %0, %1, %2" : "=r" (lo) : "r" (x), "r" (y));
+	__asm__ ("mulsh %0, %1, %2" : "=r" (hi) : "r" (x), "r" (y));
+	u.r.lo32 += lo;
+	u.r.hi32 += hi + (u.r.lo32 < lo);
+
+	return u.w64;
+}
+
+/* CLIP_2N and CLIP_2N_SHIFT: the generic versions below (n is out of
+ * CLAMPS' 7..22 immediate range, or not a constant) */
+
 #elif defined(ARDUINO) || defined(ESP32) || defined(__GNUC__) && (defined(__powerpc__) || defined(__POWERPC__)) || (defined (_SOLARIS) && !defined (__GNUC__) && !defined (_SOLARISX86))
 
 typedef long long Word64;
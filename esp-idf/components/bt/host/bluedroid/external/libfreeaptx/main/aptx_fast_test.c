@@ -0,0 +1,148 @@
+/* Bit-exactness test of the fast decode path (APTX_FAST_KERNELS) against
+ * aptx_decode32(): one second of test audio (tones, noise and full-scale
+ * steps that drive the quantizers and QMF to their limits) is encoded with
+ * aptx_encode() and decoded by both paths, for aptX and aptX HD, in one
+ * call and in random input / output chunks. Returns non-zero on the first
+ * mismatch. */
+#define APTX_FAST_KERNELS 1
+#include "freeaptx.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RATE        48000
+#define NSAMPLES    RATE
+#define NPASSES     8
+
+static unsigned int s_seed = 12345;
+static int rnd(int n) {
+    s_seed = s_seed * 1103515245u + 12345u;
+    return (int)((s_seed >> 8) % (unsigned int)n);
+}
+
+static int32_t clip24(int64_t v) {
+    return v > 0x7FFFFF ? 0x7FFFFF : v < -0x800000 ? -0x800000 : (int32_t)v;
+}
+
+/* 24-bit LLLRRR input for aptx_encode() */
+static void make_pcm(unsigned char *pcm) {
+    int32_t phase = 0;
+    for (int i = 0; i < NSAMPLES; i++) {
+        int32_t l, r;
+        const int part = i * 4 / NSAMPLES;
+        phase += 1 + i / 64;    /* Rising pitch */
+        if (part == 0) {
+            /* Two tones, the right one at half level */
+            l = (int32_t)(((phase & 0x3FF) - 0x200) * 0x3000);
+            r = (int32_t)(((i * 37) & 0x7FF) - 0x400) * 0xC00;
+        } else if (part == 1) {
+            /* Noise */
+            l = (rnd(0x1000000) - 0x800000);
+            r = (rnd(0x1000000) - 0x800000) / 16;
+        } else if (part == 2) {
+            /* Full-scale square waves, out of phase */
+            l = (i / 50) & 1 ? 0x7FFFFF : -0x800000;
+            r = -l - 1;
+        } else {
+            /* Decaying noise bursts into silence */
+            const int left = NSAMPLES - i;
+            l = (i % 4800) < 200 ? rnd(0x1000000) - 0x800000 : 0;
+            r = left < 1000 ? 0 : (rnd(0x2000) - 0x1000);
+        }
+        l = clip24(l);
+        r = clip24(r);
+        for (int b = 0; b < 3; b++) {
+            pcm[i * 6 + b] = (unsigned char)((uint32_t)l >> (8 * b));
+            pcm[i * 6 + 3 + b] = (unsigned char)((uint32_t)r >> (8 * b));
+        }
+    }
+}
+
+static size_t encode(int hd, const unsigned char *pcm, unsigned char *out, size_t cap) {
+    struct aptx_context *ctx = aptx_init(hd);
+    size_t written = 0, tail = 0;
+    aptx_encode(ctx, pcm, (size_t)NSAMPLES * 6, out, cap, &written);
+    aptx_encode_finish(ctx, out + written, cap - written, &tail);
+    aptx_finish(ctx);
+    return written + tail;
+}
+
+/* Whole stream through aptx_decode32(), in one call */
+static size_t decode_ref(int hd, const unsigned char *in, size_t len, unsigned char *out, size_t cap) {
+    struct aptx_context *ctx = aptx_init(hd);
+    size_t written = 0;
+    const size_t used = aptx_decode32(ctx, in, len, out, cap, &written);
+    aptx_finish(ctx);
+    return used == len ? written : 0;
+}
+
+/* Through aptx_decode32_fast(), in random chunks of input and output when
+ * chunked; each call goes on from what the last one consumed */
+static size_t decode_fast(int hd, const unsigned char *in, size_t len, unsigned char *out, size_t cap,
+                          int chunked) {
+    struct aptx_context *ctx = aptx_init(hd);
+    size_t ipos = 0, opos = 0;
+    while (ipos < len) {
+        size_t ilen = len - ipos, olen = cap - opos, written = 0;
+        if (chunked) {
+            const size_t ichunk = 1 + (size_t)rnd(200);
+            const size_t ochunk = 32 + (size_t)rnd(512);
+            if (ilen > ichunk) ilen = ichunk;
+            if (olen > ochunk) olen = ochunk;
+        }
+        const size_t used = aptx_decode32_fast(ctx, in + ipos, ilen, out + opos, olen, &written);
+        ipos += used;
+        opos += written;
+        if (used == 0 && ilen >= (size_t)(hd ? 6 : 4) && olen >= 32) {
+            aptx_finish(ctx);
+            return 0;   /* Parity error */
+        }
+        if (!chunked && used != len) break;
+    }
+    aptx_finish(ctx);
+    return ipos == len ? opos : 0;
+}
+
+static int run(int hd, const unsigned char *pcm) {
+    const size_t enc_cap = (size_t)(NSAMPLES / 4 + 64) * 6;
+    const size_t pcm_cap = (size_t)(NSAMPLES + 256) * 8;
+    unsigned char *enc = malloc(enc_cap);
+    unsigned char *ref = malloc(pcm_cap);
+    uint32_t *fast = malloc(pcm_cap);     /* Word aligned, as the fast path needs */
+    int fail = 0;
+
+    const size_t elen = encode(hd, pcm, enc, enc_cap);
+    const size_t rlen = decode_ref(hd, enc, elen, ref, pcm_cap);
+    if (rlen == 0) {
+        printf("%s: reference decode failed\n", hd ? "aptX HD" : "aptX");
+        fail = 1;
+    }
+    for (int pass = 0; pass < NPASSES && !fail; pass++) {
+        memset(fast, 0x5A, pcm_cap);
+        const size_t flen = decode_fast(hd, enc, elen, (unsigned char *)fast, pcm_cap, pass > 0);
+        if (flen != rlen || memcmp(ref, fast, rlen)) {
+            size_t i = 0;
+            while (i < rlen && i < flen && ref[i] == ((unsigned char *)fast)[i]) i++;
+            printf("%s pass %d (%s): %u bytes vs %u, first difference at byte %u\n",
+                   hd ? "aptX HD" : "aptX", pass, pass ? "chunked" : "one call",
+                   (unsigned)flen, (unsigned)rlen, (unsigned)i);
+            fail = 1;
+        }
+    }
+    if (!fail) {
+        printf("%s: %u codeword bytes, %u PCM bytes, %d passes bit-exact\n",
+               hd ? "aptX HD" : "aptX", (unsigned)elen, (unsigned)rlen, NPASSES);
+    }
+    free(enc);
+    free(ref);
+    free(fast);
+    return fail;
+}
+
+int main(void) {
+    unsigned char *pcm = malloc((size_t)NSAMPLES * 6);
+    make_pcm(pcm);
+    const int fail = run(0, pcm) || run(1, pcm);
+    free(pcm);
+    return fail;
+}
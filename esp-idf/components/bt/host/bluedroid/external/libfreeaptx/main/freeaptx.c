@@ -25,6 +25,23 @@
 
 #include <freeaptx.h>
 
+/*
+ * ESP32 fast decode path (CONFIG_APTX_DEC_FAST_KERNELS): aptx_decode32_fast().
+ * Same arithmetic as aptx_decode32(), bit-exact, with the QMF taps and the
+ * prediction filter unrolled per subband order and 32-bit stores of the
+ * output samples.
+ */
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#endif
+#ifndef APTX_FAST_KERNELS
+#if defined(CONFIG_APTX_DEC_FAST_KERNELS) && CONFIG_APTX_DEC_FAST_KERNELS
+#define APTX_FAST_KERNELS 1
+#else
+#define APTX_FAST_KERNELS 0
+#endif
+#endif
+
 #if (!defined(__STDC_VERSION__) || __STDC_VERSION__ < 199901L) && !defined(inline)
 #define inline
 #endif
@@ -1385,3 +1402,212 @@ size_t aptx_decode32(struct aptx_context *ctx, const unsigned char *input, size_
     *written = opos;
     return ipos;
 }
+
+#if APTX_FAST_KERNELS
+
+#define APTX_ALWAYS_INLINE inline __attribute__((always_inline))
+
+/*
+ * Both polyphase filters of one synthesis stage with the 16 taps unrolled,
+ * so the two 64-bit accumulators stay in registers.
+ */
+static APTX_ALWAYS_INLINE void aptx_qmf_polyphase_synthesis_fast(struct aptx_filter_signal signal[NB_FILTERS],
+                                                                 const int32_t coeffs[NB_FILTERS][FILTER_TAPS],
+                                                                 unsigned shift,
+                                                                 int32_t low_subband_input,
+                                                                 int32_t high_subband_input,
+                                                                 int32_t samples[NB_FILTERS])
+{
+    const int32_t *s0, *s1;
+    int64_t e0 = 0, e1 = 0;
+
+    aptx_qmf_filter_signal_push(&signal[0], low_subband_input - high_subband_input);
+    aptx_qmf_filter_signal_push(&signal[1], low_subband_input + high_subband_input);
+    s0 = &signal[0].buffer[signal[0].pos];
+    s1 = &signal[1].buffer[signal[1].pos];
+
+#define APTX_TAP(i) \
+    e0 += (int64_t)s0[i] * (int64_t)coeffs[0][i]; \
+    e1 += (int64_t)s1[i] * (int64_t)coeffs[1][i];
+    APTX_TAP(0)  APTX_TAP(1)  APTX_TAP(2)  APTX_TAP(3)
+    APTX_TAP(4)  APTX_TAP(5)  APTX_TAP(6)  APTX_TAP(7)
+    APTX_TAP(8)  APTX_TAP(9)  APTX_TAP(10) APTX_TAP(11)
+    APTX_TAP(12) APTX_TAP(13) APTX_TAP(14) APTX_TAP(15)
+#undef APTX_TAP
+
+    samples[0] = rshift64_clip24(e0, shift);
+    samples[1] = rshift64_clip24(e1, shift);
+}
+
+static void aptx_qmf_tree_synthesis_fast(struct aptx_channel *channel, int32_t samples[4])
+{
+    struct aptx_QMF_analysis *qmf = &channel->qmf;
+    const struct aptx_prediction *prediction = channel->prediction;
+    int32_t intermediate_samples[4];
+
+    aptx_qmf_polyphase_synthesis_fast(qmf->inner_filter_signal[0], aptx_qmf_inner_coeffs, 22,
+                                      prediction[0].previous_reconstructed_sample,
+                                      prediction[1].previous_reconstructed_sample,
+                                      &intermediate_samples[0]);
+    aptx_qmf_polyphase_synthesis_fast(qmf->inner_filter_signal[1], aptx_qmf_inner_coeffs, 22,
+                                      prediction[2].previous_reconstructed_sample,
+                                      prediction[3].previous_reconstructed_sample,
+                                      &intermediate_samples[2]);
+    aptx_qmf_polyphase_synthesis_fast(qmf->outer_filter_signal, aptx_qmf_outer_coeffs, 21,
+                                      intermediate_samples[0], intermediate_samples[2],
+                                      &samples[0]);
+    aptx_qmf_polyphase_synthesis_fast(qmf->outer_filter_signal, aptx_qmf_outer_coeffs, 21,
+                                      intermediate_samples[1], intermediate_samples[3],
+                                      &samples[2]);
+}
+
+/*
+ * aptx_prediction_filtering() with the order as a compile-time constant:
+ * the weight update loop is fully unrolled and the history position wraps
+ * without a division.
+ */
+static APTX_ALWAYS_INLINE void aptx_prediction_filtering_fast(struct aptx_prediction *prediction,
+                                                              int32_t reconstructed_difference,
+                                                              const int order)
+{
+    int32_t reconstructed_sample, predictor, srd0, srd;
+    int32_t *rd1 = prediction->reconstructed_differences, *rd2 = rd1 + order;
+    int32_t *reconstructed_differences;
+    int64_t predicted_difference = 0;
+    int i, p = prediction->pos;
+
+    reconstructed_sample = clip_intp2(reconstructed_difference + prediction->predicted_sample, 23);
+    predictor = clip_intp2((int32_t)(((int64_t)prediction->s_weight[0] * (int64_t)prediction->previous_reconstructed_sample
+                                    + (int64_t)prediction->s_weight[1] * (int64_t)reconstructed_sample) >> 22), 23);
+    prediction->previous_reconstructed_sample = reconstructed_sample;
+
+    rd1[p] = rd2[p];
+    p = (p + 1 == order) ? 0 : p + 1;
+    prediction->pos = p;
+    rd2[p] = reconstructed_difference;
+    reconstructed_differences = &rd2[p];
+
+    srd0 = (int32_t)DIFFSIGN(reconstructed_difference, 0) * ((int32_t)1 << 23);
+    for (i = 0; i < order; i++) {
+        srd = (reconstructed_differences[-i-1] >> 31) | 1;
+        prediction->d_weight[i] -= rshift32(prediction->d_weight[i] - srd*srd0, 8);
+        predicted_difference += (int64_t)reconstructed_differences[-i] * (int64_t)prediction->d_weight[i];
+    }
+
+    prediction->predicted_difference = clip_intp2((int32_t)(predicted_difference >> 22), 23);
+    prediction->predicted_sample = clip_intp2(predictor + prediction->predicted_difference, 23);
+}
+
+/* aptx_process_subband() for one fixed prediction order */
+#define APTX_PROCESS_SUBBAND_FAST(order)                                                  \
+static void aptx_process_subband_fast##order(struct aptx_invert_quantize *invert_quantize, \
+                                             struct aptx_prediction *prediction,         \
+                                             int32_t quantized_sample, int32_t dither,   \
+                                             const struct aptx_tables *tables)           \
+{                                                                                         \
+    int32_t sign, same_sign[2], weight[2], sw1, range;                                    \
+                                                                                          \
+    aptx_invert_quantization(invert_quantize, quantized_sample, dither, tables);          \
+                                                                                          \
+    sign = DIFFSIGN(invert_quantize->reconstructed_difference,                            \
+                    -prediction->predicted_difference);                                   \
+    same_sign[0] = sign * prediction->prev_sign[0];                                       \
+    same_sign[1] = sign * prediction->prev_sign[1];                                       \
+    prediction->prev_sign[0] = prediction->prev_sign[1];                                  \
+    prediction->prev_sign[1] = sign | 1;                                                  \
+                                                                                          \
+    range = 0x100000;                                                                     \
+    sw1 = rshift32(-same_sign[1] * prediction->s_weight[1], 1);                           \
+    sw1 = (clip(sw1, -range, range) & ~0xF) * 16;                                         \
+                                                                                          \
+    range = 0x300000;                                                                     \
+    weight[0] = 254 * prediction->s_weight[0] + 0x800000*same_sign[0] + sw1;              \
+    prediction->s_weight[0] = clip(rshift32(weight[0], 8), -range, range);                \
+                                                                                          \
+    range = 0x3C0000 - prediction->s_weight[0];                                           \
+    weight[1] = 255 * prediction->s_weight[1] + 0xC00000*same_sign[1];                    \
+    prediction->s_weight[1] = clip(rshift32(weight[1], 8), -range, range);                \
+                                                                                          \
+    aptx_prediction_filtering_fast(prediction,                                            \
+                                   invert_quantize->reconstructed_difference, order);     \
+}
+APTX_PROCESS_SUBBAND_FAST(24)
+APTX_PROCESS_SUBBAND_FAST(12)
+APTX_PROCESS_SUBBAND_FAST(6)
+
+/* Subband orders are 24, 12, 6, 12 for both aptX and aptX HD */
+static void aptx_invert_quantize_and_prediction_fast(struct aptx_channel *channel, int hd)
+{
+    const struct aptx_tables *tables = all_tables[hd];
+    const struct aptx_quantize *quantize = channel->quantize;
+
+    aptx_process_subband_fast24(&channel->invert_quantize[0], &channel->prediction[0],
+                                quantize[0].quantized_sample, channel->dither[0], &tables[0]);
+    aptx_process_subband_fast12(&channel->invert_quantize[1], &channel->prediction[1],
+                                quantize[1].quantized_sample, channel->dither[1], &tables[1]);
+    aptx_process_subband_fast6(&channel->invert_quantize[2], &channel->prediction[2],
+                               quantize[2].quantized_sample, channel->dither[2], &tables[2]);
+    aptx_process_subband_fast12(&channel->invert_quantize[3], &channel->prediction[3],
+                                quantize[3].quantized_sample, channel->dither[3], &tables[3]);
+}
+
+static int aptx_decode_samples_fast(struct aptx_context *ctx,
+                                    const uint8_t *input,
+                                    int32_t samples[NB_CHANNELS][4])
+{
+    struct aptx_channel *left = &ctx->channels[LEFT];
+    struct aptx_channel *right = &ctx->channels[RIGHT];
+    int ret;
+
+    aptx_generate_dither(left);
+    aptx_generate_dither(right);
+    if (ctx->hd) {
+        aptxhd_unpack_codeword(left, ((uint32_t)input[0] << 16) | ((uint32_t)input[1] << 8) | input[2]);
+        aptxhd_unpack_codeword(right, ((uint32_t)input[3] << 16) | ((uint32_t)input[4] << 8) | input[5]);
+    } else {
+        aptx_unpack_codeword(left, (uint16_t)((input[0] << 8) | input[1]));
+        aptx_unpack_codeword(right, (uint16_t)((input[2] << 8) | input[3]));
+    }
+    aptx_invert_quantize_and_prediction_fast(left, ctx->hd);
+    aptx_invert_quantize_and_prediction_fast(right, ctx->hd);
+
+    ret = aptx_check_parity(ctx->channels, &ctx->sync_idx);
+
+    aptx_qmf_tree_synthesis_fast(left, samples[LEFT]);
+    aptx_qmf_tree_synthesis_fast(right, samples[RIGHT]);
+    return ret;
+}
+
+/*
+ * Output as aptx_decode32() (24 bit samples left-justified in little-endian
+ * 32 bit words, LRLR...), stored a word at a time: output must be 4-byte
+ * aligned and the target little-endian.
+ */
+size_t aptx_decode32_fast(struct aptx_context *ctx, const unsigned char *input, size_t input_size, unsigned char *output, size_t output_size, size_t *written)
+{
+    const size_t sample_size = ctx->hd ? 6 : 4;
+    int32_t samples[NB_CHANNELS][4];
+    int32_t *out = (int32_t *)output;
+    unsigned sample;
+    size_t ipos, opos;
+
+    for (ipos = 0, opos = 0; ipos + sample_size <= input_size && (opos + 4*NB_CHANNELS*4 <= output_size || ctx->decode_skip_leading > 0); ipos += sample_size) {
+        if (aptx_decode_samples_fast(ctx, input + ipos, samples))
+            break;
+        sample = 0;
+        if (ctx->decode_skip_leading > 0) {
+            ctx->decode_skip_leading--;
+            if (ctx->decode_skip_leading > 0)
+                continue;
+            sample = LATENCY_SAMPLES%4;
+        }
+        for (; sample < 4; sample++, opos += 4*NB_CHANNELS) {
+            *out++ = (int32_t)((uint32_t)samples[LEFT][sample] << 8);
+            *out++ = (int32_t)((uint32_t)samples[RIGHT][sample] << 8);
+        }
+    }
+    *written = opos;
+    return ipos;
+}
+
+#endif /* APTX_FAST_KERNELS */
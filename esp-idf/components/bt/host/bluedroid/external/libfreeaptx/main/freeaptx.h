@@ -155,5 +155,16 @@ size_t aptx_decode32(struct aptx_context *ctx,
                      size_t output_size,
                      size_t *written);
 
+/*
+ * Bit-exact variant of aptx_decode32() built with APTX_FAST_KERNELS
+ * (CONFIG_APTX_DEC_FAST_KERNELS). Output buffer must be 4-byte aligned.
+ */
+size_t aptx_decode32_fast(struct aptx_context *ctx,
+                          const unsigned char *input,
+                          size_t input_size,
+                          unsigned char *output,
+                          size_t output_size,
+                          size_t *written);
+
 
 #endif
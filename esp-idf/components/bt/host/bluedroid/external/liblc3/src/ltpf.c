@@ -21,6 +21,7 @@
 
 #include "ltpf_neon.h"
 #include "ltpf_arm.h"
+#include "ltpf_xtensa.h"
 
 
 /* ----------------------------------------------------------------------------
@@ -758,6 +759,7 @@ bool lc3_ltpf_analyse(
  * c, w            Coefficients `den` then `num`, and width of filter
  * fade            Fading mode of filter  -1: Out  1: In  0: None
  */
+#ifndef synthesize_template
 LC3_HOT static inline void synthesize_template(
     const float *xh, int nh, int lag,
     const float *x0, float *x, int n,
@@ -808,6 +810,7 @@ LC3_HOT static inline void synthesize_template(
             u[j] = 0;
         }
 }
+#endif /* synthesize_template */
 
 /**
  * Synthesis filter for each samplerates (width of filter)
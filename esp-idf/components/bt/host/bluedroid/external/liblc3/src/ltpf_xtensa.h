@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+/* Kernels for the Xtensa LX FPU (ESP32), see `mdct_xtensa.h` */
+
+#if defined(LC3_XTENSA) || defined(TEST_XTENSA)
+
+/**
+ * Synthesis filter, direct form
+ * Same parameters and accumulation order as the generic template, but each
+ * output sample is computed in one pass over the `w` taps from windows of
+ * inputs and history, instead of spreading every input over a ring of `w`
+ * partial sums indexed modulo `w`.
+ */
+#ifndef synthesize_template
+
+#define XTENSA_LTPF_MAX_WIDTH (LC3_MAX_SRATE_HZ / 4000)
+#define XTENSA_LTPF_BLOCK 32
+
+LC3_HOT static inline void xtensa_synthesize_template(
+    const float *xh, int nh, int lag,
+    const float *x0, float *x, int n,
+    const float *c, const int w, int fade)
+{
+    float g = (float)(fade <= 0);
+    float g_incr = (float)((fade > 0) - (fade < 0)) / n;
+
+    /* Unfiltered inputs: `w-1` previous ones followed by a block */
+    float xb[XTENSA_LTPF_MAX_WIDTH + XTENSA_LTPF_BLOCK];
+    float yb[XTENSA_LTPF_MAX_WIDTH];
+
+    lag += (w >> 1);
+
+    const float *y = x - xh < lag ? x + (nh - lag) : x - lag;
+    const float *y_end = xh + nh - 1;
+
+    for (int j = 0; j < w-1; j++)
+        xb[j] = x0[j];
+
+    for (int i = 0; i < n; ) {
+        int nb = LC3_MIN(n - i, XTENSA_LTPF_BLOCK);
+
+        for (int j = 0; j < nb; j++)
+            xb[(w-1) + j] = x[j];
+
+        for (int j = 0; j < nb; j++, g += g_incr) {
+            const float *xw = xb + j, *yw = y;
+            float u = 0;
+
+            if (y_end - y < w-1) {
+                const float *yk = y;
+                for (int k = 0; k < w; k++) {
+                    yb[k] = *yk;
+                    yk = yk < y_end ? yk + 1 : xh;
+                }
+                yw = yb;
+            }
+
+            for (int k = 0; k < w; k++) {
+                u -= yw[k] * c[k];
+                u += xw[k] * c[w+k];
+            }
+
+            *(x++) = xw[w-1] - g * u;
+            y = y < y_end ? y + 1 : xh;
+        }
+
+        for (int j = 0; j < w-1; j++)
+            xb[j] = xb[nb + j];
+
+        i += nb;
+    }
+}
+
+#ifndef TEST_XTENSA
+#define synthesize_template xtensa_synthesize_template
+#endif
+
+#endif /* synthesize_template */
+
+#endif /* LC3_XTENSA */
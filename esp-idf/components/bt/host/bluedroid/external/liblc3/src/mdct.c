@@ -20,6 +20,7 @@
 #include "tables.h"
 
 #include "mdct_neon.h"
+#include "mdct_xtensa.h"
 
 
 /* ----------------------------------------------------------------------------
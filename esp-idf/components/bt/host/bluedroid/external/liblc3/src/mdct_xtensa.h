@@ -0,0 +1,148 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+/* Kernels for the Xtensa LX FPU (ESP32): scalar single precision with
+ * fused multiply-add, no vector unit. They compute exactly what the generic
+ * kernels compute, but keep operands in the 16 FP registers across
+ * iterations instead of reloading them. */
+
+#if defined(LC3_XTENSA) || defined(TEST_XTENSA)
+
+/**
+ * FFT Butterfly 3 Points
+ * The twiddles of index `j` are loaded once for the `n` interleaved
+ * transforms, instead of once per transform.
+ */
+#ifndef fft_bf3
+
+LC3_HOT static inline void xtensa_fft_bf3(
+    const struct lc3_fft_bf3_twiddles *twiddles,
+    const struct lc3_complex *x, struct lc3_complex *y, int n)
+{
+    int n3 = twiddles->n3;
+    const struct lc3_complex (*w0)[2] = twiddles->t;
+    const struct lc3_complex (*w1)[2] = w0 + n3, (*w2)[2] = w1 + n3;
+
+    for (int j = 0; j < n3; j++) {
+
+        const struct lc3_complex w00 = w0[j][0], w01 = w0[j][1];
+        const struct lc3_complex w10 = w1[j][0], w11 = w1[j][1];
+        const struct lc3_complex w20 = w2[j][0], w21 = w2[j][1];
+
+        const struct lc3_complex *x0 = x + j, *x1 = x0 + n*n3, *x2 = x1 + n*n3;
+        struct lc3_complex *y0 = y + j, *y1 = y0 + n3, *y2 = y1 + n3;
+
+        for (int i = 0; i < n; i++,
+                x0 += n3, x1 += n3, x2 += n3,
+                y0 += 3*n3, y1 += 3*n3, y2 += 3*n3) {
+
+            const float x0re = x0->re, x0im = x0->im;
+            const float x1re = x1->re, x1im = x1->im;
+            const float x2re = x2->re, x2im = x2->im;
+
+            y0->re = x0re + x1re * w00.re - x1im * w00.im
+                          + x2re * w01.re - x2im * w01.im;
+
+            y0->im = x0im + x1im * w00.re + x1re * w00.im
+                          + x2im * w01.re + x2re * w01.im;
+
+            y1->re = x0re + x1re * w10.re - x1im * w10.im
+                          + x2re * w11.re - x2im * w11.im;
+
+            y1->im = x0im + x1im * w10.re + x1re * w10.im
+                          + x2im * w11.re + x2re * w11.im;
+
+            y2->re = x0re + x1re * w20.re - x1im * w20.im
+                          + x2re * w21.re - x2im * w21.im;
+
+            y2->im = x0im + x1im * w20.re + x1re * w20.im
+                          + x2im * w21.re + x2re * w21.im;
+        }
+    }
+}
+
+#ifndef TEST_XTENSA
+#define fft_bf3 xtensa_fft_bf3
+#endif
+
+#endif /* fft_bf3 */
+
+/**
+ * FFT Butterfly 2 Points
+ * Same twiddle reuse as `xtensa_fft_bf3()`, two butterflies per iteration
+ * of the inner loop
+ */
+#ifndef fft_bf2
+
+LC3_HOT static inline void xtensa_fft_bf2(
+    const struct lc3_fft_bf2_twiddles *twiddles,
+    const struct lc3_complex *x, struct lc3_complex *y, int n)
+{
+    int n2 = twiddles->n2;
+    const struct lc3_complex *w = twiddles->t;
+
+    for (int j = 0; j < n2; j++) {
+
+        const float wre = w[j].re, wim = w[j].im;
+
+        const struct lc3_complex *x0 = x + j, *x1 = x0 + n*n2;
+        struct lc3_complex *y0 = y + j, *y1 = y0 + n2;
+        int i = 0;
+
+        for ( ; i + 2 <= n; i += 2,
+                x0 += 2*n2, x1 += 2*n2, y0 += 4*n2, y1 += 4*n2) {
+
+            const float a0re = x0[0].re, a0im = x0[0].im;
+            const float a1re = x1[0].re, a1im = x1[0].im;
+            const float b0re = x0[n2].re, b0im = x0[n2].im;
+            const float b1re = x1[n2].re, b1im = x1[n2].im;
+
+            y0[0].re = a0re + a1re * wre - a1im * wim;
+            y0[0].im = a0im + a1im * wre + a1re * wim;
+
+            y1[0].re = a0re - a1re * wre + a1im * wim;
+            y1[0].im = a0im - a1im * wre - a1re * wim;
+
+            y0[2*n2].re = b0re + b1re * wre - b1im * wim;
+            y0[2*n2].im = b0im + b1im * wre + b1re * wim;
+
+            y1[2*n2].re = b0re - b1re * wre + b1im * wim;
+            y1[2*n2].im = b0im - b1im * wre - b1re * wim;
+        }
+
+        if (i < n) {
+            const float a0re = x0->re, a0im = x0->im;
+            const float a1re = x1->re, a1im = x1->im;
+
+            y0->re = a0re + a1re * wre - a1im * wim;
+            y0->im = a0im + a1im * wre + a1re * wim;
+
+            y1->re = a0re - a1re * wre + a1im * wim;
+            y1->im = a0im - a1im * wre - a1re * wim;
+        }
+    }
+}
+
+#ifndef TEST_XTENSA
+#define fft_bf2 xtensa_fft_bf2
+#endif
+
+#endif /* fft_bf2 */
+
+#endif /* LC3_XTENSA */
@@ -116,6 +116,9 @@ static const float dct16_m[16][16] = {
 
 };
 
+/* Architecture kernels, using the matrix above */
+#include "sns_xtensa.h"
+
 /**
  * Forward DCT-16 transformation
  * x, y            Input and output 16 values
@@ -131,12 +134,14 @@ LC3_HOT static void dct16_forward(const float *x, float *y)
  * Inverse DCT-16 transformation
  * x, y            Input and output 16 values
  */
+#ifndef dct16_inverse
 LC3_HOT static void dct16_inverse(const float *x, float *y)
 {
     for (int i = 0, j; i < 16; i++)
         for (y[i] = 0, j = 0; j < 16; j++)
             y[i] += x[j] * dct16_m[i][j];
 }
+#endif /* dct16_inverse */
 
 
 /* ----------------------------------------------------------------------------
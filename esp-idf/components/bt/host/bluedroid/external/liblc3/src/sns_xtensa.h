@@ -0,0 +1,54 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+/* Kernels for the Xtensa LX FPU (ESP32), see `mdct_xtensa.h` */
+
+#if defined(LC3_XTENSA) || defined(TEST_XTENSA)
+
+/**
+ * Inverse DCT-16 transformation
+ * Rows `n` and `15-n` of the matrix differ only by the sign of the odd
+ * columns, so both outputs come from the same even and odd partial sums:
+ * half the multiplications of the generic matrix product.
+ */
+#ifndef dct16_inverse
+
+LC3_HOT static void xtensa_dct16_inverse(const float *x, float *y)
+{
+    for (int i = 0; i < 8; i++) {
+        const float *m = dct16_m[i];
+        float e = 0, o = 0;
+
+        for (int j = 0; j < 16; j += 2) {
+            e += x[j  ] * m[j  ];
+            o += x[j+1] * m[j+1];
+        }
+
+        y[   i] = e + o;
+        y[15-i] = e - o;
+    }
+}
+
+#ifndef TEST_XTENSA
+#define dct16_inverse xtensa_dct16_inverse
+#endif
+
+#endif /* dct16_inverse */
+
+#endif /* LC3_XTENSA */
@@ -37,9 +37,15 @@ depends = [ 'ctypes.h' ] + \
 
 includes = [ SRC_DIR, INC_DIR, numpy.get_include() ]
 
+define_macros = [ ('NPY_NO_DEPRECATED_API', 'NPY_1_7_API_VERSION') ]
+
+# Run the conformance tests over the Xtensa kernels (src/*_xtensa.h)
+if os.environ.get('LC3_XTENSA'):
+  define_macros.append(('LC3_XTENSA', None))
+
 extension = Extension('lc3',
   extra_compile_args = [ '-std=c11', '-ffast-math' ],
-  define_macros = [ ('NPY_NO_DEPRECATED_API', 'NPY_1_7_API_VERSION') ],
+  define_macros = define_macros,
   sources = sources,
   depends = depends,
   include_dirs = includes)
@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* -------------------------------------------------------------------------- */
+
+#define TEST_XTENSA
+#include <ltpf.c>
+
+void lc3_put_bits_generic(lc3_bits_t *a, unsigned b, int c)
+{ (void)a, (void)b, (void)c; }
+
+unsigned lc3_get_bits_generic(struct lc3_bits *a, int b)
+{ return (void)a, (void)b, 0; }
+
+/* -------------------------------------------------------------------------- */
+
+static int check_synthesize(void)
+{
+    enum { NH = 1440, NS = 480 };
+    static float xh[NH], xh_xtensa[NH];
+    float x0[MAX_FILTER_WIDTH], c[2*MAX_FILTER_WIDTH];
+    static const int widths[] = { 4, 6, 8, 12 };
+
+    for (int t = 0; t < 64; t++) {
+        int w = widths[t & 3];
+        int fade = (t >> 2) % 3 - 1;
+        int lag = 32 + rand() % 200;
+        int n = (t & 4) ? NS : NS / 2;
+
+        /* Current frame at various positions of the ring buffer,
+         * so that the history wraps around */
+
+        int pos = (t * 97) % (NH - NS);
+
+        for (int i = 0; i < NH; i++)
+            xh[i] = xh_xtensa[i] = (2.f * rand() / RAND_MAX) - 1;
+        for (int i = 0; i < w-1; i++)
+            x0[i] = (2.f * rand() / RAND_MAX) - 1;
+        for (int i = 0; i < 2*w; i++)
+            c[i] = (0.5f * rand() / RAND_MAX) - 0.25f;
+
+        synthesize_template(xh, NH, lag,
+            x0, xh + pos, n, c, w, fade);
+        xtensa_synthesize_template(xh_xtensa, NH, lag,
+            x0, xh_xtensa + pos, n, c, w, fade);
+
+        if (memcmp(xh, xh_xtensa, sizeof(xh)) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+int check_ltpf(void)
+{
+    int ret;
+
+    if ((ret = check_synthesize()) < 0)
+        return ret;
+
+    return 0;
+}
@@ -0,0 +1,33 @@
+#
+# Copyright 2022 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at:
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+test_xtensa_src += \
+    $(TEST_DIR)/xtensa/test_xtensa.c \
+    $(TEST_DIR)/xtensa/ltpf_xtensa.c \
+    $(TEST_DIR)/xtensa/mdct_xtensa.c \
+    $(TEST_DIR)/xtensa/sns_xtensa.c \
+    $(SRC_DIR)/tables.c
+
+test_xtensa_include += $(SRC_DIR)
+test_xtensa_ldlibs += m
+
+$(eval $(call add-bin,test_xtensa))
+
+test_xtensa: $(test_xtensa_bin)
+	@echo "  RUN     $(notdir $<)"
+	$(V)$<
+
+test: test_xtensa
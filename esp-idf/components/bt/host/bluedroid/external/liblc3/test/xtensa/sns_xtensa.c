@@ -0,0 +1,60 @@
+/******************************************************************************
+ *
+ *  Copyright 2022 Google LLC
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* -------------------------------------------------------------------------- */
+
+#define TEST_XTENSA
+#include <sns.c>
+
+void lc3_put_bits_generic(lc3_bits_t *a, unsigned b, int c);
+unsigned lc3_get_bits_generic(struct lc3_bits *a, int b);
+
+/* -------------------------------------------------------------------------- */
+
+static int check_dct16(void)
+{
+    float x[16], y[16], y_xtensa[16];
+
+    for (int t = 0; t < 100; t++) {
+        for (int i = 0; i < 16; i++)
+            x[i] = (20.f * rand() / RAND_MAX) - 10;
+
+        dct16_inverse(x, y);
+        xtensa_dct16_inverse(x, y_xtensa);
+        for (int i = 0; i < 16; i++)
+            if (fabsf(y[i] - y_xtensa[i]) > 1e-5f)
+                return -1;
+    }
+
+    return 0;
+}
+
+int check_sns(void)
+{
+    int ret;
+
+    if ((ret = check_dct16()) < 0)
+        return ret;
+
+    return 0;
+}
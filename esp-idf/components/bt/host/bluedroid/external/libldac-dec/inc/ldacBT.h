@@ -286,6 +286,24 @@ LDACBT_API int  ldacBT_get_sampling_freq( HANDLE_LDAC_BT hLdacBt );
  */
 LDACBT_API int  ldacBT_get_bitrate( HANDLE_LDAC_BT hLdacBt );
 
+/* Reduction of the decoded bandwidth, for a decoder short of CPU time.
+ * From the next frame on, only the quantization units starting below "hz"
+ * are dequantized; the spectrum above them decodes as silence. The frame
+ * is still unpacked in full, so the limit can change on any frame and the
+ * stream stays in sync. 0 (the default) decodes every unit.
+ * The LDAC handle must be initialized by API function ldacBT_init_handle_decode() prior to
+ * calling this function; a new initialization clears the limit.
+ *
+ *  Format
+ *      int  ldacBT_set_decode_bandwidth( HANDLE_LDAC_BT hLdacBt, int hz );
+ *  Arguments
+ *      hLdacBt    HANDLE_LDAC_BT    LDAC handle.
+ *      hz         int               Upper edge of the decoded audio. Unit: Hz. 0 for no limit.
+ *  Return value
+ *      int : 0 for success, -1 for failure.
+ */
+LDACBT_API int  ldacBT_set_decode_bandwidth( HANDLE_LDAC_BT hLdacBt, int hz );
+
 #ifndef _DECODE_ONLY
 /* Initialization of a LDAC handle for encode processing.
  * The LDAC handle must be allocated by API function ldacBT_get_handle() prior to calling this API.
@@ -0,0 +1,100 @@
+/* Bit-exactness test of the fast kernels (LDAC_FAST_KERNELS) against the
+ * reference dequant / IMDCT / PCM output path, on random spectra for both
+ * frame sizes, all output formats and several frames of overlap state.
+ * Returns non-zero on the first mismatch. */
+#define LDAC_FAST_KERNELS 1
+#include "src/ldaclib.c"
+
+#include <stdio.h>
+
+#define NFRAMES 64
+
+static unsigned int s_seed = 12345;
+static int rnd(int n) {
+  s_seed = s_seed * 1103515245u + 12345u;
+  return (int)((s_seed >> 8) % (unsigned int)n);
+}
+
+static int setup(SFINFO* p_sfinfo) {
+  memset(p_sfinfo, 0, sizeof(*p_sfinfo));
+  p_sfinfo->cfg.ch = 2;
+  p_sfinfo->cfg.chconfig_id = LDAC_CHCONFIGID_ST;
+  return init_decode_ldac(p_sfinfo) == LDAC_S_OK;
+}
+
+/* Same random frame into both decoders */
+static void fill(SFINFO* p_ref, SFINFO* p_fast, int maxnqus) {
+  const int nqus = 1 + rnd(maxnqus);
+  p_ref->p_ab->nqus = p_fast->p_ab->nqus = (int8_t)nqus;
+  for (int ich = 0; ich < 2; ich++) {
+    AC* a = p_ref->ap_ac[ich];
+    AC* b = p_fast->ap_ac[ich];
+    for (int iqu = 0; iqu < LDAC_MAXNQUS; iqu++) {
+      a->a_idsf[iqu] = b->a_idsf[iqu] = (int8_t)rnd(LDAC_NIDSF);
+      a->a_idwl1[iqu] = b->a_idwl1[iqu] = (int8_t)(1 + rnd(LDAC_MAXIDWL1));
+      a->a_idwl2[iqu] = b->a_idwl2[iqu] = (int8_t)(rnd(4) ? 0 : rnd(LDAC_MAXIDWL2 + 1));
+    }
+    for (int isp = 0; isp < LDAC_MAXLSU; isp++) {
+      a->a_qspec[isp] = b->a_qspec[isp] = (int16_t)(rnd(2001) - 1000);
+      a->a_rspec[isp] = b->a_rspec[isp] = (int16_t)(rnd(201) - 100);
+    }
+  }
+}
+
+static int run(int nlnn, LDAC_SMPL_FMT_T fmt, int bps) {
+  static SFINFO ref, fast;
+  static unsigned char a_ref[LDAC_PRCNCH][LDAC_MAXLSU * 4];
+  static unsigned char a_out[LDAC_PRCNCH * LDAC_MAXLSU * 4];
+  static unsigned char a_ilv[LDAC_PRCNCH * LDAC_MAXLSU * 4];
+  void* ap_pcm[LDAC_PRCNCH] = {a_ref[0], a_ref[1]};
+  const int nsmpl = npow2_ldac(nlnn);
+  const int maxnqus = (nlnn == LDAC_2FSLNN) ? LDAC_2FSNQUS : LDAC_1FSNQUS;
+
+  if (!setup(&ref) || !setup(&fast)) return 1;
+  set_imdct_table_ldac(nlnn);
+  for (int frm = 0; frm < NFRAMES; frm++) {
+    fill(&ref, &fast, maxnqus);
+
+    decode_ldac(&ref);
+    proc_imdct_ldac(&ref, nlnn);
+    set_output_pcm_ldac(&ref, ap_pcm, fmt, nlnn);
+    for (int isp = 0; isp < nsmpl; isp++) {
+      for (int ich = 0; ich < 2; ich++) {
+        memcpy(&a_ilv[(isp * 2 + ich) * bps], &a_ref[ich][isp * bps], bps);
+      }
+    }
+
+    decode_fast_ldac(&fast);
+    proc_imdct_fast_ldac(&fast, nlnn);
+    const int nbytes = set_output_pcm_interleaved_ldac(&fast, a_out, fmt, nlnn);
+
+    for (int ich = 0; ich < 2; ich++) {
+      if (memcmp(ref.ap_ac[ich]->p_acsub, fast.ap_ac[ich]->p_acsub, sizeof(ACSUB))) {
+        printf("nlnn %d fmt %d frame %d ch %d: spectrum/time mismatch\n", nlnn, fmt, frm, ich);
+        return 1;
+      }
+    }
+    if (nbytes != nsmpl * 2 * bps || memcmp(a_ilv, a_out, nbytes)) {
+      printf("nlnn %d fmt %d frame %d: PCM mismatch\n", nlnn, fmt, frm);
+      return 1;
+    }
+  }
+  free_decode_ldac(&ref);
+  free_decode_ldac(&fast);
+  return 0;
+}
+
+int main(void) {
+  static const struct {
+    LDAC_SMPL_FMT_T fmt;
+    int bps;
+  } fmts[] = {
+      {LDAC_SMPL_FMT_S16, 2}, {LDAC_SMPL_FMT_S24, 3}, {LDAC_SMPL_FMT_S32, 4}, {LDAC_SMPL_FMT_F32, 4}};
+  for (int nlnn = LDAC_1FSLNN; nlnn <= LDAC_2FSLNN; nlnn++) {
+    for (unsigned int i = 0; i < sizeof(fmts) / sizeof(fmts[0]); i++) {
+      if (run(nlnn, fmts[i].fmt, fmts[i].bps)) return 1;
+    }
+  }
+  printf("fast kernels bit-exact (%d frames per case)\n", NFRAMES);
+  return 0;
+}
@@ -84,17 +84,19 @@ LDAC_HOT DECLFUNC void decode_ldac(SFINFO* __restrict__ p_sfinfo) {
   int nbks;
   int ibk;
   int nchs;
+  int nqus;
   int ich;
 
   p_ab = p_sfinfo->p_ab;
   nbks = gaa_block_setting_ldac[p_sfinfo->cfg.chconfig_id][1];
   for (ibk = 0; ibk < nbks; ++ibk) {
     nchs = p_ab->blk_nchs;
+    nqus = decode_nqus_ldac(p_sfinfo, p_ab);
     for (ich = 0; ich < nchs; ++ich) {
       AC* __restrict__ p_ac = p_ab->ap_ac[ich];
       clear_spectrum_ldac(p_ac, LDAC_MAXLSU);
-      dequant_spectrum_ldac(p_ac);
-      dequant_residual_ldac(p_ac);
+      dequant_spectrum_ldac(p_ac, nqus);
+      dequant_residual_ldac(p_ac, nqus);
     }
     ++p_ab;
   }
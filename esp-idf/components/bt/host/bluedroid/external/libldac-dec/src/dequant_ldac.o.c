@@ -27,9 +27,8 @@ static inline void dequant_spectrum_core_ldac(AC* __restrict__ p_ac, int iqu) {
   }
 }
 
-DECLFUNC void dequant_spectrum_ldac(AC* p_ac) {
+DECLFUNC void dequant_spectrum_ldac(AC* p_ac, int nqus) {
   int iqu;
-  const int nqus = p_ac->p_ab->nqus;
   for (iqu = 0; iqu < nqus; iqu++) {
     dequant_spectrum_core_ldac(p_ac, iqu);
   }
@@ -61,10 +60,8 @@ static inline void dequant_residual_core_ldac(AC* __restrict__ p_ac, int iqu) {
   }
 }
 
-DECLFUNC void dequant_residual_ldac(AC* p_ac) {
-  int nqus;
+DECLFUNC void dequant_residual_ldac(AC* p_ac, int nqus) {
   int iqu;
-  nqus = p_ac->p_ab->nqus;
   for (iqu = 0; iqu < nqus; iqu++) {
     if (__builtin_expect(p_ac->a_idwl2[iqu] > 0, 0)) {
       dequant_residual_core_ldac(p_ac, iqu);
@@ -72,6 +69,13 @@ DECLFUNC void dequant_residual_ldac(AC* p_ac) {
   }
 }
 
+/* QUs of the block to dequantize: all it carries, or fewer under
+ * nqus_limit, the spectrum above staying zero */
+DECLFUNC int decode_nqus_ldac(const SFINFO* p_sfinfo, const AB* p_ab) {
+  const int limit = p_sfinfo->nqus_limit;
+  return (limit > 0 && limit < p_ab->nqus) ? limit : p_ab->nqus;
+}
+
 DECLFUNC void clear_spectrum_ldac(AC* p_ac, int nsps) {
   clear_data_ldac(p_ac->p_acsub->a_spec, sizeof(SCALAR) * nsps);
 }
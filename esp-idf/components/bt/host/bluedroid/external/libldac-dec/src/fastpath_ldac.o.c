@@ -0,0 +1,238 @@
+#include "ldac.h"
+
+/* ESP32 fast path (LDAC_FAST_KERNELS). Every kernel performs exactly the
+ * arithmetic of its reference counterpart in the same order, only with
+ * fewer passes over memory, so the output is bit-exact:
+ * - decode_fast_ldac: clear, dequant and residual in one pass per QU
+ * - proc_imdct_fast_ldac: the radix-2 FFT stages of proc_imdct_core_ldac
+ *   fused in pairs (radix-4 passes), keeping the four points in registers
+ * - set_output_pcm_interleaved_ldac: set_output_pcm_ldac writing straight
+ *   into the interleaved output (no ldacBT_interleave_pcm pass) */
+#if LDAC_FAST_KERNELS
+
+/* Spectrum and residual of one channel, zero above the last QU */
+LDAC_IRAM static void dequant_fused_ldac(AC* __restrict__ p_ac, int nqus) {
+  SCALAR* __restrict__ p_nspec = p_ac->p_acsub->a_spec;
+  const int16_t* __restrict__ p_qspec = p_ac->a_qspec;
+  const int16_t* __restrict__ p_rspec = p_ac->a_rspec;
+  /* Residual scale as in dequant_residual_core_ldac */
+  const SCALAR rtmp = ga_rsf_ldac[LDAC_MAXIDWL1] * ga_iqf_ldac[p_ac->a_idwl2[0]] *
+                      ga_sf_ldac[p_ac->a_idsf[0]];
+  int isp = 0;
+
+  for (int iqu = 0; iqu < nqus; iqu++) {
+    const int start = ga_isp_ldac[iqu];
+    const int end = start + ga_nsps_ldac[iqu];
+    const SCALAR scale = ga_iqf_ldac[p_ac->a_idwl1[iqu]] * ga_sf_ldac[p_ac->a_idsf[iqu]];
+    for (; isp < start; isp++) p_nspec[isp] = _scalar(0.0);
+    if (LDAC_UNLIKELY(p_ac->a_idwl2[iqu] > 0)) {
+      for (; isp < end; isp++) {
+        SCALAR v = (SCALAR)p_qspec[isp] * scale;
+        v += rtmp * (SCALAR)p_rspec[isp];
+        p_nspec[isp] = v;
+      }
+    } else {
+      for (; isp < end; isp++) p_nspec[isp] = (SCALAR)p_qspec[isp] * scale;
+    }
+  }
+  for (; isp < LDAC_MAXLSU; isp++) p_nspec[isp] = _scalar(0.0);
+}
+
+LDAC_IRAM DECLFUNC void decode_fast_ldac(SFINFO* __restrict__ p_sfinfo) {
+  AB* __restrict__ p_ab = p_sfinfo->p_ab;
+  const int nbks = gaa_block_setting_ldac[p_sfinfo->cfg.chconfig_id][1];
+  for (int ibk = 0; ibk < nbks; ++ibk) {
+    const int nqus = decode_nqus_ldac(p_sfinfo, p_ab);
+    for (int ich = 0; ich < p_ab->blk_nchs; ++ich) {
+      dequant_fused_ldac(p_ab->ap_ac[ich], nqus);
+    }
+    ++p_ab;
+  }
+}
+
+/* One butterfly of proc_imdct_core_ldac on (a, b) with twiddle (cc, cs) */
+#define LDAC_BFLY(ar, ai, br, bi, cc, cs)                 \
+  do {                                                    \
+    const SCALAR _c = (br) * (cc) + (bi) * (cs);          \
+    const SCALAR _d = (br) * (cs) - (bi) * (cc);          \
+    const SCALAR _ar = (ar), _ai = (ai);                  \
+    (ar) = _ar + _c;                                      \
+    (ai) = _ai + _d;                                      \
+    (br) = _ar - _c;                                      \
+    (bi) = _ai - _d;                                      \
+  } while (0)
+
+LDAC_IRAM static void proc_imdct_core_fast_ldac(SCALAR* __restrict__ p_y,
+                                                SCALAR* __restrict__ p_x, int nlnn) {
+  const int nsmpl = npow2_ldac(nlnn);
+  const int nsmpl_half = nsmpl >> 1;
+  const int tbl = nlnn - LDAC_1FSLNN;
+  const SCALAR* __restrict__ p_w = gaa_bwin_ldac[tbl];
+  const SCALAR* __restrict__ p_c = gaa_wcos_ldac[tbl];
+  const SCALAR* __restrict__ p_s = gaa_wsin_ldac[tbl];
+  const int* __restrict__ p_rp = gaa_rev_perm_ldac[tbl];
+  SCALAR a_work[LDAC_MAXLSU];
+  int i;
+
+  /* Stage 0: permutation and the first butterflies (one twiddle) */
+  {
+    const SCALAR cc = p_c[0], cs = p_s[0];
+    for (i = 0; i < nsmpl; i += 4) {
+      const SCALAR f1 = p_y[p_rp[i + 0]];
+      const SCALAR f2 = p_y[p_rp[i + 1]];
+      const SCALAR f3 = p_y[p_rp[i + 2]];
+      const SCALAR f4 = p_y[p_rp[i + 3]];
+      const SCALAR a = f1 * cc + f2 * cs;
+      const SCALAR b = f1 * cs - f2 * cc;
+      a_work[i + 0] = a + f3;
+      a_work[i + 1] = b + f4;
+      a_work[i + 2] = f3 - a;
+      a_work[i + 3] = f4 - b;
+    }
+  }
+
+  /* Stages 1 .. nlnn-2. Stage s pairs points 2^s complex apart with
+   * twiddle 2^s - 1 + k; two stages at a time touch each group of four
+   * points once. */
+  int stage = 1;
+  for (; stage + 1 <= nlnn - 2; stage += 2) {
+    const int h = 1 << (stage + 1);      /* Stage s partner, in floats */
+    const int ngrp = 1 << stage;
+    const SCALAR* p_c0 = p_c + ngrp - 1;  /* Stage s twiddles */
+    const SCALAR* p_s0 = p_s + ngrp - 1;
+    const SCALAR* p_c1 = p_c + 2 * ngrp - 1;  /* Stage s+1 */
+    const SCALAR* p_s1 = p_s + 2 * ngrp - 1;
+    for (int k = 0; k < ngrp; k++) {
+      const SCALAR cc0 = p_c0[k], cs0 = p_s0[k];
+      const SCALAR cc1 = p_c1[k], cs1 = p_s1[k];
+      const SCALAR cc2 = p_c1[k + ngrp], cs2 = p_s1[k + ngrp];
+      for (int b = 2 * k; b < nsmpl; b += 4 * h) {
+        SCALAR* p0 = a_work + b;
+        SCALAR x0r = p0[0], x0i = p0[1];
+        SCALAR x1r = p0[h], x1i = p0[h + 1];
+        SCALAR x2r = p0[2 * h], x2i = p0[2 * h + 1];
+        SCALAR x3r = p0[3 * h], x3i = p0[3 * h + 1];
+        LDAC_BFLY(x0r, x0i, x1r, x1i, cc0, cs0);
+        LDAC_BFLY(x2r, x2i, x3r, x3i, cc0, cs0);
+        LDAC_BFLY(x0r, x0i, x2r, x2i, cc1, cs1);
+        LDAC_BFLY(x1r, x1i, x3r, x3i, cc2, cs2);
+        p0[0] = x0r;
+        p0[1] = x0i;
+        p0[h] = x1r;
+        p0[h + 1] = x1i;
+        p0[2 * h] = x2r;
+        p0[2 * h + 1] = x2i;
+        p0[3 * h] = x3r;
+        p0[3 * h + 1] = x3i;
+      }
+    }
+  }
+  if (stage <= nlnn - 2) {
+    /* Odd stage count: one radix-2 pass left */
+    const int h = 1 << (stage + 1);
+    const int ngrp = 1 << stage;
+    for (int k = 0; k < ngrp; k++) {
+      const SCALAR cc = p_c[ngrp - 1 + k], cs = p_s[ngrp - 1 + k];
+      for (int b = 2 * k; b < nsmpl; b += 2 * h) {
+        LDAC_BFLY(a_work[b], a_work[b + 1], a_work[b + h], a_work[b + h + 1], cc, cs);
+      }
+    }
+  }
+
+  /* Post twiddle (coef continues after the last stage) */
+  {
+    const SCALAR* p_cp = p_c + nsmpl_half - 1;
+    const SCALAR* p_sp = p_s + nsmpl_half - 1;
+    for (i = 0; i < nsmpl_half; i++) {
+      p_y[2 * i] = p_sp[i] * a_work[2 * i + 1] + p_cp[i] * a_work[2 * i];
+      p_y[nsmpl - 2 * i - 1] = p_sp[i] * a_work[2 * i] - a_work[2 * i + 1] * p_cp[i];
+    }
+  }
+
+  /* Windowing and overlap */
+  for (i = 0; i < nsmpl_half; i++) {
+    p_x[i] = p_y[nsmpl_half + i] * p_w[i] - p_w[nsmpl - 1 - i] * p_x[nsmpl + i];
+    p_x[nsmpl_half + i] = -p_w[nsmpl_half - 1 - i] * p_x[nsmpl + nsmpl_half + i] -
+                          p_y[nsmpl - 1 - i] * p_w[nsmpl_half + i];
+    p_x[nsmpl + i] = p_y[nsmpl_half - 1 - i];
+    p_x[nsmpl + nsmpl_half + i] = p_y[i];
+  }
+}
+
+#undef LDAC_BFLY
+
+LDAC_IRAM DECLFUNC void proc_imdct_fast_ldac(SFINFO* p_sfinfo, int nlnn) {
+  const int nchs = p_sfinfo->cfg.ch;
+  for (int ich = 0; ich < nchs; ich++) {
+    ACSUB* p_acsub = p_sfinfo->ap_ac[ich]->p_acsub;
+    proc_imdct_core_fast_ldac(p_acsub->a_spec, p_acsub->a_time, nlnn);
+  }
+}
+
+/* Same conversions as set_output_pcm_ldac; returns bytes written */
+LDAC_IRAM DECLFUNC int set_output_pcm_interleaved_ldac(
+    SFINFO* p_sfinfo, unsigned char* p_pcm, LDAC_SMPL_FMT_T format, int nlnn) {
+  const int nchs = p_sfinfo->cfg.ch;
+  const int nsmpl = npow2_ldac(nlnn);
+
+  if (LDAC_UNLIKELY(nchs <= 0)) {
+    return 0;
+  }
+
+  switch (format) {
+    case LDAC_SMPL_FMT_S16: {
+      for (int ich = 0; ich < nchs; ich++) {
+        const SCALAR* __restrict__ p_time = p_sfinfo->ap_ac[ich]->p_acsub->a_time;
+        short* __restrict__ p_out = (short*)p_pcm + ich;
+        for (int isp = 0; isp < nsmpl; isp++) {
+          p_out[isp * nchs] = fast_clamp16(fast_round_to_int(p_time[isp]));
+        }
+      }
+      return nsmpl * nchs * 2;
+    }
+    case LDAC_SMPL_FMT_S24: {
+      for (int ich = 0; ich < nchs; ich++) {
+        const SCALAR* __restrict__ p_time = p_sfinfo->ap_ac[ich]->p_acsub->a_time;
+        unsigned char* __restrict__ p_out = p_pcm + ich * 3;
+        for (int isp = 0; isp < nsmpl; isp++) {
+          int temp = fast_clamp24(fast_round_to_int(p_time[isp] * _scalar(256.0)));
+          unsigned char* p = p_out + isp * nchs * 3;
+          p[0] = ((unsigned char*)(&temp))[0];
+          p[1] = ((unsigned char*)(&temp))[1];
+          p[2] = ((unsigned char*)(&temp))[2];
+        }
+      }
+      return nsmpl * nchs * 3;
+    }
+    case LDAC_SMPL_FMT_S32: {
+      for (int ich = 0; ich < nchs; ich++) {
+        const SCALAR* __restrict__ p_time = p_sfinfo->ap_ac[ich]->p_acsub->a_time;
+        int* __restrict__ p_out = (int*)p_pcm + ich;
+        for (int isp = 0; isp < nsmpl; isp++) {
+          long long temp = (long long)(p_time[isp] * _scalar(65536.0) + _scalar(0.5));
+          if (temp < -0x80000000LL) temp = -0x80000000LL;
+          if (temp >= 0x7FFFFFFFLL) temp = 0x7FFFFFFFLL;
+          p_out[isp * nchs] = (int)temp;
+        }
+      }
+      return nsmpl * nchs * 4;
+    }
+    case LDAC_SMPL_FMT_F32: {
+      const SCALAR inv_scale = _scalar(1.0) / _scalar(32768.0);
+      for (int ich = 0; ich < nchs; ich++) {
+        const SCALAR* __restrict__ p_time = p_sfinfo->ap_ac[ich]->p_acsub->a_time;
+        float* __restrict__ p_out = (float*)p_pcm + ich;
+        for (int isp = 0; isp < nsmpl; isp++) {
+          float temp = p_time[isp] * inv_scale;
+          temp = (temp < -1.0f) ? -1.0f : ((temp > 1.0f) ? 1.0f : temp);
+          p_out[isp * nchs] = temp;
+        }
+      }
+      return nsmpl * nchs * 4;
+    }
+    default:
+      return 0;
+  }
+}
+
+#endif /* LDAC_FAST_KERNELS */
@@ -235,6 +235,7 @@ struct _sfinfo_ldac {
   AC* ap_ac[LDAC_MAXNCH];
   char* p_mempos;
   int error_code;
+  int nqus_limit;  /* Dequantize at most this many QUs (0: all) */
 };
 
 /* LDAC Handle */
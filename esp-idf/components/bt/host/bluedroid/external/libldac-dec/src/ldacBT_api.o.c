@@ -126,6 +126,19 @@ LDACBT_API int ldacBT_get_bitrate(HANDLE_LDAC_BT hLdacBT) {
   return -1;
 }
 
+LDACBT_API int ldacBT_set_decode_bandwidth(HANDLE_LDAC_BT hLdacBT, int hz) {
+  if (!hLdacBT) return LDACBT_E_FAIL;
+  if (hLdacBT->proc_mode != LDACBT_PROCMODE_DECODE) {
+    hLdacBT->error_code_api = LDACBT_ERR_HANDLE_NOT_INIT;
+    return LDACBT_E_FAIL;
+  }
+  if (ldaclib_set_decode_bandwidth(hLdacBT->hLDAC, hz) != LDAC_S_OK) {
+    hLdacBT->error_code_api = LDACBT_ERR_ILL_PARAM;
+    return LDACBT_E_FAIL;
+  }
+  return LDACBT_S_OK;
+}
+
 LDACBT_API int ldacBT_init_handle_decode(
     HANDLE_LDAC_BT hLdacBT, int cm, int sf, int nshift, int var0, int var1) {
   int cci;
@@ -268,6 +281,23 @@ LDACBT_API int ldacBT_decode(
     if (!hLdacBT->flg_decode_inited) return 13;
   }
 
+#if LDAC_FAST_KERNELS
+  if (LDAC_FAILED(ldaclib_decode_interleaved(
+          hLdacBT->hLDAC,
+          p_bs + LDACBT_FRMHDRBYTES,
+          p_pcm,
+          bs_bytes - LDACBT_FRMHDRBYTES,
+          used_bytes,
+          wrote_bytes,
+          (LDAC_SMPL_FMT_T)fmt))) {
+    hLdacBT->error_code_api = LDACBT_GET_LDACLIB_ERROR_CODE;
+    *wrote_bytes = 0;
+    return 14;
+  }
+  if (*used_bytes) *used_bytes += LDACBT_FRMHDRBYTES;
+  frm_samples = hLdacBT->frm_samples;
+  hLdacBT->bitrate = *used_bytes * hLdacBT->pcm.sf / frm_samples / (1000 / 8);
+#else
   if (LDAC_FAILED(ldaclib_decode(
           hLdacBT->hLDAC,
           p_bs + LDACBT_FRMHDRBYTES,
@@ -283,5 +313,6 @@ LDACBT_API int ldacBT_decode(
   hLdacBT->bitrate = *used_bytes * hLdacBT->pcm.sf / frm_samples / (1000 / 8);
   *wrote_bytes = ldacBT_interleave_pcm(
       p_pcm, (const char**)hLdacBT->pp_pcm, frm_samples, hLdacBT->pcm.ch, fmt);
+#endif
   return tmp;
 }
@@ -15,6 +15,7 @@
 #include "ldaclib_api.o.c"
 #include "imdct_ldac.o.c"
 #include "dequant_ldac.o.c"
+#include "fastpath_ldac.o.c"
 #include "unpack_ldac.o.c"
 #include "decode_ldac.o.c"
 
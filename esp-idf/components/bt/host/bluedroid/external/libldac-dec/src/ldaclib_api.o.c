@@ -345,6 +345,7 @@ LDAC_RESULT ldaclib_init_decode(HANDLE_LDAC hData, int nlnn_shift) {
     nlnn = ga_ln_framesmpls_ldac[smplrate_id] + nlnn_shift;
     hData->nlnn = nlnn;
     set_imdct_table_ldac(nlnn);
+    p_sfinfo->nqus_limit = 0;
     result = init_decode_ldac(p_sfinfo);
     if (result) {
       hData->error_code = LDAC_ERR_DEC_INIT_ALLOC;
@@ -393,6 +394,69 @@ LDAC_RESULT ldaclib_decode(
     return LDAC_E_FAIL;
   }
 }
+
+/* From the next frame on, dequantize only the QUs starting below hz
+ * (0: all). The bands above are still unpacked, then left at zero, so
+ * the stream stays in sync whatever the limit. Needs ldaclib_init_decode
+ * first, which clears the limit. */
+LDAC_RESULT ldaclib_set_decode_bandwidth(HANDLE_LDAC hData, int hz) {
+  int smplrate;
+  int nqus;
+
+  if (hz < 0 || ldaclib_get_sampling_rate(hData->sfinfo.cfg.smplrate_id, &smplrate) != LDAC_S_OK) {
+    return LDAC_E_FAIL;
+  }
+  nqus = 0;
+  if (hz > 0) {
+    /* Spectral line k sits at k * smplrate / (2 << nlnn) Hz */
+    nqus = 1;
+    while (nqus < LDAC_MAXNQUS &&
+           (int64_t)ga_isp_ldac[nqus] * smplrate < ((int64_t)hz << (hData->nlnn + 1))) {
+      nqus++;
+    }
+  }
+  hData->sfinfo.nqus_limit = nqus;
+  return LDAC_S_OK;
+}
+
+#if LDAC_FAST_KERNELS
+/* ldaclib_decode on the fast kernels, with the PCM interleaved straight
+ * into p_pcm; *p_nbytes_pcm gets the bytes written */
+LDAC_RESULT ldaclib_decode_interleaved(
+    HANDLE_LDAC hData,
+    uint8_t* p_stream,
+    uint8_t* p_pcm,
+    int frame_length,
+    int* p_nbytes_used,
+    int* p_nbytes_pcm,
+    LDAC_SMPL_FMT_T sample_format) {
+  SFINFO* p_sfinfo;
+  int error_code;
+  int loc;
+
+  loc = 0;
+  *p_nbytes_pcm = 0;
+  if (hData->sfinfo.cfg.frame_length > frame_length) {
+    hData->error_code = LDAC_ERR_INPUT_BUFFER_SIZE;
+    return LDAC_E_FAIL;
+  }
+  if ((unsigned int)(sample_format - 2) > 3) {
+    hData->error_code = LDAC_ERR_ILL_SMPL_FORMAT;
+    return LDAC_E_FAIL;
+  }
+  p_sfinfo = &hData->sfinfo;
+  error_code = unpack_raw_data_frame_ldac(&hData->sfinfo, p_stream, &loc, p_nbytes_used);
+  if (error_code <= 0) {
+    decode_fast_ldac(p_sfinfo);
+    proc_imdct_fast_ldac(p_sfinfo, hData->nlnn);
+    *p_nbytes_pcm = set_output_pcm_interleaved_ldac(p_sfinfo, p_pcm, sample_format, hData->nlnn);
+    return hData->sfinfo.error_code < LDAC_ERR_FATAL;
+  }
+  hData->error_code = error_code;
+  return LDAC_E_FAIL;
+}
+#endif
+
 LDAC_RESULT ldaclib_clear_error_code(HANDLE_LDAC hData) {
   hData->error_code = LDAC_ERR_NONE;
   return 0;
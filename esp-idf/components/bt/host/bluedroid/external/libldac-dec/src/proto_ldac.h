@@ -22,8 +22,9 @@ DECLFUNC void reconst_word_length_ldac(AC*);
 
 /* dequant_ldac.c */
 DECLFUNC void clear_spectrum_ldac(AC*, int);
-DECLFUNC void dequant_spectrum_ldac(AC*);
-DECLFUNC void dequant_residual_ldac(AC*);
+DECLFUNC void dequant_spectrum_ldac(AC*, int);
+DECLFUNC void dequant_residual_ldac(AC*, int);
+DECLFUNC int decode_nqus_ldac(const SFINFO*, const AB*);
 
 /* unpack_ldac.c */
 DECLFUNC int unpack_frame_header_ldac(int*, int*, int*, int*, STREAM*);
@@ -36,6 +37,13 @@ DECLFUNC int get_block_nchs_ldac(int);
 /* tables_sigproc_ldac.c */
 DECLFUNC void set_imdct_table_ldac(int);
 
+/* fastpath_ldac.c */
+#if LDAC_FAST_KERNELS
+DECLFUNC void decode_fast_ldac(SFINFO*);
+DECLFUNC void proc_imdct_fast_ldac(SFINFO*, int);
+DECLFUNC int set_output_pcm_interleaved_ldac(SFINFO*, unsigned char*, LDAC_SMPL_FMT_T, int);
+#endif
+
 /* memory_ldac.c */
 DECLFUNC size_t align_ldac(size_t);
 DECLFUNC void* calloc_ldac(SFINFO*, size_t, size_t);
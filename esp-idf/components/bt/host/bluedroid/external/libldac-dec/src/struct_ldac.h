@@ -36,6 +36,30 @@
 #define LDAC_HOT __attribute__((hot))
 #endif
 
+/* ESP32 fast kernels (CONFIG_LDAC_DEC_FAST_KERNELS): stage-fused IMDCT,
+ * one-pass dequantization and PCM written interleaved into the caller's
+ * buffer. Bit-exact with the reference kernels (ldac_kernel_test.c).
+ * Hot kernels go to IRAM and the IMDCT tables to DRAM, out of the flash
+ * cache. */
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#endif
+#ifndef LDAC_FAST_KERNELS
+#if defined(CONFIG_LDAC_DEC_FAST_KERNELS) && CONFIG_LDAC_DEC_FAST_KERNELS && !CONFIG_USED_CSI_DSP
+#define LDAC_FAST_KERNELS 1
+#else
+#define LDAC_FAST_KERNELS 0
+#endif
+#endif
+#if LDAC_FAST_KERNELS && defined(ESP_PLATFORM)
+#define LDAC_IRAM IRAM_ATTR
+#define LDAC_DRAM DRAM_ATTR
+#else
+#define LDAC_IRAM
+#define LDAC_DRAM
+#endif
+
 #ifndef PI
 #ifdef M_PI
 #define PI M_PI
@@ -5,7 +5,7 @@
 ***************************************************************************************************/
 
 DECLFUNC const SCALAR* gaa_wsin_ldac[LDAC_NUMLNN];
-static const SCALAR sa_wsin_1fs_ldac[LDAC_1FSLSU] = {
+static const SCALAR LDAC_DRAM sa_wsin_1fs_ldac[LDAC_1FSLSU] = {
     7.0710678118654746e-01, 3.8268343236508978e-01, 9.2387953251128674e-01, 1.9509032201612825e-01,
     8.3146961230254524e-01, 9.8078528040323043e-01, 5.5557023301960218e-01, 9.8017140329560604e-02,
     4.7139673682599764e-01, 7.7301045336273699e-01, 9.5694033573220894e-01, 9.9518472667219693e-01,
@@ -40,7 +40,7 @@ static const SCALAR sa_wsin_1fs_ldac[LDAC_1FSLSU] = {
     9.9772306664419164e-01, 9.9907772775264536e-01, 9.9983058179582340e-01, 0.0000000000000000e+00,
 };
 
-static const SCALAR sa_wsin_2fs_ldac[LDAC_2FSLSU] = {
+static const SCALAR LDAC_DRAM sa_wsin_2fs_ldac[LDAC_2FSLSU] = {
     7.0710678118654746e-01, 3.8268343236508978e-01, 9.2387953251128674e-01, 1.9509032201612825e-01,
     8.3146961230254524e-01, 9.8078528040323043e-01, 5.5557023301960218e-01, 9.8017140329560604e-02,
     4.7139673682599764e-01, 7.7301045336273699e-01, 9.5694033573220894e-01, 9.9518472667219693e-01,
@@ -107,7 +107,7 @@ static const SCALAR sa_wsin_2fs_ldac[LDAC_2FSLSU] = {
     9.9943060455546173e-01, 9.9976940535121528e-01, 9.9995764455196390e-01, 0.0000000000000000e+00,
 };
 DECLFUNC const int* gaa_rev_perm_ldac[LDAC_NUMLNN];
-static const int sa_rev_perm_1fs_ldac[LDAC_1FSLSU] = {
+static const int LDAC_DRAM sa_rev_perm_1fs_ldac[LDAC_1FSLSU] = {
     63,  64,  0,   127, 32,  95,  31,  96,  48,  79,  15,  112, 47,  80,  16, 111, 56,  71,  7,
     120, 39,  88,  24,  103, 55,  72,  8,   119, 40,  87,  23,  104, 60,  67, 3,   124, 35,  92,
     28,  99,  51,  76,  12,  115, 44,  83,  19,  108, 59,  68,  4,   123, 36, 91,  27,  100, 52,
@@ -117,7 +117,7 @@ static const int sa_rev_perm_1fs_ldac[LDAC_1FSLSU] = {
     5,   122, 37,  90,  26,  101, 53,  74,  10,  117, 42,  85,  21,  106,
 };
 
-static const int sa_rev_perm_2fs_ldac[LDAC_2FSLSU] = {
+static const int LDAC_DRAM sa_rev_perm_2fs_ldac[LDAC_2FSLSU] = {
     127, 128, 0,  255, 64,  191, 63, 192, 96,  159, 31, 224, 95,  160, 32, 223, 112, 143, 15, 240,
     79,  176, 48, 207, 111, 144, 16, 239, 80,  175, 47, 208, 120, 135, 7,  248, 71,  184, 56, 199,
     103, 152, 24, 231, 88,  167, 39, 216, 119, 136, 8,  247, 72,  183, 55, 200, 104, 151, 23, 232,
@@ -134,7 +134,7 @@ static const int sa_rev_perm_2fs_ldac[LDAC_2FSLSU] = {
 };
 
 DECLFUNC const SCALAR* gaa_bwin_ldac[LDAC_NUMLNN];
-static const SCALAR sa_bwin_1fs_ldac[LDAC_1FSLSU] = {
+static const SCALAR LDAC_DRAM sa_bwin_1fs_ldac[LDAC_1FSLSU] = {
     3.765191544099423e-05, 3.390373649321848e-04, 9.427159656260942e-04, 1.850504857178094e-03,
     3.065134055998753e-03, 4.590251528447209e-03, 6.430429793887341e-03, 8.591173914068285e-03,
     1.107893068263796e-02, 1.390109878135223e-02, 1.706603961668948e-02, 2.058308849110322e-02,
@@ -169,7 +169,7 @@ static const SCALAR sa_bwin_1fs_ldac[LDAC_1FSLSU] = {
     1.001843681328112e+00, 1.000940941880612e+00, 1.000338807627989e+00, 1.000037649080321e+00,
 };
 
-static const SCALAR sa_bwin_2fs_ldac[LDAC_2FSLSU] = {
+static const SCALAR LDAC_DRAM sa_bwin_2fs_ldac[LDAC_2FSLSU] = {
     9.412535886105758e-06, 8.472345456793429e-05, 2.354019994499397e-04, 4.615616128443440e-04,
     7.633725262781104e-04, 1.141061841797753e-03, 1.594913639763588e-03, 2.125269112603825e-03,
     2.732526723860336e-03, 3.417142391712789e-03, 4.179629696022335e-03, 5.020560107778368e-03,
@@ -236,7 +236,7 @@ static const SCALAR sa_bwin_2fs_ldac[LDAC_2FSLSU] = {
     1.000461135927378e+00, 1.000235291223389e+00, 1.000084709100872e+00, 1.000009412358698e+00,
 };
 DECLFUNC const SCALAR* gaa_wcos_ldac[LDAC_NUMLNN];
-static const SCALAR sa_wcos_1fs_ldac[LDAC_1FSLSU] = {
+static const SCALAR LDAC_DRAM sa_wcos_1fs_ldac[LDAC_1FSLSU] = {
     7.0710678118654757e-01,  9.2387953251128674e-01,  -3.8268343236508973e-01,
     9.8078528040323043e-01,  5.5557023301960229e-01,  -1.9509032201612819e-01,
     -8.3146961230254535e-01, 9.9518472667219693e-01,  8.8192126434835505e-01,
@@ -282,7 +282,7 @@ static const SCALAR sa_wcos_1fs_ldac[LDAC_1FSLSU] = {
     1.8406729905804820e-02,  0.0000000000000000e+00,
 };
 
-static const SCALAR sa_wcos_2fs_ldac[LDAC_2FSLSU] = {
+static const SCALAR LDAC_DRAM sa_wcos_2fs_ldac[LDAC_2FSLSU] = {
     7.0710678118654757e-01,  9.2387953251128674e-01,  -3.8268343236508973e-01,
     9.8078528040323043e-01,  5.5557023301960229e-01,  -1.9509032201612819e-01,
     -8.3146961230254535e-01, 9.9518472667219693e-01,  8.8192126434835505e-01,
@@ -1,5 +1,6 @@
 #include "opus_defines.h"
 #include "osi/allocator.h"
+#include "esp_heap_caps.h"
 
 static OPUS_INLINE void *opus_alloc (size_t size)
 {
@@ -10,3 +11,10 @@ static OPUS_INLINE void opus_free (void *ptr)
 {
    osi_free(ptr);
 }
+
+/* The pseudostack is touched on every frame: internal RAM when it fits */
+static OPUS_INLINE void *opus_alloc_scratch (size_t size)
+{
+   void *p = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+   return p ? p : osi_malloc(size);
+}
@@ -118,6 +118,21 @@ typedef struct {
 #define DCTII_8_SHIFT_6 (DCTII_8_SHIFT_OUT-1)
 #define DCTII_8_SHIFT_7 (DCTII_8_SHIFT_OUT-2)
 
+/* CONFIG_SBC_DEC_FAST_SYNTHESIS: 8-subband synthesis specialised per channel
+ * count, with the fixed-point multiplies done natively (synthesis-sbc.c,
+ * synthesis-dct8.c). Bit-exact with the portable code. */
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#endif
+
+#ifndef SBC_FAST_SYNTHESIS
+#if defined(CONFIG_SBC_DEC_FAST_SYNTHESIS) && CONFIG_SBC_DEC_FAST_SYNTHESIS
+#define SBC_FAST_SYNTHESIS 1
+#else
+#define SBC_FAST_SYNTHESIS 0
+#endif
+#endif
+
 #define DCT_SHIFT 15
 
 #define DCTIII_4_SHIFT_IN 2
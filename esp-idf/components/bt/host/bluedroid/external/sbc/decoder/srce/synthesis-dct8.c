@@ -52,6 +52,10 @@
 #define SCALE(x, y) (((x) + (1 <<((y)-1))) >> (y))
 #endif
 
+#if SBC_FAST_SYNTHESIS
+/* Same 32 MSBs as default_mul_32s_32s_hi() below, in one mulsh on Xtensa */
+#define MUL_32S_32S_HI(_x, _y) ((OI_INT32)(((long long)(_x) * (_y)) >> 32))
+#else
 /**
  * Default C language implementation of a 32x32->32 multiply. This function may
  * be replaced by a platform-specific version for speed.
@@ -78,6 +82,7 @@ static INLINE OI_INT32 default_mul_32s_32s_hi(OI_INT32 u, OI_INT32 v)
 }
 
 #define MUL_32S_32S_HI(_x, _y) default_mul_32s_32s_hi(_x, _y)
+#endif
 
 
 #ifdef DEBUG_DCT
@@ -205,6 +205,10 @@ const OI_INT32 dec_window_4[21] = {
 #define CLIP_INT16(x) do { if (x > OI_INT16_MAX) { x = OI_INT16_MAX; } else if (x < OI_INT16_MIN) { x = OI_INT16_MIN; } } while (0)
 #endif
 
+#if SBC_FAST_SYNTHESIS
+/* Same 32 MSBs as default_mul_16s_32s_hi() below, in one mull/mulsh pair */
+#define MUL_16S_32S_HI(_x, _y) ((OI_INT32)(((long long)(_x) * (_y)) >> 16))
+#else
 /**
  * Default C language implementation of a 16x32->32 multiply. This function may
  * be replaced by a platform-specific version for speed.
@@ -232,6 +236,7 @@ static INLINE OI_INT32 default_mul_16s_32s_hi(OI_INT16 u, OI_INT32 v)
 }
 
 #define MUL_16S_32S_HI(_x, _y) default_mul_16s_32s_hi(_x, _y)
+#endif
 
 #define LONG_MULT_DCT(K, sample) (MUL_16S_32S_HI(K, sample)<<2)
 
@@ -320,6 +325,64 @@ PRIVATE void OI_SBC_SynthFrame_4SB(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT
     context->common.filterBufferOffset = offset;
 }
 
+#if SBC_FAST_SYNTHESIS
+/*
+ * 8-subband synthesis with the channel count fixed per function: the filter
+ * buffers of both channels are shifted together, the channel loop is
+ * unrolled and the PCM goes straight to its interleaved slot. Same
+ * arithmetic as OI_SBC_SynthFrame_80.
+ */
+PRIVATE void OI_SBC_SynthFrame_80_Mono(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT16 *pcm, OI_UINT blkstart, OI_UINT blkcount)
+{
+    SBC_BUFFER_T *fb = context->common.filterBuffer[0];
+    const OI_UINT tail = context->common.filterBufferLen - 72;
+    const OI_UINT pcmStrideShift = context->common.pcmStride == 1 ? 0 : 1;
+    OI_UINT offset = context->common.filterBufferOffset;
+    OI_INT32 *s = context->common.subdata + 8 * blkstart;
+
+    while (blkcount--) {
+        if (offset == 0) {
+            COPY_BACKWARD_32BIT_ALIGNED_72_HALFWORDS(fb + tail, fb);
+            offset = tail - 8;
+        } else {
+            offset -= 8;
+        }
+        DCT2_8(fb + offset, s);
+        SYNTH80(pcm, fb + offset, pcmStrideShift);
+        s += 8;
+        pcm += (8 << pcmStrideShift);
+    }
+    context->common.filterBufferOffset = offset;
+}
+
+PRIVATE void OI_SBC_SynthFrame_80_Stereo(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT16 *pcm, OI_UINT blkstart, OI_UINT blkcount)
+{
+    SBC_BUFFER_T *fb0 = context->common.filterBuffer[0];
+    SBC_BUFFER_T *fb1 = context->common.filterBuffer[1];
+    const OI_UINT tail = context->common.filterBufferLen - 72;
+    OI_UINT offset = context->common.filterBufferOffset;
+    OI_INT32 *s = context->common.subdata + 16 * blkstart;
+
+    /* Two channels always come with a PCM stride of 2 */
+    while (blkcount--) {
+        if (offset == 0) {
+            COPY_BACKWARD_32BIT_ALIGNED_72_HALFWORDS(fb0 + tail, fb0);
+            COPY_BACKWARD_32BIT_ALIGNED_72_HALFWORDS(fb1 + tail, fb1);
+            offset = tail - 8;
+        } else {
+            offset -= 8;
+        }
+        DCT2_8(fb0 + offset, s);
+        SYNTH80(pcm, fb0 + offset, 1);
+        DCT2_8(fb1 + offset, s + 8);
+        SYNTH80(pcm + 1, fb1 + offset, 1);
+        s += 16;
+        pcm += 16;
+    }
+    context->common.filterBufferOffset = offset;
+}
+#endif /* SBC_FAST_SYNTHESIS */
+
 #ifdef SBC_ENHANCED
 
 PRIVATE void OI_SBC_SynthFrame_Enhanced(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT16 *pcm, OI_UINT blkstart, OI_UINT blkcount)
@@ -362,8 +425,13 @@ static const SYNTH_FRAME SynthFrameEnhanced[] = {
 
 static const SYNTH_FRAME SynthFrame8SB[] = {
     NULL,             /* invalid */
+#if SBC_FAST_SYNTHESIS
+    OI_SBC_SynthFrame_80_Mono,  /* mono */
+    OI_SBC_SynthFrame_80_Stereo /* stereo */
+#else
     OI_SBC_SynthFrame_80, /* mono */
     OI_SBC_SynthFrame_80  /* stereo */
+#endif
 };
 
 
@@ -0,0 +1,18 @@
+/* The synthesis sources built with SBC_FAST_SYNTHESIS, every global renamed
+ * with a fast_ prefix, so sbc_synth_test.c can link them next to the
+ * portable build of the same files. */
+#define SBC_FAST_SYNTHESIS 1
+
+#define OI_SBC_SynthFrame                           fast_OI_SBC_SynthFrame
+#define OI_SBC_SynthFrame_4SB                       fast_OI_SBC_SynthFrame_4SB
+#define OI_SBC_SynthFrame_80                        fast_OI_SBC_SynthFrame_80
+#define OI_SBC_SynthFrame_80_Mono                   fast_OI_SBC_SynthFrame_80_Mono
+#define OI_SBC_SynthFrame_80_Stereo                 fast_OI_SBC_SynthFrame_80_Stereo
+#define OI_SBC_SynthFrame_Enhanced                  fast_OI_SBC_SynthFrame_Enhanced
+#define SynthWindow40_int32_int32_symmetry_with_sum fast_SynthWindow40_int32_int32_symmetry_with_sum
+#define cosineModulateSynth4                        fast_cosineModulateSynth4
+#define dec_window_4                                fast_dec_window_4
+#define dct2_8                                      fast_dct2_8
+
+#include "../srce/synthesis-sbc.c"
+#include "../srce/synthesis-dct8.c"
@@ -0,0 +1,139 @@
+/* Bit-exactness test of the fast synthesis (SBC_FAST_SYNTHESIS, built in
+ * sbc_synth_fast.c) against the portable one: mono and stereo, 4 and 8
+ * subbands, PCM strides 1 and 2, several filter buffer lengths, random
+ * block splits and subband samples from OI_SBC_Dequant() up to full scale
+ * (scale factor 15, 16 bits, joint stereo sums). PCM, filter buffers and
+ * offsets are compared after every call. Returns non-zero on the first
+ * mismatch. */
+#include "common/bt_target.h"
+#include "oi_codec_sbc_private.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if SBC_FAST_SYNTHESIS
+#error "the reference must be the portable synthesis"
+#endif
+
+#define NFRAMES 400
+
+void fast_OI_SBC_SynthFrame(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT16 *pcm, OI_UINT start_block, OI_UINT nrof_blocks);
+
+static unsigned int s_seed = 12345;
+static int rnd(int n)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return (int)((s_seed >> 8) % (unsigned int)n);
+}
+
+/* One subband sample as the decoder dequantizes it; mode 0 random, 1 full
+ * scale (largest scale factor and word length, extreme codes) */
+static OI_INT32 sample(int mode)
+{
+    if (mode == 1) {
+        return OI_SBC_Dequant(rnd(2) ? 0xFFFF : 0, 15, 16);
+    }
+    const OI_UINT bits = 2 + rnd(15);
+    const OI_UINT raw = rnd(4) ? (OI_UINT)rnd(1 << bits) : (rnd(2) ? (1u << bits) - 1 : 0);
+    return OI_SBC_Dequant(raw, rnd(16), bits);
+}
+
+static void fill(OI_INT32 *s, int nch, int nsb, int blocks, int mode, int joint)
+{
+    for (int blk = 0; blk < blocks; blk++) {
+        for (int sb = 0; sb < nsb; sb++) {
+            const OI_INT32 m = sample(mode), d = sample(mode);
+            if (nch == 2 && joint) {
+                s[(blk * 2 + 0) * nsb + sb] = m + d;
+                s[(blk * 2 + 1) * nsb + sb] = m - d;
+            } else {
+                for (int ch = 0; ch < nch; ch++) {
+                    s[(blk * nch + ch) * nsb + sb] = ch ? d : m;
+                }
+            }
+        }
+    }
+}
+
+static int setup(OI_CODEC_SBC_DECODER_CONTEXT *ctx, OI_UINT32 *data, OI_UINT32 bytes,
+                 int nch, int nsb, int stride)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    if (OI_CODEC_SBC_Alloc(&ctx->common, data, bytes, (OI_UINT8)(stride > nch ? stride : nch),
+                           (OI_UINT8)stride) != OI_OK) {
+        return 0;
+    }
+    memset(data, 0, bytes);
+    ctx->common.frameInfo.nrof_channels = (OI_UINT8)nch;
+    ctx->common.frameInfo.nrof_subbands = (OI_UINT8)nsb;
+    return 1;
+}
+
+static int run(int nch, int nsb, int stride, int nbuffers)
+{
+    static OI_CODEC_SBC_DECODER_CONTEXT ref, fast;
+    static OI_UINT32 ref_data[CODEC_DATA_WORDS(2, 40)], fast_data[CODEC_DATA_WORDS(2, 40)];
+    static OI_INT16 ref_pcm[SBC_MAX_SAMPLES_PER_FRAME * 2], fast_pcm[SBC_MAX_SAMPLES_PER_FRAME * 2];
+    const int maxch = stride > nch ? stride : nch;
+    const OI_UINT32 bytes = (OI_UINT32)(sizeof(OI_INT32) * maxch * SBC_MAX_BANDS * SBC_MAX_BLOCKS +
+                                        sizeof(SBC_BUFFER_T) * SBC_MAX_BANDS * maxch * nbuffers);
+
+    if (!setup(&ref, ref_data, bytes, nch, nsb, stride) || !setup(&fast, fast_data, bytes, nch, nsb, stride)) {
+        printf("%d ch %d sb: alloc failed\n", nch, nsb);
+        return 1;
+    }
+    for (int frm = 0; frm < NFRAMES; frm++) {
+        const int blocks = 4 * (1 + rnd(4));
+        const int mode = frm % 3 == 1;
+        fill(ref.common.subdata, nch, nsb, blocks, mode, rnd(2));
+        memcpy(fast.common.subdata, ref.common.subdata, sizeof(OI_INT32) * nch * nsb * blocks);
+        memset(ref_pcm, 0x5A, sizeof(ref_pcm));
+        memset(fast_pcm, 0x5A, sizeof(fast_pcm));
+
+        /* The frame in one call or split, as partial PCM buffers split it */
+        int start = 0;
+        while (start < blocks) {
+            const int count = frm & 1 ? blocks - start : 1 + rnd(blocks - start);
+            OI_INT16 *const ref_at = ref_pcm + start * nsb * stride;
+            OI_INT16 *const fast_at = fast_pcm + start * nsb * stride;
+            OI_SBC_SynthFrame(&ref, ref_at, start, count);
+            fast_OI_SBC_SynthFrame(&fast, fast_at, start, count);
+            start += count;
+        }
+
+        if (memcmp(ref_pcm, fast_pcm, sizeof(ref_pcm))) {
+            printf("%d ch %d sb stride %d buffers %d frame %d: PCM mismatch\n", nch, nsb, stride, nbuffers, frm);
+            return 1;
+        }
+        if (ref.common.filterBufferOffset != fast.common.filterBufferOffset) {
+            printf("%d ch %d sb stride %d buffers %d frame %d: offset %u vs %u\n", nch, nsb, stride, nbuffers,
+                   frm, (unsigned)ref.common.filterBufferOffset, (unsigned)fast.common.filterBufferOffset);
+            return 1;
+        }
+        for (int ch = 0; ch < nch; ch++) {
+            if (memcmp(ref.common.filterBuffer[ch], fast.common.filterBuffer[ch],
+                       sizeof(SBC_BUFFER_T) * ref.common.filterBufferLen)) {
+                printf("%d ch %d sb stride %d buffers %d frame %d: filter buffer %d mismatch\n",
+                       nch, nsb, stride, nbuffers, frm, ch);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    static const int buffers[] = { SBC_CODEC_MIN_FILTER_BUFFERS, 21, SBC_CODEC_FAST_FILTER_BUFFERS };
+    int cases = 0;
+    for (int nsb = 4; nsb <= 8; nsb += 4) {
+        for (unsigned b = 0; b < sizeof(buffers) / sizeof(buffers[0]); b++) {
+            if (run(1, nsb, 1, buffers[b]) || run(1, nsb, 2, buffers[b]) || run(2, nsb, 2, buffers[b])) {
+                return 1;
+            }
+            cases += 3;
+        }
+    }
+    printf("SBC synthesis: %d cases, %d frames each, bit-exact\n", cases, NFRAMES);
+    return 0;
+}
@@ -13,6 +13,7 @@
 #include "oi_codec_sbc.h"
 #include "oi_status.h"
 #include "osi/future.h"
+#include "osi/allocator.h"
 
 #if (defined(SBC_DEC_INCLUDED) && SBC_DEC_INCLUDED == TRUE)
 
@@ -24,9 +25,19 @@ typedef struct {
   decoded_data_callback_t decode_callback;
 } tA2DP_SBC_DECODER_CB;
 
-static tA2DP_SBC_DECODER_CB a2dp_sbc_decoder_cb;
+/* Allocated while SBC is the active codec */
+static tA2DP_SBC_DECODER_CB *a2dp_sbc_decoder_cb_ptr;
+#define a2dp_sbc_decoder_cb (*a2dp_sbc_decoder_cb_ptr)
 
 bool a2dp_sbc_decoder_init(decoded_data_callback_t decode_callback) {
+  if (!a2dp_sbc_decoder_cb_ptr) {
+    a2dp_sbc_decoder_cb_ptr = (tA2DP_SBC_DECODER_CB *)osi_calloc(sizeof(tA2DP_SBC_DECODER_CB));
+    if (!a2dp_sbc_decoder_cb_ptr) {
+      LOG_ERROR("%s: no memory for decoder state (%u bytes)", __func__,
+                (unsigned)sizeof(tA2DP_SBC_DECODER_CB));
+      return false;
+    }
+  }
   a2dp_sbc_decoder_cb.maxChannels = 2;
   a2dp_sbc_decoder_cb.pcmStride = 2;
   a2dp_sbc_decoder_reset();
@@ -35,10 +46,14 @@ bool a2dp_sbc_decoder_init(decoded_data_callback_t decode_callback) {
 }
 
 void a2dp_sbc_decoder_cleanup(void) {
-  // Do nothing.
+  osi_free(a2dp_sbc_decoder_cb_ptr);
+  a2dp_sbc_decoder_cb_ptr = NULL;
 }
 
 bool a2dp_sbc_decoder_reset() {
+  if (!a2dp_sbc_decoder_cb_ptr) {
+    return false;
+  }
   OI_STATUS status = OI_CODEC_SBC_DecoderReset(
       &a2dp_sbc_decoder_cb.decoder_context, a2dp_sbc_decoder_cb.context_data,
       sizeof(a2dp_sbc_decoder_cb.context_data),
@@ -55,6 +70,9 @@ bool a2dp_sbc_decoder_reset() {
 void a2dp_sbc_decoder_configure(const uint8_t* p_codec_info) {
   tA2D_SBC_CIE cie;
   tA2D_STATUS status;
+  if (!a2dp_sbc_decoder_cb_ptr) {
+    return;
+  }
   status = A2D_ParsSbcInfo(&cie, (uint8_t*)p_codec_info, false);
   if (status != A2D_SUCCESS) {
     LOG_ERROR("%s: failed parsing codec info. %d", __func__, status);
@@ -169,6 +187,10 @@ bool a2dp_sbc_decoder_decode_packet(BT_HDR* p_buf, unsigned char* buf, size_t bu
     OI_STATUS status;
     int count;
 
+    if (!a2dp_sbc_decoder_cb_ptr) {
+        return false;
+    }
+
     data  = (UINT8 *)(p_buf + 1) + p_buf->offset;
     header = (struct sbc_header*)data;
     num_frames = header->num_frames;
@@ -5,7 +5,9 @@
  * A2DP AAC Decoder - Custom Implementation
  * 
  * Integrates lightweight LATM parser with custom AAC-LC decoder
- * for Bluetooth A2DP audio streaming.
+ * for Bluetooth A2DP audio streaming. The LATM parser only locates the
+ * raw AAC frame inside the packet; Helix decodes it from there, starting
+ * at whatever bit it begins, so the payload is never copied.
  * 
  * Implements tA2DP_DECODER_INTERFACE for use by btc_a2dp_sink.
  */
@@ -26,6 +28,7 @@
 
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_cpu.h"
 
 #define TAG "A2DP_AAC_CUSTOM"
 
@@ -48,16 +51,22 @@ typedef struct {
     /* Statistics */
     uint32_t frames_decoded;
     uint32_t frames_failed;
+    bool sbr_logged;
+    
+    /* CPU cycles spent in LATM parsing and AAC decoding since the last
+     * periodic log, for the per-frame averages it prints */
+    uint32_t latm_cycles;
+    uint32_t aac_cycles;
+    uint32_t cycle_frames;
     
     /* Output buffer for decoded PCM */
     int16_t *pcm_buffer;
     size_t pcm_buffer_size;
-    
-    /* Raw AAC buffer for LATM extraction */
-    uint8_t raw_aac_buffer[1024];
 } a2dp_aac_decoder_state_t;
 
-static a2dp_aac_decoder_state_t s_decoder = {0};
+/* Allocated while AAC is the active codec */
+static a2dp_aac_decoder_state_t *s_decoder_ptr = NULL;
+#define s_decoder (*s_decoder_ptr)
 static osi_mutex_t s_mutex = NULL;
 
 /* Forward declarations */
@@ -75,6 +84,20 @@ static void log_memory_info(const char *label)
              (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
 }
 
+/* Frees everything init allocated, in reverse order */
+static void release_state(void)
+{
+    if (s_decoder.pcm_buffer) {
+        heap_caps_free(s_decoder.pcm_buffer);
+    }
+    if (s_decoder.decoder) {
+        aac_decoder_deinit(s_decoder.decoder);
+        heap_caps_free(s_decoder.decoder);
+    }
+    heap_caps_free(s_decoder_ptr);
+    s_decoder_ptr = NULL;
+}
+
 /*******************************************************************************
  * Public API - tA2DP_DECODER_INTERFACE Implementation
  ******************************************************************************/
@@ -85,7 +108,7 @@ static void log_memory_info(const char *label)
  */
 bool a2dp_aac_decoder_init(decoded_data_callback_t decode_callback)
 {
-    if (s_decoder.initialized) {
+    if (s_decoder_ptr) {
         ESP_LOGW(TAG, "Already initialized, reinitializing");
         a2dp_aac_decoder_cleanup();
     }
@@ -97,7 +120,14 @@ bool a2dp_aac_decoder_init(decoded_data_callback_t decode_callback)
     
     log_memory_info("Before AAC decoder init");
     
-    memset(&s_decoder, 0, sizeof(s_decoder));
+    s_decoder_ptr = (a2dp_aac_decoder_state_t *)heap_caps_calloc(
+        1, sizeof(a2dp_aac_decoder_state_t),
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT
+    );
+    if (!s_decoder_ptr) {
+        ESP_LOGE(TAG, "Failed to allocate decoder state (%u bytes)", sizeof(a2dp_aac_decoder_state_t));
+        return false;
+    }
     s_decoder.decode_callback = decode_callback;
     
     /* Create mutex */
@@ -113,6 +143,7 @@ bool a2dp_aac_decoder_init(decoded_data_callback_t decode_callback)
     
     if (!s_decoder.decoder) {
         ESP_LOGE(TAG, "Failed to allocate decoder (%u bytes)", sizeof(aac_decoder_t));
+        release_state();
         return false;
     }
     
@@ -122,8 +153,7 @@ bool a2dp_aac_decoder_init(decoded_data_callback_t decode_callback)
     int err = aac_decoder_init(s_decoder.decoder);
     if (err != AAC_OK) {
         ESP_LOGE(TAG, "Decoder init failed: %d", err);
-        heap_caps_free(s_decoder.decoder);
-        s_decoder.decoder = NULL;
+        release_state();
         return false;
     }
     
@@ -139,8 +169,7 @@ bool a2dp_aac_decoder_init(decoded_data_callback_t decode_callback)
     
     if (!s_decoder.pcm_buffer) {
         ESP_LOGE(TAG, "Failed to allocate PCM buffer");
-        heap_caps_free(s_decoder.decoder);
-        s_decoder.decoder = NULL;
+        release_state();
         return false;
     }
     
@@ -159,7 +188,7 @@ bool a2dp_aac_decoder_init(decoded_data_callback_t decode_callback)
  */
 void a2dp_aac_decoder_cleanup(void)
 {
-    if (!s_decoder.initialized) {
+    if (!s_decoder_ptr) {
         return;
     }
     
@@ -167,23 +196,11 @@ void a2dp_aac_decoder_cleanup(void)
         osi_mutex_lock(&s_mutex, OSI_MUTEX_MAX_TIMEOUT);
     }
     
-    if (s_decoder.pcm_buffer) {
-        heap_caps_free(s_decoder.pcm_buffer);
-        s_decoder.pcm_buffer = NULL;
-    }
-    
-    if (s_decoder.decoder) {
-        heap_caps_free(s_decoder.decoder);
-        s_decoder.decoder = NULL;
-    }
-    
-    latm_parser_reset(&s_decoder.latm);
-    
     ESP_LOGI(TAG, "AAC decoder cleaned up. Decoded: %lu, Failed: %lu",
              (unsigned long)s_decoder.frames_decoded,
              (unsigned long)s_decoder.frames_failed);
     
-    s_decoder.initialized = false;
+    release_state();
     
     if (s_mutex) {
         osi_mutex_unlock(&s_mutex);
@@ -213,7 +230,7 @@ bool a2dp_aac_decoder_decode_packet(BT_HDR *p_buf, unsigned char *buf, size_t bu
     (void)buf;
     (void)buf_len;
     
-    if (!s_decoder.initialized || !s_decoder.decoder || !p_buf) {
+    if (!s_decoder_ptr || !s_decoder.initialized || !s_decoder.decoder || !p_buf) {
         ESP_LOGW(TAG, "decode_packet: not initialized or null buffer");
         return false;
     }
@@ -228,7 +245,7 @@ bool a2dp_aac_decoder_decode_packet(BT_HDR *p_buf, unsigned char *buf, size_t bu
     bool success = false;
     uint8_t *data = (uint8_t *)(p_buf + 1) + p_buf->offset;
     size_t data_len = p_buf->len;
-    size_t raw_aac_len = 0;
+    latm_payload_t payload;
     
     /* Log every 100 packets */
     static uint32_t pkt_count = 0;
@@ -271,11 +288,10 @@ bool a2dp_aac_decoder_decode_packet(BT_HDR *p_buf, unsigned char *buf, size_t bu
                  latm_len > 3 ? latm_data[3] : 0);
     }
     
-    /* Parse LATM wrapper to extract raw AAC frame */
-    latm_error_t latm_result = latm_parse_frame(&s_decoder.latm, latm_data, latm_len,
-                                                 s_decoder.raw_aac_buffer, 
-                                                 sizeof(s_decoder.raw_aac_buffer),
-                                                 &raw_aac_len, NULL);
+    /* Parse LATM wrapper to locate the raw AAC frame */
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    latm_error_t latm_result = latm_parse_payload(&s_decoder.latm, latm_data, latm_len, &payload);
+    uint32_t t1 = esp_cpu_get_cycle_count();
     
     if (latm_result != LATM_OK) {
         if (latm_result == LATM_ERR_NOT_ENOUGH_DATA) {
@@ -290,7 +306,8 @@ bool a2dp_aac_decoder_decode_packet(BT_HDR *p_buf, unsigned char *buf, size_t bu
     }
     
     if (pkt_count == 1) {
-        ESP_LOGI(TAG, "LATM extracted %d bytes raw AAC", (int)raw_aac_len);
+        ESP_LOGI(TAG, "LATM payload %d bytes raw AAC at bit %d",
+                 (int)payload.len, payload.bit_offset);
     }
     
     /* If first frame or config changed, configure from LATM */
@@ -305,14 +322,24 @@ bool a2dp_aac_decoder_decode_packet(BT_HDR *p_buf, unsigned char *buf, size_t bu
             ESP_LOGI(TAG, "Auto-configured: %luHz, %dch",
                      (unsigned long)audio_cfg->sample_rate, 
                      audio_cfg->channel_config);
+            /* Helix is built without SBR: HE-AAC plays as its AAC-LC core */
+            if (audio_cfg->sbr_present && !s_decoder.sbr_logged) {
+                ESP_LOGW(TAG, "ASC signals SBR (%luHz), decoding the %luHz AAC-LC core only",
+                         (unsigned long)audio_cfg->sbr_sample_rate,
+                         (unsigned long)audio_cfg->sample_rate);
+                s_decoder.sbr_logged = true;
+            }
         }
     }
     
-    /* Decode raw AAC frame */
+    /* Decode raw AAC frame in place */
     int samples_out = 0;
-    int err = aac_decoder_decode(s_decoder.decoder,
-                                  s_decoder.raw_aac_buffer, raw_aac_len,
-                                  s_decoder.pcm_buffer, &samples_out);
+    int err = aac_decoder_decode_bits(s_decoder.decoder,
+                                      payload.data, (int)payload.len, payload.bit_offset,
+                                      s_decoder.pcm_buffer, &samples_out);
+    s_decoder.latm_cycles += t1 - t0;
+    s_decoder.aac_cycles += esp_cpu_get_cycle_count() - t1;
+    s_decoder.cycle_frames++;
     
     if (err != AAC_OK) {
         if (pkt_count <= 10 || pkt_count % 100 == 0) {
@@ -339,10 +366,15 @@ bool a2dp_aac_decoder_decode_packet(BT_HDR *p_buf, unsigned char *buf, size_t bu
         s_decoder.frames_decoded++;
         
         if (s_decoder.frames_decoded % 100 == 1) {
-            ESP_LOGI(TAG, "Decoded %lu frames, %d samples/frame, failed=%lu",
+            ESP_LOGI(TAG, "Decoded %lu frames, %d samples/frame, failed=%lu, cycles/frame latm=%lu aac=%lu",
                      (unsigned long)s_decoder.frames_decoded,
                      (int)samples_out,
-                     (unsigned long)s_decoder.frames_failed);
+                     (unsigned long)s_decoder.frames_failed,
+                     (unsigned long)(s_decoder.latm_cycles / s_decoder.cycle_frames),
+                     (unsigned long)(s_decoder.aac_cycles / s_decoder.cycle_frames));
+            s_decoder.latm_cycles = 0;
+            s_decoder.aac_cycles = 0;
+            s_decoder.cycle_frames = 0;
         }
         success = true;
     }
@@ -357,7 +389,7 @@ done:
  */
 void a2dp_aac_decoder_configure(const uint8_t *p_codec_info)
 {
-    if (!s_decoder.initialized || !s_decoder.decoder || !p_codec_info) {
+    if (!s_decoder_ptr || !s_decoder.initialized || !s_decoder.decoder || !p_codec_info) {
         return;
     }
     
@@ -37,6 +37,15 @@ extern size_t aptx_decode32(struct aptx_context *ctx,
                             unsigned char *output,
                             size_t output_size,
                             size_t *written);
+#if CONFIG_APTX_DEC_FAST_KERNELS
+/* Bit-exact aptx_decode32() with unrolled kernels and word stores */
+extern size_t aptx_decode32_fast(struct aptx_context *ctx,
+                                 const unsigned char *input,
+                                 size_t input_size,
+                                 unsigned char *output,
+                                 size_t output_size,
+                                 size_t *written);
+#endif
 
 typedef enum
 {
@@ -74,7 +83,7 @@ void a2dp_aptx_decoder_cleanup(void) {
     }
 
     aptx_finish(decoder_context);
-    decoder_context = NULL;
+    a2dp_aptx_decoder_cb.decoder_context = NULL;
 }
 
 bool a2dp_aptx_decoder_reset(void) {
@@ -109,6 +118,11 @@ bool a2dp_aptx_decoder_decode_packet(BT_HDR* p_buf, unsigned char* buf, size_t b
     size_t processed = -1;
     while (src_size > 0 && avail > 0 && processed) {
         size_t written;
+#if CONFIG_APTX_DEC_FAST_KERNELS
+        if (((uintptr_t)dst & 3) == 0) {
+            processed = aptx_decode32_fast(decoder_context, src, (size_t)src_size, dst, (size_t)avail, &written);
+        } else
+#endif
         processed = aptx_decode32(decoder_context, src, (size_t)src_size, dst, (size_t)avail, &written);
 
         src += processed;
@@ -14,6 +14,7 @@
 
 // #define LC3PLUS_MAX_BYTES 1250
 #define FRAGMENT_BUF_SIZE   (1250)
+#define LC3PLUS_MAX_CHANNELS 2
 
 typedef struct {
     int fragment_size;
@@ -24,32 +25,68 @@ typedef struct {
     int frame_duration;
     bool hr_mode;
 
-    struct lc3_decoder* decoder[2];
+    struct lc3_decoder* decoder[LC3PLUS_MAX_CHANNELS];
+
+    /* Decoder memory for the largest configuration (10 ms, 96 kHz), one
+     * slot per channel, reused by every configure */
+    uint8_t* arena;
+    size_t arena_slot;
 
     decoded_data_callback_t decode_callback;
 } tA2DP_LC3PLUS_DECODER_CB;
 
-static tA2DP_LC3PLUS_DECODER_CB a2dp_lc3plus_decoder_cb;
+/* Allocated while LC3plus is the active codec */
+static tA2DP_LC3PLUS_DECODER_CB *a2dp_lc3plus_decoder_cb_ptr;
+#define a2dp_lc3plus_decoder_cb (*a2dp_lc3plus_decoder_cb_ptr)
 
 
 bool a2dp_lc3plus_decoder_init(decoded_data_callback_t decode_callback) {
+    if (!a2dp_lc3plus_decoder_cb_ptr) {
+        a2dp_lc3plus_decoder_cb_ptr = (tA2DP_LC3PLUS_DECODER_CB *)osi_calloc(sizeof(tA2DP_LC3PLUS_DECODER_CB));
+        if (!a2dp_lc3plus_decoder_cb_ptr) {
+            APPL_TRACE_ERROR("%s: no memory for decoder state (%u bytes)", __func__,
+                             (unsigned)sizeof(tA2DP_LC3PLUS_DECODER_CB));
+            return false;
+        }
+    }
+    if (!a2dp_lc3plus_decoder_cb.arena) {
+        static const int frame_durations[] = { 2500, 5000, 10000 };
+        size_t slot = 0;
+        for (size_t i = 0; i < sizeof(frame_durations) / sizeof(frame_durations[0]); i++) {
+            size_t sz = lc3_hr_decoder_size(true, frame_durations[i], 96000);
+            slot = sz > slot ? sz : slot;
+        }
+        slot = (slot + 7) & ~(size_t)7;
+        a2dp_lc3plus_decoder_cb.arena = (uint8_t*)osi_malloc(slot * LC3PLUS_MAX_CHANNELS);
+        if (!a2dp_lc3plus_decoder_cb.arena) {
+            APPL_TRACE_ERROR("%s: no memory for decoder arena (%u bytes)", __func__,
+                             (unsigned)(slot * LC3PLUS_MAX_CHANNELS));
+            osi_free(a2dp_lc3plus_decoder_cb_ptr);
+            a2dp_lc3plus_decoder_cb_ptr = NULL;
+            return false;
+        }
+        a2dp_lc3plus_decoder_cb.arena_slot = slot;
+    }
     a2dp_lc3plus_decoder_cb.decode_callback = decode_callback;
     return true;
 }
 
 void a2dp_lc3plus_decoder_cleanup(void) {
-    tA2DP_LC3PLUS_DECODER_CB* cb = &a2dp_lc3plus_decoder_cb;
-    
-    for (size_t i = 0; i < cb->channels; i++) {
-        if (cb->decoder[i]) {
-            osi_free(cb->decoder[i]);
-        }
-        cb->decoder[i] = NULL;
+    tA2DP_LC3PLUS_DECODER_CB* cb = a2dp_lc3plus_decoder_cb_ptr;
+    if (!cb) {
+        return;
     }
+
+    osi_free(cb->arena);
+    osi_free(a2dp_lc3plus_decoder_cb_ptr);
+    a2dp_lc3plus_decoder_cb_ptr = NULL;
 }
 
 void a2dp_lc3plus_decoder_configure(const uint8_t* p_codec_info) {
-    tA2DP_LC3PLUS_DECODER_CB* cb = &a2dp_lc3plus_decoder_cb;
+    tA2DP_LC3PLUS_DECODER_CB* cb = a2dp_lc3plus_decoder_cb_ptr;
+    if (!cb) {
+        return;
+    }
 
     tA2DP_LC3PLUS_CIE p_ie;
     A2DP_ParseInfoLc3Plus(&p_ie, p_codec_info, false);
@@ -98,28 +135,27 @@ void a2dp_lc3plus_decoder_configure(const uint8_t* p_codec_info) {
     cb->sample_rate = sample_rate;
     cb->hr_mode = hr_mode;
 
-    for (size_t i = 0; i < channels; i++) {
-        if (cb->decoder[i]) {
-            osi_free(cb->decoder[i]);
-            cb->decoder[i] = NULL;
-        }
-    }
-
-    for (size_t i = 0; i < channels; i++) {
+    for (size_t i = 0; i < LC3PLUS_MAX_CHANNELS; i++) {
+        struct lc3_decoder* dec = NULL;
         size_t sz = lc3_hr_decoder_size(hr_mode, frame_duration, sample_rate);
-        struct lc3_decoder* dec = osi_malloc(sz);
-        if (!dec) {
-            APPL_TRACE_ERROR("%s: Failed to allocate decoder for ch %u", __func__, i);
+        if (i < channels && sz <= cb->arena_slot) {
+            dec = lc3_hr_setup_decoder(hr_mode, frame_duration, sample_rate, sample_rate,
+                                       cb->arena + i * cb->arena_slot);
+        }
+        if (i < channels && !dec) {
+            APPL_TRACE_ERROR("%s: Failed to set up decoder for ch %u", __func__, i);
         }
-
         cb->decoder[i] = dec;
-
-        lc3_hr_setup_decoder(hr_mode, frame_duration, sample_rate, sample_rate, dec);
     }
+    cb->fragment_count = 0;
+    cb->fragment_size = 0;
 }
 
 ssize_t a2dp_lc3plus_decoder_decode_packet_header(BT_HDR* p_buf) {
-    tA2DP_LC3PLUS_DECODER_CB* cb = &a2dp_lc3plus_decoder_cb;
+    tA2DP_LC3PLUS_DECODER_CB* cb = a2dp_lc3plus_decoder_cb_ptr;
+    if (!cb) {
+        return -EINVAL;
+    }
 
     size_t header_len = sizeof(struct media_packet_header) +
                            sizeof(struct media_payload_header);
@@ -152,44 +188,77 @@ ssize_t a2dp_lc3plus_decoder_decode_packet_header(BT_HDR* p_buf) {
 }
 
 bool a2dp_lc3plus_decoder_decode_packet(BT_HDR* p_buf, unsigned char* buf, size_t buf_len) {
-    tA2DP_LC3PLUS_DECODER_CB* cb = &a2dp_lc3plus_decoder_cb;
+    tA2DP_LC3PLUS_DECODER_CB* cb = a2dp_lc3plus_decoder_cb_ptr;
+    if (!cb) {
+        return false;
+    }
 
     unsigned char* src = ((unsigned char *)(p_buf + 1) + p_buf->offset);
     int src_size = p_buf->len;
+    int channels = cb->channels;
+
+    /* The channel frames are read in place from the packet. Only the
+     * part of a frame that started in an earlier fragment is rebuilt in
+     * cb->fragment: that is head[0, head_size), the rest follows in src. */
+    const uint8_t* head = cb->fragment;
+    int head_size = 0;
+    int total_size = src_size;
 
+    if (channels <= 0 || channels > LC3PLUS_MAX_CHANNELS) {
+        APPL_TRACE_ERROR("%s: decoder not configured", __func__);
+        return false;
+    }
 
     if (cb->fragment_count > 0) {
         /* Fragmented frame */
-        size_t avail;
-        avail = min(sizeof(cb->fragment) - cb->fragment_size, src_size);
-        memcpy(cb->fragment + cb->fragment_size, src, avail);
+        if (cb->fragment_count > 1) {
+            size_t avail;
+            avail = min(sizeof(cb->fragment) - cb->fragment_size, src_size);
+            memcpy(cb->fragment + cb->fragment_size, src, avail);
 
-        cb->fragment_size += avail;
+            cb->fragment_size += avail;
 
-        if (cb->fragment_count > 1) {
             /* More fragments to come */
             APPL_TRACE_DEBUG("%s: More fragments to come", __func__);
             return true;
         }
 
-        src = cb->fragment;
-        src_size = cb->fragment_size;
+        /* Last fragment: complete the frame that straddles the boundary */
+        total_size = cb->fragment_size + src_size;
+        if (total_size > FRAGMENT_BUF_SIZE) {
+            APPL_TRACE_ERROR("%s: fragmented frame too long (%d bytes): drop", __func__, total_size);
+            cb->fragment_count = 0;
+            cb->fragment_size = 0;
+            return false;
+        }
+        int need = 0;
+        for (int ich = 0, off = 0; ich < channels; ich++) {
+            int frame_size = total_size / channels + (ich < total_size % channels);
+            if (off < cb->fragment_size) {
+                need = off + frame_size - cb->fragment_size;
+            }
+            off += frame_size;
+        }
+        need = need > 0 ? need : 0;
+        memcpy(cb->fragment + cb->fragment_size, src, need);
+        head_size = cb->fragment_size + need;
+        src += need;
 
         cb->fragment_count = 0;
         cb->fragment_size = 0;
     }
 
     enum lc3_pcm_format cfmt = LC3_PCM_FORMAT_S24;
-    int channels = cb->channels;
     int32_t* pcm = (int32_t*)buf;
     int ret = 0;
 
-    const uint8_t *in_ptr = src;
+    int off = 0;
     for (size_t ich = 0; ich < channels; ich++) {
         struct lc3_decoder* dec = cb->decoder[ich];
 
-        int frame_size = src_size / channels
-                            + (ich < src_size % channels);
+        int frame_size = total_size / channels
+                            + (ich < total_size % channels);
+        const uint8_t *in_ptr = off < head_size ? head + off : src + (off - head_size);
 
         int _ret = lc3_decode(dec, in_ptr, frame_size,
                                 cfmt, pcm + ich, channels);
@@ -198,7 +267,7 @@ bool a2dp_lc3plus_decoder_decode_packet(BT_HDR* p_buf, unsigned char* buf, size_
         }
         ret |= _ret;
 
-        in_ptr += frame_size;
+        off += frame_size;
     }
 
     if (!ret) {
@@ -58,6 +58,7 @@ static const tA2DP_DECODER_INTERFACE a2dp_decoder_interface_ldac = {
     NULL,  // decoder_start
     NULL,  // decoder_suspend
     a2dp_ldac_decoder_configure,
+    a2dp_ldac_decoder_set_level,
 };
 
 tA2D_STATUS A2DP_BuildInfoLdac(uint8_t media_type,
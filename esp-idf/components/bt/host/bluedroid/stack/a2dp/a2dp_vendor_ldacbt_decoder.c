@@ -14,6 +14,10 @@
 
 #define MAX_QUALITY (LDACBT_EQMID_HQ)
 
+/* Decoded bandwidth per a2dp_ldac_decoder_set_level level (0: all) */
+static const int ldac_level_bandwidth_hz[] = { 0, 20000, 18000 };
+#define LDAC_MAX_LEVEL (sizeof(ldac_level_bandwidth_hz) / sizeof(ldac_level_bandwidth_hz[0]) - 1)
+
 typedef struct {
     HANDLE_LDAC_BT ldac_handle;
     bool has_ldac_handle;
@@ -176,4 +180,15 @@ void a2dp_ldac_decoder_configure(const uint8_t* p_codec_info) {
     }
 }
 
+void a2dp_ldac_decoder_set_level(uint8_t level) {
+    if (level > LDAC_MAX_LEVEL) {
+        level = LDAC_MAX_LEVEL;
+    }
+    if (!a2dp_ldac_decoder_cb.has_ldac_handle) {
+        return;
+    }
+    /* Cleared by configure, so the sink sets it again after one */
+    ldacBT_set_decode_bandwidth(a2dp_ldac_decoder_cb.ldac_handle, ldac_level_bandwidth_hz[level]);
+}
+
 #endif /* defined(LDAC_DEC_INCLUDED) && LDAC_DEC_INCLUDED == TRUE) */
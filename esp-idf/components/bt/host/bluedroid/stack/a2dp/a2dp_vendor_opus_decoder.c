@@ -7,6 +7,7 @@
 #include "stack/a2dp_vendor_opus_decoder.h"
 #include "stack/a2dp_vendor_opus.h"
 #include "opus_multistream.h"
+#include "osi/allocator.h"
 
 
 #if (defined(OPUS_DEC_INCLUDED) && OPUS_DEC_INCLUDED == TRUE)
@@ -17,6 +18,9 @@
 
 typedef struct {
   OpusMSDecoder *decoder;
+  /* Decoder memory for the largest stereo layout, reused by every configure */
+  void *arena;
+  opus_int32 arena_size;
   int fragment_size;
   int fragment_count;
   uint8_t fragment[FRAGMENT_BUF_SIZE];
@@ -24,31 +28,57 @@ typedef struct {
   decoded_data_callback_t decode_callback;
 } tA2DP_OPUS_DECODER_CB;
 
-static tA2DP_OPUS_DECODER_CB a2dp_opus_decoder_cb;
+/* Allocated while Opus is the active codec */
+static tA2DP_OPUS_DECODER_CB *a2dp_opus_decoder_cb_ptr;
+#define a2dp_opus_decoder_cb (*a2dp_opus_decoder_cb_ptr)
 
 
 bool a2dp_opus_decoder_init(decoded_data_callback_t decode_callback) {
+    if (!a2dp_opus_decoder_cb_ptr) {
+        a2dp_opus_decoder_cb_ptr = (tA2DP_OPUS_DECODER_CB *)osi_calloc(sizeof(tA2DP_OPUS_DECODER_CB));
+        if (!a2dp_opus_decoder_cb_ptr) {
+            APPL_TRACE_ERROR("%s: no memory for decoder state (%u bytes)", __func__,
+                             (unsigned)sizeof(tA2DP_OPUS_DECODER_CB));
+            return false;
+        }
+    }
+    if (!a2dp_opus_decoder_cb.arena) {
+        opus_int32 coupled = opus_multistream_decoder_get_size(1, 1);
+        opus_int32 dual = opus_multistream_decoder_get_size(2, 0);
+        opus_int32 size = coupled > dual ? coupled : dual;
+        a2dp_opus_decoder_cb.arena = size > 0 ? osi_malloc(size) : NULL;
+        if (!a2dp_opus_decoder_cb.arena) {
+            APPL_TRACE_ERROR("%s: no memory for decoder arena (%d bytes)", __func__, (int)size);
+            osi_free(a2dp_opus_decoder_cb_ptr);
+            a2dp_opus_decoder_cb_ptr = NULL;
+            return false;
+        }
+        a2dp_opus_decoder_cb.arena_size = size;
+    }
     a2dp_opus_decoder_cb.decode_callback = decode_callback;
     return true;
 }
 
 void a2dp_opus_decoder_cleanup(void) {
-    tA2DP_OPUS_DECODER_CB* cb = &a2dp_opus_decoder_cb;
-    OpusMSDecoder* st = cb->decoder;
-    if (st) {
-        opus_multistream_decoder_destroy(st);
+    tA2DP_OPUS_DECODER_CB* cb = a2dp_opus_decoder_cb_ptr;
+    if (!cb) {
+        return;
     }
-    cb->decoder = NULL;
+    osi_free(cb->arena);
+    osi_free(a2dp_opus_decoder_cb_ptr);
+    a2dp_opus_decoder_cb_ptr = NULL;
 }
 
 void a2dp_opus_decoder_configure(const uint8_t* p_codec_info) {
-    tA2DP_OPUS_DECODER_CB* cb = &a2dp_opus_decoder_cb;
-    OpusMSDecoder* st = cb->decoder;
-
-    if (st != NULL) {
-        opus_multistream_decoder_destroy(st);
-        st = NULL;
+    tA2DP_OPUS_DECODER_CB* cb = a2dp_opus_decoder_cb_ptr;
+    if (!cb) {
+        return;
     }
+    OpusMSDecoder* st = (OpusMSDecoder*)cb->arena;
+
+    cb->decoder = NULL;
+    cb->fragment_count = 0;
+    cb->fragment_size = 0;
 
     tA2DP_OPUS_CIE p_ie;
     A2DP_ParseInfoOpus(&p_ie, p_codec_info, false);
@@ -61,7 +91,7 @@ void a2dp_opus_decoder_configure(const uint8_t* p_codec_info) {
     unsigned int i;
     int error;
 
-    for (i = 0; i < channels; ++i)
+    for (i = 0; i < channels && i < CHANNEL_MAX; ++i)
         mapping[i] = i;
 
 
@@ -85,13 +115,18 @@ void a2dp_opus_decoder_configure(const uint8_t* p_codec_info) {
     LOG_INFO("%s: Opus Frame Duration = %lu us", __func__, frame_duration);
     LOG_INFO("%s: Opus Maximum Bitrate = %lu", __func__, p_ie.maximum_bitrate);
 
-    st = (OpusMSDecoder*) opus_multistream_decoder_create(Fs, channels, streams,
-                                                          coupled_streams,
-                                                          (unsigned char*)&mapping,
-                                                          &error);
+    if (channels <= 0 || channels > CHANNEL_MAX ||
+        opus_multistream_decoder_get_size(streams, coupled_streams) > cb->arena_size) {
+        APPL_TRACE_ERROR("%s: unsupported layout: %d channels, %d streams", __func__,
+                         channels, streams);
+        return;
+    }
+
+    error = opus_multistream_decoder_init(st, Fs, channels, streams,
+                                          coupled_streams,
+                                          (unsigned char*)&mapping);
     if (error != OPUS_OK) {
-        APPL_TRACE_ERROR("%s: opus decoder create error %d", __func__, error);
-        a2dp_opus_decoder_cb.decoder = NULL;
+        APPL_TRACE_ERROR("%s: opus decoder init error %d", __func__, error);
         return;
     }
 
@@ -100,7 +135,10 @@ void a2dp_opus_decoder_configure(const uint8_t* p_codec_info) {
 }
 
 ssize_t a2dp_opus_decoder_decode_packet_header(BT_HDR* p_buf) {
-    tA2DP_OPUS_DECODER_CB* cb = &a2dp_opus_decoder_cb;
+    tA2DP_OPUS_DECODER_CB* cb = a2dp_opus_decoder_cb_ptr;
+    if (!cb) {
+        return -EINVAL;
+    }
 
     size_t header_len = sizeof(struct media_packet_header) +
                            sizeof(struct media_payload_header);
@@ -133,8 +171,8 @@ ssize_t a2dp_opus_decoder_decode_packet_header(BT_HDR* p_buf) {
 }
 
 bool a2dp_opus_decoder_decode_packet(BT_HDR* p_buf, unsigned char* buf, size_t buf_len) {
-    tA2DP_OPUS_DECODER_CB* cb = &a2dp_opus_decoder_cb;
-    OpusMSDecoder* dec = cb->decoder;
+    tA2DP_OPUS_DECODER_CB* cb = a2dp_opus_decoder_cb_ptr;
+    OpusMSDecoder* dec = cb ? cb->decoder : NULL;
 
     if (!dec) {
         APPL_TRACE_ERROR("%s: opus decoder not allocated", __func__);
@@ -18,47 +18,80 @@ static const uint32_t sample_rate_table[13] = {
 };
 
 /*******************************************************************************
- * Bitstream Reader - reads bits from byte buffer
+ * Bitstream Reader - 64-bit big-endian cache over a byte buffer
+ *
+ * The cache holds the next bits left-justified. A refill with 8 bytes left in
+ * the buffer is one unaligned load ORed in under the valid bits, leaving 56-63
+ * of them; the bits it loads past that are the stream's own next bits, so the
+ * next refill ORs the same values over them. Past the end the stream reads as
+ * zeros and bit_pos keeps counting, so callers check for overrun by position.
  ******************************************************************************/
 typedef struct {
     const uint8_t *data;
-    size_t data_len;
-    size_t bit_pos;
+    const uint8_t *ptr;         /* Next byte to load into the cache */
+    const uint8_t *end;
+    uint64_t cache;             /* Next bits, MSB first */
+    int bits;                   /* Valid bits in the cache */
+    size_t bit_pos;             /* Bits consumed */
 } bitstream_t;
 
-static inline void bs_init(bitstream_t *bs, const uint8_t *data, size_t len)
+static inline uint64_t bs_load_be64(const uint8_t *p)
 {
-    bs->data = data;
-    bs->data_len = len;
-    bs->bit_pos = 0;
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return __builtin_bswap64(v);
+}
+
+static inline void bs_refill(bitstream_t *bs)
+{
+    if (bs->end - bs->ptr >= 8) {
+        bs->cache |= bs_load_be64(bs->ptr) >> bs->bits;
+        bs->ptr += (63 - bs->bits) >> 3;
+        bs->bits |= 56;
+        return;
+    }
+    while (bs->bits <= 56 && bs->ptr < bs->end) {
+        bs->cache |= (uint64_t)*bs->ptr++ << (56 - bs->bits);
+        bs->bits += 8;
+    }
+    if (bs->ptr == bs->end) {
+        bs->bits = 64;          /* Zeros from here on */
+    }
+}
+
+/* Restart the cache at bit_pos */
+static void bs_seek(bitstream_t *bs, size_t bit_pos)
+{
+    size_t byte_pos = bit_pos >> 3;
+    size_t len = (size_t)(bs->end - bs->data);
+    bs->bit_pos = bit_pos;
+    bs->ptr = bs->data + (byte_pos < len ? byte_pos : len);
+    bs->cache = 0;
+    bs->bits = 0;
+    bs_refill(bs);
+    if (byte_pos < len) {
+        bs->cache <<= bit_pos & 7;
+        bs->bits -= bit_pos & 7;
+    }
 }
 
-static inline size_t bs_bits_left(const bitstream_t *bs)
+static inline void bs_init(bitstream_t *bs, const uint8_t *data, size_t len)
 {
-    return (bs->data_len * 8) - bs->bit_pos;
+    bs->data = data;
+    bs->end = data + len;
+    bs_seek(bs, 0);
 }
 
+/* n in 1-32 */
 static inline uint32_t bs_read_bits(bitstream_t *bs, uint8_t n)
 {
-    if (n == 0 || n > 32) return 0;
-    if (bs_bits_left(bs) < n) return 0;
-    
-    uint32_t result = 0;
-    while (n > 0) {
-        size_t byte_pos = bs->bit_pos >> 3;
-        size_t bit_in_byte = bs->bit_pos & 7;
-        size_t bits_in_this_byte = 8 - bit_in_byte;
-        
-        if (bits_in_this_byte > n) bits_in_this_byte = n;
-        
-        uint8_t mask = (1 << bits_in_this_byte) - 1;
-        uint8_t shift = 8 - bit_in_byte - bits_in_this_byte;
-        uint8_t val = (bs->data[byte_pos] >> shift) & mask;
-        
-        result = (result << bits_in_this_byte) | val;
-        bs->bit_pos += bits_in_this_byte;
-        n -= bits_in_this_byte;
+    if (bs->bits < n) {
+        bs_refill(bs);
     }
+    uint32_t result = (uint32_t)(bs->cache >> (64 - n));
+    bs->cache <<= n;
+    bs->bits -= n;
+    bs->bit_pos += n;
     return result;
 }
 
@@ -74,9 +107,10 @@ static inline size_t bs_get_bit_pos(const bitstream_t *bs)
 
 static inline void bs_skip_bits(bitstream_t *bs, size_t n)
 {
-    bs->bit_pos += n;
-    if (bs->bit_pos > bs->data_len * 8) {
-        bs->bit_pos = bs->data_len * 8;
+    if (n <= 32) {
+        if (n) bs_read_bits(bs, (uint8_t)n);
+    } else {
+        bs_seek(bs, bs->bit_pos + n);
     }
 }
 
@@ -97,29 +131,52 @@ static uint32_t latm_get_value(bitstream_t *bs)
 /*******************************************************************************
  * Parse AudioSpecificConfig (GASpecificConfig for AAC-LC)
  ******************************************************************************/
-static latm_error_t parse_audio_specific_config(bitstream_t *bs, latm_audio_config_t *config)
+#define AOT_SBR             5
+#define AOT_PS              29
+#define SYNC_EXTENSION_SBR  0x2b7
+
+static uint8_t read_object_type(bitstream_t *bs)
 {
     /* audioObjectType (5 bits, may extend to 11) */
     uint8_t audio_object_type = (uint8_t)bs_read_bits(bs, 5);
     if (audio_object_type == 31) {
         audio_object_type = 32 + (uint8_t)bs_read_bits(bs, 6);
     }
-    config->object_type = audio_object_type;
-    
-    /* samplingFrequencyIndex (4 bits) */
+    return audio_object_type;
+}
+
+/* samplingFrequencyIndex (4 bits), or an explicit 24-bit rate; 0 if invalid */
+static uint32_t read_sample_rate(bitstream_t *bs)
+{
     uint8_t sf_index = (uint8_t)bs_read_bits(bs, 4);
     if (sf_index == 0x0F) {
-        /* explicit sample rate (24 bits) */
-        config->sample_rate = bs_read_bits(bs, 24);
-    } else if (sf_index < 13) {
-        config->sample_rate = sample_rate_table[sf_index];
-    } else {
+        return bs_read_bits(bs, 24);
+    }
+    return (sf_index < 13) ? sample_rate_table[sf_index] : 0;
+}
+
+static latm_error_t parse_audio_specific_config(bitstream_t *bs, latm_audio_config_t *config)
+{
+    uint8_t audio_object_type = read_object_type(bs);
+    
+    config->sample_rate = read_sample_rate(bs);
+    if (config->sample_rate == 0) {
         return LATM_ERR_UNSUPPORTED_CONFIG;
     }
     
     /* channelConfiguration (4 bits) */
     config->channel_config = (uint8_t)bs_read_bits(bs, 4);
     
+    /* Explicit (hierarchical) SBR signaling: extension rate, then the core */
+    config->sbr_present = false;
+    config->sbr_sample_rate = 0;
+    if (audio_object_type == AOT_SBR || audio_object_type == AOT_PS) {
+        config->sbr_present = true;
+        config->sbr_sample_rate = read_sample_rate(bs);
+        audio_object_type = read_object_type(bs);
+    }
+    config->object_type = audio_object_type;
+    
     /* For AAC-LC (objectType 2), parse GASpecificConfig */
     if (audio_object_type == 2) {
         /* frameLengthFlag */
@@ -137,6 +194,19 @@ static latm_error_t parse_audio_specific_config(bitstream_t *bs, latm_audio_conf
     return LATM_OK;
 }
 
+/* Backward-compatible (implicit) SBR signaling after the GASpecificConfig,
+ * only reachable when the ASC length is known */
+static void parse_sync_extension(bitstream_t *bs, latm_audio_config_t *config, size_t bits_left)
+{
+    if (bits_left < 16 || bs_read_bits(bs, 11) != SYNC_EXTENSION_SBR) {
+        return;
+    }
+    if (read_object_type(bs) == AOT_SBR && bs_read_bit(bs)) {
+        config->sbr_present = true;
+        config->sbr_sample_rate = read_sample_rate(bs);
+    }
+}
+
 /*******************************************************************************
  * Parse StreamMuxConfig
  ******************************************************************************/
@@ -197,8 +267,13 @@ static latm_error_t parse_stream_mux_config(bitstream_t *bs, latm_parser_t *pars
         err = parse_audio_specific_config(bs, &parser->audio_config);
         if (err != LATM_OK) return err;
         
-        /* Skip any remaining ASC bits */
         size_t asc_read = bs_get_bit_pos(bs) - asc_start;
+        if (asc_read < asc_len && !parser->audio_config.sbr_present) {
+            parse_sync_extension(bs, &parser->audio_config, asc_len - asc_read);
+        }
+        
+        /* Skip any remaining ASC bits */
+        asc_read = bs_get_bit_pos(bs) - asc_start;
         if (asc_read < asc_len) {
             bs_skip_bits(bs, asc_len - asc_read);
         }
@@ -259,6 +334,35 @@ static uint32_t parse_payload_length_info(bitstream_t *bs)
     return length;
 }
 
+/*******************************************************************************
+ * StreamMuxConfig cache
+ *
+ * Sources that send the config in band with every frame (useSameStreamMux 0)
+ * repeat the same bits each time. The packet's leading bits up to the end of
+ * the config are kept, and a packet that starts with the same bits skips the
+ * parse and keeps the parsed state.
+ ******************************************************************************/
+static bool mux_config_cached(const latm_parser_t *parser, const uint8_t *data, size_t data_len)
+{
+    uint16_t bits = parser->stream_mux_config_bits;
+    size_t full = bits >> 3;
+    if (bits == 0 || (size_t)bits > data_len * 8 || memcmp(data, parser->stream_mux_config, full) != 0) {
+        return false;
+    }
+    uint8_t mask = (uint8_t)(0xFF00 >> (bits & 7));
+    return (bits & 7) == 0 || ((data[full] ^ parser->stream_mux_config[full]) & mask) == 0;
+}
+
+static void mux_config_store(latm_parser_t *parser, const uint8_t *data, size_t bits)
+{
+    if (bits > sizeof(parser->stream_mux_config) * 8) {
+        parser->stream_mux_config_bits = 0;
+        return;
+    }
+    memcpy(parser->stream_mux_config, data, (bits + 7) >> 3);
+    parser->stream_mux_config_bits = (uint16_t)bits;
+}
+
 /*******************************************************************************
  * Public API
  ******************************************************************************/
@@ -278,13 +382,11 @@ void latm_parser_reset(latm_parser_t *parser)
     }
 }
 
-latm_error_t latm_parse_frame(latm_parser_t *parser,
-                               const uint8_t *data, size_t data_len,
-                               uint8_t *aac_out, size_t aac_out_size,
-                               size_t *aac_len,
-                               latm_frame_info_t *frame_info)
+latm_error_t latm_parse_payload(latm_parser_t *parser,
+                                const uint8_t *data, size_t data_len,
+                                latm_payload_t *payload)
 {
-    if (parser == NULL || data == NULL || aac_out == NULL || aac_len == NULL) {
+    if (parser == NULL || data == NULL || payload == NULL) {
         return LATM_ERR_NULL_POINTER;
     }
     
@@ -301,15 +403,27 @@ latm_error_t latm_parse_frame(latm_parser_t *parser,
     parser->use_same_stream_mux = bs_read_bit(&bs) ? true : false;
     
     if (!parser->use_same_stream_mux) {
-        /* Parse new StreamMuxConfig */
-        err = parse_stream_mux_config(&bs, parser);
-        if (err != LATM_OK) return err;
+        if (parser->config_parsed && mux_config_cached(parser, data, data_len)) {
+            /* Same StreamMuxConfig as the last one parsed */
+            bs_seek(&bs, parser->stream_mux_config_bits);
+        } else {
+            /* Parse new StreamMuxConfig */
+            parser->stream_mux_config_bits = 0;
+            err = parse_stream_mux_config(&bs, parser);
+            if (err != LATM_OK) return err;
+            if (bs_get_bit_pos(&bs) > data_len * 8) {
+                /* Truncated: what was parsed is partly zeros */
+                parser->config_parsed = false;
+                return LATM_ERR_NOT_ENOUGH_DATA;
+            }
+            mux_config_store(parser, data, bs_get_bit_pos(&bs));
+        }
     } else if (!parser->config_parsed) {
         /* No config available yet */
         return LATM_ERR_UNSUPPORTED_CONFIG;
     }
     
-    /* PayloadMux - extract AAC frame(s) */
+    /* PayloadLengthInfo - length of the AAC frame(s) */
     uint32_t aac_frame_len = 0;
     
     for (uint8_t sf = 0; sf < parser->num_sub_frames; sf++) {
@@ -322,55 +436,66 @@ latm_error_t latm_parse_frame(latm_parser_t *parser,
         }
     }
     
-    /* Get bit position where AAC frame starts */
+    /* PayloadMux - the AAC frame follows directly, usually not byte aligned */
     size_t frame_bit_offset = bs_get_bit_pos(&bs);
-    size_t frame_byte_offset = frame_bit_offset >> 3;
-    size_t bit_remainder = frame_bit_offset & 7;
+    if (frame_bit_offset + (size_t)aac_frame_len * 8 > data_len * 8) {
+        return LATM_ERR_NOT_ENOUGH_DATA;
+    }
+    
+    payload->data = data + (frame_bit_offset >> 3);
+    payload->len = aac_frame_len;
+    payload->bit_offset = (uint8_t)(frame_bit_offset & 7);
+    return LATM_OK;
+}
+
+latm_error_t latm_parse_frame(latm_parser_t *parser,
+                               const uint8_t *data, size_t data_len,
+                               uint8_t *aac_out, size_t aac_out_size,
+                               size_t *aac_len,
+                               latm_frame_info_t *frame_info)
+{
+    if (aac_out == NULL || aac_len == NULL) {
+        return LATM_ERR_NULL_POINTER;
+    }
+    
+    latm_payload_t payload;
+    latm_error_t err = latm_parse_payload(parser, data, data_len, &payload);
+    if (err != LATM_OK) {
+        return err;
+    }
     
     /* Fill in frame info if requested */
     if (frame_info) {
-        frame_info->frame_length_bits = aac_frame_len * 8;
-        frame_info->frame_length_bytes = aac_frame_len;
-        frame_info->bit_offset = frame_bit_offset;
-        frame_info->is_byte_aligned = (bit_remainder == 0);
+        frame_info->frame_length_bits = payload.len * 8;
+        frame_info->frame_length_bytes = payload.len;
+        frame_info->bit_offset = (uint32_t)(payload.data - data) * 8 + payload.bit_offset;
+        frame_info->is_byte_aligned = (payload.bit_offset == 0);
     }
     
     /* Check output buffer size */
-    if (aac_frame_len > aac_out_size) {
+    if (payload.len > aac_out_size) {
         return LATM_ERR_BUFFER_TOO_SMALL;
     }
     
-    /* Check input data bounds */
-    if (frame_byte_offset + aac_frame_len > data_len) {
-        return LATM_ERR_NOT_ENOUGH_DATA;
-    }
-    
-    /*
-     * Extract AAC frame data
-     * 
-     * If byte-aligned, simple copy
-     * If not byte-aligned, need to shift bits
-     */
-    if (bit_remainder == 0) {
-        /* Byte aligned - simple copy */
-        memcpy(aac_out, data + frame_byte_offset, aac_frame_len);
+    /* Copy out, realigning to a byte boundary if needed */
+    if (payload.bit_offset == 0) {
+        memcpy(aac_out, payload.data, payload.len);
     } else {
-        /* Not byte aligned - need to shift bits */
-        /* This is the tricky case mentioned by the user */
-        uint8_t left_shift = bit_remainder;
-        uint8_t right_shift = 8 - bit_remainder;
+        const uint8_t *end = data + data_len;
+        uint8_t left_shift = payload.bit_offset;
+        uint8_t right_shift = 8 - payload.bit_offset;
         
-        for (size_t i = 0; i < aac_frame_len; i++) {
-            size_t src_byte = frame_byte_offset + i;
-            uint8_t byte_val = (data[src_byte] << left_shift);
-            if (src_byte + 1 < data_len) {
-                byte_val |= (data[src_byte + 1] >> right_shift);
+        for (size_t i = 0; i < payload.len; i++) {
+            const uint8_t *src = payload.data + i;
+            uint8_t byte_val = (uint8_t)(src[0] << left_shift);
+            if (src + 1 < end) {
+                byte_val |= (src[1] >> right_shift);
             }
             aac_out[i] = byte_val;
         }
     }
     
-    *aac_len = aac_frame_len;
+    *aac_len = payload.len;
     return LATM_OK;
 }
 
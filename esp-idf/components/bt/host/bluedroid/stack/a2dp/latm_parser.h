@@ -5,7 +5,7 @@
  * Lightweight LATM Parser for A2DP AAC
  * 
  * Parses LATM (Low-overhead MPEG-4 Audio Transport Multiplex) headers
- * used in A2DP AAC streams. Extracts raw AAC frames for decoding.
+ * used in A2DP AAC streams. Locates raw AAC frames in place for decoding.
  * 
  * Based on ISO/IEC 14496-3 LATM specification.
  * 
@@ -36,8 +36,10 @@ typedef enum {
 
 /* Audio Specific Config extracted from LATM */
 typedef struct {
-    uint8_t  object_type;       /* AAC object type (1=Main, 2=LC, 3=SSR, 4=LTP) */
-    uint32_t sample_rate;       /* Sample rate in Hz */
+    uint8_t  object_type;       /* AAC object type (1=Main, 2=LC, 3=SSR, 4=LTP), core for SBR */
+    uint32_t sample_rate;       /* Sample rate in Hz (of the core for SBR) */
+    uint32_t sbr_sample_rate;   /* Output rate of the SBR extension, 0 without SBR */
+    bool     sbr_present;       /* ASC signals SBR (HE-AAC), explicitly or by sync extension */
     uint8_t  channel_config;    /* Channel configuration (1=mono, 2=stereo) */
     uint8_t  frame_length_flag; /* 0=1024 samples, 1=960 samples */
     bool     config_valid;      /* True if config has been parsed */
@@ -51,6 +53,13 @@ typedef struct {
     bool     is_byte_aligned;    /* True if frame starts on byte boundary */
 } latm_frame_info_t;
 
+/* Raw AAC frame inside the LATM packet, not copied or realigned */
+typedef struct {
+    const uint8_t *data;         /* Byte holding the first payload bit */
+    uint32_t len;                /* Payload length in bytes */
+    uint8_t  bit_offset;         /* Payload starts at this bit of data[0] (0 = MSB) */
+} latm_payload_t;
+
 /* LATM Parser Context - minimal state */
 typedef struct {
     /* StreamMuxConfig state */
@@ -69,9 +78,10 @@ typedef struct {
     bool     config_parsed;
     bool     use_same_stream_mux;
     
-    /* Cached StreamMuxConfig for reuse */
+    /* Leading bits of the last packet that carried a StreamMuxConfig, up to
+     * the config's end; a packet starting with the same bits reuses it */
     uint8_t  stream_mux_config[64];
-    uint8_t  stream_mux_config_len;
+    uint16_t stream_mux_config_bits;
 } latm_parser_t;
 
 /**
@@ -87,6 +97,24 @@ latm_error_t latm_parser_init(latm_parser_t *parser);
  */
 void latm_parser_reset(latm_parser_t *parser);
 
+/**
+ * @brief Parse LATM frame and locate the raw AAC frame in place
+ *
+ * Parses the AudioMuxElement like latm_parse_frame() but does not copy the
+ * payload; it usually starts mid-byte (after the useSameStreamMux bit), so
+ * it is returned as a byte pointer plus bit offset for a decoder that can
+ * start reading there (AACDecodeBits).
+ *
+ * @param parser    Parser context
+ * @param data      Input LATM data, must stay valid while the payload is used
+ * @param data_len  Length of input data in bytes
+ * @param payload   [out] Location of the raw AAC frame
+ * @return LATM_OK on success, error code otherwise
+ */
+latm_error_t latm_parse_payload(latm_parser_t *parser,
+                                const uint8_t *data, size_t data_len,
+                                latm_payload_t *payload);
+
 /**
  * @brief Parse LATM frame and extract raw AAC frame
  * 
@@ -1331,4 +1331,19 @@ UINT16 AVDT_GetDelayValue(void)
     return avdt_cb.delay_value;
 }
 
+/*******************************************************************************
+**
+** Function         AVDT_SetSepFilter
+**
+** Description      Set the callback that decides, per peer, which local
+**                  stream endpoints a discover response offers.
+**
+** Returns          void
+**
+*******************************************************************************/
+void AVDT_SetSepFilter(tAVDT_SEP_FILTER_CBACK *p_cback)
+{
+    avdt_cb.p_sep_filter = p_cback;
+}
+
 #endif /*  #if (defined(AVDT_INCLUDED) && AVDT_INCLUDED == TRUE) */
@@ -148,7 +148,8 @@ void avdt_ccb_chk_close(tAVDT_CCB *p_ccb, tAVDT_CCB_EVT *p_data)
 ** Description      This function is called when a discover command is
 **                  received from the peer.  It gathers up the stream
 **                  information for all allocated streams and initiates
-**                  sending of a discover response.
+**                  sending of a discover response.  Streams the SEP filter
+**                  withholds from this peer are reported as in use.
 **
 **
 ** Returns          void.
@@ -167,7 +168,12 @@ void avdt_ccb_hdl_discover_cmd(tAVDT_CCB *p_ccb, tAVDT_CCB_EVT *p_data)
     for (i = 0; i < AVDT_NUM_SEPS; i++, p_scb++) {
         if (p_scb->allocated) {
             /* copy sep info */
-            sep_info[p_data->msg.discover_rsp.num_seps].in_use = p_scb->in_use;
+            BOOLEAN in_use = p_scb->in_use;
+            if (!in_use && avdt_cb.p_sep_filter != NULL) {
+                in_use = !(*avdt_cb.p_sep_filter)(p_ccb->peer_addr, p_scb->cs.tsep,
+                                                  p_scb->cs.cfg.codec_info);
+            }
+            sep_info[p_data->msg.discover_rsp.num_seps].in_use = in_use;
             sep_info[p_data->msg.discover_rsp.num_seps].seid = i + 1;
             sep_info[p_data->msg.discover_rsp.num_seps].media_type = p_scb->cs.media_type;
             sep_info[p_data->msg.discover_rsp.num_seps].tsep = p_scb->cs.tsep;
@@ -560,6 +560,7 @@ typedef struct {
     tAVDT_CTRL_CBACK    *p_conn_cback;          /* connection callback function */
     UINT8               trace_level;            /* trace level */
     UINT16              delay_value;            /* delay reporting value */
+    tAVDT_SEP_FILTER_CBACK *p_sep_filter;       /* endpoints offered per peer */
 } tAVDT_CB;
 
 
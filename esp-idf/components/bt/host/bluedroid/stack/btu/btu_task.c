@@ -256,6 +256,11 @@ bool btu_task_post(uint32_t sig, void *param, uint32_t timeout)
         case SIG_BTU_L2CAP_ALARM:
             status = osi_thread_post(btu_thread, btu_l2cap_alarm_process, param, 0, timeout);
             break;
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+        case SIG_BTU_L2CAP_LE_COC:
+            status = osi_thread_post(btu_thread, l2cble_coc_api_process, param, 0, timeout);
+            break;
+#endif
         default:
             break;
     }
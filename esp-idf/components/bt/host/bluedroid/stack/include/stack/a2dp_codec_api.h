@@ -48,6 +48,11 @@ typedef struct {
 
   // A2DP decoder configuration.
   void (*decoder_configure)(const uint8_t* p_codec_info);
+
+  // Trade output quality for decode time: 0 is full quality, each level
+  // up is cheaper. Takes effect with the next packet; levels the codec
+  // has no step for behave as its last one. NULL if the codec has none.
+  void (*decoder_set_level)(uint8_t level);
 } tA2DP_DECODER_INTERFACE;
 
 
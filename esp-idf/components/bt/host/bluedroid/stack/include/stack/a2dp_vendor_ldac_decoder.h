@@ -71,6 +71,16 @@ bool a2dp_ldac_decoder_decode_packet(BT_HDR* p_buf, unsigned char* buf, size_t b
 ******************************************************************************/
 void a2dp_ldac_decoder_configure(const uint8_t* p_codec_info);
 
+/******************************************************************************
+**
+** Function         a2dp_ldac_decoder_set_level
+**
+** Description      Limit the decoded bandwidth to save CPU time: level 0
+**                  decodes everything, 1 stops near 20 kHz, 2 near 18 kHz.
+**
+******************************************************************************/
+void a2dp_ldac_decoder_set_level(uint8_t level);
+
 #ifdef __cplusplus
 }
 #endif
@@ -393,6 +393,13 @@ typedef void (tAVDT_REPORT_CBACK)(UINT8 handle, AVDT_REPORT_TYPE type,
 
 typedef UINT16 (tAVDT_GETCAP_REQ) (BD_ADDR bd_addr, UINT8 seid, tAVDT_CFG *p_cfg, tAVDT_CTRL_CBACK *p_cback);
 
+/* This is the stream endpoint filter callback function. It is executed when
+** a peer discovers the local stream endpoints, once per endpoint that is not
+** in use, with the endpoint's codec information. Returning FALSE reports the
+** endpoint to that peer as in use, so it configures another one.
+*/
+typedef BOOLEAN (tAVDT_SEP_FILTER_CBACK)(BD_ADDR bd_addr, UINT8 tsep, const UINT8 *p_codec_info);
+
 /* This structure contains information required when a stream is created.
 ** It is passed to the AVDT_CreateStream() function.
 */
@@ -1020,6 +1027,19 @@ extern void AVDT_SetDelayValue(UINT16 delay_value);
 *******************************************************************************/
 extern UINT16 AVDT_GetDelayValue(void);
 
+/*******************************************************************************
+**
+** Function         AVDT_SetSepFilter
+**
+** Description      Set the callback that decides, per peer, which local
+**                  stream endpoints a discover response offers. NULL offers
+**                  all of them.
+**
+** Returns          void
+**
+*******************************************************************************/
+extern void AVDT_SetSepFilter(tAVDT_SEP_FILTER_CBACK *p_cback);
+
 #ifdef __cplusplus
 }
 #endif
@@ -179,6 +179,7 @@ typedef enum {
     SIG_BTU_ONESHOT_ALARM,
     SIG_BTU_L2CAP_ALARM,
     SIG_BTU_HCI_ADV_RPT_MSG,
+    SIG_BTU_L2CAP_LE_COC,
     SIG_BTU_NUM,
 } SIG_BTU_t;
 
@@ -569,6 +569,37 @@ extern BOOLEAN L2CA_ConnectLECocRsp (BD_ADDR p_bd_addr, UINT8 id, UINT16 lcid, U
 *******************************************************************************/
 extern BOOLEAN L2CA_GetPeerLECocConfig (UINT16 lcid, tL2CAP_LE_CFG_INFO* peer_cfg);
 
+/*******************************************************************************
+**
+**  Function         L2CA_LECocGiveCredits
+**
+**  Description      Gives the peer more credits on an open LE COC, one per
+**                  K-frame it may send. BTU task only.
+**
+**  Return value:    TRUE if the credits were sent
+**
+*******************************************************************************/
+extern BOOLEAN L2CA_LECocGiveCredits (UINT16 lcid, UINT16 credits);
+
+/* Calls L2CA_LECocPost() carries to the BTU task */
+#define L2CA_LE_COC_OP_WRITE        0   /* Send an SDU */
+#define L2CA_LE_COC_OP_CREDITS      1   /* L2CA_LECocGiveCredits() */
+#define L2CA_LE_COC_OP_DISCONNECT   2   /* Close the channel */
+
+/*******************************************************************************
+**
+**  Function         L2CA_LECocPost
+**
+**  Description      Runs an L2CA_LE_COC_OP_xxx call on an LE COC on the BTU
+**                  task, from any task. p_data (WRITE only) is always freed
+**                  by L2CAP. Data indications carry the number of K-frames
+**                  the SDU took in layer_specific.
+**
+**  Return value:    TRUE if the call was queued
+**
+*******************************************************************************/
+extern BOOLEAN L2CA_LECocPost (UINT8 op, UINT16 lcid, UINT16 credits, BT_HDR *p_data);
+
 #endif // (BLE_L2CAP_COC_INCLUDED == TRUE)
 
 /*******************************************************************************
@@ -42,6 +42,7 @@
 #define L2CAP_LE_DEFAULT_MTU        512
 #define L2CAP_LE_DEFAULT_MPS        23
 #define L2CAP_LE_DEFAULT_CREDIT     1
+#define L2CAP_LE_COC_BUFF_QUOTA     24      /* Queued K-frames before a channel reports congestion */
 
 
 /* Timeouts. Since L2CAP works off a 1-second list, all are in seconds.
@@ -280,6 +281,10 @@ typedef struct t_l2c_ccb {
     tL2C_CHNL_STATE     chnl_state;             /* Channel state                    */
     tL2CAP_LE_CFG_INFO  local_conn_cfg;         /* Our config for ble conn oriented channel */
     tL2CAP_LE_CFG_INFO  peer_conn_cfg;          /* Peer device config ble conn oriented channel */
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+    BT_HDR              *ble_sdu;               /* LE SDU being reassembled from K-frames */
+    UINT16              ble_sdu_length;         /* Its length, from the first K-frame */
+#endif
 
     struct t_l2c_ccb    *p_next_ccb;            /* Next CCB in the chain            */
     struct t_l2c_ccb    *p_prev_ccb;            /* Previous CCB in the chain        */
@@ -798,6 +803,21 @@ extern void l2cble_credit_based_conn_req (tL2C_CCB *p_ccb);
 extern void l2cble_credit_based_conn_res (tL2C_CCB *p_ccb, UINT16 result);
 extern void l2cble_send_peer_disc_req(tL2C_CCB *p_ccb);
 extern void l2cble_send_flow_control_credit(tL2C_CCB *p_ccb, UINT16 credit_value);
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+/* An L2CA_LECocPost() call, carried to the BTU task */
+typedef struct {
+    UINT8               op;                     /* L2CA_LE_COC_OP_xxx */
+    UINT16              lcid;
+    UINT16              credits;
+    BT_HDR              *p_data;
+} tL2C_LE_COC_API_MSG;
+
+extern void l2cble_coc_conn_rsp(tL2C_CCB *p_ccb, UINT16 result);
+extern void l2cble_coc_rcv_data(tL2C_CCB *p_ccb, BT_HDR *p_msg);
+extern UINT8 l2cble_coc_write(tL2C_CCB *p_ccb, BT_HDR *p_data);
+extern void l2cble_coc_disconnect(tL2C_CCB *p_ccb, BOOLEAN send_req);
+extern void l2cble_coc_api_process(void *param);
+#endif
 extern BOOLEAN l2ble_sec_access_req(BD_ADDR bd_addr, UINT16 psm, BOOLEAN is_originator, tL2CAP_SEC_CBACK *p_callback, void *p_ref_data);
 
 
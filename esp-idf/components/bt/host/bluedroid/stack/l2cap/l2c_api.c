@@ -1565,6 +1565,20 @@ BOOLEAN L2CA_ConnectLECocRsp (BD_ADDR p_bd_addr, UINT8 id, UINT16 lcid, UINT16 r
         memcpy(&p_ccb->local_conn_cfg, p_cfg, sizeof(tL2CAP_LE_CFG_INFO));
     }
 
+    /* The LE credit based response carries our configuration; no config phase */
+    if (p_lcb->transport == BT_TRANSPORT_LE) {
+        if (result == L2CAP_CONN_OK &&
+            (p_ccb->local_conn_cfg.mtu < L2CAP_LE_MIN_MTU ||
+             p_ccb->local_conn_cfg.mps < L2CAP_LE_MIN_MPS ||
+             p_ccb->local_conn_cfg.mps > L2CAP_LE_MAX_MPS)) {
+            L2CAP_TRACE_WARNING("%s bad local config, MTU: %d  MPS: %d", __func__,
+                                p_ccb->local_conn_cfg.mtu, p_ccb->local_conn_cfg.mps);
+            result = L2CAP_LE_RESULT_NO_RESOURCES;
+        }
+        l2cble_coc_conn_rsp(p_ccb, result);
+        return TRUE;
+    }
+
     if (result == L2CAP_CONN_OK)
         l2c_csm_execute (p_ccb, L2CEVT_L2CA_CONNECT_RSP, NULL);
     else
@@ -1608,6 +1622,76 @@ BOOLEAN L2CA_GetPeerLECocConfig (UINT16 lcid, tL2CAP_LE_CFG_INFO* peer_cfg)
 
     return TRUE;
 }
+
+/*******************************************************************************
+**
+**  Function         L2CA_LECocGiveCredits
+**
+**  Description      Gives the peer more credits on an open LE Connection
+**                  Oriented Channel, one per K-frame it may send. Must be
+**                  called on the BTU task; see L2CA_LECocPost().
+**
+**  Return value:    TRUE if the credits were sent
+**
+*******************************************************************************/
+BOOLEAN L2CA_LECocGiveCredits (UINT16 lcid, UINT16 credits)
+{
+    tL2C_CCB *p_ccb = l2cu_find_ccb_by_cid(NULL, lcid);
+    if (p_ccb == NULL || p_ccb->chnl_state != CST_OPEN || credits == 0) {
+        return FALSE;
+    }
+
+    if ((UINT32)p_ccb->local_conn_cfg.credits + credits > L2CAP_LE_MAX_CREDIT) {
+        credits = L2CAP_LE_MAX_CREDIT - p_ccb->local_conn_cfg.credits;
+        if (credits == 0) {
+            return FALSE;
+        }
+    }
+
+    p_ccb->local_conn_cfg.credits += credits;
+    l2cble_send_flow_control_credit(p_ccb, credits);
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+**  Function         L2CA_LECocPost
+**
+**  Description      Carries a call on an LE Connection Oriented Channel to
+**                  the BTU task, from any task:
+**                      L2CA_LE_COC_OP_WRITE       send the SDU p_data (freed
+**                                                 by L2CAP in every case)
+**                      L2CA_LE_COC_OP_CREDITS     L2CA_LECocGiveCredits()
+**                      L2CA_LE_COC_OP_DISCONNECT  close the channel; the
+**                                                 disconnect indication
+**                                                 follows on the BTU task
+**
+**  Return value:    TRUE if the call was queued
+**
+*******************************************************************************/
+BOOLEAN L2CA_LECocPost (UINT8 op, UINT16 lcid, UINT16 credits, BT_HDR *p_data)
+{
+    tL2C_LE_COC_API_MSG *p_msg = (tL2C_LE_COC_API_MSG *)osi_malloc(sizeof(tL2C_LE_COC_API_MSG));
+    if (p_msg == NULL) {
+        if (p_data) {
+            osi_free(p_data);
+        }
+        return FALSE;
+    }
+
+    p_msg->op = op;
+    p_msg->lcid = lcid;
+    p_msg->credits = credits;
+    p_msg->p_data = p_data;
+    if (!btu_task_post(SIG_BTU_L2CAP_LE_COC, p_msg, OSI_THREAD_MAX_TIMEOUT)) {
+        if (p_data) {
+            osi_free(p_data);
+        }
+        osi_free(p_msg);
+        return FALSE;
+    }
+    return TRUE;
+}
 #endif // (BLE_L2CAP_COC_INCLUDED == TRUE)
 
 #if (L2CAP_NUM_FIXED_CHNLS > 0)
@@ -809,7 +809,6 @@ void l2cble_process_sig_cmd (tL2C_LCB *p_lcb, UINT8 *p, UINT16 pkt_len)
         STREAM_TO_UINT16(mps, p);
         STREAM_TO_UINT16(credits, p);
         L2CAP_TRACE_DEBUG("%s spsm %x, scid %x", __func__, spsm, scid);
-        UNUSED(spsm);
 
         p_ccb = l2cu_find_ccb_by_remote_cid(p_lcb, scid);
         if (p_ccb) {
@@ -817,12 +816,18 @@ void l2cble_process_sig_cmd (tL2C_LCB *p_lcb, UINT8 *p, UINT16 pkt_len)
             break;
         }
 
-        #if 0
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
         p_rcb = l2cu_find_ble_rcb_by_psm(spsm);
-        if (p_rcb == NULL) {
+        if (p_rcb == NULL || p_rcb->api.pL2CA_ConnectInd_Cb == NULL) {
+            l2cu_reject_ble_connection(p_lcb, id, L2CAP_LE_RESULT_NO_PSM);
+            break;
+        }
+
+        if (scid < L2CAP_BASE_APPL_CID || mtu < L2CAP_LE_MIN_MTU ||
+            mps < L2CAP_LE_MIN_MPS || mps > L2CAP_LE_MAX_MPS) {
+            l2cu_reject_ble_connection(p_lcb, id, L2CAP_LE_RESULT_INVALID_PARAMETERS);
             break;
         }
-        #endif
 
         p_ccb = l2cu_allocate_ccb(p_lcb, 0);
         if (p_ccb == NULL) {
@@ -833,16 +838,44 @@ void l2cble_process_sig_cmd (tL2C_LCB *p_lcb, UINT8 *p, UINT16 pkt_len)
         p_ccb->remote_id = id;
         p_ccb->p_rcb = p_rcb;
         p_ccb->remote_cid = scid;
-        p_ccb->local_conn_cfg.mtu = mtu;
-        p_ccb->local_conn_cfg.mps = controller_get_interface()->get_acl_data_size_ble();
-        p_ccb->local_conn_cfg.credits = credits;
         p_ccb->peer_conn_cfg.mtu = mtu;
         p_ccb->peer_conn_cfg.mps = mps;
         p_ccb->peer_conn_cfg.credits = credits;
 
-        l2cu_send_peer_ble_credit_based_conn_res(p_ccb, L2CAP_LE_RESULT_CONN_OK);
+        /* The application accepts or refuses with L2CA_ConnectLECocRsp() */
+        (*p_rcb->api.pL2CA_ConnectInd_Cb)(p_lcb->remote_bd_addr, p_ccb->local_cid, p_rcb->psm, id);
+#else
+        UNUSED(p_rcb);
+        UNUSED(mtu);
+        UNUSED(mps);
+        UNUSED(credits);
+        l2cu_reject_ble_connection(p_lcb, id, L2CAP_LE_RESULT_NO_PSM);
+#endif  ///BLE_L2CAP_COC_INCLUDED == TRUE
+        break;
+    }
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+    case L2CAP_CMD_BLE_FLOW_CTRL_CREDIT: {
+        tL2C_CCB *p_ccb = NULL;
+        UINT16 rcid;
+        UINT16 credits;
+        STREAM_TO_UINT16(rcid, p);
+        STREAM_TO_UINT16(credits, p);
+
+        p_ccb = l2cu_find_ccb_by_remote_cid(p_lcb, rcid);
+        if (p_ccb == NULL || p_ccb->chnl_state != CST_OPEN) {
+            break;
+        }
+        if ((UINT32)p_ccb->peer_conn_cfg.credits + credits > L2CAP_LE_MAX_CREDIT) {
+            /* A peer that overflows its credits has to be disconnected */
+            L2CAP_TRACE_WARNING("%s credit overflow, CID: 0x%04x", __func__, p_ccb->local_cid);
+            l2cble_coc_disconnect(p_ccb, TRUE);
+            break;
+        }
+        p_ccb->peer_conn_cfg.credits += credits;
+        l2c_link_check_send_pkts(p_lcb, NULL, NULL);
         break;
     }
+#endif  ///BLE_L2CAP_COC_INCLUDED == TRUE
     case L2CAP_CMD_DISC_REQ: {
         tL2C_CCB *p_ccb = NULL;
         UINT16 lcid;
@@ -850,15 +883,20 @@ void l2cble_process_sig_cmd (tL2C_LCB *p_lcb, UINT8 *p, UINT16 pkt_len)
         STREAM_TO_UINT16(lcid, p);
         STREAM_TO_UINT16(rcid, p);
 
+        l2cu_send_peer_disc_rsp(p_lcb, id, lcid, rcid);
+
         p_ccb = l2cu_find_ccb_by_cid(p_lcb, lcid);
-        if (p_ccb) {
+        if (p_ccb && p_ccb->remote_cid == rcid) {
             p_ccb->remote_id = id;
-            // TODO
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+            l2cble_coc_disconnect(p_ccb, FALSE);
+#endif  ///BLE_L2CAP_COC_INCLUDED == TRUE
         }
-
-        l2cu_send_peer_disc_rsp(p_lcb, id, lcid, rcid);
         break;
     }
+    case L2CAP_CMD_DISC_RSP:
+        /* Our own disconnect released the channel when it was sent */
+        break;
     default:
         L2CAP_TRACE_WARNING ("L2CAP - LE - unknown cmd code: %d", cmd_code);
         l2cu_send_peer_cmd_reject (p_lcb, L2CAP_CMD_REJ_NOT_UNDERSTOOD, id, 0, 0);
@@ -1695,6 +1733,260 @@ BOOLEAN l2ble_sec_access_req(BD_ADDR bd_addr, UINT16 psm, BOOLEAN is_originator,
     return status;
 }
 #endif /* #if (SMP_INCLUDED == TRUE) */
+
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         l2cble_coc_conn_rsp
+**
+** Description      Answers a peer's LE Credit Based Connection Request once the
+**                  application decided. Accepting opens the channel with the
+**                  local configuration already in the CCB; refusing releases
+**                  the CCB.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_coc_conn_rsp(tL2C_CCB *p_ccb, UINT16 result)
+{
+    if (result != L2CAP_LE_RESULT_CONN_OK) {
+        l2cu_reject_ble_connection(p_ccb->p_lcb, p_ccb->remote_id, result);
+        l2cu_release_ccb(p_ccb);
+        return;
+    }
+
+    p_ccb->chnl_state = CST_OPEN;
+    p_ccb->buff_quota = L2CAP_LE_COC_BUFF_QUOTA;
+    l2cu_send_peer_ble_credit_based_conn_res(p_ccb, L2CAP_LE_RESULT_CONN_OK);
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_coc_disconnect
+**
+** Description      Closes an LE connection oriented channel: optionally sends
+**                  the Disconnection Request, releases the CCB and tells the
+**                  application. The peer's response finds no channel and is
+**                  dropped.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_coc_disconnect(tL2C_CCB *p_ccb, BOOLEAN send_req)
+{
+    UINT16 lcid = p_ccb->local_cid;
+    tL2CA_DISCONNECT_IND_CB *p_disc_cb = p_ccb->p_rcb ? p_ccb->p_rcb->api.pL2CA_DisconnectInd_Cb : NULL;
+
+    if (send_req) {
+        l2cble_send_peer_disc_req(p_ccb);
+    }
+    l2cu_release_ccb(p_ccb);
+
+    if (p_disc_cb) {
+        (*p_disc_cb)(lcid, FALSE);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_coc_rcv_data
+**
+** Description      Handles one K-frame received on an LE connection oriented
+**                  channel. Each frame takes one of the credits we gave; the
+**                  first frame of an SDU carries its length, and a whole SDU
+**                  goes to the application's data callback with the number of
+**                  K-frames it took in layer_specific, so the credits can be
+**                  given back as it is consumed. Protocol violations close the
+**                  channel.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_coc_rcv_data(tL2C_CCB *p_ccb, BT_HDR *p_msg)
+{
+    UINT8  *p = (UINT8 *)(p_msg + 1) + p_msg->offset;
+    UINT16 sdu_len;
+    UINT16 frames = 1;
+
+    if (p_ccb->chnl_state != CST_OPEN || !p_ccb->p_rcb) {
+        osi_free(p_msg);
+        return;
+    }
+
+    if (p_ccb->local_conn_cfg.credits == 0 || p_msg->len > p_ccb->local_conn_cfg.mps) {
+        L2CAP_TRACE_WARNING("%s CID: 0x%04x, K-frame of %d bytes with %d credits",
+                            __func__, p_ccb->local_cid, p_msg->len, p_ccb->local_conn_cfg.credits);
+        osi_free(p_msg);
+        l2cble_coc_disconnect(p_ccb, TRUE);
+        return;
+    }
+    p_ccb->local_conn_cfg.credits--;
+
+    if (p_ccb->ble_sdu == NULL) {
+        /* First K-frame of an SDU */
+        if (p_msg->len < L2CAP_SDU_LEN_OVERHEAD) {
+            osi_free(p_msg);
+            l2cble_coc_disconnect(p_ccb, TRUE);
+            return;
+        }
+        STREAM_TO_UINT16(sdu_len, p);
+        p_msg->offset += L2CAP_SDU_LEN_OVERHEAD;
+        p_msg->len    -= L2CAP_SDU_LEN_OVERHEAD;
+
+        if (sdu_len > p_ccb->local_conn_cfg.mtu || p_msg->len > sdu_len) {
+            L2CAP_TRACE_WARNING("%s CID: 0x%04x, SDU of %d bytes, MTU %d", __func__,
+                                p_ccb->local_cid, sdu_len, p_ccb->local_conn_cfg.mtu);
+            osi_free(p_msg);
+            l2cble_coc_disconnect(p_ccb, TRUE);
+            return;
+        }
+
+        if (p_msg->len == sdu_len) {
+            p_msg->layer_specific = frames;
+            (*p_ccb->p_rcb->api.pL2CA_DataInd_Cb)(p_ccb->local_cid, p_msg);
+            return;
+        }
+
+        p_ccb->ble_sdu = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + sdu_len);
+        if (p_ccb->ble_sdu == NULL) {
+            L2CAP_TRACE_ERROR("%s CID: 0x%04x, no buffer for an SDU of %d bytes", __func__,
+                              p_ccb->local_cid, sdu_len);
+            osi_free(p_msg);
+            l2cble_coc_disconnect(p_ccb, TRUE);
+            return;
+        }
+        p_ccb->ble_sdu->event = 0;
+        p_ccb->ble_sdu->offset = 0;
+        p_ccb->ble_sdu->len = 0;
+        p_ccb->ble_sdu->layer_specific = 0;
+        p_ccb->ble_sdu_length = sdu_len;
+    } else if (p_ccb->ble_sdu->len + p_msg->len > p_ccb->ble_sdu_length) {
+        L2CAP_TRACE_WARNING("%s CID: 0x%04x, K-frames overrun the SDU", __func__, p_ccb->local_cid);
+        osi_free(p_msg);
+        l2cble_coc_disconnect(p_ccb, TRUE);
+        return;
+    }
+
+    memcpy((UINT8 *)(p_ccb->ble_sdu + 1) + p_ccb->ble_sdu->len,
+           (UINT8 *)(p_msg + 1) + p_msg->offset, p_msg->len);
+    p_ccb->ble_sdu->len += p_msg->len;
+    p_ccb->ble_sdu->layer_specific++;
+    osi_free(p_msg);
+
+    if (p_ccb->ble_sdu->len < p_ccb->ble_sdu_length) {
+        return;
+    }
+
+    p_msg = p_ccb->ble_sdu;
+    p_ccb->ble_sdu = NULL;
+    (*p_ccb->p_rcb->api.pL2CA_DataInd_Cb)(p_ccb->local_cid, p_msg);
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_coc_write
+**
+** Description      Segments an SDU into K-frames of at most the peer's MPS,
+**                  the first one carrying the SDU length, and queues them on
+**                  the channel. The link sends one K-frame per peer credit.
+**                  p_data is always freed.
+**
+** Returns          L2CAP_DW_SUCCESS, L2CAP_DW_CONGESTED (queued, channel now
+**                  congested) or L2CAP_DW_FAILED
+**
+*******************************************************************************/
+UINT8 l2cble_coc_write(tL2C_CCB *p_ccb, BT_HDR *p_data)
+{
+    UINT8  *p_src = (UINT8 *)(p_data + 1) + p_data->offset;
+    UINT16 remaining = p_data->len;
+    UINT16 mps = p_ccb->peer_conn_cfg.mps;
+    BOOLEAN first = TRUE;
+
+    if (p_ccb->chnl_state != CST_OPEN || p_data->len > p_ccb->peer_conn_cfg.mtu || p_ccb->cong_sent) {
+        L2CAP_TRACE_DEBUG("%s CID: 0x%04x, SDU of %d bytes not sent, state %d congested %d", __func__,
+                          p_ccb->local_cid, p_data->len, p_ccb->chnl_state, p_ccb->cong_sent);
+        osi_free(p_data);
+        return L2CAP_DW_FAILED;
+    }
+
+    do {
+        UINT16 hdr = first ? L2CAP_SDU_LEN_OVERHEAD : 0;
+        UINT16 len = (remaining < mps - hdr) ? remaining : (mps - hdr);
+        BT_HDR *p_buf = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + hdr + len);
+        UINT8 *p;
+
+        if (p_buf == NULL) {
+            /* Part of the SDU may be queued already: the stream is broken */
+            L2CAP_TRACE_ERROR("%s CID: 0x%04x, no buffer for a K-frame", __func__, p_ccb->local_cid);
+            osi_free(p_data);
+            l2cble_coc_disconnect(p_ccb, TRUE);
+            return L2CAP_DW_FAILED;
+        }
+        p_buf->event = 0;
+        p_buf->offset = L2CAP_MIN_OFFSET;
+        p_buf->len = hdr + len;
+        p_buf->layer_specific = 0;
+
+        p = (UINT8 *)(p_buf + 1) + p_buf->offset;
+        if (first) {
+            UINT16_TO_STREAM(p, p_data->len);
+        }
+        memcpy(p, p_src, len);
+        p_src += len;
+        remaining -= len;
+        first = FALSE;
+
+        l2c_enqueue_peer_data(p_ccb, p_buf);
+    } while (remaining);
+
+    osi_free(p_data);
+    l2c_link_check_send_pkts(p_ccb->p_lcb, NULL, NULL);
+
+    return p_ccb->cong_sent ? L2CAP_DW_CONGESTED : L2CAP_DW_SUCCESS;
+}
+
+/*******************************************************************************
+**
+** Function         l2cble_coc_api_process
+**
+** Description      Runs an L2CA_LECocPost() call on the BTU task.
+**
+** Returns          void
+**
+*******************************************************************************/
+void l2cble_coc_api_process(void *param)
+{
+    tL2C_LE_COC_API_MSG *p_msg = (tL2C_LE_COC_API_MSG *)param;
+    tL2C_CCB *p_ccb = l2cu_find_ccb_by_cid(NULL, p_msg->lcid);
+
+    if (p_ccb == NULL || p_ccb->p_lcb == NULL || p_ccb->p_lcb->transport != BT_TRANSPORT_LE) {
+        L2CAP_TRACE_DEBUG("%s no LE channel, CID: 0x%04x", __func__, p_msg->lcid);
+        if (p_msg->p_data) {
+            osi_free(p_msg->p_data);
+        }
+        osi_free(p_msg);
+        return;
+    }
+
+    switch (p_msg->op) {
+    case L2CA_LE_COC_OP_WRITE:
+        l2cble_coc_write(p_ccb, p_msg->p_data);
+        break;
+    case L2CA_LE_COC_OP_CREDITS:
+        L2CA_LECocGiveCredits(p_msg->lcid, p_msg->credits);
+        break;
+    case L2CA_LE_COC_OP_DISCONNECT:
+        l2cble_coc_disconnect(p_ccb, TRUE);
+        break;
+    default:
+        if (p_msg->p_data) {
+            osi_free(p_msg->p_data);
+        }
+        break;
+    }
+    osi_free(p_msg);
+}
+#endif  ///BLE_L2CAP_COC_INCLUDED == TRUE
 #endif /* (BLE_INCLUDED == TRUE) */
 /*******************************************************************************
 **
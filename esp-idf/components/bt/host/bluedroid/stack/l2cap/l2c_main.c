@@ -150,7 +150,6 @@ void l2c_rcv_acl_data (BT_HDR *p_msg)
 #if (!CONFIG_BT_STACK_NO_LOG)
     UINT16      psm;
 #endif
-    UINT16      credit;
 
     /* Extract the handle */
     STREAM_TO_UINT16 (handle, p);
@@ -309,22 +308,13 @@ void l2c_rcv_acl_data (BT_HDR *p_msg)
         if (p_ccb == NULL) {
             osi_free (p_msg);
         } else {
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
             if (p_lcb->transport == BT_TRANSPORT_LE) {
-                // Got a pkt, valid send out credits to the peer device
-                credit = L2CAP_LE_DEFAULT_CREDIT;
-                L2CAP_TRACE_DEBUG("%s Credits received %d",__func__, credit);
-                if((p_ccb->peer_conn_cfg.credits + credit) > L2CAP_LE_MAX_CREDIT) {
-                    /* we have received credits more than max coc credits,
-                     * so disconnecting the Le Coc Channel
-                     */
-#if (BLE_INCLUDED == TRUE)
-                    l2cble_send_peer_disc_req (p_ccb);
-#endif  ///BLE_INCLUDED == TRUE
-                } else {
-                    p_ccb->peer_conn_cfg.credits += credit;
-                    l2c_link_check_send_pkts (p_ccb->p_lcb, NULL, NULL);
-                }
+                /* LE credit based channel: K-frames, reassembled into SDUs */
+                l2cble_coc_rcv_data (p_ccb, p_msg);
+                return;
             }
+#endif  ///BLE_L2CAP_COC_INCLUDED == TRUE
             /* Basic mode packets go straight to the state machine */
             if (p_ccb->peer_cfg.fcr.mode == L2CAP_FCR_BASIC_MODE) {
 #if (CLASSIC_BT_INCLUDED == TRUE)
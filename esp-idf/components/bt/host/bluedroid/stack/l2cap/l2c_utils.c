@@ -1590,6 +1590,10 @@ tL2C_CCB *l2cu_allocate_ccb (tL2C_LCB *p_lcb, UINT16 cid)
 
     p_ccb->cong_sent    = FALSE;
     p_ccb->buff_quota   = 2;                /* This gets set after config */
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+    p_ccb->ble_sdu        = NULL;
+    p_ccb->ble_sdu_length = 0;
+#endif  ///BLE_L2CAP_COC_INCLUDED == TRUE
 
     /* If CCB was reserved Config_Done can already have some value */
     if (cid == 0) {
@@ -1715,6 +1719,13 @@ void l2cu_release_ccb (tL2C_CCB *p_ccb)
 
     fixed_queue_free(p_ccb->xmit_hold_q, osi_free_func);
     p_ccb->xmit_hold_q = NULL;
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+    /* A partly reassembled LE SDU */
+    if (p_ccb->ble_sdu) {
+        osi_free(p_ccb->ble_sdu);
+        p_ccb->ble_sdu = NULL;
+    }
+#endif  ///BLE_L2CAP_COC_INCLUDED == TRUE
 #if (CLASSIC_BT_INCLUDED == TRUE)
     fixed_queue_free(p_ccb->fcrb.srej_rcv_hold_q, osi_free_func);
     fixed_queue_free(p_ccb->fcrb.retrans_q, osi_free_func);
@@ -3379,6 +3390,12 @@ static tL2C_CCB *l2cu_get_next_channel_in_rr(tL2C_LCB *p_lcb)
                 if (fixed_queue_is_empty(p_ccb->xmit_hold_q)) {
                     continue;
                 }
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+                /* LE credit based channel: one K-frame per peer credit */
+                if (p_lcb->transport == BT_TRANSPORT_LE && p_ccb->peer_conn_cfg.credits == 0) {
+                    continue;
+                }
+#endif  ///BLE_L2CAP_COC_INCLUDED == TRUE
             }
 
             /* found a channel to serve */
@@ -3442,6 +3459,13 @@ static tL2C_CCB *l2cu_get_next_channel(tL2C_LCB *p_lcb)
             continue;
         }
 
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+        /* LE credit based channel: one K-frame per peer credit */
+        if (p_lcb->transport == BT_TRANSPORT_LE && p_ccb->peer_conn_cfg.credits == 0) {
+            continue;
+        }
+#endif  ///BLE_L2CAP_COC_INCLUDED == TRUE
+
         /* If in eRTM mode, check for window closure */
         if ( (p_ccb->peer_cfg.fcr.mode == L2CAP_FCR_ERTM_MODE) && (l2c_fcr_is_flow_controlled (p_ccb)) ) {
             continue;
@@ -3551,6 +3575,11 @@ BT_HDR *l2cu_get_next_buffer_to_send (tL2C_LCB *p_lcb)
             L2CAP_TRACE_ERROR("l2cu_get_buffer_to_send() #2: No data to be sent");
             return (NULL);
         }
+#if (BLE_L2CAP_COC_INCLUDED == TRUE)
+        if (p_lcb->transport == BT_TRANSPORT_LE) {
+            p_ccb->peer_conn_cfg.credits--;
+        }
+#endif  ///BLE_L2CAP_COC_INCLUDED == TRUE
     }
 
     if ( p_ccb->p_rcb && p_ccb->p_rcb->api.pL2CA_TxComplete_Cb && (p_ccb->peer_cfg.fcr.mode != L2CAP_FCR_ERTM_MODE) ) {